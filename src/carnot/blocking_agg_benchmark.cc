@@ -26,6 +26,7 @@
 #include <sole.hpp>
 
 #include "src/carnot/carnot.h"
+#include "src/carnot/exec/agg_node.h"
 #include "src/carnot/exec/local_grpc_result_server.h"
 #include "src/carnot/exec/test_utils.h"
 #include "src/carnot/udf/udf.h"
@@ -121,6 +122,16 @@ void BM_Query_Int(benchmark::State& state, std::vector<types::DataType> types,
   BM_Query(state, types, distribution_types, query, num_batches, default_params, default_params);
 }
 
+// Runs the query with the RowTuple keyed hash map, to compare against the fixed width key path.
+// NOLINTNEXTLINE : runtime/references.
+void BM_Query_Int_RowTupleKeys(benchmark::State& state, std::vector<types::DataType> types,
+                               std::vector<datagen::DistributionType> distribution_types,
+                               const std::string& query, int64_t num_batches) {
+  FLAGS_carnot_agg_fixed_width_keys = false;
+  BM_Query_Int(state, types, distribution_types, query, num_batches);
+  FLAGS_carnot_agg_fixed_width_keys = true;
+}
+
 const std::unique_ptr<const datagen::DistributionParams> sample_selection_params =
     std::make_unique<const datagen::ZipfianParams>(2, 2, 999);
 const std::unique_ptr<const datagen::DistributionParams> sample_length_params =
@@ -182,6 +193,21 @@ BENCHMARK_CAPTURE(BM_Query_Int, eval_group_by_two_uniform_ints,
     ->RangeMultiplier(2)
     ->Range(1, 1 << 16);
 
+BENCHMARK_CAPTURE(BM_Query_Int_RowTupleKeys, eval_group_by_one_uniform_int_row_tuple_keys,
+                  {types::DataType::INT64, types::DataType::INT64},
+                  {datagen::DistributionType::kUniform, datagen::DistributionType::kUniform},
+                  kGroupByOneQuery, 20)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+
+BENCHMARK_CAPTURE(BM_Query_Int_RowTupleKeys, eval_group_by_two_uniform_ints_row_tuple_keys,
+                  {types::DataType::INT64, types::DataType::INT64, types::DataType::INT64},
+                  {datagen::DistributionType::kUniform, datagen::DistributionType::kUniform,
+                   datagen::DistributionType::kUniform},
+                  kGroupByTwoQuery, 20)
+    ->RangeMultiplier(2)
+    ->Range(1, 1 << 16);
+
 BENCHMARK_CAPTURE(BM_Query_Int, eval_group_by_one_exponential_int,
                   {types::DataType::INT64, types::DataType::INT64},
                   {datagen::DistributionType::kExponential, datagen::DistributionType::kUniform},
@@ -16,22 +16,47 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <chrono>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
 
 #include "src/carnot/carnot.h"
 #include "src/carnot/engine_state.h"
 #include "src/carnot/exec/exec_graph.h"
+#include "src/carnot/exec/execution_gate.h"
+#include "src/carnot/exec/plan_template_cache.h"
 #include "src/carnot/funcs/builtins/builtins.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/plan/plan.h"
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/planner/distributed/annotate_abortable_sources_for_limits_rule.h"
 #include "src/carnot/udf/registry.h"
+#include "src/common/base/thread_pool.h"
 #include "src/common/perf/perf.h"
+#include "src/common/uuid/uuid.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_int32(carnot_exec_parallelism, gflags::Int32FromEnv("PL_CARNOT_EXEC_PARALLELISM", 1),
+             "The number of threads used to execute stateless operators (Map/Filter) of a single "
+             "query in parallel, unless the plan options of the query set it. A value of 1 "
+             "disables parallel execution.");
+DEFINE_int64(carnot_morsel_size_rows,
+             gflags::Int64FromEnv("PL_CARNOT_MORSEL_SIZE_ROWS",
+                                  px::carnot::exec::kDefaultMorselSizeRows),
+             "The maximum number of rows in a single morsel of work when parallel execution is "
+             "enabled.");
+DEFINE_int64(carnot_plan_template_cache_size,
+             gflags::Int64FromEnv("PL_CARNOT_PLAN_TEMPLATE_CACHE_SIZE", 128),
+             "The number of recently executed plans whose resolved UDFs and operator relations "
+             "are kept for reuse by later runs of the same plan. 0 disables the cache.");
+
 namespace px {
 namespace carnot {
 
@@ -63,10 +88,23 @@ class CarnotImpl final : public Carnot {
 
   Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id, bool analyze) override;
 
+  Status StopQuery(const sole::uuid& query_id) override;
+
+  void PauseQueries(planpb::PlanOptions::QueryPriority priority) override {
+    execution_gate_.Pause(priority);
+  }
+  void ResumeQueries(planpb::PlanOptions::QueryPriority priority) override {
+    execution_gate_.Resume(priority);
+  }
+
   void RegisterAgentMetadataCallback(AgentMetadataCallbackFunc func) override {
     agent_md_callback_ = func;
   };
 
+  void RegisterQuerySpanCallback(QuerySpanCallbackFunc func) override {
+    query_span_callback_ = func;
+  }
+
   const udf::Registry* FuncRegistry() const override { return engine_state_->func_registry(); }
 
  private:
@@ -86,11 +124,19 @@ class CarnotImpl final : public Carnot {
     return agent_md_callback_();
   }
 
+  void RecordQuerySpan(const sole::uuid& query_id, std::string_view span, int64_t start_time_ns,
+                       int64_t end_time_ns) {
+    if (query_span_callback_) {
+      query_span_callback_(query_id, span, start_time_ns, end_time_ns);
+    }
+  }
+
   bool HasGRPCServer() { return grpc_server_ != nullptr; }
 
   void GRPCServerFunc();
 
   AgentMetadataCallbackFunc agent_md_callback_;
+  QuerySpanCallbackFunc query_span_callback_;
   planner::compiler::Compiler compiler_;
   std::unique_ptr<EngineState> engine_state_;
 
@@ -102,6 +148,13 @@ class CarnotImpl final : public Carnot {
 
   // The id of the agent that owns this Carnot instance.
   sole::uuid agent_id_;
+
+  // The exec state of each query that is currently executing, so that it can be stopped.
+  absl::flat_hash_map<sole::uuid, exec::ExecState*> running_queries_
+      ABSL_GUARDED_BY(running_queries_lock_);
+  absl::Mutex running_queries_lock_;
+  exec::ExecutionGate execution_gate_;
+  exec::PlanTemplateCache plan_template_cache_{FLAGS_carnot_plan_template_cache_size};
 };
 
 Status CarnotImpl::Init(const sole::uuid& agent_id, std::unique_ptr<udf::Registry> func_registry,
@@ -229,7 +282,8 @@ Status SendFinalExecutionStatsToOutgoingConns(
         outgoing_servers,
     std::function<void(grpc::ClientContext*)> add_auth_to_grpc_context_func,
     const queryresultspb::AgentExecutionStats& agent_stats,
-    const std::vector<queryresultspb::AgentExecutionStats>& all_agent_stats) {
+    const std::vector<queryresultspb::AgentExecutionStats>& all_agent_stats,
+    const std::vector<uuidpb::UUID>& missing_agents) {
   // Only run this if there are outgoing_servers.
   if (outgoing_servers.size()) {
     ::px::carnotpb::TransferResultChunkRequest req;
@@ -251,6 +305,9 @@ Status SendFinalExecutionStatsToOutgoingConns(
     stats->mutable_timing()->set_execution_time_ns(agent_stats.execution_time_ns());
     stats->set_bytes_processed(total_bytes_processed);
     stats->set_records_processed(total_records_processed);
+    for (const auto& agent_id : missing_agents) {
+      *(stats->add_missing_agent_ids()) = agent_id;
+    }
 
     for (const auto& [addr, server] : outgoing_servers) {
       ::px::carnotpb::TransferResultChunkResponse resp;
@@ -275,6 +332,7 @@ Status SendFinalExecutionStatsToOutgoingConns(
 
 Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uuid& query_id,
                                bool analyze) {
+  int64_t prepare_start_ns = CurrentTimeNS();
   auto timer = ElapsedTimer();
   plan::Plan plan;
 
@@ -283,6 +341,28 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   // For each of the plan fragments in the plan, execute the query.
   std::vector<std::string> output_table_strs;
   auto exec_state = engine_state_->CreateExecState(query_id);
+  const auto& plan_options = logical_plan.plan_options();
+  int64_t parallelism = plan_options.exec_parallelism() > 0 ? plan_options.exec_parallelism()
+                                                            : FLAGS_carnot_exec_parallelism;
+  int64_t morsel_size_rows = plan_options.morsel_size_rows() > 0 ? plan_options.morsel_size_rows()
+                                                                 : FLAGS_carnot_morsel_size_rows;
+  if (parallelism > 1) {
+    exec_state->EnableParallelExecution(static_cast<int>(parallelism), morsel_size_rows,
+                                        ThreadPool::Shared());
+  }
+  exec_state->set_straggler_policy(
+      logical_plan.plan_options().straggler_quorum_fraction(),
+      std::chrono::milliseconds(logical_plan.plan_options().straggler_deadline_ms()));
+  exec_state->set_cpu_quota(logical_plan.plan_options().cpu_quota());
+  exec_state->set_priority(logical_plan.plan_options().priority(), &execution_gate_);
+  {
+    absl::MutexLock lock(&running_queries_lock_);
+    running_queries_[query_id] = exec_state.get();
+  }
+  DEFER({
+    absl::MutexLock lock(&running_queries_lock_);
+    running_queries_.erase(query_id);
+  });
 
   // TODO(michellenguyen/zasgar, PP-2579): We should periodically update the metadata state for
   // long-running queries after a certain time duration or number of row batches processed. For now,
@@ -292,13 +372,33 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
     exec_state->set_metadata_state(metadata_state);
   }
 
-  PL_RETURN_IF_ERROR(RegisterUDFs(exec_state.get(), &plan));
+  // Plans that ran recently reuse their resolved UDFs and operator relations. Otherwise, they are
+  // recorded into a new template as they are resolved.
+  std::string template_key;
+  std::shared_ptr<const exec::PlanTemplate> plan_template;
+  std::shared_ptr<exec::PlanTemplate> new_template;
+  if (FLAGS_carnot_plan_template_cache_size > 0) {
+    template_key = exec::PlanTemplateCache::Key(logical_plan);
+    plan_template = plan_template_cache_.Get(template_key);
+  }
+  if (plan_template != nullptr) {
+    exec_state->SetFuncDefinitions(plan_template->scalar_udfs, plan_template->udas);
+  } else {
+    PL_RETURN_IF_ERROR(RegisterUDFs(exec_state.get(), &plan));
+    if (FLAGS_carnot_plan_template_cache_size > 0) {
+      new_template = std::make_shared<exec::PlanTemplate>();
+      new_template->scalar_udfs = exec_state->id_to_scalar_udf_map();
+      new_template->udas = exec_state->id_to_uda_map();
+    }
+  }
 
   auto plan_state = engine_state_->CreatePlanState();
   int64_t bytes_processed = 0;
   int64_t rows_processed = 0;
   queryresultspb::AgentExecutionStats agent_operator_exec_stats;
   ToProto(agent_id_, agent_operator_exec_stats.mutable_agent_id());
+  int64_t execute_start_ns = CurrentTimeNS();
+  RecordQuerySpan(query_id, "carnot.prepare", prepare_start_ns, execute_start_ns);
   timer.Start();
   // Unclear how we'll use plan fragments in the future (they're currently unused). For now, we will
   // share the schema between plan fragments.
@@ -307,6 +407,11 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
       plan::PlanWalker()
           .OnPlanFragment([&](auto* pf) {
             auto exec_graph = exec::ExecutionGraph();
+            if (plan_template != nullptr && plan_template->fragments.contains(pf->id())) {
+              exec_graph.SetFragmentTemplate(&plan_template->fragments.at(pf->id()), nullptr);
+            } else if (new_template != nullptr) {
+              exec_graph.SetFragmentTemplate(nullptr, &new_template->fragments[pf->id()]);
+            }
             PL_RETURN_IF_ERROR(exec_graph.Init(schema.get(), plan_state.get(), exec_state.get(), pf,
                                                /* collect_exec_node_stats */ analyze));
             PL_RETURN_IF_ERROR(exec_graph.Execute());
@@ -323,6 +428,7 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
                     absl::Substitute("$0 (id=$1)", pf->nodes()[node_id]->DebugString(), node_id);
                 exec::ExecNodeStats* stats = exec_node->stats();
                 stats->AddExtraMetric("batches_output", stats->batches_output);
+                stats->AddDistributionMetrics();
                 int64_t total_time_ns = stats->TotalExecTime();
                 int64_t self_time_ns = stats->SelfExecTime();
                 LOG(INFO) << absl::Substitute(
@@ -352,6 +458,9 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
           })
           .Walk(&plan);
   PL_RETURN_IF_ERROR(s);
+  if (new_template != nullptr) {
+    plan_template_cache_.Put(template_key, std::move(new_template));
+  }
 
   std::vector<uuidpb::UUID> incoming_agents;
   for (const auto& id : logical_plan.incoming_agent_ids()) {
@@ -359,6 +468,8 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   }
   timer.Stop();
   int64_t exec_time_ns = timer.ElapsedTime_us() * 1000;
+  int64_t finalize_start_ns = CurrentTimeNS();
+  RecordQuerySpan(query_id, "carnot.execute", execute_start_ns, finalize_start_ns);
 
   std::vector<queryresultspb::AgentExecutionStats> input_agent_stats;
   if (HasGRPCServer() && !incoming_agents.empty()) {
@@ -366,6 +477,26 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
                         grpc_router_->GetIncomingWorkerExecStats(query_id, incoming_agents));
   }
 
+  // If some result streams were cut off, report the incoming agents that never got to send their
+  // stats, since the results of the query are missing their data.
+  std::vector<uuidpb::UUID> missing_agents;
+  if (!exec_state->straggler_sources().empty()) {
+    absl::flat_hash_set<sole::uuid> done_agents;
+    for (const auto& agent_stats : input_agent_stats) {
+      PL_ASSIGN_OR_RETURN(auto agent_id, ParseUUID(agent_stats.agent_id()));
+      done_agents.insert(agent_id);
+    }
+    for (const auto& agent_id_pb : incoming_agents) {
+      PL_ASSIGN_OR_RETURN(auto agent_id, ParseUUID(agent_id_pb));
+      if (!done_agents.contains(agent_id)) {
+        missing_agents.push_back(agent_id_pb);
+      }
+    }
+    LOG(WARNING) << absl::Substitute(
+        "Query $0 finished without waiting on $1 GRPC sources, missing the results of $2 agents",
+        query_id.str(), exec_state->straggler_sources().size(), missing_agents.size());
+  }
+
   // Compute bytes processed and records processed across all agents for all queries,
   // regardless of flags.
   for (const auto& agent_stats : input_agent_stats) {
@@ -376,6 +507,7 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   agent_operator_exec_stats.set_execution_time_ns(exec_time_ns);
   agent_operator_exec_stats.set_bytes_processed(bytes_processed);
   agent_operator_exec_stats.set_records_processed(rows_processed);
+  agent_operator_exec_stats.set_peak_memory_bytes(exec_state->peak_memory_bytes());
 
   std::vector<queryresultspb::AgentExecutionStats> all_agent_stats;
   if (analyze) {
@@ -386,9 +518,21 @@ Status CarnotImpl::ExecutePlan(const planpb::Plan& logical_plan, const sole::uui
   // analyze=true will send per operator stats.
   all_agent_stats.push_back(agent_operator_exec_stats);
 
-  return SendFinalExecutionStatsToOutgoingConns(query_id, exec_state->OutgoingServers(),
-                                                engine_state_->add_auth_to_grpc_context_func(),
-                                                agent_operator_exec_stats, all_agent_stats);
+  auto send_status = SendFinalExecutionStatsToOutgoingConns(
+      query_id, exec_state->OutgoingServers(), engine_state_->add_auth_to_grpc_context_func(),
+      agent_operator_exec_stats, all_agent_stats, missing_agents);
+  RecordQuerySpan(query_id, "carnot.finalize", finalize_start_ns, CurrentTimeNS());
+  return send_status;
+}
+
+Status CarnotImpl::StopQuery(const sole::uuid& query_id) {
+  absl::MutexLock lock(&running_queries_lock_);
+  auto it = running_queries_.find(query_id);
+  if (it == running_queries_.end()) {
+    return error::NotFound("Query $0 is not executing", query_id.str());
+  }
+  it->second->StopQuery();
+  return Status::OK();
 }
 
 CarnotImpl::~CarnotImpl() {
@@ -21,6 +21,7 @@
 #include <arrow/memory_pool.h>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -31,6 +32,8 @@
 #include "src/shared/metadata/metadata_state.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_int32(carnot_exec_parallelism);
+
 namespace px {
 namespace carnot {
 
@@ -51,6 +54,9 @@ class Carnot : public NotCopyable {
       std::shared_ptr<grpc::ServerCredentials> grpc_server_creds = nullptr);
 
   using AgentMetadataCallbackFunc = std::function<std::shared_ptr<const md::AgentMetadataState>()>;
+  using QuerySpanCallbackFunc =
+      std::function<void(const sole::uuid& query_id, std::string_view span,
+                         int64_t start_time_ns, int64_t end_time_ns)>;
 
   virtual ~Carnot() = default;
 
@@ -72,11 +78,37 @@ class Carnot : public NotCopyable {
   virtual Status ExecutePlan(const planpb::Plan& plan, const sole::uuid& query_id,
                              bool analyze = false) = 0;
 
+  /**
+   * Stops a query that is currently executing, which then returns from ExecutePlan once its
+   * sources have sent their final results. This is how continuous queries over streaming sources
+   * are ended.
+   *
+   * @param query_id the id of the query to stop.
+   * @return an error if no such query is executing.
+   */
+  virtual Status StopQuery(const sole::uuid& query_id) = 0;
+
+  /**
+   * Holds back the executing queries of the given priority at their next time slice boundary,
+   * until ResumeQueries is called. Lets the host give the CPU to other work, like table store
+   * compaction.
+   */
+  virtual void PauseQueries(planpb::PlanOptions::QueryPriority priority) = 0;
+  virtual void ResumeQueries(planpb::PlanOptions::QueryPriority priority) = 0;
+
   /**
    * Registers the callback for updating the agents metadata state.
    */
   virtual void RegisterAgentMetadataCallback(AgentMetadataCallbackFunc func) = 0;
 
+  /**
+   * Registers the callback that is handed the unix start and end times of the stages of each
+   * executed plan: carnot.prepare (setting up the plan), carnot.execute (running the plan
+   * fragments, including the GRPC transfers of their results) and carnot.finalize (gathering the
+   * execution stats of the incoming agents and sending on the stats).
+   */
+  virtual void RegisterQuerySpanCallback(QuerySpanCallbackFunc func) = 0;
+
   /**
    * Returns a const pointer to carnot's function registry.
    */
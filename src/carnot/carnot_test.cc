@@ -19,7 +19,10 @@
 #include <google/protobuf/text_format.h>
 
 #include <algorithm>
+#include <chrono>
 #include <map>
+#include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -27,6 +30,7 @@
 #include <pypa/parser/parser.hh>
 
 #include "src/carnot/carnot.h"
+#include "src/carnot/exec/filter_node.h"
 #include "src/carnot/exec/local_grpc_result_server.h"
 #include "src/carnot/exec/test_utils.h"
 #include "src/carnot/udf_exporter/udf_exporter.h"
@@ -111,6 +115,30 @@ TEST_F(CarnotTest, basic) {
   EXPECT_TRUE(rb2.ColumnAt(1)->Equals(types::ToArrow(col2_in2, arrow::default_memory_pool())));
 }
 
+TEST_F(CarnotTest, stop_streaming_query) {
+  auto query = absl::StrJoin(
+      {
+          "import px",
+          "df = px.DataFrame(table='test_table', select=['col1','col2']).stream()",
+          "px.display(df, 'test_output')",
+      },
+      "\n");
+  auto query_id = sole::uuid4();
+  Status exec_status;
+  std::thread exec_thread([&] { exec_status = carnot_->ExecuteQuery(query, query_id, 0); });
+
+  // The streaming query keeps running until it is stopped.
+  while (!carnot_->StopQuery(query_id).ok()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  exec_thread.join();
+  ASSERT_OK(exec_status);
+  EXPECT_THAT(result_server_->output_tables(), UnorderedElementsAre("test_output"));
+
+  // Once the query is done, it can't be stopped anymore.
+  EXPECT_NOT_OK(carnot_->StopQuery(query_id));
+}
+
 TEST_F(CarnotTest, register_metadata) {
   auto callback_calls = 0;
   carnot_->RegisterAgentMetadataCallback(
@@ -132,6 +160,31 @@ TEST_F(CarnotTest, register_metadata) {
   EXPECT_EQ(1, callback_calls);
 }
 
+TEST_F(CarnotTest, register_query_span_callback) {
+  std::vector<std::string> spans;
+  int64_t prev_end_time_ns = 0;
+  auto query_id = sole::uuid4();
+  carnot_->RegisterQuerySpanCallback([&](const sole::uuid& id, std::string_view span,
+                                         int64_t start_time_ns, int64_t end_time_ns) {
+    EXPECT_EQ(query_id, id);
+    // The stages follow each other.
+    EXPECT_LE(prev_end_time_ns, start_time_ns);
+    EXPECT_LE(start_time_ns, end_time_ns);
+    prev_end_time_ns = end_time_ns;
+    spans.emplace_back(span);
+  });
+
+  auto query = absl::StrJoin(
+      {
+          "import px",
+          "df = px.DataFrame(table='test_table', select=['col1', 'col2'])",
+          "px.display(df, 'test_output')",
+      },
+      "\n");
+  ASSERT_OK(carnot_->ExecuteQuery(query, query_id, 0));
+  EXPECT_THAT(spans, ::testing::ElementsAre("carnot.prepare", "carnot.execute", "carnot.finalize"));
+}
+
 TEST_F(CarnotTest, literal_only) {
   auto query = absl::StrJoin(
       {
@@ -754,7 +807,12 @@ class CarnotFilterTest
   void SetUp() {
     CarnotTest::SetUp();
     std::tie(comparison_fn_str, comparison_fn) = GetParam();
+    // The expected results follow the batches of the source, so the filter must not merge them.
+    coalesce_rows_ = FLAGS_carnot_filter_coalesce_rows;
+    FLAGS_carnot_filter_coalesce_rows = 0;
   }
+  void TearDown() { FLAGS_carnot_filter_coalesce_rows = coalesce_rows_; }
+  int64_t coalesce_rows_;
   std::string comparison_fn_str;
   std::function<bool(const double&, const double&)> comparison_fn;
 };
@@ -856,8 +914,13 @@ TEST_F(CarnotTest, string_filter) {
   std::string comparison_fn_str = "==";
   auto comparison_fn = [](std::string a, std::string b) { return a == b; };
 
+  // The expected results follow the batches of the source, so the filter must not merge them.
+  int64_t coalesce_rows = FLAGS_carnot_filter_coalesce_rows;
+  FLAGS_carnot_filter_coalesce_rows = 0;
   query = absl::Substitute(query, comparison_val, comparison_fn_str, comparison_column_str);
-  ASSERT_OK(carnot_->ExecuteQuery(query, sole::uuid4(), 0));
+  auto s = carnot_->ExecuteQuery(query, sole::uuid4(), 0);
+  FLAGS_carnot_filter_coalesce_rows = coalesce_rows;
+  ASSERT_OK(s);
 
   EXPECT_THAT(result_server_->output_tables(), UnorderedElementsAre("test_output"));
   auto output_batches = result_server_->query_results("test_output");
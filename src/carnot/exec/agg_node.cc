@@ -20,9 +20,16 @@
 
 #include <arrow/array.h>
 #include <arrow/array/builder_base.h>
+#include <arrow/builder.h>
 #include <arrow/status.h>
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <magic_enum.hpp>
 
@@ -35,6 +42,10 @@
 #include "src/shared/types/type_utils.h"
 #include "src/shared/types/types.h"
 
+DEFINE_bool(carnot_agg_fixed_width_keys, true,
+            "Use packed fixed width group keys (instead of RowTuples) for aggregates where all of "
+            "the group columns are fixed size.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -64,6 +75,21 @@ void AppendToBuilder(arrow::ArrayBuilder* builder, RowTuple* rt, size_t rt_idx)
   PL_UNUSED(status);
 }
 
+template <types::DataType DT>
+void AppendFixedWidthKeyToBuilder(arrow::ArrayBuilder* builder,
+                                  const types::FixedSizeValueUnion& key) {
+  using ArrowBuilder = typename types::DataTypeTraits<DT>::arrow_builder_type;
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  if constexpr (types::ValueTypeTraits<ValueType>::is_fixed_size) {
+    auto status =
+        static_cast<ArrowBuilder*>(builder)->Append(udf::UnWrap(types::Get<ValueType>(key)));
+    PL_DCHECK_OK(status);
+    PL_UNUSED(status);
+  } else {
+    DCHECK(false) << "Variable size types can't be used as fixed width keys";
+  }
+}
+
 template <types::DataType DT>
 void ExtractToColumnWrapper(const std::vector<GroupArgs>& group_args,
                             const table_store::schema::RowBatch& rb, size_t col_idx,
@@ -78,6 +104,30 @@ void ExtractToColumnWrapper(const std::vector<GroupArgs>& group_args,
   }
 }
 
+// Each partial aggregate in a packed string is prefixed by its size.
+using PartialSize = uint32_t;
+
+void AppendPartial(std::string* packed, const std::string& partial) {
+  PartialSize size = partial.size();
+  packed->append(reinterpret_cast<const char*>(&size), sizeof(size));
+  packed->append(partial);
+}
+
+StatusOr<std::string_view> NextPartial(std::string_view* packed) {
+  PartialSize size;
+  if (packed->size() < sizeof(size)) {
+    return error::InvalidArgument("Truncated partial aggregate");
+  }
+  std::memcpy(&size, packed->data(), sizeof(size));
+  packed->remove_prefix(sizeof(size));
+  if (packed->size() < size) {
+    return error::InvalidArgument("Truncated partial aggregate");
+  }
+  std::string_view partial = packed->substr(0, size);
+  packed->remove_prefix(size);
+  return partial;
+}
+
 }  // namespace
 
 std::string AggNode::DebugStringImpl() {
@@ -106,11 +156,26 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
     }
   }
 
-  size_t output_size = plan_node_->values().size() + plan_node_->groups().size();
+  // Partial aggregates are output as a single column of packed partials.
+  size_t output_size = (plan_node_->partial_output() ? 1 : plan_node_->values().size()) +
+                       plan_node_->groups().size();
   if (output_size != output_descriptor_->size()) {
     return error::InvalidArgument("Output size mismatch in aggregate");
   }
 
+  if (plan_node_->partial_input()) {
+    // The packed partials come after the group columns.
+    partial_input_col_idx_ = input_descriptor_->size() - 1;
+    if (partial_input_col_idx_ < 0 ||
+        input_descriptor_->type(partial_input_col_idx_) != types::STRING) {
+      return error::InvalidArgument("Expected the last input column to hold partial aggregates");
+    }
+  }
+
+  if (plan_node_->windowed()) {
+    window_panes_ = std::max<int64_t>(plan_node_->window_panes(), 1);
+  }
+
   if (HasNoGroups()) {
     return Status::OK();
   }
@@ -128,13 +193,32 @@ Status AggNode::InitImpl(const plan::Operator& plan_node) {
     group_data_types_.emplace_back(input_descriptor_->type(group.idx));
   }
 
-  auto values_size = plan_node_->values().size();
+  auto values_size = plan_node_->partial_output() ? 1 : plan_node_->values().size();
   for (size_t i = 0; i < values_size; ++i) {
     auto values_idx = i + groups_size;
     DCHECK(values_idx < output_descriptor_->size());
     value_data_types_.emplace_back(output_descriptor_->type(values_idx));
   }
 
+  int64_t time_bin_group = plan_node_->time_bin_group();
+  if (time_bin_group >= 0) {
+    // Groups of an emitted bin can show up again, which only partial outputs can take.
+    if (time_bin_group >= static_cast<int64_t>(groups_size) || !plan_node_->partial_output() ||
+        plan_node_->windowed()) {
+      return error::InvalidArgument("Streaming time bins need a partial aggregate by time bins");
+    }
+    if (group_data_types_[time_bin_group] != types::DataType::TIME64NS &&
+        group_data_types_[time_bin_group] != types::DataType::INT64) {
+      return error::InvalidArgument("Expected the time bin group to be a time or an int");
+    }
+    time_bin_col_idx_ = plan_node_->groups()[time_bin_group].idx;
+  }
+
+  use_fixed_width_keys_ =
+      FLAGS_carnot_agg_fixed_width_keys &&
+      std::all_of(group_data_types_.begin(), group_data_types_.end(),
+                  [](types::DataType dt) { return dt != types::DataType::STRING; });
+
   return CreateColumnMapping();
 }
 
@@ -147,6 +231,7 @@ Status AggNode::OpenImpl(ExecState* exec_state) {
   if (HasNoGroups()) {
     PL_RETURN_IF_ERROR(CreateUDAInfoValues(&udas_no_groups_, exec_state));
   }
+  last_snapshot_time_ = std::chrono::steady_clock::now();
   return Status::OK();
 }
 
@@ -154,14 +239,23 @@ Status AggNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_
   if (HasNoGroups()) {
     return AggregateGroupByNone(exec_state, rb);
   }
+  if (time_bin_col_idx_ != -1) {
+    return AggregateTimeBins(exec_state, rb);
+  }
   return AggregateGroupByClause(exec_state, rb);
 }
 
 Status AggNode::CloseImpl(ExecState*) {
+  RecordHashMapStats();
+  stats()->AddExtraMetric("max_groups", max_groups_);
+  stats()->AddExtraMetric("max_load_factor", max_load_factor_);
+
+  panes_.clear();
   udas_no_groups_.clear();
   group_args_chunk_.clear();
-  group_args_pool_.Clear();
-  udas_pool_.Clear();
+  fixed_width_keys_chunk_.clear();
+  group_args_pool_->Clear();
+  udas_pool_->Clear();
 
   return Status::OK();
 }
@@ -170,38 +264,221 @@ bool AggNode::ReadyToEmitBatches(const RowBatch& rb) const {
   return rb.eos() || (rb.eow() && plan_node_->windowed());
 }
 
-Status AggNode::ClearAggState(ExecState* exec_state) {
+bool AggNode::SnapshotDue(const RowBatch& rb) const {
+  // Partial outputs are merged downstream, so they can't be snapshotted.
+  if (plan_node_->snapshot_interval_ms() <= 0 || plan_node_->windowed() ||
+      plan_node_->partial_output() || rb.eos()) {
+    return false;
+  }
+  return std::chrono::steady_clock::now() - last_snapshot_time_ >=
+         std::chrono::milliseconds(plan_node_->snapshot_interval_ms());
+}
+
+Status AggNode::EmitSnapshot(ExecState* exec_state) {
+  last_snapshot_time_ = std::chrono::steady_clock::now();
   if (HasNoGroups()) {
+    return EmitNoGroups(exec_state, udas_no_groups_, /*eow*/ true, /*eos*/ false);
+  }
+  RowBatch output_rb(*output_descriptor_, NumGroups());
+  PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, agg_hash_map_,
+                                                 fixed_width_agg_hash_map_, &output_rb));
+  output_rb.set_eow(true);
+  output_rb.set_eos(false);
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
+
+void AggNode::RecordHashMapStats() {
+  max_groups_ = std::max(max_groups_, NumGroups());
+  double load_factor = use_fixed_width_keys_ ? fixed_width_agg_hash_map_.load_factor()
+                                             : agg_hash_map_.load_factor();
+  max_load_factor_ = std::max(max_load_factor_, load_factor);
+}
+
+Status AggNode::ClearAggState(ExecState* exec_state, AggPane* pane) {
+  RecordHashMapStats();
+  AggPane dropped;
+  if (pane == nullptr) {
+    pane = &dropped;
+  }
+  // The group keys and values live in the pools, so the pools go along with the maps. Any
+  // RowTuples left in group_args_chunk_ are from the old pool as well.
+  pane->group_args_pool = std::move(group_args_pool_);
+  pane->udas_pool = std::move(udas_pool_);
+  group_args_pool_ = std::make_unique<ObjectPool>("group_args_pool");
+  udas_pool_ = std::make_unique<ObjectPool>("udas_pool");
+  group_args_chunk_.clear();
+
+  pane->agg_hash_map = std::move(agg_hash_map_);
+  pane->fixed_width_agg_hash_map = std::move(fixed_width_agg_hash_map_);
+  agg_hash_map_.clear();
+  fixed_width_agg_hash_map_.clear();
+
+  if (HasNoGroups()) {
+    pane->udas_no_groups = std::move(udas_no_groups_);
     udas_no_groups_.clear();
     PL_RETURN_IF_ERROR(CreateUDAInfoValues(&udas_no_groups_, exec_state));
   }
-  agg_hash_map_.clear();
   return Status::OK();
 }
 
-Status AggNode::AggregateGroupByNone(ExecState* exec_state, const RowBatch& rb) {
-  auto values = plan_node_->values();
-  for (size_t i = 0; i < values.size(); ++i) {
+Status AggNode::EmitSlidingWindow(ExecState* exec_state, const RowBatch& rb) {
+  // Fold the rows that are still buffered into the UDAs, so that the pane only holds partials.
+  for (const auto& kv : agg_hash_map_) {
+    PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, kv.second));
+  }
+  for (const auto& kv : fixed_width_agg_hash_map_) {
+    PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, kv.second));
+  }
+  panes_.emplace_back();
+  PL_RETURN_IF_ERROR(ClearAggState(exec_state, &panes_.back()));
+  if (static_cast<int64_t>(panes_.size()) > window_panes_) {
+    panes_.pop_front();
+  }
+
+  // Merge the partials of every pane into fresh UDAs instead of aggregating the raw rows again.
+  if (HasNoGroups()) {
+    std::vector<UDAInfo> merged;
+    PL_RETURN_IF_ERROR(CreateUDAInfoValues(&merged, exec_state));
+    for (const auto& pane : panes_) {
+      for (const auto& [i, uda_info] : Enumerate(merged)) {
+        PL_RETURN_IF_ERROR(uda_info.def->Merge(
+            uda_info.uda.get(), pane.udas_no_groups[i].uda.get(), function_ctx_.get()));
+      }
+    }
+    return EmitNoGroups(exec_state, merged, rb.eow(), rb.eos());
+  }
+
+  ObjectPool merged_pool("merged_udas_pool");
+  AggHashMap merged_hash_map;
+  FixedWidthKeyHashMap merged_fixed_width_hash_map;
+  auto merge_values = [&](AggHashValue* merged_val, const AggHashValue& val) -> Status {
+    for (const auto& [i, uda_info] : Enumerate(merged_val->udas)) {
+      PL_RETURN_IF_ERROR(
+          uda_info.def->Merge(uda_info.uda.get(), val.udas[i].uda.get(), function_ctx_.get()));
+    }
+    return Status::OK();
+  };
+  for (const auto& pane : panes_) {
+    // The merged maps point at the keys of the panes, which outlive them.
+    for (const auto& [rt, val] : pane.agg_hash_map) {
+      auto& merged_val = merged_hash_map[rt];
+      if (merged_val == nullptr) {
+        merged_val = CreateAggHashValue(exec_state, &merged_pool);
+      }
+      PL_RETURN_IF_ERROR(merge_values(merged_val, *val));
+    }
+    for (const auto& [key, val] : pane.fixed_width_agg_hash_map) {
+      auto& merged_val = merged_fixed_width_hash_map[key];
+      if (merged_val == nullptr) {
+        merged_val = CreateAggHashValue(exec_state, &merged_pool);
+      }
+      PL_RETURN_IF_ERROR(merge_values(merged_val, *val));
+    }
+  }
+
+  RowBatch output_rb(*output_descriptor_,
+                     merged_hash_map.size() + merged_fixed_width_hash_map.size());
+  PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, merged_hash_map,
+                                                 merged_fixed_width_hash_map, &output_rb));
+  output_rb.set_eow(rb.eow());
+  output_rb.set_eos(rb.eos());
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
+
+Status AggNode::EmitNoGroups(ExecState* exec_state, const std::vector<UDAInfo>& udas, bool eow,
+                             bool eos) {
+  RowBatch output_rb(*output_descriptor_, 1);
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders;
+  if (plan_node_->partial_output()) {
+    builders.push_back(types::MakeArrowBuilder(types::STRING, exec_state->exec_mem_pool()));
+  } else {
+    for (const auto& uda_info : udas) {
+      builders.push_back(types::MakeArrowBuilder(uda_info.def->finalize_return_type(),
+                                                 exec_state->exec_mem_pool()));
+    }
+  }
+  PL_RETURN_IF_ERROR(AppendAggValues(udas, builders));
+  for (const auto& builder : builders) {
+    SharedArray out_col;
+    PL_RETURN_IF_ERROR(builder->Finish(&out_col));
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(out_col));
+  }
+  output_rb.set_eow(eow);
+  output_rb.set_eos(eos);
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
+
+Status AggNode::AppendAggValues(const std::vector<UDAInfo>& udas,
+                                const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders) {
+  if (plan_node_->partial_output()) {
+    DCHECK_EQ(builders.size(), 1UL);
+    PL_ASSIGN_OR_RETURN(auto packed, SerializePartialAggregates(udas));
+    return static_cast<arrow::StringBuilder*>(builders[0].get())->Append(packed);
+  }
+  DCHECK_EQ(builders.size(), udas.size());
+  for (const auto& [i, uda_info] : Enumerate(udas)) {
     PL_RETURN_IF_ERROR(
-        EvaluateSingleExpressionNoGroups(exec_state, udas_no_groups_[i], values[i].get(), rb));
+        uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(), builders[i].get()));
   }
+  return Status::OK();
+}
 
-  if (ReadyToEmitBatches(rb)) {
-    RowBatch output_rb(*output_descriptor_, 1);
+StatusOr<types::StringValue> AggNode::SerializePartialAggregates(
+    const std::vector<UDAInfo>& udas) {
+  std::string packed;
+  for (const auto& uda_info : udas) {
+    types::StringValue partial;
+    PL_RETURN_IF_ERROR(uda_info.def->Serialize(uda_info.uda.get(), function_ctx_.get(), &partial));
+    AppendPartial(&packed, partial);
+  }
+  return types::StringValue(std::move(packed));
+}
+
+Status AggNode::MergePartialAggregates(const std::vector<UDAInfo>& udas, std::string_view packed) {
+  for (const auto& uda_info : udas) {
+    PL_ASSIGN_OR_RETURN(std::string_view partial_data, NextPartial(&packed));
+    auto partial = uda_info.def->Make();
+    PL_RETURN_IF_ERROR(uda_info.def->Deserialize(partial.get(), function_ctx_.get(),
+                                                 types::StringValue(partial_data)));
+    PL_RETURN_IF_ERROR(uda_info.def->Merge(uda_info.uda.get(), partial.get(), function_ctx_.get()));
+  }
+  if (!packed.empty()) {
+    return error::InvalidArgument("Partial aggregate has more values than the aggregate");
+  }
+  return Status::OK();
+}
+
+Status AggNode::MergePartialAggregatesNoGroups(const RowBatch& rb) {
+  const auto* col =
+      static_cast<const arrow::StringArray*>(rb.ColumnAt(partial_input_col_idx_).get());
+  for (int64_t i = 0; i < col->length(); ++i) {
+    int32_t length;
+    const uint8_t* value = col->GetValue(i, &length);
+    PL_RETURN_IF_ERROR(MergePartialAggregates(
+        udas_no_groups_, std::string_view(reinterpret_cast<const char*>(value), length)));
+  }
+  return Status::OK();
+}
+
+Status AggNode::AggregateGroupByNone(ExecState* exec_state, const RowBatch& rb) {
+  auto values = plan_node_->values();
+  if (plan_node_->partial_input()) {
+    PL_RETURN_IF_ERROR(MergePartialAggregatesNoGroups(rb));
+  } else {
     for (size_t i = 0; i < values.size(); ++i) {
-      const auto& uda_info = udas_no_groups_[i];
-      auto builder = types::MakeArrowBuilder(uda_info.def->finalize_return_type(),
-                                             exec_state->exec_mem_pool());
       PL_RETURN_IF_ERROR(
-          uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(), builder.get()));
-      SharedArray out_col;
-      PL_RETURN_IF_ERROR(builder->Finish(&out_col));
-      PL_RETURN_IF_ERROR(output_rb.AddColumn(out_col));
+          EvaluateSingleExpressionNoGroups(exec_state, udas_no_groups_[i], values[i].get(), rb));
     }
-    output_rb.set_eow(rb.eow());
-    output_rb.set_eos(rb.eos());
-    PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
+  }
+
+  if (ReadyToEmitBatches(rb)) {
+    if (IsSlidingWindow()) {
+      return EmitSlidingWindow(exec_state, rb);
+    }
+    PL_RETURN_IF_ERROR(EmitNoGroups(exec_state, udas_no_groups_, rb.eow(), rb.eos()));
     PL_RETURN_IF_ERROR(ClearAggState(exec_state));
+  } else if (SnapshotDue(rb)) {
+    PL_RETURN_IF_ERROR(EmitSnapshot(exec_state));
   }
   return Status::OK();
 }
@@ -245,7 +522,7 @@ Status AggNode::HashRowBatch(ExecState* exec_state, const RowBatch& rb) {
     // If not in hash then insert
     if (it == agg_hash_map_.end()) {
       // Create a val array.
-      val = CreateAggHashValue(exec_state);
+      val = CreateAggHashValue(exec_state, udas_pool_.get());
       agg_hash_map_[ga.rt] = val;
       // We have inserted this, so the stored RowTuple is now in the table.
       ga.rt = nullptr;
@@ -255,7 +532,49 @@ Status AggNode::HashRowBatch(ExecState* exec_state, const RowBatch& rb) {
     ga.av = val;
   }
 
-  auto values = plan_node_->values();
+  return ExtractValuesForBatch(rb);
+}
+
+Status AggNode::ExtractFixedWidthKeysForBatch(const RowBatch& rb) {
+  size_t num_rows = rb.num_rows();
+  size_t num_groups = group_data_types_.size();
+  if (group_args_chunk_.size() < num_rows) {
+    group_args_chunk_.resize(num_rows, GroupArgs(nullptr));
+  }
+  fixed_width_keys_chunk_.resize(num_rows * num_groups);
+  // Zero the keys so that any padding in smaller values doesn't affect hashing and comparison.
+  memset(reinterpret_cast<uint8_t*>(fixed_width_keys_chunk_.data()), 0,
+         sizeof(types::FixedSizeValueUnion) * fixed_width_keys_chunk_.size());
+
+  for (size_t idx = 0; idx < num_groups; idx++) {
+    auto grp = plan_node_->groups()[idx];
+    DCHECK(grp.idx < input_descriptor_->size());
+    auto col = rb.ColumnAt(grp.idx).get();
+#define TYPE_CASE(_dt_) \
+  ExtractIntoFixedWidthKeys<_dt_>(col, num_groups, idx, fixed_width_keys_chunk_.data());
+    PL_SWITCH_FOREACH_DATATYPE(group_data_types_[idx], TYPE_CASE);
+#undef TYPE_CASE
+  }
+  return Status::OK();
+}
+
+Status AggNode::HashRowBatchFixedWidth(ExecState* exec_state, const RowBatch& rb) {
+  size_t key_size = sizeof(types::FixedSizeValueUnion) * group_data_types_.size();
+  const char* keys = reinterpret_cast<const char*>(fixed_width_keys_chunk_.data());
+  for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+    std::string_view key(keys + row_idx * key_size, key_size);
+    auto it = fixed_width_agg_hash_map_.find(key);
+    if (it == fixed_width_agg_hash_map_.end()) {
+      it = fixed_width_agg_hash_map_
+               .emplace(std::string(key), CreateAggHashValue(exec_state, udas_pool_.get()))
+               .first;
+    }
+    group_args_chunk_[row_idx].av = it->second;
+  }
+  return ExtractValuesForBatch(rb);
+}
+
+Status AggNode::ExtractValuesForBatch(const RowBatch& rb) {
   // Now extract the values in the agg hash value.
   for (size_t i = 0; i < stored_cols_data_types_.size(); ++i) {
     const auto& rb_col_idx = stored_cols_to_plan_idx_[i];
@@ -291,6 +610,10 @@ Status AggNode::ResetGroupArgs() {
   // agg hash value to nullptr.
   for (size_t i = 0; i < group_args_chunk_.size(); ++i) {
     group_args_chunk_[i].av = nullptr;
+    if (use_fixed_width_keys_) {
+      // Fixed width keys don't use RowTuples.
+      continue;
+    }
     if (group_args_chunk_[i].rt == nullptr) {
       group_args_chunk_[i].rt = CreateGroupArgsRowTuple();
     } else {
@@ -300,7 +623,9 @@ Status AggNode::ResetGroupArgs() {
   return Status::OK();
 }
 
-Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* output_rb) {
+Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, const AggHashMap& agg_hash_map,
+                                            const FixedWidthKeyHashMap& fixed_width_agg_hash_map,
+                                            RowBatch* output_rb) {
   PL_UNUSED(exec_state);
   DCHECK(output_rb != nullptr);
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> group_builders;
@@ -312,8 +637,14 @@ Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* out
     value_builders.push_back(types::MakeArrowBuilder(value_data_type, exec_state->exec_mem_pool()));
   }
 
+  auto finalize_values = [&](AggHashValue* val) -> Status {
+    // Actually Finalize the UDA based on the column wrapper chunks.
+    PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, val));
+    return AppendAggValues(val->udas, value_builders);
+  };
+
   // Agg into agg values and emit!
-  for (const auto& kv : agg_hash_map_) {
+  for (const auto& kv : agg_hash_map) {
     auto* groups_rt = kv.first;
     auto* val = kv.second;
 
@@ -324,13 +655,17 @@ Status AggNode::ConvertAggHashMapToRowBatch(ExecState* exec_state, RowBatch* out
       PL_SWITCH_FOREACH_DATATYPE(group_data_types_[i], TYPE_CASE);
 #undef TYPE_CASE
     }
-    // Actually Finalize the UDA based on the column wrapper chunks.
-    PL_RETURN_IF_ERROR(EvaluateAggHashValue(exec_state, val));
-    for (size_t i = 0; i < val->udas.size(); ++i) {
-      const auto& uda_info = val->udas[i];
-      PL_RETURN_IF_ERROR(uda_info.def->FinalizeArrow(uda_info.uda.get(), function_ctx_.get(),
-                                                     value_builders[i].get()));
+    PL_RETURN_IF_ERROR(finalize_values(val));
+  }
+
+  for (const auto& [key, val] : fixed_width_agg_hash_map) {
+    const auto* key_values = reinterpret_cast<const types::FixedSizeValueUnion*>(key.data());
+    for (size_t i = 0; i < group_data_types_.size(); ++i) {
+#define TYPE_CASE(_dt_) AppendFixedWidthKeyToBuilder<_dt_>(group_builders[i].get(), key_values[i]);
+      PL_SWITCH_FOREACH_DATATYPE(group_data_types_[i], TYPE_CASE);
+#undef TYPE_CASE
     }
+    PL_RETURN_IF_ERROR(finalize_values(val));
   }
 
   for (const auto& group_builder : group_builders) {
@@ -357,23 +692,75 @@ Status AggNode::AggregateGroupByClause(ExecState* exec_state, const RowBatch& rb
   // 3. If the agg values are large then run aggregate and compact.
   // 4. Reset state to prepare for next row batch.
   // 5. If it's the last batch then emit the values.
-  PL_RETURN_IF_ERROR(ExtractRowTupleForBatch(rb));
-  PL_RETURN_IF_ERROR(HashRowBatch(exec_state, rb));
+  if (use_fixed_width_keys_) {
+    PL_RETURN_IF_ERROR(ExtractFixedWidthKeysForBatch(rb));
+    PL_RETURN_IF_ERROR(HashRowBatchFixedWidth(exec_state, rb));
+  } else {
+    PL_RETURN_IF_ERROR(ExtractRowTupleForBatch(rb));
+    PL_RETURN_IF_ERROR(HashRowBatch(exec_state, rb));
+  }
   if (plan_node_->values().size() > 0) {
     PL_RETURN_IF_ERROR(EvaluatePartialAggregates(exec_state, rb.num_rows()));
   }
   PL_RETURN_IF_ERROR(ResetGroupArgs());
   if (ReadyToEmitBatches(rb)) {
-    RowBatch output_rb(*output_descriptor_, agg_hash_map_.size());
-    PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, &output_rb));
+    if (IsSlidingWindow()) {
+      return EmitSlidingWindow(exec_state, rb);
+    }
+    RowBatch output_rb(*output_descriptor_, NumGroups());
+    PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, agg_hash_map_,
+                                                   fixed_width_agg_hash_map_, &output_rb));
     output_rb.set_eow(rb.eow());
     output_rb.set_eos(rb.eos());
     PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
     PL_RETURN_IF_ERROR(ClearAggState(exec_state));
+  } else if (SnapshotDue(rb)) {
+    PL_RETURN_IF_ERROR(EmitSnapshot(exec_state));
   }
   return Status::OK();
 }
 
+Status AggNode::AggregateTimeBins(ExecState* exec_state, const RowBatch& rb) {
+  // Both times and ints are held in int64 arrays.
+  const auto* bins = static_cast<const arrow::Int64Array*>(rb.ColumnAt(time_bin_col_idx_).get());
+  auto aggregate_rows = [&](int64_t offset, int64_t length, bool last) -> Status {
+    RowBatch rows(*input_descriptor_, length);
+    for (int64_t col_idx = 0; col_idx < rb.num_columns(); ++col_idx) {
+      PL_RETURN_IF_ERROR(rows.AddColumn(rb.ColumnAt(col_idx)->Slice(offset, length)));
+    }
+    rows.set_eow(last && rb.eow());
+    rows.set_eos(last && rb.eos());
+    return AggregateGroupByClause(exec_state, rows);
+  };
+
+  int64_t start = 0;
+  for (int64_t i = 0; i < rb.num_rows(); ++i) {
+    int64_t bin = bins->Value(i);
+    if (bin <= current_time_bin_) {
+      continue;
+    }
+    // The input is past the bins of every group held so far.
+    if (i > start) {
+      PL_RETURN_IF_ERROR(aggregate_rows(start, i - start, /*last*/ false));
+    }
+    if (NumGroups() > 0) {
+      RowBatch output_rb(*output_descriptor_, NumGroups());
+      PL_RETURN_IF_ERROR(ConvertAggHashMapToRowBatch(exec_state, agg_hash_map_,
+                                                     fixed_width_agg_hash_map_, &output_rb));
+      output_rb.set_eow(false);
+      output_rb.set_eos(false);
+      PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
+      PL_RETURN_IF_ERROR(ClearAggState(exec_state));
+    }
+    current_time_bin_ = bin;
+    start = i;
+  }
+  if (start == 0) {
+    return AggregateGroupByClause(exec_state, rb);
+  }
+  return aggregate_rows(start, rb.num_rows() - start, /*last*/ true);
+}
+
 StatusOr<types::DataType> AggNode::GetTypeOfDep(const plan::ScalarExpression& expr) const {
   // Agg exprs can only be of type col, or  const.
   switch (expr.ExpressionType()) {
@@ -432,6 +819,18 @@ Status AggNode::EvaluateSingleExpressionNoGroups(ExecState* exec_state, const UD
 }
 
 Status AggNode::EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val) {
+  if (plan_node_->partial_input()) {
+    if (val->agg_cols.empty()) {
+      return Status::OK();
+    }
+    const auto* partials =
+        static_cast<const types::StringValueColumnWrapper*>(val->agg_cols[0].get());
+    for (size_t i = 0; i < partials->Size(); ++i) {
+      PL_RETURN_IF_ERROR(MergePartialAggregates(val->udas, (*partials)[i]));
+    }
+    val->agg_cols[0]->Clear();
+    return Status::OK();
+  }
   size_t values_size = plan_node_->values().size();
   for (size_t i = 0; i < values_size; ++i) {
     const auto& uda_info = val->udas[i];
@@ -481,6 +880,15 @@ Status AggNode::EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val) {
 }
 
 Status AggNode::CreateColumnMapping() {
+  if (plan_node_->partial_input()) {
+    // The packed partials are the only column needed to merge the partial aggregates.
+    if (!plan_node_->values().empty()) {
+      plan_cols_to_stored_map_[partial_input_col_idx_] = 0;
+      stored_cols_to_plan_idx_.emplace_back(partial_input_col_idx_);
+      stored_cols_data_types_.emplace_back(types::STRING);
+    }
+    return Status::OK();
+  }
   for (const auto& expr : plan_node_->values()) {
     plan::ExpressionWalker<int> walker;
 
@@ -506,8 +914,8 @@ Status AggNode::CreateColumnMapping() {
   return Status::OK();
 }
 
-AggHashValue* AggNode::CreateAggHashValue(ExecState* exec_state) {
-  auto* val = udas_pool_.Add(new AggHashValue);
+AggHashValue* AggNode::CreateAggHashValue(ExecState* exec_state, ObjectPool* pool) {
+  auto* val = pool->Make<AggHashValue>();
   PL_CHECK_OK(CreateUDAInfoValues(&(val->udas), exec_state));
   for (const auto& dt : stored_cols_data_types_) {
     val->agg_cols.emplace_back(types::ColumnWrapper::Make(dt, 0));
@@ -520,11 +928,14 @@ Status AggNode::CreateUDAInfoValues(std::vector<UDAInfo>* val, ExecState* exec_s
   CHECK_EQ(val->size(), 0ULL);
 
   for (const auto& value : plan_node_->values()) {
-    std::vector<types::DataType> types;
-    types.reserve(value->Deps().size());
-    for (auto* dep : value->Deps()) {
-      PL_ASSIGN_OR_RETURN(auto type, GetTypeOfDep(*dep));
-      types.push_back(type);
+    // The arguments of partial inputs refer to the columns before the partial aggregate.
+    if (!plan_node_->partial_input()) {
+      std::vector<types::DataType> types;
+      types.reserve(value->Deps().size());
+      for (auto* dep : value->Deps()) {
+        PL_ASSIGN_OR_RETURN(auto type, GetTypeOfDep(*dep));
+        types.push_back(type);
+      }
     }
     auto def = exec_state->GetUDADefinition(value->uda_id());
     auto uda = def->Make();
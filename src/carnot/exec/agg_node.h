@@ -17,13 +17,19 @@
  */
 
 #pragma once
+#include <chrono>
 #include <cstddef>
+#include <deque>
+#include <limits>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
@@ -40,6 +46,8 @@
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_bool(carnot_agg_fixed_width_keys);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -65,6 +73,20 @@ struct GroupArgs {
 
 class AggNode : public ProcessingNode {
   using AggHashMap = AbslRowTupleHashMap<AggHashValue*>;
+  // Hash map used when every group column is fixed size (ie. no strings). Keys are the group
+  // values of a row packed into contiguous FixedSizeValueUnions, which lets us look up a whole
+  // batch of rows without allocating a RowTuple per row.
+  using FixedWidthKeyHashMap = absl::flat_hash_map<std::string, AggHashValue*>;
+
+  // The aggregate state of one closed window of a sliding windowed aggregate. The pools are
+  // declared first so that they outlive the maps that point into them.
+  struct AggPane {
+    std::unique_ptr<ObjectPool> group_args_pool;
+    std::unique_ptr<ObjectPool> udas_pool;
+    std::vector<UDAInfo> udas_no_groups;
+    AggHashMap agg_hash_map;
+    FixedWidthKeyHashMap fixed_width_agg_hash_map;
+  };
 
  public:
   AggNode() = default;
@@ -73,6 +95,9 @@ class AggNode : public ProcessingNode {
  protected:
   Status AggregateGroupByNone(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status AggregateGroupByClause(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Aggregates rb like AggregateGroupByClause, except that the groups held so far are emitted and
+  // freed whenever a row of a later time bin arrives.
+  Status AggregateTimeBins(ExecState* exec_state, const table_store::schema::RowBatch& rb);
 
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -84,13 +109,32 @@ class AggNode : public ProcessingNode {
 
  private:
   AggHashMap agg_hash_map_;
+  FixedWidthKeyHashMap fixed_width_agg_hash_map_;
+  size_t max_groups_ = 0;
+  double max_load_factor_ = 0;
   bool HasNoGroups() const { return plan_node_->groups().empty(); }
+  size_t NumGroups() const {
+    return use_fixed_width_keys_ ? fixed_width_agg_hash_map_.size() : agg_hash_map_.size();
+  }
   // ReadyToEmitBatches returns true when the input stream has reached a point where output batches
   // can be emitted. In the windowed aggregate case, this happens whenever end of window (eow) is
   // reached. In the blocking aggregate case, this happens at eos only.
   bool ReadyToEmitBatches(const table_store::schema::RowBatch& rb) const;
-  // When we see a new window, we need to be able to clear the aggregate state.
-  Status ClearAggState(ExecState* exec_state);
+  // Keeps the largest group count and load factor of the hash map, for the exec stats.
+  void RecordHashMapStats();
+  // When we see a new window, we need to be able to clear the aggregate state. If pane is not null,
+  // the cleared state is moved into it instead of being dropped.
+  Status ClearAggState(ExecState* exec_state, AggPane* pane = nullptr);
+  // Whether results cover several consecutive windows, ie. the aggregate slides by one window.
+  bool IsSlidingWindow() const { return window_panes_ > 1; }
+  // Closes the current window as a pane, and emits the merged aggregates of the last
+  // window_panes_ panes.
+  Status EmitSlidingWindow(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  Status EmitNoGroups(ExecState* exec_state, const std::vector<UDAInfo>& udas, bool eow, bool eos);
+  // Whether a blocking aggregate should emit a snapshot of its results so far after consuming rb.
+  bool SnapshotDue(const table_store::schema::RowBatch& rb) const;
+  // Emits the results so far as a complete window, without clearing the aggregate state.
+  Status EmitSnapshot(ExecState* exec_state);
 
   Status EvaluateSingleExpressionNoGroups(ExecState* exec_state, const UDAInfo& uda_info,
                                           plan::AggregateExpression* expr,
@@ -98,12 +142,25 @@ class AggNode : public ProcessingNode {
   Status EvaluateAggHashValue(ExecState* exec_state, AggHashValue* val);
   StatusOr<types::DataType> GetTypeOfDep(const plan::ScalarExpression& expr) const;
 
+  // Partial aggregates hold the serialized states of all the UDAs of a group in a single string.
+  // Merges the packed partial aggregates into udas.
+  Status MergePartialAggregates(const std::vector<UDAInfo>& udas, std::string_view packed);
+  Status MergePartialAggregatesNoGroups(const table_store::schema::RowBatch& rb);
+  StatusOr<types::StringValue> SerializePartialAggregates(const std::vector<UDAInfo>& udas);
+  // Appends the value of each UDA to the builders, either finalized or as a packed partial
+  // aggregate.
+  Status AppendAggValues(const std::vector<UDAInfo>& udas,
+                         const std::vector<std::unique_ptr<arrow::ArrayBuilder>>& builders);
+
   // Store information about aggregate node from the query planner.
   std::unique_ptr<plan::AggregateOperator> plan_node_;
   std::unique_ptr<table_store::schema::RowDescriptor> input_descriptor_;
 
   std::unique_ptr<udf::FunctionContext> function_ctx_;
 
+  // The input column with the packed partial aggregates, when the input holds partials.
+  int64_t partial_input_col_idx_ = -1;
+
   // Variables specific to GroupByNone Agg.
   std::vector<UDAInfo> udas_no_groups_;
   // END: Variables specific to GroupByNone Agg.
@@ -121,8 +178,21 @@ class AggNode : public ProcessingNode {
   // 3. The data type of the stored colums, by the index they are stored at.
   std::vector<types::DataType> stored_cols_data_types_;
 
-  ObjectPool group_args_pool_{"group_args_pool"};
-  ObjectPool udas_pool_{"udas_pool"};
+  std::unique_ptr<ObjectPool> group_args_pool_ = std::make_unique<ObjectPool>("group_args_pool");
+  std::unique_ptr<ObjectPool> udas_pool_ = std::make_unique<ObjectPool>("udas_pool");
+
+  // The number of windows each result covers, 1 unless this is a sliding windowed aggregate.
+  int64_t window_panes_ = 1;
+  // The closed panes of a sliding window, oldest first. Holds at most window_panes_ panes.
+  std::deque<AggPane> panes_;
+
+  // For partial aggregates over time bins that arrive in increasing order, the input column of
+  // the time bins, or -1. The groups of all the bins up to current_time_bin_ are held.
+  int64_t time_bin_col_idx_ = -1;
+  int64_t current_time_bin_ = std::numeric_limits<int64_t>::min();
+
+  // When the last snapshot of a blocking aggregate was emitted, or when the node was opened.
+  std::chrono::steady_clock::time_point last_snapshot_time_;
 
   std::vector<types::DataType> group_data_types_;
   std::vector<types::DataType> value_data_types_;
@@ -131,6 +201,13 @@ class AggNode : public ProcessingNode {
   // This vector holds pointers to the row_tuples which are managed by the group_args_pool_.
 
   std::vector<GroupArgs> group_args_chunk_;
+
+  // Whether all the group columns are fixed size, in which case the group keys are stored in
+  // fixed_width_agg_hash_map_ instead of agg_hash_map_.
+  bool use_fixed_width_keys_ = false;
+  // The packed group keys of the current row batch, num_rows * num_groups values in row major
+  // order.
+  std::vector<types::FixedSizeValueUnion> fixed_width_keys_chunk_;
   // END: Variables specific to GroupBy Agg.
 
   // Creates a mapping between plan cols and stored cols (see above comment).
@@ -138,14 +215,18 @@ class AggNode : public ProcessingNode {
 
   Status ExtractRowTupleForBatch(const table_store::schema::RowBatch& rb);
   Status HashRowBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  Status ExtractFixedWidthKeysForBatch(const table_store::schema::RowBatch& rb);
+  Status HashRowBatchFixedWidth(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  Status ExtractValuesForBatch(const table_store::schema::RowBatch& rb);
   Status EvaluatePartialAggregates(ExecState* exec_state, size_t num_records);
   Status ResetGroupArgs();
-  Status ConvertAggHashMapToRowBatch(ExecState* exec_state,
+  Status ConvertAggHashMapToRowBatch(ExecState* exec_state, const AggHashMap& agg_hash_map,
+                                     const FixedWidthKeyHashMap& fixed_width_agg_hash_map,
                                      table_store::schema::RowBatch* output_rb);
 
-  AggHashValue* CreateAggHashValue(ExecState* exec_state);
+  AggHashValue* CreateAggHashValue(ExecState* exec_state, ObjectPool* pool);
   RowTuple* CreateGroupArgsRowTuple() {
-    return group_args_pool_.Add(new RowTuple(&group_data_types_));
+    return group_args_pool_->Make<RowTuple>(&group_data_types_);
   }
 
   Status CreateUDAInfoValues(std::vector<UDAInfo>* val, ExecState* exec_state);
@@ -19,7 +19,12 @@
 #include "src/carnot/exec/agg_node.h"
 
 #include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include <absl/strings/numbers.h>
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 #include <sole.hpp>
@@ -71,6 +76,39 @@ class MinSumWithInitUDA : public udf::UDA {
   types::Int64Value sum_ = 0;
 };
 
+// MinSumUDA with a partial aggregate representation, the decimal sum.
+class PartialMinSumUDA : public udf::UDA {
+ public:
+  void Update(udf::FunctionContext*, types::Int64Value arg1, types::Int64Value arg2) {
+    sum_ = sum_.val + std::min(arg1.val, arg2.val);
+  }
+  void Merge(udf::FunctionContext*, const PartialMinSumUDA& other) {
+    sum_ = sum_.val + other.sum_.val;
+  }
+  types::Int64Value Finalize(udf::FunctionContext*) { return sum_; }
+  types::StringValue Serialize(udf::FunctionContext*) { return absl::StrCat(sum_.val); }
+  Status Deserialize(udf::FunctionContext*, const types::StringValue& data) {
+    if (!absl::SimpleAtoi(data, &sum_.val)) {
+      return error::InvalidArgument("Invalid partial sum '$0'", data);
+    }
+    return Status::OK();
+  }
+
+ protected:
+  types::Int64Value sum_ = 0;
+};
+
+// Packs the partials of each UDA the way AggNode does.
+types::StringValue PackPartials(const std::vector<std::string>& partials) {
+  std::string packed;
+  for (const auto& partial : partials) {
+    uint32_t size = partial.size();
+    packed.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    packed.append(partial);
+  }
+  return packed;
+}
+
 constexpr char kBlockingNoGroupAgg[] = R"(
 op_type: AGGREGATE_OPERATOR
 agg_op {
@@ -120,6 +158,34 @@ agg_op {
   value_names: "value1"
 })";
 
+constexpr char kSnapshotSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 0
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "g1"
+  value_names: "value1"
+  snapshot_interval_ms: 1
+})";
+
 constexpr char kBlockingMultipleGroupAgg[] = R"(
 op_type: AGGREGATE_OPERATOR
 agg_op {
@@ -201,6 +267,57 @@ agg_op {
   value_names: "value1"
 })";
 
+constexpr char kSlidingWindowNoGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: true
+  window_panes: 2
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 0
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+  }
+  value_names: "value1"
+})";
+
+constexpr char kSlidingWindowSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: true
+  window_panes: 2
+  values {
+    name: "minsum"
+    args {
+      column {
+        node:0
+        index: 0
+      }
+    }
+    args {
+      column {
+        node:0
+        index: 1
+      }
+    }
+  }
+  groups {
+     node: 0
+     index: 0
+  }
+  group_names: "g1"
+  value_names: "value1"
+})";
+
 constexpr char kSingleGroupNoValues[] = R"(
 op_type: AGGREGATE_OPERATOR
 agg_op {
@@ -282,17 +399,111 @@ std::unique_ptr<plan::Operator> PlanNodeFromPbtxt(const std::string& pbtxt) {
   return plan::AggregateOperator::FromProto(op_pb, 1);
 }
 
+// The two partial aggregates of one group are packed together.
+constexpr char kPartialSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  partial_agg: true
+  finalize_results: false
+  values {
+    name: "partial_minsum"
+    id: 2
+    args { column { node:0 index: 0 } }
+    args { column { node:0 index: 1 } }
+  }
+  values {
+    name: "partial_minsum"
+    id: 2
+    args { column { node:0 index: 1 } }
+    args { column { node:0 index: 1 } }
+  }
+  groups { node: 0 index: 0 }
+  group_names: "g1"
+  value_names: "value1"
+  value_names: "value2"
+})";
+
+// The group holds time bins in increasing order.
+constexpr char kStreamingTimeBinsAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  partial_agg: true
+  finalize_results: false
+  streaming_time_bins: true
+  time_bin_group: 0
+  values {
+    name: "partial_minsum"
+    id: 2
+    args { column { node:0 index: 0 } }
+    args { column { node:0 index: 1 } }
+  }
+  values {
+    name: "partial_minsum"
+    id: 2
+    args { column { node:0 index: 1 } }
+    args { column { node:0 index: 1 } }
+  }
+  groups { node: 0 index: 0 }
+  group_names: "g1"
+  value_names: "value1"
+  value_names: "value2"
+})";
+
+constexpr char kFinalizeSingleGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  partial_agg: false
+  finalize_results: true
+  values {
+    name: "partial_minsum"
+    id: 2
+    args { column { node:0 index: 0 } }
+    args { column { node:0 index: 1 } }
+  }
+  values {
+    name: "partial_minsum"
+    id: 2
+    args { column { node:0 index: 1 } }
+    args { column { node:0 index: 1 } }
+  }
+  groups { node: 0 index: 0 }
+  group_names: "g1"
+  value_names: "value1"
+  value_names: "value2"
+})";
+
+constexpr char kMergePartialsNoGroupAgg[] = R"(
+op_type: AGGREGATE_OPERATOR
+agg_op {
+  windowed: false
+  partial_agg: true
+  finalize_results: false
+  merge_partials: true
+  values {
+    name: "partial_minsum"
+    id: 2
+    args { column { node:0 index: 0 } }
+    args { column { node:0 index: 1 } }
+  }
+  value_names: "value1"
+})";
+
 class AggNodeTest : public ::testing::Test {
  public:
   AggNodeTest() {
     func_registry_ = std::make_unique<udf::Registry>("test");
     EXPECT_TRUE(func_registry_->Register<MinSumUDA>("minsum").ok());
     EXPECT_TRUE(func_registry_->Register<MinSumWithInitUDA>("minsum_w_init").ok());
+    EXPECT_TRUE(func_registry_->Register<PartialMinSumUDA>("partial_minsum").ok());
 
     exec_state_ = MakeTestExecState(func_registry_.get());
     EXPECT_OK(exec_state_->AddUDA(0, "minsum",
                                   std::vector<types::DataType>({types::INT64, types::INT64})));
     EXPECT_OK(exec_state_->AddUDA(1, "minsum_w_init", {types::INT64, types::INT64, types::INT64}));
+    EXPECT_OK(exec_state_->AddUDA(2, "partial_minsum", {types::INT64, types::INT64}));
   }
 
  protected:
@@ -382,6 +593,42 @@ TEST_F(AggNodeTest, single_group_blocking) {
       .Close();
 }
 
+TEST_F(AggNodeTest, single_group_blocking_snapshots) {
+  auto plan_node = PlanNodeFromPbtxt(kSnapshotSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  // Once the interval has passed, the groups seen so far are emitted as a complete window.
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 1, 2, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 3, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, false)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({2, 3})
+                          .get(),
+                      false)
+      // The snapshot doesn't reset the aggregates, so the final results cover every row.
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({5, 6, 3, 4})
+                       .AddColumn<types::Int64Value>({1, 5, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                          .AddColumn<types::Int64Value>({2, 3, 3, 4, 1, 5})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, multiple_groups_blocking) {
   auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
@@ -413,6 +660,72 @@ TEST_F(AggNodeTest, multiple_groups_blocking) {
       .Close();
 }
 
+TEST_F(AggNodeTest, multiple_groups_blocking_row_tuple_keys) {
+  FLAGS_carnot_agg_fixed_width_keys = false;
+  auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  FLAGS_carnot_agg_fixed_width_keys = true;
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 5, 1, 2})
+                       .AddColumn<types::Int64Value>({2, 1, 3, 1})
+                       .AddColumn<types::Int64Value>({2, 5, 3, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({5, 1, 3, 3})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 3})
+                       .AddColumn<types::Int64Value>({1, 3, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, true, true)
+                          .AddColumn<types::Int64Value>({1, 1, 2, 5, 3})
+                          .AddColumn<types::Int64Value>({2, 3, 1, 1, 3})
+                          .AddColumn<types::Int64Value>({4, 3, 1, 2, 6})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, multiple_groups_with_mixed_fixed_width_keys) {
+  auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
+  RowDescriptor input_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Time64NSValue>({10, 50, 10, 20})
+                       .AddColumn<types::Int64Value>({2, 1, 3, 1})
+                       .AddColumn<types::Int64Value>({2, 5, 3, 1})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Time64NSValue>({50, 10, 30, 30})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 3})
+                       .AddColumn<types::Int64Value>({1, 3, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 5, true, true)
+                          .AddColumn<types::Time64NSValue>({10, 10, 20, 50, 30})
+                          .AddColumn<types::Int64Value>({2, 3, 1, 1, 3})
+                          .AddColumn<types::Int64Value>({4, 3, 1, 2, 6})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, multiple_groups_with_string_blocking) {
   auto plan_node = PlanNodeFromPbtxt(kBlockingMultipleGroupAgg);
   RowDescriptor input_rd({types::DataType::STRING, types::DataType::INT64, types::DataType::INT64});
@@ -529,6 +842,141 @@ TEST_F(AggNodeTest, single_group_windowed) {
       .Close();
 }
 
+TEST_F(AggNodeTest, no_groups_sliding_window) {
+  auto plan_node = PlanNodeFromPbtxt(kSlidingWindowNoGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .AddColumn<types::Int64Value>({2, 5, 6, 8})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, false)
+                       .AddColumn<types::Int64Value>({5, 6, 3, 4})
+                       .AddColumn<types::Int64Value>({1, 5, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, false)
+                          .AddColumn<types::Int64Value>({Int64Value(23)})
+                          .get(),
+                      false)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, false)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::Int64Value>({2, 5})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, false)
+                          .AddColumn<types::Int64Value>({Int64Value(26)})
+                          .get(),
+                      false)
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, true, true)
+                       .AddColumn<types::Int64Value>({7})
+                       .AddColumn<types::Int64Value>({1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::Int64Value>({Int64Value(4)})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, single_group_sliding_window) {
+  auto plan_node = PlanNodeFromPbtxt(kSlidingWindowSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ true, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 1, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, false)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({2, 1})
+                          .get(),
+                      false)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, false)
+                       .AddColumn<types::Int64Value>({2, 3})
+                       .AddColumn<types::Int64Value>({5, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, false)
+                          .AddColumn<types::Int64Value>({1, 2, 3})
+                          .AddColumn<types::Int64Value>({2, 3, 1})
+                          .get(),
+                      false)
+      // The first window slides out, so group 1 is gone.
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, true, true)
+                       .AddColumn<types::Int64Value>({3})
+                       .AddColumn<types::Int64Value>({4})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({2, 3})
+                          .AddColumn<types::Int64Value>({2, 4})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, single_group_sliding_window_row_tuple_keys) {
+  FLAGS_carnot_agg_fixed_width_keys = false;
+  auto plan_node = PlanNodeFromPbtxt(kSlidingWindowSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  FLAGS_carnot_agg_fixed_width_keys = true;
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ true, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 1, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, false)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::Int64Value>({2, 1})
+                          .get(),
+                      false)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, false)
+                       .AddColumn<types::Int64Value>({2, 3})
+                       .AddColumn<types::Int64Value>({5, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, false)
+                          .AddColumn<types::Int64Value>({1, 2, 3})
+                          .AddColumn<types::Int64Value>({2, 3, 1})
+                          .get(),
+                      false)
+      // The first window slides out, so group 1 is gone.
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, true, true)
+                       .AddColumn<types::Int64Value>({3})
+                       .AddColumn<types::Int64Value>({4})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({2, 3})
+                          .AddColumn<types::Int64Value>({2, 4})
+                          .get(),
+                      false)
+      .Close();
+}
+
 TEST_F(AggNodeTest, no_aggregate_expressions) {
   auto plan_node = PlanNodeFromPbtxt(kSingleGroupNoValues);
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
@@ -610,6 +1058,145 @@ TEST_F(AggNodeTest, single_group_blocking_init_args) {
       .Close();
 }
 
+TEST_F(AggNodeTest, single_group_partial_agg) {
+  auto plan_node = PlanNodeFromPbtxt(kPartialSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::STRING});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 1, 2, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 3, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .AddColumn<types::StringValue>(
+                              {PackPartials({"2", "5"}), PackPartials({"3", "4"})})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, streaming_time_bins) {
+  auto plan_node = PlanNodeFromPbtxt(kStreamingTimeBinsAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::STRING});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  // Each bin is emitted as soon as a row of a later bin arrives, before eos.
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 1, 2})
+                       .AddColumn<types::Int64Value>({2, 3, 3})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, false, false)
+                          .AddColumn<types::Int64Value>({1})
+                          .AddColumn<types::StringValue>({PackPartials({"2", "5"})})
+                          .get(),
+                      false)
+      // Late rows of an emitted bin form a new group, which is emitted with the bins after it.
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, true, true)
+                       .AddColumn<types::Int64Value>({2, 3, 1, 3})
+                       .AddColumn<types::Int64Value>({1, 4, 1, 1})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, false, false)
+                          .AddColumn<types::Int64Value>({2})
+                          .AddColumn<types::StringValue>({PackPartials({"3", "4"})})
+                          .get(),
+                      false)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 3})
+                          .AddColumn<types::StringValue>(
+                              {PackPartials({"1", "1"}), PackPartials({"4", "5"})})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, single_group_finalize_partials) {
+  auto plan_node = PlanNodeFromPbtxt(kFinalizeSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::STRING});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  // The partials of two agents.
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ true, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .AddColumn<types::StringValue>(
+                           {PackPartials({"2", "5"}), PackPartials({"3", "4"})})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, true)
+                       .AddColumn<types::Int64Value>({1, 3})
+                       .AddColumn<types::StringValue>(
+                           {PackPartials({"10", "1"}), PackPartials({"7", "7"})})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 3})
+                          .AddColumn<types::Int64Value>({12, 3, 7})
+                          .AddColumn<types::Int64Value>({6, 4, 7})
+                          .get(),
+                      false)
+      .Close();
+}
+
+TEST_F(AggNodeTest, single_group_finalize_invalid_partials) {
+  auto plan_node = PlanNodeFromPbtxt(kFinalizeSingleGroupAgg);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::STRING});
+
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  // Only one of the two partials.
+  auto rb = RowBatchBuilder(input_rd, 1, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>({1})
+                .AddColumn<types::StringValue>({PackPartials({"2"})})
+                .get();
+  EXPECT_NOT_OK(tester.node()->ConsumeNext(exec_state_.get(), rb, 0));
+}
+
+TEST_F(AggNodeTest, no_groups_merge_partials) {
+  auto plan_node = PlanNodeFromPbtxt(kMergePartialsNoGroupAgg);
+  RowDescriptor input_rd({types::DataType::STRING});
+
+  RowDescriptor output_rd({types::DataType::STRING});
+
+  auto tester = exec::ExecNodeTester<AggNode, plan::AggregateOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::StringValue>({PackPartials({"2"}), PackPartials({"5"})})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 1, true, true)
+                       .AddColumn<types::StringValue>({PackPartials({"4"})})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::StringValue>({PackPartials({"11"})})
+                          .get(),
+                      false)
+      .Close();
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -0,0 +1,357 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/as_of_join_node.h"
+
+#include <arrow/array.h>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/str_join.h>
+#include <absl/strings/substitute.h>
+
+#include "src/carnot/exec/equijoin_node.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/udf_wrapper.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+namespace {
+
+template <types::DataType DT>
+Status AppendRowTupleValue(arrow::ArrayBuilder* builder, const RowTuple& rt, size_t idx) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  return table_store::schema::CopyValue<DT>(builder, udf::UnWrap(rt.GetValue<ValueType>(idx)));
+}
+
+template <types::DataType DT>
+Status AppendDefaultValue(arrow::ArrayBuilder* builder) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  ValueType zeroval;
+  return table_store::schema::CopyValue<DT>(builder, udf::UnWrap(zeroval));
+}
+
+}  // namespace
+
+std::string AsOfJoinNode::DebugStringImpl() {
+  return absl::Substitute("Exec::AsOfJoinNode<$0>", absl::StrJoin(plan_node_->column_names(), ","));
+}
+
+Status AsOfJoinNode::InitImpl(const plan::Operator& plan_node) {
+  CHECK(plan_node.op_type() == planpb::OperatorType::JOIN_OPERATOR);
+  if (input_descriptors_.size() != 2) {
+    return error::InvalidArgument("Join operator expects a two input relations, got $0",
+                                  input_descriptors_.size());
+  }
+  const auto* join_plan_node = static_cast<const plan::JoinOperator*>(&plan_node);
+  plan_node_ = std::make_unique<plan::JoinOperator>(*join_plan_node);
+  DCHECK(plan_node_->as_of());
+  output_rows_per_batch_ =
+      plan_node_->rows_per_batch() == 0 ? kDefaultJoinRowBatchSize : plan_node_->rows_per_batch();
+  tolerance_ns_ = plan_node_->as_of_tolerance_ns();
+
+  switch (plan_node_->type()) {
+    case planpb::JoinOperator::INNER:
+      emit_unmatched_left_rows_ = false;
+      break;
+    case planpb::JoinOperator::LEFT_OUTER:
+      emit_unmatched_left_rows_ = true;
+      break;
+    default:
+      return error::Internal(absl::Substitute("AsOfJoinNode: Unsupported Join Type $0",
+                                              static_cast<int>(plan_node_->type())));
+  }
+
+  left_spec_.time_index = plan_node_->left_time_column_index();
+  right_spec_.time_index = plan_node_->right_time_column_index();
+  if (input_descriptors_[0].type(left_spec_.time_index) != types::DataType::TIME64NS ||
+      input_descriptors_[1].type(right_spec_.time_index) != types::DataType::TIME64NS) {
+    return error::InvalidArgument("As-of join time columns must be of type TIME64NS.");
+  }
+
+  for (const auto& eq_condition : plan_node_->equality_conditions()) {
+    int64_t left_index = eq_condition.left_column_index();
+    int64_t right_index = eq_condition.right_column_index();
+
+    CHECK_EQ(input_descriptors_[0].type(left_index), input_descriptors_[1].type(right_index));
+    key_data_types_.emplace_back(input_descriptors_[0].type(left_index));
+    left_spec_.key_indices.emplace_back(left_index);
+    right_spec_.key_indices.emplace_back(right_index);
+  }
+
+  const auto& output_cols = plan_node_->output_columns();
+  for (size_t i = 0; i < output_cols.size(); ++i) {
+    auto parent_index = output_cols[i].parent_index();
+    auto input_column_index = output_cols[i].column_index();
+
+    TableSpec& selected_spec = parent_index == 0 ? left_spec_ : right_spec_;
+    selected_spec.input_col_indices.emplace_back(input_column_index);
+    selected_spec.input_col_types.emplace_back(
+        input_descriptors_[parent_index].type(input_column_index));
+    selected_spec.output_col_indices.emplace_back(i);
+  }
+
+  left_row_scratch_ = std::make_unique<RowTuple>(&left_spec_.input_col_types);
+  return Status::OK();
+}
+
+Status AsOfJoinNode::InitializeColumnBuilders(ExecState* exec_state) {
+  for (size_t i = 0; i < output_descriptor_->size(); ++i) {
+    column_builders_[i] =
+        MakeArrowBuilder(output_descriptor_->type(i), exec_state->exec_mem_pool());
+    PL_RETURN_IF_ERROR(column_builders_[i]->Reserve(output_rows_per_batch_));
+  }
+  return Status::OK();
+}
+
+Status AsOfJoinNode::PrepareImpl(ExecState* exec_state) {
+  column_builders_.resize(output_descriptor_->size());
+  return InitializeColumnBuilders(exec_state);
+}
+
+Status AsOfJoinNode::OpenImpl(ExecState* /*exec_state*/) { return Status::OK(); }
+
+Status AsOfJoinNode::CloseImpl(ExecState* /*exec_state*/) {
+  stats()->AddExtraMetric("left_rows", left_rows_);
+  stats()->AddExtraMetric("right_rows", right_rows_);
+  stats()->AddExtraMetric("keys", key_states_.size());
+  stats()->AddExtraMetric("max_pending_left_rows", max_pending_left_rows_);
+
+  key_states_.clear();
+  keys_chunk_.clear();
+  free_right_rows_.clear();
+  key_values_pool_.Clear();
+  return Status::OK();
+}
+
+void AsOfJoinNode::ExtractRow(const RowBatch& rb, int64_t row_idx, const TableSpec& spec,
+                              RowTuple* rt) {
+  rt->Reset();
+  for (size_t col_idx = 0; col_idx < spec.input_col_indices.size(); ++col_idx) {
+    auto col = rb.ColumnAt(spec.input_col_indices[col_idx]).get();
+#define TYPE_CASE(_dt_) ExtractIntoRowTuple<_dt_>(rt, col, col_idx, row_idx);
+    PL_SWITCH_FOREACH_DATATYPE(spec.input_col_types[col_idx], TYPE_CASE);
+#undef TYPE_CASE
+  }
+}
+
+AsOfJoinNode::KeyState* AsOfJoinNode::FindOrInsertKey(int64_t row_idx) {
+  auto [it, inserted] = key_states_.try_emplace(keys_chunk_[row_idx]);
+  if (inserted) {
+    // The map now holds on to the row tuple, so it can't be reused for the next row.
+    keys_chunk_[row_idx] = key_values_pool_.Make<RowTuple>(&key_data_types_);
+  }
+  return &it->second;
+}
+
+void AsOfJoinNode::PruneRightRows(KeyState* state, int64_t time) {
+  auto& rows = state->right_rows;
+  while (rows.size() > 1 && rows[1].time <= time) {
+    free_right_rows_.push_back(std::move(rows.front().values));
+    rows.pop_front();
+  }
+}
+
+// Create a new output row batch from the column builders, and flush the pending row batch.
+// We hold on to a pending row batch because it is difficult to know a priori whether a given
+// output batch will be eos/eow.
+Status AsOfJoinNode::NextOutputBatch(ExecState* exec_state) {
+  PL_ASSIGN_OR_RETURN(auto output_batch, RowBatch::FromColumnBuilders(*output_descriptor_, false,
+                                                                      false, &column_builders_));
+  if (pending_output_batch_ != nullptr) {
+    PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *pending_output_batch_));
+  }
+  pending_output_batch_.swap(output_batch);
+
+  return InitializeColumnBuilders(exec_state);
+}
+
+Status AsOfJoinNode::EmitLeftRow(ExecState* exec_state, KeyState* state, int64_t time,
+                                 const RowTuple& left_values) {
+  PruneRightRows(state, time);
+  const RowTuple* match = nullptr;
+  if (!state->right_rows.empty()) {
+    const auto& right_row = state->right_rows.front();
+    if (right_row.time <= time && time - right_row.time <= tolerance_ns_) {
+      match = right_row.values.get();
+    }
+  }
+  if (match == nullptr && !emit_unmatched_left_rows_) {
+    return Status::OK();
+  }
+
+  for (size_t col = 0; col < left_spec_.output_col_indices.size(); ++col) {
+    auto output_idx = left_spec_.output_col_indices[col];
+    auto builder = column_builders_[output_idx].get();
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(AppendRowTupleValue<_dt_>(builder, left_values, col))
+    PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(output_idx), TYPE_CASE);
+#undef TYPE_CASE
+  }
+  for (size_t col = 0; col < right_spec_.output_col_indices.size(); ++col) {
+    auto output_idx = right_spec_.output_col_indices[col];
+    auto builder = column_builders_[output_idx].get();
+    if (match == nullptr) {
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(AppendDefaultValue<_dt_>(builder))
+      PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(output_idx), TYPE_CASE);
+#undef TYPE_CASE
+    } else {
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(AppendRowTupleValue<_dt_>(builder, *match, col))
+      PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(output_idx), TYPE_CASE);
+#undef TYPE_CASE
+    }
+  }
+
+  if (column_builders_[0]->length() == output_rows_per_batch_) {
+    return NextOutputBatch(exec_state);
+  }
+  return Status::OK();
+}
+
+Status AsOfJoinNode::EmitPendingLeftRows(ExecState* exec_state, KeyState* state,
+                                         int64_t before_time) {
+  auto& pending = state->pending_left_rows;
+  while (!pending.empty() && pending.front().time < before_time) {
+    PL_RETURN_IF_ERROR(EmitLeftRow(exec_state, state, pending.front().time,
+                                   *pending.front().values));
+    pending.pop_front();
+    --num_pending_left_rows_;
+  }
+  return Status::OK();
+}
+
+Status AsOfJoinNode::ConsumeLeftBatch(ExecState* exec_state, const RowBatch& rb) {
+  auto time_col = rb.ColumnAt(left_spec_.time_index).get();
+  for (int64_t row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+    KeyState* state = FindOrInsertKey(row_idx);
+    int64_t time = types::GetValueFromArrowArray<types::DataType::TIME64NS>(time_col, row_idx);
+    state->left_watermark = time;
+
+    // Right rows at the same time as the left row can still arrive until the right input passes
+    // that time.
+    if (right_eos_ || state->right_watermark > time) {
+      ExtractRow(rb, row_idx, left_spec_, left_row_scratch_.get());
+      PL_RETURN_IF_ERROR(EmitLeftRow(exec_state, state, time, *left_row_scratch_));
+      continue;
+    }
+    auto values = std::make_unique<RowTuple>(&left_spec_.input_col_types);
+    ExtractRow(rb, row_idx, left_spec_, values.get());
+    state->pending_left_rows.push_back(TimedRow{time, std::move(values)});
+    max_pending_left_rows_ = std::max(max_pending_left_rows_, ++num_pending_left_rows_);
+  }
+  return Status::OK();
+}
+
+Status AsOfJoinNode::ConsumeRightBatch(ExecState* exec_state, const RowBatch& rb) {
+  auto time_col = rb.ColumnAt(right_spec_.time_index).get();
+  for (int64_t row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+    KeyState* state = FindOrInsertKey(row_idx);
+    int64_t time = types::GetValueFromArrowArray<types::DataType::TIME64NS>(time_col, row_idx);
+
+    std::unique_ptr<RowTuple> values;
+    if (free_right_rows_.empty()) {
+      values = std::make_unique<RowTuple>(&right_spec_.input_col_types);
+    } else {
+      values = std::move(free_right_rows_.back());
+      free_right_rows_.pop_back();
+    }
+    ExtractRow(rb, row_idx, right_spec_, values.get());
+    state->right_rows.push_back(TimedRow{time, std::move(values)});
+    state->right_watermark = time;
+
+    PL_RETURN_IF_ERROR(EmitPendingLeftRows(exec_state, state, time));
+    PruneRightRows(state, state->left_watermark);
+  }
+  return Status::OK();
+}
+
+Status AsOfJoinNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb,
+                                     size_t parent_index) {
+  const TableSpec& spec = parent_index == 0 ? left_spec_ : right_spec_;
+  if (keys_chunk_.size() < static_cast<size_t>(rb.num_rows())) {
+    keys_chunk_.resize(rb.num_rows(), nullptr);
+  }
+  for (int64_t row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+    auto& rt = keys_chunk_[row_idx];
+    if (rt == nullptr) {
+      rt = key_values_pool_.Make<RowTuple>(&key_data_types_);
+    } else {
+      rt->Reset();
+    }
+  }
+  for (size_t key_idx = 0; key_idx < spec.key_indices.size(); ++key_idx) {
+    auto col = rb.ColumnAt(spec.key_indices[key_idx]).get();
+    for (int64_t row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+#define TYPE_CASE(_dt_) ExtractIntoRowTuple<_dt_>(keys_chunk_[row_idx], col, key_idx, row_idx);
+      PL_SWITCH_FOREACH_DATATYPE(key_data_types_[key_idx], TYPE_CASE);
+#undef TYPE_CASE
+    }
+  }
+
+  if (parent_index == 0) {
+    DCHECK(!left_eos_);
+    left_eos_ = rb.eos();
+    left_rows_ += rb.num_rows();
+    PL_RETURN_IF_ERROR(ConsumeLeftBatch(exec_state, rb));
+  } else {
+    DCHECK(!right_eos_);
+    right_eos_ = rb.eos();
+    right_rows_ += rb.num_rows();
+    // Once the left input is done and every left row is output, the right rows have nothing left
+    // to match.
+    if (!left_eos_ || num_pending_left_rows_ > 0) {
+      PL_RETURN_IF_ERROR(ConsumeRightBatch(exec_state, rb));
+    }
+    if (right_eos_) {
+      for (auto& [key, state] : key_states_) {
+        PL_RETURN_IF_ERROR(
+            EmitPendingLeftRows(exec_state, &state, std::numeric_limits<int64_t>::max()));
+      }
+    }
+  }
+
+  if (!left_eos_ || !right_eos_) {
+    return Status::OK();
+  }
+  if (column_builders_[0]->length()) {
+    PL_RETURN_IF_ERROR(NextOutputBatch(exec_state));
+  }
+  // Now send the last row batch and we know it is EOS/EOW.
+  if (pending_output_batch_ == nullptr) {
+    PL_ASSIGN_OR_RETURN(pending_output_batch_, RowBatch::WithZeroRows(*output_descriptor_,
+                                                                      /* eow */ true,
+                                                                      /* eos */ true));
+  } else {
+    pending_output_batch_->set_eos(true);
+    pending_output_batch_->set_eow(true);
+  }
+  return SendRowBatchToChildren(exec_state, *pending_output_batch_);
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array/builder_base.h>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/row_tuple.h"
+#include "src/carnot/plan/operators.h"
+#include "src/common/base/base.h"
+#include "src/common/base/status.h"
+#include "src/common/memory/memory.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table_store.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * AsOfJoinNode joins each left row with the latest right row that has the same keys and a time at
+ * or before the left row's, if that right row is within the tolerance. For example, it matches
+ * http_events with the most recent process_stats sample of the same UPID.
+ *
+ * Both inputs must be ordered by time for each key, but not across keys, which is what a
+ * GRPCSource that merges the streams of several agents produces. The inputs are merged in a
+ * single pass: each key holds the right rows that may still be matched, which is usually one,
+ * and the left rows that arrived before the right input passed their time.
+ *
+ * Left rows are output in time order for each key.
+ */
+class AsOfJoinNode : public ProcessingNode {
+  struct TimedRow {
+    int64_t time;
+    std::unique_ptr<RowTuple> values;
+  };
+
+  struct KeyState {
+    // The right rows that may still be matched, oldest first. Only the last right row at or before
+    // the left watermark is kept, along with the rows after it.
+    std::deque<TimedRow> right_rows;
+    // The left rows that are waiting for the right input to pass their time.
+    std::deque<TimedRow> pending_left_rows;
+    // The time of the latest row of each input.
+    int64_t left_watermark = std::numeric_limits<int64_t>::min();
+    int64_t right_watermark = std::numeric_limits<int64_t>::min();
+  };
+
+  struct TableSpec {
+    int64_t time_index;
+    std::vector<int64_t> key_indices;
+    // Indices of the input columns that are output, and their indices in the output row batch.
+    std::vector<int64_t> input_col_indices;
+    std::vector<types::DataType> input_col_types;
+    std::vector<int64_t> output_col_indices;
+  };
+
+ public:
+  AsOfJoinNode() = default;
+  virtual ~AsOfJoinNode() = default;
+
+ protected:
+  std::string DebugStringImpl() override;
+  Status InitImpl(const plan::Operator& plan_node) override;
+  Status PrepareImpl(ExecState* exec_state) override;
+  Status OpenImpl(ExecState* exec_state) override;
+  Status CloseImpl(ExecState* exec_state) override;
+  Status ConsumeNextImpl(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                         size_t parent_index) override;
+
+ private:
+  Status InitializeColumnBuilders(ExecState* exec_state);
+  Status ConsumeLeftBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  Status ConsumeRightBatch(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Returns the state of the key of the given row of the batch, which must have been extracted
+  // into keys_chunk_.
+  KeyState* FindOrInsertKey(int64_t row_idx);
+  static void ExtractRow(const table_store::schema::RowBatch& rb, int64_t row_idx,
+                         const TableSpec& spec, RowTuple* rt);
+  // Drops the right rows of the key that are superseded by a later right row at or before time.
+  void PruneRightRows(KeyState* state, int64_t time);
+  // Outputs the left row joined with the right row of the key that matches its time, if any.
+  Status EmitLeftRow(ExecState* exec_state, KeyState* state, int64_t time,
+                     const RowTuple& left_values);
+  Status EmitPendingLeftRows(ExecState* exec_state, KeyState* state, int64_t before_time);
+  Status NextOutputBatch(ExecState* exec_state);
+
+  bool left_eos_ = false;
+  bool right_eos_ = false;
+  bool emit_unmatched_left_rows_ = false;
+  int64_t tolerance_ns_ = 0;
+  int64_t output_rows_per_batch_;
+
+  TableSpec left_spec_;
+  TableSpec right_spec_;
+  std::vector<types::DataType> key_data_types_;
+
+  // The state of every key, which holds on to its key tuple.
+  AbslRowTupleHashMap<KeyState> key_states_;
+  ObjectPool key_values_pool_{"as_of_join_kv_pool"};
+  // The key of each row of the batch being consumed.
+  std::vector<RowTuple*> keys_chunk_;
+  // Holds the values of left rows that are output as soon as they are consumed.
+  std::unique_ptr<RowTuple> left_row_scratch_;
+  // Right rows that were pruned, reused for later right rows.
+  std::vector<std::unique_ptr<RowTuple>> free_right_rows_;
+
+  int64_t left_rows_ = 0;
+  int64_t right_rows_ = 0;
+  int64_t max_pending_left_rows_ = 0;
+  int64_t num_pending_left_rows_ = 0;
+
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> column_builders_;
+  // Handle on the most recent RowBatch (in case it's the final one).
+  std::unique_ptr<table_store::schema::RowBatch> pending_output_batch_;
+
+  std::unique_ptr<plan::JoinOperator> plan_node_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/as_of_join_node.h"
+
+#include <absl/strings/substitute.h>
+#include <gmock/gmock.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+#include <sole.hpp>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/carnot/udf/registry.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+
+class AsOfJoinNodeTest : public ::testing::Test {
+ public:
+  AsOfJoinNodeTest() {
+    func_registry_ = std::make_unique<udf::Registry>("test_registry");
+    auto table_store = std::make_shared<table_store::TableStore>();
+    exec_state_ = std::make_unique<ExecState>(func_registry_.get(), table_store,
+                                              MockResultSinkStubGenerator, sole::uuid4(), nullptr);
+  }
+
+ protected:
+  std::unique_ptr<plan::Operator> PlanNodeFromPbtxt(const std::string& pbtxt) {
+    planpb::Operator op_pb;
+    EXPECT_TRUE(google::protobuf::TextFormat::MergeFromString(
+        absl::Substitute(planpb::testutils::kOperatorProtoTmpl, "JOIN_OPERATOR", "join_op", pbtxt),
+        &op_pb));
+    return plan::JoinOperator::FromProto(op_pb, 1);
+  }
+
+  std::unique_ptr<ExecState> exec_state_;
+  std::unique_ptr<udf::Registry> func_registry_;
+};
+
+TEST_F(AsOfJoinNodeTest, left_join_with_tolerance) {
+  // Left table input: [time_:Time64Ns, upid:Int, left_val:Int]
+  // Right table input: [time_:Time64Ns, upid:Int, cpu:Float]
+  // Output table: [time_:Time64Ns, upid:Int, left_val:Int, cpu:Float]
+  const char* proto = R"(
+    type: LEFT_OUTER
+    equality_conditions {
+      left_column_index: 1
+      right_column_index: 1
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 0
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 1
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 2
+    }
+    output_columns: {
+      parent_index: 1
+      column_index: 2
+    }
+    column_names: "time_"
+    column_names: "upid"
+    column_names: "left_val"
+    column_names: "cpu"
+    rows_per_batch: 10
+    as_of: true
+    left_time_column_index: 0
+    right_time_column_index: 0
+    as_of_tolerance_ns: 10
+  )";
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  RowDescriptor input_rd_0(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor input_rd_1(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::FLOAT64});
+  RowDescriptor output_rd({types::DataType::TIME64NS, types::DataType::INT64,
+                           types::DataType::INT64, types::DataType::FLOAT64});
+  auto tester = exec::ExecNodeTester<AsOfJoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 3, false, false)
+                       .AddColumn<types::Time64NSValue>({10, 15, 20})
+                       .AddColumn<types::Int64Value>({1, 2, 1})
+                       .AddColumn<types::Float64Value>({1.0, 2.0, 1.5})
+                       .get(),
+                   1, 0)
+      // The rows at 12 and 18 match the right row at 10. The rows at 25 and 16 wait for the right
+      // input to pass their time.
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 4, false, false)
+                       .AddColumn<types::Time64NSValue>({12, 18, 25, 16})
+                       .AddColumn<types::Int64Value>({1, 1, 1, 2})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 2, true, true)
+                       .AddColumn<types::Time64NSValue>({30, 40})
+                       .AddColumn<types::Int64Value>({1, 3})
+                       .AddColumn<types::Float64Value>({3.0, 4.0})
+                       .get(),
+                   1, 0)
+      // The row at 100 is further than the tolerance from the right row at 30.
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 2, true, true)
+                       .AddColumn<types::Time64NSValue>({100, 41})
+                       .AddColumn<types::Int64Value>({1, 3})
+                       .AddColumn<types::Int64Value>({5, 6})
+                       .get(),
+                   0, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, true, true)
+                          .AddColumn<types::Time64NSValue>({12, 18, 25, 16, 100, 41})
+                          .AddColumn<types::Int64Value>({1, 1, 1, 2, 1, 3})
+                          .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                          .AddColumn<types::Float64Value>({1.0, 1.0, 1.5, 2.0, 0, 4.0})
+                          .get())
+      .Close();
+}
+
+TEST_F(AsOfJoinNodeTest, inner_join_exact_match) {
+  // Left table input: [time_:Time64Ns, pod:String]
+  // Right table input: [time_:Time64Ns, pod:String, val:Int]
+  // Output table: [time_:Time64Ns, pod:String, val:Int]
+  const char* proto = R"(
+    type: INNER
+    equality_conditions {
+      left_column_index: 1
+      right_column_index: 1
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 0
+    }
+    output_columns: {
+      parent_index: 0
+      column_index: 1
+    }
+    output_columns: {
+      parent_index: 1
+      column_index: 2
+    }
+    column_names: "time_"
+    column_names: "pod"
+    column_names: "val"
+    rows_per_batch: 2
+    as_of: true
+    left_time_column_index: 0
+    right_time_column_index: 0
+  )";
+
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  RowDescriptor input_rd_0({types::DataType::TIME64NS, types::DataType::STRING});
+  RowDescriptor input_rd_1(
+      {types::DataType::TIME64NS, types::DataType::STRING, types::DataType::INT64});
+  RowDescriptor output_rd(
+      {types::DataType::TIME64NS, types::DataType::STRING, types::DataType::INT64});
+  auto tester = exec::ExecNodeTester<AsOfJoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 3, false, false)
+                       .AddColumn<types::Time64NSValue>({10, 20, 20})
+                       .AddColumn<types::StringValue>({"a", "a", "b"})
+                       .get(),
+                   0, 0)
+      // Right rows at the same time as a left row match it. The left row "a" at 20 has no right
+      // row at its time, so it isn't output.
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 3, true, true)
+                       .AddColumn<types::Time64NSValue>({10, 20, 30})
+                       .AddColumn<types::StringValue>({"a", "b", "a"})
+                       .AddColumn<types::Int64Value>({1, 2, 3})
+                       .get(),
+                   1, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 1, true, true)
+                       .AddColumn<types::Time64NSValue>({30})
+                       .AddColumn<types::StringValue>({"a"})
+                       .get(),
+                   0, 2)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, false, false)
+                          .AddColumn<types::Time64NSValue>({10, 20})
+                          .AddColumn<types::StringValue>({"a", "b"})
+                          .AddColumn<types::Int64Value>({1, 2})
+                          .get())
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::Time64NSValue>({30})
+                          .AddColumn<types::StringValue>({"a"})
+                          .AddColumn<types::Int64Value>({3})
+                          .get())
+      .Close();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
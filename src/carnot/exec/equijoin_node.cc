@@ -23,9 +23,14 @@
 #include <arrow/status.h>
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include <absl/hash/hash.h>
 #include <absl/strings/str_join.h>
 #include <absl/strings/substitute.h>
 
@@ -35,6 +40,13 @@
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/type_utils.h"
 
+DEFINE_bool(carnot_join_fixed_width_keys, true,
+            "Use packed fixed width join keys (instead of RowTuples) for joins where all of the "
+            "key columns are fixed size.");
+DEFINE_int64(carnot_join_partition_keys, 4096,
+             "The average number of build keys per partition of a join above which the build side "
+             "is split into more partitions. Partitions should stay small enough to fit in L2.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -42,6 +54,32 @@ namespace exec {
 using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 
+namespace {
+
+// Partitions are picked with the top bits of the hash, so that splitting a partition in two only
+// needs one more bit.
+size_t RadixPartition(size_t hash, int radix_bits) {
+  return radix_bits == 0 ? 0 : hash >> (sizeof(size_t) * 8 - radix_bits);
+}
+
+size_t HashFixedWidthKey(std::string_view key) { return absl::Hash<std::string_view>{}(key); }
+
+template <typename TMap, typename THashFn>
+void SplitPartitions(std::vector<TMap>* partitions, int radix_bits, THashFn hash_fn) {
+  std::vector<TMap> new_partitions(size_t{1} << radix_bits);
+  for (auto& partition : *partitions) {
+    for (auto it = partition.begin(); it != partition.end();) {
+      auto next = std::next(it);
+      auto node = partition.extract(it);
+      new_partitions[RadixPartition(hash_fn(node.key()), radix_bits)].insert(std::move(node));
+      it = next;
+    }
+  }
+  partitions->swap(new_partitions);
+}
+
+}  // namespace
+
 std::string EquijoinNode::DebugStringImpl() {
   return absl::Substitute("Exec::JoinNode<$0>", absl::StrJoin(plan_node_->column_names(), ","));
 }
@@ -112,21 +150,32 @@ Status EquijoinNode::InitImpl(const plan::Operator& plan_node) {
     selected_spec.output_col_indices.emplace_back(i);
   }
 
+  use_fixed_width_keys_ =
+      FLAGS_carnot_join_fixed_width_keys &&
+      std::all_of(key_data_types_.begin(), key_data_types_.end(),
+                  [](types::DataType dt) { return dt != types::DataType::STRING; });
+  partition_keys_ = std::max<int64_t>(1, FLAGS_carnot_join_partition_keys);
+  if (use_fixed_width_keys_) {
+    fixed_width_build_partitions_.resize(1);
+  } else {
+    build_partitions_.resize(1);
+  }
+
   return Status::OK();
 }
 
-Status EquijoinNode::InitializeColumnBuilders() {
+Status EquijoinNode::InitializeColumnBuilders(ExecState* exec_state) {
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
     column_builders_[i] =
-        MakeArrowBuilder(output_descriptor_->type(i), arrow::default_memory_pool());
+        MakeArrowBuilder(output_descriptor_->type(i), exec_state->exec_mem_pool());
     PL_RETURN_IF_ERROR(column_builders_[i]->Reserve(output_rows_per_batch_));
   }
   return Status::OK();
 }
 
-Status EquijoinNode::PrepareImpl(ExecState* /*exec_state*/) {
+Status EquijoinNode::PrepareImpl(ExecState* exec_state) {
   column_builders_.resize(output_descriptor_->size());
-  PL_RETURN_IF_ERROR(InitializeColumnBuilders());
+  PL_RETURN_IF_ERROR(InitializeColumnBuilders(exec_state));
 
   return Status::OK();
 }
@@ -134,9 +183,17 @@ Status EquijoinNode::PrepareImpl(ExecState* /*exec_state*/) {
 Status EquijoinNode::OpenImpl(ExecState* /*exec_state*/) { return Status::OK(); }
 
 Status EquijoinNode::CloseImpl(ExecState* /*exec_state*/) {
+  stats()->AddExtraMetric("build_rows", build_rows_);
+  stats()->AddExtraMetric("build_bytes", build_bytes_);
+  stats()->AddExtraMetric("build_keys", num_build_keys_);
+  stats()->AddExtraMetric("build_partitions", size_t{1} << radix_bits_);
+  stats()->AddExtraMetric("probe_rows", probe_rows_);
+  stats()->AddExtraMetric("probe_bytes", probe_bytes_);
+
   join_keys_chunk_.clear();
-  build_buffer_.clear();
-  probed_keys_.clear();
+  fixed_width_keys_chunk_.clear();
+  build_partitions_.clear();
+  fixed_width_build_partitions_.clear();
   key_values_pool_.Clear();
   return Status::OK();
 }
@@ -155,7 +212,7 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
   // Reset the row tuples
   for (auto& rt : join_keys_chunk_) {
     if (rt == nullptr) {
-      rt = key_values_pool_.Add(new RowTuple(&key_data_types_));
+      rt = key_values_pool_.Make<RowTuple>(&key_data_types_);
     } else {
       rt->Reset();
     }
@@ -167,7 +224,7 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
     int prev_size = join_keys_chunk_.size();
     join_keys_chunk_.reserve(num_rows);
     for (size_t idx = prev_size; idx < num_rows; ++idx) {
-      auto tuple_ptr = key_values_pool_.Add(new RowTuple(&key_data_types_));
+      auto tuple_ptr = key_values_pool_.Make<RowTuple>(&key_data_types_);
       join_keys_chunk_.emplace_back(tuple_ptr);
     }
   }
@@ -188,9 +245,73 @@ Status EquijoinNode::ExtractJoinKeysForBatch(const table_store::schema::RowBatch
   return Status::OK();
 }
 
+Status EquijoinNode::ExtractFixedWidthJoinKeysForBatch(const table_store::schema::RowBatch& rb,
+                                                       bool is_probe) {
+  const TableSpec& spec = is_probe ? probe_spec_ : build_spec_;
+  size_t num_keys = key_data_types_.size();
+  fixed_width_keys_chunk_.resize(rb.num_rows() * num_keys);
+  // Zero the keys so that any padding in smaller values doesn't affect hashing and comparison.
+  memset(reinterpret_cast<uint8_t*>(fixed_width_keys_chunk_.data()), 0,
+         sizeof(types::FixedSizeValueUnion) * fixed_width_keys_chunk_.size());
+
+  for (size_t key_idx = 0; key_idx < num_keys; ++key_idx) {
+    auto col = rb.ColumnAt(spec.key_indices[key_idx]).get();
+#define TYPE_CASE(_dt_) \
+  ExtractIntoFixedWidthKeys<_dt_>(col, num_keys, key_idx, fixed_width_keys_chunk_.data());
+    PL_SWITCH_FOREACH_DATATYPE(key_data_types_[key_idx], TYPE_CASE);
+#undef TYPE_CASE
+  }
+  return Status::OK();
+}
+
+std::string_view EquijoinNode::FixedWidthKey(int64_t row_idx) const {
+  size_t key_size = sizeof(types::FixedSizeValueUnion) * key_data_types_.size();
+  return std::string_view(reinterpret_cast<const char*>(fixed_width_keys_chunk_.data()) +
+                              row_idx * key_size,
+                          key_size);
+}
+
+void EquijoinNode::PartitionRows(int64_t num_rows) {
+  partitioned_rows_.resize(num_rows);
+  size_t num_partitions = size_t{1} << radix_bits_;
+  partition_offsets_.assign(num_partitions + 1, 0);
+  partition_offsets_[num_partitions] = num_rows;
+  if (num_partitions == 1) {
+    for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+      partitioned_rows_[row_idx] = row_idx;
+    }
+    return;
+  }
+
+  key_hashes_chunk_.resize(num_rows);
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    size_t hash = use_fixed_width_keys_ ? HashFixedWidthKey(FixedWidthKey(row_idx))
+                                        : join_keys_chunk_[row_idx]->Hash();
+    key_hashes_chunk_[row_idx] = hash;
+    ++partition_offsets_[RadixPartition(hash, radix_bits_)];
+  }
+  // Turn the counts into the start offset of each partition, then scatter the rows. This is a
+  // counting sort, so rows keep their original order within a partition.
+  int64_t start = 0;
+  for (size_t p = 0; p < num_partitions; ++p) {
+    int64_t count = partition_offsets_[p];
+    partition_offsets_[p] = start;
+    start += count;
+  }
+  for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+    auto p = RadixPartition(key_hashes_chunk_[row_idx], radix_bits_);
+    partitioned_rows_[partition_offsets_[p]++] = row_idx;
+  }
+  // Scattering moved each offset to the start of the next partition, shift them back.
+  for (size_t p = num_partitions - 1; p > 0; --p) {
+    partition_offsets_[p] = partition_offsets_[p - 1];
+  }
+  partition_offsets_[0] = 0;
+}
+
 std::vector<types::SharedColumnWrapper>* CreateWrapper(ObjectPool* pool,
                                                        const std::vector<types::DataType>& types) {
-  auto ptr = pool->Add(new std::vector<types::SharedColumnWrapper>(types.size()));
+  auto ptr = pool->Make<std::vector<types::SharedColumnWrapper>>(types.size());
   for (size_t col_idx = 0; col_idx < types.size(); ++col_idx) {
     (*ptr)[col_idx] = types::ColumnWrapper::Make(types[col_idx], 0);
   }
@@ -208,34 +329,85 @@ Status EquijoinNode::HashRowBatch(const table_store::schema::RowBatch& rb) {
     }
   }
 
-  // Make sure the map has constructed the necessary column wrappers for all of the tuples.
-  for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
-    auto& rt = join_keys_chunk_[row_idx];
-    auto& current = build_buffer_[rt];
-    auto wrappers_ptr = current != nullptr ? current : build_wrappers_chunk_[row_idx];
+  PartitionRows(rb.num_rows());
+  for (size_t p = 0; p + 1 < partition_offsets_.size(); ++p) {
+    for (auto i = partition_offsets_[p]; i < partition_offsets_[p + 1]; ++i) {
+      auto row_idx = partitioned_rows_[i];
+      auto entry = FindOrInsertBuildEntry(row_idx, p);
 
-    // Now extract the values into the corresponding column wrappers.
-    for (size_t i = 0; i < build_spec_.input_col_indices.size(); ++i) {
-      const auto& rb_col_idx = build_spec_.input_col_indices[i];
-      auto arr = rb.ColumnAt(rb_col_idx).get();
-      const auto& dt = build_spec_.input_col_types[i];
+      // Now extract the values into the corresponding column wrappers.
+      for (size_t col_idx = 0; col_idx < build_spec_.input_col_indices.size(); ++col_idx) {
+        const auto& rb_col_idx = build_spec_.input_col_indices[col_idx];
+        auto arr = rb.ColumnAt(rb_col_idx).get();
+        const auto& dt = build_spec_.input_col_types[col_idx];
 
 #define TYPE_CASE(_dt_) \
-  types::ExtractValueToColumnWrapper<_dt_>(wrappers_ptr->at(i).get(), arr, row_idx);
-      PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
+  types::ExtractValueToColumnWrapper<_dt_>(entry->wrappers->at(col_idx).get(), arr, row_idx);
+        PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
 #undef TYPE_CASE
+      }
+      // Keep track of the number of rows that the build buffer matches for each key.
+      entry->num_rows++;
     }
-    // Keep track of the number of rows that the build buffer matches for each key.
-    build_buffer_rows_[rt]++;
+  }
 
-    if (current == nullptr) {
-      std::swap(build_wrappers_chunk_[row_idx], current);
-      // Reset the new tuples that we added
-      join_keys_chunk_[row_idx] = nullptr;
+  MaybeRepartitionBuild();
+  return Status::OK();
+}
+
+EquijoinNode::BuildEntry* EquijoinNode::FindOrInsertBuildEntry(int64_t row_idx,
+                                                               size_t partition) {
+  BuildEntry* entry;
+  if (use_fixed_width_keys_) {
+    auto& build_map = fixed_width_build_partitions_[partition];
+    auto key = FixedWidthKey(row_idx);
+    auto it = build_map.find(key);
+    if (it != build_map.end()) {
+      return &it->second;
     }
+    entry = &build_map.try_emplace(std::string(key)).first->second;
+  } else {
+    auto& rt = join_keys_chunk_[row_idx];
+    auto [it, inserted] = build_partitions_[partition].try_emplace(rt);
+    if (!inserted) {
+      return &it->second;
+    }
+    entry = &it->second;
+    // The map now holds on to the row tuple, so it can't be reused for the next batch.
+    rt = nullptr;
   }
+  ++num_build_keys_;
+  std::swap(build_wrappers_chunk_[row_idx], entry->wrappers);
+  return entry;
+}
 
-  return Status::OK();
+EquijoinNode::BuildEntry* EquijoinNode::FindBuildEntry(int64_t row_idx, size_t partition) {
+  if (use_fixed_width_keys_) {
+    auto& build_map = fixed_width_build_partitions_[partition];
+    auto it = build_map.find(FixedWidthKey(row_idx));
+    return it == build_map.end() ? nullptr : &it->second;
+  }
+  auto& build_map = build_partitions_[partition];
+  auto it = build_map.find(join_keys_chunk_[row_idx]);
+  return it == build_map.end() ? nullptr : &it->second;
+}
+
+void EquijoinNode::MaybeRepartitionBuild() {
+  int radix_bits = radix_bits_;
+  while (radix_bits < kMaxJoinRadixBits &&
+         num_build_keys_ > (int64_t{1} << radix_bits) * partition_keys_) {
+    ++radix_bits;
+  }
+  if (radix_bits == radix_bits_) {
+    return;
+  }
+  radix_bits_ = radix_bits;
+  if (use_fixed_width_keys_) {
+    SplitPartitions(&fixed_width_build_partitions_, radix_bits_,
+                    [](const std::string& key) { return HashFixedWidthKey(key); });
+  } else {
+    SplitPartitions(&build_partitions_, radix_bits_, [](const RowTuple* rt) { return rt->Hash(); });
+  }
 }
 
 template <types::DataType DT>
@@ -272,7 +444,7 @@ Status EquijoinNode::NextOutputBatch(ExecState* exec_state) {
   }
   pending_output_batch_.swap(output_batch);
 
-  return InitializeColumnBuilders();
+  return InitializeColumnBuilders(exec_state);
 }
 
 Status EquijoinNode::FlushChunkedRows(ExecState* exec_state) {
@@ -351,19 +523,25 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
     probe_eos_ = true;
   }
 
-  PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(rb, true));
+  if (use_fixed_width_keys_) {
+    PL_RETURN_IF_ERROR(ExtractFixedWidthJoinKeysForBatch(rb, true));
+  } else {
+    PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(rb, true));
+  }
 
-  if (rb.num_rows() > static_cast<int64_t>(probe_wrappers_chunk_.size())) {
-    probe_wrappers_chunk_.resize(rb.num_rows());
+  if (rb.num_rows() > static_cast<int64_t>(probe_entries_chunk_.size())) {
+    probe_entries_chunk_.resize(rb.num_rows());
   }
 
-  for (auto row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
-    auto it = build_buffer_.find(join_keys_chunk_[row_idx]);
-    if (it != build_buffer_.end()) {
-      probe_wrappers_chunk_[row_idx] = it->second;
-      probed_keys_.insert(it->first);
-    } else {
-      probe_wrappers_chunk_[row_idx] = nullptr;
+  PartitionRows(rb.num_rows());
+  for (size_t p = 0; p + 1 < partition_offsets_.size(); ++p) {
+    for (auto i = partition_offsets_[p]; i < partition_offsets_[p + 1]; ++i) {
+      auto row_idx = partitioned_rows_[i];
+      auto entry = FindBuildEntry(row_idx, p);
+      if (entry != nullptr) {
+        entry->probed = true;
+      }
+      probe_entries_chunk_[row_idx] = entry;
     }
   }
 
@@ -374,7 +552,8 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
       PL_RETURN_IF_ERROR(FlushChunkedRows(exec_state));
     }
 
-    if (probe_wrappers_chunk_[row_idx] == nullptr) {
+    const auto* entry = probe_entries_chunk_[row_idx];
+    if (entry == nullptr) {
       if (probe_spec_.emit_unmatched_rows) {
         OutputChunk c{rb_ptr, nullptr, 1, 0, row_idx};
         chunks_.emplace_back(c);
@@ -383,9 +562,8 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
       continue;
     }
 
-    PL_RETURN_IF_ERROR(MatchBuildValuesAndFlush(exec_state, probe_wrappers_chunk_[row_idx], rb_ptr,
-                                                row_idx,
-                                                build_buffer_rows_[join_keys_chunk_[row_idx]]));
+    PL_RETURN_IF_ERROR(
+        MatchBuildValuesAndFlush(exec_state, entry->wrappers, rb_ptr, row_idx, entry->num_rows));
   }
 
   if (probe_eos_ && queued_rows_ > 0) {
@@ -396,12 +574,21 @@ Status EquijoinNode::DoProbe(ExecState* exec_state, const table_store::schema::R
 }
 
 Status EquijoinNode::EmitUnmatchedBuildRows(ExecState* exec_state) {
-  for (auto it = build_buffer_.begin(); it != build_buffer_.end(); ++it) {
-    if (probed_keys_.find(it->first) != probed_keys_.end()) {
-      continue;
+  auto emit_unprobed = [&](const BuildEntry& entry) {
+    if (entry.probed) {
+      return Status::OK();
+    }
+    return MatchBuildValuesAndFlush(exec_state, entry.wrappers, nullptr, 0, entry.num_rows);
+  };
+  for (const auto& partition : build_partitions_) {
+    for (const auto& [rt, entry] : partition) {
+      PL_RETURN_IF_ERROR(emit_unprobed(entry));
+    }
+  }
+  for (const auto& partition : fixed_width_build_partitions_) {
+    for (const auto& [key, entry] : partition) {
+      PL_RETURN_IF_ERROR(emit_unprobed(entry));
     }
-    PL_RETURN_IF_ERROR(MatchBuildValuesAndFlush(exec_state, it->second, nullptr, 0,
-                                                build_buffer_rows_[it->first]));
   }
 
   if (queued_rows_ > 0) {
@@ -415,8 +602,14 @@ Status EquijoinNode::ConsumeBuildBatch(ExecState* exec_state,
   if (rb.eos()) {
     build_eos_ = true;
   }
+  build_rows_ += rb.num_rows();
+  build_bytes_ += rb.NumBytes();
 
-  PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(rb, false));
+  if (use_fixed_width_keys_) {
+    PL_RETURN_IF_ERROR(ExtractFixedWidthJoinKeysForBatch(rb, false));
+  } else {
+    PL_RETURN_IF_ERROR(ExtractJoinKeysForBatch(rb, false));
+  }
   PL_RETURN_IF_ERROR(HashRowBatch(rb));
 
   if (build_eos_) {
@@ -430,6 +623,8 @@ Status EquijoinNode::ConsumeBuildBatch(ExecState* exec_state,
 
 Status EquijoinNode::ConsumeProbeBatch(ExecState* exec_state,
                                        const table_store::schema::RowBatch& rb) {
+  probe_rows_ += rb.num_rows();
+  probe_bytes_ += rb.NumBytes();
   if (!build_eos_) {
     probe_batches_.push(rb);
     return Status::OK();
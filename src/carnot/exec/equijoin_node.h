@@ -23,6 +23,7 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -39,11 +40,16 @@
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_bool(carnot_join_fixed_width_keys);
+DECLARE_int64(carnot_join_partition_keys);
+
 namespace px {
 namespace carnot {
 namespace exec {
 
 constexpr size_t kDefaultJoinRowBatchSize = 1024;
+// The build side is split into at most 2^kMaxJoinRadixBits partitions.
+constexpr int kMaxJoinRadixBits = 10;
 
 class EquijoinNode : public ProcessingNode {
   enum class JoinInputTable { kLeftTable, kRightTable };
@@ -60,6 +66,22 @@ class EquijoinNode : public ProcessingNode {
     std::vector<int64_t> output_col_indices;
   };
 
+  // The buffered build rows that share the same join key.
+  struct BuildEntry {
+    std::vector<types::SharedColumnWrapper>* wrappers = nullptr;
+    // The number of build rows for the key. This is kept in addition to the wrappers in the event
+    // that no columns from the build side are emitted.
+    int64_t num_rows = 0;
+    // For joins where the build side needs to emit any non-probed rows at the end of the join,
+    // keep track of which keys were probed.
+    bool probed = false;
+  };
+
+  using RowTupleBuildMap = AbslRowTupleHashMap<BuildEntry>;
+  // Build map used when every key column is fixed size (ie. no strings). Keys are the key values
+  // of a row packed into contiguous FixedSizeValueUnions.
+  using FixedWidthBuildMap = absl::flat_hash_map<std::string, BuildEntry>;
+
  public:
   EquijoinNode() = default;
   virtual ~EquijoinNode() = default;
@@ -74,11 +96,22 @@ class EquijoinNode : public ProcessingNode {
                          size_t parent_index) override;
 
  private:
-  Status InitializeColumnBuilders();
+  Status InitializeColumnBuilders(ExecState* exec_state);
   bool IsProbeTable(size_t parent_index);
   Status FlushChunkedRows(ExecState* exec_state);
   Status ExtractJoinKeysForBatch(const table_store::schema::RowBatch& rb, bool is_probe);
+  Status ExtractFixedWidthJoinKeysForBatch(const table_store::schema::RowBatch& rb,
+                                           bool is_probe);
+  // Hashes the extracted join keys of the batch and sorts its rows by partition into
+  // partitioned_rows_, so that each partition's hash map is only touched once per batch.
+  void PartitionRows(int64_t num_rows);
   Status HashRowBatch(const table_store::schema::RowBatch& rb);
+  BuildEntry* FindOrInsertBuildEntry(int64_t row_idx, size_t partition);
+  BuildEntry* FindBuildEntry(int64_t row_idx, size_t partition);
+  std::string_view FixedWidthKey(int64_t row_idx) const;
+  // Splits the build side into more partitions once they hold more than partition_keys_ keys on
+  // average.
+  void MaybeRepartitionBuild();
 
   Status DoProbe(ExecState* exec_state, const table_store::schema::RowBatch& rb);
   Status MatchBuildValuesAndFlush(ExecState* exec_state,
@@ -135,21 +168,38 @@ class EquijoinNode : public ProcessingNode {
 
   // Chunk of data to use when extracting join keys.
   std::vector<RowTuple*> join_keys_chunk_;
+  // Chunk of data to use when extracting fixed width join keys, num_rows * num_keys values in row
+  // major order.
+  std::vector<types::FixedSizeValueUnion> fixed_width_keys_chunk_;
   // Chunk of data to use when performing the build stage of the join.
   std::vector<std::vector<types::SharedColumnWrapper>*> build_wrappers_chunk_;
 
   // Chunk of data to use when performing the probe stage of the join.
-  // This will store build table data from `build_buffer_`.
-  std::vector<std::vector<types::SharedColumnWrapper>*> probe_wrappers_chunk_;
-  AbslRowTupleHashMap<std::vector<types::SharedColumnWrapper>*> build_buffer_;
-  // Store the number of rows that match a given set of keys for the build buffer.
-  // This is necessary to store in addition to the values in `build_buffer_` in
-  // the event that no columns from the build side are emitted.
-  AbslRowTupleHashMap<int64_t> build_buffer_rows_;
-
-  // For joins where the build_buffer_ needs to emit any non-probed rows at the end of the join,
-  // keep track of which ones they were.
-  AbslRowTupleHashSet probed_keys_;
+  // This will store the build entry that matches each probe row, if any.
+  std::vector<BuildEntry*> probe_entries_chunk_;
+
+  // The hash of each row's join key, and the row indices of the batch sorted by partition.
+  // Rows of partition p are partitioned_rows_[partition_offsets_[p], partition_offsets_[p + 1]).
+  std::vector<size_t> key_hashes_chunk_;
+  std::vector<int64_t> partitioned_rows_;
+  std::vector<int64_t> partition_offsets_;
+
+  // The build side of the join, radix partitioned on the top radix_bits_ bits of the key hash so
+  // that each partition's hash map stays small enough to be cache resident. Only one of
+  // build_partitions_ and fixed_width_build_partitions_ is used, depending on
+  // use_fixed_width_keys_.
+  bool use_fixed_width_keys_ = false;
+  int radix_bits_ = 0;
+  int64_t partition_keys_ = 0;
+  int64_t num_build_keys_ = 0;
+  std::vector<RowTupleBuildMap> build_partitions_;
+  std::vector<FixedWidthBuildMap> fixed_width_build_partitions_;
+
+  // Sizes of each side of the join, reported in the exec stats.
+  int64_t build_rows_ = 0;
+  int64_t build_bytes_ = 0;
+  int64_t probe_rows_ = 0;
+  int64_t probe_bytes_ = 0;
 
   // Handle on the most recent RowBatch (in case it's the final one).
   std::unique_ptr<table_store::schema::RowBatch> pending_output_batch_;
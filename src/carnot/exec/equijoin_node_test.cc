@@ -685,6 +685,135 @@ TEST_F(JoinNodeTest, unordered_many_matches) {
       .Close();
 }
 
+TEST_F(JoinNodeTest, unordered_many_build_partitions) {
+  // Left table input: [left_0:Int64, left_1:Int64]
+  // Right table input: [right_0:Int64]
+  // Output table: [left_1:Int64, right_0:Int64]
+  // Inner join on left_0=right_0
+  const char* proto = R"(
+  type: INNER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 0
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 0
+  }
+  column_names: "left_1"
+  column_names: "right_0"
+  rows_per_batch: 5
+)";
+
+  // Left
+  RowDescriptor input_rd_0({types::DataType::INT64, types::DataType::INT64});
+  // Right
+  RowDescriptor input_rd_1({types::DataType::INT64});
+  // Left[1], Right[0]
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  // Split the build side into a partition per key, so that it gets repartitioned after each batch.
+  auto partition_keys = FLAGS_carnot_join_partition_keys;
+  FLAGS_carnot_join_partition_keys = 1;
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+  FLAGS_carnot_join_partition_keys = partition_keys;
+
+  tester
+      // Build(left) table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 6, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({0, 1, 2, 3, 4, 5})
+                       .AddColumn<types::Int64Value>({100, 101, 102, 103, 104, 105})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 7, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({6, 7, 8, 9, 10, 11, 3})
+                       .AddColumn<types::Int64Value>({106, 107, 108, 109, 110, 111, 203})
+                       .get(),
+                   0, 0)
+      // Probe(right) table
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 4, true, true)
+                       .AddColumn<types::Int64Value>({11, 3, 20, 0})
+                       .get(),
+                   1, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<types::Int64Value>({111, 103, 203, 100})
+                          .AddColumn<types::Int64Value>({11, 3, 3, 0})
+                          .get(),
+                      true)
+      .Close();
+}
+
+TEST_F(JoinNodeTest, full_outer_join_string_keys_many_build_partitions) {
+  // Left table input: [left_0:String, left_1:Int64]
+  // Right table input: [right_0:String, right_1:Int64]
+  // Output table: [left_1:Int64, right_1:Int64]
+  // Full outer join on left_0=right_0
+  const char* proto = R"(
+  type: FULL_OUTER
+  equality_conditions {
+    left_column_index: 0
+    right_column_index: 0
+  }
+  output_columns: {
+    parent_index: 0
+    column_index: 1
+  }
+  output_columns: {
+    parent_index: 1
+    column_index: 1
+  }
+  column_names: "left_1"
+  column_names: "right_1"
+  rows_per_batch: 5
+)";
+
+  // Left
+  RowDescriptor input_rd_0({types::DataType::STRING, types::DataType::INT64});
+  // Right
+  RowDescriptor input_rd_1({types::DataType::STRING, types::DataType::INT64});
+  // Left[1], Right[1]
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto partition_keys = FLAGS_carnot_join_partition_keys;
+  FLAGS_carnot_join_partition_keys = 1;
+  auto plan_node = PlanNodeFromPbtxt(proto);
+  auto tester = exec::ExecNodeTester<EquijoinNode, plan::JoinOperator>(
+      *plan_node, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+  FLAGS_carnot_join_partition_keys = partition_keys;
+
+  tester
+      // Build(left) table
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 4, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::StringValue>({"a", "b", "c", "d"})
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .get(),
+                   0, 0)
+      // Probe(right) table
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 3, true, true)
+                       .AddColumn<types::StringValue>({"b", "x", "d"})
+                       .AddColumn<types::Int64Value>({10, 20, 30})
+                       .get(),
+                   1, 2)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, false, false)
+                          .AddColumn<types::Int64Value>({2, 0, 4})
+                          .AddColumn<types::Int64Value>({10, 20, 30})
+                          .get(),
+                      true)
+      // Unmatched build rows, in no particular order.
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({1, 3})
+                          .AddColumn<types::Int64Value>({0, 0})
+                          .get(),
+                      false)
+      .Close();
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -18,15 +18,23 @@
 
 #include "src/carnot/exec/exec_graph.h"
 
+#include <time.h>
+
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <set>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "src/carnot/exec/agg_node.h"
+#include "src/carnot/exec/as_of_join_node.h"
 #include "src/carnot/exec/empty_source_node.h"
 #include "src/carnot/exec/equijoin_node.h"
 #include "src/carnot/exec/exec_node.h"
+#include "src/carnot/exec/filter_kernels.h"
 #include "src/carnot/exec/filter_node.h"
 #include "src/carnot/exec/grpc_router.h"
 #include "src/carnot/exec/grpc_sink_node.h"
@@ -42,12 +50,52 @@
 #include "src/common/perf/perf.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_bool(carnot_defer_filtered_columns, true,
+            "Defer converting the columns of a memory source that are not used by a downstream "
+            "filter predicate, so only the rows that pass the filter are converted.");
+DEFINE_bool(carnot_skip_batches_with_zone_maps, true,
+            "Let memory sources skip cold batches whose zone maps show that no row can pass the "
+            "downstream filter predicate.");
+DEFINE_bool(carnot_select_pods_in_memory_sources, true,
+            "Let memory sources drop the rows of processes outside the pod that the downstream "
+            "filter predicate selects (ctx['pod'] == ...), looking up each UPID's pod once rather "
+            "than once per row.");
+
+DEFINE_int64(carnot_exec_time_slice_ms,
+             gflags::Int64FromEnv("PL_CARNOT_EXEC_TIME_SLICE_MS", 50),
+             "How long a query executes before reaching a scheduling point, where it yields the "
+             "thread and waits while its priority is paused. 0 disables time slicing.");
+
 namespace px {
 namespace carnot {
 namespace exec {
 
 using table_store::schema::RowDescriptor;
 
+namespace {
+
+// CPU quotas are enforced over periods of this length, so a throttled query runs in short bursts
+// rather than stalling for long stretches.
+constexpr std::chrono::milliseconds kCPUQuotaPeriod{100};
+
+std::chrono::nanoseconds ThreadCPUTime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+void CollectColumnIndexes(const plan::ScalarExpression& expr, absl::flat_hash_set<int64_t>* cols) {
+  if (expr.ExpressionType() == plan::Expression::kColumn) {
+    cols->insert(static_cast<const plan::Column&>(expr).Index());
+    return;
+  }
+  for (const auto* dep : expr.Deps()) {
+    CollectColumnIndexes(*dep, cols);
+  }
+}
+
+}  // namespace
+
 Status ExecutionGraph::Init(table_store::schema::Schema* schema, plan::PlanState* plan_state,
                             ExecState* exec_state, plan::PlanFragment* pf,
                             bool collect_exec_node_stats,
@@ -73,10 +121,13 @@ Status ExecutionGraph::Init(table_store::schema::Schema* schema, plan::PlanState
         return OnOperatorImpl<plan::AggregateOperator, AggNode>(node, &descriptors);
       })
       .OnMemorySource([&](auto& node) {
+        memory_sources_.insert(node.id());
         return OnOperatorImpl<plan::MemorySourceOperator, MemorySourceNode>(node, &descriptors);
       })
       .OnFilter([&](auto& node) {
-        return OnOperatorImpl<plan::FilterOperator, FilterNode>(node, &descriptors);
+        PL_RETURN_IF_ERROR(OnOperatorImpl<plan::FilterOperator, FilterNode>(node, &descriptors));
+        PushDownFilterToMemorySource(node);
+        return Status::OK();
       })
       .OnLimit([&](auto& node) {
         return OnOperatorImpl<plan::LimitOperator, LimitNode>(node, &descriptors);
@@ -85,6 +136,9 @@ Status ExecutionGraph::Init(table_store::schema::Schema* schema, plan::PlanState
         return OnOperatorImpl<plan::UnionOperator, UnionNode>(node, &descriptors);
       })
       .OnJoin([&](auto& node) {
+        if (node.as_of()) {
+          return OnOperatorImpl<plan::JoinOperator, AsOfJoinNode>(node, &descriptors);
+        }
         return OnOperatorImpl<plan::JoinOperator, EquijoinNode>(node, &descriptors);
       })
       .OnGRPCSource([&](auto& node) {
@@ -108,13 +162,40 @@ Status ExecutionGraph::Init(table_store::schema::Schema* schema, plan::PlanState
       .Walk(pf_);
 }
 
-bool ExecutionGraph::YieldWithTimeout() {
+void ExecutionGraph::PushDownFilterToMemorySource(const plan::FilterOperator& node) {
+  auto parents = pf_->dag().ParentsOf(node.id());
+  if (parents.size() != 1 || !memory_sources_.contains(parents[0])) {
+    return;
+  }
+  // Other children of the source would be affected too, and they might need all of the rows.
+  if (pf_->dag().DependenciesOf(parents[0]).size() != 1) {
+    return;
+  }
+  auto* source = static_cast<MemorySourceNode*>(nodes_[parents[0]]);
+  if (FLAGS_carnot_defer_filtered_columns) {
+    absl::flat_hash_set<int64_t> predicate_cols;
+    CollectColumnIndexes(*node.expression(), &predicate_cols);
+    source->DeferColumnsExcept(predicate_cols);
+  }
+  if (FLAGS_carnot_skip_batches_with_zone_maps) {
+    std::vector<table_store::ZoneMapPredicate> preds;
+    CollectZoneMapPredicates(*node.expression(), &preds);
+    source->SetZoneMapPredicates(std::move(preds));
+  }
+  if (FLAGS_carnot_select_pods_in_memory_sources) {
+    std::vector<UPIDPodPredicate> preds;
+    CollectUPIDPodPredicates(*node.expression(), &preds);
+    source->SetUPIDPodPredicates(std::move(preds));
+  }
+}
+
+bool ExecutionGraph::YieldWithTimeout(std::chrono::milliseconds timeout) {
   std::unique_lock<std::mutex> lock(execution_mutex_);
   if (continue_) {
     continue_ = false;
     return false;
   }
-  auto timed_out = !(execution_cv_.wait_for(lock, yield_timeout_ms_, [this] { return continue_; }));
+  auto timed_out = !(execution_cv_.wait_for(lock, timeout, [this] { return continue_; }));
   return timed_out;
 }
 
@@ -126,6 +207,46 @@ void ExecutionGraph::Continue() {
   execution_cv_.notify_one();
 }
 
+void ExecutionGraph::ThrottleToCPUQuota() {
+  double quota = exec_state_->cpu_quota();
+  if (quota <= 0) {
+    return;
+  }
+  // The point by which the CPU used since the start of the period is back within the quota. This
+  // is past the end of the period when the query went over, so the overage isn't forgiven.
+  std::chrono::duration<double, std::nano> used = ThreadCPUTime() - cpu_quota_period_start_cpu_;
+  auto within_quota_at = cpu_quota_period_start_ +
+                         std::chrono::duration_cast<std::chrono::nanoseconds>(used / quota);
+  auto now = std::chrono::steady_clock::now();
+  while (now < within_quota_at && !exec_state_->stop_requested()) {
+    YieldWithTimeout(std::chrono::ceil<std::chrono::milliseconds>(within_quota_at - now));
+    now = std::chrono::steady_clock::now();
+  }
+  if (now - cpu_quota_period_start_ >= kCPUQuotaPeriod) {
+    cpu_quota_period_start_ = now;
+    cpu_quota_period_start_cpu_ = ThreadCPUTime();
+  }
+}
+
+bool ExecutionGraph::TimeSliceElapsed() const {
+  return FLAGS_carnot_exec_time_slice_ms > 0 &&
+         std::chrono::steady_clock::now() - time_slice_start_ >=
+             std::chrono::milliseconds(FLAGS_carnot_exec_time_slice_ms);
+}
+
+void ExecutionGraph::EndTimeSlice() {
+  std::this_thread::yield();
+  ExecutionGate* gate = exec_state_->execution_gate();
+  if (gate != nullptr) {
+    auto paused = gate->WaitUntilRunnable(exec_state_->priority(),
+                                          [this] { return exec_state_->stop_requested(); });
+    VLOG_IF(1, paused > std::chrono::milliseconds(1)) << absl::Substitute(
+        "Query $0 was paused for $1ms", exec_state_->query_id().str(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(paused).count());
+  }
+  time_slice_start_ = std::chrono::steady_clock::now();
+}
+
 Status ExecutionGraph::CheckUpstreamGRPCConnectionHealth(GRPCSourceNode* source_node) {
   // Note: for the following logic, HasBatchesRemaining is equivalent to whether or not
   // the source node has sent a final end of stream row batch already or not.
@@ -167,10 +288,91 @@ Status ExecutionGraph::CheckDownstreamGRPCConnectionsHealth() {
     }
     GRPCSinkNode* grpc_sink = static_cast<GRPCSinkNode*>(node->second);
     PL_RETURN_IF_ERROR(grpc_sink->OptionallyCheckConnection(exec_state_));
+    if (grpc_sink->destination_stopped()) {
+      stopped_sinks_.insert(grpc_sink);
+    }
+  }
+  return Status::OK();
+}
+
+bool ExecutionGraph::FeedsOnlyStoppedSinks(ExecNode* node) const {
+  if (node->IsSink()) {
+    return stopped_sinks_.contains(node);
+  }
+  std::vector<ExecNode*> children = node->children();
+  if (children.empty()) {
+    return false;
+  }
+  for (ExecNode* child : children) {
+    if (!FeedsOnlyStoppedSinks(child)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status ExecutionGraph::CutOffStragglers(
+    absl::flat_hash_set<SourceNode*>* running_sources,
+    const absl::flat_hash_map<SourceNode*, int64_t>& source_to_id) {
+  double quorum_fraction = exec_state_->straggler_quorum_fraction();
+  std::chrono::milliseconds deadline = exec_state_->straggler_deadline();
+  if (grpc_sources_.empty() || (quorum_fraction <= 0 && deadline.count() <= 0)) {
+    return Status::OK();
+  }
+
+  std::vector<SourceNode*> running_grpc_sources;
+  for (SourceNode* source : *running_sources) {
+    if (grpc_sources_.contains(source_to_id.at(source))) {
+      running_grpc_sources.push_back(source);
+    }
+  }
+  if (running_grpc_sources.empty()) {
+    return Status::OK();
+  }
+
+  int64_t num_sources = grpc_sources_.size();
+  int64_t num_done = num_sources - running_grpc_sources.size();
+  bool quorum_reached = quorum_fraction > 0 && num_done >= quorum_fraction * num_sources;
+  bool deadline_passed =
+      deadline.count() > 0 && std::chrono::system_clock::now() - query_start_time_ >= deadline;
+  if (!quorum_reached && !deadline_passed) {
+    return Status::OK();
+  }
+
+  for (SourceNode* source : running_grpc_sources) {
+    int64_t src_id = source_to_id.at(source);
+    LOG(WARNING) << absl::Substitute(
+        "Query $0 is no longer waiting on GRPC source $1 ($2 of $3 GRPC sources done, deadline "
+        "passed: $4), finishing without the rest of its results.",
+        exec_state_->query_id().str(), src_id, num_done, num_sources, deadline_passed);
+    PL_RETURN_IF_ERROR(source->SendEndOfStream(exec_state_));
+    exec_state_->AddStragglerSource(src_id);
+    if (exec_state_->grpc_router() != nullptr) {
+      exec_state_->grpc_router()->CancelSourceStream(exec_state_->query_id(), src_id);
+    }
+    running_sources->erase(source);
+  }
+  return Status::OK();
+}
+
+Status ExecutionGraph::StopSources(const absl::flat_hash_set<SourceNode*>& running_sources) {
+  LOG(INFO) << absl::Substitute("Stopping query $0 with $1 running sources",
+                                exec_state_->query_id().str(), running_sources.size());
+  for (SourceNode* source : running_sources) {
+    PL_RETURN_IF_ERROR(source->SendEndOfStream(exec_state_));
   }
   return Status::OK();
 }
 
+StatusOr<std::chrono::milliseconds> ExecutionGraph::FlushDueRowBatches() {
+  auto due_in = std::chrono::milliseconds::max();
+  for (const auto& [id, node] : nodes_) {
+    PL_RETURN_IF_ERROR(node->FlushDueRowBatches(exec_state_));
+    due_in = std::min(due_in, node->TimeUntilRowBatchesDue());
+  }
+  return due_in;
+}
+
 Status ExecutionGraph::ExecuteSources() {
   absl::flat_hash_set<SourceNode*> running_sources;
 
@@ -185,8 +387,15 @@ Status ExecutionGraph::ExecuteSources() {
     source_to_id[n] = node_id;
   }
 
+  cpu_quota_period_start_ = std::chrono::steady_clock::now();
+  cpu_quota_period_start_cpu_ = ThreadCPUTime();
+  time_slice_start_ = cpu_quota_period_start_;
+
   // Run all sources to completion, or exit if the query encounters an error.
   while (running_sources.size()) {
+    if (exec_state_->stop_requested()) {
+      return StopSources(running_sources);
+    }
     absl::flat_hash_set<SourceNode*> completed_sources_execute_loop;
 
     for (SourceNode* source : running_sources) {
@@ -206,15 +415,29 @@ Status ExecutionGraph::ExecuteSources() {
       exec_state_->SetCurrentSource(source_to_id[source]);
 
       for (auto i = 0; i < consecutive_generate_calls_per_source_; ++i) {
-        if (!source->NextBatchReady() || !exec_state_->keep_running()) {
+        // Every source gets a batch in each pass, so a slow source can't starve the others.
+        if (!source->NextBatchReady() || !exec_state_->keep_running() ||
+            (i > 0 && TimeSliceElapsed())) {
           break;
         }
         PL_RETURN_IF_ERROR(source->GenerateNext(exec_state_));
+        // Stop the query at the first row batch boundary after it goes over its memory limit.
+        PL_RETURN_IF_ERROR(exec_state_->CheckMemoryLimit());
       }
 
       // keep_running will be set to false when a downstream limit for this particular
-      // source (set in exec_state) has been reached.
-      if (!source->HasBatchesRemaining() || !exec_state_->keep_running()) {
+      // source (set in exec_state) has been reached. The source is also done once all of its
+      // results go to remote destinations whose own limits were reached.
+      bool source_stopped = !exec_state_->keep_running() ||
+                            (!stopped_sinks_.empty() && FeedsOnlyStoppedSinks(source));
+      if (source_stopped && source->HasBatchesRemaining() &&
+          grpc_sources_.contains(source_to_id.at(source)) &&
+          exec_state_->grpc_router() != nullptr) {
+        // Tell the agent sending this source's results that it can stop producing them.
+        exec_state_->grpc_router()->StopSourceStream(exec_state_->query_id(),
+                                                     source_to_id.at(source));
+      }
+      if (!source->HasBatchesRemaining() || source_stopped) {
         completed_sources_execute_loop.insert(source);
         break;
       }
@@ -225,11 +448,17 @@ Status ExecutionGraph::ExecuteSources() {
     for (SourceNode* source : completed_sources_execute_loop) {
       running_sources.erase(source);
     }
+    PL_RETURN_IF_ERROR(CutOffStragglers(&running_sources, source_to_id));
 
     // If all sources are complete, the query is done executing.
     if (!running_sources.size()) {
       break;
     }
+    PL_ASSIGN_OR_RETURN(auto held_rows_due_in, FlushDueRowBatches());
+    if (TimeSliceElapsed()) {
+      EndTimeSlice();
+    }
+    ThrottleToCPUQuota();
 
     // For all running sources, check to see if any of them have data
     // or if we need to yield for more data.
@@ -244,8 +473,13 @@ Status ExecutionGraph::ExecuteSources() {
     while (wait_for_more_data) {
       auto timer = ElapsedTimer();
       timer.Start();
-      YieldWithTimeout();
+      // Wake up in time to send the rows held back by coalescing, so streaming results aren't
+      // delayed by a pause in the inputs.
+      YieldWithTimeout(std::min(yield_timeout_ms_, held_rows_due_in));
       timer.Stop();
+      if (exec_state_->stop_requested()) {
+        return StopSources(running_sources);
+      }
 
       absl::flat_hash_set<SourceNode*> completed_sources_wait_loop;
 
@@ -271,11 +505,13 @@ Status ExecutionGraph::ExecuteSources() {
         }
       }
       PL_RETURN_IF_ERROR(CheckDownstreamGRPCConnectionsHealth());
+      PL_ASSIGN_OR_RETURN(held_rows_due_in, FlushDueRowBatches());
 
       // Flush all of the completed sources after this phase of source deletion.
       for (SourceNode* source : completed_sources_wait_loop) {
         running_sources.erase(source);
       }
+      PL_RETURN_IF_ERROR(CutOffStragglers(&running_sources, source_to_id));
       if (!running_sources.size()) {
         return Status::OK();
       }
@@ -20,6 +20,7 @@
 
 #include <stddef.h>
 #include <algorithm>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <memory>
@@ -32,6 +33,7 @@
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/memory_source_node.h"
+#include "src/carnot/exec/plan_template_cache.h"
 #include "src/carnot/plan/plan_fragment.h"
 #include "src/carnot/plan/plan_state.h"
 #include "src/common/base/base.h"
@@ -39,6 +41,11 @@
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_bool(carnot_defer_filtered_columns);
+DECLARE_bool(carnot_skip_batches_with_zone_maps);
+DECLARE_bool(carnot_select_pods_in_memory_sources);
+DECLARE_int64(carnot_exec_time_slice_ms);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -89,6 +96,15 @@ class ExecutionGraph {
               ExecState* exec_state, plan::PlanFragment* pf, bool collect_exec_node_stats,
               int32_t consecutive_generate_calls_per_source);
 
+  /**
+   * Must be called before Init. The operator relations are taken from cached when it has them, and
+   * the relations that had to be computed are recorded into recorded, if it's set.
+   */
+  void SetFragmentTemplate(const PlanFragmentTemplate* cached, PlanFragmentTemplate* recorded) {
+    cached_template_ = cached;
+    recorded_template_ = recorded;
+  }
+
   Status Init(table_store::schema::Schema* schema, plan::PlanState* plan_state,
               ExecState* exec_state, plan::PlanFragment* pf, bool collect_exec_node_stats) {
     return Init(schema, plan_state, exec_state, pf, collect_exec_node_stats,
@@ -135,7 +151,8 @@ class ExecutionGraph {
    * Yields the execution of the current graph until Continue() is called or the timeout is reached.
    * @return true if the yield timed out, false if Continue() was called.
    */
-  bool YieldWithTimeout();
+  bool YieldWithTimeout() { return YieldWithTimeout(yield_timeout_ms_); }
+  bool YieldWithTimeout(std::chrono::milliseconds timeout);
 
   std::vector<std::string> OutputTables() const;
   ExecutionStats GetStats() const;
@@ -185,7 +202,15 @@ class ExecutionGraph {
       input_descriptors.push_back(input_desc->second);
     }
     // Get output descriptor.
-    PL_ASSIGN_OR_RETURN(auto output_rel, node.OutputRelation(*schema_, *plan_state_, parents));
+    table_store::schema::Relation output_rel;
+    if (cached_template_ != nullptr && cached_template_->output_relations.contains(node.id())) {
+      output_rel = cached_template_->output_relations.at(node.id());
+    } else {
+      PL_ASSIGN_OR_RETURN(output_rel, node.OutputRelation(*schema_, *plan_state_, parents));
+      if (recorded_template_ != nullptr) {
+        recorded_template_->output_relations[node.id()] = output_rel;
+      }
+    }
     table_store::schema::RowDescriptor output_descriptor(output_rel.col_types());
     schema_->AddRelation(node.id(), output_rel);
     descriptors->insert({node.id(), output_descriptor});
@@ -210,6 +235,50 @@ class ExecutionGraph {
 
   Status ExecuteSources();
 
+  // Sends the eos of every running source, once the query has been asked to stop.
+  Status StopSources(const absl::flat_hash_set<SourceNode*>& running_sources);
+
+  /**
+   * Cuts off the GRPC sources that are still running once the query's straggler policy says it
+   * shouldn't wait on them any longer: each gets its end of stream and its upstream result stream
+   * is cancelled. The cut off sources are removed from running_sources.
+   */
+  Status CutOffStragglers(absl::flat_hash_set<SourceNode*>* running_sources,
+                          const absl::flat_hash_map<SourceNode*, int64_t>& source_to_id);
+
+  /**
+   * Sends the rows that nodes hold back for coalescing once they are due, and returns how long
+   * until the next held rows are due.
+   */
+  StatusOr<std::chrono::milliseconds> FlushDueRowBatches();
+
+  /**
+   * Whether every sink that the node's results reach is a GRPC sink whose destination needs no
+   * more results, so that the sources feeding the node can stop.
+   */
+  bool FeedsOnlyStoppedSinks(ExecNode* node) const;
+
+  /**
+   * If the filter is the only consumer of a memory source, defers every source column that the
+   * filter predicate does not read, so the filter only converts the rows it keeps. The source is
+   * also given the predicate's column/constant comparisons to skip cold batches with.
+   */
+  void PushDownFilterToMemorySource(const plan::FilterOperator& node);
+
+  /**
+   * Yields while the executing thread has used more CPU than the query's quota of the current
+   * quota period allows. Does nothing for queries without a CPU quota.
+   */
+  void ThrottleToCPUQuota();
+
+  /**
+   * A query's time slice is the stretch of execution between two scheduling points. At the end of
+   * each slice the executing thread is offered to other work, and the query waits while its
+   * priority is paused.
+   */
+  bool TimeSliceElapsed() const;
+  void EndTimeSlice();
+
   ExecState* exec_state_;
   ObjectPool pool_{"exec_graph_pool"};
   table_store::schema::Schema* schema_;
@@ -219,6 +288,9 @@ class ExecutionGraph {
   std::vector<int64_t> sinks_;
   absl::flat_hash_set<int64_t> grpc_sources_;
   absl::flat_hash_set<int64_t> grpc_sinks_;
+  // The GRPC sinks whose destination needs no more results.
+  absl::flat_hash_set<ExecNode*> stopped_sinks_;
+  absl::flat_hash_set<int64_t> memory_sources_;
   std::unordered_map<int64_t, ExecNode*> nodes_;
 
   SystemTimePoint query_start_time_;
@@ -230,6 +302,12 @@ class ExecutionGraph {
   // for the presence of new data.
   std::chrono::milliseconds yield_timeout_ms_;
 
+  // The start of the current CPU quota period, in wall time and in CPU time of the executing
+  // thread.
+  std::chrono::steady_clock::time_point cpu_quota_period_start_;
+  std::chrono::nanoseconds cpu_quota_period_start_cpu_{0};
+  std::chrono::steady_clock::time_point time_slice_start_;
+
   // We alternate round robin style between running sources when calling GenerateNext to ensure
   // that no active sources are starved during a streaming query. This field sets the max number of
   // times in a row to invoke a particular source before moving on to another available source.
@@ -242,6 +320,9 @@ class ExecutionGraph {
   std::condition_variable execution_cv_;
   // Whether to collect stats on exec nodes.
   bool collect_exec_node_stats_;
+
+  const PlanFragmentTemplate* cached_template_ = nullptr;
+  PlanFragmentTemplate* recorded_template_ = nullptr;
 };
 
 }  // namespace exec
@@ -20,8 +20,12 @@
 
 #include <arrow/array.h>
 #include <arrow/memory_pool.h>
+#include <atomic>
+#include <chrono>
+#include <ctime>
 #include <memory>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -39,6 +43,7 @@
 #include "src/carnot/udf/registry.h"
 #include "src/carnot/udf/udf.h"
 #include "src/common/base/test_utils.h"
+#include "src/common/perf/perf.h"
 #include "src/shared/types/arrow_adapter.h"
 #include "src/shared/types/types.h"
 #include "src/table_store/table_store.h"
@@ -668,6 +673,102 @@ TEST_F(YieldingExecGraphTest, yield_timeout) {
   exec_thread.join();
 }
 
+TEST_F(YieldingExecGraphTest, cpu_quota) {
+  ExecutionGraph e{std::chrono::milliseconds(1), std::chrono::milliseconds(1)};
+  e.testing_set_exec_state(exec_state_.get());
+  exec_state_->set_cpu_quota(0.25);
+
+  RowDescriptor output_rd({types::DataType::INT64});
+  MockSourceNode busy_source(output_rd);
+  FakePlanNode plan_node(1);
+
+  EXPECT_CALL(busy_source, InitImpl(::testing::_));
+  ASSERT_OK(busy_source.Init(plan_node, output_rd, {}));
+  EXPECT_CALL(busy_source, PrepareImpl(::testing::_))
+      .Times(1)
+      .WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(busy_source, OpenImpl(::testing::_))
+      .Times(1)
+      .WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(busy_source, CloseImpl(::testing::_))
+      .Times(1)
+      .WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(busy_source, NextBatchReady()).WillRepeatedly(::testing::Return(true));
+
+  // Each batch burns 4ms of CPU, 100ms over the whole query.
+  int batches = 0;
+  auto burn_cpu = [&](ExecState*) {
+    auto start = std::clock();
+    while ((std::clock() - start) * 1000 / CLOCKS_PER_SEC < 4) {
+    }
+    if (++batches == 25) {
+      busy_source.SendEOS();
+    }
+  };
+  EXPECT_CALL(busy_source, GenerateNextImpl(::testing::_))
+      .Times(25)
+      .WillRepeatedly(
+          ::testing::DoAll(::testing::Invoke(burn_cpu), ::testing::Return(Status::OK())));
+  e.AddNode(1, &busy_source);
+
+  auto timer = ElapsedTimer();
+  timer.Start();
+  ASSERT_OK(e.Execute());
+  timer.Stop();
+  // At a quarter of a core, the first 80ms of CPU take at least 320ms.
+  EXPECT_GE(timer.ElapsedTime_us(), 300 * 1000);
+}
+
+TEST_F(YieldingExecGraphTest, paused_at_time_slice_boundary) {
+  auto time_slice_ms = FLAGS_carnot_exec_time_slice_ms;
+  FLAGS_carnot_exec_time_slice_ms = 1;
+  ExecutionGraph e{std::chrono::milliseconds(1), std::chrono::milliseconds(1)};
+  e.testing_set_exec_state(exec_state_.get());
+  ExecutionGate gate;
+  exec_state_->set_priority(planpb::PlanOptions::BACKGROUND, &gate);
+
+  RowDescriptor output_rd({types::DataType::INT64});
+  MockSourceNode source(output_rd);
+  FakePlanNode plan_node(1);
+
+  EXPECT_CALL(source, InitImpl(::testing::_));
+  ASSERT_OK(source.Init(plan_node, output_rd, {}));
+  EXPECT_CALL(source, PrepareImpl(::testing::_))
+      .Times(1)
+      .WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(source, OpenImpl(::testing::_)).Times(1).WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(source, CloseImpl(::testing::_)).Times(1).WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(source, NextBatchReady()).WillRepeatedly(::testing::Return(true));
+
+  // The first batch pauses the query, which can only produce the second one once resumed.
+  std::atomic<bool> resumed{false};
+  int batches = 0;
+  auto generate = [&](ExecState*) {
+    if (batches == 0) {
+      gate.Pause(planpb::PlanOptions::BACKGROUND);
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    } else {
+      EXPECT_TRUE(resumed);
+      source.SendEOS();
+    }
+    ++batches;
+  };
+  EXPECT_CALL(source, GenerateNextImpl(::testing::_))
+      .Times(2)
+      .WillRepeatedly(
+          ::testing::DoAll(::testing::Invoke(generate), ::testing::Return(Status::OK())));
+  e.AddNode(1, &source);
+
+  std::thread resume_thread([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    resumed = true;
+    gate.Resume(planpb::PlanOptions::BACKGROUND);
+  });
+  EXPECT_OK(e.Execute());
+  resume_thread.join();
+  FLAGS_carnot_exec_time_slice_ms = time_slice_ms;
+}
+
 constexpr char kGRPCSourcePlanFragment[] = R"(
   id: 1,
   dag {
@@ -889,6 +990,148 @@ TEST_F(GRPCExecGraphTest, infinite_source_and_error_source) {
   EXPECT_NOT_OK(s);
 }
 
+TEST_F(GRPCExecGraphTest, straggler_deadline) {
+  // The upstream connects but never sends anything, which would otherwise block the query.
+  exec_state_->set_straggler_policy(/* quorum_fraction */ 0, std::chrono::milliseconds(1));
+  ExecutionGraph e{std::chrono::milliseconds(1), std::chrono::milliseconds(1000)};
+  ASSERT_OK(e.Init(schema_.get(), plan_state_.get(), exec_state_.get(), plan_fragment_.get(),
+                   /* collect_exec_node_stats */ false));
+
+  auto src_id = *(e.grpc_sources().begin());
+  auto grpc_src = static_cast<GRPCSourceNode*>(e.node(src_id).ConsumeValueOrDie());
+  grpc_src->set_upstream_initiated_connection();
+
+  EXPECT_OK(e.Execute());
+  EXPECT_FALSE(grpc_src->HasBatchesRemaining());
+  EXPECT_THAT(exec_state_->straggler_sources(), ::testing::ElementsAre(src_id));
+}
+
+constexpr char kTwoGRPCSourcesPlanFragment[] = R"(
+  id: 1,
+  dag {
+    nodes {
+      id: 1
+      sorted_children: 2
+    }
+    nodes {
+      id: 2
+      sorted_parents: 1
+    }
+    nodes {
+      id: 3
+      sorted_children: 4
+    }
+    nodes {
+      id: 4
+      sorted_parents: 3
+    }
+  }
+  nodes {
+    id: 1
+    op {
+      op_type: GRPC_SOURCE_OPERATOR
+      grpc_source_op {
+        column_types: INT64
+        column_names: "test"
+      }
+    }
+  }
+  nodes {
+    id: 2
+    op {
+      op_type: MEMORY_SINK_OPERATOR
+      mem_sink_op {
+        name: "mem_sink1"
+        column_types: INT64
+        column_names: "test"
+      }
+    }
+  }
+  nodes {
+    id: 3
+    op {
+      op_type: GRPC_SOURCE_OPERATOR
+      grpc_source_op {
+        column_types: INT64
+        column_names: "test"
+      }
+    }
+  }
+  nodes {
+    id: 4
+    op {
+      op_type: MEMORY_SINK_OPERATOR
+      mem_sink_op {
+        name: "mem_sink2"
+        column_types: INT64
+        column_names: "test"
+      }
+    }
+  }
+)";
+
+TEST_F(GRPCExecGraphTest, straggler_quorum) {
+  planpb::PlanFragment pf_pb;
+  ASSERT_TRUE(TextFormat::MergeFromString(kTwoGRPCSourcesPlanFragment, &pf_pb));
+  auto plan_fragment = std::make_shared<plan::PlanFragment>(1);
+  ASSERT_OK(plan_fragment->Init(pf_pb));
+
+  exec_state_->set_straggler_policy(/* quorum_fraction */ 0.5, std::chrono::milliseconds(0));
+  ExecutionGraph e{std::chrono::milliseconds(1), std::chrono::milliseconds(1000)};
+  ASSERT_OK(e.Init(schema_.get(), plan_state_.get(), exec_state_.get(), plan_fragment.get(),
+                   /* collect_exec_node_stats */ false));
+
+  auto done_src = static_cast<GRPCSourceNode*>(e.node(1).ConsumeValueOrDie());
+  auto slow_src = static_cast<GRPCSourceNode*>(e.node(3).ConsumeValueOrDie());
+  done_src->set_upstream_initiated_connection();
+  slow_src->set_upstream_initiated_connection();
+
+  RowDescriptor output_rd({types::DataType::INT64});
+  auto req = std::make_unique<carnotpb::TransferResultChunkRequest>();
+  auto rb = RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>({1, 2})
+                .get();
+  ASSERT_OK(rb.ToProto(req->mutable_query_result()->mutable_row_batch()));
+  ASSERT_OK(done_src->EnqueueRowBatch(std::move(req)));
+
+  // Half of the sources are done, so the query shouldn't wait on the other one.
+  EXPECT_OK(e.Execute());
+  EXPECT_FALSE(slow_src->HasBatchesRemaining());
+  EXPECT_THAT(exec_state_->straggler_sources(), ::testing::ElementsAre(3));
+}
+
+TEST_F(GRPCExecGraphTest, stop_query_with_infinite_source) {
+  ExecutionGraph e{std::chrono::milliseconds(1), std::chrono::milliseconds(1)};
+  e.testing_set_exec_state(exec_state_.get());
+
+  RowDescriptor output_rd({types::DataType::INT64});
+  MockSourceNode infinite_source(output_rd);
+  FakePlanNode plan_node(1);
+
+  EXPECT_CALL(infinite_source, InitImpl(::testing::_));
+  ASSERT_OK(infinite_source.Init(plan_node, output_rd, {}));
+  EXPECT_CALL(infinite_source, PrepareImpl(::testing::_))
+      .Times(1)
+      .WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(infinite_source, OpenImpl(::testing::_))
+      .Times(1)
+      .WillOnce(::testing::Return(Status::OK()));
+  EXPECT_CALL(infinite_source, CloseImpl(::testing::_))
+      .Times(1)
+      .WillOnce(::testing::Return(Status::OK()));
+  // The source never runs out of data, like a streaming memory source waiting on new rows.
+  EXPECT_CALL(infinite_source, NextBatchReady()).WillRepeatedly(::testing::Return(false));
+  e.AddNode(10, &infinite_source);
+
+  std::thread stop_thread([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    exec_state_->StopQuery();
+  });
+  EXPECT_OK(e.Execute());
+  stop_thread.join();
+  EXPECT_FALSE(infinite_source.HasBatchesRemaining());
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -18,11 +18,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
+
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/row_batch_coalescer.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/perf/perf.h"
@@ -38,6 +45,43 @@ enum class ExecNodeType : int8_t {
   kProcessingNode = 2,
 };
 
+/**
+ * Log2Histogram counts values in power of two buckets, for the distributions of ExecNodeStats.
+ */
+class Log2Histogram {
+ public:
+  void Add(uint64_t value) {
+    ++buckets_[value == 0 ? 0 : 64 - __builtin_clzll(value)];
+    ++count_;
+    max_ = std::max(max_, value);
+  }
+
+  /**
+   * Returns the upper bound of the bucket that holds the q quantile, capped at the max value.
+   */
+  uint64_t Quantile(double q) const {
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * count_)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        uint64_t upper_bound = i == 0 ? 0 : (i == 64 ? UINT64_MAX : (uint64_t{1} << i) - 1);
+        return std::min(upper_bound, max_);
+      }
+    }
+    return max_;
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t max() const { return max_; }
+
+ private:
+  // Bucket 0 holds 0, and bucket i holds the values in [2^(i-1), 2^i).
+  std::array<uint64_t, 65> buckets_ = {};
+  uint64_t count_ = 0;
+  uint64_t max_ = 0;
+};
+
 struct ExecNodeStats {
   explicit ExecNodeStats(bool collect_stats) : collect_exec_stats(collect_stats) {}
   void AddOutputStats(const table_store::schema::RowBatch& rb) {
@@ -47,6 +91,7 @@ struct ExecNodeStats {
     ++batches_output;
     bytes_output += rb.NumBytes();
     rows_output += rb.num_rows();
+    output_batch_rows.Add(rb.num_rows());
   }
 
   void AddInputStats(const table_store::schema::RowBatch& rb) {
@@ -56,6 +101,7 @@ struct ExecNodeStats {
     ++batches_input;
     bytes_input += rb.NumBytes();
     rows_input += rb.num_rows();
+    input_batch_rows.Add(rb.num_rows());
   }
 
   void ResumeChildTimer() {
@@ -75,12 +121,16 @@ struct ExecNodeStats {
       return;
     }
     total_timer.Resume();
+    call_start_time = std::chrono::steady_clock::now();
   }
   void StopTotalTimer() {
     if (!collect_exec_stats) {
       return;
     }
     total_timer.Stop();
+    call_time_ns.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - call_start_time)
+                         .count());
   }
 
   void AddExtraMetric(std::string_view key, double value) {
@@ -99,6 +149,23 @@ struct ExecNodeStats {
     extra_info[key] = value;
   }
 
+  /**
+   * Adds the distributions of the call times and batch sizes to the extra metrics.
+   */
+  void AddDistributionMetrics() {
+    auto add_distribution = [this](std::string_view name, const Log2Histogram& histogram) {
+      if (histogram.count() == 0) {
+        return;
+      }
+      AddExtraMetric(absl::StrCat(name, "_p50"), histogram.Quantile(0.5));
+      AddExtraMetric(absl::StrCat(name, "_p99"), histogram.Quantile(0.99));
+      AddExtraMetric(absl::StrCat(name, "_max"), histogram.max());
+    };
+    add_distribution("call_time_ns", call_time_ns);
+    add_distribution("input_batch_rows", input_batch_rows);
+    add_distribution("output_batch_rows", output_batch_rows);
+  }
+
   int64_t ChildExecTime() const { return children_timer.ElapsedTime_us() * 1000; }
   int64_t TotalExecTime() const { return total_timer.ElapsedTime_us() * 1000; }
   int64_t SelfExecTime() const { return TotalExecTime() - ChildExecTime(); }
@@ -119,6 +186,12 @@ struct ExecNodeStats {
   ElapsedTimer total_timer;
   // Total timer for the children of the ndoe.
   ElapsedTimer children_timer;
+  // The time of each GenerateNext/ConsumeNext call, children included.
+  Log2Histogram call_time_ns;
+  std::chrono::steady_clock::time_point call_start_time;
+  // The rows of each input and output batch.
+  Log2Histogram input_batch_rows;
+  Log2Histogram output_batch_rows;
   // Flag to determine whether to collect stats or not.
   bool collect_exec_stats;
 
@@ -275,6 +348,31 @@ class ExecNode {
 
   ExecNodeStats* stats() const { return stats_.get(); }
 
+  /**
+   * How long until the rows held back by output coalescing are due to be sent, or max() if no
+   * rows are held.
+   */
+  std::chrono::milliseconds TimeUntilRowBatchesDue() const {
+    if (output_coalescer_ == nullptr) {
+      return std::chrono::milliseconds::max();
+    }
+    return output_coalescer_->TimeUntilFlushDue();
+  }
+
+  /**
+   * Sends the rows held back by output coalescing to the children, if they have waited for the
+   * coalescing delay.
+   * @param exec_state The exec state.
+   * @return Status of children execution.
+   */
+  Status FlushDueRowBatches(ExecState* exec_state) {
+    if (output_coalescer_ == nullptr || !output_coalescer_->FlushDue()) {
+      return Status::OK();
+    }
+    PL_ASSIGN_OR_RETURN(auto rb, output_coalescer_->Flush(exec_state->exec_mem_pool()));
+    return SendRowBatchToChildrenNow(exec_state, *rb);
+  }
+
  protected:
   /**
    * Send data to children row batches.
@@ -283,6 +381,28 @@ class ExecNode {
    * @return Status of children execution.
    */
   Status SendRowBatchToChildren(ExecState* exec_state, const table_store::schema::RowBatch& rb) {
+    if (output_coalescer_ == nullptr) {
+      return SendRowBatchToChildrenNow(exec_state, rb);
+    }
+    PL_ASSIGN_OR_RETURN(auto output_rb, output_coalescer_->Add(rb, exec_state->exec_mem_pool()));
+    if (output_rb == nullptr) {
+      return Status::OK();
+    }
+    return SendRowBatchToChildrenNow(exec_state, *output_rb);
+  }
+
+  /**
+   * Merges the small row batches sent to children into batches of the target rows or bytes. See
+   * RowBatchCoalescer. Must be called after Init.
+   */
+  void CoalesceOutputRowBatches(int64_t target_rows, int64_t target_bytes,
+                                std::chrono::milliseconds max_delay) {
+    output_coalescer_ = std::make_unique<RowBatchCoalescer>(*output_descriptor_, target_rows,
+                                                            target_bytes, max_delay);
+  }
+
+  Status SendRowBatchToChildrenNow(ExecState* exec_state,
+                                   const table_store::schema::RowBatch& rb) {
     stats_->ResumeChildTimer();
     for (size_t i = 0; i < children_.size(); ++i) {
       PL_RETURN_IF_ERROR(children_[i]->ConsumeNext(exec_state, rb, parent_ids_for_children_[i]));
@@ -319,6 +439,8 @@ class ExecNode {
   std::vector<table_store::schema::RowDescriptor> input_descriptors_;
   // Whether or not the node sent EOS to its children.
   bool sent_eos_ = false;
+  // Set when the row batches sent to children are coalesced.
+  std::unique_ptr<RowBatchCoalescer> output_coalescer_;
 
  private:
   // The stats of this exec node.
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/exec_node.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+TEST(Log2HistogramTest, quantiles) {
+  Log2Histogram histogram;
+  EXPECT_EQ(0, histogram.Quantile(0.5));
+
+  for (uint64_t v = 1; v <= 100; ++v) {
+    histogram.Add(v);
+  }
+  EXPECT_EQ(100, histogram.count());
+  EXPECT_EQ(100, histogram.max());
+  // 50 is in the bucket [32, 64).
+  EXPECT_EQ(63, histogram.Quantile(0.5));
+  // The last bucket is capped at the max.
+  EXPECT_EQ(100, histogram.Quantile(0.99));
+  EXPECT_EQ(1, histogram.Quantile(0));
+
+  histogram.Add(0);
+  EXPECT_EQ(0, histogram.Quantile(0));
+}
+
+TEST(ExecNodeStatsTest, distribution_metrics) {
+  ExecNodeStats stats(/* collect_stats */ true);
+  RowDescriptor desc(std::vector<types::DataType>{});
+  for (int64_t num_rows : {10, 20, 1000}) {
+    stats.AddInputStats(RowBatch(desc, num_rows));
+    stats.ResumeTotalTimer();
+    stats.StopTotalTimer();
+  }
+  stats.AddDistributionMetrics();
+
+  EXPECT_EQ(31, stats.extra_metrics["input_batch_rows_p50"]);
+  EXPECT_EQ(1000, stats.extra_metrics["input_batch_rows_max"]);
+  EXPECT_TRUE(stats.extra_metrics.contains("call_time_ns_p99"));
+  // Nothing was output.
+  EXPECT_FALSE(stats.extra_metrics.contains("output_batch_rows_p50"));
+}
+
+TEST(ExecNodeStatsTest, disabled) {
+  ExecNodeStats stats(/* collect_stats */ false);
+  stats.AddInputStats(RowBatch(RowDescriptor(std::vector<types::DataType>{}), 10));
+  stats.AddDistributionMetrics();
+  EXPECT_EQ(0, stats.input_batch_rows.count());
+  EXPECT_TRUE(stats.extra_metrics.empty());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -20,6 +20,8 @@
 
 #include <arrow/memory_pool.h>
 
+#include <atomic>
+#include <chrono>
 #include <map>
 #include <memory>
 #include <string>
@@ -29,8 +31,11 @@
 #include <sole.hpp>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
+#include "src/carnot/exec/execution_gate.h"
 #include "src/carnot/exec/grpc_router.h"
 #include "src/carnot/exec/ml/model_pool.h"
+#include "src/carnot/exec/morsel_executor.h"
+#include "src/carnot/exec/query_memory_pool.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 #include "src/shared/metadata/metadata_state.h"
@@ -67,16 +72,30 @@ class ExecState {
         query_id_(query_id),
         model_pool_(model_pool),
         grpc_router_(grpc_router),
-        add_auth_to_grpc_client_context_func_(add_auth_func) {}
+        add_auth_to_grpc_client_context_func_(add_auth_func),
+        exec_mem_pool_(QueryMemoryPool::Create(FLAGS_carnot_query_memory_limit_bytes)) {}
 
   ~ExecState() {
     if (grpc_router_ != nullptr) {
       grpc_router_->DeleteQuery(query_id_);
     }
+    exec_mem_pool_->Release();
   }
-  arrow::MemoryPool* exec_mem_pool() {
-    // TOOD(zasgar): Make this the correct pool.
-    return arrow::default_memory_pool();
+  arrow::MemoryPool* exec_mem_pool() { return exec_mem_pool_; }
+
+  // The most bytes the query had allocated from its memory pool at once.
+  int64_t peak_memory_bytes() const { return exec_mem_pool_->max_memory(); }
+
+  /**
+   * @return an error if the query went over its memory limit, in which case it should be stopped.
+   */
+  Status CheckMemoryLimit() const {
+    if (exec_mem_pool_->LimitExceeded()) {
+      return error::ResourceUnavailable(
+          "Query $0 exceeded its memory limit of $1 bytes (peak usage: $2 bytes)", query_id_.str(),
+          exec_mem_pool_->limit_bytes(), exec_mem_pool_->max_memory());
+    }
+    return Status::OK();
   }
 
   udf::Registry* func_registry() { return func_registry_; }
@@ -100,6 +119,13 @@ class ExecState {
     return Status::OK();
   }
 
+  // Sets the UDF and UDA definitions resolved by an earlier run of the same plan.
+  void SetFuncDefinitions(std::map<int64_t, udf::ScalarUDFDefinition*> scalar_udfs,
+                          std::map<int64_t, udf::UDADefinition*> udas) {
+    id_to_scalar_udf_map_ = std::move(scalar_udfs);
+    id_to_uda_map_ = std::move(udas);
+  }
+
   // This function returns a stub to a service that is responsible for receiving results.
   // Currently, it will either be a Kelvin instance or a query broker.
   carnotpb::ResultSinkService::StubInterface* ResultSinkServiceStub(
@@ -116,7 +142,14 @@ class ExecState {
     return raw;
   }
 
-  udf::ScalarUDFDefinition* GetScalarUDFDefinition(int64_t id) { return id_to_scalar_udf_map_[id]; }
+  udf::ScalarUDFDefinition* GetScalarUDFDefinition(int64_t id) {
+    // Avoid operator[] so that this is safe to call concurrently from morsel workers.
+    auto it = id_to_scalar_udf_map_.find(id);
+    if (it == id_to_scalar_udf_map_.end()) {
+      return nullptr;
+    }
+    return it->second;
+  }
 
   std::map<int64_t, udf::ScalarUDFDefinition*> id_to_scalar_udf_map() {
     return id_to_scalar_udf_map_;
@@ -124,6 +157,8 @@ class ExecState {
 
   udf::UDADefinition* GetUDADefinition(int64_t id) { return id_to_uda_map_[id]; }
 
+  std::map<int64_t, udf::UDADefinition*> id_to_uda_map() { return id_to_uda_map_; }
+
   std::unique_ptr<udf::FunctionContext> CreateFunctionContext() {
     auto ctx = std::make_unique<udf::FunctionContext>(metadata_state_, model_pool_);
     return ctx;
@@ -150,9 +185,73 @@ class ExecState {
   void set_metadata_state(std::shared_ptr<const md::AgentMetadataState> metadata_state) {
     metadata_state_ = metadata_state;
   }
+  const md::AgentMetadataState* metadata_state() const { return metadata_state_.get(); }
 
   GRPCRouter* grpc_router() { return grpc_router_; }
 
+  /**
+   * Lets the query finish without waiting on every incoming result stream.
+   * @param quorum_fraction once this fraction of the GRPC sources are done, the rest are cut off.
+   * 0 disables the quorum.
+   * @param deadline how long after the start of the query the remaining GRPC sources are cut off.
+   * 0 disables the deadline.
+   */
+  void set_straggler_policy(double quorum_fraction, std::chrono::milliseconds deadline) {
+    straggler_quorum_fraction_ = quorum_fraction;
+    straggler_deadline_ = deadline;
+  }
+  double straggler_quorum_fraction() const { return straggler_quorum_fraction_; }
+  std::chrono::milliseconds straggler_deadline() const { return straggler_deadline_; }
+
+  /**
+   * Asks the query to stop. Its sources send their eos at the next chance, so the query still
+   * finishes cleanly, which is how queries over infinite streams end. Safe to call from any thread.
+   */
+  void StopQuery() { stop_requested_ = true; }
+  bool stop_requested() const { return stop_requested_; }
+
+  /**
+   * Limits the CPU time the query's executing thread may use, as a fraction of wall time, e.g.
+   * 0.25 for a quarter of a core. 0 leaves the query unthrottled.
+   */
+  void set_cpu_quota(double cpu_quota) { cpu_quota_ = cpu_quota; }
+  double cpu_quota() const { return cpu_quota_; }
+
+  /**
+   * Sets the scheduling class of the query, and the gate that holds the query back at its time
+   * slice boundaries while its priority is paused. The gate may be null.
+   */
+  void set_priority(ExecutionGate::Priority priority, ExecutionGate* gate) {
+    priority_ = priority;
+    execution_gate_ = gate;
+  }
+  ExecutionGate::Priority priority() const { return priority_; }
+  ExecutionGate* execution_gate() const { return execution_gate_; }
+
+  // Records that the given GRPC source was cut off before its upstream agent finished.
+  void AddStragglerSource(int64_t src_id) { straggler_sources_.push_back(src_id); }
+  const std::vector<int64_t>& straggler_sources() const { return straggler_sources_; }
+
+  /**
+   * Enables morsel-driven parallel execution of stateless operators for this query.
+   * @param num_workers the number of workers (including the executing thread). Values <= 1 leave
+   * parallel execution disabled.
+   * @param morsel_size_rows the maximum number of rows handed to a single worker at once.
+   * @param pool the threads to run on, usually shared by all the queries of the agent. If null,
+   * the query gets threads of its own.
+   */
+  void EnableParallelExecution(int num_workers, int64_t morsel_size_rows,
+                               ThreadPool* pool = nullptr) {
+    if (num_workers <= 1) {
+      morsel_executor_.reset();
+      return;
+    }
+    morsel_executor_ = std::make_unique<MorselExecutor>(num_workers, morsel_size_rows, pool);
+  }
+
+  // Returns nullptr if parallel execution is disabled for this query.
+  MorselExecutor* morsel_executor() { return morsel_executor_.get(); }
+
   void AddAuthToGRPCClientContext(grpc::ClientContext* ctx) {
     CHECK(add_auth_to_grpc_client_context_func_);
     add_auth_to_grpc_client_context_func_(ctx);
@@ -174,6 +273,17 @@ class ExecState {
   ml::ModelPool* model_pool_;
   GRPCRouter* grpc_router_ = nullptr;
   std::function<void(grpc::ClientContext*)> add_auth_to_grpc_client_context_func_;
+  // Owned by the pool itself once the query releases it, see QueryMemoryPool.
+  QueryMemoryPool* exec_mem_pool_;
+  std::unique_ptr<MorselExecutor> morsel_executor_;
+
+  double straggler_quorum_fraction_ = 0;
+  std::chrono::milliseconds straggler_deadline_{0};
+  std::vector<int64_t> straggler_sources_;
+  std::atomic<bool> stop_requested_{false};
+  double cpu_quota_ = 0;
+  ExecutionGate::Priority priority_ = planpb::PlanOptions::INTERACTIVE;
+  ExecutionGate* execution_gate_ = nullptr;
 
   int64_t current_source_ = 0;
   bool current_source_set_ = false;
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/execution_gate.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+namespace {
+// How often a paused query checks whether it should stop.
+constexpr absl::Duration kStopCheckPeriod = absl::Milliseconds(10);
+}  // namespace
+
+void ExecutionGate::Pause(Priority priority) {
+  absl::MutexLock lock(&mu_);
+  ++pauses_[priority];
+}
+
+void ExecutionGate::Resume(Priority priority) {
+  absl::MutexLock lock(&mu_);
+  DCHECK_GT(pauses_[priority], 0);
+  if (pauses_[priority] > 0) {
+    --pauses_[priority];
+  }
+}
+
+bool ExecutionGate::paused(Priority priority) const {
+  absl::MutexLock lock(&mu_);
+  return pauses_[priority] > 0;
+}
+
+std::chrono::nanoseconds ExecutionGate::WaitUntilRunnable(
+    Priority priority, const std::function<bool()>& should_stop) {
+  auto start = std::chrono::steady_clock::now();
+  absl::MutexLock lock(&mu_);
+  auto resumed = [this, priority]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return pauses_[priority] == 0;
+  };
+  while (!resumed() && !should_stop()) {
+    mu_.AwaitWithTimeout(absl::Condition(&resumed), kStopCheckPeriod);
+  }
+  return std::chrono::steady_clock::now() - start;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
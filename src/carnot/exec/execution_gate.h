@@ -0,0 +1,64 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * ExecutionGate holds back the queries of a priority at their next time slice boundary, e.g. so
+ * background queries give up the CPU while table store compaction runs. Safe to use from any
+ * thread.
+ */
+class ExecutionGate : public NotCopyable {
+ public:
+  using Priority = planpb::PlanOptions::QueryPriority;
+
+  /**
+   * Pauses the queries of the given priority. Pauses are counted, so each needs its own Resume.
+   */
+  void Pause(Priority priority);
+  void Resume(Priority priority);
+  bool paused(Priority priority) const;
+
+  /**
+   * Blocks while the queries of the given priority are paused, or until should_stop returns true.
+   * @return how long the caller was held back.
+   */
+  std::chrono::nanoseconds WaitUntilRunnable(Priority priority,
+                                             const std::function<bool()>& should_stop);
+
+ private:
+  mutable absl::Mutex mu_;
+  std::array<int, planpb::PlanOptions::QueryPriority_ARRAYSIZE> pauses_ ABSL_GUARDED_BY(mu_) = {};
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/execution_gate.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using planpb::PlanOptions;
+
+TEST(ExecutionGateTest, runnable_when_not_paused) {
+  ExecutionGate gate;
+  gate.Pause(PlanOptions::BACKGROUND);
+  EXPECT_TRUE(gate.paused(PlanOptions::BACKGROUND));
+  EXPECT_FALSE(gate.paused(PlanOptions::INTERACTIVE));
+
+  auto waited = gate.WaitUntilRunnable(PlanOptions::INTERACTIVE, [] { return false; });
+  EXPECT_LT(waited, std::chrono::seconds(1));
+}
+
+TEST(ExecutionGateTest, pauses_are_counted) {
+  ExecutionGate gate;
+  gate.Pause(PlanOptions::BACKGROUND);
+  gate.Pause(PlanOptions::BACKGROUND);
+  gate.Resume(PlanOptions::BACKGROUND);
+  EXPECT_TRUE(gate.paused(PlanOptions::BACKGROUND));
+  gate.Resume(PlanOptions::BACKGROUND);
+  EXPECT_FALSE(gate.paused(PlanOptions::BACKGROUND));
+}
+
+TEST(ExecutionGateTest, wait_until_resumed) {
+  ExecutionGate gate;
+  gate.Pause(PlanOptions::BACKGROUND);
+
+  std::atomic<bool> resumed{false};
+  std::thread resume_thread([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    resumed = true;
+    gate.Resume(PlanOptions::BACKGROUND);
+  });
+  gate.WaitUntilRunnable(PlanOptions::BACKGROUND, [] { return false; });
+  EXPECT_TRUE(resumed);
+  resume_thread.join();
+}
+
+TEST(ExecutionGateTest, wait_until_stopped) {
+  ExecutionGate gate;
+  gate.Pause(PlanOptions::BACKGROUND);
+
+  std::atomic<bool> stop{false};
+  std::thread stop_thread([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stop = true;
+  });
+  gate.WaitUntilRunnable(PlanOptions::BACKGROUND, [&] { return stop.load(); });
+  EXPECT_TRUE(stop);
+  EXPECT_TRUE(gate.paused(PlanOptions::BACKGROUND));
+  stop_thread.join();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,395 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/filter_kernels.h"
+
+#include <arrow/builder.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+namespace {
+
+// Returns the op for `b <op> a`, given the op for `a <op> b`.
+CompareOp FlipCompareOp(CompareOp op) {
+  switch (op) {
+    case CompareOp::kLessThan:
+      return CompareOp::kGreaterThan;
+    case CompareOp::kLessThanEqual:
+      return CompareOp::kGreaterThanEqual;
+    case CompareOp::kGreaterThan:
+      return CompareOp::kLessThan;
+    case CompareOp::kGreaterThanEqual:
+      return CompareOp::kLessThanEqual;
+    default:
+      return op;
+  }
+}
+
+const absl::flat_hash_map<std::string, CompareOp>& CompareOps() {
+  static const auto* const kCompareOps = new absl::flat_hash_map<std::string, CompareOp>({
+      {"equal", CompareOp::kEqual},
+      {"notEqual", CompareOp::kNotEqual},
+      {"lessThan", CompareOp::kLessThan},
+      {"lessThanEqual", CompareOp::kLessThanEqual},
+      {"greaterThan", CompareOp::kGreaterThan},
+      {"greaterThanEqual", CompareOp::kGreaterThanEqual},
+  });
+  return *kCompareOps;
+}
+
+// Matches `col <op> val` and `val <op> col` (which is flipped into the former), where val is a
+// non-null constant of the same type as the column.
+bool MatchColumnComparison(const plan::ScalarFunc& func, CompareOp* op, const plan::Column** col,
+                           const plan::ScalarValue** val) {
+  const auto& args = func.arg_deps();
+  const auto& arg_types = func.registry_arg_types();
+  if (args.size() != 2 || arg_types.size() != 2 || arg_types[0] != arg_types[1]) {
+    return false;
+  }
+  const plan::ScalarExpression* col_expr = args[0].get();
+  const plan::ScalarExpression* val_expr = args[1].get();
+  if (col_expr->ExpressionType() == plan::Expression::kConstant &&
+      val_expr->ExpressionType() == plan::Expression::kColumn) {
+    std::swap(col_expr, val_expr);
+    *op = FlipCompareOp(*op);
+  }
+  if (col_expr->ExpressionType() != plan::Expression::kColumn ||
+      val_expr->ExpressionType() != plan::Expression::kConstant) {
+    return false;
+  }
+  *col = static_cast<const plan::Column*>(col_expr);
+  *val = static_cast<const plan::ScalarValue*>(val_expr);
+  return !(*val)->IsNull() && (*val)->DataType() == arg_types[0];
+}
+
+bool CompileComparison(const plan::ScalarFunc& func, CompareOp op,
+                       std::vector<ColumnComparison>* comparisons) {
+  const plan::Column* col;
+  const plan::ScalarValue* val;
+  if (!MatchColumnComparison(func, &op, &col, &val)) {
+    return false;
+  }
+  auto data_type = val->DataType();
+  if (data_type != types::INT64 && data_type != types::TIME64NS && data_type != types::FLOAT64) {
+    return false;
+  }
+  // Float equality is registered as approximate equality, so leave it to the UDF.
+  if (data_type == types::FLOAT64 && (op == CompareOp::kEqual || op == CompareOp::kNotEqual)) {
+    return false;
+  }
+
+  ColumnComparison comparison;
+  comparison.col_idx = col->Index();
+  comparison.data_type = data_type;
+  comparison.op = op;
+  if (data_type == types::FLOAT64) {
+    comparison.float_operand = val->Float64Value();
+  } else if (data_type == types::TIME64NS) {
+    comparison.int_operand = val->Time64NSValue();
+  } else {
+    comparison.int_operand = val->Int64Value();
+  }
+  comparisons->push_back(comparison);
+  return true;
+}
+
+bool ToZoneMapPredicate(const plan::ScalarFunc& func, CompareOp op,
+                        table_store::ZoneMapPredicate* pred) {
+  const plan::Column* col;
+  const plan::ScalarValue* val;
+  if (!MatchColumnComparison(func, &op, &col, &val)) {
+    return false;
+  }
+  switch (op) {
+    case CompareOp::kEqual:
+      pred->op = table_store::ZoneMapOp::kEqual;
+      break;
+    case CompareOp::kLessThan:
+      pred->op = table_store::ZoneMapOp::kLessThan;
+      break;
+    case CompareOp::kLessThanEqual:
+      pred->op = table_store::ZoneMapOp::kLessThanEqual;
+      break;
+    case CompareOp::kGreaterThan:
+      pred->op = table_store::ZoneMapOp::kGreaterThan;
+      break;
+    case CompareOp::kGreaterThanEqual:
+      pred->op = table_store::ZoneMapOp::kGreaterThanEqual;
+      break;
+    default:
+      return false;
+  }
+  pred->col_idx = col->Index();
+  pred->data_type = val->DataType();
+  switch (pred->data_type) {
+    case types::INT64:
+      pred->int_value = val->Int64Value();
+      return true;
+    case types::TIME64NS:
+      pred->int_value = val->Time64NSValue();
+      return true;
+    case types::FLOAT64:
+      // Float equality is approximate, so only ranges can be used to skip batches.
+      pred->float_value = val->Float64Value();
+      return op != CompareOp::kEqual;
+    case types::STRING:
+      pred->string_value = val->StringValue();
+      return op == CompareOp::kEqual;
+    case types::UINT128:
+      pred->uint128_value = val->UInt128Value();
+      return op == CompareOp::kEqual;
+    default:
+      return false;
+  }
+}
+
+template <typename T, typename TCmp>
+void CompareToOperandImpl(const T* __restrict__ values, int64_t num_rows, T operand,
+                          bool conjunct, uint8_t* __restrict__ mask) {
+  TCmp cmp;
+  if (conjunct) {
+    for (int64_t i = 0; i < num_rows; ++i) {
+      mask[i] &= static_cast<uint8_t>(cmp(values[i], operand));
+    }
+  } else {
+    for (int64_t i = 0; i < num_rows; ++i) {
+      mask[i] = static_cast<uint8_t>(cmp(values[i], operand));
+    }
+  }
+}
+
+template <typename T>
+void CompareToOperand(const T* values, int64_t n, T operand, CompareOp op, bool conjunct,
+                      uint8_t* mask) {
+  switch (op) {
+    case CompareOp::kEqual:
+      return CompareToOperandImpl<T, std::equal_to<T>>(values, n, operand, conjunct, mask);
+    case CompareOp::kNotEqual:
+      return CompareToOperandImpl<T, std::not_equal_to<T>>(values, n, operand, conjunct, mask);
+    case CompareOp::kLessThan:
+      return CompareToOperandImpl<T, std::less<T>>(values, n, operand, conjunct, mask);
+    case CompareOp::kLessThanEqual:
+      return CompareToOperandImpl<T, std::less_equal<T>>(values, n, operand, conjunct, mask);
+    case CompareOp::kGreaterThan:
+      return CompareToOperandImpl<T, std::greater<T>>(values, n, operand, conjunct, mask);
+    case CompareOp::kGreaterThanEqual:
+      return CompareToOperandImpl<T, std::greater_equal<T>>(values, n, operand, conjunct, mask);
+  }
+}
+
+template <types::DataType T>
+void CompareColumnToOperand(const arrow::Array* col,
+                            typename types::DataTypeTraits<T>::native_type operand, CompareOp op,
+                            bool conjunct, uint8_t* mask) {
+  using ArrayType = typename types::DataTypeTraits<T>::arrow_array_type;
+  using NativeType = typename types::DataTypeTraits<T>::native_type;
+  CompareToOperand<NativeType>(static_cast<const ArrayType*>(col)->raw_values(), col->length(),
+                               operand, op, conjunct, mask);
+}
+
+template <types::DataType T>
+Status GatherValues(const arrow::Array* input, const std::vector<int64_t>& selection,
+                    arrow::ArrayBuilder* builder) {
+  auto* typed_builder =
+      static_cast<typename types::DataTypeTraits<T>::arrow_builder_type*>(builder);
+  PL_RETURN_IF_ERROR(typed_builder->Reserve(selection.size()));
+  for (auto idx : selection) {
+    typed_builder->UnsafeAppend(types::GetValueFromArrowArray<T>(input, idx));
+  }
+  return Status::OK();
+}
+
+template <>
+Status GatherValues<types::STRING>(const arrow::Array* input,
+                                   const std::vector<int64_t>& selection,
+                                   arrow::ArrayBuilder* builder) {
+  const auto* typed_input = static_cast<const arrow::StringArray*>(input);
+  auto* typed_builder = static_cast<arrow::StringBuilder*>(builder);
+  // Size the data buffer exactly up front, so the copy loop never has to grow it.
+  int64_t total_size = 0;
+  for (auto idx : selection) {
+    total_size += typed_input->value_length(idx);
+  }
+  PL_RETURN_IF_ERROR(typed_builder->Reserve(selection.size()));
+  PL_RETURN_IF_ERROR(typed_builder->ReserveData(total_size));
+  for (auto idx : selection) {
+    int32_t length;
+    const uint8_t* value = typed_input->GetValue(idx, &length);
+    typed_builder->UnsafeAppend(value, length);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+bool CompileColumnComparisons(const plan::ScalarExpression& expr,
+                              std::vector<ColumnComparison>* comparisons) {
+  if (expr.ExpressionType() != plan::Expression::kFunc) {
+    return false;
+  }
+  const auto& func = static_cast<const plan::ScalarFunc&>(expr);
+  if (func.name() == "logicalAnd") {
+    for (const auto& arg : func.arg_deps()) {
+      if (!CompileColumnComparisons(*arg, comparisons)) {
+        return false;
+      }
+    }
+    return !func.arg_deps().empty();
+  }
+  auto it = CompareOps().find(func.name());
+  if (it == CompareOps().end()) {
+    return false;
+  }
+  return CompileComparison(func, it->second, comparisons);
+}
+
+void CollectZoneMapPredicates(const plan::ScalarExpression& expr,
+                              std::vector<table_store::ZoneMapPredicate>* preds) {
+  if (expr.ExpressionType() != plan::Expression::kFunc) {
+    return;
+  }
+  const auto& func = static_cast<const plan::ScalarFunc&>(expr);
+  if (func.name() == "logicalAnd") {
+    for (const auto& arg : func.arg_deps()) {
+      CollectZoneMapPredicates(*arg, preds);
+    }
+    return;
+  }
+  auto it = CompareOps().find(func.name());
+  if (it == CompareOps().end()) {
+    return;
+  }
+  table_store::ZoneMapPredicate pred;
+  if (ToZoneMapPredicate(func, it->second, &pred)) {
+    preds->push_back(std::move(pred));
+  }
+}
+
+void CollectUPIDPodPredicates(const plan::ScalarExpression& expr,
+                              std::vector<UPIDPodPredicate>* preds) {
+  if (expr.ExpressionType() != plan::Expression::kFunc) {
+    return;
+  }
+  const auto& func = static_cast<const plan::ScalarFunc&>(expr);
+  if (func.name() == "logicalAnd") {
+    for (const auto& arg : func.arg_deps()) {
+      CollectUPIDPodPredicates(*arg, preds);
+    }
+    return;
+  }
+  if (func.name() != "equal" || func.arg_deps().size() != 2) {
+    return;
+  }
+  const plan::ScalarExpression* lhs = func.arg_deps()[0];
+  const plan::ScalarExpression* rhs = func.arg_deps()[1];
+  if (lhs->ExpressionType() == plan::Expression::kConstant) {
+    std::swap(lhs, rhs);
+  }
+  if (lhs->ExpressionType() != plan::Expression::kFunc ||
+      rhs->ExpressionType() != plan::Expression::kConstant) {
+    return;
+  }
+  const auto& pod_func = static_cast<const plan::ScalarFunc&>(*lhs);
+  const auto& pod_name = static_cast<const plan::ScalarValue&>(*rhs);
+  if (pod_func.name() != "upid_to_pod_name" || pod_func.arg_deps().size() != 1 ||
+      pod_func.arg_deps()[0]->ExpressionType() != plan::Expression::kColumn ||
+      pod_name.DataType() != types::STRING || pod_name.IsNull()) {
+    return;
+  }
+  const auto& upid_col = static_cast<const plan::Column&>(*pod_func.arg_deps()[0]);
+  preds->push_back({upid_col.Index(), pod_name.StringValue()});
+}
+
+Status EvaluateColumnComparisons(const std::vector<ColumnComparison>& comparisons,
+                                 const RowBatch& rb, std::vector<uint8_t>* mask) {
+  DCHECK(!comparisons.empty());
+  int64_t num_rows = rb.num_rows();
+  mask->resize(num_rows);
+  bool conjunct = false;
+  for (const auto& comparison : comparisons) {
+    auto col = rb.ColumnAt(comparison.col_idx);
+    if (col->length() != num_rows) {
+      return error::Internal("Column $0 has $1 rows, expected $2", comparison.col_idx,
+                             col->length(), num_rows);
+    }
+    switch (comparison.data_type) {
+      case types::INT64:
+        CompareColumnToOperand<types::INT64>(col.get(), comparison.int_operand, comparison.op,
+                                             conjunct, mask->data());
+        break;
+      case types::TIME64NS:
+        CompareColumnToOperand<types::TIME64NS>(col.get(), comparison.int_operand, comparison.op,
+                                                conjunct, mask->data());
+        break;
+      case types::FLOAT64:
+        CompareColumnToOperand<types::FLOAT64>(col.get(), comparison.float_operand, comparison.op,
+                                               conjunct, mask->data());
+        break;
+      default:
+        return error::Internal("Unsupported comparison type: $0",
+                               types::ToString(comparison.data_type));
+    }
+    conjunct = true;
+  }
+  return Status::OK();
+}
+
+int64_t SelectionFromMask(const uint8_t* mask, int64_t num_rows, std::vector<int64_t>* selection) {
+  selection->resize(num_rows);
+  int64_t* out = selection->data();
+  int64_t num_selected = 0;
+  // Branch free, so the cost does not depend on the selectivity of the predicate.
+  for (int64_t i = 0; i < num_rows; ++i) {
+    out[num_selected] = i;
+    num_selected += mask[i] != 0;
+  }
+  selection->resize(num_selected);
+  return num_selected;
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> GatherArrowArray(types::DataType data_type,
+                                                         const arrow::Array* input,
+                                                         const std::vector<int64_t>& selection,
+                                                         arrow::MemoryPool* mem_pool) {
+  auto builder = types::MakeArrowBuilder(data_type, mem_pool);
+#define TYPE_CASE(_dt_) PL_RETURN_IF_ERROR(GatherValues<_dt_>(input, selection, builder.get()));
+  PL_SWITCH_FOREACH_DATATYPE(data_type, TYPE_CASE);
+#undef TYPE_CASE
+  std::shared_ptr<arrow::Array> output;
+  PL_RETURN_IF_ERROR(builder->Finish(&output));
+  return output;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
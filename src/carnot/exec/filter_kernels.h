@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/plan/scalar_expression.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/schema/row_batch.h"
+#include "src/table_store/table/zone_map.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+enum class CompareOp {
+  kEqual,
+  kNotEqual,
+  kLessThan,
+  kLessThanEqual,
+  kGreaterThan,
+  kGreaterThanEqual,
+};
+
+/**
+ * A comparison of a fixed width input column against a constant, ie. `col <op> operand`.
+ */
+struct ColumnComparison {
+  int64_t col_idx;
+  // One of INT64, TIME64NS or FLOAT64.
+  types::DataType data_type;
+  CompareOp op;
+  // int_operand is used for INT64 and TIME64NS, float_operand for FLOAT64.
+  int64_t int_operand = 0;
+  double float_operand = 0;
+};
+
+/**
+ * Tries to compile a filter predicate into a conjunction of column/constant comparisons that can
+ * be evaluated by EvaluateColumnComparisons without going through the UDF machinery. Only
+ * `logicalAnd` of the builtin comparison functions where the column and constant share the same
+ * INT64, TIME64NS or FLOAT64 type are supported.
+ *
+ * @return true if the whole predicate was compiled into comparisons.
+ */
+bool CompileColumnComparisons(const plan::ScalarExpression& expr,
+                              std::vector<ColumnComparison>* comparisons);
+
+/**
+ * Collects the conjuncts of a filter predicate that can be checked against table zone maps, ie.
+ * comparisons of a column against a constant. Conjuncts that can't be checked are left out, so a
+ * row satisfying the predicate always satisfies the collected predicates. The col_idx of the
+ * collected predicates indexes into the filter's input, not the table.
+ */
+void CollectZoneMapPredicates(const plan::ScalarExpression& expr,
+                              std::vector<table_store::ZoneMapPredicate>* preds);
+
+/**
+ * A check that a UPID column's process belongs to a pod, ie.
+ * `upid_to_pod_name(col) == pod_name`. Filters on ctx['pod'] compile to this.
+ */
+struct UPIDPodPredicate {
+  int64_t upid_col_idx;
+  // In the <namespace>/<name> form that upid_to_pod_name returns.
+  std::string pod_name;
+};
+
+/**
+ * Collects the conjuncts of a filter predicate that are UPIDPodPredicates. As with
+ * CollectZoneMapPredicates, other conjuncts are left out and col_idx indexes into the filter's
+ * input.
+ */
+void CollectUPIDPodPredicates(const plan::ScalarExpression& expr,
+                              std::vector<UPIDPodPredicate>* preds);
+
+/**
+ * Evaluates the comparisons over rb, writing one byte per row into mask (1 if the row passes every
+ * comparison, 0 otherwise). The comparison loops are written so the compiler can vectorize them,
+ * and every comparison after the first is ANDed into the mask.
+ */
+Status EvaluateColumnComparisons(const std::vector<ColumnComparison>& comparisons,
+                                 const table_store::schema::RowBatch& rb,
+                                 std::vector<uint8_t>* mask);
+
+/**
+ * Converts a byte mask into the list of selected row indices.
+ * @return The number of selected rows.
+ */
+int64_t SelectionFromMask(const uint8_t* mask, int64_t num_rows, std::vector<int64_t>* selection);
+
+/**
+ * Copies the selected rows of input into a new array of the given type.
+ */
+StatusOr<std::shared_ptr<arrow::Array>> GatherArrowArray(types::DataType data_type,
+                                                         const arrow::Array* input,
+                                                         const std::vector<int64_t>& selection,
+                                                         arrow::MemoryPool* mem_pool);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
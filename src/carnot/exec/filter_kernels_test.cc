@@ -0,0 +1,238 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/filter_kernels.h"
+
+#include <memory>
+#include <vector>
+
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+using ::testing::ElementsAre;
+
+std::unique_ptr<plan::ScalarExpression> ParseExpression(const char* pbtxt) {
+  planpb::ScalarExpression pb;
+  CHECK(google::protobuf::TextFormat::MergeFromString(pbtxt, &pb));
+  return plan::ScalarExpression::FromProto(pb).ConsumeValueOrDie();
+}
+
+TEST(FilterKernelsTest, compile_conjunction) {
+  auto expr = ParseExpression(planpb::testutils::kRangeScalarFuncConstPbtxt);
+  std::vector<ColumnComparison> comparisons;
+  ASSERT_TRUE(CompileColumnComparisons(*expr, &comparisons));
+  ASSERT_EQ(2, comparisons.size());
+
+  EXPECT_EQ(0, comparisons[0].col_idx);
+  EXPECT_EQ(types::INT64, comparisons[0].data_type);
+  EXPECT_EQ(CompareOp::kGreaterThan, comparisons[0].op);
+  EXPECT_EQ(1, comparisons[0].int_operand);
+
+  // `9 >= col1` is flipped into `col1 <= 9`.
+  EXPECT_EQ(1, comparisons[1].col_idx);
+  EXPECT_EQ(CompareOp::kLessThanEqual, comparisons[1].op);
+  EXPECT_EQ(9, comparisons[1].int_operand);
+}
+
+TEST(FilterKernelsTest, compile_unsupported) {
+  std::vector<ColumnComparison> comparisons;
+  auto eq = ParseExpression(planpb::testutils::kEq1ScalarFuncConstPbtxt);
+  EXPECT_FALSE(CompileColumnComparisons(*eq, &comparisons));
+  auto str_eq = ParseExpression(planpb::testutils::kStrEqAScalarFuncConstPbtxt);
+  EXPECT_FALSE(CompileColumnComparisons(*str_eq, &comparisons));
+}
+
+constexpr char kStrEqAndNotEqPbtxt[] = R"(
+func {
+  name: "logicalAnd"
+  args {
+    func {
+      name: "equal"
+      args {
+        column {
+          node: 0
+          index: 2
+        }
+      }
+      args {
+        constant {
+          data_type: STRING,
+          string_value: "/healthz"
+        }
+      }
+      args_data_types: STRING
+      args_data_types: STRING
+    }
+  }
+  args {
+    func {
+      name: "notEqual"
+      args {
+        column {
+          node: 0
+          index: 0
+        }
+      }
+      args {
+        constant {
+          data_type: INT64,
+          int64_value: 3
+        }
+      }
+      args_data_types: INT64
+      args_data_types: INT64
+    }
+  }
+  args_data_types: BOOLEAN
+  args_data_types: BOOLEAN
+})";
+
+TEST(FilterKernelsTest, collect_zone_map_predicates) {
+  std::vector<table_store::ZoneMapPredicate> preds;
+  CollectZoneMapPredicates(*ParseExpression(planpb::testutils::kRangeScalarFuncConstPbtxt),
+                           &preds);
+  ASSERT_EQ(2, preds.size());
+  EXPECT_EQ(0, preds[0].col_idx);
+  EXPECT_EQ(table_store::ZoneMapOp::kGreaterThan, preds[0].op);
+  EXPECT_EQ(1, preds[0].int_value);
+  EXPECT_EQ(1, preds[1].col_idx);
+  EXPECT_EQ(table_store::ZoneMapOp::kLessThanEqual, preds[1].op);
+  EXPECT_EQ(9, preds[1].int_value);
+
+  // notEqual can't be checked against a zone map, so only the string equality is collected.
+  preds.clear();
+  CollectZoneMapPredicates(*ParseExpression(kStrEqAndNotEqPbtxt), &preds);
+  ASSERT_EQ(1, preds.size());
+  EXPECT_EQ(2, preds[0].col_idx);
+  EXPECT_EQ(types::STRING, preds[0].data_type);
+  EXPECT_EQ(table_store::ZoneMapOp::kEqual, preds[0].op);
+  EXPECT_EQ("/healthz", preds[0].string_value);
+}
+
+constexpr char kPodEqAndIntEqPbtxt[] = R"(
+func {
+  name: "logicalAnd"
+  args {
+    func {
+      name: "equal"
+      args {
+        constant {
+          data_type: STRING,
+          string_value: "pl/vizier-pem-abcde"
+        }
+      }
+      args {
+        func {
+          name: "upid_to_pod_name"
+          args {
+            column {
+              node: 0
+              index: 1
+            }
+          }
+          args_data_types: UINT128
+        }
+      }
+      args_data_types: STRING
+      args_data_types: STRING
+    }
+  }
+  args {
+    func {
+      name: "equal"
+      args {
+        column {
+          node: 0
+          index: 2
+        }
+      }
+      args {
+        constant {
+          data_type: INT64,
+          int64_value: 3
+        }
+      }
+      args_data_types: INT64
+      args_data_types: INT64
+    }
+  }
+  args_data_types: BOOLEAN
+  args_data_types: BOOLEAN
+})";
+
+TEST(FilterKernelsTest, collect_upid_pod_predicates) {
+  std::vector<UPIDPodPredicate> preds;
+  CollectUPIDPodPredicates(*ParseExpression(kPodEqAndIntEqPbtxt), &preds);
+  ASSERT_EQ(1, preds.size());
+  EXPECT_EQ(1, preds[0].upid_col_idx);
+  EXPECT_EQ("pl/vizier-pem-abcde", preds[0].pod_name);
+
+  preds.clear();
+  CollectUPIDPodPredicates(*ParseExpression(kStrEqAndNotEqPbtxt), &preds);
+  EXPECT_TRUE(preds.empty());
+}
+
+TEST(FilterKernelsTest, evaluate_and_gather) {
+  RowDescriptor rd({types::DataType::INT64, types::DataType::FLOAT64, types::DataType::STRING});
+  auto rb_builder = RowBatchBuilder(rd, 5, /*eow*/ false, /*eos*/ false);
+  const auto& rb = rb_builder.AddColumn<types::Int64Value>({1, 2, 3, 4, 5})
+                       .AddColumn<types::Float64Value>({0.5, 1.5, 2.5, 3.5, 4.5})
+                       .AddColumn<types::StringValue>({"a", "bb", "ccc", "dddd", "eeeee"})
+                       .get();
+
+  std::vector<ColumnComparison> comparisons(2);
+  comparisons[0].col_idx = 0;
+  comparisons[0].data_type = types::INT64;
+  comparisons[0].op = CompareOp::kNotEqual;
+  comparisons[0].int_operand = 3;
+  comparisons[1].col_idx = 1;
+  comparisons[1].data_type = types::FLOAT64;
+  comparisons[1].op = CompareOp::kGreaterThan;
+  comparisons[1].float_operand = 1.0;
+
+  std::vector<uint8_t> mask;
+  ASSERT_OK(EvaluateColumnComparisons(comparisons, rb, &mask));
+  EXPECT_THAT(mask, ElementsAre(0, 1, 0, 1, 1));
+
+  std::vector<int64_t> selection;
+  EXPECT_EQ(3, SelectionFromMask(mask.data(), mask.size(), &selection));
+  EXPECT_THAT(selection, ElementsAre(1, 3, 4));
+
+  ASSERT_OK_AND_ASSIGN(auto out, GatherArrowArray(types::STRING, rb.ColumnAt(2).get(), selection,
+                                                  arrow::default_memory_pool()));
+  auto* str_out = static_cast<arrow::StringArray*>(out.get());
+  ASSERT_EQ(3, str_out->length());
+  EXPECT_EQ("bb", str_out->GetString(0));
+  EXPECT_EQ("dddd", str_out->GetString(1));
+  EXPECT_EQ("eeeee", str_out->GetString(2));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -22,6 +22,8 @@
 #include <arrow/array/builder_binary.h>
 #include <arrow/memory_pool.h>
 #include <arrow/status.h>
+#include <chrono>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <utility>
@@ -29,6 +31,7 @@
 
 #include <absl/strings/substitute.h>
 
+#include "src/carnot/exec/filter_kernels.h"
 #include "src/carnot/plan/scalar_expression.h"
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/carnot/udf/udf_wrapper.h"
@@ -39,6 +42,20 @@
 #include "src/shared/types/types.h"
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
 
+DEFINE_bool(carnot_filter_comparison_kernels, true,
+            "Evaluate filters that are simple comparisons of columns against constants with "
+            "vectorized kernels instead of the scalar UDFs.");
+DEFINE_int64(carnot_filter_coalesce_rows,
+             gflags::Int64FromEnv("PL_CARNOT_FILTER_COALESCE_ROWS", 1024),
+             "Merge the small row batches output by a filter until they hold this many rows, so "
+             "the operators downstream of selective filters see fewer batches. 0 disables "
+             "coalescing.");
+DEFINE_int64(carnot_filter_coalesce_bytes, 1024 * 1024,
+             "Merge the small row batches output by a filter until they hold this many bytes.");
+DEFINE_int64(carnot_filter_coalesce_max_delay_ms, 100,
+             "The longest that the output rows of a filter are held for coalescing, which bounds "
+             "the latency it adds to streaming queries.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -47,6 +64,9 @@ using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 
 std::string FilterNode::DebugStringImpl() {
+  if (evaluator_ == nullptr) {
+    return absl::Substitute("Exec::FilterNode<$0>", plan_node_->expression()->DebugString());
+  }
   return absl::Substitute("Exec::FilterNode<$0>", evaluator_->DebugString());
 }
 
@@ -55,118 +75,140 @@ Status FilterNode::InitImpl(const plan::Operator& plan_node) {
   const auto* filter_plan_node = static_cast<const plan::FilterOperator*>(&plan_node);
   // copy the plan node to local object;
   plan_node_ = std::make_unique<plan::FilterOperator>(*filter_plan_node);
+  if (FLAGS_carnot_filter_coalesce_rows > 0) {
+    CoalesceOutputRowBatches(FLAGS_carnot_filter_coalesce_rows, FLAGS_carnot_filter_coalesce_bytes,
+                             std::chrono::milliseconds(FLAGS_carnot_filter_coalesce_max_delay_ms));
+  }
   return Status::OK();
 }
 
 Status FilterNode::PrepareImpl(ExecState* exec_state) {
+  // Simple comparisons against constants are evaluated directly on the arrow buffers, and don't
+  // need the UDF based evaluators.
+  if (FLAGS_carnot_filter_comparison_kernels &&
+      CompileColumnComparisons(*plan_node_->expression(), &comparisons_)) {
+    return Status::OK();
+  }
+  comparisons_.clear();
+
   function_ctx_ = exec_state->CreateFunctionContext();
   evaluator_ = std::make_unique<VectorNativeScalarExpressionEvaluator>(
       plan::ConstScalarExpressionVector{plan_node_->expression()}, function_ctx_.get());
+
+  auto morsel_executor = exec_state->morsel_executor();
+  if (morsel_executor != nullptr) {
+    for (int i = 0; i < morsel_executor->num_workers(); ++i) {
+      worker_function_ctxs_.push_back(exec_state->CreateFunctionContext());
+      worker_evaluators_.push_back(std::make_unique<VectorNativeScalarExpressionEvaluator>(
+          plan::ConstScalarExpressionVector{plan_node_->expression()},
+          worker_function_ctxs_.back().get()));
+    }
+  }
   return Status::OK();
 }
 
 Status FilterNode::OpenImpl(ExecState* exec_state) {
+  if (evaluator_ == nullptr) {
+    return Status::OK();
+  }
   PL_RETURN_IF_ERROR(evaluator_->Open(exec_state));
+  for (auto& evaluator : worker_evaluators_) {
+    PL_RETURN_IF_ERROR(evaluator->Open(exec_state));
+  }
   return Status::OK();
 }
 
 Status FilterNode::CloseImpl(ExecState* exec_state) {
-  PL_RETURN_IF_ERROR(evaluator_->Close(exec_state));
-  return Status::OK();
-}
-
-template <types::DataType T>
-Status PredicateCopyValues(const types::BoolValueColumnWrapper& pred, const arrow::Array* input_col,
-                           RowBatch* output_rb) {
-  DCHECK_EQ(pred.Size(), static_cast<size_t>(input_col->length()));
-  size_t num_output_records = output_rb->num_rows();
-  size_t num_input_records = input_col->length();
-  auto output_col_builder_generic = MakeArrowBuilder(T, arrow::default_memory_pool());
-  auto* output_col_builder = static_cast<typename types::DataTypeTraits<T>::arrow_builder_type*>(
-      output_col_builder_generic.get());
-  PL_RETURN_IF_ERROR(output_col_builder->Reserve(num_output_records));
-  for (size_t idx = 0; idx < num_input_records; ++idx) {
-    if (udf::UnWrap(pred[idx])) {
-      output_col_builder->UnsafeAppend(types::GetValueFromArrowArray<T>(input_col, idx));
-    }
+  if (evaluator_ == nullptr) {
+    return Status::OK();
   }
-  std::shared_ptr<arrow::Array> output_array;
-  PL_RETURN_IF_ERROR(output_col_builder->Finish(&output_array));
-  PL_RETURN_IF_ERROR(output_rb->AddColumn(output_array));
-  return Status::OK();
-}
-
-template <>
-Status PredicateCopyValues<types::STRING>(const types::BoolValueColumnWrapper& pred,
-                                          const arrow::Array* input_col, RowBatch* output_rb) {
-  DCHECK_EQ(pred.Size(), static_cast<size_t>(input_col->length()));
-  size_t num_output_records = output_rb->num_rows();
-  size_t num_input_records = input_col->length();
-  size_t reserved =
-      100;  // This can be an arbritrary number, since we do exponential doubling below.
-  size_t total_size = 0;
-
-  auto output_col_builder_generic = MakeArrowBuilder(types::STRING, arrow::default_memory_pool());
-  auto* output_col_builder = static_cast<types::DataTypeTraits<types::STRING>::arrow_builder_type*>(
-      output_col_builder_generic.get());
-
-  PL_RETURN_IF_ERROR(output_col_builder->Reserve(num_output_records));
-  PL_RETURN_IF_ERROR(output_col_builder->ReserveData(reserved));
-  for (size_t idx = 0; idx < num_input_records; ++idx) {
-    if (udf::UnWrap(pred[idx])) {
-      auto res = types::GetValueFromArrowArray<types::STRING>(input_col, idx);
-      total_size += res.size();
-      while (total_size >= reserved) {
-        reserved *= 2;
-      }
-      PL_RETURN_IF_ERROR(output_col_builder->ReserveData(reserved));
-      output_col_builder->UnsafeAppend(std::move(res));
-    }
+  PL_RETURN_IF_ERROR(evaluator_->Close(exec_state));
+  for (auto& evaluator : worker_evaluators_) {
+    PL_RETURN_IF_ERROR(evaluator->Close(exec_state));
   }
-  std::shared_ptr<arrow::Array> output_array;
-  PL_RETURN_IF_ERROR(output_col_builder->Finish(&output_array));
-  PL_RETURN_IF_ERROR(output_rb->AddColumn(output_array));
   return Status::OK();
 }
 
-Status FilterNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
+StatusOr<std::unique_ptr<RowBatch>> FilterNode::FilterRowBatch(
+    ExecState* exec_state, VectorNativeScalarExpressionEvaluator* evaluator, const RowBatch& rb) {
   // Current implementation does not merge across row batches, we should
   // consider this for cases where the filter has really low selectivity.
-  PL_ASSIGN_OR_RETURN(auto pred_col, evaluator_->EvaluateSingleExpression(
-                                         exec_state, rb, *plan_node_->expression()));
-
-  // Verify that the type of the column is boolean.
-  DCHECK_EQ(pred_col->data_type(), types::BOOLEAN) << "Predicate expression must be a boolean";
-
-  const types::BoolValueColumnWrapper& pred_col_wrapper =
-      *static_cast<types::BoolValueColumnWrapper*>(pred_col.get());
-  size_t num_pred = pred_col_wrapper.Size();
-
-  DCHECK_EQ(static_cast<size_t>(rb.num_rows()), num_pred);
-
-  // Find out how many of them returned true;
-  size_t num_output_records = 0;
-  for (size_t i = 0; i < num_pred; ++i) {
-    if (pred_col_wrapper[i].val) {
-      ++num_output_records;
+  std::vector<uint8_t> mask;
+  if (!comparisons_.empty()) {
+    PL_RETURN_IF_ERROR(EvaluateColumnComparisons(comparisons_, rb, &mask));
+  } else {
+    PL_ASSIGN_OR_RETURN(auto pred_col, evaluator->EvaluateSingleExpression(
+                                           exec_state, rb, *plan_node_->expression()));
+
+    // Verify that the type of the column is boolean.
+    DCHECK_EQ(pred_col->data_type(), types::BOOLEAN) << "Predicate expression must be a boolean";
+
+    const types::BoolValueColumnWrapper& pred_col_wrapper =
+        *static_cast<types::BoolValueColumnWrapper*>(pred_col.get());
+    size_t num_pred = pred_col_wrapper.Size();
+    DCHECK_EQ(static_cast<size_t>(rb.num_rows()), num_pred);
+
+    mask.resize(num_pred);
+    for (size_t i = 0; i < num_pred; ++i) {
+      mask[i] = pred_col_wrapper[i].val;
     }
   }
 
-  RowBatch output_rb(*output_descriptor_, num_output_records);
+  std::vector<int64_t> selection;
+  int64_t num_output_records = SelectionFromMask(mask.data(), rb.num_rows(), &selection);
+
+  auto output_rb = std::make_unique<RowBatch>(*output_descriptor_, num_output_records);
   DCHECK_EQ(output_descriptor_->size(), plan_node_->selected_cols().size());
 
   for (const auto& [output_col_idx, input_col_idx] : Enumerate(plan_node_->selected_cols())) {
+    // Every row passed, so the input column can be forwarded without a copy.
+    if (num_output_records == rb.num_rows()) {
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(rb.ColumnAt(input_col_idx)));
+      continue;
+    }
+    // Only convert the selected rows of columns that have not been materialized yet.
+    if (rb.IsDeferredColumn(input_col_idx)) {
+      PL_ASSIGN_OR_RETURN(auto output_col, rb.DeferredColumnRowsAt(input_col_idx, selection));
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(output_col));
+      continue;
+    }
     auto input_col = rb.ColumnAt(input_col_idx);
-    auto col_type = output_descriptor_->type(output_col_idx);
-#define TYPE_CASE(_dt_) \
-  PL_RETURN_IF_ERROR(PredicateCopyValues<_dt_>(pred_col_wrapper, input_col.get(), &output_rb));
-    PL_SWITCH_FOREACH_DATATYPE(col_type, TYPE_CASE);
-#undef TYPE_CASE
+    PL_ASSIGN_OR_RETURN(auto output_col,
+                        GatherArrowArray(output_descriptor_->type(output_col_idx), input_col.get(),
+                                         selection, exec_state->exec_mem_pool()));
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(output_col));
+  }
+  return output_rb;
+}
+
+StatusOr<std::unique_ptr<RowBatch>> FilterNode::FilterRowBatchParallel(ExecState* exec_state,
+                                                                       const RowBatch& rb) {
+  auto morsel_executor = exec_state->morsel_executor();
+  PL_ASSIGN_OR_RETURN(auto morsels, SplitIntoMorsels(rb, morsel_executor->morsel_size_rows()));
+  std::vector<std::unique_ptr<RowBatch>> outputs(morsels.size());
+  PL_RETURN_IF_ERROR(morsel_executor->ParallelFor(
+      morsels.size(), [&](int64_t morsel_idx, int worker_idx) -> Status {
+        auto* evaluator =
+            worker_evaluators_.empty() ? nullptr : worker_evaluators_[worker_idx].get();
+        PL_ASSIGN_OR_RETURN(outputs[morsel_idx],
+                            FilterRowBatch(exec_state, evaluator, *morsels[morsel_idx]));
+        return Status::OK();
+      }));
+  return ConcatenateMorsels(*output_descriptor_, outputs, exec_state->exec_mem_pool());
+}
+
+Status FilterNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
+  std::unique_ptr<RowBatch> output_rb;
+  auto morsel_executor = exec_state->morsel_executor();
+  if (morsel_executor != nullptr && rb.num_rows() > morsel_executor->morsel_size_rows()) {
+    PL_ASSIGN_OR_RETURN(output_rb, FilterRowBatchParallel(exec_state, rb));
+  } else {
+    PL_ASSIGN_OR_RETURN(output_rb, FilterRowBatch(exec_state, evaluator_.get(), rb));
   }
 
-  output_rb.set_eow(rb.eow());
-  output_rb.set_eos(rb.eos());
-  PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
+  output_rb->set_eow(rb.eow());
+  output_rb->set_eos(rb.eos());
+  PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *output_rb));
   return Status::OK();
 }
 
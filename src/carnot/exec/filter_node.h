@@ -26,12 +26,17 @@
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/filter_kernels.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/udf/base.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
 #include "src/table_store/table_store.h"
 
+DECLARE_bool(carnot_filter_comparison_kernels);
+DECLARE_int64(carnot_filter_coalesce_rows);
+DECLARE_int64(carnot_filter_coalesce_max_delay_ms);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -51,9 +56,23 @@ class FilterNode : public ProcessingNode {
                          size_t parent_index) override;
 
  private:
+  // Applies the predicate to rb and returns the selected rows. Does not set eow/eos.
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> FilterRowBatch(
+      ExecState* exec_state, VectorNativeScalarExpressionEvaluator* evaluator,
+      const table_store::schema::RowBatch& rb);
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> FilterRowBatchParallel(
+      ExecState* exec_state, const table_store::schema::RowBatch& rb);
+
+  // Set when the predicate compiles into comparisons against constants, in which case no
+  // evaluators are created.
+  std::vector<ColumnComparison> comparisons_;
   std::unique_ptr<VectorNativeScalarExpressionEvaluator> evaluator_;
   std::unique_ptr<plan::FilterOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
+
+  // Per-worker evaluators used when the query runs with a MorselExecutor.
+  std::vector<std::unique_ptr<VectorNativeScalarExpressionEvaluator>> worker_evaluators_;
+  std::vector<std::unique_ptr<udf::FunctionContext>> worker_function_ctxs_;
 };
 
 }  // namespace exec
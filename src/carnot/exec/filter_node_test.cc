@@ -66,12 +66,16 @@ class FilterNodeTest : public ::testing::Test {
         0, "eq", std::vector<types::DataType>({types::DataType::INT64, types::DataType::INT64})));
     EXPECT_OK(exec_state_->AddScalarUDF(
         1, "eq", std::vector<types::DataType>({types::DataType::STRING, types::DataType::STRING})));
+    // Most tests check the output of each input batch, so the outputs are not coalesced.
+    FLAGS_carnot_filter_coalesce_rows = 0;
   }
+  ~FilterNodeTest() { FLAGS_carnot_filter_coalesce_rows = coalesce_rows_; }
 
  protected:
   std::unique_ptr<plan::Operator> plan_node_;
   std::unique_ptr<ExecState> exec_state_;
   std::unique_ptr<udf::Registry> func_registry_;
+  int64_t coalesce_rows_ = FLAGS_carnot_filter_coalesce_rows;
 };
 
 TEST_F(FilterNodeTest, basic) {
@@ -222,6 +226,94 @@ TEST_F(FilterNodeTest, string_pred) {
       .Close();
 }
 
+TEST_F(FilterNodeTest, comparison_kernels) {
+  // The predicate only uses builtin comparisons against constants, so it is evaluated without
+  // looking up any of the UDFs.
+  auto op_proto = planpb::testutils::CreateTestFilterTwoColsRange();
+  plan_node_ = plan::FilterOperator::FromProto(op_proto, /*id*/ 1);
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+  RowDescriptor output_rd(
+      {types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+
+  auto tester = exec::ExecNodeTester<FilterNode, plan::FilterOperator>(
+      *plan_node_, output_rd, {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 5, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5})
+                       .AddColumn<types::Int64Value>({1, 3, 9, 10, 2})
+                       .AddColumn<types::StringValue>({"ABC", "DEF", "HELLO", "WORLD", "!"})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, false, false)
+                          .AddColumn<types::Int64Value>({2, 3, 5})
+                          .AddColumn<types::Int64Value>({3, 9, 2})
+                          .AddColumn<types::StringValue>({"DEF", "HELLO", "!"})
+                          .get())
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, true)
+                       .AddColumn<types::Int64Value>({7, 8})
+                       .AddColumn<types::Int64Value>({1, 4})
+                       .AddColumn<types::StringValue>({"Hello", "world"})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({7, 8})
+                          .AddColumn<types::Int64Value>({1, 4})
+                          .AddColumn<types::StringValue>({"Hello", "world"})
+                          .get())
+      .Close();
+}
+
+TEST_F(FilterNodeTest, coalesce_outputs) {
+  FLAGS_carnot_filter_coalesce_rows = 3;
+  int64_t max_delay_ms = FLAGS_carnot_filter_coalesce_max_delay_ms;
+  FLAGS_carnot_filter_coalesce_max_delay_ms = 60 * 60 * 1000;
+
+  auto op_proto = planpb::testutils::CreateTestFilterTwoCols();
+  plan_node_ = plan::FilterOperator::FromProto(op_proto, /*id*/ 1);
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+  RowDescriptor output_rd(
+      {types::DataType::INT64, types::DataType::INT64, types::DataType::STRING});
+
+  auto tester = exec::ExecNodeTester<FilterNode, plan::FilterOperator>(
+      *plan_node_, output_rd, {input_rd}, exec_state_.get());
+  // The rows kept from the first two batches are held until they reach 3 rows.
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 1})
+                       .AddColumn<types::Int64Value>({1, 3, 6})
+                       .AddColumn<types::StringValue>({"ABC", "DEF", "GHI"})
+                       .get(),
+                   0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, false, false)
+                       .AddColumn<types::Int64Value>({1, 3})
+                       .AddColumn<types::Int64Value>({4, 9})
+                       .AddColumn<types::StringValue>({"JKL", "MNO"})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, false, false)
+                          .AddColumn<types::Int64Value>({1, 1, 1})
+                          .AddColumn<types::Int64Value>({1, 6, 4})
+                          .AddColumn<types::StringValue>({"ABC", "GHI", "JKL"})
+                          .get())
+      // The end of the stream sends the held rows.
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, true, true)
+                       .AddColumn<types::Int64Value>({1, 6})
+                       .AddColumn<types::Int64Value>({5, 7})
+                       .AddColumn<types::StringValue>({"PQR", "STU"})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 1, true, true)
+                          .AddColumn<types::Int64Value>({1})
+                          .AddColumn<types::Int64Value>({5})
+                          .AddColumn<types::StringValue>({"PQR"})
+                          .get())
+      .Close();
+
+  FLAGS_carnot_filter_coalesce_max_delay_ms = max_delay_ms;
+}
+
 TEST_F(FilterNodeTest, child_fail) {
   auto op_proto = planpb::testutils::CreateTestFilterTwoCols();
   plan_node_ = plan::FilterOperator::FromProto(op_proto, /*id*/ 1);
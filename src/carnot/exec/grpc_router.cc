@@ -41,8 +41,9 @@ GRPCRouter::SourceNodeTracker* GRPCRouter::GetSourceNodeTracker(QueryTracker* qu
   return &query_tracker->source_node_trackers[source_id];
 }
 
-Status GRPCRouter::EnqueueRowBatch(QueryTracker* query_tracker,
-                                   std::unique_ptr<carnotpb::TransferResultChunkRequest> req) {
+Status GRPCRouter::EnqueueRowBatch(QueryTracker* query_tracker, ::grpc::ServerContext* context,
+                                   std::unique_ptr<carnotpb::TransferResultChunkRequest> req,
+                                   bool* source_stopped) {
   if (!req->has_query_result() || !req->query_result().has_row_batch() ||
       req->query_result().destination_case() !=
           carnotpb::TransferResultChunkRequest_SinkResult::DestinationCase::kGrpcSourceId) {
@@ -51,22 +52,64 @@ Status GRPCRouter::EnqueueRowBatch(QueryTracker* query_tracker,
         "with a GPRC source ID.");
   }
 
-  auto snt = GetSourceNodeTracker(query_tracker, req->query_result().grpc_source_id());
-  {
-    absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
-    // It's possible that we see row batches before we have gotten information about the query. To
-    // solve this race, We store a backlog of all the pending batches.
-    if (snt->source_node == nullptr) {
-      snt->response_backlog.emplace_back(std::move(req));
-      return Status::OK();
+  int64_t source_id = req->query_result().grpc_source_id();
+  auto start_time = std::chrono::steady_clock::now();
+  auto deadline = start_time + kMaxEnqueueWait;
+  bool blocked = false;
+  while (true) {
+    auto snt = GetSourceNodeTracker(query_tracker, source_id);
+    // Read before checking for capacity, so that a drain in between isn't missed.
+    int64_t seen_drains = snt->NumDrains();
+    {
+      absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
+      if (snt->source_stopped) {
+        *source_stopped = true;
+        return Status::OK();
+      }
+      // It's possible that we see row batches before we have gotten information about the query.
+      // To solve this race, We store a backlog of all the pending batches.
+      if (snt->source_node == nullptr) {
+        if (FLAGS_carnot_grpc_source_max_queued_bytes <= 0 ||
+            snt->response_backlog_bytes < FLAGS_carnot_grpc_source_max_queued_bytes) {
+          snt->response_backlog_bytes += req->ByteSizeLong();
+          snt->response_backlog.emplace_back(std::move(req));
+          return Status::OK();
+        }
+      } else if (snt->source_node->HasCapacity()) {
+        if (blocked) {
+          snt->source_node->RecordEnqueueBlockedTime(std::chrono::steady_clock::now() - start_time);
+        }
+        PL_RETURN_IF_ERROR(snt->source_node->EnqueueRowBatch(std::move(req)));
+        break;
+      }
     }
-    PL_RETURN_IF_ERROR(snt->source_node->EnqueueRowBatch(std::move(req)));
+    // The queue is full. Not reading from the stream until it drains makes gRPC flow control
+    // stop the sink from sending more.
+    if (context != nullptr && context->IsCancelled()) {
+      return error::Cancelled("Result stream cancelled while waiting to enqueue for source $0",
+                              source_id);
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      // Either the source stopped consuming, or it was never registered.
+      return error::ResourceUnavailable(
+          "Timed out after $0 ms waiting for room in the queue of source $1",
+          std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time).count(),
+          source_id);
+    }
+    blocked = true;
+    snt->WaitForDrain(seen_drains, std::min(deadline, now + kEnqueueCancelCheckInterval));
   }
   query_tracker->RestartExecution();
   return Status::OK();
 }
 
-Status GRPCRouter::MarkResultStreamInitiated(QueryTracker* query_tracker, int64_t source_id) {
+Status GRPCRouter::MarkResultStreamInitiated(QueryTracker* query_tracker, int64_t source_id,
+                                             ::grpc::ServerContext* context) {
+  {
+    absl::base_internal::SpinLockHolder lock(&query_tracker->query_lock);
+    query_tracker->source_stream_contexts[source_id] = context;
+  }
   auto snt = GetSourceNodeTracker(query_tracker, source_id);
   absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
   // It's possible that we see row batches before we have gotten information about the query. To
@@ -111,13 +154,20 @@ void GRPCRouter::MarkResultStreamContextAsComplete(QueryTracker* query_tracker,
                                                    ::grpc::ServerContext* context) {
   absl::base_internal::SpinLockHolder lock(&query_tracker->query_lock);
   query_tracker->active_agent_contexts.erase(context);
+  for (auto it = query_tracker->source_stream_contexts.begin();
+       it != query_tracker->source_stream_contexts.end();) {
+    if (it->second == context) {
+      query_tracker->source_stream_contexts.erase(it++);
+    } else {
+      ++it;
+    }
+  }
 }
 
 ::grpc::Status GRPCRouter::TransferResultChunk(
     ::grpc::ServerContext* context,
     ::grpc::ServerReader<::px::carnotpb::TransferResultChunkRequest>* reader,
     ::px::carnotpb::TransferResultChunkResponse* response) {
-  PL_UNUSED(context);
   auto rb = std::make_unique<carnotpb::TransferResultChunkRequest>();
 
   // If this is a query result stream, these are used to track whether or not this particular
@@ -170,11 +220,19 @@ void GRPCRouter::MarkResultStreamContextAsComplete(QueryTracker* query_tracker,
         break;
       }
     } else if (rb->has_query_result() && rb->query_result().has_row_batch()) {
-      auto s = EnqueueRowBatch(query_tracker.get(), std::move(rb));
+      bool source_stopped = false;
+      auto s = EnqueueRowBatch(query_tracker.get(), context, std::move(rb), &source_stopped);
       if (!s.ok()) {
         result_status = ::grpc::Status(grpc::StatusCode::INTERNAL, "failed to enqueue batch");
         break;
       }
+      if (source_stopped) {
+        // Returning ends the stream, and the response tells the sink that it can stop sending.
+        MarkResultStreamContextAsComplete(query_tracker.get(), context);
+        response->set_success(true);
+        response->set_source_stopped(true);
+        return ::grpc::Status::OK;
+      }
     } else if (rb->has_query_result() && rb->query_result().initiate_result_stream()) {
       if (rb->query_result().destination_case() !=
           carnotpb::TransferResultChunkRequest_SinkResult::DestinationCase::kGrpcSourceId) {
@@ -185,7 +243,7 @@ void GRPCRouter::MarkResultStreamContextAsComplete(QueryTracker* query_tracker,
 
       stream_has_query_results = true;
       source_node_id = rb->query_result().grpc_source_id();
-      auto s = MarkResultStreamInitiated(query_tracker.get(), source_node_id);
+      auto s = MarkResultStreamInitiated(query_tracker.get(), source_node_id, context);
       if (!s.ok()) {
         result_status = ::grpc::Status(grpc::StatusCode::INTERNAL, s.msg());
         break;
@@ -240,7 +298,7 @@ Status GRPCRouter::RecordStats(const sole::uuid& query_id,
   for (const auto& agent : stats) {
     auto agent_id = px::ParseUUID(agent.agent_id()).ConsumeValueOrDie();
     // There are some cases where we get duplicate exec stats.
-    if (tracker->seen_agents.contains(agent_id)) {
+    if (!tracker->seen_agents.insert(agent_id).second) {
       continue;
     }
     tracker->agent_exec_stats.push_back(agent);
@@ -248,6 +306,23 @@ Status GRPCRouter::RecordStats(const sole::uuid& query_id,
   return Status::OK();
 }
 
+GRPCRouter::QueryProgress GRPCRouter::GetQueryProgress(const sole::uuid& query_id) const {
+  std::shared_ptr<QueryTracker> query_tracker;
+  {
+    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+    auto it = query_node_map_.find(query_id);
+    if (it == query_node_map_.end()) {
+      return QueryProgress();
+    }
+    query_tracker = it->second;
+  }
+  absl::base_internal::SpinLockHolder lock(&query_tracker->query_lock);
+  QueryProgress progress;
+  progress.num_agents_done = query_tracker->seen_agents.size();
+  progress.num_active_streams = query_tracker->active_agent_contexts.size();
+  return progress;
+}
+
 Status GRPCRouter::AddGRPCSourceNode(sole::uuid query_id, int64_t source_id,
                                      GRPCSourceNode* source_node,
                                      std::function<void()> restart_execution) {
@@ -267,6 +342,9 @@ Status GRPCRouter::AddGRPCSourceNode(sole::uuid query_id, int64_t source_id,
   }
   auto snt = GetSourceNodeTracker(query_tracker.get(), source_id);
 
+  // The tracker is kept alive for as long as the node may call it.
+  source_node->set_on_pop([query_tracker, snt] { snt->NotifyDrained(); });
+
   absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
   snt->source_node = source_node;
   if (snt->connection_initiated_by_sink) {
@@ -277,6 +355,8 @@ Status GRPCRouter::AddGRPCSourceNode(sole::uuid query_id, int64_t source_id,
       PL_RETURN_IF_ERROR(snt->source_node->EnqueueRowBatch(std::move(rb)));
     }
     snt->response_backlog.clear();
+    snt->response_backlog_bytes = 0;
+    snt->NotifyDrained();
   }
   if (snt->connection_closed_by_sink) {
     source_node->set_upstream_closed_connection();
@@ -330,6 +410,49 @@ Status GRPCRouter::DeleteGRPCSourceNode(sole::uuid query_id, int64_t source_id)
   return Status::OK();
 }
 
+void GRPCRouter::CancelSourceStream(const sole::uuid& query_id, int64_t source_id) {
+  std::shared_ptr<QueryTracker> query_tracker;
+  {
+    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+    auto it = query_node_map_.find(query_id);
+    if (it == query_node_map_.end()) {
+      return;
+    }
+    query_tracker = it->second;
+  }
+  absl::base_internal::SpinLockHolder lock(&query_tracker->query_lock);
+  auto it = query_tracker->source_stream_contexts.find(source_id);
+  if (it == query_tracker->source_stream_contexts.end()) {
+    return;
+  }
+  VLOG(1) << absl::Substitute("Cancelling result stream for source $0 of query $1", source_id,
+                              query_id.str());
+  // The context stays valid until the stream is marked as complete, which also drops it from
+  // source_stream_contexts under the query lock.
+  it->second->TryCancel();
+}
+
+void GRPCRouter::StopSourceStream(const sole::uuid& query_id, int64_t source_id) {
+  std::shared_ptr<QueryTracker> query_tracker;
+  {
+    absl::base_internal::SpinLockHolder lock(&query_node_map_lock_);
+    auto it = query_node_map_.find(query_id);
+    if (it == query_node_map_.end()) {
+      return;
+    }
+    query_tracker = it->second;
+  }
+  VLOG(1) << absl::Substitute("Stopping result stream for source $0 of query $1", source_id,
+                              query_id.str());
+  auto snt = GetSourceNodeTracker(query_tracker.get(), source_id);
+  {
+    absl::base_internal::SpinLockHolder snt_lock(&snt->node_lock);
+    snt->source_stopped = true;
+  }
+  // Wakes up the streams waiting for room, so that they see the source is stopped.
+  snt->NotifyDrained();
+}
+
 void GRPCRouter::DeleteQuery(sole::uuid query_id) {
   VLOG(1) << "Deleting query ID from GRPC Router: " << query_id.str();
   std::shared_ptr<QueryTracker> query_tracker;
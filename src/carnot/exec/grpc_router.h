@@ -20,7 +20,9 @@
 
 #include <stdint.h>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -45,6 +47,11 @@ namespace exec {
 // Forward declaration needed to break circular dependency.
 class GRPCSourceNode;
 
+// How long a result stream waits for room in a full source queue before it fails.
+constexpr std::chrono::milliseconds kMaxEnqueueWait{5000};
+// How often a waiting result stream checks whether it was cancelled.
+constexpr std::chrono::milliseconds kEnqueueCancelCheckInterval{10};
+
 /**
  * GRPCRouter tracks incoming Kelvin connections and routes them to the appropriate Carnot source
  * node.
@@ -79,6 +86,24 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
    */
   Status DeleteGRPCSourceNode(sole::uuid query_id, int64_t source_id);
 
+  /**
+   * Cancels the result stream feeding the given source, so that the agent sending it stops
+   * producing results that will no longer be read. Does nothing if the stream isn't open.
+   * @param query_id
+   * @param source_id
+   */
+  void CancelSourceStream(const sole::uuid& query_id, int64_t source_id);
+
+  /**
+   * Ends the result stream feeding the given source without an error, because the source needs no
+   * more results (ie. a downstream limit was reached). The agent sending the stream is told so
+   * in the response, and stops the sources that only feed it. Batches that arrive for the source
+   * afterwards are dropped.
+   * @param query_id
+   * @param source_id
+   */
+  void StopSourceStream(const sole::uuid& query_id, int64_t source_id);
+
   /**
    * @brief Get the Exec stats from the agents that are clients to this GRPC and the query_id.
    *
@@ -98,6 +123,17 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
   Status RecordStats(const sole::uuid& query_id,
                      const std::vector<queryresultspb::AgentExecutionStats>& stats);
 
+  /**
+   * @brief How far along the agents sending results for a query are.
+   */
+  struct QueryProgress {
+    // The number of agents that have sent their execution stats, ie. finished the query.
+    int64_t num_agents_done = 0;
+    // The number of result streams that are still open.
+    int64_t num_active_streams = 0;
+  };
+  QueryProgress GetQueryProgress(const sole::uuid& query_id) const;
+
   /**
    * @brief Number of queries currently being tracked.
    * @return size_t number of queries being tracked.
@@ -114,9 +150,36 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     GRPCSourceNode* source_node GUARDED_BY(node_lock) = nullptr;
     bool connection_initiated_by_sink GUARDED_BY(node_lock) = false;
     bool connection_closed_by_sink GUARDED_BY(node_lock) = false;
+    // Whether the source needs no more results, see StopSourceStream.
+    bool source_stopped GUARDED_BY(node_lock) = false;
     std::vector<std::unique_ptr<::px::carnotpb::TransferResultChunkRequest>> response_backlog
         GUARDED_BY(node_lock);
+    int64_t response_backlog_bytes GUARDED_BY(node_lock) = 0;
     absl::base_internal::SpinLock node_lock;
+
+    // Bumped every time the queue of the source node, or the backlog, shrinks. Result streams
+    // blocked on a full queue wait for it to change. Guarded by drain_mutex.
+    int64_t num_drains = 0;
+    std::mutex drain_mutex;
+    std::condition_variable drain_cv;
+
+    int64_t NumDrains() {
+      std::lock_guard<std::mutex> lock(drain_mutex);
+      return num_drains;
+    }
+    void NotifyDrained() {
+      {
+        std::lock_guard<std::mutex> lock(drain_mutex);
+        ++num_drains;
+      }
+      drain_cv.notify_all();
+    }
+    // Waits until NotifyDrained is called after NumDrains returned seen_drains, or until the
+    // deadline.
+    void WaitForDrain(int64_t seen_drains, std::chrono::steady_clock::time_point deadline) {
+      std::unique_lock<std::mutex> lock(drain_mutex);
+      drain_cv.wait_until(lock, deadline, [&] { return num_drains != seen_drains; });
+    }
   };
 
   /**
@@ -127,9 +190,12 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     absl::node_hash_map<int64_t, SourceNodeTracker> source_node_trackers GUARDED_BY(query_lock);
     const std::chrono::steady_clock::time_point create_time GUARDED_BY(query_lock);
     std::function<void()> restart_execution_func_ GUARDED_BY(query_lock);
-    // The set of agents we've seen for the query.
+    // The set of agents we've seen the execution stats of for the query.
     absl::flat_hash_set<sole::uuid> seen_agents GUARDED_BY(query_lock);
     absl::flat_hash_set<::grpc::ServerContext*> active_agent_contexts GUARDED_BY(query_lock);
+    // The context of the open result stream for each source.
+    absl::flat_hash_map<int64_t, ::grpc::ServerContext*> source_stream_contexts
+        GUARDED_BY(query_lock);
     // The execution stats for agents that are clients to this service.
     std::vector<queryresultspb::AgentExecutionStats> agent_exec_stats GUARDED_BY(query_lock);
     absl::base_internal::SpinLock query_lock;
@@ -151,10 +217,15 @@ class GRPCRouter final : public carnotpb::ResultSinkService::Service {
     }
   };
 
-  Status EnqueueRowBatch(QueryTracker* query_tracker,
-                         std::unique_ptr<carnotpb::TransferResultChunkRequest> req);
+  // Blocks while the destination source (or its backlog) is full, so that the result stream isn't
+  // read from until there's room for more of its batches. Sets source_stopped, and drops the
+  // batch, if the destination source needs no more results.
+  Status EnqueueRowBatch(QueryTracker* query_tracker, ::grpc::ServerContext* context,
+                         std::unique_ptr<carnotpb::TransferResultChunkRequest> req,
+                         bool* source_stopped);
 
-  Status MarkResultStreamInitiated(QueryTracker* query_tracker, int64_t source_id);
+  Status MarkResultStreamInitiated(QueryTracker* query_tracker, int64_t source_id,
+                                   ::grpc::ServerContext* context);
   Status MarkResultStreamClosed(QueryTracker* query_tracker, int64_t source_id);
   void RegisterResultStreamContext(QueryTracker* query_tracker, ::grpc::ServerContext* context);
   void MarkResultStreamContextAsComplete(QueryTracker* query_tracker,
@@ -26,6 +26,7 @@
 
 #include <absl/strings/substitute.h>
 #include <absl/synchronization/barrier.h>
+#include <absl/synchronization/notification.h>
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/security/credentials.h>
 #include <grpcpp/security/server_credentials.h>
@@ -318,6 +319,11 @@ TEST_F(GRPCRouterTest, router_and_stats_test) {
   auto exec_stats = exec_stats_or_s.ConsumeValueOrDie();
   EXPECT_EQ(exec_stats.size(), 1);
   LOG(INFO) << exec_stats[0].DebugString();
+
+  // Every stream has finished and the agent has sent its stats.
+  auto progress = service_->GetQueryProgress(query_uuid);
+  EXPECT_EQ(progress.num_agents_done, 1);
+  EXPECT_EQ(progress.num_active_streams, 0);
 }
 
 TEST_F(GRPCRouterTest, delete_node_router_test) {
@@ -522,6 +528,116 @@ TEST_F(GRPCRouterTest, delete_query_router_test) {
   EXPECT_EQ(0, service_->NumQueriesTracking());
 }
 
+TEST_F(GRPCRouterTest, cancel_source_stream_test) {
+  int64_t grpc_source_node_id = 1;
+  uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
+
+  RowDescriptor input_rd({types::DataType::INT64});
+  auto query_uuid = sole::rebuild(ab, cd);
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<px::carnot::plan::Operator> plan_node =
+      plan::GRPCSourceOperator::FromProto(op_proto, grpc_source_node_id);
+  auto source_node = FakeGRPCSourceNode();
+  ASSERT_OK(source_node.Init(*plan_node, input_rd, {}));
+  absl::Notification batch_enqueued;
+  ASSERT_OK(service_->AddGRPCSourceNode(query_uuid, grpc_source_node_id, &source_node, [&] {
+    if (!batch_enqueued.HasBeenNotified()) {
+      batch_enqueued.Notify();
+    }
+  }));
+
+  // Cancelling a stream that was never opened is a no-op.
+  service_->CancelSourceStream(query_uuid, grpc_source_node_id);
+
+  carnotpb::TransferResultChunkRequest initiate_stream_req;
+  auto query_id = initiate_stream_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+  initiate_stream_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  initiate_stream_req.mutable_query_result()->set_initiate_result_stream(true);
+
+  auto rb = RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                .AddColumn<types::Int64Value>({1, 2})
+                .get();
+  carnotpb::TransferResultChunkRequest rb_req;
+  EXPECT_OK(rb.ToProto(rb_req.mutable_query_result()->mutable_row_batch()));
+  rb_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  query_id = rb_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+
+  px::carnotpb::TransferResultChunkResponse response;
+  grpc::ClientContext context;
+  auto writer = stub_->TransferResultChunk(&context, &response);
+  EXPECT_TRUE(writer->Write(initiate_stream_req));
+  EXPECT_TRUE(writer->Write(rb_req));
+  // The stream has been initiated by the time its first batch is enqueued.
+  batch_enqueued.WaitForNotification();
+
+  service_->CancelSourceStream(query_uuid, grpc_source_node_id);
+  writer->WritesDone();
+  auto status = writer->Finish();
+  EXPECT_FALSE(status.ok());
+  // Only the stream is cancelled, the query is still tracked.
+  EXPECT_EQ(1, service_->NumQueriesTracking());
+}
+
+TEST_F(GRPCRouterTest, stop_source_stream_test) {
+  int64_t grpc_source_node_id = 1;
+  uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
+
+  RowDescriptor input_rd({types::DataType::INT64});
+  auto query_uuid = sole::rebuild(ab, cd);
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<px::carnot::plan::Operator> plan_node =
+      plan::GRPCSourceOperator::FromProto(op_proto, grpc_source_node_id);
+  auto source_node = FakeGRPCSourceNode();
+  ASSERT_OK(source_node.Init(*plan_node, input_rd, {}));
+  absl::Notification batch_enqueued;
+  ASSERT_OK(service_->AddGRPCSourceNode(query_uuid, grpc_source_node_id, &source_node, [&] {
+    if (!batch_enqueued.HasBeenNotified()) {
+      batch_enqueued.Notify();
+    }
+  }));
+
+  carnotpb::TransferResultChunkRequest initiate_stream_req;
+  auto query_id = initiate_stream_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+  initiate_stream_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  initiate_stream_req.mutable_query_result()->set_initiate_result_stream(true);
+
+  auto rb = RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                .AddColumn<types::Int64Value>({1, 2})
+                .get();
+  carnotpb::TransferResultChunkRequest rb_req;
+  EXPECT_OK(rb.ToProto(rb_req.mutable_query_result()->mutable_row_batch()));
+  rb_req.mutable_query_result()->set_grpc_source_id(grpc_source_node_id);
+  query_id = rb_req.mutable_query_id();
+  query_id->set_high_bits(ab);
+  query_id->set_low_bits(cd);
+
+  px::carnotpb::TransferResultChunkResponse response;
+  grpc::ClientContext context;
+  auto writer = stub_->TransferResultChunk(&context, &response);
+  EXPECT_TRUE(writer->Write(initiate_stream_req));
+  EXPECT_TRUE(writer->Write(rb_req));
+  batch_enqueued.WaitForNotification();
+
+  // The next batch ends the stream instead of being enqueued.
+  service_->StopSourceStream(query_uuid, grpc_source_node_id);
+  writer->Write(rb_req);
+  writer->WritesDone();
+  auto status = writer->Finish();
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(response.success());
+  EXPECT_TRUE(response.source_stopped());
+  EXPECT_EQ(1, source_node.row_batches.size());
+  EXPECT_EQ(1, service_->NumQueriesTracking());
+}
+
 TEST_F(GRPCRouterTest, threaded_router_test_multi_writer) {
   uint64_t ab = 0xea8aa095697f49f1, cd = 0xb127d50e5b6e2645;
   auto query_uuid = sole::rebuild(ab, cd);
@@ -18,19 +18,39 @@
 
 #include "src/carnot/exec/grpc_sink_node.h"
 
+#include <algorithm>
 #include <chrono>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/strings/substitute.h>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
+#include "src/carnot/exec/filter_kernels.h"
 #include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/hash_utils.h"
 #include "src/common/base/macros.h"
 #include "src/common/uuid/uuid_utils.h"
+#include "src/common/zlib/zlib_wrapper.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/hash_utils.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_bool(carnot_grpc_arrow_row_batches, false,
+            "Send row batches to other Carnot instances as their arrow buffers instead of value "
+            "by value. Only enable this once every Kelvin understands the arrow encoding, since "
+            "older ones drop it and receive empty row batches. Results sent to the query broker "
+            "always use the value by value encoding.");
+DEFINE_int64(carnot_grpc_compression_min_bytes, 0,
+             "Compress the arrow buffers of columns of at least this many bytes in row batches "
+             "sent to other Carnot instances. 0 disables compression.");
+DEFINE_int64(carnot_grpc_sink_max_pending_writes, 0,
+             "The most requests a GRPC sink queues for a background thread to write while the "
+             "query keeps executing. 0 writes every request on the exec thread.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -38,6 +58,8 @@ namespace exec {
 using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 
+GRPCSinkNode::~GRPCSinkNode() { StopWriterThread(); }
+
 std::string GRPCSinkNode::DebugStringImpl() {
   std::string destination;
   if (plan_node_->has_table_name()) {
@@ -67,8 +89,74 @@ StatusOr<carnotpb::TransferResultChunkRequest> RequestWithMetadata(
   return req;
 }
 
+// Only Carnot can read the arrow encoding, so it is not used for results sent to the query broker.
+Status SerializeRowBatch(const plan::GRPCSinkOperator& plan_node, const RowBatch& rb,
+                         carnotpb::TransferResultChunkRequest* req) {
+  auto* rb_proto = req->mutable_query_result()->mutable_row_batch();
+  if (FLAGS_carnot_grpc_arrow_row_batches && plan_node.has_grpc_source_id()) {
+    return rb.ToArrowProto(rb_proto);
+  }
+  return rb.ToProto(rb_proto);
+}
+
+// Folds the values of the column into the hash of each row. Every agent of a shuffle has to send a
+// key to the same partition, so this uses farmhash rather than the per process seeded absl::Hash.
+template <types::DataType T>
+void HashColumnRows(const arrow::Array* col, std::vector<uint64_t>* hashes) {
+  for (int64_t i = 0; i < col->length(); ++i) {
+    uint64_t hash;
+    if constexpr (T == types::STRING) {
+      auto val = static_cast<const arrow::StringArray*>(col)->GetView(i);
+      hash = ::util::Hash64(val.data(), val.size());
+    } else {
+      auto val = types::GetValueFromArrowArray<T>(col, i);
+      hash = ::util::Hash64(reinterpret_cast<const char*>(&val), sizeof(val));
+    }
+    (*hashes)[i] = ::px::HashCombine((*hashes)[i], hash);
+  }
+}
+
+StatusOr<std::unique_ptr<RowBatch>> GRPCSinkNode::PartitionRows(ExecState* exec_state,
+                                                                const RowBatch& rb) {
+  const auto& partition = plan_node_->hash_partition();
+  std::vector<uint64_t> hashes(rb.num_rows(), 0);
+  for (int64_t col_idx : partition.column_indexes()) {
+    auto col = rb.ColumnAt(col_idx);
+#define TYPE_CASE(_dt_) HashColumnRows<_dt_>(col.get(), &hashes);
+    PL_SWITCH_FOREACH_DATATYPE(rb.desc().type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  std::vector<int64_t> selection;
+  for (const auto& [row_idx, hash] : Enumerate(hashes)) {
+    if (static_cast<int64_t>(hash % partition.num_partitions()) == partition.partition()) {
+      selection.push_back(row_idx);
+    }
+  }
+
+  auto output_rb = std::make_unique<RowBatch>(rb.desc(), selection.size());
+  for (int64_t col_idx = 0; col_idx < rb.num_columns(); ++col_idx) {
+    if (static_cast<int64_t>(selection.size()) == rb.num_rows()) {
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(rb.ColumnAt(col_idx)));
+      continue;
+    }
+    if (rb.IsDeferredColumn(col_idx)) {
+      PL_ASSIGN_OR_RETURN(auto output_col, rb.DeferredColumnRowsAt(col_idx, selection));
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(output_col));
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(auto output_col,
+                        GatherArrowArray(rb.desc().type(col_idx), rb.ColumnAt(col_idx).get(),
+                                         selection, exec_state->exec_mem_pool()));
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(output_col));
+  }
+  output_rb->set_eow(rb.eow());
+  output_rb->set_eos(rb.eos());
+  return output_rb;
+}
+
 Status GRPCSinkNode::OptionallyCheckConnection(ExecState* exec_state) {
-  if (sent_eos_ || cancelled_) {
+  if (sent_eos_ || cancelled_ || destination_stopped_) {
     return Status::OK();
   }
 
@@ -83,12 +171,48 @@ Status GRPCSinkNode::OptionallyCheckConnection(ExecState* exec_state) {
   PL_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
   PL_ASSIGN_OR_RETURN(auto rb,
                       RowBatch::WithZeroRows(*input_descriptor_, /* eow */ false, /* eos */ false));
-  PL_RETURN_IF_ERROR(rb->ToProto(req.mutable_query_result()->mutable_row_batch()));
+  PL_RETURN_IF_ERROR(SerializeRowBatch(*plan_node_, *rb, &req));
 
   PL_RETURN_IF_ERROR(TryWriteRequest(exec_state, req));
   return Status::OK();
 }
 
+Status GRPCSinkNode::CompressArrowColumns(table_store::schemapb::RowBatchData* rb_proto) {
+  skip_compression_cols_.resize(rb_proto->arrow_cols_size(), false);
+  for (int col_idx = 0; col_idx < rb_proto->arrow_cols_size(); ++col_idx) {
+    auto* col = rb_proto->mutable_arrow_cols(col_idx);
+    int64_t num_bytes = col->data().size();
+    if (skip_compression_cols_[col_idx] || num_bytes < FLAGS_carnot_grpc_compression_min_bytes) {
+      continue;
+    }
+    compress_timer_.Resume();
+    auto compressed_or = zlib::Deflate(col->data());
+    compress_timer_.Stop();
+    PL_ASSIGN_OR_RETURN(std::string compressed, std::move(compressed_or));
+    if (compressed.size() > num_bytes * kMaxCompressedFraction) {
+      // Columns that don't compress in one batch (ie. random UPIDs or floats) are unlikely to in
+      // the next, so the rest of the stream doesn't pay to try.
+      skip_compression_cols_[col_idx] = true;
+      continue;
+    }
+    bytes_before_compression_ += num_bytes;
+    bytes_after_compression_ += compressed.size();
+    *col->mutable_data() = std::move(compressed);
+    col->set_uncompressed_size(num_bytes);
+  }
+  return Status::OK();
+}
+
+int64_t GRPCSinkNode::DesiredBatchBytes() const {
+  int64_t desired_bytes = static_cast<int64_t>(max_batch_size_ * batch_size_factor_);
+  if (wire_bytes_sent_ == 0) {
+    return desired_bytes;
+  }
+  // Batches that have been compressing well can hold more rows and still fit in a message.
+  double ratio = static_cast<double>(input_bytes_sent_) / wire_bytes_sent_;
+  return static_cast<int64_t>(desired_bytes * std::clamp(ratio, 1.0, kMaxBatchSizeGrowth));
+}
+
 Status GRPCSinkNode::InitImpl(const plan::Operator& plan_node) {
   CHECK(plan_node.op_type() == planpb::OperatorType::GRPC_SINK_OPERATOR);
   if (input_descriptors_.size() != 1) {
@@ -99,6 +223,10 @@ Status GRPCSinkNode::InitImpl(const plan::Operator& plan_node) {
   input_descriptor_ = std::make_unique<RowDescriptor>(input_descriptors_[0]);
   const auto* sink_plan_node = static_cast<const plan::GRPCSinkOperator*>(&plan_node);
   plan_node_ = std::make_unique<plan::GRPCSinkOperator>(*sink_plan_node);
+  compress_row_batches_ = FLAGS_carnot_grpc_compression_min_bytes > 0 &&
+                          FLAGS_carnot_grpc_arrow_row_batches && plan_node_->has_grpc_source_id();
+  async_writes_ = FLAGS_carnot_grpc_sink_max_pending_writes > 0;
+  max_pending_writes_ = std::max<int64_t>(FLAGS_carnot_grpc_sink_max_pending_writes, 0);
   return Status::OK();
 }
 
@@ -139,7 +267,7 @@ Status GRPCSinkNode::StartConnectionWithRetries(ExecState* exec_state, bool send
     // initiate_result_stream request.
     PL_ASSIGN_OR_RETURN(
         auto rb, RowBatch::WithZeroRows(*input_descriptor_, /* eow */ false, /* eos */ false));
-    PL_RETURN_IF_ERROR(rb->ToProto(req.mutable_query_result()->mutable_row_batch()));
+    PL_RETURN_IF_ERROR(SerializeRowBatch(*plan_node_, *rb, &req));
   }
 
   if (!writer_->Write(req)) {
@@ -160,15 +288,33 @@ Status GRPCSinkNode::CancelledByServer(ExecState* exec_state) {
 
 Status GRPCSinkNode::TryWriteRequest(ExecState* exec_state,
                                      const carnotpb::TransferResultChunkRequest& req) {
-  if (writer_->Write(req)) {
+  if (async_writes_) {
+    return QueueWriteRequest(exec_state, req);
+  }
+  write_timer_.Resume();
+  bool written = writer_->Write(req);
+  write_timer_.Stop();
+  if (written) {
     last_send_time_ = std::chrono::system_clock::now();
     return Status::OK();
   }
+  return RecoverFailedWrite(exec_state, {req});
+}
 
+Status GRPCSinkNode::RecoverFailedWrite(
+    ExecState* exec_state, const std::vector<carnotpb::TransferResultChunkRequest>& unsent) {
   // We need to determine if the server sent a response (i.e. server closed connection) or if the
   // connection just died.
   writer_->WritesDone();
   auto s = writer_->Finish();
+  if (s.ok() && response_.source_stopped()) {
+    VLOG(1) << absl::Substitute(
+        "GRPCSinkNode $0 of query $1: destination $2 needs no more results, stopping the stream.",
+        plan_node_->id(), exec_state->query_id().str(), plan_node_->address());
+    destination_stopped_ = true;
+    writer_.reset();
+    return Status::OK();
+  }
   // If the Finish call was successful, then the server closed the connection and sent a response,
   // in which case we shouldn't try to reconnect. If there's an error from the server side
   // other than a RST_STREAM, we also shouldn't retry.
@@ -180,16 +326,106 @@ Status GRPCSinkNode::TryWriteRequest(ExecState* exec_state,
   // so we can try to restart the connection.
   PL_RETURN_IF_ERROR(StartConnection(exec_state, /* send_initiate_req */ false));
 
-  // Try again to write the request on the new connection.
-  if (!writer_->Write(req)) {
-    return CancelledByServer(exec_state);
+  // Try again to write the requests on the new connection.
+  for (const auto& req : unsent) {
+    if (!writer_->Write(req)) {
+      return CancelledByServer(exec_state);
+    }
   }
   last_send_time_ = std::chrono::system_clock::now();
   return Status::OK();
 }
 
+Status GRPCSinkNode::QueueWriteRequest(ExecState* exec_state,
+                                       const carnotpb::TransferResultChunkRequest& req) {
+  {
+    std::unique_lock<std::mutex> lock(writes_mutex_);
+    write_timer_.Resume();
+    writes_cv_.wait(lock, [this] {
+      return write_failed_ || pending_writes_.size() < max_pending_writes_;
+    });
+    write_timer_.Stop();
+    if (!write_failed_) {
+      pending_writes_.push_back(req);
+      lock.unlock();
+      writes_cv_.notify_all();
+      last_send_time_ = std::chrono::system_clock::now();
+      return Status::OK();
+    }
+  }
+
+  std::vector<carnotpb::TransferResultChunkRequest> unsent = StopWriterThread();
+  unsent.push_back(req);
+  PL_RETURN_IF_ERROR(RecoverFailedWrite(exec_state, unsent));
+  if (!destination_stopped_) {
+    StartWriterThread();
+  }
+  return Status::OK();
+}
+
+Status GRPCSinkNode::FlushWrites(ExecState* exec_state) {
+  std::vector<carnotpb::TransferResultChunkRequest> unsent = StopWriterThread();
+  if (unsent.empty()) {
+    return Status::OK();
+  }
+  return RecoverFailedWrite(exec_state, unsent);
+}
+
+void GRPCSinkNode::StartWriterThread() {
+  writer_thread_ = std::thread(&GRPCSinkNode::WriterLoop, this);
+}
+
+std::vector<carnotpb::TransferResultChunkRequest> GRPCSinkNode::StopWriterThread() {
+  if (!writer_thread_.joinable()) {
+    return {};
+  }
+  {
+    std::lock_guard<std::mutex> lock(writes_mutex_);
+    stop_writer_ = true;
+  }
+  writes_cv_.notify_all();
+  write_timer_.Resume();
+  writer_thread_.join();
+  write_timer_.Stop();
+
+  std::lock_guard<std::mutex> lock(writes_mutex_);
+  std::vector<carnotpb::TransferResultChunkRequest> unsent(
+      std::make_move_iterator(pending_writes_.begin()),
+      std::make_move_iterator(pending_writes_.end()));
+  pending_writes_.clear();
+  write_failed_ = false;
+  stop_writer_ = false;
+  return unsent;
+}
+
+void GRPCSinkNode::WriterLoop() {
+  std::unique_lock<std::mutex> lock(writes_mutex_);
+  while (true) {
+    writes_cv_.wait(lock, [this] { return stop_writer_ || !pending_writes_.empty(); });
+    if (pending_writes_.empty()) {
+      return;
+    }
+    // References to the elements of a deque stay valid as the exec thread queues more requests.
+    const auto& req = pending_writes_.front();
+    lock.unlock();
+    bool written = writer_->Write(req);
+    lock.lock();
+    if (!written) {
+      write_failed_ = true;
+      writes_cv_.notify_all();
+      return;
+    }
+    pending_writes_.pop_front();
+    writes_cv_.notify_all();
+  }
+}
+
 Status GRPCSinkNode::OpenImpl(ExecState* exec_state) {
-  return StartConnection(exec_state, /* send_initiate_req */ true);
+  PL_RETURN_IF_ERROR(StartConnection(exec_state, /* send_initiate_req */ true));
+  if (async_writes_) {
+    StartWriterThread();
+  }
+  return Status::OK();
 }
 
 Status GRPCSinkNode::CloseWriter(ExecState* exec_state) {
@@ -207,6 +443,19 @@ Status GRPCSinkNode::CloseWriter(ExecState* exec_state) {
 }
 
 Status GRPCSinkNode::CloseImpl(ExecState* exec_state) {
+  // The query is done with the sink, so requests that couldn't be written are dropped.
+  StopWriterThread();
+  stats()->AddExtraMetric("write_time_ms", write_timer_.ElapsedTime_us() / 1000.0);
+  if (compress_row_batches_) {
+    stats()->AddExtraMetric("compress_time_ms", compress_timer_.ElapsedTime_us() / 1000.0);
+    stats()->AddExtraMetric("compressed_bytes", bytes_after_compression_);
+    stats()->AddExtraMetric("compression_ratio",
+                            bytes_after_compression_ == 0
+                                ? 1.0
+                                : static_cast<double>(bytes_before_compression_) /
+                                      bytes_after_compression_);
+  }
+
   if (sent_eos_ || cancelled_) {
     return Status::OK();
   }
@@ -243,7 +492,7 @@ static inline bool GetRowSizes(const RowBatch& rb, std::vector<int64_t>* string_
 std::vector<int64_t> GRPCSinkNode::SplitBatchSizes(bool has_string_col,
                                                    const std::vector<int64_t>& string_col_row_sizes,
                                                    int64_t other_col_row_size) const {
-  int64_t desired_batch_size_bytes = static_cast<int64_t>(max_batch_size_ * batch_size_factor_);
+  int64_t desired_batch_size_bytes = DesiredBatchBytes();
   std::vector<int64_t> new_batches_num_rows;
   if (has_string_col) {
     int64_t batch_bytes = 0;
@@ -310,20 +559,71 @@ Status GRPCSinkNode::SplitAndSendBatch(ExecState* exec_state, const RowBatch& rb
 }
 
 Status GRPCSinkNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t parent_idx) {
-  if (rb.NumBytes() > (max_batch_size_ * batch_size_factor_)) {
+  if (destination_stopped_) {
+    return Status::OK();
+  }
+  if (plan_node_->has_hash_partition()) {
+    PL_ASSIGN_OR_RETURN(std::unique_ptr<RowBatch> partition_rb, PartitionRows(exec_state, rb));
+    // The other partitions' sinks send the rest of the batch, so there's nothing to send unless
+    // the batch ends a window or the stream.
+    if (partition_rb->num_rows() == 0 && !rb.eow() && !rb.eos()) {
+      return Status::OK();
+    }
+    if (partition_rb->NumBytes() > DesiredBatchBytes()) {
+      return SplitAndSendBatch(exec_state, *partition_rb, parent_idx);
+    }
+    return ConsumeNextImplNoSplit(exec_state, *partition_rb, parent_idx);
+  }
+  if (rb.NumBytes() > DesiredBatchBytes()) {
     return SplitAndSendBatch(exec_state, rb, parent_idx);
   }
   return ConsumeNextImplNoSplit(exec_state, rb, parent_idx);
 }
 
-Status GRPCSinkNode::ConsumeNextImplNoSplit(ExecState* exec_state, const RowBatch& rb, size_t) {
+Status GRPCSinkNode::ConsumeNextImplNoSplit(ExecState* exec_state, const RowBatch& rb,
+                                            size_t parent_idx) {
+  // The destination may have stopped while the previous part of a split batch was sent.
+  if (destination_stopped_) {
+    return Status::OK();
+  }
   PL_ASSIGN_OR_RETURN(auto req, RequestWithMetadata(plan_node_.get(), exec_state));
   // Serialize the RowBatch.
-  PL_RETURN_IF_ERROR(rb.ToProto(req.mutable_query_result()->mutable_row_batch()));
+  PL_RETURN_IF_ERROR(SerializeRowBatch(*plan_node_, rb, &req));
+  if (plan_node_->snapshots() && rb.eow() && !rb.eos()) {
+    auto* result = req.mutable_query_result();
+    result->set_snapshot(true);
+    if (exec_state->grpc_router() != nullptr) {
+      auto progress = exec_state->grpc_router()->GetQueryProgress(exec_state->query_id());
+      result->set_num_agents_done(progress.num_agents_done);
+      result->set_num_active_streams(progress.num_active_streams);
+    }
+  }
+
+  if (compress_row_batches_) {
+    PL_RETURN_IF_ERROR(CompressArrowColumns(req.mutable_query_result()->mutable_row_batch()));
+    int64_t wire_bytes = req.ByteSizeLong();
+    if (wire_bytes > static_cast<int64_t>(max_batch_size_) && rb.num_rows() > 1) {
+      // The batch was sized for how well the previous batches compressed, but this one didn't
+      // compress as well and is too big for a single message.
+      int64_t half = rb.num_rows() / 2;
+      PL_ASSIGN_OR_RETURN(std::unique_ptr<RowBatch> first, rb.Slice(0, half));
+      PL_ASSIGN_OR_RETURN(std::unique_ptr<RowBatch> second, rb.Slice(half, rb.num_rows() - half));
+      second->set_eow(rb.eow());
+      second->set_eos(rb.eos());
+      PL_RETURN_IF_ERROR(ConsumeNextImplNoSplit(exec_state, *first, parent_idx));
+      return ConsumeNextImplNoSplit(exec_state, *second, parent_idx);
+    }
+    input_bytes_sent_ += rb.NumBytes();
+    wire_bytes_sent_ += wire_bytes;
+  }
 
   PL_RETURN_IF_ERROR(TryWriteRequest(exec_state, req));
 
-  if (!rb.eos()) {
+  if (!rb.eos() || destination_stopped_) {
+    return Status::OK();
+  }
+  PL_RETURN_IF_ERROR(FlushWrites(exec_state));
+  if (destination_stopped_) {
     return Status::OK();
   }
 
@@ -20,8 +20,12 @@
 
 #include <stddef.h>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <grpcpp/grpcpp.h>
@@ -35,6 +39,10 @@
 
 #include "src/carnot/carnotpb/carnot.grpc.pb.h"
 
+DECLARE_bool(carnot_grpc_arrow_row_batches);
+DECLARE_int64(carnot_grpc_compression_min_bytes);
+DECLARE_int64(carnot_grpc_sink_max_pending_writes);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -50,17 +58,25 @@ constexpr float kBatchSizeFactor = 0.9f;
 
 // Number of times to retry connecting to grpc before giving up.
 constexpr size_t kGRPCRetries = 3;
+// Compressed columns that don't save more than this fraction of their bytes are sent as is.
+constexpr double kMaxCompressedFraction = 0.9;
+// Upper bound on how much the compression ratio of a stream can grow its batches.
+constexpr double kMaxBatchSizeGrowth = 4.0;
 
 class GRPCSinkNode : public SinkNode {
  public:
   GRPCSinkNode(size_t max_batch_size, float batch_size_factor)
       : max_batch_size_(max_batch_size), batch_size_factor_(batch_size_factor) {}
   GRPCSinkNode() : GRPCSinkNode(kMaxBatchSize, kBatchSizeFactor) {}
-  virtual ~GRPCSinkNode() = default;
+  virtual ~GRPCSinkNode();
 
   // Used to check the downstream connection after connection_check_timeout_ has elapsed.
   Status OptionallyCheckConnection(ExecState* exec_state);
 
+  // Whether the destination of the stream needs no more results, ie. a limit downstream of it was
+  // reached. The sink drops the batches it's given from then on.
+  bool destination_stopped() const { return destination_stopped_; }
+
   void testing_set_connection_check_timeout(const std::chrono::milliseconds& timeout) {
     connection_check_timeout_ = timeout;
   }
@@ -91,8 +107,32 @@ class GRPCSinkNode : public SinkNode {
                                     size_t n_retries);
   Status CancelledByServer(ExecState* exec_state);
   Status TryWriteRequest(ExecState* exec_state, const carnotpb::TransferResultChunkRequest& req);
+  // Handles a write that failed on the current stream. Reconnects if the stream died, and then
+  // writes the unsent requests, in order, on the new stream.
+  Status RecoverFailedWrite(ExecState* exec_state,
+                            const std::vector<carnotpb::TransferResultChunkRequest>& unsent);
+
+  // With async writes, requests are queued for writer_thread_, which writes them while the exec
+  // thread keeps producing batches. The exec thread blocks once max_pending_writes_ requests are
+  // queued, and handles failed writes the next time it queues or flushes.
+  Status QueueWriteRequest(ExecState* exec_state, const carnotpb::TransferResultChunkRequest& req);
+  // Waits for the queued requests to be written.
+  Status FlushWrites(ExecState* exec_state);
+  void StartWriterThread();
+  // Waits for the writer thread to write the queued requests or fail, and stops it. Returns the
+  // requests that weren't written.
+  std::vector<carnotpb::TransferResultChunkRequest> StopWriterThread();
+  void WriterLoop();
+  // Compresses the large arrow columns of the row batch in place.
+  Status CompressArrowColumns(table_store::schemapb::RowBatchData* rb_proto);
+  // The number of bytes of row batch that fit in a single request.
+  int64_t DesiredBatchBytes() const;
+  // Returns the rows of the row batch that belong to the sink's hash partition.
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> PartitionRows(
+      ExecState* exec_state, const table_store::schema::RowBatch& rb);
 
   bool cancelled_ = false;
+  bool destination_stopped_ = false;
 
   std::unique_ptr<grpc::ClientContext> context_;
   carnotpb::TransferResultChunkResponse response_;
@@ -108,6 +148,31 @@ class GRPCSinkNode : public SinkNode {
 
   size_t max_batch_size_;
   float batch_size_factor_;
+
+  // Whether the arrow columns of the row batches are compressed before they are sent.
+  bool compress_row_batches_ = false;
+  // Indexed by column, set for the columns that stopped being compressed.
+  std::vector<bool> skip_compression_cols_;
+  int64_t bytes_before_compression_ = 0;
+  int64_t bytes_after_compression_ = 0;
+  // The row batch and request bytes sent so far, used to adapt the batch size to the
+  // compression ratio of the stream.
+  int64_t input_bytes_sent_ = 0;
+  int64_t wire_bytes_sent_ = 0;
+  ElapsedTimer compress_timer_;
+  // The time the exec thread spent writing, or waiting on the writer thread.
+  ElapsedTimer write_timer_;
+
+  bool async_writes_ = false;
+  size_t max_pending_writes_ = 0;
+  std::thread writer_thread_;
+  std::mutex writes_mutex_;
+  std::condition_variable writes_cv_;
+  // The front request is the one being written, and stays queued until it's written so that a
+  // failed write can be retried.
+  std::deque<carnotpb::TransferResultChunkRequest> pending_writes_;
+  bool write_failed_ = false;
+  bool stop_writer_ = false;
 };
 
 }  // namespace exec
@@ -19,6 +19,7 @@
 #include <utility>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
 #include <benchmark/benchmark.h>
 #include <grpcpp/test/mock_stream.h>
 #include <gtest/gtest.h>
@@ -101,3 +102,50 @@ void BM_GRPCSinkNodeSplitting(benchmark::State& state) {
 }
 
 BENCHMARK(BM_GRPCSinkNodeSplitting)->Unit(benchmark::kMillisecond);
+
+// Compares the cost of encoding a row batch into a request and decoding it back out with the
+// value by value encoding (0) and the arrow buffer encoding (1).
+// NOLINTNEXTLINE : runtime/references.
+void BM_RowBatchTransferEncoding(benchmark::State& state) {
+  bool arrow_encoding = state.range(0);
+  auto num_rows = 16 * 1024;
+
+  RowDescriptor rd({DataType::TIME64NS, DataType::INT64, DataType::FLOAT64, DataType::STRING});
+  std::vector<px::types::Time64NSValue> times(num_rows);
+  std::vector<px::types::Int64Value> ints(num_rows);
+  std::vector<px::types::Float64Value> floats(num_rows);
+  std::vector<px::types::StringValue> strings(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    times[i] = i;
+    ints[i] = i * 7;
+    floats[i] = i * 0.5;
+    strings[i] = absl::StrCat("/api/v1/endpoint/", i % 64);
+  }
+  auto row_batch_builder = px::carnot::exec::RowBatchBuilder(rd, num_rows, /*eow*/ true,
+                                                             /*eos*/ true);
+  row_batch_builder.AddColumn<px::types::Time64NSValue>(times);
+  row_batch_builder.AddColumn<px::types::Int64Value>(ints);
+  row_batch_builder.AddColumn<px::types::Float64Value>(floats);
+  row_batch_builder.AddColumn<px::types::StringValue>(strings);
+  auto rb = row_batch_builder.get();
+
+  for (auto _ : state) {
+    TransferResultChunkRequest req;
+    auto* rb_proto = req.mutable_query_result()->mutable_row_batch();
+    if (arrow_encoding) {
+      PL_CHECK_OK(rb.ToArrowProto(rb_proto));
+    } else {
+      PL_CHECK_OK(rb.ToProto(rb_proto));
+    }
+    std::string serialized = req.SerializeAsString();
+    TransferResultChunkRequest received;
+    CHECK(received.ParseFromString(serialized));
+    auto output_rb =
+        RowBatch::FromProto(std::move(*received.mutable_query_result()->mutable_row_batch()));
+    PL_CHECK_OK(output_rb);
+    benchmark::DoNotOptimize(output_rb);
+  }
+  state.SetBytesProcessed(state.iterations() * rb.NumBytes());
+}
+
+BENCHMARK(BM_RowBatchTransferEncoding)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -33,6 +33,7 @@
 #include "src/carnot/udf/registry.h"
 #include "src/common/testing/testing.h"
 #include "src/common/uuid/uuid_utils.h"
+#include "src/common/zlib/zlib_wrapper.h"
 #include "src/shared/types/types.h"
 
 namespace px {
@@ -231,6 +232,60 @@ TEST_F(GRPCSinkNodeTest, internal_result) {
   EXPECT_FALSE(add_metadata_called_);
 }
 
+TEST_F(GRPCSinkNodeTest, compressed_internal_result) {
+  FLAGS_carnot_grpc_arrow_row_batches = true;
+  FLAGS_carnot_grpc_compression_min_bytes = 1024;
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  std::vector<TransferResultChunkRequest> actual_protos(2);
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(2)
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)));
+  EXPECT_CALL(*writer, WritesDone());
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  // The first column compresses well, the second is effectively random and is sent as is.
+  std::vector<types::Int64Value> repeated(1000, 7);
+  std::vector<types::Int64Value> random(1000);
+  for (uint64_t i = 0; i < random.size(); ++i) {
+    random[i] = static_cast<int64_t>((i + 1) * 0x9E3779B97F4A7C15ULL);
+  }
+  auto rb = RowBatchBuilder(output_rd, 1000, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>(repeated)
+                .AddColumn<types::Int64Value>(random)
+                .get();
+  tester.ConsumeNext(rb, 5, 0);
+  tester.Close();
+  FLAGS_carnot_grpc_compression_min_bytes = 0;
+  FLAGS_carnot_grpc_arrow_row_batches = false;
+
+  const auto& rb_proto = actual_protos[1].query_result().row_batch();
+  ASSERT_EQ(2, rb_proto.arrow_cols_size());
+  EXPECT_EQ(8000, rb_proto.arrow_cols(0).uncompressed_size());
+  EXPECT_LT(rb_proto.arrow_cols(0).data().size(), 8000U);
+  EXPECT_EQ(0, rb_proto.arrow_cols(1).uncompressed_size());
+  EXPECT_EQ(8000U, rb_proto.arrow_cols(1).data().size());
+
+  ASSERT_OK_AND_ASSIGN(std::string decompressed, zlib::Inflate(rb_proto.arrow_cols(0).data()));
+  table_store::schemapb::RowBatchData expected_proto;
+  EXPECT_OK(rb.ToArrowProto(&expected_proto));
+  EXPECT_EQ(expected_proto.arrow_cols(0).data(), decompressed);
+}
+
 constexpr char kExpectedExternalInitialization[] = R"proto(
 address: "localhost:1234"
 query_id {
@@ -732,6 +787,125 @@ TEST_F(GRPCSinkNodeTest, retry_failed_writes) {
   EXPECT_FALSE(add_metadata_called_);
 }
 
+TEST_F(GRPCSinkNodeTest, async_writes_retry_failed_writes) {
+  auto max_pending_writes = FLAGS_carnot_grpc_sink_max_pending_writes;
+  FLAGS_carnot_grpc_sink_max_pending_writes = 1;
+
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  google::protobuf::util::MessageDifferencer differ;
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  std::vector<TransferResultChunkRequest> actual_protos(5);
+  std::vector<std::string> expected_protos = {
+      absl::Substitute(kExpectedInternalInitialization, exec_state_->query_id().ab,
+                       exec_state_->query_id().cd),
+      absl::Substitute(kExpectedInteralResult0, exec_state_->query_id().ab,
+                       exec_state_->query_id().cd),
+      absl::Substitute(kExpectedInteralResult1, exec_state_->query_id().ab,
+                       exec_state_->query_id().cd),
+      absl::Substitute(kExpected0RowResult, exec_state_->query_id().ab, exec_state_->query_id().cd),
+      absl::Substitute(kExpectedInteralResult2, exec_state_->query_id().ab,
+                       exec_state_->query_id().cd),
+  };
+
+  auto writer1 = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  auto writer2 = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+
+  EXPECT_CALL(*writer1, Write(_, _))
+      .Times(4)
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[2]), Return(true)))
+      .WillOnce(Return(false));
+
+  EXPECT_CALL(*writer2, Write(_, _))
+      .Times(2)
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[3]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[4]), Return(true)));
+
+  EXPECT_CALL(*writer1, WritesDone()).WillOnce(Return(true));
+  EXPECT_CALL(*writer2, WritesDone()).WillOnce(Return(true));
+
+  EXPECT_CALL(*writer1, Finish())
+      .WillOnce(
+          Return(grpc::Status(grpc::StatusCode::INTERNAL, "Received RST_STREAM with code 2")));
+  EXPECT_CALL(*writer2, Finish()).WillOnce(Return(grpc::Status::OK));
+
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .Times(2)
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer1)))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer2)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  for (auto i = 0; i < 3; ++i) {
+    std::vector<types::Int64Value> data(i, i);
+    auto rb = RowBatchBuilder(output_rd, i, /*eow*/ i == 2, /*eos*/ i == 2)
+                  .AddColumn<types::Int64Value>(data)
+                  .get();
+    tester.ConsumeNext(rb, 5, 0);
+  }
+
+  tester.Close();
+
+  for (auto i = 0; i < 5; ++i) {
+    EXPECT_THAT(actual_protos[i], EqualsProto(expected_protos[i]));
+  }
+
+  EXPECT_FALSE(add_metadata_called_);
+  FLAGS_carnot_grpc_sink_max_pending_writes = max_pending_writes;
+}
+
+TEST_F(GRPCSinkNodeTest, destination_stopped) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  auto s = plan_node->Init(op_proto.grpc_sink_op());
+  RowDescriptor input_rd({types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+  resp.set_source_stopped(true);
+
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(3)
+      .WillOnce(Return(true))    // Initiate result sink
+      .WillOnce(Return(true))    // First batch.
+      .WillOnce(Return(false));  // The destination ended the stream.
+  EXPECT_CALL(*writer, WritesDone()).Times(1).WillOnce(Return(true));
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+
+  // The sink shouldn't reconnect to a destination that needs no more results.
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .Times(1)
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+  tester.node()->testing_set_connection_check_timeout(std::chrono::milliseconds(-1));
+
+  for (auto i = 0; i < 4; ++i) {
+    std::vector<types::Int64Value> data(1, i);
+    auto rb = RowBatchBuilder(output_rd, 1, /*eow*/ i == 3, /*eos*/ i == 3)
+                  .AddColumn<types::Int64Value>(data)
+                  .get();
+    tester.ConsumeNext(rb, 5, 0);
+  }
+  EXPECT_TRUE(tester.node()->destination_stopped());
+  EXPECT_OK(tester.node()->OptionallyCheckConnection(exec_state_.get()));
+
+  tester.Close();
+}
+
 TEST_F(GRPCSinkNodeTest, check_connection_after_eos) {
   auto op_proto = planpb::testutils::CreateTestGRPCSink2PB();
   auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
@@ -773,6 +947,61 @@ TEST_F(GRPCSinkNodeTest, check_connection_after_eos) {
   tester.Close();
 }
 
+TEST_F(GRPCSinkNodeTest, hash_partition) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSink1PB();
+  auto hash_partition = op_proto.mutable_grpc_sink_op()->mutable_hash_partition();
+  hash_partition->add_column_indexes(0);
+  hash_partition->set_num_partitions(2);
+  hash_partition->set_partition(0);
+  auto plan_node = std::make_unique<plan::GRPCSinkOperator>(1);
+  EXPECT_OK(plan_node->Init(op_proto.grpc_sink_op()));
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  TransferResultChunkResponse resp;
+  resp.set_success(true);
+
+  std::vector<TransferResultChunkRequest> actual_protos(2);
+  auto writer = new grpc::testing::MockClientWriter<TransferResultChunkRequest>();
+  EXPECT_CALL(*writer, Write(_, _))
+      .Times(2)
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[0]), Return(true)))
+      .WillOnce(DoAll(SaveArg<0>(&actual_protos[1]), Return(true)));
+  EXPECT_CALL(*writer, WritesDone());
+  EXPECT_CALL(*writer, Finish()).WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_, TransferResultChunkRaw(_, _))
+      .WillOnce(DoAll(SetArgPointee<1>(resp), Return(writer)));
+
+  auto tester = exec::ExecNodeTester<GRPCSinkNode, plan::GRPCSinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  std::vector<types::Int64Value> keys;
+  std::vector<types::Int64Value> values;
+  for (int64_t i = 0; i < 100; ++i) {
+    keys.push_back(i);
+    values.push_back(i * 10);
+  }
+  auto rb = RowBatchBuilder(output_rd, keys.size(), /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>(keys)
+                .AddColumn<types::Int64Value>(values)
+                .get();
+  tester.ConsumeNext(rb, 5, 0);
+  tester.Close();
+
+  ASSERT_OK_AND_ASSIGN(auto sent_rb,
+                       RowBatch::FromProto(actual_protos[1].query_result().row_batch()));
+  EXPECT_TRUE(sent_rb->eow());
+  EXPECT_TRUE(sent_rb->eos());
+  // Only some of the keys belong to the partition, and their rows are sent whole.
+  EXPECT_GT(sent_rb->num_rows(), 0);
+  EXPECT_LT(sent_rb->num_rows(), 100);
+  auto sent_keys = std::static_pointer_cast<arrow::Int64Array>(sent_rb->ColumnAt(0));
+  auto sent_values = std::static_pointer_cast<arrow::Int64Array>(sent_rb->ColumnAt(1));
+  for (int64_t i = 0; i < sent_rb->num_rows(); ++i) {
+    EXPECT_EQ(sent_keys->Value(i) * 10, sent_values->Value(i));
+  }
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
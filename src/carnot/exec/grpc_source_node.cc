@@ -18,6 +18,8 @@
 
 #include "src/carnot/exec/grpc_source_node.h"
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,6 +27,11 @@
 #include <absl/strings/substitute.h>
 
 #include "src/carnot/planpb/plan.pb.h"
+#include "src/common/zlib/zlib_wrapper.h"
+
+DEFINE_int64(carnot_grpc_source_max_queued_bytes, 128 * 1024 * 1024,
+             "The number of bytes of row batches a GRPCSource buffers before the result streams "
+             "sending to it are paused. 0 leaves the queue unbounded.");
 
 namespace px {
 namespace carnot {
@@ -32,6 +39,46 @@ namespace exec {
 
 using table_store::schema::RowBatch;
 
+namespace {
+
+void UpdateMax(std::atomic<int64_t>* max, int64_t val) {
+  int64_t prev = max->load();
+  while (prev < val && !max->compare_exchange_weak(prev, val)) {
+  }
+}
+
+// Decompresses the arrow columns that the GRPCSink compressed, in place.
+Status DecompressArrowColumns(table_store::schemapb::RowBatchData* rb_proto) {
+  for (auto& col : *rb_proto->mutable_arrow_cols()) {
+    if (col.uncompressed_size() == 0) {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(std::string data, zlib::Inflate(col.data(), col.uncompressed_size()));
+    if (static_cast<int64_t>(data.size()) != col.uncompressed_size()) {
+      return error::Internal("Expected $0 bytes once decompressed, got $1",
+                             col.uncompressed_size(), data.size());
+    }
+    *col.mutable_data() = std::move(data);
+    col.set_uncompressed_size(0);
+  }
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<RowBatch>> DecodeRowBatch(
+    carnotpb::TransferResultChunkRequest* rb_request) {
+  if (!rb_request->has_query_result() || !rb_request->query_result().has_row_batch()) {
+    return error::Internal(
+        "GRPCSourceNode::EnqueueRowBatch expected TransferResultChunkRequest to have RowBatch "
+        "message.");
+  }
+  // The request isn't needed anymore, so its arrow buffers can be moved into the row batch.
+  auto* rb_proto = rb_request->mutable_query_result()->mutable_row_batch();
+  PL_RETURN_IF_ERROR(DecompressArrowColumns(rb_proto));
+  return RowBatch::FromProto(std::move(*rb_proto));
+}
+
+}  // namespace
+
 std::string GRPCSourceNode::DebugStringImpl() {
   return absl::Substitute("Exec::GRPCSourceNode: <id: $0, output: $1>", plan_node_->id(),
                           output_descriptor_->DebugString());
@@ -47,7 +94,13 @@ Status GRPCSourceNode::PrepareImpl(ExecState*) { return Status::OK(); }
 
 Status GRPCSourceNode::OpenImpl(ExecState*) { return Status::OK(); }
 
-Status GRPCSourceNode::CloseImpl(ExecState*) { return Status::OK(); }
+Status GRPCSourceNode::CloseImpl(ExecState*) {
+  stats()->AddExtraMetric("max_queued_bytes", max_queued_bytes_.load());
+  stats()->AddExtraMetric("max_queued_batches", max_queued_batches_.load());
+  stats()->AddExtraMetric("enqueue_blocked_ms", enqueue_blocked_ns_.load() / 1000000.0);
+  stats()->AddExtraMetric("decode_time_ms", decode_ns_.load() / 1000000.0);
+  return Status::OK();
+}
 
 Status GRPCSourceNode::GenerateNextImpl(ExecState* exec_state) {
   PL_RETURN_IF_ERROR(PopRowBatch());
@@ -57,28 +110,43 @@ Status GRPCSourceNode::GenerateNextImpl(ExecState* exec_state) {
 
 Status GRPCSourceNode::EnqueueRowBatch(
     std::unique_ptr<carnotpb::TransferResultChunkRequest> row_batch) {
-  if (!row_batch_queue_.enqueue(std::move(row_batch))) {
+  QueuedRowBatch queued;
+  queued.num_bytes = row_batch->ByteSizeLong();
+  auto start_time = std::chrono::steady_clock::now();
+  auto rb_or = DecodeRowBatch(row_batch.get());
+  decode_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_time)
+                    .count();
+  if (rb_or.ok()) {
+    queued.rb = rb_or.ConsumeValueOrDie();
+  } else {
+    queued.status = rb_or.status();
+  }
+  int64_t num_bytes = queued.num_bytes;
+  if (!row_batch_queue_.enqueue(std::move(queued))) {
     return error::Internal("Failed to enqueue RowBatch");
   }
+  UpdateMax(&max_queued_bytes_, queued_bytes_ += num_bytes);
+  UpdateMax(&max_queued_batches_, ++queued_batches_);
   return Status::OK();
 }
 
 Status GRPCSourceNode::PopRowBatch() {
   DCHECK(NextBatchReady());
-  std::unique_ptr<carnotpb::TransferResultChunkRequest> rb_request;
-  bool got_one = row_batch_queue_.try_dequeue(rb_request);
+  QueuedRowBatch queued;
+  bool got_one = row_batch_queue_.try_dequeue(queued);
   if (!got_one) {
     return error::Internal(
         "Called GRPCSourceNode::OptionallyPopRowBatch but there was no available row batch in the "
         "queue.");
   }
-  if (!rb_request->has_query_result() || !rb_request->query_result().has_row_batch()) {
-    return error::Internal(
-        "GRPCSourceNode::PopRowBatch expected TransferResultChunkRequest to have RowBatch "
-        "message.");
+  queued_bytes_ -= queued.num_bytes;
+  --queued_batches_;
+  if (on_pop_) {
+    on_pop_();
   }
-
-  PL_ASSIGN_OR_RETURN(rb_, RowBatch::FromProto(rb_request->query_result().row_batch()));
+  PL_RETURN_IF_ERROR(queued.status);
+  rb_ = std::move(queued.rb);
   return Status::OK();
 }
 
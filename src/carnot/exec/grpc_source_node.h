@@ -18,9 +18,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/carnotpb/carnot.pb.h"
@@ -32,6 +35,8 @@
 
 #include "blockingconcurrentqueue.h"
 
+DECLARE_int64(carnot_grpc_source_max_queued_bytes);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -42,8 +47,25 @@ class GRPCSourceNode : public SourceNode {
   virtual ~GRPCSourceNode() = default;
 
   bool NextBatchReady() override;
+  // Decodes the row batch of the request and queues it for the exec thread. Called by the
+  // GRPCRouter on the gRPC thread of the result stream, so the streams sending to a Kelvin decode
+  // their batches in parallel rather than on the exec thread.
   virtual Status EnqueueRowBatch(std::unique_ptr<carnotpb::TransferResultChunkRequest> row_batch);
 
+  // Whether the queue of row batches has room for another one. The GRPCRouter stops reading from
+  // the result streams of a source without capacity, which pushes back on the sinks sending to it.
+  bool HasCapacity() const {
+    return FLAGS_carnot_grpc_source_max_queued_bytes <= 0 ||
+           queued_bytes_ < FLAGS_carnot_grpc_source_max_queued_bytes;
+  }
+  // Sets a function that the exec thread calls every time it pops a batch from the queue, so
+  // that the result streams waiting for capacity wake up. Must be set before the node runs.
+  void set_on_pop(std::function<void()> on_pop) { on_pop_ = std::move(on_pop); }
+  // Records the time a result stream spent waiting for this source to have capacity.
+  void RecordEnqueueBlockedTime(std::chrono::nanoseconds blocked_time) {
+    enqueue_blocked_ns_ += blocked_time.count();
+  }
+
   // Tracks whether the upstream sink node has successfully initiated the connection to
   // this remote source. Used by the exec graph to determine whether or not any sources have
   // taken too long for their connection to be established with the sinks.
@@ -67,9 +89,27 @@ class GRPCSourceNode : public SourceNode {
  private:
   Status PopRowBatch();
 
+  struct QueuedRowBatch {
+    // Set if the request couldn't be decoded, in which case rb is null. The error is returned
+    // when the batch is popped so that it fails the query like any other exec error.
+    Status status;
+    std::unique_ptr<table_store::schema::RowBatch> rb;
+    // The size of the request the batch was decoded from.
+    int64_t num_bytes = 0;
+  };
+
   std::unique_ptr<table_store::schema::RowBatch> rb_;
-  moodycamel::BlockingConcurrentQueue<std::unique_ptr<carnotpb::TransferResultChunkRequest>>
-      row_batch_queue_;
+  moodycamel::BlockingConcurrentQueue<QueuedRowBatch> row_batch_queue_;
+
+  // Updated by the GRPCRouter threads as well as the exec thread.
+  std::atomic<int64_t> queued_bytes_ = 0;
+  std::atomic<int64_t> queued_batches_ = 0;
+  std::atomic<int64_t> max_queued_bytes_ = 0;
+  std::atomic<int64_t> max_queued_batches_ = 0;
+  std::atomic<int64_t> enqueue_blocked_ns_ = 0;
+  std::atomic<int64_t> decode_ns_ = 0;
+
+  std::function<void()> on_pop_;
 
   std::unique_ptr<plan::GRPCSourceOperator> plan_node_;
   bool upstream_initiated_connection_ = false;
@@ -86,6 +86,53 @@ TEST_F(GRPCSourceNodeTest, basic) {
   EXPECT_FALSE(tester.node()->HasBatchesRemaining());
 }
 
+TEST_F(GRPCSourceNodeTest, bounded_queue) {
+  auto max_queued_bytes = FLAGS_carnot_grpc_source_max_queued_bytes;
+  FLAGS_carnot_grpc_source_max_queued_bytes = 1;
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<plan::Operator> plan_node = plan::GRPCSourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<GRPCSourceNode, plan::GRPCSourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  EXPECT_TRUE(tester.node()->HasCapacity());
+  int num_pops = 0;
+  tester.node()->set_on_pop([&num_pops] { ++num_pops; });
+
+  std::vector<types::Int64Value> data = {1, 2};
+  auto rb = RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>(data)
+                .get();
+  auto rb_wrapper = std::make_unique<carnotpb::TransferResultChunkRequest>();
+  EXPECT_OK(rb.ToProto(rb_wrapper->mutable_query_result()->mutable_row_batch()));
+  // A batch is always accepted, even if it is larger than the bound.
+  EXPECT_OK(tester.node()->EnqueueRowBatch(std::move(rb_wrapper)));
+  EXPECT_FALSE(tester.node()->HasCapacity());
+
+  EXPECT_EQ(0, num_pops);
+
+  tester.GenerateNextResult().ExpectRowBatch(rb);
+  EXPECT_TRUE(tester.node()->HasCapacity());
+  EXPECT_EQ(1, num_pops);
+  FLAGS_carnot_grpc_source_max_queued_bytes = max_queued_bytes;
+}
+
+TEST_F(GRPCSourceNodeTest, decode_error_fails_on_pop) {
+  auto op_proto = planpb::testutils::CreateTestGRPCSource1PB();
+  std::unique_ptr<plan::Operator> plan_node = plan::GRPCSourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<GRPCSourceNode, plan::GRPCSourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+
+  // Requests are decoded as they are enqueued, but the error is returned to the exec thread.
+  auto req = std::make_unique<carnotpb::TransferResultChunkRequest>();
+  req->mutable_query_result()->set_grpc_source_id(1);
+  EXPECT_OK(tester.node()->EnqueueRowBatch(std::move(req)));
+  EXPECT_TRUE(tester.node()->NextBatchReady());
+  EXPECT_NOT_OK(tester.node()->GenerateNext(exec_state_.get()));
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
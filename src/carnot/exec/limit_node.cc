@@ -19,6 +19,7 @@
 #include "src/carnot/exec/limit_node.h"
 
 #include <arrow/array.h>
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -26,6 +27,9 @@
 
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/shared/types/type_utils.h"
 
 namespace px {
 namespace carnot {
@@ -34,6 +38,17 @@ namespace exec {
 using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 
+namespace {
+// The number of input batches an ordered limit keeps around before copying its top rows out of
+// them, so that a few top rows don't hold on to a lot of batches.
+constexpr size_t kMaxTopKBatches = 16;
+// Ordered limits of more rows than this sort all of their input instead of keeping a heap of it,
+// which can spill to disk.
+constexpr int64_t kMaxTopKHeapRows = 4096;
+// The most rows per output batch of an ordered limit that sorts its input.
+constexpr int64_t kSortOutputBatchRows = 1024;
+}  // namespace
+
 std::string LimitNode::DebugStringImpl() {
   return absl::Substitute("Exec::LimitNode<$0>", plan_node_->DebugString());
 }
@@ -44,15 +59,182 @@ Status LimitNode::InitImpl(const plan::Operator& plan_node) {
   // copy the plan node to local object;
   plan_node_ = std::make_unique<plan::LimitOperator>(*limit_plan_node);
 
+  if (plan_node_->ordered()) {
+    if (input_descriptors_.size() != 1) {
+      return error::InvalidArgument("Limit operator expects a single input relation, got $0",
+                                    input_descriptors_.size());
+    }
+    const auto& input_descriptor = input_descriptors_[0];
+    for (size_t i = 0; i < input_descriptor.size(); ++i) {
+      input_types_.push_back(input_descriptor.type(i));
+    }
+    for (int64_t sort_col : plan_node_->sort_cols()) {
+      if (sort_col < 0 || sort_col >= static_cast<int64_t>(input_types_.size())) {
+        return error::InvalidArgument("Sort column $0 is out of bounds", sort_col);
+      }
+      sort_compare_fns_.push_back(RowSorter::GetCompareFn(input_types_[sort_col]));
+    }
+  }
   return Status::OK();
 }
 Status LimitNode::PrepareImpl(ExecState* /*exec_state*/) { return Status::OK(); }
 
 Status LimitNode::OpenImpl(ExecState* /*exec_state*/) { return Status::OK(); }
 
-Status LimitNode::CloseImpl(ExecState* /*exec_state*/) { return Status::OK(); }
+Status LimitNode::CloseImpl(ExecState* /*exec_state*/) {
+  topk_batches_.clear();
+  topk_heap_.clear();
+  sorter_.reset();
+  return Status::OK();
+}
+
+bool LimitNode::RowBefore(const TopKRow& a, const TopKRow& b) const {
+  const auto& a_cols = topk_batches_[a.batch_idx];
+  const auto& b_cols = topk_batches_[b.batch_idx];
+  for (const auto& [i, sort_col] : Enumerate(plan_node_->sort_cols())) {
+    int cmp = sort_compare_fns_[i](a_cols[sort_col].get(), a.row_idx, b_cols[sort_col].get(),
+                                   b.row_idx);
+    if (cmp != 0) {
+      return plan_node_->sort_ascending() ? cmp < 0 : cmp > 0;
+    }
+  }
+  return false;
+}
+
+std::vector<std::shared_ptr<arrow::Array>> LimitNode::GatherRows(
+    ExecState* exec_state, const std::vector<TopKRow>& rows) {
+  std::vector<std::shared_ptr<arrow::Array>> cols;
+  cols.reserve(input_types_.size());
+  for (const auto& [col_idx, dt] : Enumerate(input_types_)) {
+    auto wrapper = types::ColumnWrapper::Make(dt, 0);
+    wrapper->Reserve(rows.size());
+    for (const auto& row : rows) {
+      auto* arr = topk_batches_[row.batch_idx][col_idx].get();
+#define TYPE_CASE(_dt_) types::ExtractValueToColumnWrapper<_dt_>(wrapper.get(), arr, row.row_idx);
+      PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
+#undef TYPE_CASE
+    }
+    cols.push_back(wrapper->ConvertToArrow(exec_state->exec_mem_pool()));
+  }
+  return cols;
+}
+
+Status LimitNode::ConsumeOrdered(ExecState* exec_state, const RowBatch& rb) {
+  size_t record_limit = static_cast<size_t>(plan_node_->record_limit());
+  auto comp = [this](const TopKRow& a, const TopKRow& b) { return RowBefore(a, b); };
+
+  if (rb.num_rows() > 0 && record_limit > 0) {
+    topk_batches_.push_back(rb.columns());
+    size_t batch_idx = topk_batches_.size() - 1;
+    bool batch_used = false;
+    for (int64_t row_idx = 0; row_idx < rb.num_rows(); ++row_idx) {
+      TopKRow row{batch_idx, row_idx};
+      if (topk_heap_.size() < record_limit) {
+        topk_heap_.push_back(row);
+        std::push_heap(topk_heap_.begin(), topk_heap_.end(), comp);
+        batch_used = true;
+      } else if (RowBefore(row, topk_heap_.front())) {
+        std::pop_heap(topk_heap_.begin(), topk_heap_.end(), comp);
+        topk_heap_.back() = row;
+        std::push_heap(topk_heap_.begin(), topk_heap_.end(), comp);
+        batch_used = true;
+      }
+    }
+    if (!batch_used) {
+      topk_batches_.pop_back();
+    } else if (topk_batches_.size() > kMaxTopKBatches) {
+      // Copy the top rows into a single batch, so that the other batches can be released.
+      auto cols = GatherRows(exec_state, topk_heap_);
+      topk_batches_.clear();
+      topk_batches_.push_back(std::move(cols));
+      for (size_t i = 0; i < topk_heap_.size(); ++i) {
+        topk_heap_[i] = TopKRow{0, static_cast<int64_t>(i)};
+      }
+      std::make_heap(topk_heap_.begin(), topk_heap_.end(), comp);
+    }
+  }
+
+  if (!rb.eos() && !(plan_node_->per_window() && rb.eow())) {
+    return Status::OK();
+  }
+
+  std::sort_heap(topk_heap_.begin(), topk_heap_.end(), comp);
+  auto cols = GatherRows(exec_state, topk_heap_);
+  RowBatch output_rb(*output_descriptor_, topk_heap_.size());
+  for (int64_t input_col_idx : plan_node_->selected_cols()) {
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(cols[input_col_idx]));
+  }
+  output_rb.set_eow(true);
+  output_rb.set_eos(rb.eos());
+  topk_batches_.clear();
+  topk_heap_.clear();
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
+
+Status LimitNode::ConsumeSorted(ExecState* exec_state, const RowBatch& rb) {
+  if (sorter_ == nullptr) {
+    sorter_ = std::make_unique<RowSorter>(input_types_, plan_node_->sort_cols(),
+                                          plan_node_->sort_ascending(),
+                                          FLAGS_carnot_sort_memory_budget_bytes,
+                                          FLAGS_carnot_sort_spill_dir);
+  }
+  PL_RETURN_IF_ERROR(sorter_->Add(rb, exec_state->exec_mem_pool()));
+  if (!rb.eos() && !(plan_node_->per_window() && rb.eow())) {
+    return Status::OK();
+  }
+
+  auto send = [&](const RowSorter::Columns& cols, bool last) -> Status {
+    RowBatch output_rb(*output_descriptor_, cols[0]->length());
+    for (int64_t input_col_idx : plan_node_->selected_cols()) {
+      PL_RETURN_IF_ERROR(output_rb.AddColumn(cols[input_col_idx]));
+    }
+    output_rb.set_eow(last);
+    output_rb.set_eos(last && rb.eos());
+    return SendRowBatchToChildren(exec_state, output_rb);
+  };
+  // Each batch is held back until the next one comes out, so that the last one can end the window.
+  RowSorter::Columns pending;
+  PL_RETURN_IF_ERROR(sorter_->Merge(plan_node_->record_limit(), kSortOutputBatchRows,
+                                    exec_state->exec_mem_pool(),
+                                    [&](RowSorter::Columns cols) -> Status {
+                                      if (!pending.empty()) {
+                                        PL_RETURN_IF_ERROR(send(pending, false));
+                                      }
+                                      pending = std::move(cols);
+                                      return Status::OK();
+                                    }));
+  if (pending.empty()) {
+    pending = GatherRows(exec_state, {});
+  }
+  return send(pending, true);
+}
+
+Status LimitNode::ConsumePerWindow(ExecState* exec_state, const RowBatch& rb) {
+  int64_t num_rows = std::min(plan_node_->record_limit() - records_processed_, rb.num_rows());
+  // Once the window is full, only its end needs to be passed on.
+  if (num_rows == 0 && !rb.eow() && !rb.eos()) {
+    return Status::OK();
+  }
+  RowBatch output_rb(*output_descriptor_, num_rows);
+  for (int64_t input_col_idx : plan_node_->selected_cols()) {
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(rb.ColumnAt(input_col_idx)->Slice(0, num_rows)));
+  }
+  output_rb.set_eow(rb.eow());
+  output_rb.set_eos(rb.eos());
+  records_processed_ = rb.eow() ? 0 : records_processed_ + num_rows;
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
 
 Status LimitNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
+  if (plan_node_->ordered()) {
+    if (plan_node_->record_limit() > kMaxTopKHeapRows) {
+      return ConsumeSorted(exec_state, rb);
+    }
+    return ConsumeOrdered(exec_state, rb);
+  }
+  if (plan_node_->per_window()) {
+    return ConsumePerWindow(exec_state, rb);
+  }
   int64_t record_limit = plan_node_->record_limit();
   // We need to send over a slice of the input data.
   int64_t remainder_records = record_limit - records_processed_;
@@ -23,9 +23,12 @@
 #include <string>
 #include <vector>
 
+#include <arrow/array.h>
+
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/row_sorter.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
@@ -50,8 +53,36 @@ class LimitNode : public ProcessingNode {
                          size_t parent_index) override;
 
  private:
+  // A row of one of the batches kept by an ordered limit.
+  struct TopKRow {
+    size_t batch_idx;
+    int64_t row_idx;
+  };
+  Status ConsumeOrdered(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Consumes the input of an ordered limit that keeps too many rows for a heap, by sorting all of
+  // it.
+  Status ConsumeSorted(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Consumes the input of a limit that restarts its count at every eow.
+  Status ConsumePerWindow(ExecState* exec_state, const table_store::schema::RowBatch& rb);
+  // Whether row a comes before row b in the output of an ordered limit.
+  bool RowBefore(const TopKRow& a, const TopKRow& b) const;
+  // Copies the given rows of the kept batches into new arrays, one per input column.
+  std::vector<std::shared_ptr<arrow::Array>> GatherRows(ExecState* exec_state,
+                                                        const std::vector<TopKRow>& rows);
+
   size_t records_processed_ = 0;
   std::unique_ptr<plan::LimitOperator> plan_node_;
+
+  // Variables specific to ordered limits (top-k).
+  std::vector<RowSorter::CompareFn> sort_compare_fns_;
+  std::vector<types::DataType> input_types_;
+  // The columns of the input batches that hold at least one of the current top rows.
+  std::vector<std::vector<std::shared_ptr<arrow::Array>>> topk_batches_;
+  // A heap of (at most) limit rows, where the front is the row that comes last in the output.
+  std::vector<TopKRow> topk_heap_;
+  // Sorts the input of ordered limits of more than kMaxTopKHeapRows rows.
+  std::unique_ptr<RowSorter> sorter_;
+  // END: Variables specific to ordered limits.
 };
 
 }  // namespace exec
@@ -236,6 +236,146 @@ TEST_F(LimitNodeTest, drop_input_columns_fewer_than_limit) {
       .Close();
 }
 
+TEST_F(LimitNodeTest, per_window_limit) {
+  auto op_proto = planpb::testutils::CreateTestLimit1PB();
+  op_proto.mutable_limit_op()->set_per_window(true);
+  auto limit = plan::LimitOperator::FromProto(op_proto, 1);
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<LimitNode, plan::LimitOperator>(*limit, output_rd, {input_rd},
+                                                                     exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 6, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                       .AddColumn<types::Int64Value>({1, 3, 6, 9, 12, 15})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, false, false)
+                          .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                          .AddColumn<types::Int64Value>({1, 3, 6, 9, 12, 15})
+                          .get())
+      .ConsumeNext(RowBatchBuilder(input_rd, 6, /*eow*/ true, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                       .AddColumn<types::Int64Value>({1, 4, 6, 8, 10, 12})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, false)
+                          .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                          .AddColumn<types::Int64Value>({1, 4, 6, 8})
+                          .get())
+      // The eow restarts the count for the next window.
+      .ConsumeNext(RowBatchBuilder(input_rd, 6, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                       .AddColumn<types::Int64Value>({1, 3, 6, 9, 12, 15})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6})
+                          .AddColumn<types::Int64Value>({1, 3, 6, 9, 12, 15})
+                          .get())
+      .Close();
+}
+
+TEST_F(LimitNodeTest, ordered_limit) {
+  auto op_proto = planpb::testutils::CreateTestTopKLimit1PB();
+  auto topk = plan::LimitOperator::FromProto(op_proto, 1);
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<LimitNode, plan::LimitOperator>(*topk, output_rd, {input_rd},
+                                                                     exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .AddColumn<types::Int64Value>({5, 1, 9, 3})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({5, 6, 7})
+                       .AddColumn<types::Int64Value>({7, 2, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({3, 7, 5})
+                          .AddColumn<types::Int64Value>({9, 8, 7})
+                          .get())
+      .Close();
+}
+
+TEST_F(LimitNodeTest, ordered_limit_many_batches) {
+  auto op_proto = planpb::testutils::CreateTestTopKLimit1PB();
+  op_proto.mutable_limit_op()->set_sort_ascending(true);
+  auto topk = plan::LimitOperator::FromProto(op_proto, 1);
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<LimitNode, plan::LimitOperator>(*topk, output_rd, {input_rd},
+                                                                     exec_state_.get());
+  // Enough batches with new top rows that the limit has to compact the rows it keeps.
+  for (int64_t i = 40; i > 0; --i) {
+    tester.ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                           .AddColumn<types::Int64Value>({i, -i})
+                           .AddColumn<types::Int64Value>({i, 100 + i})
+                           .get(),
+                       0, 0);
+  }
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 0, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({})
+                       .AddColumn<types::Int64Value>({})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 3, true, true)
+                          .AddColumn<types::Int64Value>({1, 2, 3})
+                          .AddColumn<types::Int64Value>({1, 2, 3})
+                          .get())
+      .Close();
+}
+
+TEST_F(LimitNodeTest, ordered_limit_sorts_input) {
+  auto op_proto = planpb::testutils::CreateTestTopKLimit1PB();
+  // Too many rows for a heap, so the limit sorts all of its input.
+  op_proto.mutable_limit_op()->set_limit(100000);
+  op_proto.mutable_limit_op()->set_per_window(true);
+  auto limit = plan::LimitOperator::FromProto(op_proto, 1);
+
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64, types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<LimitNode, plan::LimitOperator>(*limit, output_rd, {input_rd},
+                                                                     exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .AddColumn<types::Int64Value>({5, 1, 9, 3})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd, 3, /*eow*/ true, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({5, 6, 7})
+                       .AddColumn<types::Int64Value>({7, 3, 8})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 7, true, false)
+                          .AddColumn<types::Int64Value>({3, 7, 5, 1, 4, 6, 2})
+                          .AddColumn<types::Int64Value>({9, 8, 7, 5, 3, 3, 1})
+                          .get())
+      // The next window is sorted on its own.
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({8, 9})
+                       .AddColumn<types::Int64Value>({1, 2})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 2, true, true)
+                          .AddColumn<types::Int64Value>({9, 8})
+                          .AddColumn<types::Int64Value>({2, 1})
+                          .get())
+      .Close();
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
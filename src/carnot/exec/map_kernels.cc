@@ -0,0 +1,374 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "src/carnot/exec/map_kernels.h"
+
+#include <arrow/builder.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+namespace {
+
+// The number of rows an expression is evaluated over at a time. Small enough for the
+// intermediate values of an expression to stay in the L1/L2 cache.
+constexpr int64_t kNumericBlockRows = 1024;
+
+const absl::flat_hash_map<std::string, NumericStep::Kind>& ArithmeticKinds() {
+  static const auto* const kArithmeticKinds =
+      new absl::flat_hash_map<std::string, NumericStep::Kind>({
+          {"add", NumericStep::Kind::kAdd},
+          {"subtract", NumericStep::Kind::kSubtract},
+          {"multiply", NumericStep::Kind::kMultiply},
+          {"divide", NumericStep::Kind::kDivide},
+      });
+  return *kArithmeticKinds;
+}
+
+bool IsNumericType(types::DataType data_type) {
+  return data_type == types::INT64 || data_type == types::TIME64NS ||
+         data_type == types::FLOAT64;
+}
+
+// Appends the steps of expr to steps. Sets is_float to whether expr produces FLOAT64 values.
+bool CompileNumeric(const plan::ScalarExpression& expr, const RowDescriptor& input_desc,
+                    std::vector<NumericStep>* steps, bool* is_float) {
+  NumericStep step;
+  switch (expr.ExpressionType()) {
+    case plan::Expression::kColumn: {
+      const auto& col = static_cast<const plan::Column&>(expr);
+      if (col.Index() < 0 || col.Index() >= static_cast<int64_t>(input_desc.size()) ||
+          !IsNumericType(input_desc.type(col.Index()))) {
+        return false;
+      }
+      step.kind = NumericStep::Kind::kColumn;
+      step.col_idx = col.Index();
+      step.is_float = input_desc.type(col.Index()) == types::FLOAT64;
+      break;
+    }
+    case plan::Expression::kConstant: {
+      const auto& val = static_cast<const plan::ScalarValue&>(expr);
+      if (val.IsNull() || !IsNumericType(val.DataType())) {
+        return false;
+      }
+      step.kind = NumericStep::Kind::kConstant;
+      step.is_float = val.DataType() == types::FLOAT64;
+      if (val.DataType() == types::FLOAT64) {
+        step.float_value = val.Float64Value();
+      } else if (val.DataType() == types::TIME64NS) {
+        step.int_value = val.Time64NSValue();
+      } else {
+        step.int_value = val.Int64Value();
+      }
+      break;
+    }
+    case plan::Expression::kFunc: {
+      const auto& func = static_cast<const plan::ScalarFunc&>(expr);
+      auto it = ArithmeticKinds().find(func.name());
+      const auto& args = func.arg_deps();
+      const auto& arg_types = func.registry_arg_types();
+      if (it == ArithmeticKinds().end() || args.size() != 2 || arg_types.size() != 2 ||
+          !func.init_arguments().empty()) {
+        return false;
+      }
+      for (const auto& [arg_idx, arg] : Enumerate(args)) {
+        bool arg_is_float;
+        if (!CompileNumeric(*arg, input_desc, steps, &arg_is_float) ||
+            arg_is_float != (arg_types[arg_idx] == types::FLOAT64)) {
+          return false;
+        }
+        step.is_float |= arg_is_float;
+      }
+      step.kind = it->second;
+      // The builtin divide always returns FLOAT64.
+      step.is_float |= step.kind == NumericStep::Kind::kDivide;
+      break;
+    }
+    default:
+      return false;
+  }
+  steps->push_back(step);
+  *is_float = step.is_float;
+  return true;
+}
+
+// A value on the evaluation stack: either a block of values or a single value for every row.
+struct Operand {
+  bool is_float = false;
+  bool is_scalar = false;
+  const int64_t* ints = nullptr;
+  const double* floats = nullptr;
+  int64_t int_scalar = 0;
+  double float_scalar = 0;
+};
+
+template <typename TOut, typename TOp, typename TA, typename TB>
+void BinaryLoop(const TA* __restrict__ a, TA a_scalar, bool a_is_scalar, const TB* __restrict__ b,
+                TB b_scalar, bool b_is_scalar, int64_t num_rows, TOut* __restrict__ out) {
+  TOp op;
+  if (a_is_scalar) {
+    TOut a_val = static_cast<TOut>(a_scalar);
+    for (int64_t i = 0; i < num_rows; ++i) {
+      out[i] = op(a_val, static_cast<TOut>(b[i]));
+    }
+  } else if (b_is_scalar) {
+    TOut b_val = static_cast<TOut>(b_scalar);
+    for (int64_t i = 0; i < num_rows; ++i) {
+      out[i] = op(static_cast<TOut>(a[i]), b_val);
+    }
+  } else {
+    for (int64_t i = 0; i < num_rows; ++i) {
+      out[i] = op(static_cast<TOut>(a[i]), static_cast<TOut>(b[i]));
+    }
+  }
+}
+
+template <typename TOut, typename TOp, typename TA>
+void BinaryLoopB(const TA* a, TA a_scalar, const Operand& lhs, const Operand& rhs,
+                 int64_t num_rows, TOut* out) {
+  if (rhs.is_float) {
+    BinaryLoop<TOut, TOp>(a, a_scalar, lhs.is_scalar, rhs.floats, rhs.float_scalar, rhs.is_scalar,
+                          num_rows, out);
+  } else {
+    BinaryLoop<TOut, TOp>(a, a_scalar, lhs.is_scalar, rhs.ints, rhs.int_scalar, rhs.is_scalar,
+                          num_rows, out);
+  }
+}
+
+template <typename TOut, typename TOp>
+void ApplyTyped(const Operand& lhs, const Operand& rhs, int64_t num_rows, TOut* out) {
+  if (lhs.is_float) {
+    BinaryLoopB<TOut, TOp>(lhs.floats, lhs.float_scalar, lhs, rhs, num_rows, out);
+  } else {
+    BinaryLoopB<TOut, TOp>(lhs.ints, lhs.int_scalar, lhs, rhs, num_rows, out);
+  }
+}
+
+template <typename TOut>
+void Apply(NumericStep::Kind kind, const Operand& lhs, const Operand& rhs, int64_t num_rows,
+           TOut* out) {
+  switch (kind) {
+    case NumericStep::Kind::kAdd:
+      return ApplyTyped<TOut, std::plus<TOut>>(lhs, rhs, num_rows, out);
+    case NumericStep::Kind::kSubtract:
+      return ApplyTyped<TOut, std::minus<TOut>>(lhs, rhs, num_rows, out);
+    case NumericStep::Kind::kMultiply:
+      return ApplyTyped<TOut, std::multiplies<TOut>>(lhs, rhs, num_rows, out);
+    case NumericStep::Kind::kDivide:
+      return ApplyTyped<TOut, std::divides<TOut>>(lhs, rhs, num_rows, out);
+    default:
+      DCHECK(false) << "Not an arithmetic step";
+  }
+}
+
+// Evaluates the steps over rows [offset, offset + num_rows) of rb into int_out or float_out,
+// depending on the type of the expression. The buffers hold the intermediate values of the steps.
+void EvaluateBlock(const std::vector<NumericStep>& steps,
+                   const std::vector<const arrow::Array*>& columns, int64_t offset,
+                   int64_t num_rows, std::vector<std::vector<int64_t>>* int_buffers,
+                   std::vector<std::vector<double>>* float_buffers, std::vector<Operand>* stack,
+                   int64_t* int_out, double* float_out) {
+  stack->clear();
+  for (const auto& [step_idx, step] : Enumerate(steps)) {
+    Operand result;
+    result.is_float = step.is_float;
+    switch (step.kind) {
+      case NumericStep::Kind::kColumn:
+        if (step.is_float) {
+          result.floats =
+              static_cast<const arrow::DoubleArray*>(columns[step.col_idx])->raw_values() + offset;
+        } else {
+          result.ints =
+              static_cast<const arrow::Int64Array*>(columns[step.col_idx])->raw_values() + offset;
+        }
+        break;
+      case NumericStep::Kind::kConstant:
+        result.is_scalar = true;
+        result.int_scalar = step.int_value;
+        result.float_scalar = step.float_value;
+        break;
+      default: {
+        Operand rhs = stack->back();
+        stack->pop_back();
+        Operand lhs = stack->back();
+        stack->pop_back();
+        int64_t rows = num_rows;
+        if (lhs.is_scalar && rhs.is_scalar) {
+          // Compute the single value, by treating the scalars as blocks of one row.
+          lhs.is_scalar = false;
+          lhs.ints = &lhs.int_scalar;
+          lhs.floats = &lhs.float_scalar;
+          rhs.is_scalar = false;
+          rhs.ints = &rhs.int_scalar;
+          rhs.floats = &rhs.float_scalar;
+          result.is_scalar = true;
+          rows = 1;
+        }
+        // The last step writes straight into the output.
+        bool is_last = step_idx == steps.size() - 1;
+        if (step.is_float) {
+          double* out = result.is_scalar ? &result.float_scalar
+                        : is_last        ? float_out
+                                         : (*float_buffers)[step_idx].data();
+          Apply<double>(step.kind, lhs, rhs, rows, out);
+          result.floats = out;
+        } else {
+          int64_t* out = result.is_scalar ? &result.int_scalar
+                         : is_last        ? int_out
+                                          : (*int_buffers)[step_idx].data();
+          Apply<int64_t>(step.kind, lhs, rhs, rows, out);
+          result.ints = out;
+        }
+        break;
+      }
+    }
+    stack->push_back(result);
+  }
+
+  const Operand& result = stack->back();
+  if (result.is_float) {
+    if (result.is_scalar) {
+      std::fill(float_out, float_out + num_rows, result.float_scalar);
+    } else if (result.floats != float_out) {
+      std::copy(result.floats, result.floats + num_rows, float_out);
+    }
+  } else {
+    if (result.is_scalar) {
+      std::fill(int_out, int_out + num_rows, result.int_scalar);
+    } else if (result.ints != int_out) {
+      std::copy(result.ints, result.ints + num_rows, int_out);
+    }
+  }
+}
+
+template <typename TBuilder, typename T>
+Status FinishNumericColumn(TBuilder* builder, std::vector<T>* values, RowBatch* output) {
+  PL_RETURN_IF_ERROR(builder->AppendValues(values->data(), values->size()));
+  std::shared_ptr<arrow::Array> arr;
+  PL_RETURN_IF_ERROR(builder->Finish(&arr));
+  return output->AddColumn(arr);
+}
+
+}  // namespace
+
+bool CompileNumericExpressions(const plan::ConstScalarExpressionVector& exprs,
+                               const RowDescriptor& input_desc, const RowDescriptor& output_desc,
+                               std::vector<NumericExpression>* compiled) {
+  if (exprs.size() != output_desc.size()) {
+    return false;
+  }
+  compiled->clear();
+  for (const auto& [expr_idx, expr] : Enumerate(exprs)) {
+    NumericExpression numeric_expr;
+    numeric_expr.output_type = output_desc.type(expr_idx);
+    if (expr->ExpressionType() == plan::Expression::kColumn) {
+      const auto* col = static_cast<const plan::Column*>(expr.get());
+      if (col->Index() < 0 || col->Index() >= static_cast<int64_t>(input_desc.size()) ||
+          input_desc.type(col->Index()) != numeric_expr.output_type) {
+        return false;
+      }
+      numeric_expr.forward_col_idx = col->Index();
+      compiled->push_back(std::move(numeric_expr));
+      continue;
+    }
+    bool is_float;
+    if (!IsNumericType(numeric_expr.output_type) ||
+        !CompileNumeric(*expr, input_desc, &numeric_expr.steps, &is_float) ||
+        is_float != (numeric_expr.output_type == types::FLOAT64)) {
+      return false;
+    }
+    compiled->push_back(std::move(numeric_expr));
+  }
+  return true;
+}
+
+Status EvaluateNumericExpressions(const std::vector<NumericExpression>& exprs, const RowBatch& rb,
+                                  arrow::MemoryPool* mem_pool, RowBatch* output) {
+  int64_t num_rows = rb.num_rows();
+  std::vector<const arrow::Array*> columns(rb.num_columns(), nullptr);
+  std::vector<std::shared_ptr<arrow::Array>> column_refs(rb.num_columns());
+  std::vector<std::vector<int64_t>> int_buffers;
+  std::vector<std::vector<double>> float_buffers;
+  std::vector<Operand> stack;
+
+  for (const auto& expr : exprs) {
+    if (expr.forward_col_idx != -1) {
+      PL_RETURN_IF_ERROR(output->AddColumn(rb.ColumnAt(expr.forward_col_idx)));
+      continue;
+    }
+    for (const auto& step : expr.steps) {
+      if (step.kind != NumericStep::Kind::kColumn || columns[step.col_idx] != nullptr) {
+        continue;
+      }
+      column_refs[step.col_idx] = rb.ColumnAt(step.col_idx);
+      if (column_refs[step.col_idx]->length() != num_rows) {
+        return error::Internal("Column $0 has $1 rows, expected $2", step.col_idx,
+                               column_refs[step.col_idx]->length(), num_rows);
+      }
+      columns[step.col_idx] = column_refs[step.col_idx].get();
+    }
+    int_buffers.resize(std::max(int_buffers.size(), expr.steps.size()));
+    float_buffers.resize(std::max(float_buffers.size(), expr.steps.size()));
+    for (const auto& [step_idx, step] : Enumerate(expr.steps)) {
+      if (step.is_float) {
+        float_buffers[step_idx].resize(kNumericBlockRows);
+      } else {
+        int_buffers[step_idx].resize(kNumericBlockRows);
+      }
+    }
+
+    bool is_float = expr.output_type == types::FLOAT64;
+    std::vector<int64_t> int_values(is_float ? 0 : num_rows);
+    std::vector<double> float_values(is_float ? num_rows : 0);
+    for (int64_t offset = 0; offset < num_rows; offset += kNumericBlockRows) {
+      int64_t block_rows = std::min(kNumericBlockRows, num_rows - offset);
+      EvaluateBlock(expr.steps, columns, offset, block_rows, &int_buffers, &float_buffers, &stack,
+                    is_float ? nullptr : int_values.data() + offset,
+                    is_float ? float_values.data() + offset : nullptr);
+    }
+
+    if (is_float) {
+      arrow::DoubleBuilder builder(mem_pool);
+      PL_RETURN_IF_ERROR(FinishNumericColumn(&builder, &float_values, output));
+    } else {
+      arrow::Int64Builder builder(mem_pool);
+      PL_RETURN_IF_ERROR(FinishNumericColumn(&builder, &int_values, output));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
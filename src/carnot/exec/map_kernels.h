@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "src/carnot/plan/scalar_expression.h"
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/schema/row_batch.h"
+#include "src/table_store/schema/row_descriptor.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * A step of a compiled numeric expression. The steps run in postfix order: columns and constants
+ * push a value, and the arithmetic steps pop two values and push their result.
+ */
+struct NumericStep {
+  enum class Kind {
+    kColumn,
+    kConstant,
+    kAdd,
+    kSubtract,
+    kMultiply,
+    kDivide,
+  };
+  Kind kind;
+  // Whether the step produces FLOAT64 values. Otherwise it produces INT64 or TIME64NS values.
+  bool is_float = false;
+  // Only set for kColumn.
+  int64_t col_idx = -1;
+  // Only set for kConstant, int_value if !is_float and float_value otherwise.
+  int64_t int_value = 0;
+  double float_value = 0;
+};
+
+/**
+ * A map expression compiled by CompileNumericExpressions.
+ */
+struct NumericExpression {
+  // Set if the expression just forwards an input column. steps is empty in that case.
+  int64_t forward_col_idx = -1;
+  types::DataType output_type;
+  std::vector<NumericStep> steps;
+};
+
+/**
+ * Tries to compile map expressions into arithmetic that can be evaluated by
+ * EvaluateNumericExpressions without going through the UDF machinery. Only input columns and
+ * trees of the builtin add, subtract, multiply and divide functions over INT64, TIME64NS and
+ * FLOAT64 columns and constants are supported.
+ *
+ * @return true if every expression was compiled.
+ */
+bool CompileNumericExpressions(const plan::ConstScalarExpressionVector& exprs,
+                               const table_store::schema::RowDescriptor& input_desc,
+                               const table_store::schema::RowDescriptor& output_desc,
+                               std::vector<NumericExpression>* compiled);
+
+/**
+ * Evaluates the expressions over rb, adding one column per expression to output. The expression
+ * is evaluated over blocks of rows, so the intermediate values of an expression stay in cache
+ * instead of being materialized as columns, and the loops over a block are written so the
+ * compiler can vectorize them.
+ */
+Status EvaluateNumericExpressions(const std::vector<NumericExpression>& exprs,
+                                  const table_store::schema::RowBatch& rb,
+                                  arrow::MemoryPool* mem_pool,
+                                  table_store::schema::RowBatch* output);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "src/carnot/exec/map_kernels.h"
+
+#include <memory>
+#include <vector>
+
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/planpb/test_proto.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+namespace {
+
+std::shared_ptr<const plan::ScalarExpression> ParseExpression(const char* pbtxt) {
+  planpb::ScalarExpression pb;
+  CHECK(google::protobuf::TextFormat::MergeFromString(pbtxt, &pb));
+  return plan::ScalarExpression::FromProto(pb).ConsumeValueOrDie();
+}
+
+// (col0 - 10) / (col1 * 2), where col0 is INT64 and col1 is FLOAT64.
+constexpr char kLatencyRatioPbtxt[] = R"(
+func {
+  name: "divide"
+  args {
+    func {
+      name: "subtract"
+      args {
+        column {
+          node: 0
+          index: 0
+        }
+      }
+      args {
+        constant {
+          data_type: INT64,
+          int64_value: 10
+        }
+      }
+      args_data_types: INT64
+      args_data_types: INT64
+    }
+  }
+  args {
+    func {
+      name: "multiply"
+      args {
+        column {
+          node: 0
+          index: 1
+        }
+      }
+      args {
+        constant {
+          data_type: INT64,
+          int64_value: 2
+        }
+      }
+      args_data_types: FLOAT64
+      args_data_types: INT64
+    }
+  }
+  args_data_types: INT64
+  args_data_types: FLOAT64
+})";
+
+constexpr char kConstantSumPbtxt[] = R"(
+func {
+  name: "add"
+  args {
+    constant {
+      data_type: INT64,
+      int64_value: 1
+    }
+  }
+  args {
+    constant {
+      data_type: INT64,
+      int64_value: 2
+    }
+  }
+  args_data_types: INT64
+  args_data_types: INT64
+})";
+
+constexpr char kColumn2Pbtxt[] = R"(
+column {
+  node: 0
+  index: 2
+})";
+
+}  // namespace
+
+TEST(MapKernelsTest, compile_and_evaluate) {
+  RowDescriptor input_rd(
+      {types::DataType::INT64, types::DataType::FLOAT64, types::DataType::STRING});
+  RowDescriptor output_rd(
+      {types::DataType::FLOAT64, types::DataType::INT64, types::DataType::STRING});
+  plan::ConstScalarExpressionVector exprs = {ParseExpression(kLatencyRatioPbtxt),
+                                             ParseExpression(kConstantSumPbtxt),
+                                             ParseExpression(kColumn2Pbtxt)};
+  std::vector<NumericExpression> compiled;
+  ASSERT_TRUE(CompileNumericExpressions(exprs, input_rd, output_rd, &compiled));
+  ASSERT_EQ(3, compiled.size());
+  EXPECT_EQ(7, compiled[0].steps.size());
+  EXPECT_EQ(-1, compiled[0].forward_col_idx);
+  EXPECT_EQ(2, compiled[2].forward_col_idx);
+
+  // More rows than a block, so that the expressions are evaluated over several blocks.
+  int64_t num_rows = 3000;
+  std::vector<types::Int64Value> col0;
+  std::vector<types::Float64Value> col1;
+  std::vector<types::StringValue> col2;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    col0.push_back(i);
+    col1.push_back(0.5 + i);
+    col2.push_back(std::to_string(i));
+  }
+  auto input = RowBatchBuilder(input_rd, num_rows, /*eow*/ false, /*eos*/ false)
+                   .AddColumn<types::Int64Value>(col0)
+                   .AddColumn<types::Float64Value>(col1)
+                   .AddColumn<types::StringValue>(col2)
+                   .get();
+
+  RowBatch output(output_rd, num_rows);
+  ASSERT_OK(
+      EvaluateNumericExpressions(compiled, input, arrow::default_memory_pool(), &output));
+  ASSERT_EQ(3, output.num_columns());
+  for (int64_t i = 0; i < num_rows; i += 999) {
+    EXPECT_DOUBLE_EQ((i - 10) / ((0.5 + i) * 2),
+                     types::GetValueFromArrowArray<types::FLOAT64>(output.ColumnAt(0).get(), i));
+    EXPECT_EQ(3, types::GetValueFromArrowArray<types::INT64>(output.ColumnAt(1).get(), i));
+  }
+  // Forwarded columns aren't copied.
+  EXPECT_EQ(input.ColumnAt(2), output.ColumnAt(2));
+}
+
+TEST(MapKernelsTest, compile_unsupported) {
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  std::vector<NumericExpression> compiled;
+
+  // Comparisons aren't arithmetic.
+  plan::ConstScalarExpressionVector eq = {
+      ParseExpression(planpb::testutils::kEq1ScalarFuncConstPbtxt)};
+  EXPECT_FALSE(CompileNumericExpressions(eq, input_rd, RowDescriptor({types::DataType::BOOLEAN}),
+                                         &compiled));
+
+  // The output type has to match the arithmetic.
+  plan::ConstScalarExpressionVector add = {ParseExpression(planpb::testutils::kAddScalarFuncPbtxt)};
+  EXPECT_FALSE(CompileNumericExpressions(add, input_rd, RowDescriptor({types::DataType::FLOAT64}),
+                                         &compiled));
+  EXPECT_TRUE(CompileNumericExpressions(add, input_rd, RowDescriptor({types::DataType::INT64}),
+                                        &compiled));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -18,14 +18,21 @@
 
 #include "src/carnot/exec/map_node.h"
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <absl/strings/str_join.h>
 #include <absl/strings/substitute.h>
 
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/base.h"
 
+DEFINE_bool(carnot_map_numeric_kernels, true,
+            "Evaluate maps whose expressions are arithmetic over numeric columns and constants "
+            "with vectorized kernels instead of the scalar UDFs.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -34,6 +41,13 @@ using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 
 std::string MapNode::DebugStringImpl() {
+  if (evaluator_ == nullptr) {
+    std::vector<std::string> exprs;
+    for (const auto& expr : plan_node_->expressions()) {
+      exprs.push_back(expr->DebugString());
+    }
+    return absl::Substitute("Exec::MapNode<$0>", absl::StrJoin(exprs, ","));
+  }
   return absl::Substitute("Exec::MapNode<$0>", evaluator_->DebugString());
 }
 
@@ -45,25 +59,95 @@ Status MapNode::InitImpl(const plan::Operator& plan_node) {
   return Status::OK();
 }
 Status MapNode::PrepareImpl(ExecState* exec_state) {
+  // Arithmetic over numeric columns is evaluated directly on the arrow buffers, and doesn't need
+  // the UDF based evaluators.
+  if (FLAGS_carnot_map_numeric_kernels && input_descriptors_.size() == 1 &&
+      CompileNumericExpressions(plan_node_->expressions(), input_descriptors_[0],
+                                *output_descriptor_, &numeric_exprs_)) {
+    return Status::OK();
+  }
+  numeric_exprs_.clear();
+
   function_ctx_ = exec_state->CreateFunctionContext();
   evaluator_ = ScalarExpressionEvaluator::Create(
       plan_node_->expressions(), ScalarExpressionEvaluatorType::kArrowNative, function_ctx_.get());
+
+  auto morsel_executor = exec_state->morsel_executor();
+  if (morsel_executor != nullptr) {
+    for (int i = 0; i < morsel_executor->num_workers(); ++i) {
+      worker_function_ctxs_.push_back(exec_state->CreateFunctionContext());
+      worker_evaluators_.push_back(ScalarExpressionEvaluator::Create(
+          plan_node_->expressions(), ScalarExpressionEvaluatorType::kArrowNative,
+          worker_function_ctxs_.back().get()));
+    }
+  }
   return Status::OK();
 }
 
 Status MapNode::OpenImpl(ExecState* exec_state) {
+  if (evaluator_ == nullptr) {
+    return Status::OK();
+  }
   PL_RETURN_IF_ERROR(evaluator_->Open(exec_state));
+  for (auto& evaluator : worker_evaluators_) {
+    PL_RETURN_IF_ERROR(evaluator->Open(exec_state));
+  }
   return Status::OK();
 }
 
 Status MapNode::CloseImpl(ExecState* exec_state) {
   stats()->AddExtraInfo("expressions", DebugString());
+  if (evaluator_ == nullptr) {
+    stats()->AddExtraInfo("numeric_kernels", "true");
+    return Status::OK();
+  }
   PL_RETURN_IF_ERROR(evaluator_->Close(exec_state));
+  for (auto& evaluator : worker_evaluators_) {
+    PL_RETURN_IF_ERROR(evaluator->Close(exec_state));
+  }
   return Status::OK();
 }
+
+Status MapNode::ConsumeNextParallel(ExecState* exec_state, const RowBatch& rb,
+                                    RowBatch* output_rb) {
+  auto morsel_executor = exec_state->morsel_executor();
+  PL_ASSIGN_OR_RETURN(auto morsels, SplitIntoMorsels(rb, morsel_executor->morsel_size_rows()));
+  std::vector<std::unique_ptr<RowBatch>> outputs(morsels.size());
+  PL_RETURN_IF_ERROR(morsel_executor->ParallelFor(
+      morsels.size(), [&](int64_t morsel_idx, int worker_idx) -> Status {
+        const auto& morsel = morsels[morsel_idx];
+        auto output = std::make_unique<RowBatch>(*output_descriptor_, morsel->num_rows());
+        if (!numeric_exprs_.empty()) {
+          PL_RETURN_IF_ERROR(EvaluateNumericExpressions(
+              numeric_exprs_, *morsel, exec_state->exec_mem_pool(), output.get()));
+        } else {
+          PL_RETURN_IF_ERROR(
+              worker_evaluators_[worker_idx]->Evaluate(exec_state, *morsel, output.get()));
+        }
+        outputs[morsel_idx] = std::move(output);
+        return Status::OK();
+      }));
+  PL_ASSIGN_OR_RETURN(auto concatenated, ConcatenateMorsels(*output_descriptor_, outputs,
+                                                            exec_state->exec_mem_pool()));
+  for (const auto& col : concatenated->columns()) {
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(col));
+  }
+  return Status::OK();
+}
+
 Status MapNode::ConsumeNextImpl(ExecState* exec_state, const RowBatch& rb, size_t) {
   RowBatch output_rb(*output_descriptor_, rb.num_rows());
-  PL_RETURN_IF_ERROR(evaluator_->Evaluate(exec_state, rb, &output_rb));
+  auto morsel_executor = exec_state->morsel_executor();
+  bool parallel = !numeric_exprs_.empty() || !worker_evaluators_.empty();
+  if (parallel && morsel_executor != nullptr &&
+      rb.num_rows() > morsel_executor->morsel_size_rows()) {
+    PL_RETURN_IF_ERROR(ConsumeNextParallel(exec_state, rb, &output_rb));
+  } else if (!numeric_exprs_.empty()) {
+    PL_RETURN_IF_ERROR(
+        EvaluateNumericExpressions(numeric_exprs_, rb, exec_state->exec_mem_pool(), &output_rb));
+  } else {
+    PL_RETURN_IF_ERROR(evaluator_->Evaluate(exec_state, rb, &output_rb));
+  }
   output_rb.set_eow(rb.eow());
   output_rb.set_eos(rb.eos());
   PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, output_rb));
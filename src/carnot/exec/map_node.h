@@ -26,6 +26,7 @@
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
 #include "src/carnot/exec/expression_evaluator.h"
+#include "src/carnot/exec/map_kernels.h"
 #include "src/carnot/plan/operators.h"
 #include "src/carnot/udf/base.h"
 #include "src/common/base/base.h"
@@ -51,9 +52,20 @@ class MapNode : public ProcessingNode {
                          size_t parent_index) override;
 
  private:
+  Status ConsumeNextParallel(ExecState* exec_state, const table_store::schema::RowBatch& rb,
+                             table_store::schema::RowBatch* output_rb);
+
+  // Set if the expressions were compiled into numeric kernels, in which case there are no
+  // evaluators.
+  std::vector<NumericExpression> numeric_exprs_;
   std::unique_ptr<ExpressionEvaluator> evaluator_;
   std::unique_ptr<plan::MapOperator> plan_node_;
   std::unique_ptr<udf::FunctionContext> function_ctx_;
+
+  // Per-worker evaluators used when the query runs with a MorselExecutor. Each worker gets its own
+  // evaluator (and UDF instances) so that no UDF state is shared across threads.
+  std::vector<std::unique_ptr<ExpressionEvaluator>> worker_evaluators_;
+  std::vector<std::unique_ptr<udf::FunctionContext>> worker_function_ctxs_;
 };
 
 }  // namespace exec
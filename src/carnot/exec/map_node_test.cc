@@ -130,6 +130,44 @@ TEST_F(MapNodeTest, zero_row_row_batch) {
       .Close();
 }
 
+TEST_F(MapNodeTest, parallel_morsels) {
+  exec_state_->EnableParallelExecution(/* num_workers */ 3, /* morsel_size_rows */ 2);
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  auto tester = exec::ExecNodeTester<MapNode, plan::MapOperator>(*plan_node_, output_rd, {},
+                                                                 exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 7, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4, 5, 6, 7})
+                       .AddColumn<types::Int64Value>({1, 3, 6, 9, 10, 11, 12})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 7, true, true)
+                          .AddColumn<types::Int64Value>({2, 5, 9, 13, 15, 17, 19})
+                          .get())
+      .Close();
+}
+
+TEST_F(MapNodeTest, numeric_kernels) {
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
+  RowDescriptor output_rd({types::DataType::INT64});
+
+  // With the input descriptor, the add is compiled into a numeric kernel.
+  auto tester = exec::ExecNodeTester<MapNode, plan::MapOperator>(*plan_node_, output_rd,
+                                                                 {input_rd}, exec_state_.get());
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 4, /*eow*/ true, /*eos*/ true)
+                       .AddColumn<types::Int64Value>({1, 2, 3, 4})
+                       .AddColumn<types::Int64Value>({1, 3, 6, 9})
+                       .get(),
+                   0)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<types::Int64Value>({2, 5, 9, 13})
+                          .get())
+      .Close();
+}
+
 TEST_F(MapNodeTest, child_fail) {
   RowDescriptor input_rd({types::DataType::INT64, types::DataType::INT64});
   RowDescriptor output_rd({types::DataType::INT64});
@@ -62,8 +62,17 @@ Status MemorySinkNode::PrepareImpl(ExecState* exec_state_) {
     col_names.push_back(plan_node_->ColumnName(i));
   }
 
-  table_ = Table::Create(Relation(input_descriptor_->types(), col_names));
-  exec_state_->table_store()->AddTable(plan_node_->TableName(), table_);
+  Relation relation(input_descriptor_->types(), col_names);
+  if (plan_node_->append()) {
+    table_ = exec_state_->table_store()->GetTable(plan_node_->TableName());
+    if (table_ != nullptr && table_->GetRelation() == relation) {
+      return Status::OK();
+    }
+  }
+
+  auto table = Table::Create(relation);
+  table_ = table.get();
+  exec_state_->table_store()->AddTable(plan_node_->TableName(), std::move(table));
 
   return Status::OK();
 }
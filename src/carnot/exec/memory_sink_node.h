@@ -53,7 +53,7 @@ class MemorySinkNode : public SinkNode {
  private:
   std::unique_ptr<plan::MemorySinkOperator> plan_node_;
   std::unique_ptr<table_store::schema::RowDescriptor> input_descriptor_;
-  std::shared_ptr<table_store::Table> table_;
+  table_store::Table* table_ = nullptr;
 };
 
 }  // namespace exec
@@ -180,6 +180,37 @@ TEST_F(MemorySinkNodeTest, zero_row_row_batch_eos) {
   EXPECT_EQ(0, exec_state_->table_store()->GetTable("cpu_15s")->GetTableStats().batches_added);
 }
 
+TEST_F(MemorySinkNodeTest, append_to_existing_table) {
+  RowDescriptor input_rd({types::DataType::INT64, types::DataType::BOOLEAN});
+  RowDescriptor output_rd({});
+
+  auto existing = table_store::Table::Create(table_store::schema::Relation(
+      {types::DataType::INT64, types::DataType::BOOLEAN}, {"test_col1", "test_col2"}));
+  exec_state_->table_store()->AddTable("cpu_15s", existing);
+  ASSERT_OK(existing->WriteRowBatch(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                                        .AddColumn<types::Int64Value>({1, 2})
+                                        .AddColumn<types::BoolValue>({true, false})
+                                        .get()));
+
+  auto op_proto = planpb::testutils::CreateTestSink2PB();
+  op_proto.mutable_mem_sink_op()->set_append(true);
+  auto plan_node = plan::MemorySinkOperator::FromProto(op_proto, 1);
+  auto tester = exec::ExecNodeTester<MemorySinkNode, plan::MemorySinkOperator>(
+      *plan_node, output_rd, {input_rd}, exec_state_.get());
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd, 2, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::Int64Value>({3, 4})
+                       .AddColumn<types::BoolValue>({false, true})
+                       .get(),
+                   false, 0)
+      .Close();
+
+  // The sink kept the existing table and its rows.
+  EXPECT_EQ(existing.get(), exec_state_->table_store()->GetTable("cpu_15s"));
+  EXPECT_EQ(2, existing->GetTableStats().batches_added);
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
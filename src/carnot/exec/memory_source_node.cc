@@ -18,19 +18,51 @@
 
 #include "src/carnot/exec/memory_source_node.h"
 
+#include <cmath>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/strings/substitute.h>
 
 #include "src/carnot/planpb/plan.pb.h"
 #include "src/common/base/base.h"
+#include "src/shared/types/arrow_adapter.h"
 
 namespace px {
 namespace carnot {
 namespace exec {
 
+namespace {
+
+// The splitmix64 finalizer. The sample needs a hash that doesn't change across processes, so that
+// every agent and every run of a query picks the same batches.
+uint64_t MixRowID(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Same as the upid_to_pod_name UDF.
+std::string PodNameOfUPID(const md::AgentMetadataState& md, const md::UPID& upid) {
+  const auto* pid = md.GetPIDByUPID(upid);
+  if (pid == nullptr) {
+    return "";
+  }
+  const auto* container = md.k8s_metadata_state().ContainerInfoByID(pid->cid());
+  if (container == nullptr) {
+    return "";
+  }
+  const auto* pod = md.k8s_metadata_state().PodInfoByID(container->pod_id());
+  if (pod == nullptr) {
+    return "";
+  }
+  return absl::Substitute("$0/$1", pod->ns(), pod->name());
+}
+
+}  // namespace
+
 std::string MemorySourceNode::DebugStringImpl() {
   return absl::Substitute("Exec::MemorySourceNode: <name: $0, output: $1>", plan_node_->TableName(),
                           output_descriptor_->DebugString());
@@ -45,6 +77,32 @@ Status MemorySourceNode::InitImpl(const plan::Operator& plan_node) {
   return Status::OK();
 }
 
+void MemorySourceNode::DeferColumnsExcept(const absl::flat_hash_set<int64_t>& keep_cols) {
+  defer_cols_.assign(plan_node_->Columns().size(), true);
+  for (auto col_idx : keep_cols) {
+    if (col_idx >= 0 && col_idx < static_cast<int64_t>(defer_cols_.size())) {
+      defer_cols_[col_idx] = false;
+    }
+  }
+}
+
+void MemorySourceNode::SetZoneMapPredicates(std::vector<table_store::ZoneMapPredicate> preds) {
+  zone_map_preds_.clear();
+  const auto& cols = plan_node_->Columns();
+  for (auto& pred : preds) {
+    if (pred.col_idx < 0 || pred.col_idx >= static_cast<int64_t>(cols.size())) {
+      continue;
+    }
+    pred.col_idx = cols[pred.col_idx];
+    zone_map_preds_.push_back(std::move(pred));
+  }
+}
+
+void MemorySourceNode::SetUPIDPodPredicates(std::vector<UPIDPodPredicate> preds) {
+  upid_pod_preds_ = std::move(preds);
+  upid_in_pod_.resize(upid_pod_preds_.size());
+}
+
 Status MemorySourceNode::PrepareImpl(ExecState*) { return Status::OK(); }
 
 Status MemorySourceNode::OpenImpl(ExecState* exec_state) {
@@ -52,21 +110,27 @@ Status MemorySourceNode::OpenImpl(ExecState* exec_state) {
   DCHECK(table_ != nullptr);
 
   infinite_stream_ = plan_node_->infinite_stream();
+  stream_window_ = plan_node_->stream_window();
+  window_start_ = std::chrono::steady_clock::now();
+  sample_fraction_ = plan_node_->sample_fraction();
+  if (sample_fraction_ < 1.0) {
+    sample_threshold_ = static_cast<uint64_t>(
+        std::ldexp(sample_fraction_, std::numeric_limits<uint64_t>::digits));
+  }
 
   if (table_ == nullptr) {
     return error::NotFound("Table '$0' not found", plan_node_->TableName());
   }
 
   if (plan_node_->HasStartTime()) {
-    PL_ASSIGN_OR_RETURN(current_batch_, table_->FindBatchSliceGreaterThanOrEqual(
-                                            plan_node_->start_time(), exec_state->exec_mem_pool()));
+    PL_ASSIGN_OR_RETURN(current_batch_,
+                        table_->FindBatchSliceGreaterThanOrEqual(plan_node_->start_time()));
   } else {
     current_batch_ = table_->FirstBatch();
   }
 
   if (plan_node_->HasStopTime()) {
-    PL_ASSIGN_OR_RETURN(stop_, table_->FindStopPositionForTime(plan_node_->stop_time(),
-                                                               exec_state->exec_mem_pool()));
+    PL_ASSIGN_OR_RETURN(stop_, table_->FindStopPositionForTime(plan_node_->stop_time()));
   } else {
     // Determine table_end at Open() time because Stirling may be pushing to the table
     stop_ = table_->End();
@@ -78,6 +142,22 @@ Status MemorySourceNode::OpenImpl(ExecState* exec_state) {
 
 Status MemorySourceNode::CloseImpl(ExecState*) {
   stats()->AddExtraInfo("infinite_stream", infinite_stream_ ? "true" : "false");
+  if (!zone_map_preds_.empty()) {
+    stats()->AddExtraInfo("batches_skipped", std::to_string(batches_skipped_));
+  }
+  if (!upid_pod_preds_.empty()) {
+    stats()->AddExtraInfo("rows_of_other_pods", std::to_string(rows_of_other_pods_));
+  }
+  if (sample_fraction_ < 1.0) {
+    stats()->AddExtraInfo("sample_fraction", std::to_string(sample_fraction_));
+    stats()->AddExtraInfo("batches_not_sampled", std::to_string(batches_not_sampled_));
+    // The relative standard error of the number of rows in the table estimated from the sample,
+    // rows_processed / sample_fraction. The errors of counts and sums are of the same order.
+    double rse = rows_processed_ > 0 ? std::sqrt((1 - sample_fraction_) * sampled_rows_sq_) /
+                                           static_cast<double>(rows_processed_)
+                                     : 0;
+    stats()->AddExtraInfo("sample_row_count_rse", std::to_string(rse));
+  }
   return Status::OK();
 }
 
@@ -91,23 +171,40 @@ StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState*
     stop_ = table_->End();
     auto next_batch = table_->NextBatch(current_batch_, stop_);
     if (!next_batch.IsValid()) {
-      return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ false, /* eos */ false);
+      return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ CloseWindowIfDue(),
+                                    /* eos */ false);
     }
     current_batch_ = next_batch;
     wait_for_valid_next_ = false;
   }
 
+  // Skip over the batches that the zone maps rule out, or that aren't in the sample.
+  while (current_batch_.IsValid() && !ReadSlice(current_batch_)) {
+    auto next_batch = table_->NextBatch(current_batch_, stop_);
+    if (infinite_stream_ && !next_batch.IsValid()) {
+      wait_for_valid_next_ = true;
+      return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ CloseWindowIfDue(),
+                                    /* eos */ false);
+    }
+    current_batch_ = next_batch;
+  }
+
   if (!current_batch_.IsValid()) {
-    return RowBatch::WithZeroRows(*output_descriptor_, /* eow */ !infinite_stream_,
+    return RowBatch::WithZeroRows(*output_descriptor_,
+                                  /* eow */ !infinite_stream_ || CloseWindowIfDue(),
                                   /* eos */ !infinite_stream_);
   }
 
-  PL_ASSIGN_OR_RETURN(
-      auto row_batch,
-      table_->GetRowBatchSlice(current_batch_, plan_node_->Columns(), exec_state->exec_mem_pool()));
+  PL_ASSIGN_OR_RETURN(auto row_batch,
+                      table_->GetSharedRowBatchSlice(current_batch_, plan_node_->Columns(),
+                                                     defer_cols_, exec_state->exec_mem_pool()));
 
   rows_processed_ += row_batch->num_rows();
+  sampled_rows_sq_ += static_cast<double>(row_batch->num_rows()) * row_batch->num_rows();
   bytes_processed_ += row_batch->NumBytes();
+  if (!upid_pod_preds_.empty()) {
+    PL_ASSIGN_OR_RETURN(row_batch, SelectRowsOfPods(exec_state, std::move(row_batch)));
+  }
   auto next_batch = table_->NextBatch(current_batch_, stop_);
   if (infinite_stream_ && !next_batch.IsValid()) {
     wait_for_valid_next_ = true;
@@ -122,9 +219,71 @@ StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::GetNextRowBatch(ExecState*
     row_batch->set_eow(true);
     row_batch->set_eos(true);
   }
+  // Windowed streams do send eow, at the end of each window.
+  if (infinite_stream_ && CloseWindowIfDue()) {
+    row_batch->set_eow(true);
+  }
   return row_batch;
 }
 
+bool MemorySourceNode::ReadSlice(const table_store::BatchSlice& slice) {
+  if (sample_fraction_ < 1.0 &&
+      MixRowID(static_cast<uint64_t>(slice.uniq_row_start_idx)) >= sample_threshold_) {
+    ++batches_not_sampled_;
+    return false;
+  }
+  if (!table_->SliceMayMatch(slice, zone_map_preds_)) {
+    ++batches_skipped_;
+    return false;
+  }
+  return true;
+}
+
+StatusOr<std::unique_ptr<RowBatch>> MemorySourceNode::SelectRowsOfPods(
+    ExecState* exec_state, std::unique_ptr<RowBatch> rb) {
+  const md::AgentMetadataState* md = exec_state->metadata_state();
+  // Without metadata the rows are left for the downstream filter to decide on.
+  if (md == nullptr) {
+    return rb;
+  }
+  int64_t num_rows = rb->num_rows();
+  std::vector<uint8_t> mask(num_rows, 1);
+  for (const auto& [pred_idx, pred] : Enumerate(upid_pod_preds_)) {
+    auto col = rb->ColumnAt(pred.upid_col_idx);
+    auto& upid_in_pod = upid_in_pod_[pred_idx];
+    for (int64_t i = 0; i < num_rows; ++i) {
+      absl::uint128 upid = types::GetValueFromArrowArray<types::UINT128>(col.get(), i);
+      auto [it, inserted] = upid_in_pod.try_emplace(upid, false);
+      if (inserted) {
+        it->second = PodNameOfUPID(*md, md::UPID(upid)) == pred.pod_name;
+      }
+      mask[i] &= it->second;
+    }
+  }
+
+  std::vector<int64_t> selection;
+  int64_t num_selected = SelectionFromMask(mask.data(), num_rows, &selection);
+  if (num_selected == num_rows) {
+    return rb;
+  }
+  rows_of_other_pods_ += num_rows - num_selected;
+
+  auto output_rb = std::make_unique<RowBatch>(*output_descriptor_, num_selected);
+  for (int64_t col_idx = 0; col_idx < rb->num_columns(); ++col_idx) {
+    if (rb->IsDeferredColumn(col_idx)) {
+      PL_ASSIGN_OR_RETURN(auto output_col, rb->DeferredColumnRowsAt(col_idx, selection));
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(output_col));
+      continue;
+    }
+    auto input_col = rb->ColumnAt(col_idx);
+    PL_ASSIGN_OR_RETURN(auto output_col,
+                        GatherArrowArray(output_descriptor_->type(col_idx), input_col.get(),
+                                         selection, exec_state->exec_mem_pool()));
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(output_col));
+  }
+  return output_rb;
+}
+
 Status MemorySourceNode::GenerateNextImpl(ExecState* exec_state) {
   PL_ASSIGN_OR_RETURN(auto row_batch, GetNextRowBatch(exec_state));
   PL_RETURN_IF_ERROR(SendRowBatchToChildren(exec_state, *row_batch));
@@ -139,10 +298,24 @@ bool MemorySourceNode::InfiniteStreamNextBatchReady() {
   return next_batch.IsValid();
 }
 
+bool MemorySourceNode::WindowDue() const {
+  return infinite_stream_ && stream_window_.count() > 0 &&
+         std::chrono::steady_clock::now() - window_start_ >= stream_window_;
+}
+
+bool MemorySourceNode::CloseWindowIfDue() {
+  if (!WindowDue()) {
+    return false;
+  }
+  window_start_ = std::chrono::steady_clock::now();
+  return true;
+}
+
 bool MemorySourceNode::NextBatchReady() {
   // Next batch is ready if we haven't seen an eow and if it's an infinite_stream that has batches
-  // to push.
-  return HasBatchesRemaining() && (!infinite_stream_ || InfiniteStreamNextBatchReady());
+  // to push, or whose current window needs to be closed even though no new data came in.
+  return HasBatchesRemaining() &&
+         (!infinite_stream_ || InfiniteStreamNextBatchReady() || WindowDue());
 }
 
 }  // namespace exec
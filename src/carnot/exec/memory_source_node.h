@@ -19,12 +19,18 @@
 #pragma once
 
 #include <stdint.h>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/numeric/int128.h>
+
 #include "src/carnot/exec/exec_node.h"
 #include "src/carnot/exec/exec_state.h"
+#include "src/carnot/exec/filter_kernels.h"
 #include "src/carnot/plan/operators.h"
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
@@ -44,6 +50,25 @@ class MemorySourceNode : public SourceNode {
 
   bool NextBatchReady() override;
 
+  /**
+   * Defers every output column except keep_cols (indexes into the output). Deferred columns read
+   * from hot storage are only converted to arrow once a downstream node accesses them.
+   */
+  void DeferColumnsExcept(const absl::flat_hash_set<int64_t>& keep_cols);
+
+  /**
+   * Skips cold batches that can't contain a row satisfying all of preds, according to the table's
+   * zone maps. The col_idx of each predicate indexes into the output of this node.
+   */
+  void SetZoneMapPredicates(std::vector<table_store::ZoneMapPredicate> preds);
+
+  /**
+   * Only outputs the rows whose UPID column belongs to the pod of each of preds, resolving each
+   * distinct UPID against the query's metadata state once. The upid_col_idx of each predicate
+   * indexes into the output of this node.
+   */
+  void SetUPIDPodPredicates(std::vector<UPIDPodPredicate> preds);
+
  protected:
   std::string DebugStringImpl() override;
   Status InitImpl(const plan::Operator& plan_node) override;
@@ -55,17 +80,45 @@ class MemorySourceNode : public SourceNode {
  private:
   StatusOr<std::unique_ptr<RowBatch>> GetNextRowBatch(ExecState* exec_state);
   bool InfiniteStreamNextBatchReady();
+  // Whether the current window of the stream has been open for stream_window_.
+  bool WindowDue() const;
+  // Returns whether the batch about to be output closes the current window of the stream, in which
+  // case the next window starts.
+  bool CloseWindowIfDue();
+  // Whether the batch is read, or skipped because of the zone maps or the sample.
+  bool ReadSlice(const table_store::BatchSlice& slice);
+  // Drops the rows of rb that don't satisfy upid_pod_preds_.
+  StatusOr<std::unique_ptr<RowBatch>> SelectRowsOfPods(ExecState* exec_state,
+                                                       std::unique_ptr<RowBatch> rb);
   // Whether this memory source will stream infinitely. Can be stopped by the
   // exec_state_->keep_running() call in exec_graph.
   bool infinite_stream_ = false;
   // An infinite stream will set this to true once its exceeded the current data in the table, and
   // then will keep checking for new data.
   bool wait_for_valid_next_ = false;
+  // For infinite streams, how often to close a window with an eow. 0 never closes a window.
+  std::chrono::milliseconds stream_window_{0};
+  std::chrono::steady_clock::time_point window_start_;
   table_store::BatchSlice current_batch_;
   table_store::Table::StopPosition stop_;
 
   std::unique_ptr<plan::MemorySourceOperator> plan_node_;
   table_store::Table* table_ = nullptr;
+  // Indexed like plan_node_->Columns(). Empty when nothing is deferred.
+  std::vector<bool> defer_cols_;
+  // Predicates over table columns used to skip batches.
+  std::vector<table_store::ZoneMapPredicate> zone_map_preds_;
+  int64_t batches_skipped_ = 0;
+  // Batches are read if the hash of their first row id is below sample_threshold_.
+  double sample_fraction_ = 1.0;
+  uint64_t sample_threshold_ = 0;
+  int64_t batches_not_sampled_ = 0;
+  // The sum of the squares of the sizes of the sampled batches, for the error of the sample.
+  double sampled_rows_sq_ = 0;
+  std::vector<UPIDPodPredicate> upid_pod_preds_;
+  // Indexed like upid_pod_preds_. Whether each UPID seen so far satisfies the predicate.
+  std::vector<absl::flat_hash_map<absl::uint128, bool>> upid_in_pod_;
+  int64_t rows_of_other_pods_ = 0;
 };
 
 }  // namespace exec
@@ -19,7 +19,9 @@
 #include "src/carnot/exec/memory_source_node.h"
 
 #include <arrow/memory_pool.h>
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -383,6 +385,34 @@ TEST_F(MemorySourceNodeTest, infinite_stream) {
   tester.Close();
 }
 
+TEST_F(MemorySourceNodeTest, windowed_infinite_stream) {
+  auto op_proto = planpb::testutils::CreateTestWindowedStreamingSource1PB(100);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 3, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>({1, 2, 3})
+          .get());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ false, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>({5, 6})
+          .get());
+  EXPECT_FALSE(tester.node()->NextBatchReady());
+
+  // Once the window is over, the stream closes it even though there is no new data.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(tester.node()->NextBatchReady());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 0, /*eow*/ true, /*eos*/ false)
+          .AddColumn<types::Time64NSValue>({})
+          .get());
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+}
+
 TEST_F(MemorySourceNodeTest, table_compact_between_open_and_exec) {
   auto op_proto = planpb::testutils::CreateTestSourceRangePB();
   std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
@@ -412,6 +442,70 @@ TEST_F(MemorySourceNodeTest, table_compact_between_open_and_exec) {
   tester.Close();
 }
 
+TEST_F(MemorySourceNodeTest, zone_map_skips_cold_batches) {
+  // Moves the first batch, with times 1-3, to cold storage.
+  EXPECT_OK(cpu_table_->CompactHotToCold(arrow::default_memory_pool()));
+
+  auto op_proto = planpb::testutils::CreateTestSource1PB();
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+      *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+
+  table_store::ZoneMapPredicate pred;
+  pred.col_idx = 0;
+  pred.data_type = types::TIME64NS;
+  pred.op = table_store::ZoneMapOp::kGreaterThanEqual;
+  pred.int_value = 4;
+  tester.node()->SetZoneMapPredicates({pred});
+
+  EXPECT_TRUE(tester.node()->HasBatchesRemaining());
+  tester.GenerateNextResult().ExpectRowBatch(
+      RowBatchBuilder(output_rd, 2, /*eow*/ true, /*eos*/ true)
+          .AddColumn<types::Time64NSValue>({5, 6})
+          .get());
+  EXPECT_FALSE(tester.node()->HasBatchesRemaining());
+  tester.Close();
+  EXPECT_EQ(2, tester.node()->RowsProcessed());
+}
+
+TEST_F(MemorySourceNodeTest, sample_fraction) {
+  table_store::schema::Relation rel({types::DataType::BOOLEAN, types::DataType::TIME64NS},
+                                    {"col1", "time_"});
+  auto table = Table::Create(rel);
+  exec_state_->table_store()->AddTable("sampled", table);
+  constexpr int64_t kNumBatches = 200;
+  for (int64_t i = 0; i < kNumBatches; ++i) {
+    auto rb = RowBatch(RowDescriptor(rel.col_types()), 1);
+    EXPECT_OK(rb.AddColumn(
+        types::ToArrow(std::vector<types::BoolValue>{true}, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(
+        types::ToArrow(std::vector<types::Time64NSValue>{i}, arrow::default_memory_pool())));
+    EXPECT_OK(table->WriteRowBatch(rb));
+  }
+
+  auto op_proto = planpb::testutils::CreateTestSource1PB("sampled");
+  op_proto.mutable_mem_source_op()->set_sample_fraction(0.25);
+  std::unique_ptr<plan::Operator> plan_node = plan::MemorySourceOperator::FromProto(op_proto, 1);
+  RowDescriptor output_rd({types::DataType::TIME64NS});
+
+  auto read_sample = [&]() {
+    auto tester = exec::ExecNodeTester<MemorySourceNode, plan::MemorySourceOperator>(
+        *plan_node, output_rd, std::vector<RowDescriptor>({}), exec_state_.get());
+    while (tester.node()->HasBatchesRemaining()) {
+      tester.GenerateNextResult();
+    }
+    tester.Close();
+    return tester.node()->RowsProcessed();
+  };
+  int64_t num_rows = read_sample();
+  EXPECT_GT(num_rows, kNumBatches / 8);
+  EXPECT_LT(num_rows, kNumBatches / 2);
+  // The same batches are picked every time.
+  EXPECT_EQ(num_rows, read_sample());
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -61,6 +61,20 @@ class BorrowPool {
     return ptr;
   }
 
+  /**
+   * Removes an idle item from the pool, handing its ownership to the caller.
+   * @return the item, or nullptr if every item is borrowed.
+   */
+  StoredPtrType Take() {
+    absl::base_internal::SpinLockHolder l(&pool_lock_);
+    if (pool_.size() == 0) {
+      return nullptr;
+    }
+    auto ptr = std::move(pool_.back());
+    pool_.pop_back();
+    return ptr;
+  }
+
   size_t Size() {
     absl::base_internal::SpinLockHolder l(&pool_lock_);
     return pool_.size();
@@ -51,6 +51,23 @@ TEST(BorrowPool, basic) {
   EXPECT_NE(ptr3, nullptr);
 }
 
+TEST(BorrowPool, take) {
+  BorrowPool<int> pool;
+  pool.Add(BorrowPool<int>::StoredPtrType(new int(1)));
+  pool.Add(BorrowPool<int>::StoredPtrType(new int(2)));
+
+  auto borrowed = pool.Borrow();
+  EXPECT_NE(borrowed, nullptr);
+  auto taken = pool.Take();
+  EXPECT_NE(taken, nullptr);
+  EXPECT_EQ(0, pool.Size());
+  EXPECT_EQ(pool.Take(), nullptr);
+  // Borrowed items still return to the pool, taken items don't.
+  borrowed.reset();
+  taken.reset();
+  EXPECT_EQ(1, pool.Size());
+}
+
 // Test to check for data races with ASAN/TSAN
 TEST(BorrowPool, threaded) {
   BorrowPool<int> pool;
@@ -30,6 +30,7 @@
 #include <absl/strings/substitute.h>
 #include "third_party/eigen3/Eigen/Core"
 
+#include "src/carnot/exec/ml/parallel.h"
 #include "src/common/base/base.h"
 
 namespace px {
@@ -160,8 +161,10 @@ class CoresetTree {
  public:
   /**
    * r-way Coreset Tree.
+   * @param num_threads the number of threads that coreset the full levels after a merge.
    **/
-  CoresetTree(size_t r, size_t coreset_size) : coreset_size_(coreset_size), r_(r) {}
+  CoresetTree(size_t r, size_t coreset_size, int num_threads = FLAGS_carnot_ml_num_threads)
+      : coreset_size_(coreset_size), r_(r), num_threads_(num_threads) {}
 
   void Update(std::shared_ptr<WeightedPointSet> set) {
     if (levels_.size() == 0) {
@@ -207,16 +210,36 @@ class CoresetTree {
       }
     }
 
-    // Fix the r-way tree by coresetting any levels that have r or more buckets after merge.
-    for (auto i = 0UL; i < levels_.size(); i++) {
-      if (levels_[i].size() >= r_) {
-        auto merged =
-            TCoreset::FromWeightedPointSet(WeightedPointSet::Union(levels_[i]), coreset_size_);
+    // Fix the r-way tree by coresetting any levels that have r or more buckets after merge. The
+    // full levels are independent, so they're coreset in parallel. Pushing their coresets up a
+    // level can fill the next level, so repeat until no level is full.
+    while (true) {
+      std::vector<size_t> full_levels;
+      for (auto i = 0UL; i < levels_.size(); i++) {
+        if (levels_[i].size() >= r_) {
+          full_levels.push_back(i);
+        }
+      }
+      if (full_levels.empty()) {
+        break;
+      }
+      std::vector<std::shared_ptr<WeightedPointSet>> merged(full_levels.size());
+      ParallelFor(full_levels.size(), num_threads_, [&](int64_t begin, int64_t end, int) {
+        for (auto j = begin; j < end; j++) {
+          merged[j] = TCoreset::FromWeightedPointSet(
+              WeightedPointSet::Union(levels_[full_levels[j]]), coreset_size_);
+        }
+      });
+      // Clear every full level before pushing, so that a level that is both full and receiving a
+      // coreset from the level below keeps the new coreset.
+      for (auto i : full_levels) {
         levels_[i].clear();
+      }
+      for (const auto& [j, i] : Enumerate(full_levels)) {
         if (i == levels_.size() - 1) {
           levels_.emplace_back();
         }
-        levels_[i + 1].push_back(std::move(merged));
+        levels_[i + 1].push_back(std::move(merged[j]));
       }
     }
   }
@@ -276,6 +299,7 @@ class CoresetTree {
  private:
   size_t coreset_size_;
   size_t r_;
+  int num_threads_;
   std::vector<Level> levels_;
 };
 
@@ -69,6 +69,24 @@ static void BM_CoresetTreeMerge(benchmark::State& state) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_CoresetTreeMergeThreads(benchmark::State& state) {
+  // Each tree has 3 buckets on each of its 4 levels, so every level is full after the merge.
+  int d = 64;
+  CoresetTree<KMeansCoreset> tree(4, 64, state.range(0));
+  for (int i = 0; i < 3 * (1 + 4 + 16 + 64); i++) {
+    tree.Update(std::make_shared<WeightedPointSet>(Eigen::MatrixXf::Random(64, d),
+                                                   Eigen::VectorXf::Ones(64)));
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    CoresetTree<KMeansCoreset> merged = tree;
+    state.ResumeTiming();
+    merged.Merge(tree);
+  }
+}
+
 // NOLINTNEXTLINE : runtime/references.
 static void BM_CoresetFromWeightedPointSet(benchmark::State& state) {
   int d = 65;
@@ -115,5 +133,6 @@ BENCHMARK(BM_CoresetTreeUpdate);
 BENCHMARK(BM_CoresetFromWeightedPointSet);
 BENCHMARK(BM_CoresetTreeQuery);
 BENCHMARK(BM_CoresetTreeMerge);
+BENCHMARK(BM_CoresetTreeMergeThreads)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
 BENCHMARK(BM_CoresetSerialize);
 BENCHMARK(BM_CoresetDeserialize);
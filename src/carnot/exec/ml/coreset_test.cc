@@ -81,6 +81,23 @@ TEST(CoresetDriver, merge) {
   EXPECT_EQ(192, driver1.Query()->size());
 }
 
+TEST(CoresetTree, parallel_merge) {
+  int d = 8;
+  CoresetTree<KMeansCoreset> tree1(/*r*/ 4, /*coreset_size*/ 64, /*num_threads*/ 4);
+  CoresetTree<KMeansCoreset> tree2(/*r*/ 4, /*coreset_size*/ 64, /*num_threads*/ 4);
+  // 15 buckets leave 3 buckets on each of the first two levels.
+  for (int i = 0; i < 15; i++) {
+    tree1.Update(std::make_shared<WeightedPointSet>(Eigen::MatrixXf::Random(64, d),
+                                                    Eigen::VectorXf::Ones(64)));
+    tree2.Update(std::make_shared<WeightedPointSet>(Eigen::MatrixXf::Random(64, d),
+                                                    Eigen::VectorXf::Ones(64)));
+  }
+  tree1.Merge(tree2);
+  // Both levels are full after the merge, so both get coreset at once, leaving one bucket on the
+  // second level and one on the third.
+  EXPECT_EQ(2 * 64, tree1.Coreset()->size());
+}
+
 TEST(CoresetDriver, serialization) {
   // Create a coreset driver using the Coreset R-way tree data structure, and kmeans coresets.
   // Uses base buckets of size 64, points of size 64, 4-way tree, and coresets of size 64.
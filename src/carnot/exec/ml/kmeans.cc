@@ -17,7 +17,11 @@
  */
 
 #include "src/carnot/exec/ml/kmeans.h"
+
+#include <algorithm>
 #include <random>
+#include <utility>
+#include <vector>
 
 #include "src/carnot/exec/ml/sampling.h"
 
@@ -26,6 +30,11 @@ namespace carnot {
 namespace exec {
 namespace ml {
 
+namespace {
+constexpr int64_t kBlockBytes = 128 * 1024;
+constexpr int64_t kMinBlockRows = 16;
+}  // namespace
+
 void KMeans::Fit(std::shared_ptr<WeightedPointSet> set) {
   if (set->size() < 2) {
     LOG(ERROR) << "Fitting KMeans on less than 2 points is currently unsupported.";
@@ -49,17 +58,42 @@ void KMeans::Fit(std::shared_ptr<WeightedPointSet> set) {
 }
 
 bool KMeans::LloydsIteration(const Eigen::MatrixXf& points, const Eigen::VectorXf& weights) {
-  Eigen::MatrixXf new_centroids = Eigen::MatrixXf::Zero(centroids_.rows(), centroids_.cols());
-  Eigen::ArrayXf centroid_weights = Eigen::ArrayXf::Zero(centroids_.rows());
-
-  for (int i = 0; i < points.rows(); i++) {
-    Eigen::VectorXf::Index closest_centroid;
-    (centroids_.rowwise() - points(i, Eigen::all))
-        .rowwise()
-        .squaredNorm()
-        .minCoeff(&closest_centroid);
-    new_centroids(closest_centroid, Eigen::all) += weights(i) * points(i, Eigen::all);
-    centroid_weights(closest_centroid) += weights(i);
+  // Points are assigned in blocks of rows, sized so that a block of points and its distances to
+  // every centroid stay in cache.
+  const int64_t block_rows =
+      std::max<int64_t>(kMinBlockRows, kBlockBytes / (sizeof(float) * (points.cols() + k_)));
+  // Each thread gets at least one block, and accumulates its own centroid sums.
+  int num_threads =
+      std::max<int64_t>(1, std::min<int64_t>(num_threads_, points.rows() / block_rows));
+  std::vector<Eigen::MatrixXf> thread_centroids(
+      num_threads, Eigen::MatrixXf::Zero(centroids_.rows(), centroids_.cols()));
+  std::vector<Eigen::ArrayXf> thread_weights(num_threads, Eigen::ArrayXf::Zero(centroids_.rows()));
+
+  // |p - c|^2 = |p|^2 - 2 p.c + |c|^2, and |p|^2 doesn't change which centroid is the closest, so
+  // the distances of a block are a single matrix product.
+  const Eigen::RowVectorXf centroid_norms = centroids_.rowwise().squaredNorm().transpose();
+  ParallelFor(points.rows(), num_threads, [&](int64_t begin, int64_t end, int thread_idx) {
+    Eigen::MatrixXf& new_centroids = thread_centroids[thread_idx];
+    Eigen::ArrayXf& centroid_weights = thread_weights[thread_idx];
+    Eigen::MatrixXf dists;
+    for (int64_t block = begin; block < end; block += block_rows) {
+      int64_t rows = std::min(block_rows, end - block);
+      dists.noalias() = points.middleRows(block, rows) * centroids_.transpose();
+      dists = (-2 * dists).rowwise() + centroid_norms;
+      for (int64_t r = 0; r < rows; ++r) {
+        Eigen::VectorXf::Index closest_centroid;
+        dists.row(r).minCoeff(&closest_centroid);
+        new_centroids.row(closest_centroid) += weights(block + r) * points.row(block + r);
+        centroid_weights(closest_centroid) += weights(block + r);
+      }
+    }
+  });
+
+  Eigen::MatrixXf new_centroids = std::move(thread_centroids[0]);
+  Eigen::ArrayXf centroid_weights = std::move(thread_weights[0]);
+  for (int t = 1; t < num_threads; ++t) {
+    new_centroids += thread_centroids[t];
+    centroid_weights += thread_weights[t];
   }
 
   for (int i = 0; i < k_; i++) {
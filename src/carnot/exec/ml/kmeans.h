@@ -23,6 +23,7 @@
 #include <string>
 
 #include "src/carnot/exec/ml/coreset.h"
+#include "src/carnot/exec/ml/parallel.h"
 
 namespace px {
 namespace carnot {
@@ -34,9 +35,16 @@ class KMeans {
   enum KMeansInitType {
     kKMeansPlusPlus = 0,
   };
+  /**
+   * @param num_threads the number of threads that assign points to centroids in each iteration.
+   */
   explicit KMeans(int k, int max_iters = 10, KMeansInitType init_type = kKMeansPlusPlus,
-                  unsigned int seed = 42)
-      : k_(k), max_iters_(max_iters), init_type_(init_type), random_gen_(seed) {}
+                  unsigned int seed = 42, int num_threads = FLAGS_carnot_ml_num_threads)
+      : k_(k),
+        max_iters_(max_iters),
+        init_type_(init_type),
+        random_gen_(seed),
+        num_threads_(num_threads) {}
 
   /**
    * Run kmeans on a weighted set of points.
@@ -65,6 +73,7 @@ class KMeans {
   KMeansInitType init_type_;
   Eigen::MatrixXf centroids_;
   std::mt19937 random_gen_;
+  int num_threads_;
 };
 
 }  // namespace ml
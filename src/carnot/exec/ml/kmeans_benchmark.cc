@@ -40,6 +40,23 @@ static void BM_KMeansFit(benchmark::State& state) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_KMeansFitThreads(benchmark::State& state) {
+  int k = 10;
+  int d = 64;
+  int n = 100000;
+  KMeans kmeans(k, /*max_iters*/ 10, KMeans::kKMeansPlusPlus, /*seed*/ 42,
+                /*num_threads*/ state.range(0));
+
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(n, d);
+  Eigen::VectorXf weights = Eigen::VectorXf::Ones(n);
+  auto set = std::make_shared<WeightedPointSet>(points, weights);
+
+  for (auto _ : state) {
+    kmeans.Fit(set);
+  }
+}
+
 // NOLINTNEXTLINE : runtime/references.
 static void BM_KMeansTransform(benchmark::State& state) {
   int k = 10;
@@ -59,4 +76,5 @@ static void BM_KMeansTransform(benchmark::State& state) {
 }
 
 BENCHMARK(BM_KMeansFit);
+BENCHMARK(BM_KMeansFitThreads)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
 BENCHMARK(BM_KMeansTransform);
@@ -96,6 +96,26 @@ TEST(KMeans, trimodal_normal_dist) {
   }
 }
 
+TEST(KMeans, multithreaded_fit) {
+  int k = 3;
+  int n = 60000;
+  Eigen::MatrixXf points = Eigen::MatrixXf::Random(n, k) * 0.1;
+  for (int i = 0; i < n; i++) {
+    points(i, i % k) += 5;
+  }
+  auto set = std::make_shared<WeightedPointSet>(points, Eigen::VectorXf::Ones(n));
+
+  KMeans single_threaded(k, /*max_iters*/ 10, KMeans::kKMeansPlusPlus, /*seed*/ 42,
+                         /*num_threads*/ 1);
+  single_threaded.Fit(set);
+  KMeans multithreaded(k, /*max_iters*/ 10, KMeans::kKMeansPlusPlus, /*seed*/ 42,
+                       /*num_threads*/ 4);
+  multithreaded.Fit(set);
+
+  // Only the order of the floating point sums differs.
+  EXPECT_THAT(multithreaded.centroids(), UnorderedRowsAre(single_threaded.centroids(), 1e-3f));
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
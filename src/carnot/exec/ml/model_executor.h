@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -36,6 +38,12 @@ enum ModelType {
 class ModelExecutor {
  public:
   virtual ~ModelExecutor() = default;
+
+  /**
+   * @return the approximate number of bytes held by the executor, used for the ModelPool's
+   * memory budget.
+   */
+  virtual int64_t NumBytes() const { return 0; }
 };
 
 }  // namespace ml
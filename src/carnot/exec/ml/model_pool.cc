@@ -0,0 +1,26 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/ml/model_pool.h"
+
+DEFINE_int32(carnot_ml_model_pool_max_executors, 4,
+             "The maximum number of executors loaded for each model, which bounds the number of "
+             "concurrent inferences of a model.");
+DEFINE_int64(carnot_ml_model_pool_max_bytes, 1024 * 1024 * 1024,
+             "The memory budget of the loaded models. Idle executors of the least recently used "
+             "models are unloaded when it's exceeded.");
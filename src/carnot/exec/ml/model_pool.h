@@ -18,21 +18,36 @@
 
 #pragma once
 
-#include <absl/base/internal/spinlock.h>
+#include <algorithm>
 #include <chrono>
 #include <memory>
+#include <string>
 #include <thread>
-#include <unordered_map>
 #include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/str_cat.h>
+#include <absl/synchronization/mutex.h>
 
 #include "src/carnot/exec/ml/borrow_pool.h"
 #include "src/carnot/exec/ml/model_executor.h"
+#include "src/common/base/base.h"
+
+DECLARE_int32(carnot_ml_model_pool_max_executors);
+DECLARE_int64(carnot_ml_model_pool_max_bytes);
 
 namespace px {
 namespace carnot {
 namespace exec {
 namespace ml {
 
+/**
+ * ModelPool holds warm model executors shared by every query of the engine. There's a pool per
+ * model type and constructor args, which grows on demand up to max_executors_per_model executors.
+ * When the executors take more than max_bytes, idle executors of the least recently used models
+ * are unloaded.
+ */
 class ModelPool {
  public:
   using PoolType = BorrowPool<ModelExecutor>;
@@ -40,14 +55,10 @@ class ModelPool {
 
   static std::unique_ptr<ModelPool> Create() { return std::make_unique<ModelPool>(); }
 
-  template <typename TExecutor, typename... Args>
-  void CreatePool(Args... args) {
-    // TODO(james, PP-2594): currently if you ask for the same type of model with different args the
-    // pool will return the first args asked for.
-    auto pool = std::make_unique<PoolType>();
-    pool->Add(std::make_unique<TExecutor>(args...));
-    pool_map_[TExecutor::Type()] = std::move(pool);
-  }
+  ModelPool()
+      : ModelPool(FLAGS_carnot_ml_model_pool_max_executors, FLAGS_carnot_ml_model_pool_max_bytes) {}
+  ModelPool(int max_executors_per_model, int64_t max_bytes)
+      : max_executors_per_model_(std::max(1, max_executors_per_model)), max_bytes_(max_bytes) {}
 
   template <typename TExecutor>
   struct DerivedDeleter {
@@ -57,19 +68,116 @@ class ModelPool {
 
   template <typename TExecutor, typename... Args>
   std::unique_ptr<TExecutor, DerivedDeleter<TExecutor>> GetModelExecutor(Args... args) {
-    if (pool_map_.find(TExecutor::Type()) == pool_map_.end()) {
-      CreatePool<TExecutor>(args...);
-    }
-    auto ptr = pool_map_[TExecutor::Type()]->Borrow();
+    Entry* entry = GetEntry(TExecutor::Type(), absl::StrCat(args...));
+    auto ptr = entry->pool.Borrow();
     while (ptr == nullptr) {
-      ptr = pool_map_[TExecutor::Type()]->Borrow();
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      if (ReserveExecutor(entry)) {
+        // Models are loaded outside of the lock, they can take a while.
+        auto executor = std::make_unique<TExecutor>(args...);
+        AddExecutor(entry, executor->NumBytes());
+        entry->pool.Add(std::move(executor));
+      } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      ptr = entry->pool.Borrow();
     }
     return std::unique_ptr<TExecutor, DerivedDeleter<TExecutor>>(
         static_cast<TExecutor*>(ptr.release()), DerivedDeleter<TExecutor>{ptr.get_deleter()});
   }
 
-  std::unordered_map<ModelType, std::unique_ptr<PoolType>> pool_map_;
+  /**
+   * @return the number of bytes held by the loaded executors.
+   */
+  int64_t NumBytes() const {
+    absl::MutexLock lock(&mu_);
+    return total_bytes_;
+  }
+
+  /**
+   * @return the number of loaded executors, borrowed or idle.
+   */
+  int64_t NumExecutors() const {
+    absl::MutexLock lock(&mu_);
+    int64_t num_executors = 0;
+    for (const auto& [key, entry] : entries_) {
+      num_executors += entry->num_executors;
+    }
+    return num_executors;
+  }
+
+ private:
+  struct Entry {
+    // Entries are never removed, since borrowed executors hold a pointer to their pool.
+    PoolType pool;
+    int num_executors = 0;
+    int64_t bytes_per_executor = 0;
+    int64_t last_used = 0;
+  };
+
+  Entry* GetEntry(ModelType type, std::string args) {
+    absl::MutexLock lock(&mu_);
+    auto& entry = entries_[std::make_pair(type, std::move(args))];
+    if (entry == nullptr) {
+      entry = std::make_unique<Entry>();
+    }
+    entry->last_used = ++clock_;
+    return entry.get();
+  }
+
+  // Returns true if the caller should load another executor into the entry's pool.
+  bool ReserveExecutor(Entry* entry) {
+    absl::MutexLock lock(&mu_);
+    if (entry->num_executors >= max_executors_per_model_) {
+      return false;
+    }
+    entry->num_executors++;
+    return true;
+  }
+
+  void AddExecutor(Entry* entry, int64_t num_bytes) {
+    std::vector<PoolType::StoredPtrType> evicted;
+    {
+      absl::MutexLock lock(&mu_);
+      entry->bytes_per_executor = num_bytes;
+      total_bytes_ += num_bytes;
+      EvictIdle(entry, &evicted);
+    }
+    // The evicted executors are unloaded here, outside of the lock.
+  }
+
+  // Takes idle executors out of the least recently used pools until the pool is within its memory
+  // budget, or there's nothing left to evict. The pool that's being added to is left alone.
+  void EvictIdle(const Entry* keep, std::vector<PoolType::StoredPtrType>* evicted)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    while (total_bytes_ > max_bytes_) {
+      Entry* lru = nullptr;
+      for (const auto& [key, entry] : entries_) {
+        if (entry.get() != keep && entry->pool.Size() > 0 &&
+            (lru == nullptr || entry->last_used < lru->last_used)) {
+          lru = entry.get();
+        }
+      }
+      if (lru == nullptr) {
+        return;
+      }
+      auto executor = lru->pool.Take();
+      if (executor == nullptr) {
+        continue;
+      }
+      lru->num_executors--;
+      total_bytes_ -= lru->bytes_per_executor;
+      evicted->push_back(std::move(executor));
+    }
+  }
+
+  const int max_executors_per_model_;
+  const int64_t max_bytes_;
+
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<std::pair<ModelType, std::string>, std::unique_ptr<Entry>> entries_
+      GUARDED_BY(mu_);
+  int64_t total_bytes_ GUARDED_BY(mu_) = 0;
+  int64_t clock_ GUARDED_BY(mu_) = 0;
 };
 
 }  // namespace ml
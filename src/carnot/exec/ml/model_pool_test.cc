@@ -19,6 +19,8 @@
 #include "src/carnot/exec/ml/model_pool.h"
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
+#include <string>
+#include <utility>
 #include "src/carnot/exec/ml/transformer_executor.h"
 
 DEFINE_string(embedding_dir, "", "Path to embedding.proto");
@@ -34,6 +36,59 @@ TEST(ModelPool, basic) {
   EXPECT_EQ(kTransformer, executor->Type());
 }
 
+// Stands in for a loaded model, so that the pool itself can be tested without model files.
+class FakeExecutor : public ModelExecutor {
+ public:
+  explicit FakeExecutor(std::string name) : name_(std::move(name)) {}
+  ~FakeExecutor() override { num_unloaded++; }
+
+  static constexpr ModelType Type() { return kTransformer; }
+  int64_t NumBytes() const override { return 100; }
+  const std::string& name() const { return name_; }
+
+  static inline int num_unloaded = 0;
+
+ private:
+  std::string name_;
+};
+
+TEST(ModelPool, pools_per_args) {
+  ModelPool pool(/*max_executors_per_model*/ 2, /*max_bytes*/ 1000);
+  {
+    auto a = pool.GetModelExecutor<FakeExecutor>("a");
+    auto b = pool.GetModelExecutor<FakeExecutor>("b");
+    EXPECT_EQ("a", a->name());
+    EXPECT_EQ("b", b->name());
+    // A second concurrent borrow of a model loads another executor.
+    auto a2 = pool.GetModelExecutor<FakeExecutor>("a");
+    EXPECT_EQ("a", a2->name());
+    EXPECT_EQ(3, pool.NumExecutors());
+  }
+  // Returned executors are reused.
+  auto a = pool.GetModelExecutor<FakeExecutor>("a");
+  EXPECT_EQ(3, pool.NumExecutors());
+  EXPECT_EQ(300, pool.NumBytes());
+}
+
+TEST(ModelPool, evicts_idle_lru_models) {
+  FakeExecutor::num_unloaded = 0;
+  ModelPool pool(/*max_executors_per_model*/ 1, /*max_bytes*/ 250);
+  { auto a = pool.GetModelExecutor<FakeExecutor>("a"); }
+  auto b = pool.GetModelExecutor<FakeExecutor>("b");
+  EXPECT_EQ(0, FakeExecutor::num_unloaded);
+
+  // Loading c goes over budget, a is the least recently used idle model.
+  auto c = pool.GetModelExecutor<FakeExecutor>("c");
+  EXPECT_EQ(1, FakeExecutor::num_unloaded);
+  EXPECT_EQ(200, pool.NumBytes());
+
+  // Borrowed executors are never unloaded, so the pool can go over budget.
+  auto a = pool.GetModelExecutor<FakeExecutor>("a");
+  EXPECT_EQ(1, FakeExecutor::num_unloaded);
+  EXPECT_EQ(300, pool.NumBytes());
+  EXPECT_EQ("a", a->name());
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
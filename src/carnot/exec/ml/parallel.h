@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "src/common/base/base.h"
+#include "src/common/base/thread_pool.h"
+
+DECLARE_int32(carnot_ml_num_threads);
+
+namespace px {
+namespace carnot {
+namespace exec {
+namespace ml {
+
+/**
+ * Splits [0, n) into up to num_threads contiguous ranges, and calls fn(begin, end, thread_idx)
+ * once per range, on the calling thread and the threads of ThreadPool::Shared(). The ranges and
+ * their thread_idx only depend on n and num_threads, not on which thread runs them, so results
+ * that are reduced in thread_idx order are deterministic. Blocks until every range is done.
+ */
+template <typename TFn>
+void ParallelFor(int64_t n, int num_threads, const TFn& fn) {
+  num_threads = static_cast<int>(std::clamp<int64_t>(n, 1, std::max(num_threads, 1)));
+  int64_t range_size = (n + num_threads - 1) / num_threads;
+  auto run_range = [&](int64_t t) {
+    int64_t begin = std::min(n, t * range_size);
+    fn(begin, std::min(n, begin + range_size), static_cast<int>(t));
+  };
+  if (num_threads == 1) {
+    run_range(0);
+    return;
+  }
+  ThreadPool::Shared()->ParallelFor(num_threads, num_threads,
+                                    [&](int64_t t, int /*worker_idx*/) { run_range(t); });
+}
+
+}  // namespace ml
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -50,6 +50,16 @@ void sample_from_probs(const Eigen::ArrayXf& probs, Eigen::ArrayXi* inds, size_t
 
 size_t randint(size_t high) { return rand() % high; }
 
+double randreal() {
+  thread_local std::mt19937_64 gen(std::random_device{}());
+  std::uniform_real_distribution<double> dis(0.0, 1.0);
+  double val = dis(gen);
+  while (val == 0.0) {
+    val = dis(gen);
+  }
+  return val;
+}
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
@@ -30,6 +30,9 @@ void sample_from_probs(const Eigen::ArrayXf& probs, Eigen::ArrayXi* inds, size_t
 
 size_t randint(size_t high);
 
+// Returns a uniformly random double in (0, 1).
+double randreal();
+
 }  // namespace ml
 }  // namespace exec
 }  // namespace carnot
@@ -18,6 +18,16 @@
 
 #include "src/carnot/exec/ml/transformer_executor.h"
 
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+DEFINE_int32(carnot_ml_inference_num_threads, 1,
+             "The number of threads each transformer model executor runs inference with.");
+DEFINE_int32(carnot_ml_inference_batch_size, 16,
+             "The maximum number of docs the transformer model embeds in one inference.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -50,39 +60,71 @@ static int load_ints_from_json(std::string in, int32_t* arr, int max_num) {
 }
 
 void TransformerExecutor::Execute(std::string doc, std::string* out) {
-  // LOG(INFO) << "inputs: " << tf_interpreter_->inputs().size() << "\n";
-  // LOG(INFO) << "input(0) name: " << tf_interpreter_->GetInputName(0) << "\n";
-
-  // int t_size = tf_interpreter_->tensors_size();
-  // for (int i = 0; i < t_size; i++) {
-  //   if (tf_interpreter_->tensor(i)->name) {
-  //     LOG(INFO) << i << ": " << tf_interpreter_->tensor(i)->name << ", "
-  //               << tf_interpreter_->tensor(i)->bytes << ", "
-  //               << tf_interpreter_->tensor(i)->type;
-  //   }
-  // }
+  std::vector<std::string> outs;
+  ExecuteBatch({&doc}, &outs);
+  *out = std::move(outs[0]);
+}
+
+bool TransformerExecutor::ResizeBatch(int batch_size) {
+  if (batch_size == batch_size_) {
+    return true;
+  }
+  tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0], {batch_size, max_length_});
+  if (tf_interpreter_->AllocateTensors() != kTfLiteOk) {
+    return false;
+  }
+  batch_size_ = batch_size;
+  return true;
+}
+
+void TransformerExecutor::ExecuteBatch(const std::vector<const std::string*>& docs,
+                                       std::vector<std::string>* out) {
+  out->assign(docs.size(), "");
+  for (size_t begin = 0; begin < docs.size(); begin += max_batch_size_) {
+    size_t end = std::min(docs.size(), begin + max_batch_size_);
+    if (!ResizeBatch(end - begin)) {
+      // Not every model supports a dynamic batch dimension, fall back to one doc at a time.
+      LOG(INFO) << "Failed to allocate tensors for a batch of " << end - begin
+                << " docs, running the transformer model one doc at a time";
+      max_batch_size_ = 1;
+      end = begin + 1;
+      if (!ResizeBatch(1)) {
+        LOG(INFO) << "Failed to allocate tensors";
+        return;
+      }
+    }
+    InvokeBatch(docs, begin, end, out);
+  }
+}
+
+void TransformerExecutor::InvokeBatch(const std::vector<const std::string*>& docs, size_t begin,
+                                      size_t end, std::vector<std::string>* out) {
   auto input = tf_interpreter_->typed_input_tensor<int32_t>(0);
   if (input == nullptr) {
     LOG(INFO) << "Error getting typed input tensor, most likely using wrong type for this model";
-    *out = "";
     return;
   }
 
-  auto count = load_ints_from_json(doc, input, max_length_);
-  if (count == 0) {
-    // Either input array was empty or there was an error parsing the json, either way don't
-    // continue.
-    *out = "";
-    return;
-  }
+  std::vector<bool> valid(end - begin);
+  bool any_valid = false;
+  for (size_t i = begin; i < end; ++i) {
+    int32_t* row = input + (i - begin) * max_length_;
+    auto count = load_ints_from_json(*docs[i], row, max_length_);
+    // Either input array was empty or there was an error parsing the json, either way the doc's
+    // output is left empty.
+    valid[i - begin] = count > 0;
+    any_valid |= count > 0;
 
-  // Add 1 to each token to account for pad token.
-  for (int i = 0; i < count; i++) {
-    input[i] = input[i] + 1;
+    // Add 1 to each token to account for pad token.
+    for (int j = 0; j < count; j++) {
+      row[j] = row[j] + 1;
+    }
+    for (int j = count; j < max_length_; j++) {
+      row[j] = 0;
+    }
   }
-
-  for (int i = count; i < max_length_; i++) {
-    input[i] = 0;
+  if (!any_valid) {
+    return;
   }
 
   const int embedding_size = 256;
@@ -90,16 +132,31 @@ void TransformerExecutor::Execute(std::string doc, std::string* out) {
   tf_interpreter_->Invoke();
 
   auto output = tf_interpreter_->typed_output_tensor<float>(0);
+  int64_t row_stride = tf_interpreter_->output_tensor(0)->bytes / sizeof(float) / (end - begin);
+
+  for (size_t i = begin; i < end; ++i) {
+    if (!valid[i - begin]) {
+      continue;
+    }
+    const float* row = output + (i - begin) * row_stride;
+    // Copy output to json array.
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    writer.StartArray();
+    for (int j = 0; j < embedding_size; j++) {
+      writer.Double(row[j]);
+    }
+    writer.EndArray();
+    (*out)[i] = sb.GetString();
+  }
+}
 
-  // Copy output to json array.
-  rapidjson::StringBuffer sb;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-  writer.StartArray();
-  for (int i = 0; i < embedding_size; i++) {
-    writer.Double(output[i]);
+int64_t TransformerExecutor::NumBytes() const {
+  int64_t bytes = model_->allocation() == nullptr ? 0 : model_->allocation()->bytes();
+  for (size_t i = 0; i < tf_interpreter_->tensors_size(); ++i) {
+    bytes += tf_interpreter_->tensor(i)->bytes;
   }
-  writer.EndArray();
-  *out = sb.GetString();
+  return bytes;
 }
 
 }  // namespace ml
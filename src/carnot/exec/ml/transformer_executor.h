@@ -24,11 +24,17 @@
 #include <tensorflow/lite/interpreter.h>
 #include <tensorflow/lite/kernels/register.h>
 #include <tensorflow/lite/model.h>
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 #include "src/carnot/exec/ml/model_executor.h"
+#include "src/common/base/base.h"
 #include "src/common/base/utils.h"
 
+DECLARE_int32(carnot_ml_inference_num_threads);
+DECLARE_int32(carnot_ml_inference_batch_size);
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -45,8 +51,9 @@ class TransformerExecutor : public ModelExecutor {
     model_ = tflite::FlatBufferModel::BuildFromFile(model_proto_path.c_str());
     tflite::ops::builtin::BuiltinOpResolver resolver;
     tflite::InterpreterBuilder(*model_, resolver)(&tf_interpreter_);
-    tf_interpreter_->ResizeInputTensor(tf_interpreter_->inputs()[0], {1, max_length_});
-    if (tf_interpreter_->AllocateTensors() != kTfLiteOk) {
+    tf_interpreter_->SetNumThreads(FLAGS_carnot_ml_inference_num_threads);
+    max_batch_size_ = std::max(1, FLAGS_carnot_ml_inference_batch_size);
+    if (!ResizeBatch(1)) {
       LOG(INFO) << "Failed to allocate tensors";
     } else {
       LOG(INFO) << "Init Transformer model";
@@ -55,10 +62,26 @@ class TransformerExecutor : public ModelExecutor {
 
   void Execute(std::string doc, std::string* out);
 
+  /**
+   * Embeds each of the docs, running the model on up to max_batch_size_ docs at a time. Docs that
+   * aren't valid json arrays of ints are embedded as "".
+   */
+  void ExecuteBatch(const std::vector<const std::string*>& docs, std::vector<std::string>* out);
+
+  int64_t NumBytes() const override;
+
  private:
+  // Resizes the input tensor to hold batch_size docs, returns false if the tensors can't be
+  // allocated.
+  bool ResizeBatch(int batch_size);
+  void InvokeBatch(const std::vector<const std::string*>& docs, size_t begin, size_t end,
+                   std::vector<std::string>* out);
+
   std::unique_ptr<tflite::Interpreter> tf_interpreter_;
   std::unique_ptr<tflite::FlatBufferModel> model_;
   int max_length_ = 64;
+  int max_batch_size_ = 1;
+  int batch_size_ = 0;
 };
 
 }  // namespace ml
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/morsel_executor.h"
+
+#include <arrow/array/concatenate.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+MorselExecutor::MorselExecutor(int num_workers, int64_t morsel_size_rows, ThreadPool* pool)
+    : num_workers_(std::max(1, num_workers)),
+      morsel_size_rows_(std::max<int64_t>(1, morsel_size_rows)),
+      pool_(pool != nullptr ? pool : ThreadPool::Shared()) {}
+
+Status MorselExecutor::ParallelFor(int64_t num_morsels, const MorselFunc& fn) {
+  std::atomic<bool> failed = false;
+  std::mutex status_mutex;
+  Status status;
+  pool_->ParallelFor(num_morsels, num_workers_, [&](int64_t morsel_idx, int worker_idx) {
+    // The remaining morsels are skipped once one fails.
+    if (failed) {
+      return;
+    }
+    Status s = fn(morsel_idx, worker_idx);
+    if (!s.ok()) {
+      std::lock_guard<std::mutex> lock(status_mutex);
+      if (status.ok()) {
+        status = s;
+      }
+      failed = true;
+    }
+  });
+  return status;
+}
+
+StatusOr<std::vector<std::unique_ptr<RowBatch>>> SplitIntoMorsels(const RowBatch& rb,
+                                                                  int64_t morsel_size_rows) {
+  DCHECK_GT(morsel_size_rows, 0);
+  std::vector<std::unique_ptr<RowBatch>> morsels;
+  for (int64_t offset = 0; offset < rb.num_rows(); offset += morsel_size_rows) {
+    auto length = std::min(morsel_size_rows, rb.num_rows() - offset);
+    PL_ASSIGN_OR_RETURN(auto morsel, rb.Slice(offset, length));
+    morsels.push_back(std::move(morsel));
+  }
+  return morsels;
+}
+
+StatusOr<std::unique_ptr<RowBatch>> ConcatenateMorsels(
+    const RowDescriptor& desc, const std::vector<std::unique_ptr<RowBatch>>& morsels,
+    arrow::MemoryPool* mem_pool) {
+  int64_t num_rows = 0;
+  for (const auto& morsel : morsels) {
+    num_rows += morsel->num_rows();
+  }
+  auto output = std::make_unique<RowBatch>(desc, num_rows);
+  arrow::ArrayVector col_arrays(morsels.size());
+  for (int64_t col_idx = 0; col_idx < static_cast<int64_t>(desc.size()); ++col_idx) {
+    if (morsels.empty()) {
+      auto builder = types::MakeArrowBuilder(desc.type(col_idx), mem_pool);
+      std::shared_ptr<arrow::Array> arr;
+      PL_RETURN_IF_ERROR(builder->Finish(&arr));
+      PL_RETURN_IF_ERROR(output->AddColumn(arr));
+      continue;
+    }
+    // A single morsel can be passed through without a copy.
+    if (morsels.size() == 1) {
+      PL_RETURN_IF_ERROR(output->AddColumn(morsels[0]->ColumnAt(col_idx)));
+      continue;
+    }
+    for (size_t i = 0; i < morsels.size(); ++i) {
+      col_arrays[i] = morsels[i]->ColumnAt(col_idx);
+    }
+    // Copies the value and offset buffers of all the morsels at once, rather than value by value.
+    std::shared_ptr<arrow::Array> arr;
+    PL_RETURN_IF_ERROR(arrow::Concatenate(col_arrays, mem_pool, &arr));
+    PL_RETURN_IF_ERROR(output->AddColumn(arr));
+  }
+  return output;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/common/base/thread_pool.h"
+#include "src/table_store/schema/row_batch.h"
+#include "src/table_store/schema/row_descriptor.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+constexpr int64_t kDefaultMorselSizeRows = 16 * 1024;
+
+/**
+ * MorselExecutor runs morsels (fixed size row ranges of a RowBatch) of stateless operators on the
+ * threads of a ThreadPool. Morsels are handed out dynamically from a shared counter, so workers
+ * that finish early steal the remaining morsels instead of idling.
+ *
+ * The calling thread participates as worker 0, so an executor with num_workers == 1 runs
+ * everything inline.
+ */
+class MorselExecutor : public NotCopyable {
+ public:
+  using MorselFunc = std::function<Status(int64_t morsel_idx, int worker_idx)>;
+
+  /**
+   * @param num_workers The total number of workers, including the calling thread.
+   * @param morsel_size_rows The maximum number of rows in a single morsel.
+   * @param pool The threads to run the morsels on. If null, the process-wide ThreadPool::Shared()
+   * is used.
+   */
+  MorselExecutor(int num_workers, int64_t morsel_size_rows, ThreadPool* pool = nullptr);
+
+  int num_workers() const { return num_workers_; }
+  int64_t morsel_size_rows() const { return morsel_size_rows_; }
+
+  /**
+   * Runs fn once for every morsel index in [0, num_morsels). worker_idx is in [0, num_workers())
+   * and is unique among concurrently running invocations, so callers can use it to index
+   * per-worker state without locking. Blocks until all morsels are complete.
+   * @return The first error returned by fn, or OK.
+   */
+  Status ParallelFor(int64_t num_morsels, const MorselFunc& fn);
+
+ private:
+  const int num_workers_;
+  const int64_t morsel_size_rows_;
+  ThreadPool* pool_;
+};
+
+/**
+ * Splits the row batch into morsels of at most morsel_size_rows rows. The morsels share the
+ * underlying arrow buffers with the input and do not carry eow/eos.
+ */
+StatusOr<std::vector<std::unique_ptr<table_store::schema::RowBatch>>> SplitIntoMorsels(
+    const table_store::schema::RowBatch& rb, int64_t morsel_size_rows);
+
+/**
+ * Concatenates the morsels, in order, into a single row batch with the given descriptor.
+ */
+StatusOr<std::unique_ptr<table_store::schema::RowBatch>> ConcatenateMorsels(
+    const table_store::schema::RowDescriptor& desc,
+    const std::vector<std::unique_ptr<table_store::schema::RowBatch>>& morsels,
+    arrow::MemoryPool* mem_pool);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/morsel_executor.h"
+
+#include <atomic>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+
+TEST(MorselExecutorTest, runs_every_morsel_once) {
+  MorselExecutor executor(4, /* morsel_size_rows */ 10);
+  std::vector<std::atomic<int>> counts(1000);
+  std::atomic<int> max_worker_idx = 0;
+  ASSERT_OK(executor.ParallelFor(counts.size(), [&](int64_t morsel_idx, int worker_idx) {
+    counts[morsel_idx]++;
+    int prev = max_worker_idx;
+    while (worker_idx > prev && !max_worker_idx.compare_exchange_weak(prev, worker_idx)) {
+    }
+    return Status::OK();
+  }));
+  for (const auto& count : counts) {
+    EXPECT_EQ(1, count.load());
+  }
+  EXPECT_LT(max_worker_idx.load(), 4);
+
+  // The executor should be reusable across calls.
+  std::atomic<int> total = 0;
+  ASSERT_OK(executor.ParallelFor(10, [&](int64_t, int) {
+    total++;
+    return Status::OK();
+  }));
+  EXPECT_EQ(10, total.load());
+}
+
+TEST(MorselExecutorTest, returns_error) {
+  MorselExecutor executor(3, /* morsel_size_rows */ 10);
+  auto s = executor.ParallelFor(100, [&](int64_t morsel_idx, int) {
+    if (morsel_idx == 42) {
+      return error::Internal("morsel failed");
+    }
+    return Status::OK();
+  });
+  EXPECT_NOT_OK(s);
+  EXPECT_EQ("morsel failed", s.msg());
+}
+
+TEST(MorselExecutorTest, single_worker_runs_inline) {
+  MorselExecutor executor(1, /* morsel_size_rows */ 10);
+  std::vector<int64_t> order;
+  ASSERT_OK(executor.ParallelFor(5, [&](int64_t morsel_idx, int worker_idx) {
+    EXPECT_EQ(0, worker_idx);
+    order.push_back(morsel_idx);
+    return Status::OK();
+  }));
+  EXPECT_THAT(order, ::testing::ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST(MorselExecutorTest, shares_pool) {
+  ThreadPool pool(2);
+  MorselExecutor executor1(3, /* morsel_size_rows */ 10, &pool);
+  MorselExecutor executor2(2, /* morsel_size_rows */ 10, &pool);
+  std::atomic<int> total = 0;
+  ASSERT_OK(executor1.ParallelFor(100, [&](int64_t, int worker_idx) {
+    EXPECT_LT(worker_idx, 3);
+    return executor2.ParallelFor(10, [&](int64_t, int inner_worker_idx) {
+      EXPECT_LT(inner_worker_idx, 2);
+      total++;
+      return Status::OK();
+    });
+  }));
+  EXPECT_EQ(1000, total.load());
+}
+
+TEST(MorselExecutorTest, split_and_concatenate) {
+  RowDescriptor rd({types::DataType::INT64, types::DataType::STRING});
+  auto rb = RowBatchBuilder(rd, 5, /*eow*/ true, /*eos*/ true)
+                .AddColumn<types::Int64Value>({1, 2, 3, 4, 5})
+                .AddColumn<types::StringValue>({"a", "b", "c", "d", "e"})
+                .get();
+
+  auto morsels = SplitIntoMorsels(rb, 2).ConsumeValueOrDie();
+  ASSERT_EQ(3, morsels.size());
+  EXPECT_EQ(2, morsels[0]->num_rows());
+  EXPECT_EQ(2, morsels[1]->num_rows());
+  EXPECT_EQ(1, morsels[2]->num_rows());
+
+  auto output = ConcatenateMorsels(rd, morsels, arrow::default_memory_pool()).ConsumeValueOrDie();
+  EXPECT_TRUE(output->ColumnAt(0)->Equals(rb.ColumnAt(0)));
+  EXPECT_TRUE(output->ColumnAt(1)->Equals(rb.ColumnAt(1)));
+  EXPECT_EQ(5, output->num_rows());
+
+  auto empty = ConcatenateMorsels(rd, {}, arrow::default_memory_pool()).ConsumeValueOrDie();
+  EXPECT_EQ(0, empty->num_rows());
+  EXPECT_EQ(0, empty->ColumnAt(1)->length());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/plan_template_cache.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <utility>
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+std::string PlanTemplateCache::Key(const planpb::Plan& plan) {
+  planpb::Plan normalized = plan;
+  for (auto& fragment : *normalized.mutable_nodes()) {
+    for (auto& node : *fragment.mutable_nodes()) {
+      if (!node.op().has_mem_source_op()) {
+        continue;
+      }
+      auto* mem_src = node.mutable_op()->mutable_mem_source_op();
+      mem_src->clear_start_time();
+      mem_src->clear_stop_time();
+    }
+  }
+  std::string key;
+  {
+    google::protobuf::io::StringOutputStream stream(&key);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    coded.SetSerializationDeterministic(true);
+    normalized.SerializeToCodedStream(&coded);
+  }
+  return key;
+}
+
+std::shared_ptr<const PlanTemplate> PlanTemplateCache::Get(const std::string& key) {
+  absl::MutexLock lock(&mu_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->plan_template;
+}
+
+void PlanTemplateCache::Put(const std::string& key,
+                            std::shared_ptr<const PlanTemplate> plan_template) {
+  if (max_entries_ <= 0) {
+    return;
+  }
+  absl::MutexLock lock(&mu_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    auto entry_it = it->second;
+    index_.erase(it);
+    entries_.erase(entry_it);
+  }
+  entries_.push_front(Entry{key, std::move(plan_template)});
+  index_.emplace(entries_.front().key, entries_.begin());
+  while (static_cast<int64_t>(entries_.size()) > max_entries_) {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+}
+
+int64_t PlanTemplateCache::size() const {
+  absl::MutexLock lock(&mu_);
+  return entries_.size();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/carnot/udf/registry.h"
+#include "src/common/base/base.h"
+#include "src/table_store/schema/relation.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * The output relations of the operators of a plan fragment, which only depend on the plan and the
+ * UDF registry.
+ */
+struct PlanFragmentTemplate {
+  absl::flat_hash_map<int64_t, table_store::schema::Relation> output_relations;
+};
+
+/**
+ * The parts of setting up a plan that don't change between runs of the same plan on an agent: the
+ * UDF and UDA definitions resolved from the registry and the relations of every operator. Exec
+ * nodes and the rest of the per-run state are still created for every run.
+ */
+struct PlanTemplate {
+  std::map<int64_t, udf::ScalarUDFDefinition*> scalar_udfs;
+  std::map<int64_t, udf::UDADefinition*> udas;
+  // Keyed by plan fragment id.
+  absl::flat_hash_map<int64_t, PlanFragmentTemplate> fragments;
+};
+
+/**
+ * @brief PlanTemplateCache holds the templates of recently executed plans, so that plans which
+ * are run over and over, ie. by live views that refresh every few seconds, skip resolving their
+ * UDFs and operator relations.
+ */
+class PlanTemplateCache : public NotCopyable {
+ public:
+  explicit PlanTemplateCache(int64_t max_entries) : max_entries_(max_entries) {}
+
+  /**
+   * @brief Returns the cache key of the plan. The start and stop times of memory sources change
+   * on every run of a script and don't affect the template, so they aren't part of the key.
+   */
+  static std::string Key(const planpb::Plan& plan);
+
+  /**
+   * @brief Returns the template cached for key, or nullptr if there isn't one.
+   */
+  std::shared_ptr<const PlanTemplate> Get(const std::string& key);
+
+  void Put(const std::string& key, std::shared_ptr<const PlanTemplate> plan_template);
+
+  int64_t size() const;
+
+ private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<const PlanTemplate> plan_template;
+  };
+
+  const int64_t max_entries_;
+  mutable absl::Mutex mu_;
+  // Ordered from the most to the least recently used. The index keys point into the entries.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string_view, std::list<Entry>::iterator> index_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
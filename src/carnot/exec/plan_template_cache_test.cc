@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include <absl/strings/substitute.h>
+
+#include "src/carnot/exec/plan_template_cache.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+constexpr char kMemSrcPlan[] = R"proto(
+nodes {
+  id: 1
+  nodes {
+    id: 1
+    op {
+      op_type: MEMORY_SOURCE_OPERATOR
+      mem_source_op {
+        name: "$0"
+        start_time { value: $1 }
+        stop_time { value: 5000 }
+      }
+    }
+  }
+}
+)proto";
+
+planpb::Plan MemSrcPlan(std::string_view table, int64_t start_time) {
+  planpb::Plan plan;
+  CHECK(google::protobuf::TextFormat::ParseFromString(
+      absl::Substitute(kMemSrcPlan, table, start_time), &plan));
+  return plan;
+}
+
+TEST(PlanTemplateCacheTest, key_ignores_times) {
+  EXPECT_EQ(PlanTemplateCache::Key(MemSrcPlan("http_events", 1000)),
+            PlanTemplateCache::Key(MemSrcPlan("http_events", 2000)));
+  EXPECT_NE(PlanTemplateCache::Key(MemSrcPlan("http_events", 1000)),
+            PlanTemplateCache::Key(MemSrcPlan("conn_stats", 1000)));
+}
+
+TEST(PlanTemplateCacheTest, evicts_least_recently_used) {
+  PlanTemplateCache cache(/*max_entries*/ 2);
+  auto a = std::make_shared<PlanTemplate>();
+  auto b = std::make_shared<PlanTemplate>();
+  auto c = std::make_shared<PlanTemplate>();
+  cache.Put("a", a);
+  cache.Put("b", b);
+  EXPECT_EQ(a, cache.Get("a"));
+  cache.Put("c", c);
+
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(a, cache.Get("a"));
+  EXPECT_EQ(nullptr, cache.Get("b"));
+  EXPECT_EQ(c, cache.Get("c"));
+}
+
+TEST(PlanTemplateCacheTest, disabled) {
+  PlanTemplateCache cache(/*max_entries*/ 0);
+  cache.Put("a", std::make_shared<PlanTemplate>());
+  EXPECT_EQ(nullptr, cache.Get("a"));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "src/carnot/exec/query_memory_pool.h"
+
+DEFINE_int64(carnot_query_memory_limit_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_QUERY_MEMORY_LIMIT_BYTES", 0),
+             "The number of bytes a single query can allocate for row batches and exec node "
+             "state before it's cancelled. 0 means no limit.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+void QueryMemoryPool::AddBytes(int64_t size) {
+  int64_t allocated = bytes_allocated_.fetch_add(size) + size;
+  int64_t peak = max_memory_.load();
+  while (allocated > peak && !max_memory_.compare_exchange_weak(peak, allocated)) {
+  }
+}
+
+arrow::Status QueryMemoryPool::Allocate(int64_t size, uint8_t** out) {
+  auto status = arrow::ProxyMemoryPool::Allocate(size, out);
+  if (!status.ok()) {
+    return status;
+  }
+  refs_.fetch_add(1);
+  AddBytes(size);
+  return status;
+}
+
+arrow::Status QueryMemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+  auto status = arrow::ProxyMemoryPool::Reallocate(old_size, new_size, ptr);
+  if (!status.ok()) {
+    return status;
+  }
+  AddBytes(new_size - old_size);
+  return status;
+}
+
+void QueryMemoryPool::Free(uint8_t* buffer, int64_t size) {
+  arrow::ProxyMemoryPool::Free(buffer, size);
+  bytes_allocated_.fetch_sub(size);
+  Unref();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
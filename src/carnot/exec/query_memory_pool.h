@@ -0,0 +1,96 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+#include <arrow/status.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include "src/common/base/base.h"
+
+DECLARE_int64(carnot_query_memory_limit_bytes);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * QueryMemoryPool is the arrow memory pool of a single query. It forwards allocations to a parent
+ * pool, and keeps track of the bytes that are currently allocated by the query and their high
+ * water mark.
+ *
+ * The memory limit is soft: allocations past the limit still succeed (a lot of the exec code
+ * can't recover from a failed allocation), but the pool remembers that the limit was exceeded so
+ * that the query can be cancelled at the next row batch boundary.
+ *
+ * Buffers allocated for a query can outlive it (ie. the row batches that a memory sink writes into
+ * the table store), so the pool isn't deleted with its query. Instead the query calls Release()
+ * when it's done, and the pool deletes itself once the last of its buffers is freed.
+ */
+class QueryMemoryPool final : public arrow::ProxyMemoryPool {
+ public:
+  /**
+   * @param limit_bytes the soft memory limit of the query, or 0 for no limit.
+   */
+  static QueryMemoryPool* Create(int64_t limit_bytes,
+                                 arrow::MemoryPool* parent = arrow::default_memory_pool()) {
+    return new QueryMemoryPool(limit_bytes, parent);
+  }
+
+  /**
+   * Drops the query's reference to the pool. The pool must not be used for new allocations
+   * afterwards.
+   */
+  void Release() { Unref(); }
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  int64_t bytes_allocated() const override { return bytes_allocated_.load(); }
+  int64_t max_memory() const override { return max_memory_.load(); }
+
+  int64_t limit_bytes() const { return limit_bytes_; }
+  bool LimitExceeded() const { return limit_bytes_ > 0 && max_memory() > limit_bytes_; }
+
+ private:
+  QueryMemoryPool(int64_t limit_bytes, arrow::MemoryPool* parent)
+      : arrow::ProxyMemoryPool(parent), limit_bytes_(limit_bytes) {}
+  ~QueryMemoryPool() override = default;
+
+  void AddBytes(int64_t size);
+  void Unref() {
+    if (refs_.fetch_sub(1) == 1) {
+      delete this;
+    }
+  }
+
+  const int64_t limit_bytes_;
+  std::atomic<int64_t> bytes_allocated_{0};
+  std::atomic<int64_t> max_memory_{0};
+  // One reference for the query, plus one for each live allocation.
+  std::atomic<int64_t> refs_{1};
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "src/carnot/exec/query_memory_pool.h"
+
+#include <arrow/array.h>
+#include <arrow/builder.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+TEST(QueryMemoryPoolTest, tracks_peak_bytes) {
+  auto* pool = QueryMemoryPool::Create(/* limit_bytes */ 0);
+  uint8_t* a;
+  uint8_t* b;
+  ASSERT_TRUE(pool->Allocate(100, &a).ok());
+  ASSERT_TRUE(pool->Allocate(50, &b).ok());
+  EXPECT_EQ(150, pool->bytes_allocated());
+  ASSERT_TRUE(pool->Reallocate(100, 300, &a).ok());
+  EXPECT_EQ(350, pool->bytes_allocated());
+  pool->Free(b, 50);
+  pool->Free(a, 300);
+  EXPECT_EQ(0, pool->bytes_allocated());
+  EXPECT_EQ(350, pool->max_memory());
+  EXPECT_FALSE(pool->LimitExceeded());
+  pool->Release();
+}
+
+TEST(QueryMemoryPoolTest, soft_limit) {
+  auto* pool = QueryMemoryPool::Create(/* limit_bytes */ 128);
+  uint8_t* a;
+  ASSERT_TRUE(pool->Allocate(100, &a).ok());
+  EXPECT_FALSE(pool->LimitExceeded());
+  // Going over the limit doesn't fail the allocation, but it's remembered.
+  ASSERT_TRUE(pool->Reallocate(100, 200, &a).ok());
+  EXPECT_TRUE(pool->LimitExceeded());
+  pool->Free(a, 200);
+  EXPECT_TRUE(pool->LimitExceeded());
+  pool->Release();
+}
+
+TEST(QueryMemoryPoolTest, buffers_outlive_release) {
+  auto* pool = QueryMemoryPool::Create(/* limit_bytes */ 0);
+  arrow::Int64Builder builder(pool);
+  ASSERT_TRUE(builder.Append(42).ok());
+  std::shared_ptr<arrow::Array> arr;
+  ASSERT_TRUE(builder.Finish(&arr).ok());
+  EXPECT_LT(0, pool->bytes_allocated());
+  // The pool stays alive until the last of its buffers is freed.
+  pool->Release();
+  EXPECT_EQ(42, std::static_pointer_cast<arrow::Int64Array>(arr)->Value(0));
+  arr.reset();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
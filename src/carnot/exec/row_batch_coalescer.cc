@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/row_batch_coalescer.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "src/carnot/exec/morsel_executor.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatchCoalescer::Add(const RowBatch& rb,
+                                                           arrow::MemoryPool* mem_pool) {
+  if (rb.num_rows() > 0) {
+    if (held_.empty()) {
+      first_held_time_ = std::chrono::steady_clock::now();
+    }
+    // The columns are shared with rb, so holding them doesn't copy.
+    auto held = std::make_unique<RowBatch>(desc_, rb.num_rows());
+    for (int64_t col_idx = 0; col_idx < rb.num_columns(); ++col_idx) {
+      PL_RETURN_IF_ERROR(held->AddColumn(rb.ColumnAt(col_idx)));
+    }
+    held_rows_ += rb.num_rows();
+    held_bytes_ += rb.NumBytes();
+    held_.push_back(std::move(held));
+  }
+
+  if (rb.eow() || rb.eos()) {
+    std::unique_ptr<RowBatch> output;
+    if (held_.empty()) {
+      PL_ASSIGN_OR_RETURN(output, RowBatch::WithZeroRows(desc_, rb.eow(), rb.eos()));
+      return output;
+    }
+    PL_ASSIGN_OR_RETURN(output, Flush(mem_pool));
+    output->set_eow(rb.eow());
+    output->set_eos(rb.eos());
+    return output;
+  }
+  if (held_rows_ >= target_rows_ || held_bytes_ >= target_bytes_ || FlushDue()) {
+    return Flush(mem_pool);
+  }
+  return std::unique_ptr<RowBatch>();
+}
+
+std::chrono::milliseconds RowBatchCoalescer::TimeUntilFlushDue() const {
+  if (held_.empty()) {
+    return std::chrono::milliseconds::max();
+  }
+  auto due_in = std::chrono::ceil<std::chrono::milliseconds>(
+      first_held_time_ + max_delay_ - std::chrono::steady_clock::now());
+  return std::max(due_in, std::chrono::milliseconds(0));
+}
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatchCoalescer::Flush(arrow::MemoryPool* mem_pool) {
+  if (held_.empty()) {
+    return std::unique_ptr<RowBatch>();
+  }
+  PL_ASSIGN_OR_RETURN(auto output, ConcatenateMorsels(desc_, held_, mem_pool));
+  held_.clear();
+  held_rows_ = 0;
+  held_bytes_ = 0;
+  output->set_eow(false);
+  output->set_eos(false);
+  return output;
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
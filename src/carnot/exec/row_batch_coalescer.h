@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/row_batch.h"
+#include "src/table_store/schema/row_descriptor.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * RowBatchCoalescer merges the small row batches that an exec node outputs, such as those of a
+ * selective filter, into batches of a target size, so the nodes downstream pay their per batch
+ * costs less often.
+ *
+ * Batches are held until the held rows or bytes reach their targets, a batch ends a window or the
+ * stream, or the first held batch has waited for the max delay. The delay bounds the latency
+ * that coalescing adds to streaming queries, whose inputs may pause for a long time.
+ */
+class RowBatchCoalescer {
+ public:
+  RowBatchCoalescer(const table_store::schema::RowDescriptor& desc, int64_t target_rows,
+                    int64_t target_bytes, std::chrono::milliseconds max_delay)
+      : desc_(desc),
+        target_rows_(target_rows),
+        target_bytes_(target_bytes),
+        max_delay_(max_delay) {}
+
+  /**
+   * Adds rb to the held batches. Returns the merged batch if it is due, otherwise nullptr.
+   */
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> Add(
+      const table_store::schema::RowBatch& rb, arrow::MemoryPool* mem_pool);
+
+  /**
+   * Whether the first held batch has waited for the max delay.
+   */
+  bool FlushDue() const {
+    return !held_.empty() && std::chrono::steady_clock::now() - first_held_time_ >= max_delay_;
+  }
+
+  /**
+   * How long until the first held batch has waited for the max delay, or max() if no batches are
+   * held.
+   */
+  std::chrono::milliseconds TimeUntilFlushDue() const;
+
+  /**
+   * Merges the held batches into one, which doesn't end a window or the stream. Returns nullptr
+   * if no rows are held.
+   */
+  StatusOr<std::unique_ptr<table_store::schema::RowBatch>> Flush(arrow::MemoryPool* mem_pool);
+
+  int64_t held_rows() const { return held_rows_; }
+
+ private:
+  table_store::schema::RowDescriptor desc_;
+  int64_t target_rows_;
+  int64_t target_bytes_;
+  std::chrono::milliseconds max_delay_;
+
+  std::vector<std::unique_ptr<table_store::schema::RowBatch>> held_;
+  int64_t held_rows_ = 0;
+  int64_t held_bytes_ = 0;
+  std::chrono::steady_clock::time_point first_held_time_;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/row_batch_coalescer.h"
+
+#include <chrono>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+
+TEST(RowBatchCoalescerTest, merges_to_target_rows) {
+  RowDescriptor rd({types::DataType::INT64, types::DataType::STRING});
+  RowBatchCoalescer coalescer(rd, /*target_rows*/ 4, /*target_bytes*/ 1024 * 1024,
+                              std::chrono::hours(1));
+  auto* mem_pool = arrow::default_memory_pool();
+
+  auto output = coalescer
+                    .Add(RowBatchBuilder(rd, 2, /*eow*/ false, /*eos*/ false)
+                             .AddColumn<types::Int64Value>({1, 2})
+                             .AddColumn<types::StringValue>({"a", "b"})
+                             .get(),
+                         mem_pool)
+                    .ConsumeValueOrDie();
+  EXPECT_EQ(nullptr, output);
+  // Empty batches don't hold anything.
+  output = coalescer
+               .Add(RowBatchBuilder(rd, 0, false, false)
+                        .AddColumn<types::Int64Value>({})
+                        .AddColumn<types::StringValue>({})
+                        .get(),
+                    mem_pool)
+               .ConsumeValueOrDie();
+  EXPECT_EQ(nullptr, output);
+  EXPECT_EQ(2, coalescer.held_rows());
+
+  output = coalescer
+               .Add(RowBatchBuilder(rd, 3, false, false)
+                        .AddColumn<types::Int64Value>({3, 4, 5})
+                        .AddColumn<types::StringValue>({"c", "d", "e"})
+                        .get(),
+                    mem_pool)
+               .ConsumeValueOrDie();
+  ASSERT_NE(nullptr, output);
+  EXPECT_EQ(5, output->num_rows());
+  EXPECT_FALSE(output->eow());
+  EXPECT_FALSE(output->eos());
+  EXPECT_TRUE(output->ColumnAt(0)->Equals(
+      types::ToArrow(std::vector<types::Int64Value>{1, 2, 3, 4, 5}, mem_pool)));
+  EXPECT_TRUE(output->ColumnAt(1)->Equals(
+      types::ToArrow(std::vector<types::StringValue>{"a", "b", "c", "d", "e"}, mem_pool)));
+  EXPECT_EQ(0, coalescer.held_rows());
+}
+
+TEST(RowBatchCoalescerTest, end_of_stream_sends_held_rows) {
+  RowDescriptor rd({types::DataType::INT64});
+  RowBatchCoalescer coalescer(rd, /*target_rows*/ 100, /*target_bytes*/ 1024 * 1024,
+                              std::chrono::hours(1));
+  auto* mem_pool = arrow::default_memory_pool();
+
+  ASSERT_OK(coalescer.Add(
+      RowBatchBuilder(rd, 1, false, false).AddColumn<types::Int64Value>({1}).get(), mem_pool));
+  auto output = coalescer
+                    .Add(RowBatchBuilder(rd, 0, /*eow*/ true, /*eos*/ true)
+                             .AddColumn<types::Int64Value>({})
+                             .get(),
+                         mem_pool)
+                    .ConsumeValueOrDie();
+  ASSERT_NE(nullptr, output);
+  EXPECT_EQ(1, output->num_rows());
+  EXPECT_TRUE(output->eow());
+  EXPECT_TRUE(output->eos());
+
+  // With nothing held, the end of the stream still gets its own batch.
+  output = coalescer
+               .Add(RowBatchBuilder(rd, 0, true, true).AddColumn<types::Int64Value>({}).get(),
+                    mem_pool)
+               .ConsumeValueOrDie();
+  ASSERT_NE(nullptr, output);
+  EXPECT_EQ(0, output->num_rows());
+  EXPECT_TRUE(output->eos());
+}
+
+TEST(RowBatchCoalescerTest, flush_after_max_delay) {
+  RowDescriptor rd({types::DataType::INT64});
+  RowBatchCoalescer coalescer(rd, /*target_rows*/ 100, /*target_bytes*/ 1024 * 1024,
+                              std::chrono::milliseconds(0));
+  auto* mem_pool = arrow::default_memory_pool();
+  EXPECT_FALSE(coalescer.FlushDue());
+  EXPECT_EQ(std::chrono::milliseconds::max(), coalescer.TimeUntilFlushDue());
+
+  // A batch that is due as soon as it is added is sent right away.
+  auto output =
+      coalescer
+          .Add(RowBatchBuilder(rd, 1, false, false).AddColumn<types::Int64Value>({1}).get(),
+               mem_pool)
+          .ConsumeValueOrDie();
+  ASSERT_NE(nullptr, output);
+  EXPECT_EQ(1, output->num_rows());
+  EXPECT_FALSE(coalescer.FlushDue());
+  EXPECT_EQ(nullptr, coalescer.Flush(mem_pool).ConsumeValueOrDie());
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,452 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/row_sorter.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <string_view>
+#include <utility>
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/substitute.h>
+
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/shared/types/type_utils.h"
+
+DEFINE_int64(carnot_sort_memory_budget_bytes,
+             gflags::Int64FromEnv("PL_CARNOT_SORT_MEMORY_BUDGET_BYTES", 64 * 1024 * 1024),
+             "The bytes of rows a sort buffers before sorting them into a run, which is spilled "
+             "to --carnot_sort_spill_dir.");
+DEFINE_string(carnot_sort_spill_dir, gflags::StringFromEnv("PL_CARNOT_SORT_SPILL_DIR", ""),
+              "The directory that sorts spill their sorted runs to. If empty, sorts are done "
+              "entirely in memory.");
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowBatch;
+using table_store::schema::RowDescriptor;
+
+namespace {
+// The number of rows of a spilled run that are written, and read back, at a time.
+constexpr int64_t kSpillChunkRows = 8192;
+// The radix sort goes over 16 bits of the keys per pass.
+constexpr int kRadixBits = 16;
+constexpr size_t kRadixBuckets = 1 << kRadixBits;
+
+template <types::DataType DT>
+int CompareValues(const arrow::Array* left, int64_t left_idx, const arrow::Array* right,
+                  int64_t right_idx) {
+  if constexpr (DT == types::STRING) {
+    int32_t left_len;
+    int32_t right_len;
+    const uint8_t* left_val = static_cast<const arrow::StringArray*>(left)->GetValue(left_idx,
+                                                                                    &left_len);
+    const uint8_t* right_val =
+        static_cast<const arrow::StringArray*>(right)->GetValue(right_idx, &right_len);
+    return std::string_view(reinterpret_cast<const char*>(left_val), left_len)
+        .compare(std::string_view(reinterpret_cast<const char*>(right_val), right_len));
+  } else {
+    auto left_val = types::GetValueFromArrowArray<DT>(left, left_idx);
+    auto right_val = types::GetValueFromArrowArray<DT>(right, right_idx);
+    if (left_val < right_val) {
+      return -1;
+    }
+    return right_val < left_val ? 1 : 0;
+  }
+}
+
+std::unique_ptr<types::ColumnWrapper> MakeWrapper(types::DataType dt, int64_t reserve) {
+  auto wrapper = types::ColumnWrapper::Make(dt, 0);
+  wrapper->Reserve(reserve);
+  return wrapper;
+}
+
+void AppendValue(types::DataType dt, types::ColumnWrapper* wrapper, arrow::Array* arr,
+                 int64_t row_idx) {
+#define TYPE_CASE(_dt_) types::ExtractValueToColumnWrapper<_dt_>(wrapper, arr, row_idx);
+  PL_SWITCH_FOREACH_DATATYPE(dt, TYPE_CASE);
+#undef TYPE_CASE
+}
+}  // namespace
+
+// A sorted run of rows, either in memory or in a spill file.
+struct RowSorter::Run {
+  ~Run() {
+    if (!path.empty()) {
+      std::error_code ec;
+      std::filesystem::remove(path, ec);
+    }
+  }
+
+  int64_t num_rows = 0;
+  // Set for runs kept in memory.
+  Columns cols;
+  // Set for spilled runs.
+  std::filesystem::path path;
+};
+
+// Reads the rows of a run in order. Spilled runs are read one chunk at a time.
+class RowSorter::RunCursor {
+ public:
+  RunCursor(const Run* run, size_t run_idx) : run_(run), run_idx_(run_idx) {}
+
+  Status Init() {
+    if (run_->path.empty()) {
+      cols_ = run_->cols;
+      num_rows_ = run_->num_rows;
+      return Status::OK();
+    }
+    file_.open(run_->path, std::ios::binary);
+    if (!file_) {
+      return error::Internal("Failed to open spilled sort run $0", run_->path.string());
+    }
+    return LoadChunk();
+  }
+
+  Status Next() {
+    if (++row_ < num_rows_ || run_->path.empty()) {
+      return Status::OK();
+    }
+    return LoadChunk();
+  }
+
+  bool done() const { return row_ >= num_rows_; }
+  const Columns& cols() const { return cols_; }
+  int64_t row() const { return row_; }
+  size_t run_idx() const { return run_idx_; }
+
+ private:
+  Status LoadChunk() {
+    row_ = 0;
+    num_rows_ = 0;
+    cols_.clear();
+    uint64_t size;
+    if (!file_.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+      // The end of the run.
+      return Status::OK();
+    }
+    buf_.resize(size);
+    if (!file_.read(buf_.data(), size)) {
+      return error::Internal("Spilled sort run $0 is truncated", run_->path.string());
+    }
+    table_store::schemapb::RowBatchData proto;
+    if (!proto.ParseFromString(buf_)) {
+      return error::Internal("Failed to parse spilled sort run $0", run_->path.string());
+    }
+    PL_ASSIGN_OR_RETURN(auto rb, RowBatch::FromProto(std::move(proto)));
+    cols_ = rb->columns();
+    num_rows_ = rb->num_rows();
+    return Status::OK();
+  }
+
+  const Run* run_;
+  const size_t run_idx_;
+  std::ifstream file_;
+  std::string buf_;
+  Columns cols_;
+  int64_t num_rows_ = 0;
+  int64_t row_ = 0;
+};
+
+RowSorter::RowSorter(std::vector<types::DataType> types, std::vector<int64_t> sort_cols,
+                     bool ascending, int64_t memory_budget_bytes, std::filesystem::path spill_dir)
+    : types_(std::move(types)),
+      sort_cols_(std::move(sort_cols)),
+      ascending_(ascending),
+      memory_budget_bytes_(memory_budget_bytes),
+      spill_dir_(std::move(spill_dir)) {
+  for (int64_t sort_col : sort_cols_) {
+    DCHECK_LT(sort_col, static_cast<int64_t>(types_.size()));
+    compare_fns_.push_back(GetCompareFn(types_[sort_col]));
+  }
+}
+
+RowSorter::~RowSorter() = default;
+
+RowSorter::CompareFn RowSorter::GetCompareFn(types::DataType type) {
+#define TYPE_CASE(_dt_) return &CompareValues<_dt_>;
+  PL_SWITCH_FOREACH_DATATYPE(type, TYPE_CASE);
+#undef TYPE_CASE
+}
+
+int RowSorter::CompareRows(const Columns& a_cols, int64_t a_idx, const Columns& b_cols,
+                           int64_t b_idx) const {
+  for (const auto& [i, sort_col] : Enumerate(sort_cols_)) {
+    int cmp = compare_fns_[i](a_cols[sort_col].get(), a_idx, b_cols[sort_col].get(), b_idx);
+    if (cmp != 0) {
+      return ascending_ ? cmp : -cmp;
+    }
+  }
+  return 0;
+}
+
+Status RowSorter::Add(const RowBatch& rb, arrow::MemoryPool* pool) {
+  if (rb.num_rows() == 0) {
+    return Status::OK();
+  }
+  buffered_.push_back(rb.columns());
+  buffered_bytes_ += rb.NumBytes();
+  // Without a spill directory there is nothing to gain from sorting runs early, since they'd be
+  // kept in memory anyway.
+  if (!spill_dir_.empty() && buffered_bytes_ > memory_budget_bytes_) {
+    return SortBuffered(pool);
+  }
+  return Status::OK();
+}
+
+bool RowSorter::RadixSortBuffered(std::vector<BufferedRow>* rows) const {
+  if (sort_cols_.size() != 1 || rows->empty()) {
+    return false;
+  }
+  int64_t sort_col = sort_cols_[0];
+  types::DataType dt = types_[sort_col];
+  if (dt != types::INT64 && dt != types::TIME64NS && dt != types::BOOLEAN) {
+    return false;
+  }
+
+  // Normalize the keys so that they sort as unsigned integers in the output order.
+  std::vector<std::pair<uint64_t, BufferedRow>> keyed;
+  keyed.reserve(rows->size());
+  for (const auto& row : *rows) {
+    const arrow::Array* arr = buffered_[row.batch_idx][sort_col].get();
+    uint64_t key;
+    if (dt == types::BOOLEAN) {
+      key = types::GetValueFromArrowArray<types::BOOLEAN>(arr, row.row_idx) ? 1 : 0;
+    } else if (dt == types::INT64) {
+      key = static_cast<uint64_t>(types::GetValueFromArrowArray<types::INT64>(arr, row.row_idx)) ^
+            (uint64_t{1} << 63);
+    } else {
+      key = static_cast<uint64_t>(
+                types::GetValueFromArrowArray<types::TIME64NS>(arr, row.row_idx)) ^
+            (uint64_t{1} << 63);
+    }
+    keyed.emplace_back(ascending_ ? key : ~key, row);
+  }
+
+  // A stable LSD radix sort, which skips the digits that all keys share.
+  std::vector<std::pair<uint64_t, BufferedRow>> sorted(keyed.size());
+  std::vector<size_t> offsets(kRadixBuckets);
+  constexpr uint64_t kMask = kRadixBuckets - 1;
+  for (int shift = 0; shift < 64; shift += kRadixBits) {
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (const auto& k : keyed) {
+      ++offsets[(k.first >> shift) & kMask];
+    }
+    if (offsets[(keyed[0].first >> shift) & kMask] == keyed.size()) {
+      continue;
+    }
+    size_t sum = 0;
+    for (auto& offset : offsets) {
+      size_t count = offset;
+      offset = sum;
+      sum += count;
+    }
+    for (const auto& k : keyed) {
+      sorted[offsets[(k.first >> shift) & kMask]++] = k;
+    }
+    keyed.swap(sorted);
+  }
+
+  for (const auto& [i, k] : Enumerate(keyed)) {
+    (*rows)[i] = k.second;
+  }
+  return true;
+}
+
+RowSorter::Columns RowSorter::GatherRows(const std::vector<BufferedRow>& rows,
+                                         arrow::MemoryPool* pool) const {
+  Columns cols;
+  cols.reserve(types_.size());
+  for (const auto& [col_idx, dt] : Enumerate(types_)) {
+    auto wrapper = MakeWrapper(dt, rows.size());
+    for (const auto& row : rows) {
+      AppendValue(dt, wrapper.get(), buffered_[row.batch_idx][col_idx].get(), row.row_idx);
+    }
+    cols.push_back(wrapper->ConvertToArrow(pool));
+  }
+  return cols;
+}
+
+Status RowSorter::SortBuffered(arrow::MemoryPool* pool) {
+  if (buffered_.empty()) {
+    return Status::OK();
+  }
+  std::vector<BufferedRow> rows;
+  for (const auto& [batch_idx, cols] : Enumerate(buffered_)) {
+    for (int64_t row_idx = 0; row_idx < cols[0]->length(); ++row_idx) {
+      rows.push_back(BufferedRow{static_cast<uint32_t>(batch_idx), static_cast<uint32_t>(row_idx)});
+    }
+  }
+  if (!RadixSortBuffered(&rows)) {
+    std::stable_sort(rows.begin(), rows.end(), [this](const BufferedRow& a, const BufferedRow& b) {
+      return CompareRows(buffered_[a.batch_idx], a.row_idx, buffered_[b.batch_idx], b.row_idx) <
+             0;
+    });
+  }
+
+  auto run = std::make_unique<Run>();
+  run->num_rows = rows.size();
+  Columns cols = GatherRows(rows, pool);
+  buffered_.clear();
+  buffered_bytes_ = 0;
+
+  if (!spill_dir_.empty()) {
+    Status s = SpillRun(cols, run.get());
+    if (s.ok()) {
+      ++num_spilled_runs_;
+      runs_.push_back(std::move(run));
+      return Status::OK();
+    }
+    LOG(WARNING) << absl::Substitute("Keeping sort run in memory: $0", s.msg());
+  }
+  run->cols = std::move(cols);
+  runs_.push_back(std::move(run));
+  return Status::OK();
+}
+
+Status RowSorter::SpillRun(const Columns& cols, Run* run) {
+  static std::atomic<int64_t> next_run_id = 0;
+
+  std::error_code ec;
+  std::filesystem::create_directories(spill_dir_, ec);
+  std::filesystem::path path =
+      spill_dir_ / absl::StrCat("sort-", getpid(), "-", next_run_id.fetch_add(1));
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return error::Internal("Failed to create spill file $0", path.string());
+  }
+  // The run owns the file from here on, so that it's removed on failure.
+  run->path = path;
+
+  RowDescriptor desc(types_);
+  std::string buf;
+  for (int64_t offset = 0; offset < run->num_rows; offset += kSpillChunkRows) {
+    int64_t num_rows = std::min(kSpillChunkRows, run->num_rows - offset);
+    RowBatch chunk(desc, num_rows);
+    for (const auto& col : cols) {
+      PL_RETURN_IF_ERROR(chunk.AddColumn(col->Slice(offset, num_rows)));
+    }
+    table_store::schemapb::RowBatchData proto;
+    PL_RETURN_IF_ERROR(chunk.ToArrowProto(&proto));
+    if (!proto.SerializeToString(&buf)) {
+      return error::Internal("Failed to serialize sort run");
+    }
+    uint64_t size = buf.size();
+    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    file.write(buf.data(), buf.size());
+  }
+  file.close();
+  if (!file) {
+    return error::Internal("Failed to write spill file $0", path.string());
+  }
+  return Status::OK();
+}
+
+Status RowSorter::Merge(int64_t limit, int64_t batch_rows, arrow::MemoryPool* pool,
+                        const EmitFn& emit) {
+  PL_RETURN_IF_ERROR(SortBuffered(pool));
+  // Clear the runs (and remove their files) however the merge ends.
+  DEFER(Reset());
+
+  // A single run in memory is already in order.
+  if (runs_.size() == 1 && runs_[0]->path.empty()) {
+    const Run& run = *runs_[0];
+    int64_t num_rows = std::min(limit, run.num_rows);
+    for (int64_t offset = 0; offset < num_rows; offset += batch_rows) {
+      int64_t len = std::min(batch_rows, num_rows - offset);
+      Columns out;
+      for (const auto& col : run.cols) {
+        out.push_back(col->Slice(offset, len));
+      }
+      PL_RETURN_IF_ERROR(emit(std::move(out)));
+    }
+    return Status::OK();
+  }
+
+  std::vector<std::unique_ptr<RunCursor>> cursors;
+  std::vector<RunCursor*> heap;
+  for (const auto& [i, run] : Enumerate(runs_)) {
+    cursors.push_back(std::make_unique<RunCursor>(run.get(), i));
+    PL_RETURN_IF_ERROR(cursors.back()->Init());
+    if (!cursors.back()->done()) {
+      heap.push_back(cursors.back().get());
+    }
+  }
+  // The front of the heap is the cursor whose row comes first. Ties go to the earlier run, which
+  // holds the rows that were added first.
+  auto after = [this](const RunCursor* a, const RunCursor* b) {
+    int cmp = CompareRows(a->cols(), a->row(), b->cols(), b->row());
+    return cmp != 0 ? cmp > 0 : a->run_idx() > b->run_idx();
+  };
+  std::make_heap(heap.begin(), heap.end(), after);
+
+  std::vector<std::unique_ptr<types::ColumnWrapper>> wrappers;
+  for (auto dt : types_) {
+    wrappers.push_back(MakeWrapper(dt, batch_rows));
+  }
+  auto flush = [&]() -> Status {
+    Columns out;
+    for (const auto& [col_idx, dt] : Enumerate(types_)) {
+      out.push_back(wrappers[col_idx]->ConvertToArrow(pool));
+      wrappers[col_idx] = MakeWrapper(dt, batch_rows);
+    }
+    return emit(std::move(out));
+  };
+
+  int64_t num_emitted = 0;
+  int64_t num_buffered = 0;
+  while (!heap.empty() && num_emitted < limit) {
+    std::pop_heap(heap.begin(), heap.end(), after);
+    RunCursor* cursor = heap.back();
+    for (const auto& [col_idx, dt] : Enumerate(types_)) {
+      AppendValue(dt, wrappers[col_idx].get(), cursor->cols()[col_idx].get(), cursor->row());
+    }
+    ++num_emitted;
+    if (++num_buffered == batch_rows) {
+      PL_RETURN_IF_ERROR(flush());
+      num_buffered = 0;
+    }
+    PL_RETURN_IF_ERROR(cursor->Next());
+    if (cursor->done()) {
+      heap.pop_back();
+    } else {
+      std::push_heap(heap.begin(), heap.end(), after);
+    }
+  }
+  if (num_buffered > 0) {
+    PL_RETURN_IF_ERROR(flush());
+  }
+  return Status::OK();
+}
+
+void RowSorter::Reset() {
+  buffered_.clear();
+  buffered_bytes_ = 0;
+  runs_.clear();
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
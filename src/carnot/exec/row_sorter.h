@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/schema/row_batch.h"
+
+DECLARE_int64(carnot_sort_memory_budget_bytes);
+DECLARE_string(carnot_sort_spill_dir);
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+/**
+ * RowSorter sorts all the rows it's given by a set of columns, for ordered limits that keep too
+ * many rows for a heap.
+ *
+ * Rows are buffered until they go over the memory budget, then sorted into a run. Runs are
+ * spilled to a file in the spill directory, if there is one, and otherwise kept in memory. Once
+ * all rows are added, the runs are merged with a k-way merge into the output, reading spilled
+ * runs back one chunk at a time.
+ *
+ * The sort is stable: rows with equal sort columns come out in the order they were added.
+ *
+ * Not thread-safe.
+ */
+class RowSorter : public NotCopyable {
+ public:
+  using ArrayPtr = std::shared_ptr<arrow::Array>;
+  using Columns = std::vector<ArrayPtr>;
+  using EmitFn = std::function<Status(Columns)>;
+
+  /**
+   * @param types the types of the columns of the rows.
+   * @param sort_cols the indexes of the columns to sort by, in order of precedence.
+   * @param memory_budget_bytes the bytes of rows to buffer before sorting them into a run.
+   * @param spill_dir where to spill sorted runs, or empty to keep them in memory.
+   */
+  RowSorter(std::vector<types::DataType> types, std::vector<int64_t> sort_cols, bool ascending,
+            int64_t memory_budget_bytes, std::filesystem::path spill_dir);
+  ~RowSorter();
+
+  Status Add(const table_store::schema::RowBatch& rb, arrow::MemoryPool* pool);
+
+  /**
+   * Merges the rows added so far and passes them, in order, to emit in batches of at most
+   * batch_rows rows, stopping after limit rows. The sorter is empty afterwards.
+   */
+  Status Merge(int64_t limit, int64_t batch_rows, arrow::MemoryPool* pool, const EmitFn& emit);
+
+  int64_t num_spilled_runs() const { return num_spilled_runs_; }
+
+  // Compares the values of two rows of a column, returns <0, 0 or >0.
+  using CompareFn = int (*)(const arrow::Array* left, int64_t left_idx, const arrow::Array* right,
+                            int64_t right_idx);
+  static CompareFn GetCompareFn(types::DataType type);
+
+ private:
+  struct Run;
+  class RunCursor;
+
+  // A row of the buffered batches.
+  struct BufferedRow {
+    uint32_t batch_idx;
+    uint32_t row_idx;
+  };
+
+  // Sorts the buffered rows into a new run.
+  Status SortBuffered(arrow::MemoryPool* pool);
+  // Sorts rows by a single integer column with a radix sort on its normalized keys.
+  bool RadixSortBuffered(std::vector<BufferedRow>* rows) const;
+  Status SpillRun(const Columns& cols, Run* run);
+  Columns GatherRows(const std::vector<BufferedRow>& rows, arrow::MemoryPool* pool) const;
+  int CompareRows(const Columns& a_cols, int64_t a_idx, const Columns& b_cols,
+                  int64_t b_idx) const;
+  void Reset();
+
+  const std::vector<types::DataType> types_;
+  const std::vector<int64_t> sort_cols_;
+  const bool ascending_;
+  const int64_t memory_budget_bytes_;
+  const std::filesystem::path spill_dir_;
+  std::vector<CompareFn> compare_fns_;
+
+  std::vector<Columns> buffered_;
+  int64_t buffered_bytes_ = 0;
+  std::vector<std::unique_ptr<Run>> runs_;
+  int64_t num_spilled_runs_ = 0;
+};
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/exec/row_sorter.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/carnot/exec/test_utils.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+using table_store::schema::RowDescriptor;
+
+namespace {
+// Runs the merge and returns the int64 values of col in the order they came out.
+std::vector<int64_t> MergeColumn(RowSorter* sorter, int64_t limit, int64_t batch_rows,
+                                 int64_t col, int64_t* num_batches = nullptr) {
+  std::vector<int64_t> out;
+  int64_t batches = 0;
+  EXPECT_OK(sorter->Merge(limit, batch_rows, arrow::default_memory_pool(),
+                          [&](RowSorter::Columns cols) {
+                            EXPECT_LE(cols[col]->length(), batch_rows);
+                            auto arr = std::static_pointer_cast<arrow::Int64Array>(cols[col]);
+                            for (int64_t i = 0; i < arr->length(); ++i) {
+                              out.push_back(arr->Value(i));
+                            }
+                            ++batches;
+                            return Status::OK();
+                          }));
+  if (num_batches != nullptr) {
+    *num_batches = batches;
+  }
+  return out;
+}
+}  // namespace
+
+TEST(RowSorterTest, multi_column) {
+  RowDescriptor rd({types::STRING, types::INT64, types::INT64});
+  RowSorter sorter(rd.types(), /*sort_cols*/ {0, 1}, /*ascending*/ true,
+                   /*memory_budget_bytes*/ 1 << 20, /*spill_dir*/ "");
+  ASSERT_OK(sorter.Add(RowBatchBuilder(rd, 4, false, false)
+                           .AddColumn<types::StringValue>({"b", "a", "b", "a"})
+                           .AddColumn<types::Int64Value>({2, 3, 1, 1})
+                           .AddColumn<types::Int64Value>({0, 1, 2, 3})
+                           .get(),
+                       arrow::default_memory_pool()));
+  ASSERT_OK(sorter.Add(RowBatchBuilder(rd, 2, false, false)
+                           .AddColumn<types::StringValue>({"a", "c"})
+                           .AddColumn<types::Int64Value>({2, 0})
+                           .AddColumn<types::Int64Value>({4, 5})
+                           .get(),
+                       arrow::default_memory_pool()));
+  EXPECT_EQ(std::vector<int64_t>({3, 4, 1, 2, 0, 5}), MergeColumn(&sorter, 100, 10, 2));
+  EXPECT_EQ(0, sorter.num_spilled_runs());
+}
+
+TEST(RowSorterTest, radix_sort_is_stable) {
+  RowDescriptor rd({types::INT64, types::INT64});
+  RowSorter sorter(rd.types(), /*sort_cols*/ {0}, /*ascending*/ false,
+                   /*memory_budget_bytes*/ 1 << 20, /*spill_dir*/ "");
+  ASSERT_OK(sorter.Add(RowBatchBuilder(rd, 6, false, false)
+                           .AddColumn<types::Int64Value>({-5, 7, 0, 7, -5, 1LL << 40})
+                           .AddColumn<types::Int64Value>({0, 1, 2, 3, 4, 5})
+                           .get(),
+                       arrow::default_memory_pool()));
+  int64_t num_batches;
+  EXPECT_EQ(std::vector<int64_t>({5, 1, 3, 2, 0, 4}),
+            MergeColumn(&sorter, 100, 4, 1, &num_batches));
+  EXPECT_EQ(2, num_batches);
+}
+
+TEST(RowSorterTest, spills_and_merges_runs) {
+  std::filesystem::path spill_dir =
+      std::filesystem::path(::testing::TempDir()) / "row_sorter_test";
+  RowDescriptor rd({types::INT64, types::FLOAT64});
+  // The budget is small enough that every batch becomes its own run.
+  RowSorter sorter(rd.types(), /*sort_cols*/ {1}, /*ascending*/ true,
+                   /*memory_budget_bytes*/ 1, spill_dir);
+  std::vector<int64_t> expected;
+  for (int64_t i = 0; i < 10; ++i) {
+    std::vector<types::Int64Value> ids;
+    std::vector<types::Float64Value> vals;
+    for (int64_t j = 0; j < 10; ++j) {
+      ids.push_back(j * 10 + i);
+      vals.push_back(static_cast<double>(j));
+      expected.push_back(i * 10 + j);
+    }
+    ASSERT_OK(sorter.Add(RowBatchBuilder(rd, ids.size(), false, false)
+                             .AddColumn<types::Int64Value>(ids)
+                             .AddColumn<types::Float64Value>(vals)
+                             .get(),
+                         arrow::default_memory_pool()));
+  }
+  EXPECT_EQ(10, sorter.num_spilled_runs());
+  expected.resize(95);
+  EXPECT_EQ(expected, MergeColumn(&sorter, 95, 16, 0));
+  // The spill files are removed once the runs are merged.
+  EXPECT_TRUE(std::filesystem::is_empty(spill_dir));
+}
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
@@ -251,6 +251,27 @@ void ExtractIntoRowTuple(RowTuple* rt, arrow::Array* col, int rt_col_idx, int rt
                              types::GetValue(static_cast<ArrowArrayType*>(col), rt_row_idx));
 }
 
+/**
+ * Extracts the values of col into column key_idx of the packed, row major, fixed width keys.
+ * keys must hold col->length() * num_keys values.
+ */
+template <types::DataType DT>
+void ExtractIntoFixedWidthKeys(const arrow::Array* col, size_t num_keys, size_t key_idx,
+                               types::FixedSizeValueUnion* keys) {
+  using ValueType = typename types::DataTypeTraits<DT>::value_type;
+  using ArrowArrayType = typename types::DataTypeTraits<DT>::arrow_array_type;
+  if constexpr (types::ValueTypeTraits<ValueType>::is_fixed_size) {
+    auto typed_col = static_cast<const ArrowArrayType*>(col);
+    auto num_rows = col->length();
+    for (int64_t row_idx = 0; row_idx < num_rows; ++row_idx) {
+      types::SetValue<ValueType>(&keys[row_idx * num_keys + key_idx],
+                                 types::GetValue(typed_col, row_idx));
+    }
+  } else {
+    DCHECK(false) << "Variable size types can't be used as fixed width keys";
+  }
+}
+
 }  // namespace exec
 }  // namespace carnot
 }  // namespace px
@@ -36,6 +36,10 @@
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
 #include "src/table_store/table_store.h"
 
+DEFINE_int64(carnot_udtf_batch_bytes, 1024 * 1024,
+             "The most bytes of records that a UDTF source outputs in one row batch. UDTFs that "
+             "return large records, such as metadata dumps, output them over several batches.");
+
 namespace px {
 namespace carnot {
 namespace exec {
@@ -102,7 +106,7 @@ Status UDTFSourceNode::GenerateNextImpl(ExecState* exec_state) {
   std::vector<std::unique_ptr<arrow::ArrayBuilder>> outputs;
 
   for (const auto& r : udtf_def_->output_relation()) {
-    outputs.emplace_back(types::MakeArrowBuilder(r.type(), arrow::default_memory_pool()));
+    outputs.emplace_back(types::MakeArrowBuilder(r.type(), exec_state->exec_mem_pool()));
   }
 
   // TODO(zasgar): Change Exec to take in unique_ptrs.
@@ -111,8 +115,9 @@ Status UDTFSourceNode::GenerateNextImpl(ExecState* exec_state) {
     outputs_raw.emplace_back(out.get());
   }
 
-  auto has_more_batches = udtf_def_->ExecBatchUpdate(udtf_inst_.get(), function_ctx_.get(),
-                                                     kUDTFBatchSize, &outputs_raw);
+  auto has_more_batches =
+      udtf_def_->ExecBatchUpdate(udtf_inst_.get(), function_ctx_.get(), kUDTFBatchSize,
+                                 &outputs_raw, FLAGS_carnot_udtf_batch_bytes);
 
   DCHECK_GT(outputs.size(), 0);
 
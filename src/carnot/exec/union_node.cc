@@ -41,6 +41,42 @@ namespace exec {
 using table_store::schema::RowBatch;
 using table_store::schema::RowDescriptor;
 
+namespace {
+
+// Appends rows [offset, offset + length) of the array to the builder. Fixed width columns are
+// appended with a single copy.
+template <types::DataType T>
+Status AppendArraySlice(const arrow::Array* arr, int64_t offset, int64_t length,
+                        arrow::ArrayBuilder* builder) {
+  if constexpr (T == types::INT64 || T == types::TIME64NS || T == types::FLOAT64) {
+    using ArrayType = typename types::DataTypeTraits<T>::arrow_array_type;
+    using BuilderType = typename types::DataTypeTraits<T>::arrow_builder_type;
+    const auto* typed_arr = static_cast<const ArrayType*>(arr);
+    PL_RETURN_IF_ERROR(
+        static_cast<BuilderType*>(builder)->AppendValues(typed_arr->raw_values() + offset, length));
+  } else if constexpr (T == types::STRING) {
+    // Reserve the slice's bytes up front and append views of the strings.
+    const auto* typed_arr = static_cast<const arrow::StringArray*>(arr);
+    auto* typed_builder = static_cast<arrow::StringBuilder*>(builder);
+    PL_RETURN_IF_ERROR(typed_builder->Reserve(length));
+    PL_RETURN_IF_ERROR(typed_builder->ReserveData(typed_arr->value_offset(offset + length) -
+                                                  typed_arr->value_offset(offset)));
+    for (int64_t i = offset; i < offset + length; ++i) {
+      int32_t value_length;
+      const uint8_t* value = typed_arr->GetValue(i, &value_length);
+      typed_builder->UnsafeAppend(value, value_length);
+    }
+  } else {
+    for (int64_t i = offset; i < offset + length; ++i) {
+      PL_RETURN_IF_ERROR(table_store::schema::CopyValue<T>(
+          builder, types::GetValueFromArrowArray<T>(arr, i)));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 std::string UnionNode::DebugStringImpl() {
   return absl::Substitute("Exec::UnionNode<$0>", absl::StrJoin(plan_node_->column_names(), ","));
 }
@@ -56,16 +92,16 @@ Status UnionNode::InitImpl(const plan::Operator& plan_node) {
   return Status::OK();
 }
 
-Status UnionNode::InitializeColumnBuilders() {
+Status UnionNode::InitializeColumnBuilders(ExecState* exec_state) {
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
     column_builders_[i] =
-        MakeArrowBuilder(output_descriptor_->type(i), arrow::default_memory_pool());
+        MakeArrowBuilder(output_descriptor_->type(i), exec_state->exec_mem_pool());
     PL_RETURN_IF_ERROR(column_builders_[i]->Reserve(output_rows_per_batch_));
   }
   return Status::OK();
 }
 
-Status UnionNode::PrepareImpl(ExecState*) {
+Status UnionNode::PrepareImpl(ExecState* exec_state) {
   size_t num_output_cols = output_descriptor_->size();
 
   flushed_parent_eoses_.resize(num_parents_);
@@ -78,7 +114,7 @@ Status UnionNode::PrepareImpl(ExecState*) {
     data_columns_.resize(num_parents_, std::vector<arrow::Array*>(num_output_cols));
 
     column_builders_.resize(num_output_cols);
-    PL_RETURN_IF_ERROR(InitializeColumnBuilders());
+    PL_RETURN_IF_ERROR(InitializeColumnBuilders(exec_state));
   }
 
   return Status::OK();
@@ -86,7 +122,12 @@ Status UnionNode::PrepareImpl(ExecState*) {
 
 Status UnionNode::OpenImpl(ExecState*) { return Status::OK(); }
 
-Status UnionNode::CloseImpl(ExecState*) { return Status::OK(); }
+Status UnionNode::CloseImpl(ExecState*) {
+  if (plan_node_->order_by_time()) {
+    stats()->AddExtraInfo("batches_passed_through", std::to_string(batches_passed_through_));
+  }
+  return Status::OK();
+}
 
 bool UnionNode::InputsComplete() {
   for (bool parent_eos : flushed_parent_eoses_) {
@@ -111,13 +152,29 @@ types::Time64NSValue UnionNode::GetTimeAtParentCursor(size_t parent_index) const
                                                         row_cursors_[parent_index]);
 }
 
-Status UnionNode::AppendRow(size_t parent) {
-  auto row = row_cursors_[parent];
+int64_t UnionNode::RunEnd(size_t parent, std::optional<size_t> limit_parent) const {
+  const auto* times = static_cast<const arrow::Int64Array*>(time_columns_[parent]);
+  if (!limit_parent.has_value()) {
+    return times->length();
+  }
+  // The time column of a parent is sorted, so the run ends at the first row past the limit. Rows
+  // at the limit's time only belong to the run if the parent is at a smaller index, so that rows
+  // are always stable with respect to input parent index.
+  const int64_t* begin = times->raw_values() + row_cursors_[parent];
+  const int64_t* end = times->raw_values() + times->length();
+  int64_t limit_time = GetTimeAtParentCursor(limit_parent.value()).val;
+  if (parent < limit_parent.value()) {
+    return std::upper_bound(begin, end, limit_time) - times->raw_values();
+  }
+  return std::lower_bound(begin, end, limit_time) - times->raw_values();
+}
+
+Status UnionNode::AppendRun(size_t parent, int64_t offset, int64_t num_rows) {
   for (size_t i = 0; i < output_descriptor_->size(); ++i) {
     auto input_col = data_columns_[parent][i];
-#define TYPE_CASE(_dt_)                                    \
-  PL_RETURN_IF_ERROR(table_store::schema::CopyValue<_dt_>( \
-      column_builders_[i].get(), types::GetValueFromArrowArray<_dt_>(input_col, row)));
+    auto* builder = column_builders_[i].get();
+#define TYPE_CASE(_dt_) \
+  PL_RETURN_IF_ERROR(AppendArraySlice<_dt_>(input_col, offset, num_rows, builder));
     PL_SWITCH_FOREACH_DATATYPE(output_descriptor_->type(i), TYPE_CASE);
 #undef TYPE_CASE
   }
@@ -164,80 +221,121 @@ Status UnionNode::FlushBatch(ExecState* exec_state) {
   bool eos = InputsComplete();
   PL_ASSIGN_OR_RETURN(auto rb, RowBatch::FromColumnBuilders(*output_descriptor_, /*eow*/ eos,
                                                             /*eos*/ eos, &column_builders_));
-  PL_RETURN_IF_ERROR(InitializeColumnBuilders());
+  PL_RETURN_IF_ERROR(InitializeColumnBuilders(exec_state));
   last_data_flush_time_ = std::chrono::system_clock::now();
   return SendRowBatchToChildren(exec_state, *rb);
 }
 
-Status UnionNode::MergeData(ExecState* exec_state) {
-  while (!sent_eos_) {
-    // Get the smallest time out of all of the current streams.
-    std::vector<size_t> parent_streams;
-    parent_streams.reserve(row_cursors_.size());
-
-    for (size_t parent = 0; parent < row_cursors_.size(); ++parent) {
-      if (flushed_parent_eoses_[parent]) {
-        continue;
-      }
-      // If we lack necessary data, we can't merge anymore.
-      if (!parent_row_batches_[parent].size()) {
-        return Status::OK();
-      }
-      parent_streams.push_back(parent);
-    }
+void UnionNode::PopRowBatch(size_t parent) {
+  if (parent_row_batches_[parent][0].eos()) {
+    flushed_parent_eoses_[parent] = true;
+  }
+  // Delete the top row batch from our buffer and update the cursor.
+  parent_row_batches_[parent].erase(parent_row_batches_[parent].begin());
+  row_cursors_[parent] = 0;
+  CacheNextRowBatch(parent);
+}
+
+Status UnionNode::PassThroughRowBatch(ExecState* exec_state, size_t parent) {
+  RowBatch input_rb = parent_row_batches_[parent][0];
+  PopRowBatch(parent);
+
+  RowBatch output_rb(*output_descriptor_, input_rb.num_rows());
+  for (size_t i = 0; i < output_descriptor_->size(); ++i) {
+    PL_RETURN_IF_ERROR(output_rb.AddColumn(GetInputColumn(input_rb, parent, i)));
+  }
+  bool eos = InputsComplete();
+  output_rb.set_eow(eos);
+  output_rb.set_eos(eos);
+  last_data_flush_time_ = std::chrono::system_clock::now();
+  ++batches_passed_through_;
+  return SendRowBatchToChildren(exec_state, output_rb);
+}
 
-    // If we have reached end of stream for all of our inputs, flush the queue.
-    if (!parent_streams.size()) {
-      return OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state);
+Status UnionNode::MergeRun(ExecState* exec_state, size_t parent,
+                           std::optional<size_t> limit_parent) {
+  while (parent_row_batches_[parent].size()) {
+    int64_t begin = row_cursors_[parent];
+    int64_t end = RunEnd(parent, limit_parent);
+    if (end == begin) {
+      return Status::OK();
+    }
+    int64_t num_rows = parent_row_batches_[parent][0].num_rows();
+    int64_t output_rows = column_builders_[0]->length();
+    // A whole row batch that is at least as big as an output batch doesn't need to be copied.
+    if (begin == 0 && end == num_rows && output_rows == 0 &&
+        num_rows >= static_cast<int64_t>(output_rows_per_batch_)) {
+      PL_RETURN_IF_ERROR(PassThroughRowBatch(exec_state, parent));
+      continue;
     }
 
-    std::sort(parent_streams.begin(), parent_streams.end(),
-              [this](size_t parent_a, size_t parent_b) {
-                auto time_a = GetTimeAtParentCursor(parent_a);
-                auto time_b = GetTimeAtParentCursor(parent_b);
-                return time_a < time_b || (time_a == time_b && parent_a < parent_b);
-              });
-
-    bool has_limit = parent_streams.size() > 1;
-    size_t parent = parent_streams[0];
-
-    while (parent_row_batches_[parent].size()) {
-      if (has_limit) {
-        size_t next_parent = parent_streams[1];
-        // If this time is greater than another parent stream's earliest time,
-        // or if they are the same but the first parent is at a smaller index, stop merging.
-        // This way rows are always stable with respect to input parent index.
-        if (GetTimeAtParentCursor(parent) > GetTimeAtParentCursor(next_parent) ||
-            (GetTimeAtParentCursor(parent) == GetTimeAtParentCursor(next_parent) &&
-             parent > next_parent)) {
-          break;
-        }
-      }
-
-      PL_RETURN_IF_ERROR(AppendRow(parent));
-
-      // Mark whether or not we hit the eos for this stream, and whether the row batch needs to be
-      // popped.
-      const auto& rb = parent_row_batches_[parent][0];
-      bool pop_row_batch = ++row_cursors_[parent] == static_cast<size_t>(rb.num_rows());
-      if (pop_row_batch && rb.eos()) {
-        flushed_parent_eoses_[parent] = true;
-      }
-
-      if (pop_row_batch) {
-        // Delete the top row batch from our buffer and update the cursor.
-        parent_row_batches_[parent].erase(parent_row_batches_[parent].begin());
-        row_cursors_[parent] = 0;
-        CacheNextRowBatch(parent);
-      }
-
-      // Flush the current RowBatch if necessary.
-      PL_RETURN_IF_ERROR(OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state));
+    int64_t run_rows =
+        std::min(end - begin, static_cast<int64_t>(output_rows_per_batch_) - output_rows);
+    PL_RETURN_IF_ERROR(AppendRun(parent, begin, run_rows));
+    row_cursors_[parent] += run_rows;
+    if (row_cursors_[parent] == static_cast<size_t>(num_rows)) {
+      PopRowBatch(parent);
     }
+
+    // Flush the current RowBatch if necessary.
+    PL_RETURN_IF_ERROR(OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state));
   }
   return Status::OK();
 }
 
+Status UnionNode::MergeData(ExecState* exec_state) {
+  if (sent_eos_) {
+    return Status::OK();
+  }
+  // A heap of the parent streams, with the parent that has the smallest time at its cursor on
+  // top. Ties go to the parent at the smaller index.
+  std::vector<size_t> parent_streams;
+  parent_streams.reserve(row_cursors_.size());
+  for (size_t parent = 0; parent < row_cursors_.size(); ++parent) {
+    if (flushed_parent_eoses_[parent]) {
+      continue;
+    }
+    // If we lack necessary data, we can't merge anymore.
+    if (!parent_row_batches_[parent].size()) {
+      return Status::OK();
+    }
+    parent_streams.push_back(parent);
+  }
+  auto comes_after = [this](size_t parent_a, size_t parent_b) {
+    auto time_a = GetTimeAtParentCursor(parent_a);
+    auto time_b = GetTimeAtParentCursor(parent_b);
+    return time_a > time_b || (time_a == time_b && parent_a > parent_b);
+  };
+  std::make_heap(parent_streams.begin(), parent_streams.end(), comes_after);
+
+  while (parent_streams.size()) {
+    std::pop_heap(parent_streams.begin(), parent_streams.end(), comes_after);
+    size_t parent = parent_streams.back();
+    parent_streams.pop_back();
+
+    std::optional<size_t> limit_parent;
+    if (parent_streams.size()) {
+      limit_parent = parent_streams.front();
+    }
+    PL_RETURN_IF_ERROR(MergeRun(exec_state, parent, limit_parent));
+
+    if (flushed_parent_eoses_[parent]) {
+      continue;
+    }
+    if (!parent_row_batches_[parent].size()) {
+      return Status::OK();
+    }
+    parent_streams.push_back(parent);
+    std::push_heap(parent_streams.begin(), parent_streams.end(), comes_after);
+  }
+
+  // We have reached end of stream for all of our inputs, so flush the queue.
+  if (sent_eos_) {
+    return Status::OK();
+  }
+  return OptionallyFlushRowBatchIfMaxRowsOrEOS(exec_state);
+}
+
 void UnionNode::CacheNextRowBatch(size_t parent) {
   // Purge all of the 0-row RowBatches.
   while (parent_row_batches_[parent].size() && parent_row_batches_[parent][0].num_rows() == 0) {
@@ -22,6 +22,7 @@
 #include <arrow/array/builder_base.h>
 #include <stddef.h>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -89,9 +90,18 @@ class UnionNode : public ProcessingNode {
   // The items below are all for the time-ordered case.
 
   void CacheNextRowBatch(size_t parent);
-  Status InitializeColumnBuilders();
+  Status InitializeColumnBuilders(ExecState* exec_state);
   types::Time64NSValue GetTimeAtParentCursor(size_t parent_index) const;
-  Status AppendRow(size_t parent);
+  // Returns the end of the run of rows in the parent's current row batch that come before the
+  // row at the cursor of limit_parent, if there is one.
+  int64_t RunEnd(size_t parent, std::optional<size_t> limit_parent) const;
+  Status AppendRun(size_t parent, int64_t offset, int64_t num_rows);
+  // Copies the rows of the parent to the output until they reach the row at the cursor of
+  // limit_parent, or the parent has no more row batches.
+  Status MergeRun(ExecState* exec_state, size_t parent, std::optional<size_t> limit_parent);
+  // Sends the parent's current row batch to the children as is.
+  Status PassThroughRowBatch(ExecState* exec_state, size_t parent);
+  void PopRowBatch(size_t parent);
   Status OptionallyFlushRowBatchIfMaxRowsOrEOS(ExecState* exec_state);
   Status OptionallyFlushRowBatchIfTimeout(ExecState* exec_state);
   Status FlushBatch(ExecState* exec_state);
@@ -112,6 +122,9 @@ class UnionNode : public ProcessingNode {
   // Cache current working time and data columns for performance reasons.
   std::vector<arrow::Array*> time_columns_;
   std::vector<std::vector<arrow::Array*>> data_columns_;
+  // The number of row batches that were sent on without being copied, because all of their rows
+  // came before the rows of the other parents.
+  int64_t batches_passed_through_ = 0;
 
   bool enable_data_flush_timeout_ = true;
   // When enable_data_flush_timeout_ is set to true, use this time to decide if we should
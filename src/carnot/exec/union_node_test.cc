@@ -275,6 +275,52 @@ TEST_F(UnionNodeTest, ordered_full_overlap) {
       .Close();
 }
 
+// A row batch that comes entirely before the other parents is sent on without being copied.
+TEST_F(UnionNodeTest, ordered_pass_through) {
+  auto op_proto = planpb::testutils::CreateTestUnionOrderedPB();
+  plan_node_ = plan::UnionOperator::FromProto(op_proto, /*id*/ 1);
+
+  RowDescriptor input_rd_0({types::DataType::STRING, types::DataType::TIME64NS});
+  RowDescriptor input_rd_1({types::DataType::TIME64NS, types::DataType::STRING});
+
+  RowDescriptor output_rd({types::DataType::STRING, types::DataType::TIME64NS});
+
+  auto tester = exec::ExecNodeTester<UnionNode, plan::UnionOperator>(
+      *plan_node_, output_rd, {input_rd_0, input_rd_1}, exec_state_.get());
+  tester.node()->disable_data_flush_timeout();
+
+  tester
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 6, /*eow*/ false, /*eos*/ false)
+                       .AddColumn<types::StringValue>({"A", "B", "C", "D", "E", "F"})
+                       .AddColumn<types::Time64NSValue>({0, 1, 2, 3, 4, 5})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 2, false, false)
+                       .AddColumn<types::Time64NSValue>({10, 11})
+                       .AddColumn<types::StringValue>({"Z", "Y"})
+                       .get(),
+                   1, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 6, false, false)
+                          .AddColumn<types::StringValue>({"A", "B", "C", "D", "E", "F"})
+                          .AddColumn<types::Time64NSValue>({0, 1, 2, 3, 4, 5})
+                          .get())
+      .ConsumeNext(RowBatchBuilder(input_rd_0, 1, true, true)
+                       .AddColumn<types::StringValue>({"H"})
+                       .AddColumn<types::Time64NSValue>({20})
+                       .get(),
+                   0, 0)
+      .ConsumeNext(RowBatchBuilder(input_rd_1, 1, true, true)
+                       .AddColumn<types::Time64NSValue>({12})
+                       .AddColumn<types::StringValue>({"X"})
+                       .get(),
+                   1, 1)
+      .ExpectRowBatch(RowBatchBuilder(output_rd, 4, true, true)
+                          .AddColumn<types::StringValue>({"Z", "Y", "X", "H"})
+                          .AddColumn<types::Time64NSValue>({10, 11, 12, 20})
+                          .get())
+      .Close();
+}
+
 TEST_F(UnionNodeTest, no_rows_parent) {
   auto op_proto = planpb::testutils::CreateTestUnionOrderedPB();
   plan_node_ = plan::UnionOperator::FromProto(op_proto, /*id*/ 1);
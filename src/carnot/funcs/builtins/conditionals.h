@@ -43,6 +43,14 @@ class SelectUDF : public udf::ScalarUDF {
     return v2;
   }
 
+  Status ExecBatch(FunctionContext*, size_t count, const BoolValue* s, const TArg* v1,
+                   const TArg* v2, TArg* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = s[i].val ? v1[i] : v2[i];
+    }
+    return Status::OK();
+  }
+
   static udf::InfRuleVec SemanticInferenceRules() {
     // Match the 1st and 2nd arg.
     return {udf::InheritTypeFromArgs<SelectUDF>::CreateGeneric({1, 2})};
@@ -34,6 +34,19 @@ TEST(ConditionalsTest, SelectUDF) {
   udf_tester.ForInput(true, 20, 21).Expect(20);
 }
 
+TEST(ConditionalsTest, SelectUDFExecBatch) {
+  std::vector<types::BoolValue> s{true, false, true};
+  std::vector<types::Int64Value> v1{1, 2, 3};
+  std::vector<types::Int64Value> v2{10, 20, 30};
+  std::vector<types::Int64Value> out(s.size());
+
+  SelectUDF<types::Int64Value> udf;
+  EXPECT_OK(udf.ExecBatch(nullptr, s.size(), s.data(), v1.data(), v2.data(), out.data()));
+  EXPECT_EQ(1, out[0].val);
+  EXPECT_EQ(20, out[1].val);
+  EXPECT_EQ(3, out[2].val);
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -18,6 +18,8 @@
 
 #include "src/carnot/funcs/builtins/json_ops.h"
 
+#include <limits>
+
 #include "src/carnot/udf/registry.h"
 
 namespace px {
@@ -26,6 +28,143 @@ namespace builtins {
 
 using types::StringValue;
 
+bool JSONValueExtractor::Extract(const char* json) {
+  rapidjson::Reader reader;
+  rapidjson::StringStream stream(json);
+  return !reader.Parse(stream, *this).IsError();
+}
+
+bool JSONValueExtractor::BeginValue(Kind kind) {
+  if (capturing_) {
+    return true;
+  }
+  if (depth_ == 0) {
+    // Scalar roots have no members or elements; StartObject and StartArray check the others.
+    return kind == Kind::kNested;
+  }
+  if (depth_ == 1 && kind_ == Kind::kNotFound &&
+      (index_ < 0 ? key_matched_ : num_root_elements_ == index_)) {
+    kind_ = kind;
+    capturing_ = true;
+  }
+  return true;
+}
+
+void JSONValueExtractor::EndValue() {
+  if (depth_ == 1) {
+    capturing_ = false;
+    key_matched_ = false;
+    ++num_root_elements_;
+  }
+}
+
+bool JSONValueExtractor::Null() {
+  if (!BeginValue(Kind::kNull)) return false;
+  if (capturing_) writer_.Null();
+  EndValue();
+  return true;
+}
+
+bool JSONValueExtractor::Bool(bool b) {
+  if (!BeginValue(Kind::kBool)) return false;
+  if (capturing_) writer_.Bool(b);
+  EndValue();
+  return true;
+}
+
+bool JSONValueExtractor::Int(int i) { return Int64(i); }
+
+bool JSONValueExtractor::Uint(unsigned u) { return Int64(u); }
+
+bool JSONValueExtractor::Int64(int64_t i) {
+  if (!BeginValue(Kind::kInt64)) return false;
+  if (capturing_) {
+    if (depth_ == 1) {
+      int64_value_ = i;
+      double_value_ = static_cast<double>(i);
+    }
+    writer_.Int64(i);
+  }
+  EndValue();
+  return true;
+}
+
+bool JSONValueExtractor::Uint64(uint64_t u) {
+  if (u <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+    return Int64(static_cast<int64_t>(u));
+  }
+  if (!BeginValue(Kind::kUint64)) return false;
+  if (capturing_) {
+    if (depth_ == 1) {
+      double_value_ = static_cast<double>(u);
+    }
+    writer_.Uint64(u);
+  }
+  EndValue();
+  return true;
+}
+
+bool JSONValueExtractor::Double(double d) {
+  if (!BeginValue(Kind::kDouble)) return false;
+  if (capturing_) {
+    if (depth_ == 1) {
+      double_value_ = d;
+    }
+    writer_.Double(d);
+  }
+  EndValue();
+  return true;
+}
+
+bool JSONValueExtractor::String(const char* str, rapidjson::SizeType length, bool copy) {
+  if (!BeginValue(Kind::kString)) return false;
+  if (capturing_) {
+    if (depth_ == 1) {
+      string_value_.assign(str, length);
+    }
+    writer_.String(str, length, copy);
+  }
+  EndValue();
+  return true;
+}
+
+bool JSONValueExtractor::StartObject() {
+  if ((depth_ == 0 && index_ >= 0) || !BeginValue(Kind::kNested)) return false;
+  if (capturing_) writer_.StartObject();
+  ++depth_;
+  return true;
+}
+
+bool JSONValueExtractor::Key(const char* str, rapidjson::SizeType length, bool copy) {
+  if (capturing_) {
+    writer_.Key(str, length, copy);
+  } else if (depth_ == 1) {
+    key_matched_ = std::string_view(str, length) == key_;
+  }
+  return true;
+}
+
+bool JSONValueExtractor::EndObject(rapidjson::SizeType member_count) {
+  if (capturing_) writer_.EndObject(member_count);
+  --depth_;
+  EndValue();
+  return true;
+}
+
+bool JSONValueExtractor::StartArray() {
+  if ((depth_ == 0 && index_ < 0) || !BeginValue(Kind::kNested)) return false;
+  if (capturing_) writer_.StartArray();
+  ++depth_;
+  return true;
+}
+
+bool JSONValueExtractor::EndArray(rapidjson::SizeType element_count) {
+  if (capturing_) writer_.EndArray(element_count);
+  --depth_;
+  EndValue();
+  return true;
+}
+
 void RegisterJSONOpsOrDie(udf::Registry* registry) {
   registry->RegisterOrDie<PluckUDF>("pluck");
   registry->RegisterOrDie<PluckAsInt64UDF>("pluck_int64");
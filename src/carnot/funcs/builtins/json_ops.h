@@ -19,10 +19,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include <rapidjson/document.h>
+#include <rapidjson/reader.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
@@ -33,37 +35,120 @@ namespace px {
 namespace carnot {
 namespace builtins {
 
+/**
+ * Extracts a single value from a serialized JSON document with rapidjson's SAX reader, instead of
+ * parsing the whole document into a DOM. The document is still fully validated, exactly like
+ * rapidjson::Document::Parse() does, but only the extracted value is materialized.
+ */
+class JSONValueExtractor
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JSONValueExtractor> {
+ public:
+  enum class Kind {
+    kNotFound,
+    kNull,
+    kBool,
+    // Integers that fit into an int64_t.
+    kInt64,
+    // Integers that only fit into an uint64_t.
+    kUint64,
+    kDouble,
+    kString,
+    // Objects and arrays.
+    kNested,
+  };
+
+  // Extracts the value of the member key of the root object.
+  static JSONValueExtractor ForKey(std::string_view key) { return JSONValueExtractor(key, -1); }
+  // Extracts the element at index of the root array.
+  static JSONValueExtractor ForIndex(int64_t index) { return JSONValueExtractor({}, index); }
+
+  /**
+   * Parses the null terminated JSON document.
+   * @return false if the document is not valid JSON, or if its root is not an object (ForKey) or
+   * an array (ForIndex).
+   */
+  bool Extract(const char* json);
+
+  Kind kind() const { return kind_; }
+  // The value of a kString.
+  const std::string& string_value() const { return string_value_; }
+  // The value of a kInt64.
+  int64_t int64_value() const { return int64_value_; }
+  // The value of any number.
+  double double_value() const { return double_value_; }
+  // The value serialized as JSON, like rapidjson::Writer writes it.
+  std::string_view json() const { return std::string_view(json_.GetString(), json_.GetSize()); }
+
+  // The rapidjson SAX handler.
+  bool Null();
+  bool Bool(bool b);
+  bool Int(int i);
+  bool Uint(unsigned u);
+  bool Int64(int64_t i);
+  bool Uint64(uint64_t u);
+  bool Double(double d);
+  bool String(const char* str, rapidjson::SizeType length, bool copy);
+  bool StartObject();
+  bool Key(const char* str, rapidjson::SizeType length, bool copy);
+  bool EndObject(rapidjson::SizeType member_count);
+  bool StartArray();
+  bool EndArray(rapidjson::SizeType element_count);
+
+ private:
+  JSONValueExtractor(std::string_view key, int64_t index)
+      : key_(key), index_(index), writer_(json_) {}
+
+  // Called before every value. Returns false to stop parsing, when the root has the wrong type.
+  bool BeginValue(Kind kind);
+  // Called after every value, and at the end of objects and arrays.
+  void EndValue();
+
+  std::string_view key_;
+  int64_t index_;
+
+  // The nesting level of the current value, where the root is at 0.
+  int depth_ = 0;
+  int64_t num_root_elements_ = 0;
+  // Whether the last key of the root object was key_.
+  bool key_matched_ = false;
+  // Whether the value being parsed is (part of) the extracted value.
+  bool capturing_ = false;
+
+  Kind kind_ = Kind::kNotFound;
+  std::string string_value_;
+  int64_t int64_value_ = 0;
+  double double_value_ = 0;
+  rapidjson::StringBuffer json_;
+  rapidjson::Writer<rapidjson::StringBuffer> writer_;
+};
+
 // TODO(zasgar): PL-419 To have proper support for JSON we need structs and nullable types.
 // Revisit when we have them.
 class PluckUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    auto extractor = JSONValueExtractor::ForKey(key);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
-      return "";
-    }
-    if (!d.IsObject()) {
+    if (!extractor.Extract(in.data())) {
       return "";
     }
-    if (!d.HasMember(key.data())) {
-      return "";
-    }
-    const auto& plucked_value = d[key.data()];
-    if (plucked_value.IsNull()) {
-      return "";
-    }
-    if (plucked_value.IsString()) {
-      return plucked_value.GetString();
-    }
+    return PluckedValueToString(extractor);
+  }
 
-    // This is robust to nested JSON.
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    plucked_value.Accept(writer);
-    return sb.GetString();
+  // Returns the extracted value as a string, or as serialized JSON if it's not a string. This is
+  // robust to nested JSON.
+  static StringValue PluckedValueToString(const JSONValueExtractor& extractor) {
+    switch (extractor.kind()) {
+      case JSONValueExtractor::Kind::kNotFound:
+      case JSONValueExtractor::Kind::kNull:
+        return "";
+      case JSONValueExtractor::Kind::kString:
+        return extractor.string_value();
+      default:
+        return std::string(extractor.json());
+    }
   }
+
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
                "Grabs the value for the key value the serialized JSON string and returns as a "
@@ -87,17 +172,12 @@ class PluckUDF : public udf::ScalarUDF {
 class PluckAsInt64UDF : public udf::ScalarUDF {
  public:
   Int64Value Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    auto extractor = JSONValueExtractor::ForKey(key);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
+    if (!extractor.Extract(in.data()) || extractor.kind() != JSONValueExtractor::Kind::kInt64) {
       return 0;
     }
-    if (!d.IsObject()) {
-      return 0;
-    }
-    const auto& plucked_value = d[key.data()];
-    return plucked_value.GetInt64();
+    return extractor.int64_value();
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -122,17 +202,19 @@ class PluckAsInt64UDF : public udf::ScalarUDF {
 class PluckAsFloat64UDF : public udf::ScalarUDF {
  public:
   Float64Value Exec(FunctionContext*, StringValue in, StringValue key) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
+    auto extractor = JSONValueExtractor::ForKey(key);
     // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
+    if (!extractor.Extract(in.data())) {
       return 0.0;
     }
-    if (!d.IsObject()) {
-      return 0.0;
+    switch (extractor.kind()) {
+      case JSONValueExtractor::Kind::kInt64:
+      case JSONValueExtractor::Kind::kUint64:
+      case JSONValueExtractor::Kind::kDouble:
+        return extractor.double_value();
+      default:
+        return 0.0;
     }
-    const auto& plucked_value = d[key.data()];
-    return plucked_value.GetDouble();
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -160,33 +242,15 @@ class PluckAsFloat64UDF : public udf::ScalarUDF {
 class PluckArrayUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue in, Int64Value index) {
-    rapidjson::Document d;
-    rapidjson::ParseResult ok = d.Parse(in.data());
-    // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
-    if (ok == nullptr) {
+    if (index < 0) {
       return "";
     }
-    if (!d.IsArray()) {
-      return "";
-    }
-    const auto& plucked_array = d.GetArray();
-    if (index < 0 || index >= plucked_array.Size()) {
-      return "";
-    }
-
-    const auto& plucked_value = plucked_array[index.val];
-    if (plucked_value.IsNull()) {
+    auto extractor = JSONValueExtractor::ForIndex(index.val);
+    // TODO(zasgar/michellenguyen, PP-419): Replace with null when available.
+    if (!extractor.Extract(in.data())) {
       return "";
     }
-    if (plucked_value.IsString()) {
-      return plucked_value.GetString();
-    }
-
-    // This is robust to nested JSON.
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    plucked_value.Accept(writer);
-    return sb.GetString();
+    return PluckUDF::PluckedValueToString(extractor);
   }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
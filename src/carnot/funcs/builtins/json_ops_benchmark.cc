@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/json_ops.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+
+// A typical HTTP JSON response body, as traced by Stirling.
+static constexpr std::string_view kResponseBody = R"body({
+  "id": "3f2504e0-4f89-11d3-9a0c-0305e82c3301",
+  "status": "shipped",
+  "customer": {"id": 1234567, "name": "Jane Doe", "email": "jane@example.com",
+               "address": {"street": "1 Main St", "city": "Springfield", "zip": "12345"}},
+  "items": [
+    {"sku": "A-1001", "name": "Widget", "quantity": 2, "price": 19.99, "tags": ["blue", "small"]},
+    {"sku": "B-2002", "name": "Gadget", "quantity": 1, "price": 149.5, "tags": []},
+    {"sku": "C-3003", "name": "Doohickey", "quantity": 12, "price": 0.75, "tags": ["bulk"]}
+  ],
+  "total": 199.48,
+  "currency": "USD",
+  "created_at": "2021-06-01T12:34:56Z",
+  "latency_ms": 42,
+  "trace": {"span_id": "b7ad6b7169203331", "sampled": true}
+})body";
+
+// The keys that a script plucks from each body, as px.pluck* calls on the same column.
+const std::vector<StringValue> kKeys = {"status", "customer", "total", "currency", "latency_ms"};
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_PluckDOM(benchmark::State& state) {
+  std::string body(kResponseBody);
+  for (auto _ : state) {
+    for (const auto& key : kKeys) {
+      // What each pluck used to do.
+      rapidjson::Document d;
+      d.Parse(body.data());
+      rapidjson::StringBuffer sb;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+      d[key.data()].Accept(writer);
+      benchmark::DoNotOptimize(std::string(sb.GetString()));
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(body.size() * kKeys.size()) *
+                          static_cast<int64_t>(state.iterations()));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_Pluck(benchmark::State& state) {
+  PluckUDF udf;
+  std::string body(kResponseBody);
+  for (auto _ : state) {
+    for (const auto& key : kKeys) {
+      benchmark::DoNotOptimize(udf.Exec(nullptr, body, key));
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(body.size() * kKeys.size()) *
+                          static_cast<int64_t>(state.iterations()));
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_PluckAsInt64(benchmark::State& state) {
+  PluckAsInt64UDF udf;
+  std::string body(kResponseBody);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(udf.Exec(nullptr, body, "latency_ms"));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(body.size()) *
+                          static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_PluckDOM);
+BENCHMARK(BM_Pluck);
+BENCHMARK(BM_PluckAsInt64);
+
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -18,6 +18,9 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
 #include "src/carnot/funcs/builtins/json_ops.h"
 #include "src/carnot/udf/test_utils.h"
 
@@ -107,6 +110,70 @@ TEST(JSONOps, PluckArrayUDF_index_out_of_bound) {
   udf_tester.ForInput(kTestJSONArray, 3).Expect("");
 }
 
+TEST(JSONOps, PluckUDF_matches_dom) {
+  // What pluck returned when it parsed the whole document into a DOM.
+  auto dom_pluck = [](const std::string& in, const std::string& key) -> std::string {
+    rapidjson::Document d;
+    if (d.Parse(in.data()).IsError() || !d.IsObject() || !d.HasMember(key.data())) {
+      return "";
+    }
+    const auto& value = d[key.data()];
+    if (value.IsNull()) {
+      return "";
+    }
+    if (value.IsString()) {
+      return value.GetString();
+    }
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    value.Accept(writer);
+    return sb.GetString();
+  };
+
+  const std::vector<std::string> docs = {
+      kTestJSONStr,
+      R"({"a": {"b": [1, 2.50, -3, true, null, "x\"y"]}, "b": 1e3, "c": "\u00e9"})",
+      R"({"a": 18446744073709551615, "b": -9223372036854775808, "c": false, "d": null})",
+      // Only the first of duplicate keys is plucked, and nested keys aren't.
+      R"({"x": {"a": 1}, "a": 2, "a": 3})",
+      // Invalid documents.
+      R"({"a": 1, "b": )",
+      R"({"a": 1} trailing)",
+      R"("a")",
+  };
+  auto udf_tester = udf::UDFTester<PluckUDF>();
+  for (const auto& doc : docs) {
+    for (const auto& key : {"a", "b", "c", "d", "x", "str_key", "int64_key", "float64_key"}) {
+      udf_tester.ForInput(doc, key).Expect(dom_pluck(doc, key));
+    }
+  }
+}
+
+TEST(JSONOps, PluckAsInt64UDF_non_int_return_zero) {
+  auto udf_tester = udf::UDFTester<PluckAsInt64UDF>();
+  udf_tester.ForInput(kTestJSONStr, "float64_key").Expect(0);
+  udf_tester.ForInput(kTestJSONStr, "str_plain").Expect(0);
+  udf_tester.ForInput(kTestJSONStr, "blah").Expect(0);
+  udf_tester.ForInput(R"({"a": 18446744073709551615})", "a").Expect(0);
+  udf_tester.ForInput(R"({"a": -5})", "a").Expect(-5);
+}
+
+TEST(JSONOps, PluckAsFloat64UDF_int_value) {
+  auto udf_tester = udf::UDFTester<PluckAsFloat64UDF>();
+  udf_tester.ForInput(kTestJSONStr, "int64_key").Expect(34243242341.0);
+  udf_tester.ForInput(kTestJSONStr, "str_plain").Expect(0.0);
+}
+
+TEST(JSONOps, PluckArrayUDF_nested_and_negative_index) {
+  auto udf_tester = udf::UDFTester<PluckArrayUDF>();
+  udf_tester.ForInput(R"([[1, [2]], {"a": [3]}, 4.5, null])", 0).Expect("[1,[2]]");
+  udf_tester.ForInput(R"([[1, [2]], {"a": [3]}, 4.5, null])", 1).Expect(R"({"a":[3]})");
+  udf_tester.ForInput(R"([[1, [2]], {"a": [3]}, 4.5, null])", 2).Expect("4.5");
+  udf_tester.ForInput(R"([[1, [2]], {"a": [3]}, 4.5, null])", 3).Expect("");
+  udf_tester.ForInput(R"([[1, [2]], {"a": [3]}, 4.5, null])", -1).Expect("");
+  udf_tester.ForInput(R"(["foo", )", 0).Expect("");
+}
+
 TEST(JSONOps, ScriptReferenceUDF_no_args) {
   auto udf_tester = udf::UDFTester<ScriptReferenceUDF<>>();
   auto res = udf_tester.ForInput("text", "px/script").Result();
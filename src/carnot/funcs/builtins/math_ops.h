@@ -34,6 +34,12 @@ template <typename TReturn, typename TArg1, typename TArg2>
 class AddUDF : public udf::ScalarUDF {
  public:
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val + b2.val; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2, TReturn* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i].val + b2[i].val;
+    }
+    return Status::OK();
+  }
   static udf::InfRuleVec SemanticInferenceRules() {
     return {
         udf::InheritTypeFromArgs<AddUDF>::Create({types::ST_BYTES, types::ST_THROUGHPUT_PER_NS,
@@ -59,6 +65,12 @@ template <typename TReturn, typename TArg1, typename TArg2>
 class SubtractUDF : public udf::ScalarUDF {
  public:
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val - b2.val; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2, TReturn* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i].val - b2[i].val;
+    }
+    return Status::OK();
+  }
   static udf::InfRuleVec SemanticInferenceRules() {
     return {
         udf::InheritTypeFromArgs<SubtractUDF>::Create({types::ST_BYTES, types::ST_THROUGHPUT_PER_NS,
@@ -114,6 +126,12 @@ template <typename TReturn, typename TArg1, typename TArg2>
 class MultiplyUDF : public udf::ScalarUDF {
  public:
   TReturn Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val * b2.val; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2, TReturn* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i].val * b2[i].val;
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Multiplies the arguments.")
         .Details("Multiplies the two values together. Accessible using the `*` operator syntax.")
@@ -261,6 +279,13 @@ template <typename TArg1, typename TArg2>
 class LogicalOrUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val || b2.val; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2,
+                   BoolValue* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i].val || b2[i].val;
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Boolean ORs the passed in values.")
         .Example(R"doc(# Implicit call.
@@ -280,6 +305,13 @@ template <typename TArg1, typename TArg2>
 class LogicalAndUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1.val && b2.val; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2,
+                   BoolValue* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i].val && b2[i].val;
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Boolean ANDs the passed in values.")
         .Example(R"doc(# Implicit call.
@@ -297,6 +329,12 @@ template <typename TArg1>
 class LogicalNotUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1) { return !b1.val; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, BoolValue* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = !b1[i].val;
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Boolean NOTs the passed in value.")
         .Example(R"doc(# Implicit call.
@@ -369,6 +407,13 @@ template <typename TArg1, typename TArg2>
 class EqualUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 == b2; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2,
+                   BoolValue* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] == b2[i];
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns whether the values are equal.")
         .Details(
@@ -389,6 +434,13 @@ template <typename TArg1, typename TArg2>
 class NotEqualUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 != b2; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2,
+                   BoolValue* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] != b2[i];
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns whether the values are not equal.")
         .Details(
@@ -436,6 +488,13 @@ template <typename TArg1, typename TArg2>
 class GreaterThanUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 > b2; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2,
+                   BoolValue* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] > b2[i];
+    }
+    return Status::OK();
+  }
 
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -455,6 +514,13 @@ template <typename TArg1, typename TArg2>
 class GreaterThanEqualUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 >= b2; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2,
+                   BoolValue* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] >= b2[i];
+    }
+    return Status::OK();
+  }
 
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder(
@@ -475,6 +541,13 @@ template <typename TArg1, typename TArg2>
 class LessThanUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 < b2; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2,
+                   BoolValue* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] < b2[i];
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns which value is less than the other.")
         .Example(R"doc(# Implict call.
@@ -491,6 +564,13 @@ template <typename TArg1, typename TArg2>
 class LessThanEqualUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, TArg1 b1, TArg2 b2) { return b1 <= b2; }
+  Status ExecBatch(FunctionContext*, size_t count, const TArg1* b1, const TArg2* b2,
+                   BoolValue* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = b1[i] <= b2[i];
+    }
+    return Status::OK();
+  }
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Returns which value is less than or equal to the the other.")
         .Example(R"doc(
@@ -54,6 +54,24 @@ TEST(MathOps, basic_string_add_test) {
   udf_tester.ForInput("a", "b").Expect("ab");
 }
 
+TEST(MathOps, exec_batch_matches_exec_test) {
+  std::vector<types::Int64Value> a{1, -2, 3, 40};
+  std::vector<types::Float64Value> b{0.5, 2.0, 3.0, -1.5};
+
+  AddUDF<types::Float64Value, types::Int64Value, types::Float64Value> add;
+  std::vector<types::Float64Value> sums(a.size());
+  EXPECT_OK(add.ExecBatch(nullptr, a.size(), a.data(), b.data(), sums.data()));
+
+  LessThanUDF<types::Int64Value, types::Float64Value> lt;
+  std::vector<types::BoolValue> lts(a.size());
+  EXPECT_OK(lt.ExecBatch(nullptr, a.size(), a.data(), b.data(), lts.data()));
+
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_DOUBLE_EQ(add.Exec(nullptr, a[i], b[i]).val, sums[i].val);
+    EXPECT_EQ(lt.Exec(nullptr, a[i], b[i]).val, lts[i].val);
+  }
+}
+
 TEST(MathOps, basic_int64_subtract_test) {
   auto udf_tester =
       udf::UDFTester<SubtractUDF<types::Int64Value, types::Int64Value, types::Int64Value>>();
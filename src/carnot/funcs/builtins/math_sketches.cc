@@ -18,13 +18,450 @@
 
 #include "src/carnot/funcs/builtins/math_sketches.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// NOLINTNEXTLINE: build/include_subdir
+#include "xxhash.h"
+
+DEFINE_double(carnot_quantiles_compression, 1000,
+              "The compression of the t-digests used by quantiles. Higher values are more "
+              "accurate, but make the digests bigger and slower to merge.");
+
 namespace px {
 namespace carnot {
 namespace builtins {
 
+namespace {
+
+// The serialized digest is the version, the compression and the number of centroids, followed by
+// the centroid means and then the centroid weights. Keeping the means and weights in contiguous
+// arrays keeps the digest small and cheap to read back.
+constexpr char kTDigestWireVersion = 1;
+constexpr size_t kTDigestHeaderSize = sizeof(char) + sizeof(double) + sizeof(uint32_t);
+
+template <typename T>
+void AppendPOD(std::string* out, T val) {
+  out->append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+template <typename T>
+T ReadPOD(const char* data) {
+  T val;
+  std::memcpy(&val, data, sizeof(val));
+  return val;
+}
+
+// The serialized HyperLogLog is the version, the precision and the representation, followed by
+// the entry count and the sparse entries, or by the dense registers.
+constexpr char kHLLWireVersion = 1;
+constexpr char kHLLSparse = 0;
+constexpr char kHLLDense = 1;
+constexpr size_t kHLLHeaderSize = 3;
+
+uint32_t SparseIndex(uint32_t entry) { return entry >> 8; }
+uint8_t SparseRank(uint32_t entry) { return entry & 0xff; }
+
+// The serialized SpaceSaving sketch is the version, the capacity and the number of counters,
+// followed by the count, the error, the value size and the value of each counter.
+constexpr char kSpaceSavingWireVersion = 1;
+constexpr size_t kSpaceSavingHeaderSize = sizeof(char) + 2 * sizeof(uint32_t);
+constexpr size_t kSpaceSavingCounterHeaderSize = 2 * sizeof(uint64_t) + sizeof(uint32_t);
+
+// Orders counters by decreasing count, then by value so that the order is deterministic.
+bool LargerCounter(const SpaceSaving::Counter& a, const SpaceSaving::Counter& b) {
+  if (a.count != b.count) {
+    return a.count > b.count;
+  }
+  return a.value < b.value;
+}
+
+}  // namespace
+
+std::string SerializeTDigest(tdigest::TDigest* digest) {
+  digest->compress();
+  const auto& centroids = digest->processed();
+  std::string out;
+  out.reserve(kTDigestHeaderSize + centroids.size() * 2 * sizeof(double));
+  out.push_back(kTDigestWireVersion);
+  AppendPOD<double>(&out, digest->compression());
+  AppendPOD<uint32_t>(&out, centroids.size());
+  for (const auto& centroid : centroids) {
+    AppendPOD<double>(&out, centroid.mean());
+  }
+  for (const auto& centroid : centroids) {
+    AppendPOD<double>(&out, centroid.weight());
+  }
+  return out;
+}
+
+Status DeserializeTDigest(std::string_view data, tdigest::TDigest* digest) {
+  if (data.size() < kTDigestHeaderSize || data[0] != kTDigestWireVersion) {
+    return error::InvalidArgument("Invalid serialized t-digest");
+  }
+  auto compression = ReadPOD<double>(data.data() + sizeof(char));
+  auto num_centroids = ReadPOD<uint32_t>(data.data() + sizeof(char) + sizeof(double));
+  if (!std::isfinite(compression) || compression <= 0 ||
+      data.size() != kTDigestHeaderSize + num_centroids * 2 * sizeof(double)) {
+    return error::InvalidArgument("Invalid serialized t-digest");
+  }
+
+  *digest = tdigest::TDigest(compression);
+  const char* means = data.data() + kTDigestHeaderSize;
+  const char* weights = means + num_centroids * sizeof(double);
+  for (uint32_t i = 0; i < num_centroids; ++i) {
+    digest->add(ReadPOD<double>(means + i * sizeof(double)),
+                ReadPOD<double>(weights + i * sizeof(double)));
+  }
+  return Status::OK();
+}
+
+HyperLogLog::HyperLogLog(int precision) : precision_(precision) {
+  DCHECK_GE(precision, kMinPrecision);
+  DCHECK_LE(precision, kMaxPrecision);
+}
+
+void HyperLogLog::Add(uint64_t hash) {
+  uint32_t index = hash >> (64 - precision_);
+  // The rank is the position of the first set bit after the index bits. The sentinel bit bounds
+  // it by the number of hash bits that are left.
+  uint64_t rest = (hash << precision_) | (uint64_t{1} << (precision_ - 1));
+  uint8_t rank = __builtin_clzll(rest) + 1;
+  if (!is_sparse()) {
+    dense_[index] = std::max(dense_[index], rank);
+    return;
+  }
+  sparse_.push_back(SparseEntry(index, rank));
+  // Sorting once the unsorted tail is as long as the sorted prefix keeps adds amortized cheap.
+  if (sparse_.size() - sorted_size_ >= std::max<size_t>(64, sorted_size_)) {
+    CompactSparse();
+  }
+}
+
+void HyperLogLog::SortSparse(std::vector<uint32_t>* sparse, size_t sorted_size) {
+  std::sort(sparse->begin() + sorted_size, sparse->end());
+  std::inplace_merge(sparse->begin(), sparse->begin() + sorted_size, sparse->end());
+  // Entries sort by index and then by rank, so the last entry of each index has its highest rank.
+  size_t num_unique = 0;
+  for (size_t i = 0; i < sparse->size(); ++i) {
+    if (i + 1 < sparse->size() && SparseIndex((*sparse)[i]) == SparseIndex((*sparse)[i + 1])) {
+      continue;
+    }
+    (*sparse)[num_unique++] = (*sparse)[i];
+  }
+  sparse->resize(num_unique);
+}
+
+std::vector<uint32_t> HyperLogLog::SortedSparse() const {
+  std::vector<uint32_t> sparse = sparse_;
+  SortSparse(&sparse, sorted_size_);
+  return sparse;
+}
+
+void HyperLogLog::CompactSparse() {
+  SortSparse(&sparse_, sorted_size_);
+  sorted_size_ = sparse_.size();
+  if (static_cast<int64_t>(sparse_.size() * sizeof(uint32_t)) > num_registers()) {
+    ToDense();
+  }
+}
+
+void HyperLogLog::ToDense() {
+  dense_.assign(num_registers(), 0);
+  for (uint32_t entry : sparse_) {
+    dense_[SparseIndex(entry)] = std::max(dense_[SparseIndex(entry)], SparseRank(entry));
+  }
+  sparse_.clear();
+  sparse_.shrink_to_fit();
+  sorted_size_ = 0;
+}
+
+void HyperLogLog::Merge(const HyperLogLog& other) {
+  DCHECK_EQ(precision_, other.precision_);
+  if (is_sparse() && other.is_sparse()) {
+    sparse_.insert(sparse_.end(), other.sparse_.begin(), other.sparse_.end());
+    CompactSparse();
+    return;
+  }
+  if (is_sparse()) {
+    ToDense();
+  }
+  if (other.is_sparse()) {
+    for (uint32_t entry : other.sparse_) {
+      dense_[SparseIndex(entry)] = std::max(dense_[SparseIndex(entry)], SparseRank(entry));
+    }
+    return;
+  }
+  // A plain loop over the registers, so that it's vectorized.
+  for (size_t i = 0; i < dense_.size(); ++i) {
+    dense_[i] = std::max(dense_[i], other.dense_[i]);
+  }
+}
+
+int64_t HyperLogLog::Estimate() const {
+  double m = num_registers();
+  double sum = 0;
+  int64_t num_zeros = 0;
+  if (is_sparse()) {
+    std::vector<uint32_t> sparse = SortedSparse();
+    num_zeros = num_registers() - sparse.size();
+    sum = num_zeros;
+    for (uint32_t entry : sparse) {
+      sum += std::ldexp(1.0, -SparseRank(entry));
+    }
+  } else {
+    for (uint8_t rank : dense_) {
+      sum += std::ldexp(1.0, -rank);
+      num_zeros += rank == 0;
+    }
+  }
+  double alpha = 0.7213 / (1 + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+  // Linear counting is more accurate while many registers are still empty.
+  if (estimate <= 2.5 * m && num_zeros > 0) {
+    estimate = m * std::log(m / num_zeros);
+  }
+  return std::llround(estimate);
+}
+
+std::string HyperLogLog::Serialize() const {
+  std::string out;
+  out.push_back(kHLLWireVersion);
+  out.push_back(static_cast<char>(precision_));
+  if (is_sparse()) {
+    std::vector<uint32_t> sparse = SortedSparse();
+    out.reserve(kHLLHeaderSize + sizeof(uint32_t) * (sparse.size() + 1));
+    out.push_back(kHLLSparse);
+    AppendPOD<uint32_t>(&out, sparse.size());
+    for (uint32_t entry : sparse) {
+      AppendPOD<uint32_t>(&out, entry);
+    }
+  } else {
+    out.push_back(kHLLDense);
+    out.append(reinterpret_cast<const char*>(dense_.data()), dense_.size());
+  }
+  return out;
+}
+
+StatusOr<HyperLogLog> HyperLogLog::Deserialize(std::string_view data) {
+  if (data.size() < kHLLHeaderSize || data[0] != kHLLWireVersion || data[1] < kMinPrecision ||
+      data[1] > kMaxPrecision) {
+    return error::InvalidArgument("Invalid serialized HyperLogLog");
+  }
+  HyperLogLog hll(data[1]);
+  uint8_t max_rank = 64 - hll.precision_ + 1;
+  const char* body = data.data() + kHLLHeaderSize;
+  switch (data[2]) {
+    case kHLLSparse: {
+      if (data.size() < kHLLHeaderSize + sizeof(uint32_t)) {
+        return error::InvalidArgument("Invalid serialized HyperLogLog");
+      }
+      auto num_entries = ReadPOD<uint32_t>(body);
+      if (data.size() != kHLLHeaderSize + sizeof(uint32_t) * (uint64_t{num_entries} + 1)) {
+        return error::InvalidArgument("Invalid serialized HyperLogLog");
+      }
+      hll.sparse_.resize(num_entries);
+      for (uint32_t i = 0; i < num_entries; ++i) {
+        uint32_t entry = ReadPOD<uint32_t>(body + sizeof(uint32_t) * (i + 1));
+        if (SparseIndex(entry) >= hll.num_registers() || SparseRank(entry) == 0 ||
+            SparseRank(entry) > max_rank) {
+          return error::InvalidArgument("Invalid serialized HyperLogLog");
+        }
+        hll.sparse_[i] = entry;
+      }
+      hll.CompactSparse();
+      break;
+    }
+    case kHLLDense: {
+      if (static_cast<int64_t>(data.size() - kHLLHeaderSize) != hll.num_registers()) {
+        return error::InvalidArgument("Invalid serialized HyperLogLog");
+      }
+      hll.dense_.assign(body, body + hll.num_registers());
+      if (*std::max_element(hll.dense_.begin(), hll.dense_.end()) > max_rank) {
+        return error::InvalidArgument("Invalid serialized HyperLogLog");
+      }
+      break;
+    }
+    default:
+      return error::InvalidArgument("Invalid serialized HyperLogLog");
+  }
+  return hll;
+}
+
+void SpaceSaving::Swap(size_t i, size_t j) {
+  std::swap(heap_[i], heap_[j]);
+  index_[heap_[i].value] = i;
+  index_[heap_[j].value] = j;
+}
+
+void SpaceSaving::SiftUp(size_t pos) {
+  while (pos > 0) {
+    size_t parent = (pos - 1) / 2;
+    if (heap_[parent].count <= heap_[pos].count) {
+      break;
+    }
+    Swap(pos, parent);
+    pos = parent;
+  }
+}
+
+void SpaceSaving::SiftDown(size_t pos) {
+  while (true) {
+    size_t smallest = pos;
+    for (size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < heap_.size(); ++child) {
+      if (heap_[child].count < heap_[smallest].count) {
+        smallest = child;
+      }
+    }
+    if (smallest == pos) {
+      return;
+    }
+    Swap(pos, smallest);
+    pos = smallest;
+  }
+}
+
+void SpaceSaving::Add(std::string_view value) {
+  DCHECK_GT(capacity_, 0U);
+  auto it = index_.find(value);
+  if (it != index_.end()) {
+    size_t pos = it->second;
+    ++heap_[pos].count;
+    SiftDown(pos);
+    return;
+  }
+  if (heap_.size() < capacity_) {
+    index_.emplace(value, heap_.size());
+    heap_.push_back(Counter{std::string(value), 1, 0});
+    SiftUp(heap_.size() - 1);
+    return;
+  }
+  // Take over the smallest counter.
+  Counter& smallest = heap_[0];
+  index_.erase(smallest.value);
+  smallest.value.assign(value.data(), value.size());
+  smallest.error = smallest.count;
+  ++smallest.count;
+  index_.emplace(smallest.value, 0);
+  SiftDown(0);
+}
+
+void SpaceSaving::Rebuild(std::vector<Counter> counters) {
+  if (counters.size() > capacity_) {
+    std::nth_element(counters.begin(), counters.begin() + capacity_, counters.end(),
+                     LargerCounter);
+    counters.resize(capacity_);
+  }
+  heap_ = std::move(counters);
+  std::make_heap(heap_.begin(), heap_.end(),
+                 [](const Counter& a, const Counter& b) { return a.count > b.count; });
+  index_.clear();
+  index_.reserve(heap_.size());
+  for (size_t i = 0; i < heap_.size(); ++i) {
+    index_.emplace(heap_[i].value, i);
+  }
+}
+
+void SpaceSaving::Merge(const SpaceSaving& other) {
+  capacity_ = std::max(capacity_, other.capacity_);
+  std::vector<Counter> counters = std::move(heap_);
+  for (const Counter& counter : other.heap_) {
+    auto it = index_.find(counter.value);
+    if (it != index_.end()) {
+      counters[it->second].count += counter.count;
+      counters[it->second].error += counter.error;
+    } else {
+      counters.push_back(counter);
+    }
+  }
+  Rebuild(std::move(counters));
+}
+
+std::vector<SpaceSaving::Counter> SpaceSaving::TopK(size_t k) const {
+  std::vector<Counter> counters = heap_;
+  k = std::min(k, counters.size());
+  std::partial_sort(counters.begin(), counters.begin() + k, counters.end(), LargerCounter);
+  counters.resize(k);
+  return counters;
+}
+
+std::string SpaceSaving::Serialize() const {
+  size_t size = kSpaceSavingHeaderSize;
+  for (const Counter& counter : heap_) {
+    size += kSpaceSavingCounterHeaderSize + counter.value.size();
+  }
+  std::string out;
+  out.reserve(size);
+  out.push_back(kSpaceSavingWireVersion);
+  AppendPOD<uint32_t>(&out, capacity_);
+  AppendPOD<uint32_t>(&out, heap_.size());
+  for (const Counter& counter : heap_) {
+    AppendPOD<uint64_t>(&out, counter.count);
+    AppendPOD<uint64_t>(&out, counter.error);
+    AppendPOD<uint32_t>(&out, counter.value.size());
+    out.append(counter.value);
+  }
+  return out;
+}
+
+StatusOr<SpaceSaving> SpaceSaving::Deserialize(std::string_view data) {
+  if (data.size() < kSpaceSavingHeaderSize || data[0] != kSpaceSavingWireVersion) {
+    return error::InvalidArgument("Invalid serialized SpaceSaving sketch");
+  }
+  auto capacity = ReadPOD<uint32_t>(data.data() + sizeof(char));
+  auto num_counters = ReadPOD<uint32_t>(data.data() + sizeof(char) + sizeof(uint32_t));
+  if (capacity > kMaxCapacity || num_counters > capacity) {
+    return error::InvalidArgument("Invalid serialized SpaceSaving sketch");
+  }
+
+  std::vector<Counter> counters(num_counters);
+  size_t pos = kSpaceSavingHeaderSize;
+  for (Counter& counter : counters) {
+    if (data.size() - pos < kSpaceSavingCounterHeaderSize) {
+      return error::InvalidArgument("Invalid serialized SpaceSaving sketch");
+    }
+    counter.count = ReadPOD<uint64_t>(data.data() + pos);
+    counter.error = ReadPOD<uint64_t>(data.data() + pos + sizeof(uint64_t));
+    auto value_size = ReadPOD<uint32_t>(data.data() + pos + 2 * sizeof(uint64_t));
+    pos += kSpaceSavingCounterHeaderSize;
+    if (data.size() - pos < value_size || counter.count == 0 || counter.error >= counter.count) {
+      return error::InvalidArgument("Invalid serialized SpaceSaving sketch");
+    }
+    counter.value.assign(data.data() + pos, value_size);
+    pos += value_size;
+  }
+  if (pos != data.size()) {
+    return error::InvalidArgument("Invalid serialized SpaceSaving sketch");
+  }
+
+  SpaceSaving sketch(capacity);
+  sketch.Rebuild(std::move(counters));
+  if (sketch.index_.size() != sketch.heap_.size()) {
+    return error::InvalidArgument("Invalid serialized SpaceSaving sketch: duplicate values");
+  }
+  return sketch;
+}
+
+namespace internal {
+
+uint64_t ApproxCountDistinctHash(const void* data, size_t size) { return XXH64(data, size, 0); }
+
+}  // namespace internal
+
 void RegisterMathSketchesOrDie(udf::Registry* registry) {
   registry->RegisterOrDie<QuantilesUDA<types::Int64Value>>("quantiles");
   registry->RegisterOrDie<QuantilesUDA<types::Float64Value>>("quantiles");
+
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::BoolValue>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Int64Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Float64Value>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::Time64NSValue>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::StringValue>>("approx_count_distinct");
+  registry->RegisterOrDie<ApproxCountDistinctUDA<types::UInt128Value>>("approx_count_distinct");
+
+  registry->RegisterOrDie<ApproxTopKUDA<types::StringValue>>("approx_top_k");
+  registry->RegisterOrDie<ApproxTopKUDA<types::Int64Value>>("approx_top_k");
 }
 
 }  // namespace builtins
@@ -21,22 +21,50 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
 #include "src/carnot/udf/registry.h"
 #include "src/shared/types/types.h"
 #include "tdigest/tdigest.h"
 
+DECLARE_double(carnot_quantiles_compression);
+
 namespace px {
 namespace carnot {
 namespace builtins {
 
+/**
+ * Serializes the centroids of a digest into a compact binary form, for sending partial
+ * aggregates between agents. Compresses the digest first.
+ */
+std::string SerializeTDigest(tdigest::TDigest* digest);
+
+/**
+ * Replaces the digest with the one serialized in data by SerializeTDigest.
+ */
+Status DeserializeTDigest(std::string_view data, tdigest::TDigest* digest);
+
 // TODO(zasgar): PL-419 Replace this when we add support for structs.
 template <typename TArg>
 class QuantilesUDA : public udf::UDA {
  public:
-  QuantilesUDA() : digest_(1000) {}
+  QuantilesUDA() : digest_(FLAGS_carnot_quantiles_compression) {}
   void Update(FunctionContext*, TArg val) { digest_.add(val.val); }
   void Merge(FunctionContext*, const QuantilesUDA& other) { digest_.merge(&other.digest_); }
 
+  StringValue Serialize(FunctionContext*) { return SerializeTDigest(&digest_); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return DeserializeTDigest(data, &digest_);
+  }
+
   StringValue Finalize(FunctionContext*) {
     rapidjson::Document d;
     d.SetObject();
@@ -81,6 +109,249 @@ class QuantilesUDA : public udf::UDA {
   tdigest::TDigest digest_;
 };
 
+/**
+ * HyperLogLog estimates the number of distinct 64-bit hashes it is given.
+ *
+ * While few registers are set, they are kept sparsely as a list of (index, rank) pairs. Once the
+ * list would take more memory than one byte per register, the sketch switches to dense
+ * registers. Sketches with the same precision can be merged and serialized into a compact binary
+ * form, so that partial aggregates can be combined across agents.
+ */
+class HyperLogLog {
+ public:
+  // 2^14 registers, for a standard error of about 0.8%.
+  static constexpr int kDefaultPrecision = 14;
+  static constexpr int kMinPrecision = 4;
+  static constexpr int kMaxPrecision = 18;
+
+  explicit HyperLogLog(int precision = kDefaultPrecision);
+
+  void Add(uint64_t hash);
+  void Merge(const HyperLogLog& other);
+  int64_t Estimate() const;
+
+  std::string Serialize() const;
+  static StatusOr<HyperLogLog> Deserialize(std::string_view data);
+
+  int precision() const { return precision_; }
+  bool is_sparse() const { return dense_.empty(); }
+
+ private:
+  int64_t num_registers() const { return int64_t{1} << precision_; }
+  // Sparse entries are (index << 8 | rank).
+  static uint32_t SparseEntry(uint32_t index, uint8_t rank) { return index << 8 | rank; }
+  // Sorts the entries after sorted_size and merges them into the sorted prefix, keeping only the
+  // highest rank per register.
+  static void SortSparse(std::vector<uint32_t>* sparse, size_t sorted_size);
+  std::vector<uint32_t> SortedSparse() const;
+  // Sorts the sparse entries, then switches to dense registers if the sparse list is too big.
+  void CompactSparse();
+  void ToDense();
+
+  int precision_;
+  // The sparse entries, sorted by index up to sorted_size_, then unsorted.
+  std::vector<uint32_t> sparse_;
+  size_t sorted_size_ = 0;
+  // One rank per register, empty while the sketch is sparse.
+  std::vector<uint8_t> dense_;
+};
+
+namespace internal {
+
+uint64_t ApproxCountDistinctHash(const void* data, size_t size);
+
+template <typename TArg>
+uint64_t ApproxCountDistinctHash(const TArg& val) {
+  if constexpr (std::is_same_v<TArg, types::StringValue>) {
+    return ApproxCountDistinctHash(val.data(), val.size());
+  } else if constexpr (std::is_same_v<TArg, types::UInt128Value>) {
+    uint64_t words[2] = {val.High64(), val.Low64()};
+    return ApproxCountDistinctHash(words, sizeof(words));
+  } else {
+    auto native = val.val;
+    return ApproxCountDistinctHash(&native, sizeof(native));
+  }
+}
+
+}  // namespace internal
+
+template <typename TArg>
+class ApproxCountDistinctUDA : public udf::UDA {
+ public:
+  void Update(FunctionContext*, TArg val) { hll_.Add(internal::ApproxCountDistinctHash(val)); }
+  void Merge(FunctionContext*, const ApproxCountDistinctUDA& other) { hll_.Merge(other.hll_); }
+  Int64Value Finalize(FunctionContext*) { return hll_.Estimate(); }
+
+  StringValue Serialize(FunctionContext*) { return hll_.Serialize(); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    PL_ASSIGN_OR_RETURN(hll_, HyperLogLog::Deserialize(data));
+    if (hll_.precision() != HyperLogLog::kDefaultPrecision) {
+      return error::InvalidArgument("Can't merge a HyperLogLog with precision $0 into one with $1",
+                                    hll_.precision(), HyperLogLog::kDefaultPrecision);
+    }
+    return Status::OK();
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Approximates the number of distinct values in the group.")
+        .Details(
+            "Estimates the number of distinct values using a "
+            "[HyperLogLog](https://en.wikipedia.org/wiki/HyperLogLog) sketch, which has a "
+            "standard error of about 0.8%. Unlike grouping by the value and counting the groups, "
+            "it uses a bounded amount of memory and can be computed partially on each agent.")
+        .Example("df = df.agg(num_remote_addrs=('remote_addr', px.approx_count_distinct))")
+        .Arg("val", "The values to count the distinct values of.")
+        .Returns("The approximate number of distinct values.");
+  }
+
+ private:
+  HyperLogLog hll_;
+};
+
+/**
+ * SpaceSaving approximately counts the most frequent of the values it is given, with at most
+ * capacity counters (Metwally et al., "Efficient Computation of Frequent and Top-k Elements in
+ * Data Streams"). A value that isn't counted yet takes over the counter with the smallest count,
+ * and keeps that count as how much it may overestimate its own. Every value that occurs more than
+ * 1/capacity of the time has a counter.
+ *
+ * Sketches merge by adding up the counters of the same values, and keeping the largest ones.
+ * They serialize into a compact binary form, so that partial aggregates can be combined across
+ * agents.
+ */
+class SpaceSaving {
+ public:
+  static constexpr size_t kMaxCapacity = 4096;
+
+  struct Counter {
+    std::string value;
+    uint64_t count = 0;
+    // By how much count may overestimate the number of times that value was added.
+    uint64_t error = 0;
+  };
+
+  explicit SpaceSaving(size_t capacity = 0) : capacity_(capacity) {
+    DCHECK_LE(capacity, kMaxCapacity);
+  }
+
+  void Add(std::string_view value);
+  void Merge(const SpaceSaving& other);
+
+  // Returns up to k of the counters, with the largest counts first.
+  std::vector<Counter> TopK(size_t k) const;
+
+  std::string Serialize() const;
+  static StatusOr<SpaceSaving> Deserialize(std::string_view data);
+
+  size_t capacity() const { return capacity_; }
+  size_t size() const { return heap_.size(); }
+
+ private:
+  // Restores heap order around the counter at pos, and updates its position in index_.
+  void SiftUp(size_t pos);
+  void SiftDown(size_t pos);
+  void Swap(size_t i, size_t j);
+  // Rebuilds the heap and the index from counters, keeping only the capacity_ largest.
+  void Rebuild(std::vector<Counter> counters);
+
+  size_t capacity_;
+  // A min-heap of the counters by count, so that the smallest one is replaced in O(log capacity).
+  std::vector<Counter> heap_;
+  // The position of each counted value in heap_.
+  absl::flat_hash_map<std::string, size_t> index_;
+};
+
+namespace internal {
+
+// The values that approx_top_k counts are kept as strings in the sketch.
+inline std::string TopKKey(const types::StringValue& val) { return val; }
+inline std::string TopKKey(const types::Int64Value& val) {
+  return std::string(reinterpret_cast<const char*>(&val.val), sizeof(val.val));
+}
+
+template <typename TWriter>
+void WriteTopKValue(TWriter* writer, const std::string& key, const types::StringValue*) {
+  writer->String(key.data(), key.size());
+}
+template <typename TWriter>
+void WriteTopKValue(TWriter* writer, const std::string& key, const types::Int64Value*) {
+  int64_t val = 0;
+  std::memcpy(&val, key.data(), std::min(key.size(), sizeof(val)));
+  writer->Int64(val);
+}
+
+}  // namespace internal
+
+template <typename TArg>
+class ApproxTopKUDA : public udf::UDA {
+ public:
+  // The most values that approx_top_k returns per group.
+  static constexpr int64_t kMaxK = 1024;
+  // Counting a few times more values than are returned makes the counts of the top ones accurate
+  // unless the distribution is nearly flat.
+  static constexpr int64_t kCountersPerK = 4;
+  static_assert(kMaxK * kCountersPerK <= static_cast<int64_t>(SpaceSaving::kMaxCapacity));
+
+  void Update(FunctionContext*, TArg val, Int64Value k) {
+    if (sketch_.capacity() == 0) {
+      sketch_ = SpaceSaving(std::clamp<int64_t>(k.val, 1, kMaxK) * kCountersPerK);
+    }
+    sketch_.Add(internal::TopKKey(val));
+  }
+  void Merge(FunctionContext*, const ApproxTopKUDA<TArg>& other) { sketch_.Merge(other.sketch_); }
+
+  StringValue Finalize(FunctionContext*) {
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    writer.StartArray();
+    for (const auto& counter : sketch_.TopK(sketch_.capacity() / kCountersPerK)) {
+      writer.StartObject();
+      writer.Key("value");
+      internal::WriteTopKValue(&writer, counter.value, static_cast<const TArg*>(nullptr));
+      writer.Key("count");
+      writer.Uint64(counter.count);
+      writer.EndObject();
+    }
+    writer.EndArray();
+    return std::string(sb.GetString(), sb.GetSize());
+  }
+
+  StringValue Serialize(FunctionContext*) { return sketch_.Serialize(); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    PL_ASSIGN_OR_RETURN(sketch_, SpaceSaving::Deserialize(data));
+    if (sketch_.capacity() % kCountersPerK != 0) {
+      return error::InvalidArgument("Can't merge a top-k sketch with $0 counters",
+                                    sketch_.capacity());
+    }
+    return Status::OK();
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Approximates the k most frequent values of the group.")
+        .Details(
+            "Counts the values with a space-saving sketch of 4k counters, so it uses a bounded "
+            "amount of memory however many distinct values there are, and is computed partially "
+            "on each agent. Unlike grouping by the value and sorting the counts, only the sketches "
+            "are sent over the network. The counts are exact while the group has fewer than 4k "
+            "distinct values, and otherwise may be off by up to 1/4k of the group's rows. "
+            "k is read from the first row of the group, and is capped at 1024.")
+        .Example(R"doc(
+        | df.k = 10
+        | df = df.groupby('service').agg(top_paths=('req_path', 'k', px.approx_top_k))
+        )doc")
+        .Arg("val", "The values to find the most frequent of.")
+        .Arg("k", "The number of values to return.")
+        .Returns(
+            "A JSON array of up to k objects with the keys \"value\" and \"count\", the most "
+            "frequent first.");
+  }
+
+ private:
+  SpaceSaving sketch_;
+};
+
 void RegisterMathSketchesOrDie(udf::Registry* registry);
 
 }  // namespace builtins
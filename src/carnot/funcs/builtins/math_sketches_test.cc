@@ -19,9 +19,12 @@
 #include <gtest/gtest.h>
 #include <rapidjson/document.h>
 
+#include <string>
+
 #include "src/carnot/funcs/builtins/math_sketches.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
+#include "src/common/base/test_utils.h"
 
 namespace px {
 namespace carnot {
@@ -69,6 +72,158 @@ TEST(MathSketches, quantiles_int64) {
   EXPECT_DOUBLE_EQ(d["p99"].GetDouble(), 6);
 }
 
+TEST(MathSketches, quantiles_serialization) {
+  auto uda_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
+  auto other_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
+  for (int i = 0; i < 1000; ++i) {
+    uda_tester.ForInput(i);
+    other_tester.ForInput(1000 + i);
+  }
+
+  auto serialized = other_tester.Serialize();
+  // The version, compression and centroid count, then a mean and a weight per centroid.
+  EXPECT_EQ(0, (serialized.size() - 13) % 16);
+  EXPECT_LT(serialized.size(), 2000 * 16);
+  ASSERT_OK(uda_tester.Deserialize(serialized));
+
+  rapidjson::Document d;
+  d.Parse(uda_tester.Result().data());
+  EXPECT_NEAR(d["p50"].GetDouble(), 1000, 20);
+  EXPECT_NEAR(d["p90"].GetDouble(), 1800, 20);
+}
+
+TEST(MathSketches, quantiles_invalid_serialization) {
+  auto uda_tester = udf::UDATester<QuantilesUDA<types::Float64Value>>();
+  uda_tester.ForInput(1.0);
+  auto serialized = uda_tester.Serialize();
+  EXPECT_NOT_OK(uda_tester.Deserialize(""));
+  EXPECT_NOT_OK(uda_tester.Deserialize(serialized.substr(0, serialized.size() - 1)));
+  EXPECT_OK(uda_tester.Deserialize(serialized));
+}
+
+TEST(MathSketches, approx_count_distinct) {
+  auto uda_tester = udf::UDATester<ApproxCountDistinctUDA<types::Int64Value>>();
+  uda_tester.Expect(0);
+  uda_tester.ForInput(1).ForInput(2).ForInput(2).ForInput(3).ForInput(1).Expect(3);
+}
+
+TEST(MathSketches, approx_count_distinct_merge) {
+  auto uda_tester = udf::UDATester<ApproxCountDistinctUDA<types::StringValue>>();
+  auto other_tester = udf::UDATester<ApproxCountDistinctUDA<types::StringValue>>();
+  for (int i = 0; i < 100000; ++i) {
+    uda_tester.ForInput(absl::StrCat("10.0.", i));
+    // Half of the values overlap.
+    other_tester.ForInput(absl::StrCat("10.0.", i + 50000));
+  }
+  ASSERT_OK(uda_tester.Deserialize(other_tester.Serialize()));
+  EXPECT_NEAR(uda_tester.Result().val, 150000, 150000 * 0.03);
+}
+
+TEST(MathSketches, approx_top_k) {
+  auto uda_tester = udf::UDATester<ApproxTopKUDA<types::StringValue>>();
+  uda_tester.ForInput("/a", 2)
+      .ForInput("/b", 2)
+      .ForInput("/a", 2)
+      .ForInput("/c", 2)
+      .ForInput("/b", 2)
+      .ForInput("/a", 2)
+      .Expect(R"([{"value":"/a","count":3},{"value":"/b","count":2}])");
+}
+
+TEST(MathSketches, approx_top_k_merge) {
+  auto uda_tester = udf::UDATester<ApproxTopKUDA<types::Int64Value>>();
+  auto other_tester = udf::UDATester<ApproxTopKUDA<types::Int64Value>>();
+  for (int i = 0; i < 10000; ++i) {
+    // Mostly distinct values, with 7 and 42 standing out.
+    uda_tester.ForInput(i % 4 == 0 ? 7 : 1000 + i, 10);
+    other_tester.ForInput(i % 5 == 0 ? 42 : 100000 + i, 10);
+    other_tester.ForInput(i % 10 == 0 ? 7 : 200000 + i, 10);
+  }
+  ASSERT_OK(uda_tester.Deserialize(other_tester.Serialize()));
+
+  rapidjson::Document doc;
+  doc.Parse(uda_tester.Result().data());
+  ASSERT_TRUE(doc.IsArray());
+  ASSERT_EQ(10, doc.Size());
+  // Each sketch has 40 counters, so its counts are off by at most 1/40 of its rows.
+  EXPECT_EQ(7, doc[0]["value"].GetInt64());
+  EXPECT_NEAR(3500, doc[0]["count"].GetUint64(), 10000 / 40 + 20000 / 40);
+  EXPECT_EQ(42, doc[1]["value"].GetInt64());
+  EXPECT_NEAR(2000, doc[1]["count"].GetUint64(), 10000 / 40 + 20000 / 40);
+}
+
+TEST(SpaceSaving, heavy_hitters) {
+  SpaceSaving sketch(8);
+  for (int i = 0; i < 1000; ++i) {
+    sketch.Add(i % 4 == 0 ? "heavy" : absl::StrCat("light-", i));
+  }
+  EXPECT_EQ(8, sketch.size());
+  auto top = sketch.TopK(1);
+  ASSERT_EQ(1, top.size());
+  EXPECT_EQ("heavy", top[0].value);
+  // The count overestimates by at most the error, which is bounded by 1000 / 8.
+  EXPECT_GE(top[0].count, 250);
+  EXPECT_LE(top[0].count - top[0].error, 250);
+  EXPECT_LE(top[0].error, 1000 / 8);
+
+  ASSERT_OK_AND_ASSIGN(auto copy, SpaceSaving::Deserialize(sketch.Serialize()));
+  EXPECT_EQ(8, copy.capacity());
+  EXPECT_EQ(sketch.Serialize(), copy.Serialize());
+}
+
+TEST(SpaceSaving, invalid_serialization) {
+  EXPECT_NOT_OK(SpaceSaving::Deserialize(""));
+  SpaceSaving sketch(4);
+  sketch.Add("a");
+  sketch.Add("b");
+  std::string serialized = sketch.Serialize();
+  EXPECT_NOT_OK(SpaceSaving::Deserialize(serialized.substr(0, serialized.size() - 1)));
+  // More counters than the capacity.
+  serialized[1] = 1;
+  EXPECT_NOT_OK(SpaceSaving::Deserialize(serialized));
+}
+
+TEST(HyperLogLog, sparse_and_dense) {
+  HyperLogLog hll;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    hll.Add(internal::ApproxCountDistinctHash(types::Int64Value(i)));
+  }
+  EXPECT_TRUE(hll.is_sparse());
+  EXPECT_NEAR(hll.Estimate(), 1000, 20);
+  ASSERT_OK_AND_ASSIGN(auto sparse, HyperLogLog::Deserialize(hll.Serialize()));
+  EXPECT_TRUE(sparse.is_sparse());
+  EXPECT_EQ(hll.Estimate(), sparse.Estimate());
+
+  for (uint64_t i = 0; i < 100000; ++i) {
+    hll.Add(internal::ApproxCountDistinctHash(types::Int64Value(i)));
+  }
+  EXPECT_FALSE(hll.is_sparse());
+  EXPECT_NEAR(hll.Estimate(), 100000, 100000 * 0.03);
+  std::string serialized = hll.Serialize();
+  EXPECT_EQ(3 + (1 << HyperLogLog::kDefaultPrecision), serialized.size());
+  ASSERT_OK_AND_ASSIGN(auto dense, HyperLogLog::Deserialize(serialized));
+  EXPECT_FALSE(dense.is_sparse());
+  EXPECT_EQ(hll.Estimate(), dense.Estimate());
+
+  // Merging a dense sketch into a sparse one makes it dense.
+  HyperLogLog merged;
+  merged.Add(internal::ApproxCountDistinctHash(types::Int64Value(123456789)));
+  merged.Merge(hll);
+  EXPECT_FALSE(merged.is_sparse());
+  EXPECT_NEAR(merged.Estimate(), 100001, 100000 * 0.03);
+}
+
+TEST(HyperLogLog, invalid_serialization) {
+  EXPECT_NOT_OK(HyperLogLog::Deserialize(""));
+  HyperLogLog hll;
+  hll.Add(1234);
+  std::string serialized = hll.Serialize();
+  EXPECT_NOT_OK(HyperLogLog::Deserialize(serialized.substr(0, serialized.size() - 1)));
+  // An unsupported precision.
+  serialized[1] = 30;
+  EXPECT_NOT_OK(HyperLogLog::Deserialize(serialized));
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
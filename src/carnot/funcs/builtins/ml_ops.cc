@@ -37,6 +37,16 @@ void RegisterMLOpsOrDie(udf::Registry* registry) {
    *****************************************/
   registry->RegisterOrDie<KMeansUDA>("_kmeans_fit");
   registry->RegisterOrDie<ReservoirSampleUDA<types::StringValue>>("sample");
+  registry->RegisterOrDie<ReservoirSampleUDA<types::Int64Value>>("sample");
+  registry->RegisterOrDie<ReservoirSampleUDA<types::Float64Value>>("sample");
+  registry->RegisterOrDie<ReservoirSampleUDA<types::BoolValue>>("sample");
+  registry->RegisterOrDie<ReservoirSampleUDA<types::Time64NSValue>>("sample");
+  registry->RegisterOrDie<ReservoirSampleUDA<types::UInt128Value>>("sample");
+  registry->RegisterOrDie<ReservoirSampleNUDA<types::StringValue>>("sample_n");
+  registry->RegisterOrDie<ReservoirSampleNUDA<types::Int64Value>>("sample_n");
+  registry->RegisterOrDie<ReservoirSampleNUDA<types::Float64Value>>("sample_n");
+  registry->RegisterOrDie<ReservoirSampleNUDA<types::BoolValue>>("sample_n");
+  registry->RegisterOrDie<ReservoirSampleNUDA<types::Time64NSValue>>("sample_n");
 }
 
 int load_floats_from_json(std::string in, Eigen::VectorXf* out, int max_num) {
@@ -24,8 +24,13 @@
 #include <rapidjson/writer.h>
 #include <sentencepiece/sentencepiece_processor.h>
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/exec/ml/coreset.h"
@@ -61,6 +66,25 @@ class TransformerUDF : public udf::ScalarUDF {
     return output;
   }
 
+  // Embeds the docs of a batch with a single borrowed executor, so that the model runs on a
+  // tensor batch of docs at a time.
+  Status ExecBatch(FunctionContext* ctx, size_t count, const StringValue* docs, StringValue* out) {
+    auto executor =
+        ctx->model_pool()->GetModelExecutor<exec::ml::TransformerExecutor>(model_proto_path_);
+    std::vector<const std::string*> batch(count);
+    for (size_t i = 0; i < count; ++i) {
+      batch[i] = &docs[i];
+    }
+    std::vector<std::string> outputs;
+    executor->ExecuteBatch(batch, &outputs);
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = std::move(outputs[i]);
+    }
+    return Status::OK();
+  }
+
+  static constexpr bool ExecBatchOnArrow() { return true; }
+
  private:
   std::string model_proto_path_;
 };
@@ -141,44 +165,246 @@ class KMeansUDF : public udf::ScalarUDF {
   std::unique_ptr<KMeans> kmeans_;
 };
 
+/**
+ * ReservoirSampler keeps a uniform random sample of up to k values. Each value gets a random key
+ * and the sample is the k values with the largest keys, which is weighted reservoir sampling
+ * (A-Res) with unit weights. Unlike the classic reservoir algorithm, the sample of two samplers
+ * is then just the k largest keys of both, so partial samples can be merged exactly.
+ */
 template <typename TArg>
-class ReservoirSampleUDA : public udf::UDA {
+class ReservoirSampler {
  public:
-  ReservoirSampleUDA() : ReservoirSampleUDA(1) {}
-  explicit ReservoirSampleUDA(size_t k) : k_(k), count_(0) {}
-  void Update(FunctionContext*, TArg val) {
-    count_++;
-    if (reservoir_.size() < k_) {
-      reservoir_.push_back(val);
-      return;
+  explicit ReservoirSampler(size_t k) : k_(k) {}
+
+  size_t k() const { return k_; }
+  void set_k(size_t k) { k_ = k; }
+
+  void Add(const TArg& val) { Insert(exec::ml::randreal(), val); }
+
+  void Merge(const ReservoirSampler& other) {
+    if (k_ == 0) {
+      k_ = other.k_;
     }
-    auto i = exec::ml::randint(count_);
-    if (i < k_) {
-      reservoir_[i] = val;
+    for (const auto& entry : other.entries_) {
+      Insert(entry.key, entry.val);
     }
   }
-  void Merge(FunctionContext*, const ReservoirSampleUDA<TArg>& other) {
-    DCHECK_EQ(k_, other.k_);
-    for (const auto& val : other.reservoir_) {
-      if (reservoir_.size() < k_) {
-        reservoir_.push_back(val);
-        continue;
+
+  // The sampled values, in no particular order.
+  std::vector<TArg> Values() const {
+    std::vector<TArg> values;
+    values.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+      values.push_back(entry.val);
+    }
+    return values;
+  }
+
+  // The serialized sample is the version, k and the entry count, followed by each entry's key
+  // and value. Strings are serialized as their length and data.
+  std::string Serialize() const {
+    std::string out;
+    out.push_back(kWireVersion);
+    AppendPOD<uint32_t>(&out, k_);
+    AppendPOD<uint32_t>(&out, entries_.size());
+    for (const auto& entry : entries_) {
+      AppendPOD<double>(&out, entry.key);
+      if constexpr (std::is_same_v<TArg, types::StringValue>) {
+        AppendPOD<uint32_t>(&out, entry.val.size());
+        out.append(entry.val);
+      } else {
+        AppendPOD(&out, entry.val.val);
       }
-      size_t i = exec::ml::randint(count_ + other.count_);
-      if (i < other.count_) {
-        reservoir_[i % k_] = val;
+    }
+    return out;
+  }
+
+  // Merges the serialized sample into this one.
+  Status Deserialize(std::string_view data) {
+    constexpr size_t kHeaderSize = sizeof(char) + 2 * sizeof(uint32_t);
+    if (data.size() < kHeaderSize || data[0] != kWireVersion) {
+      return error::InvalidArgument("Invalid serialized reservoir sample");
+    }
+    ReservoirSampler other(ReadPOD<uint32_t>(data.data() + sizeof(char)));
+    auto num_entries = ReadPOD<uint32_t>(data.data() + sizeof(char) + sizeof(uint32_t));
+    data.remove_prefix(kHeaderSize);
+    for (uint32_t i = 0; i < num_entries; ++i) {
+      if (data.size() < sizeof(double)) {
+        return error::InvalidArgument("Invalid serialized reservoir sample");
       }
+      Entry entry;
+      entry.key = ReadPOD<double>(data.data());
+      data.remove_prefix(sizeof(double));
+      if constexpr (std::is_same_v<TArg, types::StringValue>) {
+        if (data.size() < sizeof(uint32_t)) {
+          return error::InvalidArgument("Invalid serialized reservoir sample");
+        }
+        auto size = ReadPOD<uint32_t>(data.data());
+        data.remove_prefix(sizeof(uint32_t));
+        if (data.size() < size) {
+          return error::InvalidArgument("Invalid serialized reservoir sample");
+        }
+        entry.val = types::StringValue(std::string(data.substr(0, size)));
+        data.remove_prefix(size);
+      } else {
+        using TNative = decltype(entry.val.val);
+        if (data.size() < sizeof(TNative)) {
+          return error::InvalidArgument("Invalid serialized reservoir sample");
+        }
+        entry.val = TArg(ReadPOD<TNative>(data.data()));
+        data.remove_prefix(sizeof(TNative));
+      }
+      other.entries_.push_back(std::move(entry));
+    }
+    if (!data.empty()) {
+      return error::InvalidArgument("Invalid serialized reservoir sample");
+    }
+    Merge(other);
+    return Status::OK();
+  }
+
+ private:
+  static constexpr char kWireVersion = 1;
+
+  struct Entry {
+    double key;
+    TArg val;
+  };
+  // Orders entries_ as a min-heap on the key, so that the front is the first entry to replace.
+  static bool KeyGreater(const Entry& a, const Entry& b) { return a.key > b.key; }
+
+  void Insert(double key, const TArg& val) {
+    if (entries_.size() < k_) {
+      entries_.push_back(Entry{key, val});
+      std::push_heap(entries_.begin(), entries_.end(), KeyGreater);
+      return;
+    }
+    if (k_ == 0 || key <= entries_.front().key) {
+      return;
     }
-    count_ += other.count_;
+    std::pop_heap(entries_.begin(), entries_.end(), KeyGreater);
+    entries_.back() = Entry{key, val};
+    std::push_heap(entries_.begin(), entries_.end(), KeyGreater);
+  }
+
+  template <typename T>
+  static void AppendPOD(std::string* out, T val) {
+    out->append(reinterpret_cast<const char*>(&val), sizeof(val));
+  }
+
+  template <typename T>
+  static T ReadPOD(const char* data) {
+    T val;
+    std::memcpy(&val, data, sizeof(val));
+    return val;
+  }
+
+  size_t k_;
+  std::vector<Entry> entries_;
+};
+
+template <typename TArg>
+class ReservoirSampleUDA : public udf::UDA {
+ public:
+  ReservoirSampleUDA() : ReservoirSampleUDA(1) {}
+  explicit ReservoirSampleUDA(size_t k) : sampler_(k) {}
+  void Update(FunctionContext*, TArg val) { sampler_.Add(val); }
+  void Merge(FunctionContext*, const ReservoirSampleUDA<TArg>& other) {
+    sampler_.Merge(other.sampler_);
   }
   TArg Finalize(FunctionContext*) {
-    return reservoir_[0];
+    auto values = sampler_.Values();
+    return values.empty() ? TArg() : values[0];
+  }
+
+  StringValue Serialize(FunctionContext*) { return sampler_.Serialize(); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return sampler_.Deserialize(data);
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Returns a random value of the group.")
+        .Details(
+            "Picks a value uniformly at random from each group. The sample is computed on the "
+            "agents and merged, so only one value per group is sent over the network.")
+        .Example("df = df.agg(example_req_path=('req_path', px.sample))")
+        .Arg("arg", "The values to sample from.")
+        .Returns("One value of the group.");
   }
 
  private:
-  size_t k_;
-  size_t count_;
-  std::vector<TArg> reservoir_;
+  ReservoirSampler<TArg> sampler_;
+};
+
+template <typename TArg>
+class ReservoirSampleNUDA : public udf::UDA {
+ public:
+  // The most values that sample_n keeps per group.
+  static constexpr int64_t kMaxSampleSize = 1024;
+
+  ReservoirSampleNUDA() : sampler_(0) {}
+  void Update(FunctionContext*, TArg val, Int64Value k) {
+    if (sampler_.k() == 0) {
+      sampler_.set_k(std::clamp<int64_t>(k.val, 1, kMaxSampleSize));
+    }
+    sampler_.Add(val);
+  }
+  void Merge(FunctionContext*, const ReservoirSampleNUDA<TArg>& other) {
+    sampler_.Merge(other.sampler_);
+  }
+  StringValue Finalize(FunctionContext*) {
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    writer.StartArray();
+    for (const auto& val : sampler_.Values()) {
+      WriteJSONValue(&writer, val);
+    }
+    writer.EndArray();
+    return std::string(sb.GetString(), sb.GetSize());
+  }
+
+  StringValue Serialize(FunctionContext*) { return sampler_.Serialize(); }
+
+  Status Deserialize(FunctionContext*, const StringValue& data) {
+    return sampler_.Deserialize(data);
+  }
+
+  static udf::UDADocBuilder Doc() {
+    return udf::UDADocBuilder("Returns random values of the group.")
+        .Details(
+            "Picks up to k values uniformly at random from each group, without replacement. The "
+            "samples are computed on the agents and merged, so at most k values per group are "
+            "sent over the network. k is read from the first row of the group, and is capped at "
+            "1024.")
+        .Example(R"doc(
+        | df.k = 5
+        | df = df.groupby('req_path').agg(example_latencies=('latency', 'k', px.sample_n))
+        )doc")
+        .Arg("arg", "The values to sample from.")
+        .Arg("k", "The number of values to sample.")
+        .Returns("A JSON array of up to k values of the group.");
+  }
+
+ private:
+  template <typename TWriter>
+  static void WriteJSONValue(TWriter* writer, const StringValue& val) {
+    writer->String(val.data(), val.size());
+  }
+  template <typename TWriter>
+  static void WriteJSONValue(TWriter* writer, const Int64Value& val) {
+    writer->Int64(val.val);
+  }
+  template <typename TWriter>
+  static void WriteJSONValue(TWriter* writer, const Float64Value& val) {
+    writer->Double(val.val);
+  }
+  template <typename TWriter>
+  static void WriteJSONValue(TWriter* writer, const BoolValue& val) {
+    writer->Bool(val.val);
+  }
+
+  ReservoirSampler<TArg> sampler_;
 };
 
 void RegisterMLOpsOrDie(udf::Registry* registry);
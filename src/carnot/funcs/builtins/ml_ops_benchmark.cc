@@ -73,6 +73,24 @@ static void BM_TransformerModel(benchmark::State& state) {
   }
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TransformerModelBatch(benchmark::State& state) {
+  px::carnot::builtins::TransformerUDF udf(FLAGS_embedding_dir);
+  auto model_pool = px::carnot::exec::ml::ModelPool::Create();
+  auto ctx = px::carnot::udf::FunctionContext(nullptr, model_pool.get());
+  std::vector<px::types::StringValue> docs;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    auto ints = random_ints(64);
+    docs.push_back(px::carnot::builtins::write_ints_to_json(ints.data(), 64));
+  }
+  std::vector<px::types::StringValue> out(docs.size());
+
+  for (auto _ : state) {
+    PL_CHECK_OK(udf.ExecBatch(&ctx, docs.size(), docs.data(), out.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
 // NOLINTNEXTLINE : runtime/references.
 static void BM_SentencePiece(benchmark::State& state) {
   auto udf = px::carnot::builtins::SentencePieceUDF(FLAGS_sentencepiece_dir);
@@ -85,3 +103,4 @@ static void BM_SentencePiece(benchmark::State& state) {
 
 BENCHMARK(BM_SentencePiece)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_TransformerModel)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TransformerModelBatch)->Arg(1)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond);
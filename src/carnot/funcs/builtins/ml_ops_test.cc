@@ -18,6 +18,7 @@
 
 #include <gflags/gflags.h>
 #include <gmock/gmock.h>
+#include <algorithm>
 #include <memory>
 #include <numeric>
 #include <string>
@@ -25,6 +26,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/strings/str_cat.h>
+
 #include "src/carnot/funcs/builtins/ml_ops.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
@@ -150,6 +153,66 @@ TEST(Transformer, basic) {
       "15099024772644044,-0.10007300972938538,1.1897741556167603]");
 }
 
+TEST(Transformer, exec_batch) {
+  auto pool = exec::ml::ModelPool::Create();
+  FunctionContext ctx(nullptr, pool.get());
+  TransformerUDF udf(FLAGS_embedding_dir);
+  // More docs than fit in one tensor batch, and an invalid doc in the middle.
+  std::vector<types::StringValue> docs;
+  for (int i = 0; i < 2 * FLAGS_carnot_ml_inference_batch_size + 1; ++i) {
+    docs.push_back(i == 3 ? "not json" : absl::StrCat("[4,197,", i, ",195,16,5001]"));
+  }
+  std::vector<types::StringValue> out(docs.size());
+  ASSERT_OK(udf.ExecBatch(&ctx, docs.size(), docs.data(), out.data()));
+  for (const auto& [i, doc] : Enumerate(docs)) {
+    EXPECT_EQ(udf.Exec(&ctx, doc), out[i]);
+  }
+  EXPECT_EQ("", out[3]);
+}
+
+TEST(ReservoirSample, single_value) {
+  auto uda_tester = udf::UDATester<ReservoirSampleUDA<types::StringValue>>();
+  uda_tester.ForInput("a").ForInput("a").ForInput("a").Expect("a");
+}
+
+std::vector<int64_t> ParseSample(const std::string& json) {
+  rapidjson::Document d;
+  d.Parse(json.data());
+  EXPECT_TRUE(d.IsArray());
+  std::vector<int64_t> values;
+  for (const auto& v : d.GetArray()) {
+    values.push_back(v.GetInt64());
+  }
+  std::sort(values.begin(), values.end());
+  return values;
+}
+
+TEST(ReservoirSampleN, merge_partial_samples) {
+  auto tester1 = udf::UDATester<ReservoirSampleNUDA<types::Int64Value>>();
+  auto tester2 = udf::UDATester<ReservoirSampleNUDA<types::Int64Value>>();
+  for (int64_t i = 0; i < 100; ++i) {
+    tester1.ForInput(i, 3);
+    tester2.ForInput(100 + i, 3);
+  }
+  // Each partial sample only holds k values.
+  EXPECT_EQ(ParseSample(tester2.Result()).size(), 3);
+
+  ASSERT_OK(tester1.Deserialize(tester2.Serialize()));
+  auto values = ParseSample(tester1.Result());
+  ASSERT_EQ(values.size(), 3);
+  EXPECT_EQ(std::unique(values.begin(), values.end()), values.end());
+  for (int64_t v : values) {
+    EXPECT_GE(v, 0);
+    EXPECT_LT(v, 200);
+  }
+}
+
+TEST(ReservoirSampleN, fewer_values_than_k) {
+  auto uda_tester = udf::UDATester<ReservoirSampleNUDA<types::Int64Value>>();
+  uda_tester.ForInput(1, 5).ForInput(2, 5);
+  EXPECT_THAT(ParseSample(uda_tester.Result()), ::testing::ElementsAre(1, 2));
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
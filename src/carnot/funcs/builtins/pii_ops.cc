@@ -36,6 +36,30 @@ void RegisterPIIOpsOrDie(udf::Registry* registry) {
    *****************************************/
 }
 
+CharCounts::CharCounts(std::string_view input) {
+  for (char c : input) {
+    switch (c) {
+      case '.':
+        ++dots;
+        break;
+      case ':':
+        ++colons;
+        break;
+      case '-':
+        ++dashes;
+        break;
+      case '@':
+        ++ats;
+        break;
+      case '%':
+        ++percents;
+        break;
+      default:
+        digits += (c >= '0' && c <= '9');
+    }
+  }
+}
+
 template <>
 struct TagTypeTraits<Tag::Type::IPv6> {
   static constexpr std::string_view BuildRegexPattern() {
@@ -121,6 +145,8 @@ struct TagTypeTraits<Tag::Type::IPv6> {
   }
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_IPV6>"; }
   static bool Filter(std::string_view) { return true; }
+  // The shortest match is "::".
+  static bool MayMatch(const CharCounts& counts) { return counts.colons >= 2; }
 };
 
 template <>
@@ -137,6 +163,7 @@ struct TagTypeTraits<Tag::Type::IPv4> {
   }
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_IPV4>"; }
   static bool Filter(std::string_view) { return true; }
+  static bool MayMatch(const CharCounts& counts) { return counts.dots >= 3 && counts.digits >= 4; }
 };
 
 template <>
@@ -153,6 +180,7 @@ struct TagTypeTraits<Tag::Type::EMAIL_ADDR> {
   }
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_EMAIL>"; }
   static bool Filter(std::string_view) { return true; }
+  static bool MayMatch(const CharCounts& counts) { return counts.ats > 0 || counts.percents > 0; }
 };
 
 template <>
@@ -164,6 +192,7 @@ struct TagTypeTraits<Tag::Type::MAC_ADDR> {
   }
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_MAC_ADDR>"; }
   static bool Filter(std::string_view) { return true; }
+  static bool MayMatch(const CharCounts& counts) { return counts.colons + counts.dashes >= 5; }
 };
 
 static inline bool CheckLuhn(std::string digits) {
@@ -193,6 +222,7 @@ struct TagTypeTraits<Tag::Type::CC_NUMBER> {
     return "((?:[0-9][ -]*){12,18}[0-9])";
   }
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_CC_NUMBER>"; }
+  static bool MayMatch(const CharCounts& counts) { return counts.digits >= 13; }
   static bool Filter(std::string_view match) {
     std::string match_no_delims(match);
     match_no_delims.erase(std::remove_if(match_no_delims.begin(), match_no_delims.end(),
@@ -208,6 +238,9 @@ struct TagTypeTraits<Tag::Type::IMEI> {
     return "([0-9]{2}-[0-9]{6}-[0-9]{6}-[0-9])";
   }
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_IMEI>"; }
+  static bool MayMatch(const CharCounts& counts) {
+    return counts.dashes >= 3 && counts.digits >= 15;
+  }
   static bool Filter(std::string_view match) {
     std::string match_no_delims(match);
     match_no_delims.erase(std::remove_if(match_no_delims.begin(), match_no_delims.end(),
@@ -223,6 +256,9 @@ struct TagTypeTraits<Tag::Type::IMEISV> {
     return "([0-9]{2}-[0-9]{6}-[0-9]{6}-[0-9]{2})";
   }
   static constexpr std::string_view SubstitutionStr() { return "<REDACTED_IMEI>"; }
+  static bool MayMatch(const CharCounts& counts) {
+    return counts.dashes >= 3 && counts.digits >= 16;
+  }
   // IMEISV doesn't have a Luhn check digit.
   static bool Filter(std::string_view) { return true; }
 };
@@ -251,7 +287,7 @@ Status RedactPIIUDF::Init(FunctionContext*) {
 
 // Replace all tagged sequences in the string with the corresponding substitution string. For
 // overlapping tags, we take the longest tag.
-static inline std::string ReplaceTagsWithSubs(std::string input, std::vector<Tag>* tags) {
+static inline std::string ReplaceTagsWithSubs(const std::string& input, std::vector<Tag>* tags) {
   // Sort the tags chronologically.
   std::sort(tags->begin(), tags->end(), [](Tag a, Tag b) { return a.start_idx < b.start_idx; });
 
@@ -305,13 +341,20 @@ static inline std::string ReplaceTagsWithSubs(std::string input, std::vector<Tag
 }
 
 StringValue RedactPIIUDF::Exec(FunctionContext*, StringValue input) {
+  CharCounts counts(input);
   std::vector<Tag> tags;
   for (const auto& tagger : taggers_) {
+    if (!tagger->MayMatch(counts)) {
+      continue;
+    }
     auto s = tagger->AddTags(&input, &tags);
     if (!s.ok()) {
       return "Invalid regex: " + s.msg();
     }
   }
+  if (tags.empty()) {
+    return input;
+  }
   return ReplaceTagsWithSubs(input, &tags);
 }
 
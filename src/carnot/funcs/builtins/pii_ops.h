@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "re2/re2.h"
@@ -48,12 +49,30 @@ struct Tag {
   size_t size;
 };
 
+/**
+ * Counts of the characters that PII is made of, gathered with a single pass over the input.
+ * Every PII pattern needs a minimum number of some of these characters, which lets the taggers
+ * skip the regex scans of the (many) inputs that can't contain a match.
+ */
+struct CharCounts {
+  explicit CharCounts(std::string_view input);
+
+  int digits = 0;
+  int dots = 0;
+  int colons = 0;
+  int dashes = 0;
+  int ats = 0;
+  int percents = 0;
+};
+
 template <Tag::Type TTag>
 struct TagTypeTraits {};
 
 class Tagger {
  public:
   virtual ~Tagger() = default;
+  // Returns false if the input can't contain any tag, given its character counts.
+  virtual bool MayMatch(const CharCounts& counts) const = 0;
   virtual Status AddTags(std::string* input, std::vector<Tag>* tags) = 0;
 };
 
@@ -90,28 +109,28 @@ class RegexTagger : public Tagger {
     DCHECK_EQ(regex_.error_code(), RE2::NoError) << regex_.error();
   }
 
-  Status AddTags(std::string* input, std::vector<Tag>* tags) {
-    re2::StringPiece input_piece(input->data(), input->length());
-    auto prev_length = input_piece.length();
-    int curr_idx = 0;
-    std::string match;
-    while (RE2::FindAndConsume(&input_piece, regex_, &match)) {
-      auto consumed = prev_length - input_piece.length();
-      if (consumed == 0) {
+  bool MayMatch(const CharCounts& counts) const override {
+    return TagTypeTraits<TTag>::MayMatch(counts);
+  }
+
+  Status AddTags(std::string* input, std::vector<Tag>* tags) override {
+    re2::StringPiece text(input->data(), input->length());
+    // Asking only for the span of the whole match lets RE2 find it with its DFAs, without running
+    // the slower submatch engines.
+    re2::StringPiece match;
+    size_t pos = 0;
+    while (pos <= text.length() &&
+           regex_.Match(text, pos, text.length(), RE2::UNANCHORED, &match, 1)) {
+      if (match.empty()) {
         return Status(statuspb::Code::INVALID_ARGUMENT,
                       "RegexTagger has a regex pattern which matches an empty string.");
       }
-      if (!TagTypeTraits<TTag>::Filter(match)) {
+      auto start_idx = static_cast<int>(match.data() - text.data());
+      pos = start_idx + match.length();
+      if (!TagTypeTraits<TTag>::Filter(std::string_view(match.data(), match.length()))) {
         continue;
       }
-      auto match_size = match.length();
-      // FindAndConsume is not anchored at the start of the StringPiece. To find the start we look
-      // at how much more was consumed than matched.
-      int start_idx = curr_idx + (consumed - match_size);
-      prev_length = input_piece.length();
-      curr_idx += consumed;
-
-      tags->push_back(Tag{TTag, start_idx, match_size});
+      tags->push_back(Tag{TTag, start_idx, match.length()});
     }
     return Status::OK();
   }
@@ -51,6 +51,25 @@ static void BM_RedactPII(benchmark::State& state) {
 
 BENCHMARK(BM_RedactPII)->RangeMultiplier(2)->Range(1, 12);
 
+// Most of the rows that get redacted are log lines and HTTP paths without any PII.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_RedactPII_NoCandidates(benchmark::State& state) {
+  RedactPIIUDF udf;
+  PL_UNUSED(udf.Init(nullptr));
+
+  std::string text;
+  for (int i = 0; i < state.range(0); i++) {
+    text += "GET /api/v1/users/profile?id=42 HTTP/1.1 200 OK ";
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(udf.Exec(nullptr, text));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(text.length()) *
+                          static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_RedactPII_NoCandidates)->RangeMultiplier(2)->Range(1, 12);
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
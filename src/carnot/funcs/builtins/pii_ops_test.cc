@@ -221,6 +221,31 @@ INSTANTIATE_TEST_SUITE_P(TemplatedRedactionTest, RedactionTest,
                          testing::ValuesIn(TestCaseGen({IPv4Gen(), IPv6Gen(), EmailGen(), CCGen(),
                                                         IMEIGen(), NegativeExampleGen()})));
 
+TEST(CharCountsTest, counts) {
+  CharCounts counts("a1.b2:c3-d4@e5%f6::..");
+  EXPECT_EQ(6, counts.digits);
+  EXPECT_EQ(3, counts.dots);
+  EXPECT_EQ(3, counts.colons);
+  EXPECT_EQ(1, counts.dashes);
+  EXPECT_EQ(1, counts.ats);
+  EXPECT_EQ(1, counts.percents);
+}
+
+TEST(RedactPIIUDFTest, prefiltered_inputs_are_unchanged) {
+  udf::UDFTester<RedactPIIUDF> tester;
+  tester.Init();
+  // None of these have enough of the characters of any PII type to be scanned.
+  tester.ForInput("").Expect("");
+  tester.ForInput("GET /api/v1/users HTTP/1.1").Expect("GET /api/v1/users HTTP/1.1");
+  tester.ForInput("1.2.3").Expect("1.2.3");
+  tester.ForInput("123456789012").Expect("123456789012");
+  // Candidates that the regexes then reject.
+  tester.ForInput("a:b:c:d:e:f").Expect("a:b:c:d:e:f");
+  tester.ForInput("1234567890123").Expect("1234567890123");
+  // Sanity check that inputs with PII still go through the taggers.
+  tester.ForInput("from 10.0.0.1 to ::1").Expect("from <REDACTED_IPV4> to <REDACTED_IPV6>");
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
@@ -77,9 +77,13 @@ class RegexReplaceUDF : public udf::ScalarUDF {
     if (regex_->error_code() != RE2::NoError) {
       return absl::Substitute("Invalid regex expr: $0", regex_->error());
     }
-    std::string err_str;
-    if (!regex_->CheckRewriteString(sub, &err_str)) {
-      return absl::Substitute("Invalid regex in substitution string: $0", err_str);
+    // The substitution string is almost always a constant, so only check it when it changes.
+    if (sub != checked_sub_) {
+      std::string err_str;
+      if (!regex_->CheckRewriteString(sub, &err_str)) {
+        return absl::Substitute("Invalid regex in substitution string: $0", err_str);
+      }
+      checked_sub_ = sub;
     }
     RE2::GlobalReplace(&input, *regex_, sub);
     return input;
@@ -108,6 +112,7 @@ class RegexReplaceUDF : public udf::ScalarUDF {
 
  private:
   std::unique_ptr<re2::RE2> regex_;
+  std::string checked_sub_;
 };
 
 void RegisterRegexOpsOrDie(udf::Registry* registry);
@@ -41,19 +41,17 @@ void RegisterRequestPathOpsOrDie(udf::Registry* registry) {
 }
 
 RequestPath::RequestPath(std::string request_path) {
+  for (std::string_view path_component : SplitPathComponents(request_path)) {
+    path_components_.emplace_back(path_component);
+  }
+}
+
+std::vector<std::string_view> RequestPath::SplitPathComponents(std::string_view request_path) {
   // Chop off request params for now. In the future, we want to keep these around and include
   // them in the clustering.
-  std::string request_path_no_params;
-  auto param_index = request_path.find('?');
-  if (param_index == std::string::npos) {
-    request_path_no_params = request_path;
-  } else {
-    request_path_no_params = request_path.substr(0, param_index);
-  }
-  if (request_path_no_params[0] == '/') {
-    request_path_no_params = request_path_no_params.substr(1, request_path_no_params.size() - 1);
-  }
-  path_components_ = absl::StrSplit(request_path_no_params, '/');
+  request_path = request_path.substr(0, request_path.find('?'));
+  absl::ConsumePrefix(&request_path, "/");
+  return absl::StrSplit(request_path, '/');
 }
 
 double RequestPath::Similarity(const RequestPath& other) const {
@@ -141,6 +139,22 @@ bool RequestPath::Matches(const RequestPath& templ) const {
   return true;
 }
 
+bool RequestPath::Matches(const std::vector<std::string_view>& path_components,
+                          const RequestPath& templ) {
+  if (static_cast<int64_t>(path_components.size()) != templ.depth()) {
+    return false;
+  }
+  for (const auto& [i, path_component] : Enumerate(path_components)) {
+    if (templ.path_components()[i] == kAnyToken) {
+      continue;
+    }
+    if (path_component != templ.path_components()[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void RequestPathCluster::Merge(const RequestPathCluster& other_cluster) {
   MergeCentroids(other_cluster.centroid_);
   MergeMembers(other_cluster.members_);
@@ -333,6 +347,73 @@ void RequestPathClustering::Merge(const RequestPathClustering& other_clustering)
   }
 }
 
+CompiledRequestPathClustering::CompiledRequestPathClustering(
+    const RequestPathClustering& clustering) {
+  for (const auto& [cluster_idx, cluster] : Enumerate(clustering.clusters())) {
+    const RequestPath& centroid = cluster.centroid();
+    Cluster& compiled = clusters_.emplace_back();
+    compiled.centroid = centroid.ToString();
+    for (const auto& member : cluster.members()) {
+      compiled.members.insert(member.ToString());
+    }
+
+    // Clusters are considered in index order, as by RequestPathClustering::MaxSimilarity.
+    DepthIndex& depth = depths_[centroid.depth()];
+    depth.components.resize(centroid.depth());
+    int64_t pos = depth.clusters.size();
+    depth.clusters.push_back(cluster_idx);
+    for (const auto& [i, path_component] : Enumerate(centroid.path_components())) {
+      if (path_component != RequestPath::kAnyToken) {
+        depth.components[i][path_component].push_back(pos);
+      }
+    }
+  }
+}
+
+std::string CompiledRequestPathClustering::Predict(std::string_view request_path) const {
+  std::vector<std::string_view> path_components = RequestPath::SplitPathComponents(request_path);
+  std::string path = "/" + absl::StrJoin(path_components, "/");
+  auto depth_it = depths_.find(path_components.size());
+  if (depth_it == depths_.end()) {
+    DCHECK(false) << absl::Substitute("Failed to find cluster close to request path $0", path);
+    return path;
+  }
+  const DepthIndex& depth = depth_it->second;
+
+  // The similarity of the path to each centroid, in number of agreeing path components.
+  std::vector<int64_t> num_agree(depth.clusters.size(), 0);
+  for (const auto& [i, path_component] : Enumerate(path_components)) {
+    if (path_component == RequestPath::kAnyToken) {
+      continue;
+    }
+    auto it = depth.components[i].find(path_component);
+    if (it == depth.components[i].end()) {
+      continue;
+    }
+    for (int64_t pos : it->second) {
+      ++num_agree[pos];
+    }
+  }
+  int64_t closest_pos = -1;
+  int64_t max_agree = 0;
+  for (const auto& [pos, agree] : Enumerate(num_agree)) {
+    if (agree > max_agree) {
+      closest_pos = pos;
+      max_agree = agree;
+    }
+  }
+  if (closest_pos == -1) {
+    DCHECK(false) << absl::Substitute("Failed to find cluster close to request path $0", path);
+    return path;
+  }
+
+  const Cluster& cluster = clusters_[depth.clusters[closest_pos]];
+  if (cluster.members.contains(path)) {
+    return path;
+  }
+  return cluster.centroid;
+}
+
 }  // namespace builtins
 }  // namespace carnot
 }  // namespace px
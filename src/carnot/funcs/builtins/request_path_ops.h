@@ -20,11 +20,15 @@
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
 #include "src/carnot/udf/registry.h"
 #include "src/shared/types/types.h"
 
@@ -98,6 +102,20 @@ class RequestPath {
   const std::vector<std::string>& path_components() const { return path_components_; }
   inline static constexpr char kAnyToken[] = "*";
 
+  /**
+   * Splits a request path into the path components that RequestPath(request_path) would have,
+   * without copying them.
+   * @param request_path the request path, eg. "/a/b?k=v".
+   * @return views into request_path, eg. {"a", "b"}.
+   */
+  static std::vector<std::string_view> SplitPathComponents(std::string_view request_path);
+
+  /**
+   * Returns whether the given path components match a template request path, as Matches does.
+   */
+  static bool Matches(const std::vector<std::string_view>& path_components,
+                      const RequestPath& templ);
+
  private:
   std::vector<std::string> path_components_;
 };
@@ -207,6 +225,40 @@ class RequestPathClustering {
   double thresh_ = 0.5;
 };
 
+/**
+ * A read-only form of a RequestPathClustering, for predicting the clusters of many request paths.
+ * The centroid path components are indexed by depth and position, so that predicting looks up
+ * each path component once, instead of comparing the path to every centroid of its depth.
+ */
+class CompiledRequestPathClustering {
+ public:
+  explicit CompiledRequestPathClustering(const RequestPathClustering& clustering);
+
+  /**
+   * @param request_path request path to get prediction for.
+   * @return the same as RequestPathClustering::Predict(RequestPath(request_path)).ToString().
+   */
+  std::string Predict(std::string_view request_path) const;
+
+ private:
+  struct Cluster {
+    std::string centroid;
+    // The members as strings. Path components can't contain '/', so two request paths of the
+    // same depth are equal iff their strings are.
+    absl::flat_hash_set<std::string> members;
+  };
+  struct DepthIndex {
+    // Indices into clusters_, in the order the clustering considers them.
+    std::vector<int64_t> clusters;
+    // For each path component position, the centroid component values (other than kAnyToken),
+    // mapped to the positions in `clusters` of the clusters that have them.
+    std::vector<absl::flat_hash_map<std::string, std::vector<int64_t>>> components;
+  };
+
+  std::vector<Cluster> clusters_;
+  absl::flat_hash_map<int64_t, DepthIndex> depths_;
+};
+
 class RequestPathClusteringPredictUDF : public udf::ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue request_path_str,
@@ -216,14 +268,30 @@ class RequestPathClusteringPredictUDF : public udf::ScalarUDF {
       if (!clustering_or_s.ok()) {
         return clustering_or_s.msg();
       }
-      clustering_ = clustering_or_s.ConsumeValueOrDie();
+      clustering_ = std::make_unique<CompiledRequestPathClustering>(clustering_or_s.ValueOrDie());
       clustering_init_ = true;
     }
-    auto request_path = RequestPath(request_path_str);
-    return clustering_.Predict(request_path).ToString();
+    return clustering_->Predict(request_path_str);
   }
 
-  RequestPathClustering clustering_;
+  // Predicts once per distinct request path in the batch.
+  Status ExecBatch(FunctionContext* ctx, size_t count, const StringValue* request_paths,
+                   const StringValue* serialized_clusterings, StringValue* out) {
+    absl::flat_hash_map<std::string_view, size_t> first_rows;
+    for (size_t i = 0; i < count; ++i) {
+      if (i > 0 && request_paths[i] == request_paths[i - 1]) {
+        out[i] = out[i - 1];
+        continue;
+      }
+      auto [it, inserted] = first_rows.try_emplace(request_paths[i], i);
+      out[i] = inserted ? Exec(ctx, request_paths[i], serialized_clusterings[i]) : out[it->second];
+    }
+    return Status::OK();
+  }
+
+  static constexpr bool ExecBatchOnArrow() { return true; }
+
+  std::unique_ptr<CompiledRequestPathClustering> clustering_;
   bool clustering_init_ = false;
 };
 
@@ -252,8 +320,19 @@ class RequestPathClusteringFitUDA : public udf::UDA {
 class RequestPathEndpointMatcherUDF : public udf::ScalarUDF {
  public:
   BoolValue Exec(FunctionContext*, StringValue request_path, StringValue endpoint) {
-    return RequestPath(request_path).Matches(RequestPath(endpoint));
+    // The endpoint is usually the same for every row, so only parse it when it changes.
+    if (!endpoint_init_ || endpoint != endpoint_str_) {
+      endpoint_ = RequestPath(endpoint);
+      endpoint_str_ = endpoint;
+      endpoint_init_ = true;
+    }
+    return RequestPath::Matches(RequestPath::SplitPathComponents(request_path), endpoint_);
   }
+
+ private:
+  RequestPath endpoint_;
+  std::string endpoint_str_;
+  bool endpoint_init_ = false;
 };
 
 }  // namespace builtins
@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <string>
 #include <vector>
 
 #include "src/carnot/funcs/builtins/request_path_ops.h"
@@ -93,6 +94,49 @@ TEST(RequestPathClusteringPredict, basic_low_cardinality) {
   udf_tester.ForInput("/a/b/c", serialized_clustering).Expect("/a/b/c");
 }
 
+TEST(RequestPathClusteringPredict, compiled_matches_clustering) {
+  auto uda_tester = udf::UDATester<RequestPathClusteringFitUDA>();
+  auto serialized_clustering = uda_tester.ForInput("/a/b/c")
+                                   .ForInput("/a/b/d")
+                                   .ForInput("a/b/a")
+                                   .ForInput("/a/b/b")
+                                   .ForInput("/a/b/e")
+                                   .ForInput("a/b/f")
+                                   .ForInput("/x/y/z")
+                                   .ForInput("/x/q/z")
+                                   .ForInput("/users/1")
+                                   .ForInput("/users/2?k=v")
+                                   .Result();
+  ASSERT_OK_AND_ASSIGN(auto clustering, RequestPathClustering::FromJSON(serialized_clustering));
+  CompiledRequestPathClustering compiled(clustering);
+
+  for (const char* path : {"/a/b/c", "a/b/z", "/a/q/c", "/x/y/z", "/x/y/q", "/x/b/z", "/users/2",
+                           "/users/3?k=v", "/q/y/z"}) {
+    EXPECT_EQ(clustering.Predict(RequestPath(path)).ToString(), compiled.Predict(path)) << path;
+  }
+}
+
+TEST(RequestPathClusteringPredict, exec_batch) {
+  auto uda_tester = udf::UDATester<RequestPathClusteringFitUDA>();
+  std::string serialized_clustering = uda_tester.ForInput("/a/b/d").ForInput("/a/b/c").Result();
+
+  std::vector<types::StringValue> paths = {"/a/b/c", "/a/b/c", "/a/b/x", "/a/b/c", "/a/b/x"};
+  std::vector<types::StringValue> clusterings(paths.size(), serialized_clustering);
+  std::vector<types::StringValue> out(paths.size());
+  RequestPathClusteringPredictUDF udf;
+  ASSERT_OK(udf.ExecBatch(nullptr, paths.size(), paths.data(), clusterings.data(), out.data()));
+  EXPECT_THAT(out, testing::ElementsAre("/a/b/c", "/a/b/c", "/a/b/*", "/a/b/c", "/a/b/*"));
+}
+
+TEST(RequestPath, split_path_components) {
+  EXPECT_THAT(RequestPath::SplitPathComponents("/a/b?k=v/c"), testing::ElementsAre("a", "b"));
+  EXPECT_THAT(RequestPath::SplitPathComponents("a//b/"), testing::ElementsAre("a", "", "b", ""));
+  EXPECT_THAT(RequestPath::SplitPathComponents(""), testing::ElementsAre(""));
+  auto components = RequestPath::SplitPathComponents("/a//b/");
+  EXPECT_EQ(RequestPath("a//b/").path_components(),
+            std::vector<std::string>(components.begin(), components.end()));
+}
+
 TEST(RequestPathEndpointMatcher, basic) {
   auto udf_tester = udf::UDFTester<RequestPathEndpointMatcherUDF>();
   udf_tester.ForInput("/a/b/c", "/a/b/*").Expect(true);
@@ -21,6 +21,10 @@
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
 
+DEFINE_bool(carnot_share_sql_normalization_cache, false,
+            "Whether the SQL normalization funcs of all queries share a single cache of query "
+            "shapes, rather than each query having its own.");
+
 namespace {
 static inline px::Status ParseExecuteCommand(std::string execute, std::string* query,
                                              std::vector<std::string>* param_values) {
@@ -75,7 +79,7 @@ types::StringValue NormalizePostgresSQLUDF::Exec(FunctionContext*, StringValue s
     return result.ToJSON();
   }
 
-  auto result_or_s = sql_parsing::normalize_pgsql(query, param_values);
+  auto result_or_s = cache()->Normalize(sql_parsing::SQLDialect::kPostgres, query, param_values);
   if (!result_or_s.ok()) {
     sql_parsing::NormalizeResult result;
     result.errmsg = result_or_s.status().msg();
@@ -105,7 +109,7 @@ types::StringValue NormalizeMySQLUDF::Exec(FunctionContext*, StringValue sql_str
     return result.ToJSON();
   }
 
-  auto result_or_s = sql_parsing::normalize_mysql(query, param_values);
+  auto result_or_s = cache()->Normalize(sql_parsing::SQLDialect::kMySQL, query, param_values);
   if (!result_or_s.ok()) {
     sql_parsing::NormalizeResult result;
     result.errmsg = result_or_s.status().msg();
@@ -19,24 +19,50 @@
 #pragma once
 
 #include <absl/strings/strip.h>
+#include <gflags/gflags.h>
+#include <memory>
 #include <regex>
 #include <string>
 #include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+#include "src/carnot/funcs/builtins/sql_parsing/normalization_cache.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/status.h"
 #include "src/common/base/utils.h"
 #include "src/shared/types/types.h"
 
+DECLARE_bool(carnot_share_sql_normalization_cache);
+
 namespace px {
 namespace carnot {
 namespace builtins {
 
+/**
+ * The SQL normalization UDFs keep the normalization of each query shape they've seen, for the rest
+ * of the query. With --carnot_share_sql_normalization_cache, all the queries on the agent share
+ * a single cache instead.
+ */
+class SQLNormalizationUDF : public udf::ScalarUDF {
+ protected:
+  sql_parsing::NormalizationCache* cache() {
+    if (FLAGS_carnot_share_sql_normalization_cache) {
+      return sql_parsing::NormalizationCache::Global();
+    }
+    if (cache_ == nullptr) {
+      cache_ = std::make_unique<sql_parsing::NormalizationCache>();
+    }
+    return cache_.get();
+  }
+
+ private:
+  std::unique_ptr<sql_parsing::NormalizationCache> cache_;
+};
+
 static constexpr char kPgExecCmdCode[] = "Execute";
 static constexpr char kPgQueryCmdCode[] = "Query";
 static constexpr int64_t kMySQLQueryCmdCode = 0x03;
 static constexpr int64_t kMySQLExecuteCmdCode = 0x17;
 
-class NormalizePostgresSQLUDF : public udf::ScalarUDF {
+class NormalizePostgresSQLUDF : public SQLNormalizationUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue sql_str, StringValue cmd_code);
 
@@ -61,7 +87,7 @@ class NormalizePostgresSQLUDF : public udf::ScalarUDF {
   }
 };
 
-class NormalizeMySQLUDF : public udf::ScalarUDF {
+class NormalizeMySQLUDF : public SQLNormalizationUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue sql_str, Int64Value cmd_code);
 
@@ -117,23 +117,30 @@ NormalizeResult NormalizeResult::FromJSON(std::string json_str) {
 }
 
 void SQLFragmentHandler::ReplaceFragmentWithPlaceholder(const SQLFragment& fragment,
-                                                        absl::string_view placeholder) {
-  result_->normalized_query.replace(state_->line_start_offsets[fragment.line - 1] +
-                                        fragment.start_char_index - state_->n_shift_query,
-                                    fragment.text.length(), placeholder);
+                                                        absl::string_view placeholder,
+                                                        int param_value_index) {
+  size_t offset = state_->line_start_offsets[fragment.line - 1] + fragment.start_char_index;
+  if (state_->replaced_fragments != nullptr) {
+    state_->replaced_fragments->push_back(ReplacedFragment{
+        offset, fragment.text.length(), std::string(placeholder), param_value_index});
+  }
+  result_->normalized_query.replace(offset - state_->n_shift_query, fragment.text.length(),
+                                    placeholder);
   state_->n_shift_query += fragment.text.length() - placeholder.length();
 }
 
 StatusOr<NormalizeResult> normalize_pgsql(std::string sql,
-                                          const std::vector<std::string>& param_values) {
+                                          const std::vector<std::string>& param_values,
+                                          std::vector<ReplacedFragment>* replaced_fragments) {
   return normalize_sql<pgsql_parser::PostgresSQLParser, pgsql_parser::PostgresSQLLexer>(
-      sql, param_values);
+      sql, param_values, replaced_fragments);
 }
 
 StatusOr<NormalizeResult> normalize_mysql(std::string sql,
-                                          const std::vector<std::string>& param_values) {
+                                          const std::vector<std::string>& param_values,
+                                          std::vector<ReplacedFragment>* replaced_fragments) {
   return normalize_sql<mysql_parser::MySQLParser, mysql_parser::MySQLLexer, UpperCaseCharStream>(
-      sql, param_values);
+      sql, param_values, replaced_fragments);
 }
 
 std::ostream& operator<<(std::ostream& os, const NormalizeResult& result) {
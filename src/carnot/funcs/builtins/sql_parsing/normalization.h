@@ -139,12 +139,27 @@ struct NormalizeResult {
 
 std::ostream& operator<<(std::ostream& os, const NormalizeResult& result);
 
+/**
+ * A fragment of the unnormalized query that was replaced with a placeholder.
+ */
+struct ReplacedFragment {
+  // The byte offset of the fragment in the unnormalized query, and its length.
+  size_t offset;
+  size_t length;
+  std::string placeholder;
+  // The index of the parameter value of the fragment, if it was a parameter placeholder, or -1 if
+  // the fragment was a constant.
+  int param_value_index;
+};
+
 struct NormalizationState {
   // Number of characters to shift character indices into the query by, to account for replacements
   // that have already occured.
   int n_shift_query = 0;
   std::vector<int> line_start_offsets;
   std::string next_placeholder;
+  // If set, each replaced fragment is recorded here, in the order of the params.
+  std::vector<ReplacedFragment>* replaced_fragments = nullptr;
 };
 
 static inline void CalculateLineOffsets(std::string query, NormalizationState* state) {
@@ -165,7 +180,8 @@ class SQLFragmentHandler {
   virtual Status HandleFragment(const SQLFragment&) = 0;
 
  protected:
-  void ReplaceFragmentWithPlaceholder(const SQLFragment& frag, absl::string_view placeholder);
+  void ReplaceFragmentWithPlaceholder(const SQLFragment& frag, absl::string_view placeholder,
+                                      int param_value_index);
   NormalizationState* state_;
   NormalizeResult* result_;
 };
@@ -195,7 +211,7 @@ class ParamFragmentHandler : public SQLFragmentHandler {
       return error::InvalidArgument(
           "Query has more parameter placeholders in it than parameter values were passed in");
     }
-    ReplaceFragmentWithPlaceholder(frag, state_->next_placeholder);
+    ReplaceFragmentWithPlaceholder(frag, state_->next_placeholder, index);
     state_->next_placeholder = ParserTypeTraits<TParser>::NextPlaceholder(state_->next_placeholder);
     result_->params.push_back(param_values_[index]);
     return Status::OK();
@@ -211,7 +227,7 @@ class ConstantFragmentHandler : public SQLFragmentHandler {
  public:
   using SQLFragmentHandler::SQLFragmentHandler;
   Status HandleFragment(const SQLFragment& frag) override {
-    ReplaceFragmentWithPlaceholder(frag, state_->next_placeholder);
+    ReplaceFragmentWithPlaceholder(frag, state_->next_placeholder, -1);
     result_->params.push_back(frag.text);
     state_->next_placeholder = ParserTypeTraits<TParser>::NextPlaceholder(state_->next_placeholder);
     return Status::OK();
@@ -223,12 +239,15 @@ class ConstantFragmentHandler : public SQLFragmentHandler {
  * @param sql: Unnormalized SQL query.
  * @param param_values: Parameters already account for in the unnormalized version of the query. For
  * non-EXECUTE type queries this should be empty.
+ * @param replaced_fragments: If not null, filled with the fragments of the query that were replaced
+ * with placeholders.
  * @return status or result, whether the query was successful or not and if it was the normalization
  * result.
  */
 template <typename TParser, typename TLexer, typename TCharStream = antlr4::ANTLRInputStream>
-StatusOr<NormalizeResult> normalize_sql(std::string sql,
-                                        const std::vector<std::string>& param_values) {
+StatusOr<NormalizeResult> normalize_sql(
+    std::string sql, const std::vector<std::string>& param_values,
+    std::vector<ReplacedFragment>* replaced_fragments = nullptr) {
   AntlrParser<TParser, TLexer, TCharStream> parser(sql);
   ParserRuleFragmentListener listener({ParserTypeTraits<TParser>::constant_rule_index,
                                        ParserTypeTraits<TParser>::param_placeholder_rule_index},
@@ -240,6 +259,7 @@ StatusOr<NormalizeResult> normalize_sql(std::string sql,
   result.normalized_query = sql;
   CalculateLineOffsets(sql, &state);
   state.next_placeholder = ParserTypeTraits<TParser>::FirstPlaceholder();
+  state.replaced_fragments = replaced_fragments;
 
   ConstantFragmentHandler<TParser> constant_handler(&state, &result);
   ParamFragmentHandler<TParser> param_handler(param_values, &state, &result);
@@ -266,11 +286,13 @@ StatusOr<NormalizeResult> normalize_sql(std::string sql,
   return result;
 }
 
-StatusOr<NormalizeResult> normalize_pgsql(std::string sql,
-                                          const std::vector<std::string>& param_values);
+StatusOr<NormalizeResult> normalize_pgsql(
+    std::string sql, const std::vector<std::string>& param_values,
+    std::vector<ReplacedFragment>* replaced_fragments = nullptr);
 
-StatusOr<NormalizeResult> normalize_mysql(std::string sql,
-                                          const std::vector<std::string>& param_values);
+StatusOr<NormalizeResult> normalize_mysql(
+    std::string sql, const std::vector<std::string>& param_values,
+    std::vector<ReplacedFragment>* replaced_fragments = nullptr);
 
 }  // namespace sql_parsing
 }  // namespace builtins
@@ -16,10 +16,15 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <absl/strings/str_cat.h>
 #include <gflags/gflags.h>
 
+#include <string>
+#include <vector>
+
 #include <benchmark/benchmark.h>
 #include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+#include "src/carnot/funcs/builtins/sql_parsing/normalization_cache.h"
 #include "src/common/perf/perf.h"
 
 // NOLINTNEXTLINE : runtime/references.
@@ -72,3 +77,33 @@ BENCHMARK_CAPTURE(BM_NormalizeMySQL, sock_shop,
                   "JOIN sock_tag ON sock.sock_id=sock_tag.sock_id JOIN tag ON "
                   "sock_tag.tag_id=tag.tag_id "
                   "WHERE sock.sock_id =abcde GROUP BY sock.sock_id;");
+
+// Normalizes queries that only differ in their literals, which after the first query, all come
+// from the cache.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_NormalizeCached(benchmark::State& state,
+                               px::carnot::builtins::sql_parsing::SQLDialect dialect,
+                               std::string query_prefix) {
+  px::carnot::builtins::sql_parsing::NormalizationCache cache;
+  std::vector<std::string> queries;
+  for (int i = 0; i < 1024; ++i) {
+    queries.push_back(absl::StrCat(query_prefix, i, " AND b='val", i, "'"));
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache.Normalize(dialect, queries[i++ % queries.size()], {}));
+  }
+}
+
+BENCHMARK_CAPTURE(BM_NormalizeCached, pgsql_select,
+                  px::carnot::builtins::sql_parsing::SQLDialect::kPostgres,
+                  "SELECT * FROM test WHERE a=");
+BENCHMARK_CAPTURE(BM_NormalizeCached, mysql_select,
+                  px::carnot::builtins::sql_parsing::SQLDialect::kMySQL,
+                  "SELECT * FROM test WHERE a=");
+BENCHMARK_CAPTURE(BM_NormalizeCached, mysql_sock_shop,
+                  px::carnot::builtins::sql_parsing::SQLDialect::kMySQL,
+                  "SELECT sock.sock_id AS id, sock.name, sock.description, sock.price, sock.count, "
+                  "sock.image_url_1, sock.image_url_2, GROUP_CONCAT(tag.name) AS tag_name FROM "
+                  "sock JOIN sock_tag ON sock.sock_id=sock_tag.sock_id JOIN tag ON "
+                  "sock_tag.tag_id=tag.tag_id WHERE sock.sock_id=");
@@ -0,0 +1,308 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/funcs/builtins/sql_parsing/normalization_cache.h"
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/str_cat.h>
+
+#include <utility>
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+namespace {
+
+// Literals are framed by this in shape keys. Queries that contain it don't have a shape.
+constexpr char kLiteralMarker = '\0';
+
+// Integers with more digits than this may lex differently depending on their value (e.g. MySQL
+// has distinct tokens for 32 bit, 64 bit and larger integers), so their length is part of the
+// shape.
+constexpr size_t kMaxMaskedDigits = 9;
+
+bool IsIdentifierChar(char c) { return absl::ascii_isalnum(c) || c == '_' || c == '$'; }
+
+}  // namespace
+
+QueryShape QueryShape::Of(SQLDialect dialect, std::string_view sql) {
+  // Backslashes are escapes in some strings but not others, and antlr positions are in code points
+  // rather than bytes, so queries with either are left to the parser.
+  for (char c : sql) {
+    if (c == kLiteralMarker || c == '\\' || !absl::ascii_isascii(c)) {
+      return QueryShape{};
+    }
+  }
+
+  QueryShape shape;
+  shape.key.reserve(sql.size() + 1);
+  shape.key.push_back(dialect == SQLDialect::kPostgres ? 'p' : 'm');
+
+  size_t text_start = 0;
+  auto add_literal = [&](size_t begin, size_t end) {
+    if (begin > text_start) {
+      shape.segments.push_back(Segment{text_start, begin - text_start, false});
+      shape.key.append(sql.substr(text_start, begin - text_start));
+    }
+    shape.segments.push_back(Segment{begin, end - begin, true});
+    text_start = end;
+  };
+
+  // Comments and quoted identifiers are kept as is. Treating text as a comment when the real lexer
+  // doesn't (e.g. "#" in Postgres) only makes shapes more specific.
+  size_t i = 0;
+  const size_t n = sql.size();
+  while (i < n) {
+    char c = sql[i];
+    char next = i + 1 < n ? sql[i + 1] : '\0';
+    if ((c == '-' && next == '-') || c == '#') {
+      i = sql.find('\n', i);
+      i = i == std::string_view::npos ? n : i + 1;
+    } else if (c == '/' && next == '*') {
+      // Postgres comments nest.
+      int depth = 0;
+      do {
+        if (sql.substr(i, 2) == "/*") {
+          ++depth;
+          i += 2;
+        } else if (sql.substr(i, 2) == "*/") {
+          --depth;
+          i += 2;
+        } else {
+          ++i;
+        }
+      } while (depth > 0 && i < n);
+    } else if (c == '"' || c == '`') {
+      i = sql.find(c, i + 1);
+      i = i == std::string_view::npos ? n : i + 1;
+    } else if (c == '\'') {
+      size_t end = i + 1;
+      while (end < n && (sql[end] != '\'' || (end + 1 < n && sql[end + 1] == '\''))) {
+        end += sql[end] == '\'' ? 2 : 1;
+      }
+      if (end == n) {
+        return QueryShape{};
+      }
+      // Prefixed strings, like X'..' or E'..', have restrictions on their contents.
+      bool prefixed = i > 0 && (IsIdentifierChar(sql[i - 1]) || sql[i - 1] == '&');
+      if (!prefixed) {
+        add_literal(i, end + 1);
+        shape.key.push_back(kLiteralMarker);
+        shape.key.push_back('s');
+        shape.key.push_back(kLiteralMarker);
+      }
+      i = end + 1;
+    } else if (c == '$' && !absl::ascii_isdigit(next)) {
+      // A Postgres dollar quoted string.
+      return QueryShape{};
+    } else if (IsIdentifierChar(c)) {
+      size_t end = i;
+      bool is_number = absl::ascii_isdigit(c);
+      while (end < n && (IsIdentifierChar(sql[end]) || sql[end] == '.')) {
+        is_number &= absl::ascii_isdigit(sql[end]) || sql[end] == '.';
+        ++end;
+      }
+      // Only plain decimal numbers are masked. Numbers with letters in them (e.g. 0x1F or 1e5), and
+      // identifiers, are kept as is.
+      if (is_number) {
+        add_literal(i, end);
+        shape.key.push_back(kLiteralMarker);
+        shape.key.push_back('n');
+        for (size_t j = i; j < end;) {
+          if (sql[j] == '.') {
+            shape.key.push_back('.');
+            ++j;
+            continue;
+          }
+          size_t digits_end = j;
+          while (digits_end < end && sql[digits_end] != '.') {
+            ++digits_end;
+          }
+          shape.key.push_back('#');
+          if (digits_end - j > kMaxMaskedDigits) {
+            absl::StrAppend(&shape.key, digits_end - j);
+          }
+          j = digits_end;
+        }
+        shape.key.push_back(kLiteralMarker);
+      }
+      i = end;
+    } else {
+      ++i;
+    }
+  }
+  if (text_start < n) {
+    shape.segments.push_back(Segment{text_start, n - text_start, false});
+    shape.key.append(sql.substr(text_start));
+  }
+  shape.valid = true;
+  return shape;
+}
+
+NormalizationCache* NormalizationCache::Global() {
+  static NormalizationCache* cache = new NormalizationCache();
+  return cache;
+}
+
+size_t NormalizationCache::size() const {
+  absl::MutexLock lock(&mu_);
+  return entries_.size();
+}
+
+NormalizationCache::Template NormalizationCache::MakeTemplate(
+    const QueryShape& shape, const std::string& sql,
+    const std::vector<ReplacedFragment>& fragments) {
+  Template tmpl;
+  size_t seg_idx = 0;
+  size_t prev_end = 0;
+  for (const auto& frag : fragments) {
+    if (frag.offset < prev_end || frag.offset + frag.length > sql.size()) {
+      return Template{};
+    }
+    prev_end = frag.offset + frag.length;
+    while (seg_idx < shape.segments.size() &&
+           shape.segments[seg_idx].offset + shape.segments[seg_idx].length <= frag.offset) {
+      ++seg_idx;
+    }
+    if (seg_idx == shape.segments.size()) {
+      return Template{};
+    }
+    const auto& seg = shape.segments[seg_idx];
+    if (frag.offset + frag.length > seg.offset + seg.length) {
+      // The fragment spans more than one segment.
+      return Template{};
+    }
+    if (seg.is_literal) {
+      // Literals can only be replaced as a whole, since other queries of the shape have
+      // other literals there.
+      if (frag.offset != seg.offset || frag.length != seg.length || frag.param_value_index != -1) {
+        return Template{};
+      }
+      tmpl.replacements.push_back(Template::Replacement{seg_idx, 0, std::string::npos,
+                                                        frag.placeholder, frag.param_value_index});
+    } else {
+      tmpl.replacements.push_back(Template::Replacement{seg_idx, frag.offset - seg.offset,
+                                                        frag.length, frag.placeholder,
+                                                        frag.param_value_index});
+    }
+  }
+  tmpl.cacheable = true;
+  return tmpl;
+}
+
+bool NormalizationCache::Apply(const Template& tmpl, const QueryShape& shape,
+                               const std::string& sql,
+                               const std::vector<std::string>& param_values,
+                               NormalizeResult* result) {
+  result->normalized_query.reserve(sql.size());
+  result->params.reserve(tmpl.replacements.size());
+  auto rep = tmpl.replacements.begin();
+  for (const auto& [seg_idx, seg] : Enumerate(shape.segments)) {
+    size_t pos = seg.offset;
+    const size_t seg_end = seg.offset + seg.length;
+    for (; rep != tmpl.replacements.end() && rep->segment == seg_idx; ++rep) {
+      size_t begin = seg.offset + rep->offset;
+      size_t end = rep->length == std::string::npos ? seg_end : begin + rep->length;
+      if (rep->param_value_index >= 0) {
+        if (static_cast<size_t>(rep->param_value_index) >= param_values.size()) {
+          return false;
+        }
+        result->params.push_back(param_values[rep->param_value_index]);
+      } else {
+        result->params.emplace_back(sql, begin, end - begin);
+      }
+      result->normalized_query.append(sql, pos, begin - pos);
+      result->normalized_query.append(rep->placeholder);
+      pos = end;
+    }
+    result->normalized_query.append(sql, pos, seg_end - pos);
+  }
+  return true;
+}
+
+std::shared_ptr<const NormalizationCache::Template> NormalizationCache::Find(
+    const std::string& key) {
+  absl::MutexLock lock(&mu_);
+  auto iter = index_.find(key);
+  if (iter == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, iter->second);
+  return iter->second->tmpl;
+}
+
+void NormalizationCache::Insert(std::string key, std::shared_ptr<const Template> tmpl) {
+  absl::MutexLock lock(&mu_);
+  auto iter = index_.find(key);
+  if (iter != index_.end()) {
+    // Another thread normalized the same shape in the meantime.
+    iter->second->tmpl = std::move(tmpl);
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    return;
+  }
+  entries_.push_front(Entry{std::move(key), std::move(tmpl)});
+  index_.emplace(entries_.front().key, entries_.begin());
+  while (entries_.size() > capacity_) {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+}
+
+StatusOr<NormalizeResult> NormalizationCache::Normalize(
+    SQLDialect dialect, const std::string& sql, const std::vector<std::string>& param_values) {
+  auto normalize = [&](std::vector<ReplacedFragment>* fragments) {
+    return dialect == SQLDialect::kPostgres ? normalize_pgsql(sql, param_values, fragments)
+                                            : normalize_mysql(sql, param_values, fragments);
+  };
+
+  QueryShape shape = QueryShape::Of(dialect, sql);
+  if (!shape.valid) {
+    return normalize(nullptr);
+  }
+
+  auto tmpl = Find(shape.key);
+  if (tmpl != nullptr) {
+    NormalizeResult result;
+    if (tmpl->cacheable && Apply(*tmpl, shape, sql, param_values, &result)) {
+      ++num_hits_;
+      return result;
+    }
+    return normalize(nullptr);
+  }
+
+  // Errors aren't cached, since their messages can depend on the literals.
+  std::vector<ReplacedFragment> fragments;
+  PL_ASSIGN_OR_RETURN(NormalizeResult result, normalize(&fragments));
+  auto new_tmpl = std::make_shared<Template>(MakeTemplate(shape, sql, fragments));
+  if (new_tmpl->cacheable) {
+    // Double check that the template reproduces the normalization it was made from.
+    NormalizeResult check;
+    if (!Apply(*new_tmpl, shape, sql, param_values, &check) ||
+        check.normalized_query != result.normalized_query || check.params != result.params) {
+      new_tmpl->cacheable = false;
+    }
+  }
+  Insert(std::move(shape.key), std::move(new_tmpl));
+  return result;
+}
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <absl/base/thread_annotations.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+#include "src/common/base/statusor.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+enum class SQLDialect {
+  kPostgres,
+  kMySQL,
+};
+
+/**
+ * The shape of a query is its text with the literals (numbers and strings) masked out. Queries
+ * with the same shape lex to the same tokens, up to the values of the literals, so they normalize
+ * the same way.
+ *
+ * The shape is found with a conservative lexer. Whenever it isn't sure of how the real lexer
+ * would treat some text, it keeps the text in the shape as is, or gives up on the query.
+ */
+struct QueryShape {
+  struct Segment {
+    size_t offset;
+    size_t length;
+    bool is_literal;
+  };
+
+  static QueryShape Of(SQLDialect dialect, std::string_view sql);
+
+  // False if the query uses syntax that the lexer doesn't handle, e.g. escapes in strings.
+  bool valid = false;
+  std::string key;
+  // The query, split into literals and the text between them, in order.
+  std::vector<Segment> segments;
+};
+
+/**
+ * NormalizationCache normalizes SQL queries, and remembers how each query shape normalized, so
+ * that the later queries of the same shape are normalized without being parsed. For example,
+ * "SELECT * FROM t WHERE id=1" and "SELECT * FROM t WHERE id=2" are parsed only once.
+ *
+ * The cache holds at most a fixed number of shapes, and evicts them in least recently used order.
+ * It's thread-safe, so a single cache can be shared by all the queries of an agent.
+ */
+class NormalizationCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 4096;
+
+  explicit NormalizationCache(size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+  /**
+   * The cache shared by all the queries that run on this process.
+   */
+  static NormalizationCache* Global();
+
+  /**
+   * Returns the same result as normalize_pgsql() or normalize_mysql() for the dialect.
+   */
+  StatusOr<NormalizeResult> Normalize(SQLDialect dialect, const std::string& sql,
+                                      const std::vector<std::string>& param_values);
+
+  size_t size() const ABSL_LOCKS_EXCLUDED(mu_);
+  // The number of queries that were normalized from a cached shape.
+  size_t num_hits() const { return num_hits_; }
+
+ private:
+  // How the queries of a shape normalize.
+  struct Template {
+    struct Replacement {
+      // The segment of the shape that the replaced fragment is in.
+      size_t segment;
+      // The replaced fragment, relative to the start of the segment. Replaced literals have
+      // the length of the literal in the query at hand, so their length is left as npos.
+      size_t offset;
+      size_t length;
+      std::string placeholder;
+      // As in ReplacedFragment.
+      int param_value_index;
+    };
+
+    // False if the normalization of the shape can't be expressed as a template, e.g. because
+    // a constant spans more than a literal. Those shapes are always parsed.
+    bool cacheable = false;
+    std::vector<Replacement> replacements;
+  };
+
+  struct Entry {
+    std::string key;
+    std::shared_ptr<const Template> tmpl;
+  };
+
+  static Template MakeTemplate(const QueryShape& shape, const std::string& sql,
+                               const std::vector<ReplacedFragment>& fragments);
+
+  // Fills in the result from the template. Returns false if the template doesn't apply, e.g.
+  // because a placeholder has no parameter value.
+  static bool Apply(const Template& tmpl, const QueryShape& shape, const std::string& sql,
+                    const std::vector<std::string>& param_values, NormalizeResult* result);
+
+  std::shared_ptr<const Template> Find(const std::string& key) ABSL_LOCKS_EXCLUDED(mu_);
+  void Insert(std::string key, std::shared_ptr<const Template> tmpl) ABSL_LOCKS_EXCLUDED(mu_);
+
+  const size_t capacity_;
+
+  mutable absl::Mutex mu_;
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mu_);
+  // Keys point into the entries.
+  absl::flat_hash_map<std::string_view, std::list<Entry>::iterator> index_ ABSL_GUARDED_BY(mu_);
+  std::atomic<size_t> num_hits_ = 0;
+};
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
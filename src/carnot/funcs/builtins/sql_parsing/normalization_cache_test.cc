@@ -0,0 +1,169 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/carnot/funcs/builtins/sql_parsing/normalization.h"
+#include "src/carnot/funcs/builtins/sql_parsing/normalization_cache.h"
+#include "src/common/base/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace builtins {
+namespace sql_parsing {
+
+TEST(QueryShapeTest, masks_literals) {
+  auto shape = QueryShape::Of(SQLDialect::kPostgres, "SELECT * FROM t1 WHERE a=12 AND b='x''y'");
+  ASSERT_TRUE(shape.valid);
+  EXPECT_EQ(shape.key,
+            QueryShape::Of(SQLDialect::kPostgres, "SELECT * FROM t1 WHERE a=3 AND b=''").key);
+  ASSERT_EQ(4, shape.segments.size());
+  EXPECT_TRUE(shape.segments[1].is_literal);
+  EXPECT_EQ(25, shape.segments[1].offset);
+  EXPECT_EQ(2, shape.segments[1].length);
+  EXPECT_TRUE(shape.segments[3].is_literal);
+  EXPECT_EQ(6, shape.segments[3].length);
+
+  // The dialect is part of the shape.
+  EXPECT_NE(shape.key,
+            QueryShape::Of(SQLDialect::kMySQL, "SELECT * FROM t1 WHERE a=12 AND b='x''y'").key);
+  // So are the lengths of long integers, and numbers that aren't plain decimals.
+  EXPECT_NE(QueryShape::Of(SQLDialect::kMySQL, "SELECT 1234567890").key,
+            QueryShape::Of(SQLDialect::kMySQL, "SELECT 12345678901").key);
+  EXPECT_EQ(QueryShape::Of(SQLDialect::kMySQL, "SELECT 1.5").key,
+            QueryShape::Of(SQLDialect::kMySQL, "SELECT 22.75").key);
+  EXPECT_NE(QueryShape::Of(SQLDialect::kMySQL, "SELECT 0x1F").key,
+            QueryShape::Of(SQLDialect::kMySQL, "SELECT 0x2A").key);
+  EXPECT_NE(QueryShape::Of(SQLDialect::kPostgres, "SELECT E'a'").key,
+            QueryShape::Of(SQLDialect::kPostgres, "SELECT E'b'").key);
+}
+
+TEST(QueryShapeTest, keeps_comments_and_identifiers) {
+  EXPECT_NE(QueryShape::Of(SQLDialect::kPostgres, "SELECT 1 -- it's 1\n").key,
+            QueryShape::Of(SQLDialect::kPostgres, "SELECT 1 -- it's 2\n").key);
+  EXPECT_NE(QueryShape::Of(SQLDialect::kPostgres, "SELECT 1 /* /* 'a' */ 'b' */").key,
+            QueryShape::Of(SQLDialect::kPostgres, "SELECT 1 /* /* 'a' */ 'c' */").key);
+  EXPECT_NE(QueryShape::Of(SQLDialect::kPostgres, R"(SELECT "col1" FROM t)").key,
+            QueryShape::Of(SQLDialect::kPostgres, R"(SELECT "col2" FROM t)").key);
+  EXPECT_NE(QueryShape::Of(SQLDialect::kPostgres, "SELECT * FROM t1").key,
+            QueryShape::Of(SQLDialect::kPostgres, "SELECT * FROM t2").key);
+  EXPECT_NE(QueryShape::Of(SQLDialect::kPostgres, "SELECT $1").key,
+            QueryShape::Of(SQLDialect::kPostgres, "SELECT $2").key);
+}
+
+TEST(QueryShapeTest, invalid) {
+  EXPECT_FALSE(QueryShape::Of(SQLDialect::kMySQL, R"(SELECT 'a\'b')").valid);
+  EXPECT_FALSE(QueryShape::Of(SQLDialect::kPostgres, "SELECT $$a$$").valid);
+  EXPECT_FALSE(QueryShape::Of(SQLDialect::kPostgres, "SELECT 'unterminated").valid);
+  EXPECT_FALSE(QueryShape::Of(SQLDialect::kPostgres, "SELECT 'caf\xc3\xa9'").valid);
+  EXPECT_TRUE(QueryShape::Of(SQLDialect::kPostgres, "").valid);
+}
+
+struct CacheTestCase {
+  SQLDialect dialect;
+  std::vector<std::string> queries;
+  std::vector<std::string> param_values;
+};
+
+class NormalizationCacheTest : public testing::TestWithParam<CacheTestCase> {};
+
+// Every query of a test case has the same shape, so all but the first are normalized from the
+// cache, and must normalize the same as without it.
+TEST_P(NormalizationCacheTest, same_as_uncached) {
+  auto test_case = GetParam();
+  NormalizationCache cache;
+  for (const auto& query : test_case.queries) {
+    auto expected = test_case.dialect == SQLDialect::kPostgres
+                        ? normalize_pgsql(query, test_case.param_values)
+                        : normalize_mysql(query, test_case.param_values);
+    ASSERT_OK(expected);
+    ASSERT_OK_AND_ASSIGN(auto result,
+                         cache.Normalize(test_case.dialect, query, test_case.param_values));
+    EXPECT_EQ(expected.ValueOrDie().normalized_query, result.normalized_query) << query;
+    EXPECT_EQ(expected.ValueOrDie().params, result.params) << query;
+  }
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(test_case.queries.size() - 1, cache.num_hits());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    NormalizationCacheVariants, NormalizationCacheTest,
+    testing::Values(
+        CacheTestCase{SQLDialect::kPostgres,
+                      {"SELECT * FROM test WHERE prop=1234 AND prop2='abcd'",
+                       "SELECT * FROM test WHERE prop=5 AND prop2=''",
+                       "SELECT * FROM test WHERE prop=99999 AND prop2='it''s'"},
+                      {}},
+        CacheTestCase{SQLDialect::kPostgres,
+                      {"SELECT * FROM test WHERE prop=$1 AND prop2='abcd' LIMIT 10",
+                       "SELECT * FROM test WHERE prop=$1 AND prop2='efgh' LIMIT 20"},
+                      {"'1234'"}},
+        CacheTestCase{SQLDialect::kPostgres,
+                      {"CREATE TABLE test (name varchar(20), address text)",
+                       "CREATE TABLE test (name varchar(40), address text)"},
+                      {}},
+        CacheTestCase{SQLDialect::kPostgres,
+                      {"INSERT INTO test (a, b, c, d) VALUES (1, 'abcd', 1.23, true)",
+                       "INSERT INTO test (a, b, c, d) VALUES (2, 'efg', 10.5, true)"},
+                      {}},
+        CacheTestCase{SQLDialect::kMySQL,
+                      {"SELECT * FROM test WHERE property=1234 AND property2='abcd'",
+                       "SELECT * FROM test WHERE property=1 AND property2='a'"},
+                      {}},
+        CacheTestCase{SQLDialect::kMySQL,
+                      {"SELECT * FROM test WHERE a=? AND b=?\nAND c=5",
+                       "SELECT * FROM test WHERE a=? AND b=?\nAND c=12"},
+                      {"1", "'x'"}},
+        CacheTestCase{SQLDialect::kMySQL,
+                      {"UPDATE test SET age=10 where name='abcd'",
+                       "UPDATE test SET age=11 where name='efgh'"},
+                      {}}));
+
+TEST(NormalizationCacheTest, errors_not_cached) {
+  NormalizationCache cache;
+  EXPECT_NOT_OK(cache.Normalize(SQLDialect::kPostgres, "SELECT * FROM WHERE a=1", {}));
+  EXPECT_EQ(0, cache.size());
+
+  // The query needs a parameter value, which only the first call has.
+  ASSERT_OK(cache.Normalize(SQLDialect::kPostgres, "SELECT * FROM t WHERE a=$1", {"1"}));
+  EXPECT_NOT_OK(cache.Normalize(SQLDialect::kPostgres, "SELECT * FROM t WHERE a=$1", {}));
+  EXPECT_EQ(0, cache.num_hits());
+}
+
+TEST(NormalizationCacheTest, evicts_least_recently_used) {
+  NormalizationCache cache(2);
+  ASSERT_OK(cache.Normalize(SQLDialect::kMySQL, "SELECT a FROM t WHERE b=1", {}));
+  ASSERT_OK(cache.Normalize(SQLDialect::kMySQL, "SELECT b FROM t WHERE b=1", {}));
+  ASSERT_OK(cache.Normalize(SQLDialect::kMySQL, "SELECT a FROM t WHERE b=2", {}));
+  EXPECT_EQ(1, cache.num_hits());
+  ASSERT_OK(cache.Normalize(SQLDialect::kMySQL, "SELECT c FROM t WHERE b=1", {}));
+  EXPECT_EQ(2, cache.size());
+
+  // "SELECT b" was the least recently used, so it's gone.
+  ASSERT_OK(cache.Normalize(SQLDialect::kMySQL, "SELECT a FROM t WHERE b=3", {}));
+  EXPECT_EQ(2, cache.num_hits());
+  ASSERT_OK(cache.Normalize(SQLDialect::kMySQL, "SELECT b FROM t WHERE b=3", {}));
+  EXPECT_EQ(2, cache.num_hits());
+}
+
+}  // namespace sql_parsing
+}  // namespace builtins
+}  // namespace carnot
+}  // namespace px
@@ -20,6 +20,7 @@
 
 #include <sys/sysinfo.h>
 
+#include <absl/container/flat_hash_map.h>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
@@ -62,6 +63,33 @@ inline const px::md::AgentMetadataState* GetMetadataState(px::carnot::udf::Funct
   return md;
 }
 
+/**
+ * A base for the UDFs that look up the metadata of a UPID. Scripts call them over many rows of few
+ * distinct processes, so their batches look up each distinct UPID once, and copy the result to
+ * the other rows of the UPID. Rows of the same process also tend to be next to each other, which
+ * is checked before the hash map.
+ */
+template <typename TUDF>
+class UPIDMetadataUDF : public ScalarUDF {
+ public:
+  Status ExecBatch(FunctionContext* ctx, size_t count, const UInt128Value* upids,
+                   StringValue* out) {
+    auto* udf = static_cast<TUDF*>(this);
+    absl::flat_hash_map<absl::uint128, size_t> first_rows;
+    for (size_t i = 0; i < count; ++i) {
+      if (i > 0 && upids[i] == upids[i - 1]) {
+        out[i] = out[i - 1];
+        continue;
+      }
+      auto [it, inserted] = first_rows.try_emplace(upids[i].val, i);
+      out[i] = inserted ? udf->Exec(ctx, upids[i]) : out[it->second];
+    }
+    return Status::OK();
+  }
+
+  static constexpr bool ExecBatchOnArrow() { return true; }
+};
+
 class ASIDUDF : public ScalarUDF {
  public:
   Int64Value Exec(FunctionContext* ctx) {
@@ -211,7 +239,7 @@ class PodNameToNamespaceUDF : public ScalarUDF {
   }
 };
 
-class UPIDToContainerIDUDF : public ScalarUDF {
+class UPIDToContainerIDUDF : public UPIDMetadataUDF<UPIDToContainerIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -252,7 +280,7 @@ inline const md::ContainerInfo* UPIDToContainer(const px::md::AgentMetadataState
   return md->k8s_metadata_state().ContainerInfoByID(pid->cid());
 }
 
-class UPIDToContainerNameUDF : public ScalarUDF {
+class UPIDToContainerNameUDF : public UPIDMetadataUDF<UPIDToContainerNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -317,7 +345,7 @@ inline types::StringValue StringifyVector(const std::vector<std::string>& vec) {
   return "";
 }
 
-class UPIDToNamespaceUDF : public ScalarUDF {
+class UPIDToNamespaceUDF : public UPIDMetadataUDF<UPIDToNamespaceUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -349,7 +377,7 @@ class UPIDToNamespaceUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class UPIDToPodIDUDF : public ScalarUDF {
+class UPIDToPodIDUDF : public UPIDMetadataUDF<UPIDToPodIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -376,7 +404,7 @@ class UPIDToPodIDUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class UPIDToPodNameUDF : public ScalarUDF {
+class UPIDToPodNameUDF : public UPIDMetadataUDF<UPIDToPodNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -535,7 +563,7 @@ class ServiceNameToNamespaceUDF : public ScalarUDF {
 /**
  * @brief Returns the service ids for services that are currently running.
  */
-class UPIDToServiceIDUDF : public ScalarUDF {
+class UPIDToServiceIDUDF : public UPIDMetadataUDF<UPIDToServiceIDUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -577,7 +605,7 @@ class UPIDToServiceIDUDF : public ScalarUDF {
 /**
  * @brief Returns the service names for services that are currently running.
  */
-class UPIDToServiceNameUDF : public ScalarUDF {
+class UPIDToServiceNameUDF : public UPIDMetadataUDF<UPIDToServiceNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -623,7 +651,7 @@ class UPIDToServiceNameUDF : public ScalarUDF {
 /**
  * @brief Returns the node name for the pod associated with the input upid.
  */
-class UPIDToNodeNameUDF : public ScalarUDF {
+class UPIDToNodeNameUDF : public UPIDMetadataUDF<UPIDToNodeNameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -655,7 +683,7 @@ class UPIDToNodeNameUDF : public ScalarUDF {
 /**
  * @brief Returns the hostname for the pod associated with the input upid.
  */
-class UPIDToHostnameUDF : public ScalarUDF {
+class UPIDToHostnameUDF : public UPIDMetadataUDF<UPIDToHostnameUDF> {
  public:
   StringValue Exec(FunctionContext* ctx, UInt128Value upid_value) {
     auto md = GetMetadataState(ctx);
@@ -873,7 +901,7 @@ class PodNameToServiceIDUDF : public ScalarUDF {
   }
 };
 
-class UPIDToStringUDF : public ScalarUDF {
+class UPIDToStringUDF : public UPIDMetadataUDF<UPIDToStringUDF> {
  public:
   StringValue Exec(FunctionContext*, UInt128Value upid_value) {
     auto upid_uint128 = absl::MakeUint128(upid_value.High64(), upid_value.Low64());
@@ -1315,7 +1343,7 @@ class ContainerIDToContainerStatusUDF : public ScalarUDF {
   }
 };
 
-class UPIDToPodStatusUDF : public ScalarUDF {
+class UPIDToPodStatusUDF : public UPIDMetadataUDF<UPIDToPodStatusUDF> {
  public:
   /**
    * @brief Gets the Pod status for a passed in UPID.
@@ -1354,7 +1382,7 @@ class UPIDToPodStatusUDF : public ScalarUDF {
   static udfspb::UDFSourceExecutor Executor() { return udfspb::UDFSourceExecutor::UDF_PEM; }
 };
 
-class UPIDToCmdLineUDF : public ScalarUDF {
+class UPIDToCmdLineUDF : public UPIDMetadataUDF<UPIDToCmdLineUDF> {
  public:
   /**
    * @brief Gets the cmdline for the upid.
@@ -1395,7 +1423,7 @@ inline std::string PodInfoToPodQoS(const px::md::PodInfo* pod_info) {
   return std::string(magic_enum::enum_name(pod_info->qos_class()));
 }
 
-class UPIDToPodQoSUDF : public ScalarUDF {
+class UPIDToPodQoSUDF : public UPIDMetadataUDF<UPIDToPodQoSUDF> {
  public:
   /**
    * @brief Gets the qos for the upid's pod.
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/funcs/net/dns.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include <cstring>
+#include <utility>
+
+DEFINE_int32(carnot_dns_cache_ttl_s, 300, "The number of seconds a resolved hostname is cached.");
+DEFINE_int32(carnot_dns_cache_negative_ttl_s, 30,
+             "The number of seconds an address that could not be resolved is cached.");
+DEFINE_int32(carnot_dns_cache_max_entries, 4096, "The number of addresses in the DNS cache.");
+DEFINE_int32(carnot_dns_cache_num_workers, 4, "The number of threads that resolve addresses.");
+DEFINE_int32(carnot_dns_cache_max_pending, 1024,
+             "The number of addresses that can wait to be resolved.");
+DEFINE_bool(carnot_nslookup_async, false,
+            "Whether nslookup returns the address itself when its hostname isn't cached, and "
+            "resolves it in the background, rather than waiting for the lookup.");
+
+namespace px {
+namespace carnot {
+namespace funcs {
+namespace net {
+namespace internal {
+
+DNSResult DNSLookup(const std::string& addr) {
+  struct sockaddr_in sa;
+
+  char node[kMaxHostnameSize];
+
+  memset(&sa, 0, sizeof sa);
+  sa.sin_family = AF_INET;
+
+  inet_pton(AF_INET, addr.c_str(), &sa.sin_addr);
+
+  int res =
+      getnameinfo((struct sockaddr*)&sa, sizeof(sa), node, sizeof(node), NULL, 0, NI_NAMEREQD);
+
+  if (res) {
+    if (res != EAI_NONAME) {
+      VLOG(1) << absl::Substitute("Failed to resolve $0: $1", addr, gai_strerror(res));
+    }
+    return {false, addr};
+  }
+  return {true, node};
+}
+
+DNSCache& DNSCache::GetInstance() {
+  // Never destroyed, so that the workers don't race with static destruction.
+  static DNSCache* cache = new DNSCache(
+      {std::chrono::seconds(FLAGS_carnot_dns_cache_ttl_s),
+       std::chrono::seconds(FLAGS_carnot_dns_cache_negative_ttl_s),
+       static_cast<size_t>(FLAGS_carnot_dns_cache_max_entries),
+       FLAGS_carnot_dns_cache_num_workers,
+       static_cast<size_t>(FLAGS_carnot_dns_cache_max_pending)},
+      DNSLookup);
+  return *cache;
+}
+
+DNSCache::DNSCache(Options opts, ResolveFn resolve, ClockFn now)
+    : opts_(std::move(opts)), resolve_(std::move(resolve)), now_(std::move(now)) {}
+
+DNSCache::~DNSCache() {
+  std::vector<std::thread> workers;
+  {
+    absl::MutexLock lock(&mu_);
+    stopped_ = true;
+    workers.swap(workers_);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+std::string DNSCache::Lookup(const std::string& addr) {
+  absl::MutexLock lock(&mu_);
+  Entry* entry = &*GetEntry(addr);
+  if (IsFresh(*entry)) {
+    return Hit(*entry);
+  }
+  ++stats_.misses;
+  if (!entry->pending && !Enqueue(entry)) {
+    // All the workers are backed up, resolve it on this thread.
+    entry->pending = true;
+    mu_.Unlock();
+    DNSResult result = resolve_(addr);
+    mu_.Lock();
+    SetResult(entry, std::move(result));
+  }
+  // Entries with waiters can't be evicted, so the entry outlives the wait.
+  ++entry->waiters;
+  mu_.Await(absl::Condition(+[](Entry* entry) { return !entry->pending; }, entry));
+  --entry->waiters;
+  return Hostname(*entry);
+}
+
+std::string DNSCache::LookupAsync(const std::string& addr) {
+  absl::MutexLock lock(&mu_);
+  Entry* entry = &*GetEntry(addr);
+  if (IsFresh(*entry)) {
+    return Hit(*entry);
+  }
+  if (!entry->pending) {
+    Enqueue(entry);
+  }
+  if (entry->has_result) {
+    // Serve the expired name while it's refreshed.
+    return Hit(*entry);
+  }
+  ++stats_.async_misses;
+  return addr;
+}
+
+DNSCacheStats DNSCache::Stats() const {
+  absl::MutexLock lock(&mu_);
+  DNSCacheStats stats = stats_;
+  stats.size = entries_.size();
+  return stats;
+}
+
+DNSCache::EntryList::iterator DNSCache::GetEntry(const std::string& addr) {
+  auto idx = index_.find(addr);
+  if (idx != index_.end()) {
+    entries_.splice(entries_.begin(), entries_, idx->second);
+    return idx->second;
+  }
+  entries_.emplace_front(addr);
+  index_.emplace(entries_.front().addr, entries_.begin());
+  EvictIfFull();
+  return entries_.begin();
+}
+
+bool DNSCache::IsFresh(const Entry& entry) const {
+  return entry.has_result && now_() < entry.expiry;
+}
+
+std::string DNSCache::Hit(const Entry& entry) {
+  if (entry.result.found) {
+    ++stats_.hits;
+  } else {
+    ++stats_.negative_hits;
+  }
+  return Hostname(entry);
+}
+
+bool DNSCache::Enqueue(Entry* entry) {
+  if (opts_.num_workers <= 0 || queue_.size() >= opts_.max_pending) {
+    return false;
+  }
+  entry->pending = true;
+  queue_.push_back(entry);
+  if (static_cast<int>(queue_.size()) > idle_workers_ &&
+      static_cast<int>(workers_.size()) < opts_.num_workers) {
+    workers_.emplace_back(&DNSCache::WorkerLoop, this);
+  }
+  return true;
+}
+
+void DNSCache::SetResult(Entry* entry, DNSResult result) {
+  entry->expiry = now_() + (result.found ? opts_.ttl : opts_.negative_ttl);
+  entry->result = std::move(result);
+  entry->has_result = true;
+  entry->pending = false;
+}
+
+void DNSCache::EvictIfFull() {
+  // Evict the least recently used entries that nobody is waiting on. The front entry is the one
+  // that is being looked up.
+  auto it = entries_.end();
+  while (entries_.size() > opts_.max_entries && it != entries_.begin()) {
+    --it;
+    if (it->pending || it->waiters > 0 || it == entries_.begin()) {
+      continue;
+    }
+    index_.erase(it->addr);
+    it = entries_.erase(it);
+    ++stats_.evictions;
+  }
+}
+
+void DNSCache::WorkerLoop() {
+  absl::MutexLock lock(&mu_);
+  auto has_work = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return stopped_ || !queue_.empty();
+  };
+  while (true) {
+    ++idle_workers_;
+    mu_.Await(absl::Condition(&has_work));
+    --idle_workers_;
+    if (stopped_) {
+      return;
+    }
+    Entry* entry = queue_.front();
+    queue_.pop_front();
+    std::string addr = entry->addr;
+    mu_.Unlock();
+    DNSResult result = resolve_(addr);
+    mu_.Lock();
+    SetResult(entry, std::move(result));
+  }
+}
+
+}  // namespace internal
+}  // namespace net
+}  // namespace funcs
+}  // namespace carnot
+}  // namespace px
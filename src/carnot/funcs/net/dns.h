@@ -18,10 +18,26 @@
 
 #pragma once
 
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <list>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
-#define TBB_PREVIEW_CONCURRENT_LRU_CACHE 1
-#include "tbb/concurrent_lru_cache.h"
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_int32(carnot_dns_cache_ttl_s);
+DECLARE_int32(carnot_dns_cache_negative_ttl_s);
+DECLARE_int32(carnot_dns_cache_max_entries);
+DECLARE_int32(carnot_dns_cache_num_workers);
+DECLARE_int32(carnot_dns_cache_max_pending);
+DECLARE_bool(carnot_nslookup_async);
 
 namespace px {
 namespace carnot {
@@ -30,41 +46,111 @@ namespace net {
 namespace internal {
 
 constexpr size_t kMaxHostnameSize = 512;
-constexpr size_t kLRUCacheSize = 1024;
-
-inline std::string DNSLookup(const std::string& addr) {
-  struct sockaddr_in sa;
-
-  char node[kMaxHostnameSize];
 
-  memset(&sa, 0, sizeof sa);
-  sa.sin_family = AF_INET;
-
-  inet_pton(AF_INET, addr.c_str(), &sa.sin_addr);
-
-  int res =
-      getnameinfo((struct sockaddr*)&sa, sizeof(sa), node, sizeof(node), NULL, 0, NI_NAMEREQD);
+struct DNSResult {
+  // Whether the address has a name. If not, the address itself is returned as the hostname.
+  bool found = false;
+  std::string hostname;
+};
 
-  if (res) {
-    return res == EAI_NONAME ? addr : gai_strerror(res);
-  }
-  return node;
-}
+// Performs a blocking reverse DNS lookup of an IPv4 address.
+DNSResult DNSLookup(const std::string& addr);
+
+struct DNSCacheStats {
+  int64_t size = 0;
+  int64_t hits = 0;
+  int64_t negative_hits = 0;
+  int64_t misses = 0;
+  // Lookups that returned the address because its name was not resolved yet.
+  int64_t async_misses = 0;
+  int64_t evictions = 0;
+};
 
+/**
+ * DNSCache is an agent-wide cache of reverse DNS lookups.
+ *
+ * Names are resolved by a small pool of worker threads, so that at most one lookup per address
+ * is in flight no matter how many queries ask for it. Names expire after a TTL, and addresses
+ * without a name are cached too, with a shorter TTL.
+ */
 class DNSCache {
  public:
-  static DNSCache& GetInstance() {
-    static DNSCache cache;
-    return cache;
-  }
-
-  std::string Lookup(std::string addr) { return cache_[addr].value(); }
+  using ResolveFn = std::function<DNSResult(const std::string&)>;
+  using Clock = std::chrono::steady_clock;
+  using ClockFn = std::function<Clock::time_point()>;
+
+  struct Options {
+    std::chrono::seconds ttl{300};
+    std::chrono::seconds negative_ttl{30};
+    size_t max_entries = 4096;
+    int num_workers = 4;
+    // The number of addresses that can wait for a worker. Beyond that, async lookups give up and
+    // blocking lookups resolve the address themselves.
+    size_t max_pending = 1024;
+  };
+
+  /**
+   * @return the cache shared by all queries of this agent, configured by the dns_cache flags.
+   */
+  static DNSCache& GetInstance();
+
+  DNSCache(Options opts, ResolveFn resolve, ClockFn now = Clock::now);
+  ~DNSCache();
+
+  /**
+   * Returns the hostname of addr, waiting for it to be resolved if it isn't cached.
+   */
+  std::string Lookup(const std::string& addr);
+
+  /**
+   * Returns the hostname of addr if it's cached. Otherwise queues it to be resolved and returns
+   * addr right away. An expired name is returned while it's being refreshed.
+   */
+  std::string LookupAsync(const std::string& addr);
+
+  DNSCacheStats Stats() const;
 
  private:
-  DNSCache()
-      : cache_([](std::string addr) -> std::string { return DNSLookup(addr); }, kLRUCacheSize) {}
-
-  tbb::concurrent_lru_cache<std::string, std::string> cache_;
+  struct Entry {
+    explicit Entry(std::string addr) : addr(std::move(addr)) {}
+    std::string addr;
+    DNSResult result;
+    bool has_result = false;
+    // Whether the address is queued or being resolved. Pending entries, and entries that
+    // lookups are waiting on, are never evicted.
+    bool pending = false;
+    int waiters = 0;
+    Clock::time_point expiry;
+  };
+  using EntryList = std::list<Entry>;
+
+  // Returns the entry of addr, creating it if needed, and marks it most recently used.
+  EntryList::iterator GetEntry(const std::string& addr) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  bool IsFresh(const Entry& entry) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Counts a cache hit on the entry and returns its hostname.
+  std::string Hit(const Entry& entry) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  static std::string Hostname(const Entry& entry) {
+    return entry.result.found ? entry.result.hostname : entry.addr;
+  }
+  // Queues the entry to be resolved. Returns false if the queue is full.
+  bool Enqueue(Entry* entry) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void SetResult(Entry* entry, DNSResult result) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void EvictIfFull() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void WorkerLoop();
+
+  const Options opts_;
+  const ResolveFn resolve_;
+  const ClockFn now_;
+
+  mutable absl::Mutex mu_;
+  // Most recently used first. The map keys point into the entries.
+  EntryList entries_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string_view, EntryList::iterator> index_ ABSL_GUARDED_BY(mu_);
+  std::deque<Entry*> queue_ ABSL_GUARDED_BY(mu_);
+  std::vector<std::thread> workers_ ABSL_GUARDED_BY(mu_);
+  int idle_workers_ ABSL_GUARDED_BY(mu_) = 0;
+  bool stopped_ ABSL_GUARDED_BY(mu_) = false;
+  DNSCacheStats stats_ ABSL_GUARDED_BY(mu_);
 };
 
 }  // namespace internal
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <absl/synchronization/notification.h>
+
+#include "src/carnot/funcs/net/dns.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace funcs {
+namespace net {
+namespace internal {
+
+class DNSCacheTest : public ::testing::Test {
+ protected:
+  DNSCache::Options opts() {
+    DNSCache::Options opts;
+    opts.ttl = std::chrono::seconds(10);
+    opts.negative_ttl = std::chrono::seconds(1);
+    opts.max_entries = 2;
+    opts.num_workers = 2;
+    return opts;
+  }
+
+  DNSResult Resolve(const std::string& addr) {
+    ++num_resolves_;
+    if (block_) {
+      unblock_.WaitForNotification();
+    }
+    if (addr == "10.0.0.1") {
+      return {true, "host-1"};
+    }
+    if (addr == "10.0.0.2") {
+      return {true, "host-2"};
+    }
+    return {false, addr};
+  }
+
+  std::unique_ptr<DNSCache> MakeCache(DNSCache::Options opts) {
+    return std::make_unique<DNSCache>(
+        opts, [this](const std::string& addr) { return Resolve(addr); },
+        [this]() { return DNSCache::Clock::time_point(std::chrono::seconds(now_s_.load())); });
+  }
+
+  std::atomic<int> num_resolves_ = 0;
+  std::atomic<int64_t> now_s_ = 0;
+  bool block_ = false;
+  absl::Notification unblock_;
+};
+
+TEST_F(DNSCacheTest, lookup_caches_names) {
+  auto cache = MakeCache(opts());
+  EXPECT_EQ("host-1", cache->Lookup("10.0.0.1"));
+  EXPECT_EQ("host-1", cache->Lookup("10.0.0.1"));
+  EXPECT_EQ(1, num_resolves_);
+
+  // Addresses without a name are cached too.
+  EXPECT_EQ("10.0.0.9", cache->Lookup("10.0.0.9"));
+  EXPECT_EQ("10.0.0.9", cache->Lookup("10.0.0.9"));
+  EXPECT_EQ(2, num_resolves_);
+
+  DNSCacheStats stats = cache->Stats();
+  EXPECT_EQ(2, stats.size);
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.negative_hits);
+  EXPECT_EQ(2, stats.misses);
+}
+
+TEST_F(DNSCacheTest, names_expire) {
+  auto cache = MakeCache(opts());
+  EXPECT_EQ("host-1", cache->Lookup("10.0.0.1"));
+  EXPECT_EQ("10.0.0.9", cache->Lookup("10.0.0.9"));
+  EXPECT_EQ(2, num_resolves_);
+
+  // Only the negative entry expired.
+  now_s_ = 5;
+  cache->Lookup("10.0.0.1");
+  cache->Lookup("10.0.0.9");
+  EXPECT_EQ(3, num_resolves_);
+
+  now_s_ = 20;
+  cache->Lookup("10.0.0.1");
+  EXPECT_EQ(4, num_resolves_);
+}
+
+TEST_F(DNSCacheTest, evicts_least_recently_used) {
+  auto cache = MakeCache(opts());
+  cache->Lookup("10.0.0.1");
+  cache->Lookup("10.0.0.2");
+  cache->Lookup("10.0.0.1");
+  cache->Lookup("10.0.0.3");
+  EXPECT_EQ(3, num_resolves_);
+  EXPECT_EQ(2, cache->Stats().size);
+  EXPECT_EQ(1, cache->Stats().evictions);
+
+  cache->Lookup("10.0.0.1");
+  EXPECT_EQ(3, num_resolves_);
+  cache->Lookup("10.0.0.2");
+  EXPECT_EQ(4, num_resolves_);
+}
+
+TEST_F(DNSCacheTest, async_lookup_returns_addr_until_resolved) {
+  block_ = true;
+  auto cache = MakeCache(opts());
+  EXPECT_EQ("10.0.0.1", cache->LookupAsync("10.0.0.1"));
+  EXPECT_EQ("10.0.0.1", cache->LookupAsync("10.0.0.1"));
+  EXPECT_EQ(2, cache->Stats().async_misses);
+
+  unblock_.Notify();
+  EXPECT_EQ("host-1", cache->Lookup("10.0.0.1"));
+  EXPECT_EQ("host-1", cache->LookupAsync("10.0.0.1"));
+  EXPECT_EQ(1, num_resolves_);
+
+  // Expired names are returned while they are refreshed.
+  now_s_ = 20;
+  EXPECT_EQ("host-1", cache->LookupAsync("10.0.0.1"));
+}
+
+TEST_F(DNSCacheTest, concurrent_lookups_resolve_once) {
+  block_ = true;
+  auto cache = MakeCache(opts());
+  std::vector<std::thread> threads;
+  std::vector<std::string> hostnames(8);
+  for (size_t i = 0; i < hostnames.size(); ++i) {
+    threads.emplace_back([&, i]() { hostnames[i] = cache->Lookup("10.0.0.1"); });
+  }
+  unblock_.Notify();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, num_resolves_);
+  for (const auto& hostname : hostnames) {
+    EXPECT_EQ("host-1", hostname);
+  }
+}
+
+TEST_F(DNSCacheTest, resolves_inline_without_workers) {
+  DNSCache::Options no_workers = opts();
+  no_workers.num_workers = 0;
+  auto cache = MakeCache(no_workers);
+  EXPECT_EQ("host-2", cache->Lookup("10.0.0.2"));
+  EXPECT_EQ("10.0.0.1", cache->LookupAsync("10.0.0.1"));
+  EXPECT_EQ(1, num_resolves_);
+}
+
+}  // namespace internal
+}  // namespace net
+}  // namespace funcs
+}  // namespace carnot
+}  // namespace px
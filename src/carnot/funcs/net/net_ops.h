@@ -42,11 +42,15 @@ using ScalarUDF = px::carnot::udf::ScalarUDF;
 
 class NSLookupUDF : public ScalarUDF {
  public:
-  StringValue Exec(FunctionContext*, StringValue addr) { return cache_.Lookup(addr); }
+  StringValue Exec(FunctionContext*, StringValue addr) {
+    return FLAGS_carnot_nslookup_async ? cache_.LookupAsync(addr) : cache_.Lookup(addr);
+  }
 
   static udf::ScalarUDFDocBuilder Doc() {
     return udf::ScalarUDFDocBuilder("Perform a DNS lookup for the value (experimental).")
-        .Details("Experimental UDF to perform a DNS lookup for a given value.")
+        .Details(
+            "Experimental UDF to perform a DNS lookup for a given value. Hostnames are cached by "
+            "the agent. If the address has no hostname, the address itself is returned.")
         .Arg("addr", "An IP address")
         .Example("df.hostname = px.nslookup(df.ip_addr)")
         .Returns("The hostname.");
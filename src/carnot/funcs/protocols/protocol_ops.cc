@@ -18,17 +18,31 @@
 
 #include "src/carnot/funcs/protocols/protocol_ops.h"
 
+#include <absl/strings/escaping.h>
+#include <absl/strings/match.h>
+
 #include "src/carnot/funcs/protocols/http.h"
 #include "src/carnot/funcs/protocols/kafka.h"
 #include "src/carnot/funcs/protocols/mysql.h"
 #include "src/carnot/udf/registry.h"
 #include "src/common/base/base.h"
+#include "src/common/grpcutils/message_text.h"
 
 namespace px {
 namespace carnot {
 namespace funcs {
 namespace protocols {
 
+namespace {
+
+// Stirling appends this to the bodies that it truncated.
+constexpr std::string_view kTruncatedMsg = "... [TRUNCATED]";
+
+// Matches the truncation of string fields when Stirling parses the bodies itself.
+constexpr int kMaxPBStringLen = 64;
+
+}  // namespace
+
 void RegisterProtocolOpsOrDie(px::carnot::udf::Registry* registry) {
   CHECK(registry != nullptr);
   /*****************************************
@@ -37,6 +51,7 @@ void RegisterProtocolOpsOrDie(px::carnot::udf::Registry* registry) {
   registry->RegisterOrDie<HTTPRespMessageUDF>("http_resp_message");
   registry->RegisterOrDie<KafkaAPIKeyNameUDF>("kafka_api_key_name");
   registry->RegisterOrDie<MySQLCommandNameUDF>("mysql_command_name");
+  registry->RegisterOrDie<GRPCBodyToTextUDF>("grpc_body_to_text");
 }
 
 types::StringValue HTTPRespMessageUDF::Exec(FunctionContext*, Int64Value resp_code) {
@@ -51,6 +66,27 @@ types::StringValue MySQLCommandNameUDF::Exec(FunctionContext*, Int64Value api_ke
   return mysql::CommandName(api_key.val);
 }
 
+types::StringValue GRPCBodyToTextUDF::Exec(FunctionContext*, StringValue body) {
+  std::string_view encoded = body;
+  const bool truncated = absl::EndsWith(encoded, kTruncatedMsg);
+  if (truncated) {
+    encoded.remove_suffix(kTruncatedMsg.size());
+    // The body may have been cut in the middle of a base64 quantum.
+    encoded.remove_suffix(encoded.size() % 4);
+  }
+
+  std::string wire;
+  if (encoded.empty() || !absl::Base64Unescape(encoded, &wire)) {
+    return body;
+  }
+
+  std::string text = ::px::grpc::GRPCBodyToText(wire, /*prototype*/ nullptr, kMaxPBStringLen);
+  if (truncated) {
+    text.append(kTruncatedMsg);
+  }
+  return text;
+}
+
 }  // namespace protocols
 }  // namespace funcs
 }  // namespace carnot
@@ -65,6 +65,23 @@ class MySQLCommandNameUDF : public px::carnot::udf::ScalarUDF {
   }
 };
 
+class GRPCBodyToTextUDF : public px::carnot::udf::ScalarUDF {
+ public:
+  StringValue Exec(FunctionContext*, StringValue body);
+
+  static udf::ScalarUDFDocBuilder Doc() {
+    return udf::ScalarUDFDocBuilder("Convert a raw gRPC message body to text format protobuf.")
+        .Details(
+            "UDF to parse the base64-encoded gRPC message bodies that Stirling records when "
+            "--stirling_http2_raw_grpc_bodies is set. The messages are parsed without a schema, "
+            "so fields are printed with their field numbers. Bodies that are not base64-encoded "
+            "are returned as is.")
+        .Arg("body", "The req_body or resp_body of a gRPC request in the http_events table.")
+        .Example("df.req_body = px.grpc_body_to_text(df.req_body)")
+        .Returns("The message body as text format protobuf.");
+  }
+};
+
 void RegisterProtocolOpsOrDie(px::carnot::udf::Registry* registry);
 
 }  // namespace protocols
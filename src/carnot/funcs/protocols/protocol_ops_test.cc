@@ -18,6 +18,11 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+
+#include <absl/strings/escaping.h>
+#include <absl/strings/str_cat.h>
+
 #include "src/carnot/funcs/protocols/protocol_ops.h"
 #include "src/carnot/udf/test_utils.h"
 #include "src/common/base/base.h"
@@ -47,6 +52,19 @@ TEST(ProtocolOps, MySQLCommandNameUDF) {
   udf_tester.ForInput(9999).Expect("9999");
 }
 
+TEST(ProtocolOps, GRPCBodyToTextUDF) {
+  // A gRPC message holding {1: "foo"}.
+  const std::string wire = ConstStringView("\x00\x00\x00\x00\x05\x0a\x03\x66\x6f\x6f");
+  const std::string encoded = absl::Base64Escape(wire);
+
+  auto udf_tester = udf::UDFTester<GRPCBodyToTextUDF>();
+  udf_tester.ForInput(encoded).Expect(R"(1: "foo")");
+  udf_tester.ForInput(absl::StrCat(encoded, "... [TRUNCATED]"))
+      .Expect(R"(1: "foo"... [TRUNCATED])");
+  // Bodies that Stirling already parsed are returned as is.
+  udf_tester.ForInput(R"(1: "foo")").Expect(R"(1: "foo")");
+}
+
 }  // namespace protocols
 }  // namespace funcs
 }  // namespace carnot
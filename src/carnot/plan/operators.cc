@@ -96,6 +96,14 @@ std::string MemorySourceOperator::DebugString() const { return "Op:MemorySource"
 
 Status MemorySourceOperator::Init(const planpb::MemorySourceOperator& pb) {
   pb_ = pb;
+  if (pb_.stream_window_ms() < 0) {
+    return error::InvalidArgument("stream_window_ms must not be negative, got $0",
+                                  pb_.stream_window_ms());
+  }
+  if (pb_.sample_fraction() < 0 || pb_.sample_fraction() > 1) {
+    return error::InvalidArgument("sample_fraction must be between 0 and 1, got $0",
+                                  pb_.sample_fraction());
+  }
   column_idxs_.reserve(static_cast<size_t>(pb_.column_idxs_size()));
   for (int i = 0; i < pb_.column_idxs_size(); ++i) {
     column_idxs_.emplace_back(pb_.column_idxs(i));
@@ -201,6 +209,13 @@ Status AggregateOperator::Init(const planpb::AggregateOperator& pb) {
   if (pb_.values_size() != pb_.value_names_size()) {
     return error::InvalidArgument("values names/exp size mismatch");
   }
+  if (pb_.window_panes() < 0) {
+    return error::InvalidArgument("window_panes must not be negative, got $0", pb_.window_panes());
+  }
+  if (pb_.snapshot_interval_ms() < 0) {
+    return error::InvalidArgument("snapshot_interval_ms must not be negative, got $0",
+                                  pb_.snapshot_interval_ms());
+  }
   values_.reserve(static_cast<size_t>(pb_.values_size()));
   for (int i = 0; i < pb_.values_size(); ++i) {
     auto ae = std::make_unique<AggregateExpression>();
@@ -249,7 +264,7 @@ StatusOr<table_store::schema::Relation> AggregateOperator::OutputRelation(
   // If this node is a partial aggregate we output a simple schema where the last column has
   // serialized aggregates.
   // TODO(philkuz) need the column name and maybe type from somewhere else.
-  if (pb_.partial_agg() && !pb_.finalize_results()) {
+  if (partial_output()) {
     output_relation.AddColumn(types::STRING, "serialized_expressions");
     return output_relation;
   }
@@ -320,6 +335,10 @@ std::string GRPCSinkOperator::DebugString() const {
   } else if (has_grpc_source_id()) {
     destination = absl::Substitute("source_id=$0", grpc_source_id());
   }
+  if (has_hash_partition()) {
+    return absl::Substitute("Op:GRPCSink($0, $1, partition=$2/$3)", address(), destination,
+                            hash_partition().partition(), hash_partition().num_partitions());
+  }
   return absl::Substitute("Op:GRPCSink($0, $1)", address(), destination);
 }
 
@@ -398,6 +417,12 @@ StatusOr<table_store::schema::Relation> FilterOperator::OutputRelation(
 std::string LimitOperator::DebugString() const {
   std::string debug_string =
       absl::Substitute("($0, cols: [$1])", record_limit_, absl::StrJoin(selected_cols_, ","));
+  if (ordered()) {
+    debug_string = absl::Substitute("($0, cols: [$1], sort: [$2] $3)", record_limit_,
+                                    absl::StrJoin(selected_cols_, ","),
+                                    absl::StrJoin(sort_cols_, ","),
+                                    sort_ascending() ? "asc" : "desc");
+  }
   return "Op:Limit" + debug_string;
 }
 
@@ -415,6 +440,11 @@ Status LimitOperator::Init(const planpb::LimitOperator& pb) {
     abortable_srcs_.push_back(pb_.abortable_srcs(i));
   }
 
+  sort_cols_.reserve(pb_.sort_columns_size());
+  for (auto i = 0; i < pb_.sort_columns_size(); ++i) {
+    sort_cols_.push_back(pb_.sort_columns(i).index());
+  }
+
   is_initialized_ = true;
   return Status::OK();
 }
@@ -443,6 +473,13 @@ StatusOr<table_store::schema::Relation> LimitOperator::OutputRelation(
                               input_relation.GetColumnName(selected_col_idx),
                               input_relation.GetColumnDesc(selected_col_idx));
   }
+  for (auto sort_col_idx : sort_cols_) {
+    if (sort_col_idx < 0 || sort_col_idx >= static_cast<int64_t>(input_relation.NumColumns())) {
+      return error::InvalidArgument(
+          "Sort column index $0 is out of bounds, number of columns is $1", sort_col_idx,
+          input_relation.NumColumns());
+    }
+  }
 
   // Output relation is the same as the input relation.
   return output_relation;
@@ -588,6 +625,18 @@ Status JoinOperator::Init(const planpb::JoinOperator& pb) {
     equality_conditions_.emplace_back(pb_.equality_conditions(i));
   }
 
+  if (as_of()) {
+    if (type() != planpb::JoinOperator::INNER && type() != planpb::JoinOperator::LEFT_OUTER) {
+      return error::InvalidArgument("As-of joins must be inner or left joins.");
+    }
+    if (as_of_tolerance_ns() < 0) {
+      return error::InvalidArgument("As-of join tolerance must not be negative, got $0.",
+                                    as_of_tolerance_ns());
+    }
+    // As-of joins keep the order of the left rows for each key, but not across keys.
+    return Status::OK();
+  }
+
   if (order_by_time()) {
     // Only support inner joins and left joins where the time_ column comes from the left table.
     // We need a time_ value for every output row in the ordered case to preserve time ordering.
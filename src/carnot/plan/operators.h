@@ -19,6 +19,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -96,6 +97,13 @@ class MemorySourceOperator : public Operator {
   std::vector<int64_t> Columns() const { return column_idxs_; }
   const types::TabletID& Tablet() const { return pb_.tablet(); }
   bool infinite_stream() const { return pb_.streaming(); }
+  std::chrono::milliseconds stream_window() const {
+    return std::chrono::milliseconds(pb_.stream_window_ms());
+  }
+  // The fraction of batches to read, or 1 to read all of them.
+  double sample_fraction() const {
+    return pb_.sample_fraction() > 0 ? pb_.sample_fraction() : 1.0;
+  }
 
  private:
   planpb::MemorySourceOperator pb_;
@@ -143,6 +151,22 @@ class AggregateOperator : public Operator {
   const std::vector<GroupInfo>& groups() const { return groups_; }
   const std::vector<std::shared_ptr<AggregateExpression>>& values() const { return values_; }
   bool windowed() const { return pb_.windowed(); }
+  int64_t window_panes() const { return pb_.window_panes(); }
+  bool merge_partials() const { return pb_.merge_partials(); }
+  // How often a blocking aggregate emits a snapshot of its results so far, 0 if it doesn't.
+  int64_t snapshot_interval_ms() const { return pb_.snapshot_interval_ms(); }
+  // The group that holds time bins which arrive in increasing order, or -1 if there isn't one.
+  int64_t time_bin_group() const {
+    return pb_.streaming_time_bins() ? pb_.time_bin_group() : -1;
+  }
+  // Whether the input rows hold partial aggregates instead of the values to aggregate.
+  bool partial_input() const {
+    return pb_.merge_partials() || (pb_.finalize_results() && !pb_.partial_agg());
+  }
+  // Whether the output rows hold partial aggregates instead of the finalized values.
+  bool partial_output() const {
+    return pb_.merge_partials() || (pb_.partial_agg() && !pb_.finalize_results());
+  }
 
  private:
   std::vector<std::shared_ptr<AggregateExpression>> values_;
@@ -161,6 +185,7 @@ class MemorySinkOperator : public Operator {
   Status Init(const planpb::MemorySinkOperator& pb);
   std::string TableName() const { return pb_.name(); }
   std::string ColumnName(int64_t i) const { return pb_.column_names(i); }
+  bool append() const { return pb_.append(); }
   std::string DebugString() const override;
 
  private:
@@ -213,6 +238,13 @@ class GRPCSinkOperator : public Operator {
     return pb_.destination_case() == planpb::GRPCSinkOperator::kOutputTable;
   }
   std::string table_name() const { return pb_.output_table().table_name(); }
+  // Whether the input is a sequence of result snapshots, each ended by eow.
+  bool snapshots() const { return has_table_name() && pb_.output_table().snapshots(); }
+
+  bool has_hash_partition() const { return pb_.has_hash_partition(); }
+  const planpb::GRPCSinkOperator::HashPartition& hash_partition() const {
+    return pb_.hash_partition();
+  }
 
  private:
   planpb::GRPCSinkOperator pb_;
@@ -254,10 +286,18 @@ class LimitOperator : public Operator {
 
   const std::vector<int64_t>& abortable_srcs() const { return abortable_srcs_; }
 
+  // The input columns to sort by, empty unless this is an ordered limit (top-k).
+  const std::vector<int64_t>& sort_cols() const { return sort_cols_; }
+  bool sort_ascending() const { return pb_.sort_ascending(); }
+  bool ordered() const { return !sort_cols_.empty(); }
+  // Whether every eow of the input restarts the count.
+  bool per_window() const { return pb_.per_window(); }
+
  private:
   int64_t record_limit_ = 0;
   std::vector<int64_t> selected_cols_;
   std::vector<int64_t> abortable_srcs_;
+  std::vector<int64_t> sort_cols_;
   planpb::LimitOperator pb_;
 };
 
@@ -316,6 +356,11 @@ class JoinOperator : public Operator {
   bool order_by_time() const;
   planpb::JoinOperator::ParentColumn time_column() const;
 
+  bool as_of() const { return pb_.as_of(); }
+  int64_t left_time_column_index() const { return pb_.left_time_column_index(); }
+  int64_t right_time_column_index() const { return pb_.right_time_column_index(); }
+  int64_t as_of_tolerance_ns() const { return pb_.as_of_tolerance_ns(); }
+
  private:
   std::vector<std::string> column_names_;
   std::vector<planpb::JoinOperator::EqualityCondition> equality_conditions_;
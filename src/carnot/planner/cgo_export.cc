@@ -96,27 +96,18 @@ char* PlannerPlan(PlannerPtr planner_ptr, const char* planner_state_str_c,
 
   auto planner = reinterpret_cast<px::carnot::planner::LogicalPlanner*>(planner_ptr);
 
-  auto distributed_plan_status = planner->Plan(planner_state_pb, query_request_pb);
-  if (!distributed_plan_status.ok()) {
-    return ExitEarly<LogicalPlannerResult>(distributed_plan_status.status(), resultLen);
-  }
-  std::unique_ptr<px::carnot::planner::distributed::DistributedPlan> distributed_plan =
-      distributed_plan_status.ConsumeValueOrDie();
-
-  // If the response is ok, then we can go ahead and set this up.
-  LogicalPlannerResult planner_result_pb;
-  WrapStatus(&planner_result_pb, distributed_plan_status.status());
-  // In the future, if we actually have plan options that will actually determine how the plan is
-  // constructed, we may want to pass the planOptions to planner.Plan. However, this
-  // will need to go through many more layers (such as the coordinator), so this is fine for now.
-  distributed_plan->SetPlanOptions(planner_state_pb.plan_options());
-
-  auto plan_pb_status = distributed_plan->ToProto();
+  px::carnot::planner::LogicalPlanner::PlanTimings timings;
+  auto plan_pb_status = planner->PlanToProto(planner_state_pb, query_request_pb, &timings);
   if (!plan_pb_status.ok()) {
     return ExitEarly<LogicalPlannerResult>(plan_pb_status.status(), resultLen);
   }
 
+  // If the response is ok, then we can go ahead and set this up.
+  LogicalPlannerResult planner_result_pb;
+  WrapStatus(&planner_result_pb, plan_pb_status.status());
   *(planner_result_pb.mutable_plan()) = plan_pb_status.ConsumeValueOrDie();
+  planner_result_pb.set_compile_time_ns(timings.compile_time_ns);
+  planner_result_pb.set_distributed_plan_time_ns(timings.distributed_plan_time_ns);
 
   // Serialize the logical plan into bytes.
   return PrepareResult(&planner_result_pb, resultLen);
@@ -39,6 +39,7 @@
 #include "src/carnot/planner/compiler/analyzer/set_memory_source_times_rule.h"
 #include "src/carnot/planner/compiler/analyzer/setup_join_type_rule.h"
 #include "src/carnot/planner/compiler/analyzer/unique_sink_names_rule.h"
+#include "src/carnot/planner/compiler/analyzer/use_rollup_tables_rule.h"
 #include "src/carnot/planner/compiler/analyzer/verify_filter_expression_rule.h"
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/compiler_state/registry_info.h"
@@ -110,6 +111,11 @@ class Analyzer : public RuleExecutor<IR> {
     manage_column_access->AddRule<RestrictColumnsRule>(compiler_state_);
   }
 
+  void CreateUseRollupTablesBatch() {
+    RuleBatch* use_rollup_tables = CreateRuleBatch<FailOnMax>("UseRollupTables", 2);
+    use_rollup_tables->AddRule<UseRollupTablesRule>(compiler_state_);
+  }
+
   void CreateMetadataConversionBatch() {
     RuleBatch* metadata_conversion_batch = CreateRuleBatch<FailOnMax>("MetadataConversion", 2);
     metadata_conversion_batch->AddRule<ConvertMetadataRule>(compiler_state_);
@@ -136,6 +142,7 @@ class Analyzer : public RuleExecutor<IR> {
     CreateCombineConsecutiveMapsRule();
     CreateDataTypeResolutionBatch();
     CreateManageColumnAccessBatch();
+    CreateUseRollupTablesBatch();
     CreateMetadataConversionBatch();
     CreateResolutionVerificationBatch();
     CreateRemoveIROnlyNodesBatch();
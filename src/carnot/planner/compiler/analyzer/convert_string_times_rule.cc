@@ -51,6 +51,13 @@ StatusOr<bool> ConvertStringTimesRule::HandleMemSrc(MemorySourceIR* mem_src) {
   ExpressionIR* start_time = mem_src->start_time_expr();
   ExpressionIR* end_time = mem_src->end_time_expr();
 
+  // Relative times nested in an expression can't be told apart from the rest of the expression
+  // once it's evaluated, so the plan can't be rebound to a later time.
+  if ((start_has_string_time && !Match(start_time, String())) ||
+      (end_has_string_time && !Match(end_time, String()))) {
+    compiler_state_->MarkTimeDependent();
+  }
+
   if (start_has_string_time) {
     PL_ASSIGN_OR_RETURN(start_time, ConvertStringTimes(start_time, /* relative_time */ true));
   }
@@ -107,6 +114,9 @@ StatusOr<ExpressionIR*> ConvertStringTimesRule::ConvertStringTimes(ExpressionIR*
     PL_ASSIGN_OR_RETURN(
         int64_t time,
         ParseStringToTime(str_node, relative_time ? compiler_state_->time_now().val : 0));
+    if (relative_time && ParseDurationFmt(str_node, 0).ok()) {
+      compiler_state_->RecordRelativeTime(time);
+    }
     return node->graph()->CreateNode<IntIR>(node->ast(), time);
   } else if (Match(node, Func())) {
     auto func_node = static_cast<FuncIR*>(node);
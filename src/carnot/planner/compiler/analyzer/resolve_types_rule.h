@@ -37,6 +37,9 @@ class ResolveTypesRule : public Rule {
       : Rule(compiler_state, /*use_topo*/ true, /*reverse_topological_execution*/ false) {}
 
   StatusOr<bool> Apply(IRNode* ir_node) override;
+
+  // An operator's type only depends on its parents' types and its own expressions.
+  bool SupportsIncrementalExecution() const override { return true; }
 };
 
 }  // namespace compiler
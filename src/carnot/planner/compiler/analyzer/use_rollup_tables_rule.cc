@@ -0,0 +1,126 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/compiler/analyzer/use_rollup_tables_rule.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+// Merging the partials of a rollup by any subset of its groups gives the same result as
+// aggregating the source rows by that subset.
+bool GroupsMatch(const std::vector<ColumnIR*>& groups, const RollupDefinition& rollup) {
+  for (const ColumnIR* group : groups) {
+    if (std::find(rollup.group_columns.begin(), rollup.group_columns.end(), group->col_name()) ==
+        rollup.group_columns.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The packed partials are finalized in the order of the rollup's aggregates, so the expressions
+// have to be exactly those aggregates.
+bool AggregatesMatch(const ColExpressionVector& exprs, const RollupDefinition& rollup) {
+  if (exprs.size() != rollup.aggregates.size()) {
+    return false;
+  }
+  for (const auto& [idx, expr] : Enumerate(exprs)) {
+    if (!Match(expr.node, PartialUDA())) {
+      return false;
+    }
+    auto func = static_cast<FuncIR*>(expr.node);
+    if (func->func_name() != rollup.aggregates[idx].uda_name || func->args().size() != 1 ||
+        !Match(func->args()[0], ColumnNode())) {
+      return false;
+    }
+    if (static_cast<ColumnIR*>(func->args()[0])->col_name() != rollup.aggregates[idx].arg_column) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+const RollupDefinition* UseRollupTablesRule::FindRollup(const MemorySourceIR* src,
+                                                        const BlockingAggIR* agg) const {
+  for (const auto& rollup : compiler_state_->rollups()) {
+    if (rollup.source_table != src->table_name()) {
+      continue;
+    }
+    // The rollup table only shows up in the schema once the agents maintain it.
+    if (compiler_state_->relation_map()->find(rollup.rollup_table) ==
+        compiler_state_->relation_map()->end()) {
+      continue;
+    }
+    if (GroupsMatch(agg->groups(), rollup) &&
+        AggregatesMatch(agg->aggregate_expressions(), rollup)) {
+      return &rollup;
+    }
+  }
+  return nullptr;
+}
+
+StatusOr<bool> UseRollupTablesRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, BlockingAgg())) {
+    return false;
+  }
+  auto agg = static_cast<BlockingAggIR*>(ir_node);
+  if (!agg->partial_agg() || !agg->finalize_results() ||
+      !Match(agg->parents()[0], MemorySource())) {
+    return false;
+  }
+  auto src = static_cast<MemorySourceIR*>(agg->parents()[0]);
+  // The source is rewritten in place, so it can't feed any other operator. Sampled sources are
+  // left alone, because the aggregate's results are scaled to the sample.
+  if (src->streaming() || src->sample_fraction() < 1.0 || src->Children().size() != 1) {
+    return false;
+  }
+  const RollupDefinition* rollup = FindRollup(src, agg);
+  if (rollup == nullptr) {
+    return false;
+  }
+
+  planpb::Operator pb;
+  PL_RETURN_IF_ERROR(agg->ToProto(&pb));
+  agg->SetPreSplitProto(pb.agg_op());
+  agg->SetPartialAgg(false);
+
+  std::vector<std::string> columns;
+  for (const ColumnIR* group : agg->groups()) {
+    columns.push_back(group->col_name());
+  }
+  columns.push_back(kRollupPartialsColumn);
+  src->SetTableName(rollup->rollup_table);
+  src->SetColumnNames(columns);
+  PL_RETURN_IF_ERROR(src->ResolveType(compiler_state_));
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
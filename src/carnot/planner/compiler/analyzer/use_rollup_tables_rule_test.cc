@@ -0,0 +1,133 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/analyzer/resolve_types_rule.h"
+#include "src/carnot/planner/compiler/analyzer/use_rollup_tables_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using table_store::schema::Relation;
+using ::testing::ElementsAre;
+
+class UseRollupTablesRuleTest : public RulesTest {
+ protected:
+  void SetUpImpl() override {
+    RulesTest::SetUpImpl();
+    source_relation_ = Relation({types::TIME64NS, types::STRING, types::STRING, types::INT64},
+                                {"time_", "service", "req_path", "latency"});
+    rollup_ = RollupDefinition{"http",
+                               "http.10s",
+                               {"service", "req_path"},
+                               {{"count", "latency"}},
+                               /* bucket_ns */ 10LL * 1000 * 1000 * 1000};
+    compiler_state_->relation_map()->emplace("http", source_relation_);
+    compiler_state_->set_rollups({rollup_});
+  }
+
+  void AddRollupTable() {
+    compiler_state_->relation_map()->emplace(
+        rollup_.rollup_table, RollupRelation(rollup_, source_relation_).ConsumeValueOrDie());
+  }
+
+  // Makes and resolves an aggregate of the latency column of the source table.
+  BlockingAggIR* MakeLatencyAgg(const std::vector<std::string>& groups, const std::string& uda) {
+    MemorySourceIR* src = MakeMemSource("http", source_relation_);
+    std::vector<ColumnIR*> group_cols;
+    for (const auto& group : groups) {
+      group_cols.push_back(MakeColumn(group, 0));
+    }
+    BlockingAggIR* agg =
+        MakeBlockingAgg(src, group_cols, {{"requests", MakeFunc(uda, {MakeColumn("latency", 0)})}});
+    MakeMemSink(agg, "out");
+    ResolveTypesRule type_rule(compiler_state_.get());
+    EXPECT_OK(type_rule.Execute(graph.get()));
+    return agg;
+  }
+
+  Relation source_relation_;
+  RollupDefinition rollup_;
+};
+
+TEST_F(UseRollupTablesRuleTest, subset_of_groups) {
+  AddRollupTable();
+  BlockingAggIR* agg = MakeLatencyAgg({"service"}, "count");
+  auto src = static_cast<MemorySourceIR*>(agg->parents()[0]);
+
+  UseRollupTablesRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  EXPECT_EQ("http.10s", src->table_name());
+  EXPECT_THAT(src->resolved_table_type()->ColumnNames(),
+              ElementsAre("service", "serialized_expressions"));
+  EXPECT_THAT(src->column_index_map(), ElementsAre(1, 3));
+  EXPECT_MATCH(agg, FinalizeAgg());
+  EXPECT_THAT(agg->resolved_table_type()->ColumnNames(), ElementsAre("service", "requests"));
+
+  planpb::Operator pb;
+  ASSERT_OK(agg->ToProto(&pb));
+  ASSERT_EQ(1, pb.agg_op().values_size());
+  EXPECT_EQ("count", pb.agg_op().values(0).name());
+  EXPECT_EQ(0, pb.agg_op().groups(0).index());
+}
+
+TEST_F(UseRollupTablesRuleTest, no_rollup_table) {
+  BlockingAggIR* agg = MakeLatencyAgg({"service"}, "count");
+
+  UseRollupTablesRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ("http", static_cast<MemorySourceIR*>(agg->parents()[0])->table_name());
+}
+
+TEST_F(UseRollupTablesRuleTest, mismatched_aggregate) {
+  AddRollupTable();
+  MakeLatencyAgg({"service"}, "mean");
+
+  UseRollupTablesRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+TEST_F(UseRollupTablesRuleTest, group_not_in_rollup) {
+  AddRollupTable();
+  MakeLatencyAgg({"service", "time_"}, "count");
+
+  UseRollupTablesRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
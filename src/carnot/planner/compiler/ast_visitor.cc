@@ -158,9 +158,10 @@ StatusOr<QLObjectPtr> ASTVisitorImpl::ProcessSingleExpressionModule(
 
 StatusOr<QLObjectPtr> ASTVisitorImpl::ParseAndProcessSingleExpression(
     std::string_view single_expr_str, bool import_px) {
+  // The same default argument values are parsed on every compile, so their asts are shared.
   Parser parser;
   PL_ASSIGN_OR_RETURN(pypa::AstModulePtr ast,
-                      parser.Parse(single_expr_str.data(), /* parse_doc_strings */ false));
+                      parser.ParseCached(single_expr_str, /* parse_doc_strings */ false));
   if (import_px) {
     auto child_visitor = CreateChild();
     // Use a child of this ASTVisitor so that we can add px to its child var_table without
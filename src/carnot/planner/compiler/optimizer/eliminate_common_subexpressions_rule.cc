@@ -0,0 +1,202 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "src/carnot/planner/compiler/optimizer/eliminate_common_subexpressions_rule.h"
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/substitute.h>
+
+#include "src/carnot/planner/ir/column_ir.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+namespace {
+
+void CollectCallsInExpression(ExpressionIR* expr, FuncIR* container,
+                              std::vector<FuncIR*>* funcs, std::vector<FuncIR*>* containers) {
+  if (!Match(expr, Func())) {
+    return;
+  }
+  auto func = static_cast<FuncIR*>(expr);
+  funcs->push_back(func);
+  containers->push_back(container);
+  for (ExpressionIR* arg : func->all_args()) {
+    CollectCallsInExpression(arg, func, funcs, containers);
+  }
+}
+
+// Whether the call reads any column. Calls on literals only are left to FoldConstantsRule.
+bool ReadsColumns(FuncIR* func) {
+  auto input_columns_or_s = func->InputColumnNames();
+  return input_columns_or_s.ok() && !input_columns_or_s.ValueOrDie().empty();
+}
+
+// Whether the call can be swapped for a column. FuncIR::UpdateArg doesn't support the args of
+// funcs that have init args.
+bool IsReplaceable(FuncIR* func, FuncIR* container) {
+  if (container != nullptr && container->IsInitArgsSplit() && !container->init_args().empty()) {
+    return false;
+  }
+  return ReadsColumns(func);
+}
+
+}  // namespace
+
+std::vector<EliminateCommonSubexpressionsRule::Call>
+EliminateCommonSubexpressionsRule::CollectCalls(const MapIR* map) {
+  std::vector<FuncIR*> funcs;
+  std::vector<FuncIR*> containers;
+  for (const ColumnExpression& expr : map->col_exprs()) {
+    CollectCallsInExpression(expr.node, /*container*/ nullptr, &funcs, &containers);
+  }
+  // Calls come before the calls in their args, so that the largest repeated call is shared.
+  std::vector<Call> calls;
+  for (size_t i = 0; i < funcs.size(); ++i) {
+    if (IsReplaceable(funcs[i], containers[i])) {
+      calls.push_back({funcs[i], containers[i]});
+    }
+  }
+  return calls;
+}
+
+Status EliminateCommonSubexpressionsRule::ReplaceCall(MapIR* map, const Call& call,
+                                                      const std::string& col_name,
+                                                      const TypePtr& parent_type) {
+  PL_ASSIGN_OR_RETURN(ColumnIR * col, map->graph()->CreateNode<ColumnIR>(call.func->ast(), col_name,
+                                                                         /*parent_op_idx*/ 0));
+  PL_RETURN_IF_ERROR(ResolveExpressionType(col, compiler_state_, {parent_type}));
+  col->set_annotations(call.func->annotations());
+  if (call.container == nullptr) {
+    return map->UpdateColExpr(call.func, col);
+  }
+  return call.container->UpdateArg(call.func, col);
+}
+
+StatusOr<bool> EliminateCommonSubexpressionsRule::ReuseParentColumn(MapIR* map, MapIR* parent) {
+  // The columns that the parent passes through as they are.
+  absl::flat_hash_set<std::string> forwarded;
+  for (const ColumnExpression& expr : parent->col_exprs()) {
+    if (Match(expr.node, ColumnNode()) &&
+        static_cast<ColumnIR*>(expr.node)->col_name() == expr.name) {
+      forwarded.insert(expr.name);
+    }
+  }
+
+  for (const Call& call : CollectCalls(map)) {
+    PL_ASSIGN_OR_RETURN(auto input_columns, call.func->InputColumnNames());
+    bool inputs_forwarded = true;
+    for (const std::string& input_column : input_columns) {
+      inputs_forwarded &= forwarded.contains(input_column);
+    }
+    if (!inputs_forwarded) {
+      continue;
+    }
+    for (const ColumnExpression& expr : parent->col_exprs()) {
+      if (call.func->Equals(expr.node)) {
+        PL_RETURN_IF_ERROR(ReplaceCall(map, call, expr.name, parent->resolved_type()));
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+StatusOr<bool> EliminateCommonSubexpressionsRule::ShareRepeatedCall(MapIR* map) {
+  std::vector<Call> calls = CollectCalls(map);
+  for (size_t i = 0; i < calls.size(); ++i) {
+    std::vector<Call> repeats = {calls[i]};
+    for (size_t j = i + 1; j < calls.size(); ++j) {
+      if (calls[i].func->Equals(calls[j].func)) {
+        repeats.push_back(calls[j]);
+      }
+    }
+    if (repeats.size() < 2) {
+      continue;
+    }
+
+    OperatorIR* parent = map->parents()[0];
+    absl::flat_hash_set<std::string> used_names;
+    for (const std::string& name : parent->resolved_table_type()->ColumnNames()) {
+      used_names.insert(name);
+    }
+    for (const ColumnExpression& expr : map->col_exprs()) {
+      used_names.insert(expr.name);
+    }
+    std::string col_name;
+    for (int64_t n = 0; col_name.empty() || used_names.contains(col_name); ++n) {
+      col_name = absl::Substitute("_cse_$0", n);
+    }
+
+    // The shared map evaluates the call once, next to the columns of the parent.
+    PL_ASSIGN_OR_RETURN(
+        MapIR * shared,
+        map->graph()->CreateNode<MapIR>(map->ast(), parent,
+                                        ColExpressionVector{{col_name, calls[i].func}},
+                                        /*keep_input_columns*/ true));
+    PL_RETURN_IF_ERROR(ResolveOperatorType(shared, compiler_state_));
+    PL_RETURN_IF_ERROR(map->ReplaceParent(parent, shared));
+
+    for (const Call& call : repeats) {
+      PL_RETURN_IF_ERROR(ReplaceCall(map, call, col_name, shared->resolved_type()));
+    }
+    map->ClearResolvedType();
+    PL_RETURN_IF_ERROR(ResolveOperatorType(map, compiler_state_));
+    return true;
+  }
+  return false;
+}
+
+StatusOr<bool> EliminateCommonSubexpressionsRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Map())) {
+    return false;
+  }
+  auto map = static_cast<MapIR*>(ir_node);
+  DCHECK_EQ(1UL, map->parents().size());
+  DCHECK(map->is_type_resolved());
+
+  bool changed = false;
+  // Children are visited before their parents, so the parent still has the calls of its own
+  // columns in place.
+  if (Match(map->parents()[0], Map())) {
+    auto parent = static_cast<MapIR*>(map->parents()[0]);
+    while (true) {
+      PL_ASSIGN_OR_RETURN(bool reused, ReuseParentColumn(map, parent));
+      if (!reused) {
+        break;
+      }
+      changed = true;
+    }
+  }
+  while (true) {
+    PL_ASSIGN_OR_RETURN(bool shared, ShareRepeatedCall(map));
+    if (!shared) {
+      break;
+    }
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
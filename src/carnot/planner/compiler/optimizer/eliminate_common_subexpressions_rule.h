@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "src/carnot/planner/compiler_state/compiler_state.h"
+#include "src/carnot/planner/ir/func_ir.h"
+#include "src/carnot/planner/ir/map_ir.h"
+#include "src/carnot/planner/rules/rules.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Evaluates repeated UDF calls of a map once. PxL commonly repeats calls, ie every
+ * ctx['pod'] becomes its own px.upid_to_pod_name(df.upid).
+ *
+ * A call that a map repeats is moved into a new map in front of it, and the map reads the
+ * result from a column instead. A call that the parent map already evaluates on the same
+ * columns is replaced by the parent's output column.
+ *
+ * Carnot's scalar UDFs are pure functions of their arguments, so calls with equal arguments
+ * evaluate to the same value.
+ */
+class EliminateCommonSubexpressionsRule : public Rule {
+ public:
+  explicit EliminateCommonSubexpressionsRule(CompilerState* compiler_state)
+      : Rule(compiler_state, /*use_topo*/ true, /*reverse_topological_execution*/ true) {}
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  // A call in the expressions of a map, and the func that it's an argument of. The container is
+  // nullptr when the call is the whole expression of a column.
+  struct Call {
+    FuncIR* func;
+    FuncIR* container;
+  };
+
+  static std::vector<Call> CollectCalls(const MapIR* map);
+  StatusOr<bool> ReuseParentColumn(MapIR* map, MapIR* parent);
+  StatusOr<bool> ShareRepeatedCall(MapIR* map);
+  Status ReplaceCall(MapIR* map, const Call& call, const std::string& col_name,
+                     const TypePtr& parent_type);
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/analyzer/resolve_types_rule.h"
+#include "src/carnot/planner/compiler/optimizer/eliminate_common_subexpressions_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using ::testing::ElementsAre;
+
+using EliminateCommonSubexpressionsRuleTest = RulesTest;
+
+TEST_F(EliminateCommonSubexpressionsRuleTest, repeated_call_in_map) {
+  auto mem_src = MakeMemSource("cpu", cpu_relation);
+  auto sum_fn = MakeAddFunc(MakeColumn("cpu0", 0), MakeColumn("cpu1", 0));
+  auto double_sum_fn =
+      MakeMultFunc(MakeAddFunc(MakeColumn("cpu0", 0), MakeColumn("cpu1", 0)), MakeInt(2));
+  auto map = MakeMap(mem_src, {{"sum", sum_fn},
+                               {"double_sum", double_sum_fn},
+                               {"count", MakeColumn("count", 0)}});
+  MakeMemSink(map, "");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+  auto prev_type = map->resolved_table_type();
+
+  EliminateCommonSubexpressionsRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  // The sum is evaluated once, by a new map in front of the map.
+  ASSERT_MATCH(map->parents()[0], Map());
+  auto shared = static_cast<MapIR*>(map->parents()[0]);
+  EXPECT_EQ(mem_src, shared->parents()[0]);
+  EXPECT_THAT(shared->resolved_table_type()->ColumnNames(),
+              ElementsAre("count", "cpu0", "cpu1", "cpu2", "_cse_0"));
+  EXPECT_MATCH(shared->col_exprs()[4].node, Func());
+
+  ASSERT_MATCH(map->col_exprs()[0].node, ColumnNode("_cse_0"));
+  ASSERT_MATCH(map->col_exprs()[1].node, Func());
+  auto double_sum = static_cast<FuncIR*>(map->col_exprs()[1].node);
+  EXPECT_MATCH(double_sum->all_args()[0], ColumnNode("_cse_0"));
+  EXPECT_MATCH(double_sum->all_args()[1], Int(2));
+  EXPECT_TRUE(map->resolved_table_type()->Equals(prev_type));
+
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+TEST_F(EliminateCommonSubexpressionsRuleTest, reuse_parent_column) {
+  auto mem_src = MakeMemSource("cpu", cpu_relation);
+  auto parent = MakeMap(mem_src, {{"cpu0", MakeColumn("cpu0", 0)},
+                                  {"cpu1", MakeColumn("cpu1", 0)},
+                                  {"sum", MakeAddFunc(MakeColumn("cpu0", 0), MakeInt(1))}});
+  auto child_fn = MakeMultFunc(MakeAddFunc(MakeColumn("cpu0", 0), MakeInt(1)), MakeInt(2));
+  // sum isn't passed through by the parent, so sum + 1 can't be one of the parent's columns.
+  auto other_fn = MakeAddFunc(MakeColumn("sum", 0), MakeInt(1));
+  auto child = MakeMap(parent, {{"doubled", child_fn}, {"other", other_fn}});
+  MakeMemSink(child, "");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  EliminateCommonSubexpressionsRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  // No new map is needed, the child reads the parent's column.
+  EXPECT_EQ(parent, child->parents()[0]);
+  ASSERT_MATCH(child->col_exprs()[0].node, Func());
+  auto doubled = static_cast<FuncIR*>(child->col_exprs()[0].node);
+  EXPECT_MATCH(doubled->all_args()[0], ColumnNode("sum"));
+  EXPECT_EQ(other_fn, child->col_exprs()[1].node);
+}
+
+TEST_F(EliminateCommonSubexpressionsRuleTest, redefined_input_column) {
+  auto mem_src = MakeMemSource("cpu", cpu_relation);
+  // The parent redefines cpu0, so cpu0 + 1 in the child isn't the parent's sum.
+  auto parent = MakeMap(mem_src, {{"cpu0", MakeColumn("cpu1", 0)},
+                                  {"sum", MakeAddFunc(MakeColumn("cpu0", 0), MakeInt(1))}});
+  auto child_fn = MakeAddFunc(MakeColumn("cpu0", 0), MakeInt(1));
+  auto child = MakeMap(parent, {{"sum2", child_fn}});
+  MakeMemSink(child, "");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  EliminateCommonSubexpressionsRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+  EXPECT_EQ(child_fn, child->col_exprs()[0].node);
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "src/carnot/planner/compiler/optimizer/fold_constants_rule.h"
+
+#include <vector>
+
+#include "src/carnot/funcs/builtins/math_ops.h"
+#include "src/carnot/funcs/builtins/string_ops.h"
+#include "src/carnot/planner/ir/filter_ir.h"
+#include "src/carnot/planner/ir/func_ir.h"
+#include "src/carnot/planner/ir/map_ir.h"
+#include "src/carnot/udf/udf_definition.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+FoldConstantsRule::FoldConstantsRule(CompilerState* compiler_state)
+    : Rule(compiler_state, /*use_topo*/ true, /*reverse_topological_execution*/ true),
+      registry_(std::make_unique<udf::Registry>("fold_constants")) {
+  builtins::RegisterMathOpsOrDie(registry_.get());
+  builtins::RegisterStringOpsOrDie(registry_.get());
+}
+
+StatusOr<DataIR*> FoldConstantsRule::Evaluate(FuncIR* func, udf::ScalarUDFDefinition* def) const {
+  std::vector<std::shared_ptr<types::ColumnWrapper>> column_pool;
+  std::vector<const types::ColumnWrapper*> columns;
+  for (ExpressionIR* arg : func->all_args()) {
+    auto col = types::ColumnWrapper::Make(arg->EvaluatedDataType(), 0);
+    switch (arg->type()) {
+      case IRNodeType::kInt:
+        col->Append<types::Int64Value>(static_cast<IntIR*>(arg)->val());
+        break;
+      case IRNodeType::kFloat:
+        col->Append<types::Float64Value>(static_cast<FloatIR*>(arg)->val());
+        break;
+      case IRNodeType::kString:
+        col->Append<types::StringValue>(static_cast<StringIR*>(arg)->str());
+        break;
+      case IRNodeType::kUInt128:
+        col->Append<types::UInt128Value>(static_cast<UInt128IR*>(arg)->val());
+        break;
+      case IRNodeType::kBool:
+        col->Append<types::BoolValue>(static_cast<BoolIR*>(arg)->val());
+        break;
+      case IRNodeType::kTime:
+        col->Append<types::Time64NSValue>(static_cast<TimeIR*>(arg)->val());
+        break;
+      default:
+        return error::Internal("Unexpected literal $0", arg->DebugString());
+    }
+    columns.push_back(col.get());
+    column_pool.push_back(std::move(col));
+  }
+
+  auto output = types::ColumnWrapper::Make(def->exec_return_type(), 1);
+  auto function_ctx = std::make_unique<udf::FunctionContext>(nullptr, nullptr);
+  auto udf = def->Make();
+  PL_RETURN_IF_ERROR(def->ExecBatch(udf.get(), function_ctx.get(), columns, output.get(), 1));
+
+  IR* graph = func->graph();
+  switch (def->exec_return_type()) {
+    case types::INT64:
+      return graph->CreateNode<IntIR>(func->ast(), output->Get<types::Int64Value>(0).val);
+    case types::FLOAT64:
+      return graph->CreateNode<FloatIR>(func->ast(), output->Get<types::Float64Value>(0).val);
+    case types::STRING:
+      return graph->CreateNode<StringIR>(func->ast(), output->Get<types::StringValue>(0));
+    case types::UINT128:
+      return graph->CreateNode<UInt128IR>(func->ast(), output->Get<types::UInt128Value>(0).val);
+    case types::BOOLEAN:
+      return graph->CreateNode<BoolIR>(func->ast(), output->Get<types::BoolValue>(0).val);
+    case types::TIME64NS:
+      return graph->CreateNode<TimeIR>(func->ast(), output->Get<types::Time64NSValue>(0).val);
+    default:
+      return error::Internal("Unexpected return type for $0", func->DebugString());
+  }
+}
+
+Status FoldConstantsRule::UpdateContainer(IRNode* container, FuncIR* func, DataIR* folded) const {
+  if (Match(container, Func())) {
+    return static_cast<FuncIR*>(container)->UpdateArg(func, folded);
+  }
+  if (Match(container, Map())) {
+    return static_cast<MapIR*>(container)->UpdateColExpr(func, folded);
+  }
+  if (Match(container, Filter())) {
+    return static_cast<FilterIR*>(container)->SetFilterExpr(folded);
+  }
+  return error::Internal("Unsupported container for a folded expression: $0",
+                         container->DebugString());
+}
+
+StatusOr<bool> FoldConstantsRule::Apply(IRNode* ir_node) {
+  if (!Match(ir_node, Func())) {
+    return false;
+  }
+  auto func = static_cast<FuncIR*>(ir_node);
+  if (!func->is_type_resolved() || func->all_args().empty()) {
+    return false;
+  }
+  std::vector<types::DataType> arg_types;
+  for (ExpressionIR* arg : func->all_args()) {
+    if (!Match(arg, DataNode())) {
+      return false;
+    }
+    arg_types.push_back(arg->EvaluatedDataType());
+  }
+  auto def_or_s = registry_->GetScalarUDFDefinition(func->func_name(), arg_types);
+  if (!def_or_s.ok()) {
+    return false;
+  }
+  udf::ScalarUDFDefinition* def = def_or_s.ConsumeValueOrDie();
+  // UDFs with init arguments have to be initialized before they can be executed.
+  if (!def->init_arguments().empty() || def->exec_return_type() != func->EvaluatedDataType()) {
+    return false;
+  }
+
+  IR* graph = func->graph();
+  std::vector<int64_t> container_ids = graph->dag().ParentsOf(func->id());
+  for (int64_t container_id : container_ids) {
+    IRNode* container = graph->Get(container_id);
+    if (!Match(container, Func()) && !Match(container, Map()) && !Match(container, Filter())) {
+      return false;
+    }
+  }
+
+  PL_ASSIGN_OR_RETURN(DataIR * folded, Evaluate(func, def));
+  PL_RETURN_IF_ERROR(ResolveExpressionType(folded, compiler_state_, {}));
+  folded->set_annotations(func->annotations());
+  for (int64_t container_id : container_ids) {
+    PL_RETURN_IF_ERROR(UpdateContainer(graph->Get(container_id), func, folded));
+  }
+  return true;
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
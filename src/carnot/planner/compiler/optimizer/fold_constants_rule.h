@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <memory>
+
+#include "src/carnot/planner/compiler_state/compiler_state.h"
+#include "src/carnot/planner/rules/rules.h"
+#include "src/carnot/udf/registry.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+/**
+ * @brief Replaces calls of pure builtin UDFs whose arguments are all literals with the literal
+ * they evaluate to, so that they aren't evaluated once for every row.
+ *
+ * The AST visitor already folds operators on literals while parsing. This rule also catches the
+ * calls that are written as functions (ie px.length('abc')) and the ones whose arguments only
+ * become literals after other rules rewrote the plan.
+ */
+class FoldConstantsRule : public Rule {
+ public:
+  explicit FoldConstantsRule(CompilerState* compiler_state);
+
+ protected:
+  StatusOr<bool> Apply(IRNode* ir_node) override;
+
+ private:
+  StatusOr<DataIR*> Evaluate(FuncIR* func, udf::ScalarUDFDefinition* def) const;
+  Status UpdateContainer(IRNode* container, FuncIR* func, DataIR* folded) const;
+
+  // The builtins that are pure functions of their arguments, and that the planner can run.
+  std::unique_ptr<udf::Registry> registry_;
+};
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
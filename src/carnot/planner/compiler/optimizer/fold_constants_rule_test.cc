@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "src/carnot/planner/compiler/analyzer/resolve_types_rule.h"
+#include "src/carnot/planner/compiler/optimizer/fold_constants_rule.h"
+#include "src/carnot/planner/compiler/test_utils.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+namespace compiler {
+
+using FoldConstantsRuleTest = RulesTest;
+
+TEST_F(FoldConstantsRuleTest, nested_literals) {
+  auto mem_src = MakeMemSource("cpu", cpu_relation);
+  // 1 + (2 * 3) is folded, count + 1 isn't.
+  auto folded_fn = MakeAddFunc(MakeInt(1), MakeMultFunc(MakeInt(2), MakeInt(3)));
+  auto column_fn = MakeAddFunc(MakeColumn("count", 0), MakeInt(1));
+  auto length_fn = MakeFunc("length", {MakeString("abcd")});
+  auto map = MakeMap(mem_src, {{"folded", folded_fn}, {"column", column_fn}, {"len", length_fn}});
+  MakeMemSink(map, "");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  FoldConstantsRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+
+  ASSERT_MATCH(map->col_exprs()[0].node, Int(7));
+  EXPECT_EQ(column_fn, map->col_exprs()[1].node);
+  ASSERT_MATCH(map->col_exprs()[2].node, Int(4));
+  EXPECT_TRUE(map->col_exprs()[0].node->is_type_resolved());
+
+  // Nothing left to fold.
+  result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_FALSE(result.ConsumeValueOrDie());
+}
+
+TEST_F(FoldConstantsRuleTest, filter_expression) {
+  auto mem_src = MakeMemSource("cpu", cpu_relation);
+  auto filter = MakeFilter(mem_src, MakeEqualsFunc(MakeInt(1), MakeInt(1)));
+  MakeMemSink(filter, "");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  FoldConstantsRule rule(compiler_state_.get());
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  ASSERT_MATCH(filter->filter_expr(), Bool(true));
+}
+
+}  // namespace compiler
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -147,6 +147,38 @@ bool DoTimeIntervalsMerge(MemorySourceIR* src_a, MemorySourceIR* src_b) {
   // }
 }
 
+/**
+ * @brief Returns the operator that op passes its input through from, skipping the no-op maps
+ * that ReplaceOpsWithMerged inserts when an operator reads from several merged parents.
+ */
+OperatorIR* SkipNoOpMaps(OperatorIR* op) {
+  while (Match(op, Map())) {
+    auto map = static_cast<MapIR*>(op);
+    if (!map->keep_input_columns() || !map->col_exprs().empty()) {
+      break;
+    }
+    op = map->parents()[0];
+  }
+  return op;
+}
+
+/**
+ * @brief Returns whether a and b read from the same parents, in the same order. The parents of
+ * operators are replaced with the merged parents before the operators are compared, so operators
+ * that read from duplicated sub-graphs have the same parents by then.
+ */
+bool HaveSameParents(OperatorIR* a, OperatorIR* b) {
+  if (a->parents().size() != b->parents().size()) {
+    return false;
+  }
+  for (const auto& [idx, parent] : Enumerate(a->parents())) {
+    if (SkipNoOpMaps(parent) != SkipNoOpMaps(b->parents()[idx])) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
   if (a->type() != b->type()) {
     return false;
@@ -162,7 +194,22 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
       return false;
     }
 
-    return src_a->table_name() == src_b->table_name();
+    return src_a->table_name() == src_b->table_name() &&
+           src_a->sample_fraction() == src_b->sample_fraction() &&
+           src_a->streaming() == src_b->streaming();
+  } else if (Match(a, UDTFSource())) {
+    auto udtf_a = static_cast<UDTFSourceIR*>(a);
+    auto udtf_b = static_cast<UDTFSourceIR*>(b);
+    if (udtf_a->func_name() != udtf_b->func_name() ||
+        udtf_a->arg_values().size() != udtf_b->arg_values().size()) {
+      return false;
+    }
+    for (const auto& [idx, arg] : Enumerate(udtf_a->arg_values())) {
+      if (!arg->Equals(udtf_b->arg_values()[idx])) {
+        return false;
+      }
+    }
+    return true;
   } else if (Match(a, Map())) {
     auto map_a = static_cast<MapIR*>(a);
     auto map_b = static_cast<MapIR*>(b);
@@ -170,6 +217,11 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
   } else if (Match(a, BlockingAgg())) {
     auto agg_a = static_cast<BlockingAggIR*>(a);
     auto agg_b = static_cast<BlockingAggIR*>(b);
+    // Merged aggs are resolved again from their expressions, which aggs that read packed
+    // partials can't be.
+    if (agg_a->partial_input() || agg_b->partial_input()) {
+      return false;
+    }
     // Are the groups equal?
     if (!CompareColumns(agg_a->groups(), agg_b->groups())) {
       return false;
@@ -178,6 +230,10 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
   } else if (Match(a, Join())) {
     auto join_a = static_cast<JoinIR*>(a);
     auto join_b = static_cast<JoinIR*>(b);
+    // Joins of different inputs can have the same columns, so the inputs must match as well.
+    if (!HaveSameParents(a, b)) {
+      return false;
+    }
     if (join_a->join_type() != join_b->join_type()) {
       return false;
     }
@@ -193,7 +249,17 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
     if (!EqualStringVector(join_a->suffix_strs(), join_b->suffix_strs())) {
       return false;
     }
+    if (join_a->as_of() != join_b->as_of()) {
+      return false;
+    }
+    if (join_a->as_of()) {
+      return join_a->as_of_tolerance_ns() == join_b->as_of_tolerance_ns() &&
+             CompareColumns({join_a->left_time_column(), join_a->right_time_column()},
+                            {join_b->left_time_column(), join_b->right_time_column()});
+    }
     return true;
+  } else if (Match(a, Union())) {
+    return HaveSameParents(a, b) && a->resolved_table_type()->Equals(b->resolved_table_type());
   } else if (Match(a, Filter())) {
     auto filter_a = static_cast<FilterIR*>(a);
     auto filter_b = static_cast<FilterIR*>(b);
@@ -211,6 +277,8 @@ bool MergeNodesRule::CanMerge(OperatorIR* a, OperatorIR* b) {
     DCHECK_EQ(1, a->parents().size());
     DCHECK_EQ(1, b->parents().size());
     return limit_a->limit_value() == limit_b->limit_value() &&
+           limit_a->sort_columns() == limit_b->sort_columns() &&
+           limit_a->sort_ascending() == limit_b->sort_ascending() &&
            a->parents()[0]->resolved_table_type()->Equals(b->parents()[0]->resolved_table_type());
   }
   VLOG(1) << "Can't match, so excluding from merge." << a->DebugString();
@@ -325,7 +393,7 @@ StatusOr<OperatorIR*> MergeNodesRule::MergeOps(IR* graph,
         columns.push_back(col);
         column_idx_map.push_back(other_src->column_index_map()[idx]);
       }
-      time_not_set |= !base_src->IsTimeSet();
+      time_not_set |= !other_src->IsTimeSet();
 
       if (!time_not_set) {
         start_time = std::min(other_src->time_start_ns(), start_time);
@@ -344,7 +412,11 @@ StatusOr<OperatorIR*> MergeNodesRule::MergeOps(IR* graph,
     ResolveTypesRule rule(compiler_state_);
     PL_RETURN_IF_ERROR(rule.Apply(new_src));
     return new_src;
-
+  } else if (Match(base_op, UDTFSource())) {
+    // The copy keeps the type of the UDTF, which is set from its spec rather than resolved.
+    PL_ASSIGN_OR_RETURN(UDTFSourceIR * new_udtf,
+                        graph->CopyNode(static_cast<UDTFSourceIR*>(base_op)));
+    return new_udtf;
   } else if (Match(base_op, Map())) {
     // TODO(philkuz) support Map operators where out_column_names conflict.
     auto base_map = static_cast<MapIR*>(base_op);
@@ -389,6 +461,11 @@ StatusOr<OperatorIR*> MergeNodesRule::MergeOps(IR* graph,
     PL_ASSIGN_OR_RETURN(JoinIR * new_join, graph->CopyNode(join));
     PL_RETURN_IF_ERROR(new_join->CopyParentsFrom(join));
     merged_op = new_join;
+  } else if (Match(base_op, Union())) {
+    UnionIR* union_op = static_cast<UnionIR*>(base_op);
+    PL_ASSIGN_OR_RETURN(UnionIR * new_union, graph->CopyNode(union_op));
+    PL_RETURN_IF_ERROR(new_union->CopyParentsFrom(union_op));
+    merged_op = new_union;
   } else if (Match(base_op, Filter())) {
     FilterIR* filter = static_cast<FilterIR*>(base_op);
     PL_ASSIGN_OR_RETURN(FilterIR * new_filter, graph->CopyNode(filter));
@@ -479,6 +556,9 @@ StatusOr<bool> MergeNodesRule::Execute(IR* graph) {
   for (IRNode* src : graph->FindNodesThatMatch(MemorySource())) {
     srcs.push_back(static_cast<MemorySourceIR*>(src));
   }
+  for (IRNode* src : graph->FindNodesThatMatch(UDTFSource())) {
+    srcs.push_back(static_cast<UDTFSourceIR*>(src));
+  }
 
   // matching_set_q is the queue of matching sets to merge together.
   std::queue<MatchingSet> matching_set_q;
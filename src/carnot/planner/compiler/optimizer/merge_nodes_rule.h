@@ -40,6 +40,9 @@ struct MatchingSet {
  * multiple sources, meaning query writers are more free in composing functions together without
  * worrying too much about optimization.
  *
+ * Sub-graphs start at memory sources or UDTF sources, such as the px.GetAgentStatus() calls
+ * repeated across the widgets of a script, and operators with several parents only merge when
+ * they read from the same merged parents.
  */
 class MergeNodesRule : public Rule {
  public:
@@ -49,7 +52,7 @@ class MergeNodesRule : public Rule {
   /**
    * @brief The entry method that merges nodes within the graph together.
    *
-   * The high level algorithm starts by finding matching sets of memory sources.  A matching set is
+   * The high level algorithm starts by finding matching sets of sources.  A matching set is
    * all operators that can be merged into one. We insert the matching sets  into a queue. We read a
    * matching set from that queue, create a single "merged" operator for that matching set and
    * replace operators with the new merged one.
@@ -268,6 +268,57 @@ TEST_F(MergeNodesTest, limit_merge_different_relations_shouldnt_merge) {
   EXPECT_FALSE(rule.CanMerge(limit1, limit2));
 }
 
+TEST_F(MergeNodesTest, streaming_and_batch_memory_sources_shouldnt_merge) {
+  auto mem_src1 = MakeMemSource("cpu", cpu_relation);
+  auto mem_src2 = MakeMemSource("cpu", cpu_relation);
+  mem_src2->set_streaming(true);
+
+  MergeNodesRule rule(compiler_state_.get());
+  EXPECT_FALSE(rule.CanMerge(mem_src1, mem_src2));
+}
+
+TEST_F(MergeNodesTest, joins_of_different_inputs_shouldnt_merge) {
+  auto left = MakeMemSource("cpu", cpu_relation);
+  auto right1 = MakeMemSource("cpu", cpu_relation);
+  right1->SetTimeValuesNS(10, 100);
+  auto right2 = MakeMemSource("cpu", cpu_relation);
+  right2->SetTimeValuesNS(20, 200);
+  auto join1 = MakeJoin({left, right1}, "inner", cpu_relation, cpu_relation, {"upid"}, {"upid"});
+  auto join2 = MakeJoin({left, right1}, "inner", cpu_relation, cpu_relation, {"upid"}, {"upid"});
+  auto join3 = MakeJoin({left, right2}, "inner", cpu_relation, cpu_relation, {"upid"}, {"upid"});
+
+  MergeNodesRule rule(compiler_state_.get());
+  EXPECT_TRUE(rule.CanMerge(join1, join2));
+  EXPECT_FALSE(rule.CanMerge(join1, join3));
+}
+
+TEST_F(MergeNodesTest, merge_udtf_sources) {
+  udfspb::UDTFSourceSpec udtf_spec;
+  udtf_spec.set_name("GetAgentStatus");
+  udtf_spec.set_executor(udfspb::UDTF_ALL_AGENTS);
+  Relation rel({types::INT64, types::STRING}, {"asid", "hostname"});
+  ASSERT_OK(rel.ToProto(udtf_spec.mutable_relation()));
+  udfspb::UDTFSourceSpec other_udtf_spec = udtf_spec;
+  other_udtf_spec.set_name("GetSchemas");
+
+  auto udtf1 = MakeUDTFSource(udtf_spec, {}, {});
+  auto udtf2 = MakeUDTFSource(udtf_spec, {}, {});
+  auto udtf3 = MakeUDTFSource(other_udtf_spec, {}, {});
+  MakeMemSink(udtf1, "1");
+  MakeMemSink(udtf2, "2");
+  MakeMemSink(udtf3, "3");
+
+  MergeNodesRule rule(compiler_state_.get());
+  EXPECT_TRUE(rule.CanMerge(udtf1, udtf2));
+  EXPECT_FALSE(rule.CanMerge(udtf1, udtf3));
+
+  auto result = rule.Execute(graph.get());
+  ASSERT_OK(result);
+  EXPECT_TRUE(result.ConsumeValueOrDie());
+  EXPECT_EQ(graph->FindNodesThatMatch(UDTFSource()).size(), 2);
+  EXPECT_EQ(graph->FindNodesThatMatch(MemorySink()).size(), 3);
+}
+
 }  // namespace compiler
 }  // namespace planner
 }  // namespace carnot
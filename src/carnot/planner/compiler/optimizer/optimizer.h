@@ -23,6 +23,8 @@
 #include <unordered_set>
 #include <vector>
 
+#include "src/carnot/planner/compiler/optimizer/eliminate_common_subexpressions_rule.h"
+#include "src/carnot/planner/compiler/optimizer/fold_constants_rule.h"
 #include "src/carnot/planner/compiler/optimizer/merge_nodes_rule.h"
 #include "src/carnot/planner/compiler/optimizer/prune_unconnected_operators_rule.h"
 #include "src/carnot/planner/compiler/optimizer/prune_unused_columns_rule.h"
@@ -57,6 +59,12 @@ class Optimizer : public RuleExecutor<IR> {
     merge_nodes_batch->AddRule<MergeNodesRule>(compiler_state_);
   }
 
+  void CreateSimplifyExpressionsBatch() {
+    RuleBatch* simplify_expressions = CreateRuleBatch<TryUntilMax>("SimplifyExpressions", 10);
+    simplify_expressions->AddRule<FoldConstantsRule>(compiler_state_);
+    simplify_expressions->AddRule<EliminateCommonSubexpressionsRule>(compiler_state_);
+  }
+
   void CreatePruneUnusedColumnsBatch() {
     RuleBatch* prune_unused_columns = CreateRuleBatch<FailOnMax>("PruneUnusedColumns", 2);
     prune_unused_columns->AddRule<PruneUnusedColumnsRule>();
@@ -65,6 +73,7 @@ class Optimizer : public RuleExecutor<IR> {
   Status Init() {
     CreatePruneUnconnectedOpsBatch();
     CreateMergeNodesBatch();
+    CreateSimplifyExpressionsBatch();
     CreatePruneUnusedColumnsBatch();
     return Status::OK();
   }
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "src/carnot/planner/compiler_state/registry_info.h"
+#include "src/carnot/planner/rollup/rollup.h"
 
 #include "src/common/base/base.h"
 #include "src/shared/types/types.h"
@@ -96,15 +97,17 @@ class CompilerState : public NotCopyable {
   /**
    * CompilerState manages the state needed to compile a single query. A new one will
    * be constructed for every query compiled in Carnot and it will not be reused.
+   * The relation map may be shared with the compiler states of other queries, so it must not be
+   * modified.
    */
-  CompilerState(std::unique_ptr<RelationMap> relation_map, RegistryInfo* registry_info,
+  CompilerState(std::shared_ptr<RelationMap> relation_map, RegistryInfo* registry_info,
                 types::Time64NSValue time_now, std::string_view result_address,
                 std::string_view result_ssl_targetname = "")
       : CompilerState(std::move(relation_map), {}, registry_info, time_now,
                       /* max_output_rows_per_table */ 0, result_address, result_ssl_targetname,
                       RedactionOptions{}) {}
 
-  CompilerState(std::unique_ptr<RelationMap> relation_map,
+  CompilerState(std::shared_ptr<RelationMap> relation_map,
                 const SensitiveColumnMap& table_names_to_sensitive_columns,
                 RegistryInfo* registry_info, types::Time64NSValue time_now,
                 int64_t max_output_rows_per_table, std::string_view result_address,
@@ -158,8 +161,28 @@ class CompilerState : public NotCopyable {
   const RedactionOptions& redaction_options() { return redaction_options_; }
   void set_redaction_options(const RedactionOptions& options) { redaction_options_ = options; }
 
+  /**
+   * Records a memory source time that was computed as an offset from time_now. The plan cache
+   * shifts these times when it reuses the plan at a later time.
+   */
+  void RecordRelativeTime(int64_t time) { relative_times_.insert(time); }
+  const absl::flat_hash_set<int64_t>& relative_times() const { return relative_times_; }
+
+  /**
+   * Marks that time_now was used in a way that the plan cache can't rebind, ie. px.now(), so the
+   * plan must not be reused.
+   */
+  void MarkTimeDependent() { time_dependent_ = true; }
+  bool time_dependent() const { return time_dependent_; }
+
+  /**
+   * The rollup tables that matching aggregates can be answered from, see UseRollupTablesRule.
+   */
+  void set_rollups(std::vector<RollupDefinition> rollups) { rollups_ = std::move(rollups); }
+  const std::vector<RollupDefinition>& rollups() const { return rollups_; }
+
  private:
-  std::unique_ptr<RelationMap> relation_map_;
+  std::shared_ptr<RelationMap> relation_map_;
   SensitiveColumnMap table_names_to_sensitive_columns_;
   RegistryInfo* registry_info_;
   types::Time64NSValue time_now_;
@@ -170,6 +193,10 @@ class CompilerState : public NotCopyable {
   const std::string result_address_;
   const std::string result_ssl_targetname_;
   RedactionOptions redaction_options_;
+
+  absl::flat_hash_set<int64_t> relative_times_;
+  bool time_dependent_ = false;
+  std::vector<RollupDefinition> rollups_;
 };
 
 }  // namespace planner
@@ -50,15 +50,34 @@ StatusOr<types::DataType> RegistryInfo::ResolveUDFSubType<types::DataType>(
 template <>
 StatusOr<types::SemanticType> RegistryInfo::ResolveUDFSubType<types::SemanticType>(
     std::string name, std::vector<types::SemanticType> arg_types) {
+  return ResolveSemanticType(name, arg_types);
+}
+
+types::SemanticType RegistryInfo::ResolveSemanticType(
+    const std::string& name, const std::vector<types::SemanticType>& arg_types) {
+  auto key = std::make_pair(name, arg_types);
+  auto it = semantic_type_cache_.find(key);
+  if (it != semantic_type_cache_.end()) {
+    return it->second;
+  }
   auto type_or_s = semantic_rule_registry_.Lookup(name, arg_types);
-  if (!type_or_s.ok()) {
-    return types::ST_NONE;
+  types::SemanticType type = type_or_s.ok() ? type_or_s.ConsumeValueOrDie() : types::ST_NONE;
+  semantic_type_cache_.emplace(std::move(key), type);
+  return type;
+}
+
+void RegistryInfo::AddFunc(RegistryKey key, const FuncInfo& info) {
+  auto [it, inserted] = func_ids_.try_emplace(std::move(key), func_infos_.size());
+  if (inserted) {
+    func_infos_.push_back(info);
+  } else {
+    func_infos_[it->second] = info;
   }
-  return type_or_s.ConsumeValueOrDie();
 }
 
 Status RegistryInfo::Init(const udfspb::UDFInfo& info) {
   info_pb_ = info;
+  semantic_type_cache_.clear();
   for (const auto& uda : info.udas()) {
     std::vector<types::DataType> arg_types;
     arg_types.reserve(uda.init_arg_types_size() + uda.update_arg_types_size());
@@ -69,10 +88,11 @@ Status RegistryInfo::Init(const udfspb::UDFInfo& info) {
     for (int64_t i = 0; i < uda.update_arg_types_size(); i++) {
       arg_types.push_back(uda.update_arg_types(i));
     }
-    auto key = RegistryKey(uda.name(), arg_types);
-    uda_map_[key] = uda.finalize_type();
-    uda_supports_partial_map_[key] = uda.supports_partial();
-    num_init_args_map_[key] = uda.init_arg_types_size();
+    AddFunc(RegistryKey(uda.name(), arg_types),
+            FuncInfo{.exec_type = UDFExecType::kUDA,
+                     .return_type = uda.finalize_type(),
+                     .num_init_args = static_cast<size_t>(uda.init_arg_types_size()),
+                     .supports_partial = uda.supports_partial()});
     // Add uda to funcs_.
     if (funcs_.contains(uda.name())) {
       PL_ASSIGN_OR_RETURN(auto type, GetUDFExecType(uda.name()));
@@ -92,10 +112,11 @@ Status RegistryInfo::Init(const udfspb::UDFInfo& info) {
       arg_types.push_back(udf.exec_arg_types(i));
     }
 
-    auto key = RegistryKey(udf.name(), arg_types);
-    udf_map_[key] = udf.return_type();
-    udf_executor_map_[key] = udf.executor();
-    num_init_args_map_[key] = udf.init_arg_types_size();
+    AddFunc(RegistryKey(udf.name(), arg_types),
+            FuncInfo{.exec_type = UDFExecType::kUDF,
+                     .return_type = udf.return_type(),
+                     .executor = udf.executor(),
+                     .num_init_args = static_cast<size_t>(udf.init_arg_types_size())});
 
     // Add udf to funcs_.
     if (funcs_.contains(udf.name())) {
@@ -131,24 +152,34 @@ absl::flat_hash_set<std::string> RegistryInfo::func_names() const {
   return func_names;
 }
 
+const RegistryInfo::FuncInfo* RegistryInfo::FindFunc(
+    const std::string& name, const std::vector<types::DataType>& arg_types,
+    UDFExecType exec_type) const {
+  auto it = func_ids_.find(RegistryKey(name, arg_types));
+  if (it == func_ids_.end() || func_infos_[it->second].exec_type != exec_type) {
+    return nullptr;
+  }
+  return &func_infos_[it->second];
+}
+
 StatusOr<types::DataType> RegistryInfo::GetUDADataType(
     std::string name, std::vector<types::DataType> update_arg_types) {
-  auto uda = uda_map_.find(RegistryKey(name, update_arg_types));
-  if (uda == uda_map_.end()) {
+  const FuncInfo* uda = FindFunc(name, update_arg_types, UDFExecType::kUDA);
+  if (uda == nullptr) {
     return error::InvalidArgument("Could not find UDA '$0' with update arg types [$1].", name,
                                   absl::StrJoin(update_arg_types, ","));
   }
-  return uda->second;
+  return uda->return_type;
 }
 
 StatusOr<bool> RegistryInfo::DoesUDASupportPartial(std::string name,
                                                    std::vector<types::DataType> update_arg_types) {
-  auto uda = uda_supports_partial_map_.find(RegistryKey(name, update_arg_types));
-  if (uda == uda_supports_partial_map_.end()) {
+  const FuncInfo* uda = FindFunc(name, update_arg_types, UDFExecType::kUDA);
+  if (uda == nullptr) {
     return error::InvalidArgument("Could not find UDA '$0' with update arg types [$1].", name,
                                   absl::StrJoin(update_arg_types, ","));
   }
-  return uda->second;
+  return uda->supports_partial;
 }
 
 Status FormatMissingUDFError(std::string name, std::vector<types::DataType> exec_arg_types) {
@@ -162,20 +193,29 @@ Status FormatMissingUDFError(std::string name, std::vector<types::DataType> exec
 
 StatusOr<types::DataType> RegistryInfo::GetUDFDataType(
     std::string name, std::vector<types::DataType> exec_arg_types) {
-  auto udf = udf_map_.find(RegistryKey(name, exec_arg_types));
-  if (udf == udf_map_.end()) {
+  const FuncInfo* udf = FindFunc(name, exec_arg_types, UDFExecType::kUDF);
+  if (udf == nullptr) {
     return FormatMissingUDFError(name, exec_arg_types);
   }
-  return udf->second;
+  return udf->return_type;
 }
 
 StatusOr<udfspb::UDFSourceExecutor> RegistryInfo::GetUDFSourceExecutor(
     std::string name, std::vector<types::DataType> exec_arg_types) {
-  auto udf = udf_executor_map_.find(RegistryKey(name, exec_arg_types));
-  if (udf == udf_executor_map_.end()) {
+  const FuncInfo* udf = FindFunc(name, exec_arg_types, UDFExecType::kUDF);
+  if (udf == nullptr) {
     return FormatMissingUDFError(name, exec_arg_types);
   }
-  return udf->second;
+  return udf->executor;
+}
+
+StatusOr<RegistryInfo::FuncID> RegistryInfo::GetFuncID(
+    std::string_view name, const std::vector<types::DataType>& arg_types) const {
+  auto it = func_ids_.find(RegistryKey(std::string(name), arg_types));
+  if (it == func_ids_.end()) {
+    return FormatMissingUDFError(std::string(name), arg_types);
+  }
+  return it->second;
 }
 
 StatusOr<std::shared_ptr<ValueType>> RegistryInfo::ResolveUDFType(
@@ -191,13 +231,21 @@ StatusOr<std::shared_ptr<ValueType>> RegistryInfo::ResolveUDFType(
   return ValueType::Create(out_data_type, out_semantic_type);
 }
 
+StatusOr<std::shared_ptr<ValueType>> RegistryInfo::ResolveUDFType(
+    FuncID id, const std::string& name, const std::vector<std::shared_ptr<ValueType>>& arg_types) {
+  std::vector<types::SemanticType> arg_semantic_types;
+  arg_semantic_types.reserve(arg_types.size());
+  for (const auto& basic_type : arg_types) {
+    arg_semantic_types.push_back(basic_type->semantic_type());
+  }
+  return ValueType::Create(func_info(id).return_type,
+                           ResolveSemanticType(name, arg_semantic_types));
+}
+
 StatusOr<size_t> RegistryInfo::GetNumInitArgs(std::string name,
                                               const std::vector<types::DataType>& arg_types) {
-  auto it = num_init_args_map_.find(RegistryKey(name, arg_types));
-  if (it == num_init_args_map_.end()) {
-    return FormatMissingUDFError(name, arg_types);
-  }
-  return it->second;
+  PL_ASSIGN_OR_RETURN(FuncID id, GetFuncID(name, arg_types));
+  return func_info(id).num_init_args;
 }
 
 void RegistryInfo::AddSemanticInferenceRule(const udfspb::SemanticInferenceRule& rule) {
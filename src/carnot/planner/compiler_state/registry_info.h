@@ -21,6 +21,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -73,6 +74,15 @@ class RegistryKey {
     return name_ < lhs.name_;
   }
 
+  bool operator==(const RegistryKey& other) const {
+    return name_ == other.name_ && registry_arg_types_ == other.registry_arg_types_;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const RegistryKey& key) {
+    return H::combine(std::move(h), key.name_, key.registry_arg_types_);
+  }
+
  protected:
   std::string name_;
   std::vector<types::DataType> registry_arg_types_;
@@ -122,7 +132,34 @@ class SemanticRuleRegistry {
 
 class RegistryInfo {
  public:
+  /**
+   * FuncID identifies one overload of a UDF/UDA in the registry. IDs are dense, and stay the same
+   * when Init() is called again with more functions.
+   */
+  using FuncID = int64_t;
+
+  /**
+   * FuncInfo is what the registry knows of one overload of a UDF/UDA.
+   */
+  struct FuncInfo {
+    UDFExecType exec_type;
+    // The return type of a UDF, or the finalize type of a UDA.
+    types::DataType return_type;
+    udfspb::UDFSourceExecutor executor = udfspb::UDF_ALL;
+    size_t num_init_args = 0;
+    bool supports_partial = false;
+  };
+
   Status Init(const udfspb::UDFInfo& info);
+
+  /**
+   * Looks up the overload of the UDF/UDA with the given registry arg types, for callers that
+   * resolve the same function call repeatedly.
+   */
+  StatusOr<FuncID> GetFuncID(std::string_view name,
+                             const std::vector<types::DataType>& arg_types) const;
+  const FuncInfo& func_info(FuncID id) const { return func_infos_[id]; }
+
   StatusOr<types::DataType> GetUDADataType(std::string name,
                                            std::vector<types::DataType> arg_types);
   StatusOr<types::DataType> GetUDFDataType(std::string name,
@@ -154,6 +191,12 @@ class RegistryInfo {
   StatusOr<std::shared_ptr<ValueType>> ResolveUDFType(
       std::string name, const std::vector<std::shared_ptr<ValueType>>& arg_types);
 
+  /**
+   * Same as above, for the overload of the function that was already looked up with GetFuncID().
+   */
+  StatusOr<std::shared_ptr<ValueType>> ResolveUDFType(
+      FuncID id, const std::string& name, const std::vector<std::shared_ptr<ValueType>>& arg_types);
+
   template <typename TType>
   StatusOr<TType> ResolveUDFSubType(std::string name, std::vector<TType> arg_types);
 
@@ -161,15 +204,16 @@ class RegistryInfo {
 
  protected:
   void AddSemanticInferenceRule(const udfspb::SemanticInferenceRule& rule);
-
-  std::map<RegistryKey, types::DataType> udf_map_;
-  std::map<RegistryKey, types::DataType> uda_map_;
-  std::map<RegistryKey, udfspb::UDFSourceExecutor> udf_executor_map_;
-
-  std::map<RegistryKey, size_t> num_init_args_map_;
-
-  // Allocated as a separate map because this is a temporary solution.
-  std::map<RegistryKey, bool> uda_supports_partial_map_;
+  void AddFunc(RegistryKey key, const FuncInfo& info);
+  // Returns the info of the overload, if it is of the given exec type.
+  const FuncInfo* FindFunc(const std::string& name, const std::vector<types::DataType>& arg_types,
+                           UDFExecType exec_type) const;
+  types::SemanticType ResolveSemanticType(const std::string& name,
+                                          const std::vector<types::SemanticType>& arg_types);
+
+  // The UDF/UDA overloads, indexed by FuncID.
+  absl::flat_hash_map<RegistryKey, FuncID> func_ids_;
+  std::vector<FuncInfo> func_infos_;
   // Union of udf and uda names.
   absl::flat_hash_map<std::string, UDFExecType> funcs_;
   // The vector containing udtfs.
@@ -178,6 +222,11 @@ class RegistryInfo {
   udfspb::UDFInfo info_pb_;
 
   SemanticRuleRegistry semantic_rule_registry_;
+  // Memoizes the lookups in semantic_rule_registry_, which are repeated for every call of the same
+  // function with the same semantic types.
+  absl::flat_hash_map<std::pair<std::string, std::vector<types::SemanticType>>,
+                      types::SemanticType>
+      semantic_type_cache_;
 };
 
 }  // namespace planner
@@ -208,6 +208,57 @@ TEST(RegistryInfo, supports_partial) {
                    false);
 }
 
+TEST(RegistryInfo, func_ids) {
+  auto info = RegistryInfo();
+  udfspb::UDFInfo info_pb;
+  google::protobuf::TextFormat::MergeFromString(kExpectedUDFInfo, &info_pb);
+  EXPECT_OK(info.Init(info_pb));
+
+  ASSERT_OK_AND_ASSIGN(RegistryInfo::FuncID add_id,
+                       info.GetFuncID("add", {types::FLOAT64, types::FLOAT64}));
+  ASSERT_OK_AND_ASSIGN(RegistryInfo::FuncID uda_id, info.GetFuncID("uda1", {types::INT64}));
+  EXPECT_NE(add_id, uda_id);
+  EXPECT_NOT_OK(info.GetFuncID("add", {types::INT64, types::INT64}));
+
+  EXPECT_EQ(UDFExecType::kUDF, info.func_info(add_id).exec_type);
+  EXPECT_EQ(types::FLOAT64, info.func_info(add_id).return_type);
+  EXPECT_EQ(UDFExecType::kUDA, info.func_info(uda_id).exec_type);
+  EXPECT_TRUE(info.func_info(uda_id).supports_partial);
+
+  EXPECT_OK_AND_PTR_VAL_EQ(
+      info.ResolveUDFType(add_id, "add",
+                          {ValueType::Create(types::FLOAT64, types::ST_BYTES),
+                           ValueType::Create(types::FLOAT64, types::ST_BYTES)}),
+      ValueType::Create(types::FLOAT64, types::ST_BYTES));
+  EXPECT_OK_AND_PTR_VAL_EQ(
+      info.ResolveUDFType(add_id, "add",
+                          {ValueType::Create(types::FLOAT64, types::ST_NONE),
+                           ValueType::Create(types::FLOAT64, types::ST_NONE)}),
+      ValueType::Create(types::FLOAT64, types::ST_NONE));
+
+  // Initializing again with more functions keeps the IDs, and drops the memoized semantic types.
+  auto udf = info_pb.add_scalar_udfs();
+  udf->set_name("add");
+  udf->add_exec_arg_types(types::INT64);
+  udf->add_exec_arg_types(types::INT64);
+  udf->set_return_type(types::INT64);
+  auto rule = info_pb.add_semantic_type_rules();
+  rule->set_name("add");
+  rule->set_udf_exec_type(udfspb::SCALAR_UDF);
+  rule->add_exec_arg_types(types::ST_NONE);
+  rule->add_exec_arg_types(types::ST_NONE);
+  rule->set_output_type(types::ST_DURATION_NS);
+  EXPECT_OK(info.Init(info_pb));
+
+  EXPECT_OK_AND_EQ(info.GetFuncID("add", {types::FLOAT64, types::FLOAT64}), add_id);
+  EXPECT_OK(info.GetFuncID("add", {types::INT64, types::INT64}));
+  EXPECT_OK_AND_PTR_VAL_EQ(
+      info.ResolveUDFType(add_id, "add",
+                          {ValueType::Create(types::FLOAT64, types::ST_NONE),
+                           ValueType::Create(types::FLOAT64, types::ST_NONE)}),
+      ValueType::Create(types::FLOAT64, types::ST_DURATION_NS));
+}
+
 TEST(SemanticRuleRegistry, semantic_lookup) {
   std::vector<types::SemanticType> arg_types1({types::ST_NONE, types::ST_NONE, types::ST_BYTES});
   std::vector<types::SemanticType> arg_types2({types::ST_UPID, types::ST_NONE, types::ST_BYTES});
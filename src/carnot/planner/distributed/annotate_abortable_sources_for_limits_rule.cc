@@ -31,6 +31,10 @@ StatusOr<bool> AnnotateAbortableSourcesForLimitsRule::Apply(IRNode* node) {
   }
   IR* graph = node->graph();
   auto limit = static_cast<LimitIR*>(node);
+  // Ordered limits have to see every input row, so they can't stop their sources early.
+  if (limit->is_ordered()) {
+    return false;
+  }
 
   plan::DAG dag_copy = graph->dag();
   dag_copy.DeleteNode(limit->id());
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <numeric>
 #include <queue>
 #include <string>
 #include <unordered_set>
@@ -29,6 +30,8 @@
 #include "src/carnot/planner/distributed/coordinator/prune_unavailable_sources_rule.h"
 #include "src/carnot/planner/distributed/coordinator/removable_ops_rule.h"
 #include "src/carnot/planner/distributed/splitter/splitter.h"
+#include "src/carnot/planner/ir/grpc_source_group_ir.h"
+#include "src/carnot/planner/ir/join_ir.h"
 #include "src/carnot/planner/rules/rules.h"
 #include "src/carnot/udfspb/udfs.pb.h"
 #include "src/common/uuid/uuid.h"
@@ -236,10 +239,427 @@ StatusOr<SchemaToAgentsMap> LoadSchemaMap(
   return agent_schema_map;
 }
 
+Status CoordinatorImpl::AddAggMergeTree(DistributedPlan* distributed_plan, CarnotInstance* kelvin) {
+  int64_t fan_in = distributed_state_->max_agg_merge_fan_in();
+  std::vector<int64_t> level = distributed_plan->dag().ParentsOf(kelvin->id());
+  if (fan_in <= 0 || static_cast<int64_t>(level.size()) <= fan_in) {
+    return Status::OK();
+  }
+
+  // The tree only replaces the bridge into a finalizing aggregate. Any other bridge into the Kelvin
+  // would lose its senders once the PEMs send to the merge nodes instead.
+  IR* kelvin_plan = kelvin->plan();
+  auto source_groups = kelvin_plan->FindNodesOfType(IRNodeType::kGRPCSourceGroup);
+  if (source_groups.size() != 1) {
+    return Status::OK();
+  }
+  for (IRNode* node : kelvin_plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+    if (static_cast<GRPCSinkIR*>(node)->has_destination_id()) {
+      return Status::OK();
+    }
+  }
+  auto source_group = static_cast<GRPCSourceGroupIR*>(source_groups[0]);
+  auto children = source_group->Children();
+  if (children.size() != 1 || !Match(children[0], FinalizeAgg())) {
+    return Status::OK();
+  }
+  auto finalize_agg = static_cast<BlockingAggIR*>(children[0]);
+
+  std::vector<const CarnotInfo*> spare_kelvins;
+  for (const auto& info : remote_processor_nodes_) {
+    if (&info != &GetRemoteProcessor() && !info.has_data_store()) {
+      spare_kelvins.push_back(&info);
+    }
+  }
+
+  int64_t bridge_id = source_group->source_id();
+  size_t next_spare = 0;
+  while (static_cast<int64_t>(level.size()) > fan_in) {
+    int64_t num_merge_nodes = std::min<int64_t>((level.size() + fan_in - 1) / fan_in,
+                                                spare_kelvins.size() - next_spare);
+    // A single merge node would merge as many partials as the Kelvin does.
+    if (num_merge_nodes < 2) {
+      break;
+    }
+    int64_t merged_bridge_id = bridge_id + 1;
+    std::vector<int64_t> next_level;
+    for (int64_t i = 0; i < num_merge_nodes; ++i) {
+      PL_ASSIGN_OR_RETURN(int64_t merge_node_id,
+                          distributed_plan->AddCarnot(*spare_kelvins[next_spare++]));
+      CarnotInstance* merge_node = distributed_plan->Get(merge_node_id);
+
+      auto merge_plan_uptr = std::make_unique<IR>();
+      IR* merge_plan = merge_plan_uptr.get();
+      PL_ASSIGN_OR_RETURN(auto merge_source, merge_plan->CreateNode<GRPCSourceGroupIR>(
+                                                 source_group->ast(), bridge_id,
+                                                 source_group->resolved_type()));
+      PL_ASSIGN_OR_RETURN(BlockingAggIR * merge_agg, merge_plan->CopyNode(finalize_agg));
+      PL_RETURN_IF_ERROR(merge_agg->AddParent(merge_source));
+      merge_agg->SetPartialAgg(true);
+      merge_agg->SetFinalizeResults(false);
+      merge_agg->SetMergePartials(true);
+      PL_RETURN_IF_ERROR(merge_agg->SetResolvedType(source_group->resolved_type()));
+      PL_ASSIGN_OR_RETURN(GRPCSinkIR * merge_sink,
+                          merge_plan->CreateNode<GRPCSinkIR>(source_group->ast(), merge_agg,
+                                                             merged_bridge_id));
+      PL_RETURN_IF_ERROR(merge_sink->SetResolvedType(source_group->resolved_type()));
+
+      merge_node->AddPlan(merge_plan);
+      distributed_plan->AddPlan(std::move(merge_plan_uptr));
+      distributed_plan->AddMergeNode(merge_node);
+      distributed_plan->AddEdge(merge_node_id, kelvin->id());
+      next_level.push_back(merge_node_id);
+    }
+    // Split the current level into contiguous runs, one per merge node.
+    for (const auto& [i, node_id] : Enumerate(level)) {
+      distributed_plan->DeleteEdge(node_id, kelvin->id());
+      distributed_plan->AddEdge(node_id, next_level[i * num_merge_nodes / level.size()]);
+    }
+    source_group->SetSourceID(merged_bridge_id);
+    bridge_id = merged_bridge_id;
+    level = std::move(next_level);
+  }
+  return Status::OK();
+}
+
+Status CoordinatorImpl::AddAggShuffle(DistributedPlan* distributed_plan, CarnotInstance* kelvin) {
+  int64_t num_partitions = distributed_state_->num_agg_shuffle_partitions();
+  if (num_partitions < 2) {
+    return Status::OK();
+  }
+
+  // Same as the merge tree, only the bridge into a finalizing aggregate can be shuffled.
+  IR* kelvin_plan = kelvin->plan();
+  auto source_groups = kelvin_plan->FindNodesOfType(IRNodeType::kGRPCSourceGroup);
+  if (source_groups.size() != 1) {
+    return Status::OK();
+  }
+  for (IRNode* node : kelvin_plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+    if (static_cast<GRPCSinkIR*>(node)->has_destination_id()) {
+      return Status::OK();
+    }
+  }
+  auto source_group = static_cast<GRPCSourceGroupIR*>(source_groups[0]);
+  auto children = source_group->Children();
+  if (children.size() != 1 || !Match(children[0], FinalizeAgg())) {
+    return Status::OK();
+  }
+  auto finalize_agg = static_cast<BlockingAggIR*>(children[0]);
+  // Without groups every partial would hash to the same partition.
+  if (finalize_agg->groups().empty()) {
+    return Status::OK();
+  }
+
+  std::vector<const CarnotInfo*> spare_kelvins;
+  for (const auto& info : remote_processor_nodes_) {
+    if (&info != &GetRemoteProcessor() && !info.has_data_store()) {
+      spare_kelvins.push_back(&info);
+    }
+  }
+  num_partitions = std::min<int64_t>(num_partitions, spare_kelvins.size());
+  if (num_partitions < 2) {
+    return Status::OK();
+  }
+
+  // The partial aggregates start with the group columns.
+  std::vector<int64_t> group_columns(finalize_agg->groups().size());
+  std::iota(group_columns.begin(), group_columns.end(), 0);
+
+  // Each PEM sink is replaced by a sink per partition. PEMs can share a plan, so every unique plan
+  // is only partitioned once.
+  int64_t bridge_id = source_group->source_id();
+  std::vector<int64_t> pems = distributed_plan->dag().ParentsOf(kelvin->id());
+  absl::flat_hash_set<IR*> partitioned_plans;
+  for (int64_t pem : pems) {
+    IR* pem_plan = distributed_plan->Get(pem)->plan();
+    if (!partitioned_plans.insert(pem_plan).second) {
+      continue;
+    }
+    for (IRNode* node : pem_plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+      auto sink = static_cast<GRPCSinkIR*>(node);
+      if (!sink->has_destination_id() || sink->destination_id() != bridge_id) {
+        continue;
+      }
+      OperatorIR* parent = sink->parents()[0];
+      for (int64_t partition = 1; partition < num_partitions; ++partition) {
+        PL_ASSIGN_OR_RETURN(GRPCSinkIR * partition_sink, pem_plan->CopyNode(sink));
+        PL_RETURN_IF_ERROR(partition_sink->AddParent(parent));
+        partition_sink->SetDestinationID(bridge_id + 1 + partition);
+        partition_sink->SetHashPartition(group_columns, num_partitions, partition);
+      }
+      sink->SetDestinationID(bridge_id + 1);
+      sink->SetHashPartition(group_columns, num_partitions, 0);
+    }
+  }
+
+  int64_t shuffled_bridge_id = bridge_id + 1 + num_partitions;
+  for (int64_t partition = 0; partition < num_partitions; ++partition) {
+    PL_ASSIGN_OR_RETURN(int64_t partition_node_id,
+                        distributed_plan->AddCarnot(*spare_kelvins[partition]));
+    CarnotInstance* partition_node = distributed_plan->Get(partition_node_id);
+
+    auto partition_plan_uptr = std::make_unique<IR>();
+    IR* partition_plan = partition_plan_uptr.get();
+    PL_ASSIGN_OR_RETURN(auto partition_source, partition_plan->CreateNode<GRPCSourceGroupIR>(
+                                                   source_group->ast(), bridge_id + 1 + partition,
+                                                   source_group->resolved_type()));
+    PL_ASSIGN_OR_RETURN(BlockingAggIR * partition_agg, partition_plan->CopyNode(finalize_agg));
+    PL_RETURN_IF_ERROR(partition_agg->AddParent(partition_source));
+    PL_ASSIGN_OR_RETURN(GRPCSinkIR * partition_sink,
+                        partition_plan->CreateNode<GRPCSinkIR>(source_group->ast(), partition_agg,
+                                                               shuffled_bridge_id));
+    PL_RETURN_IF_ERROR(partition_sink->SetResolvedType(finalize_agg->resolved_type()));
+
+    partition_node->AddPlan(partition_plan);
+    distributed_plan->AddPlan(std::move(partition_plan_uptr));
+    distributed_plan->AddMergeNode(partition_node);
+    for (int64_t pem : pems) {
+      distributed_plan->AddEdge(pem, partition_node_id);
+    }
+    distributed_plan->AddEdge(partition_node_id, kelvin->id());
+  }
+  for (int64_t pem : pems) {
+    distributed_plan->DeleteEdge(pem, kelvin->id());
+  }
+
+  // The Kelvin reads the finalized groups of every partition instead of the partials.
+  PL_ASSIGN_OR_RETURN(auto shuffled_source, kelvin_plan->CreateNode<GRPCSourceGroupIR>(
+                                                source_group->ast(), shuffled_bridge_id,
+                                                finalize_agg->resolved_type()));
+  for (OperatorIR* child : finalize_agg->Children()) {
+    PL_RETURN_IF_ERROR(child->ReplaceParent(finalize_agg, shuffled_source));
+  }
+  return kelvin_plan->DeleteSubtree(source_group->id());
+}
+
+Status CoordinatorImpl::AddAggSnapshots(CarnotInstance* kelvin) {
+  int64_t interval_ms = distributed_state_->agg_snapshot_interval_ms();
+  if (interval_ms <= 0) {
+    return Status::OK();
+  }
+  for (IRNode* node : kelvin->plan()->FindNodesThatMatch(ExternalGRPCSink())) {
+    auto sink = static_cast<GRPCSinkIR*>(node);
+    // Each operator on the way to the sink must only send the snapshots on to the sink.
+    std::vector<LimitIR*> limits;
+    OperatorIR* op = sink->parents()[0];
+    while ((Match(op, Map()) || Match(op, Filter()) || Match(op, Limit())) &&
+           op->Children().size() == 1) {
+      if (Match(op, Limit())) {
+        limits.push_back(static_cast<LimitIR*>(op));
+      }
+      op = op->parents()[0];
+    }
+    if (!Match(op, BlockingAgg()) || op->Children().size() != 1) {
+      continue;
+    }
+    auto agg = static_cast<BlockingAggIR*>(op);
+    if (!agg->finalize_results() || agg->merge_partials()) {
+      continue;
+    }
+    agg->SetSnapshotIntervalMs(interval_ms);
+    // Every snapshot is limited on its own, instead of the first snapshot using up the limit.
+    for (LimitIR* limit : limits) {
+      limit->SetPerWindow(true);
+    }
+    sink->SetSnapshots(true);
+  }
+  return Status::OK();
+}
+
+namespace {
+
+// Whether the Kelvin computes the operator's output once from a small input, which is the case for
+// aggregates and UDTFs that run on the Kelvin, and for the maps, filters and limits after them.
+bool IsSmallKelvinInput(OperatorIR* op) {
+  while (Match(op, Map()) || Match(op, Filter()) || Match(op, Limit())) {
+    op = op->parents()[0];
+  }
+  return Match(op, BlockingAgg()) || Match(op, UDTFSource());
+}
+
+// Whether a copy of the join can be made in the plan, which keeps the ids of the join and its
+// columns.
+bool CanCopyJoin(const JoinIR* join, const IR* plan) {
+  if (plan->HasNode(join->id())) {
+    return false;
+  }
+  for (const auto& columns :
+       {join->output_columns(), join->left_on_columns(), join->right_on_columns()}) {
+    for (const ColumnIR* column : columns) {
+      if (plan->HasNode(column->id())) {
+        return false;
+      }
+    }
+  }
+  if (join->as_of() && (plan->HasNode(join->left_time_column()->id()) ||
+                        plan->HasNode(join->right_time_column()->id()))) {
+    return false;
+  }
+  return true;
+}
+
+GRPCSinkIR* FindSinkToBridge(IR* plan, int64_t bridge_id) {
+  for (IRNode* node : plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+    auto sink = static_cast<GRPCSinkIR*>(node);
+    if (sink->has_destination_id() && sink->destination_id() == bridge_id) {
+      return sink;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+Status CoordinatorImpl::AddBroadcastJoins(
+    DistributedPlan* distributed_plan, CarnotInstance* kelvin,
+    absl::flat_hash_map<IR*, absl::flat_hash_set<int64_t>>* plan_to_agents) {
+  std::vector<int64_t> pems = distributed_plan->dag().ParentsOf(kelvin->id());
+  if (pems.empty()) {
+    return Status::OK();
+  }
+  // The PEMs receive the broadcasts on their GRPC servers.
+  for (int64_t pem : pems) {
+    const auto& info = distributed_plan->Get(pem)->carnot_info();
+    if (!info.has_grpc_server() || info.grpc_address().empty()) {
+      return Status::OK();
+    }
+  }
+
+  // The new bridges get ids after those of the existing bridges.
+  IR* kelvin_plan = kelvin->plan();
+  int64_t next_bridge_id = 0;
+  for (IRNode* node : kelvin_plan->FindNodesOfType(IRNodeType::kGRPCSourceGroup)) {
+    next_bridge_id =
+        std::max(next_bridge_id, static_cast<GRPCSourceGroupIR*>(node)->source_id() + 1);
+  }
+  std::vector<IR*> plans{kelvin_plan};
+  for (int64_t pem : pems) {
+    plans.push_back(distributed_plan->Get(pem)->plan());
+  }
+  for (IR* plan : plans) {
+    for (IRNode* node : plan->FindNodesOfType(IRNodeType::kGRPCSink)) {
+      next_bridge_id =
+          std::max(next_bridge_id, static_cast<GRPCSinkIR*>(node)->destination_id() + 1);
+    }
+  }
+
+  // The plans of the PEMs that join a broadcast, which aren't shared with other PEMs.
+  absl::flat_hash_map<int64_t, IR*> broadcast_plans;
+  auto pem_plan = [&](int64_t pem) {
+    auto it = broadcast_plans.find(pem);
+    return it != broadcast_plans.end() ? it->second : distributed_plan->Get(pem)->plan();
+  };
+
+  for (IRNode* node : kelvin_plan->FindNodesOfType(IRNodeType::kJoin)) {
+    auto join = static_cast<JoinIR*>(node);
+    // The PEM table is read by a bridge that only feeds the join.
+    int64_t table_idx = -1;
+    for (int64_t i = 0; i < 2; ++i) {
+      OperatorIR* parent = join->parents()[i];
+      if (Match(parent, GRPCSourceGroup()) && parent->Children().size() == 1 &&
+          IsSmallKelvinInput(join->parents()[1 - i])) {
+        table_idx = i;
+        break;
+      }
+    }
+    if (table_idx == -1) {
+      continue;
+    }
+    // Every PEM joins the whole small input, so each row of the small input may be output by
+    // every PEM. Only joins that drop the unmatched rows of the small input give the same result.
+    if (join->join_type() != JoinIR::JoinType::kInner &&
+        !(join->join_type() == JoinIR::JoinType::kLeft && table_idx == 0)) {
+      continue;
+    }
+    // An as-of join matches each left row with the latest right row of all of the right input, so
+    // only the left input can be split across the PEMs.
+    if (join->as_of() && table_idx != 0) {
+      continue;
+    }
+    auto table_source = static_cast<GRPCSourceGroupIR*>(join->parents()[table_idx]);
+    OperatorIR* small_input = join->parents()[1 - table_idx];
+
+    std::vector<int64_t> join_pems;
+    bool can_copy_join = true;
+    for (int64_t pem : pems) {
+      if (FindSinkToBridge(pem_plan(pem), table_source->source_id()) == nullptr) {
+        continue;
+      }
+      join_pems.push_back(pem);
+      can_copy_join &= CanCopyJoin(join, pem_plan(pem));
+    }
+    if (join_pems.empty() || !can_copy_join) {
+      continue;
+    }
+
+    int64_t joined_bridge_id = next_bridge_id++;
+    for (int64_t pem : join_pems) {
+      CarnotInstance* pem_carnot = distributed_plan->Get(pem);
+      if (!broadcast_plans.contains(pem)) {
+        IR* shared_plan = pem_carnot->plan();
+        PL_ASSIGN_OR_RETURN(std::unique_ptr<IR> plan_uptr, shared_plan->Clone());
+        broadcast_plans[pem] = plan_uptr.get();
+        pem_carnot->AddPlan(plan_uptr.get());
+        distributed_plan->AddPlan(std::move(plan_uptr));
+        distributed_plan->AddBroadcastNode(pem_carnot);
+        auto shared_it = plan_to_agents->find(shared_plan);
+        if (shared_it != plan_to_agents->end()) {
+          shared_it->second.erase(pem);
+          if (shared_it->second.empty()) {
+            plan_to_agents->erase(shared_it);
+          }
+        }
+        (*plan_to_agents)[pem_carnot->plan()] = {pem};
+      }
+      IR* plan = pem_carnot->plan();
+
+      // The PEM joins its table with the broadcast, instead of sending the table to the Kelvin.
+      PL_ASSIGN_OR_RETURN(JoinIR * pem_join, plan->CopyNode(join));
+      int64_t broadcast_bridge_id = next_bridge_id++;
+      PL_ASSIGN_OR_RETURN(auto broadcast_source, plan->CreateNode<GRPCSourceGroupIR>(
+                                                     small_input->ast(), broadcast_bridge_id,
+                                                     small_input->resolved_type()));
+      GRPCSinkIR* table_sink = FindSinkToBridge(plan, table_source->source_id());
+      OperatorIR* table = table_sink->parents()[0];
+      PL_RETURN_IF_ERROR(table_sink->RemoveParent(table));
+      PL_RETURN_IF_ERROR(plan->DeleteNode(table_sink->id()));
+      if (table_idx == 0) {
+        PL_RETURN_IF_ERROR(pem_join->AddParent(table));
+        PL_RETURN_IF_ERROR(pem_join->AddParent(broadcast_source));
+      } else {
+        PL_RETURN_IF_ERROR(pem_join->AddParent(broadcast_source));
+        PL_RETURN_IF_ERROR(pem_join->AddParent(table));
+      }
+      PL_ASSIGN_OR_RETURN(GRPCSinkIR * joined_sink, plan->CreateNode<GRPCSinkIR>(
+                                                        join->ast(), pem_join, joined_bridge_id));
+      PL_RETURN_IF_ERROR(joined_sink->SetResolvedType(join->resolved_type()));
+
+      PL_ASSIGN_OR_RETURN(GRPCSinkIR * broadcast_sink,
+                          kelvin_plan->CreateNode<GRPCSinkIR>(small_input->ast(), small_input,
+                                                              broadcast_bridge_id));
+      PL_RETURN_IF_ERROR(broadcast_sink->SetResolvedType(small_input->resolved_type()));
+    }
+
+    // The Kelvin reads the joined rows from the PEMs instead of joining them itself.
+    PL_ASSIGN_OR_RETURN(auto joined_source,
+                        kelvin_plan->CreateNode<GRPCSourceGroupIR>(join->ast(), joined_bridge_id,
+                                                                   join->resolved_type()));
+    for (OperatorIR* child : join->Children()) {
+      PL_RETURN_IF_ERROR(child->ReplaceParent(join, joined_source));
+    }
+    PL_RETURN_IF_ERROR(join->RemoveParent(small_input));
+    PL_RETURN_IF_ERROR(kelvin_plan->DeleteSubtree(table_source->id()));
+  }
+  return Status::OK();
+}
+
 StatusOr<std::unique_ptr<DistributedPlan>> CoordinatorImpl::CoordinateImpl(const IR* logical_plan) {
-  // TODO(zasgar) set support_partial_agg to true to enable partial aggs.
+  // TODO(zasgar) set support_partial_agg to true to enable partial aggs. For now they're only
+  // enabled for aggregate merge trees and shuffles, which need partials from the PEMs.
+  bool support_partial_agg = distributed_state_->max_agg_merge_fan_in() > 0 ||
+                             distributed_state_->num_agg_shuffle_partitions() > 1;
   PL_ASSIGN_OR_RETURN(std::unique_ptr<Splitter> splitter,
-                      Splitter::Create(compiler_state_, /* support_partial_agg */ false));
+                      Splitter::Create(compiler_state_, support_partial_agg));
   PL_ASSIGN_OR_RETURN(std::unique_ptr<BlockingSplitPlan> split_plan,
                       splitter->SplitKelvinAndAgents(logical_plan));
   auto distributed_plan = std::make_unique<DistributedPlan>();
@@ -284,6 +704,12 @@ StatusOr<std::unique_ptr<DistributedPlan>> CoordinatorImpl::CoordinateImpl(const
   // Prune unnecessary sources from the Kelvin plan.
   DistributedPruneUnavailableSourcesRule prune_sources_rule(agent_schema_map);
   PL_RETURN_IF_ERROR(prune_sources_rule.Apply(remote_carnot));
+  PL_RETURN_IF_ERROR(AddBroadcastJoins(distributed_plan.get(), remote_carnot,
+                                       &agent_to_plan_map.plan_to_agents));
+  // A shuffled aggregate isn't finalized on the Kelvin anymore, so it doesn't get a merge tree.
+  PL_RETURN_IF_ERROR(AddAggShuffle(distributed_plan.get(), remote_carnot));
+  PL_RETURN_IF_ERROR(AddAggMergeTree(distributed_plan.get(), remote_carnot));
+  PL_RETURN_IF_ERROR(AddAggSnapshots(remote_carnot));
 
   distributed_plan->SetKelvin(remote_carnot);
   distributed_plan->AddPlanToAgentMap(std::move(agent_to_plan_map.plan_to_agents));
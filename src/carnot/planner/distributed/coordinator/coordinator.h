@@ -94,6 +94,43 @@ class CoordinatorImpl : public Coordinator {
   const distributedpb::CarnotInfo& GetRemoteProcessor() const;
   bool HasExecutableNodes(const IR* plan);
 
+  /**
+   * @brief Merges the PEM partial aggregates in a tree of spare Kelvins when more than
+   * max_agg_merge_fan_in PEMs send to the Kelvin, so that no Carnot merges the partials of more
+   * than that many agents. Only applies when the Kelvin plan reads a single GRPCSourceGroup that
+   * feeds a finalizing aggregate, and stops adding levels when it runs out of spare Kelvins.
+   */
+  Status AddAggMergeTree(DistributedPlan* distributed_plan, CarnotInstance* kelvin);
+
+  /**
+   * @brief Shuffles the PEM partial aggregates of a group by across num_agg_shuffle_partitions
+   * spare Kelvins. Every PEM hash partitions its partials by group and sends each partition to a
+   * different Kelvin, which finalizes the groups of its partition and sends them on to the Kelvin.
+   * The Kelvin then runs the rest of the query on the union of the partitions. Applies to the same
+   * plans as AddAggMergeTree, as long as the aggregate has groups.
+   */
+  Status AddAggShuffle(DistributedPlan* distributed_plan, CarnotInstance* kelvin);
+
+  /**
+   * @brief Makes the aggregates that produce result tables on the Kelvin send snapshots of their
+   * results every agg_snapshot_interval_ms. Only applies when the operators between the aggregate
+   * and the result sink are maps, filters and limits, which pass the snapshots through as is.
+   */
+  Status AddAggSnapshots(CarnotInstance* kelvin);
+
+  /**
+   * @brief Runs the joins between a PEM table and a small input that the Kelvin computes, such as
+   * an aggregate or a UDTF, on the PEMs instead of the Kelvin. The Kelvin broadcasts the small
+   * input to every PEM, and the PEMs send the joined rows to the Kelvin instead of the whole table.
+   * Only applies to inner joins and to left joins that keep all rows of the PEM table, when every
+   * PEM has a GRPC server.
+   *
+   * Agents that join what the Kelvin broadcasts to them stop sharing their plan, so they are
+   * moved to plans of their own in plan_to_agents.
+   */
+  Status AddBroadcastJoins(DistributedPlan* distributed_plan, CarnotInstance* kelvin,
+                           absl::flat_hash_map<IR*, absl::flat_hash_set<int64_t>>* plan_to_agents);
+
   /**
    * @brief Removes the sources and any operators depending on that source. Operators that depend on
    * the source not only means the Transitive dependents, but also any parents of those Transitive
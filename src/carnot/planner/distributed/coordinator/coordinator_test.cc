@@ -365,10 +365,10 @@ TEST_F(CoordinatorTest, prune_agents_rename_metadata_column) {
 constexpr char kPruneAgentsMultiParent[] = R"pxl(
 import px
 
-left = px.DataFrame(table='http_events', start_time='-120s', select=['upid'])
+left = px.DataFrame(table='http_events', start_time='-120s', select=['upid', 'remote_port'])
 left = left[left.ctx['pod_id'] == 'agent1_pod']
-right = px.DataFrame(table='process_stats', start_time='-120s', select=['upid'])
-joined_table = left.merge(right, how='inner', left_on=['upid'], right_on=['upid'],
+right = px.DataFrame(table='process_stats', start_time='-120s', select=['upid', 'cpu_ktime_ns'])
+joined_table = left.merge(right, how='inner', left_on=['remote_port'], right_on=['cpu_ktime_ns'],
                           suffixes=['', '_x'])
 px.display(joined_table, 'multi_parent')
 )pxl";
@@ -418,6 +418,47 @@ TEST_F(CoordinatorTest, prune_agents_multiparent) {
   EXPECT_EQ(2, plan_by_qb_addr["kelvin"]->FindNodesThatMatch(GRPCSourceGroup()).size());
 }
 
+constexpr char kPruneAgentsUPIDJoin[] = R"pxl(
+import px
+
+left = px.DataFrame(table='http_events', start_time='-120s', select=['upid'])
+left = left[left.ctx['pod_id'] == 'agent1_pod']
+right = px.DataFrame(table='process_stats', start_time='-120s', select=['upid'])
+joined_table = left.merge(right, how='inner', left_on=['upid'], right_on=['upid'],
+                          suffixes=['', '_x'])
+px.display(joined_table, 'upid_join')
+)pxl";
+TEST_F(CoordinatorTest, prune_agents_upid_join) {
+  auto physical_plan = ThreeAgentOneKelvinCoordinateQuery(kPruneAgentsUPIDJoin);
+
+  // The join on upid runs on the PEMs, so the PEMs without the pod have nothing to join.
+  ASSERT_EQ(physical_plan->dag().nodes().size(), 2UL);
+
+  absl::flat_hash_map<std::string, IR*> plan_by_qb_addr;
+  for (int64_t carnot_id : physical_plan->dag().nodes()) {
+    auto carnot = physical_plan->Get(carnot_id);
+    plan_by_qb_addr[carnot->QueryBrokerAddress()] = carnot->plan();
+  }
+  ASSERT_TRUE(plan_by_qb_addr.contains("pem1"));
+  EXPECT_FALSE(plan_by_qb_addr.contains("pem2"));
+  EXPECT_FALSE(plan_by_qb_addr.contains("pem3"));
+
+  auto pem1_sinks = plan_by_qb_addr["pem1"]->FindNodesThatMatch(GRPCSink());
+  ASSERT_EQ(1, pem1_sinks.size());
+  auto pem1_sink_parents = static_cast<OperatorIR*>(pem1_sinks[0])->parents();
+  ASSERT_EQ(1, pem1_sink_parents.size());
+  ASSERT_MATCH(pem1_sink_parents[0], Join());
+
+  auto join_parents = pem1_sink_parents[0]->parents();
+  ASSERT_EQ(2, join_parents.size());
+  EXPECT_MATCH(join_parents[0],
+               Filter(Equals(MetadataExpression(MetadataType::POD_ID), String("agent1_pod"))));
+  EXPECT_MATCH(join_parents[1], MemorySource());
+
+  EXPECT_EQ(1, plan_by_qb_addr["kelvin"]->FindNodesThatMatch(GRPCSourceGroup()).size());
+  EXPECT_TRUE(plan_by_qb_addr["kelvin"]->FindNodesThatMatch(Join()).empty());
+}
+
 constexpr char kPruneAgentsMultiChild[] = R"pxl(
 import px
 
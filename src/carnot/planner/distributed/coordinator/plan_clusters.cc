@@ -35,6 +35,34 @@ namespace carnot {
 namespace planner {
 namespace distributed {
 
+Status DeleteJoinsMissingParents(IR* plan) {
+  for (int64_t id : plan->dag().TopologicalSort()) {
+    if (!plan->HasNode(id) || !Match(plan->Get(id), Join()) ||
+        static_cast<JoinIR*>(plan->Get(id))->join_type() != JoinIR::JoinType::kInner ||
+        plan->dag().ParentsOf(id).size() == 2) {
+      continue;
+    }
+    std::queue<int64_t> ancestor_to_maybe_delete_q;
+    for (int64_t p : plan->dag().ParentsOf(id)) {
+      ancestor_to_maybe_delete_q.push(p);
+    }
+    PL_RETURN_IF_ERROR(plan->DeleteSubtree(id));
+    while (!ancestor_to_maybe_delete_q.empty()) {
+      int64_t ancestor = ancestor_to_maybe_delete_q.front();
+      ancestor_to_maybe_delete_q.pop();
+      if (!plan->HasNode(ancestor) ||
+          static_cast<OperatorIR*>(plan->Get(ancestor))->Children().size() != 0) {
+        continue;
+      }
+      for (int64_t p : plan->dag().ParentsOf(ancestor)) {
+        ancestor_to_maybe_delete_q.push(p);
+      }
+      PL_RETURN_IF_ERROR(plan->DeleteSubtree(ancestor));
+    }
+  }
+  return Status::OK();
+}
+
 StatusOr<std::unique_ptr<IR>> PlanCluster::CreatePlan(const IR* base_query) const {
   // TODO(philkuz) invert this so we don't clone everything.
   PL_ASSIGN_OR_RETURN(std::unique_ptr<IR> new_ir, base_query->Clone());
@@ -65,6 +93,7 @@ StatusOr<std::unique_ptr<IR>> PlanCluster::CreatePlan(const IR* base_query) cons
       PL_RETURN_IF_ERROR(new_ir->DeleteSubtree(ancestor->id()));
     }
   }
+  PL_RETURN_IF_ERROR(DeleteJoinsMissingParents(new_ir.get()));
   return new_ir;
 }
 
@@ -38,6 +38,16 @@ namespace distributed {
 
 using OperatorToAgentSet = absl::flat_hash_map<OperatorIR*, absl::flat_hash_set<int64_t>>;
 
+/**
+ * @brief Deletes the inner joins that lost a parent when operators were removed from an agent's
+ * plan, along with their children and the ancestors that are left without children. An inner
+ * join produces no rows without either side.
+ *
+ * @param plan the plan to clean up.
+ * @return Status: error if any occurs.
+ */
+Status DeleteJoinsMissingParents(IR* plan);
+
 /**
  * @brief Data structure that tracks a set of agents that can remove an Operator and simplifies
  * the set logic to combine two such data structures when recursively evaluating subexpressions that
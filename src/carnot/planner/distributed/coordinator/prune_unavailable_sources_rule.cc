@@ -17,6 +17,7 @@
  */
 
 #include "src/carnot/planner/distributed/coordinator/prune_unavailable_sources_rule.h"
+#include "src/carnot/planner/distributed/coordinator/plan_clusters.h"
 #include "src/carnot/planner/ir/memory_source_ir.h"
 #include "src/carnot/planner/ir/string_ir.h"
 #include "src/carnot/planner/ir/udtf_source_ir.h"
@@ -55,8 +56,9 @@ StatusOr<bool> PruneUnavailableSourcesRule::RemoveSourceIfNotNecessary(OperatorI
 
 Status DeleteSourceAndChildren(OperatorIR* source_op) {
   DCHECK(source_op->IsSource());
-  // TODO(PL-1468) figure out how to delete the Join parents.
-  return source_op->graph()->DeleteOrphansInSubtree(source_op->id());
+  IR* graph = source_op->graph();
+  PL_RETURN_IF_ERROR(graph->DeleteOrphansInSubtree(source_op->id()));
+  return DeleteJoinsMissingParents(graph);
 }
 
 StatusOr<bool> PruneUnavailableSourcesRule::MaybePruneMemorySource(MemorySourceIR* mem_src) {
@@ -69,6 +71,36 @@ StatusOr<bool> PruneUnavailableSourcesRule::MaybePruneMemorySource(MemorySourceI
     PL_RETURN_IF_ERROR(DeleteSourceAndChildren(mem_src));
     return true;
   }
+
+  if (TableDataOutsideTimeRange(mem_src, carnot_info_)) {
+    PL_RETURN_IF_ERROR(DeleteSourceAndChildren(mem_src));
+    return true;
+  }
+  return false;
+}
+
+bool PruneUnavailableSourcesRule::TableDataOutsideTimeRange(
+    MemorySourceIR* mem_src, const distributedpb::CarnotInfo& carnot_info) {
+  // Streaming sources also read rows that haven't been written yet.
+  if (!mem_src->IsTimeSet() || mem_src->streaming()) {
+    return false;
+  }
+  for (const auto& table_info : carnot_info.table_info()) {
+    if (table_info.table() != mem_src->table_name() || !table_info.has_stats()) {
+      continue;
+    }
+    const auto& stats = table_info.stats();
+    if (stats.num_rows() == 0) {
+      // Without rows there are no min and max times, so only rows written after the snapshot can
+      // fall in the range.
+      return mem_src->time_stop_ns() < stats.snapshot_time_ns();
+    }
+    if (mem_src->time_stop_ns() < stats.min_time_ns()) {
+      return true;
+    }
+    return mem_src->time_start_ns() > stats.max_time_ns() &&
+           mem_src->time_stop_ns() < stats.snapshot_time_ns();
+  }
   return false;
 }
 
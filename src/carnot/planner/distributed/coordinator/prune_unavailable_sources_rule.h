@@ -25,6 +25,7 @@
 
 #include "src/carnot/planner/distributed/distributed_plan/distributed_plan.h"
 #include "src/carnot/planner/distributed/distributed_rules.h"
+#include "src/carnot/planner/ir/memory_source_ir.h"
 #include "src/carnot/planner/ir/udtf_source_ir.h"
 
 namespace px {
@@ -43,6 +44,15 @@ class PruneUnavailableSourcesRule : public Rule {
   static bool UDTFMatchesFilters(UDTFSourceIR* source,
                                  const distributedpb::CarnotInfo& carnot_info);
 
+  /**
+   * @brief Returns true if the table stats in the carnot info show that the agent has no rows in
+   * the memory source's time range. That's the case if the range ends before the agent's oldest
+   * row, as older rows have already expired, or if it falls between the agent's newest row and
+   * the time the stats were collected, as rows written since then are newer.
+   */
+  static bool TableDataOutsideTimeRange(MemorySourceIR* mem_src,
+                                        const distributedpb::CarnotInfo& carnot_info);
+
  private:
   StatusOr<bool> RemoveSourceIfNotNecessary(OperatorIR* node);
   StatusOr<bool> MaybePruneMemorySource(MemorySourceIR* mem_src);
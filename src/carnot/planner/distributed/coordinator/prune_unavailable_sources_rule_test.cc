@@ -421,6 +421,48 @@ TEST_F(PruneUnavailableSourcesRuleTest, UDTFOnAllAgentsFilterOutNonMatchingAgent
   EXPECT_TRUE(graph->HasNode(union_node_id));
 }
 
+TEST_F(PruneUnavailableSourcesRuleTest, MemorySourceOutsideTableTimeRange) {
+  auto carnot_info = logical_state_.distributed_state().carnot_info()[0];
+  ASSERT_TRUE(IsPEM(carnot_info));
+  auto table_info = carnot_info.add_table_info();
+  table_info->set_table("http_events");
+  auto stats = table_info->mutable_stats();
+  stats->set_num_rows(100);
+  stats->set_min_time_ns(1000);
+  stats->set_max_time_ns(2000);
+  stats->set_snapshot_time_ns(5000);
+
+  auto make_sub_plan = [&](int64_t start_time, int64_t stop_time) {
+    auto mem_src = MakeMemSource("http_events");
+    mem_src->SetTimeValuesNS(start_time, stop_time);
+    MakeGRPCSink(mem_src, 123);
+    return mem_src->id();
+  };
+  // Ends before the oldest row.
+  auto before_oldest_id = make_sub_plan(0, 500);
+  // Between the newest row and the snapshot.
+  auto after_newest_id = make_sub_plan(2500, 4000);
+  // Overlaps the table's rows.
+  auto overlapping_id = make_sub_plan(1500, 3000);
+  // Ends after the snapshot, so it can read rows written since.
+  auto after_snapshot_id = make_sub_plan(2500, 6000);
+  // The time range isn't set.
+  auto no_time_id = MakeMemSource("http_events")->id();
+
+  ASSERT_OK_AND_ASSIGN(sole::uuid uuid, ParseUUID(carnot_info.agent_id()));
+  ASSERT_OK_AND_ASSIGN(auto schema_map,
+                       LoadSchemaMap(logical_state_.distributed_state(), uuid_to_id_map_));
+  PruneUnavailableSourcesRule rule(uuid_to_id_map_[uuid], carnot_info, schema_map);
+  ASSERT_OK_AND_ASSIGN(bool changed, rule.Execute(graph.get()));
+  EXPECT_TRUE(changed);
+
+  EXPECT_FALSE(graph->HasNode(before_oldest_id));
+  EXPECT_FALSE(graph->HasNode(after_newest_id));
+  EXPECT_TRUE(graph->HasNode(overlapping_id));
+  EXPECT_TRUE(graph->HasNode(after_snapshot_id));
+  EXPECT_TRUE(graph->HasNode(no_time_id));
+}
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
@@ -216,7 +216,8 @@ StatusOr<bool> MapRemovableOperatorsRule::CheckMemorySource(MemorySourceIR* mem_
   }
   const auto& mem_src_ids = schema_map_.find(mem_src_ir->table_name())->second;
   for (const auto& pem : pem_instances_) {
-    if (!mem_src_ids.contains(pem)) {
+    if (!mem_src_ids.contains(pem) || PruneUnavailableSourcesRule::TableDataOutsideTimeRange(
+                                          mem_src_ir, plan_->Get(pem)->carnot_info())) {
       agent_ids.insert(pem);
     }
   }
@@ -342,6 +342,48 @@ TEST_F(RemovableOpsRuleTest, asid_filter_does_not_work_on_column) {
   EXPECT_EQ(removable_ops_to_agents.size(), 0);
 }
 
+constexpr char kTimeRangeQuery[] = R"pxl(
+import px
+
+df = px.DataFrame(table='http_events', start_time=0, end_time=100)
+px.display(df)
+)pxl";
+
+TEST_F(RemovableOpsRuleTest, mem_src_time_range_before_table_stats) {
+  auto distributed_state = ThreeAgentOneKelvinStateWithMetadataInfo();
+  auto add_stats = [&](int64_t agent, int64_t num_rows, int64_t min_time_ns) {
+    auto table_info = distributed_state.mutable_carnot_info(agent)->add_table_info();
+    table_info->set_table("http_events");
+    table_info->mutable_stats()->set_num_rows(num_rows);
+    table_info->mutable_stats()->set_min_time_ns(min_time_ns);
+    table_info->mutable_stats()->set_max_time_ns(min_time_ns + 1000);
+  };
+  // pem1's oldest row is newer than the end of the query's time range.
+  add_stats(0, 10, 1000);
+  // pem2 has rows in the time range.
+  add_stats(1, 10, 50);
+  // pem3 doesn't report stats, so it can't be pruned.
+
+  auto logical_plan = CompileSingleNodePlan(kTimeRangeQuery);
+  auto distributed_plan = AssembleDistributedPlan(distributed_state);
+  auto split_plan = SplitPlan(logical_plan.get());
+
+  absl::flat_hash_set<int64_t> source_node_ids = SourceNodeIds(distributed_plan.get());
+
+  ASSERT_OK_AND_ASSIGN(auto agent_schema_map,
+                       LoadSchemaMap(distributed_state, distributed_plan->uuid_to_id_map()));
+
+  ASSERT_OK_AND_ASSIGN(OperatorToAgentSet removable_ops_to_agents,
+                       MapRemovableOperatorsRule::GetRemovableOperators(
+                           distributed_plan.get(), agent_schema_map, source_node_ids,
+                           split_plan->before_blocking.get()));
+
+  ASSERT_EQ(removable_ops_to_agents.size(), 1);
+  auto [op, agents] = *removable_ops_to_agents.begin();
+  EXPECT_MATCH(op, MemorySource());
+  EXPECT_THAT(agents, UnorderedElementsAre(0));
+}
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
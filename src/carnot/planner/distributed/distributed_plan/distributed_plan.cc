@@ -18,6 +18,11 @@
 
 #include "src/carnot/planner/distributed/distributed_plan/distributed_plan.h"
 
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
 namespace px {
 namespace carnot {
 namespace planner {
@@ -29,17 +34,35 @@ StatusOr<distributedpb::DistributedPlan> DistributedPlan::ToProto() const {
   auto qb_address_to_plan_pb = physical_plan_pb.mutable_qb_address_to_plan();
   auto qb_address_to_dag_id_pb = physical_plan_pb.mutable_qb_address_to_dag_id();
 
-  for (int64_t i : dag_.TopologicalSort()) {
+  // The PEMs of a cluster share one plan, so each shared plan is only converted once. The copies
+  // of the other agents just get their GRPCSinks filled in.
+  std::vector<int64_t> carnot_ids = dag_.TopologicalSort();
+  absl::flat_hash_map<const IR*, int64_t> num_carnots_per_plan;
+  for (int64_t i : carnot_ids) {
+    ++num_carnots_per_plan[Get(i)->plan()];
+  }
+  absl::flat_hash_map<const IR*, planpb::Plan> shared_plan_protos;
+  for (int64_t i : carnot_ids) {
     CarnotInstance* carnot = Get(i);
     CHECK_EQ(carnot->id(), i) << absl::Substitute("Index in node ($1) and DAG ($0) don't agree.", i,
                                                   carnot->id());
     DCHECK(carnot->plan()) << absl::Substitute("$0 doesn't have a plan set.",
                                                carnot->DebugString());
-    PL_ASSIGN_OR_RETURN(auto plan_proto, carnot->PlanProto());
+    planpb::Plan plan_proto;
+    auto shared_it = shared_plan_protos.find(carnot->plan());
+    if (shared_it != shared_plan_protos.end()) {
+      plan_proto = shared_it->second;
+      PL_RETURN_IF_ERROR(carnot->plan()->UpdateProtoForAgent(&plan_proto, i));
+    } else {
+      PL_ASSIGN_OR_RETURN(plan_proto, carnot->PlanProto());
+      if (num_carnots_per_plan[carnot->plan()] > 1) {
+        shared_plan_protos[carnot->plan()] = plan_proto;
+      }
+    }
     for (int64_t parent_i : dag_.ParentsOf(i)) {
       *(plan_proto.add_incoming_agent_ids()) = Get(parent_i)->carnot_info().agent_id();
     }
-    (*qb_address_to_plan_pb)[carnot->QueryBrokerAddress()] = plan_proto;
+    (*qb_address_to_plan_pb)[carnot->QueryBrokerAddress()] = std::move(plan_proto);
     (*qb_address_to_dag_id_pb)[carnot->QueryBrokerAddress()] = i;
 
     auto plan_opts = (*qb_address_to_plan_pb)[carnot->QueryBrokerAddress()].mutable_plan_options();
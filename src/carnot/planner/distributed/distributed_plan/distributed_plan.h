@@ -114,6 +114,7 @@ class DistributedPlan {
 
   void AddEdge(CarnotInstance* from, CarnotInstance* to) { dag_.AddEdge(from->id(), to->id()); }
   void AddEdge(int64_t from, int64_t to) { dag_.AddEdge(from, to); }
+  void DeleteEdge(int64_t from, int64_t to) { dag_.DeleteEdge(from, to); }
   bool HasNode(int64_t node_id) const { return dag_.HasNode(node_id); }
 
   Status DeleteNode(int64_t node) {
@@ -158,11 +159,28 @@ class DistributedPlan {
 
   CarnotInstance* kelvin() const { return kelvin_; }
 
+  /**
+   * @brief Registers an intermediate Kelvin, such as an aggregate merge node or shuffle partition,
+   * that processes what its parents in the DAG send it and sends the result on to its dependencies.
+   */
+  void AddMergeNode(CarnotInstance* merge_node) { merge_nodes_.push_back(merge_node); }
+  const std::vector<CarnotInstance*>& merge_nodes() const { return merge_nodes_; }
+
+  /**
+   * @brief Registers a PEM that reads what the Kelvin broadcasts to it, such as the small side of a
+   * broadcast join. There is no edge from the Kelvin to the PEM in the DAG, because the PEM also
+   * sends its results to the Kelvin.
+   */
+  void AddBroadcastNode(CarnotInstance* pem) { broadcast_nodes_.push_back(pem); }
+  const std::vector<CarnotInstance*>& broadcast_nodes() const { return broadcast_nodes_; }
+
  private:
   plan::DAG dag_;
   absl::flat_hash_map<int64_t, std::unique_ptr<CarnotInstance>> id_to_node_map_;
   absl::flat_hash_map<IR*, absl::flat_hash_set<int64_t>> plan_to_agent_map_;
   CarnotInstance* kelvin_ = nullptr;
+  std::vector<CarnotInstance*> merge_nodes_;
+  std::vector<CarnotInstance*> broadcast_nodes_;
   std::vector<std::unique_ptr<IR>> plan_pool_;
   absl::flat_hash_map<int64_t, IR*> agent_to_plan_map_;
   absl::flat_hash_map<sole::uuid, int64_t> uuid_to_id_map_;
@@ -229,6 +229,52 @@ TEST_F(DistributedPlanTest, construction_test) {
   EXPECT_THAT(physical_plan_proto, Partially(EqualsProto(kIRProto)));
 }
 
+TEST_F(DistributedPlanTest, shared_plan_to_proto) {
+  auto physical_plan = std::make_unique<DistributedPlan>();
+  distributedpb::DistributedState physical_state =
+      LoadDistributedStatePb(kOneAgentDistributedState);
+  distributedpb::CarnotInfo pem_info = physical_state.carnot_info()[0];
+  int64_t pem0 = physical_plan->AddCarnot(pem_info).ConsumeValueOrDie();
+  pem_info.set_query_broker_address("agent2");
+  pem_info.mutable_agent_id()->set_low_bits(3);
+  int64_t pem1 = physical_plan->AddCarnot(pem_info).ConsumeValueOrDie();
+  int64_t kelvin = physical_plan->AddCarnot(physical_state.carnot_info()[1]).ConsumeValueOrDie();
+
+  // Both PEMs share one plan, whose GRPCSink sends to a different source for each of them.
+  auto mem_source = MakeMemSource(MakeRelation());
+  compiler_state_->relation_map()->emplace("table", MakeRelation());
+  auto grpc_sink = MakeGRPCSink(mem_source, 1);
+  grpc_sink->SetDestinationAddress("1111");
+  grpc_sink->AddDestinationIDMap(10, pem0);
+  grpc_sink->AddDestinationIDMap(11, pem1);
+  compiler::ResolveTypesRule rule(compiler_state_.get());
+  ASSERT_OK(rule.Execute(graph.get()));
+  auto pem_plan_uptr = graph->Clone().ConsumeValueOrDie();
+  IR* pem_plan = pem_plan_uptr.get();
+  physical_plan->Get(pem0)->AddPlan(pem_plan);
+  physical_plan->Get(pem1)->AddPlan(pem_plan);
+  physical_plan->AddPlan(std::move(pem_plan_uptr));
+
+  auto kelvin_graph = std::make_shared<IR>();
+  SwapGraphBeingBuilt(kelvin_graph);
+  MakeMemSink(MakeMemSource(MakeRelation()), "out");
+  ASSERT_OK(rule.Execute(graph.get()));
+  auto kelvin_plan_uptr = graph->Clone().ConsumeValueOrDie();
+  physical_plan->Get(kelvin)->AddPlan(kelvin_plan_uptr.get());
+  physical_plan->AddPlan(std::move(kelvin_plan_uptr));
+  physical_plan->AddEdge(physical_plan->Get(pem0), physical_plan->Get(kelvin));
+  physical_plan->AddEdge(physical_plan->Get(pem1), physical_plan->Get(kelvin));
+
+  auto physical_plan_proto = physical_plan->ToProto().ConsumeValueOrDie();
+  for (const auto& [pem, address] :
+       std::vector<std::pair<int64_t, std::string>>{{pem0, "agent"}, {pem1, "agent2"}}) {
+    auto expected = pem_plan->ToProto(pem).ConsumeValueOrDie();
+    expected.mutable_plan_options();
+    EXPECT_THAT(physical_plan_proto.qb_address_to_plan().at(address),
+                EqualsProto(expected.DebugString()));
+  }
+}
+
 }  // namespace distributed
 
 }  // namespace planner
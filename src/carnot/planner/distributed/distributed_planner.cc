@@ -21,6 +21,9 @@
 #include <unordered_set>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+
 #include "src/carnot/planner/distributed/annotate_abortable_sources_for_limits_rule.h"
 #include "src/carnot/planner/distributed/coordinator/coordinator.h"
 #include "src/carnot/planner/distributed/distributed_planner.h"
@@ -51,12 +54,36 @@ Status StitchPlan(DistributedPlan* distributed_plan) {
 
   DistributedSetSourceGroupGRPCAddressRule set_grpc_address_rule;
   PL_RETURN_IF_ERROR(set_grpc_address_rule.Apply(remote_carnot));
+  for (CarnotInstance* merge_node : distributed_plan->merge_nodes()) {
+    PL_RETURN_IF_ERROR(set_grpc_address_rule.Apply(merge_node));
+  }
+  for (CarnotInstance* pem : distributed_plan->broadcast_nodes()) {
+    PL_RETURN_IF_ERROR(set_grpc_address_rule.Apply(pem));
+  }
 
-  // Connect the plans.
+  // Connect the plans. Agents that share a plan may send to different merge nodes.
   for (const auto& [plan, agents] : distributed_plan->plan_to_agent_map()) {
-    PL_ASSIGN_OR_RETURN(auto did_connect_plan, AssociateDistributedPlanEdgesRule::ConnectGraphs(
-                                                   plan, agents, remote_plan));
-    DCHECK(did_connect_plan);
+    absl::flat_hash_map<int64_t, absl::flat_hash_set<int64_t>> destination_to_agents;
+    for (int64_t agent : agents) {
+      for (int64_t destination : distributed_plan->dag().DependenciesOf(agent)) {
+        destination_to_agents[destination].insert(agent);
+      }
+    }
+    for (const auto& [destination, destination_agents] : destination_to_agents) {
+      IR* destination_plan = distributed_plan->Get(destination)->plan();
+      PL_ASSIGN_OR_RETURN(auto did_connect_plan, AssociateDistributedPlanEdgesRule::ConnectGraphs(
+                                                     plan, destination_agents, destination_plan));
+      DCHECK(did_connect_plan);
+    }
+  }
+  for (CarnotInstance* merge_node : distributed_plan->merge_nodes()) {
+    for (int64_t destination : distributed_plan->dag().DependenciesOf(merge_node->id())) {
+      PL_ASSIGN_OR_RETURN(auto did_connect_plan,
+                          AssociateDistributedPlanEdgesRule::ConnectGraphs(
+                              merge_node->plan(), {merge_node->id()},
+                              distributed_plan->Get(destination)->plan()));
+      DCHECK(did_connect_plan);
+    }
   }
 
   // TODO(philkuz) make this connect to self without a grpc bridge.
@@ -66,7 +93,20 @@ Status StitchPlan(DistributedPlan* distributed_plan) {
   // Expand GRPCSourceGroups in the remote_plan.
   GRPCSourceGroupConversionRule conversion_rule;
   PL_RETURN_IF_ERROR(conversion_rule.Execute(remote_plan));
-  return MergeSameNodeGRPCBridgeRule(remote_node_id).Execute(remote_plan).status();
+  for (CarnotInstance* merge_node : distributed_plan->merge_nodes()) {
+    PL_RETURN_IF_ERROR(conversion_rule.Execute(merge_node->plan()));
+  }
+  PL_RETURN_IF_ERROR(MergeSameNodeGRPCBridgeRule(remote_node_id).Execute(remote_plan).status());
+
+  // The broadcasts from the Kelvin are connected after the Kelvin's bridges to itself are merged.
+  // Both are sent by the Kelvin, so the merge would mistake a broadcast for a bridge to itself.
+  for (CarnotInstance* pem : distributed_plan->broadcast_nodes()) {
+    PL_ASSIGN_OR_RETURN(auto did_connect_plan, AssociateDistributedPlanEdgesRule::ConnectGraphs(
+                                                   remote_plan, {remote_node_id}, pem->plan()));
+    DCHECK(did_connect_plan);
+    PL_RETURN_IF_ERROR(conversion_rule.Execute(pem->plan()));
+  }
+  return Status::OK();
 }
 
 StatusOr<std::unique_ptr<DistributedPlan>> DistributedPlanner::Plan(
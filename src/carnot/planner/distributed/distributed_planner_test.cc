@@ -42,6 +42,7 @@ using compiler::ResolveTypesRule;
 using px::testing::proto::EqualsProto;
 using ::testing::ContainsRegex;
 using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
 using ::testing::UnorderedElementsAreArray;
 using testutils::DistributedRulesTest;
 using testutils::kThreePEMsOneKelvinDistributedState;
@@ -398,6 +399,219 @@ TEST_F(DistributedRulesTest, init_args) {
   EXPECT_OK(distributed_plan_or_s);
 }
 
+constexpr char kAggMergeTreeQuery[] = R"pxl(
+import px
+df = px.DataFrame(table='http_events', start_time='-120s', select=['upid'])
+df = df.agg(count=('upid', px.count))
+px.display(df, 'out')
+)pxl";
+
+TEST_F(DistributedRulesTest, agg_merge_tree) {
+  auto ps = testutils::LoadDistributedStatePb(kThreePEMsOneKelvinDistributedState);
+  // Add two spare Kelvins to merge the partials of the three PEMs on.
+  for (int64_t i = 1; i <= 2; ++i) {
+    distributedpb::CarnotInfo spare_kelvin = ps.carnot_info(3);
+    spare_kelvin.set_query_broker_address(absl::Substitute("spare_kelvin$0", i));
+    spare_kelvin.set_grpc_address(absl::Substitute("spare_kelvin$0:1111", i));
+    spare_kelvin.mutable_agent_id()->set_low_bits(4 + i);
+    *ps.add_carnot_info() = spare_kelvin;
+  }
+  ps.set_max_agg_merge_fan_in(2);
+
+  auto single_node_plan = CompileSingleNodePlan(kAggMergeTreeQuery);
+  auto distributed_planner = distributed::DistributedPlanner::Create().ConsumeValueOrDie();
+  auto physical_plan = distributed_planner->Plan(ps, compiler_state_.get(), single_node_plan.get())
+                           .ConsumeValueOrDie();
+  ASSERT_EQ(physical_plan->dag().nodes().size(), 6UL);
+  ASSERT_EQ(physical_plan->merge_nodes().size(), 2UL);
+
+  CarnotInstance* kelvin = physical_plan->kelvin();
+  EXPECT_EQ(kelvin->QueryBrokerAddress(), "kelvin");
+  EXPECT_EQ(kelvin->plan()->FindNodesThatMatch(FinalizeAgg()).size(), 1);
+
+  std::vector<int64_t> merge_node_ids;
+  int64_t num_pems = 0;
+  for (CarnotInstance* merge_node : physical_plan->merge_nodes()) {
+    merge_node_ids.push_back(merge_node->id());
+    EXPECT_THAT(merge_node->QueryBrokerAddress(), ContainsRegex("spare_kelvin"));
+    auto aggs = merge_node->plan()->FindNodesOfType(IRNodeType::kBlockingAgg);
+    ASSERT_EQ(aggs.size(), 1);
+    EXPECT_TRUE(static_cast<BlockingAggIR*>(aggs[0])->merge_partials());
+
+    // Every PEM sends its partials to its own merge node.
+    for (int64_t pem_id : physical_plan->dag().ParentsOf(merge_node->id())) {
+      ++num_pems;
+      auto pem = physical_plan->Get(pem_id);
+      EXPECT_THAT(pem->QueryBrokerAddress(), ContainsRegex("pem"));
+      ASSERT_OK_AND_ASSIGN(planpb::Plan pem_plan, pem->PlanProto());
+      for (const auto& fragment : pem_plan.nodes()) {
+        for (const auto& node : fragment.nodes()) {
+          if (node.op().op_type() == planpb::GRPC_SINK_OPERATOR) {
+            EXPECT_EQ(node.op().grpc_sink_op().address(),
+                      merge_node->carnot_info().grpc_address());
+          }
+        }
+      }
+    }
+  }
+  EXPECT_EQ(num_pems, 3);
+  EXPECT_THAT(physical_plan->dag().ParentsOf(kelvin->id()),
+              UnorderedElementsAreArray(merge_node_ids));
+  EXPECT_OK(physical_plan->ToProto());
+}
+
+constexpr char kAggShuffleQuery[] = R"pxl(
+import px
+df = px.DataFrame(table='http_events', start_time='-120s', select=['upid'])
+df = df.groupby('upid').agg(count=('upid', px.count))
+px.display(df, 'out')
+)pxl";
+
+TEST_F(DistributedRulesTest, agg_shuffle) {
+  auto ps = testutils::LoadDistributedStatePb(kThreePEMsOneKelvinDistributedState);
+  // Add two spare Kelvins to finalize the partitions on.
+  for (int64_t i = 1; i <= 2; ++i) {
+    distributedpb::CarnotInfo spare_kelvin = ps.carnot_info(3);
+    spare_kelvin.set_query_broker_address(absl::Substitute("spare_kelvin$0", i));
+    spare_kelvin.set_grpc_address(absl::Substitute("spare_kelvin$0:1111", i));
+    spare_kelvin.mutable_agent_id()->set_low_bits(4 + i);
+    *ps.add_carnot_info() = spare_kelvin;
+  }
+  ps.set_num_agg_shuffle_partitions(2);
+
+  auto single_node_plan = CompileSingleNodePlan(kAggShuffleQuery);
+  auto distributed_planner = distributed::DistributedPlanner::Create().ConsumeValueOrDie();
+  auto physical_plan = distributed_planner->Plan(ps, compiler_state_.get(), single_node_plan.get())
+                           .ConsumeValueOrDie();
+  ASSERT_EQ(physical_plan->merge_nodes().size(), 2UL);
+
+  // The groups are finalized on the partition Kelvins.
+  CarnotInstance* kelvin = physical_plan->kelvin();
+  EXPECT_EQ(kelvin->plan()->FindNodesThatMatch(FinalizeAgg()).size(), 0);
+  std::vector<int64_t> partition_ids;
+  for (CarnotInstance* partition : physical_plan->merge_nodes()) {
+    partition_ids.push_back(partition->id());
+    EXPECT_EQ(partition->plan()->FindNodesThatMatch(FinalizeAgg()).size(), 1);
+    EXPECT_EQ(physical_plan->dag().ParentsOf(partition->id()).size(), 3UL);
+  }
+  EXPECT_THAT(physical_plan->dag().ParentsOf(kelvin->id()),
+              UnorderedElementsAreArray(partition_ids));
+
+  // Every PEM sends one partition of its partials to each of the partition Kelvins.
+  for (int64_t pem_id : physical_plan->dag().ParentsOf(partition_ids[0])) {
+    ASSERT_OK_AND_ASSIGN(planpb::Plan pem_plan, physical_plan->Get(pem_id)->PlanProto());
+    std::vector<int64_t> partitions;
+    for (const auto& fragment : pem_plan.nodes()) {
+      for (const auto& node : fragment.nodes()) {
+        if (node.op().op_type() != planpb::GRPC_SINK_OPERATOR) {
+          continue;
+        }
+        const auto& hash_partition = node.op().grpc_sink_op().hash_partition();
+        EXPECT_EQ(hash_partition.num_partitions(), 2);
+        EXPECT_THAT(hash_partition.column_indexes(), ElementsAre(0));
+        partitions.push_back(hash_partition.partition());
+      }
+    }
+    EXPECT_THAT(partitions, UnorderedElementsAre(0, 1));
+  }
+  EXPECT_OK(physical_plan->ToProto());
+}
+
+constexpr char kBroadcastJoinQuery[] = R"pxl(
+import px
+paths = px.DataFrame(table='http_events', start_time='-120s', select=['req_path'])
+paths = paths.groupby('req_path').agg(count=('req_path', px.count))
+df = px.DataFrame(table='http_events', start_time='-120s', select=['req_path', 'req_method'])
+df = df.merge(paths, how='inner', left_on='req_path', right_on='req_path', suffixes=['', '_x'])
+px.display(df, 'out')
+)pxl";
+
+TEST_F(DistributedRulesTest, broadcast_join) {
+  auto ps = testutils::LoadDistributedStatePb(kThreePEMsOneKelvinDistributedState);
+  // The PEMs need GRPC servers to receive the aggregate from the Kelvin.
+  for (int64_t i = 0; i < 3; ++i) {
+    auto pem = ps.mutable_carnot_info(i);
+    pem->set_has_grpc_server(true);
+    pem->set_grpc_address(absl::Substitute("pem$0:1111", i + 1));
+    pem->set_ssl_targetname("pem.pl.svc");
+  }
+
+  auto single_node_plan = CompileSingleNodePlan(kBroadcastJoinQuery);
+  auto distributed_planner = distributed::DistributedPlanner::Create().ConsumeValueOrDie();
+  auto physical_plan = distributed_planner->Plan(ps, compiler_state_.get(), single_node_plan.get())
+                           .ConsumeValueOrDie();
+  ASSERT_EQ(physical_plan->dag().nodes().size(), 4UL);
+  ASSERT_EQ(physical_plan->broadcast_nodes().size(), 3UL);
+
+  // The Kelvin aggregates the paths and sends them to every PEM, instead of joining them itself.
+  CarnotInstance* kelvin = physical_plan->kelvin();
+  EXPECT_EQ(kelvin->plan()->FindNodesThatMatch(Join()).size(), 0);
+  ASSERT_OK_AND_ASSIGN(planpb::Plan kelvin_plan, kelvin->PlanProto());
+  std::vector<std::string> broadcast_addresses;
+  for (const auto& fragment : kelvin_plan.nodes()) {
+    for (const auto& node : fragment.nodes()) {
+      if (node.op().op_type() == planpb::GRPC_SINK_OPERATOR &&
+          !node.op().grpc_sink_op().has_output_table()) {
+        broadcast_addresses.push_back(node.op().grpc_sink_op().address());
+      }
+    }
+  }
+  EXPECT_THAT(broadcast_addresses, UnorderedElementsAre("pem1:1111", "pem2:1111", "pem3:1111"));
+
+  // Each PEM joins its own table with the paths, and sends the joined rows to the Kelvin.
+  for (CarnotInstance* pem : physical_plan->broadcast_nodes()) {
+    auto joins = pem->plan()->FindNodesThatMatch(Join());
+    ASSERT_EQ(joins.size(), 1);
+    auto join = static_cast<JoinIR*>(joins[0]);
+    EXPECT_MATCH(join->parents()[1], GRPCSource());
+    ASSERT_EQ(join->Children().size(), 1);
+    ASSERT_MATCH(join->Children()[0], InternalGRPCSink());
+    auto sink = static_cast<GRPCSinkIR*>(join->Children()[0]);
+    EXPECT_EQ(sink->destination_address(), kelvin->carnot_info().grpc_address());
+    EXPECT_THAT(physical_plan->dag().DependenciesOf(pem->id()), ElementsAre(kelvin->id()));
+  }
+  EXPECT_OK(physical_plan->ToProto());
+}
+
+TEST_F(DistributedRulesTest, agg_snapshots) {
+  auto ps = testutils::LoadDistributedStatePb(kThreePEMsOneKelvinDistributedState);
+  ps.set_agg_snapshot_interval_ms(200);
+
+  auto single_node_plan = CompileSingleNodePlan(kAggShuffleQuery);
+  auto distributed_planner = distributed::DistributedPlanner::Create().ConsumeValueOrDie();
+  auto physical_plan = distributed_planner->Plan(ps, compiler_state_.get(), single_node_plan.get())
+                           .ConsumeValueOrDie();
+
+  // Only the Kelvin's finalizing aggregate, that feeds the result table, sends snapshots.
+  int64_t num_snapshot_aggs = 0;
+  int64_t num_snapshot_sinks = 0;
+  for (int64_t id : physical_plan->dag().nodes()) {
+    auto carnot = physical_plan->Get(id);
+    ASSERT_OK_AND_ASSIGN(planpb::Plan plan, carnot->PlanProto());
+    for (const auto& fragment : plan.nodes()) {
+      for (const auto& node : fragment.nodes()) {
+        if (node.op().op_type() == planpb::AGGREGATE_OPERATOR &&
+            node.op().agg_op().snapshot_interval_ms() > 0) {
+          EXPECT_EQ(carnot, physical_plan->kelvin());
+          EXPECT_EQ(node.op().agg_op().snapshot_interval_ms(), 200);
+          ++num_snapshot_aggs;
+        }
+        if (node.op().op_type() == planpb::GRPC_SINK_OPERATOR &&
+            node.op().grpc_sink_op().output_table().snapshots()) {
+          EXPECT_EQ(carnot, physical_plan->kelvin());
+          ++num_snapshot_sinks;
+        }
+        // Limits on the way to the result table apply to each snapshot.
+        if (node.op().op_type() == planpb::LIMIT_OPERATOR && carnot == physical_plan->kelvin()) {
+          EXPECT_TRUE(node.op().limit_op().per_window());
+        }
+      }
+    }
+  }
+  EXPECT_EQ(num_snapshot_aggs, 1);
+  EXPECT_EQ(num_snapshot_sinks, 1);
+}
+
 }  // namespace distributed
 }  // namespace planner
 }  // namespace carnot
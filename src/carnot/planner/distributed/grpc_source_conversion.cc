@@ -109,8 +109,10 @@ StatusOr<bool> MergeSameNodeGRPCBridgeRule::Apply(IRNode* ir_node) {
     return false;
   }
   GRPCSinkIR* grpc_sink = static_cast<GRPCSinkIR*>(ir_node);
-  DCHECK(grpc_sink->agent_id_to_destination_id().contains(current_agent_id_))
-      << "Expected the grpc sink to contain this current agent ID as a a target";
+  // Sinks that broadcast to the PEMs aren't connected yet.
+  if (!grpc_sink->agent_id_to_destination_id().contains(current_agent_id_)) {
+    return false;
+  }
   int64_t dest_id = grpc_sink->agent_id_to_destination_id().at(current_agent_id_);
   auto node = grpc_sink->graph()->Get(dest_id);
   if (!Match(node, GRPCSource())) {
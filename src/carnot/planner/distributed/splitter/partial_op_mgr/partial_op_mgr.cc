@@ -18,6 +18,7 @@
 
 #include "src/carnot/planner/distributed/splitter/partial_op_mgr/partial_op_mgr.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,11 +28,79 @@ namespace carnot {
 namespace planner {
 namespace distributed {
 
+namespace {
+
+// The column that expr bins, if expr is px.bin(column, size).
+const ColumnIR* BinnedColumn(const ExpressionIR* expr) {
+  if (!Match(expr, Func())) {
+    return nullptr;
+  }
+  auto func = static_cast<const FuncIR*>(expr);
+  if (func->func_name() != "bin" || func->args().size() != 2 ||
+      !Match(func->args()[0], ColumnNode())) {
+    return nullptr;
+  }
+  return static_cast<const ColumnIR*>(func->args()[0]);
+}
+
+// Whether the column of op is px.bin() of the time column of a memory source, through operators
+// that keep the order of the rows. Table store scans return the rows of a table in time order.
+bool IsTimeOrderedBin(OperatorIR* op, std::string col_name) {
+  bool binned = false;
+  while (!Match(op, MemorySource())) {
+    if (op->parents().size() != 1) {
+      return false;
+    }
+    if (Match(op, Map())) {
+      const ExpressionIR* expr = nullptr;
+      for (const auto& col_expr : static_cast<MapIR*>(op)->col_exprs()) {
+        if (col_expr.name == col_name) {
+          expr = col_expr.node;
+        }
+      }
+      if (expr == nullptr) {
+        if (!static_cast<MapIR*>(op)->keep_input_columns()) {
+          return false;
+        }
+      } else if (Match(expr, ColumnNode())) {
+        col_name = static_cast<const ColumnIR*>(expr)->col_name();
+      } else if (!binned && BinnedColumn(expr) != nullptr) {
+        binned = true;
+        col_name = BinnedColumn(expr)->col_name();
+      } else {
+        return false;
+      }
+    } else if (!Match(op, Filter()) && !Match(op, Limit())) {
+      return false;
+    }
+    op = op->parents()[0];
+  }
+  return binned && col_name == "time_";
+}
+
+}  // namespace
+
 StatusOr<OperatorIR*> LimitOperatorMgr::CreatePrepareOperator(IR* plan, OperatorIR* op) const {
   DCHECK(Matches(op));
   LimitIR* limit = static_cast<LimitIR*>(op);
   PL_ASSIGN_OR_RETURN(LimitIR * new_limit, plan->CopyNode(limit));
   PL_RETURN_IF_ERROR(new_limit->CopyParentsFrom(limit));
+  if (!limit->is_ordered()) {
+    return new_limit;
+  }
+  // The merge limit re-sorts the partial results, so the prepare limit has to keep the sort
+  // columns even if they are pruned from the output of the original limit.
+  DCHECK(limit->parents()[0]->is_type_resolved());
+  auto parent_type = limit->parents()[0]->resolved_table_type();
+  auto new_type = TableType::Create();
+  for (const auto& [col_name, col_type] : *parent_type) {
+    if (limit->resolved_table_type()->HasColumn(col_name) ||
+        std::find(limit->sort_columns().begin(), limit->sort_columns().end(), col_name) !=
+            limit->sort_columns().end()) {
+      new_type->AddColumn(col_name, col_type);
+    }
+  }
+  PL_RETURN_IF_ERROR(new_limit->SetResolvedType(new_type));
   return new_limit;
 }
 
@@ -51,6 +120,12 @@ StatusOr<OperatorIR*> AggOperatorMgr::CreatePrepareOperator(IR* plan, OperatorIR
   PL_RETURN_IF_ERROR(new_agg->CopyParentsFrom(agg));
   new_agg->SetPartialAgg(true);
   new_agg->SetFinalizeResults(false);
+  for (const auto& [idx, group] : Enumerate(agg->groups())) {
+    if (IsTimeOrderedBin(agg->parents()[0], group->col_name())) {
+      new_agg->SetTimeBinGroup(idx);
+      break;
+    }
+  }
 
   auto new_type = TableType::Create();
   for (ColumnIR* group : agg->groups()) {
@@ -78,6 +153,11 @@ StatusOr<OperatorIR*> AggOperatorMgr::CreateMergeOperator(IR* plan, OperatorIR*
 
   new_agg->SetPartialAgg(false);
   new_agg->SetFinalizeResults(true);
+  // The partial aggregates already merge the panes of a sliding window, so the finalize step
+  // only combines the partials of each window.
+  if (agg->windowed()) {
+    new_agg->SetWindowPanes(1);
+  }
   DCHECK(Match(new_agg, FinalizeAgg()));
   return new_agg;
 }
@@ -71,7 +71,8 @@ class PartialOperatorMgr : public NotCopyable {
 /**
  * @brief LimitOperatorMgr manages splitting limits over the boundary. Prepare Limits are the same
  * as the Merge operators, but it's a nice optimization because it removes a very unnecessary
- * network transfer.
+ * network transfer. Ordered limits (top-k) become a partial top-k on each PEM that Kelvin merges
+ * into the final top-k.
  *
  */
 class LimitOperatorMgr : public PartialOperatorMgr {
@@ -98,6 +99,10 @@ class AggOperatorMgr : public PartialOperatorMgr {
       return false;
     }
     BlockingAggIR* agg = static_cast<BlockingAggIR*>(op);
+    // Aggregates that already read partials, ie. from a rollup table, only finalize them.
+    if (!agg->partial_agg() || !agg->finalize_results()) {
+      return false;
+    }
     for (const auto& col_expr : agg->aggregate_expressions()) {
       if (!Match(col_expr.node, PartialUDA())) {
         return false;
@@ -99,6 +99,8 @@ TEST_F(PartialOpMgrTest, agg_test) {
   OperatorIR* prepare_agg_uncasted = prepare_agg_or_s.ConsumeValueOrDie();
   ASSERT_MATCH(prepare_agg_uncasted, PartialAgg());
   BlockingAggIR* prepare_agg = static_cast<BlockingAggIR*>(prepare_agg_uncasted);
+  // None of the groups are time bins.
+  EXPECT_EQ(-1, prepare_agg->time_bin_group());
 
   auto mem_src2 = MakeMemSource(MakeRelation());
   auto merge_agg_or_s = mgr.CreateMergeOperator(graph.get(), mem_src2, agg);
@@ -122,6 +124,40 @@ TEST_F(PartialOpMgrTest, agg_test) {
                                    {"count", "service", "serialized_expressions"})));
 
   EXPECT_THAT(*merge_agg->resolved_table_type(), IsTableType(agg_relation));
+  // The finalize agg can't be split again.
+  EXPECT_FALSE(mgr.Matches(merge_agg));
+}
+
+TEST_F(PartialOpMgrTest, sliding_window_agg_test) {
+  auto relation = MakeRelation();
+  auto mem_src = MakeMemSource("source", relation);
+  compiler_state_->relation_map()->emplace("source", relation);
+  auto count_col = MakeColumn("count", 0);
+  EXPECT_OK(count_col->SetResolvedType(ValueType::Create(types::INT64, types::ST_NONE)));
+  auto mean_func = MakeMeanFunc(MakeColumn("count", 0));
+  auto agg = MakeBlockingAgg(mem_src, {count_col}, {{"mean", mean_func}});
+  agg->SetWindowPanes(4);
+  MakeMemSink(agg, "out");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  AggOperatorMgr mgr;
+  ASSERT_TRUE(mgr.Matches(agg));
+  ASSERT_OK_AND_ASSIGN(OperatorIR * prepare_op, mgr.CreatePrepareOperator(graph.get(), agg));
+  ASSERT_MATCH(prepare_op, PartialAgg());
+  auto prepare_agg = static_cast<BlockingAggIR*>(prepare_op);
+  // The partial aggregate covers every pane of the window.
+  EXPECT_TRUE(prepare_agg->windowed());
+  EXPECT_EQ(4, prepare_agg->window_panes());
+
+  auto mem_src2 = MakeMemSource(MakeRelation());
+  ASSERT_OK_AND_ASSIGN(OperatorIR * merge_op, mgr.CreateMergeOperator(graph.get(), mem_src2, agg));
+  ASSERT_MATCH(merge_op, FinalizeAgg());
+  auto merge_agg = static_cast<BlockingAggIR*>(merge_op);
+  // Every window's partials are finalized on their own.
+  EXPECT_TRUE(merge_agg->windowed());
+  EXPECT_EQ(1, merge_agg->window_panes());
 }
 
 // This tests aggs with functions that can't partial. We don't partial the agg if that's the case.
@@ -27,9 +27,9 @@ namespace distributed {
 // Get new locations for the input limit node.
 // A single limit may be cloned and pushed up to multiple branches.
 StatusOr<absl::flat_hash_set<OperatorIR*>> LimitPushdownRule::NewLimitParents(
-    OperatorIR* current_node) {
-  // Maps we can simply push up the chain.
-  if (Match(current_node, Map())) {
+    OperatorIR* current_node, bool ordered) {
+  // Maps we can simply push up the chain, unless the limit is ordered.
+  if (!ordered && Match(current_node, Map())) {
     DCHECK_EQ(1, current_node->parents().size());
     // Don't push a Limit earlier than a PEM-only Map, because we need to ensure that after
     // splitting on Limit nodes, we don't end up with a PEM-only map on the Kelvin side of
@@ -38,10 +38,11 @@ StatusOr<absl::flat_hash_set<OperatorIR*>> LimitPushdownRule::NewLimitParents(
         auto has_pem_only_udf,
         HasFuncWithExecutor(compiler_state_, current_node, udfspb::UDFSourceExecutor::UDF_PEM));
     if (!has_pem_only_udf) {
-      return NewLimitParents(current_node->parents()[0]);
+      return NewLimitParents(current_node->parents()[0], ordered);
     }
   }
-  // Unions will need at most N records from each source.
+  // Unions will need at most N records from each source. This holds for ordered limits too, the
+  // top N records of a union are among the top N records of its inputs.
   if (Match(current_node, Union())) {
     absl::flat_hash_set<OperatorIR*> results;
     // We want 1 Limit node after each union, and one before
@@ -49,7 +50,7 @@ StatusOr<absl::flat_hash_set<OperatorIR*>> LimitPushdownRule::NewLimitParents(
     results.insert(current_node);
 
     for (OperatorIR* parent : current_node->parents()) {
-      PL_ASSIGN_OR_RETURN(auto parent_results, NewLimitParents(parent));
+      PL_ASSIGN_OR_RETURN(auto parent_results, NewLimitParents(parent, ordered));
       for (OperatorIR* parent_result : parent_results) {
         results.insert(parent_result);
       }
@@ -70,7 +71,7 @@ StatusOr<bool> LimitPushdownRule::Apply(IRNode* ir_node) {
   DCHECK_EQ(1, limit->parents().size());
   OperatorIR* limit_parent = limit->parents()[0];
 
-  PL_ASSIGN_OR_RETURN(auto new_parents, NewLimitParents(limit_parent));
+  PL_ASSIGN_OR_RETURN(auto new_parents, NewLimitParents(limit_parent, limit->is_ordered()));
   // If we don't push the limit up at all, just return.
   if (new_parents.size() == 1 && new_parents.find(limit_parent) != new_parents.end()) {
     return false;
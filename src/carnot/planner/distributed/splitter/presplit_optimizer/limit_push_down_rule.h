@@ -29,7 +29,8 @@ namespace distributed {
 
 /**
  * @brief This rule pushes limits as early in the IR as possible, without pushing them
- * past PEM-only operators.
+ * past PEM-only operators. Ordered limits (top-k) are only pushed into the branches of unions,
+ * since a Map may change the columns they sort by.
  */
 class LimitPushdownRule : public Rule {
  public:
@@ -40,7 +41,8 @@ class LimitPushdownRule : public Rule {
   StatusOr<bool> Apply(IRNode*) override;
 
  private:
-  StatusOr<absl::flat_hash_set<OperatorIR*>> NewLimitParents(OperatorIR* current_node);
+  StatusOr<absl::flat_hash_set<OperatorIR*>> NewLimitParents(OperatorIR* current_node,
+                                                             bool ordered);
 };
 
 }  // namespace distributed
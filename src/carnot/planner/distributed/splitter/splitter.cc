@@ -33,12 +33,83 @@ namespace carnot {
 namespace planner {
 namespace distributed {
 
+bool AllSourcesAreMemorySources(OperatorIR* op) {
+  if (Match(op, SourceOperator())) {
+    return Match(op, MemorySource());
+  }
+  for (OperatorIR* parent : op->parents()) {
+    if (!AllSourcesAreMemorySources(parent)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns whether the column col_name of op is the upid column of a memory source, passed through
+// unchanged. A upid column that is computed, or renamed from another column, may hold the upids
+// of processes on other agents.
+bool IsSourceUPIDColumn(OperatorIR* op, const std::string& col_name) {
+  if (Match(op, MemorySource())) {
+    if (col_name != "upid" || !op->is_type_resolved()) {
+      return false;
+    }
+    auto type_or_s = op->resolved_table_type()->GetColumnType(col_name);
+    if (!type_or_s.ok() || !type_or_s.ValueOrDie()->IsValueType()) {
+      return false;
+    }
+    return std::static_pointer_cast<ValueType>(type_or_s.ValueOrDie())->data_type() ==
+           types::UINT128;
+  }
+  if (Match(op, Filter()) || Match(op, Limit())) {
+    return IsSourceUPIDColumn(op->parents()[0], col_name);
+  }
+  if (Match(op, Map())) {
+    auto map = static_cast<MapIR*>(op);
+    for (const auto& col_expr : map->col_exprs()) {
+      if (col_expr.name != col_name) {
+        continue;
+      }
+      if (col_expr.node->type() != IRNodeType::kColumn) {
+        return false;
+      }
+      auto col = static_cast<ColumnIR*>(col_expr.node);
+      return IsSourceUPIDColumn(op->parents()[0], col->col_name());
+    }
+    return map->keep_input_columns() && IsSourceUPIDColumn(op->parents()[0], col_name);
+  }
+  return false;
+}
+
+bool IsJoinPartitionedByAgent(OperatorIR* op) {
+  if (!Match(op, Join()) || !AllSourcesAreMemorySources(op)) {
+    return false;
+  }
+  auto join = static_cast<JoinIR*>(op);
+  if (join->join_type() != JoinIR::JoinType::kInner || join->parents().size() != 2) {
+    return false;
+  }
+  for (const auto& [i, left_col] : Enumerate(join->left_on_columns())) {
+    if (IsSourceUPIDColumn(join->parents()[0], left_col->col_name()) &&
+        IsSourceUPIDColumn(join->parents()[1], join->right_on_columns()[i]->col_name())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool BlocksOnKelvin(OperatorIR* op) {
+  // A join on the upids of table rows runs on each PEM, without sending either side to a Kelvin:
+  // the upid holds the ASID of the PEM whose process it is, so all the rows with the same upid are
+  // on the same PEM.
+  return op->IsBlocking() && !IsJoinPartitionedByAgent(op);
+}
+
 StatusOr<bool> OperatorMustRunOnKelvin(CompilerState* compiler_state, OperatorIR* op) {
   // If the operator can't run on a PEM, or is a blocking operator, we should
   // schedule this node to run on a Kelvin.
   PL_ASSIGN_OR_RETURN(bool runs_on_pem,
                       ScalarUDFsRunOnPEMRule::OperatorUDFsRunOnPEM(compiler_state, op));
-  return !runs_on_pem || op->IsBlocking();
+  return !runs_on_pem || BlocksOnKelvin(op);
 }
 
 StatusOr<bool> OperatorCanRunOnPEM(CompilerState* compiler_state, OperatorIR* op) {
@@ -46,7 +117,7 @@ StatusOr<bool> OperatorCanRunOnPEM(CompilerState* compiler_state, OperatorIR* op
   // schedule this node to run on a PEM.
   PL_ASSIGN_OR_RETURN(bool runs_on_pem,
                       ScalarUDFsRunOnPEMRule::OperatorUDFsRunOnPEM(compiler_state, op));
-  return runs_on_pem && !op->IsBlocking();
+  return runs_on_pem && !BlocksOnKelvin(op);
 }
 
 BlockingSplitNodeIDGroups Splitter::GetSplitGroups(
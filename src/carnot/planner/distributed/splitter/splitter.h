@@ -42,8 +42,9 @@ namespace distributed {
 
 /**
  * @brief A plan that is split around blocking nodes.
- * before_blocking: plan should have no blocking nodes and should end with nodes that feed into
- * GRPCSinks. No blocking nodes means there also should not be MemorySinks.
+ * before_blocking: plan should have no blocking nodes, other than inner joins on upid, and should
+ * end with nodes that feed into GRPCSinks. No blocking nodes means there also should not be
+ * MemorySinks.
  *
  * after_blocking: plan should have no memory sources, feed data in from GRPCSources and sink data
  * into MemorySinks.
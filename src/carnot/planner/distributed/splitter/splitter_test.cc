@@ -569,6 +569,91 @@ TEST_F(SplitterTest, agg_join_children) {
   EXPECT_EQ(join_parent->source_id(), grpc_sink->destination_id());
 }
 
+TEST_F(SplitterTest, upid_join_on_pem) {
+  table_store::schema::Relation relation({types::UINT128, types::INT64}, {"upid", "count"});
+  compiler_state_->relation_map()->emplace("source", relation);
+  auto mem_src1 = MakeMemSource("source", relation);
+  auto mem_src2 = MakeMemSource("source", relation);
+  auto inner_join =
+      MakeJoin({mem_src1, mem_src2}, "inner", relation, relation, {"upid"}, {"upid"}, {"", "_x"});
+  MakeMemSink(inner_join, "inner");
+  auto mem_src3 = MakeMemSource("source", relation);
+  auto mem_src4 = MakeMemSource("source", relation);
+  auto left_join =
+      MakeJoin({mem_src3, mem_src4}, "left", relation, relation, {"upid"}, {"upid"}, {"", "_x"});
+  MakeMemSink(left_join, "left");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  auto splitter_or_s = Splitter::Create(compiler_state_.get(), /* perform_partial_agg */ false);
+  ASSERT_OK(splitter_or_s);
+  std::unique_ptr<Splitter> splitter = splitter_or_s.ConsumeValueOrDie();
+  std::unique_ptr<BlockingSplitPlan> split_plan =
+      splitter->SplitKelvinAndAgents(graph.get()).ConsumeValueOrDie();
+  auto before_blocking = split_plan->before_blocking.get();
+  auto after_blocking = split_plan->after_blocking.get();
+
+  // The rows of a upid are all on the same PEM, so an inner join on upid runs on the PEMs.
+  ASSERT_TRUE(HasEquivalentInNewPlan(before_blocking, inner_join));
+  EXPECT_FALSE(HasEquivalentInNewPlan(after_blocking, inner_join));
+  HasGRPCSinkChild(inner_join->id(), before_blocking, "inner join");
+
+  // Joins that keep unmatched rows stay on the Kelvin.
+  EXPECT_FALSE(HasEquivalentInNewPlan(before_blocking, left_join));
+  ASSERT_TRUE(HasEquivalentInNewPlan(after_blocking, left_join));
+  auto new_left_join = GetEquivalentInNewPlan(after_blocking, left_join);
+  ASSERT_EQ(new_left_join->parents().size(), 2);
+  EXPECT_MATCH(new_left_join->parents()[0], GRPCSourceGroup());
+  EXPECT_MATCH(new_left_join->parents()[1], GRPCSourceGroup());
+}
+
+TEST_F(SplitterTest, renamed_upid_join_on_kelvin) {
+  table_store::schema::Relation relation({types::UINT128, types::UINT128, types::INT64},
+                                         {"upid", "remote_upid", "count"});
+  compiler_state_->relation_map()->emplace("source", relation);
+  table_store::schema::Relation map_relation({types::UINT128, types::INT64}, {"upid", "count"});
+
+  // The upid of a Map that passes the source's upid through unchanged still partitions by agent.
+  auto mem_src1 = MakeMemSource("source", relation);
+  auto mem_src2 = MakeMemSource("source", relation);
+  auto same_upid = MakeMap(mem_src2, {{"upid", MakeColumn("upid", 0)},
+                                      {"count", MakeColumn("count", 0)}});
+  auto same_upid_join = MakeJoin({mem_src1, same_upid}, "inner", relation, map_relation,
+                                 {"upid"}, {"upid"}, {"", "_x"});
+  MakeMemSink(same_upid_join, "same_upid");
+
+  // A upid column renamed from another upid may hold the processes of other agents.
+  auto mem_src3 = MakeMemSource("source", relation);
+  auto mem_src4 = MakeMemSource("source", relation);
+  auto renamed_upid = MakeMap(mem_src4, {{"upid", MakeColumn("remote_upid", 0)},
+                                         {"count", MakeColumn("count", 0)}});
+  auto renamed_upid_join = MakeJoin({mem_src3, renamed_upid}, "inner", relation, map_relation,
+                                    {"upid"}, {"upid"}, {"", "_x"});
+  MakeMemSink(renamed_upid_join, "renamed_upid");
+
+  ResolveTypesRule type_rule(compiler_state_.get());
+  ASSERT_OK(type_rule.Execute(graph.get()));
+
+  auto splitter_or_s = Splitter::Create(compiler_state_.get(), /* perform_partial_agg */ false);
+  ASSERT_OK(splitter_or_s);
+  std::unique_ptr<Splitter> splitter = splitter_or_s.ConsumeValueOrDie();
+  std::unique_ptr<BlockingSplitPlan> split_plan =
+      splitter->SplitKelvinAndAgents(graph.get()).ConsumeValueOrDie();
+  auto before_blocking = split_plan->before_blocking.get();
+  auto after_blocking = split_plan->after_blocking.get();
+
+  EXPECT_TRUE(HasEquivalentInNewPlan(before_blocking, same_upid_join));
+  EXPECT_FALSE(HasEquivalentInNewPlan(after_blocking, same_upid_join));
+
+  EXPECT_FALSE(HasEquivalentInNewPlan(before_blocking, renamed_upid_join));
+  ASSERT_TRUE(HasEquivalentInNewPlan(after_blocking, renamed_upid_join));
+  auto new_join = GetEquivalentInNewPlan(after_blocking, renamed_upid_join);
+  ASSERT_EQ(new_join->parents().size(), 2);
+  EXPECT_MATCH(new_join->parents()[0], GRPCSourceGroup());
+  EXPECT_MATCH(new_join->parents()[1], GRPCSourceGroup());
+}
+
 TEST_F(SplitterTest, simple_split_test) {
   auto mem_src = MakeMemSource("cpu", cpu_relation);
   auto map1 = MakeMap(mem_src, {{"cpu0", MakeColumn("cpu0", 0)}, {"cpu1", MakeColumn("cpu1", 0)}});
@@ -57,6 +57,11 @@ StatusOr<std::vector<absl::flat_hash_set<std::string>>> BlockingAggIR::RequiredI
   for (const auto& group : groups()) {
     required.insert(group->col_name());
   }
+  if (partial_input()) {
+    DCHECK(parents()[0]->is_type_resolved());
+    required.insert(parents()[0]->resolved_table_type()->ColumnNames().back());
+    return std::vector<absl::flat_hash_set<std::string>>{required};
+  }
   for (const auto& agg_expr : aggregate_expressions_) {
     PL_ASSIGN_OR_RETURN(auto ret, agg_expr.node->InputColumnNames());
     required.insert(ret.begin(), ret.end());
@@ -68,9 +73,16 @@ StatusOr<absl::flat_hash_set<std::string>> BlockingAggIR::PruneOutputColumnsToIm
     const absl::flat_hash_set<std::string>& output_colnames) {
   absl::flat_hash_set<std::string> kept_columns = output_colnames;
 
+  // The packed partials hold every aggregate expression, so they can't be pruned.
+  if (partial_input()) {
+    for (const auto& expr : aggregate_expressions_) {
+      kept_columns.insert(expr.name);
+    }
+  }
+
   ColExpressionVector new_aggs;
   for (const auto& expr : aggregate_expressions_) {
-    if (output_colnames.contains(expr.name)) {
+    if (kept_columns.contains(expr.name)) {
       new_aggs.push_back(expr);
     }
   }
@@ -108,7 +120,7 @@ Status BlockingAggIR::EvaluateAggregateExpression(planpb::AggregateExpression* e
 
 Status BlockingAggIR::ToProto(planpb::Operator* op) const {
   auto pb = op->mutable_agg_op();
-  if (finalize_results_ && !partial_agg_) {
+  if (partial_input()) {
     (*pb->mutable_values()) = pre_split_proto_.values();
     (*pb->mutable_value_names()) = pre_split_proto_.value_names();
   } else {
@@ -124,9 +136,18 @@ Status BlockingAggIR::ToProto(planpb::Operator* op) const {
     pb->add_group_names(group->col_name());
   }
 
-  pb->set_windowed(false);
+  pb->set_windowed(windowed_);
+  if (windowed_) {
+    pb->set_window_panes(window_panes_);
+  }
   pb->set_partial_agg(partial_agg_);
   pb->set_finalize_results(finalize_results_);
+  pb->set_merge_partials(merge_partials_);
+  pb->set_snapshot_interval_ms(snapshot_interval_ms_);
+  if (time_bin_group_ >= 0) {
+    pb->set_streaming_time_bins(true);
+    pb->set_time_bin_group(time_bin_group_);
+  }
 
   op->set_op_type(planpb::AGGREGATE_OPERATOR);
   return Status::OK();
@@ -154,7 +175,12 @@ Status BlockingAggIR::CopyFromNodeImpl(
 
   finalize_results_ = blocking_agg->finalize_results_;
   partial_agg_ = blocking_agg->partial_agg_;
+  merge_partials_ = blocking_agg->merge_partials_;
+  snapshot_interval_ms_ = blocking_agg->snapshot_interval_ms_;
+  time_bin_group_ = blocking_agg->time_bin_group_;
   pre_split_proto_ = blocking_agg->pre_split_proto_;
+  windowed_ = blocking_agg->windowed_;
+  window_panes_ = blocking_agg->window_panes_;
 
   return Status::OK();
 }
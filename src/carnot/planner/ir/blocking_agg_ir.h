@@ -69,8 +69,31 @@ class BlockingAggIR : public GroupAcceptorIR {
 
   void SetPartialAgg(bool partial_agg) { partial_agg_ = partial_agg; }
 
+  void SetMergePartials(bool merge_partials) { merge_partials_ = merge_partials; }
+
+  // Makes the aggregate emit a snapshot of its results so far every interval_ms.
+  void SetSnapshotIntervalMs(int64_t interval_ms) { snapshot_interval_ms_ = interval_ms; }
+  int64_t snapshot_interval_ms() const { return snapshot_interval_ms_; }
+  // The group that holds time bins which arrive in increasing order, or -1 if there is none.
+  // Partial aggregates emit the groups of each bin once the input is past it.
+  void SetTimeBinGroup(int64_t group_idx) { time_bin_group_ = group_idx; }
+  int64_t time_bin_group() const { return time_bin_group_; }
+
   bool partial_agg() const { return partial_agg_; }
   bool finalize_results() const { return finalize_results_; }
+  bool merge_partials() const { return merge_partials_; }
+  // Whether the input holds partial aggregates, packed in its last column, rather than the
+  // arguments of the aggregate expressions.
+  bool partial_input() const { return (finalize_results_ && !partial_agg_) || merge_partials_; }
+  // Makes the aggregate windowed: it emits a result at every eow of its input, instead of only at
+  // eos. Each result covers the last window_panes windows, so 1 is a tumbling window and more is
+  // a sliding window.
+  void SetWindowPanes(int64_t window_panes) {
+    windowed_ = true;
+    window_panes_ = window_panes;
+  }
+  bool windowed() const { return windowed_; }
+  int64_t window_panes() const { return window_panes_; }
   void SetPreSplitProto(const planpb::AggregateOperator& pre_split_proto) {
     pre_split_proto_ = pre_split_proto;
   }
@@ -86,7 +109,15 @@ class BlockingAggIR : public GroupAcceptorIR {
   bool partial_agg_ = true;
   // Whether this finalizes the result of a partial aggregate.
   bool finalize_results_ = true;
+  // Whether this merges partial aggregates into a partial aggregate, ie. it's an intermediate
+  // stage of a merge tree.
+  bool merge_partials_ = false;
+  // How often to emit a snapshot of the results so far, 0 for never.
+  int64_t snapshot_interval_ms_ = 0;
+  int64_t time_bin_group_ = -1;
   planpb::AggregateOperator pre_split_proto_;
+  bool windowed_ = false;
+  int64_t window_panes_ = 1;
 };
 }  // namespace planner
 }  // namespace carnot
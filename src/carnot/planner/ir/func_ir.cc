@@ -162,6 +162,8 @@ Status FuncIR::CopyFromNodeImpl(const IRNode* node,
   func_name_ = func->func_name_;
   registry_arg_types_ = func->registry_arg_types_;
   func_id_ = func->func_id_;
+  registry_info_ = func->registry_info_;
+  registry_func_id_ = func->registry_func_id_;
   supports_partial_ = func->supports_partial_;
   is_init_args_split_ = func->is_init_args_split_;
 
@@ -190,32 +192,39 @@ bool FuncIR::NodeMatches(IRNode* node) { return Match(node, Func()); }
 
 Status FuncIR::SetInfoFromRegistry(CompilerState* compiler_state,
                                    const std::vector<types::DataType>& registry_arg_types) {
-  registry_arg_types_ = registry_arg_types;
+  RegistryInfo* registry_info = compiler_state->registry_info();
+  if (registry_func_id_ < 0 || registry_info_ != registry_info ||
+      registry_arg_types_ != registry_arg_types) {
+    registry_arg_types_ = registry_arg_types;
+    registry_info_ = nullptr;
+    registry_func_id_ = -1;
 
-  auto udftype_or_s = compiler_state->registry_info()->GetUDFExecType(func_name());
-  if (!udftype_or_s.ok()) {
-    return CreateIRNodeError(udftype_or_s.status().msg());
+    auto udftype_or_s = registry_info->GetUDFExecType(func_name());
+    if (!udftype_or_s.ok()) {
+      return CreateIRNodeError(udftype_or_s.status().msg());
+    }
+    PL_ASSIGN_OR_RETURN(registry_func_id_,
+                        registry_info->GetFuncID(func_name(), registry_arg_types));
+    registry_info_ = registry_info;
   }
+  const RegistryInfo::FuncInfo& func_info = registry_info->func_info(registry_func_id_);
 
   if (!is_init_args_split_) {
-    PL_ASSIGN_OR_RETURN(size_t num_init_args, compiler_state->registry_info()->GetNumInitArgs(
-                                                  func_name(), registry_arg_types));
-    PL_RETURN_IF_ERROR(SplitInitArgs(num_init_args));
+    PL_RETURN_IF_ERROR(SplitInitArgs(func_info.num_init_args));
   }
 
   std::vector<uint64_t> init_arg_hashes;
   for (const auto& init_arg : init_args()) {
     init_arg_hashes.push_back(init_arg->HashValue());
   }
-  switch (udftype_or_s.ConsumeValueOrDie()) {
+  switch (func_info.exec_type) {
     case UDFExecType::kUDF: {
       func_id_ =
           compiler_state->GetUDFID(IDRegistryKey(func_name(), registry_arg_types, init_arg_hashes));
       break;
     }
     case UDFExecType::kUDA: {
-      PL_ASSIGN_OR_RETURN(supports_partial_, compiler_state->registry_info()->DoesUDASupportPartial(
-                                                 func_name(), registry_arg_types));
+      supports_partial_ = func_info.supports_partial;
       func_id_ =
           compiler_state->GetUDAID(IDRegistryKey(func_name(), registry_arg_types, init_arg_hashes));
       break;
@@ -243,8 +252,8 @@ Status FuncIR::ResolveType(CompilerState* compiler_state,
   // types::DataTypes.
   PL_RETURN_IF_ERROR(SetInfoFromRegistry(compiler_state, arg_data_types));
 
-  PL_ASSIGN_OR_RETURN(auto type_,
-                      compiler_state->registry_info()->ResolveUDFType(func_name(), arg_types));
+  PL_ASSIGN_OR_RETURN(auto type_, compiler_state->registry_info()->ResolveUDFType(
+                                       registry_func_id_, func_name(), arg_types));
   return SetResolvedType(type_);
 }
 
@@ -172,6 +172,10 @@ class FuncIR : public ExpressionIR {
   std::vector<ExpressionIR*> args_;
   std::vector<types::DataType> registry_arg_types_;
   int64_t func_id_ = 0;
+  // The overload of the function in registry_info_ that registry_arg_types_ resolved to, kept
+  // so that resolving the type of the call again doesn't repeat the registry lookups.
+  const RegistryInfo* registry_info_ = nullptr;
+  RegistryInfo::FuncID registry_func_id_ = -1;
   bool supports_partial_ = false;
   bool is_init_args_split_ = false;
 
@@ -31,6 +31,10 @@ Status GRPCSinkIR::CopyFromNodeImpl(const IRNode* node,
   destination_ssl_targetname_ = grpc_sink->destination_ssl_targetname_;
   name_ = grpc_sink->name_;
   out_columns_ = grpc_sink->out_columns_;
+  snapshots_ = grpc_sink->snapshots_;
+  hash_partition_columns_ = grpc_sink->hash_partition_columns_;
+  num_partitions_ = grpc_sink->num_partitions_;
+  partition_ = grpc_sink->partition_;
   return Status::OK();
 }
 
@@ -39,6 +43,7 @@ Status GRPCSinkIR::ToProto(planpb::Operator* op) const {
   auto pb = op->mutable_grpc_sink_op();
   op->set_op_type(planpb::GRPC_SINK_OPERATOR);
   pb->mutable_output_table()->set_table_name(name());
+  pb->mutable_output_table()->set_snapshots(snapshots_);
   pb->set_address(destination_address());
   pb->mutable_connection_options()->set_ssl_targetname(destination_ssl_targetname());
 
@@ -56,12 +61,26 @@ Status GRPCSinkIR::ToProto(planpb::Operator* op) const {
 Status GRPCSinkIR::ToProto(planpb::Operator* op, int64_t agent_id) const {
   auto pb = op->mutable_grpc_sink_op();
   op->set_op_type(planpb::GRPC_SINK_OPERATOR);
-  pb->set_address(destination_address());
-  pb->mutable_connection_options()->set_ssl_targetname(destination_ssl_targetname());
+  auto address_iter = agent_id_to_destination_address_.find(agent_id);
+  if (address_iter != agent_id_to_destination_address_.end()) {
+    pb->set_address(address_iter->second.first);
+    pb->mutable_connection_options()->set_ssl_targetname(address_iter->second.second);
+  } else {
+    pb->set_address(destination_address());
+    pb->mutable_connection_options()->set_ssl_targetname(destination_ssl_targetname());
+  }
   if (!agent_id_to_destination_id_.contains(agent_id)) {
     return CreateIRNodeError("No agent ID '$0' found in grpc sink '$1'", agent_id, DebugString());
   }
   pb->set_grpc_source_id(agent_id_to_destination_id_.find(agent_id)->second);
+  if (has_hash_partition()) {
+    auto hash_partition = pb->mutable_hash_partition();
+    for (int64_t col_idx : hash_partition_columns_) {
+      hash_partition->add_column_indexes(col_idx);
+    }
+    hash_partition->set_num_partitions(num_partitions_);
+    hash_partition->set_partition(partition_);
+  }
   return Status::OK();
 }
 
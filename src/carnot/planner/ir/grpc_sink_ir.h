@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "src/carnot/planner/compiler_state/compiler_state.h"
@@ -110,6 +111,28 @@ class GRPCSinkIR : public OperatorIR {
     destination_ssl_targetname_ = ssl_targetname;
   }
 
+  // Sets the destination of a single agent's instance of this sink, for plans that are shared by
+  // agents that send to different Carnot instances.
+  void AddDestinationAddressMap(int64_t agent_id, const std::string& address,
+                                std::string_view ssl_targetname) {
+    agent_id_to_destination_address_[agent_id] = {address, std::string(ssl_targetname)};
+  }
+
+  /**
+   * @brief Makes the sink one of the senders of a shuffle, that only sends the rows whose values in
+   * the given input columns hash to `partition` out of `num_partitions`.
+   */
+  void SetHashPartition(const std::vector<int64_t>& column_indexes, int64_t num_partitions,
+                        int64_t partition) {
+    hash_partition_columns_ = column_indexes;
+    num_partitions_ = num_partitions;
+    partition_ = partition;
+  }
+  bool has_hash_partition() const { return num_partitions_ > 0; }
+  const std::vector<int64_t>& hash_partition_columns() const { return hash_partition_columns_; }
+  int64_t num_partitions() const { return num_partitions_; }
+  int64_t partition() const { return partition_; }
+
   const std::string& destination_address() const { return destination_address_; }
   bool DestinationAddressSet() const { return destination_address_ != ""; }
   const std::string& destination_ssl_targetname() const { return destination_ssl_targetname_; }
@@ -119,6 +142,9 @@ class GRPCSinkIR : public OperatorIR {
   void set_name(const std::string& name) { name_ = name; }
   // When out_columns_ is empty, the full input relation will be written to the sink.
   const std::vector<std::string>& out_columns() const { return out_columns_; }
+  // Marks the input of an external sink as a sequence of result snapshots, each ended by eow.
+  void SetSnapshots(bool snapshots) { snapshots_ = snapshots; }
+  bool snapshots() const { return snapshots_; }
 
   inline bool IsBlocking() const override { return true; }
 
@@ -155,7 +181,15 @@ class GRPCSinkIR : public OperatorIR {
   // Used when GRPCSinkType = kExternal.
   std::string name_;
   std::vector<std::string> out_columns_;
+  bool snapshots_ = false;
   absl::flat_hash_map<int64_t, int64_t> agent_id_to_destination_id_;
+  // The (address, ssl target name) of an agent, if it differs from destination_address_.
+  absl::flat_hash_map<int64_t, std::pair<std::string, std::string>>
+      agent_id_to_destination_address_;
+  // Set when the sink only sends one hash partition of its input.
+  std::vector<int64_t> hash_partition_columns_;
+  int64_t num_partitions_ = 0;
+  int64_t partition_ = 0;
 };
 
 }  // namespace planner
@@ -74,6 +74,7 @@ class GRPCSourceGroupIR : public OperatorIR {
   bool GRPCAddressSet() const { return grpc_address_ != ""; }
   const std::string& grpc_address() const { return grpc_address_; }
   int64_t source_id() const { return source_id_; }
+  void SetSourceID(int64_t source_id) { source_id_ = source_id; }
   const std::vector<std::pair<GRPCSinkIR*, absl::flat_hash_set<int64_t>>>& dependent_sinks() {
     return dependent_sinks_;
   }
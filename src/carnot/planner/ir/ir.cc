@@ -28,8 +28,31 @@ namespace px {
 namespace carnot {
 namespace planner {
 
+IR::~IR() {
+  for (IRNode* node : nodes_) {
+    if (node != nullptr) {
+      node->~IRNode();
+    }
+  }
+}
+
+void IR::MarkNodeChanged(int64_t id) {
+  DCHECK_GE(id, 0);
+  if (static_cast<size_t>(id) >= node_change_versions_.size()) {
+    node_change_versions_.resize(id + 1, 0);
+  }
+  node_change_versions_[id] = ++change_version_;
+}
+
+void IR::ReserveNodeIDs(int64_t num_ids) {
+  nodes_.reserve(num_ids);
+  node_change_versions_.reserve(num_ids);
+}
+
 Status IR::AddEdge(int64_t from_node, int64_t to_node) {
   dag_.AddEdge(from_node, to_node);
+  MarkNodeChanged(from_node);
+  MarkNodeChanged(to_node);
   return Status::OK();
 }
 
@@ -54,6 +77,8 @@ Status IR::DeleteEdge(int64_t from_node, int64_t to_node) {
     return error::InvalidArgument("No edge ($0, $1) exists.", from_node, to_node);
   }
   dag_.DeleteEdge(from_node, to_node);
+  MarkNodeChanged(from_node);
+  MarkNodeChanged(to_node);
   return Status::OK();
 }
 
@@ -78,6 +103,7 @@ Status IR::DeleteOrphansInSubtree(int64_t id) {
 Status IR::DeleteSubtree(int64_t id) {
   for (const auto& p : dag_.ParentsOf(id)) {
     dag_.DeleteEdge(p, id);
+    MarkNodeChanged(p);
   }
   return DeleteOrphansInSubtree(id);
 }
@@ -86,11 +112,42 @@ Status IR::DeleteNode(int64_t node) {
   if (!dag_.HasNode(node)) {
     return error::InvalidArgument("No node $0 exists in graph.", node);
   }
+  for (int64_t parent : dag_.ParentsOf(node)) {
+    MarkNodeChanged(parent);
+  }
+  for (int64_t child : dag_.DependenciesOf(node)) {
+    MarkNodeChanged(child);
+  }
   dag_.DeleteNode(node);
-  id_node_map_.erase(node);
+  if (static_cast<size_t>(node) < nodes_.size() && nodes_[node] != nullptr) {
+    // The memory of the node stays in the arena until the IR is destroyed.
+    nodes_[node]->~IRNode();
+    nodes_[node] = nullptr;
+    --num_nodes_;
+  }
+  if (static_cast<size_t>(node) < node_change_versions_.size()) {
+    node_change_versions_[node] = 0;
+  }
   return Status::OK();
 }
 
+absl::flat_hash_set<int64_t> IR::NodesChangedSince(int64_t version) const {
+  absl::flat_hash_set<int64_t> changed;
+  for (const auto& [id, node_version] : Enumerate(node_change_versions_)) {
+    if (node_version <= version) {
+      continue;
+    }
+    changed.insert(id);
+    for (int64_t parent : dag_.ParentsOf(id)) {
+      changed.insert(parent);
+    }
+    for (int64_t child : dag_.DependenciesOf(id)) {
+      changed.insert(child);
+    }
+  }
+  return changed;
+}
+
 StatusOr<IRNode*> IR::MakeNodeWithType(IRNodeType node_type, int64_t new_node_id) {
   switch (node_type) {
 #undef PL_IR_NODE
@@ -109,8 +166,10 @@ StatusOr<IRNode*> IR::MakeNodeWithType(IRNodeType node_type, int64_t new_node_id
 
 std::string IR::DebugString() const {
   std::string debug_string = dag().DebugString() + "\n";
-  for (auto const& a : id_node_map_) {
-    debug_string += a.second->DebugString() + "\n";
+  for (IRNode* node : nodes_) {
+    if (node != nullptr) {
+      debug_string += node->DebugString() + "\n";
+    }
   }
   return debug_string;
 }
@@ -179,6 +238,7 @@ std::vector<absl::flat_hash_set<int64_t>> IR::IndependentGraphs() const {
 
 StatusOr<std::unique_ptr<IR>> IR::Clone() const {
   auto new_ir = std::make_unique<IR>();
+  new_ir->ReserveNodeIDs(nodes_.size());
   absl::flat_hash_set<int64_t> nodes{dag().nodes().begin(), dag().nodes().end()};
   PL_RETURN_IF_ERROR(new_ir->CopySelectedNodesAndDeps(this, nodes));
   // TODO(philkuz) check to make sure these are the same.
@@ -189,6 +249,7 @@ StatusOr<std::unique_ptr<IR>> IR::Clone() const {
 Status IR::CopySelectedNodesAndDeps(const IR* src,
                                     const absl::flat_hash_set<int64_t>& selected_nodes) {
   absl::flat_hash_map<const IRNode*, IRNode*> copied_nodes_map;
+  copied_nodes_map.reserve(selected_nodes.size());
   // Need to perform the copies in topological sort order to ensure the edges can be successfully
   // added.
   for (int64_t i : src->dag().TopologicalSort()) {
@@ -220,11 +281,10 @@ Status IR::CopyOperatorSubgraph(const IR* src,
 StatusOr<planpb::Plan> IR::ToProto() const { return ToProto(0); }
 
 IRNode* IR::Get(int64_t id) const {
-  auto iterator = id_node_map_.find(id);
-  if (iterator == id_node_map_.end()) {
+  if (id < 0 || static_cast<size_t>(id) >= nodes_.size()) {
     return nullptr;
   }
-  return iterator->second.get();
+  return nodes_[id];
 }
 
 StatusOr<planpb::Plan> IR::ToProto(int64_t agent_id) const {
@@ -251,6 +311,24 @@ StatusOr<planpb::Plan> IR::ToProto(int64_t agent_id) const {
   return plan;
 }
 
+Status IR::UpdateProtoForAgent(planpb::Plan* plan, int64_t agent_id) const {
+  for (auto& plan_fragment : *plan->mutable_nodes()) {
+    for (auto& plan_node : *plan_fragment.mutable_nodes()) {
+      if (!plan_node.op().has_grpc_sink_op()) {
+        continue;
+      }
+      DCHECK(HasNode(plan_node.id()));
+      const auto* grpc_sink = static_cast<const GRPCSinkIR*>(Get(plan_node.id()));
+      if (grpc_sink->has_output_table()) {
+        continue;
+      }
+      plan_node.mutable_op()->Clear();
+      PL_RETURN_IF_ERROR(grpc_sink->ToProto(plan_node.mutable_op(), agent_id));
+    }
+  }
+  return Status::OK();
+}
+
 Status IR::OutputProto(planpb::PlanFragment* pf, const OperatorIR* op_node,
                        int64_t agent_id) const {
   // Check to make sure that the type is resolved for this op_node, otherwise it's not connected to
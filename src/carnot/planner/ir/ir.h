@@ -35,6 +35,7 @@
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/compilerpb/compiler_status.pb.h"
 #include "src/carnot/planner/ir/ir_node.h"
+#include "src/carnot/planner/ir/ir_node_arena.h"
 #include "src/carnot/planner/ir/ir_node_traits.h"
 #include "src/carnot/planner/types/types.h"
 #include "src/carnot/udfspb/udfs.pb.h"
@@ -56,11 +57,15 @@ class OperatorIR;
  */
 class IR {
  public:
+  IR() = default;
+  ~IR();
+
   /**
    * @brief Node factory that adds a node to the list,
    * updates an id, then returns a pointer to manipulate.
    *
-   * The object will be owned by the IR object that created it.
+   * The object will be owned by the IR object that created it, and is allocated from the IR's
+   * arena.
    *
    * @tparam TOperator the type of the operator.
    * @return StatusOr<TOperator *> - the node will be owned
@@ -76,16 +81,23 @@ class IR {
   }
   template <typename TOperator>
   StatusOr<TOperator*> MakeNode(int64_t id, const pypa::AstPtr& ast) {
+    DCHECK_GE(id, 0);
     id_node_counter = std::max(id + 1, id_node_counter);
-    auto node = std::make_unique<TOperator>(id);
+    if (static_cast<size_t>(id) >= nodes_.size()) {
+      nodes_.resize(id + 1, nullptr);
+      node_change_versions_.resize(id + 1, 0);
+    }
+    DCHECK(nodes_[id] == nullptr) << "Node " << id << " already exists.";
+    auto node = new (arena_.Allocate(sizeof(TOperator), alignof(TOperator))) TOperator(id);
     dag_.AddNode(node->id());
     node->set_graph(this);
     if (ast != nullptr) {
       node->SetLineCol(ast);
     }
-    TOperator* raw = node.get();
-    id_node_map_.emplace(node->id(), std::move(node));
-    return raw;
+    nodes_[id] = node;
+    ++num_nodes_;
+    MarkNodeChanged(node->id());
+    return node;
   }
   StatusOr<IRNode*> MakeNodeWithType(IRNodeType node_type, int64_t new_node_id);
 
@@ -185,7 +197,7 @@ class IR {
    */
   IRNode* Get(int64_t id) const;
 
-  size_t size() const { return id_node_map_.size(); }
+  size_t size() const { return num_nodes_; }
 
   std::vector<OperatorIR*> GetSources() const;
 
@@ -209,6 +221,12 @@ class IR {
   StatusOr<planpb::Plan> ToProto() const;
   StatusOr<planpb::Plan> ToProto(int64_t agent_id) const;
 
+  /**
+   * @brief Updates a plan that ToProto produced for another agent to the plan of agent_id. Only
+   * the GRPCSinks differ between agents, so this is cheaper than calling ToProto(agent_id) again.
+   */
+  Status UpdateProtoForAgent(planpb::Plan* plan, int64_t agent_id) const;
+
   /**
    * @brief Removes the nodes and edges listed in the following set.
    *
@@ -258,6 +276,34 @@ class IR {
     return nodes;
   }
 
+  /**
+   * @brief Records that the node changed. Nodes are marked when they're created and when their
+   * edges change, rules mark the nodes that they report changes on.
+   */
+  void MarkNodeChanged(int64_t id);
+
+  /**
+   * @brief Records a change that isn't tied to specific nodes, after which every node has to be
+   * treated as changed.
+   */
+  void MarkGraphChanged() { graph_change_version_ = ++change_version_; }
+
+  /**
+   * @brief The version of the graph, which increases with every recorded change.
+   */
+  int64_t change_version() const { return change_version_; }
+
+  /**
+   * @brief The version of the last change recorded by MarkGraphChanged.
+   */
+  int64_t graph_change_version() const { return graph_change_version_; }
+
+  /**
+   * @brief Returns the nodes that changed after the given version, and their parents and
+   * children.
+   */
+  absl::flat_hash_set<int64_t> NodesChangedSince(int64_t version) const;
+
   friend std::ostream& operator<<(std::ostream& os, const std::shared_ptr<IR>&) {
     return os << "ir";
   }
@@ -267,9 +313,21 @@ class IR {
   // Helper function for Clone and CopySelectedOperators.
   Status CopySelectedNodesAndDeps(const IR* src, const absl::flat_hash_set<int64_t>& selected_ids);
 
+  // Reserves room for the nodes of an IR with the given ids.
+  void ReserveNodeIDs(int64_t num_ids);
+
   plan::DAG dag_;
-  std::unordered_map<int64_t, IRNodePtr> id_node_map_;
+  IRNodeArena arena_;
+  // The nodes indexed by their ids, which are dense because they come from id_node_counter.
+  // Deleted nodes leave a nullptr.
+  std::vector<IRNode*> nodes_;
+  size_t num_nodes_ = 0;
   int64_t id_node_counter = 0;
+
+  int64_t change_version_ = 0;
+  int64_t graph_change_version_ = 0;
+  // The version of the last change of each node, indexed like nodes_. 0 if never changed.
+  std::vector<int64_t> node_change_versions_;
 };
 
 Status ResolveOperatorType(OperatorIR* op, CompilerState* compiler_state);
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/ir/ir_node_arena.h"
+
+#include <cstdint>
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+void* IRNodeArena::Allocate(size_t size, size_t alignment) {
+  DCHECK_LE(alignment, static_cast<size_t>(__STDCPP_DEFAULT_NEW_ALIGNMENT__));
+  bytes_allocated_ += size;
+  auto aligned = [alignment](char* p) {
+    auto addr = reinterpret_cast<uintptr_t>(p);
+    return reinterpret_cast<char*>((addr + alignment - 1) & ~(alignment - 1));
+  };
+  if (pos_ != nullptr) {
+    char* start = aligned(pos_);
+    if (start + size <= end_) {
+      pos_ = start + size;
+      return start;
+    }
+  }
+  // Objects larger than a quarter of a block get a block of their own, so that they don't waste
+  // the rest of the current block.
+  if (size > kBlockSize / 4) {
+    blocks_.emplace_back(new char[size]);
+    return blocks_.back().get();
+  }
+  blocks_.emplace_back(new char[kBlockSize]);
+  pos_ = blocks_.back().get() + size;
+  end_ = blocks_.back().get() + kBlockSize;
+  return blocks_.back().get();
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+/**
+ * @brief IRNodeArena allocates the nodes of an IR from large blocks, which are freed together
+ * when the arena is destroyed. Compiling a script creates and deletes many small nodes, so this
+ * replaces an allocation per node with a pointer bump.
+ *
+ * The arena doesn't own the objects that it allocates: the caller constructs them in place and
+ * destroys them, after which their memory stays unused until the arena is destroyed.
+ */
+class IRNodeArena : public NotCopyable {
+ public:
+  IRNodeArena() = default;
+
+  /**
+   * @brief Returns memory for an object of the given size and alignment.
+   */
+  void* Allocate(size_t size, size_t alignment);
+
+  size_t bytes_allocated() const { return bytes_allocated_; }
+
+ private:
+  static constexpr size_t kBlockSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* pos_ = nullptr;
+  char* end_ = nullptr;
+  size_t bytes_allocated_ = 0;
+};
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
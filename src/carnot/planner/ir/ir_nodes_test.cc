@@ -515,6 +515,51 @@ TEST_F(ToProtoTest, agg_ir_with_presplit_proto) {
   EXPECT_THAT(cloned_pb, EqualsProto(kExpectedAggPb));
 }
 
+TEST_F(ToProtoTest, agg_ir_sliding_window) {
+  auto mem_src = graph
+                     ->CreateNode<MemorySourceIR>(
+                         ast, "source", std::vector<std::string>{"col1", "group1", "column"})
+                     .ValueOrDie();
+  table_store::schema::Relation rel({types::INT64, types::INT64, types::INT64},
+                                    {"col1", "group1", "column"});
+  compiler_state_->relation_map()->emplace("source", rel);
+  auto constant = graph->CreateNode<IntIR>(ast, 10).ValueOrDie();
+  auto col = graph->CreateNode<ColumnIR>(ast, "column", /*parent_op_idx*/ 0).ValueOrDie();
+  EXPECT_OK(col->SetResolvedType(ValueType::Create(types::INT64, types::ST_NONE)));
+
+  auto agg_func = graph
+                      ->CreateNode<FuncIR>(ast, FuncIR::Op{FuncIR::Opcode::non_op, "", "mean"},
+                                           std::vector<ExpressionIR*>{constant, col})
+                      .ValueOrDie();
+  EXPECT_OK(AddUDAToRegistry("mean", types::INT64, {types::INT64, types::INT64}));
+  auto group1 = graph->CreateNode<ColumnIR>(ast, "group1", /*parent_op_idx*/ 0).ValueOrDie();
+  EXPECT_OK(group1->SetResolvedType(ValueType::Create(types::INT64, types::ST_NONE)));
+
+  auto agg = graph
+                 ->CreateNode<BlockingAggIR>(ast, mem_src, std::vector<ColumnIR*>{group1},
+                                             ColExpressionVector{{"mean", agg_func}})
+                 .ValueOrDie();
+  agg->SetWindowPanes(3);
+
+  ASSERT_OK(ResolveOperatorType(mem_src, compiler_state_.get()));
+  ASSERT_OK(ResolveOperatorType(agg, compiler_state_.get()));
+
+  planpb::Operator expected_pb;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kExpectedAggPb, &expected_pb));
+  expected_pb.mutable_agg_op()->set_windowed(true);
+  expected_pb.mutable_agg_op()->set_window_panes(3);
+
+  planpb::Operator pb;
+  ASSERT_OK(agg->ToProto(&pb));
+  EXPECT_THAT(pb, EqualsProto(expected_pb.DebugString()));
+
+  // Copies keep the window.
+  ASSERT_OK_AND_ASSIGN(BlockingAggIR * cloned_agg, graph->CopyNode(agg));
+  ASSERT_OK(cloned_agg->CopyParentsFrom(agg));
+  EXPECT_TRUE(cloned_agg->windowed());
+  EXPECT_EQ(3, cloned_agg->window_panes());
+}
+
 constexpr char kExpectedLimitPb[] = R"(
   op_type: LIMIT_OPERATOR
   limit_op {
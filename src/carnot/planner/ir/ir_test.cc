@@ -32,6 +32,33 @@ namespace px {
 namespace carnot {
 namespace planner {
 
+TEST(IRTest, delete_node) {
+  IR ir;
+  auto src = ir.CreateNode<MemorySourceIR>(nullptr, "table", std::vector<std::string>{})
+                 .ConsumeValueOrDie();
+  auto map = ir.CreateNode<MapIR>(nullptr, src, ColExpressionVector{}, true).ConsumeValueOrDie();
+  auto sink = ir.CreateNode<MemorySinkIR>(nullptr, map, "output", std::vector<std::string>{})
+                  .ConsumeValueOrDie();
+  EXPECT_EQ(3, ir.size());
+  int64_t version = ir.change_version();
+
+  int64_t map_id = map->id();
+  ASSERT_OK(ir.DeleteEdge(src, map));
+  ASSERT_OK(ir.DeleteEdge(map, sink));
+  ASSERT_OK(ir.DeleteNode(map_id));
+  EXPECT_EQ(2, ir.size());
+  EXPECT_EQ(nullptr, ir.Get(map_id));
+  EXPECT_EQ(src, ir.Get(src->id()));
+  EXPECT_EQ(nullptr, ir.Get(sink->id() + 1));
+  EXPECT_THAT(ir.NodesChangedSince(version), UnorderedElementsAre(src->id(), sink->id()));
+
+  // New nodes get new ids rather than the ids of deleted nodes.
+  auto src2 = ir.CreateNode<MemorySourceIR>(nullptr, "table", std::vector<std::string>{})
+                  .ConsumeValueOrDie();
+  EXPECT_GT(src2->id(), sink->id());
+  EXPECT_EQ(3, ir.size());
+}
+
 TEST(IndependentGraphs, simple_map) {
   IR ir;
   // First connected component is a simple map:
@@ -51,6 +51,15 @@ Status JoinIR::CopyFromNodeImpl(const IRNode* node,
 
   PL_RETURN_IF_ERROR(SetJoinColumns(new_left_columns, new_right_columns));
   suffix_strs_ = join_node->suffix_strs_;
+
+  if (join_node->as_of_) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * left_time_column,
+                        graph()->CopyNode(join_node->left_time_column_, copied_nodes_map));
+    PL_ASSIGN_OR_RETURN(ColumnIR * right_time_column,
+                        graph()->CopyNode(join_node->right_time_column_, copied_nodes_map));
+    PL_RETURN_IF_ERROR(
+        SetAsOf(left_time_column, right_time_column, join_node->as_of_tolerance_ns_));
+  }
   return Status::OK();
 }
 
@@ -111,6 +120,14 @@ Status JoinIR::ToProto(planpb::Operator* op) const {
   for (const auto& col_name : column_names_) {
     *(pb->add_column_names()) = col_name;
   }
+  if (as_of_) {
+    PL_ASSIGN_OR_RETURN(auto left_time_index, left_time_column_->GetColumnIndex());
+    PL_ASSIGN_OR_RETURN(auto right_time_index, right_time_column_->GetColumnIndex());
+    pb->set_as_of(true);
+    pb->set_left_time_column_index(left_time_index);
+    pb->set_right_time_column_index(right_time_index);
+    pb->set_as_of_tolerance_ns(as_of_tolerance_ns_);
+  }
   // NOTE: not setting value as this is set in the execution engine. Keeping this here in case it
   // needs to be modified in the future.
   // pb->set_rows_per_batch(1024);
@@ -156,6 +173,22 @@ Status JoinIR::SetJoinColumns(const std::vector<ColumnIR*>& left_columns,
   return Status::OK();
 }
 
+Status JoinIR::SetAsOf(ColumnIR* left_time_column, ColumnIR* right_time_column,
+                      int64_t tolerance_ns) {
+  if (join_type_ != JoinType::kInner && join_type_ != JoinType::kLeft) {
+    return CreateIRNodeError("As-of joins must be 'inner' or 'left' joins.");
+  }
+  if (tolerance_ns < 0) {
+    return CreateIRNodeError("As-of join tolerance must not be negative.");
+  }
+  PL_ASSIGN_OR_RETURN(left_time_column_, graph()->OptionallyCloneWithEdge(this, left_time_column));
+  PL_ASSIGN_OR_RETURN(right_time_column_,
+                      graph()->OptionallyCloneWithEdge(this, right_time_column));
+  as_of_tolerance_ns_ = tolerance_ns;
+  as_of_ = true;
+  return Status::OK();
+}
+
 StatusOr<std::vector<absl::flat_hash_set<std::string>>> JoinIR::RequiredInputColumns() const {
   DCHECK(key_columns_set_);
   DCHECK(!output_columns_.empty());
@@ -174,6 +207,10 @@ StatusOr<std::vector<absl::flat_hash_set<std::string>>> JoinIR::RequiredInputCol
     DCHECK(col->container_op_parent_idx_set());
     ret[col->container_op_parent_idx()].insert(col->col_name());
   }
+  if (as_of_) {
+    ret[left_time_column_->container_op_parent_idx()].insert(left_time_column_->col_name());
+    ret[right_time_column_->container_op_parent_idx()].insert(right_time_column_->col_name());
+  }
 
   return ret;
 }
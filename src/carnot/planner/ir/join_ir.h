@@ -90,6 +90,17 @@ class JoinIR : public OperatorIR {
                           const std::vector<ColumnIR*>& columns);
   bool specified_as_right() const { return specified_as_right_; }
 
+  /**
+   * @brief Makes this an as-of join, where each left row is joined with the latest right row with
+   * the same keys whose time is at or before the left row's time, and no more than tolerance_ns
+   * older.
+   */
+  Status SetAsOf(ColumnIR* left_time_column, ColumnIR* right_time_column, int64_t tolerance_ns);
+  bool as_of() const { return as_of_; }
+  ColumnIR* left_time_column() const { return left_time_column_; }
+  ColumnIR* right_time_column() const { return right_time_column_; }
+  int64_t as_of_tolerance_ns() const { return as_of_tolerance_ns_; }
+
   StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override;
 
   const std::tuple<std::shared_ptr<TableType>, std::shared_ptr<TableType>> left_right_table_types()
@@ -161,6 +172,12 @@ class JoinIR : public OperatorIR {
   // Whether this join was originally specified as a right join.
   // Used because we transform left joins into right joins but need to do some back transform.
   bool specified_as_right_ = false;
+
+  // The time columns of each parent and the tolerance of as-of joins.
+  bool as_of_ = false;
+  ColumnIR* left_time_column_ = nullptr;
+  ColumnIR* right_time_column_ = nullptr;
+  int64_t as_of_tolerance_ns_ = 0;
 };
 
 }  // namespace planner
@@ -30,10 +30,31 @@ Status LimitIR::Init(OperatorIR* parent, int64_t limit_value, bool pem_only) {
   return Status::OK();
 }
 
+Status LimitIR::Init(OperatorIR* parent, int64_t limit_value,
+                     const std::vector<std::string>& sort_columns, bool sort_ascending) {
+  PL_RETURN_IF_ERROR(Init(parent, limit_value));
+  SetSortColumns(sort_columns, sort_ascending);
+  return Status::OK();
+}
+
 StatusOr<std::vector<absl::flat_hash_set<std::string>>> LimitIR::RequiredInputColumns() const {
   DCHECK(is_type_resolved());
-  return std::vector<absl::flat_hash_set<std::string>>{
-      {resolved_table_type()->ColumnNames().begin(), resolved_table_type()->ColumnNames().end()}};
+  absl::flat_hash_set<std::string> required_cols(resolved_table_type()->ColumnNames().begin(),
+                                                 resolved_table_type()->ColumnNames().end());
+  required_cols.insert(sort_columns_.begin(), sort_columns_.end());
+  return std::vector<absl::flat_hash_set<std::string>>{required_cols};
+}
+
+Status LimitIR::ResolveType(CompilerState* /* compiler_state */) {
+  DCHECK_EQ(1U, parent_types().size());
+  auto parent_table_type = std::static_pointer_cast<TableType>(parent_types()[0]);
+  for (const auto& col_name : sort_columns_) {
+    if (!parent_table_type->HasColumn(col_name)) {
+      return CreateIRNodeError("Column '$0' not found in parent dataframe", col_name);
+    }
+  }
+  PL_ASSIGN_OR_RETURN(auto type_ptr, OperatorIR::DefaultResolveType(parent_types()));
+  return SetResolvedType(type_ptr);
 }
 
 Status LimitIR::ToProto(planpb::Operator* op) const {
@@ -60,6 +81,14 @@ Status LimitIR::ToProto(planpb::Operator* op) const {
   for (const auto src_id : abortable_srcs_) {
     pb->add_abortable_srcs(src_id);
   }
+  for (const std::string& col_name : sort_columns_) {
+    planpb::Column* col_pb = pb->add_sort_columns();
+    col_pb->set_node(parent_id);
+    DCHECK(parent_table_type->HasColumn(col_name));
+    col_pb->set_index(parent_table_type->GetColumnIndex(col_name));
+  }
+  pb->set_sort_ascending(sort_ascending_);
+  pb->set_per_window(per_window_);
   return Status::OK();
 }
 
@@ -68,6 +97,9 @@ Status LimitIR::CopyFromNodeImpl(const IRNode* node, absl::flat_hash_map<const I
   limit_value_ = limit->limit_value_;
   limit_value_set_ = limit->limit_value_set_;
   pem_only_ = limit->pem_only_;
+  sort_columns_ = limit->sort_columns_;
+  sort_ascending_ = limit->sort_ascending_;
+  per_window_ = limit->per_window_;
   return Status::OK();
 }
 
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <algorithm>
+#include <limits>
 #include <memory>
 #include <string>
 #include <unordered_set>
@@ -40,6 +41,9 @@ class LimitIR : public OperatorIR {
   LimitIR() = delete;
   explicit LimitIR(int64_t id) : OperatorIR(id, IRNodeType::kLimit) {}
 
+  // The limit value of an ordered limit that keeps every row, i.e. a sort.
+  static constexpr int64_t kUnlimited = std::numeric_limits<int64_t>::max();
+
   Status ToProto(planpb::Operator*) const override;
   void SetLimitValue(int64_t value) {
     limit_value_ = value;
@@ -49,11 +53,29 @@ class LimitIR : public OperatorIR {
   int64_t limit_value() const { return limit_value_; }
   bool pem_only() const { return pem_only_; }
 
+  /**
+   * @brief Makes this an ordered limit (top-k), which keeps the limit_value rows that come first
+   * when sorted by the given columns instead of the first rows it sees.
+   */
+  void SetSortColumns(const std::vector<std::string>& sort_columns, bool ascending) {
+    sort_columns_ = sort_columns;
+    sort_ascending_ = ascending;
+  }
+  const std::vector<std::string>& sort_columns() const { return sort_columns_; }
+  bool sort_ascending() const { return sort_ascending_; }
+  bool is_ordered() const { return !sort_columns_.empty(); }
+
+  // Makes every eow of the input restart the count, for inputs that are sequences of snapshots.
+  void SetPerWindow(bool per_window) { per_window_ = per_window; }
+  bool per_window() const { return per_window_; }
+
   void AddAbortableSource(int64_t src_id) { abortable_srcs_.insert(src_id); }
 
   const std::unordered_set<int64_t>& abortable_srcs() const { return abortable_srcs_; }
 
   Status Init(OperatorIR* parent, int64_t limit_value, bool pem_only = false);
+  Status Init(OperatorIR* parent, int64_t limit_value, const std::vector<std::string>& sort_columns,
+              bool sort_ascending);
 
   Status CopyFromNodeImpl(const IRNode* node,
                           absl::flat_hash_map<const IRNode*, IRNode*>* copied_nodes_map) override;
@@ -61,6 +83,8 @@ class LimitIR : public OperatorIR {
 
   StatusOr<std::vector<absl::flat_hash_set<std::string>>> RequiredInputColumns() const override;
 
+  Status ResolveType(CompilerState* compiler_state);
+
  protected:
   StatusOr<absl::flat_hash_set<std::string>> PruneOutputColumnsToImpl(
       const absl::flat_hash_set<std::string>& output_cols) override {
@@ -72,6 +96,9 @@ class LimitIR : public OperatorIR {
   bool limit_value_set_ = false;
   bool pem_only_ = false;
   std::unordered_set<int64_t> abortable_srcs_;
+  std::vector<std::string> sort_columns_;
+  bool sort_ascending_ = false;
+  bool per_window_ = false;
 };
 
 }  // namespace planner
@@ -61,6 +61,9 @@ Status MemorySourceIR::ToProto(planpb::Operator* op) const {
   }
 
   pb->set_streaming(streaming());
+  if (sample_fraction_ < 1.0) {
+    pb->set_sample_fraction(sample_fraction_);
+  }
   return Status::OK();
 }
 
@@ -135,6 +138,7 @@ Status MemorySourceIR::CopyFromNodeImpl(
   column_index_map_ = source_ir->column_index_map_;
   has_time_expressions_ = source_ir->has_time_expressions_;
   streaming_ = source_ir->streaming_;
+  sample_fraction_ = source_ir->sample_fraction_;
 
   if (has_time_expressions_) {
     PL_ASSIGN_OR_RETURN(ExpressionIR * new_start_expr,
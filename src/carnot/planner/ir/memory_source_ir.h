@@ -55,12 +55,17 @@ class MemorySourceIR : public OperatorIR {
   Status Init(const std::string& table_name, const std::vector<std::string>& select_columns);
 
   std::string table_name() const { return table_name_; }
+  void SetTableName(const std::string& table_name) { table_name_ = table_name; }
 
   // Whether or not the MemorySource should be executed in persistent streaming mode,
   // where the MemorySource reads data indefinitely.
   bool streaming() const { return streaming_; }
   void set_streaming(bool streaming) { streaming_ = streaming; }
 
+  // The fraction of the table's batches to read, for approximate queries. 1 reads all of them.
+  double sample_fraction() const { return sample_fraction_; }
+  void set_sample_fraction(double sample_fraction) { sample_fraction_ = sample_fraction; }
+
   Status SetTimeExpressions(ExpressionIR* start_time_expr, ExpressionIR* end_time_expr);
 
   // Sets the time expressions that eventually get converted
@@ -128,6 +133,7 @@ class MemorySourceIR : public OperatorIR {
  private:
   std::string table_name_;
   bool streaming_ = false;
+  double sample_fraction_ = 1.0;
 
   bool has_time_expressions_ = false;
   ExpressionIR* start_time_expr_ = nullptr;
@@ -18,16 +18,54 @@
 
 #include "src/carnot/planner/logical_planner.h"
 
+#include <string>
 #include <utility>
 
+#include <absl/strings/str_cat.h>
+
+#include "src/carnot/planner/rollup/rollup.h"
 #include "src/shared/scriptspb/scripts.pb.h"
 
+DEFINE_int64(planner_plan_cache_size, gflags::Int64FromEnv("PL_PLANNER_PLAN_CACHE_SIZE", 64),
+             "The number of distributed plans the planner keeps around for repeated queries. 0 "
+             "disables the plan cache.");
+
 namespace px {
 namespace carnot {
 namespace planner {
 
 using table_store::schemapb::Schema;
 
+namespace {
+
+bool ReadsStreamingSource(const planpb::Plan& plan) {
+  for (const auto& fragment : plan.nodes()) {
+    for (const auto& node : fragment.nodes()) {
+      if (node.op().has_mem_source_op() && node.op().mem_source_op().streaming()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Marks every agent's plan of a streaming query, including the Kelvins that only read from other
+// agents, so that the agents know the query won't finish on its own.
+void MarkStreamingPlans(distributedpb::DistributedPlan* plan) {
+  bool streaming = false;
+  for (const auto& [address, agent_plan] : plan->qb_address_to_plan()) {
+    streaming = streaming || ReadsStreamingSource(agent_plan);
+  }
+  if (!streaming) {
+    return;
+  }
+  for (auto& [address, agent_plan] : *plan->mutable_qb_address_to_plan()) {
+    agent_plan.mutable_plan_options()->set_streaming(true);
+  }
+}
+
+}  // namespace
+
 StatusOr<std::unique_ptr<RelationMap>> MakeRelationMapFromSchema(const Schema& schema_pb) {
   auto rel_map = std::make_unique<RelationMap>();
   for (auto& relation_pair : schema_pb.relation_map()) {
@@ -59,11 +97,8 @@ static inline RedactionOptions RedactionOptionsFromPb(
 }
 
 StatusOr<std::unique_ptr<CompilerState>> CreateCompilerState(
-    const distributedpb::LogicalPlannerState& logical_state, RegistryInfo* registry_info,
-    int64_t max_output_rows_per_table) {
-  PL_ASSIGN_OR_RETURN(std::unique_ptr<RelationMap> rel_map,
-                      MakeRelationMapFromDistributedState(logical_state.distributed_state()));
-
+    const distributedpb::LogicalPlannerState& logical_state, std::shared_ptr<RelationMap> rel_map,
+    RegistryInfo* registry_info, int64_t max_output_rows_per_table, int64_t time_now) {
   SensitiveColumnMap sensitive_columns = {
       {"cql_events", {"req_body", "resp_body"}},
       {"http_events", {"req_headers", "req_body", "resp_headers", "resp_body"}},
@@ -72,12 +107,48 @@ StatusOr<std::unique_ptr<CompilerState>> CreateCompilerState(
       {"nats_events.beta", {"body", "resp"}},
       {"pgsql_events", {"req", "resp"}},
       {"redis_events", {"req_args", "resp"}}};
-  // Create a CompilerState obj using the relation map and grabbing the current time.
-  return std::make_unique<planner::CompilerState>(
-      std::move(rel_map), sensitive_columns, registry_info, px::CurrentTimeNS(),
+  // Create a CompilerState obj using the relation map and the current time.
+  auto compiler_state = std::make_unique<planner::CompilerState>(
+      std::move(rel_map), sensitive_columns, registry_info, time_now,
       max_output_rows_per_table, logical_state.result_address(),
       logical_state.result_ssl_targetname(),
       RedactionOptionsFromPb(logical_state.redaction_options()));
+  // Queries are only answered from the rollup tables that the agents report in their schemas.
+  compiler_state->set_rollups(DefaultRollups());
+  return compiler_state;
+}
+
+StatusOr<std::shared_ptr<RelationMap>> LogicalPlanner::GetRelationMap(
+    const distributedpb::DistributedState& state_pb) {
+  // The schemas only change when tables are added or agents report new ones, so the relation map
+  // of the previous call is usually still valid. The agent lists of the schemas don't affect it.
+  std::string key;
+  for (const auto& schema_info : state_pb.schema_info()) {
+    absl::StrAppend(&key, schema_info.name(), "\n", schema_info.relation().SerializeAsString(),
+                    "\n");
+  }
+  {
+    absl::MutexLock lock(&relation_map_lock_);
+    if (relation_map_ != nullptr && key == relation_map_key_) {
+      return relation_map_;
+    }
+  }
+
+  PL_ASSIGN_OR_RETURN(std::shared_ptr<RelationMap> rel_map,
+                      MakeRelationMapFromDistributedState(state_pb));
+  absl::MutexLock lock(&relation_map_lock_);
+  relation_map_key_ = std::move(key);
+  relation_map_ = rel_map;
+  return rel_map;
+}
+
+StatusOr<std::unique_ptr<CompilerState>> LogicalPlanner::MakeCompilerState(
+    const distributedpb::LogicalPlannerState& logical_state, int64_t time_now) {
+  auto ms = logical_state.plan_options().max_output_rows_per_table();
+  VLOG(1) << "Max output rows: " << ms;
+  PL_ASSIGN_OR_RETURN(std::shared_ptr<RelationMap> rel_map,
+                      GetRelationMap(logical_state.distributed_state()));
+  return CreateCompilerState(logical_state, std::move(rel_map), registry_info_.get(), ms, time_now);
 }
 
 StatusOr<std::unique_ptr<LogicalPlanner>> LogicalPlanner::Create(const udfspb::UDFInfo& udf_info) {
@@ -92,6 +163,9 @@ Status LogicalPlanner::Init(const udfspb::UDFInfo& udf_info) {
   PL_RETURN_IF_ERROR(registry_info_->Init(udf_info));
 
   PL_ASSIGN_OR_RETURN(distributed_planner_, distributed::DistributedPlanner::Create());
+  if (FLAGS_planner_plan_cache_size > 0) {
+    plan_cache_ = std::make_unique<PlanCache>(FLAGS_planner_plan_cache_size);
+  }
   return Status::OK();
 }
 
@@ -99,29 +173,69 @@ StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::Plan(
     const distributedpb::LogicalPlannerState& logical_state,
     const plannerpb::QueryRequest& query_request) {
   // Compile into the IR.
-  auto ms = logical_state.plan_options().max_output_rows_per_table();
-  VLOG(1) << "Max output rows: " << ms;
   PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
-                      CreateCompilerState(logical_state, registry_info_.get(), ms));
+                      MakeCompilerState(logical_state, px::CurrentTimeNS()));
+  return Plan(logical_state, query_request, compiler_state.get());
+}
 
+StatusOr<std::unique_ptr<distributed::DistributedPlan>> LogicalPlanner::Plan(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request, CompilerState* compiler_state,
+    PlanTimings* timings) {
   std::vector<plannerpb::FuncToExecute> exec_funcs(query_request.exec_funcs().begin(),
                                                    query_request.exec_funcs().end());
-  PL_ASSIGN_OR_RETURN(
-      std::shared_ptr<IR> single_node_plan,
-      compiler_.CompileToIR(query_request.query_str(), compiler_state.get(), exec_funcs));
+  int64_t compile_start_ns = px::CurrentTimeNS();
+  PL_ASSIGN_OR_RETURN(std::shared_ptr<IR> single_node_plan,
+                      compiler_.CompileToIR(query_request.query_str(), compiler_state, exec_funcs));
   // Create the distributed plan.
-  return distributed_planner_->Plan(logical_state.distributed_state(), compiler_state.get(),
-                                    single_node_plan.get());
+  int64_t distributed_plan_start_ns = px::CurrentTimeNS();
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<distributed::DistributedPlan> distributed_plan,
+                      distributed_planner_->Plan(logical_state.distributed_state(),
+                                                 compiler_state, single_node_plan.get()));
+  if (timings != nullptr) {
+    timings->compile_time_ns = distributed_plan_start_ns - compile_start_ns;
+    timings->distributed_plan_time_ns = px::CurrentTimeNS() - distributed_plan_start_ns;
+  }
+  return distributed_plan;
+}
+
+StatusOr<distributedpb::DistributedPlan> LogicalPlanner::PlanToProto(
+    const distributedpb::LogicalPlannerState& logical_state,
+    const plannerpb::QueryRequest& query_request, PlanTimings* timings) {
+  int64_t time_now = px::CurrentTimeNS();
+  std::string cache_key;
+  if (plan_cache_ != nullptr) {
+    cache_key = PlanCache::Key(logical_state, query_request);
+    auto cached_plan = plan_cache_->Get(cache_key, time_now);
+    if (cached_plan.has_value()) {
+      VLOG(1) << "Reusing the cached plan of the query";
+      return std::move(cached_plan.value());
+    }
+  }
+
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
+                      MakeCompilerState(logical_state, time_now));
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<distributed::DistributedPlan> distributed_plan,
+                      Plan(logical_state, query_request, compiler_state.get(), timings));
+  // In the future, if we actually have plan options that will actually determine how the plan is
+  // constructed, we may want to pass the planOptions to planner.Plan. However, this
+  // will need to go through many more layers (such as the coordinator), so this is fine for now.
+  distributed_plan->SetPlanOptions(logical_state.plan_options());
+  PL_ASSIGN_OR_RETURN(distributedpb::DistributedPlan plan_pb, distributed_plan->ToProto());
+  MarkStreamingPlans(&plan_pb);
+
+  if (plan_cache_ != nullptr && !compiler_state->time_dependent()) {
+    plan_cache_->Put(cache_key, plan_pb, time_now, compiler_state->relative_times());
+  }
+  return plan_pb;
 }
 
 StatusOr<std::unique_ptr<compiler::MutationsIR>> LogicalPlanner::CompileTrace(
     const distributedpb::LogicalPlannerState& logical_state,
     const plannerpb::CompileMutationsRequest& mutations_req) {
   // Compile into the IR.
-  auto ms = logical_state.plan_options().max_output_rows_per_table();
-  VLOG(1) << "Max output rows: " << ms;
   PL_ASSIGN_OR_RETURN(std::unique_ptr<CompilerState> compiler_state,
-                      CreateCompilerState(logical_state, registry_info_.get(), ms));
+                      MakeCompilerState(logical_state, px::CurrentTimeNS()));
 
   std::vector<plannerpb::FuncToExecute> exec_funcs(mutations_req.exec_funcs().begin(),
                                                    mutations_req.exec_funcs().end());
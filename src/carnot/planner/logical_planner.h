@@ -21,14 +21,19 @@
 #include <string>
 #include <vector>
 
+#include <absl/synchronization/mutex.h>
+
 #include "src/carnot/planner/compiler/compiler.h"
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/distributed/distributed_plan/distributed_plan.h"
 #include "src/carnot/planner/distributed/distributed_planner.h"
+#include "src/carnot/planner/plan_cache.h"
 #include "src/carnot/planner/plannerpb/func_args.pb.h"
 #include "src/carnot/planner/probes/probes.h"
 #include "src/shared/scriptspb/scripts.pb.h"
 
+DECLARE_int64(planner_plan_cache_size);
+
 namespace px {
 namespace carnot {
 namespace planner {
@@ -39,6 +44,12 @@ namespace planner {
  */
 class LogicalPlanner : public NotCopyable {
  public:
+  // The time spent in each stage of planning a query.
+  struct PlanTimings {
+    int64_t compile_time_ns = 0;
+    int64_t distributed_plan_time_ns = 0;
+  };
+
   /**
    * @brief The Creation function for the planner.
    *
@@ -58,6 +69,18 @@ class LogicalPlanner : public NotCopyable {
       const distributedpb::LogicalPlannerState& logical_state,
       const plannerpb::QueryRequest& query);
 
+  /**
+   * @brief Plans the query like Plan and returns the distributed plan proto, with the plan options
+   * of the logical state set. Identical requests against an unchanged logical state reuse the
+   * plan from the plan cache.
+   *
+   * @param timings: if set, filled in with the time spent in each stage of planning. The timings
+   * are left at 0 for a plan from the plan cache.
+   */
+  StatusOr<distributedpb::DistributedPlan> PlanToProto(
+      const distributedpb::LogicalPlannerState& logical_state,
+      const plannerpb::QueryRequest& query, PlanTimings* timings = nullptr);
+
   StatusOr<std::unique_ptr<compiler::MutationsIR>> CompileTrace(
       const distributedpb::LogicalPlannerState& logical_state,
       const plannerpb::CompileMutationsRequest& mutations_req);
@@ -69,9 +92,30 @@ class LogicalPlanner : public NotCopyable {
   LogicalPlanner() {}
 
  private:
+  StatusOr<std::unique_ptr<distributed::DistributedPlan>> Plan(
+      const distributedpb::LogicalPlannerState& logical_state,
+      const plannerpb::QueryRequest& query, CompilerState* compiler_state,
+      PlanTimings* timings = nullptr);
+
+  // Creates the compiler state of a query against the logical state.
+  StatusOr<std::unique_ptr<CompilerState>> MakeCompilerState(
+      const distributedpb::LogicalPlannerState& logical_state, int64_t time_now);
+
+  // Returns the relation map of the schemas in the state, reusing the one of the previous call if
+  // the schemas didn't change.
+  StatusOr<std::shared_ptr<RelationMap>> GetRelationMap(
+      const distributedpb::DistributedState& state_pb);
+
   compiler::Compiler compiler_;
   std::unique_ptr<distributed::Planner> distributed_planner_;
   std::unique_ptr<planner::RegistryInfo> registry_info_;
+  // Null when the plan cache is disabled.
+  std::unique_ptr<PlanCache> plan_cache_;
+
+  absl::Mutex relation_map_lock_;
+  // The schemas that relation_map_ was built from.
+  std::string relation_map_key_ ABSL_GUARDED_BY(relation_map_lock_);
+  std::shared_ptr<RelationMap> relation_map_ ABSL_GUARDED_BY(relation_map_lock_);
 };
 
 }  // namespace planner
@@ -20,6 +20,9 @@
 #include <google/protobuf/text_format.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -614,6 +617,73 @@ TEST_F(LogicalPlannerTest, limit_pushdown_failing) {
   ASSERT_OK(proto_or_s.status());
 }
 
+std::vector<int64_t> MemSourceStartTimes(const distributedpb::DistributedPlan& plan) {
+  std::vector<int64_t> start_times;
+  for (const auto& [address, carnot_plan] : plan.qb_address_to_plan()) {
+    for (const auto& fragment : carnot_plan.nodes()) {
+      for (const auto& node : fragment.nodes()) {
+        if (node.op().has_mem_source_op() && node.op().mem_source_op().has_start_time()) {
+          start_times.push_back(node.op().mem_source_op().start_time().value());
+        }
+      }
+    }
+  }
+  std::sort(start_times.begin(), start_times.end());
+  return start_times;
+}
+
+TEST_F(LogicalPlannerTest, plan_to_proto_rebinds_cached_relative_times) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
+
+  ASSERT_OK_AND_ASSIGN(auto first_plan,
+                       planner->PlanToProto(state, MakeQueryRequest(kSimpleQueryDefaultLimit)));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  // Trailing whitespace doesn't change the cache key.
+  auto query = MakeQueryRequest(absl::StrCat(kSimpleQueryDefaultLimit, "  \n\n"));
+  ASSERT_OK_AND_ASSIGN(auto second_plan, planner->PlanToProto(state, query));
+
+  auto first_start_times = MemSourceStartTimes(first_plan);
+  auto second_start_times = MemSourceStartTimes(second_plan);
+  ASSERT_EQ(2U, first_start_times.size());
+  ASSERT_EQ(first_start_times.size(), second_start_times.size());
+  for (const auto& [i, start_time] : Enumerate(first_start_times)) {
+    EXPECT_GE(second_start_times[i] - start_time,
+              std::chrono::nanoseconds(std::chrono::milliseconds(5)).count());
+  }
+}
+
+TEST_F(LogicalPlannerTest, relation_map_follows_schema_changes) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto http_state = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
+  auto table1_query = MakeQueryRequest("import px\npx.display(px.DataFrame('table1'), 'out')");
+
+  EXPECT_OK(planner->Plan(http_state, MakeQueryRequest(testutils::kHttpRequestStats)));
+  EXPECT_NOT_OK(planner->Plan(http_state, table1_query));
+  // The relation map of the previous schemas isn't reused once they change.
+  EXPECT_OK(planner->Plan(testutils::CreateOnePEMOneKelvinPlannerState(), table1_query));
+  EXPECT_OK(planner->Plan(http_state, MakeQueryRequest(testutils::kHttpRequestStats)));
+}
+
+TEST_F(LogicalPlannerTest, marks_streaming_plans) {
+  auto planner = LogicalPlanner::Create(info_).ConsumeValueOrDie();
+  auto state = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
+
+  ASSERT_OK_AND_ASSIGN(auto batch_plan,
+                       planner->PlanToProto(state, MakeQueryRequest(kSimpleQueryDefaultLimit)));
+  for (const auto& [address, plan] : batch_plan.qb_address_to_plan()) {
+    EXPECT_FALSE(plan.plan_options().streaming()) << address;
+  }
+
+  auto query = MakeQueryRequest(
+      "import px\npx.display(px.DataFrame(table='http_events', select=['time_']).stream())");
+  ASSERT_OK_AND_ASSIGN(auto streaming_plan, planner->PlanToProto(state, query));
+  ASSERT_EQ(3, streaming_plan.qb_address_to_plan_size());
+  for (const auto& [address, plan] : streaming_plan.qb_address_to_plan()) {
+    EXPECT_TRUE(plan.plan_options().streaming()) << address;
+  }
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
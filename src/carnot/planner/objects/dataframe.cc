@@ -18,6 +18,7 @@
 
 #include "src/carnot/planner/objects/dataframe.h"
 #include "src/carnot/planner/ir/ast_utils.h"
+#include "src/carnot/planner/ir/time.h"
 #include "src/carnot/planner/objects/collection_object.h"
 #include "src/carnot/planner/objects/expr_object.h"
 #include "src/carnot/planner/objects/funcobject.h"
@@ -74,11 +75,12 @@ StatusOr<std::vector<std::string>> ParseAsListOfStrings(QLObjectPtr obj,
 Status Dataframe::Init() {
   PL_ASSIGN_OR_RETURN(
       std::shared_ptr<FuncObject> constructor_fn,
-      FuncObject::Create(name(), {"table", "select", "start_time", "end_time"},
+      FuncObject::Create(name(), {"table", "select", "start_time", "end_time", "sample"},
                          {{"select", "[]"},
                           {"start_time", "0"},
                           {"end_time", absl::Substitute("$0.$1()", PixieModule::kPixieModuleObjName,
-                                                        PixieModule::kNowOpID)}},
+                                                        PixieModule::kNowOpID)},
+                          {"sample", "1.0"}},
                          /* has_variable_len_args */ false,
                          /* has_variable_len_kwargs */ false,
                          std::bind(&DataFrameHandler::Eval, graph(), std::placeholders::_1,
@@ -109,6 +111,25 @@ Status Dataframe::Init() {
   PL_RETURN_IF_ERROR(mergefn->SetDocString(kMergeOpDocstring));
   AddMethod(kMergeOpID, mergefn);
 
+  /**
+   * # Equivalent to the python method method syntax:
+   * def merge_asof(self, right, left_on, right_on, tolerance, how='left', on='time_',
+   *                suffixes=['_x', '_y']):
+   *     ...
+   */
+  PL_ASSIGN_OR_RETURN(
+      std::shared_ptr<FuncObject> merge_asof_fn,
+      FuncObject::Create(kMergeAsOfOpID,
+                         {"right", "left_on", "right_on", "tolerance", "how", "on", "suffixes"},
+                         {{"how", "'left'"}, {"on", "'time_'"}, {"suffixes", "['_x', '_y']"}},
+                         /* has_variable_len_args */ false,
+                         /* has_variable_len_kwargs */ false,
+                         std::bind(&JoinHandler::EvalAsOf, graph(), op(), std::placeholders::_1,
+                                   std::placeholders::_2, std::placeholders::_3),
+                         ast_visitor()));
+  PL_RETURN_IF_ERROR(merge_asof_fn->SetDocString(kMergeAsOfOpDocstring));
+  AddMethod(kMergeAsOfOpID, merge_asof_fn);
+
   /**
    * # Equivalent to the python method method syntax:
    * def agg(self, **kwargs):
@@ -172,6 +193,56 @@ Status Dataframe::Init() {
   PL_RETURN_IF_ERROR(limitfn->SetDocString(kLimitOpDocstring));
   AddMethod(kLimitOpID, limitfn);
 
+  /**
+   * # Equivalent to the python method method syntax:
+   * def nlargest(self, n, columns):
+   *     ...
+   */
+  PL_ASSIGN_OR_RETURN(
+      std::shared_ptr<FuncObject> nlargestfn,
+      FuncObject::Create(kNLargestOpID, {"n", "columns"}, {},
+                         /* has_variable_len_args */ false,
+                         /* has_variable_len_kwargs */ false,
+                         std::bind(&TopKHandler::Eval, graph(), op(), /* ascending */ false,
+                                   std::placeholders::_1, std::placeholders::_2,
+                                   std::placeholders::_3),
+                         ast_visitor()));
+  PL_RETURN_IF_ERROR(nlargestfn->SetDocString(kNLargestOpDocstring));
+  AddMethod(kNLargestOpID, nlargestfn);
+
+  /**
+   * # Equivalent to the python method method syntax:
+   * def nsmallest(self, n, columns):
+   *     ...
+   */
+  PL_ASSIGN_OR_RETURN(
+      std::shared_ptr<FuncObject> nsmallestfn,
+      FuncObject::Create(kNSmallestOpID, {"n", "columns"}, {},
+                         /* has_variable_len_args */ false,
+                         /* has_variable_len_kwargs */ false,
+                         std::bind(&TopKHandler::Eval, graph(), op(), /* ascending */ true,
+                                   std::placeholders::_1, std::placeholders::_2,
+                                   std::placeholders::_3),
+                         ast_visitor()));
+  PL_RETURN_IF_ERROR(nsmallestfn->SetDocString(kNSmallestOpDocstring));
+  AddMethod(kNSmallestOpID, nsmallestfn);
+
+  /**
+   * # Equivalent to the python method method syntax:
+   * def sort(self, by, ascending=True):
+   *     ...
+   */
+  PL_ASSIGN_OR_RETURN(
+      std::shared_ptr<FuncObject> sortfn,
+      FuncObject::Create(kSortOpID, {"by", "ascending"}, {{"ascending", "True"}},
+                         /* has_variable_len_args */ false,
+                         /* has_variable_len_kwargs */ false,
+                         std::bind(&SortHandler::Eval, graph(), op(), std::placeholders::_1,
+                                   std::placeholders::_2, std::placeholders::_3),
+                         ast_visitor()));
+  PL_RETURN_IF_ERROR(sortfn->SetDocString(kSortOpDocstring));
+  AddMethod(kSortOpID, sortfn);
+
   /**
    *
    * # Equivalent to the python method method syntax:
@@ -320,6 +391,35 @@ StatusOr<QLObjectPtr> JoinHandler::Eval(IR* graph, OperatorIR* op, const pypa::A
   return Dataframe::Create(join_op, visitor);
 }
 
+StatusOr<QLObjectPtr> JoinHandler::EvalAsOf(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
+                                            const ParsedArgs& args, ASTVisitor* visitor) {
+  PL_ASSIGN_OR_RETURN(StringIR * how, GetArgAs<StringIR>(ast, args, "how"));
+  if (how->str() != "left" && how->str() != "inner") {
+    return how->CreateIRNodeError("merge_asof() only supports 'left' and 'inner' joins, not '$0'",
+                                  how->str());
+  }
+  PL_ASSIGN_OR_RETURN(StringIR * on, GetArgAs<StringIR>(ast, args, "on"));
+  PL_ASSIGN_OR_RETURN(ExpressionIR * tolerance, GetArgAs<ExpressionIR>(ast, args, "tolerance"));
+  int64_t tolerance_ns;
+  if (Match(tolerance, Int())) {
+    tolerance_ns = static_cast<IntIR*>(tolerance)->val();
+  } else if (Match(tolerance, String())) {
+    PL_ASSIGN_OR_RETURN(tolerance_ns, ParseDurationFmt(static_cast<StringIR*>(tolerance), 0));
+  } else {
+    return tolerance->CreateIRNodeError(
+        "'tolerance' must be an int of nanoseconds or a duration string like '5s'");
+  }
+
+  PL_ASSIGN_OR_RETURN(QLObjectPtr joined, Eval(graph, op, ast, args, visitor));
+  auto join = static_cast<JoinIR*>(std::static_pointer_cast<Dataframe>(joined)->op());
+  PL_ASSIGN_OR_RETURN(ColumnIR * left_time_column,
+                      graph->CreateNode<ColumnIR>(ast, on->str(), /* parent_op_idx */ 0));
+  PL_ASSIGN_OR_RETURN(ColumnIR * right_time_column,
+                      graph->CreateNode<ColumnIR>(ast, on->str(), /* parent_op_idx */ 1));
+  PL_RETURN_IF_ERROR(join->SetAsOf(left_time_column, right_time_column, tolerance_ns));
+  return joined;
+}
+
 StatusOr<std::vector<ColumnIR*>> JoinHandler::ProcessCols(IR* graph, const pypa::AstPtr& ast,
                                                           QLObjectPtr obj, std::string arg_name,
                                                           int64_t parent_index) {
@@ -353,7 +453,53 @@ StatusOr<QLObjectPtr> AggHandler::Eval(IR* graph, OperatorIR* op, const pypa::As
   PL_ASSIGN_OR_RETURN(
       BlockingAggIR * agg_op,
       graph->CreateNode<BlockingAggIR>(ast, op, std::vector<ColumnIR*>{}, aggregate_expressions));
-  return Dataframe::Create(agg_op, visitor);
+  double sample_fraction = SampleFractionOfInput(op);
+  if (sample_fraction >= 1.0) {
+    return Dataframe::Create(agg_op, visitor);
+  }
+  PL_ASSIGN_OR_RETURN(MapIR * scaled_op,
+                      ScaleSampledAggregates(graph, ast, op, agg_op, aggregate_expressions,
+                                             sample_fraction));
+  return Dataframe::Create(scaled_op, visitor);
+}
+
+double AggHandler::SampleFractionOfInput(OperatorIR* op) {
+  while (Match(op, Map()) || Match(op, Filter()) || Match(op, GroupBy())) {
+    op = op->parents()[0];
+  }
+  if (!Match(op, MemorySource())) {
+    return 1.0;
+  }
+  return static_cast<MemorySourceIR*>(op)->sample_fraction();
+}
+
+StatusOr<MapIR*> AggHandler::ScaleSampledAggregates(
+    IR* graph, const pypa::AstPtr& ast, OperatorIR* op, BlockingAggIR* agg_op,
+    const ColExpressionVector& aggregate_expressions, double sample_fraction) {
+  // The groups come first in the output of the aggregate, followed by the aggregate expressions.
+  ColExpressionVector col_exprs;
+  if (Match(op, GroupBy())) {
+    for (ColumnIR* group : static_cast<GroupByIR*>(op)->groups()) {
+      PL_ASSIGN_OR_RETURN(ColumnIR * col, graph->CreateNode<ColumnIR>(ast, group->col_name(),
+                                                                       /* parent_op_idx */ 0));
+      col_exprs.emplace_back(group->col_name(), col);
+    }
+  }
+  for (const auto& expr : aggregate_expressions) {
+    PL_ASSIGN_OR_RETURN(ColumnIR * col,
+                        graph->CreateNode<ColumnIR>(ast, expr.name, /* parent_op_idx */ 0));
+    auto func_name = static_cast<FuncIR*>(expr.node)->func_name();
+    if (func_name != "count" && func_name != "sum") {
+      col_exprs.emplace_back(expr.name, col);
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(FloatIR * scale, graph->CreateNode<FloatIR>(ast, 1.0 / sample_fraction));
+    FuncIR::Op mult{FuncIR::Opcode::mult, "*", "multiply"};
+    PL_ASSIGN_OR_RETURN(FuncIR * scaled, graph->CreateNode<FuncIR>(
+                                             ast, mult, std::vector<ExpressionIR*>{col, scale}));
+    col_exprs.emplace_back(expr.name, scaled);
+  }
+  return graph->CreateNode<MapIR>(ast, agg_op, col_exprs, /* keep_input_columns */ false);
 }
 
 StatusOr<FuncIR*> AggHandler::ParseNameTuple(IR* ir, const pypa::AstPtr& ast,
@@ -418,6 +564,34 @@ StatusOr<QLObjectPtr> LimitHandler::Eval(IR* graph, OperatorIR* op, const pypa::
   return Dataframe::Create(limit_op, visitor);
 }
 
+StatusOr<QLObjectPtr> TopKHandler::Eval(IR* graph, OperatorIR* op, bool ascending,
+                                        const pypa::AstPtr& ast, const ParsedArgs& args,
+                                        ASTVisitor* visitor) {
+  PL_ASSIGN_OR_RETURN(IntIR * rows_node, GetArgAs<IntIR>(ast, args, "n"));
+  PL_ASSIGN_OR_RETURN(std::vector<std::string> columns,
+                      ParseAsListOfStrings(args.GetArg("columns"), "columns"));
+  if (columns.empty()) {
+    return args.GetArg("columns")->CreateError("must specify at least one column to order by");
+  }
+  PL_ASSIGN_OR_RETURN(LimitIR * limit_op,
+                      graph->CreateNode<LimitIR>(ast, op, rows_node->val(), columns, ascending));
+  return Dataframe::Create(limit_op, visitor);
+}
+
+StatusOr<QLObjectPtr> SortHandler::Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
+                                        const ParsedArgs& args, ASTVisitor* visitor) {
+  PL_ASSIGN_OR_RETURN(std::vector<std::string> columns,
+                      ParseAsListOfStrings(args.GetArg("by"), "by"));
+  if (columns.empty()) {
+    return args.GetArg("by")->CreateError("must specify at least one column to sort by");
+  }
+  PL_ASSIGN_OR_RETURN(BoolIR * ascending, GetArgAs<BoolIR>(ast, args, "ascending"));
+  PL_ASSIGN_OR_RETURN(LimitIR * limit_op,
+                      graph->CreateNode<LimitIR>(ast, op, LimitIR::kUnlimited, columns,
+                                                 ascending->val()));
+  return Dataframe::Create(limit_op, visitor);
+}
+
 StatusOr<QLObjectPtr> SubscriptHandler::Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
                                              const ParsedArgs& args, ASTVisitor* visitor) {
   QLObjectPtr key = args.GetArg("key");
@@ -533,10 +707,16 @@ StatusOr<QLObjectPtr> DataFrameHandler::Eval(IR* graph, const pypa::AstPtr& ast,
                       ParseAsListOfStrings(args.GetArg("select"), "select"));
   PL_ASSIGN_OR_RETURN(ExpressionIR * start_time, GetArgAs<ExpressionIR>(ast, args, "start_time"));
   PL_ASSIGN_OR_RETURN(ExpressionIR * end_time, GetArgAs<ExpressionIR>(ast, args, "end_time"));
+  PL_ASSIGN_OR_RETURN(FloatIR * sample, GetArgAs<FloatIR>(ast, args, "sample"));
+  if (sample->val() <= 0 || sample->val() > 1) {
+    return sample->CreateIRNodeError("sample must be greater than 0 and at most 1, got $0",
+                                     sample->val());
+  }
 
   std::string table_name = table->str();
   PL_ASSIGN_OR_RETURN(MemorySourceIR * mem_source_op,
                       graph->CreateNode<MemorySourceIR>(ast, table_name, columns));
+  mem_source_op->set_sample_fraction(sample->val());
   // If both start_time and end_time are default arguments, then we don't substitute them.
   if (!(args.default_subbed_args().contains("start_time") &&
         args.default_subbed_args().contains("end_time"))) {
@@ -85,6 +85,9 @@ class Dataframe : public QLObject {
   Examples:
     # Absolute time specification.
     df = px.DataFrame('http_events', start_time='2020-07-13 18:02:5.00 -0700')
+  Examples:
+    # Approximate the counts of a large table from 1% of it.
+    df = px.DataFrame('http_events', start_time='-24h', sample=0.01)
 
   Args:
     table (string): The table name to load.
@@ -94,6 +97,11 @@ class Dataframe : public QLObject {
       ie "-5m" or an absolute time in the following format "2020-07-13 18:02:5.00 +0000".
     end_time (px.Time): The last timestamp of data to load. Can be a relative time
       ie "-5m" or an absolute time in the following format "2020-07-13 18:02:5.00 +0000".
+    sample (float): The fraction of the table to read, for approximate results over large
+      tables. The table's batches of rows are sampled, the same ones every time for the same
+      data. Counts and sums computed by agg() are scaled up by 1/sample, which makes them
+      floats. The relative standard error of the sample is in the query's execution stats.
+      If not set, default is 1.0, which reads the whole table.
 
   Returns:
     px.DataFrame: DataFrame loaded from the table with the specified columns and time period.
@@ -265,6 +273,75 @@ class Dataframe : public QLObject {
   Returns:
     px.DataFrame: DataFrame with the first n rows.
   )doc";
+  inline static constexpr char kNLargestOpID[] = "nlargest";
+  inline static constexpr char kNLargestOpDocstring[] = R"doc(
+  Return the n rows with the largest values of the columns.
+
+  Returns a DataFrame with the n rows that have the largest values of the columns, ordered
+  by those columns in descending order. Each agent only sends its own top n rows, so this is
+  much cheaper than collecting the whole table.
+
+  :topic: dataframe_ops
+  :opname: NLargest
+
+  Examples:
+    df = px.DataFrame('http_events')
+    # Keep only the 10 slowest http requests.
+    df = df.nlargest(10, 'latency')
+
+  Args:
+    n (int): The number of rows to return.
+    columns (string or List[string]): The columns to order the rows by.
+
+  Returns:
+    px.DataFrame: DataFrame with the n rows with the largest values.
+  )doc";
+  inline static constexpr char kNSmallestOpID[] = "nsmallest";
+  inline static constexpr char kNSmallestOpDocstring[] = R"doc(
+  Return the n rows with the smallest values of the columns.
+
+  Returns a DataFrame with the n rows that have the smallest values of the columns, ordered
+  by those columns in ascending order. Each agent only sends its own top n rows, so this is
+  much cheaper than collecting the whole table.
+
+  :topic: dataframe_ops
+  :opname: NSmallest
+
+  Examples:
+    df = px.DataFrame('http_events')
+    # Keep only the 10 fastest http requests.
+    df = df.nsmallest(10, 'latency')
+
+  Args:
+    n (int): The number of rows to return.
+    columns (string or List[string]): The columns to order the rows by.
+
+  Returns:
+    px.DataFrame: DataFrame with the n rows with the smallest values.
+  )doc";
+  inline static constexpr char kSortOpID[] = "sort";
+  inline static constexpr char kSortOpDocstring[] = R"doc(
+  Sort the rows of the DataFrame by the columns.
+
+  Returns a DataFrame with all of the rows, ordered by the columns. Each agent sorts its own
+  rows before sending them on, and sorts that don't fit in memory spill to disk when
+  `--carnot_sort_spill_dir` is set. Prefer nlargest/nsmallest if only the first rows are needed.
+
+  :topic: dataframe_ops
+  :opname: Sort
+
+  Examples:
+    df = px.DataFrame('http_events')
+    # Order the http requests by service, then by latency.
+    df = df.sort(['service', 'latency'])
+
+  Args:
+    by (string or List[string]): The columns to order the rows by.
+    ascending (bool): Whether to sort in ascending order. If not set, default is True.
+
+  Returns:
+    px.DataFrame: DataFrame with the rows ordered by the columns.
+  )doc";
 
   inline static constexpr char kMergeOpID[] = "merge";
   inline static constexpr char kMergeOpDocstring[] = R"doc(
@@ -312,6 +389,40 @@ class Dataframe : public QLObject {
     px.DataFrame: Merged DataFrame with the relation
     [left_join_col, ...remaining_left_columns, ...remaining_right_columns].
   )doc";
+  inline static constexpr char kMergeAsOfOpID[] = "merge_asof";
+  inline static constexpr char kMergeAsOfOpDocstring[] = R"doc(
+  Merges the input DataFrame with this one by the nearest earlier time.
+
+  Joins each row of this DataFrame with the latest row of the right DataFrame that has the same
+  keys and a time at or before the row's time, if that right row is within the tolerance. Use it
+  to match events with the most recent sample of the same process or pod, such as the resource
+  usage of the process that served each request. Both DataFrames are merged in a single pass, so
+  this is much cheaper than joining on binned times or filtering a cross join.
+
+  Examples:
+    # Match each HTTP request with the latest process_stats sample of its process.
+    left_df = px.DataFrame('http_events', start_time='-1m')
+    right_df = px.DataFrame('process_stats', start_time='-1m')
+    df = left_df.merge_asof(right_df, left_on='upid', right_on='upid', tolerance='15s',
+                            suffixes=['', '_stats'])
+
+  :topic: dataframe_ops
+  :opname: As-Of Join
+
+  Args:
+    right (px.DataFrame): The DataFrame to join with this DataFrame.
+    left_on (Union[string, List[string]]): Key column names from this DataFrame, either as a string or a list of strings.
+    right_on (Union[string, List[string]]): Key column names from the right DataFrame. Must be the same type as the `left_on` columns.
+    tolerance (Union[int, string]): The most that a matched right row may be older than the left row, in nanoseconds or as a duration string like '5s'.
+    how (['left', 'inner'], default 'left'): the type of merge (join) to perform.
+      * left: keep the rows of this DataFrame that have no match, with default values for the right columns.
+      * inner: drop the rows of this DataFrame that have no match.
+    on (string, default 'time_'): The time column of both DataFrames.
+    suffixes (Tuple[string, string], default ['_x', '_y']): The suffixes to apply to duplicate columns.
+
+  Returns:
+    px.DataFrame: Merged DataFrame with the relation [...left_columns, ...right_columns].
+  )doc";
   inline static constexpr char kGroupByOpID[] = "groupby";
   inline static constexpr char kGroupByOpDocstring[] = R"doc(
   Groups the data in preparation for an aggregate.
@@ -431,6 +542,8 @@ class JoinHandler {
  public:
   static StatusOr<QLObjectPtr> Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
                                     const ParsedArgs& args, ASTVisitor* visitor);
+  static StatusOr<QLObjectPtr> EvalAsOf(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
+                                        const ParsedArgs& args, ASTVisitor* visitor);
 
  private:
   /**
@@ -469,6 +582,14 @@ class AggHandler {
  private:
   static StatusOr<FuncIR*> ParseNameTuple(IR* ir, const pypa::AstPtr& ast,
                                           std::shared_ptr<TupleObject> tuple);
+  // The sample fraction of the memory source that op reads from, if only maps, filters and groupbys
+  // are in between, and 1 otherwise.
+  static double SampleFractionOfInput(OperatorIR* op);
+  // Adds a map after the aggregate that scales its counts and sums up to the whole table.
+  static StatusOr<MapIR*> ScaleSampledAggregates(IR* graph, const pypa::AstPtr& ast, OperatorIR* op,
+                                                 BlockingAggIR* agg_op,
+                                                 const ColExpressionVector& aggregate_expressions,
+                                                 double sample_fraction);
 };
 
 /**
@@ -508,6 +629,44 @@ class LimitHandler {
                                     const ParsedArgs& args, ASTVisitor* visitor);
 };
 
+/**
+ * @brief Implements the nlargest and nsmallest methods, which are ordered limits.
+ *
+ */
+class TopKHandler {
+ public:
+  /**
+   * @brief Evaluates the nlargest/nsmallest method.
+   *
+   * @param op the operator that's a parent to the ordered limit.
+   * @param ascending whether the smallest (nsmallest) or largest (nlargest) rows are kept.
+   * @param ast the ast node that signifies where the query was written
+   * @param args the arguments for nlargest()/nsmallest()
+   * @return StatusOr<QLObjectPtr>
+   */
+  static StatusOr<QLObjectPtr> Eval(IR* graph, OperatorIR* op, bool ascending,
+                                    const pypa::AstPtr& ast, const ParsedArgs& args,
+                                    ASTVisitor* visitor);
+};
+
+/**
+ * @brief Implements the sort method, which is an ordered limit that keeps every row.
+ *
+ */
+class SortHandler {
+ public:
+  /**
+   * @brief Evaluates the sort method.
+   *
+   * @param op the operator that's a parent to the sort.
+   * @param ast the ast node that signifies where the query was written
+   * @param args the arguments for sort()
+   * @return StatusOr<QLObjectPtr>
+   */
+  static StatusOr<QLObjectPtr> Eval(IR* graph, OperatorIR* op, const pypa::AstPtr& ast,
+                                    const ParsedArgs& args, ASTVisitor* visitor);
+};
+
 class SubscriptHandler {
  public:
   /**
@@ -116,6 +116,46 @@ TEST_F(JoinHandlerTest, MergeTest) {
   EXPECT_THAT(join->suffix_strs(), ElementsAre("_x", "_y"));
 }
 
+TEST_F(JoinHandlerTest, MergeAsOfTest) {
+  MemorySourceIR* left = MakeMemSource();
+  MemorySourceIR* right = MakeMemSource();
+
+  ParsedArgs args;
+  args.AddArg("suffixes", MakeListObj(MakeString("_x"), MakeString("_y")));
+  args.AddArg("right", ToQLObject(right));
+  args.AddArg("how", ToQLObject(MakeString("left")));
+  args.AddArg("on", ToQLObject(MakeString("time_")));
+  args.AddArg("tolerance", ToQLObject(MakeString("5s")));
+  args.AddArg("left_on", MakeListObj(MakeString("upid")));
+  args.AddArg("right_on", MakeListObj(MakeString("upid")));
+
+  auto status = JoinHandler::EvalAsOf(graph.get(), left, ast, args, ast_visitor.get());
+  ASSERT_OK(status);
+  auto df_obj = static_cast<Dataframe*>(status.ConsumeValueOrDie().get());
+  ASSERT_MATCH(df_obj->op(), Join());
+  JoinIR* join = static_cast<JoinIR*>(df_obj->op());
+  EXPECT_EQ(join->join_type(), JoinIR::JoinType::kLeft);
+  EXPECT_TRUE(join->as_of());
+  EXPECT_EQ(5000000000, join->as_of_tolerance_ns());
+  EXPECT_MATCH(join->left_time_column(), ColumnNode("time_", 0));
+  EXPECT_MATCH(join->right_time_column(), ColumnNode("time_", 1));
+  EXPECT_MATCH(join->left_on_columns()[0], ColumnNode("upid", 0));
+  EXPECT_MATCH(join->right_on_columns()[0], ColumnNode("upid", 1));
+
+  ParsedArgs outer_args;
+  outer_args.AddArg("suffixes", MakeListObj(MakeString("_x"), MakeString("_y")));
+  outer_args.AddArg("right", ToQLObject(right));
+  outer_args.AddArg("how", ToQLObject(MakeString("outer")));
+  outer_args.AddArg("on", ToQLObject(MakeString("time_")));
+  outer_args.AddArg("tolerance", ToQLObject(MakeInt(10)));
+  outer_args.AddArg("left_on", MakeListObj(MakeString("upid")));
+  outer_args.AddArg("right_on", MakeListObj(MakeString("upid")));
+  auto outer_status = JoinHandler::EvalAsOf(graph.get(), left, ast, outer_args, ast_visitor.get());
+  ASSERT_NOT_OK(outer_status);
+  EXPECT_THAT(outer_status.status(),
+              HasCompilerError("merge_asof\\(\\) only supports 'left' and 'inner' joins"));
+}
+
 TEST_F(JoinHandlerTest, NonListKeysMergeTest) {
   MemorySourceIR* left = MakeMemSource();
   MemorySourceIR* right = MakeMemSource();
@@ -268,6 +308,44 @@ TEST_F(DataframeTest, AggTest) {
   ASSERT_THAT(col_names, UnorderedElementsAre("col1", "col2"));
 }
 
+TEST_F(DataframeTest, SampledAggIsScaled) {
+  MemorySourceIR* src = MakeMemSource();
+  src->set_sample_fraction(0.25);
+
+  std::vector<QLObjectPtr> count_args{
+      ToQLObject(MakeString("col1")),
+      MakeUDFFunc(ast_visitor.get(), src->graph(), "count").ConsumeValueOrDie()};
+  std::vector<QLObjectPtr> mean_args{
+      ToQLObject(MakeString("col2")),
+      MakeUDFFunc(ast_visitor.get(), src->graph(), "mean").ConsumeValueOrDie()};
+  ParsedArgs args;
+  args.AddKwarg("count", TupleObject::Create(count_args, ast_visitor.get()).ConsumeValueOrDie());
+  args.AddKwarg("mean", TupleObject::Create(mean_args, ast_visitor.get()).ConsumeValueOrDie());
+
+  auto status = AggHandler::Eval(graph.get(), src, ast, args, ast_visitor.get());
+  ASSERT_OK(status);
+  auto df_obj = std::static_pointer_cast<Dataframe>(status.ConsumeValueOrDie());
+
+  // The count is scaled up to the whole table, the mean is left as is.
+  ASSERT_MATCH(df_obj->op(), Map());
+  MapIR* map = static_cast<MapIR*>(df_obj->op());
+  ASSERT_MATCH(map->parents()[0], BlockingAgg());
+  ASSERT_EQ(map->col_exprs().size(), 2);
+  for (const auto& expr : map->col_exprs()) {
+    if (expr.name == "mean") {
+      EXPECT_MATCH(expr.node, ColumnNode("mean"));
+      continue;
+    }
+    EXPECT_EQ(expr.name, "count");
+    ASSERT_MATCH(expr.node, Func());
+    FuncIR* fn = static_cast<FuncIR*>(expr.node);
+    EXPECT_EQ(fn->func_name(), "multiply");
+    ASSERT_EQ(fn->all_args().size(), 2);
+    EXPECT_MATCH(fn->all_args()[0], ColumnNode("count"));
+    EXPECT_MATCH(fn->all_args()[1], Float(4.0));
+  }
+}
+
 TEST_F(DataframeTest, AggFailsWithPosArgs) {
   MemorySourceIR* src = MakeMemSource();
 
@@ -375,6 +453,49 @@ TEST_F(LimitTest, LimitNonIntArgument) {
               HasCompilerError("Expected arg 'n' as type 'Int', received 'String'"));
 }
 
+TEST_F(LimitTest, CreateTopK) {
+  MemorySourceIR* src = MakeMemSource();
+
+  ParsedArgs args;
+  args.AddArg("n", ToQLObject(MakeInt(10)));
+  args.AddArg("columns", MakeListObj(MakeString("latency"), MakeString("count")));
+
+  auto status = TopKHandler::Eval(graph.get(), src, /* ascending */ false, ast, args,
+                                  ast_visitor.get());
+  ASSERT_OK(status);
+  QLObjectPtr ql_object = status.ConsumeValueOrDie();
+  ASSERT_TRUE(ql_object->type_descriptor().type() == QLObjectType::kDataframe);
+  auto limit_obj = std::static_pointer_cast<Dataframe>(ql_object);
+
+  ASSERT_MATCH(limit_obj->op(), Limit());
+  LimitIR* limit = static_cast<LimitIR*>(limit_obj->op());
+  EXPECT_EQ(limit->limit_value(), 10);
+  EXPECT_TRUE(limit->is_ordered());
+  EXPECT_FALSE(limit->sort_ascending());
+  EXPECT_THAT(limit->sort_columns(), ElementsAre("latency", "count"));
+}
+
+TEST_F(LimitTest, CreateSort) {
+  MemorySourceIR* src = MakeMemSource();
+
+  ParsedArgs args;
+  args.AddArg("by", ToQLObject(MakeString("latency")));
+  args.AddArg("ascending", ToQLObject(graph->CreateNode<BoolIR>(ast, false).ConsumeValueOrDie()));
+
+  auto status = SortHandler::Eval(graph.get(), src, ast, args, ast_visitor.get());
+  ASSERT_OK(status);
+  QLObjectPtr ql_object = status.ConsumeValueOrDie();
+  ASSERT_TRUE(ql_object->type_descriptor().type() == QLObjectType::kDataframe);
+  auto sort_obj = std::static_pointer_cast<Dataframe>(ql_object);
+
+  ASSERT_MATCH(sort_obj->op(), Limit());
+  LimitIR* limit = static_cast<LimitIR*>(sort_obj->op());
+  EXPECT_EQ(limit->limit_value(), LimitIR::kUnlimited);
+  EXPECT_TRUE(limit->is_ordered());
+  EXPECT_FALSE(limit->sort_ascending());
+  EXPECT_THAT(limit->sort_columns(), ElementsAre("latency"));
+}
+
 TEST_F(DataframeTest, LimitCall) {
   MemorySourceIR* src = MakeMemSource();
   auto df_or_s = Dataframe::Create(src, ast_visitor.get());
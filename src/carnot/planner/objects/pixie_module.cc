@@ -343,6 +343,7 @@ StatusOr<QLObjectPtr> CompileTimeFuncHandler::NowEval(CompilerState* compiler_st
                                                       const pypa::AstPtr& ast, const ParsedArgs&,
                                                       ASTVisitor* visitor) {
   // TODO(philkuz) switch to use TimeIR.
+  compiler_state->MarkTimeDependent();
   PL_ASSIGN_OR_RETURN(IntIR * time_now,
                       graph->CreateNode<IntIR>(ast, compiler_state->time_now().val));
   return ExprObject::Create(time_now, visitor);
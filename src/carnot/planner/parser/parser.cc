@@ -21,6 +21,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
 #include <magic_enum.hpp>
 #include <pypa/ast/ast.hh>
 #include <pypa/ast/tree_walker.hh>
@@ -102,6 +104,51 @@ StatusOr<pypa::AstModulePtr> Parser::Parse(std::string_view query, bool parse_do
   return ast;
 }
 
+namespace {
+
+// The texts passed to ParseCached are a small set that repeats across compiles, so the cache is
+// simply dropped if it ever grows past this.
+constexpr size_t kMaxCachedAsts = 4096;
+
+struct ParseCache {
+  absl::Mutex lock;
+  absl::flat_hash_map<std::pair<std::string, bool>, pypa::AstModulePtr> asts ABSL_GUARDED_BY(lock);
+};
+
+ParseCache* GetParseCache() {
+  static auto* cache = new ParseCache();
+  return cache;
+}
+
+}  // namespace
+
+StatusOr<pypa::AstModulePtr> Parser::ParseCached(std::string_view text, bool parse_doc_strings) {
+  ParseCache* cache = GetParseCache();
+  auto key = std::make_pair(std::string(text), parse_doc_strings);
+  {
+    absl::MutexLock lock(&cache->lock);
+    auto it = cache->asts.find(key);
+    if (it != cache->asts.end()) {
+      return it->second;
+    }
+  }
+
+  // Errors aren't cached, they're rare and carry the context of the call that hit them.
+  PL_ASSIGN_OR_RETURN(pypa::AstModulePtr ast, Parse(text, parse_doc_strings));
+  absl::MutexLock lock(&cache->lock);
+  if (cache->asts.size() >= kMaxCachedAsts) {
+    cache->asts.clear();
+  }
+  // Another thread may have parsed the same text in the meantime, in which case its ast is kept.
+  return cache->asts.try_emplace(std::move(key), std::move(ast)).first->second;
+}
+
+size_t Parser::NumCachedAsts() {
+  ParseCache* cache = GetParseCache();
+  absl::MutexLock lock(&cache->lock);
+  return cache->asts.size();
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
@@ -43,6 +43,20 @@ class Parser {
    * @return the ast module that represents the query.
    */
   StatusOr<pypa::AstModulePtr> Parse(std::string_view query, bool parse_doc_strings = true);
+
+  /**
+   * Parses the text like Parse, but shares the ast across every call with the same text. Meant
+   * for text that is parsed again on every compile, like modules and default argument values.
+   * The returned ast must not be modified. Thread-safe.
+   * @param text the text to parse.
+   * @return the ast module that represents the text.
+   */
+  StatusOr<pypa::AstModulePtr> ParseCached(std::string_view text, bool parse_doc_strings = true);
+
+  /**
+   * @brief The number of asts held by the ParseCached cache.
+   */
+  static size_t NumCachedAsts();
 };
 
 }  // namespace planner
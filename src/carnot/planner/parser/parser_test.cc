@@ -159,6 +159,24 @@ TEST_F(ParserTest, indent_dedent_error) {
                   7, 3, "IndentationError: unindent does not match any outer indentation level"));
 }
 
+TEST_F(ParserTest, ParseCachedSharesAsts) {
+  Parser parser;
+  auto query = absl::StrJoin({"def func():", "    return 'test'", "func()"}, "\n");
+  ASSERT_OK_AND_ASSIGN(auto ast, parser.ParseCached(query));
+  ASSERT_OK_AND_ASSIGN(auto same_ast, parser.ParseCached(query));
+  EXPECT_EQ(ast.get(), same_ast.get());
+
+  // Parsing without doc strings gives a different ast.
+  ASSERT_OK_AND_ASSIGN(auto no_docs_ast, parser.ParseCached(query, /* parse_doc_strings */ false));
+  EXPECT_NE(ast.get(), no_docs_ast.get());
+
+  size_t num_cached = Parser::NumCachedAsts();
+  auto bad_query = "df = df[df['service'] != '' && px.asid() != 10]";
+  EXPECT_THAT(parser.ParseCached(bad_query).status(),
+              HasCompilerError("SyntaxError: Expected expression after operator"));
+  EXPECT_EQ(num_cached, Parser::NumCachedAsts());
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/carnot/planner/plan_cache.h"
+
+#include <absl/hash/hash.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_join.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <utility>
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+namespace {
+
+std::string DeterministicSerialize(const google::protobuf::Message& msg) {
+  std::string out;
+  {
+    google::protobuf::io::StringOutputStream stream(&out);
+    google::protobuf::io::CodedOutputStream coded(&stream);
+    coded.SetSerializationDeterministic(true);
+    msg.SerializeToCodedStream(&coded);
+  }
+  return out;
+}
+
+std::string NormalizeScript(std::string_view script) {
+  std::vector<std::string_view> lines = absl::StrSplit(script, '\n');
+  for (auto& line : lines) {
+    line = absl::StripTrailingAsciiWhitespace(line);
+  }
+  while (!lines.empty() && lines.back().empty()) {
+    lines.pop_back();
+  }
+  auto first = lines.begin();
+  while (first != lines.end() && first->empty()) {
+    ++first;
+  }
+  return absl::StrJoin(first, lines.end(), "\n");
+}
+
+void RebindTime(google::protobuf::Int64Value* time, int64_t shift,
+                const absl::flat_hash_set<int64_t>& relative_times) {
+  if (relative_times.contains(time->value())) {
+    time->set_value(time->value() + shift);
+  }
+}
+
+}  // namespace
+
+std::string PlanCache::Key(const distributedpb::LogicalPlannerState& logical_state,
+                           const plannerpb::QueryRequest& query_request) {
+  std::string key = NormalizeScript(query_request.query_str());
+  for (const auto& func : query_request.exec_funcs()) {
+    absl::StrAppend(&key, "\n", DeterministicSerialize(func));
+  }
+  // The planner state holds the schemas of every table and can be large, so only its hash is
+  // part of the key.
+  absl::StrAppend(&key, "\n", absl::Hash<std::string>{}(DeterministicSerialize(logical_state)));
+  return key;
+}
+
+std::optional<distributedpb::DistributedPlan> PlanCache::Get(const std::string& key,
+                                                             int64_t time_now) {
+  absl::MutexLock lock(&mu_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return std::nullopt;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  const Entry& entry = *it->second;
+
+  distributedpb::DistributedPlan plan = entry.plan;
+  int64_t shift = time_now - entry.time_now;
+  if (shift == 0 || entry.relative_times.empty()) {
+    return plan;
+  }
+  for (auto& [address, carnot_plan] : *plan.mutable_qb_address_to_plan()) {
+    for (auto& fragment : *carnot_plan.mutable_nodes()) {
+      for (auto& node : *fragment.mutable_nodes()) {
+        if (!node.op().has_mem_source_op()) {
+          continue;
+        }
+        auto* mem_src = node.mutable_op()->mutable_mem_source_op();
+        if (mem_src->has_start_time()) {
+          RebindTime(mem_src->mutable_start_time(), shift, entry.relative_times);
+        }
+        if (mem_src->has_stop_time()) {
+          RebindTime(mem_src->mutable_stop_time(), shift, entry.relative_times);
+        }
+      }
+    }
+  }
+  return plan;
+}
+
+void PlanCache::Put(const std::string& key, const distributedpb::DistributedPlan& plan,
+                    int64_t time_now, const absl::flat_hash_set<int64_t>& relative_times) {
+  if (max_entries_ <= 0) {
+    return;
+  }
+  absl::MutexLock lock(&mu_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    auto entry_it = it->second;
+    index_.erase(it);
+    entries_.erase(entry_it);
+  }
+  entries_.push_front(Entry{key, plan, time_now, relative_times});
+  index_.emplace(entries_.front().key, entries_.begin());
+  while (static_cast<int64_t>(entries_.size()) > max_entries_) {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+}
+
+void PlanCache::Clear() {
+  absl::MutexLock lock(&mu_);
+  index_.clear();
+  entries_.clear();
+}
+
+int64_t PlanCache::size() const {
+  absl::MutexLock lock(&mu_);
+  return entries_.size();
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/carnot/planner/distributedpb/distributed_plan.pb.h"
+#include "src/carnot/planner/plannerpb/func_args.pb.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+/**
+ * @brief PlanCache holds the distributed plans of recently planned queries, so that scripts which
+ * are run over and over, ie. live views that refresh every few seconds, skip the compiler.
+ *
+ * Entries are keyed on the script, its arguments and the full planner state, so any change to the
+ * agent set, the schemas or the plan options misses the cache. The relative start and stop times
+ * of memory sources are the only part of a cached plan that depends on when it was compiled, and
+ * they are shifted to the current time when the plan is reused.
+ */
+class PlanCache : public NotCopyable {
+ public:
+  explicit PlanCache(int64_t max_entries) : max_entries_(max_entries) {}
+
+  /**
+   * @brief Returns the cache key of the query. Whitespace at the end of lines and blank lines
+   * around the script don't change the key.
+   */
+  static std::string Key(const distributedpb::LogicalPlannerState& logical_state,
+                         const plannerpb::QueryRequest& query_request);
+
+  /**
+   * @brief Returns a copy of the plan cached for key, with its relative times moved to time_now,
+   * or std::nullopt if there isn't one.
+   */
+  std::optional<distributedpb::DistributedPlan> Get(const std::string& key, int64_t time_now);
+
+  /**
+   * @brief Caches the plan compiled at time_now. relative_times are the memory source times that
+   * were computed as offsets from time_now.
+   */
+  void Put(const std::string& key, const distributedpb::DistributedPlan& plan, int64_t time_now,
+           const absl::flat_hash_set<int64_t>& relative_times);
+
+  void Clear();
+  int64_t size() const;
+
+ private:
+  struct Entry {
+    std::string key;
+    distributedpb::DistributedPlan plan;
+    int64_t time_now;
+    absl::flat_hash_set<int64_t> relative_times;
+  };
+
+  const int64_t max_entries_;
+  mutable absl::Mutex mu_;
+  // Ordered from the most to the least recently used. The index keys point into the entries.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string_view, std::list<Entry>::iterator> index_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
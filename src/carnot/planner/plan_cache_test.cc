@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gmock/gmock.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/carnot/planner/plan_cache.h"
+#include "src/carnot/planner/test_utils.h"
+#include "src/common/testing/protobuf.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+using px::testing::proto::EqualsProto;
+
+constexpr char kMemSrcPlan[] = R"proto(
+qb_address_to_plan {
+  key: "pem"
+  value {
+    nodes {
+      id: 1
+      nodes {
+        id: 1
+        op {
+          op_type: MEMORY_SOURCE_OPERATOR
+          mem_source_op {
+            name: "http_events"
+            start_time { value: 1000 }
+            stop_time { value: 5000 }
+          }
+        }
+      }
+    }
+  }
+}
+)proto";
+
+constexpr char kReboundMemSrcPlan[] = R"proto(
+qb_address_to_plan {
+  key: "pem"
+  value {
+    nodes {
+      id: 1
+      nodes {
+        id: 1
+        op {
+          op_type: MEMORY_SOURCE_OPERATOR
+          mem_source_op {
+            name: "http_events"
+            start_time { value: 1500 }
+            stop_time { value: 5000 }
+          }
+        }
+      }
+    }
+  }
+}
+)proto";
+
+plannerpb::QueryRequest MakeQueryRequest(const std::string& query, const std::string& arg = "") {
+  plannerpb::QueryRequest query_request;
+  query_request.set_query_str(query);
+  if (!arg.empty()) {
+    auto* func = query_request.add_exec_funcs();
+    func->set_func_name("f");
+    func->set_output_table_prefix("out");
+    auto* arg_value = func->add_arg_values();
+    arg_value->set_name("start_time");
+    arg_value->set_value(arg);
+  }
+  return query_request;
+}
+
+TEST(PlanCacheTest, key) {
+  auto state = testutils::CreateTwoPEMsOneKelvinPlannerState(testutils::kHttpEventsSchema);
+  auto key = PlanCache::Key(state, MakeQueryRequest("import px\npx.display(df)\n"));
+  EXPECT_EQ(key, PlanCache::Key(state, MakeQueryRequest("\nimport px  \npx.display(df)\n\n")));
+  EXPECT_NE(key, PlanCache::Key(state, MakeQueryRequest("import px\npx.display(df, 'a')\n")));
+  EXPECT_NE(key, PlanCache::Key(state, MakeQueryRequest("import px\npx.display(df)\n", "-5m")));
+  EXPECT_NE(PlanCache::Key(state, MakeQueryRequest("import px\npx.display(df)\n", "-5m")),
+            PlanCache::Key(state, MakeQueryRequest("import px\npx.display(df)\n", "-10m")));
+
+  auto other_state = testutils::CreateOnePEMOneKelvinPlannerState(testutils::kHttpEventsSchema);
+  EXPECT_NE(key, PlanCache::Key(other_state, MakeQueryRequest("import px\npx.display(df)\n")));
+  state.mutable_plan_options()->set_max_output_rows_per_table(10);
+  EXPECT_NE(key, PlanCache::Key(state, MakeQueryRequest("import px\npx.display(df)\n")));
+}
+
+TEST(PlanCacheTest, rebinds_relative_times) {
+  distributedpb::DistributedPlan plan;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(kMemSrcPlan, &plan));
+
+  PlanCache cache(4);
+  EXPECT_FALSE(cache.Get("key", 100).has_value());
+  // Only the start time is relative to the time the plan was compiled.
+  cache.Put("key", plan, 100, {1000});
+
+  auto cached_plan = cache.Get("key", 100);
+  ASSERT_TRUE(cached_plan.has_value());
+  EXPECT_THAT(cached_plan.value(), EqualsProto(kMemSrcPlan));
+
+  cached_plan = cache.Get("key", 600);
+  ASSERT_TRUE(cached_plan.has_value());
+  EXPECT_THAT(cached_plan.value(), EqualsProto(kReboundMemSrcPlan));
+}
+
+TEST(PlanCacheTest, evicts_least_recently_used) {
+  distributedpb::DistributedPlan plan;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(kMemSrcPlan, &plan));
+
+  PlanCache cache(2);
+  cache.Put("a", plan, 0, {});
+  cache.Put("b", plan, 0, {});
+  EXPECT_TRUE(cache.Get("a", 0).has_value());
+  cache.Put("c", plan, 0, {});
+  EXPECT_EQ(2, cache.size());
+  EXPECT_TRUE(cache.Get("a", 0).has_value());
+  EXPECT_FALSE(cache.Get("b", 0).has_value());
+  EXPECT_TRUE(cache.Get("c", 0).has_value());
+
+  cache.Put("c", plan, 0, {});
+  EXPECT_EQ(2, cache.size());
+  cache.Clear();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_FALSE(cache.Get("a", 0).has_value());
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
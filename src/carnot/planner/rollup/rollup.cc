@@ -0,0 +1,204 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/rollup/rollup.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+using table_store::schema::Relation;
+
+namespace {
+
+constexpr char kTimeColumn[] = "time_";
+
+// The ids of the operators of the maintenance plan, which is a single chain.
+constexpr int64_t kSourceID = 1;
+constexpr int64_t kMapID = 2;
+constexpr int64_t kAggID = 3;
+constexpr int64_t kSinkID = 4;
+
+Status ValidateRollup(const RollupDefinition& rollup, const Relation& source_relation) {
+  if (rollup.bucket_ns <= 0) {
+    return error::InvalidArgument("Rollup '$0' needs a positive bucket_ns, got $1",
+                                  rollup.rollup_table, rollup.bucket_ns);
+  }
+  if (rollup.aggregates.empty()) {
+    return error::InvalidArgument("Rollup '$0' has no aggregates", rollup.rollup_table);
+  }
+  if (!source_relation.HasColumn(kTimeColumn) ||
+      source_relation.GetColumnType(kTimeColumn) != types::TIME64NS) {
+    return error::InvalidArgument("Rollup '$0' needs a $1 column of type TIME64NS in '$2'",
+                                  rollup.rollup_table, kTimeColumn, rollup.source_table);
+  }
+  std::vector<std::string> columns = rollup.group_columns;
+  for (const auto& agg : rollup.aggregates) {
+    columns.push_back(agg.arg_column);
+  }
+  for (const auto& col : columns) {
+    if (!source_relation.HasColumn(col)) {
+      return error::InvalidArgument("Rollup '$0' refers to column '$1', which '$2' doesn't have",
+                                    rollup.rollup_table, col, rollup.source_table);
+    }
+  }
+  if (std::find(rollup.group_columns.begin(), rollup.group_columns.end(), kTimeColumn) !=
+      rollup.group_columns.end()) {
+    return error::InvalidArgument("Rollup '$0' can't group by $1, it's binned into buckets",
+                                  rollup.rollup_table, kTimeColumn);
+  }
+  return Status::OK();
+}
+
+planpb::Operator* AddOperator(planpb::PlanFragment* fragment, int64_t id,
+                              planpb::OperatorType op_type) {
+  auto* dag_node = fragment->mutable_dag()->add_nodes();
+  dag_node->set_id(id);
+  if (id > kSourceID) {
+    dag_node->add_sorted_parents(id - 1);
+  }
+  if (id < kSinkID) {
+    dag_node->add_sorted_children(id + 1);
+  }
+  auto* node = fragment->add_nodes();
+  node->set_id(id);
+  node->mutable_op()->set_op_type(op_type);
+  return node->mutable_op();
+}
+
+void SetColumn(planpb::Column* column, int64_t node, int64_t index) {
+  column->set_node(node);
+  column->set_index(index);
+}
+
+}  // namespace
+
+const std::vector<RollupDefinition>& DefaultRollups() {
+  static const auto* rollups = new std::vector<RollupDefinition>{
+      // Per pod and endpoint request counts and latency quantiles, every 10s.
+      {"http_events",
+       "http_events.10s",
+       {"upid", "req_path"},
+       {{"count", "latency"}, {"quantiles", "latency"}},
+       /* bucket_ns */ 10LL * 1000 * 1000 * 1000},
+  };
+  return *rollups;
+}
+
+StatusOr<Relation> RollupRelation(const RollupDefinition& rollup,
+                                  const Relation& source_relation) {
+  PL_RETURN_IF_ERROR(ValidateRollup(rollup, source_relation));
+  Relation relation;
+  relation.AddColumn(types::TIME64NS, kTimeColumn,
+                     source_relation.GetColumnSemanticType(kTimeColumn));
+  for (const auto& group : rollup.group_columns) {
+    relation.AddColumn(source_relation.GetColumnType(group), group,
+                       source_relation.GetColumnSemanticType(group));
+  }
+  relation.AddColumn(types::STRING, kRollupPartialsColumn);
+  return relation;
+}
+
+StatusOr<planpb::Plan> RollupMaintenancePlan(const RollupDefinition& rollup,
+                                             const Relation& source_relation) {
+  PL_ASSIGN_OR_RETURN(Relation rollup_relation, RollupRelation(rollup, source_relation));
+
+  // The source reads time_, then the group columns, then the remaining UDA arguments.
+  std::vector<std::string> columns{kTimeColumn};
+  columns.insert(columns.end(), rollup.group_columns.begin(), rollup.group_columns.end());
+  for (const auto& agg : rollup.aggregates) {
+    if (std::find(columns.begin(), columns.end(), agg.arg_column) == columns.end()) {
+      columns.push_back(agg.arg_column);
+    }
+  }
+  auto column_index = [&columns](const std::string& col) {
+    return std::find(columns.begin(), columns.end(), col) - columns.begin();
+  };
+
+  planpb::Plan plan;
+  plan.mutable_dag()->add_nodes()->set_id(1);
+  auto* fragment = plan.add_nodes();
+  fragment->set_id(1);
+
+  auto* src = AddOperator(fragment, kSourceID, planpb::MEMORY_SOURCE_OPERATOR)
+                  ->mutable_mem_source_op();
+  src->set_name(rollup.source_table);
+  for (const auto& col : columns) {
+    src->add_column_idxs(source_relation.GetColumnIndex(col));
+    src->add_column_names(col);
+    src->add_column_types(source_relation.GetColumnType(col));
+  }
+  src->set_streaming(true);
+  // Each window of the stream flushes the partial aggregates of its rows.
+  src->set_stream_window_ms(std::max<int64_t>(rollup.bucket_ns / 1000 / 1000, 1));
+
+  // time_ is binned to the start of its bucket, the other columns are passed through.
+  auto* map = AddOperator(fragment, kMapID, planpb::MAP_OPERATOR)->mutable_map_op();
+  for (const auto& [idx, col] : Enumerate(columns)) {
+    auto* expr = map->add_expressions();
+    map->add_column_names(col);
+    if (idx > 0) {
+      SetColumn(expr->mutable_column(), kSourceID, idx);
+      continue;
+    }
+    auto* bin = expr->mutable_func();
+    bin->set_name("bin");
+    bin->set_id(0);
+    SetColumn(bin->add_args()->mutable_column(), kSourceID, idx);
+    auto* bucket = bin->add_args()->mutable_constant();
+    bucket->set_data_type(types::INT64);
+    bucket->set_int64_value(rollup.bucket_ns);
+    bin->add_args_data_types(types::TIME64NS);
+    bin->add_args_data_types(types::INT64);
+  }
+
+  auto* agg = AddOperator(fragment, kAggID, planpb::AGGREGATE_OPERATOR)->mutable_agg_op();
+  for (size_t idx = 0; idx <= rollup.group_columns.size(); ++idx) {
+    SetColumn(agg->add_groups(), kMapID, idx);
+    agg->add_group_names(columns[idx]);
+  }
+  for (const auto& [idx, rollup_agg] : Enumerate(rollup.aggregates)) {
+    auto* value = agg->add_values();
+    value->set_name(rollup_agg.uda_name);
+    value->set_id(idx);
+    SetColumn(value->add_args()->mutable_column(), kMapID, column_index(rollup_agg.arg_column));
+    value->add_args_data_types(source_relation.GetColumnType(rollup_agg.arg_column));
+    agg->add_value_names(absl::Substitute("$0_$1", rollup_agg.uda_name, rollup_agg.arg_column));
+  }
+  agg->set_windowed(true);
+  agg->set_partial_agg(true);
+  agg->set_finalize_results(false);
+
+  auto* sink = AddOperator(fragment, kSinkID, planpb::MEMORY_SINK_OPERATOR)->mutable_mem_sink_op();
+  sink->set_name(rollup.rollup_table);
+  for (size_t idx = 0; idx < rollup_relation.NumColumns(); ++idx) {
+    sink->add_column_names(rollup_relation.GetColumnName(idx));
+    sink->add_column_types(rollup_relation.GetColumnType(idx));
+    sink->add_column_semantic_types(rollup_relation.GetColumnSemanticType(idx));
+  }
+  sink->set_append(true);
+  return plan;
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
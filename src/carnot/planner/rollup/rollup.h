@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+#include "src/table_store/schema/relation.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+// The column of a rollup table that holds the packed partial aggregates of each row. It has the
+// name that partial aggregates give their output.
+constexpr char kRollupPartialsColumn[] = "serialized_expressions";
+
+struct RollupAggregate {
+  // The name of the UDA, which must support partial aggregation.
+  std::string uda_name;
+  // The source column that the UDA aggregates.
+  std::string arg_column;
+};
+
+/**
+ * RollupDefinition declares a table that the PEMs maintain continuously from one of their source
+ * tables. Every bucket_ns interval of source rows is partially aggregated by the group columns,
+ * and the rollup table holds one row per bucket and group: the bucket start as time_, the group
+ * columns, and the packed partial aggregates. Queries that aggregate the source table the same
+ * way can be answered from the rollup table by only finalizing the aggregates.
+ */
+struct RollupDefinition {
+  std::string source_table;
+  std::string rollup_table;
+  std::vector<std::string> group_columns;
+  std::vector<RollupAggregate> aggregates;
+  int64_t bucket_ns = 0;
+};
+
+/**
+ * @brief The rollups that the PEMs maintain and that the planner answers queries from.
+ */
+const std::vector<RollupDefinition>& DefaultRollups();
+
+/**
+ * @brief Returns the relation of the rollup table: time_, the group columns and the packed
+ * partial aggregates.
+ */
+StatusOr<table_store::schema::Relation> RollupRelation(
+    const RollupDefinition& rollup, const table_store::schema::Relation& source_relation);
+
+/**
+ * @brief Returns the continuous query that maintains the rollup table. It streams the source
+ * table in windows of bucket_ns, bins time_ into buckets and appends the partial aggregates of
+ * every window to the rollup table. The query runs until it's stopped.
+ */
+StatusOr<planpb::Plan> RollupMaintenancePlan(const RollupDefinition& rollup,
+                                             const table_store::schema::Relation& source_relation);
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/carnot/planner/rollup/rollup.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace carnot {
+namespace planner {
+
+using table_store::schema::Relation;
+using ::testing::ElementsAre;
+
+class RollupTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    source_relation_ = Relation(
+        {types::TIME64NS, types::UINT128, types::STRING, types::INT64, types::STRING},
+        {"time_", "upid", "req_path", "latency", "req_body"});
+    rollup_ = RollupDefinition{"http_events",
+                               "http_events.10s",
+                               {"upid", "req_path"},
+                               {{"count", "latency"}, {"quantiles", "latency"}},
+                               /* bucket_ns */ 10LL * 1000 * 1000 * 1000};
+  }
+
+  Relation source_relation_;
+  RollupDefinition rollup_;
+};
+
+TEST_F(RollupTest, relation) {
+  ASSERT_OK_AND_ASSIGN(Relation relation, RollupRelation(rollup_, source_relation_));
+  EXPECT_THAT(relation.col_names(),
+              ElementsAre("time_", "upid", "req_path", "serialized_expressions"));
+  EXPECT_THAT(relation.col_types(),
+              ElementsAre(types::TIME64NS, types::UINT128, types::STRING, types::STRING));
+}
+
+TEST_F(RollupTest, maintenance_plan) {
+  ASSERT_OK_AND_ASSIGN(planpb::Plan plan, RollupMaintenancePlan(rollup_, source_relation_));
+  ASSERT_EQ(1, plan.nodes_size());
+  const auto& nodes = plan.nodes(0).nodes();
+  ASSERT_EQ(4, nodes.size());
+
+  const auto& src = nodes[0].op().mem_source_op();
+  EXPECT_EQ("http_events", src.name());
+  EXPECT_THAT(src.column_names(), ElementsAre("time_", "upid", "req_path", "latency"));
+  EXPECT_THAT(src.column_idxs(), ElementsAre(0, 1, 2, 3));
+  EXPECT_TRUE(src.streaming());
+  EXPECT_EQ(10000, src.stream_window_ms());
+
+  const auto& map = nodes[1].op().map_op();
+  EXPECT_EQ("bin", map.expressions(0).func().name());
+  EXPECT_EQ(rollup_.bucket_ns, map.expressions(0).func().args(1).constant().int64_value());
+
+  const auto& agg = nodes[2].op().agg_op();
+  EXPECT_THAT(agg.group_names(), ElementsAre("time_", "upid", "req_path"));
+  ASSERT_EQ(2, agg.values_size());
+  EXPECT_EQ("count", agg.values(0).name());
+  EXPECT_EQ("quantiles", agg.values(1).name());
+  // Both aggregate the latency column of the map.
+  EXPECT_EQ(3, agg.values(0).args(0).column().index());
+  EXPECT_EQ(3, agg.values(1).args(0).column().index());
+  EXPECT_TRUE(agg.windowed());
+  EXPECT_TRUE(agg.partial_agg());
+  EXPECT_FALSE(agg.finalize_results());
+
+  const auto& sink = nodes[3].op().mem_sink_op();
+  EXPECT_EQ("http_events.10s", sink.name());
+  EXPECT_THAT(sink.column_names(),
+              ElementsAre("time_", "upid", "req_path", "serialized_expressions"));
+  EXPECT_TRUE(sink.append());
+}
+
+TEST_F(RollupTest, invalid_definitions) {
+  auto missing_column = rollup_;
+  missing_column.group_columns.push_back("pod");
+  EXPECT_NOT_OK(RollupRelation(missing_column, source_relation_));
+
+  auto no_bucket = rollup_;
+  no_bucket.bucket_ns = 0;
+  EXPECT_NOT_OK(RollupMaintenancePlan(no_bucket, source_relation_));
+
+  auto time_group = rollup_;
+  time_group.group_columns.push_back("time_");
+  EXPECT_NOT_OK(RollupRelation(time_group, source_relation_));
+}
+
+}  // namespace planner
+}  // namespace carnot
+}  // namespace px
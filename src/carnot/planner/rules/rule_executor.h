@@ -17,8 +17,14 @@
  */
 
 #pragma once
+#include <cxxabi.h>
+
+#include <chrono>
+#include <cstdlib>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -116,6 +122,21 @@ class BaseRuleBatch {
 
 using RuleBatch = BaseRuleBatch<Rule>;
 
+/**
+ * @brief Execution counters of a rule in a rule batch, collected by the RuleExecutor.
+ */
+struct RuleExecutionStats {
+  std::string batch_name;
+  std::string rule_name;
+  // Passes over the graph, full or incremental.
+  int64_t num_passes = 0;
+  // Passes that were skipped because nothing changed since the rule's previous no-op pass.
+  int64_t num_skipped = 0;
+  // Passes that changed the graph.
+  int64_t num_changes = 0;
+  std::chrono::nanoseconds total_time{0};
+};
+
 template <typename TPlan>
 class RuleExecutor {
   using TRule = BaseRule<TPlan>;
@@ -123,17 +144,49 @@ class RuleExecutor {
 
  public:
   virtual ~RuleExecutor() = default;
-  // TODO(philkuz) figure out how to collect stats on the execution.
   Status Execute(TPlan* ir_graph) {
+    stats_.clear();
+    // Counts the rule passes that changed the graph. A rule that made a pass without changes
+    // can't change the graph again until some other pass does, so it's skipped until then.
+    int64_t num_graph_changes = 0;
     for (const auto& rb : rule_batches) {
+      std::vector<int64_t> noop_at_changes(rb->rules().size(), -1);
+      // The graph versions at the start of each rule's previous pass, -1 before the first pass.
+      std::vector<int64_t> pass_versions(rb->rules().size(), -1);
+      size_t stats_offset = stats_.size();
+      for (const auto& rule : rb->rules()) {
+        stats_.push_back(RuleExecutionStats{rb->name(), RuleName(*rule)});
+      }
+
       bool can_continue = true;
       int64_t iteration = 0;
       // We continue executing a batch until a stop condition is met.
       while (can_continue) {
         iteration += 1;
         bool graph_is_updated = false;
-        for (const auto& rule : rb->rules()) {
-          PL_ASSIGN_OR_RETURN(bool rule_updates_graph, rule->Execute(ir_graph));
+        for (const auto& [rule_idx, rule] : Enumerate(rb->rules())) {
+          auto& stats = stats_[stats_offset + rule_idx];
+          if (noop_at_changes[rule_idx] == num_graph_changes) {
+            stats.num_skipped++;
+            continue;
+          }
+          auto start = std::chrono::steady_clock::now();
+          PL_ASSIGN_OR_RETURN(bool rule_updates_graph,
+                              ExecuteRule(rule.get(), ir_graph, &pass_versions[rule_idx]));
+          stats.total_time += std::chrono::steady_clock::now() - start;
+          stats.num_passes++;
+          if (rule_updates_graph) {
+            stats.num_changes++;
+            num_graph_changes++;
+            if constexpr (std::is_same_v<TPlan, IR>) {
+              // Only incremental rules promise that they just change the nodes they mark.
+              if (!rule->SupportsIncrementalExecution()) {
+                ir_graph->MarkGraphChanged();
+              }
+            }
+          } else {
+            noop_at_changes[rule_idx] = num_graph_changes;
+          }
           graph_is_updated = graph_is_updated || rule_updates_graph;
         }
         if (iteration >= rb->max_iterations() && graph_is_updated) {
@@ -141,15 +194,20 @@ class RuleExecutor {
           // TODO(philkuz) Reviewer: should this be a failure somehow?
           can_continue = false;
         }
-        // TODO(philkuz) in the future we might have a fast way to check whether the graph has
-        // changed. For now let's be lazy and leave it up to the user to make sure rules properly
-        // update.
         // (graph_is_updated == false) => the graph has reached a fixed point and is done
         if (!graph_is_updated) {
           can_continue = false;
         }
       }
     }
+    if (VLOG_IS_ON(1)) {
+      for (const auto& stats : stats_) {
+        VLOG(1) << absl::Substitute("Rule $0/$1: $2 passes, $3 skipped, $4 changes, $5us",
+                                    stats.batch_name, stats.rule_name, stats.num_passes,
+                                    stats.num_skipped, stats.num_changes,
+                                    stats.total_time.count() / 1000);
+      }
+    }
     return Status::OK();
   }
   template <typename S, typename... Args>
@@ -160,8 +218,40 @@ class RuleExecutor {
     return out_ptr;
   }
 
+  /**
+   * @brief The execution counters and time of every rule in the last call to Execute.
+   */
+  const std::vector<RuleExecutionStats>& stats() const { return stats_; }
+
  private:
+  // Runs a full pass of the rule, or an incremental one when the rule supports it and has already
+  // made a full pass over the graph.
+  StatusOr<bool> ExecuteRule(TRule* rule, TPlan* ir_graph, int64_t* pass_version) {
+    if constexpr (std::is_same_v<TPlan, IR>) {
+      int64_t since_version = *pass_version;
+      *pass_version = ir_graph->change_version();
+      if (since_version >= 0 && since_version >= ir_graph->graph_change_version() &&
+          rule->SupportsIncrementalExecution()) {
+        return rule->ExecuteIncremental(ir_graph, since_version);
+      }
+    }
+    return rule->Execute(ir_graph);
+  }
+
+  static std::string RuleName(const TRule& rule) {
+    const char* mangled = typeid(rule).name();
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    if (status != 0 || demangled == nullptr) {
+      return mangled;
+    }
+    std::string name(demangled);
+    std::free(demangled);
+    return name;
+  }
+
   std::vector<std::unique_ptr<TRuleBatch>> rule_batches;
+  std::vector<RuleExecutionStats> stats_;
 };
 
 }  // namespace planner
@@ -161,8 +161,10 @@ TEST_F(RuleExecutorTest, rules_in_batch_correspond) {
       .WillOnce(Return(true))
       .WillOnce(Return(false));
 
+  // rule1_2 made a pass without changes after rule1_1's change, so it's skipped in the last
+  // iteration.
   MockRule* rule1_2 = rule_batch1->AddRule<MockRule>(compiler_state_.get());
-  EXPECT_CALL(*rule1_2, Execute(_)).Times(3).WillOnce(Return(true)).WillRepeatedly(Return(false));
+  EXPECT_CALL(*rule1_2, Execute(_)).Times(2).WillOnce(Return(true)).WillRepeatedly(Return(false));
 
   EXPECT_OK(executor->Execute(graph.get()));
 }
@@ -181,6 +183,75 @@ TEST_F(RuleExecutorTest, exit_early) {
   EXPECT_NOT_OK(executor->Execute(graph.get()));
 }
 
+// Tests that rules are skipped until some other rule changes the graph, and that the skips are
+// counted in the stats.
+TEST_F(RuleExecutorTest, skips_rules_without_changes) {
+  std::unique_ptr<TestExecutor> executor = std::move(TestExecutor::Create().ValueOrDie());
+  RuleBatch* rule_batch = executor->CreateRuleBatch<FailOnMax>("resolve", 10);
+  MockRule* rule1 = rule_batch->AddRule<MockRule>(compiler_state_.get());
+  EXPECT_CALL(*rule1, Execute(_))
+      .Times(3)
+      .WillOnce(Return(true))
+      .WillOnce(Return(true))
+      .WillOnce(Return(false));
+  MockRule* rule2 = rule_batch->AddRule<MockRule>(compiler_state_.get());
+  EXPECT_CALL(*rule2, Execute(_)).Times(2).WillRepeatedly(Return(false));
+
+  ASSERT_OK(executor->Execute(graph.get()));
+  ASSERT_EQ(2U, executor->stats().size());
+  EXPECT_EQ("resolve", executor->stats()[0].batch_name);
+  EXPECT_EQ("px::carnot::planner::MockRule", executor->stats()[0].rule_name);
+  EXPECT_EQ(3, executor->stats()[0].num_passes);
+  EXPECT_EQ(2, executor->stats()[0].num_changes);
+  EXPECT_EQ(0, executor->stats()[0].num_skipped);
+  EXPECT_EQ(2, executor->stats()[1].num_passes);
+  EXPECT_EQ(0, executor->stats()[1].num_changes);
+  EXPECT_EQ(1, executor->stats()[1].num_skipped);
+}
+
+// Changes the given node the first time it's applied to it, and records every node it's applied
+// to.
+class ChangeOnceRule : public Rule {
+ public:
+  explicit ChangeOnceRule(IRNode* node_to_change)
+      : Rule(nullptr, /*use_topo*/ true, /*reverse_topological_execution*/ false),
+        node_to_change_(node_to_change) {}
+
+  bool SupportsIncrementalExecution() const override { return true; }
+  const std::vector<int64_t>& applied_nodes() const { return applied_nodes_; }
+
+ protected:
+  StatusOr<bool> Apply(IRNode* node) override {
+    applied_nodes_.push_back(node->id());
+    if (node == node_to_change_ && !changed_) {
+      changed_ = true;
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  IRNode* node_to_change_;
+  bool changed_ = false;
+  std::vector<int64_t> applied_nodes_;
+};
+
+// Tests that incremental rules only revisit the nodes around the ones that changed.
+TEST_F(RuleExecutorTest, incremental_rule_revisits_changed_nodes) {
+  std::unique_ptr<TestExecutor> executor = std::move(TestExecutor::Create().ValueOrDie());
+  RuleBatch* rule_batch = executor->CreateRuleBatch<FailOnMax>("resolve", 10);
+  ChangeOnceRule* rule = rule_batch->AddRule<ChangeOnceRule>(map);
+
+  ASSERT_OK(executor->Execute(graph.get()));
+  EXPECT_EQ(2, executor->stats()[0].num_passes);
+  // The first pass runs over the whole graph, the second only over the map and its neighbours.
+  size_t num_nodes = graph->dag().nodes().size();
+  ASSERT_EQ(num_nodes + 3, rule->applied_nodes().size());
+  std::vector<int64_t> second_pass(rule->applied_nodes().begin() + num_nodes,
+                                   rule->applied_nodes().end());
+  EXPECT_THAT(second_pass, ::testing::UnorderedElementsAre(mem_src->id(), map->id(), func2->id()));
+}
+
 }  // namespace planner
 }  // namespace carnot
 }  // namespace px
@@ -20,9 +20,11 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 
 #include "src/carnot/planner/compiler_state/compiler_state.h"
 #include "src/carnot/planner/compiler_state/registry_info.h"
@@ -65,8 +67,47 @@ class BaseRule {
     return any_changed;
   }
 
+  /**
+   * @brief Whether the rule only needs to look at the nodes that changed since its previous pass,
+   * and at their parents and children. Rules that opt in must only depend on the state of a node
+   * and its direct neighbours, and must only change the node they're applied to, its expressions
+   * and the edges of the graph.
+   */
+  virtual bool SupportsIncrementalExecution() const { return false; }
+
+  /**
+   * @brief Runs the rule on the nodes around the ones that changed after the given graph version.
+   */
+  StatusOr<bool> ExecuteIncremental(TPlan* graph, int64_t since_version) {
+    DCHECK(SupportsIncrementalExecution());
+    absl::flat_hash_set<int64_t> changed_nodes = graph->NodesChangedSince(since_version);
+    if (changed_nodes.empty()) {
+      return false;
+    }
+    bool any_changed = false;
+    if (!use_topo_) {
+      PL_ASSIGN_OR_RETURN(any_changed, ExecuteUnsorted(graph, &changed_nodes));
+    } else {
+      PL_ASSIGN_OR_RETURN(any_changed, ExecuteTopologicalSorted(graph, &changed_nodes));
+    }
+    PL_RETURN_IF_ERROR(EmptyDeleteQueue(graph));
+    return any_changed;
+  }
+
  protected:
-  StatusOr<bool> ExecuteTopologicalSorted(TPlan* graph) {
+  // Applies the rule to node_i, marking the node as changed if the rule changed it.
+  StatusOr<bool> ApplyToNode(TPlan* graph, int64_t node_i) {
+    PL_ASSIGN_OR_RETURN(bool node_is_changed, Apply(graph->Get(node_i)));
+    if constexpr (std::is_same_v<TPlan, IR>) {
+      if (node_is_changed && graph->HasNode(node_i)) {
+        graph->MarkNodeChanged(node_i);
+      }
+    }
+    return node_is_changed;
+  }
+
+  StatusOr<bool> ExecuteTopologicalSorted(
+      TPlan* graph, const absl::flat_hash_set<int64_t>* only_nodes = nullptr) {
     bool any_changed = false;
     std::vector<int64_t> topo_graph = graph->dag().TopologicalSort();
     if (reverse_topological_execution_) {
@@ -74,26 +115,27 @@ class BaseRule {
     }
     for (int64_t node_i : topo_graph) {
       // The node may have been deleted by a prior call to Apply on a parent or child node.
-      if (!graph->HasNode(node_i)) {
+      if (!graph->HasNode(node_i) || (only_nodes != nullptr && !only_nodes->contains(node_i))) {
         continue;
       }
-      PL_ASSIGN_OR_RETURN(bool node_is_changed, Apply(graph->Get(node_i)));
+      PL_ASSIGN_OR_RETURN(bool node_is_changed, ApplyToNode(graph, node_i));
       any_changed = any_changed || node_is_changed;
     }
     return any_changed;
   }
 
-  StatusOr<bool> ExecuteUnsorted(TPlan* graph) {
+  StatusOr<bool> ExecuteUnsorted(TPlan* graph,
+                                 const absl::flat_hash_set<int64_t>* only_nodes = nullptr) {
     bool any_changed = false;
     // We need to copy over nodes because the Apply() might add nodes which can affect traversal,
     // causing nodes to be skipped.
     auto nodes = graph->dag().nodes();
     for (int64_t node_i : nodes) {
       // The node may have been deleted by a prior call to Apply on a parent or child node.
-      if (!graph->HasNode(node_i)) {
+      if (!graph->HasNode(node_i) || (only_nodes != nullptr && !only_nodes->contains(node_i))) {
         continue;
       }
-      PL_ASSIGN_OR_RETURN(bool node_is_changed, Apply(graph->Get(node_i)));
+      PL_ASSIGN_OR_RETURN(bool node_is_changed, ApplyToNode(graph, node_i));
       any_changed = any_changed || node_is_changed;
     }
     return any_changed;
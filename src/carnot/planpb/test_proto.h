@@ -335,6 +335,24 @@ columns {
   index: 2
 }
 )";
+// Keeps the 3 records with the largest values of column 1.
+constexpr char kTopKLimitOperator1[] = R"(
+limit: 3
+columns {
+  node: 1
+  index: 0
+}
+columns {
+  node: 1
+  index: 1
+}
+sort_columns {
+  node: 1
+  index: 1
+}
+sort_ascending: false
+)";
+
 // relation 1: [abc, time_]
 // relation 2: [time_, abc]
 // maps to output relation:
@@ -612,6 +630,55 @@ func {
   args_data_types: STRING
 })";
 
+// col0 > 1 && 9 >= col1.
+constexpr char kRangeScalarFuncConstPbtxt[] = R"(
+func {
+  name: "logicalAnd"
+  id: 2
+  args {
+    func {
+      name: "greaterThan"
+      id: 3
+      args {
+        column {
+          node: 0
+          index: 0
+        }
+      }
+      args {
+        constant {
+          data_type: INT64,
+          int64_value: 1
+        }
+      }
+      args_data_types: INT64
+      args_data_types: INT64
+    }
+  }
+  args {
+    func {
+      name: "greaterThanEqual"
+      id: 4
+      args {
+        constant {
+          data_type: INT64,
+          int64_value: 9
+        }
+      }
+      args {
+        column {
+          node: 0
+          index: 1
+        }
+      }
+      args_data_types: INT64
+      args_data_types: INT64
+    }
+  }
+  args_data_types: BOOLEAN
+  args_data_types: BOOLEAN
+})";
+
 constexpr char kAddScalarFuncNestedPbtxt[] = R"(
 func {
   name: "add"
@@ -1306,6 +1373,15 @@ planpb::Operator CreateTestFilterTwoColsColumnSelection() {
   return op;
 }
 
+planpb::Operator CreateTestFilterTwoColsRange() {
+  planpb::Operator op;
+  auto op_proto =
+      absl::Substitute(kOperatorProtoTmpl, "FILTER_OPERATOR", "filter_op",
+                       absl::Substitute(kFilterOperatorTmpl, kRangeScalarFuncConstPbtxt));
+  CHECK(google::protobuf::TextFormat::MergeFromString(op_proto, &op)) << "Failed to parse proto";
+  return op;
+}
+
 planpb::Operator CreateTestFilterTwoColsString() {
   planpb::Operator op;
   auto op_proto =
@@ -1333,6 +1409,12 @@ planpb::Operator CreateTestStreamingSource1PB(const std::string& table_name = "c
   return op;
 }
 
+planpb::Operator CreateTestWindowedStreamingSource1PB(int64_t stream_window_ms) {
+  planpb::Operator op = CreateTestStreamingSource1PB();
+  op.mutable_mem_source_op()->set_stream_window_ms(stream_window_ms);
+  return op;
+}
+
 planpb::Operator CreateTestSourceWithTablets1PB(const types::TabletID& tablet_value) {
   planpb::Operator op;
   auto mem_proto = absl::Substitute(kMemSourceOperatorWithTablet1, tablet_value);
@@ -1478,6 +1560,14 @@ planpb::Operator CreateTestDropLimit1PB() {
   return op;
 }
 
+planpb::Operator CreateTestTopKLimit1PB() {
+  planpb::Operator op;
+  auto op_proto =
+      absl::Substitute(kOperatorProtoTmpl, "LIMIT_OPERATOR", "limit_op", kTopKLimitOperator1);
+  CHECK(google::protobuf::TextFormat::MergeFromString(op_proto, &op)) << "Failed to parse proto";
+  return op;
+}
+
 planpb::Operator CreateTestJoinWithTimePB() {
   planpb::Operator op;
   auto op_proto = absl::Substitute(kOperatorProtoTmpl, "JOIN_OPERATOR", "join_op", kJoinOperator1);
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <sole.hpp>
+
+#include "src/carnot/carnot.h"
+#include "src/carnot/exec/local_grpc_result_server.h"
+#include "src/carnot/exec/test_utils.h"
+#include "src/common/base/base.h"
+#include "src/common/benchmark/benchmark.h"
+#include "src/table_store/test_utils.h"
+
+// Runs PxL scripts shaped like the ones in src/pxl_scripts end to end through Carnot, over
+// synthetic http_events and conn_stats tables, to get scaling curves of the main plan shapes.
+// The scripts leave out the metadata (ctx) lookups, which need an agent metadata state.
+
+namespace px {
+namespace carnot {
+namespace exec {
+
+constexpr char kFilterQuery[] = R"pxl(
+import px
+df = px.DataFrame(table='http_events')
+df = df[df.resp_status >= 500]
+px.display(df[['time_', 'upid', 'req_path', 'resp_status', 'latency']], '$0')
+)pxl";
+
+constexpr char kAggQuery[] = R"pxl(
+import px
+df = px.DataFrame(table='http_events')
+df.failure = df.resp_status >= 400
+df = df.groupby(['upid', 'req_path']).agg(
+    latency_quantiles=('latency', px.quantiles),
+    error_rate=('failure', px.mean),
+    throughput_total=('latency', px.count),
+)
+px.display(df, '$0')
+)pxl";
+
+constexpr char kJoinQuery[] = R"pxl(
+import px
+http = px.DataFrame(table='http_events')
+http = http.groupby('upid').agg(
+    latency_total=('latency', px.sum),
+    throughput_total=('latency', px.count),
+)
+conns = px.DataFrame(table='conn_stats')
+conns = conns.groupby('upid').agg(
+    bytes_sent=('bytes_sent', px.sum),
+    bytes_recv=('bytes_recv', px.sum),
+)
+df = http.merge(conns, how='inner', left_on='upid', right_on='upid', suffixes=['', '_conn'])
+px.display(df.drop('upid_conn'), '$0')
+)pxl";
+
+constexpr char kUDFQuery[] = R"pxl(
+import px
+window_ns = 10 * 1000 * 1000 * 1000
+df = px.DataFrame(table='http_events')
+df.timestamp = px.bin(df.time_, window_ns)
+df.service = px.substring(df.req_path, 8, 8)
+df.is_json = px.contains(px.tolower(df.resp_headers), 'application/json')
+df.host = px.pluck(df.req_headers, 'Host')
+df.req_size = px.length(df.req_body)
+df = df.groupby(['timestamp', 'service', 'host', 'is_json']).agg(
+    req_size=('req_size', px.sum),
+    latency_quantiles=('latency', px.quantiles),
+)
+df.latency_p99 = px.pluck_float64(df.latency_quantiles, 'p99')
+px.display(df.drop('latency_quantiles'), '$0')
+)pxl";
+
+std::unique_ptr<Carnot> SetUpCarnot(std::shared_ptr<table_store::TableStore> table_store,
+                                    LocalGRPCResultSinkServer* server) {
+  auto carnot_or_s = Carnot::Create(
+      sole::uuid4(), table_store,
+      std::bind(&LocalGRPCResultSinkServer::StubGenerator, server, std::placeholders::_1));
+  if (!carnot_or_s.ok()) {
+    LOG(FATAL) << "Failed to initialize Carnot.";
+  }
+  return carnot_or_s.ConsumeValueOrDie();
+}
+
+// Generating 100M rows takes much longer than querying them, so the table store for each row
+// count is built once and shared by all the queries.
+std::shared_ptr<table_store::TableStore> GetTableStore(int64_t num_rows) {
+  static std::map<int64_t, std::shared_ptr<table_store::TableStore>> table_stores;
+  auto it = table_stores.find(num_rows);
+  if (it != table_stores.end()) {
+    return it->second;
+  }
+
+  auto table_store = std::make_shared<table_store::TableStore>();
+  table_store::HTTPEventsTableSpec http_spec;
+  http_spec.num_rows = num_rows;
+  table_store->AddTable("http_events",
+                        table_store::CreateHTTPEventsTable(http_spec).ConsumeValueOrDie());
+  // Connection stats are sampled, so there are far fewer of them than requests.
+  table_store::ConnStatsTableSpec conn_spec;
+  conn_spec.num_rows = std::max<int64_t>(num_rows / 100, 1);
+  table_store->AddTable("conn_stats",
+                        table_store::CreateConnStatsTable(conn_spec).ConsumeValueOrDie());
+  table_stores.emplace(num_rows, table_store);
+  return table_store;
+}
+
+// NOLINTNEXTLINE : runtime/references.
+void BM_PxLQuery(benchmark::State& state, const std::string& query) {
+  const int64_t num_rows = state.range(0);
+  auto table_store = GetTableStore(num_rows);
+  auto server = LocalGRPCResultSinkServer();
+  auto carnot = SetUpCarnot(table_store, &server);
+
+  int64_t bytes_processed = 0;
+  int i = 0;
+  for (auto _ : state) {
+    auto query_with_table_name = absl::Substitute(query, "results_" + std::to_string(i));
+    auto s = carnot->ExecuteQuery(query_with_table_name, sole::uuid4(), CurrentTimeNS());
+    if (!s.ok()) {
+      LOG(FATAL) << absl::Substitute("PxL benchmark query failed: $0", s.msg());
+    }
+    bytes_processed += server.exec_stats().ConsumeValueOrDie().execution_stats().bytes_processed();
+    ++i;
+  }
+
+  state.SetItemsProcessed(state.iterations() * num_rows);
+  state.SetBytesProcessed(bytes_processed);
+}
+
+#define PXL_QUERY_BENCHMARK(name, query)      \
+  BENCHMARK_CAPTURE(BM_PxLQuery, name, query) \
+      ->Arg(1000000)                          \
+      ->Arg(10000000)                         \
+      ->Arg(100000000)                        \
+      ->Unit(benchmark::kMillisecond)
+
+PXL_QUERY_BENCHMARK(filter, kFilterQuery);
+PXL_QUERY_BENCHMARK(agg, kAggQuery);
+PXL_QUERY_BENCHMARK(join, kJoinQuery);
+PXL_QUERY_BENCHMARK(udf, kUDFQuery);
+
+}  // namespace exec
+}  // namespace carnot
+}  // namespace px
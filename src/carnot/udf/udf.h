@@ -74,6 +74,17 @@ class AnyUDA : public BaseFunc {
  *      Status Init(FunctionContext *ctx, UDFValue... init_args) {}
  *  This function is called once during initialization of each instance (many instances
  *  may exists in a given query). The arguments are as provided by the query.
+ *
+ * Hot UDFs can _optionally_ implement a vectorized form of Exec:
+ *      Status ExecBatch(FunctionContext *ctx, size_t count, const UDFValue*... values,
+ *                       UDFValue* out) {}
+ *  When present it is used instead of calling Exec once per record. It must compute the same
+ *  result as Exec for every record, and should be a simple loop the compiler can vectorize.
+ *
+ * ExecBatch is only used for arrow inputs if the UDF also implements:
+ *      static constexpr bool ExecBatchOnArrow() { return true; }
+ *  The arrow inputs are then copied into UDF values for the call, which only pays off when
+ *  ExecBatch saves work across records, e.g. by computing the result once per distinct input.
  */
 class ScalarUDF : public AnyUDF {
  public:
@@ -188,6 +199,40 @@ static constexpr types::DataType ReturnTypeHelper(ReturnType (TUDF::*)(Types...)
   return types::ValueTypeTraits<ReturnType>::data_type;
 }
 
+/**
+ * Checks to see if a valid looking ExecBatch function exists. A batch function takes a pointer to
+ * the first value of each argument column (in Exec's argument order) followed by a pointer to the
+ * output, and processes count rows in one call.
+ */
+template <typename ReturnType, typename TUDF, typename... Types>
+static constexpr bool IsValidExecBatchFn(ReturnType (TUDF::*)(Types...)) {
+  return false;
+}
+
+template <typename TUDF, typename... Types>
+static constexpr bool IsValidExecBatchFn(Status (TUDF::*)(FunctionContext*, size_t, Types...)) {
+  return true;
+}
+
+// SFINAE test for ExecBatch fn.
+template <typename T, typename = void>
+struct has_udf_exec_batch_fn : std::false_type {};
+
+template <typename T>
+struct has_udf_exec_batch_fn<T, std::void_t<decltype(&T::ExecBatch)>> : std::true_type {
+  static_assert(IsValidExecBatchFn(&T::ExecBatch),
+                "If an ExecBatch function exists, it must have the form: Status "
+                "ExecBatch(FunctionContext*, size_t count, const TArgs*..., TReturn* out)");
+};
+
+// SFINAE test for ExecBatchOnArrow fn.
+template <typename T, typename = void>
+struct has_udf_exec_batch_on_arrow_fn : std::false_type {};
+
+template <typename T>
+struct has_udf_exec_batch_on_arrow_fn<T, std::void_t<decltype(&T::ExecBatchOnArrow)>>
+    : std::true_type {};
+
 template <typename T, typename = void>
 struct check_init_fn {};
 
@@ -223,6 +268,23 @@ class ScalarUDFTraits {
    */
   static constexpr bool HasInit() { return has_udf_init_fn<T>::value; }
 
+  /**
+   * Checks if the UDF has a vectorized ExecBatch function.
+   * @return true if it has an ExecBatch function.
+   */
+  static constexpr bool HasExecBatch() { return has_udf_exec_batch_fn<T>::value; }
+
+  /**
+   * Checks if ExecBatch should also be used for arrow inputs.
+   * @return true if the UDF has an ExecBatch function and asks for it to be used on arrow inputs.
+   */
+  static constexpr bool UseExecBatchOnArrow() {
+    if constexpr (has_udf_exec_batch_fn<T>::value && has_udf_exec_batch_on_arrow_fn<T>::value) {
+      return T::ExecBatchOnArrow();
+    }
+    return false;
+  }
+
   /**
    * Returns the executor type of this UDF.
    */
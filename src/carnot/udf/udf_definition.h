@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
@@ -207,6 +208,8 @@ class UDADefinition : public UDFDefinition {
     merge_fn_ = UDAWrapper<T>::Merge;
     finalize_arrow_fn_ = UDAWrapper<T>::FinalizeArrow;
     finalize_value_fn = UDAWrapper<T>::FinalizeValue;
+    serialize_fn_ = UDAWrapper<T>::Serialize;
+    deserialize_fn_ = UDAWrapper<T>::Deserialize;
 
     supports_partial_ = UDAWrapper<T>::SupportsPartial;
     return Status::OK();
@@ -245,6 +248,12 @@ class UDADefinition : public UDFDefinition {
   Status FinalizeArrow(UDA* uda, FunctionContext* ctx, arrow::ArrayBuilder* output) {
     return finalize_arrow_fn_(uda, ctx, output);
   }
+  Status Serialize(UDA* uda, FunctionContext* ctx, types::StringValue* output) {
+    return serialize_fn_(uda, ctx, output);
+  }
+  Status Deserialize(UDA* uda, FunctionContext* ctx, const types::StringValue& data) {
+    return deserialize_fn_(uda, ctx, data);
+  }
 
  private:
   std::vector<types::DataType> init_arguments_;
@@ -267,6 +276,9 @@ class UDADefinition : public UDFDefinition {
   std::function<Status(UDA* uda, FunctionContext* ctx, types::BaseValueType* output)>
       finalize_value_fn;
   std::function<Status(UDA* uda1, UDA* uda2, FunctionContext* ctx)> merge_fn_;
+  std::function<Status(UDA* uda, FunctionContext* ctx, types::StringValue* output)> serialize_fn_;
+  std::function<Status(UDA* uda, FunctionContext* ctx, const types::StringValue& data)>
+      deserialize_fn_;
   std::function<Status(UDA* uda, FunctionContext* ctx,
                        const std::vector<std::shared_ptr<types::BaseValueType>>& inputs)>
       init_wrapper_fn_;
@@ -335,8 +347,9 @@ class UDTFDefinition : public UDFDefinition {
   }
 
   bool ExecBatchUpdate(AnyUDTF* udtf, FunctionContext* ctx, int max_gen_records,
-                       std::vector<arrow::ArrayBuilder*>* outputs) {
-    return exec_batch_update_(udtf, ctx, max_gen_records, outputs);
+                       std::vector<arrow::ArrayBuilder*>* outputs,
+                       int64_t max_gen_bytes = std::numeric_limits<int64_t>::max()) {
+    return exec_batch_update_(udtf, ctx, max_gen_records, outputs, max_gen_bytes);
   }
 
   const std::vector<UDTFArg>& init_arguments() const { return init_arguments_; }
@@ -348,7 +361,7 @@ class UDTFDefinition : public UDFDefinition {
   std::function<Status(AnyUDTF*, FunctionContext*, const std::vector<const types::BaseValueType*>&)>
       exec_init_;
   std::function<bool(AnyUDTF* udtf, FunctionContext* ctx, int max_gen_records,
-                     std::vector<arrow::ArrayBuilder*>* outputs)>
+                     std::vector<arrow::ArrayBuilder*>* outputs, int64_t max_gen_bytes)>
       exec_batch_update_;
   std::vector<UDTFArg> init_arguments_;
   std::vector<ColInfo> output_relation_;
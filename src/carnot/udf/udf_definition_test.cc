@@ -20,6 +20,8 @@
 #include <arrow/pretty_print.h>
 
 #include <algorithm>
+#include <cstring>
+#include <string>
 
 #include "src/carnot/udf/udf_definition.h"
 #include "src/common/testing/testing.h"
@@ -51,6 +53,39 @@ class AddUDF : public ScalarUDF {
   }
 };
 
+class BatchAddUDF : public ScalarUDF {
+ public:
+  types::Int64Value Exec(FunctionContext*, types::Int64Value v1, types::Int64Value v2) {
+    return v1.val + v2.val;
+  }
+  Status ExecBatch(FunctionContext*, size_t count, const types::Int64Value* v1,
+                   const types::Int64Value* v2, types::Int64Value* out) {
+    ++exec_batch_calls;
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = v1[i].val + v2[i].val;
+    }
+    return Status::OK();
+  }
+
+  int exec_batch_calls = 0;
+};
+
+class ArrowBatchSubStrUDF : public ScalarUDF {
+ public:
+  types::StringValue Exec(FunctionContext*, types::StringValue str) { return str.substr(1, 2); }
+  Status ExecBatch(FunctionContext* ctx, size_t count, const types::StringValue* str,
+                   types::StringValue* out) {
+    ++exec_batch_calls;
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = Exec(ctx, str[i]);
+    }
+    return Status::OK();
+  }
+  static constexpr bool ExecBatchOnArrow() { return true; }
+
+  int exec_batch_calls = 0;
+};
+
 class InitArgUDF : public ScalarUDF {
  public:
   Status Init(FunctionContext*, types::StringValue str, types::Int64Value i) {
@@ -99,6 +134,24 @@ TEST(UDFDefinition, two_args) {
   EXPECT_EQ(8, out[2].val);
 }
 
+TEST(UDFDefinition, two_args_exec_batch) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  ScalarUDFDefinition def("add");
+  EXPECT_OK(def.Init<BatchAddUDF>());
+
+  types::Int64ValueColumnWrapper v1({1, 2, 3});
+  types::Int64ValueColumnWrapper v2({3, 4, 5});
+
+  types::Int64ValueColumnWrapper out(v1.Size());
+  auto u = def.Make();
+  EXPECT_OK(def.ExecBatch(u.get(), &ctx, {&v1, &v2}, &out, v1.Size()));
+  // The whole batch should be handed to ExecBatch in a single call.
+  EXPECT_EQ(1, static_cast<BatchAddUDF*>(u.get())->exec_batch_calls);
+  EXPECT_EQ(4, out[0].val);
+  EXPECT_EQ(6, out[1].val);
+  EXPECT_EQ(8, out[2].val);
+}
+
 TEST(UDFDefinition, str_args) {
   auto ctx = FunctionContext(nullptr, nullptr);
   ScalarUDFDefinition def("substr");
@@ -136,6 +189,37 @@ TEST(UDFDefinition, arrow_write) {
   EXPECT_EQ(6, resArr->Value(1));
 }
 
+TEST(UDFDefinition, arrow_exec_batch) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  std::vector<types::Int64Value> v1 = {1, 2, 3};
+  std::vector<types::Int64Value> v2 = {3, 4, 5};
+  std::vector<types::StringValue> strs = {"abcd", "defg", "hello"};
+
+  // ExecBatch is only used on arrow inputs when the UDF asks for it.
+  arrow::Int64Builder int_builder;
+  BatchAddUDF add;
+  EXPECT_OK(ScalarUDFWrapper<BatchAddUDF>::ExecBatchArrow(
+      &add, &ctx,
+      {ToArrow(v1, arrow::default_memory_pool()).get(),
+       ToArrow(v2, arrow::default_memory_pool()).get()},
+      &int_builder, 3));
+  EXPECT_EQ(0, add.exec_batch_calls);
+
+  arrow::StringBuilder str_builder;
+  ArrowBatchSubStrUDF substr;
+  EXPECT_OK(ScalarUDFWrapper<ArrowBatchSubStrUDF>::ExecBatchArrow(
+      &substr, &ctx, {ToArrow(strs, arrow::default_memory_pool()).get()}, &str_builder, 3));
+  EXPECT_EQ(1, substr.exec_batch_calls);
+
+  std::shared_ptr<arrow::Array> res;
+  ASSERT_TRUE(str_builder.Finish(&res).ok());
+  auto* str_arr = static_cast<arrow::StringArray*>(res.get());
+  ASSERT_EQ(3, str_arr->length());
+  EXPECT_EQ("bc", str_arr->GetString(0));
+  EXPECT_EQ("ef", str_arr->GetString(1));
+  EXPECT_EQ("el", str_arr->GetString(2));
+}
+
 TEST(UDFDefinition, init_args) {
   auto ctx = FunctionContext(nullptr, nullptr);
   ScalarUDFDefinition def("initargudf");
@@ -174,6 +258,31 @@ class MinSumUDA : public udf::UDA {
   types::Int64Value sum_ = 0;
 };
 
+// MinSumUDA with a partial aggregate representation.
+class PartialMinSumUDA : public udf::UDA {
+ public:
+  void Update(udf::FunctionContext*, types::Int64Value arg1, types::Int64Value arg2) {
+    sum_ = sum_.val + std::min(arg1.val, arg2.val);
+  }
+  void Merge(udf::FunctionContext*, const PartialMinSumUDA& other) {
+    sum_ = sum_.val + other.sum_.val;
+  }
+  types::Int64Value Finalize(udf::FunctionContext*) { return sum_; }
+  types::StringValue Serialize(udf::FunctionContext*) {
+    return std::string(reinterpret_cast<const char*>(&sum_.val), sizeof(sum_.val));
+  }
+  Status Deserialize(udf::FunctionContext*, const types::StringValue& data) {
+    if (data.size() != sizeof(sum_.val)) {
+      return error::InvalidArgument("Invalid partial sum of size $0", data.size());
+    }
+    std::memcpy(&sum_.val, data.data(), sizeof(sum_.val));
+    return Status::OK();
+  }
+
+ private:
+  types::Int64Value sum_ = 0;
+};
+
 class InitArgUDA : public udf::UDA {
  public:
   Status Init(udf::FunctionContext*, types::Int64Value i, types::StringValue str,
@@ -233,6 +342,38 @@ TEST(UDADefinition, with_merge) {
   EXPECT_EQ(11, out.val);
 }
 
+TEST(UDADefinition, serialize_partial) {
+  auto ctx = FunctionContext(nullptr, nullptr);
+  UDADefinition def("partialminsum");
+  EXPECT_OK(def.Init<PartialMinSumUDA>());
+  EXPECT_TRUE(def.supports_partial());
+
+  types::Int64ValueColumnWrapper v1({1, 2, 3});
+  types::Int64ValueColumnWrapper v2({5, 1, 3});
+
+  auto u1 = def.Make();
+  EXPECT_OK(def.ExecBatchUpdate(u1.get(), &ctx, {&v1, &v2}));
+  types::StringValue partial;
+  EXPECT_OK(def.Serialize(u1.get(), &ctx, &partial));
+
+  // Restore the partial into a new instance and merge it with another one.
+  auto u2 = def.Make();
+  EXPECT_OK(def.Deserialize(u2.get(), &ctx, partial));
+  auto u3 = def.Make();
+  EXPECT_OK(def.ExecBatchUpdate(u3.get(), &ctx, {&v1, &v1}));
+  EXPECT_OK(def.Merge(u2.get(), u3.get(), &ctx));
+  types::Int64Value out;
+  EXPECT_OK(def.FinalizeValue(u2.get(), &ctx, &out));
+  EXPECT_EQ(11, out.val);
+
+  // UDAs without a partial representation can't be serialized.
+  UDADefinition minsum_def("minsum");
+  EXPECT_OK(minsum_def.Init<MinSumUDA>());
+  EXPECT_FALSE(minsum_def.supports_partial());
+  auto u4 = minsum_def.Make();
+  EXPECT_NOT_OK(minsum_def.Serialize(u4.get(), &ctx, &partial));
+}
+
 TEST(UDADefinition, arrow_output) {
   auto ctx = FunctionContext(nullptr, nullptr);
   UDADefinition def("minsum");
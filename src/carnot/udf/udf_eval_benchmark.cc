@@ -57,12 +57,27 @@ class AddUDF : public ScalarUDF {
   Int64Value Exec(FunctionContext*, Int64Value v1, Int64Value v2) { return v1.val + v2.val; }
 };
 
+// Same as AddUDF, but provides the vectorized ExecBatch path.
+class BatchAddUDF : public ScalarUDF {
+ public:
+  Int64Value Exec(FunctionContext*, Int64Value v1, Int64Value v2) { return v1.val + v2.val; }
+  Status ExecBatch(FunctionContext*, size_t count, const Int64Value* v1, const Int64Value* v2,
+                   Int64Value* out) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = v1[i].val + v2[i].val;
+    }
+    return Status::OK();
+  }
+};
+
 class SubStrUDF : public ScalarUDF {
  public:
   StringValue Exec(FunctionContext*, StringValue v1) { return v1.substr(1, 2); }
 };
 
-// This benchmark add two columns using Int64ValueVectors.
+// This benchmark add two columns using Int64ValueVectors. TUDF selects between the per row
+// Exec path (AddUDF) and the ExecBatch path (BatchAddUDF).
+template <typename TUDF>
 // NOLINTNEXTLINE : runtime/references.
 static void BM_AddInt64Values(benchmark::State& state) {
   auto vec1 = CreateLargeData<Int64Value>(state.range(0));
@@ -75,7 +90,7 @@ static void BM_AddInt64Values(benchmark::State& state) {
 
   // Create the UDF.
   ScalarUDFDefinition def("add");
-  CHECK(def.template Init<AddUDF>().ok());
+  CHECK(def.template Init<TUDF>().ok());
   auto u = def.Make();
 
   // Loop the test.
@@ -246,7 +261,8 @@ static void BM_SubStrArrow(benchmark::State& state) {
 
 BENCHMARK(BM_AddInt64ValueToArrow)->RangeMultiplier(2)->Range(1, 1 << 16);
 BENCHMARK(BM_AddTwoInt64sArrow)->RangeMultiplier(2)->Range(1, 1 << 16);
-BENCHMARK(BM_AddInt64Values)->RangeMultiplier(2)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_AddInt64Values, AddUDF)->RangeMultiplier(2)->Range(1, 1 << 16);
+BENCHMARK_TEMPLATE(BM_AddInt64Values, BatchAddUDF)->RangeMultiplier(2)->Range(1, 1 << 16);
 
 BENCHMARK(BM_ConvertToArrowString)->RangeMultiplier(2)->Range(1, 1 << 16);
 BENCHMARK(BM_ConvertToArrowInt64)->RangeMultiplier(2)->Range(1, 1 << 16);
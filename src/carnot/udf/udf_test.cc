@@ -43,12 +43,23 @@ class ScalarUDF1WithInit : ScalarUDF {
   types::Int64Value Exec(FunctionContext*, types::BoolValue, types::BoolValue) { return 0; }
 };
 
+class ScalarUDF1WithExecBatch : ScalarUDF {
+ public:
+  types::Int64Value Exec(FunctionContext*, types::BoolValue, types::Int64Value) { return 0; }
+  Status ExecBatch(FunctionContext*, size_t, const types::BoolValue*, const types::Int64Value*,
+                   types::Int64Value*) {
+    return Status::OK();
+  }
+};
+
 TEST(ScalarUDF, basic_tests) {
   EXPECT_EQ(types::DataType::INT64, ScalarUDFTraits<ScalarUDF1>::ReturnType());
   EXPECT_THAT(ScalarUDFTraits<ScalarUDF1>::ExecArguments(),
               ElementsAre(types::DataType::BOOLEAN, types::DataType::INT64));
   EXPECT_FALSE(ScalarUDFTraits<ScalarUDF1>::HasInit());
   EXPECT_TRUE(ScalarUDFTraits<ScalarUDF1WithInit>::HasInit());
+  EXPECT_FALSE(ScalarUDFTraits<ScalarUDF1>::HasExecBatch());
+  EXPECT_TRUE(ScalarUDFTraits<ScalarUDF1WithExecBatch>::HasExecBatch());
 }
 
 TEST(UDFDataTypes, valid_tests) {
@@ -20,8 +20,11 @@
 
 #include <arrow/array.h>
 
+#include <limits>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 #include "src/carnot/udf/udf.h"
@@ -53,7 +56,8 @@ constexpr auto CastToUDFValueType(const types::BaseValueType* arg) {
  * based on the type and arity of the input arguments.
  *
  * This function takes calls the Exec function of the UDF after type casting all the
- * input values. The function is called once for each row of the input batch.
+ * input values. The function is called once for each row of the input batch, unless the
+ * UDF provides ExecBatch, in which case the whole batch is handed to it in a single call.
  *
  * @return Status of execution.
  */
@@ -62,10 +66,14 @@ Status ExecWrapper(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
                    const std::vector<const types::BaseValueType*>& args,
                    std::index_sequence<I...>) {
   [[maybe_unused]] constexpr auto exec_argument_types = ScalarUDFTraits<TUDF>::ExecArguments();
-  for (size_t idx = 0; idx < count; ++idx) {
-    out[idx] = udf->Exec(ctx, CastToUDFValueType<exec_argument_types[I]>(args[I])[idx]...);
+  if constexpr (ScalarUDFTraits<TUDF>::HasExecBatch()) {
+    return udf->ExecBatch(ctx, count, CastToUDFValueType<exec_argument_types[I]>(args[I])..., out);
+  } else {
+    for (size_t idx = 0; idx < count; ++idx) {
+      out[idx] = udf->Exec(ctx, CastToUDFValueType<exec_argument_types[I]>(args[I])[idx]...);
+    }
+    return Status::OK();
   }
-  return Status::OK();
 }
 
 template <typename TUDF, std::size_t... I>
@@ -90,20 +98,53 @@ inline auto UnWrap(const T& v) {
   return v.val;
 }
 
-template <>
-inline auto UnWrap<types::StringValue>(const types::StringValue& s) {
-  return s;
-}
+inline const types::StringValue& UnWrap(const types::StringValue& s) { return s; }
 
 /**
  * This is the inner wrapper for the arrow type.
  * This performs type casting and storing the data in the output builder.
  */
+template <typename TUDF, typename TOutput, std::size_t... I>
+Status ExecBatchWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
+                             const std::vector<arrow::Array*>& args, std::index_sequence<I...>) {
+  [[maybe_unused]] static constexpr auto exec_argument_types =
+      ScalarUDFTraits<TUDF>::ExecArguments();
+  using return_type =
+      typename types::DataTypeTraits<ScalarUDFTraits<TUDF>::ReturnType()>::value_type;
+  std::tuple<std::vector<typename types::DataTypeTraits<exec_argument_types[I]>::value_type>...>
+      inputs;
+  (std::get<I>(inputs).reserve(count), ...);
+  for (size_t idx = 0; idx < count; ++idx) {
+    (std::get<I>(inputs).emplace_back(
+         types::GetValueFromArrowArray<exec_argument_types[I]>(args[I], idx)),
+     ...);
+  }
+  std::vector<return_type> outputs(count);
+  PL_RETURN_IF_ERROR(udf->ExecBatch(ctx, count, std::get<I>(inputs).data()..., outputs.data()));
+
+  PL_RETURN_IF_ERROR(out->Reserve(count));
+  // PL_CARNOT_UPDATE_FOR_NEW_TYPES.
+  if constexpr (std::is_same_v<arrow::StringBuilder, TOutput>) {
+    size_t total_size = 0;
+    for (const auto& res : outputs) {
+      total_size += res.size();
+    }
+    PL_RETURN_IF_ERROR(out->ReserveData(total_size));
+  }
+  for (const auto& res : outputs) {
+    out->UnsafeAppend(UnWrap(res));
+  }
+  return Status::OK();
+}
+
 template <typename TUDF, typename TOutput, std::size_t... I>
 Status ExecWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput* out,
-                        const std::vector<arrow::Array*>& args, std::index_sequence<I...>) {
+                        const std::vector<arrow::Array*>& args, std::index_sequence<I...> seq) {
   [[maybe_unused]] static constexpr auto exec_argument_types =
       ScalarUDFTraits<TUDF>::ExecArguments();
+  if constexpr (ScalarUDFTraits<TUDF>::UseExecBatchOnArrow()) {
+    return ExecBatchWrapperArrow(udf, ctx, count, out, args, seq);
+  }
   CHECK(out->Reserve(count).ok());
   size_t reserved = count * kStringAssumedSizeHeuristic;
   size_t total_size = 0;
@@ -114,8 +155,9 @@ Status ExecWrapperArrow(TUDF* udf, FunctionContext* ctx, size_t count, TOutput*
     CHECK(out->ReserveData(reserved).ok());
   }
   for (size_t idx = 0; idx < count; ++idx) {
-    auto res = UnWrap(
-        udf->Exec(ctx, types::GetValueFromArrowArray<exec_argument_types[I]>(args[I], idx)...));
+    auto ret =
+        udf->Exec(ctx, types::GetValueFromArrowArray<exec_argument_types[I]>(args[I], idx)...);
+    const auto& res = UnWrap(ret);
 
     // We use doubling to make sure we minimize the number of allocations.
     // PL_CARNOT_UPDATE_FOR_NEW_TYPES.
@@ -435,6 +477,37 @@ struct UDAWrapper {
     *casted_output = casted_uda->Finalize(ctx);
     return Status::OK();
   }
+
+  /**
+   * Serialize the partial aggregate of the UDA, so that it can be merged elsewhere.
+   * @return Status of the serialize. Errors if the UDA doesn't support partial aggregates.
+   */
+  static Status Serialize(UDA* uda, FunctionContext* ctx, types::StringValue* output) {
+    DCHECK(output != nullptr);
+    if constexpr (SupportsPartial) {
+      *output = static_cast<TUDA*>(uda)->Serialize(ctx);
+      return Status::OK();
+    } else {
+      PL_UNUSED(uda);
+      PL_UNUSED(ctx);
+      return error::Unimplemented("UDA doesn't support partial aggregates");
+    }
+  }
+
+  /**
+   * Restores the UDA from a partial aggregate created by Serialize.
+   * @return Status of the deserialize.
+   */
+  static Status Deserialize(UDA* uda, FunctionContext* ctx, const types::StringValue& data) {
+    if constexpr (SupportsPartial) {
+      return static_cast<TUDA*>(uda)->Deserialize(ctx, data);
+    } else {
+      PL_UNUSED(uda);
+      PL_UNUSED(ctx);
+      PL_UNUSED(data);
+      return error::Unimplemented("UDA doesn't support partial aggregates");
+    }
+  }
 };
 
 /**
@@ -467,8 +540,14 @@ struct UDTFWrapper {
     return Status::OK();
   }
 
+  /**
+   * Generates the next batch of records into outputs. The batch ends after max_gen_records
+   * records, or after the first record that takes the batch to max_gen_bytes.
+   * @return true if the UDTF has more records.
+   */
   static bool ExecBatchUpdate(AnyUDTF* udtf, FunctionContext* ctx, int max_gen_records,
-                              std::vector<arrow::ArrayBuilder*>* outputs) {
+                              std::vector<arrow::ArrayBuilder*>* outputs,
+                              int64_t max_gen_bytes = std::numeric_limits<int64_t>::max()) {
     if (max_gen_records == 0) {
       return false;
     }
@@ -482,7 +561,7 @@ struct UDTFWrapper {
     int count = 0;
     bool more = true;
     RecordWriterProxy<TUDTF> rw(outputs);
-    while (count < max_gen_records && more) {
+    while (count < max_gen_records && rw.bytes_appended() < max_gen_bytes && more) {
       more = u->NextRecord(ctx, &rw);
       ++count;
     }
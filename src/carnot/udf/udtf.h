@@ -408,6 +408,11 @@ class RecordWriterProxy final {
         val);
   }
 
+  /**
+   * The number of bytes of values appended so far, including the data of strings.
+   */
+  int64_t bytes_appended() const { return bytes_appended_; }
+
   // Compile time function to get the index for a column with the specified name.
   static constexpr size_t ColIdx(std::string_view col_name) {
     constexpr auto col_names = UDTFTraits<TUDTF>::OutputRelationNames();
@@ -433,8 +438,10 @@ class RecordWriterProxy final {
       [[maybe_unused]] bool res = builder->ReserveData(v.size()).ok();
       DCHECK(res);
       builder->UnsafeAppend(v);
+      bytes_appended_ += v.size();
     } else {
       builder->UnsafeAppend(v.val);
+      bytes_appended_ += sizeof(v.val);
     }
   }
   // Returns true if all cols have the same length.
@@ -456,6 +463,7 @@ class RecordWriterProxy final {
   }
 
   std::vector<arrow::ArrayBuilder*>* outputs_;
+  int64_t bytes_appended_ = 0;
 };
 
 template <typename T>
@@ -184,6 +184,33 @@ TEST(BasicUDTFOneCol, can_run) {
   EXPECT_EQ(out->GetString(1), "abc 2");
 }
 
+TEST(BasicUDTFOneCol, batch_bytes_limit) {
+  UDTFWrapper<BasicUDTFOneCol> wrapper;
+  types::Int64Value init1 = 1337;
+  types::StringValue init2 = "abc";
+
+  auto u = wrapper.Make();
+  ASSERT_NE(u, nullptr);
+  EXPECT_OK(wrapper.Init(u.get(), nullptr, {&init1, &init2}));
+
+  // Each batch ends after the first record that reaches the byte limit.
+  for (const auto& expected : {"abc 1", "abc 2"}) {
+    arrow::StringBuilder string_builder(0);
+    std::vector<arrow::ArrayBuilder*> outs{&string_builder};
+    EXPECT_TRUE(wrapper.ExecBatchUpdate(u.get(), nullptr, 100, &outs, /*max_gen_bytes*/ 1));
+
+    std::shared_ptr<arrow::StringArray> out;
+    EXPECT_TRUE(string_builder.Finish(&out).ok());
+    ASSERT_EQ(out->length(), 1);
+    EXPECT_EQ(out->GetString(0), expected);
+  }
+
+  arrow::StringBuilder string_builder(0);
+  std::vector<arrow::ArrayBuilder*> outs{&string_builder};
+  EXPECT_FALSE(wrapper.ExecBatchUpdate(u.get(), nullptr, 100, &outs, /*max_gen_bytes*/ 1));
+  EXPECT_EQ(string_builder.length(), 0);
+}
+
 class BasicUDTFTwoColBad : public UDTF<BasicUDTFTwoColBad> {
  public:
   static constexpr auto Executor() { return udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/base/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace px {
+
+// The state of one ParallelFor call. Pool threads that only get to the call's task after the
+// call has returned find it closed and leave it alone, so the call doesn't have to wait for them.
+struct ThreadPool::Job {
+  const ShardFunc* fn;
+  int64_t num_shards;
+  std::atomic<int64_t> next_shard = 0;
+
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  bool closed = false;
+  int active_workers = 0;
+};
+
+ThreadPool::ThreadPool(int num_threads) {
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&ThreadPool::ThreadLoop, this);
+  }
+}
+
+ThreadPool* ThreadPool::Shared() {
+  static ThreadPool* pool =
+      new ThreadPool(std::max<int>(1, std::thread::hardware_concurrency()) - 1);
+  return pool;
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::ParallelFor(int64_t num_shards, int max_workers, const ShardFunc& fn) {
+  if (num_shards <= 0) {
+    return;
+  }
+  int64_t num_helpers =
+      std::min<int64_t>({num_shards - 1, max_workers - 1, static_cast<int64_t>(threads_.size())});
+  // Not worth waking up the pool threads.
+  if (num_helpers <= 0) {
+    for (int64_t i = 0; i < num_shards; ++i) {
+      fn(i, 0);
+    }
+    return;
+  }
+
+  auto job = std::make_shared<Job>();
+  job->fn = &fn;
+  job->num_shards = num_shards;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int worker_idx = 1; worker_idx <= num_helpers; ++worker_idx) {
+      tasks_.emplace_back([job, worker_idx]() {
+        {
+          std::lock_guard<std::mutex> job_lock(job->mutex);
+          if (job->closed) {
+            return;
+          }
+          ++job->active_workers;
+        }
+        RunShards(job.get(), worker_idx);
+        std::lock_guard<std::mutex> job_lock(job->mutex);
+        if (--job->active_workers == 0) {
+          job->done_cv.notify_one();
+        }
+      });
+    }
+  }
+  if (num_helpers == 1) {
+    work_cv_.notify_one();
+  } else {
+    work_cv_.notify_all();
+  }
+
+  RunShards(job.get(), 0);
+
+  // Every shard has been handed out, so only the workers that are still running one matter.
+  std::unique_lock<std::mutex> job_lock(job->mutex);
+  job->closed = true;
+  job->done_cv.wait(job_lock, [&job] { return job->active_workers == 0; });
+}
+
+void ThreadPool::ThreadLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [this] { return shutdown_ || !tasks_.empty(); });
+      if (shutdown_) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+void ThreadPool::RunShards(Job* job, int worker_idx) {
+  while (true) {
+    int64_t shard_idx = job->next_shard.fetch_add(1);
+    if (shard_idx >= job->num_shards) {
+      return;
+    }
+    (*job->fn)(shard_idx, worker_idx);
+  }
+}
+
+}  // namespace px
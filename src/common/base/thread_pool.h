@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "src/common/base/mixins.h"
+
+namespace px {
+
+/**
+ * ThreadPool runs shards of work on a fixed set of threads that live across calls, so that
+ * repeated parallel work doesn't pay for thread creation. It is meant to be shared: any number
+ * of threads may call ParallelFor concurrently, and each call runs on the calling thread plus
+ * whichever pool threads are free.
+ *
+ * Shards are handed out from a counter per call, so workers that finish early pick up the
+ * remaining shards. A call never waits for pool threads to become free: the calling thread runs
+ * every shard that no pool thread has picked up.
+ */
+class ThreadPool : public NotCopyable {
+ public:
+  using ShardFunc = std::function<void(int64_t shard_idx, int worker_idx)>;
+
+  /**
+   * @param num_threads The number of pool threads, not counting the callers. 0 runs everything
+   * on the calling threads.
+   */
+  explicit ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  /**
+   * The pool that the whole process shares, with one thread fewer than the number of cores. Every
+   * component runs its parallel work here, capped by its own max_workers, so that together they
+   * don't oversubscribe the node. Created on first use and never destroyed.
+   */
+  static ThreadPool* Shared();
+
+  int num_threads() const { return static_cast<int>(threads_.size()); }
+
+  /**
+   * Runs fn once for every shard index in [0, num_shards), on the calling thread and up to
+   * max_workers - 1 pool threads. worker_idx is in [0, max_workers) and is unique among the
+   * concurrently running invocations of this call, so callers can use it to index per-worker
+   * state without locking. The calling thread is worker 0. Blocks until all shards are complete.
+   */
+  void ParallelFor(int64_t num_shards, int max_workers, const ShardFunc& fn);
+
+ private:
+  struct Job;
+
+  void ThreadLoop();
+  static void RunShards(Job* job, int worker_idx);
+
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  bool shutdown_ = false;
+  std::deque<std::function<void()>> tasks_;
+};
+
+}  // namespace px
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/base/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace px {
+
+TEST(ThreadPoolTest, RunsEveryShardOnce) {
+  ThreadPool pool(3);
+  std::vector<std::atomic<int>> counts(1000);
+  std::atomic<int> max_worker_idx = 0;
+  pool.ParallelFor(counts.size(), 4, [&](int64_t shard_idx, int worker_idx) {
+    counts[shard_idx]++;
+    int prev = max_worker_idx;
+    while (worker_idx > prev && !max_worker_idx.compare_exchange_weak(prev, worker_idx)) {
+    }
+  });
+  for (const auto& count : counts) {
+    EXPECT_EQ(1, count.load());
+  }
+  EXPECT_LT(max_worker_idx.load(), 4);
+
+  // Fewer workers than pool threads.
+  std::atomic<int> total = 0;
+  pool.ParallelFor(100, 2, [&](int64_t, int worker_idx) {
+    EXPECT_LT(worker_idx, 2);
+    total++;
+  });
+  EXPECT_EQ(100, total.load());
+}
+
+TEST(ThreadPoolTest, NoThreadsRunsInline) {
+  ThreadPool pool(0);
+  std::vector<int64_t> order;
+  pool.ParallelFor(5, 4, [&](int64_t shard_idx, int worker_idx) {
+    EXPECT_EQ(0, worker_idx);
+    order.push_back(shard_idx);
+  });
+  EXPECT_EQ(std::vector<int64_t>({0, 1, 2, 3, 4}), order);
+}
+
+TEST(ThreadPoolTest, ConcurrentCallers) {
+  ThreadPool pool(2);
+  std::atomic<int64_t> total = 0;
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i) {
+    callers.emplace_back([&]() {
+      for (int j = 0; j < 100; ++j) {
+        pool.ParallelFor(10, 3, [&](int64_t shard_idx, int) { total += shard_idx; });
+      }
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+  EXPECT_EQ(4 * 100 * 45, total.load());
+}
+
+// A caller isn't held up by pool threads that are busy with another call.
+TEST(ThreadPoolTest, DoesNotWaitForBusyThreads) {
+  ThreadPool pool(1);
+  std::atomic<bool> release = false;
+  std::atomic<bool> blocked = false;
+  std::thread blocker([&]() {
+    // Worker 0 waits for the pool thread to pick up the other shard, which it holds on to.
+    pool.ParallelFor(2, 2, [&](int64_t, int worker_idx) {
+      if (worker_idx == 1) {
+        blocked = true;
+      }
+      while (!(worker_idx == 1 ? release.load() : blocked.load())) {
+        std::this_thread::yield();
+      }
+    });
+  });
+  while (!blocked) {
+    std::this_thread::yield();
+  }
+
+  int total = 0;
+  pool.ParallelFor(10, 2, [&](int64_t, int worker_idx) {
+    EXPECT_EQ(0, worker_idx);
+    ++total;
+  });
+  EXPECT_EQ(10, total);
+
+  release = true;
+  blocker.join();
+}
+
+}  // namespace px
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 
@@ -37,6 +38,21 @@ using PostCB = std::function<void()>;
 using PoolExecFunc = std::function<void()>;
 using PoolExecCompletionCB = std::function<void()>;
 
+/**
+ * How responsive the event loop of a dispatcher has been.
+ */
+struct DispatcherStats {
+  // The number of posted functors that have run.
+  int64_t num_posts = 0;
+  // How long the posted functors waited before they ran, in total and at most.
+  std::chrono::nanoseconds total_post_lag{0};
+  std::chrono::nanoseconds max_post_lag{0};
+  // The number of posted functors that held up the event loop for longer than kSlowPostThreshold.
+  int64_t num_slow_posts = 0;
+
+  static constexpr std::chrono::milliseconds kSlowPostThreshold{500};
+};
+
 /**
  * Dispatcher is the high level class for manging event dispatching (time sources, fs reads, etc.).
  */
@@ -73,6 +89,11 @@ class Dispatcher {
    */
   virtual void Post(PostCB callback) = 0;
 
+  /**
+   * Returns the lag of the functors posted to the dispatcher so far. This is safe cross thread.
+   */
+  virtual DispatcherStats GetStats() const = 0;
+
   /**
    * Will delete the passed in pointer in a future event loop.
    * This allows us to delete unique_ptr, with a clear ownership model.
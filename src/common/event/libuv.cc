@@ -20,17 +20,39 @@
 
 #include <uv.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "src/common/base/base.h"
 #include "src/common/event/api.h"
 
+DEFINE_int32(event_worker_pool_size, gflags::Int32FromEnv("PL_EVENT_WORKER_POOL_SIZE", 0),
+             "The number of threads that run the async tasks of all dispatchers, such as queries. "
+             "0 uses the number of cores, and at least libuv's default of 4. Ignored when "
+             "UV_THREADPOOL_SIZE is set.");
+
 namespace px {
 namespace event {
 
 namespace {
+
+// libuv sizes its worker pool from UV_THREADPOOL_SIZE the first time work is queued, and keeps
+// the default of 4 threads otherwise. That is fewer than the number of queries an agent runs at
+// once, so queries beyond the fourth would wait for a thread while holding a query slot.
+void SizeWorkerPool() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    int size = FLAGS_event_worker_pool_size;
+    if (size <= 0) {
+      size = std::max(4, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    setenv("UV_THREADPOOL_SIZE", std::to_string(size).c_str(), /*overwrite*/ 0);
+  });
+}
 /**
  * LibuvRunnableAsyncTask is a wrapper that contains Libuv specific run loop.
  */
@@ -128,6 +150,7 @@ void LibuvScheduler::Run(Dispatcher::RunType type) {
 }
 
 LibuvScheduler::LibuvScheduler(std::string_view name) : name_(std::string(name)) {
+  SizeWorkerPool();
   int rc = uv_loop_init(&uv_loop_);
   CHECK(rc == 0) << "Failed to init Libuv loop";
   stop_handler_.data = this;
@@ -181,10 +204,11 @@ void LibuvDispatcher::Exit() { base_scheduler_.LoopExit(); }
 
 void LibuvDispatcher::Post(PostCB cb) {
   bool activate = false;
+  MonotonicTimePoint post_time = api_.TimeSourceRef().MonotonicTime();
   {
     absl::MutexLock lock(&post_lock_);
     activate = post_callbacks_.empty();
-    post_callbacks_.emplace_back(cb);
+    post_callbacks_.push_back({std::move(cb), post_time});
   }
 
   if (activate) {
@@ -244,18 +268,40 @@ TimerUPtr LibuvDispatcher::CreateTimer(TimerCB cb) {
 void LibuvDispatcher::RunPostCallbacks() {
   while (true) {
     PostCB cb;
+    MonotonicTimePoint post_time;
     {
       absl::MutexLock lock(&post_lock_);
       if (post_callbacks_.empty()) {
         return;
       }
-      cb = post_callbacks_.front();
+      cb = std::move(post_callbacks_.front().cb);
+      post_time = post_callbacks_.front().post_time;
       post_callbacks_.pop_front();
     }
+    MonotonicTimePoint start_time = api_.TimeSourceRef().MonotonicTime();
     cb();
+    std::chrono::nanoseconds run_time = api_.TimeSourceRef().MonotonicTime() - start_time;
+
+    // Slow callbacks delay everything else on the loop, such as heartbeats and query dispatch.
+    if (run_time > DispatcherStats::kSlowPostThreshold) {
+      LOG(WARNING) << LogEntry(absl::Substitute(
+          "Posted callback held up the event loop for $0 ms",
+          std::chrono::duration_cast<std::chrono::milliseconds>(run_time).count()));
+    }
+    std::chrono::nanoseconds lag = start_time - post_time;
+    absl::MutexLock lock(&stats_lock_);
+    ++stats_.num_posts;
+    stats_.total_post_lag += lag;
+    stats_.max_post_lag = std::max(stats_.max_post_lag, lag);
+    stats_.num_slow_posts += run_time > DispatcherStats::kSlowPostThreshold;
   }
 }
 
+DispatcherStats LibuvDispatcher::GetStats() const {
+  absl::MutexLock lock(&stats_lock_);
+  return stats_;
+}
+
 void LibuvDispatcher::Stop() {
   uv_close(reinterpret_cast<uv_handle_t*>(&post_async_handler_), nullptr);
   base_scheduler_.Stop();
@@ -32,9 +32,12 @@
 #include <absl/base/attributes.h>
 #include <absl/base/thread_annotations.h>
 #include <absl/synchronization/mutex.h>
+#include "src/common/base/base.h"
 #include "src/common/event/dispatcher.h"
 #include "src/common/event/event.h"
 
+DECLARE_int32(event_worker_pool_size);
+
 namespace px {
 namespace event {
 
@@ -87,6 +90,7 @@ class LibuvDispatcher : public Dispatcher {
   void Stop() override;
   void Exit() override;
   void Post(PostCB callback) override;
+  DispatcherStats GetStats() const override;
   void DeferredDelete(DeferredDeletableUPtr&& to_delete) override;
   void Run(RunType type) override;
   RunnableAsyncTaskUPtr CreateAsyncTask(std::unique_ptr<AsyncTask> task) override;
@@ -108,10 +112,18 @@ class LibuvDispatcher : public Dispatcher {
   const std::string name_;
   std::thread::id run_tid_;
 
+  struct PostedCallback {
+    PostCB cb;
+    MonotonicTimePoint post_time;
+  };
+
   absl::Mutex post_lock_;
-  std::list<PostCB> post_callbacks_ ABSL_GUARDED_BY(post_lock_);
+  std::list<PostedCallback> post_callbacks_ ABSL_GUARDED_BY(post_lock_);
   uv_async_t post_async_handler_;
 
+  mutable absl::Mutex stats_lock_;
+  DispatcherStats stats_ ABSL_GUARDED_BY(stats_lock_);
+
   const API& api_;
   LibuvScheduler base_scheduler_;
   SchedulerUPtr scheduler_;
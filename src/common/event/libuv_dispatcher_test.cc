@@ -150,5 +150,26 @@ TEST_F(LibuvDispatcherTest, threadpool) {
   dispatcher_->Exit();
 }
 
+TEST_F(LibuvDispatcherTest, post_stats) {
+  EXPECT_EQ(0, dispatcher_->GetStats().num_posts);
+
+  int call_count = 0;
+  std::thread poster([&]() {
+    for (int i = 0; i < 3; ++i) {
+      dispatcher_->Post([&]() { ++call_count; });
+    }
+  });
+  poster.join();
+  dispatcher_->Run(Dispatcher::RunType::NonBlock);
+
+  EXPECT_EQ(3, call_count);
+  DispatcherStats stats = dispatcher_->GetStats();
+  EXPECT_EQ(3, stats.num_posts);
+  EXPECT_GE(stats.total_post_lag, stats.max_post_lag);
+  EXPECT_EQ(0, stats.num_slow_posts);
+
+  dispatcher_->Exit();
+}
+
 }  // namespace event
 }  // namespace px
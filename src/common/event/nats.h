@@ -92,8 +92,9 @@ class NATSConnector : public NATSConnectorBase {
 
   /**
    * Handle incoming message from NATS. This function is used by the C callback function. It can
-   * also be used by Fakes/tests to inject new messages.
-   * @param msg The natsMessage.
+   * also be used by Fakes/tests to inject new messages. The parsed message is moved into the
+   * handler without a copy, so the handler may hand it off to another thread.
+   * @param msg The natsMessage. It is not destroyed by this function.
    */
   void NATSMessageHandler(natsConnection* /*nc*/, natsSubscription* /*sub*/, natsMsg* msg) {
     int len = natsMsg_GetDataLength(msg);
@@ -122,9 +123,19 @@ class NATSConnector : public NATSConnectorBase {
     if (!nats_connection_) {
       return error::ResourceUnavailable("Not connected to NATS");
     }
-    auto serialized_msg = msg.SerializeAsString();
-    auto nats_status = natsConnection_Publish(nats_connection_, pub_topic_.c_str(),
-                                              serialized_msg.c_str(), serialized_msg.size());
+    // NATS copies the data into its own outgoing buffer, so most messages are serialized on the
+    // stack. Only the larger ones need a heap buffer.
+    size_t size = msg.ByteSizeLong();
+    char inline_buf[kInlinePublishBufSize];
+    std::unique_ptr<char[]> heap_buf;
+    char* data = inline_buf;
+    if (size > kInlinePublishBufSize) {
+      heap_buf = std::make_unique<char[]>(size);
+      data = heap_buf.get();
+    }
+    msg.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(data));
+    auto nats_status =
+        natsConnection_Publish(nats_connection_, pub_topic_.c_str(), data, static_cast<int>(size));
     if (nats_status != NATS_OK) {
       nats_PrintLastErrorStack(stderr);
       return error::Unknown("Failed to publish to NATS, nats_status=$0", nats_status);
@@ -145,11 +156,16 @@ class NATSConnector : public NATSConnectorBase {
   void RemoveMessageHandler() { msg_handler_ = nullptr; }
 
  protected:
+  // Messages up to this size are serialized into a stack buffer by Publish.
+  static constexpr size_t kInlinePublishBufSize = 4096;
+
   static void NATSMessageCallbackHandler(natsConnection* nc, natsSubscription* sub, natsMsg* msg,
                                          void* closure) {
     // We know that closure is of type NATSConnector.
     auto* connector = static_cast<NATSConnector<TMsg>*>(closure);
     connector->NATSMessageHandler(nc, sub, msg);
+    // The callback owns the message. Its data has been parsed into the protobuf by now.
+    natsMsg_Destroy(msg);
   }
 
   natsSubscription* nats_subscription_ = nullptr;
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/grpcutils/message_text.h"
+
+#include <algorithm>
+#include <memory>
+
+#include <absl/strings/ascii.h>
+#include <google/protobuf/empty.pb.h>
+#include <google/protobuf/text_format.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace grpc {
+
+using ::google::protobuf::Empty;
+using ::google::protobuf::Message;
+using ::google::protobuf::TextFormat;
+
+namespace {
+
+// Text format protobuf are not valid JSON. One obvious issue is that TextFormat uses unquoted
+// field numbers as key: {1: "some string"}, which is not allowed in JSON.
+Status PBWireToText(std::string_view message, Message* pb, TextFormat::Printer* pb_printer,
+                    std::string* text) {
+  pb->Clear();
+  const bool parse_succeeded = pb->ParsePartialFromArray(message.data(), message.size());
+  // Proceed to print text format protobuf even if the parse failed. This allows producing partial
+  // message.
+  const bool print_succeeded = pb_printer->PrintToString(*pb, text);
+  if (!parse_succeeded) {
+    return error::InvalidArgument("Failed to parse the serialized protobuf message");
+  }
+  if (!print_succeeded) {
+    return error::InvalidArgument("Failed to print protobuf message to text format");
+  }
+  return Status::OK();
+}
+
+// Parses the gRPC payload into text format protobuf. In addition to parsing protobuf messages, this
+// function extracts compression and length field, and also handles multiple concatenated payloads
+// as well.
+Status GRPCPBWireToText(std::string_view message, Message* pb, std::string* text,
+                        std::optional<int> str_truncation_len) {
+  if (message.size() < kGRPCMessageHeaderSizeInBytes) {
+    return error::InvalidArgument(
+        "The gRPC message does not have enough data. "
+        "Might be resulted from early termination of invalid RPC calls. "
+        "E.g.: calling unimplemented method");
+  }
+
+  TextFormat::Printer pb_printer;
+  pb_printer.SetTruncateStringFieldLongerThan(str_truncation_len.value_or(0));
+
+  Status status;
+
+  while (!message.empty()) {
+    if (message.size() < kGRPCMessageHeaderSizeInBytes) {
+      return error::ResourceUnavailable("Not enough bytes for the gRPC message header.");
+    }
+    const uint8_t compressed_flag = static_cast<uint8_t>(message[0]);
+    if (compressed_flag == 1) {
+      return error::Unimplemented("Compressed data is not implemented");
+    }
+    // The length is big-endian.
+    uint32_t len = 0;
+    for (size_t i = 1; i < kGRPCMessageHeaderSizeInBytes; ++i) {
+      len = (len << 8) | static_cast<uint8_t>(message[i]);
+    }
+    message.remove_prefix(kGRPCMessageHeaderSizeInBytes);
+    // Only extract remaining data if the data is truncated.
+    std::string_view data = message.substr(0, std::min(static_cast<size_t>(len), message.size()));
+    message.remove_prefix(data.size());
+
+    std::string pb_str;
+    // Include the most recent status.
+    status = PBWireToText(data, pb, &pb_printer, &pb_str);
+
+    text->append(pb_str);
+  }
+  return status;
+}
+
+}  // namespace
+
+std::string GRPCBodyToText(std::string_view body, const Message* prototype,
+                           std::optional<int> str_truncation_len) {
+  std::unique_ptr<Message> pb =
+      prototype != nullptr ? std::unique_ptr<Message>(prototype->New()) : std::make_unique<Empty>();
+  std::string text;
+  Status s = GRPCPBWireToText(body, pb.get(), &text, str_truncation_len);
+  absl::StripTrailingAsciiWhitespace(&text);
+  if (!s.ok() && text.empty()) {
+    return "<Failed to parse protobuf>";
+  }
+  return text;
+}
+
+}  // namespace grpc
+}  // namespace px
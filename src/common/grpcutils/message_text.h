@@ -0,0 +1,47 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <google/protobuf/message.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace px {
+namespace grpc {
+
+constexpr size_t kGRPCMessageHeaderSizeInBytes = 5;
+
+/**
+ * @brief Parses the length-prefixed gRPC messages of a request or response body into text format
+ * protobuf. The messages may be truncated; the parsed prefix is still printed.
+ *
+ * @param body The raw body, one or more concatenated gRPC messages.
+ * @param prototype The message type to parse the messages as. If null, the messages are parsed
+ *        without a schema, and printed with field numbers instead of field names.
+ * @param str_truncation_len The string length of any string/bytes fields beyond which truncation
+ *        applies, if specified.
+ * @return The parsed messages, or "<Failed to parse protobuf>" if nothing could be parsed.
+ */
+std::string GRPCBodyToText(std::string_view body, const google::protobuf::Message* prototype,
+                           std::optional<int> str_truncation_len = std::nullopt);
+
+}  // namespace grpc
+}  // namespace px
@@ -17,8 +17,12 @@
  */
 
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
@@ -55,12 +59,45 @@ class ObjectPool final : public px::NotCopyable {
     return entity;
   }
 
+  /**
+   * Construct an entity in the pool's arena. Unlike Add, this doesn't need a heap allocation per
+   * entity. The entity is destroyed, and its memory given back, when the pool is cleared.
+   *
+   * @tparam T The entity type to construct.
+   * @param args The arguments to T's constructor.
+   * @return The pointer to the entity.
+   */
+  template <typename T, typename... Args>
+  T* Make(Args&&... args) {
+    void* mem;
+    {
+      absl::base_internal::SpinLockHolder lock(&lock_);
+      mem = ArenaAllocateUnlocked(sizeof(T), alignof(T));
+    }
+    T* entity = new (mem) T(std::forward<Args>(args)...);
+    absl::base_internal::SpinLockHolder lock(&lock_);
+    obj_list_.emplace_back(Entity{entity, [](void* obj) { reinterpret_cast<T*>(obj)->~T(); }});
+    return entity;
+  }
+
   void Clear() {
     absl::base_internal::SpinLockHolder lock(&lock_);
     for (auto& obj : obj_list_) {
       obj.delete_fn(obj.obj);
     }
     obj_list_.clear();
+    arena_blocks_.clear();
+    arena_ptr_ = nullptr;
+    arena_remaining_ = 0;
+    arena_bytes_ = 0;
+  }
+
+  /**
+   * @return the number of bytes of the blocks held by the pool's arena.
+   */
+  int64_t ArenaBytes() const {
+    absl::base_internal::SpinLockHolder lock(&lock_);
+    return arena_bytes_;
   }
 
  private:
@@ -73,9 +110,35 @@ class ObjectPool final : public px::NotCopyable {
     DeleteFn delete_fn;
   };
 
+  // The size of the blocks the arena carves entities out of. Larger entities get their own block.
+  static constexpr size_t kArenaBlockSize = 64 * 1024;
+
+  void* ArenaAllocateUnlocked(size_t size, size_t alignment) {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(arena_ptr_);
+    size_t padding = (alignment - addr % alignment) % alignment;
+    if (padding + size > arena_remaining_) {
+      // operator new[] memory is aligned for any fundamental type.
+      size_t block_size = std::max(kArenaBlockSize, size);
+      arena_blocks_.emplace_back(new char[block_size]);
+      arena_bytes_ += block_size;
+      arena_ptr_ = arena_blocks_.back().get();
+      arena_remaining_ = block_size;
+      padding = 0;
+    }
+    void* mem = arena_ptr_ + padding;
+    arena_ptr_ += padding + size;
+    arena_remaining_ -= padding + size;
+    return mem;
+  }
+
   const std::string name_;
-  absl::base_internal::SpinLock lock_;
+  mutable absl::base_internal::SpinLock lock_;
   std::vector<Entity> obj_list_;
+
+  std::vector<std::unique_ptr<char[]>> arena_blocks_;
+  char* arena_ptr_ = nullptr;
+  size_t arena_remaining_ = 0;
+  int64_t arena_bytes_ = 0;
 };
 
 }  // namespace px
@@ -19,6 +19,9 @@
 #include "src/common/memory/object_pool.h"
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <vector>
+
 namespace px {
 
 class TestObject {
@@ -79,4 +82,29 @@ TEST(object_pool_test, test_different_objects) {
   EXPECT_EQ(1, count2);
 }
 
+TEST(object_pool_test, test_make_in_arena) {
+  int count = 0;
+  {
+    ObjectPool pool;
+    std::vector<TestObject*> objs;
+    for (int i = 0; i < 10000; ++i) {
+      objs.push_back(pool.Make<TestObject>(&count));
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(objs.back()) % alignof(TestObject));
+    }
+    pool.Add(new TestObjectTwo(&count));
+    // The objects are packed into a few blocks, rather than being allocated one by one.
+    EXPECT_LT(0, pool.ArenaBytes());
+    EXPECT_GE(pool.ArenaBytes(), 10000 * sizeof(TestObject));
+    EXPECT_LT(pool.ArenaBytes(), 2 * 10000 * sizeof(TestObject) + 64 * 1024);
+    EXPECT_EQ(0, count);
+
+    pool.Clear();
+    EXPECT_EQ(10001, count);
+    EXPECT_EQ(0, pool.ArenaBytes());
+
+    pool.Make<TestObject>(&count);
+  }
+  EXPECT_EQ(10002, count);
+}
+
 }  // namespace px
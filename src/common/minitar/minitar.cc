@@ -28,7 +28,12 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <deque>
 #include <string>
+#include <thread>
+#include <utility>
+
+#include <absl/synchronization/mutex.h>
 
 #include "src/common/base/base.h"
 
@@ -53,25 +58,140 @@ Minitar::~Minitar() {
 }
 
 namespace {
-Status CopyData(struct archive* ar, struct archive* aw) {
-  int r;
-  const void* buff;
-  size_t size;
-  int64_t offset;
 
+// Read from the tarball in large blocks, to keep the number of reads down for large archives.
+constexpr size_t kReadBlockSize = 1 << 20;
+// The most bytes of decompressed data that are waiting to be written to disk at a time.
+constexpr size_t kMaxQueuedBytes = 64 << 20;
+
+// The header of the next entry, or a block of data of the current entry, read from the archive.
+struct ArchiveChunk {
+  // Only set for headers. Owned by the chunk.
+  struct archive_entry* entry = nullptr;
+  std::string data;
+  int64_t offset = 0;
+};
+
+// Hands the chunks read from the archive over to the thread writing them to disk. Holds at most
+// kMaxQueuedBytes, so memory stays bounded however large the archive is.
+class ChunkQueue {
+ public:
+  ~ChunkQueue() {
+    for (auto& chunk : chunks_) {
+      if (chunk.entry != nullptr) {
+        archive_entry_free(chunk.entry);
+      }
+    }
+  }
+
+  // Returns false, without queueing the chunk, if the writer stopped.
+  bool Push(ArchiveChunk chunk) {
+    absl::MutexLock lock(&mu_);
+    mu_.Await(absl::Condition(
+        +[](ChunkQueue* q) { return q->writer_done_ || q->queued_bytes_ < kMaxQueuedBytes; },
+        this));
+    if (writer_done_) {
+      if (chunk.entry != nullptr) {
+        archive_entry_free(chunk.entry);
+      }
+      return false;
+    }
+    queued_bytes_ += chunk.data.size();
+    chunks_.push_back(std::move(chunk));
+    return true;
+  }
+
+  // Returns false once the reader is done and every chunk has been popped.
+  bool Pop(ArchiveChunk* chunk) {
+    absl::MutexLock lock(&mu_);
+    mu_.Await(absl::Condition(
+        +[](ChunkQueue* q) { return q->reader_done_ || !q->chunks_.empty(); }, this));
+    if (chunks_.empty()) {
+      return false;
+    }
+    *chunk = std::move(chunks_.front());
+    chunks_.pop_front();
+    queued_bytes_ -= chunk->data.size();
+    return true;
+  }
+
+  void ReaderDone() {
+    absl::MutexLock lock(&mu_);
+    reader_done_ = true;
+  }
+
+  void WriterDone() {
+    absl::MutexLock lock(&mu_);
+    writer_done_ = true;
+  }
+
+ private:
+  absl::Mutex mu_;
+  std::deque<ArchiveChunk> chunks_ ABSL_GUARDED_BY(mu_);
+  size_t queued_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  bool reader_done_ ABSL_GUARDED_BY(mu_) = false;
+  bool writer_done_ ABSL_GUARDED_BY(mu_) = false;
+};
+
+Status WriteChunks(ChunkQueue* queue, struct archive* aw) {
+  ArchiveChunk chunk;
+  while (queue->Pop(&chunk)) {
+    int r;
+    if (chunk.entry != nullptr) {
+      r = archive_write_header(aw, chunk.entry);
+      archive_entry_free(chunk.entry);
+      chunk.entry = nullptr;
+    } else {
+      r = archive_write_data_block(aw, chunk.data.data(), chunk.data.size(), chunk.offset);
+    }
+    PL_RETURN_IF_NOT_ARCHIVE_OK(r, aw);
+  }
+  return Status::OK();
+}
+
+Status ReadChunks(struct archive* ar, std::string_view dest_dir, ChunkQueue* queue) {
+  int r;
   while (true) {
-    r = archive_read_data_block(ar, &buff, &size, &offset);
+    struct archive_entry* entry;
+    r = archive_read_next_header(ar, &entry);
     if (r == ARCHIVE_EOF) {
       break;
     }
     PL_RETURN_IF_NOT_ARCHIVE_OK(r, ar);
 
-    r = archive_write_data_block(aw, buff, size, offset);
-    PL_RETURN_IF_NOT_ARCHIVE_OK(r, ar);
-  }
+    if (!dest_dir.empty()) {
+      std::string dest_path = absl::StrCat(dest_dir, "/", archive_entry_pathname(entry));
+      archive_entry_set_pathname(entry, dest_path.c_str());
+    }
+
+    // The reader reuses its entry for the next header, so the writer gets a copy.
+    ArchiveChunk header;
+    header.entry = archive_entry_clone(entry);
+    if (!queue->Push(std::move(header))) {
+      return Status::OK();
+    }
 
+    while (true) {
+      const void* buff;
+      size_t size;
+      int64_t offset;
+      r = archive_read_data_block(ar, &buff, &size, &offset);
+      if (r == ARCHIVE_EOF) {
+        break;
+      }
+      PL_RETURN_IF_NOT_ARCHIVE_OK(r, ar);
+
+      ArchiveChunk block;
+      block.data.assign(static_cast<const char*>(buff), size);
+      block.offset = offset;
+      if (!queue->Push(std::move(block))) {
+        return Status::OK();
+      }
+    }
+  }
   return Status::OK();
 }
+
 }  // namespace
 
 Status Minitar::Extract(std::string_view dest_dir, int flags) {
@@ -86,28 +206,22 @@ Status Minitar::Extract(std::string_view dest_dir, int flags) {
   archive_read_support_filter_gzip(a);
   archive_read_support_format_tar(a);
 
-  r = archive_read_open_filename(a, file_.string().c_str(), 10240);
+  r = archive_read_open_filename(a, file_.string().c_str(), kReadBlockSize);
   PL_RETURN_IF_NOT_ARCHIVE_OK(r, a);
 
-  while (true) {
-    struct archive_entry* entry;
-    r = archive_read_next_header(a, &entry);
-    if (r == ARCHIVE_EOF) {
-      break;
-    }
-    PL_RETURN_IF_NOT_ARCHIVE_OK(r, a);
-
-    if (!dest_dir.empty()) {
-      std::string dest_path = absl::StrCat(dest_dir, "/", archive_entry_pathname(entry));
-      archive_entry_set_pathname(entry, dest_path.c_str());
-    }
-
-    r = archive_write_header(ext, entry);
-    PL_RETURN_IF_NOT_ARCHIVE_OK(r, a);
-    PL_RETURN_IF_ERROR(CopyData(a, ext));
-  }
-
-  return Status::OK();
+  // Decompression runs on this thread, while the files are written to disk on another one.
+  ChunkQueue queue;
+  Status write_status;
+  std::thread writer([&]() {
+    write_status = WriteChunks(&queue, ext);
+    queue.WriterDone();
+  });
+  Status read_status = ReadChunks(a, dest_dir, &queue);
+  queue.ReaderDone();
+  writer.join();
+
+  PL_RETURN_IF_ERROR(read_status);
+  return write_status;
 }
 
 }  // namespace tools
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/common/system/cpu_affinity.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <string>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+
+namespace px {
+namespace system {
+
+StatusOr<std::vector<int>> ParseCPUList(std::string_view cpu_list) {
+  std::vector<int> cpus;
+  for (std::string_view range :
+       absl::StrSplit(absl::StripAsciiWhitespace(cpu_list), ',', absl::SkipEmpty())) {
+    std::vector<std::string_view> bounds = absl::StrSplit(range, absl::MaxSplits('-', 1));
+    int first = 0;
+    int last = 0;
+    if (!absl::SimpleAtoi(bounds[0], &first) ||
+        !absl::SimpleAtoi(bounds.size() == 2 ? bounds[1] : bounds[0], &last) || first < 0 ||
+        last < first || last >= CPU_SETSIZE) {
+      return error::InvalidArgument("Invalid CPU range '$0' in CPU list '$1'.", range, cpu_list);
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+StatusOr<std::map<int, std::vector<int>>> NUMANodeCPUs(const std::filesystem::path& sysfs_path) {
+  std::map<int, std::vector<int>> node_cpus;
+  const std::filesystem::path node_dir = sysfs_path / "devices/system/node";
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(node_dir, ec)) {
+    std::string filename = entry.path().filename().string();
+    std::string_view name = filename;
+    int node = 0;
+    if (!absl::ConsumePrefix(&name, "node") || !absl::SimpleAtoi(name, &node)) {
+      continue;
+    }
+    PL_ASSIGN_OR_RETURN(std::string cpu_list, ReadFileToString(entry.path() / "cpulist"));
+    PL_ASSIGN_OR_RETURN(std::vector<int> cpus, ParseCPUList(cpu_list));
+    // Nodes with memory only have no CPUs.
+    if (!cpus.empty()) {
+      node_cpus[node] = std::move(cpus);
+    }
+  }
+  if (node_cpus.empty()) {
+    PL_ASSIGN_OR_RETURN(node_cpus[0], CurrentThreadAffinity());
+  }
+  return node_cpus;
+}
+
+StatusOr<std::vector<int>> CurrentThreadAffinity() {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  int rc = pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (rc != 0) {
+    return error::Internal("Failed to get the CPU affinity of the thread [errno=$0].", rc);
+  }
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpu_set)) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+Status SetCurrentThreadAffinity(const std::vector<int>& cpus) {
+  if (cpus.empty()) {
+    return error::InvalidArgument("Can't restrict a thread to no CPUs.");
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      return error::InvalidArgument("Invalid CPU $0.", cpu);
+    }
+    CPU_SET(cpu, &cpu_set);
+  }
+  int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (rc != 0) {
+    return error::Internal("Failed to set the CPU affinity of the thread [errno=$0].", rc);
+  }
+  return Status::OK();
+}
+
+}  // namespace system
+}  // namespace px
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace system {
+
+/**
+ * Parses a Linux CPU list, such as "0-3,8,10-11" from a cpulist file or the --*_cpus flags.
+ * @return The CPUs in increasing order, without duplicates.
+ */
+StatusOr<std::vector<int>> ParseCPUList(std::string_view cpu_list);
+
+/**
+ * Returns the CPUs of each NUMA node, from <sysfs_path>/devices/system/node/node<N>/cpulist.
+ * Hosts without NUMA support have a single node 0 with all CPUs.
+ */
+StatusOr<std::map<int, std::vector<int>>> NUMANodeCPUs(const std::filesystem::path& sysfs_path);
+
+/**
+ * Returns the CPUs that the calling thread may run on.
+ */
+StatusOr<std::vector<int>> CurrentThreadAffinity();
+
+/**
+ * Restricts the calling thread to the CPUs. Threads that it creates later inherit the affinity.
+ */
+Status SetCurrentThreadAffinity(const std::vector<int>& cpus);
+
+}  // namespace system
+}  // namespace px
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/common/system/cpu_affinity.h"
+
+#include <fstream>
+
+#include "src/common/testing/temp_dir.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace system {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+TEST(ParseCPUListTest, Ranges) {
+  ASSERT_OK_AND_THAT(ParseCPUList("0-3,8,10-11\n"), ElementsAre(0, 1, 2, 3, 8, 10, 11));
+  ASSERT_OK_AND_THAT(ParseCPUList("5,1-2,2"), ElementsAre(1, 2, 5));
+  ASSERT_OK_AND_THAT(ParseCPUList(""), IsEmpty());
+}
+
+TEST(ParseCPUListTest, Invalid) {
+  EXPECT_NOT_OK(ParseCPUList("a"));
+  EXPECT_NOT_OK(ParseCPUList("3-1"));
+  EXPECT_NOT_OK(ParseCPUList("1-"));
+  EXPECT_NOT_OK(ParseCPUList("-1"));
+}
+
+TEST(NUMANodeCPUsTest, TwoNodes) {
+  testing::TempDir sysfs;
+  const std::filesystem::path node_dir = sysfs.path() / "devices/system/node";
+  // node2 has memory only.
+  for (auto [node, cpu_list] : {std::pair{"node0", "0-1,4-5\n"}, std::pair{"node1", "2-3,6-7\n"},
+                                std::pair{"node2", "\n"}}) {
+    std::filesystem::create_directories(node_dir / node);
+    std::ofstream(node_dir / node / "cpulist") << cpu_list;
+  }
+  std::filesystem::create_directories(node_dir / "power");
+
+  ASSERT_OK_AND_THAT(NUMANodeCPUs(sysfs.path()), ElementsAre(Pair(0, ElementsAre(0, 1, 4, 5)),
+                                                            Pair(1, ElementsAre(2, 3, 6, 7))));
+}
+
+TEST(NUMANodeCPUsTest, NoNUMASupport) {
+  testing::TempDir sysfs;
+  ASSERT_OK_AND_ASSIGN(auto node_cpus, NUMANodeCPUs(sysfs.path()));
+  ASSERT_OK_AND_ASSIGN(std::vector<int> cpus, CurrentThreadAffinity());
+  EXPECT_THAT(node_cpus, ElementsAre(Pair(0, cpus)));
+}
+
+TEST(CPUAffinityTest, SetCurrentThreadAffinity) {
+  ASSERT_OK_AND_ASSIGN(std::vector<int> cpus, CurrentThreadAffinity());
+  ASSERT_FALSE(cpus.empty());
+
+  ASSERT_OK(SetCurrentThreadAffinity({cpus.front()}));
+  ASSERT_OK_AND_THAT(CurrentThreadAffinity(), ElementsAre(cpus.front()));
+  ASSERT_OK(SetCurrentThreadAffinity(cpus));
+
+  EXPECT_NOT_OK(SetCurrentThreadAffinity({}));
+}
+
+}  // namespace system
+}  // namespace px
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/system/proc_events.h"
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace px {
+namespace system {
+
+Status ProcEventListener::Connect() {
+  fd_ = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+  if (fd_ < 0) {
+    return error::Internal("Could not create NETLINK_CONNECTOR connection. [errno=$0]", errno);
+  }
+
+  struct sockaddr_nl addr = {};
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = CN_IDX_PROC;
+  if (bind(fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+    return error::Internal("Could not bind to the proc connector. [errno=$0]", errno);
+  }
+  return Status::OK();
+}
+
+Status ProcEventListener::Subscribe() {
+  static constexpr size_t kPayloadSize = sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op);
+  alignas(struct nlmsghdr) uint8_t buf[NLMSG_SPACE(kPayloadSize)] = {};
+
+  auto* msg_header = reinterpret_cast<struct nlmsghdr*>(buf);
+  msg_header->nlmsg_len = NLMSG_LENGTH(kPayloadSize);
+  msg_header->nlmsg_type = NLMSG_DONE;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+  auto* cn = reinterpret_cast<struct cn_msg*>(NLMSG_DATA(msg_header));
+#pragma GCC diagnostic pop
+  cn->id.idx = CN_IDX_PROC;
+  cn->id.val = CN_VAL_PROC;
+  cn->len = sizeof(enum proc_cn_mcast_op);
+  enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+  std::memcpy(cn->data, &op, sizeof(op));
+
+  if (send(fd_, buf, msg_header->nlmsg_len, 0) < 0) {
+    return error::Internal("Failed to subscribe to proc events. [errno=$0]", errno);
+  }
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<ProcEventListener>> ProcEventListener::Create() {
+  auto listener = std::unique_ptr<ProcEventListener>(new ProcEventListener);
+  PL_RETURN_IF_ERROR(listener->Connect());
+  PL_RETURN_IF_ERROR(listener->Subscribe());
+  return listener;
+}
+
+ProcEventListener::~ProcEventListener() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+StatusOr<ProcEvents> ProcEventListener::Drain() {
+  static constexpr int kBufSize = 8192;
+  alignas(struct nlmsghdr) uint8_t buf[kBufSize];
+
+  ProcEvents events;
+  while (true) {
+    ssize_t num_bytes = recv(fd_, buf, sizeof(buf), 0);
+    if (num_bytes < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      if (errno == ENOBUFS) {
+        // The socket buffer overflowed. Keep reading what is left.
+        events.lost_events = true;
+        continue;
+      }
+      return error::Internal("Failed to read proc events. [errno=$0]", errno);
+    }
+    ParseProcEventMessages(buf, num_bytes, &events);
+  }
+  return events;
+}
+
+void ParseProcEventMessages(const uint8_t* buf, ssize_t num_bytes, ProcEvents* events) {
+  const auto* msg_header = reinterpret_cast<const struct nlmsghdr*>(buf);
+  for (; NLMSG_OK(msg_header, num_bytes); msg_header = NLMSG_NEXT(msg_header, num_bytes)) {
+    if (msg_header->nlmsg_type == NLMSG_NOOP) {
+      continue;
+    }
+    if (msg_header->nlmsg_type == NLMSG_ERROR || msg_header->nlmsg_type == NLMSG_OVERRUN) {
+      events->lost_events = true;
+      continue;
+    }
+    if (msg_header->nlmsg_len < NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(struct proc_event))) {
+      continue;
+    }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+    const auto* cn = reinterpret_cast<const struct cn_msg*>(NLMSG_DATA(msg_header));
+#pragma GCC diagnostic pop
+    const auto* ev = reinterpret_cast<const struct proc_event*>(cn->data);
+    switch (ev->what) {
+      case proc_event::PROC_EVENT_FORK:
+        // A new thread also reports a fork, with child_pid != child_tgid.
+        if (ev->event_data.fork.child_pid == ev->event_data.fork.child_tgid) {
+          events->events.push_back({ProcEvent::Type::kFork,
+                                    static_cast<uint32_t>(ev->event_data.fork.child_tgid),
+                                    static_cast<uint32_t>(ev->event_data.fork.parent_tgid)});
+        }
+        break;
+      case proc_event::PROC_EVENT_EXEC:
+        events->events.push_back(
+            {ProcEvent::Type::kExec, static_cast<uint32_t>(ev->event_data.exec.process_tgid)});
+        break;
+      case proc_event::PROC_EVENT_EXIT:
+        if (ev->event_data.exit.process_pid == ev->event_data.exit.process_tgid) {
+          events->events.push_back(
+              {ProcEvent::Type::kExit, static_cast<uint32_t>(ev->event_data.exit.process_tgid)});
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+}  // namespace system
+}  // namespace px
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace system {
+
+/**
+ * A process fork, exec or exit, as reported by the kernel's proc connector. Thread events are
+ * dropped, so pid is always a process id (tgid).
+ */
+struct ProcEvent {
+  enum class Type {
+    kFork,
+    kExec,
+    kExit,
+  };
+
+  Type type;
+  uint32_t pid;
+  // The process that forked, for kFork events. 0 otherwise.
+  uint32_t parent_pid = 0;
+};
+
+/**
+ * The result of draining the pending proc events.
+ */
+struct ProcEvents {
+  std::vector<ProcEvent> events;
+  // Set when the kernel dropped events because they were not read fast enough. The events that
+  // were read are then incomplete, and callers should fall back to a full scan.
+  bool lost_events = false;
+};
+
+/**
+ * ProcEventListener subscribes to the netlink proc connector (NETLINK_CONNECTOR/CN_IDX_PROC),
+ * which reports every fork, exec and exit on the host. The kernel only delivers these events to
+ * processes with CAP_NET_ADMIN.
+ */
+class ProcEventListener : public NotCopyMoveable {
+ public:
+  static StatusOr<std::unique_ptr<ProcEventListener>> Create();
+
+  ~ProcEventListener();
+
+  /**
+   * Reads the events received since the last call, without blocking.
+   */
+  StatusOr<ProcEvents> Drain();
+
+ private:
+  ProcEventListener() = default;
+
+  Status Connect();
+  Status Subscribe();
+
+  int fd_ = -1;
+};
+
+/**
+ * Parses the netlink messages in buf into proc events. Exposed for testing.
+ */
+void ParseProcEventMessages(const uint8_t* buf, ssize_t num_bytes, ProcEvents* events);
+
+}  // namespace system
+}  // namespace px
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+
+#include <cstring>
+#include <vector>
+
+#include "src/common/system/proc_events.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace system {
+
+namespace {
+
+// Appends a netlink message holding the proc event to buf.
+void AppendProcEvent(const struct proc_event& ev, std::vector<uint8_t>* buf) {
+  constexpr size_t kPayloadSize = sizeof(struct cn_msg) + sizeof(struct proc_event);
+  size_t offset = buf->size();
+  buf->resize(offset + NLMSG_SPACE(kPayloadSize));
+
+  auto* msg_header = reinterpret_cast<struct nlmsghdr*>(buf->data() + offset);
+  msg_header->nlmsg_len = NLMSG_LENGTH(kPayloadSize);
+  msg_header->nlmsg_type = NLMSG_DONE;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+  auto* cn = reinterpret_cast<struct cn_msg*>(NLMSG_DATA(msg_header));
+#pragma GCC diagnostic pop
+  cn->id.idx = CN_IDX_PROC;
+  cn->id.val = CN_VAL_PROC;
+  cn->len = sizeof(struct proc_event);
+  std::memcpy(cn->data, &ev, sizeof(ev));
+}
+
+struct proc_event ForkEvent(int parent_tgid, int child_pid, int child_tgid) {
+  struct proc_event ev = {};
+  ev.what = proc_event::PROC_EVENT_FORK;
+  ev.event_data.fork.parent_pid = parent_tgid;
+  ev.event_data.fork.parent_tgid = parent_tgid;
+  ev.event_data.fork.child_pid = child_pid;
+  ev.event_data.fork.child_tgid = child_tgid;
+  return ev;
+}
+
+struct proc_event ExitEvent(int pid, int tgid) {
+  struct proc_event ev = {};
+  ev.what = proc_event::PROC_EVENT_EXIT;
+  ev.event_data.exit.process_pid = pid;
+  ev.event_data.exit.process_tgid = tgid;
+  return ev;
+}
+
+}  // namespace
+
+TEST(ParseProcEventMessagesTest, ProcessEvents) {
+  std::vector<uint8_t> buf;
+  AppendProcEvent(ForkEvent(/*parent_tgid*/ 10, /*child_pid*/ 11, /*child_tgid*/ 11), &buf);
+  // A new thread of process 11 is not a process event.
+  AppendProcEvent(ForkEvent(/*parent_tgid*/ 11, /*child_pid*/ 12, /*child_tgid*/ 11), &buf);
+  struct proc_event exec = {};
+  exec.what = proc_event::PROC_EVENT_EXEC;
+  exec.event_data.exec.process_pid = 11;
+  exec.event_data.exec.process_tgid = 11;
+  AppendProcEvent(exec, &buf);
+  AppendProcEvent(ExitEvent(/*pid*/ 12, /*tgid*/ 11), &buf);
+  AppendProcEvent(ExitEvent(/*pid*/ 11, /*tgid*/ 11), &buf);
+
+  ProcEvents events;
+  ParseProcEventMessages(buf.data(), buf.size(), &events);
+
+  EXPECT_FALSE(events.lost_events);
+  ASSERT_EQ(events.events.size(), 3);
+  EXPECT_EQ(events.events[0].type, ProcEvent::Type::kFork);
+  EXPECT_EQ(events.events[0].pid, 11);
+  EXPECT_EQ(events.events[0].parent_pid, 10);
+  EXPECT_EQ(events.events[1].type, ProcEvent::Type::kExec);
+  EXPECT_EQ(events.events[1].pid, 11);
+  EXPECT_EQ(events.events[2].type, ProcEvent::Type::kExit);
+  EXPECT_EQ(events.events[2].pid, 11);
+}
+
+TEST(ParseProcEventMessagesTest, Overrun) {
+  std::vector<uint8_t> buf(NLMSG_SPACE(0));
+  auto* msg_header = reinterpret_cast<struct nlmsghdr*>(buf.data());
+  msg_header->nlmsg_len = NLMSG_LENGTH(0);
+  msg_header->nlmsg_type = NLMSG_OVERRUN;
+
+  ProcEvents events;
+  ParseProcEventMessages(buf.data(), buf.size(), &events);
+  EXPECT_TRUE(events.lost_events);
+  EXPECT_TRUE(events.events.empty());
+}
+
+}  // namespace system
+}  // namespace px
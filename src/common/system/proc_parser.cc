@@ -16,9 +16,11 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <charconv>
 #include <fstream>
 #include <limits>
 #include <string>
+#include <system_error>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -459,6 +461,10 @@ StatusOr<std::filesystem::path> ProcParser::GetExePath(int32_t pid) const {
   return proc_exe;
 }
 
+StatusOr<std::string> ProcParser::GetPIDCGroups(int32_t pid) const {
+  return px::ReadFileToString(ProcPidPath(pid) / "cgroup");
+}
+
 StatusOr<int64_t> ProcParser::GetPIDStartTimeTicks(int32_t pid) const {
   const std::filesystem::path proc_pid_path =
       std::filesystem::path(proc_base_path_) / std::to_string(pid);
@@ -644,5 +650,43 @@ StatusOr<absl::flat_hash_set<std::string>> ProcParser::GetMapPaths(pid_t pid) co
   return map_paths;
 }
 
+namespace {
+
+bool ParseHex(std::string_view str, uint64_t* val) {
+  auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), *val, 16);
+  return ec == std::errc() && ptr == str.data() + str.size();
+}
+
+}  // namespace
+
+Status ProcParser::ReadProcMaps(pid_t pid, std::vector<ProcMap>* maps) const {
+  // address perms offset dev inode pathname, where the pathname may contain spaces.
+  static constexpr int kProcMapNumFields = 6;
+
+  const std::filesystem::path proc_pid_maps_path = ProcPidPath(pid) / "maps";
+  PL_ASSIGN_OR_RETURN(std::string content, px::ReadFileToString(proc_pid_maps_path));
+  std::vector<std::string_view> lines = absl::StrSplit(content, "\n", absl::SkipWhitespace());
+  for (const auto line : lines) {
+    std::vector<std::string_view> fields =
+        absl::StrSplit(line, absl::MaxSplits(' ', kProcMapNumFields - 1));
+    if (fields.size() < kProcMapNumFields - 1) {
+      return error::Internal("Unexpected line in $0: $1", proc_pid_maps_path.string(), line);
+    }
+    ProcMap& map = maps->emplace_back();
+    std::vector<std::string_view> range = absl::StrSplit(fields[0], absl::MaxSplits('-', 1));
+    if (range.size() != 2 || !ParseHex(range[0], &map.vmem_start) ||
+        !ParseHex(range[1], &map.vmem_end) || !ParseHex(fields[2], &map.file_offset) ||
+        !absl::SimpleAtoi(fields[4], &map.inode)) {
+      return error::Internal("Unexpected line in $0: $1", proc_pid_maps_path.string(), line);
+    }
+    map.permissions = std::string(fields[1]);
+    map.dev = std::string(fields[3]);
+    if (fields.size() == kProcMapNumFields) {
+      map.pathname = std::string(absl::StripLeadingAsciiWhitespace(fields[5]));
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace system
 }  // namespace px
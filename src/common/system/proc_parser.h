@@ -145,6 +145,12 @@ class ProcParser {
    */
   StatusOr<std::filesystem::path> GetExePath(int32_t pid) const;
 
+  /**
+   * Returns the contents of /proc/<pid>/cgroup, which lists the cgroup of the process in every
+   * hierarchy.
+   */
+  StatusOr<std::string> GetPIDCGroups(int32_t pid) const;
+
   /**
    * Parses /proc/<pid>/io files.
    * @param pid is the pid for which to read IO data.
@@ -261,6 +267,29 @@ class ProcParser {
    */
   StatusOr<absl::flat_hash_set<std::string>> GetMapPaths(pid_t pid) const;
 
+  /**
+   * A line of /proc/<pid>/maps.
+   */
+  struct ProcMap {
+    uint64_t vmem_start = 0;
+    uint64_t vmem_end = 0;
+    // e.g. r-xp.
+    std::string permissions;
+    uint64_t file_offset = 0;
+    // major:minor, in hex.
+    std::string dev;
+    uint64_t inode = 0;
+    // Empty for anonymous mappings.
+    std::string pathname;
+
+    bool executable() const { return permissions.size() >= 3 && permissions[2] == 'x'; }
+  };
+
+  /**
+   * Parses /proc/<pid>/maps, in address order.
+   */
+  Status ReadProcMaps(pid_t pid, std::vector<ProcMap>* maps) const;
+
  private:
   static Status ParseNetworkStatAccumulateIFaceData(
       const std::vector<std::string_view>& dev_stat_record, NetworkStats* out);
@@ -239,6 +239,28 @@ TEST_F(ProcParserTest, GetMapPaths) {
   }
 }
 
+TEST_F(ProcParserTest, ReadProcMaps) {
+  std::vector<ProcParser::ProcMap> maps;
+  ASSERT_OK(parser_->ReadProcMaps(123, &maps));
+  ASSERT_EQ(maps.size(), 44);
+
+  EXPECT_EQ(maps[1].vmem_start, 0x565078f8c000);
+  EXPECT_EQ(maps[1].vmem_end, 0x565079054000);
+  EXPECT_EQ(maps[1].permissions, "r-xp");
+  EXPECT_TRUE(maps[1].executable());
+  EXPECT_EQ(maps[1].file_offset, 0x28000);
+  EXPECT_EQ(maps[1].dev, "103:02");
+  EXPECT_EQ(maps[1].inode, 27147818);
+  EXPECT_EQ(maps[1].pathname, "/usr/sbin/nginx");
+
+  // An anonymous mapping.
+  EXPECT_FALSE(maps[5].executable());
+  EXPECT_EQ(maps[5].inode, 0);
+  EXPECT_EQ(maps[5].pathname, "");
+
+  EXPECT_EQ(maps[6].pathname, "[heap]");
+}
+
 // Check ProcParser can detect itself.
 TEST(ProcParserGetExePathTest, CheckTestProcess) {
   // Since bazel prepares test files as symlinks, creating testdata/proc/123/exe symlink would
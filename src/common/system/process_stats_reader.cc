@@ -0,0 +1,235 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/system/process_stats_reader.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
+
+namespace px {
+namespace system {
+
+namespace {
+
+// The fields of /proc/<pid>/stat, counting the pid as field 0 and the process name as field 1.
+constexpr int kStatMinorFaultsField = 9;
+constexpr int kStatMajorFaultsField = 11;
+constexpr int kStatUTimeField = 13;
+constexpr int kStatKTimeField = 14;
+constexpr int kStatNumThreadsField = 19;
+constexpr int kStatVSizeField = 22;
+constexpr int kStatRSSField = 23;
+
+// Returns the next space separated token of s, starting at *pos, and advances *pos past it.
+std::string_view NextToken(std::string_view s, size_t* pos) {
+  while (*pos < s.size() && (s[*pos] == ' ' || s[*pos] == '\t' || s[*pos] == '\n')) {
+    ++*pos;
+  }
+  size_t start = *pos;
+  while (*pos < s.size() && s[*pos] != ' ' && s[*pos] != '\t' && s[*pos] != '\n') {
+    ++*pos;
+  }
+  return s.substr(start, *pos - start);
+}
+
+}  // namespace
+
+ProcessStatsReader::ProcessStatsReader(const system::Config& cfg, size_t max_open_pids)
+    : max_open_pids_(max_open_pids) {
+  CHECK(cfg.HasConfig()) << "System config is required for the ProcessStatsReader";
+  ns_per_kernel_tick_ = static_cast<int64_t>(1E9 / cfg.KernelTicksPerSecond());
+  bytes_per_page_ = cfg.PageSize();
+  proc_base_path_ = cfg.proc_path();
+}
+
+ProcessStatsReader::~ProcessStatsReader() {
+  for (auto& [pid, files] : files_) {
+    CloseFiles(&files);
+  }
+}
+
+Status ProcessStatsReader::OpenFiles(int32_t pid, PIDFiles* files) const {
+  std::string pid_path = absl::StrCat(proc_base_path_, "/", pid);
+  std::string stat_path = absl::StrCat(pid_path, "/stat");
+  files->stat_fd = open(stat_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (files->stat_fd < 0) {
+    return error::Internal("Failed to open file $0 [errno=$1]", stat_path, errno);
+  }
+  std::string io_path = absl::StrCat(pid_path, "/io");
+  files->io_fd = open(io_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (files->io_fd < 0) {
+    CloseFiles(files);
+    return error::Internal("Failed to open file $0 [errno=$1]", io_path, errno);
+  }
+  return Status::OK();
+}
+
+void ProcessStatsReader::CloseFiles(PIDFiles* files) {
+  if (files->stat_fd >= 0) {
+    close(files->stat_fd);
+    files->stat_fd = -1;
+  }
+  if (files->io_fd >= 0) {
+    close(files->io_fd);
+    files->io_fd = -1;
+  }
+}
+
+StatusOr<std::string_view> ProcessStatsReader::ReadFile(int fd) {
+  ssize_t num_bytes = pread(fd, buf_, sizeof(buf_), 0);
+  if (num_bytes <= 0) {
+    // ESRCH once the process has exited.
+    return error::Internal("Failed to read proc file [errno=$0]", num_bytes < 0 ? errno : 0);
+  }
+  return std::string_view(buf_, num_bytes);
+}
+
+Status ProcessStatsReader::ReadFiles(const PIDFiles& files, ProcParser::ProcessStats* out) {
+  PL_ASSIGN_OR_RETURN(std::string_view stat, ReadFile(files.stat_fd));
+  PL_RETURN_IF_ERROR(ParseStat(stat, ns_per_kernel_tick_, bytes_per_page_, out));
+  PL_ASSIGN_OR_RETURN(std::string_view io, ReadFile(files.io_fd));
+  return ParseIO(io, out);
+}
+
+Status ProcessStatsReader::ReadStats(int32_t pid, ProcParser::ProcessStats* out) {
+  auto it = files_.find(pid);
+  if (it != files_.end()) {
+    it->second.read = true;
+    Status s = ReadFiles(it->second, out);
+    if (s.ok()) {
+      return s;
+    }
+    // The process exited, and the pid may have been reused by a new process. Reopen the files.
+    CloseFiles(&it->second);
+    files_.erase(it);
+  }
+
+  PIDFiles files;
+  PL_RETURN_IF_ERROR(OpenFiles(pid, &files));
+  Status s = ReadFiles(files, out);
+  if (s.ok() && files_.size() < max_open_pids_) {
+    files.read = true;
+    files_.emplace(pid, files);
+  } else {
+    CloseFiles(&files);
+  }
+  return s;
+}
+
+void ProcessStatsReader::CloseUnread() {
+  for (auto it = files_.begin(); it != files_.end();) {
+    if (!it->second.read) {
+      CloseFiles(&it->second);
+      files_.erase(it++);
+      continue;
+    }
+    it->second.read = false;
+    ++it;
+  }
+}
+
+Status ProcessStatsReader::ParseStat(std::string_view contents, int64_t ns_per_kernel_tick,
+                                     int32_t bytes_per_page, ProcParser::ProcessStats* out) {
+  // The process name is in parentheses, and may itself contain spaces and parentheses.
+  size_t name_start = contents.find('(');
+  size_t name_end = contents.rfind(')');
+  if (name_start == std::string_view::npos || name_end == std::string_view::npos ||
+      name_end < name_start) {
+    return error::Internal("Failed to find the process name in stat file.");
+  }
+
+  bool ok = absl::SimpleAtoi(contents.substr(0, name_start), &out->pid);
+  out->process_name.assign(contents.data() + name_start + 1, name_end - name_start - 1);
+
+  size_t pos = name_end + 1;
+  for (int field = 2; field <= kStatRSSField; ++field) {
+    std::string_view token = NextToken(contents, &pos);
+    if (token.empty()) {
+      return error::Unknown("Incorrect number of fields in stat file.");
+    }
+    switch (field) {
+      case kStatMinorFaultsField:
+        ok &= absl::SimpleAtoi(token, &out->minor_faults);
+        break;
+      case kStatMajorFaultsField:
+        ok &= absl::SimpleAtoi(token, &out->major_faults);
+        break;
+      case kStatUTimeField:
+        ok &= absl::SimpleAtoi(token, &out->utime_ns);
+        // The kernel tracks utime and ktime in kernel ticks.
+        out->utime_ns *= ns_per_kernel_tick;
+        break;
+      case kStatKTimeField:
+        ok &= absl::SimpleAtoi(token, &out->ktime_ns);
+        out->ktime_ns *= ns_per_kernel_tick;
+        break;
+      case kStatNumThreadsField:
+        ok &= absl::SimpleAtoi(token, &out->num_threads);
+        break;
+      case kStatVSizeField:
+        ok &= absl::SimpleAtoi(token, &out->vsize_bytes);
+        break;
+      case kStatRSSField:
+        ok &= absl::SimpleAtoi(token, &out->rss_bytes);
+        // RSS is in pages.
+        out->rss_bytes *= bytes_per_page;
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (!ok) {
+    return error::Internal("Failed to parse stat file. ATOI failed.");
+  }
+  return Status::OK();
+}
+
+Status ProcessStatsReader::ParseIO(std::string_view contents, ProcParser::ProcessStats* out) {
+  size_t pos = 0;
+  bool ok = true;
+  while (true) {
+    std::string_view key = NextToken(contents, &pos);
+    std::string_view val = NextToken(contents, &pos);
+    if (val.empty()) {
+      break;
+    }
+    if (key == "rchar:") {
+      ok &= absl::SimpleAtoi(val, &out->rchar_bytes);
+    } else if (key == "wchar:") {
+      ok &= absl::SimpleAtoi(val, &out->wchar_bytes);
+    } else if (key == "read_bytes:") {
+      ok &= absl::SimpleAtoi(val, &out->read_bytes);
+    } else if (key == "write_bytes:") {
+      ok &= absl::SimpleAtoi(val, &out->write_bytes);
+    }
+  }
+
+  if (!ok) {
+    return error::Unknown("Failed to parse io file.");
+  }
+  return Status::OK();
+}
+
+}  // namespace system
+}  // namespace px
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/common/system/config.h"
+#include "src/common/system/proc_parser.h"
+
+namespace px {
+namespace system {
+
+/**
+ * ProcessStatsReader reads the same stats as ProcParser::ParseProcPIDStat and
+ * ProcParser::ParseProcPIDStatIO, for callers that sample many processes repeatedly.
+ * It keeps /proc/<pid>/stat and /proc/<pid>/io open between reads, re-reads them with pread, and
+ * parses them in place without allocating.
+ *
+ * Not thread-safe.
+ */
+class ProcessStatsReader : public NotCopyable {
+ public:
+  // The most pids whose files are kept open. Other pids have their files opened on every read.
+  static constexpr size_t kDefaultMaxOpenPIDs = 1024;
+
+  explicit ProcessStatsReader(const system::Config& cfg,
+                              size_t max_open_pids = kDefaultMaxOpenPIDs);
+  ~ProcessStatsReader();
+
+  /**
+   * Reads the stats of the pid. Only the fields that ParseProcPIDStat and ParseProcPIDStatIO fill
+   * in are set.
+   */
+  Status ReadStats(int32_t pid, ProcParser::ProcessStats* out);
+
+  /**
+   * Closes the files of the pids that were not read since the previous call.
+   */
+  void CloseUnread();
+
+  size_t NumOpenPIDs() const { return files_.size(); }
+
+  /**
+   * Parses the contents of a /proc/<pid>/stat file.
+   */
+  static Status ParseStat(std::string_view contents, int64_t ns_per_kernel_tick,
+                          int32_t bytes_per_page, ProcParser::ProcessStats* out);
+
+  /**
+   * Parses the contents of a /proc/<pid>/io file.
+   */
+  static Status ParseIO(std::string_view contents, ProcParser::ProcessStats* out);
+
+ private:
+  struct PIDFiles {
+    int stat_fd = -1;
+    int io_fd = -1;
+    bool read = false;
+  };
+
+  Status OpenFiles(int32_t pid, PIDFiles* files) const;
+  static void CloseFiles(PIDFiles* files);
+  Status ReadFiles(const PIDFiles& files, ProcParser::ProcessStats* out);
+  StatusOr<std::string_view> ReadFile(int fd);
+
+  int64_t ns_per_kernel_tick_;
+  int32_t bytes_per_page_;
+  std::string proc_base_path_;
+  size_t max_open_pids_;
+
+  absl::flat_hash_map<int32_t, PIDFiles> files_;
+
+  // Holds the contents of the file being parsed. Large enough for a stat file.
+  char buf_[4096];
+};
+
+}  // namespace system
+}  // namespace px
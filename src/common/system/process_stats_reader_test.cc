@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/common/system/process_stats_reader.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+
+#include "src/common/system/config_mock.h"
+#include "src/common/testing/test_environment.h"
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace system {
+
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+class ProcessStatsReaderTest : public ::testing::Test {
+ protected:
+  ProcessStatsReaderTest()
+      : proc_path_(testing::TestFilePath("src/common/system/testdata/proc")) {}
+
+  void SetUp() override {
+    system::MockConfig sysconfig;
+
+    EXPECT_CALL(sysconfig, HasConfig()).WillRepeatedly(Return(true));
+    EXPECT_CALL(sysconfig, PageSize()).WillRepeatedly(Return(4096));
+    EXPECT_CALL(sysconfig, KernelTicksPerSecond()).WillRepeatedly(Return(10000000));
+    EXPECT_CALL(sysconfig, proc_path()).WillRepeatedly(ReturnRef(proc_path_));
+    parser_ = std::make_unique<ProcParser>(sysconfig);
+    reader_ = std::make_unique<ProcessStatsReader>(sysconfig, /*max_open_pids*/ 1);
+  }
+
+  std::filesystem::path proc_path_;
+  std::unique_ptr<ProcParser> parser_;
+  std::unique_ptr<ProcessStatsReader> reader_;
+};
+
+TEST_F(ProcessStatsReaderTest, MatchesProcParser) {
+  ProcParser::ProcessStats expected;
+  ASSERT_OK(parser_->ParseProcPIDStat(123, &expected));
+  ASSERT_OK(parser_->ParseProcPIDStatIO(123, &expected));
+
+  // The second read is from the files kept open by the first.
+  for (int i = 0; i < 2; ++i) {
+    ProcParser::ProcessStats stats;
+    ASSERT_OK(reader_->ReadStats(123, &stats));
+    EXPECT_EQ(expected.pid, stats.pid);
+    EXPECT_EQ(expected.process_name, stats.process_name);
+    EXPECT_EQ(expected.minor_faults, stats.minor_faults);
+    EXPECT_EQ(expected.major_faults, stats.major_faults);
+    EXPECT_EQ(expected.utime_ns, stats.utime_ns);
+    EXPECT_EQ(expected.ktime_ns, stats.ktime_ns);
+    EXPECT_EQ(expected.num_threads, stats.num_threads);
+    EXPECT_EQ(expected.vsize_bytes, stats.vsize_bytes);
+    EXPECT_EQ(expected.rss_bytes, stats.rss_bytes);
+    EXPECT_EQ(expected.rchar_bytes, stats.rchar_bytes);
+    EXPECT_EQ(expected.wchar_bytes, stats.wchar_bytes);
+    EXPECT_EQ(expected.read_bytes, stats.read_bytes);
+    EXPECT_EQ(expected.write_bytes, stats.write_bytes);
+    EXPECT_EQ(1, reader_->NumOpenPIDs());
+  }
+}
+
+TEST_F(ProcessStatsReaderTest, CloseUnread) {
+  ProcParser::ProcessStats stats;
+  ASSERT_OK(reader_->ReadStats(123, &stats));
+  EXPECT_EQ(1, reader_->NumOpenPIDs());
+
+  reader_->CloseUnread();
+  EXPECT_EQ(1, reader_->NumOpenPIDs());
+  reader_->CloseUnread();
+  EXPECT_EQ(0, reader_->NumOpenPIDs());
+
+  EXPECT_NOT_OK(reader_->ReadStats(999999, &stats));
+  EXPECT_EQ(0, reader_->NumOpenPIDs());
+}
+
+TEST(ProcessStatsReaderParseTest, ProcessNameWithSpaces) {
+  constexpr std::string_view kStat =
+      "4602 (my (odd) name) S 3260 4602 3260 34818 4602 1077936128 1799 174589 55 68 8 23 106 72 "
+      "20 0 13 0 14329 114384896 2577 18446744073709551615\n";
+  ProcParser::ProcessStats stats;
+  ASSERT_OK(ProcessStatsReader::ParseStat(kStat, /*ns_per_kernel_tick*/ 100,
+                                          /*bytes_per_page*/ 4096, &stats));
+  EXPECT_EQ(4602, stats.pid);
+  EXPECT_EQ("my (odd) name", stats.process_name);
+  EXPECT_EQ(1799, stats.minor_faults);
+  EXPECT_EQ(55, stats.major_faults);
+  EXPECT_EQ(800, stats.utime_ns);
+  EXPECT_EQ(2300, stats.ktime_ns);
+  EXPECT_EQ(13, stats.num_threads);
+  EXPECT_EQ(114384896, stats.vsize_bytes);
+  EXPECT_EQ(2577 * 4096, stats.rss_bytes);
+
+  EXPECT_NOT_OK(ProcessStatsReader::ParseStat("4602 (ibazel) S 3260", 100, 4096, &stats));
+}
+
+}  // namespace system
+}  // namespace px
@@ -469,7 +469,14 @@ StatusOr<std::unique_ptr<SocketInfoManager>> SocketInfoManager::Create(
 }
 
 StatusOr<std::map<int, SocketInfo>*> SocketInfoManager::GetNamespaceConns(uint32_t pid) {
-  PL_ASSIGN_OR_RETURN(uint32_t net_ns, NetNamespace(cfg_proc_path_, pid));
+  uint32_t net_ns;
+  auto pid_iter = pid_net_ns_.find(pid);
+  if (pid_iter != pid_net_ns_.end()) {
+    net_ns = pid_iter->second;
+  } else {
+    PL_ASSIGN_OR_RETURN(net_ns, NetNamespace(cfg_proc_path_, pid));
+    pid_net_ns_.emplace(pid, net_ns);
+  }
 
   // Step 1: Get the map of connections for this network namespace.
   // Create the map if it doesn't already exist.
@@ -525,6 +532,7 @@ StatusOr<SocketInfo*> SocketInfoManager::Lookup(uint32_t pid, uint32_t inode_num
 void SocketInfoManager::Flush() {
   socket_probers_->Update();
   connections_.clear();
+  pid_net_ns_.clear();
   num_socket_prober_calls_ = 0;
 }
 
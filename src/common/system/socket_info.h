@@ -289,6 +289,8 @@ class SocketInfoManager {
 
   /**
    * Flushes the cache so new connections can be discovered.
+   * The socket prober of each network namespace is queried at most once between flushes, so the
+   * cost of resolving connections is bounded by the number of namespaces, not of connections.
    */
   void Flush();
 
@@ -314,6 +316,10 @@ class SocketInfoManager {
   // First key is namespace inode; second key is socket inode.
   std::map<int, std::map<int, SocketInfo>> connections_;
 
+  // The network namespace inode of each PID that was looked up since the last Flush(), so that
+  // the connections of the same PID only read /proc/<pid>/ns/net once.
+  std::map<uint32_t, uint32_t> pid_net_ns_;
+
   // Portal through which new connection information is gathered,
   // and populated into connections_.
   std::unique_ptr<SocketProberManager> socket_probers_;
@@ -17,6 +17,8 @@
  */
 
 #include <zlib.h>
+
+#include <algorithm>
 #include <string>
 
 #include "src/common/base/base.h"
@@ -60,5 +62,69 @@ StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size) {
   return out;
 }
 
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_size) {
+  constexpr size_t kOutputBlockSize = 16384;
+
+  z_stream zs = {};
+
+  if (inflateInit2(&zs, MAX_WBITS + 16) != Z_OK) {
+    return error::Internal("inflateInit2 failed while decompressing.");
+  }
+
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = in.size();
+
+  int ret = Z_OK;
+  std::string out;
+
+  while (ret == Z_OK && out.size() < max_output_size) {
+    out.resize(out.size() + std::min(kOutputBlockSize, max_output_size - out.size()));
+    zs.next_out = reinterpret_cast<Bytef*>(out.data() + zs.total_out);
+    zs.avail_out = out.size() - zs.total_out;
+
+    ret = inflate(&zs, 0);
+  }
+
+  out.resize(zs.total_out);
+
+  inflateEnd(&zs);
+
+  // Z_OK means decompression stopped because the output is full.
+  if (ret != Z_OK && ret != Z_STREAM_END) {
+    return error::Internal("Exception during zlib decompression: $0", zs.msg);
+  }
+
+  return out;
+}
+
+StatusOr<std::string> Deflate(std::string_view in, int level) {
+  z_stream zs = {};
+
+  if (deflateInit2(&zs, level, Z_DEFLATED, MAX_WBITS + 16, /* memLevel */ 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return error::Internal("deflateInit2 failed while compressing.");
+  }
+
+  // Setup input buffer.
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = in.size();
+
+  // deflateBound is large enough to compress the input in a single call.
+  std::string out(deflateBound(&zs, in.size()), '\0');
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = out.size();
+
+  int ret = deflate(&zs, Z_FINISH);
+  out.resize(zs.total_out);
+
+  deflateEnd(&zs);
+
+  if (ret != Z_STREAM_END) {
+    return error::Internal("Exception during zlib compression: $0", zs.msg);
+  }
+
+  return out;
+}
+
 }  // namespace zlib
 }  // namespace px
@@ -35,5 +35,25 @@ namespace zlib {
  */
 StatusOr<std::string> Inflate(std::string_view in, size_t output_block_size = 16384);
 
+/**
+ * @brief Inflates (gunzip) at most max_output_size bytes of a source buffer. Decompression stops
+ * once that many bytes are produced, so the work is bounded by the output kept, not by the size of
+ * the decompressed content.
+ *
+ * @param in A view into the source buffer.
+ * @param max_output_size The most decompressed bytes to return.
+ * @return Status or the first (up to) max_output_size bytes of the decompressed content.
+ */
+StatusOr<std::string> InflatePrefix(std::string_view in, size_t max_output_size);
+
+/**
+ * @brief Deflates (gzip) a source buffer and returns the compressed content as a string.
+ *
+ * @param in A view into the source buffer.
+ * @param level The zlib compression level, from 1 (fastest) to 9 (smallest).
+ * @return Status or the compressed content as a string.
+ */
+StatusOr<std::string> Deflate(std::string_view in, int level = 1);
+
 }  // namespace zlib
 }  // namespace px
@@ -46,4 +46,28 @@ TEST_F(ZlibTest, inflate_test) {
   EXPECT_OK_AND_EQ(result, GetExpectedResult());
 }
 
+TEST_F(ZlibTest, inflate_prefix_test) {
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 7), "This is");
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(GetCompressedString(), 100), GetExpectedResult());
+
+  std::string input;
+  for (int i = 0; i < 10000; ++i) {
+    input += GetExpectedResult();
+  }
+  ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(input));
+  EXPECT_OK_AND_EQ(px::zlib::InflatePrefix(compressed, 20000), input.substr(0, 20000));
+
+  EXPECT_NOT_OK(px::zlib::InflatePrefix("not gzip", 100));
+}
+
+TEST_F(ZlibTest, deflate_test) {
+  std::string input;
+  for (int i = 0; i < 1000; ++i) {
+    input += GetExpectedResult();
+  }
+  ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(input));
+  EXPECT_LT(compressed.size(), input.size());
+  EXPECT_OK_AND_EQ(px::zlib::Inflate(compressed), input);
+}
+
 }  // namespace px
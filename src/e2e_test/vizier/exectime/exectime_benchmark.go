@@ -25,6 +25,7 @@ import (
 	"math"
 	"os"
 	"sort"
+	"sync"
 	"time"
 
 	"github.com/gofrs/uuid"
@@ -50,6 +51,10 @@ func init() {
 	pflag.StringP("bundle", "b", defaultBundleFile, "The bundle file to use")
 	pflag.BoolP("all-clusters", "d", false, "Run script across all clusters")
 	pflag.StringP("cluster", "c", "", "Run only on selected cluster")
+	pflag.Int("concurrency", 1, "number of runs of a script to execute at the same time")
+	pflag.Duration("script_timeout", 5*time.Second, "how long a single run of a script may take")
+	pflag.StringP("output_file", "o", "", "write the results as JSON to this file")
+	pflag.String("baseline_file", "", "compare the results to those of a previous --output_file")
 }
 
 // Distribution is the interface used to make the stats.
@@ -81,6 +86,17 @@ func (t *TimeDistribution) Stddev() time.Duration {
 	return time.Duration(math.Sqrt(sumOfSquares / float64(len(t.Times))))
 }
 
+// Percentile returns the time below which the fraction p of the times fall.
+func (t *TimeDistribution) Percentile(p float64) time.Duration {
+	if len(t.Times) == 0 {
+		return 0
+	}
+	sorted := make([]time.Duration, len(t.Times))
+	copy(sorted, t.Times)
+	sort.Slice(sorted, func(i, j int) bool { return sorted[i] < sorted[j] })
+	return sorted[int(math.Round(p*float64(len(sorted)-1)))]
+}
+
 // Summarize returns the Mean +/- stddev.
 func (t *TimeDistribution) Summarize() string {
 	return fmt.Sprintf("%v +/- %v", t.Mean().Round(time.Duration(10)*time.Microsecond), t.Stddev().Round(time.Duration(10)*time.Microsecond))
@@ -150,10 +166,13 @@ type execResults struct {
 	compileTime      time.Duration
 	scriptErr        error
 	numBytes         int
+	// The input of the query on the agents.
+	bytesProcessed   int
+	recordsProcessed int
 }
 
-func executeScript(v []*vizier.Connector, execScript *script.ExecutableScript) (*execResults, error) {
-	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+func executeScript(v []*vizier.Connector, execScript *script.ExecutableScript, timeout time.Duration) (*execResults, error) {
+	ctx, cancel := context.WithTimeout(context.Background(), timeout)
 	defer cancel()
 	execRes := execResults{}
 	start := time.Now()
@@ -184,6 +203,8 @@ func executeScript(v []*vizier.Connector, execScript *script.ExecutableScript) (
 	execRes.internalExecTime = time.Duration(execStats.Timing.ExecutionTimeNs)
 	execRes.compileTime = time.Duration(execStats.Timing.CompilationTimeNs)
 	execRes.numBytes = tw.TotalBytes()
+	execRes.bytesProcessed = int(execStats.BytesProcessed)
+	execRes.recordsProcessed = int(execStats.RecordsProcessed)
 	return &execRes, nil
 }
 
@@ -264,6 +285,11 @@ func main() {
 	allClusters := viper.GetBool("all-clusters")
 	selectedCluster := viper.GetString("cluster")
 	clusterID := uuid.FromStringOrNil(selectedCluster)
+	concurrency := viper.GetInt("concurrency")
+	if concurrency < 1 {
+		concurrency = 1
+	}
+	timeout := viper.GetDuration("script_timeout")
 
 	br, err := createBundleReader(bundleFile)
 	if err != nil {
@@ -282,6 +308,12 @@ func main() {
 
 	vzrConns := vizier.MustConnectHealthyDefaultVizier(cloudAddr, allClusters, clusterID)
 
+	startTime := time.Now()
+	pemsBefore, err := snapshotPEMResources(vzrConns, timeout)
+	if err != nil {
+		log.WithError(err).Warn("Failed to get the resource usage of the PEMs")
+	}
+
 	data := make(map[string]*ScriptExecData)
 	for i, s := range scripts {
 		if isDisabled(s.ScriptName) {
@@ -294,18 +326,40 @@ func main() {
 		compilationTiming := make([]time.Duration, repeatCount)
 		scriptErrors := make([]error, repeatCount)
 		numBytes := make([]int, repeatCount)
-
-		// Run script.
+		bytesProcessed := make([]int, repeatCount)
+		recordsProcessed := make([]int, repeatCount)
+
+		// Run script, up to concurrency runs at a time.
+		runs := make([]*execResults, repeatCount)
+		runIdxs := make(chan int)
+		var wg sync.WaitGroup
+		for w := 0; w < concurrency; w++ {
+			wg.Add(1)
+			go func() {
+				defer wg.Done()
+				for i := range runIdxs {
+					res, err := executeScript(vzrConns, s, timeout)
+					if err != nil {
+						log.WithError(err).Fatalf("Failed to execute script")
+					}
+					runs[i] = res
+				}
+			}()
+		}
 		for i := 0; i < repeatCount; i++ {
-			res, err := executeScript(vzrConns, s)
-			if err != nil {
-				log.WithError(err).Fatalf("Failed to execute script")
-			}
+			runIdxs <- i
+		}
+		close(runIdxs)
+		wg.Wait()
+
+		for i, res := range runs {
 			scriptErrors[i] = res.scriptErr
 			externalExecTiming[i] = res.externalExecTime
 			compilationTiming[i] = res.compileTime
 			internalExecTiming[i] = res.internalExecTime
 			numBytes[i] = res.numBytes
+			bytesProcessed[i] = res.bytesProcessed
+			recordsProcessed[i] = res.recordsProcessed
 		}
 
 		data[s.ScriptName] = &ScriptExecData{
@@ -316,6 +370,8 @@ func main() {
 				"Compilation Time":    &TimeDistribution{compilationTiming},
 				"Num Errors":          &ErrorDistribution{scriptErrors},
 				"Num Bytes":           &BytesDistribution{numBytes},
+				"Bytes Processed":     &BytesDistribution{bytesProcessed},
+				"Records Processed":   &BytesDistribution{recordsProcessed},
 			},
 		}
 	}
@@ -327,4 +383,34 @@ func main() {
 	if err != nil {
 		log.WithError(err).Fatalf("Failure on writing table")
 	}
+
+	results := &benchmarkResults{
+		StartTime:   startTime,
+		NumRuns:     repeatCount,
+		Concurrency: concurrency,
+	}
+	for _, d := range sortedData {
+		results.Scripts = append(results.Scripts, newScriptResult(d))
+	}
+	if pemsBefore != nil {
+		pemsAfter, err := snapshotPEMResources(vzrConns, timeout)
+		if err != nil {
+			log.WithError(err).Warn("Failed to get the resource usage of the PEMs")
+		} else {
+			results.PEMs = diffPEMResources(pemsBefore, pemsAfter)
+		}
+	}
+
+	if baselineFile := viper.GetString("baseline_file"); baselineFile != "" {
+		baseline, err := readResults(baselineFile)
+		if err != nil {
+			log.WithError(err).Fatal("Failed to read the baseline results")
+		}
+		writeComparison(os.Stdout, baseline, results)
+	}
+	if outputFile := viper.GetString("output_file"); outputFile != "" {
+		if err := writeResults(outputFile, results); err != nil {
+			log.WithError(err).Fatal("Failed to write the results")
+		}
+	}
 }
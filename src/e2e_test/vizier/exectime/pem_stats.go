@@ -0,0 +1,133 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package main
+
+import (
+	"context"
+	"fmt"
+	"sort"
+	"time"
+
+	"px.dev/pixie/src/pixie_cli/pkg/script"
+	"px.dev/pixie/src/pixie_cli/pkg/vizier"
+)
+
+// The latest CPU counters and memory of the PEM of each node.
+const pemResourcesScript = `
+import px
+df = px.DataFrame(table='process_stats', start_time='-30s')
+df.pod = df.ctx['pod']
+df = df[px.contains(df.ctx['container_name'], 'pem')]
+df.cpu_ns = df.cpu_utime_ns + df.cpu_ktime_ns
+df = df.groupby(['pod', 'upid']).agg(
+    cpu_ns=('cpu_ns', px.max),
+    rss_bytes=('rss_bytes', px.max),
+)
+df = df.groupby('pod').agg(
+    cpu_ns=('cpu_ns', px.sum),
+    rss_bytes=('rss_bytes', px.sum),
+)
+px.display(df, 'pem_resources')
+`
+
+type pemResources struct {
+	cpuNs    float64
+	rssBytes float64
+}
+
+// pemResourceDelta is the resource usage of a PEM between two snapshots.
+type pemResourceDelta struct {
+	Pod string `json:"pod"`
+	// The CPU time the PEM used, in seconds.
+	CPUSeconds    float64 `json:"cpu_seconds"`
+	RSSBytesStart float64 `json:"rss_bytes_start"`
+	RSSBytesEnd   float64 `json:"rss_bytes_end"`
+}
+
+func toFloat(v interface{}) (float64, error) {
+	switch u := v.(type) {
+	case int64:
+		return float64(u), nil
+	case float64:
+		return u, nil
+	default:
+		return 0, fmt.Errorf("unexpected value %v", v)
+	}
+}
+
+// snapshotPEMResources returns the CPU counters and memory of each PEM, keyed by pod.
+func snapshotPEMResources(v []*vizier.Connector, timeout time.Duration) (map[string]*pemResources, error) {
+	ctx, cancel := context.WithTimeout(context.Background(), timeout)
+	defer cancel()
+	execScript := &script.ExecutableScript{
+		ScriptString: pemResourcesScript,
+		ScriptName:   "pem_resources",
+	}
+	resp, err := vizier.RunScript(ctx, v, execScript, nil)
+	if err != nil {
+		return nil, err
+	}
+	tw := vizier.NewStreamOutputAdapter(ctx, resp, vizier.FormatInMemory, nil)
+	if err := tw.Finish(); err != nil {
+		return nil, err
+	}
+	views, err := tw.Views()
+	if err != nil {
+		return nil, err
+	}
+
+	pems := make(map[string]*pemResources)
+	for _, view := range views {
+		for _, row := range view.Data() {
+			if len(row) != 3 {
+				return nil, fmt.Errorf("expected 3 columns, got %d", len(row))
+			}
+			pod := fmt.Sprint(row[0])
+			cpuNs, err := toFloat(row[1])
+			if err != nil {
+				return nil, err
+			}
+			rssBytes, err := toFloat(row[2])
+			if err != nil {
+				return nil, err
+			}
+			pems[pod] = &pemResources{cpuNs: cpuNs, rssBytes: rssBytes}
+		}
+	}
+	return pems, nil
+}
+
+func diffPEMResources(before, after map[string]*pemResources) []*pemResourceDelta {
+	var deltas []*pemResourceDelta
+	for pod, a := range after {
+		b, ok := before[pod]
+		if !ok {
+			// The PEM restarted or was scheduled during the benchmark.
+			continue
+		}
+		deltas = append(deltas, &pemResourceDelta{
+			Pod:           pod,
+			CPUSeconds:    (a.cpuNs - b.cpuNs) / float64(time.Second),
+			RSSBytesStart: b.rssBytes,
+			RSSBytesEnd:   a.rssBytes,
+		})
+	}
+	sort.Slice(deltas, func(i, j int) bool { return deltas[i].Pod < deltas[j].Pod })
+	return deltas
+}
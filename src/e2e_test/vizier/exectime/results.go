@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package main
+
+import (
+	"encoding/json"
+	"fmt"
+	"io"
+	"os"
+	"time"
+
+	"github.com/olekukonko/tablewriter"
+)
+
+// benchmarkResults are the results of a run of the benchmark, as written to --output_file.
+type benchmarkResults struct {
+	StartTime   time.Time       `json:"start_time"`
+	NumRuns     int             `json:"num_runs"`
+	Concurrency int             `json:"concurrency"`
+	Scripts     []*scriptResult `json:"scripts"`
+	// The resources the PEMs used while the benchmark ran.
+	PEMs []*pemResourceDelta `json:"pems,omitempty"`
+}
+
+// latencyResult summarizes a TimeDistribution.
+type latencyResult struct {
+	MeanMs float64 `json:"mean_ms"`
+	P50Ms  float64 `json:"p50_ms"`
+	P90Ms  float64 `json:"p90_ms"`
+	P99Ms  float64 `json:"p99_ms"`
+}
+
+type scriptResult struct {
+	Name                 string        `json:"name"`
+	ExternalExecTime     latencyResult `json:"external_exec_time"`
+	InternalExecTime     latencyResult `json:"internal_exec_time"`
+	CompilationTime      latencyResult `json:"compilation_time"`
+	ErrorRate            float64       `json:"error_rate"`
+	MeanBytes            float64       `json:"mean_bytes"`
+	MeanBytesProcessed   float64       `json:"mean_bytes_processed"`
+	MeanRecordsProcessed float64       `json:"mean_records_processed"`
+}
+
+func toMs(d time.Duration) float64 {
+	return float64(d) / float64(time.Millisecond)
+}
+
+func newLatencyResult(t *TimeDistribution) latencyResult {
+	return latencyResult{
+		MeanMs: toMs(t.Mean()),
+		P50Ms:  toMs(t.Percentile(0.5)),
+		P90Ms:  toMs(t.Percentile(0.9)),
+		P99Ms:  toMs(t.Percentile(0.99)),
+	}
+}
+
+func newScriptResult(d *ScriptExecData) *scriptResult {
+	errs := d.Distributions["Num Errors"].(*ErrorDistribution)
+	res := &scriptResult{
+		Name:                 d.Name,
+		ExternalExecTime:     newLatencyResult(d.Distributions["Exec Time: External"].(*TimeDistribution)),
+		InternalExecTime:     newLatencyResult(d.Distributions["Exec Time: Internal"].(*TimeDistribution)),
+		CompilationTime:      newLatencyResult(d.Distributions["Compilation Time"].(*TimeDistribution)),
+		MeanBytes:            d.Distributions["Num Bytes"].(*BytesDistribution).Mean(),
+		MeanBytesProcessed:   d.Distributions["Bytes Processed"].(*BytesDistribution).Mean(),
+		MeanRecordsProcessed: d.Distributions["Records Processed"].(*BytesDistribution).Mean(),
+	}
+	if len(errs.Errors) > 0 {
+		res.ErrorRate = float64(errs.Num()) / float64(len(errs.Errors))
+	}
+	return res
+}
+
+func writeResults(path string, results *benchmarkResults) error {
+	b, err := json.MarshalIndent(results, "", "  ")
+	if err != nil {
+		return err
+	}
+	return os.WriteFile(path, b, 0644)
+}
+
+func readResults(path string) (*benchmarkResults, error) {
+	b, err := os.ReadFile(path)
+	if err != nil {
+		return nil, err
+	}
+	results := &benchmarkResults{}
+	if err := json.Unmarshal(b, results); err != nil {
+		return nil, err
+	}
+	return results, nil
+}
+
+func formatRatio(cur, base float64) string {
+	if base == 0 {
+		return "-"
+	}
+	return fmt.Sprintf("%.2fx", cur/base)
+}
+
+// writeComparison writes a table of how the latencies of each script changed from the baseline.
+func writeComparison(w io.Writer, baseline, results *benchmarkResults) {
+	baseScripts := make(map[string]*scriptResult)
+	for _, s := range baseline.Scripts {
+		baseScripts[s.Name] = s
+	}
+
+	table := tablewriter.NewWriter(w)
+	table.SetHeader([]string{"Name", "External P50", "External P99", "Internal P50", "Internal P99",
+		"Error Rate"})
+	for _, s := range results.Scripts {
+		b, ok := baseScripts[s.Name]
+		if !ok {
+			continue
+		}
+		table.Append([]string{
+			s.Name,
+			formatRatio(s.ExternalExecTime.P50Ms, b.ExternalExecTime.P50Ms),
+			formatRatio(s.ExternalExecTime.P99Ms, b.ExternalExecTime.P99Ms),
+			formatRatio(s.InternalExecTime.P50Ms, b.InternalExecTime.P50Ms),
+			formatRatio(s.InternalExecTime.P99Ms, b.InternalExecTime.P99Ms),
+			fmt.Sprintf("%.2f -> %.2f", b.ErrorRate, s.ErrorRate),
+		})
+	}
+	table.Render()
+}
@@ -17,6 +17,7 @@
  */
 
 #include <math.h>
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -77,44 +78,87 @@ XXHash64BloomFilterPB XXHash64BloomFilter::ToProto() {
   return output;
 }
 
-void XXHash64BloomFilter::SetBit(int bit_number) {
-  int byte_index = bit_number >> 3;
+void XXHash64BloomFilter::SetBit(uint64_t bit_number) {
+  uint64_t byte_index = bit_number >> 3;
   int mask = 1 << (bit_number % 8);
   buffer_[byte_index] = buffer_[byte_index] | mask;
 }
 
-bool XXHash64BloomFilter::HasBitSet(int bit_number) const {
-  int byte_index = bit_number >> 3;
+bool XXHash64BloomFilter::HasBitSet(uint64_t bit_number) const {
+  uint64_t byte_index = bit_number >> 3;
   int mask = 1 << (bit_number % 8);
   return buffer_[byte_index] & mask;
 }
 
-void XXHash64BloomFilter::Insert(std::string_view item) {
+XXHash64BloomFilter::ItemBits XXHash64BloomFilter::Hash(std::string_view item) const {
   uint64_t a = XXH64(item.data(), item.size(), seed_);
   uint64_t b = XXH64(item.data(), item.size(), a);
+  return {a, b};
+}
 
-  for (auto i = 0; i < num_hashes_; ++i) {
-    // Use int128 because the combination of uint64s below (the underyling type of XXH64) could
-    // overflow.
-    absl::uint128 x = a + i * b;
-    int bit_number = static_cast<int>(x % (buffer_.size() << 3));
-    SetBit(bit_number);
+// The bits are stepped through by adding b, rather than computing a + i * b in 128 bit arithmetic.
+// The sum wraps around at 64 bits either way, so the bits match those of serialized filters.
+void XXHash64BloomFilter::SetBits(ItemBits bits) {
+  uint64_t n = num_bits();
+  uint64_t x = bits.a;
+  for (auto i = 0; i < num_hashes_; ++i, x += bits.b) {
+    SetBit(x % n);
   }
 }
 
-bool XXHash64BloomFilter::Contains(std::string_view item) const {
-  uint64_t a = XXH64(item.data(), item.size(), seed_);
-  uint64_t b = XXH64(item.data(), item.size(), a);
-
-  for (auto i = 0; i < num_hashes_; ++i) {
-    absl::uint128 x = a + i * b;
-    int bit_number = static_cast<int>(x % (buffer_.size() << 3));
-    if (!HasBitSet(bit_number)) {
+bool XXHash64BloomFilter::HasBitsSet(ItemBits bits) const {
+  uint64_t n = num_bits();
+  uint64_t x = bits.a;
+  for (auto i = 0; i < num_hashes_; ++i, x += bits.b) {
+    if (!HasBitSet(x % n)) {
       return false;
     }
   }
   return true;
 }
 
+void XXHash64BloomFilter::PrefetchFirstBit(ItemBits bits) const {
+  __builtin_prefetch(buffer_.data() + ((bits.a % num_bits()) >> 3));
+}
+
+void XXHash64BloomFilter::Insert(std::string_view item) { SetBits(Hash(item)); }
+
+bool XXHash64BloomFilter::Contains(std::string_view item) const { return HasBitsSet(Hash(item)); }
+
+namespace {
+// The number of items hashed ahead of setting or testing their bits.
+constexpr size_t kBatchSize = 16;
+}  // namespace
+
+void XXHash64BloomFilter::InsertMany(const std::vector<std::string_view>& items) {
+  ItemBits batch[kBatchSize];
+  for (size_t begin = 0; begin < items.size(); begin += kBatchSize) {
+    size_t n = std::min(kBatchSize, items.size() - begin);
+    for (size_t i = 0; i < n; ++i) {
+      batch[i] = Hash(items[begin + i]);
+      PrefetchFirstBit(batch[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      SetBits(batch[i]);
+    }
+  }
+}
+
+void XXHash64BloomFilter::ContainsMany(const std::vector<std::string_view>& items,
+                                       std::vector<bool>* out) const {
+  out->resize(items.size());
+  ItemBits batch[kBatchSize];
+  for (size_t begin = 0; begin < items.size(); begin += kBatchSize) {
+    size_t n = std::min(kBatchSize, items.size() - begin);
+    for (size_t i = 0; i < n; ++i) {
+      batch[i] = Hash(items[begin + i]);
+      PrefetchFirstBit(batch[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      (*out)[begin + i] = HasBitsSet(batch[i]);
+    }
+  }
+}
+
 }  // namespace bloomfilter
 }  // namespace px
@@ -21,6 +21,7 @@
 #include <absl/container/flat_hash_map.h>
 #include <map>
 #include <random>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -74,10 +75,36 @@ BENCHMARK_DEFINE_F(BloomFilterBenchmark, LookupTest)(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations() * random_strs_.size());
 }
 
+// NOLINTNEXTLINE : runtime/references.
+BENCHMARK_DEFINE_F(BloomFilterBenchmark, InsertManyTest)(benchmark::State& state) {
+  std::vector<std::string_view> items(random_strs_.begin(), random_strs_.end());
+  for (auto _ : state) {
+    insert_bf_->InsertMany(items);
+  }
+  state.SetBytesProcessed(state.iterations() * random_strs_.size() * random_strs_[0].size());
+  state.SetItemsProcessed(state.iterations() * random_strs_.size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+BENCHMARK_DEFINE_F(BloomFilterBenchmark, LookupManyTest)(benchmark::State& state) {
+  std::vector<std::string_view> items(random_strs_.begin(), random_strs_.end());
+  std::vector<bool> results;
+  for (auto _ : state) {
+    lookup_bf_->ContainsMany(items, &results);
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetBytesProcessed(state.iterations() * random_strs_.size() * random_strs_[0].size());
+  state.SetItemsProcessed(state.iterations() * random_strs_.size());
+}
+
 BENCHMARK_REGISTER_F(BloomFilterBenchmark, InsertTest)
     ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
 BENCHMARK_REGISTER_F(BloomFilterBenchmark, LookupTest)
     ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+BENCHMARK_REGISTER_F(BloomFilterBenchmark, InsertManyTest)
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
+BENCHMARK_REGISTER_F(BloomFilterBenchmark, LookupManyTest)
+    ->Ranges({{1 << 10, 1 << 20}, {10, 100000}, {8, 256}});
 
 }  // namespace bloomfilter
 }  // namespace px
@@ -16,8 +16,15 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+
 #include "src/shared/bloomfilter/bloomfilter.h"
 
 namespace px {
@@ -113,5 +120,27 @@ TEST(XXHash64BloomFilter, test_create_from_proto) {
   }
 }
 
+TEST(XXHash64BloomFilter, test_insert_and_contains_many) {
+  auto bf = XXHash64BloomFilter::Create(1000, 0.0001).ConsumeValueOrDie();
+  auto single_bf = XXHash64BloomFilter::Create(1000, 0.0001).ConsumeValueOrDie();
+
+  std::vector<std::string> strs;
+  for (int i = 0; i < 100; ++i) {
+    strs.push_back(absl::StrCat("item", i));
+  }
+  std::vector<std::string_view> items(strs.begin(), strs.end());
+  bf->InsertMany(items);
+  for (const auto& item : items) {
+    single_bf->Insert(item);
+  }
+  // Batch inserts set the same bits as single inserts.
+  EXPECT_EQ(bf->ToProto().data(), single_bf->ToProto().data());
+
+  std::vector<std::string_view> lookups{"item0", "item42", "item99", "1", "2", "3"};
+  std::vector<bool> found;
+  bf->ContainsMany(lookups, &found);
+  EXPECT_THAT(found, ::testing::ElementsAre(true, true, true, false, false, false));
+}
+
 }  // namespace bloomfilter
 }  // namespace px
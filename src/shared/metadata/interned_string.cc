@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/shared/metadata/interned_string.h"
+
+#include <mutex>
+
+#include <absl/container/node_hash_set.h>
+
+namespace px {
+namespace md {
+
+namespace {
+
+struct InternedStrings {
+  std::mutex mu;
+  // Nodes are never moved, so pointers to the values stay valid as the set grows.
+  absl::node_hash_set<std::string> values;
+};
+
+InternedStrings& GetInternedStrings() {
+  static auto* interned = new InternedStrings();
+  return *interned;
+}
+
+}  // namespace
+
+const std::string* InternedString::Intern(std::string_view s) {
+  if (s.empty()) {
+    return &Empty();
+  }
+  InternedStrings& interned = GetInternedStrings();
+  std::lock_guard<std::mutex> lock(interned.mu);
+  auto it = interned.values.find(s);
+  if (it == interned.values.end()) {
+    it = interned.values.emplace(s).first;
+  }
+  return &*it;
+}
+
+size_t InternedString::NumInterned() {
+  InternedStrings& interned = GetInternedStrings();
+  std::lock_guard<std::mutex> lock(interned.mu);
+  return interned.values.size();
+}
+
+}  // namespace md
+}  // namespace px
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace px {
+namespace md {
+
+/**
+ * InternedString refers to a single shared copy of its value, so that the many objects with the
+ * same value, like the pods of a namespace or a node, don't each hold their own copy.
+ *
+ * Interned values are never freed, so only values with few distinct values over the lifetime of
+ * the process should be interned, like namespace and node names.
+ */
+class InternedString {
+ public:
+  InternedString() : str_(&Empty()) {}
+  explicit InternedString(std::string_view s) : str_(Intern(s)) {}
+
+  InternedString& operator=(std::string_view s) {
+    str_ = Intern(s);
+    return *this;
+  }
+
+  const std::string& str() const { return *str_; }
+
+  bool operator==(const InternedString& other) const { return str_ == other.str_; }
+  bool operator!=(const InternedString& other) const { return str_ != other.str_; }
+
+  /**
+   * Returns the number of distinct values that were interned.
+   */
+  static size_t NumInterned();
+
+ private:
+  static const std::string& Empty() {
+    static const std::string kEmpty;
+    return kEmpty;
+  }
+  static const std::string* Intern(std::string_view s);
+
+  const std::string* str_;
+};
+
+}  // namespace md
+}  // namespace px
@@ -18,7 +18,9 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,6 +29,7 @@
 #include <absl/container/flat_hash_set.h>
 #include "src/common/base/base.h"
 #include "src/shared/k8s/metadatapb/metadata.pb.h"
+#include "src/shared/metadata/interned_string.h"
 #include "src/shared/upid/upid.h"
 
 namespace px {
@@ -59,7 +62,7 @@ class K8sMetadataObject {
   const UID& uid() const { return uid_; }
 
   const std::string& name() const { return name_; }
-  const std::string& ns() const { return ns_; }
+  const std::string& ns() const { return ns_.str(); }
 
   int64_t start_time_ns() const { return start_time_ns_; }
   void set_start_time_ns(int64_t start_time_ns) { start_time_ns_ = start_time_ns; }
@@ -88,8 +91,7 @@ class K8sMetadataObject {
   /**
    * The namespace for this object.
    */
-
-  std::string ns_;
+  InternedString ns_;
 
   /**
    * The name which is unique in space but not time.
@@ -243,12 +245,13 @@ class PodInfo : public K8sMetadataObject {
                           stop_timestamp_ns),
         qos_class_(qos_class),
         phase_(phase),
-        conditions_(conditions),
         phase_message_(phase_message),
         phase_reason_(phase_reason),
         node_name_(node_name),
         hostname_(hostname),
-        pod_ip_(pod_ip) {}
+        pod_ip_(pod_ip) {
+    set_conditions(conditions);
+  }
 
   explicit PodInfo(const px::shared::k8s::metadatapb::PodUpdate& pod_update_info)
       : PodInfo(pod_update_info.uid(), pod_update_info.namespace_(), pod_update_info.name(),
@@ -270,22 +273,48 @@ class PodInfo : public K8sMetadataObject {
   PodPhase phase() const { return phase_; }
   void set_phase(PodPhase phase) { phase_ = phase; }
 
-  PodConditions conditions() const { return conditions_; }
-  void set_conditions(PodConditions conditions) { conditions_ = conditions; }
+  PodConditions conditions() const {
+    PodConditions conditions;
+    for (size_t i = 0; i < conditions_.size(); ++i) {
+      if (conditions_[i].has_value()) {
+        conditions.try_emplace(static_cast<PodConditionType>(i), conditions_[i].value());
+      }
+    }
+    return conditions;
+  }
+  void set_conditions(const PodConditions& conditions) {
+    conditions_.fill(std::nullopt);
+    for (const auto& [type, status] : conditions) {
+      conditions_[static_cast<size_t>(type)] = status;
+    }
+  }
 
   const std::string& phase_message() const { return phase_message_; }
   void set_phase_message(std::string_view phase_message) { phase_message_ = phase_message; }
 
-  const std::string& phase_reason() const { return phase_reason_; }
+  const std::string& phase_reason() const { return phase_reason_.str(); }
   void set_phase_reason(std::string_view phase_reason) { phase_reason_ = phase_reason; }
 
   void set_node_name(std::string_view node_name) { node_name_ = node_name; }
   void set_hostname(std::string_view hostname) { hostname_ = hostname; }
   void set_pod_ip(std::string_view pod_ip) { pod_ip_ = pod_ip; }
-  const std::string& node_name() const { return node_name_; }
-  const std::string& hostname() const { return hostname_; }
+  const std::string& node_name() const { return node_name_.str(); }
+  const std::string& hostname() const { return hostname_.str(); }
   const std::string& pod_ip() const { return pod_ip_; }
 
+  /**
+   * Drops the details that only matter while the pod is running, such as its status message and
+   * conditions, and keeps what lookups of its processes and services need. For pods that
+   * terminated a while ago.
+   */
+  void Compact() {
+    phase_message_ = std::string();
+    conditions_.fill(std::nullopt);
+    containers_ = absl::flat_hash_set<CID>();
+    compacted_ = true;
+  }
+  bool compacted() const { return compacted_; }
+
   const absl::flat_hash_set<std::string>& containers() const { return containers_; }
   const absl::flat_hash_set<std::string>& services() const { return services_; }
 
@@ -300,13 +329,18 @@ class PodInfo : public K8sMetadataObject {
   PodInfo& operator=(const PodInfo& other) = delete;
 
  private:
+  static constexpr size_t kNumPodConditionTypes =
+      static_cast<size_t>(PodConditionType::kContainersReady) + 1;
+
   PodQOSClass qos_class_;
   PodPhase phase_;
-  PodConditions conditions_;
+  bool compacted_ = false;
+  // The status of each PodConditionType that is set, indexed by the type.
+  std::array<std::optional<PodConditionStatus>, kNumPodConditionTypes> conditions_;
   // The message for why the pod is in its current status.
   std::string phase_message_;
   // A brief CamelCase message indicating details about why the pod is in this state.
-  std::string phase_reason_;
+  InternedString phase_reason_;
   /**
    * Set of containers that are running on this pod.
    *
@@ -321,8 +355,8 @@ class PodInfo : public K8sMetadataObject {
    */
   absl::flat_hash_set<UID> services_;
 
-  std::string node_name_;
-  std::string hostname_;
+  InternedString node_name_;
+  InternedString hostname_;
   std::string pod_ip_;
 };
 
@@ -339,7 +373,7 @@ class ContainerInfo {
                 std::string_view state_message, std::string_view state_reason,
                 int64_t start_time_ns, int64_t stop_time_ns = 0)
       : cid_(std::move(cid)),
-        name_(std::string(name)),
+        name_(name),
         state_(state),
         type_(type),
         state_message_(state_message),
@@ -356,7 +390,7 @@ class ContainerInfo {
                       container_update_info.stop_timestamp_ns()) {}
 
   const CID& cid() const { return cid_; }
-  const std::string& name() const { return name_; }
+  const std::string& name() const { return name_.str(); }
   ContainerType type() const { return type_; }
 
   void set_pod_id(std::string_view pod_id) { pod_id_ = pod_id; }
@@ -376,9 +410,19 @@ class ContainerInfo {
   const std::string& state_message() const { return state_message_; }
   void set_state_message(std::string_view state_message) { state_message_ = state_message; }
 
-  const std::string& state_reason() const { return state_reason_; }
+  const std::string& state_reason() const { return state_reason_.str(); }
   void set_state_reason(std::string_view state_reason) { state_reason_ = state_reason; }
 
+  /**
+   * Drops the details that only matter while the container is running, like PodInfo::Compact().
+   */
+  void Compact() {
+    state_message_ = std::string();
+    active_upids_ = absl::flat_hash_set<UPID>();
+    compacted_ = true;
+  }
+  bool compacted() const { return compacted_; }
+
   std::unique_ptr<ContainerInfo> Clone() const {
     return std::unique_ptr<ContainerInfo>(new ContainerInfo(*this));
   }
@@ -391,7 +435,7 @@ class ContainerInfo {
 
  private:
   const CID cid_;
-  const std::string name_;
+  const InternedString name_;
   UID pod_id_ = "";
 
   /**
@@ -407,10 +451,11 @@ class ContainerInfo {
    * Type of the container, such as DOCKER, CRIO.
    */
   ContainerType type_;
+  bool compacted_ = false;
   // The message for why the container is in its current state.
   std::string state_message_;
   // A more detailed message for why the container is in its current state.
-  std::string state_reason_;
+  InternedString state_reason_;
 
   /**
    * Start time of this K8s object.
@@ -103,6 +103,49 @@ TEST(PodInfo, clone) {
   EXPECT_EQ(cloned->phase_reason(), pod_info.phase_reason());
 }
 
+TEST(PodInfo, interned_strings) {
+  PodInfo pod_info("123", "pl", "pod1", PodQOSClass::kGuaranteed, PodPhase::kRunning, {}, "",
+                   "", "testnode", "testhost", "1.2.3.4");
+  PodInfo other_pod_info("456", std::string("pl"), "pod2", PodQOSClass::kGuaranteed,
+                         PodPhase::kRunning, {}, "", "", std::string("testnode"), "testhost",
+                         "1.2.3.5");
+
+  // Pods of the same namespace and node share a single copy of the names.
+  EXPECT_EQ(&pod_info.ns(), &other_pod_info.ns());
+  EXPECT_EQ(&pod_info.node_name(), &other_pod_info.node_name());
+  EXPECT_NE(&pod_info.name(), &other_pod_info.name());
+
+  other_pod_info.set_node_name("othernode");
+  EXPECT_EQ("testnode", pod_info.node_name());
+  EXPECT_EQ("othernode", other_pod_info.node_name());
+}
+
+TEST(PodInfo, compact) {
+  PodInfo pod_info("123", "pl", "pod1", PodQOSClass::kGuaranteed, PodPhase::kSucceeded,
+                   {{PodConditionType::kReady, PodConditionStatus::kTrue},
+                    {PodConditionType::kPodScheduled, PodConditionStatus::kFalse}},
+                   "pod phase message", "pod phase reason", "testnode", "testhost", "1.2.3.4");
+  pod_info.AddContainer("ABCD");
+  pod_info.AddService("service1");
+  EXPECT_THAT(pod_info.conditions(),
+              testing::UnorderedElementsAre(
+                  testing::Pair(PodConditionType::kReady, PodConditionStatus::kTrue),
+                  testing::Pair(PodConditionType::kPodScheduled, PodConditionStatus::kFalse)));
+  EXPECT_FALSE(pod_info.compacted());
+
+  pod_info.Compact();
+  EXPECT_TRUE(pod_info.compacted());
+  EXPECT_EQ("pl", pod_info.ns());
+  EXPECT_EQ("pod1", pod_info.name());
+  EXPECT_EQ("testnode", pod_info.node_name());
+  EXPECT_EQ(PodPhase::kSucceeded, pod_info.phase());
+  EXPECT_EQ("pod phase reason", pod_info.phase_reason());
+  EXPECT_EQ("", pod_info.phase_message());
+  EXPECT_THAT(pod_info.conditions(), testing::IsEmpty());
+  EXPECT_THAT(pod_info.containers(), testing::IsEmpty());
+  EXPECT_THAT(pod_info.services(), testing::UnorderedElementsAre("service1"));
+}
+
 TEST(ContainerInfo, pod_id) {
   ContainerInfo cinfo("container1", "containername", ContainerState::kRunning,
                       ContainerType::kDocker, "container state message", "container state reason",
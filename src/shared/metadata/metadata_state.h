@@ -35,11 +35,50 @@
 namespace px {
 namespace md {
 
-using K8sMetadataObjectUPtr = std::unique_ptr<K8sMetadataObject>;
-using ContainerInfoUPtr = std::unique_ptr<ContainerInfo>;
+using K8sMetadataObjectSPtr = std::shared_ptr<K8sMetadataObject>;
+using ContainerInfoSPtr = std::shared_ptr<ContainerInfo>;
 using PIDInfoUPtr = std::unique_ptr<PIDInfo>;
+using PIDInfoSPtr = std::shared_ptr<PIDInfo>;
 using AgentID = sole::uuid;
 
+/**
+ * CopyOnWrite shares a value between the metadata states of consecutive epochs. Copying the
+ * CopyOnWrite shares the value, which is only copied once a state is about to modify a value
+ * that another state still refers to. Since every state is immutable once it's published, this
+ * makes a new epoch cost proportional to what changed in it.
+ */
+template <typename T>
+class CopyOnWrite {
+ public:
+  CopyOnWrite() : value_(std::make_shared<T>()) {}
+
+  const T& operator*() const { return *value_; }
+  const T* operator->() const { return value_.get(); }
+
+  T* Mutable() {
+    // Other states only ever drop their references concurrently, so a count of one can't change.
+    if (value_.use_count() > 1) {
+      value_ = std::make_shared<T>(*value_);
+    }
+    return value_.get();
+  }
+
+ private:
+  std::shared_ptr<T> value_;
+};
+
+/**
+ * Returns the object behind ptr for modification, first cloning it if it's shared with another
+ * state, like CopyOnWrite does for values.
+ */
+template <typename T>
+T* MutableObject(std::shared_ptr<T>* ptr) {
+  if (ptr->use_count() > 1) {
+    *ptr = std::shared_ptr<T>(static_cast<T*>((*ptr)->Clone().release()));
+  }
+  return ptr->get();
+}
+
 /**
  * This class contains all kubernetes relate metadata.
  */
@@ -97,6 +136,8 @@ class K8sMetadataState : NotCopyable {
   using ServicesByNameMap = K8sEntityByNameMap;
   using NamespacesByNameMap = K8sEntityByNameMap;
   using ContainersByNameMap = absl::flat_hash_map<std::string, CID>;
+  using K8sObjectsByIDMap = absl::flat_hash_map<UID, K8sMetadataObjectSPtr>;
+  using ContainersByIDMap = absl::flat_hash_map<CID, ContainerInfoSPtr>;
   using PodsByPodIpMap = absl::flat_hash_map<std::string, UID>;
   using ServicesByServiceIpMap = absl::flat_hash_map<std::string, UID>;
 
@@ -112,7 +153,7 @@ class K8sMetadataState : NotCopyable {
 
   const std::vector<CIDRBlock>& pod_cidrs() const { return pod_cidrs_; }
 
-  const PodsByNameMap& pods_by_name() const { return pods_by_name_; }
+  const PodsByNameMap& pods_by_name() const { return *pods_by_name_; }
 
   /**
    * PodInfoByID gets an unowned pointer to the Pod. This pointer will remain active
@@ -196,11 +237,30 @@ class K8sMetadataState : NotCopyable {
 
   Status CleanupExpiredMetadata(int64_t retention_time_ns);
 
-  absl::flat_hash_map<CID, ContainerInfoUPtr>& containers_by_id() { return containers_by_id_; }
+  /**
+   * Compacts the pods and containers that stopped more than hot_retention_time_ns ago, see
+   * PodInfo::Compact(). They stay queryable, such as for the processes that ran in them, until
+   * CleanupExpiredMetadata() removes them.
+   */
+  Status CompactTerminatedMetadata(int64_t hot_retention_time_ns);
+
+  /**
+   * The containers may be shared with the states of other epochs, and must only be modified
+   * through MutableContainerInfoByID.
+   */
+  const ContainersByIDMap& containers_by_id() const { return *containers_by_id_; }
+
+  /**
+   * Returns the container for modification, or nullptr if it doesn't exist. The container is
+   * copied first if it's shared with the state of another epoch.
+   */
+  ContainerInfo* MutableContainerInfoByID(CIDView id);
   std::string DebugString(int indent_level = 0) const;
 
  private:
   const K8sMetadataObject* K8sMetadataObjectByID(UIDView id, K8sObjectType type) const;
+  // Returns the object for modification, see MutableContainerInfoByID. The object must exist.
+  K8sMetadataObject* MutableK8sMetadataObjectByID(UIDView id);
 
   // The CIDR block used for services inside the cluster.
   std::optional<CIDRBlock> service_cidr_;
@@ -209,40 +269,40 @@ class K8sMetadataState : NotCopyable {
   std::vector<CIDRBlock> pod_cidrs_;
 
   // This stores K8s native objects (services, pods, etc).
-  absl::flat_hash_map<UID, K8sMetadataObjectUPtr> k8s_objects_by_id_;
+  CopyOnWrite<K8sObjectsByIDMap> k8s_objects_by_id_;
 
   // This stores container objects, complementing k8s_objects_by_id_.
-  absl::flat_hash_map<CID, ContainerInfoUPtr> containers_by_id_;
+  CopyOnWrite<ContainersByIDMap> containers_by_id_;
 
   /**
    * Mapping of pods by name.
    */
-  PodsByNameMap pods_by_name_;
+  CopyOnWrite<PodsByNameMap> pods_by_name_;
 
   /**
    * Mapping of services by name.
    */
-  ServicesByNameMap services_by_name_;
+  CopyOnWrite<ServicesByNameMap> services_by_name_;
 
   /**
    * Mapping of namespaces by name.
    */
-  NamespacesByNameMap namespaces_by_name_;
+  CopyOnWrite<NamespacesByNameMap> namespaces_by_name_;
 
   /**
    * Mapping of containers by name.
    */
-  ContainersByNameMap containers_by_name_;
+  CopyOnWrite<ContainersByNameMap> containers_by_name_;
 
   /**
    * Mapping of Pods by host ip.
    */
-  PodsByPodIpMap pods_by_ip_;
+  CopyOnWrite<PodsByPodIpMap> pods_by_ip_;
 
   /**
    * Mapping of Services by Cluster IP.
    */
-  ServicesByServiceIpMap services_by_cluster_ip_;
+  CopyOnWrite<ServicesByServiceIpMap> services_by_cluster_ip_;
 };
 
 class AgentMetadataState : NotCopyable {
@@ -277,9 +337,9 @@ class AgentMetadataState : NotCopyable {
 
   std::shared_ptr<AgentMetadataState> CloneToShared() const;
 
-  PIDInfo* GetPIDByUPID(UPID upid) const {
-    auto it = pids_by_upid_.find(upid);
-    if (it != pids_by_upid_.end()) {
+  const PIDInfo* GetPIDByUPID(UPID upid) const {
+    auto it = pids_by_upid_->find(upid);
+    if (it != pids_by_upid_->end()) {
       return it->second.get();
     }
     return nullptr;
@@ -289,23 +349,22 @@ class AgentMetadataState : NotCopyable {
     DCHECK(pid_info != nullptr);
     DCHECK_EQ(pid_info->stop_time_ns(), 0);
 
-    pids_by_upid_[upid] = std::move(pid_info);
-    upids_.insert(upid);
+    (*pids_by_upid_.Mutable())[upid] = std::move(pid_info);
+    upids_.Mutable()->insert(upid);
   }
 
   void MarkUPIDAsStopped(UPID upid, int64_t ts) {
-    auto* pid_info = GetPIDByUPID(upid);
-    if (pid_info != nullptr) {
-      pid_info->set_stop_time_ns(ts);
-      upids_.erase(upid);
-    } else {
-      DCHECK(!upids_.contains(upid));
+    if (GetPIDByUPID(upid) == nullptr) {
+      DCHECK(!upids_->contains(upid));
+      return;
     }
+    MutableObject(&pids_by_upid_.Mutable()->at(upid))->set_stop_time_ns(ts);
+    upids_.Mutable()->erase(upid);
   }
 
-  const absl::flat_hash_map<UPID, PIDInfoUPtr>& pids_by_upid() const { return pids_by_upid_; }
+  const absl::flat_hash_map<UPID, PIDInfoSPtr>& pids_by_upid() const { return *pids_by_upid_; }
 
-  const absl::flat_hash_set<md::UPID>& upids() const { return upids_; }
+  const absl::flat_hash_set<md::UPID>& upids() const { return *upids_; }
 
   std::string DebugString(int indent_level = 0) const;
 
@@ -333,14 +392,14 @@ class AgentMetadataState : NotCopyable {
   /**
    * Mapping of PIDs by UPID for active pods on the system.
    */
-  absl::flat_hash_map<UPID, PIDInfoUPtr> pids_by_upid_;
+  CopyOnWrite<absl::flat_hash_map<UPID, PIDInfoSPtr>> pids_by_upid_;
 
   /**
    * All active UPIDs. Unlike pids_by_upid_, this does not contain stopped pids.
    * While this set could be reconstructed from pids_by_upid_,
    * it is tracked separately as a performance optimization.
    */
-  absl::flat_hash_set<md::UPID> upids_;
+  CopyOnWrite<absl::flat_hash_set<md::UPID>> upids_;
 };
 
 }  // namespace md
@@ -169,6 +169,33 @@ TEST(K8sMetadataStateTest, CloneCopiedCIDR) {
   EXPECT_EQ(service_cidr.prefix_length, state_copy->service_cidr()->prefix_length);
 }
 
+TEST(K8sMetadataStateTest, CloneSharesUnchangedObjects) {
+  K8sMetadataState state;
+
+  K8sMetadataState::ContainerUpdate container_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kContainer0UpdatePbTxt, &container_update))
+      << "Failed to parse proto";
+  K8sMetadataState::PodUpdate pod_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kPod0UpdatePbTxt, &pod_update))
+      << "Failed to parse proto";
+  ASSERT_OK(state.HandleContainerUpdate(container_update));
+  ASSERT_OK(state.HandlePodUpdate(pod_update));
+
+  auto state_copy = state.Clone();
+  EXPECT_EQ(state.PodInfoByID("pod0_uid"), state_copy->PodInfoByID("pod0_uid"));
+  EXPECT_EQ(state.ContainerInfoByID("container0_uid"),
+            state_copy->ContainerInfoByID("container0_uid"));
+
+  // Updating the pod in the copy leaves the original untouched, and the unchanged container shared.
+  pod_update.set_node_name("another_node");
+  ASSERT_OK(state_copy->HandlePodUpdate(pod_update));
+  EXPECT_NE(state.PodInfoByID("pod0_uid"), state_copy->PodInfoByID("pod0_uid"));
+  EXPECT_EQ("a_node", state.PodInfoByID("pod0_uid")->node_name());
+  EXPECT_EQ("another_node", state_copy->PodInfoByID("pod0_uid")->node_name());
+  EXPECT_EQ(state.ContainerInfoByID("container0_uid"),
+            state_copy->ContainerInfoByID("container0_uid"));
+}
+
 TEST(K8sMetadataStateTest, HandleContainerUpdate) {
   K8sMetadataState state;
 
@@ -219,7 +246,7 @@ TEST(K8sMetadataStateTest, HandlePodUpdate) {
   EXPECT_EQ("ns0", pod_info->ns());
   EXPECT_EQ(PodQOSClass::kGuaranteed, pod_info->qos_class());
   EXPECT_EQ(PodPhase::kRunning, pod_info->phase());
-  EXPECT_EQ(1, pod_info->conditions().size());
+  EXPECT_EQ(1u, pod_info->conditions().size());
   EXPECT_EQ(PodConditionStatus::kTrue, pod_info->conditions()[PodConditionType::kReady]);
   EXPECT_EQ(PodQOSClass::kGuaranteed, pod_info->qos_class());
   EXPECT_EQ(101, pod_info->start_time_ns());
@@ -421,5 +448,52 @@ TEST(K8sMetadataStateTest, CleanupExpiredMetadata) {
   }
 }
 
+TEST(K8sMetadataStateTest, CompactTerminatedMetadata) {
+  K8sMetadataState state;
+
+  K8sMetadataState::ContainerUpdate container_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kContainer0UpdatePbTxt, &container_update));
+
+  K8sMetadataState::PodUpdate pod_update;
+  ASSERT_TRUE(TextFormat::MergeFromString(kPod0UpdatePbTxt, &pod_update));
+
+  EXPECT_OK(state.HandleContainerUpdate(container_update));
+  EXPECT_OK(state.HandlePodUpdate(pod_update));
+
+  // The pod stopped long ago, but not longer than the hot retention.
+  ASSERT_OK(state.CompactTerminatedMetadata(2 * CurrentTimeNS()));
+  {
+    const PodInfo* pod_info = state.PodInfoByID("pod0_uid");
+    ASSERT_NE(pod_info, nullptr);
+    EXPECT_FALSE(pod_info->compacted());
+    EXPECT_EQ("a pod message", pod_info->phase_message());
+    EXPECT_EQ(1u, pod_info->conditions().size());
+  }
+
+  auto state_copy = state.Clone();
+  ASSERT_OK(state.CompactTerminatedMetadata(0));
+  {
+    const PodInfo* pod_info = state.PodInfoByID("pod0_uid");
+    ASSERT_NE(pod_info, nullptr);
+    EXPECT_TRUE(pod_info->compacted());
+    EXPECT_EQ("pod0", pod_info->name());
+    EXPECT_EQ("ns0", pod_info->ns());
+    EXPECT_EQ("a_node", pod_info->node_name());
+    EXPECT_EQ("a pod reason", pod_info->phase_reason());
+    EXPECT_EQ("", pod_info->phase_message());
+    EXPECT_EQ(0u, pod_info->conditions().size());
+    EXPECT_EQ("pod0_uid", state.PodIDByName({"ns0", "pod0"}));
+
+    const ContainerInfo* container_info = state.ContainerInfoByID("container0_uid");
+    ASSERT_NE(container_info, nullptr);
+    EXPECT_TRUE(container_info->compacted());
+    EXPECT_EQ("pod0_uid", container_info->pod_id());
+  }
+
+  // The states of other epochs keep their copies.
+  EXPECT_FALSE(state_copy->PodInfoByID("pod0_uid")->compacted());
+  EXPECT_EQ("a pod message", state_copy->PodInfoByID("pod0_uid")->phase_message());
+}
+
 }  // namespace md
 }  // namespace px
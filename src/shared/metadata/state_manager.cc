@@ -17,10 +17,12 @@
  */
 
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/strings/ascii.h>
 #include "src/shared/metadata/state_manager.h"
 
 namespace px {
@@ -38,6 +40,21 @@ constexpr uint64_t kEpochsBetweenObjectDeletion = 100;
  */
 constexpr uint64_t kMinObjectRetentionAfterDeathNS = 24ULL * 3600ULL * 1'000'000'000ULL;
 
+/**
+ * kObjectHotRetentionAfterDeathNS is the time in nanoseconds that pods and containers keep all
+ * their details after being deleted, before they are compacted for the rest of their retention.
+ */
+constexpr uint64_t kObjectHotRetentionAfterDeathNS = 10ULL * 60ULL * 1'000'000'000ULL;
+
+/**
+ * kEpochsBetweenPIDReconciliation is the interval between full rescans of the pids of every
+ * container, when only the containers with proc events are rescanned in between.
+ */
+constexpr uint64_t kEpochsBetweenPIDReconciliation = 12;
+
+// The length of the container ids that are in cgroup paths.
+constexpr size_t kContainerIDLength = 64;
+
 std::shared_ptr<const AgentMetadataState>
 AgentMetadataStateManagerImpl::CurrentAgentMetadataState() {
   absl::base_internal::SpinLockHolder lock(&agent_metadata_state_lock_);
@@ -52,6 +69,36 @@ std::unique_ptr<PIDStatusEvent> AgentMetadataStateManagerImpl::GetNextPIDStatusE
   return found ? std::move(event) : nullptr;
 }
 
+void AgentMetadataStateManagerImpl::ConnectProcEvents() {
+  auto listener_or = system::ProcEventListener::Create();
+  if (!listener_or.ok()) {
+    LOG(WARNING) << absl::Substitute(
+        "Proc events are unavailable, the pids of every container will be rescanned on every "
+        "update. [msg=$0]",
+        listener_or.msg());
+    return;
+  }
+  proc_events_ = listener_or.ConsumeValueOrDie();
+}
+
+std::optional<absl::flat_hash_set<CID>> AgentMetadataStateManagerImpl::ContainersToRescan(
+    const AgentMetadataState& md, uint64_t epoch_id) {
+  if (proc_events_ == nullptr) {
+    return std::nullopt;
+  }
+  // Always drain the events, so that a reconciliation doesn't leave them to the next update.
+  auto events_or = proc_events_->Drain();
+  if (!events_or.ok()) {
+    LOG(WARNING) << "Failed to read proc events: " << events_or.msg();
+    return std::nullopt;
+  }
+  const system::ProcEvents& events = events_or.ValueOrDie();
+  if (events.lost_events || epoch_id % kEpochsBetweenPIDReconciliation == 0) {
+    return std::nullopt;
+  }
+  return ContainersWithProcEvents(md, proc_parser_, events.events);
+}
+
 Status AgentMetadataStateManagerImpl::AddK8sUpdate(std::unique_ptr<ResourceUpdate> update) {
   incoming_k8s_updates_.enqueue(std::move(update));
   return Status::OK();
@@ -90,8 +137,11 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
 
   if (collects_data_) {
     // Update PID information.
-    PL_RETURN_IF_ERROR(
-        ProcessPIDUpdates(ts, proc_parser_, shadow_state.get(), md_reader_.get(), &pid_updates_));
+    std::optional<absl::flat_hash_set<CID>> cids_to_scan =
+        ContainersToRescan(*shadow_state, epoch_id);
+    PL_RETURN_IF_ERROR(ProcessPIDUpdates(
+        ts, proc_parser_, shadow_state.get(), md_reader_.get(), &pid_updates_,
+        cids_to_scan.has_value() ? &cids_to_scan.value() : nullptr));
   }
 
   // Update the pod/service CIDRs if they have been updated.
@@ -110,6 +160,8 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
   if (epoch_id % kEpochsBetweenObjectDeletion == 0) {
     PL_RETURN_IF_ERROR(
         DeleteMetadataForDeadObjects(shadow_state.get(), kMinObjectRetentionAfterDeathNS));
+    PL_RETURN_IF_ERROR(shadow_state->k8s_metadata_state()->CompactTerminatedMetadata(
+        kObjectHotRetentionAfterDeathNS));
   }
 
   // Increment epoch and update ts.
@@ -128,14 +180,61 @@ Status AgentMetadataStateManagerImpl::PerformMetadataStateUpdate() {
   return Status::OK();
 }
 
+namespace {
+
+// Returns the object an update is for, or an empty id if the update can't be coalesced.
+std::pair<ResourceUpdate::UpdateCase, std::string> UpdatedObject(const ResourceUpdate& update) {
+  switch (update.update_case()) {
+    case ResourceUpdate::kPodUpdate:
+      return {update.update_case(), update.pod_update().uid()};
+    case ResourceUpdate::kContainerUpdate:
+      return {update.update_case(), update.container_update().cid()};
+    case ResourceUpdate::kServiceUpdate:
+      return {update.update_case(), update.service_update().uid()};
+    case ResourceUpdate::kNamespaceUpdate:
+      return {update.update_case(), update.namespace_update().uid()};
+    default:
+      return {update.update_case(), ""};
+  }
+}
+
+}  // namespace
+
 Status ApplyK8sUpdates(
     int64_t ts, AgentMetadataState* state, AgentMetadataFilter* metadata_filter,
     moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>>* updates) {
-  std::unique_ptr<ResourceUpdate> update(nullptr);
+  std::unique_ptr<ResourceUpdate> next(nullptr);
   PL_UNUSED(ts);
 
+  // Every update carries the full state of its object, so only the newest update of each object
+  // is applied. It takes the place of the object's first update in the batch, so that objects are
+  // still created before the updates that refer to them (e.g. containers before their pod).
+  std::vector<std::unique_ptr<ResourceUpdate>> batch;
+  absl::flat_hash_map<std::pair<ResourceUpdate::UpdateCase, std::string>, size_t> object_idx;
+  size_t num_coalesced = 0;
+
   // Returns false when no more items.
-  while (updates->try_dequeue(update)) {
+  while (updates->try_dequeue(next)) {
+    auto object = UpdatedObject(*next);
+    if (object.second.empty()) {
+      batch.push_back(std::move(next));
+      continue;
+    }
+    auto [it, inserted] = object_idx.try_emplace(std::move(object), batch.size());
+    if (inserted) {
+      batch.push_back(std::move(next));
+      continue;
+    }
+    ++num_coalesced;
+    auto& prev = batch[it->second];
+    if (next->update_version() >= prev->update_version()) {
+      prev = std::move(next);
+    }
+  }
+  VLOG_IF(1, num_coalesced > 0) << absl::Substitute("Coalesced $0 of $1 K8s updates",
+                                                    num_coalesced, batch.size() + num_coalesced);
+
+  for (const auto& update : batch) {
     switch (update->update_case()) {
       case ResourceUpdate::kPodUpdate:
         PL_RETURN_IF_ERROR(HandlePodUpdate(update->pod_update(), state, metadata_filter));
@@ -166,8 +265,83 @@ StatusOr<UPID> InitUPID(const system::ProcParser& proc_parser, uint32_t asid, ui
   return UPID(asid, pid, pid_start_time);
 }
 
+// Whether the pids read from a container's cgroups differ from the container's active upids.
+bool PIDsChanged(const absl::flat_hash_set<UPID>& upids,
+                 const absl::flat_hash_set<uint32_t>& cgroups_pids) {
+  if (upids.size() != cgroups_pids.size()) {
+    return true;
+  }
+  for (const auto& upid : upids) {
+    if (!cgroups_pids.contains(upid.pid())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the substrings of a /proc/<pid>/cgroup file that could be container ids.
+std::vector<std::string_view> CandidateContainerIDs(std::string_view cgroups) {
+  std::vector<std::string_view> ids;
+  size_t start = 0;
+  for (size_t i = 0; i <= cgroups.size(); ++i) {
+    if (i < cgroups.size() && absl::ascii_isxdigit(cgroups[i])) {
+      continue;
+    }
+    if (i - start == kContainerIDLength) {
+      ids.push_back(cgroups.substr(start, kContainerIDLength));
+    }
+    start = i + 1;
+  }
+  return ids;
+}
+
 }  // namespace
 
+absl::flat_hash_set<CID> ContainersWithProcEvents(const AgentMetadataState& md,
+                                                  const system::ProcParser& proc_parser,
+                                                  const std::vector<system::ProcEvent>& events) {
+  absl::flat_hash_set<CID> cids;
+  if (events.empty()) {
+    return cids;
+  }
+
+  const K8sMetadataState& k8s_md_state = md.k8s_metadata_state();
+  absl::flat_hash_map<uint32_t, CIDView> cid_by_pid;
+  for (const auto& [cid, cinfo] : k8s_md_state.containers_by_id()) {
+    for (const auto& upid : cinfo->active_upids()) {
+      cid_by_pid[upid.pid()] = cid;
+    }
+  }
+
+  absl::flat_hash_set<uint32_t> unknown_pids;
+  for (const auto& event : events) {
+    auto it = cid_by_pid.find(event.pid);
+    if (it == cid_by_pid.end() && event.type == system::ProcEvent::Type::kFork) {
+      it = cid_by_pid.find(event.parent_pid);
+    }
+    if (it != cid_by_pid.end()) {
+      cids.emplace(it->second);
+    } else if (event.type != system::ProcEvent::Type::kExit) {
+      unknown_pids.insert(event.pid);
+    }
+  }
+
+  // Processes that didn't come from a known process, e.g. one started by `kubectl exec`, are
+  // matched by their cgroup. Processes that already exited are ignored.
+  for (uint32_t pid : unknown_pids) {
+    auto cgroups_or = proc_parser.GetPIDCGroups(pid);
+    if (!cgroups_or.ok()) {
+      continue;
+    }
+    for (std::string_view id : CandidateContainerIDs(cgroups_or.ValueOrDie())) {
+      if (k8s_md_state.ContainerInfoByID(id) != nullptr) {
+        cids.emplace(id);
+      }
+    }
+  }
+  return cids;
+}
+
 void ProcessContainerPIDUpdates(
     CIDView cid, int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState* md,
     absl::flat_hash_set<UPID>* upids, absl::flat_hash_set<uint32_t>* cgroups_pids,
@@ -220,9 +394,13 @@ void ProcessContainerPIDUpdates(
 Status ProcessPIDUpdates(
     int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState* md,
     CGroupMetadataReader* md_reader,
-    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates) {
+    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates,
+    const absl::flat_hash_set<CID>* cids_to_scan) {
   const auto& k8s_md_state = md->k8s_metadata_state();
 
+  // Containers are only modified when their pids change, so that the others stay shared with the
+  // previous epoch. Modifying a container can replace the map, so the ids are collected first.
+  std::vector<CID> running_cids;
   for (const auto& [cid, cinfo] : k8s_md_state->containers_by_id()) {
     if (cinfo->stop_time_ns() != 0) {
       // Ignore dead containers.
@@ -231,6 +409,11 @@ Status ProcessPIDUpdates(
       VLOG(1) << "Ignore dead container: " << cinfo->DebugString();
       continue;
     }
+    running_cids.push_back(cid);
+  }
+
+  for (const auto& cid : running_cids) {
+    const ContainerInfo* cinfo = k8s_md_state->ContainerInfoByID(cid);
 
     // For every container:
     //   1. Read the current PIDs (from cgroups).
@@ -238,7 +421,7 @@ Status ProcessPIDUpdates(
     //   3. For each new PID create metadata object and attach to container.
     //   4. For each old PID deactivate it and set time of death.
 
-    const UID& pod_id = cinfo->pod_id();
+    const UID pod_id = cinfo->pod_id();
     if (pod_id.empty()) {
       // No pod id implies it has not synced yet.
       VLOG(1) << "Ignoring Container due to missing pod: \n" << cinfo->DebugString(1);
@@ -249,7 +432,12 @@ Status ProcessPIDUpdates(
     if (pod_info->stop_time_ns() != 0) {
       VLOG(1) << absl::Substitute("Found a running container in a deleted pod [cid=$0, pod_id=$1]",
                                   cid, pod_id);
-      cinfo->set_stop_time_ns(pod_info->stop_time_ns());
+      k8s_md_state->MutableContainerInfoByID(cid)->set_stop_time_ns(pod_info->stop_time_ns());
+      continue;
+    }
+
+    // Containers without pids are always read, as there are no proc events for their initial pids.
+    if (cids_to_scan != nullptr && !cids_to_scan->contains(cid) && !cinfo->active_upids().empty()) {
       continue;
     }
 
@@ -267,16 +455,21 @@ Status ProcessPIDUpdates(
       // NOTE: Currently, MDS sends pods that do no belong to this Agent, so this is actually
       // required to avoid repeatedly printing out the warning message above.
       if (error::IsNotFound(s)) {
-        cinfo->set_stop_time_ns(ts);
-        for (const auto& upid : cinfo->active_upids()) {
+        auto* mutable_cinfo = k8s_md_state->MutableContainerInfoByID(cid);
+        mutable_cinfo->set_stop_time_ns(ts);
+        for (const auto& upid : mutable_cinfo->active_upids()) {
           md->MarkUPIDAsStopped(upid, ts);
         }
-        cinfo->mutable_active_upids()->clear();
+        mutable_cinfo->mutable_active_upids()->clear();
       }
       continue;
     }
 
-    ProcessContainerPIDUpdates(cid, ts, proc_parser, md, cinfo->mutable_active_upids(),
+    if (!PIDsChanged(cinfo->active_upids(), cgroups_active_pids)) {
+      continue;
+    }
+    ProcessContainerPIDUpdates(cid, ts, proc_parser, md,
+                               k8s_md_state->MutableContainerInfoByID(cid)->mutable_active_upids(),
                                &cgroups_active_pids, pid_updates);
   }
 
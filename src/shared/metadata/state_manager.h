@@ -30,6 +30,7 @@
 #include <absl/container/flat_hash_set.h>
 
 #include "src/common/base/base.h"
+#include "src/common/system/proc_events.h"
 #include "src/common/system/system.h"
 #include "src/shared/k8s/metadatapb/metadata.pb.h"
 #include "src/shared/metadata/cgroup_metadata_reader.h"
@@ -126,6 +127,9 @@ class AgentMetadataStateManagerImpl : public AgentMetadataStateManager {
     md_reader_ = std::make_unique<CGroupMetadataReader>(config);
     agent_metadata_state_ =
         std::make_shared<AgentMetadataState>(hostname, asid, agent_id, pod_name);
+    if (collects_data_) {
+      ConnectProcEvents();
+    }
   }
 
   AgentMetadataFilter* metadata_filter() const override { return metadata_filter_; }
@@ -156,10 +160,22 @@ class AgentMetadataStateManagerImpl : public AgentMetadataStateManager {
    */
   size_t NumPIDUpdates() const;
 
+  void ConnectProcEvents();
+
+  /**
+   * Returns the containers to rescan for PID changes, from the proc events since the last update.
+   * Returns nullopt when every container should be rescanned.
+   */
+  std::optional<absl::flat_hash_set<CID>> ContainersToRescan(const AgentMetadataState& md,
+                                                             uint64_t epoch_id);
+
   std::string pod_name_;
   system::ProcParser proc_parser_;
 
   std::unique_ptr<CGroupMetadataReader> md_reader_;
+  // Process fork/exec/exit events, which are used to only rescan the containers that changed.
+  // nullptr if the proc connector is unavailable, in which case every container is rescanned.
+  std::unique_ptr<system::ProcEventListener> proc_events_;
   // The metadata state stored here is immutable so that we can easily share a read only
   // copy across threads. The pointer is atomically updated in PerformMetadataStateUpdate(),
   // which is responsible for applying the queued updates.
@@ -192,11 +208,21 @@ Status ApplyK8sUpdates(
 void RemoveDeadPods(int64_t ts, AgentMetadataState* md, CGroupMetadataReader* md_reader);
 
 /**
- * Processes PID updates.
+ * Processes PID updates. If cids_to_scan is set, only those containers and the containers
+ * without any pids yet have their pids read.
  */
 Status ProcessPIDUpdates(
     int64_t ts, const system::ProcParser& proc_parser, AgentMetadataState*, CGroupMetadataReader*,
-    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates);
+    moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>>* pid_updates,
+    const absl::flat_hash_set<CID>* cids_to_scan = nullptr);
+
+/**
+ * Returns the containers that the processes of the proc events belong to. Processes are matched
+ * by their pid or their parent's pid, or otherwise by the container id in their cgroup.
+ */
+absl::flat_hash_set<CID> ContainersWithProcEvents(const AgentMetadataState& md,
+                                                  const system::ProcParser& proc_parser,
+                                                  const std::vector<system::ProcEvent>& events);
 
 /**
  * Deletes metadata for dead objects.
@@ -239,6 +239,36 @@ TEST_F(AgentMetadataStateTest, initialize_md_state) {
   EXPECT_EQ("pl", ns_info->ns());
 }
 
+TEST_F(AgentMetadataStateTest, coalesce_updates) {
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
+  GenerateTestUpdateEvents(&updates);
+
+  // A newer update of the container, queued after the pod that refers to it, and a stale one.
+  auto newer_update = std::make_unique<ResourceUpdate>();
+  CHECK(google::protobuf::TextFormat::MergeFromString(kUpdate1_0Pbtxt, newer_update.get()));
+  newer_update->set_update_version(2);
+  newer_update->mutable_container_update()->set_reason("newer reason");
+  updates.enqueue(std::move(newer_update));
+  auto stale_update = std::make_unique<ResourceUpdate>();
+  CHECK(google::protobuf::TextFormat::MergeFromString(kUpdate1_0Pbtxt, stale_update.get()));
+  stale_update->set_update_version(1);
+  stale_update->mutable_container_update()->set_reason("stale reason");
+  updates.enqueue(std::move(stale_update));
+
+  EXPECT_OK(ApplyK8sUpdates(2000 /*ts*/, &metadata_state_, &md_filter_, &updates));
+  EXPECT_EQ(0, updates.size_approx());
+
+  K8sMetadataState* state = metadata_state_.k8s_metadata_state();
+  auto* container_info = state->ContainerInfoByID("container_id1");
+  ASSERT_NE(nullptr, container_info);
+  EXPECT_EQ("newer reason", container_info->state_reason());
+  EXPECT_EQ("pod_id1", container_info->pod_id());
+
+  auto* pod_info = state->PodInfoByID("pod_id1");
+  ASSERT_NE(nullptr, pod_info);
+  EXPECT_THAT(pod_info->containers(), UnorderedElementsAre("container_id1"));
+}
+
 TEST_F(AgentMetadataStateTest, pid_created) {
   moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
   GenerateTestUpdateEvents(&updates);
@@ -278,6 +308,42 @@ TEST_F(AgentMetadataStateTest, pid_created) {
   EXPECT_THAT(pids_started, UnorderedElementsAre(PIDStartedEvent{pid1}, PIDStartedEvent{pid2}));
 }
 
+TEST_F(AgentMetadataStateTest, containers_with_proc_events) {
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
+  GenerateTestUpdateEvents(&updates);
+  EXPECT_OK(ApplyK8sUpdates(2000 /*ts*/, &metadata_state_, &md_filter_, &updates));
+
+  std::filesystem::path proc_path = testing::TestFilePath("src/shared/metadata/testdata/proc");
+  system::MockConfig sysconfig;
+  EXPECT_CALL(sysconfig, ClockRealTimeOffset()).WillRepeatedly(Return(128));
+  EXPECT_CALL(sysconfig, HasConfig()).WillRepeatedly(Return(true));
+  EXPECT_CALL(sysconfig, PageSize()).WillRepeatedly(Return(4096));
+  EXPECT_CALL(sysconfig, KernelTicksPerSecond()).WillRepeatedly(Return(10000000));
+  EXPECT_CALL(sysconfig, proc_path()).WillRepeatedly(ReturnRef(proc_path));
+  system::ProcParser proc_parser(sysconfig);
+
+  // The container has no pids yet, so it is read even though it has no proc events.
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<PIDStatusEvent>> events;
+  FakePIDData md_reader;
+  absl::flat_hash_set<CID> no_cids;
+  EXPECT_OK(ProcessPIDUpdates(1000, proc_parser, &metadata_state_, &md_reader, &events, &no_cids));
+  EXPECT_EQ(2, events.size_approx());
+
+  using system::ProcEvent;
+  EXPECT_THAT(ContainersWithProcEvents(metadata_state_, proc_parser, {}), ::testing::IsEmpty());
+  EXPECT_THAT(ContainersWithProcEvents(metadata_state_, proc_parser,
+                                       {ProcEvent{ProcEvent::Type::kExit, 100}}),
+              UnorderedElementsAre("container_id1"));
+  EXPECT_THAT(ContainersWithProcEvents(metadata_state_, proc_parser,
+                                       {ProcEvent{ProcEvent::Type::kFork, 300, /*parent*/ 200}}),
+              UnorderedElementsAre("container_id1"));
+  // Unknown processes without a proc entry belong to no container.
+  EXPECT_THAT(ContainersWithProcEvents(metadata_state_, proc_parser,
+                                       {ProcEvent{ProcEvent::Type::kFork, 400, /*parent*/ 1},
+                                        ProcEvent{ProcEvent::Type::kExit, 500}}),
+              ::testing::IsEmpty());
+}
+
 TEST_F(AgentMetadataStateTest, insert_into_filter) {
   moodycamel::BlockingConcurrentQueue<std::unique_ptr<ResourceUpdate>> updates;
   GenerateTestUpdateEvents(&updates);
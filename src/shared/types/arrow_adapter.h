@@ -26,6 +26,7 @@
 #include <string>
 
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "src/common/base/base.h"
@@ -51,9 +52,17 @@ inline std::shared_ptr<arrow::Array> ToArrow(const std::vector<TUDFValue>& data,
   DCHECK(mem_pool != nullptr);
 
   typename ValueTypeTraits<TUDFValue>::arrow_builder_type builder(mem_pool);
-  PL_CHECK_OK(builder.Reserve(data.size()));
-  for (const auto& v : data) {
-    builder.UnsafeAppend(v.val);
+  using native_type = decltype(TUDFValue::val);
+  if constexpr (!std::is_same_v<native_type, bool> && std::is_standard_layout_v<TUDFValue> &&
+                sizeof(TUDFValue) == sizeof(native_type)) {
+    // The values have the memory layout of their arrow values, so they're copied in one go.
+    PL_CHECK_OK(
+        builder.AppendValues(reinterpret_cast<const native_type*>(data.data()), data.size()));
+  } else {
+    PL_CHECK_OK(builder.Reserve(data.size()));
+    for (const auto& v : data) {
+      builder.UnsafeAppend(v.val);
+    }
   }
   std::shared_ptr<arrow::Array> arr;
   PL_CHECK_OK(builder.Finish(&arr));
@@ -131,12 +140,12 @@ inline int64_t GetArrowArrayBytes(const arrow::Array* arr) {
 
 template <>
 inline int64_t GetArrowArrayBytes<types::DataType::STRING>(const arrow::Array* arr) {
-  int64_t total_bytes = 0;
-  // Loop through each string in the Arrow array.
-  for (int64_t i = 0; i < arr->length(); i++) {
-    total_bytes += sizeof(char) * GetValueFromArrowArray<types::DataType::STRING>(arr, i).length();
+  if (arr->length() == 0) {
+    return 0;
   }
-  return total_bytes;
+  // The strings are stored contiguously, so their total size is the span of their offsets.
+  const auto* str_arr = static_cast<const arrow::StringArray*>(arr);
+  return sizeof(char) * (str_arr->value_offset(arr->length()) - str_arr->value_offset(0));
 }
 
 template <types::DataType T>
@@ -44,5 +44,14 @@ TEST(BinarySearchTest, find_index_lower_or_eq) {
   EXPECT_EQ(3, SearchArrowArrayLessThan<types::DataType::INT64>(col_rb1_arrow.get(), 8));
 }
 
+TEST(GetArrowArrayBytesTest, string) {
+  std::vector<types::StringValue> col = {"abc", "", "defgh", "ij"};
+  auto arr = ToArrow(col, arrow::default_memory_pool());
+
+  EXPECT_EQ(10, GetArrowArrayBytes<types::DataType::STRING>(arr.get()));
+  EXPECT_EQ(5, GetArrowArrayBytes<types::DataType::STRING>(arr->Slice(1, 2).get()));
+  EXPECT_EQ(0, GetArrowArrayBytes<types::DataType::STRING>(arr->Slice(4).get()));
+}
+
 }  // namespace types
 }  // namespace px
@@ -24,6 +24,7 @@
 
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -54,6 +55,15 @@ class ColumnWrapper {
   static SharedColumnWrapper Make(DataType data_type, size_t size);
   static SharedColumnWrapper FromArrow(const std::shared_ptr<arrow::Array>& arr);
 
+  /**
+   * Converts the column to arrow like ConvertToArrow, but without copying the values of fixed size
+   * types that have the same memory layout in arrow (INT64, UINT128, FLOAT64 and TIME64NS). The
+   * returned array then references the column's values and keeps the column alive, so the column
+   * must not be modified afterwards.
+   */
+  static std::shared_ptr<arrow::Array> AdoptToArrow(const SharedColumnWrapper& col,
+                                                    arrow::MemoryPool* mem_pool);
+
   virtual BaseValueType* UnsafeRawData() = 0;
   virtual const BaseValueType* UnsafeRawData() const = 0;
   virtual DataType data_type() const = 0;
@@ -229,7 +239,9 @@ inline SharedColumnWrapper FromArrowImpl<StringValueColumnWrapper, DataType::STR
   auto arr_casted = static_cast<arrow::StringArray*>(arr.get());
   StringValue* out_data = static_cast<StringValueColumnWrapper*>(wrapper.get())->UnsafeRawData();
   for (size_t i = 0; i < size; ++i) {
-    out_data[i] = arr_casted->GetString(i);
+    // Copy straight from the arrow buffer, without going through a temporary string.
+    auto val = arr_casted->GetView(i);
+    out_data[i].assign(val.data(), val.size());
   }
   return wrapper;
 }
@@ -288,6 +300,53 @@ inline SharedColumnWrapper ColumnWrapper::Make(DataType data_type, size_t size)
   }
 }
 
+namespace internal {
+
+// An arrow buffer over the values of a column wrapper, which it keeps alive.
+class ColumnWrapperBuffer : public arrow::Buffer {
+ public:
+  ColumnWrapperBuffer(SharedColumnWrapper col, const uint8_t* data, int64_t size)
+      : arrow::Buffer(data, size), col_(std::move(col)) {}
+
+ private:
+  SharedColumnWrapper col_;
+};
+
+template <typename TValueType>
+inline std::shared_ptr<arrow::Array> AdoptFixedSizeToArrow(const SharedColumnWrapper& col) {
+  static_assert(std::is_standard_layout_v<TValueType> &&
+                    sizeof(TValueType) == sizeof(decltype(TValueType::val)),
+                "Value type must have the memory layout of its arrow value");
+  const auto* typed_col = static_cast<const ColumnWrapperTmpl<TValueType>*>(col.get());
+  const auto* values = typed_col->UnsafeRawData();
+  auto buffer = std::make_shared<ColumnWrapperBuffer>(
+      col, reinterpret_cast<const uint8_t*>(values), col->Size() * sizeof(TValueType));
+  return std::make_shared<typename ValueTypeTraits<TValueType>::arrow_array_type>(
+      col->Size(), std::move(buffer));
+}
+
+}  // namespace internal
+
+inline std::shared_ptr<arrow::Array> ColumnWrapper::AdoptToArrow(const SharedColumnWrapper& col,
+                                                                 arrow::MemoryPool* mem_pool) {
+  if (col->Empty()) {
+    return col->ConvertToArrow(mem_pool);
+  }
+  switch (col->data_type()) {
+    case DataType::INT64:
+      return internal::AdoptFixedSizeToArrow<Int64Value>(col);
+    case DataType::FLOAT64:
+      return internal::AdoptFixedSizeToArrow<Float64Value>(col);
+    case DataType::TIME64NS:
+      return internal::AdoptFixedSizeToArrow<Time64NSValue>(col);
+    case DataType::UINT128:
+      return internal::AdoptFixedSizeToArrow<UInt128Value>(col);
+    default:
+      // Booleans are bit packed and strings are stored contiguously in arrow, so they're copied.
+      return col->ConvertToArrow(mem_pool);
+  }
+}
+
 template <class TValueType>
 inline void ColumnWrapper::Append(TValueType val) {
   CHECK_EQ(data_type(), ValueTypeTraits<TValueType>::data_type)
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/shared/types/column_wrapper_pool.h"
+
+#include <utility>
+
+namespace px {
+namespace types {
+
+ColumnWrapperPool* ColumnWrapperPool::Global() {
+  static auto* pool = new ColumnWrapperPool();
+  return pool;
+}
+
+SharedColumnWrapper ColumnWrapperPool::Acquire(DataType data_type, size_t capacity) {
+  SharedColumnWrapper col;
+  {
+    absl::MutexLock lock(&lock_);
+    auto it = pooled_.find(data_type);
+    if (it != pooled_.end() && !it->second.empty()) {
+      col = std::move(it->second.back());
+      it->second.pop_back();
+      ++num_reused_;
+    }
+  }
+  if (col == nullptr) {
+    col = ColumnWrapper::Make(data_type, 0);
+  }
+  col->Reserve(capacity);
+  return col;
+}
+
+bool ColumnWrapperPool::Release(SharedColumnWrapper col) {
+  if (col == nullptr || col.use_count() != 1 || col->Size() > max_pooled_size_) {
+    return false;
+  }
+  // Nothing else references the column, so it can be cleared without holding the lock.
+  col->Clear();
+  {
+    absl::MutexLock lock(&lock_);
+    auto& pooled = pooled_[col->data_type()];
+    if (pooled.size() >= max_pooled_per_type_) {
+      return false;
+    }
+    pooled.push_back(std::move(col));
+  }
+  return true;
+}
+
+size_t ColumnWrapperPool::NumPooled(DataType data_type) const {
+  absl::MutexLock lock(&lock_);
+  auto it = pooled_.find(data_type);
+  return it == pooled_.end() ? 0 : it->second.size();
+}
+
+int64_t ColumnWrapperPool::num_reused() const {
+  absl::MutexLock lock(&lock_);
+  return num_reused_;
+}
+
+}  // namespace types
+}  // namespace px
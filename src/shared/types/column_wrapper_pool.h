@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/column_wrapper.h"
+
+namespace px {
+namespace types {
+
+/**
+ * ColumnWrapperPool recycles the column wrappers that nothing references anymore, so that
+ * producers that repeatedly fill columns of the same types (e.g. Stirling's data tables) reuse
+ * their allocations instead of growing new ones. The pool is bounded: it holds at most
+ * max_pooled_per_type columns of each type, and drops columns larger than max_pooled_size rows.
+ */
+class ColumnWrapperPool : public NotCopyable {
+ public:
+  static constexpr size_t kDefaultMaxPooledPerType = 256;
+  static constexpr size_t kDefaultMaxPooledSize = 16 * 1024;
+
+  explicit ColumnWrapperPool(size_t max_pooled_per_type = kDefaultMaxPooledPerType,
+                             size_t max_pooled_size = kDefaultMaxPooledSize)
+      : max_pooled_per_type_(max_pooled_per_type), max_pooled_size_(max_pooled_size) {}
+
+  /**
+   * The process wide pool.
+   */
+  static ColumnWrapperPool* Global();
+
+  /**
+   * Returns an empty column of the given type, with room for at least capacity values.
+   */
+  SharedColumnWrapper Acquire(DataType data_type, size_t capacity);
+
+  /**
+   * Clears the column and keeps it for a later Acquire, unless something else still references
+   * it (e.g. an arrow array from ColumnWrapper::AdoptToArrow) or the pool is full.
+   * @return whether the column was pooled.
+   */
+  bool Release(SharedColumnWrapper col);
+
+  size_t NumPooled(DataType data_type) const;
+  int64_t num_reused() const;
+
+ private:
+  const size_t max_pooled_per_type_;
+  const size_t max_pooled_size_;
+
+  mutable absl::Mutex lock_;
+  absl::flat_hash_map<DataType, std::vector<SharedColumnWrapper>> pooled_ ABSL_GUARDED_BY(lock_);
+  int64_t num_reused_ ABSL_GUARDED_BY(lock_) = 0;
+};
+
+}  // namespace types
+}  // namespace px
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "src/shared/types/column_wrapper_pool.h"
+
+namespace px {
+namespace types {
+
+TEST(ColumnWrapperPoolTest, ReusesReleasedColumns) {
+  ColumnWrapperPool pool(/* max_pooled_per_type */ 1);
+
+  auto col = pool.Acquire(DataType::INT64, 16);
+  EXPECT_TRUE(col->Empty());
+  col->Append<Int64Value>(1);
+  const auto* data = col->UnsafeRawData();
+  EXPECT_TRUE(pool.Release(std::move(col)));
+  EXPECT_EQ(1, pool.NumPooled(DataType::INT64));
+  // The pool is full.
+  EXPECT_FALSE(pool.Release(ColumnWrapper::Make(DataType::INT64, 0)));
+
+  // The released column comes back cleared, with its allocation.
+  auto reused = pool.Acquire(DataType::INT64, 16);
+  EXPECT_TRUE(reused->Empty());
+  EXPECT_EQ(data, reused->UnsafeRawData());
+  EXPECT_EQ(1, pool.num_reused());
+  EXPECT_EQ(0, pool.NumPooled(DataType::INT64));
+
+  // Other types get their own columns.
+  auto str_col = pool.Acquire(DataType::STRING, 16);
+  EXPECT_EQ(DataType::STRING, str_col->data_type());
+  EXPECT_EQ(1, pool.num_reused());
+}
+
+TEST(ColumnWrapperPoolTest, KeepsReferencedColumns) {
+  ColumnWrapperPool pool(/* max_pooled_per_type */ 4, /* max_pooled_size */ 2);
+
+  auto col = pool.Acquire(DataType::INT64, 2);
+  col->Append<Int64Value>(1);
+  auto arr = ColumnWrapper::AdoptToArrow(col, arrow::default_memory_pool());
+  // The array still references the column, so it must not be cleared and reused.
+  EXPECT_FALSE(pool.Release(std::move(col)));
+  EXPECT_EQ(1, static_cast<arrow::Int64Array*>(arr.get())->Value(0));
+
+  auto big_col = pool.Acquire(DataType::INT64, 3);
+  for (int i = 0; i < 3; ++i) {
+    big_col->Append<Int64Value>(i);
+  }
+  EXPECT_FALSE(pool.Release(std::move(big_col)));
+  EXPECT_EQ(0, pool.NumPooled(DataType::INT64));
+}
+
+}  // namespace types
+}  // namespace px
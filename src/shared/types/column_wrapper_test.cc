@@ -283,5 +283,40 @@ TEST(ColumnWrapperTest, MoveIndexes) {
   }
 }
 
+TEST(ColumnWrapperTest, AdoptToArrow) {
+  auto* pool = arrow::default_memory_pool();
+  std::vector<Int64Value> ints = {1, 2, 3};
+  std::vector<Time64NSValue> times = {10, 20, 30};
+  std::vector<StringValue> strs = {"a", "b", "c"};
+
+  SharedColumnWrapper int_col = std::make_shared<Int64ValueColumnWrapper>(ints);
+  auto int_arr = ColumnWrapper::AdoptToArrow(int_col, pool);
+  EXPECT_TRUE(int_arr->Equals(ToArrow(ints, pool)));
+  // Fixed size values aren't copied, and the array keeps the column alive.
+  EXPECT_EQ(static_cast<arrow::Int64Array*>(int_arr.get())->raw_values(),
+            reinterpret_cast<const int64_t*>(int_col->UnsafeRawData()));
+  EXPECT_EQ(2, int_col.use_count());
+  int_col.reset();
+  EXPECT_EQ(3, static_cast<arrow::Int64Array*>(int_arr.get())->Value(2));
+
+  SharedColumnWrapper time_col = std::make_shared<Time64NSValueColumnWrapper>(times);
+  EXPECT_TRUE(ColumnWrapper::AdoptToArrow(time_col, pool)->Equals(ToArrow(times, pool)));
+
+  std::vector<UInt128Value> upids = {UInt128Value(1, 2), UInt128Value(3, 4)};
+  SharedColumnWrapper upid_col = std::make_shared<UInt128ValueColumnWrapper>(upids);
+  auto upid_arr = ColumnWrapper::AdoptToArrow(upid_col, pool);
+  EXPECT_TRUE(upid_arr->Equals(ToArrow(upids, pool)));
+  EXPECT_EQ(absl::MakeUint128(3, 4), static_cast<arrow::UInt128Array*>(upid_arr.get())->Value(1));
+  EXPECT_EQ(2, upid_col.use_count());
+
+  // Strings are copied.
+  SharedColumnWrapper str_col = std::make_shared<StringValueColumnWrapper>(strs);
+  EXPECT_TRUE(ColumnWrapper::AdoptToArrow(str_col, pool)->Equals(ToArrow(strs, pool)));
+  EXPECT_EQ(1, str_col.use_count());
+
+  SharedColumnWrapper empty_col = ColumnWrapper::Make(DataType::FLOAT64, 0);
+  EXPECT_EQ(0, ColumnWrapper::AdoptToArrow(empty_col, pool)->length());
+}
+
 }  // namespace types
 }  // namespace px
@@ -123,6 +123,11 @@ int main(int argc, char** argv) {
 
   PL_EXIT_IF_ERROR(ParseArgs(argc, argv));
 
+  // The stack traces are printed as they come, there is no table store to resolve repeats.
+  FLAGS_stirling_profiler_elide_repeated_stack_traces = false;
+  // Only the stack traces of the target pid are printed.
+  FLAGS_stirling_profiler_self_profile = false;
+
   // Make Stirling.
   auto registry = std::make_unique<SourceRegistry>();
   registry->RegisterOrDie<PerfProfileConnector>();
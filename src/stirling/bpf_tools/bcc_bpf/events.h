@@ -0,0 +1,87 @@
+/*
+ * This code runs using bpf in the Linux kernel.
+ * Copyright 2018- The Pixie Authors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+// LINT_C_FILE: Do not remove this line. It ensures cpplint treats this as a C file.
+
+#pragma once
+
+// Event outputs through which BPF programs export data to user-space.
+//
+// When the BPF code is preprocessed with ENABLE_RINGBUF (see the defines of pl_bpf_cc_resource),
+// the outputs are BPF ring buffers (Linux 5.8+), which are shared by all CPUs and keep the events
+// in order. Otherwise they are the classic per-CPU perf buffers.
+//
+// The size of a ring buffer is fixed when the BPF code is compiled, so BCCWrapper passes it as
+// the <name>_ringbuf_pages define (see BCCWrapper::RingBufferCFlags()).
+//
+// A ring buffer does not report lost events the way a perf buffer does, so every failed
+// output is counted in the <name>_ringbuf_loss array, which BCCWrapper reports through the
+// same loss callback as the perf buffers.
+
+#ifdef ENABLE_RINGBUF
+
+#define BPF_EVENT_OUTPUT(name)                    \
+  BPF_RINGBUF_OUTPUT(name, name##_ringbuf_pages); \
+  BPF_ARRAY(name##_ringbuf_loss, uint64_t, 1)
+
+#define BPF_EVENT_RECORD_LOSS(name)                             \
+  do {                                                          \
+    int loss_idx = 0;                                           \
+    uint64_t* num_lost = name##_ringbuf_loss.lookup(&loss_idx); \
+    if (num_lost != NULL) {                                     \
+      __sync_fetch_and_add(num_lost, 1);                        \
+    }                                                           \
+  } while (0)
+
+// Copies size bytes at data into the output.
+#define BPF_EVENT_SUBMIT(ctx, name, data, size)    \
+  do {                                             \
+    if (name.ringbuf_output(data, size, 0) != 0) { \
+      BPF_EVENT_RECORD_LOSS(name);                 \
+    }                                              \
+  } while (0)
+
+// Points event to zeroed space for one event directly in the output, so that the event is not
+// copied once it's filled in. The fallback is only used with perf buffers.
+// Every reserved event must be passed to BPF_EVENT_COMMIT(); event is NULL if the output is full.
+#define BPF_EVENT_RESERVE(name, event, fallback)  \
+  do {                                            \
+    event = name.ringbuf_reserve(sizeof(*event)); \
+    if (event == NULL) {                          \
+      BPF_EVENT_RECORD_LOSS(name);                \
+    } else {                                      \
+      __builtin_memset(event, 0, sizeof(*event)); \
+    }                                             \
+  } while (0)
+
+#define BPF_EVENT_COMMIT(ctx, name, event) name.ringbuf_submit(event, 0)
+
+#else
+
+#define BPF_EVENT_OUTPUT(name) BPF_PERF_OUTPUT(name)
+
+#define BPF_EVENT_SUBMIT(ctx, name, data, size) name.perf_submit(ctx, data, size)
+
+#define BPF_EVENT_RESERVE(name, event, fallback) event = (fallback)
+
+#define BPF_EVENT_COMMIT(ctx, name, event) name.perf_submit(ctx, event, sizeof(*event))
+
+#endif
@@ -18,20 +18,45 @@
 
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 
+#include <fcntl.h>
+#include <linux/bpf.h>
 #include <linux/perf_event.h>
 #include <sys/mount.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <magic_enum.hpp>
 
 #include "src/common/base/base.h"
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/config.h"
+#include "src/common/system/cpu_affinity.h"
 #include "src/stirling/bpf_tools/task_struct_resolver.h"
 #include "src/stirling/utils/linux_headers.h"
 
+DEFINE_bool(stirling_perf_buffer_reader_thread, false,
+            "If true, BPF connectors drain their perf and ring buffers from a dedicated thread, "
+            "instead of only on their sampling period.");
+DEFINE_string(stirling_bpf_cache_dir, gflags::StringFromEnv("PL_STIRLING_BPF_CACHE_DIR", ""),
+              "If set, the BPF setup results that only depend on the host's kernel, such as the "
+              "resolved task_struct offsets, are persisted to this directory, so that they can "
+              "be reused after a restart.");
+DEFINE_bool(stirling_perf_buffer_numa_readers,
+            gflags::BoolFromEnv("PL_STIRLING_PERF_BUFFER_NUMA_READERS", false),
+            "If true, and the perf buffer reader thread is enabled on a host with several NUMA "
+            "nodes, each node's share of the perf buffers is read by a thread on that node.");
+
 namespace px {
 namespace stirling {
 namespace bpf_tools {
@@ -82,6 +107,83 @@ StatusOr<utils::TaskStructOffsets> ResolveTaskStructOffsets() {
   return offsets_status;
 }
 
+StatusOr<utils::TaskStructOffsets> LoadTaskStructOffsets(const std::filesystem::path& path,
+                                                         std::string_view kernel_build_id) {
+  PL_RETURN_IF_ERROR(fs::Exists(path));
+  PL_ASSIGN_OR_RETURN(std::string contents, ReadFileToString(path));
+  return utils::ParseTaskStructOffsets(contents, kernel_build_id);
+}
+
+Status PersistTaskStructOffsets(const std::filesystem::path& path, std::string_view kernel_build_id,
+                                const utils::TaskStructOffsets& offsets) {
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(path.parent_path()));
+
+  // Write to a temporary file first, so that a crash can't leave a truncated file behind.
+  std::filesystem::path tmp_path = absl::StrCat(path.string(), ".tmp");
+  PL_RETURN_IF_ERROR(
+      WriteFileFromString(tmp_path, utils::SerializeTaskStructOffsets(kernel_build_id, offsets)));
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    return error::Internal("Could not rename $0 to $1: $2", tmp_path.string(), path.string(),
+                           ec.message());
+  }
+  return Status::OK();
+}
+
+// Without BTF, resolving the offsets compiles and runs a BPF program, so it is done once per
+// process, and the result is shared by all BCCWrappers. If --stirling_bpf_cache_dir is set, the
+// result is also reused across restarts on the same kernel.
+StatusOr<utils::TaskStructOffsets> GetResolvedTaskStructOffsets() {
+  static std::mutex mu;
+  static std::optional<utils::TaskStructOffsets> resolved_offsets;
+
+  std::lock_guard<std::mutex> lock(mu);
+  if (resolved_offsets.has_value()) {
+    return resolved_offsets.value();
+  }
+
+  std::filesystem::path cache_path;
+  const std::string kernel_build_id = utils::KernelBuildID();
+  if (!FLAGS_stirling_bpf_cache_dir.empty() && !kernel_build_id.empty()) {
+    cache_path = std::filesystem::path(FLAGS_stirling_bpf_cache_dir) / "task_struct_offsets";
+    StatusOr<utils::TaskStructOffsets> offsets_or =
+        LoadTaskStructOffsets(cache_path, kernel_build_id);
+    if (offsets_or.ok()) {
+      resolved_offsets = offsets_or.ValueOrDie();
+      LOG(INFO) << absl::Substitute("Task struct offsets from $0: $1", cache_path.string(),
+                                    resolved_offsets->ToString());
+      return resolved_offsets.value();
+    }
+    VLOG(1) << absl::Substitute("No usable cached task_struct offsets: $0", offsets_or.msg());
+  }
+
+  LOG(INFO) << "Resolving task_struct offsets.";
+
+  // Prefer the kernel's BTF, which has the exact layout, over probing task_struct's memory.
+  utils::TaskStructOffsets offsets;
+  StatusOr<utils::TaskStructOffsets> btf_offsets_or = utils::ResolveTaskStructOffsetsFromBTF();
+  if (btf_offsets_or.ok()) {
+    offsets = btf_offsets_or.ValueOrDie();
+  } else {
+    VLOG(1) << absl::Substitute("Could not read task_struct offsets from BTF: $0",
+                                btf_offsets_or.msg());
+    PL_ASSIGN_OR_RETURN(offsets, ResolveTaskStructOffsets());
+  }
+
+  LOG(INFO) << absl::Substitute("Task struct offsets: group_leader=$0 real_start_time=$1",
+                                offsets.group_leader_offset, offsets.real_start_time_offset);
+
+  if (!cache_path.empty()) {
+    Status s = PersistTaskStructOffsets(cache_path, kernel_build_id, offsets);
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Could not persist task_struct offsets to $0: $1",
+                                                 cache_path.string(), s.msg());
+  }
+
+  resolved_offsets = offsets;
+  return offsets;
+}
+
 StatusOr<utils::TaskStructOffsets> GetTaskStructOffsets(bool always_infer_task_struct_offsets) {
   // Defaults to zero offsets, which tells BPF not to use the offset overrides.
   // If the values are changed (as they are if ResolveTaskStructOffsets() is run),
@@ -98,12 +200,7 @@ StatusOr<utils::TaskStructOffsets> GetTaskStructOffsets(bool always_infer_task_s
   // local headers, and for testing purposes.
   bool potentially_mismatched_headers = utils::g_packaged_headers_installed;
   if (potentially_mismatched_headers || always_infer_task_struct_offsets) {
-    LOG(INFO) << "Resolving task_struct offsets.";
-
-    PL_ASSIGN_OR_RETURN(offsets, ResolveTaskStructOffsets());
-
-    LOG(INFO) << absl::Substitute("Task struct offsets: group_leader=$0 real_start_time=$1",
-                                  offsets.group_leader_offset, offsets.real_start_time_offset);
+    PL_ASSIGN_OR_RETURN(offsets, GetResolvedTaskStructOffsets());
   }
 
   return offsets;
@@ -268,6 +365,59 @@ Status BCCWrapper::AttachXDP(const std::string& dev_name, const std::string& fn_
   return Status::OK();
 }
 
+namespace {
+
+// Issues BPF_PROG_ATTACH or BPF_PROG_DETACH for a cgroup program.
+int CGroupProgramOp(int cmd, int prog_fd, int cgroup_fd, bpf_attach_type attach_type,
+                    uint32_t flags) {
+  union bpf_attr attr = {};
+  attr.target_fd = cgroup_fd;
+  attr.attach_bpf_fd = prog_fd;
+  attr.attach_type = attach_type;
+  attr.attach_flags = flags;
+  return syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+}
+
+}  // namespace
+
+Status BCCWrapper::AttachCGroupProgram(const CGroupProgramSpec& spec) {
+  VLOG(1) << "Attaching cgroup program " << spec.ToString();
+  int prog_fd = -1;
+  PL_RETURN_IF_ERROR(bpf_.load_func(std::string(spec.probe_fn), BPF_PROG_TYPE_CGROUP_SKB, prog_fd));
+
+  int cgroup_fd = open(spec.cgroup_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (cgroup_fd < 0) {
+    return error::Internal("Unable to open cgroup $0, errno: $1", spec.cgroup_path.string(), errno);
+  }
+  if (CGroupProgramOp(BPF_PROG_ATTACH, prog_fd, cgroup_fd, spec.attach_type,
+                      BPF_F_ALLOW_MULTI) < 0) {
+    int attach_errno = errno;
+    close(cgroup_fd);
+    return error::Internal("Unable to attach cgroup program $0, errno: $1", spec.ToString(),
+                           attach_errno);
+  }
+  cgroup_programs_.push_back({spec, prog_fd, cgroup_fd});
+  return Status::OK();
+}
+
+Status BCCWrapper::AttachCGroupPrograms(const ArrayView<CGroupProgramSpec>& specs) {
+  for (const CGroupProgramSpec& spec : specs) {
+    PL_RETURN_IF_ERROR(AttachCGroupProgram(spec));
+  }
+  return Status::OK();
+}
+
+void BCCWrapper::DetachCGroupPrograms() {
+  for (const AttachedCGroupProgram& p : cgroup_programs_) {
+    if (CGroupProgramOp(BPF_PROG_DETACH, p.prog_fd, p.cgroup_fd, p.spec.attach_type, 0) < 0) {
+      LOG(ERROR) << absl::Substitute("Unable to detach cgroup program $0, errno: $1",
+                                     p.spec.ToString(), errno);
+    }
+    close(p.cgroup_fd);
+  }
+  cgroup_programs_.clear();
+}
+
 // TODO(PL-1294): This can fail in rare cases. See the cited issue. Find the root cause.
 Status BCCWrapper::DetachKProbe(const KProbeSpec& probe) {
   VLOG(1) << "Detaching kprobe: " << probe.ToString();
@@ -322,24 +472,105 @@ void BCCWrapper::DetachTracepoints() {
   tracepoints_.clear();
 }
 
-Status BCCWrapper::OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie) {
+namespace {
+
+// Perf buffers and ring buffers must be sized to a power of 2 number of pages.
+int NumBufferPages(int size_bytes) {
   const int kPageSizeBytes = system::Config::GetInstance().PageSize();
-  int num_pages = IntRoundUpDivide(perf_buffer.size_bytes, kPageSizeBytes);
+  return IntRoundUpToPow2(IntRoundUpDivide(size_bytes, kPageSizeBytes));
+}
 
-  // Perf buffers must be sized to a power of 2.
-  num_pages = IntRoundUpToPow2(num_pages);
+// A ring buffer is shared by all CPUs, so it gets the space that the per-CPU perf buffers of the
+// same spec would have had in total.
+int NumRingBufferPages(int size_bytes) {
+  // The kernel caps the size of a ring buffer below 4GiB, and the size must be a power of 2.
+  constexpr int64_t kMaxRingBufferBytes = 1LL << 30;
+  static const int64_t kNumCPUs = std::max(1U, std::thread::hardware_concurrency());
+  const int64_t kPageSizeBytes = system::Config::GetInstance().PageSize();
+  int64_t total_bytes = std::min(size_bytes * kNumCPUs, kMaxRingBufferBytes);
+  return static_cast<int>(IntRoundUpToPow2(IntRoundUpDivide(total_bytes, kPageSizeBytes)));
+}
+
+}  // namespace
+
+Status BCCWrapper::OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie) {
+  const int kPageSizeBytes = system::Config::GetInstance().PageSize();
+  int num_pages = NumBufferPages(perf_buffer.size_bytes);
 
   VLOG(1) << absl::Substitute("Opening perf buffer: $0 [requested_size=$1 num_pages=$2 size=$3]",
                               perf_buffer.name, perf_buffer.size_bytes, num_pages,
                               num_pages * kPageSizeBytes);
-  PL_RETURN_IF_ERROR(bpf_.open_perf_buffer(std::string(perf_buffer.name),
-                                           perf_buffer.probe_output_fn, perf_buffer.probe_loss_fn,
-                                           cb_cookie, num_pages));
+  if (reader_thread_enabled_) {
+    if (reader_thread_running_) {
+      return error::FailedPrecondition("Can't open perf buffer $0 after the reader thread started.",
+                                       perf_buffer.name);
+    }
+    auto queue = std::make_unique<EventQueue>();
+    queue->spec = perf_buffer;
+    queue->cb_cookie = cb_cookie;
+    if (UseNUMAReaders()) {
+      PL_RETURN_IF_ERROR(OpenNUMAPerfBuffer(std::string(perf_buffer.name), queue.get(), num_pages));
+    } else {
+      PL_RETURN_IF_ERROR(bpf_.open_perf_buffer(std::string(perf_buffer.name),
+                                               &EventQueue::HandleEvent, &EventQueue::HandleLoss,
+                                               queue.get(), num_pages));
+    }
+    event_queues_.push_back(std::move(queue));
+  } else {
+    PL_RETURN_IF_ERROR(bpf_.open_perf_buffer(std::string(perf_buffer.name),
+                                             perf_buffer.probe_output_fn,
+                                             perf_buffer.probe_loss_fn, cb_cookie, num_pages));
+  }
   perf_buffers_.push_back(perf_buffer);
   ++num_open_perf_buffers_;
   return Status::OK();
 }
 
+bool BCCWrapper::UseNUMAReaders() {
+  if (!FLAGS_stirling_perf_buffer_numa_readers) {
+    return false;
+  }
+  if (numa_node_cpus_.empty()) {
+    auto node_cpus = system::NUMANodeCPUs(system::Config::GetInstance().sysfs_path());
+    if (!node_cpus.ok()) {
+      LOG(WARNING) << absl::Substitute("Could not read the NUMA topology: $0",
+                                       node_cpus.msg());
+      FLAGS_stirling_perf_buffer_numa_readers = false;
+      return false;
+    }
+    numa_node_cpus_ = node_cpus.ConsumeValueOrDie();
+  }
+  return numa_node_cpus_.size() > 1;
+}
+
+Status BCCWrapper::OpenNUMAPerfBuffer(const std::string& name, EventQueue* queue,
+                                      int num_pages) {
+  int map_fd = bpf_.get_table(name).get_fd();
+  if (map_fd < 0) {
+    return error::Internal("Could not find perf buffer $0.", name);
+  }
+  // The same as bcc's BPFPerfBuffer, except that the readers are kept by node. The kernel already
+  // allocates each CPU's ring on the CPU's node, so only the reads have to be moved there.
+  for (const auto& [node, cpus] : numa_node_cpus_) {
+    for (int cpu : cpus) {
+      auto* reader = static_cast<perf_reader*>(
+          bpf_open_perf_buffer(&EventQueue::HandleEvent, &EventQueue::HandleLoss, queue,
+                               /* pid */ -1, cpu, num_pages));
+      if (reader == nullptr) {
+        return error::Internal("Could not open perf buffer $0 on CPU $1.", name, cpu);
+      }
+      numa_perf_readers_[node].push_back(reader);
+      int reader_fd = perf_reader_fd(reader);
+      if (bpf_update_elem(map_fd, &cpu, &reader_fd, 0) != 0) {
+        return error::Internal("Could not attach perf buffer $0 on CPU $1 [errno=$2].", name, cpu,
+                               errno);
+      }
+    }
+  }
+  numa_perf_buffers_.insert(name);
+  return Status::OK();
+}
+
 Status BCCWrapper::OpenPerfBuffers(const ArrayView<PerfBufferSpec>& perf_buffers, void* cb_cookie) {
   for (const PerfBufferSpec& p : perf_buffers) {
     PL_RETURN_IF_ERROR(OpenPerfBuffer(p, cb_cookie));
@@ -349,7 +580,10 @@ Status BCCWrapper::OpenPerfBuffers(const ArrayView<PerfBufferSpec>& perf_buffers
 
 Status BCCWrapper::ClosePerfBuffer(const PerfBufferSpec& perf_buffer) {
   VLOG(1) << "Closing perf buffer: " << perf_buffer.name;
-  PL_RETURN_IF_ERROR(bpf_.close_perf_buffer(std::string(perf_buffer.name)));
+  // The readers of NUMA perf buffers are freed together, by ClosePerfBuffers().
+  if (!numa_perf_buffers_.contains(std::string(perf_buffer.name))) {
+    PL_RETURN_IF_ERROR(bpf_.close_perf_buffer(std::string(perf_buffer.name)));
+  }
   --num_open_perf_buffers_;
   return Status::OK();
 }
@@ -360,6 +594,247 @@ void BCCWrapper::ClosePerfBuffers() {
     LOG_IF(ERROR, !res.ok()) << res.msg();
   }
   perf_buffers_.clear();
+  for (auto& [node, readers] : numa_perf_readers_) {
+    for (perf_reader* reader : readers) {
+      perf_reader_free(reader);
+    }
+  }
+  numa_perf_readers_.clear();
+  numa_perf_buffers_.clear();
+}
+
+bool BCCWrapper::RingBuffersSupported() {
+  constexpr uint32_t kLinux5p8VersionCode = 329728;
+  StatusOr<utils::KernelVersion> kernel_version = utils::GetKernelVersion();
+  return kernel_version.ok() && kernel_version.ValueOrDie().code() >= kLinux5p8VersionCode;
+}
+
+std::vector<std::string> BCCWrapper::RingBufferCFlags(
+    const ArrayView<PerfBufferSpec>& ring_buffers) {
+  std::vector<std::string> cflags;
+  for (const PerfBufferSpec& p : ring_buffers) {
+    cflags.push_back(
+        absl::Substitute("-D$0_ringbuf_pages=$1", p.name, NumRingBufferPages(p.size_bytes)));
+  }
+  return cflags;
+}
+
+int BCCWrapper::HandleRingBufferEvent(void* ctx, void* data, size_t data_size) {
+  auto* ring_buffer = static_cast<RingBuffer*>(ctx);
+  if (ring_buffer->queue != nullptr) {
+    EventQueue::HandleEvent(ring_buffer->queue, data, static_cast<int>(data_size));
+    return 0;
+  }
+  ring_buffer->spec.probe_output_fn(ring_buffer->cb_cookie, data, static_cast<int>(data_size));
+  return 0;
+}
+
+Status BCCWrapper::OpenRingBuffers(const ArrayView<PerfBufferSpec>& ring_buffers,
+                                   void* cb_cookie) {
+  if (reader_thread_running_) {
+    return error::FailedPrecondition("Can't open ring buffers after the reader thread started.");
+  }
+  for (const PerfBufferSpec& p : ring_buffers) {
+    VLOG(1) << absl::Substitute("Opening ring buffer: $0 [requested_size=$1 num_pages=$2]", p.name,
+                                p.size_bytes, NumRingBufferPages(p.size_bytes));
+    int map_fd = bpf_.get_table(p.name).get_fd();
+    if (map_fd < 0) {
+      return error::Internal("Could not find ring buffer $0.", p.name);
+    }
+
+    auto ring_buffer = std::make_unique<RingBuffer>();
+    ring_buffer->spec = p;
+    ring_buffer->cb_cookie = cb_cookie;
+    if (reader_thread_enabled_) {
+      // Ring buffer losses are counted by the BPF code, and are still reported from
+      // PollPerfBuffers(), so the queue only carries the events.
+      auto queue = std::make_unique<EventQueue>();
+      queue->spec = p;
+      queue->spec.probe_loss_fn = nullptr;
+      queue->cb_cookie = cb_cookie;
+      ring_buffer->queue = queue.get();
+      event_queues_.push_back(std::move(queue));
+    }
+    if (ring_buffer_manager_ == nullptr) {
+      ring_buffer_manager_ = bpf_new_ringbuf(map_fd, &HandleRingBufferEvent, ring_buffer.get());
+      if (ring_buffer_manager_ == nullptr) {
+        return error::Internal("Could not open ring buffer $0.", p.name);
+      }
+    } else if (bpf_add_ringbuf(ring_buffer_manager_, map_fd, &HandleRingBufferEvent,
+                               ring_buffer.get()) < 0) {
+      return error::Internal("Could not open ring buffer $0.", p.name);
+    }
+    ring_buffers_.push_back(std::move(ring_buffer));
+    ++num_open_ring_buffers_;
+  }
+  return Status::OK();
+}
+
+Status BCCWrapper::DrainPerCPUHashTable(const std::string& table_name,
+                                        const PerCPUHashEntryFn& fn) {
+  int map_fd = bpf_.get_table(table_name).get_fd();
+  if (map_fd < 0) {
+    return error::Internal("Could not find BPF map $0.", table_name);
+  }
+  struct bpf_map_info info = {};
+  uint32_t info_len = sizeof(info);
+  if (bpf_obj_get_info(map_fd, &info, &info_len) != 0) {
+    return error::Internal("Could not get the info of BPF map $0 [errno=$1].", table_name, errno);
+  }
+  const size_t key_size = info.key_size;
+
+  // Collect the keys first, as deleting while iterating restarts the iteration.
+  std::string keys;
+  std::string key(key_size, '\0');
+  void* prev_key = nullptr;
+  while (bpf_get_next_key(map_fd, prev_key, key.data()) == 0) {
+    keys.append(key);
+    prev_key = keys.data() + keys.size() - key_size;
+  }
+
+  const size_t aligned_value_size = (info.value_size + 7) & ~size_t{7};
+  std::string values(aligned_value_size * kCPUCount, '\0');
+  for (size_t pos = 0; pos < keys.size(); pos += key_size) {
+    char* k = keys.data() + pos;
+    if (bpf_lookup_elem(map_fd, k, values.data()) != 0) {
+      continue;
+    }
+    bpf_delete_elem(map_fd, k);
+    fn(std::string_view(k, key_size), values);
+  }
+  return Status::OK();
+}
+
+namespace {
+
+// The kernel's internal ENOTSUPP, which is not in the user-space errno headers.
+constexpr int kENOTSUPP = 524;
+
+// Issues one of the BPF_MAP_*_BATCH commands. On return, *count is the number of elements that
+// were processed, which may be non-zero even if the command failed part way.
+int MapBatchOp(int cmd, int map_fd, void* in_batch, void* out_batch, void* keys, void* values,
+               uint32_t* count) {
+  union bpf_attr attr = {};
+  attr.batch.map_fd = map_fd;
+  attr.batch.in_batch = reinterpret_cast<uint64_t>(in_batch);
+  attr.batch.out_batch = reinterpret_cast<uint64_t>(out_batch);
+  attr.batch.keys = reinterpret_cast<uint64_t>(keys);
+  attr.batch.values = reinterpret_cast<uint64_t>(values);
+  attr.batch.count = *count;
+  int rc = syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+  *count = attr.batch.count;
+  return rc;
+}
+
+// Kernels before 5.6 don't know the batch commands, and some map types don't implement them.
+bool IsUnsupportedBatchOp(int err) {
+  return err == EINVAL || err == EOPNOTSUPP || err == kENOTSUPP;
+}
+
+}  // namespace
+
+size_t BCCWrapper::DeleteHashTableKeys(const std::string& table_name, const void* keys,
+                                       size_t key_size, size_t num_keys) {
+  int map_fd = bpf_.get_table(table_name).get_fd();
+  if (map_fd < 0 || num_keys == 0) {
+    return 0;
+  }
+  // The kernel only reads the keys, but the syscalls take non-const pointers.
+  char* key_ptr = static_cast<char*>(const_cast<void*>(keys));
+
+  size_t num_deleted = 0;
+  size_t pos = 0;
+  while (map_batch_ops_supported_ && pos < num_keys) {
+    uint32_t count = num_keys - pos;
+    if (MapBatchOp(BPF_MAP_DELETE_BATCH, map_fd, nullptr, nullptr, key_ptr + pos * key_size,
+                   nullptr, &count) == 0) {
+      return num_deleted + count;
+    }
+    if (IsUnsupportedBatchOp(errno)) {
+      map_batch_ops_supported_ = false;
+      break;
+    }
+    // The batch stops at the first key that could not be deleted, usually because it is not in
+    // the map. Skip over it.
+    num_deleted += count;
+    pos += count + 1;
+  }
+
+  for (; pos < num_keys; ++pos) {
+    if (bpf_delete_elem(map_fd, key_ptr + pos * key_size) == 0) {
+      ++num_deleted;
+    }
+  }
+  return num_deleted;
+}
+
+bool BCCWrapper::LookupHashTableBatch(const std::string& table_name, size_t key_size,
+                                      size_t value_size, std::string* keys, std::string* values) {
+  if (!map_batch_ops_supported_) {
+    return false;
+  }
+  int map_fd = bpf_.get_table(table_name).get_fd();
+  if (map_fd < 0) {
+    return false;
+  }
+  struct bpf_map_info info = {};
+  uint32_t info_len = sizeof(info);
+  if (bpf_obj_get_info(map_fd, &info, &info_len) != 0 || info.key_size != key_size ||
+      info.value_size != value_size) {
+    return false;
+  }
+
+  keys->resize(size_t{info.max_entries} * key_size);
+  values->resize(size_t{info.max_entries} * value_size);
+
+  // The batch token of a hash map is the index of the next bucket to read.
+  uint32_t batch = 0;
+  void* in_batch = nullptr;
+  size_t num_entries = 0;
+  while (num_entries < info.max_entries) {
+    uint32_t count = info.max_entries - num_entries;
+    int rc = MapBatchOp(BPF_MAP_LOOKUP_BATCH, map_fd, in_batch, &batch,
+                        keys->data() + num_entries * key_size,
+                        values->data() + num_entries * value_size, &count);
+    if (rc != 0 && in_batch == nullptr && IsUnsupportedBatchOp(errno)) {
+      map_batch_ops_supported_ = false;
+      return false;
+    }
+    num_entries += count;
+    // ENOENT once the last bucket was read.
+    if (rc != 0) {
+      break;
+    }
+    in_batch = &batch;
+  }
+
+  keys->resize(num_entries * key_size);
+  values->resize(num_entries * value_size);
+  return true;
+}
+
+void BCCWrapper::ReportRingBufferLoss(RingBuffer* ring_buffer) {
+  if (ring_buffer->spec.probe_loss_fn == nullptr) {
+    return;
+  }
+  uint64_t num_lost = 0;
+  auto loss_table = bpf_.get_array_table<uint64_t>(ring_buffer->spec.name + "_ringbuf_loss");
+  if (!loss_table.get_value(0, num_lost).ok() || num_lost <= ring_buffer->num_lost_reported) {
+    return;
+  }
+  ring_buffer->spec.probe_loss_fn(ring_buffer->cb_cookie,
+                                  num_lost - ring_buffer->num_lost_reported);
+  ring_buffer->num_lost_reported = num_lost;
+}
+
+void BCCWrapper::CloseRingBuffers() {
+  if (ring_buffer_manager_ != nullptr) {
+    VLOG(1) << absl::Substitute("Closing $0 ring buffers", ring_buffers_.size());
+    bpf_free_ringbuf(ring_buffer_manager_);
+    ring_buffer_manager_ = nullptr;
+  }
+  num_open_ring_buffers_ -= ring_buffers_.size();
+  ring_buffers_.clear();
 }
 
 Status BCCWrapper::AttachPerfEvent(const PerfEventSpec& perf_event) {
@@ -388,6 +863,19 @@ Status BCCWrapper::DetachPerfEvent(const PerfEventSpec& perf_event) {
   return Status::OK();
 }
 
+Status BCCWrapper::RemovePerfEvent(const PerfEventSpec& perf_event) {
+  auto iter = std::find_if(perf_events_.begin(), perf_events_.end(),
+                           [&perf_event](const PerfEventSpec& p) {
+                             return p.type == perf_event.type && p.config == perf_event.config;
+                           });
+  if (iter == perf_events_.end()) {
+    return error::NotFound("Perf event with probe_fn=$0 is not attached.", perf_event.probe_fn);
+  }
+  PL_RETURN_IF_ERROR(DetachPerfEvent(*iter));
+  perf_events_.erase(iter);
+  return Status::OK();
+}
+
 void BCCWrapper::DetachPerfEvents() {
   for (const PerfEventSpec& p : perf_events_) {
     auto res = DetachPerfEvent(p);
@@ -404,25 +892,162 @@ std::string BCCWrapper::GetKProbeTargetName(const KProbeSpec& probe) {
   return target;
 }
 
-void BCCWrapper::PollPerfBuffer(std::string_view perf_buffer_name, int timeout_ms) {
+int BCCWrapper::PollPerfBuffer(std::string_view perf_buffer_name, int timeout_ms) {
   auto perf_buffer = bpf_.get_perf_buffer(std::string(perf_buffer_name));
-  if (perf_buffer != nullptr) {
-    perf_buffer->poll(timeout_ms);
+  if (perf_buffer == nullptr) {
+    return 0;
+  }
+  // Returns the number of per-CPU buffers that were ready, or a negative value on error.
+  return std::max(0, perf_buffer->poll(timeout_ms));
+}
+
+void BCCWrapper::EventQueue::HandleEvent(void* cb_cookie, void* data, int data_size) {
+  auto* queue = static_cast<EventQueue*>(cb_cookie);
+  if (queue->num_bytes + data_size > kMaxQueuedEventBytes) {
+    ++queue->num_lost;
+    return;
   }
+  queue->num_bytes += data_size;
+  queue->events.enqueue(std::string(static_cast<const char*>(data), data_size));
 }
 
-void BCCWrapper::PollPerfBuffers(int timeout_ms) {
+void BCCWrapper::EventQueue::HandleLoss(void* cb_cookie, uint64_t lost) {
+  static_cast<EventQueue*>(cb_cookie)->num_lost += lost;
+}
+
+double BCCWrapper::EventQueue::Drain() {
+  double occupancy = std::min(1.0, 1.0 * num_bytes / kMaxQueuedEventBytes);
+  // Only the events that were queued so far are drained, so that a busy reader thread can't keep
+  // the caller here.
+  size_t num_events = events.size_approx();
+  std::string event;
+  for (size_t i = 0; i < num_events && events.try_dequeue(event); ++i) {
+    num_bytes -= event.size();
+    spec.probe_output_fn(cb_cookie, event.data(), static_cast<int>(event.size()));
+  }
+  uint64_t lost = num_lost.exchange(0);
+  if (lost > 0 && spec.probe_loss_fn != nullptr) {
+    spec.probe_loss_fn(cb_cookie, lost);
+  }
+  return occupancy;
+}
+
+int BCCWrapper::PollKernelBuffers(int timeout_ms) {
+  int num_ready = 0;
   for (const auto& spec : perf_buffers_) {
-    PollPerfBuffer(spec.name, timeout_ms);
+    num_ready += PollPerfBuffer(spec.name, timeout_ms);
+  }
+  if (ring_buffer_manager_ != nullptr) {
+    num_ready += bpf_poll_ringbuf(ring_buffer_manager_, timeout_ms) > 0 ? 1 : 0;
+  }
+  return num_ready;
+}
+
+int BCCWrapper::PollNUMAPerfReaders(int node, bool poll_ring_buffers) {
+  std::vector<perf_reader*>& readers = numa_perf_readers_[node];
+  int num_ready = std::max(
+      0, perf_reader_poll(static_cast<int>(readers.size()), readers.data(), /* timeout */ 0));
+  if (poll_ring_buffers && ring_buffer_manager_ != nullptr) {
+    num_ready += bpf_poll_ringbuf(ring_buffer_manager_, /* timeout_ms */ 0) > 0 ? 1 : 0;
+  }
+  return num_ready;
+}
+
+void BCCWrapper::StartPerfBufferReaderThread() {
+  // When there's nothing to read, the reader briefly backs off, which still drains the buffers
+  // far more often than the connectors' sampling periods.
+  static constexpr auto kIdleBackoff = std::chrono::milliseconds{1};
+
+  reader_thread_running_ = true;
+  if (numa_perf_readers_.empty()) {
+    reader_threads_.emplace_back([this]() {
+      while (reader_thread_running_) {
+        if (PollKernelBuffers(/* timeout_ms */ 0) == 0) {
+          std::this_thread::sleep_for(kIdleBackoff);
+        }
+      }
+    });
+    return;
+  }
+
+  // The ring buffers are shared by all CPUs, and are read by the first node's thread.
+  bool poll_ring_buffers = true;
+  for (const auto& [node, cpus] : numa_node_cpus_) {
+    if (!numa_perf_readers_.contains(node)) {
+      continue;
+    }
+    // Threads stay within the CPUs that Stirling was given (--stirling_cpus). A node without any
+    // of them is read from wherever the thread is scheduled.
+    std::vector<int> node_cpus;
+    auto allowed_cpus = system::CurrentThreadAffinity();
+    if (allowed_cpus.ok()) {
+      std::set_intersection(cpus.begin(), cpus.end(), allowed_cpus.ValueOrDie().begin(),
+                            allowed_cpus.ValueOrDie().end(), std::back_inserter(node_cpus));
+    }
+    reader_threads_.emplace_back([this, node = node, node_cpus, poll_ring_buffers]() {
+      if (!node_cpus.empty()) {
+        Status s = system::SetCurrentThreadAffinity(node_cpus);
+        LOG_IF(WARNING, !s.ok()) << absl::Substitute(
+            "Could not pin the perf buffer reader of NUMA node $0: $1", node, s.msg());
+      }
+      while (reader_thread_running_) {
+        if (PollNUMAPerfReaders(node, poll_ring_buffers) == 0) {
+          std::this_thread::sleep_for(kIdleBackoff);
+        }
+      }
+    });
+    poll_ring_buffers = false;
+  }
+}
+
+void BCCWrapper::StopPerfBufferReaderThread() {
+  reader_thread_running_ = false;
+  for (std::thread& t : reader_threads_) {
+    t.join();
+  }
+  reader_threads_.clear();
+}
+
+double BCCWrapper::PollPerfBuffers(int timeout_ms) {
+  static const int kNumCPUs = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+
+  if (reader_thread_enabled_) {
+    if (reader_threads_.empty() && (!perf_buffers_.empty() || !ring_buffers_.empty())) {
+      StartPerfBufferReaderThread();
+    }
+    double occupancy = 0;
+    for (auto& queue : event_queues_) {
+      occupancy = std::max(occupancy, queue->Drain());
+    }
+    for (auto& ring_buffer : ring_buffers_) {
+      ReportRingBufferLoss(ring_buffer.get());
+    }
+    return occupancy;
+  }
+
+  int num_buffers = static_cast<int>(perf_buffers_.size()) * kNumCPUs;
+  // The ring buffers are polled together, which only tells whether any of them had data.
+  if (ring_buffer_manager_ != nullptr) {
+    num_buffers += 1;
+  }
+  int num_ready = PollKernelBuffers(timeout_ms);
+  for (auto& ring_buffer : ring_buffers_) {
+    ReportRingBufferLoss(ring_buffer.get());
   }
+  return num_buffers == 0 ? 0 : std::min(1.0, 1.0 * num_ready / num_buffers);
 }
 
 void BCCWrapper::Close() {
+  // The reader thread polls the buffers, so it must be stopped before they're closed.
+  StopPerfBufferReaderThread();
   DetachPerfEvents();
   ClosePerfBuffers();
+  CloseRingBuffers();
   DetachKProbes();
   DetachUProbes();
   DetachTracepoints();
+  DetachCGroupPrograms();
+  event_queues_.clear();
 }
 
 }  // namespace bpf_tools
@@ -34,17 +34,26 @@
 
 #include <gtest/gtest_prod.h>
 
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "concurrentqueue.h"
+
 #include "src/common/base/base.h"
 #include "src/stirling/obj_tools/elf_reader.h"
 
+DECLARE_bool(stirling_perf_buffer_reader_thread);
+DECLARE_bool(stirling_perf_buffer_numa_readers);
+DECLARE_string(stirling_bpf_cache_dir);
+
 namespace px {
 /*
  * Status adapter for ebpf::StatusTuple.
@@ -152,6 +161,7 @@ struct SamplingProbeSpec {
 
 /**
  * Describes a BPF perf buffer, through which data is returned to user-space.
+ * Also describes BPF ring buffers, which are opened with BCCWrapper::OpenRingBuffers().
  */
 struct PerfBufferSpec {
   // Name of the perf buffer.
@@ -166,6 +176,8 @@ struct PerfBufferSpec {
   perf_reader_lost_cb probe_loss_fn;
 
   // Size of perf buffer. Will be rounded up to and allocated in a power of 2 number of pages.
+  // Perf buffers are allocated once per CPU. A ring buffer is shared by all CPUs, so it is
+  // allocated with this size times the number of online CPUs instead.
   int size_bytes = 1024 * 1024;
 };
 
@@ -188,6 +200,26 @@ struct PerfEventSpec {
   uint64_t sample_period;
 };
 
+/**
+ * Describes a cgroup skb program, which runs for the packets of the sockets in a cgroup v2
+ * directory and in all of its descendants.
+ */
+struct CGroupProgramSpec {
+  // The cgroup v2 directory to attach to, e.g. /sys/fs/cgroup.
+  std::filesystem::path cgroup_path;
+
+  // BPF_CGROUP_INET_INGRESS or BPF_CGROUP_INET_EGRESS.
+  bpf_attach_type attach_type;
+
+  // Name of user-provided BPF function to run for every packet.
+  std::string_view probe_fn;
+
+  std::string ToString() const {
+    return absl::Substitute("[cgroup=$0 type=$1 probe=$2]", cgroup_path.string(),
+                            static_cast<int>(attach_type), probe_fn);
+  }
+};
+
 /**
  * Wrapper around BCC, as a convenience.
  */
@@ -253,6 +285,38 @@ class BCCWrapper {
    */
   Status OpenPerfBuffer(const PerfBufferSpec& perf_buffer, void* cb_cookie = nullptr);
 
+  /**
+   * @return Whether the kernel supports BPF ring buffers (Linux 5.8+).
+   */
+  static bool RingBuffersSupported();
+
+  /**
+   * Returns the cflags that size the ring buffers declared with BPF_EVENT_OUTPUT() (see
+   * bcc_bpf/events.h), which must be passed to InitBPFProgram() for BPF code that was
+   * preprocessed with ENABLE_RINGBUF.
+   */
+  static std::vector<std::string> RingBufferCFlags(const ArrayView<PerfBufferSpec>& ring_buffers);
+
+  /**
+   * Open BPF ring buffers for reading events.
+   * Events and lost events are reported through the same callbacks as for perf buffers,
+   * when PollPerfBuffers() is called.
+   * @param ring_buffers Specifications of the ring buffers (name, callback function, etc.).
+   * @param cb_cookie A pointer that is sent to the callback functions.
+   * @return Error of first failure (remaining ring buffer opens are not attempted).
+   */
+  Status OpenRingBuffers(const ArrayView<PerfBufferSpec>& ring_buffers, void* cb_cookie);
+
+  /**
+   * Drain the perf and ring buffers from a dedicated reader thread, so that bursts of events
+   * are read out of the kernel as they arrive, instead of only when PollPerfBuffers() is called.
+   * The events are queued until PollPerfBuffers() hands them to the PerfBufferSpec's callbacks,
+   * on the caller's thread as usual.
+   * Must be called before any perf or ring buffer is opened. The reader thread is started by the
+   * first call to PollPerfBuffers().
+   */
+  void EnablePerfBufferReaderThread() { reader_thread_enabled_ = true; }
+
   /**
    * Attach a perf event, which runs a probe every time a perf counter reaches a threshold
    * condition.
@@ -261,6 +325,13 @@ class BCCWrapper {
    */
   Status AttachPerfEvent(const PerfEventSpec& perf_event);
 
+  /**
+   * Detach a perf event that was attached by AttachPerfEvent(), without waiting for Close().
+   * @param perf_event Specification of the perf event; only its type and config are used.
+   * @return Error if the perf event is not attached, or could not be detached.
+   */
+  Status RemovePerfEvent(const PerfEventSpec& perf_event);
+
   /**
    * Convenience function that attaches multiple kprobes.
    * @param probes Vector of probes.
@@ -287,6 +358,18 @@ class BCCWrapper {
    */
   Status AttachXDP(const std::string& dev_name, const std::string& fn_name);
 
+  /**
+   * Attaches a cgroup skb program. Other programs attached to the same cgroup keep running.
+   * @return Error if the program fails to load or to attach.
+   */
+  Status AttachCGroupProgram(const CGroupProgramSpec& spec);
+
+  /**
+   * Convenience function that attaches multiple cgroup skb programs.
+   * @return Error of the first program to fail to attach (remaining programs are not attempted).
+   */
+  Status AttachCGroupPrograms(const ArrayView<CGroupProgramSpec>& specs);
+
   /**
    * Convenience function that opens multiple perf buffers.
    * @param probes Vector of perf buffer descriptors.
@@ -319,18 +402,20 @@ class BCCWrapper {
   }
 
   /**
-   * Drains all of the opened perf buffers, calling the handle function that was
-   * specified in the PerfBufferSpec when OpenPerfBuffer was called.
+   * Drains all of the opened perf and ring buffers, calling the handle function that was
+   * specified in the PerfBufferSpec when OpenPerfBuffer (or OpenRingBuffers) was called.
    *
    * @param timeout_ms If there's no event in the perf buffer, then timeout_ms specifies the
    *                   amount of time to wait for an event to arrive before returning.
    *                   Default is 0, because if nothing is ready, then we want to go back to sleep
    *                   and catch new events in the next iteration.
+   * @return the fraction of the per-CPU perf buffers, and of the ring buffers, that had data.
+   *         With the reader thread, the fullest queue's fraction of kMaxQueuedEventBytes.
    */
-  void PollPerfBuffers(int timeout_ms = 0);
+  double PollPerfBuffers(int timeout_ms = 0);
 
   /**
-   * Detaches all probes, and closes all perf buffers that are open.
+   * Detaches all probes, and closes all perf and ring buffers that are open.
    */
   void Close();
 
@@ -357,10 +442,62 @@ class BCCWrapper {
     return bpf_.get_percpu_array_table<TValueType>(table_name);
   }
 
+  template <typename TKeyType, typename TValueType>
+  ebpf::BPFPercpuHashTable<TKeyType, TValueType> GetPerCPUHashTable(const std::string& table_name) {
+    return bpf_.get_percpu_hash_table<TKeyType, TValueType>(table_name);
+  }
+
+  // Called with the key of an entry, and its values on all CPUs. The value of each CPU starts at
+  // a multiple of 8 bytes, as laid out by the kernel.
+  using PerCPUHashEntryFn =
+      std::function<void(std::string_view key, std::string_view per_cpu_values)>;
+
+  /**
+   * Reads out and deletes all entries of a BPF_PERCPU_HASH whose key and value types are only
+   * known at runtime, such as those of generated programs.
+   * Updates from BPF between the read and the delete of an entry are lost.
+   */
+  Status DrainPerCPUHashTable(const std::string& table_name, const PerCPUHashEntryFn& fn);
+
+  /**
+   * Deletes the keys from a BPF hash map, with BPF_MAP_DELETE_BATCH where the kernel supports it
+   * (5.6+), and with one syscall per key otherwise. Keys that are not in the map are skipped.
+   * @return The number of keys that were deleted.
+   */
+  size_t DeleteHashTableKeys(const std::string& table_name, const void* keys, size_t key_size,
+                             size_t num_keys);
+
+  template <typename TKeyType>
+  size_t DeleteHashTableKeys(const std::string& table_name, const std::vector<TKeyType>& keys) {
+    return DeleteHashTableKeys(table_name, keys.data(), sizeof(TKeyType), keys.size());
+  }
+
+  /**
+   * Returns all entries of a BPF_HASH. They are read with BPF_MAP_LOOKUP_BATCH where the kernel
+   * supports it, which takes a few syscalls for the whole map, instead of the two per entry of
+   * BPFHashTable::get_table_offline().
+   */
+  template <typename TKeyType, typename TValueType>
+  std::vector<std::pair<TKeyType, TValueType>> GetHashTableEntries(const std::string& table_name) {
+    std::string keys;
+    std::string values;
+    if (!LookupHashTableBatch(table_name, sizeof(TKeyType), sizeof(TValueType), &keys, &values)) {
+      return GetHashTable<TKeyType, TValueType>(table_name).get_table_offline();
+    }
+    std::vector<std::pair<TKeyType, TValueType>> entries;
+    entries.reserve(keys.size() / sizeof(TKeyType));
+    for (size_t i = 0; i < keys.size() / sizeof(TKeyType); ++i) {
+      entries.emplace_back(utils::MemCpy<TKeyType>(keys.data() + i * sizeof(TKeyType)),
+                           utils::MemCpy<TValueType>(values.data() + i * sizeof(TValueType)));
+    }
+    return entries;
+  }
+
   // These are static counters of attached/open probes across all instances.
   // It is meant for verification that we have cleaned-up all resources in tests.
   static size_t num_attached_probes() { return num_attached_kprobes_ + num_attached_uprobes_; }
   static size_t num_open_perf_buffers() { return num_open_perf_buffers_; }
+  static size_t num_open_ring_buffers() { return num_open_ring_buffers_; }
   static size_t num_attached_perf_events() { return num_attached_perf_events_; }
 
  private:
@@ -371,7 +508,64 @@ class BCCWrapper {
   Status DetachTracepoint(const TracepointSpec& probe);
   Status ClosePerfBuffer(const PerfBufferSpec& perf_buffer);
   Status DetachPerfEvent(const PerfEventSpec& perf_event);
-  void PollPerfBuffer(std::string_view perf_buffer_name, int timeout_ms);
+  // Returns the number of per-CPU buffers of the perf buffer that had data.
+  int PollPerfBuffer(std::string_view perf_buffer_name, int timeout_ms);
+  // Reads all entries of the BPF hash map with BPF_MAP_LOOKUP_BATCH, packed one after another.
+  // Returns false if the kernel does not support batch operations on the map.
+  bool LookupHashTableBatch(const std::string& table_name, size_t key_size, size_t value_size,
+                            std::string* keys, std::string* values);
+
+  // The events of one perf or ring buffer that the reader thread has read, but that haven't been
+  // handed to the PerfBufferSpec's callbacks yet.
+  struct EventQueue {
+    PerfBufferSpec spec;
+    void* cb_cookie = nullptr;
+    moodycamel::ConcurrentQueue<std::string> events;
+    std::atomic<int64_t> num_bytes = 0;
+    // Events that were dropped because the queue was full, or lost by the kernel.
+    std::atomic<uint64_t> num_lost = 0;
+
+    // Perf buffer callbacks, which run on the reader thread.
+    static void HandleEvent(void* cb_cookie, void* data, int data_size);
+    static void HandleLoss(void* cb_cookie, uint64_t lost);
+
+    // Hands the events that were queued so far to the PerfBufferSpec's callbacks.
+    // Returns the fraction of kMaxQueuedEventBytes that was used.
+    double Drain();
+  };
+
+  // Each queue holds at most this many bytes of events, so that the reader thread can't run away
+  // with memory when the events aren't consumed.
+  static constexpr int64_t kMaxQueuedEventBytes = 64 * 1024 * 1024;
+
+  void StartPerfBufferReaderThread();
+  void StopPerfBufferReaderThread();
+  // Polls the kernel buffers, and returns the number of them that had data.
+  int PollKernelBuffers(int timeout_ms);
+
+  // Whether the reader thread is split into one reader thread per NUMA node.
+  bool UseNUMAReaders();
+  // Opens the per-CPU readers of the perf buffer, grouped by the NUMA node of their CPU, instead
+  // of having bcc open them.
+  Status OpenNUMAPerfBuffer(const std::string& name, EventQueue* queue, int num_pages);
+  // Polls the per-CPU readers of the node, and returns the number of them that had data.
+  int PollNUMAPerfReaders(int node, bool poll_ring_buffers);
+
+  struct RingBuffer {
+    PerfBufferSpec spec;
+    void* cb_cookie = nullptr;
+    // Set when the reader thread queues the ring buffer's events.
+    EventQueue* queue = nullptr;
+    // The number of lost events that were already reported to spec.probe_loss_fn.
+    uint64_t num_lost_reported = 0;
+  };
+
+  // Ring buffer callback, which forwards the event to the PerfBufferSpec's probe_output_fn.
+  static int HandleRingBufferEvent(void* ctx, void* data, size_t data_size);
+
+  // The BPF code counts the events that did not fit into a ring buffer in <name>_ringbuf_loss.
+  // Reports the ones that were counted since the last call to the PerfBufferSpec's probe_loss_fn.
+  void ReportRingBufferLoss(RingBuffer* ring_buffer);
 
   // Detaches all kprobes/uprobes/perf buffers/perf events that were attached by the wrapper.
   // If any fails to detach, an error is logged, and the function continues.
@@ -379,7 +573,9 @@ class BCCWrapper {
   void DetachUProbes();
   void DetachTracepoints();
   void ClosePerfBuffers();
+  void CloseRingBuffers();
   void DetachPerfEvents();
+  void DetachCGroupPrograms();
 
   // Returns the name that identifies the target to attach this k-probe.
   std::string GetKProbeTargetName(const KProbeSpec& probe);
@@ -388,8 +584,34 @@ class BCCWrapper {
   std::vector<UProbeSpec> uprobes_;
   std::vector<TracepointSpec> tracepoints_;
   std::vector<PerfBufferSpec> perf_buffers_;
+  std::vector<std::unique_ptr<RingBuffer>> ring_buffers_;
+  // A single libbpf ring_buffer manager polls all the ring buffers.
+  void* ring_buffer_manager_ = nullptr;
   std::vector<PerfEventSpec> perf_events_;
 
+  struct AttachedCGroupProgram {
+    CGroupProgramSpec spec;
+    int prog_fd;
+    // Kept open to detach the program.
+    int cgroup_fd;
+  };
+  std::vector<AttachedCGroupProgram> cgroup_programs_;
+
+  bool reader_thread_enabled_ = false;
+  std::vector<std::unique_ptr<EventQueue>> event_queues_;
+  std::atomic<bool> reader_thread_running_ = false;
+
+  // Cleared once the kernel rejects a BPF_MAP_*_BATCH command, to not retry it on every call.
+  std::atomic<bool> map_batch_ops_supported_ = true;
+  std::vector<std::thread> reader_threads_;
+
+  // With --stirling_perf_buffer_numa_readers, the CPUs of each NUMA node, and the per-CPU perf
+  // readers of each node, which are read by a reader thread that runs on the node.
+  std::map<int, std::vector<int>> numa_node_cpus_;
+  std::map<int, std::vector<perf_reader*>> numa_perf_readers_;
+  // The perf buffers whose readers are in numa_perf_readers_, rather than owned by bcc.
+  std::set<std::string> numa_perf_buffers_;
+
   std::string system_headers_include_dir_;
 
   ebpf::BPF bpf_;
@@ -402,6 +624,7 @@ class BCCWrapper {
   inline static size_t num_attached_uprobes_;
   inline static size_t num_attached_tracepoints_;
   inline static size_t num_open_perf_buffers_;
+  inline static size_t num_open_ring_buffers_;
   inline static size_t num_attached_perf_events_;
 };
 
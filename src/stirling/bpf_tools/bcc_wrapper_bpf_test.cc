@@ -18,6 +18,10 @@
 
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/system.h"
 #include "src/common/testing/testing.h"
@@ -159,6 +163,123 @@ TEST(BCCWrapperTest, GetTGIDStartTime) {
   EXPECT_EQ(proc_pid_start_time, expected_proc_pid_start_time);
 }
 
+TEST(BCCWrapperTest, RingBuffer) {
+  if (!BCCWrapper::RingBuffersSupported()) {
+    LOG(WARNING) << "Skipping test, because the kernel does not support BPF ring buffers.";
+    return;
+  }
+
+  // The BPF code that bcc_bpf/events.h generates for a BPF_EVENT_OUTPUT(events) with
+  // ENABLE_RINGBUF.
+  std::string_view program = R"bcc(
+    BPF_RINGBUF_OUTPUT(events, events_ringbuf_pages);
+    BPF_ARRAY(events_ringbuf_loss, uint64_t, 1);
+
+    int probe_trigger(struct pt_regs* ctx) {
+      uint32_t* event = events.ringbuf_reserve(sizeof(uint32_t));
+      if (event == NULL) {
+        int loss_idx = 0;
+        uint64_t* num_lost = events_ringbuf_loss.lookup(&loss_idx);
+        if (num_lost != NULL) {
+          __sync_fetch_and_add(num_lost, 1);
+        }
+        return 0;
+      }
+      *event = 42;
+      events.ringbuf_submit(event, 0);
+      return 0;
+    }
+  )bcc";
+
+  struct Received {
+    std::vector<uint32_t> events;
+    uint64_t num_lost = 0;
+  } received;
+
+  const auto kRingBufferSpecs = MakeArray<PerfBufferSpec>({
+      {"events",
+       [](void* cb_cookie, void* data, int /*data_size*/) {
+         static_cast<Received*>(cb_cookie)->events.push_back(*static_cast<uint32_t*>(data));
+       },
+       [](void* cb_cookie, uint64_t lost) { static_cast<Received*>(cb_cookie)->num_lost += lost; },
+       4096},
+  });
+
+  BCCWrapper bcc_wrapper;
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(program, BCCWrapper::RingBufferCFlags(kRingBufferSpecs)));
+  ASSERT_OK(bcc_wrapper.OpenRingBuffers(kRingBufferSpecs, &received));
+  EXPECT_EQ(1, BCCWrapper::num_open_ring_buffers());
+
+  ASSERT_OK_AND_ASSIGN(std::filesystem::path self_path, fs::ReadSymlink("/proc/self/exe"));
+  UProbeSpec uprobe{.binary_path = self_path,
+                    .symbol = {},  // Keep GCC happy.
+                    .address = reinterpret_cast<uint64_t>(&BCCWrapperTestProbeTrigger),
+                    .attach_type = BPFProbeAttachType::kEntry,
+                    .probe_fn = "probe_trigger"};
+  ASSERT_OK(bcc_wrapper.AttachUProbe(uprobe));
+
+  BCCWrapperTestProbeTrigger();
+  BCCWrapperTestProbeTrigger();
+  bcc_wrapper.PollPerfBuffers();
+
+  EXPECT_THAT(received.events, ::testing::ElementsAre(42, 42));
+  EXPECT_EQ(received.num_lost, 0U);
+
+  bcc_wrapper.Close();
+  EXPECT_EQ(0, BCCWrapper::num_open_ring_buffers());
+}
+
+TEST(BCCWrapperTest, PerfBufferReaderThread) {
+  std::string_view program = R"bcc(
+    BPF_PERF_OUTPUT(events);
+
+    int probe_trigger(struct pt_regs* ctx) {
+      uint32_t event = 42;
+      events.perf_submit(ctx, &event, sizeof(event));
+      return 0;
+    }
+  )bcc";
+
+  std::vector<uint32_t> received;
+  const auto kPerfBufferSpecs = MakeArray<PerfBufferSpec>({
+      {"events",
+       [](void* cb_cookie, void* data, int /*data_size*/) {
+         static_cast<std::vector<uint32_t>*>(cb_cookie)->push_back(*static_cast<uint32_t*>(data));
+       },
+       nullptr, 4096},
+  });
+
+  BCCWrapper bcc_wrapper;
+  bcc_wrapper.EnablePerfBufferReaderThread();
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(program));
+  ASSERT_OK(bcc_wrapper.OpenPerfBuffers(kPerfBufferSpecs, &received));
+
+  ASSERT_OK_AND_ASSIGN(std::filesystem::path self_path, fs::ReadSymlink("/proc/self/exe"));
+  UProbeSpec uprobe{.binary_path = self_path,
+                    .symbol = {},  // Keep GCC happy.
+                    .address = reinterpret_cast<uint64_t>(&BCCWrapperTestProbeTrigger),
+                    .attach_type = BPFProbeAttachType::kEntry,
+                    .probe_fn = "probe_trigger"};
+  ASSERT_OK(bcc_wrapper.AttachUProbe(uprobe));
+
+  // The first poll starts the reader thread, and the events are only handed to the callbacks when
+  // polling, on this thread.
+  bcc_wrapper.PollPerfBuffers();
+  BCCWrapperTestProbeTrigger();
+  BCCWrapperTestProbeTrigger();
+  for (int i = 0; i < 100 && received.size() < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    bcc_wrapper.PollPerfBuffers();
+  }
+  EXPECT_THAT(received, ::testing::ElementsAre(42, 42));
+
+  // Perf buffers can't be opened once the reader thread runs.
+  EXPECT_NOT_OK(bcc_wrapper.OpenPerfBuffers(kPerfBufferSpecs, &received));
+
+  bcc_wrapper.Close();
+  EXPECT_EQ(0, BCCWrapper::num_open_perf_buffers());
+}
+
 TEST(BCCWrapperTest, TestMapClearingAPIs) {
   // Test to show that get_table_offline() with clear_table=true actually clears the table.
   bpf_tools::BCCWrapper bcc_wrapper;
@@ -191,6 +312,34 @@ TEST(BCCWrapperTest, TestMapClearingAPIs) {
   ASSERT_THAT(alphabet.get_table_offline(), IsEmpty());
 }
 
+TEST(BCCWrapperTest, BatchMapOperations) {
+  bpf_tools::BCCWrapper bcc_wrapper;
+  std::string_view kProgram = "BPF_HASH(squares, uint32_t, uint64_t, 1024);";
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(kProgram));
+  ebpf::BPFHashTable squares = bcc_wrapper.GetHashTable<uint32_t, uint64_t>("squares");
+
+  for (uint32_t i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(squares.update_value(i, uint64_t{i} * i).ok());
+  }
+
+  using ::testing::Pair;
+  using ::testing::UnorderedElementsAre;
+  using ::testing::UnorderedElementsAreArray;
+
+  EXPECT_THAT(bcc_wrapper.GetHashTableEntries<uint32_t, uint64_t>("squares"),
+              UnorderedElementsAreArray(squares.get_table_offline()));
+
+  // Keys that are not in the map, like 5000, are skipped.
+  std::vector<uint32_t> keys;
+  for (uint32_t i = 1; i < 1000; ++i) {
+    keys.push_back(i);
+  }
+  keys.insert(keys.begin() + 10, 5000);
+  EXPECT_EQ(bcc_wrapper.DeleteHashTableKeys("squares", keys), 999);
+  EXPECT_THAT(bcc_wrapper.GetHashTableEntries<uint32_t, uint64_t>("squares"),
+              UnorderedElementsAre(Pair(0, 0)));
+}
+
 // Tests that BCCWrapper can load XDP program.
 TEST(BCCWrapperTest, LoadXDP) {
   bpf_tools::BCCWrapper bcc_wrapper;
@@ -229,6 +378,30 @@ TEST(BCCWrapperTest, LoadXDP) {
   ASSERT_OK(bcc_wrapper.AttachXDP("lo", "udpfilter"));
 }
 
+// Tests that BCCWrapper can attach cgroup skb programs, and detaches them on Close().
+TEST(BCCWrapperTest, AttachCGroupPrograms) {
+  bpf_tools::BCCWrapper bcc_wrapper;
+
+  std::string_view program = R"bcc(
+      BPF_ARRAY(num_packets, uint64_t, 1);
+
+      int count_packets(struct __sk_buff* skb) {
+        num_packets.increment(0);
+        return 1;
+      }
+  )bcc";
+  ASSERT_OK(bcc_wrapper.InitBPFProgram(program));
+
+  const std::filesystem::path cgroup_path =
+      system::Config::GetInstance().sysfs_path() / "fs/cgroup";
+  const CGroupProgramSpec kSpecs[] = {
+      {cgroup_path, BPF_CGROUP_INET_INGRESS, "count_packets"},
+      {cgroup_path, BPF_CGROUP_INET_EGRESS, "count_packets"},
+  };
+  ASSERT_OK(bcc_wrapper.AttachCGroupPrograms(kSpecs));
+  bcc_wrapper.Close();
+}
+
 TEST(BCCWrapper, Tracepoint) {
   bpf_tools::BCCWrapper bcc_wrapper;
 
@@ -21,8 +21,12 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 
+#include <absl/strings/ascii.h>
+#include <absl/strings/str_join.h>
+
 #include "src/common/base/base.h"
 #include "src/stirling/bpf_tools/probe_cleaner.h"
 
@@ -72,7 +76,29 @@ Status RemoveProbes(const char* file_path, std::vector<std::string> probes) {
     return error::Internal("Failed to open file for writing: $0", file_path);
   }
 
-  std::vector<std::string> errors;
+  // The kernel runs each line of a write as a command, so the probes are removed in batches of
+  // lines, with far fewer writes than probes. The kernel parses writes in chunks of 4KB
+  // (WRITE_BUFSIZE), so batches are kept within that.
+  constexpr size_t kMaxBatchBytes = 4096;
+
+  // The kernel stops at the first command of a write that fails (e.g. a probe that is still in
+  // use), so a batch that fails is retried one command at a time, to remove all the others.
+  auto write_batch = [fd, file_path](const std::vector<std::string>& batch) {
+    std::string cmds = absl::StrJoin(batch, "");
+    if (write(fd, cmds.data(), cmds.size()) >= 0) {
+      return;
+    }
+    for (const auto& delete_probe : batch) {
+      if (write(fd, delete_probe.data(), delete_probe.size()) < 0) {
+        VLOG(1) << absl::Substitute("Failed to write '$0' to file: $1 [errno=$2 message=$3]",
+                                    absl::StripTrailingAsciiWhitespace(delete_probe), file_path,
+                                    errno, std::strerror(errno));
+      }
+    }
+  };
+
+  std::vector<std::string> batch;
+  size_t batch_bytes = 0;
   for (auto& probe : probes) {
     std::vector<std::string_view> parts = absl::StrSplit(probe, absl::MaxSplits(':', 1));
     if (parts.size() != 2) {
@@ -80,16 +106,22 @@ Status RemoveProbes(const char* file_path, std::vector<std::string> probes) {
       continue;
     }
 
-    std::string delete_probe = absl::StrCat("-:", parts[1]);
-    VLOG(1) << absl::Substitute("Writing $0", delete_probe);
+    std::string delete_probe = absl::StrCat("-:", parts[1], "\n");
+    VLOG(1) << absl::Substitute("Writing $0", parts[1]);
 
-    if (write(fd, delete_probe.data(), delete_probe.size()) < 0) {
-      VLOG(1) << absl::Substitute("Failed to write '$0' to file: $1 [errno=$2 message=$3]",
-                                  delete_probe, file_path, errno, std::strerror(errno));
+    if (batch_bytes + delete_probe.size() > kMaxBatchBytes && !batch.empty()) {
+      write_batch(batch);
+      batch.clear();
+      batch_bytes = 0;
     }
+    batch_bytes += delete_probe.size();
+    batch.push_back(std::move(delete_probe));
     // Note that even if write succeeds, it doesn't confirm that the probe was properly removed.
     // We can only confirm that we wrote to the file.
   }
+  if (!batch.empty()) {
+    write_batch(batch);
+  }
 
   close(fd);
 
@@ -120,8 +152,16 @@ Status CleanProbesFromSysFile(const char* file_path, std::string_view marker) {
 }  // namespace
 
 Status CleanProbes(std::string_view marker) {
-  PL_RETURN_IF_ERROR(CleanProbesFromSysFile(kAttachedKProbesFile, marker));
-  PL_RETURN_IF_ERROR(CleanProbesFromSysFile(kAttachedUProbesFile, marker));
+  // The kprobes and uprobes are in different files, so they are cleaned up in parallel.
+  Status uprobes_status;
+  std::thread uprobes_thread([&uprobes_status, marker]() {
+    uprobes_status = CleanProbesFromSysFile(kAttachedUProbesFile, marker);
+  });
+  Status kprobes_status = CleanProbesFromSysFile(kAttachedKProbesFile, marker);
+  uprobes_thread.join();
+
+  PL_RETURN_IF_ERROR(kprobes_status);
+  PL_RETURN_IF_ERROR(uprobes_status);
   return Status::OK();
 }
 
@@ -47,7 +47,7 @@ Status SearchForAttachedProbes(const char* file_path, std::string_view marker,
  *
  * Note that this does not confirm that the probes exist,
  * or even that they were successfully removed.
- * It simply issues the commands to the sysfs file to remove the probes.
+ * It simply issues the commands to the sysfs file to remove the probes, many per write.
  *
  * @param probes vector of probes to remove.
  * @return error if there were issues accessing sysfs.
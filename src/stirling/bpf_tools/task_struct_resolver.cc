@@ -19,12 +19,20 @@
 #include "src/stirling/bpf_tools/task_struct_resolver.h"
 
 #include <poll.h>
+#include <sys/utsname.h>
 
+#include <cstring>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+
 #include "src/common/base/base.h"
+#include "src/common/fs/fs_wrapper.h"
+#include "src/common/system/config.h"
 #include "src/common/system/proc_parser.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/bpf_tools/macros.h"
@@ -293,6 +301,248 @@ StatusOr<TaskStructOffsets> ResolveTaskStructOffsets() {
   }
 }
 
+namespace {
+
+// The layout of BTF data, from include/uapi/linux/btf.h.
+constexpr uint16_t kBTFMagic = 0xeB9F;
+
+struct BTFHeader {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t flags;
+  uint32_t hdr_len;
+  uint32_t type_off;
+  uint32_t type_len;
+  uint32_t str_off;
+  uint32_t str_len;
+};
+
+struct BTFType {
+  uint32_t name_off;
+  // Bits 0-15: vlen, bits 24-28: kind, bit 31: kind_flag.
+  uint32_t info;
+  uint32_t size_or_type;
+};
+
+struct BTFMember {
+  uint32_t name_off;
+  uint32_t type;
+  // The bit offset; with kind_flag set, only bits 0-23 (the high bits are the bitfield size).
+  uint32_t offset;
+};
+
+enum BTFKind : uint32_t {
+  kBTFKindStruct = 4,
+  kBTFKindUnion = 5,
+};
+
+template <typename T>
+T ReadBTF(std::string_view data, size_t pos) {
+  T val;
+  std::memcpy(&val, data.data() + pos, sizeof(T));
+  return val;
+}
+
+uint32_t BTFKindOf(const BTFType& t) { return (t.info >> 24) & 0x1f; }
+uint32_t BTFVlenOf(const BTFType& t) { return t.info & 0xffff; }
+
+// Returns the size of the data that follows a btf_type of the kind.
+StatusOr<size_t> BTFTypeDataSize(uint32_t kind, uint32_t vlen) {
+  switch (kind) {
+    // PTR, FWD, TYPEDEF, VOLATILE, CONST, RESTRICT, FUNC, FLOAT, TYPE_TAG.
+    case 2:
+    case 7:
+    case 8:
+    case 9:
+    case 10:
+    case 11:
+    case 12:
+    case 16:
+    case 18:
+      return 0;
+    // INT, VAR, DECL_TAG.
+    case 1:
+    case 14:
+    case 17:
+      return 4;
+    // ARRAY.
+    case 3:
+      return 12;
+    // STRUCT, UNION, DATASEC, ENUM64.
+    case 4:
+    case 5:
+    case 15:
+    case 19:
+      return 12 * vlen;
+    // ENUM, FUNC_PROTO.
+    case 6:
+    case 13:
+      return 8 * vlen;
+    default:
+      return error::Internal("Unknown BTF kind $0.", kind);
+  }
+}
+
+class BTFTypes {
+ public:
+  Status Init(std::string_view btf) {
+    if (btf.size() < sizeof(BTFHeader)) {
+      return error::Internal("BTF data is too short.");
+    }
+    auto hdr = ReadBTF<BTFHeader>(btf, 0);
+    if (hdr.magic != kBTFMagic) {
+      return error::Internal("Unexpected BTF magic $0.", hdr.magic);
+    }
+    if (uint64_t{hdr.hdr_len} + hdr.type_off + hdr.type_len > btf.size() ||
+        uint64_t{hdr.hdr_len} + hdr.str_off + hdr.str_len > btf.size()) {
+      return error::Internal("BTF sections are out of bounds.");
+    }
+    types_ = btf.substr(hdr.hdr_len + hdr.type_off, hdr.type_len);
+    strs_ = btf.substr(hdr.hdr_len + hdr.str_off, hdr.str_len);
+
+    // Type ID 0 is void, and has no entry.
+    type_offsets_ = {0};
+    size_t pos = 0;
+    while (pos < types_.size()) {
+      if (pos + sizeof(BTFType) > types_.size()) {
+        return error::Internal("BTF type section is truncated.");
+      }
+      auto t = ReadBTF<BTFType>(types_, pos);
+      PL_ASSIGN_OR_RETURN(size_t data_size, BTFTypeDataSize(BTFKindOf(t), BTFVlenOf(t)));
+      if (pos + sizeof(BTFType) + data_size > types_.size()) {
+        return error::Internal("BTF type section is truncated.");
+      }
+      type_offsets_.push_back(pos);
+      pos += sizeof(BTFType) + data_size;
+    }
+    return Status::OK();
+  }
+
+  // Returns the ID of the struct with the name, or 0 if there is none.
+  uint32_t FindStruct(std::string_view name) const {
+    for (uint32_t id = 1; id < type_offsets_.size(); ++id) {
+      auto t = ReadBTF<BTFType>(types_, type_offsets_[id]);
+      if (BTFKindOf(t) == kBTFKindStruct && Name(t.name_off) == name) {
+        return id;
+      }
+    }
+    return 0;
+  }
+
+  // Returns the byte offset of the member of the struct or union, including the members of its
+  // anonymous struct and union members, which task_struct has with randomized layouts.
+  std::optional<uint64_t> FindMemberOffset(uint32_t type_id, std::string_view name,
+                                           int depth = 0) const {
+    constexpr int kMaxDepth = 8;
+    if (type_id == 0 || type_id >= type_offsets_.size() || depth > kMaxDepth) {
+      return std::nullopt;
+    }
+    size_t pos = type_offsets_[type_id];
+    auto t = ReadBTF<BTFType>(types_, pos);
+    if (BTFKindOf(t) != kBTFKindStruct && BTFKindOf(t) != kBTFKindUnion) {
+      return std::nullopt;
+    }
+    bool kind_flag = t.info >> 31;
+    for (uint32_t i = 0; i < BTFVlenOf(t); ++i) {
+      auto m = ReadBTF<BTFMember>(types_, pos + sizeof(BTFType) + i * sizeof(BTFMember));
+      uint64_t bit_offset = kind_flag ? (m.offset & 0xffffff) : m.offset;
+      std::string_view member_name = Name(m.name_off);
+      if (member_name == name) {
+        return bit_offset / 8;
+      }
+      if (member_name.empty()) {
+        std::optional<uint64_t> offset = FindMemberOffset(m.type, name, depth + 1);
+        if (offset.has_value()) {
+          return bit_offset / 8 + offset.value();
+        }
+      }
+    }
+    return std::nullopt;
+  }
+
+ private:
+  std::string_view Name(uint32_t name_off) const {
+    if (name_off >= strs_.size()) {
+      return {};
+    }
+    size_t end = strs_.find('\0', name_off);
+    return strs_.substr(name_off, end == std::string_view::npos ? end : end - name_off);
+  }
+
+  std::string_view types_;
+  std::string_view strs_;
+  std::vector<size_t> type_offsets_;
+};
+
+}  // namespace
+
+StatusOr<TaskStructOffsets> FindTaskStructOffsetsInBTF(std::string_view btf) {
+  BTFTypes types;
+  PL_RETURN_IF_ERROR(types.Init(btf));
+
+  uint32_t task_struct_id = types.FindStruct("task_struct");
+  if (task_struct_id == 0) {
+    return error::NotFound("No task_struct in BTF.");
+  }
+
+  // real_start_time was renamed to start_boottime in Linux 5.5.
+  std::optional<uint64_t> real_start_time =
+      types.FindMemberOffset(task_struct_id, "start_boottime");
+  if (!real_start_time.has_value()) {
+    real_start_time = types.FindMemberOffset(task_struct_id, "real_start_time");
+  }
+  std::optional<uint64_t> group_leader = types.FindMemberOffset(task_struct_id, "group_leader");
+  if (!real_start_time.has_value() || !group_leader.has_value()) {
+    return error::NotFound("Could not find the task_struct members in BTF.");
+  }
+
+  TaskStructOffsets offsets;
+  offsets.real_start_time_offset = real_start_time.value();
+  offsets.group_leader_offset = group_leader.value();
+  return offsets;
+}
+
+StatusOr<TaskStructOffsets> ResolveTaskStructOffsetsFromBTF() {
+  std::filesystem::path btf_path =
+      system::Config::GetInstance().sysfs_path() / "kernel/btf/vmlinux";
+  PL_RETURN_IF_ERROR(fs::Exists(btf_path));
+  PL_ASSIGN_OR_RETURN(std::string btf, ReadFileToString(btf_path));
+  return FindTaskStructOffsetsInBTF(btf);
+}
+
+std::string KernelBuildID() {
+  struct utsname buf;
+  if (uname(&buf) != 0) {
+    return "";
+  }
+  // The version holds the build number and time, which tell apart builds of the same release.
+  return absl::StrCat(buf.release, " ", buf.version, " ", buf.machine);
+}
+
+std::string SerializeTaskStructOffsets(std::string_view kernel_build_id,
+                                       const TaskStructOffsets& offsets) {
+  return absl::Substitute("$0\n$1 $2\n", kernel_build_id, offsets.real_start_time_offset,
+                          offsets.group_leader_offset);
+}
+
+StatusOr<TaskStructOffsets> ParseTaskStructOffsets(std::string_view contents,
+                                                   std::string_view kernel_build_id) {
+  std::vector<std::string_view> lines = absl::StrSplit(contents, '\n', absl::SkipEmpty());
+  if (lines.size() != 2) {
+    return error::Internal("Expected 2 lines, got $0.", lines.size());
+  }
+  if (lines[0] != kernel_build_id) {
+    return error::NotFound("The offsets were resolved on kernel $0.", lines[0]);
+  }
+  std::vector<std::string_view> fields = absl::StrSplit(lines[1], ' ');
+  TaskStructOffsets offsets;
+  if (fields.size() != 2 || !absl::SimpleAtoi(fields[0], &offsets.real_start_time_offset) ||
+      !absl::SimpleAtoi(fields[1], &offsets.group_leader_offset)) {
+    return error::Internal("Malformed offsets: $0", lines[1]);
+  }
+  return offsets;
+}
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include "src/common/base/base.h"
 
@@ -67,6 +68,39 @@ StatusOr<TaskStructOffsets> ResolveTaskStructOffsets();
  */
 StatusOr<TaskStructOffsets> ResolveTaskStructOffsetsCore();
 
+/**
+ * Reads the task struct offsets from the BTF type information of the running kernel
+ * (/sys/kernel/btf/vmlinux), which kernels built with CONFIG_DEBUG_INFO_BTF provide.
+ * Unlike ResolveTaskStructOffsets(), this does not need to run a BPF program.
+ */
+StatusOr<TaskStructOffsets> ResolveTaskStructOffsetsFromBTF();
+
+/**
+ * Finds the task struct offsets in raw BTF data, as in /sys/kernel/btf/vmlinux.
+ * This is exposed for testing purposes only.
+ */
+StatusOr<TaskStructOffsets> FindTaskStructOffsetsInBTF(std::string_view btf);
+
+/**
+ * Returns a string that identifies the build of the running kernel. The task_struct offsets
+ * only change with it.
+ */
+std::string KernelBuildID();
+
+/**
+ * Serializes the offsets resolved on the kernel build identified by kernel_build_id,
+ * so that they can be reused by later runs on the same kernel.
+ */
+std::string SerializeTaskStructOffsets(std::string_view kernel_build_id,
+                                       const TaskStructOffsets& offsets);
+
+/**
+ * Parses the output of SerializeTaskStructOffsets(). Fails if the offsets were resolved on a
+ * different kernel build.
+ */
+StatusOr<TaskStructOffsets> ParseTaskStructOffsets(std::string_view contents,
+                                                   std::string_view kernel_build_id);
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
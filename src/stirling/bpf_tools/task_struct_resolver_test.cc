@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/bpf_tools/task_struct_resolver.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+TEST(TaskStructOffsetsSerializationTest, RoundTrip) {
+  constexpr std::string_view kKernel = "5.4.0-1059-gke #62-Ubuntu SMP Thu Nov 25 10:24:41 x86_64";
+
+  TaskStructOffsets offsets;
+  offsets.real_start_time_offset = 2256;
+  offsets.group_leader_offset = 1888;
+  std::string contents = SerializeTaskStructOffsets(kKernel, offsets);
+
+  ASSERT_OK_AND_EQ(ParseTaskStructOffsets(contents, kKernel), offsets);
+  EXPECT_NOT_OK(ParseTaskStructOffsets(contents, "5.4.0-1060-gke #63-Ubuntu SMP x86_64"));
+  EXPECT_NOT_OK(ParseTaskStructOffsets("", kKernel));
+  EXPECT_NOT_OK(ParseTaskStructOffsets(absl::StrCat(kKernel, "\n2256\n"), kKernel));
+}
+
+namespace {
+
+// The header of BTF data, as in include/uapi/linux/btf.h.
+struct BTFTestHeader {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t flags;
+  uint32_t hdr_len;
+  uint32_t type_off;
+  uint32_t type_len;
+  uint32_t str_off;
+  uint32_t str_len;
+};
+
+// Builds BTF data with the types and strings sections.
+std::string MakeBTF(const std::vector<uint32_t>& types, std::string_view strs) {
+  BTFTestHeader hdr = {};
+  hdr.magic = 0xeB9F;
+  hdr.version = 1;
+  hdr.hdr_len = sizeof(hdr);
+  hdr.type_off = 0;
+  hdr.type_len = types.size() * sizeof(uint32_t);
+  hdr.str_off = hdr.type_len;
+  hdr.str_len = strs.size();
+
+  std::string btf(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  btf.append(reinterpret_cast<const char*>(types.data()), hdr.type_len);
+  btf.append(strs);
+  return btf;
+}
+
+}  // namespace
+
+TEST(FindTaskStructOffsetsInBTFTest, AnonymousMembers) {
+  constexpr std::string_view kStrs("\0int\0task_struct\0state\0group_leader\0start_boottime\0", 51);
+  // The offsets of the names in kStrs.
+  constexpr uint32_t kInt = 1;
+  constexpr uint32_t kTaskStruct = 5;
+  constexpr uint32_t kState = 17;
+  constexpr uint32_t kGroupLeader = 23;
+  constexpr uint32_t kStartBoottime = 36;
+  constexpr uint32_t kStructKindVlen2 = (4 << 24) | 2;
+
+  // clang-format off
+  const std::vector<uint32_t> types = {
+      // [1] int: name, info (kind INT), size, encoding.
+      kInt, 1 << 24, 4, 32,
+      // [2] struct task_struct: name, info, size, then the members: name, type, bit offset.
+      kTaskStruct, kStructKindVlen2, 4096,
+      kState, 1, 0,
+      0, 3, 1024 * 8,
+      // [3] anonymous struct of the randomized layout.
+      0, kStructKindVlen2, 2048,
+      kGroupLeader, 1, 904 * 8,
+      kStartBoottime, 1, 1320 * 8,
+  };
+  // clang-format on
+
+  ASSERT_OK_AND_ASSIGN(TaskStructOffsets offsets,
+                       FindTaskStructOffsetsInBTF(MakeBTF(types, kStrs)));
+  EXPECT_EQ(offsets.group_leader_offset, 1024 + 904);
+  EXPECT_EQ(offsets.real_start_time_offset, 1024 + 1320);
+
+  EXPECT_NOT_OK(FindTaskStructOffsetsInBTF("not btf"));
+  // Without the anonymous struct, the members are not found.
+  EXPECT_NOT_OK(FindTaskStructOffsetsInBTF(
+      MakeBTF(std::vector<uint32_t>(types.begin(), types.begin() + 13), kStrs)));
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -18,6 +18,8 @@
 
 #include "src/stirling/core/connector_context.h"
 
+#include <absl/hash/hash.h>
+
 namespace px {
 namespace stirling {
 
@@ -68,5 +70,19 @@ absl::flat_hash_set<md::UPID> ListUPIDs(const std::filesystem::path& proc_path,
   return pids;
 }
 
+void ConnectorContext::DiffUPIDs(const ConnectorContext* prev) {
+  upids_delta_ = ComputeUPIDsDelta(GetUPIDs(), GetUPIDsVersion(),
+                                   prev != nullptr ? prev->GetUPIDsDelta().get() : nullptr);
+}
+
+uint64_t UPIDsFingerprint(const absl::flat_hash_set<md::UPID>& upids) {
+  // Summing the hashes makes the fingerprint independent of the iteration order.
+  uint64_t fingerprint = upids.size();
+  for (const auto& upid : upids) {
+    fingerprint += absl::Hash<md::UPID>{}(upid);
+  }
+  return fingerprint;
+}
+
 }  // namespace stirling
 }  // namespace px
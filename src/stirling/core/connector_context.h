@@ -37,6 +37,11 @@ namespace stirling {
  */
 absl::flat_hash_set<md::UPID> ListUPIDs(const std::filesystem::path& proc_path, uint32_t asid = 0);
 
+/**
+ * Returns a hash of the set of UPIDs, which does not depend on the order of the set.
+ */
+uint64_t UPIDsFingerprint(const absl::flat_hash_set<md::UPID>& upids);
+
 /**
  * ConnectorContext is the information passed on every Transfer call to source connectors.
  */
@@ -54,10 +59,32 @@ class ConnectorContext {
    */
   virtual const absl::flat_hash_set<md::UPID>& GetUPIDs() const = 0;
 
+  /**
+   * Returns a version of the UPIDs returned by GetUPIDs(), which changes whenever the UPIDs do.
+   * Consumers that track the UPIDs across calls can skip diffing them while it stays the same.
+   * Computed once per context, as a fingerprint of the UPIDs, because metadata epochs also change
+   * without the UPIDs changing, and states built outside of the state manager share epoch 0.
+   */
+  virtual uint64_t GetUPIDsVersion() const = 0;
+
+  /**
+   * Returns the UPIDs in sorted order, and how they differ from the UPIDs of the context that
+   * preceded this one, or nullptr if DiffUPIDs() was not called. Computed once per context, so
+   * that each connector with a ProcTracker applies the delta instead of diffing all the UPIDs.
+   * Shared, so that work that outlives the context can hold on to it.
+   */
+  const std::shared_ptr<const UPIDsDelta>& GetUPIDsDelta() const { return upids_delta_; }
+
+  /**
+   * Computes the delta returned by GetUPIDsDelta() relative to the previous context, which may be
+   * nullptr. Must be called before the context is shared with the connectors.
+   */
+  void DiffUPIDs(const ConnectorContext* prev);
+
   /**
    * Return detailed information on UPIDs.
    */
-  virtual const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const = 0;
+  virtual const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr>& GetPIDInfoMap() const = 0;
 
   /**
    * Return K8s information (Pod and container information)
@@ -72,6 +99,9 @@ class ConnectorContext {
    * tracing.
    */
   virtual std::vector<CIDRBlock> GetClusterCIDRs() = 0;
+
+ private:
+  std::shared_ptr<const UPIDsDelta> upids_delta_;
 };
 
 /**
@@ -87,6 +117,7 @@ class AgentContext : public ConnectorContext {
   explicit AgentContext(std::shared_ptr<const md::AgentMetadataState> agent_metadata_state)
       : agent_metadata_state_(std::move(agent_metadata_state)) {
     DCHECK(agent_metadata_state_ != nullptr);
+    upids_version_ = UPIDsFingerprint(agent_metadata_state_->upids());
   }
 
   uint32_t GetASID() const override { return agent_metadata_state_->asid(); }
@@ -95,7 +126,9 @@ class AgentContext : public ConnectorContext {
     return agent_metadata_state_->upids();
   }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
+  uint64_t GetUPIDsVersion() const override { return upids_version_; }
+
+  const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr>& GetPIDInfoMap() const override {
     return agent_metadata_state_->pids_by_upid();
   }
 
@@ -107,6 +140,7 @@ class AgentContext : public ConnectorContext {
 
  private:
   std::shared_ptr<const md::AgentMetadataState> agent_metadata_state_;
+  uint64_t upids_version_ = 0;
 };
 
 /**
@@ -117,6 +151,7 @@ class StandaloneContext : public ConnectorContext {
   StandaloneContext() {
     // The context consists of all PIDs, but no pods/containers.
     upids_ = ListUPIDs(system::Config::GetInstance().proc_path(), 0);
+    upids_version_ = UPIDsFingerprint(upids_);
 
     // Cannot be empty, otherwise stirling will wait indefinitely. Since StandaloneContext is used
     // for local environment, set it such that localhost (127.0.0.1) will be treated as outside of
@@ -129,8 +164,10 @@ class StandaloneContext : public ConnectorContext {
 
   const absl::flat_hash_set<md::UPID>& GetUPIDs() const override { return upids_; }
 
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& GetPIDInfoMap() const override {
-    static const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr> kEmpty;
+  uint64_t GetUPIDsVersion() const override { return upids_version_; }
+
+  const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr>& GetPIDInfoMap() const override {
+    static const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr> kEmpty;
     return kEmpty;
   }
 
@@ -146,6 +183,7 @@ class StandaloneContext : public ConnectorContext {
  private:
   std::vector<CIDRBlock> cidrs_;
   absl::flat_hash_set<md::UPID> upids_;
+  uint64_t upids_version_ = 0;
 };
 
 }  // namespace stirling
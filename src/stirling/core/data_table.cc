@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "src/common/base/base.h"
+#include "src/shared/types/column_wrapper_pool.h"
 #include "src/shared/types/type_utils.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/core/types.h"
@@ -30,6 +31,19 @@
 namespace px {
 namespace stirling {
 
+namespace {
+
+bool IsIdentity(const std::vector<size_t>& indexes) {
+  for (size_t i = 0; i < indexes.size(); ++i) {
+    if (indexes[i] != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
 using types::ColumnWrapper;
 using types::DataType;
 
@@ -42,12 +56,9 @@ void DataTable::InitBuffers(types::ColumnWrapperRecordBatch* record_batch_ptr) {
   for (const auto& element : table_schema_.elements()) {
     px::types::DataType type = element.type();
 
-#define TYPE_CASE(_dt_)                           \
-  auto col = types::ColumnWrapper::Make(_dt_, 0); \
-  col->Reserve(kTargetCapacity);                  \
-  record_batch_ptr->push_back(col);
-    PL_SWITCH_FOREACH_DATATYPE(type, TYPE_CASE);
-#undef TYPE_CASE
+    // Columns are recycled by the table store once it no longer needs them.
+    record_batch_ptr->push_back(
+        types::ColumnWrapperPool::Global()->Acquire(type, kTargetCapacity));
   }
 }
 
@@ -93,14 +104,20 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
 
     // Case 2: Pushable records. Copy to output.
     if (num_pushable > 0) {
-      // TODO(oazizi): Consider VectorView to avoid copying.
-      std::vector<size_t> push_indexes(sort_indexes.begin() + num_expired,
-                                       sort_indexes.end() - num_carryover);
+      uint64_t last_time = tablet.times[sort_indexes[num_expired + num_pushable - 1]];
       types::ColumnWrapperRecordBatch pushable_records;
-      for (auto& col : tablet.records) {
-        pushable_records.push_back(col->MoveIndexes(push_indexes));
+      if (num_expired == 0 && num_carryover == 0 && IsIdentity(sort_indexes)) {
+        // The records are all pushed in the order they were written, so the columns are handed
+        // over as is, instead of being copied.
+        pushable_records = std::move(tablet.records);
+      } else {
+        // TODO(oazizi): Consider VectorView to avoid copying.
+        std::vector<size_t> push_indexes(sort_indexes.begin() + num_expired,
+                                         sort_indexes.end() - num_carryover);
+        for (auto& col : tablet.records) {
+          pushable_records.push_back(col->MoveIndexes(push_indexes));
+        }
       }
-      uint64_t last_time = tablet.times[push_indexes.back()];
       next_start_time = std::max(next_start_time, last_time);
       tablets_out.push_back(TaggedRecordBatch{tablet_id, std::move(pushable_records)});
     }
@@ -123,6 +140,11 @@ std::vector<TaggedRecordBatch> DataTable::ConsumeRecords() {
           Tablet{tablet_id, std::move(times), std::move(carryover_records)};
     }
   }
+  for (auto& [tablet_id, tablet] : tablets_) {
+    for (auto& col : tablet.records) {
+      types::ColumnWrapperPool::Global()->Release(std::move(col));
+    }
+  }
   tablets_ = std::move(carryover_tablets);
 
   start_time_ = next_start_time;
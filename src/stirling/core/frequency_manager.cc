@@ -18,6 +18,10 @@
 
 #include "src/stirling/core/frequency_manager.h"
 
+#include <algorithm>
+
+#include "src/common/base/base.h"
+
 namespace px {
 namespace stirling {
 
@@ -26,5 +30,55 @@ void FrequencyManager::Reset() {
   ++count_;
 }
 
+AdaptivePeriodController::AdaptivePeriodController(std::chrono::milliseconds base_period,
+                                                   std::chrono::milliseconds min_period,
+                                                   std::chrono::milliseconds max_period)
+    : base_period_(std::clamp(base_period, min_period, max_period)),
+      min_period_(min_period),
+      max_period_(max_period) {
+  DCHECK_LE(min_period.count(), max_period.count());
+  DCHECK_GT(min_period.count(), 0);
+}
+
+AdaptivePeriodController::Decision AdaptivePeriodController::Update(const Load& load,
+                                                                    FrequencyManager* freq_mgr) {
+  const std::chrono::milliseconds period = freq_mgr->period();
+
+  if (load.lost > 0) {
+    idle_cycles_ = 0;
+    loss_free_cycles_ = 0;
+    if (period <= min_period_) {
+      return Decision::kKeep;
+    }
+    freq_mgr->set_period(std::max(min_period_, period / 2));
+    ++num_shortened_;
+    return Decision::kShorten;
+  }
+
+  ++loss_free_cycles_;
+  const bool idle = load.buffer_occupancy <= kIdleBufferOccupancy &&
+                    load.table_occupancy <= kIdleTableOccupancy;
+  idle_cycles_ = idle ? idle_cycles_ + 1 : 0;
+
+  std::chrono::milliseconds limit;
+  if (idle_cycles_ >= kIdleCyclesToLengthen) {
+    limit = max_period_;
+  } else if (loss_free_cycles_ >= kLossFreeCyclesToRestore) {
+    limit = base_period_;
+  } else {
+    return Decision::kKeep;
+  }
+  if (period >= limit) {
+    return Decision::kKeep;
+  }
+  idle_cycles_ = 0;
+  loss_free_cycles_ = 0;
+  // Grow by at least 1ms, so that short periods don't get stuck.
+  freq_mgr->set_period(std::min(limit, std::max(period + std::chrono::milliseconds{1},
+                                                period + period / 4)));
+  ++num_lengthened_;
+  return Decision::kLengthen;
+}
+
 }  // namespace stirling
 }  // namespace px
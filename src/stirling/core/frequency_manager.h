@@ -19,6 +19,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 
 #include "src/common/system/clock.h"
 
@@ -56,5 +57,56 @@ class FrequencyManager {
   uint32_t count_ = 0;
 };
 
+/**
+ * Adapts the period of a FrequencyManager to the load observed by each cycle, within
+ * [min_period, max_period]:
+ *  - The period is halved as soon as a cycle lost data.
+ *  - It grows by a quarter, up to max_period, after kIdleCyclesToLengthen consecutive idle cycles.
+ *  - It grows by a quarter, up to base_period, after kLossFreeCyclesToRestore consecutive cycles
+ *    without loss, so that a burst doesn't pin the period at its minimum.
+ */
+class AdaptivePeriodController {
+ public:
+  // What a cycle observed.
+  struct Load {
+    // The fraction of the source's buffers that had data pending when they were polled.
+    double buffer_occupancy = 0;
+    // The number of events lost by the source's buffers.
+    uint64_t lost = 0;
+    // The highest DataTable::OccupancyPct() of the source's tables.
+    double table_occupancy = 0;
+  };
+
+  enum class Decision { kKeep, kShorten, kLengthen };
+
+  static constexpr int kIdleCyclesToLengthen = 10;
+  static constexpr int kLossFreeCyclesToRestore = 50;
+  // A cycle is idle if it didn't lose data, and neither occupancy is above these.
+  static constexpr double kIdleBufferOccupancy = 0.25;
+  static constexpr double kIdleTableOccupancy = 0.5;
+
+  AdaptivePeriodController(std::chrono::milliseconds base_period,
+                           std::chrono::milliseconds min_period,
+                           std::chrono::milliseconds max_period);
+
+  /**
+   * Accounts for the load of the cycle that just ended, and updates the period of freq_mgr.
+   */
+  Decision Update(const Load& load, FrequencyManager* freq_mgr);
+
+  uint64_t num_shortened() const { return num_shortened_; }
+  uint64_t num_lengthened() const { return num_lengthened_; }
+
+ private:
+  const std::chrono::milliseconds base_period_;
+  const std::chrono::milliseconds min_period_;
+  const std::chrono::milliseconds max_period_;
+
+  int idle_cycles_ = 0;
+  int loss_free_cycles_ = 0;
+  uint64_t num_shortened_ = 0;
+  uint64_t num_lengthened_ = 0;
+};
+
 }  // namespace stirling
 }  // namespace px
@@ -49,5 +49,59 @@ TEST(FrequencyManagerTest, SetPeriodEndAndCheck) {
   EXPECT_GE(computed_period, std::chrono::milliseconds{9990});
 }
 
+using Decision = AdaptivePeriodController::Decision;
+
+// Tests that the period is halved, down to the minimum, whenever data is lost.
+TEST(AdaptivePeriodControllerTest, ShortenOnLoss) {
+  FrequencyManager mgr;
+  mgr.set_period(std::chrono::milliseconds{200});
+  AdaptivePeriodController controller(mgr.period(), std::chrono::milliseconds{50},
+                                      std::chrono::milliseconds{400});
+
+  AdaptivePeriodController::Load lossy{.buffer_occupancy = 1, .lost = 10};
+  EXPECT_EQ(controller.Update(lossy, &mgr), Decision::kShorten);
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{100});
+  EXPECT_EQ(controller.Update(lossy, &mgr), Decision::kShorten);
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{50});
+  EXPECT_EQ(controller.Update(lossy, &mgr), Decision::kKeep);
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{50});
+  EXPECT_EQ(controller.num_shortened(), 2U);
+
+  // Busy cycles without loss eventually restore the base period, but don't go past it.
+  AdaptivePeriodController::Load busy{.buffer_occupancy = 1};
+  for (int i = 0; i < 10 * AdaptivePeriodController::kLossFreeCyclesToRestore; ++i) {
+    controller.Update(busy, &mgr);
+  }
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{200});
+  EXPECT_EQ(controller.num_shortened(), 2U);
+  EXPECT_GT(controller.num_lengthened(), 0U);
+}
+
+// Tests that the period only grows after consecutive idle cycles, up to the maximum.
+TEST(AdaptivePeriodControllerTest, LengthenWhenIdle) {
+  FrequencyManager mgr;
+  mgr.set_period(std::chrono::milliseconds{200});
+  AdaptivePeriodController controller(mgr.period(), std::chrono::milliseconds{50},
+                                      std::chrono::milliseconds{400});
+
+  AdaptivePeriodController::Load idle;
+  AdaptivePeriodController::Load full_table{.table_occupancy = 0.9};
+  for (int i = 0; i < AdaptivePeriodController::kIdleCyclesToLengthen - 1; ++i) {
+    EXPECT_EQ(controller.Update(idle, &mgr), Decision::kKeep);
+  }
+  // A cycle that isn't idle starts the count over.
+  EXPECT_EQ(controller.Update(full_table, &mgr), Decision::kKeep);
+  for (int i = 0; i < AdaptivePeriodController::kIdleCyclesToLengthen - 1; ++i) {
+    EXPECT_EQ(controller.Update(idle, &mgr), Decision::kKeep);
+  }
+  EXPECT_EQ(controller.Update(idle, &mgr), Decision::kLengthen);
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{250});
+
+  for (int i = 0; i < 10 * AdaptivePeriodController::kIdleCyclesToLengthen; ++i) {
+    controller.Update(idle, &mgr);
+  }
+  EXPECT_EQ(mgr.period(), std::chrono::milliseconds{400});
+}
+
 }  // namespace stirling
 }  // namespace px
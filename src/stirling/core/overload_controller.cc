@@ -0,0 +1,144 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/core/overload_controller.h"
+
+#include <string>
+#include <vector>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+
+DEFINE_bool(stirling_overload_control,
+            gflags::BoolFromEnv("PL_STIRLING_OVERLOAD_CONTROL", true),
+            "If true, Stirling degrades its data collection step by step while its cgroup is "
+            "throttled for CPU, and undoes the steps once the throttling stops.");
+DEFINE_string(stirling_overload_cpu_stat_path, "",
+              "The cgroup cpu.stat file whose throttling counters drive the overload control. "
+              "Found from /proc/self/cgroup if empty.");
+
+namespace px {
+namespace stirling {
+
+Status ParseCPUStat(std::string_view contents, CPUThrottleStats* out) {
+  bool found_periods = false;
+  bool found_throttled = false;
+  for (std::string_view line : absl::StrSplit(contents, '\n', absl::SkipEmpty())) {
+    std::vector<std::string_view> fields = absl::StrSplit(line, ' ', absl::SkipEmpty());
+    if (fields.size() != 2) {
+      continue;
+    }
+    if (fields[0] == "nr_periods") {
+      found_periods = absl::SimpleAtoi(fields[1], &out->nr_periods);
+    } else if (fields[0] == "nr_throttled") {
+      found_throttled = absl::SimpleAtoi(fields[1], &out->nr_throttled);
+    }
+  }
+  if (!found_periods || !found_throttled) {
+    // The root cgroup, and cgroups without the CPU controller, have no throttling counters.
+    return error::NotFound("cpu.stat has no throttling counters.");
+  }
+  return Status::OK();
+}
+
+std::optional<std::filesystem::path> FindCPUStatPath() {
+  if (!FLAGS_stirling_overload_cpu_stat_path.empty()) {
+    return std::filesystem::path(FLAGS_stirling_overload_cpu_stat_path);
+  }
+
+  const std::filesystem::path kCGroupRoot = "/sys/fs/cgroup";
+  std::vector<std::filesystem::path> candidates;
+  StatusOr<std::string> self_cgroup = ReadFileToString("/proc/self/cgroup");
+  if (self_cgroup.ok()) {
+    // Each line is <hierarchy-id>:<controllers>:<path>. The cgroup v2 line has no controllers.
+    for (std::string_view line :
+         absl::StrSplit(self_cgroup.ValueOrDie(), '\n', absl::SkipEmpty())) {
+      std::vector<std::string_view> fields = absl::StrSplit(line, absl::MaxSplits(':', 2));
+      if (fields.size() != 3) {
+        continue;
+      }
+      std::string_view path = absl::StripPrefix(fields[2], "/");
+      if (fields[1].empty()) {
+        candidates.push_back(kCGroupRoot / path / "cpu.stat");
+        continue;
+      }
+      for (std::string_view controller : absl::StrSplit(fields[1], ',')) {
+        if (controller == "cpu") {
+          candidates.push_back(kCGroupRoot / fields[1] / path / "cpu.stat");
+        }
+      }
+    }
+  }
+  // With cgroup namespaces, the container's cgroup is mounted at the root.
+  candidates.push_back(kCGroupRoot / "cpu.stat");
+  candidates.push_back(kCGroupRoot / "cpu,cpuacct" / "cpu.stat");
+  candidates.push_back(kCGroupRoot / "cpu" / "cpu.stat");
+
+  for (const auto& candidate : candidates) {
+    StatusOr<std::string> contents = ReadFileToString(candidate);
+    CPUThrottleStats stats;
+    if (contents.ok() && ParseCPUStat(contents.ValueOrDie(), &stats).ok()) {
+      return candidate;
+    }
+  }
+  return std::nullopt;
+}
+
+OverloadController::OverloadController() {
+  auto& registry = utils::MetricsRegistry::Global();
+  constexpr std::string_view kHelp = "The steps of Stirling's overload degradation ladder.";
+  for (int i = 1; i < kNumLevels; ++i) {
+    std::string level(magic_enum::enum_name(static_cast<OverloadLevel>(i)));
+    num_steps_up_[i] = registry.GetCounter("stirling_overload_steps", kHelp,
+                                           {{"direction", "up"}, {"level", level}});
+    // Stepping down from level i enters level i - 1.
+    std::string lower_level(magic_enum::enum_name(static_cast<OverloadLevel>(i - 1)));
+    num_steps_down_[i - 1] = registry.GetCounter("stirling_overload_steps", kHelp,
+                                                 {{"direction", "down"}, {"level", lower_level}});
+  }
+}
+
+OverloadLevel OverloadController::Update(const Signals& signals) {
+  const bool overloaded = signals.throttled_fraction >= kOverloadedThrottledFraction ||
+                          signals.max_tick_overshoot >= kOverloadedTickOvershoot;
+  const bool calm = signals.throttled_fraction <= kCalmThrottledFraction &&
+                    signals.max_tick_overshoot <= kCalmTickOvershoot;
+  overloaded_evals_ = overloaded ? overloaded_evals_ + 1 : 0;
+  calm_evals_ = calm ? calm_evals_ + 1 : 0;
+
+  const int level = static_cast<int>(level_);
+  if (overloaded_evals_ >= kOverloadedEvalsToStepUp && level < kNumLevels - 1) {
+    overloaded_evals_ = 0;
+    level_ = static_cast<OverloadLevel>(level + 1);
+    num_steps_up_[level + 1]->Add();
+    LOG(WARNING) << absl::Substitute(
+        "Stirling is overloaded, stepping up to $0 [throttled_fraction=$1 tick_overshoot=$2ms]",
+        magic_enum::enum_name(level_), signals.throttled_fraction,
+        signals.max_tick_overshoot.count());
+  } else if (calm_evals_ >= kCalmEvalsToStepDown && level > 0) {
+    calm_evals_ = 0;
+    level_ = static_cast<OverloadLevel>(level - 1);
+    num_steps_down_[level - 1]->Add();
+    LOG(INFO) << absl::Substitute("Stirling load eased, stepping down to $0",
+                                  magic_enum::enum_name(level_));
+  }
+  return level_;
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+#include <magic_enum.hpp>
+
+#include "src/common/base/base.h"
+#include "src/stirling/utils/metrics.h"
+
+DECLARE_bool(stirling_overload_control);
+DECLARE_string(stirling_overload_cpu_stat_path);
+
+namespace px {
+namespace stirling {
+
+/**
+ * The steps of Stirling's degradation ladder, from least to most degraded. Each level also applies
+ * the degradations of the levels below it.
+ */
+enum class OverloadLevel {
+  kNone = 0,
+  // The socket tracer copies only the first bytes of each data event, enough for the headers.
+  kNoBodyCapture,
+  // Connectors with a fixed sampling period sample kOverloadSamplingPeriodFactor times less often.
+  kSlowSampling,
+  // Low priority connectors, see SourceConnector::IsLowPriority(), stop transferring data.
+  kLowPriorityPaused,
+  // The agent runs one query at a time.
+  kQueriesThrottled,
+};
+
+inline constexpr int kOverloadSamplingPeriodFactor = 4;
+
+/**
+ * The throttling counters of a cgroup's cpu.stat, which has the same fields in cgroup v1 and v2.
+ */
+struct CPUThrottleStats {
+  // The CFS enforcement periods that elapsed, and those in which the cgroup was throttled.
+  uint64_t nr_periods = 0;
+  uint64_t nr_throttled = 0;
+};
+
+/**
+ * Parses the contents of a cgroup cpu.stat file.
+ */
+Status ParseCPUStat(std::string_view contents, CPUThrottleStats* out);
+
+/**
+ * Returns the cpu.stat file of the cgroup that Stirling's process is in, as seen from inside its
+ * container, or std::nullopt if there is none, such as when the cgroup has no CPU limit.
+ */
+std::optional<std::filesystem::path> FindCPUStatPath();
+
+/**
+ * Steps Stirling up and down the degradation ladder, one level at a time, based on how much of the
+ * time its cgroup is throttled for CPU and on how late the source loops wake up:
+ *  - A step up follows kOverloadedEvalsToStepUp consecutive overloaded evaluations.
+ *  - A step down follows kCalmEvalsToStepDown consecutive calm evaluations. Calm requires both
+ *    signals to be well below their overload thresholds, so the level doesn't flap.
+ *
+ * Each step is counted in the stirling_overload_steps counter, labeled with the level that was
+ * entered and the direction of the step.
+ */
+class OverloadController {
+ public:
+  // What an evaluation observed.
+  struct Signals {
+    // The fraction of the CFS periods since the previous evaluation in which the cgroup was
+    // throttled.
+    double throttled_fraction = 0;
+    // How much later than planned the latest source loop woke up, at the most.
+    std::chrono::milliseconds max_tick_overshoot{0};
+  };
+
+  static constexpr int kOverloadedEvalsToStepUp = 3;
+  static constexpr int kCalmEvalsToStepDown = 6;
+  static constexpr double kOverloadedThrottledFraction = 0.25;
+  static constexpr double kCalmThrottledFraction = 0.05;
+  static constexpr std::chrono::milliseconds kOverloadedTickOvershoot{1000};
+  static constexpr std::chrono::milliseconds kCalmTickOvershoot{200};
+
+  OverloadController();
+
+  /**
+   * Accounts for the signals of the evaluation that just ended.
+   * @return The level to apply, which is at most one step away from the previous one.
+   */
+  OverloadLevel Update(const Signals& signals);
+
+  OverloadLevel level() const { return level_; }
+
+ private:
+  static constexpr int kNumLevels = magic_enum::enum_count<OverloadLevel>();
+
+  OverloadLevel level_ = OverloadLevel::kNone;
+  int overloaded_evals_ = 0;
+  int calm_evals_ = 0;
+
+  // Indexed by the level that was entered.
+  std::array<utils::Counter*, kNumLevels> num_steps_up_ = {};
+  std::array<utils::Counter*, kNumLevels> num_steps_down_ = {};
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "src/stirling/core/overload_controller.h"
+
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+TEST(ParseCPUStatTest, CGroupV2) {
+  constexpr std::string_view kCPUStat =
+      "usage_usec 1496343\n"
+      "user_usec 1080311\n"
+      "system_usec 416032\n"
+      "nr_periods 1000\n"
+      "nr_throttled 250\n"
+      "throttled_usec 5000000\n";
+  CPUThrottleStats stats;
+  ASSERT_OK(ParseCPUStat(kCPUStat, &stats));
+  EXPECT_EQ(stats.nr_periods, 1000);
+  EXPECT_EQ(stats.nr_throttled, 250);
+}
+
+TEST(ParseCPUStatTest, CGroupV1) {
+  CPUThrottleStats stats;
+  ASSERT_OK(ParseCPUStat("nr_periods 30\nnr_throttled 3\nthrottled_time 12345678\n", &stats));
+  EXPECT_EQ(stats.nr_periods, 30);
+  EXPECT_EQ(stats.nr_throttled, 3);
+}
+
+TEST(ParseCPUStatTest, NoThrottlingCounters) {
+  CPUThrottleStats stats;
+  EXPECT_NOT_OK(ParseCPUStat("usage_usec 1496343\nuser_usec 1080311\n", &stats));
+}
+
+constexpr OverloadController::Signals kOverloaded = {.throttled_fraction = 0.5};
+constexpr OverloadController::Signals kCalm = {};
+// Neither overloaded nor calm.
+constexpr OverloadController::Signals kBusy = {.throttled_fraction = 0.1};
+
+TEST(OverloadControllerTest, StepsUpOneLevelAtATime) {
+  OverloadController controller;
+  for (int i = 1; i < OverloadController::kOverloadedEvalsToStepUp; ++i) {
+    EXPECT_EQ(controller.Update(kOverloaded), OverloadLevel::kNone);
+  }
+  EXPECT_EQ(controller.Update(kOverloaded), OverloadLevel::kNoBodyCapture);
+
+  for (int i = 1; i < OverloadController::kOverloadedEvalsToStepUp; ++i) {
+    EXPECT_EQ(controller.Update(kOverloaded), OverloadLevel::kNoBodyCapture);
+  }
+  EXPECT_EQ(controller.Update(kOverloaded), OverloadLevel::kSlowSampling);
+
+  // Late wake ups of the source loops are also overload.
+  constexpr OverloadController::Signals kLate = {.max_tick_overshoot = std::chrono::seconds{2}};
+  for (int i = 0; i < 2 * OverloadController::kOverloadedEvalsToStepUp; ++i) {
+    controller.Update(kLate);
+  }
+  EXPECT_EQ(controller.level(), OverloadLevel::kQueriesThrottled);
+
+  // The top of the ladder is kept.
+  for (int i = 0; i < OverloadController::kOverloadedEvalsToStepUp; ++i) {
+    EXPECT_EQ(controller.Update(kOverloaded), OverloadLevel::kQueriesThrottled);
+  }
+}
+
+TEST(OverloadControllerTest, StepsDownOnlyWhenCalm) {
+  OverloadController controller;
+  for (int i = 0; i < 2 * OverloadController::kOverloadedEvalsToStepUp; ++i) {
+    controller.Update(kOverloaded);
+  }
+  ASSERT_EQ(controller.level(), OverloadLevel::kSlowSampling);
+
+  // Busy evaluations neither step up nor down.
+  for (int i = 0; i < 2 * OverloadController::kCalmEvalsToStepDown; ++i) {
+    EXPECT_EQ(controller.Update(kBusy), OverloadLevel::kSlowSampling);
+  }
+
+  // A busy evaluation restarts the count of calm ones.
+  for (int i = 1; i < OverloadController::kCalmEvalsToStepDown; ++i) {
+    EXPECT_EQ(controller.Update(kCalm), OverloadLevel::kSlowSampling);
+  }
+  controller.Update(kBusy);
+  for (int i = 1; i < OverloadController::kCalmEvalsToStepDown; ++i) {
+    EXPECT_EQ(controller.Update(kCalm), OverloadLevel::kSlowSampling);
+  }
+  EXPECT_EQ(controller.Update(kCalm), OverloadLevel::kNoBodyCapture);
+
+  for (int i = 0; i < 2 * OverloadController::kCalmEvalsToStepDown; ++i) {
+    controller.Update(kCalm);
+  }
+  EXPECT_EQ(controller.level(), OverloadLevel::kNone);
+}
+
+TEST(OverloadControllerTest, CountsSteps) {
+  auto& registry = utils::MetricsRegistry::Global();
+  utils::Counter* up = registry.GetCounter("stirling_overload_steps", "",
+                                           {{"direction", "up"}, {"level", "kNoBodyCapture"}});
+  utils::Counter* down = registry.GetCounter("stirling_overload_steps", "",
+                                             {{"direction", "down"}, {"level", "kNone"}});
+  const int64_t up_before = up->Value();
+  const int64_t down_before = down->Value();
+
+  OverloadController controller;
+  for (int i = 0; i < OverloadController::kOverloadedEvalsToStepUp; ++i) {
+    controller.Update(kOverloaded);
+  }
+  for (int i = 0; i < OverloadController::kCalmEvalsToStepDown; ++i) {
+    controller.Update(kCalm);
+  }
+  EXPECT_EQ(up->Value() - up_before, 1);
+  EXPECT_EQ(down->Value() - down_before, 1);
+}
+
+}  // namespace stirling
+}  // namespace px
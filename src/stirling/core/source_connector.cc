@@ -16,6 +16,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <cstring>
 #include <ctime>
 #include <memory>
@@ -25,6 +26,10 @@
 
 #include "src/stirling/core/source_connector.h"
 
+DEFINE_bool(stirling_adaptive_sampling, true,
+            "Whether the connectors that support it adapt their sampling period to their load, "
+            "sampling more often when they lose events and less often when they are idle.");
+
 namespace px {
 namespace stirling {
 
@@ -50,10 +55,64 @@ void SourceConnector::TransferData(ConnectorContext* ctx,
   DCHECK(ctx != nullptr);
   DCHECK_EQ(data_tables.size(), table_schemas().size())
       << "DataTable objects must all be specified.";
-  TransferDataImpl(ctx, data_tables);
+  if (IsLowPriority() && overload_level_ >= OverloadLevel::kLowPriorityPaused) {
+    sampling_freq_mgr_.Reset();
+    return;
+  }
+  {
+    utils::ScopedTimer timer(transfer_time_ns_);
+    TransferDataImpl(ctx, data_tables);
+  }
+
+  if (sampling_period_controller_ != nullptr) {
+    for (const auto* data_table : data_tables) {
+      if (data_table != nullptr) {
+        sampling_load_.table_occupancy =
+            std::max(sampling_load_.table_occupancy, data_table->OccupancyPct());
+      }
+    }
+    const auto decision = sampling_period_controller_->Update(sampling_load_, &sampling_freq_mgr_);
+    VLOG_IF(1, decision != AdaptivePeriodController::Decision::kKeep) << absl::Substitute(
+        "$0: $1 sampling period=$2ms [buffer_occupancy=$3 lost=$4 table_occupancy=$5]", name(),
+        magic_enum::enum_name(decision), sampling_freq_mgr_.period().count(),
+        sampling_load_.buffer_occupancy, sampling_load_.lost, sampling_load_.table_occupancy);
+    sampling_load_ = {};
+  }
   sampling_freq_mgr_.Reset();
 }
 
+void SourceConnector::EnableAdaptiveSampling(std::chrono::milliseconds min_period,
+                                             std::chrono::milliseconds max_period) {
+  DCHECK_NE(sampling_freq_mgr_.period().count(), 0) << "Sampling period has not been initialized";
+  if (!FLAGS_stirling_adaptive_sampling) {
+    return;
+  }
+  sampling_period_controller_ = std::make_unique<AdaptivePeriodController>(
+      sampling_freq_mgr_.period(), min_period, max_period);
+}
+
+void SourceConnector::SetOverloadLevel(OverloadLevel level) {
+  if (level == overload_level_) {
+    return;
+  }
+  overload_level_ = level;
+
+  // Adaptive sampling periods follow the load of the connector on their own.
+  const bool slow_sampling = level >= OverloadLevel::kSlowSampling;
+  if (sampling_period_controller_ == nullptr &&
+      slow_sampling != unstretched_sampling_period_.has_value()) {
+    if (slow_sampling) {
+      unstretched_sampling_period_ = sampling_freq_mgr_.period();
+      sampling_freq_mgr_.set_period(sampling_freq_mgr_.period() * kOverloadSamplingPeriodFactor);
+    } else {
+      sampling_freq_mgr_.set_period(*unstretched_sampling_period_);
+      unstretched_sampling_period_.reset();
+    }
+  }
+
+  SetOverloadLevelImpl(level);
+}
+
 void SourceConnector::PushData(DataPushCallback agent_callback,
                                const std::vector<DataTable*>& data_tables) {
   for (auto* data_table : data_tables) {
@@ -62,6 +121,7 @@ void SourceConnector::PushData(DataPushCallback agent_callback,
       if (record_batch.records.empty()) {
         continue;
       }
+      utils::ScopedTimer timer(push_callback_time_ns_);
       Status s = agent_callback(
           data_table->id(), record_batch.tablet_id,
           std::make_unique<types::ColumnWrapperRecordBatch>(std::move(record_batch.records)));
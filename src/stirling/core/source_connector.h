@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -27,6 +30,10 @@
 #include "src/stirling/core/connector_context.h"
 #include "src/stirling/core/data_table.h"
 #include "src/stirling/core/frequency_manager.h"
+#include "src/stirling/core/overload_controller.h"
+#include "src/stirling/utils/metrics.h"
+
+DECLARE_bool(stirling_adaptive_sampling);
 
 /**
  * These are the steps to follow to add a new data source connector.
@@ -81,6 +88,12 @@ class SourceConnector : public NotCopyable {
 
   const ArrayView<DataTableSchema>& table_schemas() const { return table_schemas_; }
 
+  /**
+   * Whether Init() compiles or deploys BPF programs. Stirling initializes such sources one after
+   * the other, since they share the BPF compiler and the Linux headers setup.
+   */
+  virtual bool UsesBPF() const { return false; }
+
   static constexpr uint32_t TableNum(ArrayView<DataTableSchema> tables,
                                      const DataTableSchema& key) {
     uint32_t i = 0;
@@ -107,13 +120,42 @@ class SourceConnector : public NotCopyable {
   virtual void EnablePIDTrace(int pid) { pids_to_trace_.insert(pid); }
   virtual void DisablePIDTrace(int pid) { pids_to_trace_.erase(pid); }
 
+  /**
+   * Applies the degradations of the overload level, and undoes those of the levels above it.
+   * Connectors with a fixed sampling period sample less often from OverloadLevel::kSlowSampling
+   * on, and low priority connectors skip their TransferData() from
+   * OverloadLevel::kLowPriorityPaused on. The rest is up to SetOverloadLevelImpl().
+   */
+  void SetOverloadLevel(OverloadLevel level);
+
+  /**
+   * Whether the connector is paused when Stirling is overloaded, because its data is the least
+   * important and the most expensive to collect.
+   */
+  virtual bool IsLowPriority() const { return false; }
+
   const FrequencyManager& sampling_freq_mgr() const { return sampling_freq_mgr_; }
   const FrequencyManager& push_freq_mgr() const { return push_freq_mgr_; }
 
+  /**
+   * @return the controller adapting the sampling period, or nullptr if the period is fixed.
+   */
+  const AdaptivePeriodController* sampling_period_controller() const {
+    return sampling_period_controller_.get();
+  }
+
  protected:
   explicit SourceConnector(std::string_view source_name,
                            const ArrayView<DataTableSchema>& table_schemas)
-      : source_name_(source_name), table_schemas_(table_schemas) {}
+      : source_name_(source_name),
+        table_schemas_(table_schemas),
+        transfer_time_ns_(utils::MetricsRegistry::Global().GetHistogram(
+            "stirling_transfer_data_ns", "The time each TransferData() of the source takes.",
+            {{"source", source_name_}})),
+        push_callback_time_ns_(utils::MetricsRegistry::Global().GetHistogram(
+            "stirling_push_callback_ns",
+            "The time the agent callback takes to accept each record batch of the source.",
+            {{"source", source_name_}})) {}
 
   virtual Status InitImpl() = 0;
 
@@ -125,6 +167,31 @@ class SourceConnector : public NotCopyable {
 
   virtual Status StopImpl() = 0;
 
+  // Called with the new level by SetOverloadLevel().
+  virtual void SetOverloadLevelImpl(OverloadLevel /* level */) {}
+
+  /**
+   * Makes the sampling period adapt to the load of each TransferData(), between min_period and
+   * max_period. The load is what the connector reports with RecordSamplingBufferOccupancy() and
+   * RecordSamplingLoss(), plus the occupancy of its data tables. Call from InitImpl(), after the
+   * sampling period is set. Does nothing unless --stirling_adaptive_sampling is set.
+   */
+  void EnableAdaptiveSampling(std::chrono::milliseconds min_period,
+                              std::chrono::milliseconds max_period);
+
+  /**
+   * Records the fraction of the buffers that had data pending when they were polled in the
+   * current TransferData(). Repeated calls keep the highest fraction.
+   */
+  void RecordSamplingBufferOccupancy(double occupancy) {
+    sampling_load_.buffer_occupancy = std::max(sampling_load_.buffer_occupancy, occupancy);
+  }
+
+  /**
+   * Records events lost by the buffers during the current TransferData().
+   */
+  void RecordSamplingLoss(uint64_t lost) { sampling_load_.lost += lost; }
+
  protected:
   /**
    * Track state of connector. A connector's lifetime typically progresses sequentially
@@ -142,6 +209,14 @@ class SourceConnector : public NotCopyable {
   FrequencyManager sampling_freq_mgr_;
   FrequencyManager push_freq_mgr_;
 
+  // Only set if EnableAdaptiveSampling() was called.
+  std::unique_ptr<AdaptivePeriodController> sampling_period_controller_;
+  AdaptivePeriodController::Load sampling_load_;
+
+  OverloadLevel overload_level_ = OverloadLevel::kNone;
+  // The sampling period from before OverloadLevel::kSlowSampling stretched it.
+  std::optional<std::chrono::milliseconds> unstretched_sampling_period_;
+
   // Debug members.
   int debug_level_ = 0;
   absl::flat_hash_set<int> pids_to_trace_;
@@ -151,6 +226,9 @@ class SourceConnector : public NotCopyable {
 
   const std::string source_name_;
   const ArrayView<DataTableSchema> table_schemas_;
+
+  utils::Histogram* const transfer_time_ns_;
+  utils::Histogram* const push_callback_time_ns_;
 };
 
 }  // namespace stirling
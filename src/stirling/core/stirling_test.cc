@@ -22,6 +22,7 @@
 #include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <absl/strings/str_format.h>
 
@@ -316,6 +317,77 @@ TEST_F(StirlingTest, hammer_time_on_stirling_on_the_fly_subs) {
   EXPECT_GT(NumProcessed(), 0);
 }
 
+// Each source runs its own sampling loop, and reports the latency of the loop.
+TEST_F(StirlingTest, source_loop_stats) {
+  ASSERT_OK(stirling_->RunAsThread());
+  std::this_thread::sleep_for(kDurationPerIter);
+  stirling_->Stop();
+
+  std::vector<SourceLoopStats> loop_stats = stirling_->GetSourceLoopStats();
+  ASSERT_EQ(loop_stats.size(), kNumSources);
+  for (const auto& stats : loop_stats) {
+    EXPECT_THAT(stats.source_name, ::testing::StartsWith("sequences"));
+    EXPECT_GT(stats.num_iterations, 0U);
+    EXPECT_GE(stats.max_iteration_time, stats.last_iteration_time);
+    EXPECT_GE(stats.total_iteration_time, stats.max_iteration_time);
+    // The sequence generators sample at a fixed period.
+    EXPECT_GT(stats.sampling_period.count(), 0);
+    EXPECT_EQ(stats.num_sampling_period_shortened + stats.num_sampling_period_lengthened, 0U);
+  }
+  EXPECT_GT(NumProcessed(), 0);
+}
+
+TEST_F(StirlingTest, push_queue_stats) {
+  ASSERT_OK(stirling_->RunAsThread());
+  std::this_thread::sleep_for(kDurationPerIter);
+  stirling_->Stop();
+
+  // Stop() pushes whatever is still queued.
+  PushQueueStats stats = stirling_->GetPushQueueStats();
+  EXPECT_EQ(stats.depth, 0U);
+  EXPECT_GT(stats.num_pushes, 0U);
+  EXPECT_EQ(stats.num_batches_dropped, 0U);
+  EXPECT_EQ(stats.num_rows_dropped, 0U);
+  EXPECT_GT(NumProcessed(), 0);
+}
+
+TEST_F(StirlingTest, push_queue_full_drops_batches) {
+  FLAGS_stirling_push_queue_max_batches = 0;
+  ASSERT_OK(stirling_->RunAsThread());
+  std::this_thread::sleep_for(kDurationPerIter);
+  stirling_->Stop();
+  FLAGS_stirling_push_queue_max_batches = 4096;
+
+  PushQueueStats stats = stirling_->GetPushQueueStats();
+  EXPECT_EQ(stats.num_pushes, 0U);
+  EXPECT_GT(stats.num_batches_dropped, 0U);
+  EXPECT_GT(stats.num_rows_dropped, 0U);
+  EXPECT_EQ(NumProcessed(), 0);
+}
+
+TEST(StirlingInitTest, parallel_source_init) {
+  FLAGS_stirling_parallel_source_init = true;
+
+  std::unique_ptr<SourceRegistry> registry = std::make_unique<SourceRegistry>();
+  registry->RegisterOrDie<SeqGenConnector>("sequences0");
+  registry->RegisterOrDie<SeqGenConnector>("sequences1");
+  std::unique_ptr<Stirling> stirling = Stirling::Create(std::move(registry));
+
+  FLAGS_stirling_parallel_source_init = false;
+
+  stirlingpb::Publish publish_proto;
+  stirling->GetPublishProto(&publish_proto);
+  EXPECT_EQ(publish_proto.published_info_classes_size(),
+            static_cast<int>(2 * SeqGenConnector::kTables.size()));
+
+  std::vector<SourceLoopStats> loop_stats = stirling->GetSourceLoopStats();
+  ASSERT_EQ(loop_stats.size(), 2);
+  for (const auto& stats : loop_stats) {
+    EXPECT_THAT(stats.source_name, ::testing::StartsWith("sequences"));
+    EXPECT_GE(stats.init_time.count(), 0);
+  }
+}
+
 TEST_F(StirlingTest, no_data_callback_defined) {
   stirling_->RegisterDataPushCallback(nullptr);
 
@@ -69,7 +69,10 @@ TEST_F(StirlingBPFTest, CleanupTest) {
   ASSERT_OK(stirling_->WaitUntilRunning(/* timeout */ std::chrono::seconds(5)));
 
   EXPECT_GT(SocketTraceConnector::num_attached_probes(), 0);
-  EXPECT_GT(SocketTraceConnector::num_open_perf_buffers(), 0);
+  // The socket tracer uses ring buffers instead of perf buffers on newer kernels.
+  EXPECT_GT(SocketTraceConnector::num_open_perf_buffers() +
+                SocketTraceConnector::num_open_ring_buffers(),
+            0);
 
   std::thread killer_thread = std::thread(&AsyncKill, stirling_.get());
 
@@ -78,6 +81,7 @@ TEST_F(StirlingBPFTest, CleanupTest) {
 
   EXPECT_EQ(SocketTraceConnector::num_attached_probes(), 0);
   EXPECT_EQ(SocketTraceConnector::num_open_perf_buffers(), 0);
+  EXPECT_EQ(SocketTraceConnector::num_open_ring_buffers(), 0);
 }
 
 }  // namespace stirling
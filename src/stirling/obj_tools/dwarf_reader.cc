@@ -19,8 +19,11 @@
 #include "src/stirling/obj_tools/dwarf_reader.h"
 
 #include <algorithm>
+#include <cctype>
+#include <cstring>
 
 #include <llvm/DebugInfo/DIContext.h>
+#include <llvm/DebugInfo/DWARF/DWARFAcceleratorTable.h>
 #include <llvm/Object/ObjectFile.h>
 
 #include "src/shared/types/typespb/wrapper/types_pb_wrapper.h"
@@ -56,7 +59,7 @@ std::vector<DWARFDie> GetParamDIEs(const DWARFDie& function_die) {
 uint8_t kAddressSize = sizeof(void*);
 
 StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::Create(
-    const std::filesystem::path& obj_file_path, bool index) {
+    const std::filesystem::path& obj_file_path, DwarfIndexMode index_mode) {
   using llvm::MemoryBuffer;
 
   std::error_code ec;
@@ -88,7 +91,8 @@ StatusOr<std::unique_ptr<DwarfReader>> DwarfReader::Create(
 
   PL_RETURN_IF_ERROR(dwarf_reader->DetectSourceLanguage());
 
-  if (index) {
+  dwarf_reader->index_mode_ = index_mode;
+  if (index_mode == DwarfIndexMode::kEager) {
     dwarf_reader->IndexDIEs();
   }
 
@@ -163,63 +167,99 @@ Status DwarfReader::DetectSourceLanguage() {
 }
 
 void DwarfReader::IndexDIEs() {
+  // Map from DW_AT_specification to DIE, for the DIEs that refer to a declaration in another unit.
+  absl::flat_hash_map<uint64_t, DWARFDie> fn_spec_offsets;
+
+  DWARFContext::unit_iterator_range units = dwarf_context_->normal_units();
+  for (const std::unique_ptr<llvm::DWARFUnit>& unit : units) {
+    IndexUnit(unit.get(), &fn_spec_offsets);
+  }
+  IndexFnSpecs(fn_spec_offsets);
+}
+
+void DwarfReader::IndexUnit(llvm::DWARFUnit* unit,
+                            absl::flat_hash_map<uint64_t, DWARFDie>* fn_spec_offsets) {
   absl::flat_hash_map<const llvm::DWARFDebugInfoEntry*, std::string> dwarf_entry_names;
 
   // Map from DW_AT_specification to DIE. Only DW_TAG_subprogram can have this attribute.
   // Also only applies to CPP binaries.
-  absl::flat_hash_map<uint64_t, DWARFDie> fn_spec_offsets;
+  absl::flat_hash_map<uint64_t, DWARFDie> unit_fn_spec_offsets;
 
-  DWARFContext::unit_iterator_range units = dwarf_context_->normal_units();
-  for (const std::unique_ptr<llvm::DWARFUnit>& unit : units) {
-    for (const llvm::DWARFDebugInfoEntry& entry : unit->dies()) {
-      DWARFDie die = {unit.get(), &entry};
+  // The names of the functions of this unit, by the offset of their DIE.
+  absl::flat_hash_map<uint64_t, std::string> fn_names;
 
-      if (die.isSubprogramDIE()) {
-        auto spec_or =
-            AdaptLLVMOptional(llvm::dwarf::toReference(die.find(llvm::dwarf::DW_AT_specification)),
-                              "Could not find attribute DW_AT_specification");
-        if (spec_or.ok()) {
-          fn_spec_offsets[spec_or.ValueOrDie()] = die;
-        }
+  for (const llvm::DWARFDebugInfoEntry& entry : unit->dies()) {
+    DWARFDie die = {unit, &entry};
+
+    if (die.isSubprogramDIE()) {
+      auto spec_or =
+          AdaptLLVMOptional(llvm::dwarf::toReference(die.find(llvm::dwarf::DW_AT_specification)),
+                            "Could not find attribute DW_AT_specification");
+      if (spec_or.ok()) {
+        unit_fn_spec_offsets[spec_or.ValueOrDie()] = die;
       }
+    }
 
-      // TODO(oazizi/yzhao): Change to use the demangled name of DW_AT_linkage_name as the key to
-      // index the function DIE. That removes the need of using manually-assembled names (through
-      // parent DIE).
+    // TODO(oazizi/yzhao): Change to use the demangled name of DW_AT_linkage_name as the key to
+    // index the function DIE. That removes the need of using manually-assembled names (through
+    // parent DIE).
 
-      auto name = std::string(GetShortName(die));
+    auto name = std::string(GetShortName(die));
 
-      if (name.empty()) {
-        continue;
-      }
+    if (name.empty()) {
+      continue;
+    }
 
-      llvm::dwarf::Tag tag = die.getTag();
+    llvm::dwarf::Tag tag = die.getTag();
 
-      if (IsIndexedType(tag) ||
-          // Namespace entry is processed here so that the name components can be generated.
-          IsNamespace(tag)) {
-        llvm::DWARFDie parent_die = die.getParent();
+    if (IsIndexedType(tag) ||
+        // Namespace entry is processed here so that the name components can be generated.
+        IsNamespace(tag)) {
+      llvm::DWARFDie parent_die = die.getParent();
 
-        if (parent_die.isValid()) {
-          const llvm::DWARFDebugInfoEntry* entry = parent_die.getDebugInfoEntry();
+      if (parent_die.isValid()) {
+        const llvm::DWARFDebugInfoEntry* entry = parent_die.getDebugInfoEntry();
 
-          if (entry != nullptr) {
-            auto iter = dwarf_entry_names.find(entry);
-            if (iter != dwarf_entry_names.end()) {
-              std::string_view parent_name = iter->second;
-              name = absl::StrCat(parent_name, "::", name);
-            }
+        if (entry != nullptr) {
+          auto iter = dwarf_entry_names.find(entry);
+          if (iter != dwarf_entry_names.end()) {
+            std::string_view parent_name = iter->second;
+            name = absl::StrCat(parent_name, "::", name);
           }
-          dwarf_entry_names[die.getDebugInfoEntry()] = name;
         }
+        dwarf_entry_names[die.getDebugInfoEntry()] = name;
+      }
 
-        if (IsIndexedType(tag)) {
-          InsertToDIEMap(std::move(name), tag, die);
-        }
+      if (tag == llvm::dwarf::DW_TAG_subprogram) {
+        fn_names[die.getOffset()] = name;
+      }
+      if (IsIndexedType(tag)) {
+        InsertToDIEMap(std::move(name), tag, die);
       }
     }
   }
 
+  // Replace the function DIEs with the DW_TAG_subprogram DIEs that have a DW_AT_specification
+  // attribute referring to them. The declarations in other units are left to IndexFnSpecs().
+  auto& fn_dies = die_map_[llvm::dwarf::DW_TAG_subprogram];
+  for (const auto& [offset, spec_die] : unit_fn_spec_offsets) {
+    auto name_iter = fn_names.find(offset);
+    if (name_iter == fn_names.end()) {
+      (*fn_spec_offsets)[offset] = spec_die;
+      continue;
+    }
+    auto fn_iter = fn_dies.find(name_iter->second);
+    if (fn_iter != fn_dies.end() && fn_iter->second.getOffset() == offset) {
+      fn_iter->second = spec_die;
+    }
+  }
+}
+
+void DwarfReader::IndexFnSpecs(const absl::flat_hash_map<uint64_t, DWARFDie>& fn_spec_offsets) {
+  if (fn_spec_offsets.empty()) {
+    return;
+  }
+
   auto& fn_dies = die_map_[llvm::dwarf::DW_TAG_subprogram];
 
   for (auto iter = fn_dies.begin(); iter != fn_dies.end(); ++iter) {
@@ -233,12 +273,261 @@ void DwarfReader::IndexDIEs() {
   }
 }
 
+void DwarfReader::IndexUnitOnce(llvm::DWARFUnit* unit) {
+  if (!indexed_units_.insert(unit).second) {
+    return;
+  }
+  absl::flat_hash_map<uint64_t, DWARFDie> fn_spec_offsets;
+  IndexUnit(unit, &fn_spec_offsets);
+  IndexFnSpecs(fn_spec_offsets);
+}
+
+namespace {
+
+// Returns the last component of a qualified C++ name, e.g. "Bar<ns::Baz>" for "foo::Bar<ns::Baz>",
+// which is the name under which the accelerator tables record it.
+std::string_view UnqualifiedName(std::string_view name) {
+  int template_depth = 0;
+  for (size_t i = name.size(); i >= 2; --i) {
+    char c = name[i - 1];
+    if (c == '>') {
+      ++template_depth;
+    } else if (c == '<') {
+      --template_depth;
+    } else if (c == ':' && name[i - 2] == ':' && template_depth == 0) {
+      return name.substr(i);
+    }
+  }
+  return name;
+}
+
+// Returns the package of a Go symbol, e.g. "net/http" for "net/http.(*conn).serve".
+std::string_view GoPackage(std::string_view name) {
+  // The receiver and the type parameters may name other packages.
+  std::string_view path = name.substr(0, name.find_first_of("(["));
+  size_t slash_pos = path.rfind('/');
+  size_t dot_pos = path.find('.', slash_pos == std::string_view::npos ? 0 : slash_pos);
+  return name.substr(0, dot_pos);
+}
+
+bool ReadU32(llvm::StringRef data, uint64_t offset, uint32_t* val) {
+  if (offset + sizeof(*val) > data.size()) {
+    return false;
+  }
+  std::memcpy(val, data.data() + offset, sizeof(*val));
+  return true;
+}
+
+bool ReadU64(llvm::StringRef data, uint64_t offset, uint64_t* val) {
+  if (offset + sizeof(*val) > data.size()) {
+    return false;
+  }
+  std::memcpy(val, data.data() + offset, sizeof(*val));
+  return true;
+}
+
+// Looks up a name in a .gdb_index section, and returns the offsets of the compile units that it
+// appears in. LLVM parses the section for dumping only, so the lookup is done here.
+// See https://sourceware.org/gdb/onlinedocs/gdb/Index-Section-Format.html.
+std::vector<uint64_t> GdbIndexUnitOffsets(llvm::StringRef section, std::string_view name) {
+  // The header is the version, followed by the offsets of the CU list, the types CU list,
+  // the address area, the symbol table and the constant pool.
+  uint32_t header[6];
+  if (section.size() < sizeof(header)) {
+    return {};
+  }
+  std::memcpy(header, section.data(), sizeof(header));
+  const uint32_t version = header[0];
+  const uint32_t cu_list_offset = header[1];
+  const uint32_t types_cu_list_offset = header[2];
+  const uint32_t symbol_table_offset = header[4];
+  const uint32_t constant_pool_offset = header[5];
+  // Older versions are not produced anymore, and have a different hash function.
+  if (version < 7 || version > 8 || cu_list_offset > types_cu_list_offset ||
+      symbol_table_offset > constant_pool_offset || constant_pool_offset > section.size()) {
+    return {};
+  }
+  constexpr uint32_t kCUEntrySize = 16;
+  constexpr uint32_t kSymbolEntrySize = 8;
+  const uint32_t num_cus = (types_cu_list_offset - cu_list_offset) / kCUEntrySize;
+  const uint32_t num_slots = (constant_pool_offset - symbol_table_offset) / kSymbolEntrySize;
+  // The symbol table is an open-addressed hash table, with a power of 2 size.
+  if (num_slots == 0 || (num_slots & (num_slots - 1)) != 0) {
+    return {};
+  }
+  const llvm::StringRef constant_pool = section.substr(constant_pool_offset);
+
+  uint32_t hash = 0;
+  for (char c : name) {
+    hash = hash * 67 + std::tolower(static_cast<unsigned char>(c)) - 113;
+  }
+  const uint32_t mask = num_slots - 1;
+  const uint32_t step = ((hash * 17) & mask) | 1;
+
+  std::vector<uint64_t> cu_offsets;
+  for (uint32_t i = 0, slot = hash & mask; i < num_slots; ++i, slot = (slot + step) & mask) {
+    uint64_t slot_offset = symbol_table_offset + slot * kSymbolEntrySize;
+    uint32_t name_offset = 0;
+    uint32_t cu_vector_offset = 0;
+    if (!ReadU32(section, slot_offset, &name_offset) ||
+        !ReadU32(section, slot_offset + 4, &cu_vector_offset)) {
+      return {};
+    }
+    if (name_offset == 0 && cu_vector_offset == 0) {
+      // An empty slot: the name is not in the table.
+      return {};
+    }
+    if (name_offset >= constant_pool.size()) {
+      return {};
+    }
+    llvm::StringRef slot_name = constant_pool.substr(name_offset);
+    slot_name = slot_name.substr(0, slot_name.find('\0'));
+    if (slot_name != llvm::StringRef(name.data(), name.size())) {
+      continue;
+    }
+
+    uint32_t num_entries = 0;
+    if (!ReadU32(constant_pool, cu_vector_offset, &num_entries)) {
+      return {};
+    }
+    for (uint32_t j = 0; j < num_entries; ++j) {
+      uint32_t entry = 0;
+      if (!ReadU32(constant_pool, cu_vector_offset + 4 + 4 * j, &entry)) {
+        return cu_offsets;
+      }
+      // The lower 24 bits are the index of the unit; indexes past the CU list are type units.
+      uint32_t cu_index = entry & 0xffffff;
+      uint64_t cu_offset = 0;
+      if (cu_index < num_cus &&
+          ReadU64(section, cu_list_offset + cu_index * kCUEntrySize, &cu_offset)) {
+        cu_offsets.push_back(cu_offset);
+      }
+    }
+    return cu_offsets;
+  }
+  return {};
+}
+
+}  // namespace
+
+std::vector<llvm::DWARFUnit*> DwarfReader::AcceleratedUnits(std::string_view name,
+                                                            llvm::dwarf::Tag tag,
+                                                            bool* exhaustive) {
+  *exhaustive = false;
+
+  std::vector<llvm::DWARFUnit*> units;
+  auto add_unit_at = [this, &units](uint64_t offset) {
+    llvm::DWARFUnit* unit = dwarf_context_->getCompileUnitForOffset(offset);
+    if (unit != nullptr && std::find(units.begin(), units.end(), unit) == units.end()) {
+      units.push_back(unit);
+    }
+  };
+
+  std::string_view short_name = UnqualifiedName(name);
+  llvm::StringRef short_name_ref(short_name.data(), short_name.size());
+
+  // DWARF 5 .debug_names. It indexes all the named structs, classes and functions of the units
+  // that it covers.
+  const llvm::DWARFDebugNames& debug_names = dwarf_context_->getDebugNames();
+  uint32_t num_covered_units = 0;
+  for (const llvm::DWARFDebugNames::NameIndex& name_index : debug_names) {
+    num_covered_units += name_index.getCUCount();
+  }
+  if (num_covered_units != 0) {
+    for (const llvm::DWARFDebugNames::Entry& entry : debug_names.equal_range(short_name_ref)) {
+      llvm::Optional<uint64_t> cu_offset = entry.getCUOffset();
+      if (entry.tag() == tag && cu_offset.hasValue()) {
+        add_unit_at(cu_offset.getValue());
+      }
+    }
+    *exhaustive = num_covered_units >= dwarf_context_->getNumCompileUnits();
+  }
+
+  // .apple_names has the functions, .apple_types the types.
+  const llvm::AppleAcceleratorTable& apple_table = tag == llvm::dwarf::DW_TAG_subprogram
+                                                       ? dwarf_context_->getAppleNames()
+                                                       : dwarf_context_->getAppleTypes();
+  for (const auto& entry : apple_table.equal_range(short_name_ref)) {
+    llvm::Optional<uint64_t> die_offset = entry.getDIESectionOffset();
+    if (die_offset.hasValue()) {
+      add_unit_at(die_offset.getValue());
+    }
+  }
+
+  // .gdb_index records the qualified names of C++ symbols.
+  llvm::StringRef gdb_index = dwarf_context_->getDWARFObj().getGdbIndexSection();
+  if (!gdb_index.empty()) {
+    for (uint64_t offset : GdbIndexUnitOffsets(gdb_index, name)) {
+      add_unit_at(offset);
+    }
+    for (uint64_t offset : GdbIndexUnitOffsets(gdb_index, short_name)) {
+      add_unit_at(offset);
+    }
+  }
+
+  return units;
+}
+
+std::vector<llvm::DWARFUnit*> DwarfReader::GoUnits(std::string_view name, llvm::dwarf::Tag tag) {
+  if (go_units_.empty()) {
+    for (const std::unique_ptr<llvm::DWARFUnit>& unit : dwarf_context_->normal_units()) {
+      go_units_.try_emplace(std::string(GetShortName(unit->getUnitDIE())), unit.get());
+    }
+  }
+
+  // The Go linker names each compile unit after its package, and puts the DIEs of all the types in
+  // the runtime unit.
+  std::string_view unit_name = tag == llvm::dwarf::DW_TAG_subprogram ? GoPackage(name) : "runtime";
+  auto iter = go_units_.find(std::string(unit_name));
+  if (iter == go_units_.end()) {
+    return {};
+  }
+  return {iter->second};
+}
+
+void DwarfReader::IndexUnitsFor(std::string_view name, llvm::dwarf::Tag tag) {
+  const std::string name_str(name);
+  if (all_units_indexed_ || FindInDIEMap(name_str, tag).has_value()) {
+    return;
+  }
+
+  bool exhaustive = false;
+  std::vector<llvm::DWARFUnit*> units = AcceleratedUnits(name, tag, &exhaustive);
+  if (source_language_ == llvm::dwarf::DW_LANG_Go) {
+    for (llvm::DWARFUnit* unit : GoUnits(name, tag)) {
+      units.push_back(unit);
+    }
+  }
+  for (llvm::DWARFUnit* unit : units) {
+    IndexUnitOnce(unit);
+    if (FindInDIEMap(name_str, tag).has_value()) {
+      return;
+    }
+  }
+  if (exhaustive) {
+    return;
+  }
+
+  // No hint, or a wrong one. Index the remaining units until the name is found.
+  for (const std::unique_ptr<llvm::DWARFUnit>& unit : dwarf_context_->normal_units()) {
+    IndexUnitOnce(unit.get());
+    if (FindInDIEMap(name_str, tag).has_value()) {
+      return;
+    }
+  }
+  all_units_indexed_ = true;
+}
+
 StatusOr<std::vector<DWARFDie>> DwarfReader::GetMatchingDIEs(
     std::string_view name, std::optional<llvm::dwarf::Tag> type_opt) {
   DCHECK(dwarf_context_ != nullptr);
 
   // Special case for types that are indexed.
-  if (type_opt.has_value() && IsIndexedType(type_opt.value()) && !die_map_.empty()) {
+  if (type_opt.has_value() && IsIndexedType(type_opt.value()) &&
+      index_mode_ != DwarfIndexMode::kNone) {
+    if (index_mode_ == DwarfIndexMode::kLazy) {
+      IndexUnitsFor(name, type_opt.value());
+    }
     auto die_opt = FindInDIEMap(std::string(name), type_opt.value());
     if (die_opt.has_value()) {
       return std::vector<DWARFDie>{die_opt.value()};
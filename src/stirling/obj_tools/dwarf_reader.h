@@ -22,6 +22,7 @@
 #include <llvm/Support/TargetSelect.h>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 
 #include <filesystem>
 #include <limits>
@@ -140,6 +141,23 @@ inline bool operator==(const StructSpecEntry& a, const StructSpecEntry& b) {
   return a.offset == b.offset && a.size == b.size && a.type_info == b.type_info && a.path == b.path;
 }
 
+/**
+ * How DwarfReader indexes the DIEs that are looked up by name (structs, classes and functions).
+ */
+enum class DwarfIndexMode {
+  // No index. Every lookup walks all the DIEs.
+  kNone,
+
+  // All the DIEs are indexed when the reader is created.
+  kEager,
+
+  // Compile units are indexed the first time they're needed by a lookup. The units that hold a
+  // name are found through the .debug_names, .apple_names/.apple_types or .gdb_index accelerator
+  // tables, or through the layout of Go compile units. Without a hint, or if the hinted units
+  // don't have the name, the remaining units are indexed one at a time until it is found.
+  kLazy,
+};
+
 /**
  * Accepts an executable and reads DWARF information from it.
  * APIs are provided for accessing the needed data.
@@ -149,12 +167,14 @@ class DwarfReader {
   /**
    * Creates a DwarfReader that provides access to DWARF Debugging information entries (DIEs).
    * @param obj_filename The object file from which to read DWARF information.
-   * @param index If true, creates an index to speed up accesses when called more than once.
+   * @param index_mode How to index the DIEs, to speed up accesses when called more than once.
+   *                   kLazy makes a few lookups on a large binary much cheaper than kEager.
    * @return error if file does not exist or is not a valid object file. Otherwise returns
    * a unique pointer to a DwarfReader.
    */
-  static StatusOr<std::unique_ptr<DwarfReader>> Create(const std::filesystem::path& obj_file_path,
-                                                       bool index = true);
+  static StatusOr<std::unique_ptr<DwarfReader>> Create(
+      const std::filesystem::path& obj_file_path,
+      DwarfIndexMode index_mode = DwarfIndexMode::kEager);
 
   /**
    * Searches the debug information for Debugging information entries (DIEs)
@@ -300,6 +320,28 @@ class DwarfReader {
   // When making multiple DwarfReader calls, this speeds up the process at the cost of some memory.
   void IndexDIEs();
 
+  // Adds the DIEs of the unit to the index. DIEs with a DW_AT_specification attribute are
+  // recorded in fn_spec_offsets, so that they can replace the declarations they refer to, with
+  // IndexFnSpecs(), once the units that hold the declarations are indexed too.
+  void IndexUnit(llvm::DWARFUnit* unit,
+                 absl::flat_hash_map<uint64_t, llvm::DWARFDie>* fn_spec_offsets);
+  void IndexFnSpecs(const absl::flat_hash_map<uint64_t, llvm::DWARFDie>& fn_spec_offsets);
+
+  // For DwarfIndexMode::kLazy: indexes the unit, if it isn't already.
+  void IndexUnitOnce(llvm::DWARFUnit* unit);
+
+  // For DwarfIndexMode::kLazy: indexes the units that may hold the name, until it is found.
+  void IndexUnitsFor(std::string_view name, llvm::dwarf::Tag tag);
+
+  // Returns the units that the accelerator tables point to for the name.
+  // exhaustive is set to true if the tables cover all units, so that a name that is not in the
+  // tables is not in the DWARF info.
+  std::vector<llvm::DWARFUnit*> AcceleratedUnits(std::string_view name, llvm::dwarf::Tag tag,
+                                                 bool* exhaustive);
+
+  // Returns the Go compile units that should hold the name.
+  std::vector<llvm::DWARFUnit*> GoUnits(std::string_view name, llvm::dwarf::Tag tag);
+
   // Walks the struct_die for all members, recursively visiting any members which are also structs,
   // to capture information of all base type members of the struct in a flattened form.
   // See GetStructSpec() for the public interface, and the output format.
@@ -316,8 +358,17 @@ class DwarfReader {
   std::unique_ptr<llvm::MemoryBuffer> memory_buffer_;
   std::unique_ptr<llvm::DWARFContext> dwarf_context_;
 
+  DwarfIndexMode index_mode_ = DwarfIndexMode::kNone;
+
   // Nested map: [tag][symbol_name] -> DWARFDie
   absl::flat_hash_map<llvm::dwarf::Tag, absl::flat_hash_map<std::string, llvm::DWARFDie>> die_map_;
+
+  // For DwarfIndexMode::kLazy: the units that have been added to die_map_.
+  absl::flat_hash_set<const llvm::DWARFUnit*> indexed_units_;
+  bool all_units_indexed_ = false;
+
+  // For DwarfIndexMode::kLazy on Go binaries: the compile units, by package name.
+  absl::flat_hash_map<std::string, llvm::DWARFUnit*> go_units_;
 };
 
 }  // namespace obj_tools
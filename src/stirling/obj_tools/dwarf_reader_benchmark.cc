@@ -17,11 +17,18 @@
  */
 
 #include <benchmark/benchmark.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
 
 #include "src/common/base/base.h"
 #include "src/common/testing/test_environment.h"
 #include "src/stirling/obj_tools/dwarf_reader.h"
 
+using px::stirling::obj_tools::DwarfIndexMode;
 using px::stirling::obj_tools::DwarfReader;
 using px::testing::BazelBinTestFilePath;
 
@@ -71,38 +78,58 @@ void GetSymAddrs(DwarfReader* dwarf_reader, SymAddrs* symaddrs) {
               "Fields");
 }
 
+// Returns the resident set size of this process, in bytes.
+int64_t ResidentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  int64_t size_pages = 0;
+  int64_t resident_pages = 0;
+  statm >> size_pages >> resident_pages;
+  return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+// Creates a DwarfReader with the given index mode and looks up the symbols range(0) times.
+// Besides the time, reports the memory taken by the DwarfReader, as the growth of the resident
+// set during the iteration; and the peak resident set of the process.
 // NOLINTNEXTLINE : runtime/references.
-static void BM_noindex(benchmark::State& state) {
+void BenchmarkLookups(benchmark::State& state, DwarfIndexMode index_mode) {
   size_t num_lookup_iterations = state.range(0);
 
+  int64_t max_rss_growth = 0;
   for (auto _ : state) {
     SymAddrs symaddrs;
 
+    int64_t rss_before = ResidentBytes();
     PL_ASSIGN_OR_EXIT(std::unique_ptr<DwarfReader> dwarf_reader,
-                      DwarfReader::Create(kBinary, /* index */ false));
+                      DwarfReader::Create(kBinary, index_mode));
 
     for (size_t i = 0; i < num_lookup_iterations; ++i) {
       GetSymAddrs(dwarf_reader.get(), &symaddrs);
       benchmark::DoNotOptimize(symaddrs);
     }
+    max_rss_growth = std::max(max_rss_growth, ResidentBytes() - rss_before);
   }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  state.counters["rss_growth_bytes"] = max_rss_growth;
+  // ru_maxrss is in kilobytes. It's the peak of the whole process, so it's only meaningful for the
+  // first benchmark run by a --benchmark_filter.
+  state.counters["peak_rss_bytes"] = usage.ru_maxrss * 1024.0;
 }
 
 // NOLINTNEXTLINE : runtime/references.
-static void BM_indexed(benchmark::State& state) {
-  size_t num_lookup_iterations = state.range(0);
-
-  for (auto _ : state) {
-    SymAddrs symaddrs;
-
-    PL_ASSIGN_OR_EXIT(std::unique_ptr<DwarfReader> dwarf_reader, DwarfReader::Create(kBinary));
+static void BM_noindex(benchmark::State& state) {
+  BenchmarkLookups(state, DwarfIndexMode::kNone);
+}
 
-    for (size_t i = 0; i < num_lookup_iterations; ++i) {
-      GetSymAddrs(dwarf_reader.get(), &symaddrs);
-      benchmark::DoNotOptimize(symaddrs);
-    }
-  }
+// NOLINTNEXTLINE : runtime/references.
+static void BM_indexed(benchmark::State& state) {
+  BenchmarkLookups(state, DwarfIndexMode::kEager);
 }
 
+// NOLINTNEXTLINE : runtime/references.
+static void BM_lazy(benchmark::State& state) { BenchmarkLookups(state, DwarfIndexMode::kLazy); }
+
 BENCHMARK(BM_noindex)->RangeMultiplier(2)->Range(1, 16);
 BENCHMARK(BM_indexed)->RangeMultiplier(2)->Range(1, 16);
+BENCHMARK(BM_lazy)->RangeMultiplier(2)->Range(1, 16);
@@ -47,7 +47,7 @@ using ::testing::UnorderedElementsAre;
 using ::px::operator<<;
 
 struct DwarfReaderTestParam {
-  bool index;
+  DwarfIndexMode index_mode;
 };
 
 class DwarfReaderTest : public ::testing::TestWithParam<DwarfReaderTestParam> {
@@ -101,7 +101,7 @@ TEST_F(DwarfReaderTest, SourceLanguage) {
 TEST_P(DwarfReaderTest, GetMatchingDIEsReturnsEmptyVector) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
   ASSERT_OK_AND_THAT(
       dwarf_reader->GetMatchingDIEs("non-existent-name", llvm::dwarf::DW_TAG_structure_type),
       IsEmpty());
@@ -110,7 +110,7 @@ TEST_P(DwarfReaderTest, GetMatchingDIEsReturnsEmptyVector) {
 TEST_P(DwarfReaderTest, CppGetStructByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("ABCStruct32"), 12);
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("ABCStruct64"), 24);
@@ -119,7 +119,7 @@ TEST_P(DwarfReaderTest, CppGetStructByteSize) {
 TEST_P(DwarfReaderTest, GolangGetStructByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGo1_16BinaryPath, p.index));
+                       DwarfReader::Create(kGo1_16BinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructByteSize("main.Vertex"), 16);
 }
@@ -127,7 +127,7 @@ TEST_P(DwarfReaderTest, GolangGetStructByteSize) {
 TEST_P(DwarfReaderTest, CppGetStructMemberInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructMemberInfo("ABCStruct32", llvm::dwarf::DW_TAG_structure_type, "b",
@@ -140,7 +140,7 @@ TEST_P(DwarfReaderTest, CppGetStructMemberInfo) {
 TEST_P(DwarfReaderTest, GoGetStructMemberInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGo1_16BinaryPath, p.index));
+                       DwarfReader::Create(kGo1_16BinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructMemberInfo("main.Vertex", llvm::dwarf::DW_TAG_structure_type, "Y",
@@ -153,7 +153,7 @@ TEST_P(DwarfReaderTest, GoGetStructMemberInfo) {
 TEST_P(DwarfReaderTest, CppGetStructMemberOffset) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("ABCStruct32", "a"), 0);
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("ABCStruct32", "b"), 4);
@@ -163,7 +163,7 @@ TEST_P(DwarfReaderTest, CppGetStructMemberOffset) {
 TEST_P(DwarfReaderTest, GoGetStructMemberOffset) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGo1_16BinaryPath, p.index));
+                       DwarfReader::Create(kGo1_16BinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("main.Vertex", "Y"), 8);
   EXPECT_NOT_OK(dwarf_reader->GetStructMemberOffset("main.Vertex", "bogus"));
@@ -173,7 +173,7 @@ TEST_P(DwarfReaderTest, GoGetStructMemberOffset) {
 TEST_P(DwarfReaderTest, GetStructMemberOffsetUnconventional) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGoBinaryUnconventionalPath, p.index));
+                       DwarfReader::Create(kGoBinaryUnconventionalPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetStructMemberOffset("runtime.g", "goid"), 192);
 }
@@ -181,7 +181,7 @@ TEST_P(DwarfReaderTest, GetStructMemberOffsetUnconventional) {
 TEST_P(DwarfReaderTest, CppGetStructSpec) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructSpec("OuterStruct"),
@@ -226,7 +226,7 @@ TEST_P(DwarfReaderTest, CppGetStructSpec) {
 TEST_P(DwarfReaderTest, GoGetStructSpec) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGo1_16BinaryPath, p.index));
+                       DwarfReader::Create(kGo1_16BinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(
       dwarf_reader->GetStructSpec("main.OuterStruct"),
@@ -271,7 +271,7 @@ TEST_P(DwarfReaderTest, GoGetStructSpec) {
 TEST_P(DwarfReaderTest, CppArgumentTypeByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("CanYouFindThis", "a"), 4);
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("ABCSum32", "x"), 12);
@@ -282,7 +282,7 @@ TEST_P(DwarfReaderTest, CppArgumentTypeByteSize) {
 TEST_P(DwarfReaderTest, GolangArgumentTypeByteSize) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGo1_16BinaryPath, p.index));
+                       DwarfReader::Create(kGo1_16BinaryPath, p.index_mode));
 
   // v is of type *Vertex.
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentTypeByteSize("main.(*Vertex).Scale", "v"), 8);
@@ -295,7 +295,7 @@ TEST_P(DwarfReaderTest, GolangArgumentTypeByteSize) {
 TEST_P(DwarfReaderTest, CppArgumentLocation) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentLocation("ABCSum32", "x"),
                    (VarLocation{.loc_type = LocationType::kRegister, .offset = 32}));
@@ -314,7 +314,7 @@ TEST_P(DwarfReaderTest, CppArgumentLocation) {
 TEST_P(DwarfReaderTest, Golang1_16ArgumentLocation) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGo1_16BinaryPath, p.index));
+                       DwarfReader::Create(kGo1_16BinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentLocation("main.(*Vertex).Scale", "v"),
                    (VarLocation{.loc_type = LocationType::kStack, .offset = 0}));
@@ -333,7 +333,7 @@ TEST_P(DwarfReaderTest, Golang1_16ArgumentLocation) {
 TEST_P(DwarfReaderTest, Golang1_17ArgumentLocation) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGo1_17BinaryPath, p.index));
+                       DwarfReader::Create(kGo1_17BinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetArgumentLocation("main.(*Vertex).Scale", "v"),
                    (VarLocation{.loc_type = LocationType::kRegister, .offset = 0}));
@@ -358,7 +358,7 @@ TEST_P(DwarfReaderTest, Golang1_17ArgumentLocation) {
 TEST_P(DwarfReaderTest, CppFunctionArgInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_THAT(
       dwarf_reader->GetFunctionArgInfo("CanYouFindThis"),
@@ -387,7 +387,7 @@ TEST_P(DwarfReaderTest, CppFunctionArgInfo) {
 TEST_P(DwarfReaderTest, CppFunctionRetValInfo) {
   DwarfReaderTestParam p = GetParam();
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kCppBinaryPath, p.index));
+                       DwarfReader::Create(kCppBinaryPath, p.index_mode));
 
   EXPECT_OK_AND_EQ(dwarf_reader->GetFunctionRetValInfo("CanYouFindThis"),
                    (RetValInfo{TypeInfo{VarType::kBaseType, "int"}, 4}));
@@ -402,7 +402,7 @@ TEST_P(DwarfReaderTest, GoFunctionArgInfo) {
 
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                         DwarfReader::Create(kGo1_16BinaryPath, p.index));
+                         DwarfReader::Create(kGo1_16BinaryPath, p.index_mode));
 
     EXPECT_OK_AND_THAT(
         dwarf_reader->GetFunctionArgInfo("main.(*Vertex).Scale"),
@@ -451,7 +451,7 @@ TEST_P(DwarfReaderTest, GoFunctionArgInfo) {
 
   {
     ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                         DwarfReader::Create(kGoServerBinaryPath, p.index));
+                         DwarfReader::Create(kGoServerBinaryPath, p.index_mode));
 
     // func (f *http2Framer) WriteDataPadded(streamID uint32, endStream bool, data, pad []byte)
     // error
@@ -478,7 +478,7 @@ TEST_P(DwarfReaderTest, GoFunctionVarLocationConsistency) {
   DwarfReaderTestParam p = GetParam();
 
   ASSERT_OK_AND_ASSIGN(std::unique_ptr<DwarfReader> dwarf_reader,
-                       DwarfReader::Create(kGo1_16BinaryPath, p.index));
+                       DwarfReader::Create(kGo1_16BinaryPath, p.index_mode));
 
   // First run GetFunctionArgInfo to automatically get all arguments.
   ASSERT_OK_AND_ASSIGN(auto function_arg_locations,
@@ -497,8 +497,9 @@ TEST_P(DwarfReaderTest, GoFunctionVarLocationConsistency) {
 }
 
 INSTANTIATE_TEST_SUITE_P(DwarfReaderParameterizedTest, DwarfReaderTest,
-                         ::testing::Values(DwarfReaderTestParam{true},
-                                           DwarfReaderTestParam{false}));
+                         ::testing::Values(DwarfReaderTestParam{DwarfIndexMode::kEager},
+                                           DwarfReaderTestParam{DwarfIndexMode::kNone},
+                                           DwarfReaderTestParam{DwarfIndexMode::kLazy}));
 
 }  // namespace obj_tools
 }  // namespace stirling
@@ -24,6 +24,7 @@
 #include <llvm/Support/TargetSelect.h>
 
 #include <absl/container/flat_hash_set.h>
+#include <cstring>
 #include <set>
 #include <utility>
 
@@ -166,6 +167,7 @@ StatusOr<std::unique_ptr<ElfReader>> ElfReader::Create(
   auto elf_reader = std::unique_ptr<ElfReader>(new ElfReader);
 
   elf_reader->binary_path_ = binary_path;
+  elf_reader->elf_path_ = binary_path;
 
   if (!elf_reader->elf_reader_.load(binary_path, /* skip_segments */ true)) {
     return error::Internal("Can't find or process ELF file $0", binary_path);
@@ -185,6 +187,7 @@ StatusOr<std::unique_ptr<ElfReader>> ElfReader::Create(
       LOG(INFO) << absl::Substitute("Found debug symbols file $0 for binary $1", debug_symbols_path,
                                     binary_path);
       elf_reader->elf_reader_.load(debug_symbols_path, /* skip_segments */ true);
+      elf_reader->elf_path_ = debug_symbols_path;
       return elf_reader;
     }
   }
@@ -214,52 +217,58 @@ StatusOr<ELFIO::section*> ElfReader::SymtabSection() {
   return symtab_section;
 }
 
+StatusOr<const ElfSymbolIndex*> ElfReader::SymbolIndex() {
+  if (symbol_index_ == nullptr) {
+    PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
+    PL_ASSIGN_OR_RETURN(symbol_index_,
+                        ElfSymbolIndex::Get(elf_path_, elf_reader_, *symtab_section));
+  }
+  return symbol_index_.get();
+}
+
 StatusOr<std::vector<ElfReader::SymbolInfo>> ElfReader::SearchSymbols(
     std::string_view search_symbol, SymbolMatchType match_type, std::optional<int> symbol_type,
     bool stop_at_first_match) {
-  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
+  PL_ASSIGN_OR_RETURN(const ElfSymbolIndex* index, SymbolIndex());
 
   std::vector<SymbolInfo> symbol_infos;
 
-  // Scan all symbols inside the symbol table.
-  const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
-  for (unsigned int j = 0; j < symbols.get_symbols_num(); ++j) {
-    std::string name;
-    ELFIO::Elf64_Addr addr = 0;
-    ELFIO::Elf_Xword size = 0;
-    unsigned char bind = 0;
-    unsigned char type = ELFIO::STT_NOTYPE;
-    ELFIO::Elf_Half section_index;
-    unsigned char other;
-    symbols.get_symbol(j, name, addr, size, bind, type, section_index, other);
-
-    if (symbol_type.has_value() && type != symbol_type.value()) {
-      continue;
+  auto add_symbol = [&](const ElfSymbolIndex::Symbol& symbol) {
+    if (symbol_type.has_value() && symbol.type != symbol_type.value()) {
+      return false;
     }
+    symbol_infos.push_back({std::string(symbol.name), symbol.type, symbol.address, symbol.size});
+    return stop_at_first_match;
+  };
+
+  // Exact matches are looked up by name, the others scan all the symbols.
+  if (match_type == SymbolMatchType::kExact) {
+    for (const ElfSymbolIndex::Symbol* symbol : index->FindByName(search_symbol)) {
+      if (add_symbol(*symbol)) {
+        break;
+      }
+    }
+    return symbol_infos;
+  }
 
+  for (const ElfSymbolIndex::Symbol& symbol : index->symbols()) {
     // Check for symbol match.
     bool match = false;
     switch (match_type) {
       case SymbolMatchType::kExact:
-        match = (name == search_symbol);
+        match = (symbol.name == search_symbol);
         break;
       case SymbolMatchType::kPrefix:
-        match = absl::StartsWith(name, search_symbol);
+        match = absl::StartsWith(symbol.name, search_symbol);
         break;
       case SymbolMatchType::kSuffix:
-        match = absl::EndsWith(name, search_symbol);
+        match = absl::EndsWith(symbol.name, search_symbol);
         break;
       case SymbolMatchType::kSubstr:
-        match = (name.find(search_symbol) != std::string::npos);
+        match = (symbol.name.find(search_symbol) != std::string_view::npos);
         break;
     }
-    if (!match) {
-      continue;
-    }
-
-    symbol_infos.push_back({std::move(name), type, addr, size});
-
-    if (stop_at_first_match) {
+    if (match && add_symbol(symbol)) {
       break;
     }
   }
@@ -310,77 +319,35 @@ std::optional<int64_t> ElfReader::SymbolAddress(std::string_view symbol) {
 }
 
 StatusOr<std::optional<std::string>> ElfReader::AddrToSymbol(size_t sym_addr) {
-  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
-
-  const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
-
-  // Call ELFIO to get symbol by address.
-  // ELFIO looks up the symbol and then populates name, size, type, etc.
-  // We only care about the name, but need to declare the other variables as well.
-  const ELFIO::Elf64_Addr addr = sym_addr;
-  std::string name;
-  ELFIO::Elf_Xword size = 0;
-  unsigned char bind = 0;
-  unsigned char type = ELFIO::STT_NOTYPE;
-  ELFIO::Elf_Half section_index;
-  unsigned char other;
-  bool found = symbols.get_symbol(addr, name, size, bind, type, section_index, other);
-
-  if (!found) {
+  PL_ASSIGN_OR_RETURN(const ElfSymbolIndex* index, SymbolIndex());
+
+  const ElfSymbolIndex::Symbol* symbol = index->FindByAddress(sym_addr);
+  if (symbol == nullptr) {
     return std::optional<std::string>();
   }
 
-  return std::optional<std::string>(std::move(name));
+  return std::optional<std::string>(std::string(symbol->name));
 }
 
-// TODO(oazizi): Optimize by indexing or switching to binary search if we can guarantee addresses
-//               are ordered.
 StatusOr<std::optional<std::string>> ElfReader::InstrAddrToSymbol(size_t sym_addr) {
-  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
-
-  const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
-  for (unsigned int j = 0; j < symbols.get_symbols_num(); ++j) {
-    // Call ELFIO to get symbol by index.
-    // ELFIO looks up the index and then populates name, addr, size, type, etc.
-    // We only care about the name and addr, but need to declare the other variables as well.
-    std::string name;
-    ELFIO::Elf64_Addr addr = 0;
-    ELFIO::Elf_Xword size = 0;
-    unsigned char bind = 0;
-    unsigned char type = ELFIO::STT_NOTYPE;
-    ELFIO::Elf_Half section_index;
-    unsigned char other;
-    symbols.get_symbol(j, name, addr, size, bind, type, section_index, other);
-
-    if (sym_addr >= addr && sym_addr < addr + size) {
-      return std::optional<std::string>(llvm::demangle(name));
-    }
+  PL_ASSIGN_OR_RETURN(const ElfSymbolIndex* index, SymbolIndex());
+
+  const ElfSymbolIndex::Symbol* symbol = index->FindContaining(sym_addr);
+  if (symbol == nullptr) {
+    return std::optional<std::string>();
   }
 
-  return std::optional<std::string>();
+  return std::optional<std::string>(llvm::demangle(std::string(symbol->name)));
 }
 
 StatusOr<std::unique_ptr<ElfReader::Symbolizer>> ElfReader::GetSymbolizer() {
-  PL_ASSIGN_OR_RETURN(ELFIO::section * symtab_section, SymtabSection());
+  PL_ASSIGN_OR_RETURN(const ElfSymbolIndex* index, SymbolIndex());
 
   auto symbolizer = std::make_unique<ElfReader::Symbolizer>();
 
-  const ELFIO::symbol_section_accessor symbols(elf_reader_, symtab_section);
-  for (unsigned int j = 0; j < symbols.get_symbols_num(); ++j) {
-    // Call ELFIO to get symbol by index.
-    // ELFIO looks up the index and then populates name, addr, size, type, etc.
-    // We only care about the name and addr, but need to declare the other variables as well.
-    std::string name;
-    ELFIO::Elf64_Addr addr = 0;
-    ELFIO::Elf_Xword size = 0;
-    unsigned char bind = 0;
-    unsigned char type = ELFIO::STT_NOTYPE;
-    ELFIO::Elf_Half section_index;
-    unsigned char other;
-    symbols.get_symbol(j, name, addr, size, bind, type, section_index, other);
-
-    if (type == ELFIO::STT_FUNC) {
-      symbolizer->AddEntry(addr, size, llvm::demangle(name));
+  for (const ElfSymbolIndex::Symbol& symbol : index->symbols()) {
+    if (symbol.type == ELFIO::STT_FUNC) {
+      symbolizer->AddEntry(symbol.address, symbol.size, llvm::demangle(std::string(symbol.name)));
     }
   }
 
@@ -465,7 +432,8 @@ std::vector<uint64_t> FindRetInsts(utils::u8string_view byte_code) {
 
   // TODO(yzhao): This is a short-term quick way to avoid unnecessary overheads.
   // We should create LLVMDisasmContext object inside SocketTraceConnector and pass it around.
-  static const LLVMDisasmContext kLLVMDisasmContext;
+  // The context is not safe to share, and binaries are analyzed by several threads at once.
+  static thread_local const LLVMDisasmContext kLLVMDisasmContext;
 
   // Size of the buffer to hold disassembled assembly code. Since we do not really use the assembly
   // code, we just provide a small buffer.
@@ -522,25 +490,89 @@ StatusOr<utils::u8string> ElfReader::SymbolByteCode(std::string_view section,
   if (text_section == nullptr) {
     return error::NotFound("Could not find section=$0 in binary=$1", section, binary_path_);
   }
-  int offset = symbol.address - text_section->get_address() + text_section->get_offset();
+  uint64_t offset = symbol.address - text_section->get_address() + text_section->get_offset();
 
-  std::ifstream ifs(binary_path_, std::ios::binary);
-  if (!ifs.seekg(offset)) {
-    return error::Internal("Failed to seek position=$0 in binary=$1", offset, binary_path_);
-  }
-  utils::u8string byte_code(symbol.size, '\0');
-  auto* buf = reinterpret_cast<char*>(byte_code.data());
-  if (!ifs.read(buf, symbol.size)) {
-    return error::Internal("Failed to read size=$0 bytes from offset=$1 in binary=$2", symbol.size,
-                           offset, binary_path_);
+  if (binary_file_ == nullptr) {
+    PL_ASSIGN_OR_RETURN(binary_file_, MappedFile::Create(binary_path_));
   }
-  if (ifs.gcount() != static_cast<int64_t>(symbol.size)) {
-    return error::Internal("Only read size=$0 bytes from offset=$1 in binary=$2, expect $3 bytes",
-                           symbol.size, offset, binary_path_, ifs.gcount());
+  std::string_view data = binary_file_->data();
+  if (offset > data.size() || symbol.size > data.size() - offset) {
+    return error::Internal("Failed to read size=$0 bytes from offset=$1 in binary=$2, size=$3",
+                           symbol.size, offset, binary_path_, data.size());
   }
+  utils::u8string byte_code(reinterpret_cast<const uint8_t*>(data.data() + offset), symbol.size);
   return byte_code;
 }
 
+namespace {
+
+template <typename T>
+bool ReadStruct(std::string_view data, uint64_t offset, T* val) {
+  if (offset > data.size() || sizeof(T) > data.size() - offset) {
+    return false;
+  }
+  std::memcpy(val, data.data() + offset, sizeof(T));
+  return true;
+}
+
+}  // namespace
+
+StatusOr<std::string> ReadBuildID(const std::filesystem::path& path) {
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<MappedFile> file, MappedFile::Create(path));
+  std::string_view data = file->data();
+
+  ELFIO::Elf64_Ehdr header;
+  if (!ReadStruct(data, 0, &header) || std::memcmp(header.e_ident, "\x7f" "ELF", 4) != 0) {
+    return error::InvalidArgument("$0 is not an ELF file", path.string());
+  }
+  if (header.e_ident[ELFIO::EI_CLASS] != ELFIO::ELFCLASS64) {
+    return error::Unimplemented("$0 is not a 64-bit ELF file", path.string());
+  }
+
+  std::string_view go_build_id;
+  for (int i = 0; i < header.e_shnum; ++i) {
+    ELFIO::Elf64_Shdr section;
+    if (!ReadStruct(data, header.e_shoff + i * sizeof(section), &section)) {
+      return error::Internal("Section header $0 is out of the bounds of $1", i, path.string());
+    }
+    if (section.sh_type != ELFIO::SHT_NOTE) {
+      continue;
+    }
+
+    // Same structure as described in LocateDebugSymbols(), with the fields padded to 4 bytes.
+    constexpr uint32_t kGNUBuildIDType = 3;
+    constexpr std::string_view kGNUName("GNU\0", 4);
+    constexpr uint32_t kGoBuildIDType = 4;
+    constexpr std::string_view kGoName("Go\0\0", 4);
+    uint64_t pos = section.sh_offset;
+    const uint64_t end = section.sh_offset + section.sh_size;
+    while (pos + 3 * sizeof(uint32_t) <= end) {
+      uint32_t fields[3];
+      if (!ReadStruct(data, pos, &fields)) {
+        break;
+      }
+      const uint32_t name_size = fields[0];
+      const uint32_t desc_size = fields[1];
+      const uint64_t name_pos = pos + sizeof(fields);
+      const uint64_t desc_pos = name_pos + SnapUpToMultiple<uint64_t>(name_size, 4);
+      if (desc_pos + desc_size > end || desc_pos + desc_size > data.size()) {
+        break;
+      }
+      if (fields[2] == kGNUBuildIDType && data.substr(name_pos, name_size) == kGNUName) {
+        return BytesToString<LowercaseHex>(data.substr(desc_pos, desc_size));
+      }
+      if (fields[2] == kGoBuildIDType && data.substr(name_pos, name_size) == kGoName) {
+        go_build_id = data.substr(desc_pos, desc_size);
+      }
+      pos = desc_pos + SnapUpToMultiple<uint64_t>(desc_size, 4);
+    }
+  }
+  if (!go_build_id.empty()) {
+    return BytesToString<LowercaseHex>(go_build_id);
+  }
+  return error::NotFound("$0 has no build-id", path.string());
+}
+
 }  // namespace obj_tools
 }  // namespace stirling
 }  // namespace px
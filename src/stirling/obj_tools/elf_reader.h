@@ -29,6 +29,7 @@
 #include <elfio/elfio.hpp>
 
 #include "src/common/base/base.h"
+#include "src/stirling/obj_tools/elf_symbol_index.h"
 
 namespace px {
 namespace stirling {
@@ -169,6 +170,12 @@ class ElfReader {
 
   StatusOr<ELFIO::section*> SymtabSection();
 
+  /**
+   * Returns the index of the symbol table, which is built on first use, or shared with the other
+   * ElfReaders of the same file.
+   */
+  StatusOr<const ElfSymbolIndex*> SymbolIndex();
+
   /**
    * Locates the debug symbols for the currently loaded ELF object.
    * External symbols are discovered using either the build-id or the debug-link.
@@ -187,10 +194,25 @@ class ElfReader {
 
   std::filesystem::path debug_symbols_path_;
 
+  // The file loaded by elf_reader_: either binary_path_, or its external debug symbols.
+  std::filesystem::path elf_path_;
+
   // Set up an elf reader, so we can extract debug symbols.
   ELFIO::elfio elf_reader_;
+
+  std::shared_ptr<const ElfSymbolIndex> symbol_index_;
+
+  // A mapping of binary_path_, to read the byte code of functions.
+  std::unique_ptr<MappedFile> binary_file_;
 };
 
+/**
+ * Returns the GNU build-id of an ELF file, or the Go build ID of Go binaries that have no GNU
+ * build-id, hex encoded. Unlike ElfReader, this only reads the ELF and section headers and the
+ * notes, from a mapping of the file.
+ */
+StatusOr<std::string> ReadBuildID(const std::filesystem::path& path);
+
 }  // namespace obj_tools
 }  // namespace stirling
 }  // namespace px
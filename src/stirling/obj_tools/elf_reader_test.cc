@@ -208,6 +208,15 @@ TEST(ElfReaderTest, ExternalDebugSymbolsDebugLink) {
                      ElementsAre(SymbolNameIs("CanYouFindThis")));
 }
 
+TEST(ElfReaderTest, ReadBuildID) {
+  const std::string stripped_bin =
+      px::testing::TestFilePath("src/stirling/obj_tools/testdata/cc/stripped_test_exe");
+  // Matches the file name of the external debug symbols under testdata/cc/usr/lib/debug.
+  EXPECT_OK_AND_EQ(ReadBuildID(stripped_bin), "7deb0e3f89deba61");
+
+  EXPECT_NOT_OK(ReadBuildID("/bogus"));
+}
+
 TEST(ElfReaderTest, FuncByteCode) {
   {
     const std::string path =
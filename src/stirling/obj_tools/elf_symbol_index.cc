@@ -0,0 +1,238 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/obj_tools/elf_symbol_index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <absl/synchronization/mutex.h>
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+namespace {
+
+MappedFile::Identity FileIdentity(const struct stat& st) {
+  MappedFile::Identity identity;
+  identity.dev = st.st_dev;
+  identity.inode = st.st_ino;
+  identity.size = st.st_size;
+  identity.mtime_ns =
+      static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 * 1000 * 1000 + st.st_mtim.tv_nsec;
+  return identity;
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<MappedFile>> MappedFile::Create(const std::filesystem::path& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Could not open $0: $1", path.string(), std::strerror(errno));
+  }
+  DEFER(close(fd));
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return error::Internal("Could not stat $0: $1", path.string(), std::strerror(errno));
+  }
+  if (st.st_size == 0) {
+    return error::Internal("File $0 is empty", path.string());
+  }
+  // The mapping holds a reference to the file, so the descriptor can be closed right away.
+  void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) {
+    return error::Internal("Could not mmap $0: $1", path.string(), std::strerror(errno));
+  }
+  return std::unique_ptr<MappedFile>(new MappedFile(addr, st.st_size, FileIdentity(st)));
+}
+
+MappedFile::~MappedFile() { munmap(addr_, size_); }
+
+StatusOr<std::shared_ptr<const ElfSymbolIndex>> ElfSymbolIndex::Get(
+    const std::filesystem::path& path, const ELFIO::elfio& elf, const ELFIO::section& symtab) {
+  static absl::Mutex cache_mutex;
+  static auto& cache =
+      *new absl::flat_hash_map<MappedFile::Identity, std::weak_ptr<const ElfSymbolIndex>>();
+
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return error::Internal("Could not stat $0: $1", path.string(), std::strerror(errno));
+  }
+  {
+    absl::MutexLock lock(&cache_mutex);
+    auto iter = cache.find(FileIdentity(st));
+    if (iter != cache.end()) {
+      std::shared_ptr<const ElfSymbolIndex> index = iter->second.lock();
+      if (index != nullptr) {
+        return index;
+      }
+    }
+  }
+
+  // Built without holding the lock; if another thread beat us to it, its index is kept.
+  auto index = std::shared_ptr<ElfSymbolIndex>(new ElfSymbolIndex);
+  PL_ASSIGN_OR_RETURN(index->file_, MappedFile::Create(path));
+  PL_RETURN_IF_ERROR(index->Build(elf, symtab));
+
+  absl::MutexLock lock(&cache_mutex);
+  for (auto iter = cache.begin(); iter != cache.end();) {
+    if (iter->second.expired()) {
+      cache.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+  auto [iter, inserted] = cache.try_emplace(index->file_->identity(), index);
+  if (!inserted) {
+    std::shared_ptr<const ElfSymbolIndex> cached = iter->second.lock();
+    if (cached != nullptr) {
+      return cached;
+    }
+    iter->second = index;
+  }
+  return std::shared_ptr<const ElfSymbolIndex>(std::move(index));
+}
+
+template <typename TSym>
+Status ElfSymbolIndex::ReadSymbols(const ELFIO::elfio& elf, const ELFIO::section& symtab,
+                                   const ELFIO::section& strtab) {
+  std::string_view data = file_->data();
+  if (symtab.get_offset() + symtab.get_size() > data.size() ||
+      strtab.get_offset() + strtab.get_size() > data.size()) {
+    return error::Internal("Symbol table is out of the bounds of the file");
+  }
+  std::string_view strings = data.substr(strtab.get_offset(), strtab.get_size());
+  const char* sym_data = data.data() + symtab.get_offset();
+  const size_t num_symbols = symtab.get_size() / sizeof(TSym);
+  const ELFIO::endianess_convertor& convertor = elf.get_convertor();
+
+  symbols_.reserve(num_symbols);
+  for (size_t i = 0; i < num_symbols; ++i) {
+    // The mapping isn't necessarily aligned for TSym.
+    TSym sym;
+    std::memcpy(&sym, sym_data + i * sizeof(TSym), sizeof(TSym));
+
+    uint32_t name_offset = convertor(sym.st_name);
+    std::string_view name;
+    if (name_offset < strings.size()) {
+      name = strings.substr(name_offset);
+      name = name.substr(0, name.find('\0'));
+    }
+    symbols_.push_back(Symbol{name, convertor(sym.st_value), convertor(sym.st_size),
+                              static_cast<uint8_t>(ELF_ST_TYPE(sym.st_info))});
+  }
+  return Status::OK();
+}
+
+Status ElfSymbolIndex::Build(const ELFIO::elfio& elf, const ELFIO::section& symtab) {
+  if (symtab.get_type() == ELFIO::SHT_NOBITS) {
+    return error::NotFound("Symbol table has no data");
+  }
+  if (symtab.get_link() >= elf.sections.size()) {
+    return error::Internal("Invalid string table index $0", symtab.get_link());
+  }
+  const ELFIO::section& strtab = *elf.sections[symtab.get_link()];
+
+  if (elf.get_class() == ELFIO::ELFCLASS32) {
+    PL_RETURN_IF_ERROR(ReadSymbols<ELFIO::Elf32_Sym>(elf, symtab, strtab));
+  } else {
+    PL_RETURN_IF_ERROR(ReadSymbols<ELFIO::Elf64_Sym>(elf, symtab, strtab));
+  }
+
+  next_by_name_.assign(symbols_.size(), kNoSymbol);
+  // Walked backwards, so that each name ends up pointing at its first symbol.
+  for (uint32_t i = symbols_.size(); i-- > 0;) {
+    auto [iter, inserted] = first_by_name_.try_emplace(symbols_[i].name, i);
+    if (!inserted) {
+      next_by_name_[i] = iter->second;
+      iter->second = i;
+    }
+  }
+
+  by_address_.resize(symbols_.size());
+  for (uint32_t i = 0; i < symbols_.size(); ++i) {
+    by_address_[i] = i;
+  }
+  std::sort(by_address_.begin(), by_address_.end(), [this](uint32_t a, uint32_t b) {
+    return symbols_[a].address < symbols_[b].address ||
+           (symbols_[a].address == symbols_[b].address && a < b);
+  });
+
+  max_end_by_address_.resize(by_address_.size());
+  uint64_t max_end = 0;
+  for (size_t i = 0; i < by_address_.size(); ++i) {
+    const Symbol& symbol = symbols_[by_address_[i]];
+    max_end = std::max(max_end, symbol.address + symbol.size);
+    max_end_by_address_[i] = max_end;
+  }
+  return Status::OK();
+}
+
+std::vector<const ElfSymbolIndex::Symbol*> ElfSymbolIndex::FindByName(
+    std::string_view name) const {
+  std::vector<const Symbol*> symbols;
+  auto iter = first_by_name_.find(name);
+  if (iter == first_by_name_.end()) {
+    return symbols;
+  }
+  for (uint32_t i = iter->second; i != kNoSymbol; i = next_by_name_[i]) {
+    symbols.push_back(&symbols_[i]);
+  }
+  return symbols;
+}
+
+const ElfSymbolIndex::Symbol* ElfSymbolIndex::FindByAddress(uint64_t addr) const {
+  auto iter = std::lower_bound(by_address_.begin(), by_address_.end(), addr,
+                               [this](uint32_t i, uint64_t addr) {
+                                 return symbols_[i].address < addr;
+                               });
+  if (iter == by_address_.end() || symbols_[*iter].address != addr) {
+    return nullptr;
+  }
+  return &symbols_[*iter];
+}
+
+const ElfSymbolIndex::Symbol* ElfSymbolIndex::FindContaining(uint64_t addr) const {
+  // The symbols that start at or before addr.
+  auto end = std::upper_bound(by_address_.begin(), by_address_.end(), addr,
+                              [this](uint64_t addr, uint32_t i) {
+                                return addr < symbols_[i].address;
+                              });
+
+  // Walk back while a symbol that far back could still reach addr, and keep the first one in
+  // symbol table order. This is usually just the closest symbol.
+  uint32_t found = kNoSymbol;
+  for (size_t pos = end - by_address_.begin(); pos-- > 0 && max_end_by_address_[pos] > addr;) {
+    uint32_t i = by_address_[pos];
+    if (addr < symbols_[i].address + symbols_[i].size && i < found) {
+      found = i;
+    }
+  }
+  return found == kNoSymbol ? nullptr : &symbols_[found];
+}
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include <elfio/elfio.hpp>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+/**
+ * A read-only mapping of a whole file.
+ */
+class MappedFile {
+ public:
+  static StatusOr<std::unique_ptr<MappedFile>> Create(const std::filesystem::path& path);
+
+  ~MappedFile();
+
+  std::string_view data() const { return std::string_view(static_cast<const char*>(addr_), size_); }
+
+  // Identifies the contents of the file: its device, inode, size and modification time.
+  struct Identity {
+    dev_t dev = 0;
+    ino_t inode = 0;
+    int64_t size = 0;
+    int64_t mtime_ns = 0;
+
+    bool operator==(const Identity& other) const {
+      return dev == other.dev && inode == other.inode && size == other.size &&
+             mtime_ns == other.mtime_ns;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const Identity& id) {
+      return H::combine(std::move(h), id.dev, id.inode, id.size, id.mtime_ns);
+    }
+  };
+
+  const Identity& identity() const { return identity_; }
+
+ private:
+  MappedFile(void* addr, size_t size, Identity identity)
+      : addr_(addr), size_(size), identity_(identity) {}
+
+  void* addr_;
+  size_t size_;
+  Identity identity_;
+};
+
+/**
+ * An index of the symbol table of an ELF file, by address and by name.
+ *
+ * The symbols are read in place from a mapping of the file, so the index costs a few words per
+ * symbol. It is immutable once built, and one index is shared by all the ElfReaders of the same
+ * file in the process.
+ */
+class ElfSymbolIndex {
+ public:
+  struct Symbol {
+    // Points into the file mapping, which lives as long as the index.
+    std::string_view name;
+    uint64_t address;
+    uint64_t size;
+    uint8_t type;
+  };
+
+  /**
+   * Returns the index of the symbol table of the file, which was already loaded into elf.
+   * The index is taken from a process-wide cache while any reader of the same file holds it.
+   *
+   * @param path The ELF file.
+   * @param elf The ELF headers of the file, loaded by ELFIO.
+   * @param symtab The section of the symbol table, SHT_SYMTAB or SHT_DYNSYM.
+   */
+  static StatusOr<std::shared_ptr<const ElfSymbolIndex>> Get(const std::filesystem::path& path,
+                                                             const ELFIO::elfio& elf,
+                                                             const ELFIO::section& symtab);
+
+  // All the symbols, in symbol table order.
+  const std::vector<Symbol>& symbols() const { return symbols_; }
+
+  /**
+   * Returns the symbols named name, in symbol table order.
+   */
+  std::vector<const Symbol*> FindByName(std::string_view name) const;
+
+  /**
+   * Returns the first symbol, in symbol table order, that's located at addr.
+   */
+  const Symbol* FindByAddress(uint64_t addr) const;
+
+  /**
+   * Returns the first symbol, in symbol table order, whose [address, address + size) range
+   * contains addr.
+   */
+  const Symbol* FindContaining(uint64_t addr) const;
+
+ private:
+  ElfSymbolIndex() = default;
+
+  Status Build(const ELFIO::elfio& elf, const ELFIO::section& symtab);
+
+  template <typename TSym>
+  Status ReadSymbols(const ELFIO::elfio& elf, const ELFIO::section& symtab,
+                     const ELFIO::section& strtab);
+
+  std::unique_ptr<MappedFile> file_;
+
+  std::vector<Symbol> symbols_;
+
+  // The index into symbols_ of the first symbol of each name, and for each symbol, the index of
+  // the next one with the same name, or kNoSymbol.
+  static constexpr uint32_t kNoSymbol = -1;
+  absl::flat_hash_map<std::string_view, uint32_t> first_by_name_;
+  std::vector<uint32_t> next_by_name_;
+
+  // Indexes into symbols_, sorted by address, then by index.
+  std::vector<uint32_t> by_address_;
+
+  // For each position of by_address_, the largest end address of the symbols up to it. Symbols
+  // can overlap, so this bounds how far back a symbol containing an address can be.
+  std::vector<uint64_t> max_end_by_address_;
+};
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
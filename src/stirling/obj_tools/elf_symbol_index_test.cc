@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/obj_tools/elf_symbol_index.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/obj_tools/testdata/cc/test_exe_fixture.h"
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+const TestExeFixture kTestExeFixture;
+
+class ElfSymbolIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(elf_.load(kTestExeFixture.Path().string(), /* skip_segments */ true));
+    for (int i = 0; i < elf_.sections.size(); ++i) {
+      if (elf_.sections[i]->get_type() == ELFIO::SHT_SYMTAB) {
+        symtab_ = elf_.sections[i];
+      }
+    }
+    ASSERT_NE(symtab_, nullptr);
+  }
+
+  ELFIO::elfio elf_;
+  ELFIO::section* symtab_ = nullptr;
+};
+
+TEST_F(ElfSymbolIndexTest, Lookups) {
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ElfSymbolIndex> index,
+                       ElfSymbolIndex::Get(kTestExeFixture.Path(), elf_, *symtab_));
+
+  std::vector<const ElfSymbolIndex::Symbol*> symbols = index->FindByName("CanYouFindThis");
+  ASSERT_EQ(symbols.size(), 1);
+  const ElfSymbolIndex::Symbol& symbol = *symbols.front();
+  EXPECT_EQ(symbol.type, ELFIO::STT_FUNC);
+  ASSERT_GT(symbol.size, 4);
+
+  EXPECT_EQ(index->FindByAddress(symbol.address), &symbol);
+  EXPECT_EQ(index->FindByAddress(symbol.address + 4), nullptr);
+
+  EXPECT_EQ(index->FindContaining(symbol.address), &symbol);
+  EXPECT_EQ(index->FindContaining(symbol.address + 4), &symbol);
+  EXPECT_NE(index->FindContaining(symbol.address + symbol.size), &symbol);
+
+  EXPECT_TRUE(index->FindByName("NoSuchSymbol").empty());
+  EXPECT_EQ(index->FindContaining(0), nullptr);
+}
+
+// The index is shared while it's in use, and released afterwards.
+TEST_F(ElfSymbolIndexTest, SharedByReaders) {
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ElfSymbolIndex> index1,
+                       ElfSymbolIndex::Get(kTestExeFixture.Path(), elf_, *symtab_));
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ElfSymbolIndex> index2,
+                       ElfSymbolIndex::Get(kTestExeFixture.Path(), elf_, *symtab_));
+  EXPECT_EQ(index1, index2);
+
+  std::weak_ptr<const ElfSymbolIndex> weak_index = index1;
+  index1.reset();
+  index2.reset();
+  EXPECT_TRUE(weak_index.expired());
+}
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
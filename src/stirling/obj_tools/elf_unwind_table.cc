@@ -0,0 +1,779 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/obj_tools/elf_unwind_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include <elfio/elfio.hpp>
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+namespace {
+
+using CFARule = ElfUnwindTable::CFARule;
+using BPRule = ElfUnwindTable::BPRule;
+using Row = ElfUnwindTable::Row;
+
+// DWARF register numbers on x86-64.
+constexpr uint64_t kRegBP = 6;
+constexpr uint64_t kRegSP = 7;
+constexpr uint64_t kRegRA = 16;
+
+// Call frame instructions. See section 6.4.2 of the DWARF 5 spec.
+constexpr uint8_t kCFAAdvanceLoc = 0x40;
+constexpr uint8_t kCFAOffset = 0x80;
+constexpr uint8_t kCFARestore = 0xc0;
+constexpr uint8_t kCFANop = 0x00;
+constexpr uint8_t kCFASetLoc = 0x01;
+constexpr uint8_t kCFAAdvanceLoc1 = 0x02;
+constexpr uint8_t kCFAAdvanceLoc2 = 0x03;
+constexpr uint8_t kCFAAdvanceLoc4 = 0x04;
+constexpr uint8_t kCFAOffsetExtended = 0x05;
+constexpr uint8_t kCFARestoreExtended = 0x06;
+constexpr uint8_t kCFAUndefined = 0x07;
+constexpr uint8_t kCFASameValue = 0x08;
+constexpr uint8_t kCFARegister = 0x09;
+constexpr uint8_t kCFARememberState = 0x0a;
+constexpr uint8_t kCFARestoreState = 0x0b;
+constexpr uint8_t kCFADefCFA = 0x0c;
+constexpr uint8_t kCFADefCFARegister = 0x0d;
+constexpr uint8_t kCFADefCFAOffset = 0x0e;
+constexpr uint8_t kCFADefCFAExpression = 0x0f;
+constexpr uint8_t kCFAExpression = 0x10;
+constexpr uint8_t kCFAOffsetExtendedSF = 0x11;
+constexpr uint8_t kCFADefCFASF = 0x12;
+constexpr uint8_t kCFADefCFAOffsetSF = 0x13;
+constexpr uint8_t kCFAValOffset = 0x14;
+constexpr uint8_t kCFAValOffsetSF = 0x15;
+constexpr uint8_t kCFAValExpression = 0x16;
+constexpr uint8_t kCFAGNUArgsSize = 0x2e;
+constexpr uint8_t kCFAGNUNegativeOffsetExtended = 0x2f;
+
+// Pointer encodings of .eh_frame. See the DWARF extensions of the Linux Standard Base.
+constexpr uint8_t kPEAbsPtr = 0x00;
+constexpr uint8_t kPEULEB128 = 0x01;
+constexpr uint8_t kPEUData2 = 0x02;
+constexpr uint8_t kPEUData4 = 0x03;
+constexpr uint8_t kPEUData8 = 0x04;
+constexpr uint8_t kPESLEB128 = 0x09;
+constexpr uint8_t kPESData2 = 0x0a;
+constexpr uint8_t kPESData4 = 0x0b;
+constexpr uint8_t kPESData8 = 0x0c;
+constexpr uint8_t kPEPCRel = 0x10;
+constexpr uint8_t kPEIndirect = 0x80;
+constexpr uint8_t kPEFormatMask = 0x0f;
+constexpr uint8_t kPEApplicationMask = 0x70;
+
+// Reads the little endian fields of a section, within [pos, end). Reading past the end marks it as
+// not ok, and returns zeros.
+class Cursor {
+ public:
+  Cursor(std::string_view data, uint64_t pos, uint64_t end)
+      : data_(data), pos_(pos), end_(std::min<uint64_t>(end, data.size())) {}
+
+  bool ok() const { return ok_; }
+  bool AtEnd() const { return !ok_ || pos_ >= end_; }
+  uint64_t pos() const { return pos_; }
+
+  void Seek(uint64_t pos) {
+    ok_ = ok_ && pos <= end_;
+    pos_ = pos;
+  }
+
+  template <typename T>
+  T Read() {
+    T val = {};
+    if (!ok_ || pos_ + sizeof(T) > end_) {
+      ok_ = false;
+      return val;
+    }
+    std::memcpy(&val, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return val;
+  }
+
+  uint64_t ReadULEB128() {
+    uint64_t val = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = Read<uint8_t>();
+      val |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return val;
+      }
+    }
+    ok_ = false;
+    return 0;
+  }
+
+  int64_t ReadSLEB128() {
+    uint64_t val = 0;
+    for (int shift = 0; shift < 64;) {
+      uint8_t byte = Read<uint8_t>();
+      val |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      shift += 7;
+      if ((byte & 0x80) == 0) {
+        if (shift < 64 && (byte & 0x40) != 0) {
+          val |= ~uint64_t{0} << shift;
+        }
+        return static_cast<int64_t>(val);
+      }
+    }
+    ok_ = false;
+    return 0;
+  }
+
+  std::string_view ReadCString() {
+    std::string_view rest = ok_ && pos_ < end_ ? data_.substr(pos_, end_ - pos_) : "";
+    size_t len = rest.find('\0');
+    if (len == std::string_view::npos) {
+      ok_ = false;
+      return {};
+    }
+    pos_ += len + 1;
+    return rest.substr(0, len);
+  }
+
+ private:
+  std::string_view data_;
+  uint64_t pos_;
+  uint64_t end_;
+  bool ok_ = true;
+};
+
+// Reads a pointer of the given encoding, at address section_addr + pos() once loaded.
+std::optional<uint64_t> ReadEncodedPointer(Cursor* c, uint8_t encoding, uint64_t section_addr) {
+  const uint64_t field_addr = section_addr + c->pos();
+  uint64_t val;
+  switch (encoding & kPEFormatMask) {
+    case kPEAbsPtr:
+    case kPEUData8:
+    case kPESData8:
+      val = c->Read<uint64_t>();
+      break;
+    case kPEULEB128:
+      val = c->ReadULEB128();
+      break;
+    case kPEUData2:
+      val = c->Read<uint16_t>();
+      break;
+    case kPEUData4:
+      val = c->Read<uint32_t>();
+      break;
+    case kPESLEB128:
+      val = static_cast<uint64_t>(c->ReadSLEB128());
+      break;
+    case kPESData2:
+      val = static_cast<uint64_t>(static_cast<int64_t>(c->Read<int16_t>()));
+      break;
+    case kPESData4:
+      val = static_cast<uint64_t>(static_cast<int64_t>(c->Read<int32_t>()));
+      break;
+    default:
+      return std::nullopt;
+  }
+  switch (encoding & kPEApplicationMask) {
+    case 0:
+      break;
+    case kPEPCRel:
+      val += field_addr;
+      break;
+    default:
+      // Relative to sections that aren't used for code addresses on x86-64.
+      return std::nullopt;
+  }
+  if ((encoding & kPEIndirect) != 0 || !c->ok()) {
+    return std::nullopt;
+  }
+  return val;
+}
+
+// The header of a CIE or an FDE.
+struct EntryHeader {
+  // Zero for the terminator of .eh_frame.
+  uint64_t length;
+  // The position of the CIE id, or of the CIE pointer of an FDE.
+  uint64_t id_pos;
+  uint64_t id;
+  uint64_t end;
+  bool is_cie;
+  bool is_64bit;
+};
+
+std::optional<EntryHeader> ReadEntryHeader(std::string_view data, uint64_t offset,
+                                           bool is_eh_frame) {
+  Cursor c(data, offset, data.size());
+  EntryHeader entry;
+  entry.length = c.Read<uint32_t>();
+  entry.is_64bit = entry.length == 0xffffffff;
+  if (entry.is_64bit) {
+    entry.length = c.Read<uint64_t>();
+  }
+  entry.id_pos = c.pos();
+  entry.end = entry.id_pos + entry.length;
+  if (!c.ok() || entry.end > data.size() || entry.end < entry.id_pos) {
+    return std::nullopt;
+  }
+  if (entry.length == 0) {
+    entry.id = 0;
+    entry.is_cie = false;
+    return entry;
+  }
+  Cursor id_cursor(data, entry.id_pos, entry.end);
+  entry.id = entry.is_64bit ? id_cursor.Read<uint64_t>() : id_cursor.Read<uint32_t>();
+  if (is_eh_frame) {
+    entry.is_cie = entry.id == 0;
+  } else {
+    entry.is_cie = entry.id == (entry.is_64bit ? ~uint64_t{0} : uint64_t{0xffffffff});
+  }
+  return entry;
+}
+
+struct CIE {
+  uint64_t code_align = 0;
+  int64_t data_align = 0;
+  uint8_t fde_encoding = kPEAbsPtr;
+  bool has_augmentation_data = false;
+  uint64_t instructions_begin = 0;
+  uint64_t instructions_end = 0;
+};
+
+std::optional<CIE> ParseCIE(std::string_view data, uint64_t offset, bool is_eh_frame) {
+  std::optional<EntryHeader> entry = ReadEntryHeader(data, offset, is_eh_frame);
+  if (!entry.has_value() || entry->length == 0 || !entry->is_cie) {
+    return std::nullopt;
+  }
+  Cursor c(data, entry->id_pos + (entry->is_64bit ? 8 : 4), entry->end);
+
+  CIE cie;
+  const uint8_t version = c.Read<uint8_t>();
+  const std::string_view augmentation = c.ReadCString();
+  if (version >= 4) {
+    const uint8_t address_size = c.Read<uint8_t>();
+    const uint8_t segment_selector_size = c.Read<uint8_t>();
+    if (address_size != 8 || segment_selector_size != 0) {
+      return std::nullopt;
+    }
+  }
+  cie.code_align = c.ReadULEB128();
+  cie.data_align = c.ReadSLEB128();
+  const uint64_t ra_reg = version == 1 ? c.Read<uint8_t>() : c.ReadULEB128();
+  if (ra_reg != kRegRA) {
+    return std::nullopt;
+  }
+
+  if (!augmentation.empty() && augmentation[0] == 'z') {
+    cie.has_augmentation_data = true;
+    const uint64_t length = c.ReadULEB128();
+    const uint64_t end = c.pos() + length;
+    for (char ch : augmentation.substr(1)) {
+      if (ch == 'R') {
+        cie.fde_encoding = c.Read<uint8_t>();
+      } else if (ch == 'P') {
+        // The personality routine is only skipped over.
+        const uint8_t encoding = c.Read<uint8_t>();
+        ReadEncodedPointer(&c, encoding & kPEFormatMask, 0);
+      } else if (ch == 'L') {
+        c.Read<uint8_t>();
+      } else if (ch != 'S' && ch != 'B' && ch != 'G') {
+        // The rest of the augmentation data can't be interpreted, but it can be skipped.
+        break;
+      }
+    }
+    c.Seek(end);
+  } else if (!augmentation.empty()) {
+    // Without 'z', the size of the augmentation data is unknown.
+    return std::nullopt;
+  }
+
+  if (!c.ok()) {
+    return std::nullopt;
+  }
+  cie.instructions_begin = c.pos();
+  cie.instructions_end = entry->end;
+  return cie;
+}
+
+// The rules of the registers needed to unwind, while running call frame instructions.
+struct UnwindState {
+  uint64_t cfa_reg = kRegSP;
+  int64_t cfa_offset = 8;
+  bool cfa_expression = false;
+
+  BPRule bp_rule = BPRule::kSameValue;
+  int64_t bp_offset = 0;
+
+  // The return address is either undefined, which marks the outermost frame, or at CFA - 8.
+  bool ra_undefined = false;
+  bool ra_unsupported = false;
+};
+
+Row MakeRow(uint64_t pc, const UnwindState& state) {
+  Row row = {pc, 0, 0, CFARule::kUndefined, BPRule::kUndefined};
+  if (state.ra_undefined) {
+    return row;
+  }
+  if (state.cfa_expression || state.ra_unsupported ||
+      (state.cfa_reg != kRegSP && state.cfa_reg != kRegBP) ||
+      state.cfa_offset < std::numeric_limits<int32_t>::min() ||
+      state.cfa_offset > std::numeric_limits<int32_t>::max()) {
+    row.cfa_rule = CFARule::kExpression;
+    return row;
+  }
+  row.cfa_rule = state.cfa_reg == kRegSP ? CFARule::kSP : CFARule::kBP;
+  row.cfa_offset = static_cast<int32_t>(state.cfa_offset);
+  row.bp_rule = state.bp_rule;
+  if (state.bp_rule == BPRule::kOffset) {
+    if (state.bp_offset < std::numeric_limits<int16_t>::min() ||
+        state.bp_offset > std::numeric_limits<int16_t>::max()) {
+      row.bp_rule = BPRule::kUndefined;
+    } else {
+      row.bp_offset = static_cast<int16_t>(state.bp_offset);
+    }
+  }
+  return row;
+}
+
+bool SameRules(const Row& a, const Row& b) {
+  return a.cfa_rule == b.cfa_rule && a.cfa_offset == b.cfa_offset && a.bp_rule == b.bp_rule &&
+         a.bp_offset == b.bp_offset;
+}
+
+// Runs call frame instructions, from c up to its end. initial holds the rules after the CIE
+// instructions, for the restore instructions. Whenever the location advances, the row of the
+// previous location is appended to rows, unless rows is nullptr.
+bool RunInstructions(Cursor* c, const CIE& cie, uint64_t section_addr, const UnwindState& initial,
+                     UnwindState* state, uint64_t* loc, std::vector<Row>* rows) {
+  std::vector<UnwindState> remembered;
+
+  auto advance = [&](uint64_t delta) {
+    if (rows != nullptr) {
+      rows->push_back(MakeRow(*loc, *state));
+    }
+    *loc += delta * cie.code_align;
+  };
+  auto set_offset = [&](uint64_t reg, int64_t offset) {
+    if (reg == kRegBP) {
+      state->bp_rule = BPRule::kOffset;
+      state->bp_offset = offset;
+    } else if (reg == kRegRA) {
+      state->ra_undefined = false;
+      state->ra_unsupported = offset != -8;
+    }
+  };
+  auto set_unsupported = [&](uint64_t reg) {
+    if (reg == kRegBP) {
+      state->bp_rule = BPRule::kUndefined;
+    } else if (reg == kRegRA) {
+      state->ra_unsupported = true;
+    }
+  };
+  auto restore = [&](uint64_t reg) {
+    if (reg == kRegBP) {
+      state->bp_rule = initial.bp_rule;
+      state->bp_offset = initial.bp_offset;
+    } else if (reg == kRegRA) {
+      state->ra_undefined = initial.ra_undefined;
+      state->ra_unsupported = initial.ra_unsupported;
+    }
+  };
+
+  while (!c->AtEnd()) {
+    const uint8_t op = c->Read<uint8_t>();
+    const uint8_t operand = op & 0x3f;
+    switch (op & 0xc0) {
+      case kCFAAdvanceLoc:
+        advance(operand);
+        continue;
+      case kCFAOffset:
+        set_offset(operand, static_cast<int64_t>(c->ReadULEB128()) * cie.data_align);
+        continue;
+      case kCFARestore:
+        restore(operand);
+        continue;
+    }
+
+    switch (op) {
+      case kCFANop:
+        break;
+      case kCFASetLoc: {
+        std::optional<uint64_t> new_loc = ReadEncodedPointer(c, cie.fde_encoding, section_addr);
+        if (!new_loc.has_value() || *new_loc < *loc) {
+          return false;
+        }
+        if (rows != nullptr) {
+          rows->push_back(MakeRow(*loc, *state));
+        }
+        *loc = *new_loc;
+        break;
+      }
+      case kCFAAdvanceLoc1:
+        advance(c->Read<uint8_t>());
+        break;
+      case kCFAAdvanceLoc2:
+        advance(c->Read<uint16_t>());
+        break;
+      case kCFAAdvanceLoc4:
+        advance(c->Read<uint32_t>());
+        break;
+      case kCFAOffsetExtended: {
+        const uint64_t reg = c->ReadULEB128();
+        set_offset(reg, static_cast<int64_t>(c->ReadULEB128()) * cie.data_align);
+        break;
+      }
+      case kCFAOffsetExtendedSF: {
+        const uint64_t reg = c->ReadULEB128();
+        set_offset(reg, c->ReadSLEB128() * cie.data_align);
+        break;
+      }
+      case kCFAGNUNegativeOffsetExtended: {
+        const uint64_t reg = c->ReadULEB128();
+        set_offset(reg, -static_cast<int64_t>(c->ReadULEB128()) * cie.data_align);
+        break;
+      }
+      case kCFARestoreExtended:
+        restore(c->ReadULEB128());
+        break;
+      case kCFAUndefined: {
+        const uint64_t reg = c->ReadULEB128();
+        if (reg == kRegRA) {
+          state->ra_undefined = true;
+        } else {
+          set_unsupported(reg);
+        }
+        break;
+      }
+      case kCFASameValue: {
+        const uint64_t reg = c->ReadULEB128();
+        if (reg == kRegBP) {
+          state->bp_rule = BPRule::kSameValue;
+        } else {
+          set_unsupported(reg);
+        }
+        break;
+      }
+      case kCFARegister: {
+        const uint64_t reg = c->ReadULEB128();
+        c->ReadULEB128();
+        set_unsupported(reg);
+        break;
+      }
+      case kCFAValOffset:
+      case kCFAValOffsetSF: {
+        const uint64_t reg = c->ReadULEB128();
+        if (op == kCFAValOffset) {
+          c->ReadULEB128();
+        } else {
+          c->ReadSLEB128();
+        }
+        set_unsupported(reg);
+        break;
+      }
+      case kCFAExpression:
+      case kCFAValExpression: {
+        const uint64_t reg = c->ReadULEB128();
+        const uint64_t length = c->ReadULEB128();
+        c->Seek(c->pos() + length);
+        set_unsupported(reg);
+        break;
+      }
+      case kCFARememberState:
+        remembered.push_back(*state);
+        break;
+      case kCFARestoreState:
+        if (remembered.empty()) {
+          return false;
+        }
+        *state = remembered.back();
+        remembered.pop_back();
+        break;
+      case kCFADefCFA:
+        state->cfa_reg = c->ReadULEB128();
+        state->cfa_offset = static_cast<int64_t>(c->ReadULEB128());
+        state->cfa_expression = false;
+        break;
+      case kCFADefCFASF:
+        state->cfa_reg = c->ReadULEB128();
+        state->cfa_offset = c->ReadSLEB128() * cie.data_align;
+        state->cfa_expression = false;
+        break;
+      case kCFADefCFARegister:
+        state->cfa_reg = c->ReadULEB128();
+        state->cfa_expression = false;
+        break;
+      case kCFADefCFAOffset:
+        state->cfa_offset = static_cast<int64_t>(c->ReadULEB128());
+        break;
+      case kCFADefCFAOffsetSF:
+        state->cfa_offset = c->ReadSLEB128() * cie.data_align;
+        break;
+      case kCFADefCFAExpression: {
+        // E.g. the PLT entries, whose CFA depends on the instruction within the entry.
+        const uint64_t length = c->ReadULEB128();
+        c->Seek(c->pos() + length);
+        state->cfa_expression = true;
+        break;
+      }
+      case kCFAGNUArgsSize:
+        c->ReadULEB128();
+        break;
+      default:
+        return false;
+    }
+  }
+  return c->ok();
+}
+
+struct FrameSection {
+  uint64_t addr;
+  std::string_view data;
+};
+
+// Appends the rows of an FDE, followed by a kUndefined row at the end of its range.
+bool ParseFDE(const FrameSection& section, const EntryHeader& entry, const CIE& cie,
+              std::vector<Row>* rows) {
+  Cursor c(section.data, entry.id_pos + (entry.is_64bit ? 8 : 4), entry.end);
+  std::optional<uint64_t> pc_begin = ReadEncodedPointer(&c, cie.fde_encoding, section.addr);
+  std::optional<uint64_t> pc_range =
+      ReadEncodedPointer(&c, cie.fde_encoding & kPEFormatMask, section.addr);
+  if (!pc_begin.has_value() || !pc_range.has_value()) {
+    return false;
+  }
+  // The linker leaves the FDEs of discarded functions at address 0.
+  if (*pc_begin == 0 || *pc_range == 0) {
+    return true;
+  }
+  if (cie.has_augmentation_data) {
+    const uint64_t length = c.ReadULEB128();
+    c.Seek(c.pos() + length);
+  }
+
+  uint64_t loc = *pc_begin;
+  UnwindState initial;
+  Cursor cie_instructions(section.data, cie.instructions_begin, cie.instructions_end);
+  if (!RunInstructions(&cie_instructions, cie, section.addr, initial, &initial, &loc, nullptr)) {
+    return false;
+  }
+  loc = *pc_begin;
+
+  UnwindState state = initial;
+  std::vector<Row> fde_rows;
+  if (!RunInstructions(&c, cie, section.addr, initial, &state, &loc, &fde_rows)) {
+    return false;
+  }
+  fde_rows.push_back(MakeRow(loc, state));
+
+  const uint64_t pc_end = *pc_begin + *pc_range;
+  for (const Row& row : fde_rows) {
+    if (row.pc < pc_end) {
+      rows->push_back(row);
+    }
+  }
+  rows->push_back(Row{pc_end, 0, 0, CFARule::kUndefined, BPRule::kUndefined});
+  return true;
+}
+
+Status ParseFrameSection(const FrameSection& section, bool is_eh_frame, std::vector<Row>* rows) {
+  absl::flat_hash_map<uint64_t, std::optional<CIE>> cies;
+  uint64_t offset = 0;
+  while (offset < section.data.size()) {
+    std::optional<EntryHeader> entry = ReadEntryHeader(section.data, offset, is_eh_frame);
+    if (!entry.has_value()) {
+      return error::Internal("Malformed call frame information at offset $0", offset);
+    }
+    if (entry->length == 0 && is_eh_frame) {
+      break;
+    }
+    if (entry->length != 0 && !entry->is_cie) {
+      // In .eh_frame, the CIE pointer is relative to its own position.
+      const uint64_t cie_offset = is_eh_frame ? entry->id_pos - entry->id : entry->id;
+      auto [iter, inserted] = cies.try_emplace(cie_offset);
+      if (inserted) {
+        iter->second = ParseCIE(section.data, cie_offset, is_eh_frame);
+      }
+      // FDEs that can't be parsed are left out, so their addresses are not covered.
+      if (iter->second.has_value()) {
+        ParseFDE(section, *entry, *iter->second, rows);
+      }
+    }
+    offset = entry->end;
+  }
+  return Status::OK();
+}
+
+template <typename T>
+bool ReadStruct(std::string_view data, uint64_t offset, T* val) {
+  Cursor c(data, offset, data.size());
+  *val = c.Read<T>();
+  return c.ok();
+}
+
+}  // namespace
+
+StatusOr<std::shared_ptr<const ElfUnwindTable>> ElfUnwindTable::Get(
+    const std::filesystem::path& path) {
+  static absl::Mutex cache_mutex;
+  static auto& cache =
+      *new absl::flat_hash_map<MappedFile::Identity, std::weak_ptr<const ElfUnwindTable>>();
+
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<MappedFile> file, MappedFile::Create(path));
+  {
+    absl::MutexLock lock(&cache_mutex);
+    auto iter = cache.find(file->identity());
+    if (iter != cache.end()) {
+      std::shared_ptr<const ElfUnwindTable> table = iter->second.lock();
+      if (table != nullptr) {
+        return table;
+      }
+    }
+  }
+
+  // Built without holding the lock; if another thread beat us to it, its table is kept.
+  auto table = std::shared_ptr<ElfUnwindTable>(new ElfUnwindTable);
+  PL_RETURN_IF_ERROR(table->Build(file->data()));
+
+  absl::MutexLock lock(&cache_mutex);
+  for (auto iter = cache.begin(); iter != cache.end();) {
+    if (iter->second.expired()) {
+      cache.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+  auto [iter, inserted] = cache.try_emplace(file->identity(), table);
+  if (!inserted) {
+    std::shared_ptr<const ElfUnwindTable> cached = iter->second.lock();
+    if (cached != nullptr) {
+      return cached;
+    }
+    iter->second = table;
+  }
+  return std::shared_ptr<const ElfUnwindTable>(std::move(table));
+}
+
+Status ElfUnwindTable::Build(std::string_view data) {
+  ELFIO::Elf64_Ehdr header;
+  if (!ReadStruct(data, 0, &header) || std::memcmp(header.e_ident, "\x7f" "ELF", 4) != 0) {
+    return error::InvalidArgument("Not an ELF file");
+  }
+  if (header.e_ident[ELFIO::EI_CLASS] != ELFIO::ELFCLASS64 ||
+      header.e_machine != ELFIO::EM_X86_64) {
+    return error::Unimplemented("Only x86-64 ELF files can be unwound");
+  }
+
+  for (int i = 0; i < header.e_phnum; ++i) {
+    ELFIO::Elf64_Phdr segment;
+    if (!ReadStruct(data, header.e_phoff + i * sizeof(segment), &segment)) {
+      return error::Internal("Program header $0 is out of the bounds of the file", i);
+    }
+    if (segment.p_type == ELFIO::PT_LOAD && (segment.p_flags & ELFIO::PF_X) != 0) {
+      segments_.push_back(LoadSegment{segment.p_offset, segment.p_filesz, segment.p_vaddr});
+    }
+  }
+
+  ELFIO::Elf64_Shdr names_section;
+  if (!ReadStruct(data, header.e_shoff + header.e_shstrndx * sizeof(names_section),
+                  &names_section)) {
+    return error::Internal("Section names are out of the bounds of the file");
+  }
+  std::optional<FrameSection> eh_frame;
+  std::optional<FrameSection> debug_frame;
+  for (int i = 0; i < header.e_shnum; ++i) {
+    ELFIO::Elf64_Shdr section;
+    if (!ReadStruct(data, header.e_shoff + i * sizeof(section), &section)) {
+      return error::Internal("Section header $0 is out of the bounds of the file", i);
+    }
+    if (section.sh_type == ELFIO::SHT_NOBITS ||
+        section.sh_offset + section.sh_size > data.size()) {
+      continue;
+    }
+    Cursor name(data, names_section.sh_offset + section.sh_name,
+                names_section.sh_offset + names_section.sh_size);
+    std::string_view section_name = name.ReadCString();
+    FrameSection frame_section = {section.sh_addr, data.substr(section.sh_offset, section.sh_size)};
+    if (section_name == ".eh_frame") {
+      eh_frame = frame_section;
+    } else if (section_name == ".debug_frame") {
+      debug_frame = frame_section;
+    }
+  }
+
+  // .debug_frame has the same information, but is usually stripped. It is only a fall-back.
+  Status s;
+  if (eh_frame.has_value()) {
+    s = ParseFrameSection(*eh_frame, /* is_eh_frame */ true, &rows_);
+  } else if (debug_frame.has_value()) {
+    s = ParseFrameSection(*debug_frame, /* is_eh_frame */ false, &rows_);
+  }
+  VLOG_IF(1, !s.ok()) << "Call frame information is incomplete: " << s.msg();
+
+  // At the end of a range, the next range may start. Rows of defined rules go after the kUndefined
+  // ones at the same address, so they take precedence, and only the last row at each address is
+  // kept.
+  std::stable_sort(rows_.begin(), rows_.end(), [](const Row& a, const Row& b) {
+    if (a.pc != b.pc) {
+      return a.pc < b.pc;
+    }
+    return a.cfa_rule == CFARule::kUndefined && b.cfa_rule != CFARule::kUndefined;
+  });
+  std::vector<Row> rows;
+  rows.reserve(rows_.size());
+  for (size_t i = 0; i < rows_.size(); ++i) {
+    if (i + 1 < rows_.size() && rows_[i + 1].pc == rows_[i].pc) {
+      continue;
+    }
+    if (!rows.empty() && SameRules(rows.back(), rows_[i])) {
+      continue;
+    }
+    rows.push_back(rows_[i]);
+  }
+  rows.shrink_to_fit();
+  rows_ = std::move(rows);
+  return Status::OK();
+}
+
+const ElfUnwindTable::Row* ElfUnwindTable::Find(uint64_t addr) const {
+  auto iter = std::upper_bound(rows_.begin(), rows_.end(), addr,
+                               [](uint64_t addr, const Row& row) { return addr < row.pc; });
+  if (iter == rows_.begin()) {
+    return nullptr;
+  }
+  --iter;
+  return iter->cfa_rule == CFARule::kUndefined ? nullptr : &*iter;
+}
+
+std::optional<uint64_t> ElfUnwindTable::FileOffsetToAddr(uint64_t offset) const {
+  for (const auto& segment : segments_) {
+    if (offset >= segment.offset && offset < segment.offset + segment.size) {
+      return offset - segment.offset + segment.addr;
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
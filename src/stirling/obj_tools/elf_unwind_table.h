@@ -0,0 +1,117 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/obj_tools/elf_symbol_index.h"
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+/**
+ * The call frame information of an x86-64 ELF file, from its .eh_frame and .debug_frame sections,
+ * compiled into a table that tells how to find the caller's frame at each instruction. This is
+ * what unwinds the stacks of code built without frame pointers.
+ *
+ * Only the rules needed to recover the return address, the stack pointer and the frame pointer
+ * are kept. Like the symbol index, the table is immutable, and shared by all the users of the
+ * same file in the process.
+ */
+class ElfUnwindTable {
+ public:
+  // How to compute the canonical frame address (CFA), i.e. the stack pointer of the caller.
+  enum class CFARule : uint8_t {
+    // No unwind info, or the outermost frame, whose return address is undefined.
+    kUndefined,
+    // CFA = rsp + cfa_offset.
+    kSP,
+    // CFA = rbp + cfa_offset.
+    kBP,
+    // A DWARF expression, which the table doesn't evaluate.
+    kExpression,
+  };
+
+  // How to recover the frame pointer of the caller.
+  enum class BPRule : uint8_t {
+    // Same as in the callee.
+    kSameValue,
+    // Saved on the stack, at CFA + bp_offset.
+    kOffset,
+    // Not recoverable.
+    kUndefined,
+  };
+
+  // The rules in effect at the addresses from pc, up to the pc of the next row.
+  // The return address is always at CFA - 8 on x86-64.
+  struct Row {
+    uint64_t pc;
+    int32_t cfa_offset;
+    int16_t bp_offset;
+    CFARule cfa_rule;
+    BPRule bp_rule;
+  };
+
+  /**
+   * Returns the unwind table of the file, which is taken from a process-wide cache while anyone
+   * holds it.
+   */
+  static StatusOr<std::shared_ptr<const ElfUnwindTable>> Get(const std::filesystem::path& path);
+
+  /**
+   * Returns the row that covers the virtual address, or nullptr if there's no rule to unwind from
+   * the address.
+   */
+  const Row* Find(uint64_t addr) const;
+
+  /**
+   * Converts an offset in the file, e.g. computed from /proc/<pid>/maps, into the virtual
+   * address where it's loaded, if it's part of an executable segment.
+   */
+  std::optional<uint64_t> FileOffsetToAddr(uint64_t offset) const;
+
+  const std::vector<Row>& rows() const { return rows_; }
+
+ private:
+  ElfUnwindTable() = default;
+
+  Status Build(std::string_view data);
+
+  struct LoadSegment {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t addr;
+  };
+
+  // The executable PT_LOAD segments.
+  std::vector<LoadSegment> segments_;
+
+  // Sorted by pc, with a kUndefined row at the end of each range of unwind info.
+  std::vector<Row> rows_;
+};
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
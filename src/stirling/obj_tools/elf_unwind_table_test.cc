@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/obj_tools/elf_unwind_table.h"
+
+#include <memory>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/obj_tools/elf_reader.h"
+#include "src/stirling/obj_tools/testdata/cc/test_exe_fixture.h"
+
+namespace px {
+namespace stirling {
+namespace obj_tools {
+
+const TestExeFixture kTestExeFixture;
+
+TEST(ElfUnwindTableTest, FunctionEntry) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<ElfReader> elf_reader,
+                       ElfReader::Create(kTestExeFixture.Path()));
+  ASSERT_OK_AND_ASSIGN(ElfReader::SymbolInfo symbol,
+                       elf_reader->SearchTheOnlySymbol("CanYouFindThis"));
+
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ElfUnwindTable> table,
+                       ElfUnwindTable::Get(kTestExeFixture.Path()));
+  EXPECT_FALSE(table->rows().empty());
+
+  // On entry, the return address was just pushed.
+  const ElfUnwindTable::Row* row = table->Find(symbol.address);
+  ASSERT_NE(row, nullptr);
+  EXPECT_EQ(row->cfa_rule, ElfUnwindTable::CFARule::kSP);
+  EXPECT_EQ(row->cfa_offset, 8);
+  EXPECT_EQ(row->bp_rule, ElfUnwindTable::BPRule::kSameValue);
+
+  // The whole function is covered.
+  EXPECT_NE(table->Find(symbol.address + symbol.size - 1), nullptr);
+  EXPECT_EQ(table->Find(0), nullptr);
+}
+
+TEST(ElfUnwindTableTest, SharedWhileInUse) {
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ElfUnwindTable> table1,
+                       ElfUnwindTable::Get(kTestExeFixture.Path()));
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const ElfUnwindTable> table2,
+                       ElfUnwindTable::Get(kTestExeFixture.Path()));
+  EXPECT_EQ(table1, table2);
+
+  EXPECT_NOT_OK(ElfUnwindTable::Get("/bogus"));
+}
+
+}  // namespace obj_tools
+}  // namespace stirling
+}  // namespace px
@@ -104,6 +104,7 @@ class CPUStatBPFTraceConnector : public SourceConnector, public bpf_tools::BPFTr
   }
 
   Status InitImpl() override;
+  bool UsesBPF() const override { return true; }
   Status StopImpl() override;
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
 
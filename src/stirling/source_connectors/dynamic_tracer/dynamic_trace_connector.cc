@@ -23,6 +23,7 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <chrono>
 #include <map>
 
 #include "src/common/base/base.h"
@@ -61,6 +62,7 @@ void GenericHandleEvent(void* cb_cookie, void* data, int data_size) {
 void GenericHandleEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK_NE(cb_cookie, nullptr);
   VLOG(1) << absl::Substitute("Lost $0 events", lost);
+  static_cast<DynamicTraceConnector*>(cb_cookie)->AcceptEventLoss(lost);
 }
 
 }  // namespace
@@ -145,6 +147,43 @@ BackedDataElements ConvertFields(const google::protobuf::RepeatedPtrField<Field>
   return elements;
 }
 
+namespace {
+
+// The size of the tgid_ and tgid_start_time_ fields, that start every aggregate key.
+// Must match DecodeUPID().
+constexpr size_t kAggregateKeyUPIDSize = sizeof(uint32_t) + sizeof(uint64_t);
+
+}  // namespace
+
+Struct AggregateRowStruct(const dynamic_tracing::BCCProgram::AggregateMapSpec& spec) {
+  Struct row;
+  row.set_name(spec.name);
+
+  // The time goes after the tgid_ and tgid_start_time_ fields of the key, which are decoded into
+  // the leading upid column.
+  DCHECK_GE(spec.key.fields_size(), 2);
+  for (int i = 0; i < spec.key.fields_size(); ++i) {
+    row.add_fields()->CopyFrom(spec.key.fields(i));
+    if (i == 1) {
+      auto* time_field = row.add_fields();
+      time_field->set_name("time_");
+      time_field->set_type(ScalarType::UINT64);
+    }
+  }
+
+  auto* count_field = row.add_fields();
+  count_field->set_name("count");
+  count_field->set_type(ScalarType::UINT64);
+
+  if (spec.function == dynamic_tracing::ir::shared::Aggregation::SUM) {
+    auto* sum_field = row.add_fields();
+    sum_field->set_name("sum");
+    sum_field->set_type(ScalarType::INT64);
+  }
+
+  return row;
+}
+
 StatusOr<std::unique_ptr<SourceConnector>> DynamicTraceConnector::Create(
     std::string_view name, dynamic_tracing::ir::logical::TracepointDeployment* program) {
   PL_ASSIGN_OR_RETURN(dynamic_tracing::BCCProgram bcc_program,
@@ -152,26 +191,52 @@ StatusOr<std::unique_ptr<SourceConnector>> DynamicTraceConnector::Create(
 
   LOG(INFO) << "BCCProgram:\n" << bcc_program.ToString();
 
-  if (bcc_program.perf_buffer_specs.size() != 1) {
+  if (bcc_program.perf_buffer_specs.size() + bcc_program.aggregate_map_specs.size() != 1) {
     return error::Internal("Only a single output table is allowed for now.");
   }
 
-  const auto& output = bcc_program.perf_buffer_specs[0];
+  const Struct output = bcc_program.perf_buffer_specs.empty()
+                            ? AggregateRowStruct(bcc_program.aggregate_map_specs[0])
+                            : bcc_program.perf_buffer_specs[0].output;
+  const std::string& output_name = bcc_program.perf_buffer_specs.empty()
+                                       ? bcc_program.aggregate_map_specs[0].name
+                                       : bcc_program.perf_buffer_specs[0].name;
 
   // Could consider making a better description, but may require more user input,
   // so punting on that for now.
-  std::string desc = absl::StrCat("Dynamic table for ", output.name);
+  std::string desc = absl::StrCat("Dynamic table for ", output_name);
 
   std::unique_ptr<DynamicDataTableSchema> table_schema =
-      DynamicDataTableSchema::Create(output.name, desc, ConvertFields(output.output.fields()));
+      DynamicDataTableSchema::Create(output_name, desc, ConvertFields(output.fields()));
 
   return std::unique_ptr<SourceConnector>(
       new DynamicTraceConnector(name, std::move(table_schema), std::move(bcc_program)));
 }
 
 Status DynamicTraceConnector::InitImpl() {
+  if (is_aggregated()) {
+    sampling_freq_mgr_.set_period(kAggregatePeriod);
+    push_freq_mgr_.set_period(kAggregatePeriod);
+
+    aggregate_row_struct_ = AggregateRowStruct(bcc_program_.aggregate_map_specs.front());
+    PL_ASSIGN_OR_RETURN(record_decoder_, DynamicRecordDecoder::Create(aggregate_row_struct_));
+
+    PL_RETURN_IF_ERROR(InitBPFProgram(bcc_program_.code));
+    for (const auto& uprobe_spec : bcc_program_.uprobe_specs) {
+      PL_RETURN_IF_ERROR(AttachUProbe(uprobe_spec));
+    }
+    return Status::OK();
+  }
+
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
+  EnableAdaptiveSampling(kSamplingPeriod / 4, kSamplingPeriod * 2);
+  if (FLAGS_stirling_perf_buffer_reader_thread) {
+    EnablePerfBufferReaderThread();
+  }
+
+  PL_ASSIGN_OR_RETURN(record_decoder_,
+                      DynamicRecordDecoder::Create(bcc_program_.perf_buffer_specs.front().output));
 
   PL_RETURN_IF_ERROR(InitBPFProgram(bcc_program_.code));
 
@@ -271,17 +336,18 @@ StatusOr<std::string> ParseStructBlobToJSON(const StructSpec& struct_spec, std::
 }
 
 // Reads a byte sequence representing a packed C/C++ struct, and extract the values of the fields.
+// Consumes the bytes it extracts from the front of the caller's view.
 class StructDecoder {
  public:
-  explicit StructDecoder(std::string_view buf) : buf_(buf) {}
+  explicit StructDecoder(std::string_view* buf) : buf_(buf) {}
 
   template <typename NativeScalarType>
   StatusOr<NativeScalarType> ExtractField() {
-    if (buf_.size() < sizeof(NativeScalarType)) {
+    if (buf_->size() < sizeof(NativeScalarType)) {
       return error::ResourceUnavailable("Insufficient number of bytes.");
     }
-    auto val = MemCpy<NativeScalarType>(buf_);
-    buf_.remove_prefix(sizeof(NativeScalarType));
+    auto val = MemCpy<NativeScalarType>(*buf_);
+    buf_->remove_prefix(sizeof(NativeScalarType));
     return val;
   }
 
@@ -298,8 +364,8 @@ class StructDecoder {
     //
     // TODO(oazizi): Find a better way to keep these in sync.
     PL_ASSIGN_OR_RETURN(size_t len, ExtractField<size_t>());
-    std::string s(buf_.substr(0, len));
-    buf_.remove_prefix(dynamic_tracing::kStructStringSize - sizeof(size_t) - 1);
+    std::string s(buf_->substr(0, len));
+    buf_->remove_prefix(dynamic_tracing::kStructStringSize - sizeof(size_t) - 1);
     PL_ASSIGN_OR_RETURN(uint8_t truncated, ExtractField<uint8_t>());
 
     if (truncated) {
@@ -322,9 +388,9 @@ class StructDecoder {
     // TODO(oazizi): Find a better way to keep these in sync.
     PL_ASSIGN_OR_RETURN(size_t len, ExtractField<size_t>());
 
-    std::string_view bytes = buf_.substr(0, len);
+    std::string_view bytes = buf_->substr(0, len);
 
-    buf_.remove_prefix(dynamic_tracing::kStructByteArraySize - sizeof(size_t) - 1);
+    buf_->remove_prefix(dynamic_tracing::kStructByteArraySize - sizeof(size_t) - 1);
     PL_ASSIGN_OR_RETURN(uint8_t truncated, ExtractField<uint8_t>());
 
     std::string s = BytesToString<bytes_format::HexCompact>(bytes);
@@ -338,8 +404,8 @@ class StructDecoder {
     PL_ASSIGN_OR_RETURN(size_t len, ExtractField<size_t>());
     PL_ASSIGN_OR_RETURN(int8_t idx, ExtractField<int8_t>());
 
-    std::string_view bytes = buf_.substr(0, len);
-    buf_.remove_prefix(dynamic_tracing::kStructBlobSize - sizeof(size_t) - sizeof(int8_t));
+    std::string_view bytes = buf_->substr(0, len);
+    buf_->remove_prefix(dynamic_tracing::kStructBlobSize - sizeof(size_t) - sizeof(int8_t));
 
     if (idx < 0) {
       // BPF could not figure out the correct index to the implementation type of an interface.
@@ -357,134 +423,205 @@ class StructDecoder {
   }
 
  private:
-  std::string_view buf_;
+  std::string_view* buf_;
 };
 
-Status FillColumn(StructDecoder* struct_decoder, DataTable::DynamicRecordBuilder* r, size_t col_idx,
-                  ScalarType type, const RepeatedPtrField<StructSpec>& col_decoder) {
-#define WRITE_COLUMN(field_type, column_type)                                        \
-  {                                                                                  \
-    PL_ASSIGN_OR_RETURN(field_type val, struct_decoder->ExtractField<field_type>()); \
-    r->Append(col_idx, column_type(val));                                            \
-    break;                                                                           \
-  }
+using FieldOp = DynamicRecordDecoder::FieldOp;
+
+Status DecodeTime(const FieldOp& op, const DynamicRecordDecoder::Context& ctx,
+                  std::string_view* buf, DataTable::DynamicRecordBuilder* r) {
+  PL_ASSIGN_OR_RETURN(uint64_t ktime_ns, StructDecoder(buf).ExtractField<uint64_t>());
+  int64_t time = ktime_ns + ctx.clock_realtime_offset;
+  r->Append(op.col_idx, types::Time64NSValue(time));
+  return Status::OK();
+}
+
+Status DecodeUPID(const FieldOp& op, const DynamicRecordDecoder::Context& ctx,
+                  std::string_view* buf, DataTable::DynamicRecordBuilder* r) {
+  StructDecoder struct_decoder(buf);
+  PL_ASSIGN_OR_RETURN(uint32_t tgid, struct_decoder.ExtractField<uint32_t>());
+  PL_ASSIGN_OR_RETURN(uint64_t tgid_start_time, struct_decoder.ExtractField<uint64_t>());
+  md::UPID upid(ctx.asid, tgid, tgid_start_time);
+  r->Append(op.col_idx, types::UInt128Value(upid.value()));
+  return Status::OK();
+}
+
+template <typename TFieldType, typename TColumnType>
+Status DecodeScalar(const FieldOp& op, const DynamicRecordDecoder::Context& /*ctx*/,
+                    std::string_view* buf, DataTable::DynamicRecordBuilder* r) {
+  PL_ASSIGN_OR_RETURN(TFieldType val, StructDecoder(buf).ExtractField<TFieldType>());
+  r->Append(op.col_idx, TColumnType(val));
+  return Status::OK();
+}
 
+Status DecodeString(const FieldOp& op, const DynamicRecordDecoder::Context& /*ctx*/,
+                    std::string_view* buf, DataTable::DynamicRecordBuilder* r) {
+  PL_ASSIGN_OR_RETURN(std::string val, StructDecoder(buf).ExtractString());
+  r->Append(op.col_idx, types::StringValue(std::move(val)));
+  return Status::OK();
+}
+
+Status DecodeByteArray(const FieldOp& op, const DynamicRecordDecoder::Context& /*ctx*/,
+                       std::string_view* buf, DataTable::DynamicRecordBuilder* r) {
+  PL_ASSIGN_OR_RETURN(std::string val, StructDecoder(buf).ExtractByteArrayAsHex());
+  r->Append(op.col_idx, types::StringValue(std::move(val)));
+  return Status::OK();
+}
+
+Status DecodeStructBlob(const FieldOp& op, const DynamicRecordDecoder::Context& /*ctx*/,
+                        std::string_view* buf, DataTable::DynamicRecordBuilder* r) {
+  PL_ASSIGN_OR_RETURN(std::string val,
+                      StructDecoder(buf).ExtractStructBlobAsJSON(*op.blob_decoders));
+  r->Append(op.col_idx, types::StringValue(std::move(val)));
+  return Status::OK();
+}
+
+// Returns the function that decodes a field of the type into a column.
+StatusOr<FieldOp::DecodeFn> GetDecodeFn(ScalarType type) {
   // TODO(yzhao): Right now only support scalar types. We should replace type with ScalarType
   // in Struct::Field.
   switch (type) {
     case ScalarType::BOOL:
-      WRITE_COLUMN(bool, types::BoolValue);
+      return &DecodeScalar<bool, types::BoolValue>;
     case ScalarType::INT:
-      WRITE_COLUMN(int, types::Int64Value);
+      return &DecodeScalar<int, types::Int64Value>;
     case ScalarType::INT8:
-      WRITE_COLUMN(int8_t, types::Int64Value);
+      return &DecodeScalar<int8_t, types::Int64Value>;
     case ScalarType::INT16:
-      WRITE_COLUMN(int16_t, types::Int64Value);
+      return &DecodeScalar<int16_t, types::Int64Value>;
     case ScalarType::INT32:
-      WRITE_COLUMN(int32_t, types::Int64Value);
+      return &DecodeScalar<int32_t, types::Int64Value>;
     case ScalarType::INT64:
-      WRITE_COLUMN(int64_t, types::Int64Value);
+      return &DecodeScalar<int64_t, types::Int64Value>;
     case ScalarType::UINT:
-      WRITE_COLUMN(unsigned int, types::Int64Value);
+      return &DecodeScalar<unsigned int, types::Int64Value>;
     case ScalarType::UINT8:
-      WRITE_COLUMN(uint8_t, types::Int64Value);
+      return &DecodeScalar<uint8_t, types::Int64Value>;
     case ScalarType::UINT16:
-      WRITE_COLUMN(uint16_t, types::Int64Value);
+      return &DecodeScalar<uint16_t, types::Int64Value>;
     case ScalarType::UINT32:
-      WRITE_COLUMN(uint32_t, types::Int64Value);
+      return &DecodeScalar<uint32_t, types::Int64Value>;
     case ScalarType::UINT64:
-      WRITE_COLUMN(uint64_t, types::Int64Value);
+      return &DecodeScalar<uint64_t, types::Int64Value>;
 
     case ScalarType::SHORT:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(short, types::Int64Value);
+      return &DecodeScalar<short, types::Int64Value>;
     case ScalarType::USHORT:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(unsigned short, types::Int64Value);
+      return &DecodeScalar<unsigned short, types::Int64Value>;
     case ScalarType::LONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(long, types::Int64Value);
+      return &DecodeScalar<long, types::Int64Value>;
     case ScalarType::ULONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(unsigned long, types::Int64Value);
+      return &DecodeScalar<unsigned long, types::Int64Value>;
     case ScalarType::LONGLONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(long long, types::Int64Value);
+      return &DecodeScalar<long long, types::Int64Value>;
     case ScalarType::ULONGLONG:
       // NOLINTNEXTLINE(runtime/int)
-      WRITE_COLUMN(unsigned long long, types::Int64Value);
+      return &DecodeScalar<unsigned long long, types::Int64Value>;
     case ScalarType::CHAR:
-      WRITE_COLUMN(char, types::Int64Value);
+      return &DecodeScalar<char, types::Int64Value>;
     case ScalarType::UCHAR:
-      WRITE_COLUMN(unsigned char, types::Int64Value);
+      return &DecodeScalar<unsigned char, types::Int64Value>;
 
     case ScalarType::FLOAT:
-      WRITE_COLUMN(float, types::Float64Value);
+      return &DecodeScalar<float, types::Float64Value>;
     case ScalarType::DOUBLE:
-      WRITE_COLUMN(double, types::Float64Value);
+      return &DecodeScalar<double, types::Float64Value>;
     case ScalarType::VOID_POINTER:
-      WRITE_COLUMN(uint64_t, types::Int64Value);
-    case ScalarType::STRING: {
-      PL_ASSIGN_OR_RETURN(std::string val, struct_decoder->ExtractString());
-      r->Append(col_idx, types::StringValue(val));
-      break;
-    }
-    case ScalarType::BYTE_ARRAY: {
-      PL_ASSIGN_OR_RETURN(std::string val, struct_decoder->ExtractByteArrayAsHex());
-      r->Append(col_idx, types::StringValue(val));
-      break;
-    }
-    case ScalarType::STRUCT_BLOB: {
-      PL_ASSIGN_OR_RETURN(std::string val, struct_decoder->ExtractStructBlobAsJSON(col_decoder));
-      r->Append(col_idx, types::StringValue(val));
-      break;
-    }
+      return &DecodeScalar<uint64_t, types::Int64Value>;
+    case ScalarType::STRING:
+      return &DecodeString;
+    case ScalarType::BYTE_ARRAY:
+      return &DecodeByteArray;
+    case ScalarType::STRUCT_BLOB:
+      return &DecodeStructBlob;
     case ScalarType::UNKNOWN:
       return error::Internal("Unknown scalar type should not be used.");
     case ScalarType::ScalarType_INT_MIN_SENTINEL_DO_NOT_USE_:
     case ScalarType::ScalarType_INT_MAX_SENTINEL_DO_NOT_USE_:
-      LOG(DFATAL) << "Impossible enum value";
       break;
   }
-#undef WRITE_COLUMN
-
-  return Status::OK();
+  return error::Internal("Impossible enum value $0", static_cast<int>(type));
 }
 
 }  // namespace
 
-Status DynamicTraceConnector::AppendRecord(const Struct& st, uint32_t asid, std::string_view buf,
-                                           DataTable* data_table) {
-  StructDecoder struct_decoder(buf);
-  DataTable::DynamicRecordBuilder r(data_table);
+StatusOr<DynamicRecordDecoder> DynamicRecordDecoder::Create(const Struct& st) {
+  DynamicRecordDecoder decoder;
+  decoder.field_ops_.reserve(st.fields_size());
 
-  int col_idx = 0;
+  size_t col_idx = 0;
   for (int i = 0; i < st.fields_size(); ++i) {
-    auto& field = st.fields(i);
+    const auto& field = st.fields(i);
 
+    FieldOp op;
+    op.col_idx = col_idx++;
     if (field.name() == "time_") {
-      PL_ASSIGN_OR_RETURN(uint64_t ktime_ns, struct_decoder.ExtractField<uint64_t>());
-      int64_t time = ktime_ns + ClockRealTimeOffset();
-      r.Append(col_idx++, types::Time64NSValue(time));
+      op.decode = &DecodeTime;
     } else if ((field.name() == "tgid_") && (i + 1 < st.fields_size()) &&
                (st.fields(i + 1).name() == "tgid_start_time_")) {
       // If we see "tgid_" and "tgid_start_time_" back-to-back, then we automatically create UPID.
-      PL_ASSIGN_OR_RETURN(uint32_t tgid, struct_decoder.ExtractField<uint32_t>());
-      PL_ASSIGN_OR_RETURN(uint64_t tgid_start_time, struct_decoder.ExtractField<uint64_t>());
-      md::UPID upid(asid, tgid, tgid_start_time);
-      r.Append(col_idx++, types::UInt128Value(upid.value()));
-
+      op.decode = &DecodeUPID;
       // Consume the extra tgid_start_time_ column.
       ++i;
     } else {
-      PL_RETURN_IF_ERROR(
-          FillColumn(&struct_decoder, &r, col_idx++, field.type(), field.blob_decoders()));
+      PL_ASSIGN_OR_RETURN(op.decode, GetDecodeFn(field.type()));
+      op.blob_decoders = &field.blob_decoders();
     }
+    decoder.field_ops_.push_back(op);
   }
 
+  return decoder;
+}
+
+Status DynamicRecordDecoder::Decode(const Context& ctx, std::string_view buf,
+                                    DataTable* data_table) const {
+  DataTable::DynamicRecordBuilder r(data_table);
+  for (const FieldOp& op : field_ops_) {
+    PL_RETURN_IF_ERROR(op.decode(op, ctx, &buf, &r));
+  }
   return Status::OK();
 }
 
+void DynamicTraceConnector::DrainAggregates() {
+  const uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+  const bool has_sum = bcc_program_.aggregate_map_specs.front().function ==
+                       dynamic_tracing::ir::shared::Aggregation::SUM;
+  const size_t stride = (sizeof(dynamic_tracing::AggregateValue) + 7) & ~size_t{7};
+
+  auto append_row = [&](std::string_view key, std::string_view per_cpu_values) {
+    dynamic_tracing::AggregateValue total = {};
+    for (size_t pos = 0; pos + sizeof(total) <= per_cpu_values.size(); pos += stride) {
+      auto value = MemCpy<dynamic_tracing::AggregateValue>(per_cpu_values.data() + pos);
+      total.count += value.count;
+      total.sum += value.sum;
+    }
+    if (total.count == 0) {
+      return;
+    }
+
+    // Lay out the record as the row struct: the time has the same clock as bpf_ktime_get_ns().
+    std::string row;
+    row.reserve(key.size() + sizeof(now_ns) + sizeof(total));
+    row.append(key.substr(0, kAggregateKeyUPIDSize));
+    row.append(reinterpret_cast<const char*>(&now_ns), sizeof(now_ns));
+    row.append(key.substr(kAggregateKeyUPIDSize));
+    row.append(reinterpret_cast<const char*>(&total.count), sizeof(total.count));
+    if (has_sum) {
+      row.append(reinterpret_cast<const char*>(&total.sum), sizeof(total.sum));
+    }
+    data_items_.push_back(std::move(row));
+  };
+
+  ECHECK_OK(DrainPerCPUHashTable(bcc_program_.aggregate_map_specs.front().name, append_row));
+}
+
 void DynamicTraceConnector::TransferDataImpl(ConnectorContext* ctx,
                                              const std::vector<DataTable*>& data_tables) {
   DCHECK_EQ(data_tables.size(), 1)
@@ -495,13 +632,18 @@ void DynamicTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     return;
   }
 
-  PollPerfBuffers();
+  if (is_aggregated()) {
+    DrainAggregates();
+  } else {
+    RecordSamplingBufferOccupancy(PollPerfBuffers());
+  }
 
+  const DynamicRecordDecoder::Context decode_ctx = {
+      .asid = ctx->GetASID(),
+      .clock_realtime_offset = ClockRealTimeOffset(),
+  };
   for (const auto& item : data_items_) {
-    // TODO(yzhao): Right now only support scalar types. We should replace type with ScalarType
-    // in Struct::Field.
-    ECHECK_OK(AppendRecord(bcc_program_.perf_buffer_specs.front().output, ctx->GetASID(), item,
-                           data_table));
+    ECHECK_OK(record_decoder_.Decode(decode_ctx, item, data_table));
   }
 
   data_items_.clear();
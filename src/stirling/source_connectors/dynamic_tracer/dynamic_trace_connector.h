@@ -21,21 +21,59 @@
 #include <deque>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "src/common/base/base.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/core/data_table.h"
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 
 namespace px {
 namespace stirling {
 
+// Decodes the perf buffer records of a dynamic trace program into rows of its output table.
+// How to decode each field is resolved once from the output struct of the program, so decoding a
+// record is a loop over precomputed steps, without dispatching on field names or types per record.
+class DynamicRecordDecoder {
+ public:
+  // What the decoding of a record needs, besides the record itself.
+  struct Context {
+    uint32_t asid = 0;
+    uint64_t clock_realtime_offset = 0;
+  };
+
+  // Decodes one field of a record into one column, consuming the field's bytes from buf.
+  struct FieldOp {
+    using DecodeFn = Status (*)(const FieldOp& op, const Context& ctx, std::string_view* buf,
+                                DataTable::DynamicRecordBuilder* r);
+
+    DecodeFn decode = nullptr;
+    size_t col_idx = 0;
+    // Describes the data of STRUCT_BLOB fields. Owned by the output struct.
+    const google::protobuf::RepeatedPtrField<dynamic_tracing::ir::physical::StructSpec>*
+        blob_decoders = nullptr;
+  };
+
+  // The returned decoder refers to st, which must outlive it.
+  static StatusOr<DynamicRecordDecoder> Create(const dynamic_tracing::ir::physical::Struct& st);
+
+  // Decodes the record in buf, and appends it as a row to data_table.
+  Status Decode(const Context& ctx, std::string_view buf, DataTable* data_table) const;
+
+ private:
+  std::vector<FieldOp> field_ops_;
+};
+
 class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapper {
  public:
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{100};
   static constexpr auto kPushPeriod = std::chrono::milliseconds{1000};
+  // How often the aggregates of an aggregated output are read out, which is the period that each
+  // of their rows covers.
+  static constexpr auto kAggregatePeriod = std::chrono::seconds{10};
 
   ~DynamicTraceConnector() override = default;
 
@@ -45,6 +83,9 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
   // Accepts a piece of data from the perf buffer.
   void AcceptDataEvents(std::string data) { data_items_.push_back(std::move(data)); }
 
+  // Accepts the number of data items that the perf buffer lost.
+  void AcceptEventLoss(uint64_t lost) { RecordSamplingLoss(lost); }
+
  protected:
   // TODO(oazizi): This constructor only works with a single table,
   //               since the ArrayView creation only works for a single schema.
@@ -62,8 +103,10 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
   Status StopImpl() override { return Status::OK(); }
 
  private:
-  Status AppendRecord(const ::px::stirling::dynamic_tracing::ir::physical::Struct& st,
-                      uint32_t asid, std::string_view buf, DataTable* data_table);
+  bool is_aggregated() const { return !bcc_program_.aggregate_map_specs.empty(); }
+
+  // Reads out the aggregates of the aggregated output as records of its row struct.
+  void DrainAggregates();
 
   // Describes the output table column types.
   std::unique_ptr<DynamicDataTableSchema> table_schema_;
@@ -71,6 +114,13 @@ class DynamicTraceConnector : public SourceConnector, public bpf_tools::BCCWrapp
   // The actual dynamic trace program.
   dynamic_tracing::BCCProgram bcc_program_;
 
+  // The layout of the records of an aggregated output, whose fields are the time, the key, and the
+  // aggregates. Unused for perf buffer outputs.
+  dynamic_tracing::ir::physical::Struct aggregate_row_struct_;
+
+  // Decodes the data items of the perf buffer into records of the output table.
+  DynamicRecordDecoder record_decoder_;
+
   // A buffer to hold raw data items from the perf buffer.
   std::deque<std::string> data_items_;
 };
@@ -81,5 +131,11 @@ BackedDataElements ConvertFields(
     const google::protobuf::RepeatedPtrField<dynamic_tracing::ir::physical::Field>&
         repeated_fields);
 
+// Returns the struct of the records of an aggregated output. Each record is the time at which the
+// aggregates were read out, the key, the count, and also the sum for SUM.
+// Only public for testing purposes.
+dynamic_tracing::ir::physical::Struct AggregateRowStruct(
+    const dynamic_tracing::BCCProgram::AggregateMapSpec& spec);
+
 }  // namespace stirling
 }  // namespace px
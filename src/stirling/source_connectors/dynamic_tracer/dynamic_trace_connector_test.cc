@@ -17,7 +17,10 @@
  */
 
 #include <unistd.h>
+#include <memory>
 #include <regex>
+#include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
@@ -79,5 +82,101 @@ TEST(DynamicTraceConnectorTest, ConvertFields) {
   EXPECT_EQ(elements.elements()[2].type(), types::TIME64NS);
 }
 
+TEST(DynamicTraceConnectorTest, AggregateRowStruct) {
+  constexpr std::string_view kKeyStruct = R"(
+      name: "calls_key_t"
+      fields {
+        name: "tgid_"
+        type: INT32
+      }
+      fields {
+        name: "tgid_start_time_"
+        type: UINT64
+      }
+      fields {
+        name: "arg0"
+        type: INT
+      }
+  )";
+
+  dynamic_tracing::BCCProgram::AggregateMapSpec spec;
+  spec.name = "calls";
+  spec.function = dynamic_tracing::ir::shared::Aggregation::SUM;
+  ASSERT_TRUE(google::protobuf::TextFormat::ParseFromString(std::string(kKeyStruct), &spec.key));
+
+  BackedDataElements elements = ConvertFields(AggregateRowStruct(spec).fields());
+
+  ASSERT_EQ(elements.elements().size(), 5);
+  EXPECT_EQ(elements.elements()[0].name(), "upid");
+  EXPECT_EQ(elements.elements()[1].name(), "time_");
+  EXPECT_EQ(elements.elements()[1].type(), types::TIME64NS);
+  EXPECT_EQ(elements.elements()[2].name(), "arg0");
+  EXPECT_EQ(elements.elements()[3].name(), "count");
+  EXPECT_EQ(elements.elements()[4].name(), "sum");
+}
+
+TEST(DynamicRecordDecoderTest, Decode) {
+  constexpr std::string_view kOutputStruct = R"(
+      name: "out_table_value_t"
+      fields {
+        name: "tgid_"
+        type: INT32
+      }
+      fields {
+        name: "tgid_start_time_"
+        type: UINT64
+      }
+      fields {
+        name: "time_"
+        type: UINT64
+      }
+      fields {
+        name: "arg0"
+        type: INT
+      }
+      fields {
+        name: "arg1"
+        type: BOOL
+      }
+  )";
+
+  ::px::stirling::dynamic_tracing::ir::physical::Struct output_struct;
+  ASSERT_TRUE(
+      google::protobuf::TextFormat::ParseFromString(std::string(kOutputStruct), &output_struct));
+
+  std::unique_ptr<DynamicDataTableSchema> table_schema = DynamicDataTableSchema::Create(
+      "out_table", "A table for testing", ConvertFields(output_struct.fields()));
+  DataTable data_table(/*id*/ 0, table_schema->Get());
+
+  ASSERT_OK_AND_ASSIGN(DynamicRecordDecoder decoder, DynamicRecordDecoder::Create(output_struct));
+
+  // The record is the packed struct written by the BPF program.
+  std::string record;
+  auto append = [&record](auto val) {
+    record.append(reinterpret_cast<const char*>(&val), sizeof(val));
+  };
+  append(uint32_t{123});
+  append(uint64_t{456});
+  append(uint64_t{1000});
+  append(int{-7});
+  append(true);
+
+  const DynamicRecordDecoder::Context ctx = {.asid = 1, .clock_realtime_offset = 5};
+  ASSERT_OK(decoder.Decode(ctx, record, &data_table));
+  ASSERT_OK(decoder.Decode(ctx, record, &data_table));
+
+  std::vector<TaggedRecordBatch> record_batches = data_table.ConsumeRecords();
+  ASSERT_EQ(record_batches.size(), 1);
+  types::ColumnWrapperRecordBatch& rb = record_batches[0].records;
+  ASSERT_EQ(rb.size(), 4);
+  ASSERT_EQ(rb[0]->Size(), 2);
+  for (size_t i = 0; i < 2; ++i) {
+    EXPECT_EQ(md::UPID(rb[0]->Get<types::UInt128Value>(i).val), md::UPID(1, 123, 456));
+    EXPECT_EQ(rb[1]->Get<types::Time64NSValue>(i), 1005);
+    EXPECT_EQ(rb[2]->Get<types::Int64Value>(i), -7);
+    EXPECT_EQ(rb[3]->Get<types::BoolValue>(i), true);
+  }
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -37,6 +37,8 @@ namespace dynamic_tracing {
 
 using ::px::stirling::bpf_tools::BPFProbeAttachType;
 using ::px::stirling::bpf_tools::UProbeSpec;
+using ::px::stirling::dynamic_tracing::ir::physical::AggregateAction;
+using ::px::stirling::dynamic_tracing::ir::physical::AggregateOutput;
 using ::px::stirling::dynamic_tracing::ir::physical::BinaryExpression;
 using ::px::stirling::dynamic_tracing::ir::physical::Field;
 using ::px::stirling::dynamic_tracing::ir::physical::MapDeleteAction;
@@ -52,6 +54,7 @@ using ::px::stirling::dynamic_tracing::ir::physical::ScalarVariable;
 using ::px::stirling::dynamic_tracing::ir::physical::Struct;
 using ::px::stirling::dynamic_tracing::ir::physical::StructVariable;
 using ::px::stirling::dynamic_tracing::ir::physical::Variable;
+using ::px::stirling::dynamic_tracing::ir::shared::Aggregation;
 using ::px::stirling::dynamic_tracing::ir::shared::BPFHelper;
 using ::px::stirling::dynamic_tracing::ir::shared::Condition;
 using ::px::stirling::dynamic_tracing::ir::shared::Map;
@@ -610,6 +613,56 @@ StatusOr<std::vector<std::string>> GenPerfBufferOutputAction(
   return code_lines;
 }
 
+std::string GenAggregateOutput(const AggregateOutput& output) {
+  return absl::Substitute("BPF_PERCPU_HASH($0, struct $1, struct $2, $3);", output.name(),
+                          output.key_struct_type(), kAggregateValueStructName, output.capacity());
+}
+
+StatusOr<std::vector<std::string>> GenAggregateAction(const ir::physical::Struct& key_struct,
+                                                      const AggregateAction& action) {
+  const bool is_hist = action.function() == Aggregation::LOG2_HIST;
+  if (key_struct.fields_size() != action.key_variable_names_size() + (is_hist ? 1 : 0)) {
+    return error::InvalidArgument("Aggregate action to '$0' assigns $1 variables to $2 key fields",
+                                  action.map_name(), action.key_variable_names_size(),
+                                  key_struct.fields_size());
+  }
+
+  std::string key_var_name = absl::StrCat(action.map_name(), "_key");
+  std::string zero_var_name = absl::StrCat(action.map_name(), "_zero");
+  std::string agg_var_name = absl::StrCat(action.map_name(), "_agg");
+
+  std::vector<std::string> code_lines;
+
+  // The key struct is packed, so it has no padding that could make equal keys differ.
+  code_lines.push_back(absl::Substitute("struct $0 $1 = {};", key_struct.name(), key_var_name));
+  int struct_field_index = 0;
+  for (const auto& f : action.key_variable_names()) {
+    code_lines.push_back(absl::Substitute("$0.$1 = $2;", key_var_name,
+                                          key_struct.fields(struct_field_index++).name(), f));
+  }
+  if (is_hist) {
+    code_lines.push_back(absl::Substitute("$0.$1 = pl_log2_bucket($2);", key_var_name,
+                                          key_struct.fields(struct_field_index).name(),
+                                          action.value_variable_name()));
+  }
+
+  code_lines.push_back(
+      absl::Substitute("struct $0 $1 = {};", kAggregateValueStructName, zero_var_name));
+  code_lines.push_back(absl::Substitute("struct $0* $1 = $2.lookup_or_try_init(&$3, &$4);",
+                                        kAggregateValueStructName, agg_var_name, action.map_name(),
+                                        key_var_name, zero_var_name));
+  // Per-CPU values are only updated by the current CPU, so do not need atomic operations.
+  code_lines.push_back(absl::Substitute("if ($0 != NULL) {", agg_var_name));
+  code_lines.push_back(absl::Substitute("$0->count += 1;", agg_var_name));
+  if (action.function() == Aggregation::SUM) {
+    code_lines.push_back(
+        absl::Substitute("$0->sum += $1;", agg_var_name, action.value_variable_name()));
+  }
+  code_lines.push_back("}");
+
+  return code_lines;
+}
+
 ScalarType GetScalarVariableType(const Variable& var) {
   if (var.var_oneof_case() == Variable::VarOneofCase::kScalarVar) {
     return var.scalar_var().type();
@@ -860,6 +913,24 @@ StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateProbe(const Probe&
     MOVE_BACK_STR_VEC(GenPerfBufferOutputAction(*iter->second, action), &code_lines);
   }
 
+  for (const auto& action : probe.aggregate_actions()) {
+    auto iter = structs_.find(action.key_struct_name());
+    if (iter == structs_.end()) {
+      return error::InvalidArgument("Aggregate key struct '$0' is undefined",
+                                    action.key_struct_name());
+    }
+    for (const auto& var_name : action.key_variable_names()) {
+      PL_RETURN_IF_ERROR(CheckVarExists(
+          vars, var_name, absl::Substitute("BPF aggregate map '$0' key", action.map_name())));
+    }
+    if (action.function() != Aggregation::COUNT) {
+      PL_RETURN_IF_ERROR(
+          CheckVarExists(vars, action.value_variable_name(),
+                         absl::Substitute("BPF aggregate map '$0' value", action.map_name())));
+    }
+    MOVE_BACK_STR_VEC(GenAggregateAction(*iter->second, action), &code_lines);
+  }
+
   for (const auto& printk : probe.printks()) {
     PL_ASSIGN_OR_RETURN(std::string code_line, GenPrintk(vars, printk));
     code_lines.push_back(std::move(code_line));
@@ -977,6 +1048,30 @@ std::vector<std::string> GenBlobType(std::string_view type_name, int size,
   return code_lines;
 }
 
+// Returns the value type of the aggregate maps, and the helper to compute histogram buckets.
+// NOTE: The value type must match AggregateValue in types.h.
+std::vector<std::string> GenAggregateTypes() {
+  return {
+      absl::Substitute("struct $0 {", kAggregateValueStructName),
+      "  uint64_t count;",
+      "  int64_t sum;",
+      "};",
+      // Returns the largest power of two that is not larger than x, or 0 if x is not positive.
+      // This is a loop-free bit smear, to keep the verifier happy.
+      "static __inline int64_t pl_log2_bucket(int64_t x) {",
+      "if (x <= 0) { return 0; }",
+      "uint64_t v = x;",
+      "v |= v >> 1;",
+      "v |= v >> 2;",
+      "v |= v >> 4;",
+      "v |= v >> 8;",
+      "v |= v >> 16;",
+      "v |= v >> 32;",
+      "return v - (v >> 1);",
+      "}",
+  };
+}
+
 // Returns the type definitions of pre-defined data structures.
 std::vector<std::string> GenTypes() {
   std::vector<std::string> code_lines;
@@ -1030,6 +1125,22 @@ StatusOr<std::vector<std::string>> BCCCodeGenerator::GenerateCodeLines() {
     code_lines.push_back(GenPerfBufferOutput(output));
   }
 
+  if (!program_.aggregate_outputs().empty()) {
+    MoveBackStrVec(GenAggregateTypes(), &code_lines);
+  }
+
+  for (const auto& output : program_.aggregate_outputs()) {
+    if (!structs_.contains(output.key_struct_type())) {
+      return error::InvalidArgument(
+          "Struct key type '$0' referenced in aggregate output '$1' was not defined",
+          output.key_struct_type(), output.name());
+    }
+    if (output.capacity() == 0) {
+      return error::InvalidArgument("Aggregate output '$0' capacity cannot be 0", output.name());
+    }
+    code_lines.push_back(GenAggregateOutput(output));
+  }
+
   for (const auto& probe : program_.probes()) {
     MOVE_BACK_STR_VEC(GenerateProbe(probe), &code_lines);
   }
@@ -18,6 +18,8 @@
 
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/code_gen.h"
 
+#include <algorithm>
+
 #include <google/protobuf/text_format.h>
 
 #include "src/common/testing/testing.h"
@@ -476,6 +478,99 @@ TEST(GenProgramTest, SpecsAndCode) {
   EXPECT_THAT(bcc_code_lines, ElementsAreArray(expected_code_lines));
 }
 
+TEST(GenProgramTest, AggregateOutput) {
+  const std::string program_protobuf = R"proto(
+                                       deployment_spec {
+                                         path: "target_binary_path"
+                                       }
+                                       language: C
+                                       structs {
+                                         name: "calls_key_t"
+                                         fields {
+                                           name: "tgid_"
+                                           type: UINT32
+                                         }
+                                         fields {
+                                           name: "latency"
+                                           type: INT64
+                                         }
+                                       }
+                                       aggregate_outputs {
+                                         name: "calls"
+                                         key_struct_type: "calls_key_t"
+                                         function: LOG2_HIST
+                                         capacity: 1024
+                                       }
+                                       probes {
+                                         name: "probe_return"
+                                         vars {
+                                           scalar_var {
+                                             name: "tgid_"
+                                             type: UINT32
+                                             builtin: TGID
+                                           }
+                                         }
+                                         vars {
+                                           scalar_var {
+                                             name: "lat"
+                                             type: INT64
+                                             builtin: KTIME
+                                           }
+                                         }
+                                         aggregate_actions {
+                                           map_name: "calls"
+                                           key_struct_name: "calls_key_t"
+                                           key_variable_names: "tgid_"
+                                           value_variable_name: "lat"
+                                           function: LOG2_HIST
+                                         }
+                                       }
+                                       )proto";
+
+  ir::physical::Program program;
+  ASSERT_TRUE(TextFormat::ParseFromString(program_protobuf, &program));
+
+  ASSERT_OK_AND_ASSIGN(const std::string bcc_code, GenBCCProgram(program));
+
+  std::vector<std::string> bcc_code_lines = absl::StrSplit(bcc_code, "\n");
+  auto iter = std::find(bcc_code_lines.begin(), bcc_code_lines.end(),
+                        "struct pl_aggregate_value_t {");
+  ASSERT_NE(iter, bcc_code_lines.end());
+
+  const std::vector<std::string> expected_code_lines = {
+      "struct pl_aggregate_value_t {",
+      "  uint64_t count;",
+      "  int64_t sum;",
+      "};",
+      "static __inline int64_t pl_log2_bucket(int64_t x) {",
+      "if (x <= 0) { return 0; }",
+      "uint64_t v = x;",
+      "v |= v >> 1;",
+      "v |= v >> 2;",
+      "v |= v >> 4;",
+      "v |= v >> 8;",
+      "v |= v >> 16;",
+      "v |= v >> 32;",
+      "return v - (v >> 1);",
+      "}",
+      "BPF_PERCPU_HASH(calls, struct calls_key_t, struct pl_aggregate_value_t, 1024);",
+      "int probe_return(struct pt_regs* ctx) {",
+      "uint32_t tgid_ = bpf_get_current_pid_tgid() >> 32;",
+      "int64_t lat = bpf_ktime_get_ns();",
+      "struct calls_key_t calls_key = {};",
+      "calls_key.tgid_ = tgid_;",
+      "calls_key.latency = pl_log2_bucket(lat);",
+      "struct pl_aggregate_value_t calls_zero = {};",
+      "struct pl_aggregate_value_t* calls_agg = calls.lookup_or_try_init(&calls_key, &calls_zero);",
+      "if (calls_agg != NULL) {",
+      "calls_agg->count += 1;",
+      "}",
+      "return 0;",
+      "}"};
+  EXPECT_THAT(std::vector<std::string>(iter, bcc_code_lines.end()),
+              ElementsAreArray(expected_code_lines));
+}
+
 }  // namespace dynamic_tracing
 }  // namespace stirling
 }  // namespace px
@@ -28,6 +28,7 @@
 #include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_replace.h>
 #include <google/protobuf/repeated_field.h>
+#include <google/protobuf/util/message_differencer.h>
 
 #include "src/stirling/obj_tools/dwarf_reader.h"
 #include "src/stirling/obj_tools/elf_reader.h"
@@ -122,6 +123,9 @@ class Dwarvifier {
   Status ProcessOutputAction(const ir::logical::OutputAction& output_action,
                              ir::physical::Probe* output_probe,
                              ir::physical::Program* output_program);
+  Status ProcessAggregateAction(const ir::logical::OutputAction& output_action,
+                                ir::physical::Probe* output_probe,
+                                ir::physical::Program* output_program);
 
   // TVarType can be ScalarVariable, StructVariable, etc.
   template <typename TVarType>
@@ -142,6 +146,8 @@ class Dwarvifier {
 
   std::map<std::string, ir::shared::Map*> maps_;
   std::map<std::string, ir::physical::PerfBufferOutput*> outputs_;
+  // The logical outputs that are aggregated inside BPF, instead of output to perf buffers.
+  std::map<std::string, const ir::logical::Output*> aggregated_outputs_;
   std::map<std::string, ir::physical::Struct*> structs_;
 
   obj_tools::DwarfReader* dwarf_reader_ = nullptr;
@@ -223,6 +229,14 @@ std::string StructTypeName(const std::string& obj_name) {
   return absl::StrCat(obj_name, "_value_t");
 }
 
+// Returns the name of the key struct of an aggregated Output.
+std::string KeyStructTypeName(const std::string& obj_name) {
+  return absl::StrCat(obj_name, "_key_t");
+}
+
+// The most groups of an aggregated Output that are held in BPF between two reads.
+constexpr uint32_t kAggregateOutputCapacity = 10240;
+
 // Map to convert Go Base types to ScalarType.
 // clang-format off
 const absl::flat_hash_map<std::string_view, ir::shared::ScalarType> kGoTypesMap = {
@@ -427,6 +441,16 @@ void Dwarvifier::GenerateMap(const ir::shared::Map& map, ir::physical::Program*
 
 void Dwarvifier::GenerateOutput(const ir::logical::Output& output,
                                 ir::physical::Program* output_program) {
+  if (output.has_aggregation()) {
+    auto* o = output_program->add_aggregate_outputs();
+    o->set_name(output.name());
+    o->set_key_struct_type(KeyStructTypeName(output.name()));
+    o->set_function(output.aggregation().function());
+    o->set_capacity(kAggregateOutputCapacity);
+    aggregated_outputs_[output.name()] = &output;
+    return;
+  }
+
   auto* o = output_program->add_outputs();
 
   o->set_name(output.name());
@@ -1313,6 +1337,10 @@ std::string DataBufferArrayName(std::string_view output_name) {
 Status Dwarvifier::ProcessOutputAction(const ir::logical::OutputAction& output_action_in,
                                        ir::physical::Probe* output_probe,
                                        ir::physical::Program* output_program) {
+  if (aggregated_outputs_.contains(output_action_in.output_name())) {
+    return ProcessAggregateAction(output_action_in, output_probe, output_program);
+  }
+
   std::string struct_type_name = StructTypeName(output_action_in.output_name());
   std::string data_buffer_array_name = DataBufferArrayName(output_action_in.output_name());
 
@@ -1350,6 +1378,128 @@ Status Dwarvifier::ProcessOutputAction(const ir::logical::OutputAction& output_a
   return Status::OK();
 }
 
+namespace {
+
+bool IsAggregatableKeyType(ir::shared::ScalarType type) {
+  switch (type) {
+    case ir::shared::ScalarType::STRING:
+    case ir::shared::ScalarType::BYTE_ARRAY:
+    case ir::shared::ScalarType::STRUCT_BLOB:
+    case ir::shared::ScalarType::VOID_POINTER:
+    case ir::shared::ScalarType::UNKNOWN:
+      return false;
+    default:
+      return true;
+  }
+}
+
+bool IsIntegerType(ir::shared::ScalarType type) {
+  switch (type) {
+    case ir::shared::ScalarType::BOOL:
+    case ir::shared::ScalarType::FLOAT:
+    case ir::shared::ScalarType::DOUBLE:
+      return false;
+    default:
+      return IsAggregatableKeyType(type);
+  }
+}
+
+}  // namespace
+
+Status Dwarvifier::ProcessAggregateAction(const ir::logical::OutputAction& output_action_in,
+                                          ir::physical::Probe* output_probe,
+                                          ir::physical::Program* output_program) {
+  const std::string& output_name = output_action_in.output_name();
+  const ir::logical::Output& output = *aggregated_outputs_.at(output_name);
+  const ir::shared::Aggregation& aggregation = output.aggregation();
+
+  if (output.fields_size() != output_action_in.variable_names_size()) {
+    return error::InvalidArgument(
+        "OutputAction to '$0' writes $1 variables, but the Output has $2 fields", output_name,
+        output_action_in.variable_names_size(), output.fields_size());
+  }
+
+  auto* action = output_probe->add_aggregate_actions();
+  action->set_map_name(output_name);
+  action->set_key_struct_name(KeyStructTypeName(output_name));
+  action->set_function(aggregation.function());
+
+  ir::physical::Struct key_struct;
+  key_struct.set_name(action->key_struct_name());
+
+  // Always group by process, which becomes the upid column. Unlike perf buffer outputs, the time
+  // and goid are not part of the key, as they differ between almost all calls.
+  for (std::string_view f : {kTGIDVarName, kTGIDStartTimeVarName}) {
+    auto iter = variables_.find(f);
+    if (iter == variables_.end()) {
+      return error::Internal("ProcessAggregateAction [output=$0]: Reference to unknown variable $1",
+                             output_name, f);
+    }
+    key_struct.add_fields()->CopyFrom(iter->second);
+    action->add_key_variable_names(std::string(f));
+  }
+
+  for (int i = 0; i < output_action_in.variable_names_size(); ++i) {
+    const std::string& var_name = output_action_in.variable_names(i);
+
+    auto iter = variables_.find(var_name);
+    if (iter == variables_.end()) {
+      return error::Internal("ProcessAggregateAction [output=$0]: Reference to unknown variable $1",
+                             output_name, var_name);
+    }
+    ir::shared::ScalarType type = iter->second.type();
+
+    if (aggregation.function() != ir::shared::Aggregation::COUNT &&
+        output.fields(i) == aggregation.value_field()) {
+      if (!IsIntegerType(type)) {
+        return error::InvalidArgument("Aggregated field '$0' of Output '$1' has type $2, "
+                                      "but only integers can be aggregated",
+                                      output.fields(i), output_name, magic_enum::enum_name(type));
+      }
+      action->set_value_variable_name(var_name);
+      continue;
+    }
+
+    if (!IsAggregatableKeyType(type)) {
+      return error::InvalidArgument(
+          "Field '$0' of aggregated Output '$1' has type $2, which cannot be grouped by",
+          output.fields(i), output_name, magic_enum::enum_name(type));
+    }
+
+    auto* field = key_struct.add_fields();
+    field->CopyFrom(iter->second);
+    field->set_name(output.fields(i));
+    action->add_key_variable_names(var_name);
+  }
+
+  if (aggregation.function() != ir::shared::Aggregation::COUNT &&
+      action->value_variable_name().empty()) {
+    return error::InvalidArgument("Aggregated field '$0' is not a field of Output '$1'",
+                                  aggregation.value_field(), output_name);
+  }
+
+  if (aggregation.function() == ir::shared::Aggregation::LOG2_HIST) {
+    // The power-of-two bucket of the value, which the code generator computes.
+    auto* field = key_struct.add_fields();
+    field->set_name(aggregation.value_field());
+    field->set_type(ir::shared::ScalarType::INT64);
+  }
+
+  // Several probes may update the same output.
+  auto struct_iter = structs_.find(key_struct.name());
+  if (struct_iter == structs_.end()) {
+    auto* struct_decl = output_program->add_structs();
+    *struct_decl = std::move(key_struct);
+    structs_[struct_decl->name()] = struct_decl;
+  } else if (!google::protobuf::util::MessageDifferencer::Equals(*struct_iter->second,
+                                                                 key_struct)) {
+    return error::InvalidArgument("Probes update aggregated Output '$0' with different types",
+                                  output_name);
+  }
+
+  return Status::OK();
+}
+
 }  // namespace dynamic_tracing
 }  // namespace stirling
 }  // namespace px
@@ -1461,6 +1461,150 @@ arrays {
 }
 )";
 
+constexpr std::string_view kAggregateProbeIn = R"(
+deployment_spec {
+  path: "$0"
+}
+tracepoints {
+  program {
+    language: GOLANG
+    outputs {
+      name: "calls"
+      fields: "retval0"
+      fields: "retval1"
+      aggregation {
+        function: SUM
+        value_field: "retval0"
+      }
+    }
+    probes {
+      tracepoint: {
+        symbol: "main.MixedArgTypes"
+        type: RETURN
+      }
+      ret_vals {
+        id: "retval0"
+        expr: "$$0"
+      }
+      ret_vals {
+        id: "retval1"
+        expr: "$$1.B1"
+      }
+      output_actions {
+        output_name: "calls"
+        variable_names: "retval0"
+        variable_names: "retval1"
+      }
+    }
+  }
+}
+)";
+
+constexpr std::string_view kAggregateProbeOut = R"(
+deployment_spec {
+  path: "$0"
+}
+language: GOLANG
+structs {
+  name: "calls_key_t"
+  fields {
+    name: "tgid_"
+    type: INT32
+  }
+  fields {
+    name: "tgid_start_time_"
+    type: UINT64
+  }
+  fields {
+    name: "retval1"
+    type: BOOL
+  }
+}
+aggregate_outputs {
+  name: "calls"
+  key_struct_type: "calls_key_t"
+  function: SUM
+  capacity: 10240
+}
+probes {
+  tracepoint {
+    symbol: "main.MixedArgTypes"
+    type: RETURN
+  }
+  vars {
+    scalar_var {
+      name: "sp_"
+      type: VOID_POINTER
+      reg: SP
+    }
+  }
+  vars {
+    scalar_var {
+      name: "tgid_"
+      type: INT32
+      builtin: TGID
+    }
+  }
+  vars {
+    scalar_var {
+      name: "tgid_pid_"
+      type: UINT64
+      builtin: TGID_PID
+    }
+  }
+  vars {
+    scalar_var {
+      name: "tgid_start_time_"
+      type: UINT64
+      builtin: TGID_START_TIME
+    }
+  }
+  vars {
+    scalar_var {
+      name: "time_"
+      type: UINT64
+      builtin: KTIME
+    }
+  }
+  vars {
+    scalar_var {
+      name: "goid_"
+      type: INT64
+      builtin: GOID
+    }
+  }
+  vars {
+    scalar_var {
+      name: "retval0"
+      type: INT
+      memory {
+        base: "sp_"
+        offset: 48
+      }
+    }
+  }
+  vars {
+    scalar_var {
+      name: "retval1"
+      type: BOOL
+      memory {
+        base: "sp_"
+        offset: 57
+      }
+    }
+  }
+  aggregate_actions {
+    map_name: "calls"
+    key_struct_name: "calls_key_t"
+    key_variable_names: "tgid_"
+    key_variable_names: "tgid_start_time_"
+    key_variable_names: "retval1"
+    value_variable_name: "retval0"
+    function: SUM
+  }
+}
+)";
+
 struct DwarfInfoTestParam {
   std::string_view input;
   std::string_view expected_output;
@@ -1514,7 +1658,8 @@ INSTANTIATE_TEST_SUITE_P(
                       DwarfInfoTestParam{kActionProbeIn, kActionProbeOut},
                       DwarfInfoTestParam{kStructProbeIn, kStructProbeOut},
                       DwarfInfoTestParam{kGolangErrorInterfaceProbeIn,
-                                         kGolangErrorInterfaceProbeOut}));
+                                         kGolangErrorInterfaceProbeOut},
+                      DwarfInfoTestParam{kAggregateProbeIn, kAggregateProbeOut}));
 
 }  // namespace dynamic_tracing
 }  // namespace stirling
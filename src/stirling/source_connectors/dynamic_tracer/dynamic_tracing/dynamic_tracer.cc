@@ -20,11 +20,17 @@
 
 #include <algorithm>
 #include <memory>
+#include <optional>
 #include <regex>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/system.h"
 
@@ -49,6 +55,7 @@ namespace dynamic_tracing {
 
 using ::px::stirling::bpf_tools::BPFProbeAttachType;
 using ::px::stirling::bpf_tools::UProbeSpec;
+using ::px::stirling::obj_tools::DwarfIndexMode;
 using ::px::stirling::obj_tools::DwarfReader;
 using ::px::stirling::obj_tools::ElfReader;
 using ::px::system::ProcParser;
@@ -95,6 +102,24 @@ StatusOr<BCCProgram::PerfBufferSpec> GetPerfBufferSpec(
   return pf_spec;
 }
 
+StatusOr<BCCProgram::AggregateMapSpec> GetAggregateMapSpec(
+    const absl::flat_hash_map<std::string_view, const ir::physical::Struct*>& structs,
+    const ir::physical::AggregateOutput& output) {
+  auto iter = structs.find(output.key_struct_type());
+
+  if (iter == structs.end()) {
+    return error::InvalidArgument("Struct '$0' was not defined", output.key_struct_type());
+  }
+
+  BCCProgram::AggregateMapSpec spec;
+
+  spec.name = output.name();
+  spec.key = *iter->second;
+  spec.function = output.function();
+
+  return spec;
+}
+
 // Return value for Prepare(), so we can return multiple pointers.
 struct ObjInfo {
   std::unique_ptr<ElfReader> elf_reader;
@@ -114,23 +139,69 @@ StatusOr<ObjInfo> Prepare(const ir::logical::TracepointDeployment& input_program
 
   const auto& debug_symbols_path = obj_info.elf_reader->debug_symbols_path().string();
 
-  obj_info.dwarf_reader = DwarfReader::Create(debug_symbols_path).ConsumeValueOr(nullptr);
+  obj_info.dwarf_reader =
+      DwarfReader::Create(debug_symbols_path, DwarfIndexMode::kLazy).ConsumeValueOr(nullptr);
 
   return obj_info;
 }
 
-}  // namespace
+// Memoizes the compiled programs by the build of the target binary and the tracepoint spec.
+// Redeploying a tracepoint on another copy of the same binary, e.g. in a newly created pod, or
+// after its TTL was refreshed, then skips the DWARF resolution and the code generation.
+class CompiledProgramCache {
+ public:
+  std::optional<BCCProgram> Lookup(const std::string& key) {
+    absl::MutexLock lock(&mu_);
+    auto iter = programs_.find(key);
+    if (iter == programs_.end()) {
+      return std::nullopt;
+    }
+    return iter->second;
+  }
 
-StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_program) {
-  if (input_program->deployment_spec().path().empty()) {
-    return error::InvalidArgument("Must have path resolved before compiling program");
+  void Insert(std::string key, const BCCProgram& program) {
+    absl::MutexLock lock(&mu_);
+    // Tracepoints are deployed rarely, so simply start over once the cache is full.
+    if (programs_.size() >= kMaxPrograms) {
+      programs_.clear();
+    }
+    programs_.insert_or_assign(std::move(key), program);
   }
 
-  if (input_program->tracepoints_size() != 1) {
-    return error::InvalidArgument("Only one tracepoint currently supported, got '$0'",
-                                  input_program->tracepoints_size());
+ private:
+  static constexpr size_t kMaxPrograms = 64;
+
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::string, BCCProgram> programs_ ABSL_GUARDED_BY(mu_);
+};
+
+CompiledProgramCache& GetCompiledProgramCache() {
+  static auto* cache = new CompiledProgramCache();
+  return *cache;
+}
+
+// Returns the key of the program in the CompiledProgramCache: the build ID of the target binary,
+// and the deterministically serialized program, less its deployment spec.
+StatusOr<std::string> CompiledProgramKey(const ir::logical::TracepointDeployment& program) {
+  PL_ASSIGN_OR_RETURN(std::string build_id,
+                      obj_tools::ReadBuildID(program.deployment_spec().path()));
+
+  ir::logical::TracepointDeployment spec = program;
+  spec.clear_deployment_spec();
+
+  std::string key = absl::StrCat(build_id, "/");
+  {
+    google::protobuf::io::StringOutputStream stream(&key);
+    google::protobuf::io::CodedOutputStream coded_stream(&stream);
+    coded_stream.SetSerializationDeterministic(true);
+    if (!spec.SerializeToCodedStream(&coded_stream)) {
+      return error::Internal("Failed to serialize the tracepoint program.");
+    }
   }
+  return key;
+}
 
+StatusOr<BCCProgram> CompileProgramUncached(ir::logical::TracepointDeployment* input_program) {
   // Get the ELF and DWARF readers for the program.
   PL_ASSIGN_OR_RETURN(ObjInfo obj_info, Prepare(*input_program));
 
@@ -201,6 +272,45 @@ StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_pro
     bcc_program.perf_buffer_specs.push_back(std::move(pf_spec));
   }
 
+  for (const auto& output : physical_program.aggregate_outputs()) {
+    PL_ASSIGN_OR_RETURN(BCCProgram::AggregateMapSpec spec, GetAggregateMapSpec(structs, output));
+    bcc_program.aggregate_map_specs.push_back(std::move(spec));
+  }
+
+  return bcc_program;
+}
+
+}  // namespace
+
+StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_program) {
+  if (input_program->deployment_spec().path().empty()) {
+    return error::InvalidArgument("Must have path resolved before compiling program");
+  }
+
+  if (input_program->tracepoints_size() != 1) {
+    return error::InvalidArgument("Only one tracepoint currently supported, got '$0'",
+                                  input_program->tracepoints_size());
+  }
+
+  // Binaries without a build ID are always compiled.
+  StatusOr<std::string> key_or = CompiledProgramKey(*input_program);
+  if (!key_or.ok()) {
+    VLOG(1) << absl::Substitute("Not caching the compiled program: $0", key_or.msg());
+    return CompileProgramUncached(input_program);
+  }
+
+  const std::string& binary_path = input_program->deployment_spec().path();
+  std::optional<BCCProgram> cached = GetCompiledProgramCache().Lookup(key_or.ValueOrDie());
+  if (cached.has_value()) {
+    LOG(INFO) << absl::Substitute("Reusing the compiled program for binary $0.", binary_path);
+    for (auto& spec : cached->uprobe_specs) {
+      spec.binary_path = binary_path;
+    }
+    return std::move(cached.value());
+  }
+
+  PL_ASSIGN_OR_RETURN(BCCProgram bcc_program, CompileProgramUncached(input_program));
+  GetCompiledProgramCache().Insert(key_or.ConsumeValueOrDie(), bcc_program);
   return bcc_program;
 }
 
@@ -44,6 +44,9 @@ Status ResolveTargetObjPath(const md::K8sMetadataState& k8s_mds,
 /**
  * Transforms any logical probes inside a program into entry and return probes.
  * Also automatically adds any required supporting maps and implicit outputs.
+ *
+ * The compiled programs are memoized by the build ID of the target binary and the rest of the
+ * program. When the memoized program is returned, input_program is left as is.
  */
 StatusOr<BCCProgram> CompileProgram(ir::logical::TracepointDeployment* input_program);
 
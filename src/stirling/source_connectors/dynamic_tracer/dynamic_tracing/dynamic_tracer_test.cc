@@ -18,11 +18,14 @@
 
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "src/common/exec/subprocess.h"
 #include "src/common/fs/fs_wrapper.h"
+#include "src/common/fs/temp_file.h"
 #include "src/common/testing/testing.h"
 #include "src/stirling/testing/common.h"
 
@@ -106,7 +109,7 @@ class ResolveTargetObjPathTest : public ::testing::Test {
     ASSERT_OK(k8s_mds_.HandlePodUpdate(pod0_update));
     ASSERT_OK(k8s_mds_.HandlePodUpdate(pod1_update));
 
-    k8s_mds_.containers_by_id()["container0"]->mutable_active_upids()->emplace(
+    k8s_mds_.MutableContainerInfoByID("container0")->mutable_active_upids()->emplace(
         PIDToUPID(s_.child_pid()));
   }
 
@@ -379,6 +382,31 @@ const std::vector<std::string> kExpectedBCC = {
     "}",
 };
 
+// A copy of the same binary, like the binary of a new pod of the same image, reuses the
+// compiled program, with its uprobes attached to the copy.
+TEST(DynamicTracerTest, CompileCopyOfBinary) {
+  const std::filesystem::path binary_path = px::testing::BazelBinTestFilePath(kBinaryPath);
+  std::unique_ptr<fs::TempFile> binary_copy = fs::TempFile::Create();
+  std::filesystem::copy_file(binary_path, binary_copy->path(),
+                             std::filesystem::copy_options::overwrite_existing);
+
+  ir::logical::TracepointDeployment input_program;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kLogicalProgramSpec, binary_path.string()), &input_program));
+  ASSERT_OK_AND_ASSIGN(BCCProgram bcc_program, CompileProgram(&input_program));
+
+  ir::logical::TracepointDeployment copy_program;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      absl::Substitute(kLogicalProgramSpec, binary_copy->path().string()), &copy_program));
+  ASSERT_OK_AND_ASSIGN(BCCProgram copy_bcc_program, CompileProgram(&copy_program));
+
+  EXPECT_EQ(copy_bcc_program.code, bcc_program.code);
+  ASSERT_THAT(copy_bcc_program.uprobe_specs, SizeIs(bcc_program.uprobe_specs.size()));
+  for (const auto& spec : copy_bcc_program.uprobe_specs) {
+    EXPECT_EQ(spec.binary_path, binary_copy->path().string());
+  }
+}
+
 TEST(DynamicTracerTest, Compile) {
   std::string input_program_str = absl::Substitute(
       kLogicalProgramSpec, px::testing::BazelBinTestFilePath(kBinaryPath).string());
@@ -53,6 +53,16 @@ constexpr size_t kStructByteArraySize = 64;
 // generated types.
 constexpr size_t kStructBlobSize = 64;
 
+// The name of the value struct of the BPF maps of aggregated outputs.
+constexpr char kAggregateValueStructName[] = "pl_aggregate_value_t";
+
+// The value of the BPF maps of aggregated outputs.
+// NOTE: This must match the struct generated in code_gen.cc.
+struct AggregateValue {
+  uint64_t count;
+  int64_t sum;
+};
+
 struct BCCProgram {
   struct PerfBufferSpec {
     std::string name;
@@ -63,8 +73,22 @@ struct BCCProgram {
     }
   };
 
+  // Describes a BPF_PERCPU_HASH of aggregates, whose key is the key struct, and whose value is
+  // an AggregateValue.
+  struct AggregateMapSpec {
+    std::string name;
+    ir::physical::Struct key;
+    ir::shared::Aggregation::Function function;
+
+    std::string ToString() const {
+      return absl::Substitute("[name=$0 function=$1 Key struct=$2]", name,
+                              ir::shared::Aggregation::Function_Name(function), key.DebugString());
+    }
+  };
+
   std::vector<bpf_tools::UProbeSpec> uprobe_specs;
   std::vector<PerfBufferSpec> perf_buffer_specs;
+  std::vector<AggregateMapSpec> aggregate_map_specs;
   std::string code;
 
   std::string ToString() const {
@@ -76,6 +100,9 @@ struct BCCProgram {
     for (const auto& spec : perf_buffer_specs) {
       absl::StrAppend(&txt, spec.ToString(), "\n");
     }
+    for (const auto& spec : aggregate_map_specs) {
+      absl::StrAppend(&txt, spec.ToString(), "\n");
+    }
     absl::StrAppend(&txt, "[BCC BEGIN]\n", code, "\n[BCC END]");
 
     return txt;
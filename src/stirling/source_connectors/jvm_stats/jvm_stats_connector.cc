@@ -45,7 +45,7 @@ Status JVMStatsConnector::InitImpl() {
 
 void JVMStatsConnector::FindJavaUPIDs(const ConnectorContext& ctx) {
   const auto& proc_parser = system::ProcParser(system::Config::GetInstance());
-  proc_tracker_.Update(ctx.GetUPIDs());
+  proc_tracker_.Update(ctx.GetUPIDs(), ctx.GetUPIDsVersion(), ctx.GetUPIDsDelta().get());
 
   for (const auto& upid : proc_tracker_.new_upids()) {
     // The host PID 1 is not a Java app. However, when later invoking HsperfdataPath(), it could be
@@ -65,21 +65,22 @@ void JVMStatsConnector::FindJavaUPIDs(const ConnectorContext& ctx) {
   }
 }
 
-Status JVMStatsConnector::ExportStats(const md::UPID& upid,
-                                      const std::filesystem::path& hsperf_data_path,
+Status JVMStatsConnector::ExportStats(const md::UPID& upid, JavaProcInfo* java_proc,
                                       DataTable* data_table) const {
-  PL_ASSIGN_OR_RETURN(std::string hsperf_data_str, ReadFileToString(hsperf_data_path));
-
-  if (hsperf_data_str.empty()) {
-    // Assume this is a transient failure.
-    return Status::OK();
+  if (java_proc->stats_reader == nullptr) {
+    auto stats_reader_or = java::StatsReader::Create(java_proc->hsperf_data_path);
+    if (error::IsResourceUnavailable(stats_reader_or.status())) {
+      // Assume this is a transient failure.
+      return Status::OK();
+    }
+    PL_ASSIGN_OR_RETURN(java_proc->stats_reader, std::move(stats_reader_or));
   }
 
-  java::Stats stats(std::move(hsperf_data_str));
-  if (!stats.Parse().ok()) {
+  if (!java_proc->stats_reader->Refresh().ok()) {
     // Assumes this is a transient failure.
     return Status::OK();
   }
+  const java::StatsReader& stats = *java_proc->stats_reader;
 
   uint64_t time = CurrentTimeNS();
 
@@ -106,12 +107,17 @@ void JVMStatsConnector::TransferDataImpl(ConnectorContext* ctx,
 
   FindJavaUPIDs(*ctx);
 
+  // The hsperfdata file stays mapped after the process exits, so stop monitoring explicitly.
+  for (const auto& upid : proc_tracker_.deleted_upids()) {
+    java_procs_.erase(upid);
+  }
+
   for (auto iter = java_procs_.begin(); iter != java_procs_.end();) {
     const md::UPID& upid = iter->first;
     JavaProcInfo& java_proc = iter->second;
 
     md::UPID upid_with_asid(ctx->GetASID(), upid.pid(), upid.start_ts());
-    auto status = ExportStats(upid_with_asid, java_proc.hsperf_data_path, data_table);
+    auto status = ExportStats(upid_with_asid, &java_proc, data_table);
     if (!status.ok()) {
       ++java_proc.export_failure_count;
     }
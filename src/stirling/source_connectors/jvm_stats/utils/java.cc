@@ -18,14 +18,22 @@
 
 #include "src/stirling/source_connectors/jvm_stats/utils/java.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <absl/strings/match.h>
 
+#include <cerrno>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "src/common/base/byte_utils.h"
+#include "src/common/base/defer.h"
 #include "src/common/base/statusor.h"
 #include "src/common/fs/fs_wrapper.h"
 #include "src/common/system/proc_parser.h"
@@ -41,6 +49,29 @@ using ::px::stirling::java::hsperf::ParseHsperfData;
 using ::px::system::ProcParser;
 using ::px::utils::LEndianBytesToInt;
 
+namespace {
+
+constexpr std::string_view kYoungGCTimeSuffix = "gc.collector.0.time";
+constexpr std::string_view kFullGCTimeSuffix = "gc.collector.1.time";
+constexpr std::string_view kUsedHeapSizeSuffixes[] = {
+    "gc.generation.0.space.0.used",
+    "gc.generation.0.space.1.used",
+    "gc.generation.0.space.2.used",
+    "gc.generation.1.space.0.used",
+};
+constexpr std::string_view kTotalHeapSizeSuffixes[] = {
+    "gc.generation.0.space.0.capacity",
+    "gc.generation.0.space.1.capacity",
+    "gc.generation.0.space.2.capacity",
+    "gc.generation.1.space.0.capacity",
+};
+constexpr std::string_view kMaxHeapSizeSuffixes[] = {
+    "gc.generation.0.maxCapacity",
+    "gc.generation.1.maxCapacity",
+};
+
+}  // namespace
+
 Stats::Stats(std::vector<Stat> stats) : stats_(std::move(stats)) {}
 
 Stats::Stats(std::string hsperf_data_str) : hsperf_data_(std::move(hsperf_data_str)) {}
@@ -58,34 +89,15 @@ Status Stats::Parse() {
   return Status::OK();
 }
 
-uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix("gc.collector.0.time"); }
+uint64_t Stats::YoungGCTimeNanos() const { return StatForSuffix(kYoungGCTimeSuffix); }
 
-uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix("gc.collector.1.time"); }
+uint64_t Stats::FullGCTimeNanos() const { return StatForSuffix(kFullGCTimeSuffix); }
 
-uint64_t Stats::UsedHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.used",
-      "gc.generation.0.space.1.used",
-      "gc.generation.0.space.2.used",
-      "gc.generation.1.space.0.used",
-  });
-}
+uint64_t Stats::UsedHeapSizeBytes() const { return SumStatsForSuffixes(kUsedHeapSizeSuffixes); }
 
-uint64_t Stats::TotalHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.space.0.capacity",
-      "gc.generation.0.space.1.capacity",
-      "gc.generation.0.space.2.capacity",
-      "gc.generation.1.space.0.capacity",
-  });
-}
+uint64_t Stats::TotalHeapSizeBytes() const { return SumStatsForSuffixes(kTotalHeapSizeSuffixes); }
 
-uint64_t Stats::MaxHeapSizeBytes() const {
-  return SumStatsForSuffixes({
-      "gc.generation.0.maxCapacity",
-      "gc.generation.1.maxCapacity",
-  });
-}
+uint64_t Stats::MaxHeapSizeBytes() const { return SumStatsForSuffixes(kMaxHeapSizeSuffixes); }
 
 uint64_t Stats::StatForSuffix(std::string_view suffix) const {
   for (const auto& stat : stats_) {
@@ -96,7 +108,7 @@ uint64_t Stats::StatForSuffix(std::string_view suffix) const {
   return 0;
 }
 
-uint64_t Stats::SumStatsForSuffixes(const std::vector<std::string_view>& suffixes) const {
+uint64_t Stats::SumStatsForSuffixes(const ArrayView<std::string_view>& suffixes) const {
   uint64_t sum = 0;
   for (const auto& suffix : suffixes) {
     sum += StatForSuffix(suffix);
@@ -104,6 +116,106 @@ uint64_t Stats::SumStatsForSuffixes(const std::vector<std::string_view>& suffixe
   return sum;
 }
 
+StatusOr<std::unique_ptr<StatsReader>> StatsReader::Create(
+    const std::filesystem::path& hsperf_data_path) {
+  int fd = open(hsperf_data_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return error::Internal("Could not open $0: $1", hsperf_data_path.string(),
+                           std::strerror(errno));
+  }
+  DEFER(close(fd));
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return error::Internal("Could not stat $0: $1", hsperf_data_path.string(),
+                           std::strerror(errno));
+  }
+  if (static_cast<size_t>(st.st_size) < sizeof(hsperf::Prologue)) {
+    // The JVM creates the file before sizing it.
+    return error::ResourceUnavailable("File $0 is not initialized yet", hsperf_data_path.string());
+  }
+  // MAP_SHARED, so that the JVM's updates to the counters are visible.
+  void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    return error::Internal("Could not mmap $0: $1", hsperf_data_path.string(),
+                           std::strerror(errno));
+  }
+  auto reader =
+      std::unique_ptr<StatsReader>(new StatsReader(static_cast<const char*>(addr), st.st_size));
+  PL_RETURN_IF_ERROR(reader->LocateCounters());
+  return reader;
+}
+
+StatsReader::~StatsReader() { munmap(const_cast<char*>(data_), size_); }
+
+Status StatsReader::Refresh() {
+  const auto* prologue = reinterpret_cast<const hsperf::Prologue*>(data_);
+  if (prologue->num_entries == num_entries_) {
+    return Status::OK();
+  }
+  return LocateCounters();
+}
+
+Status StatsReader::LocateCounters() {
+  hsperf::HsperfData hsperf_data = {};
+  PL_RETURN_IF_ERROR(ParseHsperfData(std::string_view(data_, size_), &hsperf_data));
+  const std::vector<hsperf::DataEntry>& entries = hsperf_data.data_entries;
+
+  young_gc_time_ = CounterForSuffix(entries, kYoungGCTimeSuffix);
+  full_gc_time_ = CounterForSuffix(entries, kFullGCTimeSuffix);
+  auto locate = [&](const ArrayView<std::string_view>& suffixes, std::vector<const char*>* out) {
+    out->clear();
+    for (std::string_view suffix : suffixes) {
+      const char* counter = CounterForSuffix(entries, suffix);
+      if (counter != nullptr) {
+        out->push_back(counter);
+      }
+    }
+  };
+  locate(kUsedHeapSizeSuffixes, &used_heap_size_);
+  locate(kTotalHeapSizeSuffixes, &total_heap_size_);
+  locate(kMaxHeapSizeSuffixes, &max_heap_size_);
+
+  num_entries_ = hsperf_data.prologue->num_entries;
+  return Status::OK();
+}
+
+const char* StatsReader::CounterForSuffix(const std::vector<hsperf::DataEntry>& entries,
+                                          std::string_view suffix) const {
+  for (const auto& entry : entries) {
+    if (entry.header->data_type == static_cast<uint8_t>(hsperf::DataType::kLong) &&
+        entry.data.size() == sizeof(uint64_t) && absl::EndsWith(entry.name, suffix)) {
+      return entry.data.data();
+    }
+  }
+  return nullptr;
+}
+
+uint64_t StatsReader::CounterValue(const char* counter) {
+  if (counter == nullptr) {
+    return 0;
+  }
+  return LEndianBytesToInt<uint64_t>(std::string_view(counter, sizeof(uint64_t)));
+}
+
+uint64_t StatsReader::SumCounterValues(const std::vector<const char*>& counters) {
+  uint64_t sum = 0;
+  for (const char* counter : counters) {
+    sum += CounterValue(counter);
+  }
+  return sum;
+}
+
+uint64_t StatsReader::YoungGCTimeNanos() const { return CounterValue(young_gc_time_); }
+
+uint64_t StatsReader::FullGCTimeNanos() const { return CounterValue(full_gc_time_); }
+
+uint64_t StatsReader::UsedHeapSizeBytes() const { return SumCounterValues(used_heap_size_); }
+
+uint64_t StatsReader::TotalHeapSizeBytes() const { return SumCounterValues(total_heap_size_); }
+
+uint64_t StatsReader::MaxHeapSizeBytes() const { return SumCounterValues(max_heap_size_); }
+
 StatusOr<std::filesystem::path> HsperfdataPath(pid_t pid) {
   const system::Config& sysconfig = system::Config::GetInstance();
   const std::filesystem::path& host_path = sysconfig.host_path();
@@ -19,12 +19,16 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "src/common/base/mixins.h"
 #include "src/common/base/statusor.h"
+#include "src/common/base/types.h"
+#include "src/stirling/source_connectors/jvm_stats/utils/hsperfdata.h"
 
 namespace px {
 namespace stirling {
@@ -58,12 +62,61 @@ class Stats {
 
  private:
   uint64_t StatForSuffix(std::string_view suffix) const;
-  uint64_t SumStatsForSuffixes(const std::vector<std::string_view>& suffixes) const;
+  uint64_t SumStatsForSuffixes(const ArrayView<std::string_view>& suffixes) const;
 
   std::string hsperf_data_;
   std::vector<Stat> stats_;
 };
 
+/**
+ * StatsReader computes the same stats as Stats, for callers that sample a JVM repeatedly.
+ * It maps the hsperfdata file once, and locates the counters it reads once. The JVM updates the
+ * counters in place, so each read is just a load from the mapped file.
+ */
+class StatsReader : public NotCopyable {
+ public:
+  static StatusOr<std::unique_ptr<StatsReader>> Create(
+      const std::filesystem::path& hsperf_data_path);
+
+  ~StatsReader();
+
+  /**
+   * Locates the counters again if the JVM added entries to the file since they were last located.
+   */
+  Status Refresh();
+
+  uint64_t YoungGCTimeNanos() const;
+  uint64_t FullGCTimeNanos() const;
+  uint64_t UsedHeapSizeBytes() const;
+  uint64_t TotalHeapSizeBytes() const;
+  uint64_t MaxHeapSizeBytes() const;
+
+ private:
+  StatsReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  Status LocateCounters();
+
+  // Returns the first long counter whose name has the suffix, or nullptr if there is none.
+  const char* CounterForSuffix(const std::vector<hsperf::DataEntry>& entries,
+                               std::string_view suffix) const;
+
+  static uint64_t CounterValue(const char* counter);
+  static uint64_t SumCounterValues(const std::vector<const char*>& counters);
+
+  const char* data_;
+  size_t size_;
+
+  // The number of entries in the file when the counters were located.
+  uint32_t num_entries_ = 0;
+
+  // Pointers into the mapped file, at the values of the counters.
+  const char* young_gc_time_ = nullptr;
+  const char* full_gc_time_ = nullptr;
+  std::vector<const char*> used_heap_size_;
+  std::vector<const char*> total_heap_size_;
+  std::vector<const char*> max_heap_size_;
+};
+
 /**
  * Returns the path of the hsperfdata for a JVM process.
  */
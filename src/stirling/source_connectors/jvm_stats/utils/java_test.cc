@@ -22,12 +22,14 @@
 #include <gtest/gtest.h>
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <string_view>
 
 #include <absl/strings/match.h>
 
 #include "src/common/base/test_utils.h"
+#include "src/common/base/file.h"
 #include "src/common/exec/subprocess.h"
 #include "src/common/testing/test_environment.h"
 
@@ -59,6 +61,24 @@ TEST(StatsTest, CommonValues) {
   EXPECT_EQ(2, stats.MaxHeapSizeBytes());
 }
 
+// Tests that StatsReader computes the same values as Stats.
+TEST(StatsReaderTest, MatchesStats) {
+  const std::string hsperf_data_path =
+      testing::TestFilePath("src/stirling/source_connectors/jvm_stats/utils/test_hsperfdata");
+  ASSERT_OK_AND_ASSIGN(std::string hsperf_data, ReadFileToString(hsperf_data_path));
+  Stats stats(std::move(hsperf_data));
+  ASSERT_OK(stats.Parse());
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<StatsReader> reader, StatsReader::Create(hsperf_data_path));
+  ASSERT_OK(reader->Refresh());
+  EXPECT_EQ(stats.YoungGCTimeNanos(), reader->YoungGCTimeNanos());
+  EXPECT_EQ(stats.FullGCTimeNanos(), reader->FullGCTimeNanos());
+  EXPECT_EQ(stats.UsedHeapSizeBytes(), reader->UsedHeapSizeBytes());
+  EXPECT_EQ(stats.TotalHeapSizeBytes(), reader->TotalHeapSizeBytes());
+  EXPECT_EQ(stats.MaxHeapSizeBytes(), reader->MaxHeapSizeBytes());
+  EXPECT_GT(reader->MaxHeapSizeBytes(), 0);
+}
+
 TEST(HsperfdataPathTest, ResultIsAsExpected) {
   const char kClassPath[] = "src/stirling/source_connectors/jvm_stats/testing/HelloWorld.jar";
   const std::string class_path = testing::TestFilePath(kClassPath);
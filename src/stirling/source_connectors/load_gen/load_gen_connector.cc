@@ -0,0 +1,152 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/load_gen/load_gen_connector.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <absl/strings/substitute.h>
+
+DEFINE_double(stirling_load_gen_rows_per_sec,
+              gflags::DoubleFromEnv("PL_STIRLING_LOAD_GEN_ROWS_PER_SEC", 10000),
+              "The number of http_events rows that the load generator emits per second.");
+DEFINE_uint32(stirling_load_gen_num_upids,
+              gflags::Uint32FromEnv("PL_STIRLING_LOAD_GEN_NUM_UPIDS", 100),
+              "The number of distinct UPIDs, and remote endpoints, of the generated rows.");
+DEFINE_uint32(stirling_load_gen_num_paths,
+              gflags::Uint32FromEnv("PL_STIRLING_LOAD_GEN_NUM_PATHS", 1000),
+              "The number of distinct request paths of the generated rows.");
+DEFINE_uint32(stirling_load_gen_body_size_mean,
+              gflags::Uint32FromEnv("PL_STIRLING_LOAD_GEN_BODY_SIZE_MEAN", 128),
+              "The mean size in bytes of the request and response bodies of the generated rows.");
+DEFINE_uint32(stirling_load_gen_body_size_max,
+              gflags::Uint32FromEnv("PL_STIRLING_LOAD_GEN_BODY_SIZE_MAX", 512),
+              "The largest size in bytes of the request and response bodies of generated rows.");
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+// Weights of a Zipf distribution with exponent 1 over n values.
+std::vector<double> ZipfWeights(size_t n) {
+  std::vector<double> weights(std::max<size_t>(n, 1));
+  for (size_t i = 0; i < weights.size(); ++i) {
+    weights[i] = 1.0 / (i + 1);
+  }
+  return weights;
+}
+
+constexpr std::string_view kReqMethods[] = {"GET", "GET", "GET", "POST", "PUT", "DELETE"};
+constexpr std::string_view kReqHeaders =
+    R"({"Accept":"*/*","Content-Type":"application/json","Host":"load-gen","User-Agent":"px"})";
+constexpr std::string_view kRespHeaders =
+    R"({"Content-Type":"application/json","Server":"load-gen"})";
+
+}  // namespace
+
+Status LoadGenConnector::InitImpl() {
+  sampling_freq_mgr_.set_period(kSamplingPeriod);
+  push_freq_mgr_.set_period(kPushPeriod);
+
+  for (uint32_t i = 0; i < std::max<uint32_t>(FLAGS_stirling_load_gen_num_upids, 1); ++i) {
+    upids_.emplace_back(/*asid*/ 0, /*pid*/ 1000 + i, /*ts_ns*/ i);
+  }
+  for (uint32_t i = 0; i < std::max<uint32_t>(FLAGS_stirling_load_gen_num_paths, 1); ++i) {
+    paths_.push_back(absl::Substitute("/api/v1/service$0/resource/$1", i % 16, i));
+  }
+  std::vector<double> upid_weights = ZipfWeights(upids_.size());
+  upid_dist_ = std::discrete_distribution<size_t>(upid_weights.begin(), upid_weights.end());
+  std::vector<double> path_weights = ZipfWeights(paths_.size());
+  path_dist_ = std::discrete_distribution<size_t>(path_weights.begin(), path_weights.end());
+  body_size_dist_ = std::exponential_distribution<double>(
+      1.0 / std::max<uint32_t>(FLAGS_stirling_load_gen_body_size_mean, 1));
+
+  body_source_.resize(2 * FLAGS_stirling_load_gen_body_size_max + 1);
+  for (auto& c : body_source_) {
+    c = 'a' + rng_() % 26;
+  }
+
+  last_transfer_time_ = clock_();
+  return Status::OK();
+}
+
+void LoadGenConnector::TransferDataImpl(ConnectorContext* /* ctx */,
+                                        const std::vector<DataTable*>& data_tables) {
+  DCHECK_EQ(data_tables.size(), 1U);
+
+  auto now = clock_();
+  std::chrono::duration<double> elapsed = now - last_transfer_time_;
+  last_transfer_time_ = now;
+  double rows_due = rows_carried_over_ + elapsed.count() * FLAGS_stirling_load_gen_rows_per_sec;
+  auto num_records = static_cast<size_t>(rows_due);
+  rows_carried_over_ = rows_due - num_records;
+
+  if (data_tables[0] != nullptr) {
+    GenerateRecords(num_records, data_tables[0]);
+  }
+}
+
+void LoadGenConnector::GenerateRecords(size_t num_records, DataTable* data_table) {
+  const size_t max_body_size = FLAGS_stirling_load_gen_body_size_max;
+  auto body = [this, max_body_size]() {
+    auto size = std::min(static_cast<size_t>(body_size_dist_(rng_)), max_body_size);
+    return std::string(body_source_.substr(rng_() % (body_source_.size() - size), size));
+  };
+
+  // The records of a transfer are spread over the nanoseconds leading up to now.
+  const int64_t end_time = CurrentTimeNS();
+  for (size_t i = 0; i < num_records; ++i) {
+    const int64_t time = end_time - static_cast<int64_t>(num_records - i);
+    const size_t upid_idx = upid_dist_(rng_);
+    const int resp_status = rng_() % 100 < 2 ? 500 : (rng_() % 100 < 5 ? 404 : 200);
+    std::string req_body = body();
+    std::string resp_body = body();
+
+    DataTable::RecordBuilder<&kHTTPTable> r(data_table, time);
+    r.Append<r.ColIndex("time_")>(time);
+    r.Append<r.ColIndex("upid")>(upids_[upid_idx].value());
+    r.Append<r.ColIndex("remote_addr")>(absl::Substitute("10.0.$0.$1", upid_idx / 256,
+                                                          upid_idx % 256));
+    r.Append<r.ColIndex("remote_port")>(8080);
+    r.Append<r.ColIndex("trace_role")>(2);
+    r.Append<r.ColIndex("major_version")>(1);
+    r.Append<r.ColIndex("minor_version")>(1);
+    r.Append<r.ColIndex("content_type")>(static_cast<uint64_t>(HTTPContentType::kJSON));
+    r.Append<r.ColIndex("req_headers")>(std::string(kReqHeaders));
+    r.Append<r.ColIndex("req_method")>(std::string(kReqMethods[rng_() % std::size(kReqMethods)]));
+    r.Append<r.ColIndex("req_path")>(paths_[path_dist_(rng_)]);
+    r.Append<r.ColIndex("req_body_size")>(req_body.size());
+    r.Append<r.ColIndex("req_body")>(std::move(req_body));
+    r.Append<r.ColIndex("resp_headers")>(std::string(kRespHeaders));
+    r.Append<r.ColIndex("resp_status")>(resp_status);
+    r.Append<r.ColIndex("resp_message")>(resp_status == 200 ? "OK" : "Error");
+    r.Append<r.ColIndex("resp_body_size")>(resp_body.size());
+    r.Append<r.ColIndex("resp_body")>(std::move(resp_body));
+    r.Append<r.ColIndex("latency")>(static_cast<int64_t>(10'000 + rng_() % 50'000'000));
+    r.Append<r.ColIndex("sample_rate")>(1.0);
+#ifndef NDEBUG
+    r.Append<r.ColIndex("px_info_")>("");
+#endif
+  }
+  num_rows_generated_ += num_records;
+}
+
+}  // namespace stirling
+}  // namespace px
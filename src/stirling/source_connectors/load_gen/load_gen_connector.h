@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/shared/upid/upid.h"
+#include "src/stirling/core/source_connector.h"
+#include "src/stirling/source_connectors/socket_tracer/http_table.h"
+
+DECLARE_double(stirling_load_gen_rows_per_sec);
+DECLARE_uint32(stirling_load_gen_num_upids);
+DECLARE_uint32(stirling_load_gen_num_paths);
+DECLARE_uint32(stirling_load_gen_body_size_mean);
+DECLARE_uint32(stirling_load_gen_body_size_max);
+
+namespace px {
+namespace stirling {
+
+/**
+ * LoadGenConnector generates synthetic HTTP events into the http_events table, at a configured
+ * rate of rows per second, to load test the agent's pipeline without real traffic.
+ *
+ * The UPIDs and request paths are drawn from Zipf distributions over a configured number of
+ * distinct values, like the few busy services and endpoints of a real cluster, and the body sizes
+ * are exponentially distributed. Must not run with the SocketTraceConnector, which owns the
+ * http_events table.
+ */
+class LoadGenConnector : public SourceConnector {
+ public:
+  static constexpr std::string_view kName = "load_gen";
+  static constexpr auto kSamplingPeriod = std::chrono::milliseconds{100};
+  static constexpr auto kPushPeriod = std::chrono::milliseconds{1000};
+  static constexpr auto kTables = MakeArray(kHTTPTable);
+
+  using Clock = std::function<std::chrono::steady_clock::time_point()>;
+
+  LoadGenConnector() = delete;
+  ~LoadGenConnector() override = default;
+
+  static std::unique_ptr<SourceConnector> Create(std::string_view name) {
+    return std::unique_ptr<SourceConnector>(
+        new LoadGenConnector(name, &std::chrono::steady_clock::now));
+  }
+
+  Status InitImpl() override;
+  Status StopImpl() override { return Status::OK(); }
+  void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+
+  uint64_t num_rows_generated() const { return num_rows_generated_; }
+
+ protected:
+  LoadGenConnector(std::string_view name, Clock clock)
+      : SourceConnector(name, kTables), clock_(std::move(clock)), rng_(37) {}
+
+ private:
+  void GenerateRecords(size_t num_records, DataTable* data_table);
+
+  Clock clock_;
+  std::chrono::steady_clock::time_point last_transfer_time_;
+  // The fraction of a row that was due, but not generated, by the previous transfer.
+  double rows_carried_over_ = 0;
+  uint64_t num_rows_generated_ = 0;
+
+  std::mt19937_64 rng_;
+  std::vector<md::UPID> upids_;
+  std::vector<std::string> paths_;
+  std::discrete_distribution<size_t> upid_dist_;
+  std::discrete_distribution<size_t> path_dist_;
+  std::exponential_distribution<double> body_size_dist_;
+  // Bodies are substrings of this, so that they don't have to be generated per row.
+  std::string body_source_;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/load_gen/load_gen_connector.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "src/common/testing/testing.h"
+#include "src/stirling/core/connector_context.h"
+
+namespace px {
+namespace stirling {
+
+class TestLoadGenConnector : public LoadGenConnector {
+ public:
+  explicit TestLoadGenConnector(const std::chrono::steady_clock::time_point* now)
+      : LoadGenConnector("load_gen", [now]() { return *now; }) {}
+};
+
+class LoadGenConnectorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    FLAGS_stirling_load_gen_rows_per_sec = 1000;
+    FLAGS_stirling_load_gen_num_paths = 10;
+    connector_ = std::make_unique<TestLoadGenConnector>(&now_);
+    ASSERT_OK(connector_->Init());
+  }
+
+  void TearDown() override { EXPECT_OK(connector_->Stop()); }
+
+  size_t Transfer(std::chrono::milliseconds elapsed) {
+    now_ += elapsed;
+    connector_->TransferData(&ctx_, data_tables_);
+    size_t num_rows = 0;
+    for (const auto& tablet : data_table_.ConsumeRecords()) {
+      num_rows += tablet.records[0]->Size();
+      for (size_t i = 0; i < tablet.records[0]->Size(); ++i) {
+        paths_.insert(tablet.records[kHTTPReqPathIdx]->Get<types::StringValue>(i));
+      }
+    }
+    return num_rows;
+  }
+
+  std::chrono::steady_clock::time_point now_;
+  StandaloneContext ctx_;
+  std::unique_ptr<LoadGenConnector> connector_;
+  DataTable data_table_{/*id*/ 0, kHTTPTable};
+  const std::vector<DataTable*> data_tables_{&data_table_};
+  absl::flat_hash_set<std::string> paths_;
+};
+
+TEST_F(LoadGenConnectorTest, GeneratesRowsAtRate) {
+  EXPECT_EQ(Transfer(std::chrono::milliseconds{100}), 100);
+  EXPECT_EQ(Transfer(std::chrono::milliseconds{1000}), 1000);
+  // Fractions of rows are carried over to the next transfer.
+  EXPECT_EQ(Transfer(std::chrono::microseconds{1500}), 1);
+  EXPECT_EQ(Transfer(std::chrono::microseconds{1500}), 2);
+  EXPECT_EQ(connector_->num_rows_generated(), 1103);
+
+  EXPECT_LE(paths_.size(), 10);
+  EXPECT_GT(paths_.size(), 1);
+}
+
+}  // namespace stirling
+}  // namespace px
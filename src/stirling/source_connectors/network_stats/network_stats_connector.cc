@@ -18,14 +18,29 @@
 
 #include "src/stirling/source_connectors/network_stats/network_stats_connector.h"
 
+#include <sys/stat.h>
+
 #include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
 
 #include "src/common/base/base.h"
 #include "src/common/system/proc_parser.h"
 #include "src/shared/metadata/metadata.h"
+#include "src/stirling/bpf_tools/macros.h"
+
+BPF_SRC_STRVIEW(cgroup_skb_counters_bcc_script, cgroup_skb_counters);
+
+DEFINE_bool(stirling_network_stats_bpf,
+            gflags::BoolFromEnv("PL_STIRLING_NETWORK_STATS_BPF", false),
+            "Whether to count the traffic of each pod with cgroup skb programs, instead of reading "
+            "/proc/<pid>/net/dev. Requires cgroup v2.");
 
 namespace px {
 namespace stirling {
@@ -35,16 +50,48 @@ using system::ProcParser;
 Status NetworkStatsConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
+  if (FLAGS_stirling_network_stats_bpf) {
+    Status s = InitBPF();
+    if (!s.ok()) {
+      LOG(WARNING) << absl::Substitute(
+          "Failed to count network stats in BPF, falling back to /proc. [msg=$0]", s.msg());
+    }
+  }
   return Status::OK();
 }
 
-Status NetworkStatsConnector::StopImpl() { return Status::OK(); }
+Status NetworkStatsConnector::InitBPF() {
+  auto bcc = std::make_unique<bpf_tools::BCCWrapper>();
+  PL_RETURN_IF_ERROR(bcc->InitBPFProgram(cgroup_skb_counters_bcc_script, /*cflags*/ {},
+                                         /*requires_linux_headers*/ false));
+
+  const std::filesystem::path cgroup_root = sysconfig_.sysfs_path() / "fs/cgroup";
+  const bpf_tools::CGroupProgramSpec kCGroupPrograms[] = {
+      {cgroup_root, BPF_CGROUP_INET_INGRESS, "cgroup_skb_ingress"},
+      {cgroup_root, BPF_CGROUP_INET_EGRESS, "cgroup_skb_egress"},
+  };
+  PL_RETURN_IF_ERROR(bcc->AttachCGroupPrograms(kCGroupPrograms));
+  bcc_ = std::move(bcc);
+  return Status::OK();
+}
+
+Status NetworkStatsConnector::StopImpl() {
+  if (bcc_ != nullptr) {
+    bcc_->Close();
+  }
+  return Status::OK();
+}
 
 void NetworkStatsConnector::TransferDataImpl(ConnectorContext* ctx,
                                              const std::vector<DataTable*>& data_tables) {
   DCHECK_EQ(data_tables.size(), 1) << "NetworkStatsConnector only has one data table.";
 
-  if (data_tables[kNetStatsTableNum] != nullptr) {
+  if (data_tables[kNetStatsTableNum] == nullptr) {
+    return;
+  }
+  if (bcc_ != nullptr) {
+    TransferBPFNetworkStatsTable(ctx, data_tables[kNetStatsTableNum]);
+  } else {
     TransferNetworkStatsTable(ctx, data_tables[kNetStatsTableNum]);
   }
 }
@@ -87,6 +134,116 @@ void NetworkStatsConnector::TransferNetworkStatsTable(ConnectorContext* ctx,
   }
 }
 
+StatusOr<uint64_t> NetworkStatsConnector::CGroupID(const md::ContainerInfo& container_info) const {
+  // All the processes of a container are in the same cgroup, so any of them will do.
+  for (const auto& upid : container_info.active_upids()) {
+    auto cgroups_or = proc_parser_->GetPIDCGroups(upid.pid());
+    if (!cgroups_or.ok()) {
+      continue;
+    }
+    // The cgroup v2 hierarchy is the line with id 0, e.g. "0::/kubepods.slice/...".
+    for (std::string_view line : absl::StrSplit(cgroups_or.ValueOrDie(), '\n')) {
+      if (!absl::StartsWith(line, "0::")) {
+        continue;
+      }
+      std::filesystem::path cgroup_path = sysconfig_.sysfs_path() / "fs/cgroup";
+      cgroup_path += line.substr(3);
+      struct stat st;
+      if (stat(cgroup_path.c_str(), &st) != 0) {
+        return error::Internal("Failed to stat cgroup $0", cgroup_path.string());
+      }
+      return static_cast<uint64_t>(st.st_ino);
+    }
+    return error::NotFound("Container $0 is not in a cgroup v2 hierarchy", container_info.cid());
+  }
+  return error::NotFound("No running process of container $0", container_info.cid());
+}
+
+void NetworkStatsConnector::TransferBPFNetworkStatsTable(ConnectorContext* ctx,
+                                                         DataTable* data_table) {
+  const md::K8sMetadataState& k8s_md = ctx->GetK8SMetadata();
+
+  auto table =
+      bcc_->GetPerCPUHashTable<uint64_t, struct cgroup_net_stats_t>("cgroup_net_stats");
+  absl::flat_hash_map<uint64_t, struct cgroup_net_stats_t> stats_by_cgroup_id;
+  for (const auto& [cgroup_id, per_cpu_stats] : table.get_table_offline()) {
+    struct cgroup_net_stats_t& stats = stats_by_cgroup_id[cgroup_id];
+    for (const auto& cpu_stats : per_cpu_stats) {
+      stats.rx_bytes += cpu_stats.rx_bytes;
+      stats.rx_packets += cpu_stats.rx_packets;
+      stats.tx_bytes += cpu_stats.tx_bytes;
+      stats.tx_packets += cpu_stats.tx_packets;
+    }
+  }
+
+  int64_t timestamp = CurrentTimeNS();
+
+  // Only the cgroup ids of the containers of running pods are kept, so that the counters of
+  // containers that have exited stay in their pod's totals until the pod stops.
+  absl::flat_hash_map<md::CID, uint64_t> cgroup_id_by_cid;
+  for (const auto& [pod_name, pod_id] : k8s_md.pods_by_name()) {
+    PL_UNUSED(pod_name);
+
+    auto* pod_info = k8s_md.PodInfoByID(pod_id);
+    if (pod_info == nullptr || pod_info->stop_time_ns() > 0) {
+      continue;
+    }
+
+    struct cgroup_net_stats_t pod_stats = {};
+    for (const auto& cid : pod_info->containers()) {
+      auto it = cgroup_id_by_cid_.find(cid);
+      if (it == cgroup_id_by_cid_.end()) {
+        auto* container_info = k8s_md.ContainerInfoByID(cid);
+        if (container_info == nullptr) {
+          continue;
+        }
+        auto cgroup_id_or = CGroupID(*container_info);
+        if (!cgroup_id_or.ok()) {
+          VLOG(1) << cgroup_id_or.msg();
+          continue;
+        }
+        it = cgroup_id_by_cid_.emplace(cid, cgroup_id_or.ValueOrDie()).first;
+      }
+      cgroup_id_by_cid.insert(*it);
+
+      auto stats_it = stats_by_cgroup_id.find(it->second);
+      if (stats_it == stats_by_cgroup_id.end()) {
+        continue;
+      }
+      pod_stats.rx_bytes += stats_it->second.rx_bytes;
+      pod_stats.rx_packets += stats_it->second.rx_packets;
+      pod_stats.tx_bytes += stats_it->second.tx_bytes;
+      pod_stats.tx_packets += stats_it->second.tx_packets;
+    }
+
+    DataTable::RecordBuilder<&kNetworkStatsTable> r(data_table, timestamp);
+
+    r.Append<r.ColIndex("time_")>(timestamp);
+    r.Append<r.ColIndex("pod_id")>(std::string(pod_id));
+    r.Append<r.ColIndex("rx_bytes")>(static_cast<int64_t>(pod_stats.rx_bytes));
+    r.Append<r.ColIndex("rx_packets")>(static_cast<int64_t>(pod_stats.rx_packets));
+    // The cgroup skb programs only see the packets that reach a socket.
+    r.Append<r.ColIndex("rx_errors")>(0);
+    r.Append<r.ColIndex("rx_drops")>(0);
+    r.Append<r.ColIndex("tx_bytes")>(static_cast<int64_t>(pod_stats.tx_bytes));
+    r.Append<r.ColIndex("tx_packets")>(static_cast<int64_t>(pod_stats.tx_packets));
+    r.Append<r.ColIndex("tx_errors")>(0);
+    r.Append<r.ColIndex("tx_drops")>(0);
+  }
+  cgroup_id_by_cid_ = std::move(cgroup_id_by_cid);
+
+  // Free the counters of the cgroups that don't belong to a running pod.
+  absl::flat_hash_set<uint64_t> pod_cgroup_ids;
+  for (const auto& [cid, cgroup_id] : cgroup_id_by_cid_) {
+    pod_cgroup_ids.insert(cgroup_id);
+  }
+  for (const auto& [cgroup_id, stats] : stats_by_cgroup_id) {
+    if (!pod_cgroup_ids.contains(cgroup_id)) {
+      table.remove_value(cgroup_id);
+    }
+  }
+}
+
 Status NetworkStatsConnector::GetNetworkStatsForPod(const system::ProcParser& proc_parser,
                                                     const md::PodInfo& pod_info,
                                                     const md::K8sMetadataState& k8s_metadata_state,
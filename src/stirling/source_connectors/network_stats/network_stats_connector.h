@@ -24,13 +24,19 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/common/base/base.h"
 #include "src/common/system/system.h"
 #include "src/shared/metadata/metadata.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/core/canonical_types.h"
 #include "src/stirling/core/source_connector.h"
+#include "src/stirling/source_connectors/network_stats/bcc_bpf_intf/cgroup_net_stats.h"
 #include "src/stirling/source_connectors/network_stats/network_stats_table.h"
 
+DECLARE_bool(stirling_network_stats_bpf);
+
 namespace px {
 namespace stirling {
 
@@ -50,6 +56,7 @@ class NetworkStatsConnector : public SourceConnector {
   }
 
   Status InitImpl() override;
+  bool UsesBPF() const override { return FLAGS_stirling_network_stats_bpf; }
 
   Status StopImpl() override;
 
@@ -64,12 +71,23 @@ class NetworkStatsConnector : public SourceConnector {
  private:
   void TransferNetworkStatsTable(ConnectorContext* ctx, DataTable* data_table);
 
+  // Counts the traffic of every pod with cgroup skb programs attached to the cgroup v2 root.
+  Status InitBPF();
+  void TransferBPFNetworkStatsTable(ConnectorContext* ctx, DataTable* data_table);
+  // Returns the cgroup id of the container, which is the inode number of its cgroup v2 directory.
+  StatusOr<uint64_t> CGroupID(const md::ContainerInfo& container_info) const;
+
   static Status GetNetworkStatsForPod(const system::ProcParser& proc_parser,
                                       const md::PodInfo& pod_info,
                                       const md::K8sMetadataState& k8s_metadata_state,
                                       system::ProcParser::NetworkStats* stats);
 
   std::unique_ptr<system::ProcParser> proc_parser_;
+
+  // Set when the stats are counted in BPF, instead of read from /proc/<pid>/net/dev.
+  std::unique_ptr<bpf_tools::BCCWrapper> bcc_;
+  // The cgroup ids of the containers of the running pods.
+  absl::flat_hash_map<md::CID, uint64_t> cgroup_id_by_cid_;
 };
 
 }  // namespace stirling
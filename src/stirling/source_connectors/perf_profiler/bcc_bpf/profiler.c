@@ -89,6 +89,65 @@ BPF_STACK_TRACE(stack_traces_b, kNumMapEntries);
 // See comments in shared header file "stack_event.h".
 BPF_ARRAY(profiler_state, uint64_t, kProfilerStateVectorSize);
 
+// Targeted profiling sessions sample the processes in targeted_upids (tgid => start_time_ticks)
+// more often than sample_call_stack does, for a limited time. User space only attaches
+// sample_targeted_call_stack for the duration of a session. The samples go to their own maps,
+// double buffered like the ones above, because their number depends on the session's sampling
+// period; the stack traces are deduplicated, so kNumTargetedMapEntries bounds the distinct
+// stack traces per transfer period, not the samples.
+static const uint32_t kNumTargetedMapEntries = 16384;
+
+BPF_HASH(targeted_upids, uint32_t, uint64_t, kMaxTargetedUPIDs);
+BPF_PERF_OUTPUT(targeted_histogram_a);
+BPF_PERF_OUTPUT(targeted_histogram_b);
+BPF_STACK_TRACE(targeted_stack_traces_a, kNumTargetedMapEntries);
+BPF_STACK_TRACE(targeted_stack_traces_b, kNumTargetedMapEntries);
+
+#if UNWIND_USER_STACKS
+// For binaries without frame pointers, get_stackid() can't walk the user stack. Instead,
+// the registers and the top of the stack are sent to user space, which unwinds them with the
+// call frame information of the binaries. User space reads them more often than the histograms,
+// so none of this is double buffered.
+BPF_PERCPU_ARRAY(user_stack_snapshot_scratch, struct user_stack_snapshot_t, 1);
+BPF_PERF_OUTPUT(user_stack_snapshots);
+
+// The reads of the stack that are tried, halving the size each time, for when the stack ends
+// less than kUserStackSnapshotBytes above the stack pointer.
+#define NUM_USER_STACK_READS 5
+
+// Returns true if a snapshot of the user stack was sent to user space.
+static __inline bool submit_user_stack_snapshot(struct bpf_perf_event_data* ctx,
+                                                const struct stack_trace_key_t* key) {
+  // Only samples taken in user mode have the user registers in ctx->regs.
+  if ((ctx->regs.cs & 3) != 3) {
+    return false;
+  }
+
+  int kZero = 0;
+  struct user_stack_snapshot_t* snapshot = user_stack_snapshot_scratch.lookup(&kZero);
+  if (snapshot == NULL) {
+    return false;
+  }
+  snapshot->upid = key->upid;
+  snapshot->ip = ctx->regs.ip;
+  snapshot->sp = ctx->regs.sp;
+  snapshot->bp = ctx->regs.bp;
+
+  uint32_t size = kUserStackSnapshotBytes;
+#pragma unroll
+  for (int i = 0; i < NUM_USER_STACK_READS; ++i) {
+    if (bpf_probe_read(snapshot->stack, size, (void*)snapshot->sp) == 0) {
+      snapshot->stack_size = size;
+      user_stack_snapshots.perf_submit(ctx, snapshot,
+                                       offsetof(struct user_stack_snapshot_t, stack) + size);
+      return true;
+    }
+    size /= 2;
+  }
+  return false;
+}
+#endif
+
 int sample_call_stack(struct bpf_perf_event_data* ctx) {
   int transfer_count_idx = kTransferCountIdx;
   int sample_count_a_idx = kSampleCountAIdx;
@@ -116,6 +175,12 @@ int sample_call_stack(struct bpf_perf_event_data* ctx) {
 
   uint64_t sample_count = 0;
 
+#if UNWIND_USER_STACKS
+  if (submit_user_stack_snapshot(ctx, &key)) {
+    return 0;
+  }
+#endif
+
   if (transfer_count % 2 == 0) {
     // map set A branch:
     key.user_stack_id = stack_traces_a.get_stackid(&ctx->regs, BPF_F_USER_STACK);
@@ -145,3 +210,42 @@ int sample_call_stack(struct bpf_perf_event_data* ctx) {
 
   return 0;
 }
+
+int sample_targeted_call_stack(struct bpf_perf_event_data* ctx) {
+  uint32_t tgid = bpf_get_current_pid_tgid() >> 32;
+  uint64_t* start_time_ticks = targeted_upids.lookup(&tgid);
+  if (start_time_ticks == NULL) {
+    return 0;
+  }
+
+  struct stack_trace_key_t key = {};
+  key.upid.tgid = tgid;
+  key.upid.start_time_ticks = get_tgid_start_time();
+
+  // The pid was reused by another process.
+  if (key.upid.start_time_ticks != *start_time_ticks) {
+    return 0;
+  }
+
+  int transfer_count_idx = kTransferCountIdx;
+  uint64_t* transfer_count_ptr = profiler_state.lookup(&transfer_count_idx);
+  if (transfer_count_ptr == NULL) {
+    int error_status_idx = kErrorStatusIdx;
+    uint64_t rd_fail_status_code = kMapReadFailureError;
+    profiler_state.update(&error_status_idx, &rd_fail_status_code);
+    return 0;
+  }
+
+  // Switches maps along with sample_call_stack.
+  if (*transfer_count_ptr % 2 == 0) {
+    key.user_stack_id = targeted_stack_traces_a.get_stackid(&ctx->regs, BPF_F_USER_STACK);
+    key.kernel_stack_id = targeted_stack_traces_a.get_stackid(&ctx->regs, 0);
+    targeted_histogram_a.perf_submit(ctx, &key, sizeof(key));
+  } else {
+    key.user_stack_id = targeted_stack_traces_b.get_stackid(&ctx->regs, BPF_F_USER_STACK);
+    key.kernel_stack_id = targeted_stack_traces_b.get_stackid(&ctx->regs, 0);
+    targeted_histogram_b.perf_submit(ctx, &key, sizeof(key));
+  }
+
+  return 0;
+}
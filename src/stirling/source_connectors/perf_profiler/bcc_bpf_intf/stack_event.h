@@ -34,6 +34,9 @@ static const uint32_t kSampleCountBIdx = 2;
 static const uint32_t kErrorStatusIdx = 3;
 static const uint32_t kProfilerStateVectorSize = 4;
 
+// The most processes that a targeted profiling session samples, see sample_targeted_call_stack.
+static const uint32_t kMaxTargetedUPIDs = 256;
+
 // stack_trace_key_t indexes into the stack-trace histogram.
 // By tying together the user & kernel stack-trace-ids [1],
 // it fully identifies a unique stack trace.
@@ -50,6 +53,26 @@ struct stack_trace_key_t {
   int kernel_stack_id;
 };
 
+// The number of bytes of the user stack, from the stack pointer up, that are copied for each
+// sample when unwinding in user space (see UserStackUnwinder). Same default as perf's
+// --call-graph=dwarf. A power of 2, as BPF tries smaller reads at the top of the stack.
+static const uint32_t kUserStackSnapshotBytes = 8192;
+
+// A sample for which the user stack is unwound in user space, instead of with the frame pointers
+// by the kernel: the registers needed to unwind, and a snapshot of the top of the stack.
+struct user_stack_snapshot_t {
+  // The samples are taken in user mode, so there's no kernel stack.
+  struct upid_t upid;
+
+  uint64_t ip;
+  uint64_t sp;
+  uint64_t bp;
+
+  // The number of bytes in stack, that were copied from sp up.
+  uint32_t stack_size;
+  uint8_t stack[kUserStackSnapshotBytes];
+};
+
 // Bit positions in the error status bitfield:
 static const uint32_t kOverflowBitPos = 0;
 static const uint32_t kMapReadFailureBitPos = 1;
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/perf_map.h"
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_split.h>
+#include <absl/strings/strip.h>
+#include <absl/strings/substitute.h>
+
+#include "src/common/system/config.h"
+
+namespace px {
+namespace stirling {
+
+StatusOr<std::filesystem::path> PerfMap::PathOfPID(uint32_t pid) {
+  const std::filesystem::path proc_pid_path =
+      system::Config::GetInstance().proc_path() / std::to_string(pid);
+
+  // The process names the file after its pid in its own pid namespace, the last of the NSpid
+  // line of its status.
+  PL_ASSIGN_OR_RETURN(std::string status, ReadFileToString(proc_pid_path / "status"));
+  uint32_t ns_pid = 0;
+  for (std::string_view line : absl::StrSplit(status, '\n')) {
+    if (!absl::ConsumePrefix(&line, "NSpid:")) {
+      continue;
+    }
+    std::vector<std::string_view> pids = absl::StrSplit(line, '\t', absl::SkipWhitespace());
+    if (pids.empty() || !absl::SimpleAtoi(pids.back(), &ns_pid)) {
+      return error::Internal("Malformed NSpid line of pid $0.", pid);
+    }
+  }
+  if (ns_pid == 0) {
+    // Kernels before 4.1 have no NSpid, and neither pid namespaces to speak of for containers.
+    ns_pid = pid;
+  }
+
+  return proc_pid_path / "root" / "tmp" / absl::StrCat("perf-", ns_pid, ".map");
+}
+
+Status PerfMap::Refresh() {
+  std::ifstream file(path_, std::ios::binary);
+  if (!file.good()) {
+    return error::NotFound("Could not open $0.", path_.string());
+  }
+
+  file.seekg(0, std::ios::end);
+  const uint64_t file_size = file.tellg();
+  if (file_size < read_offset_) {
+    // The file was rewritten, e.g. by a new process with the same pid.
+    entries_.clear();
+    read_offset_ = 0;
+  }
+  if (file_size == read_offset_) {
+    return Status::OK();
+  }
+
+  std::string contents(file_size - read_offset_, '\0');
+  file.seekg(read_offset_);
+  file.read(contents.data(), contents.size());
+  contents.resize(file.gcount());
+
+  // A line that is still being written is read on the next refresh.
+  const size_t end = contents.rfind('\n');
+  if (end == std::string::npos) {
+    return Status::OK();
+  }
+  read_offset_ += end + 1;
+
+  // Each line is: <start address> <size> <symbol>, with the numbers in hex.
+  for (std::string_view line :
+       absl::StrSplit(std::string_view(contents).substr(0, end), '\n', absl::SkipEmpty())) {
+    std::vector<std::string_view> fields = absl::StrSplit(line, absl::MaxSplits(' ', 2));
+    uint64_t start = 0;
+    uint64_t size = 0;
+    if (fields.size() != 3 || !absl::SimpleHexAtoi(fields[0], &start) ||
+        !absl::SimpleHexAtoi(fields[1], &size) || size == 0) {
+      VLOG(1) << absl::Substitute("Malformed line in $0: $1", path_.string(), line);
+      continue;
+    }
+    Insert(start, size, std::string(fields[2]));
+  }
+  return Status::OK();
+}
+
+void PerfMap::Insert(uint64_t start, uint64_t size, std::string symbol) {
+  const uint64_t end = start + size;
+
+  // Remove the entries that the new one overlaps, including one that starts before it.
+  auto iter = entries_.lower_bound(start);
+  if (iter != entries_.begin() && std::prev(iter)->second.end > start) {
+    --iter;
+  }
+  while (iter != entries_.end() && iter->first < end) {
+    iter = entries_.erase(iter);
+  }
+
+  entries_.emplace(start, Entry{end, std::move(symbol)});
+}
+
+const std::string* PerfMap::Lookup(uint64_t addr) const {
+  auto iter = entries_.upper_bound(addr);
+  if (iter == entries_.begin()) {
+    return nullptr;
+  }
+  --iter;
+  return addr < iter->second.end ? &iter->second.symbol : nullptr;
+}
+
+}  // namespace stirling
+}  // namespace px
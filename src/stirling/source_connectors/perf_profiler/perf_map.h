@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * The symbols of the JIT code of a process, from the /tmp/perf-<pid>.map file that runtimes such
+ * as the JVM (with perf-map-agent) and Node (with --perf-basic-prof) write for perf.
+ *
+ * The runtimes only append to the file, so each Refresh() reads just the lines added since the
+ * previous one, instead of the whole file.
+ */
+class PerfMap {
+ public:
+  explicit PerfMap(std::filesystem::path path) : path_(std::move(path)) {}
+
+  /**
+   * Returns the path of the perf map of the process, as seen from the host.
+   */
+  static StatusOr<std::filesystem::path> PathOfPID(uint32_t pid);
+
+  /**
+   * Reads the entries appended to the file since the previous call.
+   */
+  Status Refresh();
+
+  /**
+   * Returns the symbol of the code at the address, or nullptr if it's not in the map.
+   */
+  const std::string* Lookup(uint64_t addr) const;
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    uint64_t end;
+    std::string symbol;
+  };
+
+  void Insert(uint64_t start, uint64_t size, std::string symbol);
+
+  const std::filesystem::path path_;
+
+  // How far the file has been read, always at the start of a line.
+  uint64_t read_offset_ = 0;
+
+  // By start address. JIT code is recompiled into reused memory, so later entries replace the
+  // earlier ones that they overlap, and the entries never overlap.
+  std::map<uint64_t, Entry> entries_;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/perf_map.h"
+
+#include <fstream>
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+class PerfMapTest : public ::testing::Test {
+ protected:
+  void SetUp() override { path_ = std::filesystem::path(::testing::TempDir()) / "perf-1.map"; }
+
+  void Append(std::string_view lines) {
+    std::ofstream file(path_, std::ios::app);
+    file << lines;
+  }
+
+  std::filesystem::path path_;
+};
+
+TEST_F(PerfMapTest, ReadsAppendedEntries) {
+  std::filesystem::remove(path_);
+  PerfMap perf_map(path_);
+  EXPECT_NOT_OK(perf_map.Refresh());
+
+  Append("7f0000001000 100 LFoo;::bar\n7f0000002000 80 Interpreter\n7f00000030");
+  ASSERT_OK(perf_map.Refresh());
+  EXPECT_EQ(perf_map.size(), 2);
+  EXPECT_EQ(*perf_map.Lookup(0x7f0000001000), "LFoo;::bar");
+  EXPECT_EQ(*perf_map.Lookup(0x7f00000010ff), "LFoo;::bar");
+  EXPECT_EQ(perf_map.Lookup(0x7f0000001100), nullptr);
+  EXPECT_EQ(*perf_map.Lookup(0x7f0000002010), "Interpreter");
+  EXPECT_EQ(perf_map.Lookup(0x7f0000000fff), nullptr);
+
+  // The partial line is read once it's complete. Recompiled code replaces what it overlaps.
+  Append("00 40 LBaz;::qux\n7f0000001080 100 LFoo;::bar2\n");
+  ASSERT_OK(perf_map.Refresh());
+  EXPECT_EQ(perf_map.size(), 3);
+  EXPECT_EQ(*perf_map.Lookup(0x7f0000003010), "LBaz;::qux");
+  EXPECT_EQ(perf_map.Lookup(0x7f0000001000), nullptr);
+  EXPECT_EQ(*perf_map.Lookup(0x7f0000001100), "LFoo;::bar2");
+
+  // A rewritten file is read from the start.
+  std::filesystem::remove(path_);
+  Append("1000 10 LNew;::fn\n");
+  ASSERT_OK(perf_map.Refresh());
+  EXPECT_EQ(perf_map.size(), 1);
+  EXPECT_EQ(*perf_map.Lookup(0x1008), "LNew;::fn");
+}
+
+}  // namespace stirling
+}  // namespace px
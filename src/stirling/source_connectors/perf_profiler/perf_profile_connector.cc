@@ -19,7 +19,9 @@
 #include "src/stirling/source_connectors/perf_profiler/perf_profile_connector.h"
 
 #include <sys/sysinfo.h>
+#include <unistd.h>
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
@@ -33,6 +35,24 @@ DEFINE_string(stirling_profiler_symbolizer, "bcc",
               "Choice of which symbolizer to use. Options: bcc, elf");
 DEFINE_bool(stirling_profiler_cache_symbols, true, "Whether to cache symbols");
 
+DEFINE_bool(stirling_profiler_unwind_user_stacks, false,
+            "Whether to unwind the user stacks in user space, from a snapshot of the stack, with "
+            "the call frame information of the binaries, instead of with the frame pointers in "
+            "BPF. For binaries built without frame pointers.");
+DEFINE_uint32(stirling_profiler_unwind_budget_ms, 300,
+              "CPU time spent unwinding user stacks per iteration of the profiler, past which the "
+              "samples of the iteration keep only their innermost frame.");
+
+DEFINE_bool(stirling_profiler_elide_repeated_stack_traces, true,
+            "Whether to leave the stack_trace column empty for a stack trace ID whose string was "
+            "already emitted since the ID cache last aged. The table store resolves the empty "
+            "strings by ID, see Table::EnableStringDictionary().");
+
+DEFINE_bool(stirling_profiler_self_profile,
+            gflags::BoolFromEnv("PL_STIRLING_PROFILER_SELF_PROFILE", true),
+            "Whether to publish the sampled stack traces of the agent itself to the "
+            "px_agent_self_profile table.");
+
 DEFINE_uint32(stirling_perf_profiler_stats_logging_ratio,
               std::chrono::minutes(10) / px::stirling::PerfProfileConnector::kSamplingPeriod,
               "Sets the frequency of printing perf profiler stats.");
@@ -41,11 +61,16 @@ namespace px {
 namespace stirling {
 
 PerfProfileConnector::PerfProfileConnector(std::string_view source_name)
-    : SourceConnector(source_name, kTables) {}
+    : SourceConnector(source_name, kTables), self_pid_(getpid()) {}
 
 Status PerfProfileConnector::InitImpl() {
-  sampling_freq_mgr_.set_period(kSamplingPeriod);
+  const bool unwind_user_stacks = FLAGS_stirling_profiler_unwind_user_stacks;
+
+  // The user stack snapshots and the samples of targeted sessions are drained more often than
+  // the stack traces are transferred, to bound the size of their perf buffers.
+  sampling_freq_mgr_.set_period(kPollPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
+  transfer_freq_mgr_.set_period(kSamplingPeriod);
 
   const size_t ncpus = get_nprocs_conf();
   VLOG(1) << "PerfProfiler: get_nprocs_conf(): " << ncpus;
@@ -53,11 +78,17 @@ Status PerfProfileConnector::InitImpl() {
   const std::vector<std::string> defines = {
       absl::Substitute("-DNCPUS=$0", ncpus),
       absl::Substitute("-DTRANSFER_PERIOD=$0", kSamplingPeriod.count()),
-      absl::Substitute("-DSAMPLE_PERIOD=$0", kBPFSamplingPeriod.count())};
+      absl::Substitute("-DSAMPLE_PERIOD=$0", kBPFSamplingPeriod.count()),
+      absl::Substitute("-DUNWIND_USER_STACKS=$0", static_cast<int>(unwind_user_stacks))};
 
   PL_RETURN_IF_ERROR(InitBPFProgram(profiler_bcc_script, defines));
   PL_RETURN_IF_ERROR(AttachSamplingProbes(kProbeSpecs));
   PL_RETURN_IF_ERROR(OpenPerfBuffers(kPerfBufferSpecs, this));
+  PL_RETURN_IF_ERROR(OpenPerfBuffers(kTargetedPerfBufferSpecs, this));
+  if (unwind_user_stacks) {
+    PL_RETURN_IF_ERROR(OpenPerfBuffers(kUserStackPerfBufferSpecs, this));
+    user_stacks_perf_buffer_ = GetPerfBuffer("user_stack_snapshots");
+  }
 
   stack_traces_a_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("stack_traces_a"));
   stack_traces_b_ = std::make_unique<ebpf::BPFStackTable>(GetStackTable("stack_traces_b"));
@@ -65,6 +96,15 @@ Status PerfProfileConnector::InitImpl() {
   histogram_a_perf_buffer_ = GetPerfBuffer("histogram_a");
   histogram_b_perf_buffer_ = GetPerfBuffer("histogram_b");
 
+  targeted_stack_traces_a_ =
+      std::make_unique<ebpf::BPFStackTable>(GetStackTable("targeted_stack_traces_a"));
+  targeted_stack_traces_b_ =
+      std::make_unique<ebpf::BPFStackTable>(GetStackTable("targeted_stack_traces_b"));
+  targeted_upids_ = std::make_unique<ebpf::BPFHashTable<uint32_t, uint64_t>>(
+      GetHashTable<uint32_t, uint64_t>("targeted_upids"));
+  targeted_histogram_a_perf_buffer_ = GetPerfBuffer("targeted_histogram_a");
+  targeted_histogram_b_perf_buffer_ = GetPerfBuffer("targeted_histogram_b");
+
   profiler_state_ =
       std::make_unique<ebpf::BPFArrayTable<uint64_t>>(GetArrayTable<uint64_t>("profiler_state"));
 
@@ -111,12 +151,56 @@ void PerfProfileConnector::HandleHistoEvent(void* cb_cookie, void* data, int /*d
   connector->AcceptStackTraceKey(histo_key_ptr);
 }
 
+void PerfProfileConnector::HandleTargetedHistoEvent(void* cb_cookie, void* data,
+                                                    int /*data_size*/) {
+  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
+  auto* connector = static_cast<PerfProfileConnector*>(cb_cookie);
+  connector->raw_targeted_histo_data_.push_back(*static_cast<stack_trace_key_t*>(data));
+}
+
 void PerfProfileConnector::HandleHistoLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
   auto* connector = static_cast<PerfProfileConnector*>(cb_cookie);
   connector->stats_.Increment(StatKey::kLossHistoEvent, lost);
 }
 
+void PerfProfileConnector::AcceptUserStackSnapshot(const user_stack_snapshot_t& snapshot) {
+  std::vector<uintptr_t> addrs;
+  if (unwind_time_ < std::chrono::milliseconds(FLAGS_stirling_profiler_unwind_budget_ms)) {
+    const auto start = std::chrono::steady_clock::now();
+    addrs = user_stack_unwinder_.Unwind(snapshot);
+    const auto unwind_time = std::chrono::steady_clock::now() - start;
+    unwind_time_ += unwind_time;
+    stats_.Increment(StatKey::kUnwoundUserStacks);
+    stats_.Increment(StatKey::kUnwindTimeUS,
+                     std::chrono::duration_cast<std::chrono::microseconds>(unwind_time).count());
+  } else {
+    // Over budget, only the sampled instruction is kept.
+    addrs.push_back(snapshot.ip);
+    stats_.Increment(StatKey::kUnwindOverBudget);
+  }
+  raw_user_stacks_.push_back({snapshot.upid, std::move(addrs)});
+}
+
+void PerfProfileConnector::HandleUserStackEvent(void* cb_cookie, void* data, int data_size) {
+  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
+  auto* connector = static_cast<PerfProfileConnector*>(cb_cookie);
+  const auto* snapshot = static_cast<const user_stack_snapshot_t*>(data);
+  if (static_cast<size_t>(data_size) < offsetof(user_stack_snapshot_t, stack) ||
+      static_cast<size_t>(data_size) <
+          offsetof(user_stack_snapshot_t, stack) + snapshot->stack_size) {
+    LOG(DFATAL) << absl::Substitute("Truncated user stack snapshot of $0 bytes", data_size);
+    return;
+  }
+  connector->AcceptUserStackSnapshot(*snapshot);
+}
+
+void PerfProfileConnector::HandleUserStackLoss(void* cb_cookie, uint64_t lost) {
+  DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
+  auto* connector = static_cast<PerfProfileConnector*>(cb_cookie);
+  connector->stats_.Increment(StatKey::kLossUserStackSnapshot, lost);
+}
+
 void PerfProfileConnector::CleanupSymbolizers(const absl::flat_hash_set<md::UPID>& deleted_upids) {
   for (const auto& md_upid : deleted_upids) {
     // Clean-up caches.
@@ -124,7 +208,9 @@ void PerfProfileConnector::CleanupSymbolizers(const absl::flat_hash_set<md::UPID
     upid.pid = md_upid.pid();
     upid.start_time_ticks = md_upid.start_ts();
     u_symbolizer_->DeleteUPID(upid);
+    user_stack_unwinder_.DeleteUPID(upid);
   }
+  user_stack_unwinder_.AdvanceGeneration();
 
   if (FLAGS_stirling_profiler_cache_symbols) {
     size_t evict_count;
@@ -138,12 +224,111 @@ void PerfProfileConnector::CleanupSymbolizers(const absl::flat_hash_set<md::UPID
   }
 }
 
-PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces(
-    ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces) {
+Status PerfProfileConnector::StartTargetedSession(const std::vector<md::UPID>& upids,
+                                                  std::chrono::milliseconds sampling_period,
+                                                  std::chrono::milliseconds duration) {
+  if (upids.empty() || upids.size() > kMaxTargetedUPIDs) {
+    return error::InvalidArgument("A targeted session needs between 1 and $0 UPIDs, got $1.",
+                                  kMaxTargetedUPIDs, upids.size());
+  }
+  if (sampling_period < kMinTargetedSamplingPeriod) {
+    return error::InvalidArgument("The sampling period must be at least $0ms, got $1ms.",
+                                  kMinTargetedSamplingPeriod.count(), sampling_period.count());
+  }
+  if (duration <= std::chrono::milliseconds::zero() || duration > kMaxTargetedSessionDuration) {
+    return error::InvalidArgument(
+        "The duration must be positive and at most $0ms, got $1ms.",
+        std::chrono::milliseconds(kMaxTargetedSessionDuration).count(), duration.count());
+  }
+
+  absl::MutexLock lock(&targeted_session_mutex_);
+  requested_targeted_session_ =
+      TargetedSession{upids, sampling_period, std::chrono::steady_clock::now() + duration};
+  return Status::OK();
+}
+
+void PerfProfileConnector::StopTargetedSession() {
+  absl::MutexLock lock(&targeted_session_mutex_);
+  requested_targeted_session_ = TargetedSession{};
+}
+
+Status PerfProfileConnector::BeginTargetedSession(const TargetedSession& session) {
+  for (const md::UPID& upid : session.upids) {
+    const ebpf::StatusTuple s = targeted_upids_->update_value(upid.pid(), upid.start_ts());
+    if (!s.ok()) {
+      return error::Internal("Failed to add pid $0 to the targeted UPIDs: $1", upid.pid(), s.msg());
+    }
+  }
+
+  // The continuous profiling already uses the cpu-clock event, and BCC attaches a single event
+  // per type and config. A cpu-wide task-clock event ticks the same way.
+  constexpr uint64_t kNanosPerMilli = 1000 * 1000;
+  const bpf_tools::PerfEventSpec perf_event{
+      .type = PERF_TYPE_SOFTWARE,
+      .config = PERF_COUNT_SW_TASK_CLOCK,
+      .probe_fn = "sample_targeted_call_stack",
+      .sample_period = static_cast<uint64_t>(session.sampling_period.count()) * kNanosPerMilli};
+  PL_RETURN_IF_ERROR(AttachPerfEvent(perf_event));
+  targeted_perf_event_ = perf_event;
+  return Status::OK();
+}
+
+void PerfProfileConnector::EndTargetedSession() {
+  if (targeted_perf_event_.has_value()) {
+    Status s = RemovePerfEvent(targeted_perf_event_.value());
+    LOG_IF(ERROR, !s.ok()) << s.msg();
+    targeted_perf_event_.reset();
+  }
+  if (targeted_session_.has_value()) {
+    for (const md::UPID& upid : targeted_session_->upids) {
+      targeted_upids_->remove_value(upid.pid());
+    }
+    LOG(INFO) << absl::Substitute("PerfProfiler: Ended the targeted session of $0 processes.",
+                                  targeted_session_->upids.size());
+    targeted_session_.reset();
+  }
+}
+
+void PerfProfileConnector::UpdateTargetedSession() {
+  std::optional<TargetedSession> request;
+  {
+    absl::MutexLock lock(&targeted_session_mutex_);
+    request.swap(requested_targeted_session_);
+  }
+
+  if (request.has_value()) {
+    EndTargetedSession();
+    if (request->upids.empty()) {
+      return;
+    }
+    // Set first, so that EndTargetedSession() also cleans up a session that failed to begin.
+    targeted_session_ = std::move(request);
+    Status s = BeginTargetedSession(targeted_session_.value());
+    if (!s.ok()) {
+      LOG(ERROR) << "PerfProfiler: Failed to begin the targeted session: " << s.msg();
+      EndTargetedSession();
+      return;
+    }
+    LOG(INFO) << absl::Substitute(
+        "PerfProfiler: Began a targeted session of $0 processes, sampled every $1ms.",
+        targeted_session_->upids.size(), targeted_session_->sampling_period.count());
+    return;
+  }
+
+  if (targeted_session_.has_value() &&
+      std::chrono::steady_clock::now() >= targeted_session_->end_time) {
+    EndTargetedSession();
+  }
+}
+
+void PerfProfileConnector::AggregateStackTraces(ConnectorContext* ctx,
+                                                ebpf::BPFStackTable* stack_traces,
+                                                RawHistoData* raw_histo_data,
+                                                StackTraceHisto* histo) {
   // TODO(jps): switch from using get_table_offline() to directly stepping through
   // the histogram data structure. Inline populating our own data structures with this.
   // Avoid an unnecessary copy of the information in local stack_trace_keys_and_counts.
-  StackTraceHisto symbolic_histogram;
+  StackTraceHisto& symbolic_histogram = *histo;
   uint64_t cum_sum_count = 0;
 
   const uint32_t asid = ctx->GetASID();
@@ -154,11 +339,11 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
 
   absl::flat_hash_set<int> k_stack_ids_to_remove;
 
-  for (const auto& stack_trace_key : raw_histo_data_) {
+  for (const auto& stack_trace_key : *raw_histo_data) {
     std::string stack_trace_str;
 
     const md::UPID upid(asid, stack_trace_key.upid.pid, stack_trace_key.upid.start_time_ticks);
-    const bool symbolize = upids_for_symbolization.contains(upid);
+    const bool symbolize = upids_for_symbolization.contains(upid) || IsSelf(upid);
 
     if (symbolize) {
       // The stringifier clears stack-ids out of the stack traces table when it
@@ -205,15 +390,38 @@ PerfProfileConnector::StackTraceHisto PerfProfileConnector::AggregateStackTraces
     stack_traces->clear_stack_id(k_stack_id);
   }
 
-  raw_histo_data_.clear();
+  raw_histo_data->clear();
 
   VLOG(1) << "PerfProfileConnector::AggregateStackTraces(): cum_sum_count: " << cum_sum_count;
   stats_.Increment(StatKey::kCumulativeSumOfAllStackTraces, cum_sum_count);
-  return symbolic_histogram;
 }
 
-void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces, ConnectorContext* ctx,
-                                         DataTable* data_table) {
+void PerfProfileConnector::AggregateUnwoundUserStacks(ConnectorContext* ctx,
+                                                      ebpf::BPFStackTable* stack_traces,
+                                                      StackTraceHisto* histo) {
+  const uint32_t asid = ctx->GetASID();
+  const absl::flat_hash_set<md::UPID>& upids_for_symbolization = ctx->GetUPIDs();
+  Stringifier stringifier(u_symbolizer_.get(), k_symbolizer_.get(), stack_traces);
+
+  // The stacks unwound in user space have no kernel part.
+  for (const auto& user_stack : raw_user_stacks_) {
+    const md::UPID upid(asid, user_stack.upid.pid, user_stack.upid.start_time_ticks);
+    std::string stack_trace_str =
+        upids_for_symbolization.contains(upid) || IsSelf(upid)
+            ? stringifier.FoldedStackTraceString(user_stack.upid, user_stack.addrs)
+            : std::string(profiler::kNotSymbolizedMessage);
+
+    SymbolicStackTrace symbolic_stack_trace = {upid, std::move(stack_trace_str)};
+    ++(*histo)[symbolic_stack_trace];
+  }
+  stats_.Increment(StatKey::kCumulativeSumOfAllStackTraces, raw_user_stacks_.size());
+  raw_user_stacks_.clear();
+}
+
+void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces,
+                                         ebpf::BPFStackTable* targeted_stack_traces,
+                                         ConnectorContext* ctx, DataTable* data_table,
+                                         DataTable* self_profile_table) {
   constexpr size_t kMaxSymbolSize = 512;
   constexpr size_t kMaxStackDepth = 64;
   constexpr size_t kMaxStackTraceSize = kMaxStackDepth * kMaxSymbolSize;
@@ -226,35 +434,62 @@ void PerfProfileConnector::CreateRecords(ebpf::BPFStackTable* stack_traces, Conn
   // p0, p1, p2 => main;qux;baz   # both p2 & p3 point into baz.
   // p0, p1, p3 => main;qux;baz
 
-  StackTraceHisto stack_trace_histogram = AggregateStackTraces(ctx, stack_traces);
+  // The samples of a targeted session add to the counts of the same stack traces.
+  StackTraceHisto stack_trace_histogram;
+  stats_.Increment(StatKey::kTargetedStackTraces, raw_targeted_histo_data_.size());
+  AggregateStackTraces(ctx, stack_traces, &raw_histo_data_, &stack_trace_histogram);
+  AggregateStackTraces(ctx, targeted_stack_traces, &raw_targeted_histo_data_,
+                       &stack_trace_histogram);
+  AggregateUnwoundUserStacks(ctx, stack_traces, &stack_trace_histogram);
 
   constexpr auto age_tick_period = std::chrono::minutes(5);
-  if (sampling_freq_mgr_.count() % (age_tick_period / kSamplingPeriod) == 0) {
+  if (transfer_freq_mgr_.count() % (age_tick_period / kSamplingPeriod) == 0) {
     stack_trace_ids_.AgeTick();
   }
 
   for (const auto& [key, count] : stack_trace_histogram) {
+    if (self_profile_table != nullptr && IsSelf(key.upid)) {
+      DataTable::RecordBuilder<&kAgentSelfProfileTable> r(self_profile_table, timestamp_ns);
+      r.Append<r.ColIndex("time_")>(timestamp_ns);
+      r.Append<r.ColIndex("upid")>(key.upid.value());
+      r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+      r.Append<r.ColIndex("count")>(count);
+    }
+
+    if (data_table == nullptr) {
+      continue;
+    }
+
     DataTable::RecordBuilder<&kStackTraceTable> r(data_table, timestamp_ns);
 
     r.Append<r.ColIndex("time_")>(timestamp_ns);
     r.Append<r.ColIndex("upid")>(key.upid.value());
-    r.Append<r.ColIndex("stack_trace_id")>(stack_trace_ids_.Lookup(key));
-    r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+    bool first_in_period;
+    r.Append<r.ColIndex("stack_trace_id")>(stack_trace_ids_.Lookup(key, &first_in_period));
+    if (first_in_period || !FLAGS_stirling_profiler_elide_repeated_stack_traces) {
+      r.Append<r.ColIndex("stack_trace"), kMaxStackTraceSize>(key.stack_trace_str);
+    } else {
+      r.Append<r.ColIndex("stack_trace")>("");
+    }
     r.Append<r.ColIndex("count")>(count);
   }
 }
 
-void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table) {
+void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table,
+                                                 DataTable* self_profile_table) {
   // Choose the maps to consume.
   const bool using_map_set_a = transfer_count_ % 2 == 0;
   auto& stack_traces = using_map_set_a ? stack_traces_a_ : stack_traces_b_;
   auto& histo_perf_buf = using_map_set_a ? histogram_a_perf_buffer_ : histogram_b_perf_buffer_;
+  auto& targeted_stack_traces =
+      using_map_set_a ? targeted_stack_traces_a_ : targeted_stack_traces_b_;
   const uint32_t sample_count_idx = using_map_set_a ? kSampleCountAIdx : kSampleCountBIdx;
 
   // Read out the perf buffer that contains the histogram for this iteration.
   // TODO(jps): change PollPerfBuffer() to use std::chrono.
   constexpr int kPollTimeoutMS = 0;
   histo_perf_buf->poll(kPollTimeoutMS);
+  TargetedPerfBuffer()->poll(kPollTimeoutMS);
 
   ++transfer_count_;
 
@@ -263,7 +498,8 @@ void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTabl
   LOG_IF(ERROR, !s.ok()) << "Error writing transfer_count_";
 
   // Read BPF stack traces & histogram, build records, incorporate records to data table.
-  CreateRecords(stack_traces.get(), ctx, data_table);
+  CreateRecords(stack_traces.get(), targeted_stack_traces.get(), ctx, data_table,
+                self_profile_table);
 
   // Now that we've consumed the data, reset the sample count in BPF.
   profiler_state_->update_value(sample_count_idx, 0);
@@ -271,25 +507,43 @@ void PerfProfileConnector::ProcessBPFStackTraces(ConnectorContext* ctx, DataTabl
 
 void PerfProfileConnector::TransferDataImpl(ConnectorContext* ctx,
                                             const std::vector<DataTable*>& data_tables) {
-  DCHECK_EQ(data_tables.size(), 1);
+  DCHECK_EQ(data_tables.size(), kTables.size());
 
-  auto* data_table = data_tables[0];
+  auto* data_table = data_tables[kPerfProfileTableNum];
+  auto* self_profile_table = data_tables[kAgentSelfProfileTableNum];
 
-  if (data_table == nullptr) {
+  if (data_table == nullptr && self_profile_table == nullptr) {
     return;
   }
 
-  ProcessBPFStackTraces(ctx, data_table);
+  UpdateTargetedSession();
+
+  constexpr int kPollTimeoutMS = 0;
+  if (user_stacks_perf_buffer_ != nullptr) {
+    user_stacks_perf_buffer_->poll(kPollTimeoutMS);
+  }
+  if (targeted_session_.has_value()) {
+    TargetedPerfBuffer()->poll(kPollTimeoutMS);
+  }
+  if (!transfer_freq_mgr_.Expired()) {
+    return;
+  }
+
+  ProcessBPFStackTraces(ctx, data_table, self_profile_table);
 
   // Cleanup the symbolizer so we don't leak memory.
-  proc_tracker_.Update(ctx->GetUPIDs());
+  proc_tracker_.Update(ctx->GetUPIDs(), ctx->GetUPIDsVersion(), ctx->GetUPIDsDelta().get());
   CleanupSymbolizers(proc_tracker_.deleted_upids());
 
   stats_.Increment(StatKey::kBPFMapSwitchoverEvent, 1);
 
-  if (sampling_freq_mgr_.count() % FLAGS_stirling_perf_profiler_stats_logging_ratio == 0) {
-    VLOG(1) << "PerfProfileConnector statistics: " << stats_.Print();
+  if (transfer_freq_mgr_.count() % FLAGS_stirling_perf_profiler_stats_logging_ratio == 0) {
+    VLOG(1) << "PerfProfileConnector statistics: " << stats_.Print()
+            << "unwind_truncated=" << user_stack_unwinder_.stat_truncated();
   }
+
+  unwind_time_ = {};
+  transfer_freq_mgr_.Reset();
 }
 
 }  // namespace stirling
@@ -18,12 +18,17 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/synchronization/mutex.h>
+
 #include "src/shared/types/types.h"
+#include "src/shared/upid/upid.h"
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/core/source_connector.h"
@@ -34,8 +39,12 @@
 #include "src/stirling/source_connectors/perf_profiler/stringifier.h"
 #include "src/stirling/source_connectors/perf_profiler/symbolizer.h"
 #include "src/stirling/source_connectors/perf_profiler/types.h"
+#include "src/stirling/source_connectors/perf_profiler/user_stack_unwinder.h"
 #include "src/stirling/utils/stat_counter.h"
 
+DECLARE_bool(stirling_profiler_elide_repeated_stack_traces);
+DECLARE_bool(stirling_profiler_self_profile);
+
 namespace px {
 namespace stirling {
 
@@ -46,8 +55,9 @@ static constexpr std::string_view kNotSymbolizedMessage = "<not symbolized>";
 class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrapper {
  public:
   static constexpr std::string_view kName = "perf_profiler";
-  static constexpr auto kTables = MakeArray(kStackTraceTable);
+  static constexpr auto kTables = MakeArray(kStackTraceTable, kAgentSelfProfileTable);
   static constexpr uint32_t kPerfProfileTableNum = TableNum(kTables, kStackTraceTable);
+  static constexpr uint32_t kAgentSelfProfileTableNum = TableNum(kTables, kAgentSelfProfileTable);
 
   // kBPFSamplingPeriod: the time interval in between stack trace samples.
   static constexpr auto kBPFSamplingPeriod = std::chrono::milliseconds{11};
@@ -58,13 +68,40 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{30000};
   static constexpr auto kPushPeriod = std::chrono::milliseconds{15000};
 
+  // How often the perf buffers that fill up faster than kSamplingPeriod are drained: the user
+  // stack snapshots, when unwinding user stacks in user space, and the samples of targeted
+  // sessions.
+  static constexpr auto kPollPeriod = std::chrono::milliseconds{1000};
+
+  // Bounds of the targeted sessions, see StartTargetedSession().
+  static constexpr auto kMinTargetedSamplingPeriod = std::chrono::milliseconds{1};
+  static constexpr auto kMaxTargetedSessionDuration = std::chrono::minutes{10};
+
   static std::unique_ptr<SourceConnector> Create(std::string_view name) {
     return std::unique_ptr<SourceConnector>(new PerfProfileConnector(name));
   }
 
   Status InitImpl() override;
+  bool UsesBPF() const override { return true; }
   Status StopImpl() override;
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+  bool IsLowPriority() const override { return true; }
+
+  /**
+   * Starts a targeted session, which samples the stack traces of the given processes every
+   * sampling_period for the given duration, on top of the continuous profiling of all processes.
+   * Its samples go to the same stack traces table, so the targeted processes have larger counts
+   * while the session lasts. A new session replaces the one in progress.
+   * Thread-safe: the session starts on the next iteration of the connector.
+   */
+  Status StartTargetedSession(const std::vector<md::UPID>& upids,
+                              std::chrono::milliseconds sampling_period,
+                              std::chrono::milliseconds duration);
+
+  /**
+   * Ends the targeted session in progress, if any. Thread-safe.
+   */
+  void StopTargetedSession();
 
  private:
   // StackTraceHisto: SymbolicStackTrace => observation-count
@@ -73,24 +110,68 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // RawHistoData: a list of stack trace keys that will need to be histogrammed.
   using RawHistoData = std::vector<stack_trace_key_t>;
 
+  // A targeted session, requested by StartTargetedSession(). No upids stops the session.
+  struct TargetedSession {
+    std::vector<md::UPID> upids;
+    std::chrono::milliseconds sampling_period = {};
+    std::chrono::steady_clock::time_point end_time = {};
+  };
+
+  // A user stack that was unwound in user space.
+  struct UnwoundUserStack {
+    struct upid_t upid;
+    std::vector<uintptr_t> addrs;
+  };
+
   explicit PerfProfileConnector(std::string_view source_name);
 
-  void ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table);
+  void ProcessBPFStackTraces(ConnectorContext* ctx, DataTable* data_table,
+                             DataTable* self_profile_table);
+
+  // Read BPF data structures, build & incorporate records to the tables.
+  // The stack traces of the agent itself also go to self_profile_table. Either table may be null.
+  void CreateRecords(ebpf::BPFStackTable* stack_traces,
+                     ebpf::BPFStackTable* targeted_stack_traces, ConnectorContext* ctx,
+                     DataTable* data_table, DataTable* self_profile_table);
+
+  bool IsSelf(const md::UPID& upid) const {
+    return FLAGS_stirling_profiler_self_profile && upid.pid() == self_pid_;
+  }
 
-  // Read BPF data structures, build & incorporate records to the table.
-  void CreateRecords(ebpf::BPFStackTable* stack_traces, ConnectorContext* ctx,
-                     DataTable* data_table);
+  // Symbolizes the keys in raw_histo_data, whose stack ids index stack_traces, into histo, and
+  // clears raw_histo_data.
+  void AggregateStackTraces(ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces,
+                            RawHistoData* raw_histo_data, StackTraceHisto* histo);
 
-  StackTraceHisto AggregateStackTraces(ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces);
+  // Symbolizes raw_user_stacks_ into histo, and clears raw_user_stacks_.
+  void AggregateUnwoundUserStacks(ConnectorContext* ctx, ebpf::BPFStackTable* stack_traces,
+                                  StackTraceHisto* histo);
+
+  // Starts or ends the targeted session, per the last request and the session's end time.
+  void UpdateTargetedSession();
+  Status BeginTargetedSession(const TargetedSession& session);
+  void EndTargetedSession();
+
+  // The perf buffer of the targeted samples, for the map set that BPF currently writes to.
+  ebpf::BPFPerfBuffer* TargetedPerfBuffer() const {
+    return transfer_count_ % 2 == 0 ? targeted_histogram_a_perf_buffer_
+                                    : targeted_histogram_b_perf_buffer_;
+  }
 
   void CleanupSymbolizers(const absl::flat_hash_set<md::UPID>& deleted_upids);
 
   // data structures shared with BPF:
   std::unique_ptr<ebpf::BPFStackTable> stack_traces_a_;
   std::unique_ptr<ebpf::BPFStackTable> stack_traces_b_;
+  std::unique_ptr<ebpf::BPFStackTable> targeted_stack_traces_a_;
+  std::unique_ptr<ebpf::BPFStackTable> targeted_stack_traces_b_;
+  std::unique_ptr<ebpf::BPFHashTable<uint32_t, uint64_t>> targeted_upids_;
 
   std::unique_ptr<ebpf::BPFArrayTable<uint64_t>> profiler_state_;
 
+  // The pid of the agent, whose stack traces are always symbolized for kAgentSelfProfileTable.
+  const uint32_t self_pid_;
+
   // Number of iterations, where each iteration is drains the information collectid in BPF.
   uint64_t transfer_count_ = 0;
 
@@ -100,6 +181,29 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // The raw histogram from BPF; it is populated on each iteration by a call to PollPerfBuffer().
   RawHistoData raw_histo_data_;
 
+  // The same, for the samples of the targeted session. Populated between iterations as well.
+  RawHistoData raw_targeted_histo_data_;
+
+  // The last session request, not yet picked up by UpdateTargetedSession().
+  absl::Mutex targeted_session_mutex_;
+  std::optional<TargetedSession> requested_targeted_session_
+      ABSL_GUARDED_BY(targeted_session_mutex_);
+
+  // The session in progress, and the perf event that samples it.
+  std::optional<TargetedSession> targeted_session_;
+  std::optional<bpf_tools::PerfEventSpec> targeted_perf_event_;
+
+  // The user stacks unwound since the last iteration, by AcceptUserStackSnapshot().
+  std::vector<UnwoundUserStack> raw_user_stacks_;
+  UserStackUnwinder user_stack_unwinder_;
+
+  // The time spent unwinding in this iteration, bounded by stirling_profiler_unwind_budget_ms.
+  std::chrono::nanoseconds unwind_time_ = {};
+
+  // Paces the iterations, which drain the BPF maps and build the records. It's the same as the
+  // sampling period, unless unwinding user stacks.
+  FrequencyManager transfer_freq_mgr_;
+
   // For converting stack trace addresses to symbols.
   std::unique_ptr<Symbolizer> k_symbolizer_;
   std::unique_ptr<Symbolizer> u_symbolizer_;
@@ -121,21 +225,56 @@ class PerfProfileConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   static void HandleHistoEvent(void* cb_cookie, void* data, int /*data_size*/);
   static void HandleHistoLoss(void* cb_cookie, uint64_t lost);
+  static void HandleTargetedHistoEvent(void* cb_cookie, void* data, int /*data_size*/);
 
   // Called by HandleHistoEvent() to add the stack-trace-key to raw_histo_data_.
   void AcceptStackTraceKey(stack_trace_key_t* data);
 
+  static void HandleUserStackEvent(void* cb_cookie, void* data, int data_size);
+  static void HandleUserStackLoss(void* cb_cookie, uint64_t lost);
+
+  // Called by HandleUserStackEvent() to unwind the snapshot into raw_user_stacks_.
+  void AcceptUserStackSnapshot(const user_stack_snapshot_t& snapshot);
+
   inline static const auto kPerfBufferSpecs = MakeArray<bpf_tools::PerfBufferSpec>(
       {{"histogram_a", HandleHistoEvent, HandleHistoLoss, kNumPerfBufferEntries},
        {"histogram_b", HandleHistoEvent, HandleHistoLoss, kNumPerfBufferEntries}});
 
+  // Sized for kPollPeriod, at the highest sampling rate of a targeted session, with a margin.
+  static const uint32_t kTargetedPerfBufferBytes =
+      4 * IntRoundUpDivide(kPollPeriod.count(), kMinTargetedSamplingPeriod.count()) *
+      sizeof(stack_trace_key_t);
+
+  inline static const auto kTargetedPerfBufferSpecs = MakeArray<bpf_tools::PerfBufferSpec>(
+      {{"targeted_histogram_a", HandleTargetedHistoEvent, HandleHistoLoss,
+        kTargetedPerfBufferBytes},
+       {"targeted_histogram_b", HandleTargetedHistoEvent, HandleHistoLoss,
+        kTargetedPerfBufferBytes}});
+
+  // Sized for kPollPeriod, at the BPF sampling rate, with a margin.
+  static const uint32_t kUserStackPerfBufferBytes =
+      2 * IntRoundUpDivide(kPollPeriod.count(), kBPFSamplingPeriod.count()) *
+      sizeof(user_stack_snapshot_t);
+
+  inline static const auto kUserStackPerfBufferSpecs = MakeArray<bpf_tools::PerfBufferSpec>(
+      {{"user_stack_snapshots", HandleUserStackEvent, HandleUserStackLoss,
+        kUserStackPerfBufferBytes}});
+
   ebpf::BPFPerfBuffer* histogram_a_perf_buffer_;
   ebpf::BPFPerfBuffer* histogram_b_perf_buffer_;
+  ebpf::BPFPerfBuffer* targeted_histogram_a_perf_buffer_;
+  ebpf::BPFPerfBuffer* targeted_histogram_b_perf_buffer_;
+  ebpf::BPFPerfBuffer* user_stacks_perf_buffer_ = nullptr;
 
   enum class StatKey {
     kBPFMapSwitchoverEvent,
     kCumulativeSumOfAllStackTraces,
     kLossHistoEvent,
+    kLossUserStackSnapshot,
+    kTargetedStackTraces,
+    kUnwoundUserStacks,
+    kUnwindOverBudget,
+    kUnwindTimeUS,
   };
 
   utils::StatCounter<StatKey> stats_;
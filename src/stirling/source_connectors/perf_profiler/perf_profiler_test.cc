@@ -24,6 +24,7 @@
 #include "src/common/base/base.h"
 #include "src/common/exec/subprocess.h"
 #include "src/common/fs/fs_wrapper.h"
+#include "src/shared/upid/upid.h"
 #include "src/stirling/source_connectors/perf_profiler/perf_profile_connector.h"
 #include "src/stirling/source_connectors/perf_profiler/stack_traces_table.h"
 #include "src/stirling/testing/common.h"
@@ -110,10 +111,20 @@ class PerfProfileBPFTest : public ::testing::Test {
     // and did not corrupt the cumulative sum already.
     ASSERT_TRUE(column_ptrs_populated_);
 
+    // Repeats of a stack trace ID leave the string empty, resolve those like the table store does.
+    absl::flat_hash_map<int64_t, std::string> stack_trace_strs;
+    for (size_t row_idx = 0; row_idx < stack_traces_column_->Size(); ++row_idx) {
+      const std::string& stack_trace_str = stack_traces_column_->Get<types::StringValue>(row_idx);
+      if (!stack_trace_str.empty()) {
+        stack_trace_strs[trace_ids_column_->Get<types::Int64Value>(row_idx).val] = stack_trace_str;
+      }
+    }
+
     for (const auto row_idx : target_row_idxs) {
       // Build the histogram of observed stack traces here:
       // Also, track the cumulative sum (or total number of samples).
-      const std::string stack_trace_str = stack_traces_column_->Get<types::StringValue>(row_idx);
+      const int64_t stack_trace_id = trace_ids_column_->Get<types::Int64Value>(row_idx).val;
+      const std::string& stack_trace_str = stack_trace_strs[stack_trace_id];
       const int64_t count = counts_column_->Get<types::Int64Value>(row_idx).val;
       observed_stack_traces_[stack_trace_str] += count;
     }
@@ -209,8 +220,9 @@ class PerfProfileBPFTest : public ::testing::Test {
     column_ptrs_populated_ = true;
   }
 
-  std::chrono::duration<double> RunTest(const std::chrono::seconds test_run_time) {
-    constexpr std::chrono::milliseconds t_sleep = PerfProfileConnector::kSamplingPeriod;
+  std::chrono::duration<double> RunTest(
+      const std::chrono::seconds test_run_time,
+      const std::chrono::milliseconds t_sleep = PerfProfileConnector::kSamplingPeriod) {
     const auto start_time = std::chrono::steady_clock::now();
     const auto stop_time = start_time + test_run_time;
 
@@ -230,7 +242,7 @@ class PerfProfileBPFTest : public ::testing::Test {
   std::unique_ptr<SourceConnector> source_;
   std::unique_ptr<StandaloneContext> ctx_;
   DataTable data_table_;
-  const std::vector<DataTable*> data_tables_{&data_table_};
+  const std::vector<DataTable*> data_tables_{&data_table_, nullptr};
 
   bool column_ptrs_populated_ = false;
   std::shared_ptr<types::ColumnWrapper> trace_ids_column_;
@@ -351,5 +363,47 @@ TEST_F(PerfProfileBPFTest, TestOutOfContext) {
   ASSERT_NO_FATAL_FAILURE(PopulateObservedStackTraces(target_row_idxs));
 }
 
+TEST_F(PerfProfileBPFTest, TargetedSession) {
+  // Needs to be unique across test fixtures because we use this to map
+  // into CPU index. If non-unique, two or more different test fixtures
+  // will run their toy apps. on the same CPU.
+  constexpr uint32_t kTestIdx = 3;
+
+  const std::filesystem::path bazel_app_path = BazelCCTestAppPath("profiler_test_app_fib");
+  auto sub_processes = StartSubProcesses<CPUPinnedBinaryRunner>(bazel_app_path, kTestIdx);
+  ctx_ = std::make_unique<StandaloneContext>();
+
+  std::vector<md::UPID> upids;
+  for (const auto& upid : ctx_->GetUPIDs()) {
+    for (const auto& sub_process : sub_processes) {
+      if (upid.pid() == static_cast<uint32_t>(sub_process.pid())) {
+        upids.push_back(upid);
+      }
+    }
+  }
+  ASSERT_EQ(upids.size(), kNumSubProcesses);
+
+  auto* profiler = static_cast<PerfProfileConnector*>(source_.get());
+  EXPECT_NOT_OK(profiler->StartTargetedSession(upids, std::chrono::milliseconds{0},
+                                               std::chrono::seconds{60}));
+  ASSERT_OK(profiler->StartTargetedSession(upids, std::chrono::milliseconds{1},
+                                           std::chrono::seconds{60}));
+
+  // The targeted samples are drained every poll period.
+  const std::chrono::duration<double> elapsed_time =
+      RunTest(std::chrono::seconds(60), PerfProfileConnector::kPollPeriod);
+
+  ASSERT_NO_FATAL_FAILURE(ConsumeRecords());
+  const std::vector<size_t> target_row_idxs = GetTargetRowIdxs(sub_processes);
+  ASSERT_NO_FATAL_FAILURE(PopulateCumulativeSum(target_row_idxs));
+
+  // Sampled every 1ms by the session, on top of every 11ms by the continuous profiler. Allow for
+  // the session starting on the first iteration, and for its samples being sparser at high rate.
+  const double continuous_rate = 1000.0 / PerfProfileConnector::kBPFSamplingPeriod.count();
+  const double continuous_num_samples =
+      kNumSubProcesses * elapsed_time.count() * continuous_rate;
+  EXPECT_GT(cumulative_sum_, 4 * continuous_num_samples);
+}
+
 }  // namespace stirling
 }  // namespace px
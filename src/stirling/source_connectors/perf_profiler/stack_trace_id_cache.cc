@@ -23,14 +23,21 @@
 namespace px {
 namespace stirling {
 
-uint64_t StackTraceIDCache::Lookup(const SymbolicStackTrace& stack_trace) {
+uint64_t StackTraceIDCache::Lookup(const SymbolicStackTrace& stack_trace, bool* first_in_period) {
   // Case 1: Stack trace ID is in the current set. Just return it.
   const auto it = stack_trace_ids_.find(stack_trace);
   if (it != stack_trace_ids_.end()) {
     const uint64_t stack_trace_id = it->second;
+    if (first_in_period != nullptr) {
+      *first_in_period = false;
+    }
     return stack_trace_id;
   }
 
+  if (first_in_period != nullptr) {
+    *first_in_period = true;
+  }
+
   // Case 2: Stack trace ID is in the previous set. Copy it to current set, and return it.
   const auto it2 = prev_stack_trace_ids_.find(stack_trace);
   if (it2 != prev_stack_trace_ids_.end()) {
@@ -31,7 +31,8 @@ namespace stirling {
 // We maintain these IDs for a number of reasons:
 //  1) The IDs enable more efficient aggregations across time samples in Carnot:
 //     aggregations with integers are more efficient than aggregations with strings.
-//  2) The IDs enable table normalization (future work).
+//  2) The IDs enable table normalization: the string of an ID only has to be emitted once per
+//     aging period (see Lookup()), and the consumer resolves the repeats by ID.
 //
 // As a cache, it should be noted that no guarantee is made that a stack trace from one time
 // period is assigned the same stack trace ID. Any consumer of the data can only assume that
@@ -46,7 +47,10 @@ namespace stirling {
 // the UI will aggregate the identical stack traces for us in the visualization.
 class StackTraceIDCache {
  public:
-  uint64_t Lookup(const SymbolicStackTrace& stack_trace);
+  // If first_in_period is not null, it is set to whether this is the first lookup of the stack
+  // trace since the last AgeTick(). Consumers that remember the string of each ID only need the
+  // string the first time around.
+  uint64_t Lookup(const SymbolicStackTrace& stack_trace, bool* first_in_period = nullptr);
   void AgeTick();
 
  private:
@@ -51,5 +51,25 @@ TEST(StackTraceIDCache, Basic) {
   EXPECT_NE(stack_trace_ids.Lookup(kStackTrace2), id2);
 }
 
+TEST(StackTraceIDCache, FirstInPeriod) {
+  StackTraceIDCache stack_trace_ids;
+
+  const md::UPID kUPID(1, 1, 1);
+  const SymbolicStackTrace kStackTrace1{kUPID, "a();b();c();"};
+
+  bool first_in_period = false;
+  uint64_t id1 = stack_trace_ids.Lookup(kStackTrace1, &first_in_period);
+  EXPECT_TRUE(first_in_period);
+  EXPECT_EQ(stack_trace_ids.Lookup(kStackTrace1, &first_in_period), id1);
+  EXPECT_FALSE(first_in_period);
+
+  // The first lookup after an age tick is the first of its period, even though the ID is kept.
+  stack_trace_ids.AgeTick();
+  EXPECT_EQ(stack_trace_ids.Lookup(kStackTrace1, &first_in_period), id1);
+  EXPECT_TRUE(first_in_period);
+  EXPECT_EQ(stack_trace_ids.Lookup(kStackTrace1, &first_in_period), id1);
+  EXPECT_FALSE(first_in_period);
+}
+
 }  // namespace stirling
 }  // namespace px
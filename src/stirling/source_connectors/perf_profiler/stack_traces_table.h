@@ -53,6 +53,28 @@ constexpr auto kStackTraceTable = DataTableSchema(
 // clang-format on
 DEFINE_PRINT_TABLE(StackTrace)
 
+// clang-format off
+static constexpr DataElement kAgentSelfProfileElements[] = {
+    canonical_data_elements::kTime,
+    canonical_data_elements::kUPID,
+    {"stack_trace",
+     "A stack trace within the agent, in folded format. "
+     "The call stack symbols are separated by semicolons.",
+     types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+    {"count",
+     "Number of times the stack trace has been sampled.",
+     types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_GAUGE}
+};
+
+constexpr auto kAgentSelfProfileTable = DataTableSchema(
+        "px_agent_self_profile",
+        "Sampled stack traces of the Pixie agent itself, that identify where the agent spends "
+        "its CPU time.",
+        kAgentSelfProfileElements
+);
+// clang-format on
+DEFINE_PRINT_TABLE(AgentSelfProfile)
+
 constexpr int kStackTraceTimeIdx = kStackTraceTable.ColIndex("time_");
 constexpr int kStackTraceUPIDIdx = kStackTraceTable.ColIndex("upid");
 constexpr int kStackTraceStackTraceIDIdx = kStackTraceTable.ColIndex("stack_trace_id");
@@ -133,5 +133,11 @@ std::string Stringifier::FoldedStackTraceString(const stack_trace_key_t& key) {
   return stack_trace_str;
 }
 
+std::string Stringifier::FoldedStackTraceString(const struct upid_t& upid,
+                                                const std::vector<uintptr_t>& user_addrs) {
+  return BuildStackTraceString(user_addrs, u_symbolizer_->GetSymbolizerFn(upid),
+                               stringifier::kUserSuffix);
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -80,6 +80,11 @@ class Stringifier {
   // passed into FindOrBuildStackTraceString().
   std::string FoldedStackTraceString(const stack_trace_key_t& key);
 
+  // Returns a folded stack trace string for a user stack that was unwound in user space,
+  // from its addresses, innermost first.
+  std::string FoldedStackTraceString(const struct upid_t& upid,
+                                     const std::vector<uintptr_t>& user_addrs);
+
  private:
   std::string BuildStackTraceString(const std::vector<uintptr_t>& addrs, SymbolizerFn symbolize_fn,
                                     const std::string_view& suffix);
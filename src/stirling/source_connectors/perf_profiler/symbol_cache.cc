@@ -50,5 +50,41 @@ size_t SymbolCache::PerformEvictions() {
   return evict_count;
 }
 
+SymbolLRUCache::ObjectID SymbolLRUCache::GetObjectID(const std::string& object_key) {
+  return object_ids_.try_emplace(object_key, object_ids_.size()).first->second;
+}
+
+const std::string* SymbolLRUCache::Find(ObjectID object, uint64_t offset) {
+  auto iter = index_.find(Key{object, offset});
+  if (iter == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, iter->second);
+  return &iter->second->symbol;
+}
+
+const std::string& SymbolLRUCache::Insert(ObjectID object, uint64_t offset, std::string symbol) {
+  const Key key{object, offset};
+  auto [iter, inserted] = index_.try_emplace(key);
+  if (!inserted) {
+    bytes_ -= EntryBytes(*iter->second);
+    iter->second->symbol = std::move(symbol);
+    entries_.splice(entries_.begin(), entries_, iter->second);
+  } else {
+    entries_.push_front(Entry{key, std::move(symbol)});
+    iter->second = entries_.begin();
+  }
+  bytes_ += EntryBytes(entries_.front());
+
+  while (bytes_ > max_bytes_ && entries_.size() > 1) {
+    const Entry& lru = entries_.back();
+    bytes_ -= EntryBytes(lru);
+    index_.erase(lru.key);
+    entries_.pop_back();
+    ++evict_count_;
+  }
+  return entries_.front().symbol;
+}
+
 }  // namespace stirling
 }  // namespace px
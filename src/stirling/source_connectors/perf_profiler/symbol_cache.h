@@ -19,6 +19,7 @@
 #pragma once
 
 #include <functional>
+#include <list>
 #include <string>
 #include <utility>
 
@@ -67,5 +68,79 @@ class SymbolCache {
   absl::flat_hash_map<uintptr_t, Symbol> prev_cache_;
 };
 
+/**
+ * A cache of symbols keyed by the object that holds the code, and the offset of the code in it,
+ * rather than by process and address. So all the processes that map the same object share the
+ * symbols. Entries are evicted in least recently used order, once the size of the symbols goes
+ * over a budget.
+ */
+class SymbolLRUCache {
+ public:
+  explicit SymbolLRUCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+  // Identifies an object. See GetObjectID().
+  using ObjectID = uint32_t;
+
+  /**
+   * Returns the ID of the object with the given key, e.g. its build-id. IDs are never reused.
+   */
+  ObjectID GetObjectID(const std::string& object_key);
+
+  /**
+   * Returns the symbol, if it's cached, and marks it as the most recently used.
+   */
+  const std::string* Find(ObjectID object, uint64_t offset);
+
+  /**
+   * Caches a symbol, and evicts the least recently used symbols if needed to keep within budget.
+   * Never evicts the symbol being inserted, so the returned reference stays valid until the next
+   * call.
+   */
+  const std::string& Insert(ObjectID object, uint64_t offset, std::string symbol);
+
+  size_t bytes() const { return bytes_; }
+  size_t size() const { return index_.size(); }
+
+  // Returns the number of entries evicted since the last call.
+  size_t TakeEvictCount() { return std::exchange(evict_count_, 0); }
+
+ private:
+  struct Key {
+    ObjectID object;
+    uint64_t offset;
+
+    bool operator==(const Key& other) const {
+      return object == other.object && offset == other.offset;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.object, key.offset);
+    }
+  };
+
+  struct Entry {
+    Key key;
+    std::string symbol;
+  };
+
+  // An estimate of the overhead of an entry in the list and in the index, on top of its symbol.
+  static constexpr size_t kEntryOverheadBytes = sizeof(Entry) + 4 * sizeof(void*) + sizeof(Key);
+
+  static size_t EntryBytes(const Entry& entry) {
+    return kEntryOverheadBytes + entry.symbol.capacity();
+  }
+
+  const size_t max_bytes_;
+  size_t bytes_ = 0;
+  size_t evict_count_ = 0;
+
+  absl::flat_hash_map<std::string, ObjectID> object_ids_;
+
+  // Most recently used first.
+  std::list<Entry> entries_;
+  absl::flat_hash_map<Key, std::list<Entry>::iterator> index_;
+};
+
 }  // namespace stirling
 }  // namespace px
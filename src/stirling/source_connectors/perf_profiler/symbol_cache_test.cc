@@ -113,5 +113,51 @@ TEST_F(SymbolCacheTest, EvictOldEntries) {
   EXPECT_EQ(sym_cache_->active_entries(), 1);
 }
 
+TEST(SymbolLRUCacheTest, SharedByObject) {
+  SymbolLRUCache cache(1024 * 1024);
+
+  const SymbolLRUCache::ObjectID libc = cache.GetObjectID("libc_build_id");
+  const SymbolLRUCache::ObjectID app = cache.GetObjectID("app_build_id");
+  EXPECT_NE(libc, app);
+  EXPECT_EQ(cache.GetObjectID("libc_build_id"), libc);
+
+  EXPECT_EQ(cache.Find(libc, kAddr1), nullptr);
+  EXPECT_EQ(cache.Insert(libc, kAddr1, "malloc"), "malloc");
+  ASSERT_NE(cache.Find(libc, kAddr1), nullptr);
+  EXPECT_EQ(*cache.Find(libc, kAddr1), "malloc");
+
+  // The same offset in another object is another symbol.
+  EXPECT_EQ(cache.Find(app, kAddr1), nullptr);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(SymbolLRUCacheTest, EvictLeastRecentlyUsed) {
+  SymbolLRUCache sizing_cache(1024 * 1024);
+  sizing_cache.Insert(0, 0, "symbol");
+  const size_t entry_bytes = sizing_cache.bytes();
+
+  // Room for two entries.
+  SymbolLRUCache cache(2 * entry_bytes);
+  const SymbolLRUCache::ObjectID object = cache.GetObjectID("build_id");
+
+  cache.Insert(object, kAddr1, "symbol");
+  cache.Insert(object, kAddr2, "symbol");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.TakeEvictCount(), 0);
+
+  // Makes kAddr2 the least recently used.
+  EXPECT_NE(cache.Find(object, kAddr1), nullptr);
+
+  cache.Insert(object, 789, "symbol");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_LE(cache.bytes(), 2 * entry_bytes);
+  EXPECT_EQ(cache.TakeEvictCount(), 1);
+  EXPECT_EQ(cache.TakeEvictCount(), 0);
+
+  EXPECT_NE(cache.Find(object, kAddr1), nullptr);
+  EXPECT_EQ(cache.Find(object, kAddr2), nullptr);
+  EXPECT_NE(cache.Find(object, 789), nullptr);
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -16,6 +16,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
+#include <limits>
 #include <utility>
 
 #include "src/stirling/bpf_tools/bcc_symbolizer.h"
@@ -26,6 +28,9 @@ using ::px::stirling::obj_tools::ElfReader;
 DEFINE_uint64(
     stirling_profiler_cache_eviction_threshold, 0,
     "Number of symbols in the current generation of the cache that triggers an eviction.");
+DEFINE_uint64(stirling_profiler_symbol_cache_bytes, 64 * 1024 * 1024,
+              "Size budget of the symbols cached by object and offset, which are shared by all "
+              "processes. Least recently used symbols are evicted past it.");
 
 namespace px {
 namespace stirling {
@@ -114,54 +119,229 @@ StatusOr<std::unique_ptr<Symbolizer>> CachingSymbolizer::Create(
   return uptr;
 }
 
+namespace {
+
+std::string AddrString(const uintptr_t addr) { return absl::StrFormat("0x%016llx", addr); }
+
+// Past this many mapped files, the build-id memo is cleared, as the files are probably gone.
+constexpr size_t kMaxObjectKeys = 64 * 1024;
+
+}  // namespace
+
+const std::string& CachingSymbolizer::ObjectKey(uint32_t pid,
+                                                const system::ProcParser::ProcMap& map) {
+  auto [iter, inserted] = object_keys_.try_emplace(std::make_pair(map.dev, map.inode));
+  if (!inserted) {
+    return iter->second;
+  }
+
+  // The path in the maps is in the mount namespace of the process.
+  const std::filesystem::path host_path = system::Config::GetInstance().proc_path() /
+                                          std::to_string(pid) / "root" /
+                                          std::filesystem::path(map.pathname).relative_path();
+  StatusOr<std::string> build_id_status = obj_tools::ReadBuildID(host_path);
+  if (build_id_status.ok()) {
+    iter->second = build_id_status.ConsumeValueOrDie();
+  } else {
+    // Without a build-id, the file is only shared with the processes that map the same inode.
+    VLOG(1) << absl::Substitute("No build-id for $0: $1", host_path.string(),
+                                build_id_status.msg());
+    iter->second = absl::StrCat("inode:", map.dev, ":", map.inode);
+  }
+  return iter->second;
+}
+
+void CachingSymbolizer::ReadMappings(uint32_t pid, UPIDSymbols* upid_symbols) {
+  upid_symbols->mappings_generation = generation_;
+  upid_symbols->mappings.clear();
+  upid_symbols->jit_ranges.clear();
+
+  if (pid == profiler::kKernelUPID.pid) {
+    // The kernel is a single object, the same for every process.
+    upid_symbols->mappings.push_back(ObjectMapping{0, std::numeric_limits<uint64_t>::max(), 0,
+                                                   object_symbols_.GetObjectID("[kernel]")});
+    return;
+  }
+
+  std::vector<system::ProcParser::ProcMap> maps;
+  Status s = system::ProcParser(system::Config::GetInstance()).ReadProcMaps(pid, &maps);
+  if (!s.ok()) {
+    VLOG(1) << absl::Substitute("Could not read the mappings of pid $0: $1", pid, s.msg());
+    return;
+  }
+
+  if (object_keys_.size() > kMaxObjectKeys) {
+    object_keys_.clear();
+  }
+
+  for (const auto& map : maps) {
+    if (!map.executable()) {
+      continue;
+    }
+    if (map.inode == 0 && map.pathname.empty()) {
+      upid_symbols->jit_ranges.emplace_back(map.vmem_start, map.vmem_end);
+      continue;
+    }
+    // Special ([vdso]) mappings are symbolized per process.
+    if (map.inode == 0 || map.pathname.empty() || map.pathname[0] != '/') {
+      continue;
+    }
+    const SymbolLRUCache::ObjectID object = object_symbols_.GetObjectID(ObjectKey(pid, map));
+    upid_symbols->mappings.push_back(
+        ObjectMapping{map.vmem_start, map.vmem_end, map.file_offset, object});
+  }
+
+  if (!upid_symbols->jit_ranges.empty() && upid_symbols->perf_map == nullptr) {
+    StatusOr<std::filesystem::path> path = PerfMap::PathOfPID(pid);
+    if (path.ok()) {
+      upid_symbols->perf_map = std::make_unique<PerfMap>(path.ConsumeValueOrDie());
+    }
+  }
+}
+
+const CachingSymbolizer::ObjectMapping* CachingSymbolizer::FindMapping(
+    const UPIDSymbols& upid_symbols, uintptr_t addr) const {
+  const auto& mappings = upid_symbols.mappings;
+  auto iter =
+      std::upper_bound(mappings.begin(), mappings.end(), addr,
+                       [](uintptr_t addr, const ObjectMapping& m) { return addr < m.vmem_start; });
+  if (iter == mappings.begin()) {
+    return nullptr;
+  }
+  --iter;
+  return addr < iter->vmem_end ? &*iter : nullptr;
+}
+
+bool CachingSymbolizer::InJITRange(const UPIDSymbols& upid_symbols, uintptr_t addr) {
+  const auto& ranges = upid_symbols.jit_ranges;
+  auto iter = std::upper_bound(
+      ranges.begin(), ranges.end(), addr,
+      [](uintptr_t addr, const std::pair<uint64_t, uint64_t>& r) { return addr < r.first; });
+  if (iter == ranges.begin()) {
+    return false;
+  }
+  --iter;
+  return addr < iter->second;
+}
+
+std::string_view CachingSymbolizer::SymbolizeJIT(UPIDSymbols* upid_symbols, uintptr_t addr) {
+  PerfMap* perf_map = upid_symbols->perf_map.get();
+  if (perf_map == nullptr) {
+    addr_str_ = AddrString(addr);
+    return addr_str_;
+  }
+
+  const std::string* symbol = perf_map->Lookup(addr);
+  if (symbol == nullptr && upid_symbols->perf_map_generation != generation_) {
+    // The runtime may have compiled new code since. Only the new lines of the file are read.
+    upid_symbols->perf_map_generation = generation_;
+    Status s = perf_map->Refresh();
+    if (!s.ok()) {
+      VLOG(2) << s.msg();
+    }
+    symbol = perf_map->Lookup(addr);
+  } else if (symbol != nullptr) {
+    ++stat_hits_;
+  }
+
+  // Unknown JIT addresses are not passed to the inner symbolizer, which would re-read the perf
+  // map of the process, or its whole symbol tables, for each of them.
+  if (symbol == nullptr) {
+    addr_str_ = AddrString(addr);
+    return addr_str_;
+  }
+  return *symbol;
+}
+
 SymbolizerFn CachingSymbolizer::GetSymbolizerFn(const struct upid_t& upid) {
   using std::placeholders::_1;
   const auto [iter, inserted] = symbol_caches_.try_emplace(upid, nullptr);
   if (inserted) {
-    iter->second = std::make_unique<SymbolCache>(symbolizer_->GetSymbolizerFn(upid));
+    iter->second = std::make_unique<UPIDSymbols>(symbolizer_->GetSymbolizerFn(upid));
+    ReadMappings(upid.pid, iter->second.get());
   }
   auto& cache = iter->second;
-  auto fn = std::bind(&CachingSymbolizer::Symbolize, this, cache.get(), _1);
+  auto fn = std::bind(&CachingSymbolizer::Symbolize, this, cache.get(), upid.pid, _1);
   return fn;
 }
 
 void CachingSymbolizer::DeleteUPID(const struct upid_t& upid) {
   // The inner map is owned by a unique_ptr; this will free the memory.
+  // The symbols cached by object are kept, as other processes may map the same objects.
   symbol_caches_.erase(upid);
 
   symbolizer_->DeleteUPID(upid);
 }
 
 size_t CachingSymbolizer::PerformEvictions() {
+  ++generation_;
+
+  // The shared cache evicts as it goes, to stay within its budget.
+  size_t evict_count = object_symbols_.TakeEvictCount();
+
   // Zero has a special meaning: no evictions.
   if (FLAGS_stirling_profiler_cache_eviction_threshold == 0) {
-    return 0;
+    return evict_count;
   }
 
   size_t active_entries = 0;
   for (const auto& sym_cache : symbol_caches_) {
-    active_entries += sym_cache.second->active_entries();
+    active_entries += sym_cache.second->cache.active_entries();
   }
 
-  size_t evict_count = 0;
   if (active_entries > FLAGS_stirling_profiler_cache_eviction_threshold) {
     for (const auto& sym_cache : symbol_caches_) {
-      evict_count += sym_cache.second->PerformEvictions();
+      evict_count += sym_cache.second->cache.PerformEvictions();
     }
   }
 
   return evict_count;
 }
 
-std::string_view CachingSymbolizer::Symbolize(SymbolCache* symbol_cache, const uintptr_t addr) {
+std::string_view CachingSymbolizer::Symbolize(UPIDSymbols* upid_symbols, uint32_t pid,
+                                              const uintptr_t addr) {
   ++stat_accesses_;
 
-  const SymbolCache::LookupResult result = symbol_cache->Lookup(addr);
+  const ObjectMapping* mapping = FindMapping(*upid_symbols, addr);
+  if (mapping == nullptr && InJITRange(*upid_symbols, addr)) {
+    return SymbolizeJIT(upid_symbols, addr);
+  }
+  if (mapping == nullptr && upid_symbols->mappings_generation != generation_) {
+    // The process may have mapped new objects since.
+    ReadMappings(pid, upid_symbols);
+    mapping = FindMapping(*upid_symbols, addr);
+    if (mapping == nullptr && InJITRange(*upid_symbols, addr)) {
+      return SymbolizeJIT(upid_symbols, addr);
+    }
+  }
+
+  if (mapping == nullptr) {
+    const SymbolCache::LookupResult result = upid_symbols->cache.Lookup(addr);
+    if (result.hit) {
+      ++stat_hits_;
+    }
+    return result.symbol;
+  }
 
-  if (result.hit) {
+  const uint64_t offset = addr - mapping->vmem_start + mapping->file_offset;
+  const std::string* symbol = object_symbols_.Find(mapping->object, offset);
+  if (symbol != nullptr) {
     ++stat_hits_;
+  } else {
+    std::string symbol_str(upid_symbols->symbolizer_fn(addr));
+    // Unknown symbols are cached as empty, their address being different in each process.
+    addr_str_ = AddrString(addr);
+    if (symbol_str == addr_str_) {
+      symbol_str.clear();
+    }
+    symbol = &object_symbols_.Insert(mapping->object, offset, std::move(symbol_str));
+  }
+
+  if (symbol->empty()) {
+    addr_str_ = AddrString(addr);
+    return addr_str_;
   }
-  return result.symbol;
+  return *symbol;
 }
 
 }  // namespace stirling
@@ -21,15 +21,19 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "src/common/system/proc_parser.h"
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
 #include "src/stirling/bpf_tools/bcc_symbolizer.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/obj_tools/elf_reader.h"
+#include "src/stirling/source_connectors/perf_profiler/perf_map.h"
 #include "src/stirling/source_connectors/perf_profiler/symbol_cache.h"
 #include "src/stirling/source_connectors/perf_profiler/types.h"
 
 DECLARE_uint64(stirling_profiler_cache_eviction_threshold);
+DECLARE_uint64(stirling_profiler_symbol_cache_bytes);
 
 namespace px {
 namespace stirling {
@@ -100,6 +104,12 @@ class ElfSymbolizer : public Symbolizer, public NotCopyMoveable {
 
 /**
  * A class that takes another symbolizer and adds a cache to it.
+ *
+ * Addresses in file mappings are cached by the object mapped (its build-id) and the offset in
+ * it, in a cache shared by all processes: replicas of the same binary, and processes that load
+ * the same libraries, reuse each other's symbols. Addresses in anonymous executable mappings (JIT
+ * code) are symbolized from the perf map of the process, read incrementally, and never by the
+ * inner symbolizer. Other addresses are cached per process.
  */
 class CachingSymbolizer : public Symbolizer {
  public:
@@ -113,14 +123,70 @@ class CachingSymbolizer : public Symbolizer {
   int64_t stat_accesses() const { return stat_accesses_; }
   int64_t stat_hits() const { return stat_hits_; }
 
+  const SymbolLRUCache& object_symbols() const { return object_symbols_; }
+
  private:
-  CachingSymbolizer() = default;
+  CachingSymbolizer() : object_symbols_(FLAGS_stirling_profiler_symbol_cache_bytes) {}
+
+  // An executable file mapping of a process.
+  struct ObjectMapping {
+    uint64_t vmem_start;
+    uint64_t vmem_end;
+    uint64_t file_offset;
+    SymbolLRUCache::ObjectID object;
+  };
+
+  struct UPIDSymbols {
+    explicit UPIDSymbols(SymbolizerFn fn) : symbolizer_fn(fn), cache(fn) {}
+
+    // The inner symbolizer of the process.
+    SymbolizerFn symbolizer_fn;
+
+    // Caches the symbols of the addresses outside of mappings.
+    SymbolCache cache;
+
+    // Sorted by address.
+    std::vector<ObjectMapping> mappings;
+
+    // The anonymous executable mappings, sorted by address.
+    std::vector<std::pair<uint64_t, uint64_t>> jit_ranges;
+
+    // The symbols of the JIT code, or nullptr if the process has no JIT mappings.
+    std::unique_ptr<PerfMap> perf_map;
 
-  std::string_view Symbolize(SymbolCache* symbol_cache, const uintptr_t addr);
+    // The value of generation_ when perf_map was refreshed, as it is refreshed at most once per
+    // generation when an address in a JIT range is not found in it.
+    int64_t perf_map_generation = -1;
+
+    // The value of generation_ when mappings were read, as they are refreshed at most once per
+    // generation when an address is found outside of them.
+    int64_t mappings_generation = -1;
+  };
+
+  std::string_view Symbolize(UPIDSymbols* upid_symbols, uint32_t pid, const uintptr_t addr);
+
+  void ReadMappings(uint32_t pid, UPIDSymbols* upid_symbols);
+  const ObjectMapping* FindMapping(const UPIDSymbols& upid_symbols, uintptr_t addr) const;
+  static bool InJITRange(const UPIDSymbols& upid_symbols, uintptr_t addr);
+  std::string_view SymbolizeJIT(UPIDSymbols* upid_symbols, uintptr_t addr);
+
+  // Returns the key that identifies the contents of a mapped file.
+  const std::string& ObjectKey(uint32_t pid, const system::ProcParser::ProcMap& map);
 
   std::unique_ptr<Symbolizer> symbolizer_;
 
-  absl::flat_hash_map<struct upid_t, std::unique_ptr<SymbolCache>> symbol_caches_;
+  absl::flat_hash_map<struct upid_t, std::unique_ptr<UPIDSymbols>> symbol_caches_;
+
+  SymbolLRUCache object_symbols_;
+
+  // The build-ids of the mapped files, by their device and inode, to read each file only once.
+  absl::flat_hash_map<std::pair<std::string, uint64_t>, std::string> object_keys_;
+
+  // Incremented by PerformEvictions(), once per iteration of the profiler.
+  int64_t generation_ = 0;
+
+  // Formatted addresses of unknown symbols.
+  std::string addr_str_;
 
   int64_t stat_accesses_ = 0;
   int64_t stat_hits_ = 0;
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/user_stack_unwinder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+
+#include "src/common/system/config.h"
+
+namespace px {
+namespace stirling {
+
+using obj_tools::ElfUnwindTable;
+
+void UserStackUnwinder::ReadMappings(uint32_t pid, ProcessMappings* process) {
+  process->generation = generation_;
+  process->mappings.clear();
+
+  const system::Config& config = system::Config::GetInstance();
+  std::vector<system::ProcParser::ProcMap> maps;
+  Status s = system::ProcParser(config).ReadProcMaps(pid, &maps);
+  if (!s.ok()) {
+    VLOG(1) << absl::Substitute("Could not read the mappings of pid $0: $1", pid, s.msg());
+    return;
+  }
+
+  for (const auto& map : maps) {
+    if (!map.executable() || map.inode == 0 || map.pathname.empty() || map.pathname[0] != '/') {
+      continue;
+    }
+    // The path in the maps is in the mount namespace of the process.
+    const std::filesystem::path host_path = config.proc_path() / std::to_string(pid) / "root" /
+                                            std::filesystem::path(map.pathname).relative_path();
+    StatusOr<std::shared_ptr<const ElfUnwindTable>> table_status = ElfUnwindTable::Get(host_path);
+    VLOG_IF(1, !table_status.ok()) << absl::Substitute(
+        "No unwind info for $0: $1", host_path.string(), table_status.msg());
+    process->mappings.push_back(Mapping{map.vmem_start, map.vmem_end, map.file_offset,
+                                        table_status.ConsumeValueOr(nullptr)});
+  }
+}
+
+const UserStackUnwinder::Mapping* UserStackUnwinder::FindMapping(uint32_t pid,
+                                                                 ProcessMappings* process,
+                                                                 uint64_t addr) {
+  auto find = [process, addr]() -> const Mapping* {
+    const auto& mappings = process->mappings;
+    auto iter =
+        std::upper_bound(mappings.begin(), mappings.end(), addr,
+                         [](uint64_t addr, const Mapping& m) { return addr < m.vmem_start; });
+    if (iter == mappings.begin()) {
+      return nullptr;
+    }
+    --iter;
+    return addr < iter->vmem_end ? &*iter : nullptr;
+  };
+
+  const Mapping* mapping = find();
+  if (mapping == nullptr && process->generation != generation_) {
+    // The process may have mapped new binaries since.
+    ReadMappings(pid, process);
+    mapping = find();
+  }
+  return mapping;
+}
+
+std::vector<uintptr_t> UserStackUnwinder::Unwind(const user_stack_snapshot_t& snapshot) {
+  std::unique_ptr<ProcessMappings>& process = processes_[snapshot.upid];
+  if (process == nullptr) {
+    process = std::make_unique<ProcessMappings>();
+  }
+
+  const uint64_t stack_begin = snapshot.sp;
+  const uint64_t stack_end =
+      stack_begin + std::min<uint64_t>(snapshot.stack_size, kUserStackSnapshotBytes);
+  auto read_stack = [&](uint64_t addr, uint64_t* val) {
+    if (addr < stack_begin || addr + sizeof(*val) > stack_end) {
+      return false;
+    }
+    std::memcpy(val, snapshot.stack + (addr - stack_begin), sizeof(*val));
+    return true;
+  };
+
+  std::vector<uintptr_t> addrs;
+  uint64_t pc = snapshot.ip;
+  uint64_t sp = snapshot.sp;
+  uint64_t bp = snapshot.bp;
+  bool bp_known = true;
+
+  while (true) {
+    addrs.push_back(pc);
+    if (addrs.size() == kMaxStackDepth) {
+      break;
+    }
+
+    // Past the innermost frame, pc is a return address, which may be the start of the next
+    // function if the call was the last instruction. The call itself is the instruction before.
+    const uint64_t lookup_pc = addrs.size() == 1 ? pc : pc - 1;
+    const Mapping* mapping = FindMapping(snapshot.upid.pid, process.get(), lookup_pc);
+    if (mapping == nullptr || mapping->table == nullptr) {
+      ++stat_truncated_;
+      break;
+    }
+    std::optional<uint64_t> addr =
+        mapping->table->FileOffsetToAddr(lookup_pc - mapping->vmem_start + mapping->file_offset);
+    const ElfUnwindTable::Row* row = addr.has_value() ? mapping->table->Find(*addr) : nullptr;
+    if (row == nullptr) {
+      // The outermost frames, e.g. _start, end the stack without unwind info.
+      break;
+    }
+    if (row->cfa_rule == ElfUnwindTable::CFARule::kExpression ||
+        (row->cfa_rule == ElfUnwindTable::CFARule::kBP && !bp_known)) {
+      ++stat_truncated_;
+      break;
+    }
+
+    const uint64_t cfa = (row->cfa_rule == ElfUnwindTable::CFARule::kSP ? sp : bp) +
+                         static_cast<int64_t>(row->cfa_offset);
+    uint64_t return_addr;
+    if (!read_stack(cfa - sizeof(return_addr), &return_addr)) {
+      ++stat_truncated_;
+      break;
+    }
+    if (row->bp_rule == ElfUnwindTable::BPRule::kOffset) {
+      bp_known = read_stack(cfa + row->bp_offset, &bp);
+    } else if (row->bp_rule == ElfUnwindTable::BPRule::kUndefined) {
+      bp_known = false;
+    }
+
+    // The stack grows down, so each caller's frame is above the previous one.
+    if (return_addr == 0 || cfa <= sp) {
+      break;
+    }
+    sp = cfa;
+    pc = return_addr;
+  }
+  return addrs;
+}
+
+void UserStackUnwinder::DeleteUPID(const struct upid_t& upid) { processes_.erase(upid); }
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/system/proc_parser.h"
+#include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
+#include "src/stirling/obj_tools/elf_unwind_table.h"
+#include "src/stirling/source_connectors/perf_profiler/bcc_bpf_intf/stack_event.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * Unwinds the user stack snapshots taken by BPF, for the binaries without frame pointers, with
+ * the call frame information (.eh_frame) of the mapped binaries.
+ *
+ * The unwind tables are built once per binary, and shared by all the processes that map it.
+ * Unwinding stops at the first frame without unwind info, or that is beyond the snapshot.
+ */
+class UserStackUnwinder {
+ public:
+  // The most frames unwound, same as the kernel's default for get_stackid().
+  static constexpr int kMaxStackDepth = 127;
+
+  /**
+   * Returns the instruction addresses of the frames of the snapshot, innermost first, like the
+   * stack traces collected by BPF.
+   */
+  std::vector<uintptr_t> Unwind(const user_stack_snapshot_t& snapshot);
+
+  void DeleteUPID(const struct upid_t& upid);
+
+  // Once per iteration of the profiler: the mappings of the processes are re-read at most once
+  // per iteration, when an address is found outside of them.
+  void AdvanceGeneration() { ++generation_; }
+
+  // Number of stacks that were cut short, for lack of unwind info or of stack.
+  int64_t stat_truncated() const { return stat_truncated_; }
+
+ private:
+  struct Mapping {
+    uint64_t vmem_start;
+    uint64_t vmem_end;
+    uint64_t file_offset;
+    // Null if the file has no unwind info.
+    std::shared_ptr<const obj_tools::ElfUnwindTable> table;
+  };
+
+  struct ProcessMappings {
+    // Sorted by address.
+    std::vector<Mapping> mappings;
+    int64_t generation = -1;
+  };
+
+  void ReadMappings(uint32_t pid, ProcessMappings* process);
+  const Mapping* FindMapping(uint32_t pid, ProcessMappings* process, uint64_t addr);
+
+  absl::flat_hash_map<struct upid_t, std::unique_ptr<ProcessMappings>> processes_;
+  int64_t generation_ = 0;
+  int64_t stat_truncated_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
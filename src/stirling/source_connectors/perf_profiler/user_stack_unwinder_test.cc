@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/perf_profiler/user_stack_unwinder.h"
+
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace test {
+
+// Takes a snapshot of the registers and the stack like the BPF code does, along with the return
+// addresses found by glibc's own unwinder, for comparison.
+__attribute__((noinline)) void CaptureStack(user_stack_snapshot_t* snapshot,
+                                            std::vector<void*>* return_addrs) {
+  uint64_t ip;
+  uint64_t sp;
+  uint64_t bp;
+  asm volatile("lea 0(%%rip), %0\n mov %%rsp, %1\n mov %%rbp, %2" : "=r"(ip), "=r"(sp), "=r"(bp));
+
+  pthread_attr_t attr;
+  pthread_getattr_np(pthread_self(), &attr);
+  void* stack_addr;
+  size_t stack_size;
+  pthread_attr_getstack(&attr, &stack_addr, &stack_size);
+  pthread_attr_destroy(&attr);
+  const uint64_t stack_top = reinterpret_cast<uint64_t>(stack_addr) + stack_size;
+
+  snapshot->upid.pid = getpid();
+  snapshot->upid.start_time_ticks = 0;
+  snapshot->ip = ip;
+  snapshot->sp = sp;
+  snapshot->bp = bp;
+  snapshot->stack_size = std::min<uint64_t>(kUserStackSnapshotBytes, stack_top - sp);
+  std::memcpy(snapshot->stack, reinterpret_cast<const void*>(sp), snapshot->stack_size);
+
+  return_addrs->resize(64);
+  return_addrs->resize(backtrace(return_addrs->data(), return_addrs->size()));
+}
+
+__attribute__((noinline)) void Caller2(user_stack_snapshot_t* snapshot,
+                                       std::vector<void*>* return_addrs) {
+  CaptureStack(snapshot, return_addrs);
+  // Prevents a tail call.
+  asm volatile("");
+}
+
+__attribute__((noinline)) void Caller1(user_stack_snapshot_t* snapshot,
+                                       std::vector<void*>* return_addrs) {
+  Caller2(snapshot, return_addrs);
+  asm volatile("");
+}
+
+}  // namespace test
+
+namespace px {
+namespace stirling {
+
+TEST(UserStackUnwinderTest, UnwindsLikeBacktrace) {
+  auto snapshot = std::make_unique<user_stack_snapshot_t>();
+  std::vector<void*> return_addrs;
+  test::Caller1(snapshot.get(), &return_addrs);
+  ASSERT_GE(return_addrs.size(), 4);
+
+  UserStackUnwinder unwinder;
+  std::vector<uintptr_t> addrs = unwinder.Unwind(*snapshot);
+  ASSERT_GE(addrs.size(), 4);
+  EXPECT_EQ(addrs[0], snapshot->ip);
+
+  // The first frame of backtrace() is in CaptureStack(), after the snapshot. The callers are the
+  // same: Caller2(), Caller1(), and this test.
+  for (size_t i = 1; i < 4; ++i) {
+    EXPECT_EQ(addrs[i], reinterpret_cast<uintptr_t>(return_addrs[i])) << i;
+  }
+}
+
+TEST(UserStackUnwinderTest, TruncatedSnapshot) {
+  auto snapshot = std::make_unique<user_stack_snapshot_t>();
+  std::vector<void*> return_addrs;
+  test::Caller1(snapshot.get(), &return_addrs);
+
+  // Without the stack, only the sampled instruction is known.
+  snapshot->stack_size = 0;
+  UserStackUnwinder unwinder;
+  EXPECT_THAT(unwinder.Unwind(*snapshot), ::testing::ElementsAre(snapshot->ip));
+  EXPECT_EQ(unwinder.stat_truncated(), 1);
+}
+
+}  // namespace stirling
+}  // namespace px
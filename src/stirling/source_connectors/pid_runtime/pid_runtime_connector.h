@@ -62,6 +62,7 @@ class PIDRuntimeConnector : public SourceConnector, public bpf_tools::BCCWrapper
   }
 
   Status InitImpl() override;
+  bool UsesBPF() const override { return true; }
   Status StopImpl() override;
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
 
@@ -98,6 +98,26 @@ void PIDCPUUseBPFTraceConnector::TransferDataImpl(ConnectorContext* /* ctx */,
     DCHECK_EQ(4ULL, key.size()) << "Expected uint32_t key";
     uint64_t pid = *(reinterpret_cast<uint32_t*>(key.data()));
 
+    // Get the last cpu time from the BPFTraceMap from previous call to this function.
+    uint64_t last_cputime = 0;
+    last_result_it = BPFTraceMapSearch(last_result_times_, last_result_it, pid);
+    if (last_result_it != last_result_times_.end()) {
+      uint32_t found_pid = *(reinterpret_cast<uint32_t*>(last_result_it->first.data()));
+      if (found_pid == pid) {
+        last_cputime = *(reinterpret_cast<uint64_t*>(last_result_it->second.data()));
+      }
+    }
+    // The pid exited, and was reused since the previous call.
+    if (cputime < last_cputime) {
+      last_cputime = 0;
+    }
+
+    // Only output the pids that ran since the previous call, so the output scales with the
+    // activity rather than with the number of pids in the map.
+    if (cputime == last_cputime) {
+      continue;
+    }
+
     // Get the name from the auxiliary BPFTraceMap for names.
     std::string name("-");
     pid_name_it = BPFTraceMapSearch(pid_name_pairs, pid_name_it, pid);
@@ -111,16 +131,6 @@ void PIDCPUUseBPFTraceConnector::TransferDataImpl(ConnectorContext* /* ctx */,
       }
     }
 
-    // Get the last cpu time from the BPFTraceMap from previous call to this function.
-    uint64_t last_cputime = 0;
-    last_result_it = BPFTraceMapSearch(last_result_times_, last_result_it, pid);
-    if (last_result_it != last_result_times_.end()) {
-      uint32_t found_pid = *(reinterpret_cast<uint32_t*>(last_result_it->first.data()));
-      if (found_pid == pid) {
-        last_cputime = *(reinterpret_cast<uint64_t*>(last_result_it->second.data()));
-      }
-    }
-
     DataTable::RecordBuilder<&kTable> r(data_table);
     r.Append<r.ColIndex("time_")>(timestamp + ClockRealTimeOffset());
     r.Append<r.ColIndex("pid")>(pid);
@@ -77,6 +77,7 @@ class PIDCPUUseBPFTraceConnector : public SourceConnector, public bpf_tools::BPF
   }
 
   Status InitImpl() override;
+  bool UsesBPF() const override { return true; }
   Status StopImpl() override;
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
 
@@ -42,7 +42,7 @@ Status ProcessStatsConnector::StopImpl() { return Status::OK(); }
 
 void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
                                                       DataTable* data_table) {
-  const absl::flat_hash_map<md::UPID, md::PIDInfoUPtr>& pid_info_by_upid = ctx->GetPIDInfoMap();
+  const absl::flat_hash_map<md::UPID, md::PIDInfoSPtr>& pid_info_by_upid = ctx->GetPIDInfoMap();
 
   int64_t timestamp = CurrentTimeNS();
 
@@ -57,17 +57,10 @@ void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
     int32_t pid = upid.pid();
     // TODO(zasgar): We should double check the process start time to make sure it still the same
     // PID.
-    auto s1 = proc_parser_->ParseProcPIDStat(pid, &stats);
-    if (!s1.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Failed to fetch cpu stat info for PID ($0). Error=\"$1\" skipping.", pid, s1.msg());
-      continue;
-    }
-
-    auto s2 = proc_parser_->ParseProcPIDStatIO(pid, &stats);
-    if (!s2.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Failed to fetch IO stat info for PID ($0). Error=\"$1\" skipping.", pid, s2.msg());
+    auto s = stats_reader_->ReadStats(pid, &stats);
+    if (!s.ok()) {
+      VLOG(1) << absl::Substitute("Failed to fetch stat info for PID ($0). Error=\"$1\" skipping.",
+                                  pid, s.msg());
       continue;
     }
 
@@ -90,6 +83,9 @@ void ProcessStatsConnector::TransferProcessStatsTable(ConnectorContext* ctx,
     r.Append<r.ColIndex("read_bytes")>(stats.read_bytes);
     r.Append<r.ColIndex("write_bytes")>(stats.write_bytes);
   }
+
+  // Don't hold on to the files of processes that are no longer sampled.
+  stats_reader_->CloseUnread();
 }
 
 void ProcessStatsConnector::TransferDataImpl(ConnectorContext* ctx,
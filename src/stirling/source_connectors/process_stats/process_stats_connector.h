@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "src/common/base/base.h"
+#include "src/common/system/process_stats_reader.h"
 #include "src/common/system/system.h"
 #include "src/shared/metadata/metadata.h"
 #include "src/stirling/core/canonical_types.h"
@@ -58,13 +59,13 @@ class ProcessStatsConnector : public SourceConnector {
  protected:
   explicit ProcessStatsConnector(std::string_view source_name)
       : SourceConnector(source_name, kTables) {
-    proc_parser_ = std::make_unique<system::ProcParser>(sysconfig_);
+    stats_reader_ = std::make_unique<system::ProcessStatsReader>(sysconfig_);
   }
 
  private:
   void TransferProcessStatsTable(ConnectorContext* ctx, DataTable* data_table);
 
-  std::unique_ptr<system::ProcParser> proc_parser_;
+  std::unique_ptr<system::ProcessStatsReader> stats_reader_;
 };
 
 }  // namespace stirling
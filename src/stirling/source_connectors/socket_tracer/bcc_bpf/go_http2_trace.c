@@ -21,6 +21,7 @@
 
 // LINT_C_FILE: Do not remove this line. It ensures cpplint treats this as a C file.
 
+#include "src/stirling/bpf_tools/bcc_bpf/events.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf/go_trace_common.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf/macros.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/go_grpc_types.h"
@@ -28,8 +29,8 @@
 
 #define MAX_HEADER_COUNT 64
 
-BPF_PERF_OUTPUT(go_grpc_header_events);
-BPF_PERF_OUTPUT(go_grpc_data_events);
+BPF_EVENT_OUTPUT(go_grpc_header_events);
+BPF_EVENT_OUTPUT(go_grpc_data_events);
 
 // BPF programs are limited to a 512-byte stack. We store this value per CPU
 // and use it as a heap allocated value.
@@ -215,7 +216,7 @@ static __inline void submit_headers(struct pt_regs* ctx, enum http2_probe_type_t
   for (unsigned int i = 0; i < MAX_HEADER_COUNT; ++i) {
     if (i < fields_len) {
       fill_header_field(&event, fields_ptr + i * kSizeOfHeaderField, symaddrs);
-      go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+      BPF_EVENT_SUBMIT(ctx, go_grpc_header_events, &event, sizeof(event));
     }
   }
 
@@ -224,7 +225,7 @@ static __inline void submit_headers(struct pt_regs* ctx, enum http2_probe_type_t
     event.name.size = 0;
     event.value.size = 0;
     event.attr.end_stream = true;
-    go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+    BPF_EVENT_SUBMIT(ctx, go_grpc_header_events, &event, sizeof(event));
   }
 }
 
@@ -245,7 +246,7 @@ static __inline void submit_header(struct pt_regs* ctx, enum http2_probe_type_t
   event.attr.stream_id = attr->stream_id;
 
   fill_header_field(&event, header_field_ptr, symaddrs);
-  go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+  BPF_EVENT_SUBMIT(ctx, go_grpc_header_events, &event, sizeof(event));
 }
 
 // TODO(oazizi): Remove this struct; Use DWARF instead.
@@ -747,7 +748,7 @@ int probe_http_http2writeResHeaders_write_frame(struct pt_regs* ctx) {
     event.name.size = 0;
     event.value.size = 0;
     event.attr.end_stream = true;
-    go_grpc_header_events.perf_submit(ctx, &event, sizeof(event));
+    BPF_EVENT_SUBMIT(ctx, go_grpc_header_events, &event, sizeof(event));
   }
 
   // TODO(oazizi): We are leaking BPF map entries until this line is activated,
@@ -806,7 +807,7 @@ static __inline void go_http2_submit_data(struct pt_regs* ctx, enum http2_probe_
 
   if (data_buf_size_minus_1 < MAX_DATA_SIZE) {
     bpf_probe_read(info->data, data_buf_size, data_ptr);
-    go_grpc_data_events.perf_submit(ctx, info, sizeof(info->attr) + data_buf_size);
+    BPF_EVENT_SUBMIT(ctx, go_grpc_data_events, info, sizeof(info->attr) + data_buf_size);
   }
 }
 
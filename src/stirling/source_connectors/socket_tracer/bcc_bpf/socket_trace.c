@@ -28,6 +28,7 @@
 
 #define socklen_t size_t
 
+#include "src/stirling/bpf_tools/bcc_bpf/events.h"
 #include "src/stirling/bpf_tools/bcc_bpf/task_struct_utils.h"
 #include "src/stirling/bpf_tools/bcc_bpf/utils.h"
 #include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
@@ -43,13 +44,13 @@ const int32_t kInvalidFD = -1;
 // is reported to user-space. It applies to read and write traffic combined.
 const int kConnStatsDataThreshold = 65536;
 
-// This is the perf buffer for BPF program to export data from kernel to user space.
-BPF_PERF_OUTPUT(socket_data_events);
-BPF_PERF_OUTPUT(socket_control_events);
-BPF_PERF_OUTPUT(conn_stats_events);
+// These are the perf or ring buffers for BPF program to export data from kernel to user space.
+BPF_EVENT_OUTPUT(socket_data_events);
+BPF_EVENT_OUTPUT(socket_control_events);
+BPF_EVENT_OUTPUT(conn_stats_events);
 
 // This output is used to export notification of processes that have performed an mmap.
-BPF_PERF_OUTPUT(mmap_events);
+BPF_EVENT_OUTPUT(mmap_events);
 
 // This control_map is a bit-mask that controls which endpoints are traced in a connection.
 // The bits are defined in endpoint_role_t enum, kRoleClient or kRoleServer. kRoleUnknown is not
@@ -57,6 +58,11 @@ BPF_PERF_OUTPUT(mmap_events);
 // There is a control map element for each protocol.
 BPF_PERCPU_ARRAY(control_map, uint64_t, kNumProtocols);
 
+// The maximum number of bytes of each data event that are copied to user-space, per protocol.
+// The rest of the event is only reported through its size, and user-space fills it in.
+// 0 means that the whole event is copied (up to MAX_MSG_SIZE).
+BPF_PERCPU_ARRAY(capture_size_map, uint64_t, kNumProtocols);
+
 // Map from user-space file descriptors to the connections obtained from accept() syscall.
 // Tracks connection from accept() -> close().
 // Key is {tgid, fd}.
@@ -109,6 +115,10 @@ BPF_PERCPU_ARRAY(conn_stats_event_buffer_heap, struct conn_stats_event_t, 1);
 // number of arrays with only 1 element.
 BPF_PERCPU_ARRAY(control_values, int64_t, kNumControlValues);
 
+// The TGIDs to trace, when the kTracedTGIDsFilterIndex control value is set. Populated by
+// user-space from the processes of the selected K8s namespaces.
+BPF_HASH(traced_tgids_map, uint32_t, bool, 65536);
+
 /***********************************************************
  * General helper functions
  ***********************************************************/
@@ -174,7 +184,8 @@ static __inline struct socket_data_event_t* fill_socket_data_event(
 static __inline struct conn_stats_event_t* fill_conn_stats_event(
     const struct conn_info_t* conn_info) {
   uint32_t kZero = 0;
-  struct conn_stats_event_t* event = conn_stats_event_buffer_heap.lookup(&kZero);
+  struct conn_stats_event_t* event;
+  BPF_EVENT_RESERVE(conn_stats_events, event, conn_stats_event_buffer_heap.lookup(&kZero));
   if (event == NULL) {
     return NULL;
   }
@@ -228,6 +239,15 @@ static __inline bool is_stirling_tgid(const uint32_t tgid) {
   return *stirling_tgid == tgid;
 }
 
+static __inline bool conn_stats_polled() {
+  int idx = kConnStatsPollingIndex;
+  int64_t* polled = control_values.lookup(&idx);
+  if (polled == NULL) {
+    return false;
+  }
+  return *polled != 0;
+}
+
 enum target_tgid_match_result_t {
   TARGET_TGID_UNSPECIFIED,
   TARGET_TGID_ALL,
@@ -235,15 +255,24 @@ enum target_tgid_match_result_t {
   TARGET_TGID_UNMATCHED,
 };
 
+static __inline bool is_traced_tgid(const uint32_t tgid) {
+  int idx = kTracedTGIDsFilterIndex;
+  int64_t* filter_enabled = control_values.lookup(&idx);
+  if (filter_enabled == NULL || *filter_enabled == 0) {
+    return true;
+  }
+  return traced_tgids_map.lookup(&tgid) != NULL;
+}
+
 static __inline enum target_tgid_match_result_t match_trace_tgid(const uint32_t tgid) {
   int idx = kTargetTGIDIndex;
   int64_t* target_tgid = control_values.lookup(&idx);
   if (target_tgid == NULL) {
-    return TARGET_TGID_UNSPECIFIED;
+    return is_traced_tgid(tgid) ? TARGET_TGID_UNSPECIFIED : TARGET_TGID_UNMATCHED;
   }
   if (*target_tgid < 0) {
-    // Negative value means trace all.
-    return TARGET_TGID_ALL;
+    // Negative value means trace all, subject to the traced TGIDs filter.
+    return is_traced_tgid(tgid) ? TARGET_TGID_ALL : TARGET_TGID_UNMATCHED;
   }
   if (*target_tgid == tgid) {
     return TARGET_TGID_MATCHED;
@@ -344,37 +373,52 @@ static __inline void submit_new_conn(struct pt_regs* ctx, uint32_t tgid, int32_t
     return;
   }
 
-  struct socket_control_event_t control_event = {};
-  control_event.type = kConnOpen;
-  control_event.timestamp_ns = bpf_ktime_get_ns();
-  control_event.conn_id = conn_info.conn_id;
-  control_event.open.addr = conn_info.addr;
-  control_event.open.role = conn_info.role;
+  struct socket_control_event_t control_event_buf = {};
+  struct socket_control_event_t* control_event;
+  BPF_EVENT_RESERVE(socket_control_events, control_event, &control_event_buf);
+  if (control_event == NULL) {
+    return;
+  }
+  control_event->type = kConnOpen;
+  control_event->timestamp_ns = bpf_ktime_get_ns();
+  control_event->conn_id = conn_info.conn_id;
+  control_event->open.addr = conn_info.addr;
+  control_event->open.role = conn_info.role;
 
-  socket_control_events.perf_submit(ctx, &control_event, sizeof(struct socket_control_event_t));
+  BPF_EVENT_COMMIT(ctx, socket_control_events, control_event);
 }
 
 static __inline void submit_close_event(struct pt_regs* ctx, struct conn_info_t* conn_info) {
-  struct socket_control_event_t control_event = {};
-  control_event.type = kConnClose;
-  control_event.timestamp_ns = bpf_ktime_get_ns();
-  control_event.conn_id = conn_info->conn_id;
-  control_event.close.rd_bytes = conn_info->rd_bytes;
-  control_event.close.wr_bytes = conn_info->wr_bytes;
+  struct socket_control_event_t control_event_buf = {};
+  struct socket_control_event_t* control_event;
+  BPF_EVENT_RESERVE(socket_control_events, control_event, &control_event_buf);
+  if (control_event == NULL) {
+    return;
+  }
+  control_event->type = kConnClose;
+  control_event->timestamp_ns = bpf_ktime_get_ns();
+  control_event->conn_id = conn_info->conn_id;
+  control_event->close.rd_bytes = conn_info->rd_bytes;
+  control_event->close.wr_bytes = conn_info->wr_bytes;
 
-  socket_control_events.perf_submit(ctx, &control_event, sizeof(struct socket_control_event_t));
+  BPF_EVENT_COMMIT(ctx, socket_control_events, control_event);
 }
 
 // Writes the input buf to event, and submits the event to the corresponding perf buffer.
 // Returns the bytes output from the input buf. Note that is not the total bytes submitted to the
 // perf buffer, which includes additional metadata.
 static __inline void perf_submit_buf(struct pt_regs* ctx, const enum traffic_direction_t direction,
-                                     const char* buf, size_t buf_size,
+                                     const char* buf, size_t buf_size, const size_t capture_size,
                                      struct conn_info_t* conn_info,
                                      struct socket_data_event_t* event) {
   // Record original size of packet. This may get truncated below before submit.
   event->attr.msg_size = buf_size;
 
+  // Only copy the bytes that the protocol wants to see.
+  if (capture_size > 0 && buf_size > capture_size) {
+    buf_size = capture_size;
+  }
+
   // This rest of this function has been written carefully to keep the BPF verifier happy in older
   // kernels, so please take care when modifying.
   //
@@ -434,13 +478,14 @@ static __inline void perf_submit_buf(struct pt_regs* ctx, const enum traffic_dir
   // If-statement is redundant, but is required to keep the 4.14 verifier happy.
   if (amount_copied > 0) {
     event->attr.msg_buf_size = amount_copied;
-    socket_data_events.perf_submit(ctx, event, sizeof(event->attr) + amount_copied);
+    BPF_EVENT_SUBMIT(ctx, socket_data_events, event, sizeof(event->attr) + amount_copied);
   }
 }
 
 static __inline void perf_submit_wrapper(struct pt_regs* ctx,
                                          const enum traffic_direction_t direction, const char* buf,
-                                         const size_t buf_size, struct conn_info_t* conn_info,
+                                         const size_t buf_size, const size_t capture_size,
+                                         struct conn_info_t* conn_info,
                                          struct socket_data_event_t* event) {
   int bytes_sent = 0;
   unsigned int i;
@@ -450,7 +495,8 @@ static __inline void perf_submit_wrapper(struct pt_regs* ctx,
     const int bytes_remaining = buf_size - bytes_sent;
     const size_t current_size =
         (bytes_remaining > MAX_MSG_SIZE && (i != CHUNK_LIMIT - 1)) ? MAX_MSG_SIZE : bytes_remaining;
-    perf_submit_buf(ctx, direction, buf + bytes_sent, current_size, conn_info, event);
+    perf_submit_buf(ctx, direction, buf + bytes_sent, current_size, capture_size, conn_info,
+                    event);
     bytes_sent += current_size;
 
     // Move the position for the next event.
@@ -461,7 +507,8 @@ static __inline void perf_submit_wrapper(struct pt_regs* ctx,
 static __inline void perf_submit_iovecs(struct pt_regs* ctx,
                                         const enum traffic_direction_t direction,
                                         const struct iovec* iov, const size_t iovlen,
-                                        const size_t total_size, struct conn_info_t* conn_info,
+                                        const size_t total_size, const size_t capture_size,
+                                        struct conn_info_t* conn_info,
                                         struct socket_data_event_t* event) {
   // NOTE: The syscalls for scatter buffers, {send,recv}msg()/{write,read}v(), access buffers in
   // array order. That means they read or fill iov[0], then iov[1], and so on. They return the total
@@ -478,7 +525,7 @@ static __inline void perf_submit_iovecs(struct pt_regs* ctx,
 
     // TODO(oazizi/yzhao): Should switch this to go through perf_submit_wrapper.
     //                     We don't have the BPF instruction count to do so right now.
-    perf_submit_buf(ctx, direction, iov_cpy.iov_base, iov_size, conn_info, event);
+    perf_submit_buf(ctx, direction, iov_cpy.iov_base, iov_size, capture_size, conn_info, event);
     bytes_sent += iov_size;
 
     // Move the position for the next event.
@@ -660,6 +707,11 @@ static __inline void update_conn_stats(struct pt_regs* ctx, struct conn_info_t*
       break;
   }
 
+  // User-space reads the updated counts from conn_info_map instead.
+  if (conn_stats_polled()) {
+    return;
+  }
+
   // Only send event if there's been enough of a change.
   // TODO(oazizi): Add elapsed time since last send as a triggering condition too.
   uint64_t total_bytes = conn_info->wr_bytes + conn_info->rd_bytes;
@@ -668,7 +720,7 @@ static __inline void update_conn_stats(struct pt_regs* ctx, struct conn_info_t*
   if (meets_activity_threshold) {
     struct conn_stats_event_t* event = fill_conn_stats_event(conn_info);
     if (event != NULL) {
-      conn_stats_events.perf_submit(ctx, event, sizeof(struct conn_stats_event_t));
+      BPF_EVENT_COMMIT(ctx, conn_stats_events, event);
     }
 
     conn_info->last_reported_bytes = conn_info->rd_bytes + conn_info->wr_bytes;
@@ -739,14 +791,21 @@ static __inline void process_data(const bool vecs, struct pt_regs* ctx, uint64_t
         return;
       }
 
+      // Looked up once per syscall, rather than for every chunk submitted below.
+      uint32_t protocol = conn_info->protocol;
+      uint64_t* capture_size_ptr = capture_size_map.lookup(&protocol);
+      const size_t capture_size = (capture_size_ptr == NULL) ? 0 : *capture_size_ptr;
+
       // TODO(yzhao): Same TODO for split the interface.
       if (!vecs) {
-        perf_submit_wrapper(ctx, direction, args->buf, bytes_count, conn_info, event);
+        perf_submit_wrapper(ctx, direction, args->buf, bytes_count, capture_size, conn_info,
+                            event);
       } else {
         // TODO(yzhao): iov[0] is copied twice, once in calling update_traffic_class(), and here.
         // This happens to the write probes as well, but the calls are placed in the entry and
         // return probes respectively. Consider remove one copy.
-        perf_submit_iovecs(ctx, direction, args->iov, args->iovlen, bytes_count, conn_info, event);
+        perf_submit_iovecs(ctx, direction, args->iov, args->iovlen, bytes_count, capture_size,
+                           conn_info, event);
       }
     }
   }
@@ -829,7 +888,7 @@ static __inline void process_syscall_sendfile(struct pt_regs* ctx, uint64_t id,
     event->attr.pos = conn_info->wr_bytes;
     event->attr.msg_size = bytes_count;
     event->attr.msg_buf_size = 0;
-    socket_data_events.perf_submit(ctx, event, sizeof(event->attr));
+    BPF_EVENT_SUBMIT(ctx, socket_data_events, event, sizeof(event->attr));
   }
 
   update_conn_stats(ctx, conn_info, kEgress, bytes_count);
@@ -871,7 +930,7 @@ static __inline void process_syscall_close(struct pt_regs* ctx, uint64_t id,
     struct conn_stats_event_t* event = fill_conn_stats_event(conn_info);
     if (event != NULL) {
       event->conn_events = event->conn_events | CONN_CLOSE;
-      conn_stats_events.perf_submit(ctx, event, sizeof(struct conn_stats_event_t));
+      BPF_EVENT_COMMIT(ctx, conn_stats_events, event);
     }
   }
 
@@ -1508,7 +1567,7 @@ int syscall__probe_entry_mmap(struct pt_regs* ctx) {
   upid.tgid = id >> 32;
   upid.start_time_ticks = get_tgid_start_time();
 
-  mmap_events.perf_submit(ctx, &upid, sizeof(upid));
+  BPF_EVENT_SUBMIT(ctx, mmap_events, &upid, sizeof(upid));
 
   return 0;
 }
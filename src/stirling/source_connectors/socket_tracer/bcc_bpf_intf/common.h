@@ -122,5 +122,10 @@ enum control_value_index_t {
   // * Support efficient lookup inside bpf to minimize overhead.
   kTargetTGIDIndex = 0,
   kStirlingTGIDIndex,
+  // When non-zero, user-space polls the connection stats from conn_info_map, and BPF only
+  // reports them when the connection is closed.
+  kConnStatsPollingIndex,
+  // When non-zero, only the TGIDs in traced_tgids_map are traced.
+  kTracedTGIDsFilterIndex,
   kNumControlValues,
 };
@@ -71,7 +71,11 @@ inline std::string ToString(const struct go_grpc_data_event_t::data_attr_t& attr
 
 struct HTTP2DataEvent {
   HTTP2DataEvent() : attr{}, payload{} {}
-  explicit HTTP2DataEvent(const void* data) {
+  explicit HTTP2DataEvent(const void* data) { Assign(data); }
+
+  // Copies the event from BPF. Reuses the capacity of payload, so that an event object that is
+  // assigned repeatedly does not allocate for every event.
+  void Assign(const void* data) {
     memcpy(&attr, static_cast<const char*>(data) + offsetof(go_grpc_data_event_t, attr),
            sizeof(go_grpc_data_event_t::data_attr_t));
 
@@ -27,6 +27,7 @@
 #define PX_AF_UNKNOWN 0xff
 
 const char kControlMapName[] = "control_map";
+const char kCaptureSizeMapName[] = "capture_size_map";
 const uint64_t kSocketTraceNothing = 0;
 
 const int64_t kTraceAllTGIDs = -1;
@@ -23,6 +23,7 @@
 #include <cstring>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include <absl/hash/hash.h>
@@ -96,11 +97,45 @@ struct SocketDataEvent {
   }
 
   socket_data_event_t::attr_t attr;
-  // TODO(oazizi/yzhao): Eventually, we will write the data into a buffer that can be used for later
-  // parsing. By then, msg can be changed to string_view.
   std::string msg;
 };
 
+/**
+ * A view of a data event, whose msg is not copied, but points into either the perf buffer or a
+ * SocketDataEvent. The ingestion path uses it to copy the msg from the perf buffer directly into
+ * the DataStreamBuffer of the connection.
+ *
+ * A view of the perf buffer is only valid during the perf buffer callback.
+ */
+struct SocketDataEventView {
+  explicit SocketDataEventView(const void* data) {
+    // See SocketDataEvent for why this is a memcpy.
+    memcpy(&attr, static_cast<const char*>(data) + offsetof(socket_data_event_t, attr),
+           sizeof(socket_data_event_t::attr_t));
+    msg = std::string_view(static_cast<const char*>(data) + offsetof(socket_data_event_t, msg),
+                           attr.msg_buf_size);
+  }
+
+  explicit SocketDataEventView(const SocketDataEvent& event) : attr(event.attr), msg(event.msg) {}
+
+  /**
+   * Returns false for the events that SocketDataEvent changes while copying them: a length
+   * header is prepended to the events that have one in their attributes, and filler is appended
+   * to the events whose data was not transferred. Those events must go through SocketDataEvent.
+   */
+  bool ViewableInPlace() const {
+    return !attr.prepend_length_header && attr.msg_buf_size == attr.msg_size;
+  }
+
+  std::string ToString() const {
+    return absl::Substitute("attr:[$0] msg_size:$1 msg:[$2]", ::ToString(attr), msg.size(),
+                            BytesToString<bytes_format::HexAsciiMix>(msg));
+  }
+
+  socket_data_event_t::attr_t attr;
+  std::string_view msg;
+};
+
 }  // namespace stirling
 }  // namespace px
 
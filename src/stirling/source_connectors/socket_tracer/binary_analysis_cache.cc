@@ -0,0 +1,267 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/binary_analysis_cache.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/escaping.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_join.h>
+#include <absl/strings/str_split.h>
+#include <magic_enum.hpp>
+
+#include "src/common/base/base.h"
+#include "src/common/fs/fs_wrapper.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::stirling::bpf_tools::BPFProbeAttachType;
+using ::px::stirling::bpf_tools::UProbeSpec;
+
+StatusOr<BinaryKey> BinaryKey::Create(const std::filesystem::path& binary) {
+  struct stat st;
+  if (stat(binary.c_str(), &st) != 0) {
+    return error::Internal("Could not stat $0: $1", binary.string(), std::strerror(errno));
+  }
+  BinaryKey key;
+  key.inode = st.st_ino;
+  key.size = st.st_size;
+  key.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 * 1000 * 1000 + st.st_mtim.tv_nsec;
+  return key;
+}
+
+//-----------------------------------------------------------------------------
+// Serialization of GoBinaryAnalysis
+//-----------------------------------------------------------------------------
+
+// The persisted analyses are a line of space separated fields per property. The symaddrs structs
+// are stored as hex encoded bytes, so the first line records the sizes of the structs, in
+// addition to the format version; files written with other struct layouts are ignored.
+// Bump the version whenever the computation of the symaddrs changes.
+
+namespace {
+
+constexpr int kFormatVersion = 1;
+
+std::string FormatHeader() {
+  return absl::Substitute("go_binary_analysis $0 $1 $2 $3", kFormatVersion,
+                          sizeof(struct go_common_symaddrs_t), sizeof(struct go_tls_symaddrs_t),
+                          sizeof(struct go_http2_symaddrs_t));
+}
+
+template <typename TSymAddrs>
+void AppendSymAddrs(std::string* out, std::string_view tag,
+                    const std::optional<TSymAddrs>& symaddrs) {
+  if (!symaddrs.has_value()) {
+    return;
+  }
+  std::string_view bytes(reinterpret_cast<const char*>(&symaddrs.value()), sizeof(TSymAddrs));
+  absl::StrAppend(out, tag, " ", absl::BytesToHexString(bytes), "\n");
+}
+
+template <typename TSymAddrs>
+StatusOr<TSymAddrs> ParseSymAddrs(std::string_view hex) {
+  if (hex.size() != 2 * sizeof(TSymAddrs) ||
+      !std::all_of(hex.begin(), hex.end(), [](char c) { return absl::ascii_isxdigit(c); })) {
+    return error::InvalidArgument("Malformed symaddrs: $0", hex);
+  }
+  std::string bytes = absl::HexStringToBytes(hex);
+  TSymAddrs symaddrs;
+  memcpy(&symaddrs, bytes.data(), sizeof(TSymAddrs));
+  return symaddrs;
+}
+
+// Symbols never contain spaces, and an empty symbol, for probes attached by address, is "-".
+void AppendProbes(std::string* out, std::string_view tag, const std::vector<UProbeSpec>& probes) {
+  for (const auto& spec : probes) {
+    absl::StrAppend(out, tag, " ", static_cast<int>(spec.attach_type), " ", spec.address, " ",
+                    spec.symbol.empty() ? "-" : spec.symbol, " ", spec.probe_fn, "\n");
+  }
+}
+
+StatusOr<UProbeSpec> ParseProbe(const std::vector<std::string_view>& fields) {
+  UProbeSpec spec;
+  int attach_type;
+  if (!absl::SimpleAtoi(fields[1], &attach_type) ||
+      !magic_enum::enum_cast<BPFProbeAttachType>(attach_type).has_value() ||
+      !absl::SimpleAtoi(fields[2], &spec.address)) {
+    return error::InvalidArgument("Malformed probe: $0",
+                                  absl::StrJoin(fields.begin(), fields.end(), " "));
+  }
+  spec.attach_type = static_cast<BPFProbeAttachType>(attach_type);
+  spec.symbol = fields[3] == "-" ? "" : std::string(fields[3]);
+  spec.probe_fn = std::string(fields[4]);
+  return spec;
+}
+
+}  // namespace
+
+std::string SerializeGoBinaryAnalysis(const GoBinaryAnalysis& analysis) {
+  std::string out = absl::StrCat(FormatHeader(), "\n");
+  AppendSymAddrs(&out, "common", analysis.common_symaddrs);
+  AppendSymAddrs(&out, "tls", analysis.tls_symaddrs);
+  AppendSymAddrs(&out, "http2", analysis.http2_symaddrs);
+  if (analysis.http2_analyzed) {
+    absl::StrAppend(&out, "http2_analyzed\n");
+  }
+  AppendProbes(&out, "tls_probe", analysis.tls_probes);
+  AppendProbes(&out, "http2_probe", analysis.http2_probes);
+  return out;
+}
+
+StatusOr<GoBinaryAnalysis> ParseGoBinaryAnalysis(std::string_view contents) {
+  std::vector<std::string_view> lines = absl::StrSplit(contents, '\n', absl::SkipEmpty());
+  if (lines.empty() || lines[0] != FormatHeader()) {
+    return error::InvalidArgument("Unsupported format, expected header '$0'", FormatHeader());
+  }
+
+  GoBinaryAnalysis analysis;
+  for (size_t i = 1; i < lines.size(); ++i) {
+    std::vector<std::string_view> fields = absl::StrSplit(lines[i], ' ');
+    std::string_view tag = fields[0];
+    if (tag == "common" && fields.size() == 2) {
+      PL_ASSIGN_OR_RETURN(analysis.common_symaddrs,
+                          ParseSymAddrs<struct go_common_symaddrs_t>(fields[1]));
+    } else if (tag == "tls" && fields.size() == 2) {
+      PL_ASSIGN_OR_RETURN(analysis.tls_symaddrs,
+                          ParseSymAddrs<struct go_tls_symaddrs_t>(fields[1]));
+    } else if (tag == "http2" && fields.size() == 2) {
+      PL_ASSIGN_OR_RETURN(analysis.http2_symaddrs,
+                          ParseSymAddrs<struct go_http2_symaddrs_t>(fields[1]));
+    } else if (tag == "http2_analyzed" && fields.size() == 1) {
+      analysis.http2_analyzed = true;
+    } else if (tag == "tls_probe" && fields.size() == 5) {
+      PL_ASSIGN_OR_RETURN(UProbeSpec spec, ParseProbe(fields));
+      analysis.tls_probes.push_back(std::move(spec));
+    } else if (tag == "http2_probe" && fields.size() == 5) {
+      PL_ASSIGN_OR_RETURN(UProbeSpec spec, ParseProbe(fields));
+      analysis.http2_probes.push_back(std::move(spec));
+    } else {
+      return error::InvalidArgument("Malformed line: $0", lines[i]);
+    }
+  }
+  return analysis;
+}
+
+//-----------------------------------------------------------------------------
+// BinaryAnalysisCache
+//-----------------------------------------------------------------------------
+
+std::filesystem::path BinaryAnalysisCache::PersistPath(const BinaryKey& key) const {
+  return persist_dir_ / absl::StrCat(key.ToString(), ".go");
+}
+
+StatusOr<GoBinaryAnalysis> BinaryAnalysisCache::LoadGo(const BinaryKey& key) const {
+  std::filesystem::path path = PersistPath(key);
+  PL_RETURN_IF_ERROR(fs::Exists(path));
+  PL_ASSIGN_OR_RETURN(std::string contents, ReadFileToString(path));
+  return ParseGoBinaryAnalysis(contents);
+}
+
+Status BinaryAnalysisCache::PersistGo(const BinaryKey& key,
+                                      const GoBinaryAnalysis& analysis) const {
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(persist_dir_));
+
+  // Write to a temporary file first, so that a crash can't leave a truncated file behind.
+  std::filesystem::path path = PersistPath(key);
+  std::filesystem::path tmp_path = absl::StrCat(path.string(), ".tmp");
+  PL_RETURN_IF_ERROR(WriteFileFromString(tmp_path, SerializeGoBinaryAnalysis(analysis)));
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    return error::Internal("Could not rename $0 to $1: $2", tmp_path.string(), path.string(),
+                           ec.message());
+  }
+  return Status::OK();
+}
+
+const GoBinaryAnalysis* BinaryAnalysisCache::LookupGo(const BinaryKey& key) {
+  auto iter = go_.find(key);
+  if (iter != go_.end()) {
+    return &iter->second;
+  }
+  if (persist_dir_.empty()) {
+    return nullptr;
+  }
+
+  StatusOr<GoBinaryAnalysis> analysis_or = LoadGo(key);
+  if (!analysis_or.ok()) {
+    VLOG(1) << absl::Substitute("No usable persisted analysis for binary $0: $1", key.ToString(),
+                                analysis_or.msg());
+    return nullptr;
+  }
+  iter = go_.emplace(key, analysis_or.ConsumeValueOrDie()).first;
+  return &iter->second;
+}
+
+const GoBinaryAnalysis& BinaryAnalysisCache::InsertGo(const BinaryKey& key,
+                                                      GoBinaryAnalysis analysis) {
+  // Only Go binaries are persisted. There are many more other binaries, which are cheap to
+  // rule out anyways.
+  if (!persist_dir_.empty() && analysis.common_symaddrs.has_value()) {
+    Status s = PersistGo(key, analysis);
+    if (!s.ok()) {
+      LOG_FIRST_N(WARNING, 1) << absl::Substitute("Could not persist binary analysis to $0: $1",
+                                                  persist_dir_.string(), s.msg());
+    }
+  }
+  auto iter = go_.insert_or_assign(key, std::move(analysis)).first;
+  return iter->second;
+}
+
+std::optional<struct openssl_symaddrs_t> BinaryAnalysisCache::LookupOpenSSL(
+    const BinaryKey& key) const {
+  auto iter = openssl_.find(key);
+  if (iter == openssl_.end()) {
+    return std::nullopt;
+  }
+  return iter->second;
+}
+
+void BinaryAnalysisCache::InsertOpenSSL(const BinaryKey& key,
+                                        const struct openssl_symaddrs_t& symaddrs) {
+  openssl_.insert_or_assign(key, symaddrs);
+}
+
+const NodeBinaryAnalysis* BinaryAnalysisCache::LookupNode(const BinaryKey& key) const {
+  auto iter = node_.find(key);
+  if (iter == node_.end()) {
+    return nullptr;
+  }
+  return &iter->second;
+}
+
+const NodeBinaryAnalysis& BinaryAnalysisCache::InsertNode(const BinaryKey& key,
+                                                          NodeBinaryAnalysis analysis) {
+  auto iter = node_.insert_or_assign(key, std::move(analysis)).first;
+  return iter->second;
+}
+
+}  // namespace stirling
+}  // namespace px
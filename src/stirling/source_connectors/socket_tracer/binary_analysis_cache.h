@@ -0,0 +1,147 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/node_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/bpf_tools/bcc_wrapper.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
+#include "src/stirling/utils/detect_application.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * Identifies the contents of a binary, wherever it is mounted. Every container started from the
+ * same image sees the same file from the image layer, so its inode, size and modification time
+ * are the same, even though its path on the host differs per container.
+ */
+struct BinaryKey {
+  uint64_t inode = 0;
+  uint64_t size = 0;
+  int64_t mtime_ns = 0;
+
+  static StatusOr<BinaryKey> Create(const std::filesystem::path& binary);
+
+  std::string ToString() const { return absl::Substitute("$0_$1_$2", inode, size, mtime_ns); }
+
+  bool operator==(const BinaryKey& other) const {
+    return inode == other.inode && size == other.size && mtime_ns == other.mtime_ns;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const BinaryKey& key) {
+    return H::combine(std::move(h), key.inode, key.size, key.mtime_ns);
+  }
+};
+
+/**
+ * What UProbeManager learned about a Go binary, to deploy uprobes on any copy of it.
+ */
+struct GoBinaryAnalysis {
+  // Not set if the binary isn't a Go binary, or doesn't have the symbols needed by every Go probe.
+  std::optional<struct go_common_symaddrs_t> common_symaddrs;
+
+  // Not set if the binary doesn't use the library.
+  std::optional<struct go_tls_symaddrs_t> tls_symaddrs;
+  std::optional<struct go_http2_symaddrs_t> http2_symaddrs;
+
+  // The uprobes to attach to the binary, without their binary_path.
+  std::vector<bpf_tools::UProbeSpec> tls_probes;
+  std::vector<bpf_tools::UProbeSpec> http2_probes;
+
+  // Whether the HTTP2 symbols and probes were looked up at all, as that is only done when HTTP2
+  // tracing is enabled.
+  bool http2_analyzed = false;
+};
+
+/**
+ * What UProbeManager learned about a node executable.
+ */
+struct NodeBinaryAnalysis {
+  SemVer version;
+  struct node_tlswrap_symaddrs_t tlswrap_symaddrs;
+
+  // The node specific uprobes to attach to the executable, without their binary_path.
+  std::vector<bpf_tools::UProbeSpec> probes;
+};
+
+/**
+ * Memoizes the analysis of binaries for uprobe deployment across all the processes that run
+ * them. Analyzing a large Go binary's DWARF info takes seconds, and a node often runs many
+ * replicas of it.
+ *
+ * If a directory is provided, the analyses of Go binaries are also persisted there, one file per
+ * BinaryKey, so that they survive restarts.
+ *
+ * Not thread-safe.
+ */
+class BinaryAnalysisCache {
+ public:
+  explicit BinaryAnalysisCache(std::filesystem::path persist_dir = {})
+      : persist_dir_(std::move(persist_dir)) {}
+
+  /**
+   * Returns the analysis of a Go binary, from memory or from the persist directory,
+   * or nullptr if it hasn't been analyzed.
+   */
+  const GoBinaryAnalysis* LookupGo(const BinaryKey& key);
+  const GoBinaryAnalysis& InsertGo(const BinaryKey& key, GoBinaryAnalysis analysis);
+
+  /**
+   * Returns the OpenSSL symbol addresses of a libcrypto library, if it has been analyzed.
+   */
+  std::optional<struct openssl_symaddrs_t> LookupOpenSSL(const BinaryKey& key) const;
+  void InsertOpenSSL(const BinaryKey& key, const struct openssl_symaddrs_t& symaddrs);
+
+  /**
+   * Returns the analysis of a node executable, or nullptr if it hasn't been analyzed.
+   */
+  const NodeBinaryAnalysis* LookupNode(const BinaryKey& key) const;
+  const NodeBinaryAnalysis& InsertNode(const BinaryKey& key, NodeBinaryAnalysis analysis);
+
+  size_t num_go_binaries() const { return go_.size(); }
+
+ private:
+  std::filesystem::path PersistPath(const BinaryKey& key) const;
+  StatusOr<GoBinaryAnalysis> LoadGo(const BinaryKey& key) const;
+  Status PersistGo(const BinaryKey& key, const GoBinaryAnalysis& analysis) const;
+
+  const std::filesystem::path persist_dir_;
+
+  // node_hash_maps, so that the returned pointers stay valid as binaries are added.
+  absl::node_hash_map<BinaryKey, GoBinaryAnalysis> go_;
+  absl::node_hash_map<BinaryKey, NodeBinaryAnalysis> node_;
+  absl::flat_hash_map<BinaryKey, struct openssl_symaddrs_t> openssl_;
+};
+
+// Exposed for testing.
+std::string SerializeGoBinaryAnalysis(const GoBinaryAnalysis& analysis);
+StatusOr<GoBinaryAnalysis> ParseGoBinaryAnalysis(std::string_view contents);
+
+}  // namespace stirling
+}  // namespace px
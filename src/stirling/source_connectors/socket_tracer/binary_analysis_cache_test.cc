@@ -0,0 +1,135 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/binary_analysis_cache.h"
+
+#include <filesystem>
+#include <string>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::px::stirling::bpf_tools::BPFProbeAttachType;
+using ::px::stirling::bpf_tools::UProbeSpec;
+
+namespace {
+
+GoBinaryAnalysis TestAnalysis() {
+  GoBinaryAnalysis analysis;
+  struct go_common_symaddrs_t common = {};
+  common.FD_Sysfd_offset = 16;
+  analysis.common_symaddrs = common;
+  struct go_tls_symaddrs_t tls = {};
+  tls.Write_c_loc.offset = 8;
+  analysis.tls_symaddrs = tls;
+  analysis.http2_analyzed = true;
+  analysis.tls_probes.push_back(UProbeSpec{.symbol = "crypto/tls.(*Conn).Write",
+                                           .attach_type = BPFProbeAttachType::kEntry,
+                                           .probe_fn = "probe_entry_tls_conn_write"});
+  analysis.tls_probes.push_back(UProbeSpec{.address = 0x4f1234,
+                                           .attach_type = BPFProbeAttachType::kEntry,
+                                           .probe_fn = "probe_return_tls_conn_write"});
+  return analysis;
+}
+
+}  // namespace
+
+TEST(BinaryKeyTest, SameFileUnderAnotherPath) {
+  px::testing::TempDir dir;
+  std::filesystem::path binary = dir.path() / "binary";
+  std::filesystem::path other = dir.path() / "other";
+  ASSERT_OK(WriteFileFromString(binary, "contents"));
+  ASSERT_OK(WriteFileFromString(other, "contents"));
+  std::filesystem::create_hard_link(binary, dir.path() / "link");
+
+  ASSERT_OK_AND_ASSIGN(BinaryKey key, BinaryKey::Create(binary));
+  EXPECT_OK_AND_EQ(BinaryKey::Create(dir.path() / "link"), key);
+  ASSERT_OK_AND_ASSIGN(BinaryKey other_key, BinaryKey::Create(other));
+  EXPECT_FALSE(other_key == key);
+
+  EXPECT_NOT_OK(BinaryKey::Create(dir.path() / "missing"));
+}
+
+TEST(GoBinaryAnalysisTest, SerializeAndParse) {
+  GoBinaryAnalysis analysis = TestAnalysis();
+  ASSERT_OK_AND_ASSIGN(GoBinaryAnalysis parsed,
+                       ParseGoBinaryAnalysis(SerializeGoBinaryAnalysis(analysis)));
+
+  ASSERT_TRUE(parsed.common_symaddrs.has_value());
+  EXPECT_EQ(parsed.common_symaddrs->FD_Sysfd_offset, 16);
+  ASSERT_TRUE(parsed.tls_symaddrs.has_value());
+  EXPECT_EQ(parsed.tls_symaddrs->Write_c_loc.offset, 8);
+  EXPECT_FALSE(parsed.http2_symaddrs.has_value());
+  EXPECT_TRUE(parsed.http2_analyzed);
+
+  ASSERT_EQ(parsed.tls_probes.size(), 2);
+  EXPECT_EQ(parsed.tls_probes[0].ToString(), analysis.tls_probes[0].ToString());
+  EXPECT_EQ(parsed.tls_probes[1].ToString(), analysis.tls_probes[1].ToString());
+  EXPECT_TRUE(parsed.http2_probes.empty());
+}
+
+TEST(GoBinaryAnalysisTest, ParseRejectsOtherFormats) {
+  std::string contents = SerializeGoBinaryAnalysis(TestAnalysis());
+  EXPECT_NOT_OK(ParseGoBinaryAnalysis(""));
+  EXPECT_NOT_OK(ParseGoBinaryAnalysis(contents.substr(contents.find('\n'))));
+  EXPECT_NOT_OK(ParseGoBinaryAnalysis(absl::StrCat(contents, "unknown 1\n")));
+  EXPECT_NOT_OK(ParseGoBinaryAnalysis(absl::StrCat(contents, "tls_probe 100 0 - fn\n")));
+  EXPECT_NOT_OK(ParseGoBinaryAnalysis(absl::StrCat(contents, "common 0102\n")));
+}
+
+TEST(BinaryAnalysisCacheTest, LookupAndInsert) {
+  BinaryAnalysisCache cache;
+  BinaryKey key{1, 2, 3};
+  EXPECT_EQ(cache.LookupGo(key), nullptr);
+
+  const GoBinaryAnalysis& inserted = cache.InsertGo(key, TestAnalysis());
+  EXPECT_EQ(cache.LookupGo(key), &inserted);
+  EXPECT_EQ(cache.LookupGo(BinaryKey{1, 2, 4}), nullptr);
+
+  EXPECT_FALSE(cache.LookupOpenSSL(key).has_value());
+  cache.InsertOpenSSL(key, openssl_symaddrs_t{.SSL_rbio_offset = 0x10, .RBIO_num_offset = 0x30});
+  ASSERT_TRUE(cache.LookupOpenSSL(key).has_value());
+  EXPECT_EQ(cache.LookupOpenSSL(key)->RBIO_num_offset, 0x30);
+}
+
+TEST(BinaryAnalysisCacheTest, PersistsGoBinaries) {
+  px::testing::TempDir dir;
+  BinaryKey key{1, 2, 3};
+  BinaryKey not_go_key{4, 5, 6};
+  {
+    BinaryAnalysisCache cache(dir.path() / "cache");
+    cache.InsertGo(key, TestAnalysis());
+    cache.InsertGo(not_go_key, GoBinaryAnalysis());
+  }
+
+  // A new cache, as after a restart, reads the analysis back.
+  BinaryAnalysisCache cache(dir.path() / "cache");
+  const GoBinaryAnalysis* analysis = cache.LookupGo(key);
+  ASSERT_NE(analysis, nullptr);
+  EXPECT_EQ(analysis->tls_probes.size(), 2);
+  EXPECT_EQ(cache.LookupGo(not_go_key), nullptr);
+
+  // Files in another format are ignored.
+  ASSERT_OK(WriteFileFromString(dir.path() / "cache" / "7_8_9.go", "garbage"));
+  EXPECT_EQ(cache.LookupGo(BinaryKey{7, 8, 9}), nullptr);
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -62,6 +62,14 @@ constexpr DataElement kLatencyNS = {
     types::PatternType::METRIC_GAUGE,
 };
 
+constexpr DataElement kSampleRate = {
+    "sample_rate",
+    "The fraction of the traffic that the record was sampled from, weigh it by 1/sample_rate.",
+    types::DataType::FLOAT64,
+    types::SemanticType::ST_NONE,
+    types::PatternType::METRIC_GAUGE,
+};
+
 constexpr DataElement kPXInfo = {
     "px_info_",
     "Pixie messages regarding the record (e.g. warnings)",
@@ -16,6 +16,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <thread>
+
 #include "src/common/testing/testing.h"
 #include "src/stirling/core/output.h"
 #include "src/stirling/source_connectors/socket_tracer/testing/client_server_system.h"
@@ -205,6 +207,56 @@ TEST_F(ConnStatsBPFTest, RoleFromConnectAccept) {
   }
 }
 
+class ConnStatsPollingBPFTest : public testing::SocketTraceBPFTest</* TClientSideTracing */ false> {
+ protected:
+  ConnStatsPollingBPFTest() {
+    FLAGS_stirling_conn_stats_sampling_ratio = 1;
+    FLAGS_stirling_conn_stats_bpf_polling = true;
+  }
+  ~ConnStatsPollingBPFTest() { FLAGS_stirling_conn_stats_bpf_polling = false; }
+};
+
+// Tests that the stats of an open connection are reported, even though the connection has not
+// moved enough bytes for BPF to send a conn stats event.
+TEST_F(ConnStatsPollingBPFTest, ReportsOpenConnection) {
+  StartTransferDataThread();
+
+  TCPSocket server_listener;
+  server_listener.BindAndListen();
+  TCPSocket client;
+  client.Connect(server_listener);
+  std::unique_ptr<TCPSocket> server = server_listener.Accept();
+
+  std::string_view test_msg = "Hello World!";
+  EXPECT_EQ(test_msg.size(), client.Send(test_msg));
+  std::string text;
+  while (!server->Recv(&text)) {
+  }
+
+  // Give TransferData() a few iterations to poll the stats, while the connection is open.
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  StopTransferDataThread();
+
+  client.Close();
+  server->Close();
+  server_listener.Close();
+
+  std::vector<TaggedRecordBatch> tablets = ConsumeRecords(SocketTraceConnector::kConnStatsTableNum);
+  ASSERT_FALSE(tablets.empty());
+  const types::ColumnWrapperRecordBatch& rb = tablets[0].records;
+
+  bool found_client_stats = false;
+  for (size_t idx : FindRecordIdxMatchesPID(rb, kUPIDIdx, getpid())) {
+    int conn_close = AccessRecordBatch<types::Int64Value>(rb, kConnCloseIdx, idx).val;
+    int bytes_sent = AccessRecordBatch<types::Int64Value>(rb, kBytesSentIdx, idx).val;
+    int role = AccessRecordBatch<types::Int64Value>(rb, kRoleIdx, idx).val;
+    if (role == kRoleClient && conn_close == 0 && bytes_sent == static_cast<int>(test_msg.size())) {
+      found_client_stats = true;
+    }
+  }
+  EXPECT_TRUE(found_client_stats);
+}
+
 // Test fixture that starts SocketTraceConnector after the connection was already established.
 class ConnStatsMidConnBPFTest : public testing::SocketTraceBPFTest</* TClientSideTracing */ false> {
  protected:
@@ -122,24 +122,24 @@ void ConnTracker::AddConnCloseEvent(const close_event_t& close_event, uint64_t t
   MarkForDeath();
 }
 
-void ConnTracker::AddDataEvent(std::unique_ptr<SocketDataEvent> event) {
-  SetRole(event->attr.role, "inferred from data_event");
-  SetProtocol(event->attr.protocol, "inferred from data_event");
-  SetSSL(event->attr.ssl, "inferred from data_event");
+void ConnTracker::AddDataEvent(const SocketDataEventView& event) {
+  SetRole(event.attr.role, "inferred from data_event");
+  SetProtocol(event.attr.protocol, "inferred from data_event");
+  SetSSL(event.attr.ssl, "inferred from data_event");
 
   CheckTracker();
-  UpdateTimestamps(event->attr.timestamp_ns);
-  UpdateDataStats(*event);
+  UpdateTimestamps(event.attr.timestamp_ns);
+  UpdateDataStats(event);
 
-  CONN_TRACE(1) << absl::Substitute("Data event received: $0", event->ToString());
+  CONN_TRACE(1) << absl::Substitute("Data event received: $0", event.ToString());
 
   // TODO(yzhao): Change to let userspace resolve the connection type and signal back to BPF.
   // Then we need at least one data event to let ConnTracker know the field descriptor.
-  if (event->attr.protocol == kProtocolUnknown) {
+  if (event.attr.protocol == kProtocolUnknown) {
     return;
   }
 
-  if (event->attr.protocol != protocol_) {
+  if (event.attr.protocol != protocol_) {
     return;
   }
 
@@ -148,12 +148,12 @@ void ConnTracker::AddDataEvent(std::unique_ptr<SocketDataEvent> event) {
     return;
   }
 
-  switch (event->attr.direction) {
+  switch (event.attr.direction) {
     case traffic_direction_t::kEgress: {
-      send_data_.AddData(std::move(event));
+      send_data_.AddData(event);
     } break;
     case traffic_direction_t::kIngress: {
-      recv_data_.AddData(std::move(event));
+      recv_data_.AddData(event);
     } break;
   }
 }
@@ -194,28 +194,28 @@ protocols::http2::HalfStream* ConnTracker::HalfStreamPtr(uint32_t stream_id, boo
   return streams.HalfStreamPtr(stream_id, write_event);
 }
 
-endpoint_role_t InferHTTP2Role(bool write_event, const std::unique_ptr<HTTP2HeaderEvent>& hdr) {
+endpoint_role_t InferHTTP2Role(bool write_event, const HTTP2HeaderEvent& hdr) {
   // Look for standard headers to infer role.
   // Could look at others (:scheme, :path, :authority), but this seems sufficient.
 
-  if (hdr->name == ":method") {
+  if (hdr.name == ":method") {
     return (write_event) ? kRoleClient : kRoleServer;
   }
-  if (hdr->name == ":status") {
+  if (hdr.name == ":status") {
     return (write_event) ? kRoleServer : kRoleClient;
   }
 
   return kRoleUnknown;
 }
 
-void ConnTracker::AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> hdr) {
+void ConnTracker::AddHTTP2Header(HTTP2HeaderEvent&& hdr) {
   SetProtocol(kProtocolHTTP2, "inferred from http2 headers");
 
   if (protocol_ != kProtocolHTTP2) {
     return;
   }
 
-  CONN_TRACE(2) << absl::Substitute("HTTP2 header event received: $0", hdr->ToString());
+  CONN_TRACE(2) << absl::Substitute("HTTP2 header event received: $0", hdr.ToString());
 
   if (conn_id_.fd == 0) {
     Disable(
@@ -232,14 +232,14 @@ void ConnTracker::AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> hdr) {
   CheckTracker();
 
   // Don't trace any control messages.
-  if (hdr->attr.stream_id == 0) {
+  if (hdr.attr.stream_id == 0) {
     return;
   }
 
-  UpdateTimestamps(hdr->attr.timestamp_ns);
+  UpdateTimestamps(hdr.attr.timestamp_ns);
 
   bool write_event = false;
-  switch (hdr->attr.type) {
+  switch (hdr.attr.type) {
     case HeaderEventType::kHeaderEventWrite:
       write_event = true;
       break;
@@ -256,13 +256,13 @@ void ConnTracker::AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> hdr) {
     SetRole(role, "Inferred from http2 header");
   }
 
-  protocols::http2::HalfStream* half_stream_ptr = HalfStreamPtr(hdr->attr.stream_id, write_event);
+  protocols::http2::HalfStream* half_stream_ptr = HalfStreamPtr(hdr.attr.stream_id, write_event);
 
   // End stream flag is on a empty header, so just record the end_stream, but don't add the headers.
-  if (hdr->attr.end_stream) {
+  if (hdr.attr.end_stream) {
     // Expecting an empty header since this is how it is done in BPF.
-    ECHECK(hdr->name.empty());
-    ECHECK(hdr->value.empty());
+    ECHECK(hdr.name.empty());
+    ECHECK(hdr.value.empty());
 
     // Only expect one end_stream signal per stream direction.
     // Note: Duplicate calls to the writeHeaders (calls with same arguments) have been observed.
@@ -273,26 +273,26 @@ void ConnTracker::AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> hdr) {
     // flag set; the end_stream cases are just the easiest to detect.
     if (half_stream_ptr->end_stream()) {
       CONN_TRACE(1) << absl::Substitute(
-          "Duplicate end_stream flag in header. stream_id: $0, conn_id: $1", hdr->attr.stream_id,
-          ::ToString(hdr->attr.conn_id));
+          "Duplicate end_stream flag in header. stream_id: $0, conn_id: $1", hdr.attr.stream_id,
+          ::ToString(hdr.attr.conn_id));
     }
 
     half_stream_ptr->AddEndStream();
     return;
   }
 
-  half_stream_ptr->AddHeader(std::move(hdr->name), std::move(hdr->value));
-  half_stream_ptr->UpdateTimestamp(hdr->attr.timestamp_ns);
+  half_stream_ptr->AddHeader(std::move(hdr.name), std::move(hdr.value));
+  half_stream_ptr->UpdateTimestamp(hdr.attr.timestamp_ns);
 }
 
-void ConnTracker::AddHTTP2Data(std::unique_ptr<HTTP2DataEvent> data) {
+void ConnTracker::AddHTTP2Data(const HTTP2DataEvent& data) {
   SetProtocol(kProtocolHTTP2, "inferred from http2 data");
 
   if (protocol_ != kProtocolHTTP2) {
     return;
   }
 
-  CONN_TRACE(1) << absl::Substitute("HTTP2 data event received: $0", data->ToString());
+  CONN_TRACE(1) << absl::Substitute("HTTP2 data event received: $0", data.ToString());
 
   if (conn_id_.fd == 0) {
     Disable(
@@ -309,14 +309,14 @@ void ConnTracker::AddHTTP2Data(std::unique_ptr<HTTP2DataEvent> data) {
   CheckTracker();
 
   // Don't trace any control messages.
-  if (data->attr.stream_id == 0) {
+  if (data.attr.stream_id == 0) {
     return;
   }
 
-  UpdateTimestamps(data->attr.timestamp_ns);
+  UpdateTimestamps(data.attr.timestamp_ns);
 
   bool write_event = false;
-  switch (data->attr.type) {
+  switch (data.attr.type) {
     case DataFrameEventType::kDataFrameEventWrite:
       write_event = true;
       break;
@@ -328,23 +328,23 @@ void ConnTracker::AddHTTP2Data(std::unique_ptr<HTTP2DataEvent> data) {
       return;
   }
 
-  protocols::http2::HalfStream* half_stream_ptr = HalfStreamPtr(data->attr.stream_id, write_event);
+  protocols::http2::HalfStream* half_stream_ptr = HalfStreamPtr(data.attr.stream_id, write_event);
 
   // Note: Duplicate calls to the writeHeaders have been observed (though they are rare).
   // It is not yet known if duplicate data also occurs. This log will help us figure out if such
   // cases exist. Note that the duplicates are not related to the end_stream flag being set;
   // the end_stream cases are just the easiest to detect.
-  if (half_stream_ptr->end_stream() && data->attr.end_stream) {
+  if (half_stream_ptr->end_stream() && data.attr.end_stream) {
     CONN_TRACE(1) << absl::Substitute(
-        "Duplicate end_stream flag in data. stream_id: $0, conn_id: $1", data->attr.stream_id,
-        ::ToString(data->attr.conn_id));
+        "Duplicate end_stream flag in data. stream_id: $0, conn_id: $1", data.attr.stream_id,
+        ::ToString(data.attr.conn_id));
   }
 
-  half_stream_ptr->AddData(data->payload);
-  if (data->attr.end_stream) {
+  half_stream_ptr->AddData(data.payload);
+  if (data.attr.end_stream) {
     half_stream_ptr->AddEndStream();
   }
-  half_stream_ptr->UpdateTimestamp(data->attr.timestamp_ns);
+  half_stream_ptr->UpdateTimestamp(data.attr.timestamp_ns);
 }
 
 template <>
@@ -352,6 +352,8 @@ std::vector<protocols::http2::Record>
 ConnTracker::ProcessToRecords<protocols::http2::ProtocolTraits>() {
   protocols::RecordsWithErrorCount<protocols::http2::Record> result;
 
+  // HTTP2 frames are parsed as their events arrive, so only the stitching is timed.
+  utils::ScopedTimer timer(GetSocketTracerProtocolMetrics(kProtocolHTTP2).stitch_time_ns);
   protocols::http2::ProcessHTTP2Streams(&http2_client_streams_, IsZombie(), &result);
   protocols::http2::ProcessHTTP2Streams(&http2_server_streams_, IsZombie(), &result);
 
@@ -693,7 +695,7 @@ void ConnTracker::UpdateState(const std::vector<CIDRBlock>& cluster_cidrs) {
   }
 }
 
-void ConnTracker::UpdateDataStats(const SocketDataEvent& event) {
+void ConnTracker::UpdateDataStats(const SocketDataEventView& event) {
   switch (event.attr.direction) {
     case traffic_direction_t::kEgress: {
       stats_.Increment(StatKey::kDataEventSent, 1);
@@ -766,11 +768,13 @@ void ConnTracker::IterationPostTick() {
       (recv_data().ParseFailureRate() > kParseFailureRateThreshold)) {
     Disable(absl::Substitute("Connection does not appear parseable as protocol $0",
                              magic_enum::enum_name(protocol())));
+    disabled_as_unparseable_ = true;
   }
 
   if (StitchFailureRate() > kStitchFailureRateThreshold) {
     Disable(absl::Substitute("Connection does not appear to produce valid records of protocol $0",
                              magic_enum::enum_name(protocol())));
+    disabled_as_unparseable_ = true;
   }
 }
 
@@ -39,6 +39,7 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http2/http2_streams_container.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_tracer_metrics.h"
 // Include all specializations of the StitchFrames() template specializations for all protocols.
 #include "src/stirling/source_connectors/socket_tracer/protocols/stitchers.h"
 #include "src/stirling/utils/stat_counter.h"
@@ -199,7 +200,17 @@ class ConnTracker : NotCopyMoveable {
    *
    * @param event The data event from BPF.
    */
-  void AddDataEvent(std::unique_ptr<SocketDataEvent> event);
+  void AddDataEvent(std::unique_ptr<SocketDataEvent> event) {
+    AddDataEvent(SocketDataEventView(*event));
+  }
+
+  /**
+   * Registers a BPF data event into the tracker, without copying it: only its msg is copied
+   * into the data stream.
+   *
+   * @param event The data event from BPF.
+   */
+  void AddDataEvent(const SocketDataEventView& event);
 
   /**
    * Registers a BPF connection stats event into the tracker.
@@ -213,18 +224,18 @@ class ConnTracker : NotCopyMoveable {
    * The struct should contain stream ID and other meta-data so it can matched with other HTTP2
    * header events and data frames.
    *
-   * @param data The event from BPF uprobe.
+   * @param data The event from BPF uprobe. Its name and value are moved into the tracker.
    */
-  void AddHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> data);
+  void AddHTTP2Header(HTTP2HeaderEvent&& data);
 
   /**
    * Add a recorded HTTP2 data frame.
    * The struct should contain stream ID and other meta-data so it can matched with other HTTP2
    * header events and data frames.
    *
-   * @param data The event from BPF uprobe.
+   * @param data The event from BPF uprobe. Its payload is copied into the tracker.
    */
-  void AddHTTP2Data(std::unique_ptr<HTTP2DataEvent> data);
+  void AddHTTP2Data(const HTTP2DataEvent& data);
 
   /**
    * Attempts to infer the remote endpoint of a connection.
@@ -236,6 +247,16 @@ class ConnTracker : NotCopyMoveable {
    */
   void InferConnInfo(system::ProcParser* proc_parser, system::SocketInfoManager* socket_info_mgr);
 
+  /**
+   * Whether IterationPreTick() would attempt to infer the remote endpoint, if it is given a
+   * SocketInfoManager.
+   */
+  bool NeedsConnInference() const {
+    return state_ != State::kDisabled &&
+           open_info_.remote_addr.family == SockAddrFamily::kUnspecified &&
+           !conn_resolution_failed_;
+  }
+
   /**
    * Processes the connection tracker, parsing raw events into frames,
    * and frames into record.
@@ -251,7 +272,11 @@ class ConnTracker : NotCopyMoveable {
 
     InitProtocolState<TStateType>();
 
-    DataStreamsToFrames<TFrameType, TStateType>();
+    const SocketTracerProtocolMetrics& metrics = GetSocketTracerProtocolMetrics(protocol_);
+    {
+      utils::ScopedTimer timer(metrics.parse_time_ns);
+      DataStreamsToFrames<TFrameType, TStateType>();
+    }
 
     auto& req_frames = req_data()->Frames<TFrameType>();
     auto& resp_frames = resp_data()->Frames<TFrameType>();
@@ -260,9 +285,12 @@ class ConnTracker : NotCopyMoveable {
     CONN_TRACE(1) << absl::Substitute("req_frames=$0 resp_frames=$1", req_frames.size(),
                                       resp_frames.size());
 
-    protocols::RecordsWithErrorCount<TRecordType> result =
-        protocols::StitchFrames<TRecordType, TFrameType, TStateType>(&req_frames, &resp_frames,
-                                                                     state_ptr);
+    protocols::RecordsWithErrorCount<TRecordType> result;
+    {
+      utils::ScopedTimer timer(metrics.stitch_time_ns);
+      result = protocols::StitchFrames<TRecordType, TFrameType, TStateType>(
+          &req_frames, &resp_frames, state_ptr);
+    }
 
     CONN_TRACE(1) << absl::Substitute("records=$0", result.records.size());
 
@@ -336,6 +364,11 @@ class ConnTracker : NotCopyMoveable {
    */
   const DataStream& recv_data() const { return recv_data_; }
 
+  /**
+   * Approximate memory held by the data streams of this connection.
+   */
+  size_t MemoryUsage() const { return send_data_.MemoryUsage() + recv_data_.MemoryUsage(); }
+
   /**
    * Get the DataStream of requests for this connection.
    *
@@ -382,6 +415,11 @@ class ConnTracker : NotCopyMoveable {
    */
   std::string_view disable_reason() const { return disable_reason_; }
 
+  /**
+   * Whether the tracker was disabled because its data could not be parsed as its protocol.
+   */
+  bool disabled_as_unparseable() const { return disabled_as_unparseable_; }
+
   /**
    * Returns a state that determine the operations performed on the traffic traced on the
    * connection.
@@ -596,7 +634,7 @@ class ConnTracker : NotCopyMoveable {
   bool IsRemoteAddrInCluster(const std::vector<CIDRBlock>& cluster_cidrs);
   void UpdateState(const std::vector<CIDRBlock>& cluster_cidrs);
 
-  void UpdateDataStats(const SocketDataEvent& event);
+  void UpdateDataStats(const SocketDataEventView& event);
 
   template <typename TFrameType, typename TStateType>
   void DataStreamsToFrames() {
@@ -671,6 +709,7 @@ class ConnTracker : NotCopyMoveable {
   State state_ = State::kCollecting;
 
   std::string disable_reason_;
+  bool disabled_as_unparseable_ = false;
 
   // Iterations before the tracker can be killed.
   int32_t death_countdown_ = -1;
@@ -64,7 +64,7 @@ auto EqHTTP2Record(const protocols::http2::Stream& x) {
 TEST_F(ConnTrackerHTTP2Test, BasicData) {
   const int kStreamID = 7;
   auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
-  std::unique_ptr<HTTP2DataEvent> data_frame;
+  HTTP2DataEvent data_frame;
 
   data_frame = frame_generator.GenDataFrame<kDataFrameEventWrite>("Request", /* end_stream */ true);
   tracker_.AddHTTP2Data(std::move(data_frame));
@@ -82,7 +82,7 @@ TEST_F(ConnTrackerHTTP2Test, BasicData) {
 TEST_F(ConnTrackerHTTP2Test, BasicHeader) {
   const int kStreamID = 7;
   auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
-  std::unique_ptr<HTTP2HeaderEvent> header_event;
+  HTTP2HeaderEvent header_event;
 
   header_event = frame_generator.GenHeader<kHeaderEventWrite>(":method", "post");
   tracker_.AddHTTP2Header(std::move(header_event));
@@ -106,7 +106,7 @@ TEST_F(ConnTrackerHTTP2Test, BasicHeader) {
 TEST_F(ConnTrackerHTTP2Test, MultipleDataFrames) {
   const int kStreamID = 7;
   auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
-  std::unique_ptr<HTTP2DataEvent> data_frame;
+  HTTP2DataEvent data_frame;
 
   data_frame = frame_generator.GenDataFrame<kDataFrameEventWrite>("Req");
   tracker_.AddHTTP2Data(std::move(data_frame));
@@ -130,8 +130,8 @@ TEST_F(ConnTrackerHTTP2Test, MultipleDataFrames) {
 TEST_F(ConnTrackerHTTP2Test, MixedHeadersAndData) {
   const int kStreamID = 7;
   auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
-  std::unique_ptr<HTTP2DataEvent> data_frame;
-  std::unique_ptr<HTTP2HeaderEvent> header_event;
+  HTTP2DataEvent data_frame;
+  HTTP2HeaderEvent header_event;
 
   header_event = frame_generator.GenHeader<kHeaderEventWrite>(":method", "post");
   tracker_.AddHTTP2Header(std::move(header_event));
@@ -175,8 +175,8 @@ TEST_F(ConnTrackerHTTP2Test, MixedHeadersAndData) {
 TEST_F(ConnTrackerHTTP2Test, MidStreamCapture) {
   const int kStreamID = 7;
   auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
-  std::unique_ptr<HTTP2DataEvent> data_frame;
-  std::unique_ptr<HTTP2HeaderEvent> header_event;
+  HTTP2DataEvent data_frame;
+  HTTP2HeaderEvent header_event;
 
   // Note that request headers are missing.
 
@@ -219,8 +219,8 @@ TEST_F(ConnTrackerHTTP2Test, ZeroFD) {
 
   const int kStreamID = 7;
   auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
-  std::unique_ptr<HTTP2DataEvent> data_frame;
-  std::unique_ptr<HTTP2HeaderEvent> header_event;
+  HTTP2DataEvent data_frame;
+  HTTP2HeaderEvent header_event;
 
   header_event = frame_generator.GenHeader<kHeaderEventWrite>(":method", "post");
   tracker.AddHTTP2Header(std::move(header_event));
@@ -311,8 +311,8 @@ TEST_F(ConnTrackerHTTP2Test, StreamIDJumpAhead) {
     const uint32_t kStreamID = 7;
     auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
 
-    std::unique_ptr<HTTP2DataEvent> data_frame;
-    std::unique_ptr<HTTP2HeaderEvent> header_event;
+    HTTP2DataEvent data_frame;
+    HTTP2HeaderEvent header_event;
 
     header_event = frame_generator.GenHeader<kHeaderEventWrite>(":method", "post");
     tracker_.AddHTTP2Header(std::move(header_event));
@@ -343,8 +343,8 @@ TEST_F(ConnTrackerHTTP2Test, StreamIDJumpAhead) {
     const uint32_t kStreamID = 100007;
     auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
 
-    std::unique_ptr<HTTP2DataEvent> data_frame;
-    std::unique_ptr<HTTP2HeaderEvent> header_event;
+    HTTP2DataEvent data_frame;
+    HTTP2HeaderEvent header_event;
 
     header_event = frame_generator.GenHeader<kHeaderEventWrite>(":method", "post");
     tracker_.AddHTTP2Header(std::move(header_event));
@@ -401,8 +401,8 @@ TEST_F(ConnTrackerHTTP2Test, StreamIDJumpBack) {
     const uint32_t kStreamID = 100007;
     auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
 
-    std::unique_ptr<HTTP2DataEvent> data_frame;
-    std::unique_ptr<HTTP2HeaderEvent> header_event;
+    HTTP2DataEvent data_frame;
+    HTTP2HeaderEvent header_event;
 
     header_event = frame_generator.GenHeader<kHeaderEventWrite>(":method", "post");
     tracker_.AddHTTP2Header(std::move(header_event));
@@ -433,8 +433,8 @@ TEST_F(ConnTrackerHTTP2Test, StreamIDJumpBack) {
     const uint32_t kStreamID = 7;
     auto frame_generator = testing::StreamEventGenerator(&real_clock_, kConnID, kStreamID);
 
-    std::unique_ptr<HTTP2DataEvent> data_frame;
-    std::unique_ptr<HTTP2HeaderEvent> header_event;
+    HTTP2DataEvent data_frame;
+    HTTP2HeaderEvent header_event;
 
     header_event = frame_generator.GenHeader<kHeaderEventWrite>(":method", "post");
     tracker_.AddHTTP2Header(std::move(header_event));
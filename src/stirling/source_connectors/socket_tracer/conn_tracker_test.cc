@@ -505,6 +505,20 @@ TEST_F(ConnTrackerTest, TrackerDisabledForOtherSockAddrFamily) {
   EXPECT_EQ(ConnTracker::State::kDisabled, tracker.state());
 }
 
+// Tests that only trackers whose connect/accept was not traced need connection inference.
+TEST_F(ConnTrackerTest, NeedsConnInference) {
+  testing::EventGenerator event_gen(&real_clock_);
+
+  ConnTracker traced_tracker;
+  traced_tracker.AddControlEvent(event_gen.InitConn());
+  EXPECT_FALSE(traced_tracker.NeedsConnInference());
+
+  ConnTracker untraced_tracker;
+  EXPECT_TRUE(untraced_tracker.NeedsConnInference());
+  untraced_tracker.Disable("test");
+  EXPECT_FALSE(untraced_tracker.NeedsConnInference());
+}
+
 // Tests that tracker is disabled after mapping the addresses from IPv4 to IPv6.
 TEST_F(ConnTrackerTest, TrackerDisabledAfterMapping) {
   {
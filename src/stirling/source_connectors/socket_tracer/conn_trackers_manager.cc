@@ -18,6 +18,10 @@
 
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
 
+#include <algorithm>
+
+#include "src/stirling/source_connectors/socket_tracer/socket_tracer_metrics.h"
+
 DEFINE_double(
     stirling_conn_tracker_cleanup_threshold, 0.2,
     "Percentage of trackers that are ready for destruction that will trigger a memory cleanup");
@@ -114,6 +118,10 @@ uint64_t GetConnMapKey(uint32_t pid, int32_t fd) { return (static_cast<uint64_t>
 ConnTrackersManager::ConnTrackersManager() : trackers_pool_(kMaxConnTrackerPoolSize) {}
 
 ConnTracker& ConnTrackersManager::GetOrCreateConnTracker(struct conn_id_t conn_id) {
+  if (last_tracker_ != nullptr && last_tracker_->conn_id() == conn_id) {
+    return *last_tracker_;
+  }
+
   const uint64_t conn_map_key = GetConnMapKey(conn_id.upid.pid, conn_id.fd);
   DCHECK_NE(conn_map_key, 0) << "Connection map key cannot be 0, pid must be wrong";
 
@@ -130,6 +138,7 @@ ConnTracker& ConnTrackersManager::GetOrCreateConnTracker(struct conn_id_t conn_i
   }
 
   DebugChecks();
+  last_tracker_ = conn_tracker_ptr;
   return *conn_tracker_ptr;
 }
 
@@ -159,6 +168,8 @@ void ConnTrackersManager::CleanupTrackers() {
     while (iter != active_trackers_.end()) {
       const auto& tracker = *iter;
       if (tracker->ReadyForDestruction()) {
+        conn_map_keys_to_cleanup_.insert(
+            GetConnMapKey(tracker->conn_id().upid.pid, tracker->conn_id().fd));
         active_trackers_.erase(iter++);
         stats_.Increment(StatKey::kReadyForDestruction);
       } else {
@@ -173,10 +184,17 @@ void ConnTrackersManager::CleanupTrackers() {
   double percent_destroyable =
       1.0 * stats_.Get(StatKey::kReadyForDestruction) / stats_.Get(StatKey::kTotal);
   if (percent_destroyable > FLAGS_stirling_conn_tracker_cleanup_threshold) {
-    // Outer loop iterates through tracker sets (keyed by PID+FD),
-    // while inner loop iterates through generations of trackers for that PID+FD pair.
-    auto iter = conn_id_tracker_generations_.begin();
-    while (iter != conn_id_tracker_generations_.end()) {
+    // The trackers about to be destroyed are recycled by the pool.
+    last_tracker_ = nullptr;
+
+    // Only the tracker sets (keyed by PID+FD) with trackers ReadyForDestruction() are visited,
+    // while CleanupGenerations() iterates through generations of trackers for that PID+FD pair.
+    for (uint64_t conn_map_key : conn_map_keys_to_cleanup_) {
+      auto iter = conn_id_tracker_generations_.find(conn_map_key);
+      if (iter == conn_id_tracker_generations_.end()) {
+        DCHECK(false) << "Trackers to clean up must be in the map.";
+        continue;
+      }
       auto& tracker_generations = iter->second;
 
       int num_erased = tracker_generations.CleanupGenerations(&trackers_pool_);
@@ -186,12 +204,11 @@ void ConnTrackersManager::CleanupTrackers() {
       stats_.Increment(StatKey::kDestroyed, num_erased);
 
       if (tracker_generations.empty()) {
-        conn_id_tracker_generations_.erase(iter++);
+        conn_id_tracker_generations_.erase(iter);
         stats_.Increment(StatKey::kDestroyedGens);
-      } else {
-        ++iter;
       }
     }
+    conn_map_keys_to_cleanup_.clear();
   }
 
   DebugChecks();
@@ -218,13 +235,18 @@ std::string ConnTrackersManager::DebugInfo() const {
 }
 
 std::string ConnTrackersManager::StatsString() const {
-  return absl::StrCat(stats_.Print(), protocol_stats_.Print());
+  const auto& pool_stats = trackers_pool_.stats();
+  return absl::StrCat(stats_.Print(), protocol_stats_.Print(),
+                      absl::Substitute("kPoolHits=$0 kPoolMisses=$1 kPoolDropped=$2 ",
+                                       pool_stats.hits, pool_stats.misses, pool_stats.dropped));
 }
 
 void ConnTrackersManager::ComputeProtocolStats() {
   absl::flat_hash_map<traffic_protocol_t, int> protocol_count;
+  absl::flat_hash_map<traffic_protocol_t, size_t> protocol_memory;
   for (const auto* tracker : active_trackers_) {
     ++protocol_count[tracker->protocol()];
+    protocol_memory[tracker->protocol()] += tracker->MemoryUsage();
   }
   for (auto protocol : magic_enum::enum_values<traffic_protocol_t>()) {
     protocol_stats_.Reset(protocol);
@@ -232,7 +254,50 @@ void ConnTrackersManager::ComputeProtocolStats() {
     if (iter != protocol_count.end()) {
       protocol_stats_.Increment(protocol, iter->second);
     }
+    protocol_memory_stats_.Reset(protocol);
+    auto memory_iter = protocol_memory.find(protocol);
+    if (memory_iter != protocol_memory.end()) {
+      protocol_memory_stats_.Increment(protocol, memory_iter->second);
+    }
+  }
+}
+
+int ConnTrackersManager::EnforceMemoryBudget(size_t budget_bytes) {
+  std::vector<std::pair<ConnTracker*, size_t>> trackers;
+  size_t total_bytes = 0;
+  for (ConnTracker* tracker : active_trackers_) {
+    size_t bytes = tracker->MemoryUsage();
+    if (bytes > 0) {
+      trackers.emplace_back(tracker, bytes);
+      total_bytes += bytes;
+    }
+  }
+  if (total_bytes <= budget_bytes) {
+    return 0;
+  }
+
+  auto eviction_order = [](ConnTracker* tracker) {
+    bool makes_records = tracker->state() != ConnTracker::State::kDisabled && !tracker->IsZombie();
+    return std::make_pair(makes_records, tracker->last_update_timestamp());
+  };
+  std::sort(trackers.begin(), trackers.end(), [&eviction_order](const auto& a, const auto& b) {
+    return eviction_order(a.first) < eviction_order(b.first);
+  });
+
+  int num_evicted = 0;
+  for (const auto& [tracker, bytes] : trackers) {
+    if (total_bytes <= budget_bytes) {
+      break;
+    }
+    tracker->Reset();
+    size_t evicted_bytes = bytes - std::min(bytes, tracker->MemoryUsage());
+    GetSocketTracerProtocolMetrics(tracker->protocol()).evicted_bytes->Add(evicted_bytes);
+    total_bytes -= evicted_bytes;
+    ++num_evicted;
+    VLOG(1) << absl::Substitute("Dropped $0 bytes of $1 to stay within the memory budget.",
+                                evicted_bytes, tracker->ToString());
   }
+  return num_evicted;
 }
 
 }  // namespace stirling
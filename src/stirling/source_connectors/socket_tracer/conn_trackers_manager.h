@@ -26,6 +26,8 @@
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/stirling/source_connectors/socket_tracer/conn_tracker.h"
 #include "src/stirling/utils/obj_pool.h"
 #include "src/stirling/utils/stat_counter.h"
@@ -120,13 +122,23 @@ class ConnTrackersManager {
    */
   void CleanupTrackers();
 
+  /**
+   * Drops the buffered data of trackers until the data streams of all trackers hold at most
+   * budget_bytes. The trackers whose data won't make records (disabled or marked for death) go
+   * first, then the trackers that have gone the longest without new data.
+   *
+   * @return The number of trackers whose data was dropped.
+   */
+  int EnforceMemoryBudget(size_t budget_bytes);
+
   /**
    * Returns extensive debug information about the connection trackers.
    */
   std::string DebugInfo() const;
 
   /**
-   * Computes the count of ConnTracker objects for each protocol and stores them into stats_.
+   * Computes the count of ConnTracker objects, and the memory held by their data streams, for each
+   * protocol and stores them into stats_.
    */
   void ComputeProtocolStats();
 
@@ -135,6 +147,12 @@ class ConnTrackersManager {
    */
   std::string StatsString() const;
 
+  /**
+   * Returns a string representing the memory held by the ConnTracker objects of each protocol,
+   * as of the last ComputeProtocolStats().
+   */
+  std::string MemoryStatsString() const { return protocol_memory_stats_.Print(); }
+
  private:
   // Simple consistency DCHECKs meant for enforcing invariants.
   void DebugChecks() const;
@@ -146,6 +164,14 @@ class ConnTrackersManager {
 
   std::list<ConnTracker*> active_trackers_;
 
+  // The tracker returned by the last GetOrCreateConnTracker(). Events of a connection tend to
+  // arrive back-to-back, so this skips the map lookups for most events.
+  ConnTracker* last_tracker_ = nullptr;
+
+  // The {PID, FD} keys of trackers that were removed from active_trackers_ as
+  // ReadyForDestruction(), but not yet destroyed. Cleanup only visits these keys.
+  absl::flat_hash_set<uint64_t> conn_map_keys_to_cleanup_;
+
   // A pool of unused trackers that can be recycled.
   // This is useful for avoiding memory reallocations.
   ConnTrackerPool trackers_pool_;
@@ -153,6 +179,7 @@ class ConnTrackersManager {
   // Records statistics of ConnTracker for reporting and consistency check.
   utils::StatCounter<StatKey> stats_;
   utils::StatCounter<traffic_protocol_t> protocol_stats_;
+  utils::StatCounter<traffic_protocol_t> protocol_memory_stats_;
 };
 
 }  // namespace stirling
@@ -17,13 +17,17 @@
  */
 
 #include <random>
+#include <string>
+#include <vector>
 
 #include "src/common/testing/testing.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
+#include "src/stirling/source_connectors/socket_tracer/testing/event_generator.h"
 
 namespace px {
 namespace stirling {
 
+using ::testing::HasSubstr;
 using ::testing::StrEq;
 
 class ConnTrackersManagerTest : public ::testing::Test {
@@ -95,6 +99,32 @@ TEST_F(ConnTrackersManagerTest, Fuzz) {
   }
 }
 
+// Tests that the trackers that won't make records lose their data first when over budget.
+TEST_F(ConnTrackersManagerTest, EnforceMemoryBudget) {
+  testing::MockClock mock_clock;
+  std::vector<ConnTracker*> trackers;
+  for (uint32_t pid = 1; pid <= 3; ++pid) {
+    testing::EventGenerator event_gen(&mock_clock, pid);
+    struct socket_control_event_t conn = event_gen.InitConn();
+    ConnTracker& tracker = trackers_mgr_.GetOrCreateConnTracker(conn.conn_id);
+    tracker.AddControlEvent(conn);
+    tracker.AddDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(std::string(1000, 'x')));
+    ASSERT_GE(tracker.MemoryUsage(), 1000);
+    trackers.push_back(&tracker);
+  }
+  trackers[1]->MarkForDeath();
+
+  size_t live_bytes = trackers[0]->MemoryUsage() + trackers[2]->MemoryUsage();
+  EXPECT_EQ(trackers_mgr_.EnforceMemoryBudget(live_bytes + trackers[1]->MemoryUsage()), 0);
+  EXPECT_EQ(trackers_mgr_.EnforceMemoryBudget(live_bytes), 1);
+  EXPECT_EQ(trackers[1]->MemoryUsage(), 0);
+  EXPECT_EQ(trackers[0]->MemoryUsage() + trackers[2]->MemoryUsage(), live_bytes);
+
+  EXPECT_EQ(trackers_mgr_.EnforceMemoryBudget(0), 2);
+  EXPECT_EQ(trackers[0]->MemoryUsage(), 0);
+  EXPECT_EQ(trackers[2]->MemoryUsage(), 0);
+}
+
 // Tests that the DebugInfo() returns expected text.
 TEST_F(ConnTrackersManagerTest, DebugInfo) {
   struct conn_id_t conn_id = {};
@@ -111,13 +141,36 @@ TEST_F(ConnTrackersManagerTest, DebugInfo) {
             "kCreated=1 kDestroyed=0 kDestroyedGens=0 "
             "kProtocolUnknown=0 kProtocolHTTP=0 kProtocolHTTP2=0 kProtocolMySQL=0 kProtocolCQL=0 "
             "kProtocolPGSQL=0 kProtocolDNS=0 kProtocolRedis=0 kProtocolNATS=0 kProtocolMongo=0 "
-            "kProtocolKafka=0 kNumProtocols=0 \n"
+            "kProtocolKafka=0 kNumProtocols=0 kPoolHits=0 kPoolMisses=1 kPoolDropped=0 \n"
             "Detailed statistics of individual ConnTracker:\n"
             "  conn_tracker=conn_id=[pid=1 start_time_ticks=1 fd=1 gen=1] state=kCollecting "
             "remote_addr=-:-1 role=kRoleUnknown protocol=kProtocolUnknown zombie=false "
             "ready_for_destruction=false\n"));
 }
 
+// Tests that destroyed trackers are no longer returned, and that trackers of other connections
+// survive the cleanup.
+TEST_F(ConnTrackersManagerTest, CleanupDestroysOnlyReadyTrackers) {
+  struct conn_id_t conn_id1 = {{{1}, 1}, /*fd*/ 1, /*tsid*/ 1};
+  struct conn_id_t conn_id2 = {{{2}, 1}, /*fd*/ 1, /*tsid*/ 1};
+  ConnTracker& tracker2 = trackers_mgr_.GetOrCreateConnTracker(conn_id2);
+  ConnTracker& tracker1 = trackers_mgr_.GetOrCreateConnTracker(conn_id1);
+  ASSERT_EQ(&trackers_mgr_.GetOrCreateConnTracker(conn_id1), &tracker1);
+
+  tracker1.MarkForDeath(0);
+  tracker1.MarkFinalConnStatsReported();
+  CleanupTrackers();
+
+  EXPECT_NOT_OK(trackers_mgr_.GetConnTracker(1, 1));
+  ASSERT_OK_AND_EQ(trackers_mgr_.GetConnTracker(2, 1), &tracker2);
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 1);
+
+  // A new tracker is created for the old conn_id, instead of returning the destroyed one.
+  trackers_mgr_.GetOrCreateConnTracker(conn_id1);
+  EXPECT_EQ(trackers_mgr_.active_trackers().size(), 2);
+  EXPECT_THAT(trackers_mgr_.StatsString(), HasSubstr("kCreated=3 kDestroyed=1"));
+}
+
 class ConnTrackerGenerationsTest : public ::testing::Test {
  protected:
   ConnTrackerGenerationsTest() : tracker_pool(1024) {
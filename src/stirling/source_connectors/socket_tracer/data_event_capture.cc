@@ -0,0 +1,73 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/data_event_capture.h"
+
+#include <cstring>
+#include <fstream>
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+
+namespace px {
+namespace stirling {
+
+RawDataEvent ToRawDataEvent(const sockeventpb::SocketDataEvent& pb) {
+  socket_data_event_t::attr_t attr = {};
+  attr.timestamp_ns = pb.attr().timestamp_ns();
+  attr.conn_id.upid.pid = pb.attr().conn_id().pid();
+  attr.conn_id.upid.start_time_ticks = pb.attr().conn_id().start_time_ns();
+  attr.conn_id.fd = pb.attr().conn_id().fd();
+  attr.conn_id.tsid = pb.attr().conn_id().generation();
+  attr.protocol = static_cast<traffic_protocol_t>(pb.attr().protocol());
+  attr.role = static_cast<endpoint_role_t>(pb.attr().role());
+  attr.direction = static_cast<traffic_direction_t>(pb.attr().direction());
+  attr.pos = pb.attr().pos();
+  attr.msg_size = pb.attr().msg_size();
+  attr.msg_buf_size = pb.msg().size();
+
+  RawDataEvent raw(offsetof(socket_data_event_t, msg) + pb.msg().size());
+  std::memcpy(raw.data() + offsetof(socket_data_event_t, attr), &attr, sizeof(attr));
+  std::memcpy(raw.data() + offsetof(socket_data_event_t, msg), pb.msg().data(), pb.msg().size());
+  return raw;
+}
+
+StatusOr<std::vector<RawDataEvent>> ReadDataEventCapture(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.good()) {
+    return error::Internal("Could not open capture $0", path.string());
+  }
+  google::protobuf::io::IstreamInputStream input(&file);
+
+  std::vector<RawDataEvent> events;
+  sockeventpb::SocketDataEvent pb;
+  bool clean_eof = false;
+  while (google::protobuf::util::ParseDelimitedFromZeroCopyStream(&pb, &input, &clean_eof)) {
+    events.push_back(ToRawDataEvent(pb));
+  }
+  if (!clean_eof) {
+    return error::Internal("Capture $0 is truncated after $1 events", path.string(),
+                           events.size());
+  }
+  return events;
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
+
+namespace px {
+namespace stirling {
+
+// A data event laid out like the socket_data_event_t records in the perf buffer, so it can be
+// handed to the same callbacks that handle the perf buffer.
+using RawDataEvent = std::vector<char>;
+
+RawDataEvent ToRawDataEvent(const sockeventpb::SocketDataEvent& pb);
+
+/**
+ * Reads the data events of a capture recorded by running stirling with
+ * --perf_buffer_events_output_path=<path>.bin.
+ */
+StatusOr<std::vector<RawDataEvent>> ReadDataEventCapture(const std::filesystem::path& path);
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+#include "src/stirling/source_connectors/socket_tracer/data_event_capture.h"
+#include "src/stirling/source_connectors/socket_tracer/data_stream.h"
+#include "src/stirling/source_connectors/socket_tracer/proto/sock_event.pb.h"
+
+// Captures are recorded by running stirling with --perf_buffer_events_output_path=<path>.bin.
+DEFINE_string(data_events_capture, "",
+              "Binary capture of socket data events to replay. If empty, synthetic HTTP-sized "
+              "events are used.");
+
+using px::stirling::DataStream;
+using px::stirling::RawDataEvent;
+using px::stirling::SocketDataEvent;
+using px::stirling::SocketDataEventView;
+
+namespace {
+
+std::vector<RawDataEvent> SyntheticEvents() {
+  constexpr int kNumConns = 16;
+  constexpr int kNumEventsPerConn = 256;
+  constexpr int kMsgSize = 1024;
+
+  std::vector<RawDataEvent> events;
+  std::vector<uint64_t> pos(kNumConns, 0);
+  for (int i = 0; i < kNumEventsPerConn; ++i) {
+    for (int c = 0; c < kNumConns; ++c) {
+      px::stirling::sockeventpb::SocketDataEvent pb;
+      pb.mutable_attr()->set_timestamp_ns(i);
+      pb.mutable_attr()->mutable_conn_id()->set_pid(c);
+      pb.mutable_attr()->mutable_conn_id()->set_fd(3);
+      pb.mutable_attr()->set_protocol(kProtocolHTTP);
+      pb.mutable_attr()->set_direction(kEgress);
+      pb.mutable_attr()->set_pos(pos[c]);
+      pb.mutable_attr()->set_msg_size(kMsgSize);
+      pb.set_msg(std::string(kMsgSize, 'x'));
+      pos[c] += kMsgSize;
+      events.push_back(px::stirling::ToRawDataEvent(pb));
+    }
+  }
+  return events;
+}
+
+const std::vector<RawDataEvent>& Events() {
+  static const std::vector<RawDataEvent> kEvents =
+      FLAGS_data_events_capture.empty()
+          ? SyntheticEvents()
+          : px::stirling::ReadDataEventCapture(FLAGS_data_events_capture).ConsumeValueOrDie();
+  return kEvents;
+}
+
+int64_t TotalBytes(const std::vector<RawDataEvent>& events) {
+  int64_t bytes = 0;
+  for (const auto& event : events) {
+    bytes += event.size() - offsetof(socket_data_event_t, msg);
+  }
+  return bytes;
+}
+
+// The data streams of the traced connections, as held by their ConnTrackers.
+class DataStreams {
+ public:
+  DataStream* Get(const socket_data_event_t::attr_t& attr) {
+    auto& stream = streams_[std::make_tuple(attr.conn_id.upid.pid, attr.conn_id.fd,
+                                            attr.conn_id.tsid, attr.direction)];
+    if (stream == nullptr) {
+      stream = std::make_unique<DataStream>();
+    }
+    return stream.get();
+  }
+
+ private:
+  absl::flat_hash_map<std::tuple<uint32_t, int32_t, uint64_t, traffic_direction_t>,
+                      std::unique_ptr<DataStream>>
+      streams_;
+};
+
+}  // namespace
+
+// The previous ingestion path: every event is copied into a heap allocated SocketDataEvent,
+// and then again into the DataStreamBuffer.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ingest_copied_events(benchmark::State& state) {
+  const auto& events = Events();
+  for (auto _ : state) {
+    DataStreams streams;
+    for (const auto& raw : events) {
+      auto event = std::make_unique<SocketDataEvent>(raw.data());
+      streams.Get(event->attr)->AddData(std::move(event));
+    }
+    benchmark::DoNotOptimize(streams);
+  }
+  state.SetBytesProcessed(state.iterations() * TotalBytes(events));
+  state.SetItemsProcessed(state.iterations() * events.size());
+}
+
+// The current ingestion path: the msg is copied straight from the perf buffer record into the
+// DataStreamBuffer.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_ingest_event_views(benchmark::State& state) {
+  const auto& events = Events();
+  for (auto _ : state) {
+    DataStreams streams;
+    for (const auto& raw : events) {
+      SocketDataEventView event(raw.data());
+      if (event.ViewableInPlace()) {
+        streams.Get(event.attr)->AddData(event);
+      } else {
+        SocketDataEvent event_copy(raw.data());
+        streams.Get(event.attr)->AddData(SocketDataEventView(event_copy));
+      }
+    }
+    benchmark::DoNotOptimize(streams);
+  }
+  state.SetBytesProcessed(state.iterations() * TotalBytes(events));
+  state.SetItemsProcessed(state.iterations() * events.size());
+}
+
+BENCHMARK(BM_ingest_copied_events);
+BENCHMARK(BM_ingest_event_views);
@@ -18,6 +18,7 @@
 
 #include "src/stirling/source_connectors/socket_tracer/data_stream.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/types.h"
@@ -32,12 +33,12 @@ DEFINE_uint32(datastream_buffer_spike_size,
 namespace px {
 namespace stirling {
 
-void DataStream::AddData(std::unique_ptr<SocketDataEvent> event) {
-  LOG_IF(WARNING, event->attr.msg_size > event->msg.size() && !event->msg.empty())
+void DataStream::AddData(const SocketDataEventView& event) {
+  LOG_IF(WARNING, event.attr.msg_size > event.msg.size() && !event.msg.empty())
       << absl::Substitute("Message truncated, original size: $0, transferred size: $1",
-                          event->attr.msg_size, event->msg.size());
+                          event.attr.msg_size, event.msg.size());
 
-  data_buffer_.Add(event->attr.pos, event->msg, event->attr.timestamp_ns);
+  data_buffer_.Add(event.attr.pos, event.msg, event.attr.timestamp_ns);
 
   has_new_events_ = true;
 }
@@ -70,6 +71,13 @@ bool IsSyncRequired(int64_t stuck_count) {
 
 }  // namespace
 
+bool DataStream::AwaitingPartialFrame() const {
+  // A frame that can't fit in the buffer, or that is followed by a gap, is never going to complete.
+  return partial_frame_size_ != 0 && partial_frame_pos_ == data_buffer_.position() &&
+         data_buffer_.size() < partial_frame_size_ && partial_frame_size_ <= retention_capacity_ &&
+         data_buffer_.Head().size() == data_buffer_.size() && !IsSyncRequired(stuck_count_);
+}
+
 // ProcessBytesToFrames() processes the raw data in the DataStream to extract parsed frames.
 //
 // It considers contiguous events from the head of the stream. Any missing events in the sequence
@@ -91,6 +99,7 @@ void DataStream::ProcessBytesToFrames(message_type_t type, TStateType* state) {
   LOG_IF(WARNING, IsEOS()) << "DataStream reaches EOS, no more data to process.";
 
   const size_t orig_pos = data_buffer_.position();
+  const bool idle = !has_new_events_;
 
   // A description of some key variables in this function:
   //
@@ -112,6 +121,14 @@ void DataStream::ProcessBytesToFrames(message_type_t type, TStateType* state) {
   //                 new events, because we have hit the threshold to attempt a stream recovery.
   //                 Used for the first iteration only.
 
+  // The frame at the head is still short of the size its header announced, so parsing it again
+  // would only need more data again. New data towards the frame is progress, so this doesn't count
+  // towards stuck_count_; the stream only gets stuck if the data stops coming.
+  if (has_new_events_ && AwaitingPartialFrame()) {
+    has_new_events_ = false;
+    return;
+  }
+
   // We appear to be stuck with an an unparseable sequence of events blocking the head.
   bool attempt_sync = IsSyncRequired(stuck_count_);
 
@@ -125,8 +142,9 @@ void DataStream::ProcessBytesToFrames(message_type_t type, TStateType* state) {
     size_t contiguous_bytes = data_buffer_.Head().size();
 
     // Now parse the raw data.
-    parse_result = protocols::ParseFrames(type, data_buffer_, &typed_messages,
-                                          IsSyncRequired(stuck_count_), state);
+    const bool resync = IsSyncRequired(stuck_count_);
+    parse_result = protocols::ParseFrames(type, data_buffer_, &typed_messages, resync, state);
+    partial_frame_size_ = 0;
 
     if (contiguous_bytes != data_buffer_.size()) {
       // We weren't able to submit all bytes, which means we ran into a missing event.
@@ -148,6 +166,13 @@ void DataStream::ProcessBytesToFrames(message_type_t type, TStateType* state) {
         stuck_count_ = 0;
       }
 
+      // Remember the size of the incomplete frame now at the head. After a resync, the head is
+      // not necessarily where that frame starts.
+      if (parse_result.state == ParseState::kNeedsMoreData && !resync) {
+        partial_frame_size_ = protocols::PartialFrameSize<TFrameType>(type, data_buffer_.Head());
+        partial_frame_pos_ = data_buffer_.position();
+      }
+
       keep_processing = false;
     }
 
@@ -183,6 +208,14 @@ void DataStream::ProcessBytesToFrames(message_type_t type, TStateType* state) {
     stuck_count_ = 0;
   }
 
+  // The buffer only grows as data arrives, and keeps its memory for the next data. Give back the
+  // memory of a spike right away, and all the spare memory once the stream goes idle.
+  constexpr size_t kMaxSpareFactor = 2;
+  if (idle || data_buffer_.AllocatedBytes() >
+                  kMaxSpareFactor * std::max<size_t>(data_buffer_.size(), retention_capacity_)) {
+    data_buffer_.ShrinkToFit();
+  }
+
   last_parse_state_ = parse_result.state;
 
   // has_new_events_ should be false for the next transfer cycle.
@@ -214,6 +247,8 @@ void DataStream::Reset() {
   data_buffer_.Reset();
   has_new_events_ = false;
   stuck_count_ = 0;
+  partial_frame_size_ = 0;
+  frames_bytes_ = 0;
 
   frames_ = std::monostate();
 }
@@ -53,7 +53,13 @@ class DataStream : NotCopyMoveable {
   /**
    * Adds a raw (unparsed) chunk of data into the stream.
    */
-  void AddData(std::unique_ptr<SocketDataEvent> event);
+  void AddData(std::unique_ptr<SocketDataEvent> event) { AddData(SocketDataEventView(*event)); }
+
+  /**
+   * Adds a raw (unparsed) chunk of data into the stream, copying the msg straight into the
+   * stream's buffer.
+   */
+  void AddData(const SocketDataEventView& event);
 
   /**
    * Parses as many messages as it can from the raw events into the messages container.
@@ -176,13 +182,13 @@ class DataStream : NotCopyMoveable {
   template <typename TFrameType>
   void CleanupFrames(size_t size_limit_bytes,
                      std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp) {
-    size_t size = FramesSize<TFrameType>();
-    if (size > size_limit_bytes) {
-      VLOG(1) << absl::Substitute("Messages cleared due to size limit ($0 > $1).", size,
-                                  size_limit_bytes);
+    frames_bytes_ = FramesSize<TFrameType>();
+    if (frames_bytes_ > size_limit_bytes) {
+      VLOG(1) << absl::Substitute("Messages cleared due to size limit (> $0).", size_limit_bytes);
       Frames<TFrameType>().clear();
+      frames_bytes_ = 0;
     }
-    EraseExpiredFrames(expiry_timestamp, &Frames<TFrameType>());
+    frames_bytes_ -= EraseExpiredFrames(expiry_timestamp, &Frames<TFrameType>());
   }
 
   /**
@@ -201,11 +207,23 @@ class DataStream : NotCopyMoveable {
 
   const protocols::DataStreamBuffer& data_buffer() const { return data_buffer_; }
 
+  /**
+   * Approximate memory held by the stream: the raw data buffer as allocated, and the parsed frames
+   * as of the last CleanupFrames().
+   */
+  size_t MemoryUsage() const { return data_buffer_.AllocatedBytes() + frames_bytes_; }
+
  private:
+  // Returns true if the frame at the head is known to be incomplete still, from the size read out
+  // of its header by the last ProcessBytesToFrames().
+  bool AwaitingPartialFrame() const;
+
+  // Returns the approximate size of the erased frames.
   template <typename TFrameType>
-  static void EraseExpiredFrames(
+  static size_t EraseExpiredFrames(
       std::chrono::time_point<std::chrono::steady_clock> expiry_timestamp,
       std::deque<TFrameType>* frames) {
+    size_t erased_bytes = 0;
     auto iter = frames->begin();
     for (; iter != frames->end(); ++iter) {
       auto frame_timestamp = std::chrono::time_point<std::chrono::steady_clock>(
@@ -216,8 +234,10 @@ class DataStream : NotCopyMoveable {
       if (expiry_timestamp < frame_timestamp) {
         break;
       }
+      erased_bytes += iter->ByteSize();
     }
     frames->erase(frames->begin(), iter);
+    return erased_bytes;
   }
 
   // Raw data events from BPF.
@@ -225,6 +245,9 @@ class DataStream : NotCopyMoveable {
 
   uint32_t retention_capacity_ = 0;
 
+  // The approximate size of the parsed frames, as of the last CleanupFrames().
+  size_t frames_bytes_ = 0;
+
   // Vector of parsed HTTP/MySQL messages.
   // Once parsed, the raw data events should be discarded.
   // std::variant adds 8 bytes of overhead (to 80->88 for deque)
@@ -248,6 +271,12 @@ class DataStream : NotCopyMoveable {
   // Thus it is a state, not a statistic.
   int stuck_count_ = 0;
 
+  // The size of the incomplete frame at position partial_frame_pos_ of the data buffer, if its
+  // protocol can tell from the frame header. 0 if unknown.
+  // Note: like stuck_count_, this is a state and resets with the stream.
+  size_t partial_frame_size_ = 0;
+  size_t partial_frame_pos_ = 0;
+
   // Keep some stats on ParseFrames() attempts.
   int stat_valid_frames_ = 0;
   int stat_invalid_frames_ = 0;
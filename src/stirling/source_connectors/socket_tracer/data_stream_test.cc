@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "src/common/testing/testing.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/mysql/test_utils.h"
 #include "src/stirling/source_connectors/socket_tracer/testing/event_generator.h"
 
 namespace px {
@@ -85,6 +86,32 @@ TEST_F(DataStreamTest, LostEvent) {
   EXPECT_FALSE(stream.IsStuck());
 }
 
+TEST_F(DataStreamTest, EventViews) {
+  socket_data_event_t event = {};
+  event.attr.direction = traffic_direction_t::kEgress;
+  event.attr.protocol = kProtocolHTTP;
+  event.attr.msg_size = kHTTPReq0.size();
+  event.attr.msg_buf_size = kHTTPReq0.size();
+  kHTTPReq0.copy(event.msg, kHTTPReq0.size());
+
+  SocketDataEventView view(&event);
+  EXPECT_TRUE(view.ViewableInPlace());
+  EXPECT_EQ(view.msg, kHTTPReq0);
+
+  protocols::NoState state{};
+  DataStream stream;
+  stream.AddData(view);
+  stream.ProcessBytesToFrames<http::Message>(message_type_t::kRequest, &state);
+  EXPECT_THAT(stream.Frames<http::Message>(), SizeIs(1));
+
+  // Events that SocketDataEvent changes while copying them can't be viewed in place.
+  event.attr.msg_size = kHTTPReq0.size() + 100;
+  EXPECT_FALSE(SocketDataEventView(&event).ViewableInPlace());
+  event.attr.msg_size = kHTTPReq0.size();
+  event.attr.prepend_length_header = true;
+  EXPECT_FALSE(SocketDataEventView(&event).ViewableInPlace());
+}
+
 TEST_F(DataStreamTest, StuckTemporarily) {
   testing::EventGenerator event_gen(&real_clock_);
 
@@ -150,6 +177,43 @@ TEST_F(DataStreamTest, StuckTooLong) {
   EXPECT_EQ(requests[1].req_path, "/bar.html");
 }
 
+// A frame whose header tells its size is neither parsed again, nor counted as stuck, while the
+// rest of it keeps arriving. So a large frame spread over many transfer iterations is not lost to
+// stream recovery.
+TEST_F(DataStreamTest, LargeFrameOverManyIterations) {
+  testing::EventGenerator event_gen(&real_clock_);
+  const std::string packet = mysql::testutils::GenRequestPacket(
+      mysql::Command::kQuery, absl::StrCat("SELECT '", std::string(4000, 'x'), "'"));
+  protocols::mysql::StateWrapper state{};
+
+  DataStream stream;
+  constexpr size_t kEventSize = 400;
+  for (size_t pos = 0; pos < packet.size(); pos += kEventSize) {
+    stream.AddData(event_gen.InitSendEvent<kProtocolMySQL>(packet.substr(pos, kEventSize)));
+    stream.ProcessBytesToFrames<mysql::Packet>(message_type_t::kRequest, &state);
+    EXPECT_FALSE(stream.IsStuck());
+  }
+
+  const auto& requests = stream.Frames<mysql::Packet>();
+  ASSERT_THAT(requests, SizeIs(1));
+  EXPECT_EQ(requests[0].msg.size(), packet.size() - mysql::kPacketHeaderLength);
+}
+
+// If the rest of the frame stops coming, the stream still gets stuck.
+TEST_F(DataStreamTest, PartialFrameStuckWhenDataStops) {
+  testing::EventGenerator event_gen(&real_clock_);
+  const std::string packet = mysql::testutils::GenRequestPacket(
+      mysql::Command::kQuery, absl::StrCat("SELECT '", std::string(4000, 'x'), "'"));
+  protocols::mysql::StateWrapper state{};
+
+  DataStream stream;
+  stream.AddData(event_gen.InitSendEvent<kProtocolMySQL>(packet.substr(0, 400)));
+  for (int i = 0; i < 5; ++i) {
+    stream.ProcessBytesToFrames<mysql::Packet>(message_type_t::kRequest, &state);
+  }
+  EXPECT_TRUE(stream.IsStuck());
+}
+
 TEST_F(DataStreamTest, PartialMessageRecovery) {
   testing::EventGenerator event_gen(&real_clock_);
   std::unique_ptr<SocketDataEvent> req0 = event_gen.InitSendEvent<kProtocolHTTP>(kHTTPReq0);
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/endpoint_protocol_cache.h"
+
+DEFINE_bool(stirling_enable_endpoint_protocol_cache,
+            gflags::BoolFromEnv("PL_STIRLING_ENABLE_ENDPOINT_PROTOCOL_CACHE", false),
+            "If true, new client connections start out with the protocol that earlier connections "
+            "of the same process to the same server produced records of, and connections to "
+            "servers that were repeatedly unparseable are disabled right away.");
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+bool IsIPAddr(const SockAddr& addr) {
+  return addr.family == SockAddrFamily::kIPv4 || addr.family == SockAddrFamily::kIPv6;
+}
+
+}  // namespace
+
+const EndpointProtocolCache::Entry* EndpointProtocolCache::Find(const struct upid_t& upid,
+                                                              const SockAddr& server) const {
+  if (!IsIPAddr(server)) {
+    return nullptr;
+  }
+  auto iter = entries_.find(MakeKey(upid, server));
+  if (iter == entries_.end()) {
+    return nullptr;
+  }
+  return &iter->second;
+}
+
+EndpointProtocolCache::Entry* EndpointProtocolCache::GetOrCreate(const struct upid_t& upid,
+                                                                 const SockAddr& server) {
+  Key key = MakeKey(upid, server);
+  auto iter = entries_.find(key);
+  if (iter != entries_.end()) {
+    return &iter->second;
+  }
+  if (entries_.size() >= max_entries_) {
+    VLOG(1) << absl::Substitute("Clearing the endpoint protocol cache of $0 entries.",
+                                entries_.size());
+    entries_.clear();
+  }
+  return &entries_[std::move(key)];
+}
+
+void EndpointProtocolCache::Confirm(const struct upid_t& upid, const SockAddr& server,
+                                    traffic_protocol_t protocol) {
+  if (!IsIPAddr(server)) {
+    return;
+  }
+  Entry* entry = GetOrCreate(upid, server);
+  entry->protocol = protocol;
+  entry->num_unparseable = 0;
+}
+
+void EndpointProtocolCache::ReportUnparseable(const struct upid_t& upid, const SockAddr& server) {
+  if (!IsIPAddr(server)) {
+    return;
+  }
+  Entry* entry = GetOrCreate(upid, server);
+  entry->protocol = kProtocolUnknown;
+  ++entry->num_unparseable;
+}
+
+}  // namespace stirling
+}  // namespace px
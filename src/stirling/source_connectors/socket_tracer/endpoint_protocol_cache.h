@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/common/base/inet_utils.h"
+#include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+
+DECLARE_bool(stirling_enable_endpoint_protocol_cache);
+
+namespace px {
+namespace stirling {
+
+/**
+ * Remembers the protocol of the servers that the client connections of each process talk to, so
+ * that new connections to the same server start out with the protocol that the earlier
+ * connections confirmed, instead of relying on the kernel-side inference of their first bytes.
+ * This matters for short-lived connections, which are often too short for a misinference to be
+ * corrected.
+ *
+ * Servers whose connections are repeatedly unparseable, and never produced a record, are marked
+ * uninteresting, so that new connections to them are disabled right away.
+ *
+ * Server-side connections are not cached, because their remote endpoint is the client's
+ * ephemeral port. Only IP endpoints are cached.
+ */
+class EndpointProtocolCache {
+ public:
+  // The number of consecutive unparseable connections after which a server is uninteresting.
+  static constexpr int kUnparseableThreshold = 3;
+
+  struct Entry {
+    // kProtocolUnknown until a connection produced records.
+    traffic_protocol_t protocol = kProtocolUnknown;
+    int num_unparseable = 0;
+
+    bool uninteresting() const {
+      return protocol == kProtocolUnknown && num_unparseable >= kUnparseableThreshold;
+    }
+  };
+
+  /**
+   * @param max_entries Once there are this many entries, the cache is cleared, so that the entries
+   * of exited processes and old servers don't accumulate.
+   */
+  explicit EndpointProtocolCache(size_t max_entries) : max_entries_(max_entries) {}
+
+  /**
+   * Returns the entry of the server that the client connection of the process talks to, or
+   * nullptr if there is none.
+   */
+  const Entry* Find(const struct upid_t& upid, const SockAddr& server) const;
+
+  /**
+   * Records that a connection to the server produced records of the protocol.
+   */
+  void Confirm(const struct upid_t& upid, const SockAddr& server, traffic_protocol_t protocol);
+
+  /**
+   * Records that a connection to the server was disabled because it was unparseable.
+   * A confirmed protocol that a connection can't parse is forgotten.
+   */
+  void ReportUnparseable(const struct upid_t& upid, const SockAddr& server);
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Key {
+    uint32_t tgid;
+    uint64_t start_time_ticks;
+    std::string addr;
+    int port;
+
+    bool operator==(const Key& rhs) const {
+      return tgid == rhs.tgid && start_time_ticks == rhs.start_time_ticks && addr == rhs.addr &&
+             port == rhs.port;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.tgid, key.start_time_ticks, key.addr, key.port);
+    }
+  };
+
+  static Key MakeKey(const struct upid_t& upid, const SockAddr& server) {
+    return Key{upid.tgid, upid.start_time_ticks, server.AddrStr(), server.port()};
+  }
+
+  Entry* GetOrCreate(const struct upid_t& upid, const SockAddr& server);
+
+  size_t max_entries_;
+  absl::flat_hash_map<Key, Entry> entries_;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/endpoint_protocol_cache.h"
+
+#include <arpa/inet.h>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+SockAddr Server(std::string_view addr, int port) {
+  struct in_addr in_addr;
+  inet_pton(AF_INET, std::string(addr).c_str(), &in_addr);
+  SockAddr sock_addr;
+  PopulateInetAddr(in_addr, htons(port), &sock_addr);
+  return sock_addr;
+}
+
+TEST(EndpointProtocolCacheTest, Confirm) {
+  EndpointProtocolCache cache(/*max_entries*/ 10);
+  struct upid_t upid = {};
+  upid.tgid = 123;
+  upid.start_time_ticks = 456;
+
+  EXPECT_EQ(cache.Find(upid, Server("1.2.3.4", 80)), nullptr);
+
+  cache.Confirm(upid, Server("1.2.3.4", 80), kProtocolHTTP);
+  const EndpointProtocolCache::Entry* entry = cache.Find(upid, Server("1.2.3.4", 80));
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->protocol, kProtocolHTTP);
+  EXPECT_FALSE(entry->uninteresting());
+
+  // Other ports, and other processes, have their own entries.
+  EXPECT_EQ(cache.Find(upid, Server("1.2.3.4", 81)), nullptr);
+  struct upid_t other_upid = upid;
+  other_upid.start_time_ticks = 789;
+  EXPECT_EQ(cache.Find(other_upid, Server("1.2.3.4", 80)), nullptr);
+}
+
+TEST(EndpointProtocolCacheTest, Unparseable) {
+  EndpointProtocolCache cache(/*max_entries*/ 10);
+  struct upid_t upid = {};
+  upid.tgid = 123;
+  const SockAddr server = Server("1.2.3.4", 5432);
+
+  cache.Confirm(upid, server, kProtocolPGSQL);
+  cache.ReportUnparseable(upid, server);
+  ASSERT_NE(cache.Find(upid, server), nullptr);
+  EXPECT_EQ(cache.Find(upid, server)->protocol, kProtocolUnknown);
+
+  for (int i = 1; i < EndpointProtocolCache::kUnparseableThreshold; ++i) {
+    EXPECT_FALSE(cache.Find(upid, server)->uninteresting());
+    cache.ReportUnparseable(upid, server);
+  }
+  EXPECT_TRUE(cache.Find(upid, server)->uninteresting());
+
+  // A connection that produces records makes the server interesting again.
+  cache.Confirm(upid, server, kProtocolPGSQL);
+  EXPECT_FALSE(cache.Find(upid, server)->uninteresting());
+}
+
+TEST(EndpointProtocolCacheTest, MaxEntries) {
+  EndpointProtocolCache cache(/*max_entries*/ 2);
+  struct upid_t upid = {};
+
+  cache.Confirm(upid, Server("1.2.3.4", 1), kProtocolHTTP);
+  cache.Confirm(upid, Server("1.2.3.4", 2), kProtocolHTTP);
+  EXPECT_EQ(cache.size(), 2u);
+  cache.Confirm(upid, Server("1.2.3.4", 2), kProtocolHTTP);
+  EXPECT_EQ(cache.size(), 2u);
+  cache.Confirm(upid, Server("1.2.3.4", 3), kProtocolHTTP);
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_NE(cache.Find(upid, Server("1.2.3.4", 3)), nullptr);
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/http_red_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <absl/strings/ascii.h>
+#include <absl/strings/str_join.h>
+#include <absl/strings/str_split.h>
+
+DEFINE_bool(stirling_enable_http_red_metrics,
+            gflags::BoolFromEnv("PL_STIRLING_ENABLE_HTTP_RED_METRICS", false),
+            "If true, the socket tracer aggregates the rate, errors and latency of HTTP requests "
+            "into the http_red_metrics table.");
+DEFINE_uint32(stirling_http_red_metrics_max_keys,
+              gflags::Uint32FromEnv("PL_STIRLING_HTTP_RED_METRICS_MAX_KEYS", 10000),
+              "The most (process, endpoint, method, path, status class) keys that the "
+              "http_red_metrics table aggregates per push. Requests of further keys are "
+              "aggregated with the path *.");
+DEFINE_double(stirling_http_events_success_sample_rate,
+              gflags::DoubleFromEnv("PL_STIRLING_HTTP_EVENTS_SUCCESS_SAMPLE_RATE", 1.0),
+              "With --stirling_enable_http_red_metrics, the fraction of the requests without an "
+              "error status that are recorded in http_events. Requests with an error status are "
+              "always recorded.");
+
+namespace px {
+namespace stirling {
+
+size_t LatencySketch::BucketIndex(uint64_t v) {
+  constexpr uint64_t kNumSubBuckets = 1 << kSubBucketBits;
+  if (v < kNumSubBuckets) {
+    return v;
+  }
+  int msb = 63 - __builtin_clzll(v);
+  uint64_t sub_bucket = (v >> (msb - kSubBucketBits)) & (kNumSubBuckets - 1);
+  return (msb - kSubBucketBits + 1) * kNumSubBuckets + sub_bucket;
+}
+
+uint64_t LatencySketch::BucketLowerBound(size_t idx) {
+  constexpr size_t kNumSubBuckets = 1 << kSubBucketBits;
+  if (idx < kNumSubBuckets) {
+    return idx;
+  }
+  int msb = idx / kNumSubBuckets + kSubBucketBits - 1;
+  uint64_t sub_bucket = idx % kNumSubBuckets;
+  return (kNumSubBuckets + sub_bucket) << (msb - kSubBucketBits);
+}
+
+void LatencySketch::Add(int64_t latency_ns) {
+  latency_ns = std::max<int64_t>(latency_ns, 0);
+  size_t idx = BucketIndex(latency_ns);
+  if (idx >= buckets_.size()) {
+    buckets_.resize(idx + 1);
+  }
+  ++buckets_[idx];
+  ++count_;
+  max_ = std::max(max_, latency_ns);
+  sum_ += latency_ns;
+}
+
+int64_t LatencySketch::Quantile(double q) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  uint64_t rank = std::max<uint64_t>(1, std::ceil(q * count_));
+  uint64_t seen = 0;
+  for (size_t idx = 0; idx < buckets_.size(); ++idx) {
+    seen += buckets_[idx];
+    if (seen >= rank) {
+      // The middle of the bucket, which is never further than the largest latency.
+      uint64_t lower = BucketLowerBound(idx);
+      uint64_t upper = BucketLowerBound(idx + 1);
+      return std::min<int64_t>(lower + (upper - lower) / 2, max_);
+    }
+  }
+  return max_;
+}
+
+namespace {
+
+bool IsIDSegment(std::string_view segment) {
+  if (segment.empty()) {
+    return false;
+  }
+  if (std::all_of(segment.begin(), segment.end(), absl::ascii_isdigit)) {
+    return true;
+  }
+  // Hex strings and UUIDs, but not short words like "cafe" or "v1".
+  constexpr size_t kMinHexIDLength = 8;
+  return segment.size() >= kMinHexIDLength &&
+         std::any_of(segment.begin(), segment.end(), absl::ascii_isdigit) &&
+         std::all_of(segment.begin(), segment.end(),
+                     [](char c) { return absl::ascii_isxdigit(c) || c == '-'; });
+}
+
+}  // namespace
+
+std::string NormalizeHTTPPath(std::string_view path) {
+  path = path.substr(0, path.find_first_of("?#"));
+  std::vector<std::string_view> segments = absl::StrSplit(path, '/');
+  for (auto& segment : segments) {
+    if (IsIDSegment(segment)) {
+      segment = "*";
+    }
+  }
+  return absl::StrJoin(segments, "/");
+}
+
+void HTTPREDMetrics::Record(const struct upid_t& upid, std::string_view remote_addr,
+                            int remote_port, endpoint_role_t role,
+                            const protocols::http::Record& record) {
+  int status = record.resp.resp_status;
+  Key key{upid,
+          std::string(remote_addr),
+          role == kRoleServer ? 0 : remote_port,
+          role,
+          record.req.req_method,
+          NormalizeHTTPPath(record.req.req_path),
+          status >= 100 && status < 600 ? status / 100 : 0};
+  if (metrics_.size() >= max_keys_ && !metrics_.contains(key)) {
+    key.req_path = "*";
+  }
+
+  int64_t latency_ns = 0;
+  if (record.req.timestamp_ns > 0 && record.resp.timestamp_ns > record.req.timestamp_ns) {
+    latency_ns = record.resp.timestamp_ns - record.req.timestamp_ns;
+  }
+  metrics_[std::move(key)].Add(latency_ns);
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/bpf_tools/bcc_bpf_intf/upid.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/types.h"
+
+DECLARE_bool(stirling_enable_http_red_metrics);
+DECLARE_uint32(stirling_http_red_metrics_max_keys);
+DECLARE_double(stirling_http_events_success_sample_rate);
+
+namespace px {
+namespace stirling {
+
+/**
+ * A histogram of latencies with logarithmic buckets, from which quantiles are estimated to within
+ * about 6% of the actual value. Each power of two is split into 8 buckets.
+ */
+class LatencySketch {
+ public:
+  void Add(int64_t latency_ns);
+
+  /**
+   * Returns an estimate of the q-quantile of the added latencies, or 0 if there are none.
+   */
+  int64_t Quantile(double q) const;
+
+  uint64_t count() const { return count_; }
+  int64_t max() const { return max_; }
+  int64_t sum() const { return sum_; }
+
+ private:
+  static constexpr int kSubBucketBits = 3;
+
+  static size_t BucketIndex(uint64_t v);
+  static uint64_t BucketLowerBound(size_t idx);
+
+  // Grown to the largest bucket that was used.
+  std::vector<uint32_t> buckets_;
+  uint64_t count_ = 0;
+  int64_t max_ = 0;
+  int64_t sum_ = 0;
+};
+
+/**
+ * Returns the request path without its query and fragment, and with the segments that look like
+ * IDs (numbers, hex strings and UUIDs) replaced by *, so that requests for different resources of
+ * the same endpoint aggregate together.
+ */
+std::string NormalizeHTTPPath(std::string_view path);
+
+/**
+ * Aggregates the rate, errors and duration (RED) of HTTP requests, which are flushed to the
+ * http_red_metrics table. Requests are added before the ingest sampler decides which records go
+ * to http_events, so the metrics also count the requests that it drops.
+ */
+class HTTPREDMetrics {
+ public:
+  struct Key {
+    struct upid_t upid;
+    std::string remote_addr;
+    int remote_port;
+    endpoint_role_t role;
+    std::string req_method;
+    std::string req_path;
+    int resp_status_class;
+
+    bool operator==(const Key& rhs) const {
+      return upid.tgid == rhs.upid.tgid && upid.start_time_ticks == rhs.upid.start_time_ticks &&
+             remote_addr == rhs.remote_addr && remote_port == rhs.remote_port &&
+             role == rhs.role && req_method == rhs.req_method && req_path == rhs.req_path &&
+             resp_status_class == rhs.resp_status_class;
+    }
+
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.upid.tgid, key.upid.start_time_ticks, key.remote_addr,
+                        key.remote_port, key.role, key.req_method, key.req_path,
+                        key.resp_status_class);
+    }
+  };
+
+  /**
+   * @param max_keys The most keys that are aggregated between flushes. Once there are this many,
+   * the requests of new keys are aggregated with the path *.
+   */
+  explicit HTTPREDMetrics(size_t max_keys) : max_keys_(max_keys) {}
+
+  /**
+   * Adds the request of the record. For servers, the remote port is ignored, so that the requests
+   * of all the connections from the same client aggregate together.
+   */
+  void Record(const struct upid_t& upid, std::string_view remote_addr, int remote_port,
+              endpoint_role_t role, const protocols::http::Record& record);
+
+  const absl::flat_hash_map<Key, LatencySketch>& metrics() const { return metrics_; }
+
+  /**
+   * Forgets the requests that were added so far, such as after they've been flushed.
+   */
+  void Clear() { metrics_.clear(); }
+
+ private:
+  size_t max_keys_;
+  absl::flat_hash_map<Key, LatencySketch> metrics_;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "src/stirling/core/types.h"
+#include "src/stirling/source_connectors/socket_tracer/canonical_types.h"
+
+namespace px {
+namespace stirling {
+
+// clang-format off
+constexpr DataElement kHTTPREDMetricsElements[] = {
+        canonical_data_elements::kTime,
+        canonical_data_elements::kUPID,
+        canonical_data_elements::kRemoteAddr,
+        canonical_data_elements::kRemotePort,
+        canonical_data_elements::kTraceRole,
+        {"req_method", "HTTP request method (e.g. GET, POST, ...)",
+         types::DataType::STRING, types::SemanticType::ST_HTTP_REQ_METHOD,
+         types::PatternType::GENERAL_ENUM},
+        {"req_path", "Request path, without the query, and with ID-like segments replaced by *",
+         types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::STRUCTURED},
+        {"resp_status_class", "The class of the HTTP response status, e.g. 2 for 2xx statuses",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::GENERAL_ENUM},
+        {"num_requests", "The number of requests since the previous record.",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_GAUGE},
+        {"latency_p50", "The median latency of the requests since the previous record.",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_GAUGE},
+        {"latency_p90", "The 90th percentile latency of the requests since the previous record.",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_GAUGE},
+        {"latency_p99", "The 99th percentile latency of the requests since the previous record.",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_GAUGE},
+        {"latency_max", "The largest latency of the requests since the previous record.",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_GAUGE},
+        {"latency_sum", "The total latency of the requests since the previous record.",
+         types::DataType::INT64, types::SemanticType::ST_DURATION_NS,
+         types::PatternType::METRIC_GAUGE},
+#ifndef NDEBUG
+        canonical_data_elements::kPXInfo,
+#endif
+};
+// clang-format on
+
+constexpr DataTableSchema kHTTPREDMetricsTable(
+    "http_red_metrics",
+    "HTTP request rate, error rate and latency, aggregated per process, remote endpoint, method, "
+    "path and status class. Unlike http_events, it also counts the requests that are dropped "
+    "from http_events by the ingest rate limits.",
+    kHTTPREDMetricsElements);
+DEFINE_PRINT_TABLE(HTTPREDMetrics)
+
+namespace http_red_metrics_idx {
+
+constexpr int kTime = kHTTPREDMetricsTable.ColIndex("time_");
+constexpr int kUPID = kHTTPREDMetricsTable.ColIndex("upid");
+constexpr int kRemoteAddr = kHTTPREDMetricsTable.ColIndex("remote_addr");
+constexpr int kRemotePort = kHTTPREDMetricsTable.ColIndex("remote_port");
+constexpr int kRole = kHTTPREDMetricsTable.ColIndex("trace_role");
+constexpr int kReqMethod = kHTTPREDMetricsTable.ColIndex("req_method");
+constexpr int kReqPath = kHTTPREDMetricsTable.ColIndex("req_path");
+constexpr int kRespStatusClass = kHTTPREDMetricsTable.ColIndex("resp_status_class");
+constexpr int kNumRequests = kHTTPREDMetricsTable.ColIndex("num_requests");
+constexpr int kLatencyP50 = kHTTPREDMetricsTable.ColIndex("latency_p50");
+constexpr int kLatencyP90 = kHTTPREDMetricsTable.ColIndex("latency_p90");
+constexpr int kLatencyP99 = kHTTPREDMetricsTable.ColIndex("latency_p99");
+constexpr int kLatencyMax = kHTTPREDMetricsTable.ColIndex("latency_max");
+constexpr int kLatencySum = kHTTPREDMetricsTable.ColIndex("latency_sum");
+#ifndef NDEBUG
+constexpr int kPxInfo = kHTTPREDMetricsTable.ColIndex("px_info_");
+#endif
+
+}  // namespace http_red_metrics_idx
+
+}  // namespace stirling
+}  // namespace px
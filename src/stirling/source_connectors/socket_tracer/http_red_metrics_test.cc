@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/http_red_metrics.h"
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+TEST(LatencySketchTest, Quantiles) {
+  LatencySketch sketch;
+  EXPECT_EQ(sketch.Quantile(0.5), 0);
+
+  for (int64_t i = 1; i <= 1000; ++i) {
+    sketch.Add(i * 1000);
+  }
+  EXPECT_EQ(sketch.count(), 1000u);
+  EXPECT_EQ(sketch.max(), 1000 * 1000);
+  EXPECT_EQ(sketch.sum(), 1000 * 1001 / 2 * 1000);
+
+  EXPECT_NEAR(sketch.Quantile(0.5), 500 * 1000, 0.07 * 500 * 1000);
+  EXPECT_NEAR(sketch.Quantile(0.9), 900 * 1000, 0.07 * 900 * 1000);
+  EXPECT_NEAR(sketch.Quantile(0.99), 990 * 1000, 0.07 * 990 * 1000);
+  EXPECT_LE(sketch.Quantile(1.0), sketch.max());
+}
+
+TEST(LatencySketchTest, SmallValuesAreExact) {
+  LatencySketch sketch;
+  sketch.Add(-5);
+  sketch.Add(3);
+  sketch.Add(7);
+  EXPECT_EQ(sketch.Quantile(0.1), 0);
+  EXPECT_EQ(sketch.Quantile(0.5), 3);
+  EXPECT_EQ(sketch.Quantile(1.0), 7);
+}
+
+TEST(NormalizeHTTPPathTest, ReplacesIDs) {
+  EXPECT_EQ(NormalizeHTTPPath("/"), "/");
+  EXPECT_EQ(NormalizeHTTPPath("/api/v1/users"), "/api/v1/users");
+  EXPECT_EQ(NormalizeHTTPPath("/api/v1/users/1234"), "/api/v1/users/*");
+  EXPECT_EQ(NormalizeHTTPPath("/users/1234/orders/5678?page=2#top"), "/users/*/orders/*");
+  EXPECT_EQ(NormalizeHTTPPath("/items/3fa85f64-5717-4562-b3fc-2c963f66afa6"), "/items/*");
+  EXPECT_EQ(NormalizeHTTPPath("/blobs/deadbeef01"), "/blobs/*");
+  EXPECT_EQ(NormalizeHTTPPath("/cafe/deadbeef"), "/cafe/deadbeef");
+}
+
+protocols::http::Record HTTPRecord(std::string method, std::string path, int status,
+                                   uint64_t req_ts, uint64_t resp_ts) {
+  protocols::http::Record record;
+  record.req.req_method = std::move(method);
+  record.req.req_path = std::move(path);
+  record.req.timestamp_ns = req_ts;
+  record.resp.resp_status = status;
+  record.resp.timestamp_ns = resp_ts;
+  return record;
+}
+
+TEST(HTTPREDMetricsTest, Aggregates) {
+  HTTPREDMetrics metrics(/*max_keys*/ 100);
+  struct upid_t upid = {};
+  upid.pid = 123;
+  upid.start_time_ticks = 456;
+
+  metrics.Record(upid, "1.2.3.4", 40001, kRoleServer, HTTPRecord("GET", "/users/1", 200, 10, 30));
+  metrics.Record(upid, "1.2.3.4", 40002, kRoleServer, HTTPRecord("GET", "/users/2", 201, 10, 20));
+  metrics.Record(upid, "1.2.3.4", 40002, kRoleServer, HTTPRecord("GET", "/users/3", 503, 10, 50));
+  metrics.Record(upid, "5.6.7.8", 80, kRoleClient, HTTPRecord("POST", "/login", 200, 10, 15));
+
+  auto count_and_sum = [](const LatencySketch& s) { return std::make_pair(s.count(), s.sum()); };
+  std::vector<std::pair<std::string, std::pair<uint64_t, int64_t>>> got;
+  for (const auto& [key, sketch] : metrics.metrics()) {
+    got.emplace_back(absl::Substitute("$0:$1 $2 $3 $4xx", key.remote_addr, key.remote_port,
+                                      key.req_method, key.req_path, key.resp_status_class),
+                     count_and_sum(sketch));
+  }
+  EXPECT_THAT(got, UnorderedElementsAre(Pair("1.2.3.4:0 GET /users/* 2xx", Pair(2u, 30)),
+                                        Pair("1.2.3.4:0 GET /users/* 5xx", Pair(1u, 40)),
+                                        Pair("5.6.7.8:80 POST /login 2xx", Pair(1u, 5))));
+
+  metrics.Clear();
+  EXPECT_TRUE(metrics.metrics().empty());
+}
+
+TEST(HTTPREDMetricsTest, MaxKeys) {
+  HTTPREDMetrics metrics(/*max_keys*/ 2);
+  struct upid_t upid = {};
+
+  metrics.Record(upid, "1.2.3.4", 80, kRoleClient, HTTPRecord("GET", "/a", 200, 10, 20));
+  metrics.Record(upid, "1.2.3.4", 80, kRoleClient, HTTPRecord("GET", "/b", 200, 10, 20));
+  metrics.Record(upid, "1.2.3.4", 80, kRoleClient, HTTPRecord("GET", "/c", 200, 10, 20));
+  metrics.Record(upid, "1.2.3.4", 80, kRoleClient, HTTPRecord("GET", "/d", 200, 10, 20));
+  metrics.Record(upid, "1.2.3.4", 80, kRoleClient, HTTPRecord("GET", "/a", 200, 10, 20));
+
+  std::vector<std::pair<std::string, uint64_t>> got;
+  for (const auto& [key, sketch] : metrics.metrics()) {
+    got.emplace_back(key.req_path, sketch.count());
+  }
+  EXPECT_THAT(got, UnorderedElementsAre(Pair("/a", 2u), Pair("/b", 1u), Pair("*", 2u)));
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -97,6 +97,7 @@ constexpr DataElement kHTTPElements[] = {
          types::SemanticType::ST_BYTES,
          types::PatternType::METRIC_GAUGE},
         canonical_data_elements::kLatencyNS,
+        canonical_data_elements::kSampleRate,
 #ifndef NDEBUG
         canonical_data_elements::kPXInfo,
 #endif
@@ -35,6 +35,7 @@ using ::testing::ContainsRegex;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
 using ::testing::SizeIs;
+using ::testing::StartsWith;
 using ::testing::StrEq;
 
 class GoHTTPTraceTest : public SocketTraceBPFTest</* TClientSideTracing */ false> {
@@ -146,6 +147,37 @@ TEST_F(GoHTTPTraceTest, LargePostMessage) {
           "AYORsUfUMApsVgzHblmYYtEjVgwfFbbGGcnqbaEREunUZjQXmZOtaRLUtmYgmSVYB... [TRUNCATED]"));
 }
 
+// Tests that capping the capture size of HTTP still yields the record: the headers are parsed in
+// full, and only the prefix of the body within the cap carries the original bytes.
+TEST_F(GoHTTPTraceTest, CappedCaptureSize) {
+  auto* socket_trace_connector = static_cast<SocketTraceConnector*>(source_.get());
+  ASSERT_NE(nullptr, socket_trace_connector);
+  ASSERT_OK(socket_trace_connector->UpdateBPFProtocolCaptureSize(kProtocolHTTP, 512));
+
+  StartTransferDataThread();
+
+  go_http_fixture_.LaunchPostClient();
+
+  StopTransferDataThread();
+
+  std::vector<TaggedRecordBatch> tablets = ConsumeRecords(kHTTPTableNum);
+  ASSERT_FALSE(tablets.empty());
+  types::ColumnWrapperRecordBatch record_batch = tablets[0].records;
+
+  const std::vector<size_t> target_record_indices =
+      testing::FindRecordIdxMatchesPID(record_batch, kHTTPUPIDIdx, go_http_fixture_.server_pid());
+  ASSERT_THAT(target_record_indices, SizeIs(1));
+
+  const size_t target_record_idx = target_record_indices.front();
+
+  EXPECT_THAT(
+      std::string(record_batch[kHTTPReqHeadersIdx]->Get<types::StringValue>(target_record_idx)),
+      HasSubstr(absl::Substitute(R"(Host":"localhost:$0")", go_http_fixture_.server_port())));
+  EXPECT_THAT(
+      std::string(record_batch[kHTTPReqBodyIdx]->Get<types::StringValue>(target_record_idx)),
+      StartsWith(R"({"data":"XVlBzgba)"));
+}
+
 struct TraceRoleTestParam {
   endpoint_role_t role;
   size_t client_records_count;
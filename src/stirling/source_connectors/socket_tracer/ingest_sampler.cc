@@ -0,0 +1,178 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/ingest_sampler.h"
+
+#include <algorithm>
+
+DEFINE_double(stirling_socket_tracer_conn_sample_rate, 1.0,
+              "The fraction of connections whose records are kept. "
+              "The connections that are not sampled are not parsed.");
+DEFINE_uint32(stirling_socket_tracer_protocol_records_per_sec, 0,
+              "The maximum number of records per second, per protocol, that the socket tracer "
+              "writes to its tables. 0 means unlimited.");
+DEFINE_uint32(stirling_socket_tracer_upid_records_per_sec, 0,
+              "The maximum number of records per second, per process, that the socket tracer "
+              "writes to its tables. 0 means unlimited.");
+DEFINE_uint32(stirling_socket_tracer_table_records_per_sec, 0,
+              "The maximum number of records per second, per table, that the socket tracer "
+              "writes. 0 means unlimited.");
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+// A hash of the conn_id that, unlike absl::Hash, is stable across restarts.
+uint64_t StableConnHash(const conn_id_t& conn_id) {
+  uint64_t h = (static_cast<uint64_t>(conn_id.upid.tgid) << 32) ^
+               static_cast<uint32_t>(conn_id.fd) ^ conn_id.upid.start_time_ticks * 31 ^
+               conn_id.tsid * 131;
+  // splitmix64 finalizer.
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+}  // namespace
+
+void TokenBucket::Refill(std::chrono::steady_clock::duration elapsed) {
+  double secs = std::chrono::duration<double>(elapsed).count();
+  tokens_ = std::min(rate_, tokens_ + rate_ * secs);
+}
+
+template <typename TKey>
+void IngestSampler::BucketGroup<TKey>::Refill(std::chrono::steady_clock::duration elapsed) {
+  for (auto iter = buckets.begin(); iter != buckets.end();) {
+    iter->second.Refill(elapsed);
+    // Forget the keys that are idle, a new bucket starts out full anyways.
+    if (iter->second.full() && !offered.contains(iter->first)) {
+      buckets.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+  offered.clear();
+  fractions.clear();
+}
+
+template <typename TKey>
+double IngestSampler::BucketGroup<TKey>::Fraction(const TKey& key) {
+  if (rate == 0) {
+    return 1.0;
+  }
+  auto [iter, inserted] = fractions.try_emplace(key, 1.0);
+  if (inserted) {
+    const auto& bucket = buckets.try_emplace(key, rate).first->second;
+    size_t num_offered = std::max<size_t>(1, offered[key]);
+    iter->second = std::min(1.0, bucket.tokens() / num_offered);
+  }
+  return iter->second;
+}
+
+template <typename TKey>
+void IngestSampler::BucketGroup<TKey>::Take(const TKey& key) {
+  if (rate == 0) {
+    return;
+  }
+  buckets.try_emplace(key, rate).first->second.Take(1);
+}
+
+IngestSampler::Config IngestSampler::ConfigFromFlags() {
+  Config config;
+  config.conn_sample_rate = FLAGS_stirling_socket_tracer_conn_sample_rate;
+  config.protocol_records_per_sec = FLAGS_stirling_socket_tracer_protocol_records_per_sec;
+  config.upid_records_per_sec = FLAGS_stirling_socket_tracer_upid_records_per_sec;
+  config.table_records_per_sec = FLAGS_stirling_socket_tracer_table_records_per_sec;
+  return config;
+}
+
+IngestSampler::IngestSampler(const Config& config)
+    : config_(config),
+      rate_limited_(config.protocol_records_per_sec > 0 || config.upid_records_per_sec > 0 ||
+                    config.table_records_per_sec > 0) {
+  protocol_buckets_.rate = config.protocol_records_per_sec;
+  upid_buckets_.rate = config.upid_records_per_sec;
+  table_buckets_.rate = config.table_records_per_sec;
+}
+
+bool IngestSampler::SampleConn(const conn_id_t& conn_id) const {
+  if (config_.conn_sample_rate >= 1.0) {
+    return true;
+  }
+  if (config_.conn_sample_rate <= 0.0) {
+    return false;
+  }
+  // Use the top 53 bits, to map the hash onto [0, 1) with full double precision.
+  double x = static_cast<double>(StableConnHash(conn_id) >> 11) * 0x1.0p-53;
+  return x < config_.conn_sample_rate;
+}
+
+void IngestSampler::BeginIteration(std::chrono::steady_clock::time_point now) {
+  if (!rate_limited_) {
+    return;
+  }
+  auto elapsed = now - last_refill_time_;
+  last_refill_time_ = now;
+  protocol_buckets_.Refill(elapsed);
+  upid_buckets_.Refill(elapsed);
+  table_buckets_.Refill(elapsed);
+  key_states_.clear();
+}
+
+void IngestSampler::Offer(const RecordKey& key, size_t num_records) {
+  if (!rate_limited_) {
+    return;
+  }
+  protocol_buckets_.offered[key.protocol] += num_records;
+  upid_buckets_.offered[key.upid] += num_records;
+  table_buckets_.offered[key.table_num] += num_records;
+}
+
+double IngestSampler::Admit(const RecordKey& key) {
+  const double conn_sample_rate = std::min(1.0, config_.conn_sample_rate);
+  if (!rate_limited_) {
+    return conn_sample_rate;
+  }
+
+  // Each key gets the smallest fraction that any of its buckets can afford. Since every key of a
+  // bucket gets at most tokens/offered of its records, the bucket's budget is never overrun.
+  auto& state = key_states_[key];
+  if (state.admit_fraction < 0) {
+    state.admit_fraction = std::min({protocol_buckets_.Fraction(key.protocol),
+                                     upid_buckets_.Fraction(key.upid),
+                                     table_buckets_.Fraction(key.table_num)});
+  }
+
+  // Admit records at even intervals: every time the accumulated fraction crosses 1.
+  constexpr double kEpsilon = 1e-9;
+  state.accumulator += state.admit_fraction;
+  if (state.accumulator < 1.0 - kEpsilon) {
+    ++num_dropped_records_;
+    return 0;
+  }
+  state.accumulator -= 1.0;
+
+  protocol_buckets_.Take(key.protocol);
+  upid_buckets_.Take(key.upid);
+  table_buckets_.Take(key.table_num);
+  return conn_sample_rate * state.admit_fraction;
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+
+DECLARE_double(stirling_socket_tracer_conn_sample_rate);
+DECLARE_uint32(stirling_socket_tracer_protocol_records_per_sec);
+DECLARE_uint32(stirling_socket_tracer_upid_records_per_sec);
+DECLARE_uint32(stirling_socket_tracer_table_records_per_sec);
+
+namespace px {
+namespace stirling {
+
+/**
+ * A token bucket that refills at a fixed rate, and holds at most one second worth of tokens.
+ * A rate of 0 means unlimited.
+ */
+class TokenBucket {
+ public:
+  explicit TokenBucket(uint32_t tokens_per_sec = 0)
+      : rate_(tokens_per_sec), tokens_(tokens_per_sec) {}
+
+  bool unlimited() const { return rate_ == 0; }
+  double tokens() const { return tokens_; }
+  bool full() const { return tokens_ >= rate_; }
+
+  void Refill(std::chrono::steady_clock::duration elapsed);
+  void Take(double n) { tokens_ = std::max(0.0, tokens_ - n); }
+
+ private:
+  double rate_;
+  double tokens_;
+};
+
+/**
+ * IngestSampler decides which of the socket tracer's records make it into the data tables, so
+ * that a spiking service cannot overflow them.
+ *
+ * There are two layers:
+ *  - Connection sampling: a deterministic hash of the conn_id keeps a fixed fraction of the
+ *    connections. The other connections should not be parsed at all.
+ *  - Rate limiting: token buckets per protocol, per UPID and per table. Once per iteration, the
+ *    records of every connection are offered, and each key is admitted the fraction of its
+ *    records that fits the budgets of all of its buckets.
+ *
+ * The sample rate of each admitted record is reported, so that aggregates can re-weight records
+ * by 1/sample_rate.
+ */
+class IngestSampler : public NotCopyable {
+ public:
+  struct Config {
+    double conn_sample_rate = 1.0;
+    uint32_t protocol_records_per_sec = 0;
+    uint32_t upid_records_per_sec = 0;
+    uint32_t table_records_per_sec = 0;
+  };
+
+  static Config ConfigFromFlags();
+
+  explicit IngestSampler(const Config& config);
+
+  /**
+   * Returns true if the records of the connection should be kept.
+   * The decision only depends on the conn_id, so it is stable across iterations.
+   */
+  bool SampleConn(const conn_id_t& conn_id) const;
+
+  struct RecordKey {
+    traffic_protocol_t protocol;
+    upid_t upid;
+    uint32_t table_num;
+
+    template <typename H>
+    friend H AbslHashValue(H h, const RecordKey& key) {
+      return H::combine(std::move(h), key.protocol, key.upid, key.table_num);
+    }
+
+    bool operator==(const RecordKey& other) const {
+      return protocol == other.protocol && upid == other.upid && table_num == other.table_num;
+    }
+  };
+
+  /**
+   * Starts a new iteration: refills the buckets, and forgets the previous iteration's offers.
+   */
+  void BeginIteration(std::chrono::steady_clock::time_point now);
+
+  /**
+   * Registers that num_records records with the given key want to be appended in this iteration.
+   * Must be called for all records before the first call to Admit() in the iteration.
+   */
+  void Offer(const RecordKey& key, size_t num_records);
+
+  /**
+   * Decides whether the next record with the given key is appended. Admitted records take a
+   * token from each of the key's buckets. Records are picked at even intervals, so the outcome is
+   * deterministic for a given sequence of offers.
+   *
+   * @return the sample rate of the record if it is admitted, or 0 if it's dropped.
+   */
+  double Admit(const RecordKey& key);
+
+  /**
+   * The number of records dropped by the rate limits since the sampler was created.
+   */
+  int64_t num_dropped_records() const { return num_dropped_records_; }
+
+ private:
+  struct KeyState {
+    double admit_fraction = -1;
+    double accumulator = 0;
+  };
+
+  template <typename TKey>
+  struct BucketGroup {
+    uint32_t rate = 0;
+    absl::flat_hash_map<TKey, TokenBucket> buckets;
+    absl::flat_hash_map<TKey, size_t> offered;
+    // The fraction of the offered records that fits in the bucket. Computed once per iteration,
+    // before any tokens are taken, so that all keys that share the bucket get the same share.
+    absl::flat_hash_map<TKey, double> fractions;
+
+    void Refill(std::chrono::steady_clock::duration elapsed);
+    double Fraction(const TKey& key);
+    void Take(const TKey& key);
+  };
+
+  const Config config_;
+  const bool rate_limited_;
+
+  BucketGroup<traffic_protocol_t> protocol_buckets_;
+  BucketGroup<upid_t> upid_buckets_;
+  BucketGroup<uint32_t> table_buckets_;
+
+  absl::flat_hash_map<RecordKey, KeyState> key_states_;
+
+  std::chrono::steady_clock::time_point last_refill_time_;
+  int64_t num_dropped_records_ = 0;
+};
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/ingest_sampler.h"
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::DoubleEq;
+
+conn_id_t ConnID(uint32_t pid, int32_t fd) {
+  conn_id_t conn_id = {};
+  conn_id.upid.pid = pid;
+  conn_id.upid.start_time_ticks = 1000;
+  conn_id.fd = fd;
+  conn_id.tsid = 1;
+  return conn_id;
+}
+
+TEST(IngestSamplerTest, ConnSampling) {
+  IngestSampler::Config config;
+  config.conn_sample_rate = 0.25;
+  IngestSampler sampler(config);
+
+  constexpr int kNumConns = 10000;
+  int num_sampled = 0;
+  for (int fd = 0; fd < kNumConns; ++fd) {
+    bool sampled = sampler.SampleConn(ConnID(123, fd));
+    // The decision is deterministic.
+    EXPECT_EQ(sampled, sampler.SampleConn(ConnID(123, fd)));
+    num_sampled += sampled;
+  }
+  EXPECT_NEAR(num_sampled, kNumConns * 0.25, kNumConns * 0.02);
+
+  // All records of sampled connections are admitted, and carry the connection sample rate.
+  IngestSampler::RecordKey key = {kProtocolHTTP, ConnID(123, 1).upid, 1};
+  sampler.BeginIteration(std::chrono::steady_clock::now());
+  sampler.Offer(key, 10);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_THAT(sampler.Admit(key), DoubleEq(0.25));
+  }
+  EXPECT_EQ(sampler.num_dropped_records(), 0);
+}
+
+TEST(IngestSamplerTest, RateLimits) {
+  IngestSampler::Config config;
+  config.protocol_records_per_sec = 100;
+  config.upid_records_per_sec = 40;
+  IngestSampler sampler(config);
+
+  IngestSampler::RecordKey key1 = {kProtocolHTTP, ConnID(1, 1).upid, 1};
+  IngestSampler::RecordKey key2 = {kProtocolHTTP, ConnID(2, 1).upid, 1};
+
+  auto now = std::chrono::steady_clock::now();
+  sampler.BeginIteration(now);
+  sampler.Offer(key1, 400);
+  sampler.Offer(key2, 50);
+
+  // key1 is limited by its UPID bucket: 40 of 400. key2 is limited by the protocol bucket, which
+  // can afford 100 of the 450 offered records.
+  int admitted1 = 0;
+  for (int i = 0; i < 400; ++i) {
+    double sample_rate = sampler.Admit(key1);
+    if (sample_rate > 0) {
+      EXPECT_THAT(sample_rate, DoubleEq(0.1));
+      ++admitted1;
+    }
+  }
+  int admitted2 = 0;
+  for (int i = 0; i < 50; ++i) {
+    admitted2 += sampler.Admit(key2) > 0;
+  }
+  EXPECT_EQ(admitted1, 40);
+  EXPECT_EQ(admitted2, 11);
+  EXPECT_EQ(sampler.num_dropped_records(), 450 - 51);
+
+  // The buckets refill over time.
+  sampler.BeginIteration(now + std::chrono::milliseconds(500));
+  sampler.Offer(key2, 10);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_THAT(sampler.Admit(key2), DoubleEq(1.0));
+  }
+}
+
+}  // namespace stirling
+}  // namespace px
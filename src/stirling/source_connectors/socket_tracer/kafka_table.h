@@ -55,6 +55,7 @@ static constexpr DataElement kKafkaElements[] = {
        types::SemanticType::ST_NONE,
        types::PatternType::GENERAL},
        canonical_data_elements::kLatencyNS,
+       canonical_data_elements::kSampleRate,
 #ifndef NDEBUG
        canonical_data_elements::kPXInfo,
 #endif
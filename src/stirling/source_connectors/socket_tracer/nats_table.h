@@ -39,6 +39,7 @@ constexpr DataElement kNATSElements[] = {
          types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::STRUCTURED},
         {"resp", "The response to the command. One of OK & ERR",
          types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+        canonical_data_elements::kSampleRate,
 #ifndef NDEBUG
         canonical_data_elements::kPXInfo,
 #endif
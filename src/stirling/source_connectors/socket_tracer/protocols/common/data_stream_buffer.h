@@ -18,10 +18,13 @@
 
 #pragma once
 
-#include <map>
+#include <memory>
 #include <string>
 
 #include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer_impl.h"
+
+DECLARE_bool(datastream_buffer_use_ring);
 
 namespace px {
 namespace stirling {
@@ -40,12 +43,21 @@ namespace protocols {
  * DataStreamBuffer supports data arriving out-of-order such that they are slotted into the middle
  * of the buffer.
  *
- * The underlying implementation is currently a simple string buffer, but this could be changed
- * in the future, as long as the data is maintained in a contiguous buffer.
+ * The data is always exposed as contiguous views. There are two implementations:
+ * LinearDataStreamBuffer (a string buffer) and RingDataStreamBuffer (a double mapped ring buffer),
+ * selected with --datastream_buffer_use_ring.
  */
 class DataStreamBuffer {
  public:
-  explicit DataStreamBuffer(size_t max_capacity) : capacity_(max_capacity) {}
+  enum class Impl {
+    kLinear,
+    kRing,
+  };
+
+  explicit DataStreamBuffer(size_t max_capacity)
+      : DataStreamBuffer(max_capacity,
+                         FLAGS_datastream_buffer_use_ring ? Impl::kRing : Impl::kLinear) {}
+  DataStreamBuffer(size_t max_capacity, Impl impl);
 
   /**
    * Adds data to the buffer at the specified logical position.
@@ -56,27 +68,29 @@ class DataStreamBuffer {
    * @param data The data to insert.
    * @param timestamp Timestamp to associate with the data.
    */
-  void Add(size_t pos, std::string_view data, uint64_t timestamp);
+  void Add(size_t pos, std::string_view data, uint64_t timestamp) {
+    impl_->Add(pos, data, timestamp);
+  }
 
   /**
    * Get all the contiguous data at the specified position of the buffer.
    * @param pos The logical position of the requested data.
    * @return A string_view to the data.
    */
-  std::string_view Get(size_t pos) const;
+  std::string_view Get(size_t pos) const { return impl_->Get(pos); }
 
   /**
    * Get all the contiguous data at the head of the buffer.
    * @return A string_view to the data.
    */
-  std::string_view Head() const { return Get(position_); }
+  std::string_view Head() const { return Get(position()); }
 
   /**
    * Get timestamp recorded for the data at the specified position.
    * @param pos The logical position of the data.
    * @return The timestamp or error if the position does not contain valid data.
    */
-  StatusOr<uint64_t> GetTimestamp(size_t pos) const;
+  StatusOr<uint64_t> GetTimestamp(size_t pos) const { return impl_->GetTimestamp(pos); }
 
   /**
    * Remove n bytes from the head of the buffer.
@@ -84,67 +98,50 @@ class DataStreamBuffer {
    * Negative values for pos are invalid and will not remove anything.
    * In debug mode, negative values will cause a failure.
    */
-  void RemovePrefix(ssize_t n);
+  void RemovePrefix(ssize_t n) { impl_->RemovePrefix(n); }
 
   /**
    * If the head of the buffer contains any non-valid data (never populated),
    * then remove it until reaching the first data added.
    */
-  void Trim();
+  void Trim() { impl_->Trim(); }
 
   /**
    * Current size of the internal buffer. Not all bytes may be populated.
    */
-  size_t size() const { return buffer_.size(); }
+  size_t size() const { return impl_->size(); }
 
   /**
    * Return true if the buffer is empty.
    */
-  bool empty() const { return buffer_.empty(); }
+  bool empty() const { return impl_->empty(); }
 
   /**
    * Logical position of the head of the buffer.
    */
-  size_t position() const { return position_; }
+  size_t position() const { return impl_->position(); }
+
+  /**
+   * Memory held by the buffer for its data, which may be more than size().
+   * The buffer only allocates as data arrives, so an unused buffer holds no memory.
+   */
+  size_t AllocatedBytes() const { return impl_->AllocatedBytes(); }
+
+  /**
+   * Releases the memory that is not needed for the data currently held, such as after a spike.
+   */
+  void ShrinkToFit() { impl_->ShrinkToFit(); }
 
-  std::string DebugInfo() const;
+  std::string DebugInfo() const { return impl_->DebugInfo(); }
 
   /**
    * Resets the entire buffer to an empty state.
    * Intended for hard recovery conditions.
    */
-  void Reset();
+  void Reset() { impl_->Reset(); }
 
  private:
-  std::map<size_t, size_t>::const_iterator GetChunkForPos(size_t pos) const;
-  void AddNewChunk(size_t pos, size_t size);
-  void AddNewTimestamp(size_t pos, uint64_t timestamp);
-
-  void CleanupTimestamps();
-  void CleanupChunks();
-
-  // Umbrella that calls CleanupTimestamps and CleanupChunks.
-  void CleanupMetadata();
-
-  const size_t capacity_;
-
-  // Logical position of data stream buffer.
-  // In other words, the position of buffer_[0].
-  size_t position_ = 0;
-
-  // Buffer where all data is stored.
-  // TODO(oazizi): Investigate buffer that is better suited to the rolling buffer (slinky) model.
-  std::string buffer_;
-
-  // Map of chunk start positions to chunk sizes.
-  // A chunk is a contiguous sequence of bytes.
-  // Adjacent chunks are always fused, so a chunk either ends at a gap or the end of the buffer.
-  std::map<size_t, size_t> chunks_;
-
-  // Map of positions to timestamps.
-  // Unlike chunks_, which will fuse when adjacent, timestamps never fuse.
-  // Also, we don't track gaps in the buffer with timestamps; must use chunks_ for that.
-  std::map<size_t, uint64_t> timestamps_;
+  std::unique_ptr<DataStreamBufferImpl> impl_;
 };
 
 }  // namespace protocols
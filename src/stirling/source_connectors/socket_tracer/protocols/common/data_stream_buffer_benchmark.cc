@@ -0,0 +1,126 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
+
+using px::stirling::protocols::DataStreamBuffer;
+
+namespace {
+
+constexpr size_t kCapacity = 1024 * 1024;
+
+DataStreamBuffer::Impl ImplArg(const benchmark::State& state) {
+  return state.range(0) == 0 ? DataStreamBuffer::Impl::kLinear : DataStreamBuffer::Impl::kRing;
+}
+
+std::string RandomData(size_t size) {
+  std::mt19937 rng(37);
+  std::string data(size, ' ');
+  for (auto& c : data) {
+    c = 'a' + rng() % 26;
+  }
+  return data;
+}
+
+}  // namespace
+
+// Events arrive in order, and the parser consumes small frames from the head of a backlog of
+// state.range(1) bytes, looking up the timestamp of each, like a busy connection does.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_consume_frames(benchmark::State& state) {
+  constexpr size_t kEventSize = 16 * 1024;
+  constexpr size_t kFrameSize = 512;
+  const size_t backlog = state.range(1);
+  const std::string event = RandomData(kEventSize);
+
+  DataStreamBuffer buffer(kCapacity, ImplArg(state));
+  size_t pos = 0;
+  uint64_t ts = 0;
+  while (buffer.size() < backlog) {
+    buffer.Add(pos, event, ++ts);
+    pos += event.size();
+  }
+
+  for (auto _ : state) {
+    buffer.Add(pos, event, ++ts);
+    pos += event.size();
+    for (size_t consumed = 0; consumed < kEventSize; consumed += kFrameSize) {
+      benchmark::DoNotOptimize(buffer.Head());
+      benchmark::DoNotOptimize(buffer.GetTimestamp(buffer.position() + kFrameSize - 1));
+      buffer.RemovePrefix(kFrameSize);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kEventSize);
+}
+
+// Events arrive with the gaps and reordering seen when the perf buffer drops or reorders events:
+// some events are lost, and some arrive before the one that precedes them.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_gaps_and_reordering(benchmark::State& state) {
+  const std::string data = RandomData(64 * 1024);
+  std::mt19937 rng(37);
+
+  DataStreamBuffer buffer(kCapacity, ImplArg(state));
+  size_t pos = 0;
+  uint64_t ts = 0;
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    size_t size = 64 + rng() % 8192;
+    std::string_view event(data.data() + rng() % (data.size() - size), size);
+    std::string_view next = event.substr(0, 64);
+    if (rng() % 16 == 0) {
+      // Lost event.
+      pos += size;
+      continue;
+    }
+    bool reorder = rng() % 8 == 0;
+    if (reorder) {
+      buffer.Add(pos + size, next, ts + 1);
+    }
+    buffer.Add(pos, event, ++ts);
+    pos += size;
+    if (reorder) {
+      pos += next.size();
+      ++ts;
+    }
+    bytes += size;
+
+    // Consume everything that is contiguous, then skip over any gap.
+    while (!buffer.Head().empty()) {
+      size_t frame_size = std::min<size_t>(buffer.Head().size(), 128 + rng() % 1024);
+      benchmark::DoNotOptimize(buffer.GetTimestamp(buffer.position()));
+      buffer.RemovePrefix(frame_size);
+    }
+    buffer.Trim();
+  }
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK(BM_consume_frames)
+    ->ArgNames({"ring", "backlog"})
+    ->Args({0, 64 << 10})
+    ->Args({1, 64 << 10})
+    ->Args({0, 768 << 10})
+    ->Args({1, 768 << 10});
+BENCHMARK(BM_gaps_and_reordering)->ArgName("ring")->Args({0})->Args({1});
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+/**
+ * The storage behind a DataStreamBuffer.
+ * See DataStreamBuffer for the semantics of each function.
+ */
+class DataStreamBufferImpl {
+ public:
+  virtual ~DataStreamBufferImpl() = default;
+
+  virtual void Add(size_t pos, std::string_view data, uint64_t timestamp) = 0;
+  virtual std::string_view Get(size_t pos) const = 0;
+  virtual StatusOr<uint64_t> GetTimestamp(size_t pos) const = 0;
+  virtual void RemovePrefix(ssize_t n) = 0;
+  virtual void Trim() = 0;
+  virtual size_t size() const = 0;
+  virtual bool empty() const = 0;
+  virtual size_t position() const = 0;
+  virtual size_t AllocatedBytes() const = 0;
+  virtual void ShrinkToFit() = 0;
+  virtual std::string DebugInfo() const = 0;
+  virtual void Reset() = 0;
+};
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -18,14 +18,20 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer.h"
 
+#include <algorithm>
+#include <random>
+#include <string>
+
 #include "src/common/testing/testing.h"
 
 namespace px {
 namespace stirling {
 namespace protocols {
 
-TEST(DataStreamTest, AddAndGet) {
-  DataStreamBuffer stream_buffer(15);
+class DataStreamBufferTest : public ::testing::TestWithParam<DataStreamBuffer::Impl> {};
+
+TEST_P(DataStreamBufferTest, AddAndGet) {
+  DataStreamBuffer stream_buffer(15, GetParam());
 
   // Initially everything should be empty.
   EXPECT_EQ(stream_buffer.Get(0), "");
@@ -121,8 +127,8 @@ TEST(DataStreamTest, AddAndGet) {
   EXPECT_EQ(stream_buffer.Get(131), "LMNOPQRSTUVWXYZ");
 }
 
-TEST(DataStreamTest, RemovePrefixAndTrim) {
-  DataStreamBuffer stream_buffer(15);
+TEST_P(DataStreamBufferTest, RemovePrefixAndTrim) {
+  DataStreamBuffer stream_buffer(15, GetParam());
 
   // Add some events with a gap.
   stream_buffer.Add(0, "0123", 0);
@@ -175,8 +181,8 @@ TEST(DataStreamTest, RemovePrefixAndTrim) {
   EXPECT_EQ(stream_buffer.Head(), "abcd");
 }
 
-TEST(DataStreamTest, Timestamp) {
-  DataStreamBuffer stream_buffer(15);
+TEST_P(DataStreamBufferTest, Timestamp) {
+  DataStreamBuffer stream_buffer(15, GetParam());
 
   EXPECT_NOT_OK(stream_buffer.GetTimestamp(0));
   EXPECT_NOT_OK(stream_buffer.GetTimestamp(20));
@@ -193,8 +199,8 @@ TEST(DataStreamTest, Timestamp) {
   EXPECT_NOT_OK(stream_buffer.GetTimestamp(8));
 }
 
-TEST(DataStreamTest, TimestampWithGap) {
-  DataStreamBuffer stream_buffer(15);
+TEST_P(DataStreamBufferTest, TimestampWithGap) {
+  DataStreamBuffer stream_buffer(15, GetParam());
 
   stream_buffer.Add(0, "0123", 0);
   stream_buffer.Add(10, "abcd", 10);
@@ -225,8 +231,8 @@ TEST(DataStreamTest, TimestampWithGap) {
   EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(13), 10);
 }
 
-TEST(DataStreamTest, SizeAndGetPos) {
-  DataStreamBuffer stream_buffer(15);
+TEST_P(DataStreamBufferTest, SizeAndGetPos) {
+  DataStreamBuffer stream_buffer(15, GetParam());
 
   // Start off empty.
   EXPECT_EQ(stream_buffer.position(), 0);
@@ -291,6 +297,94 @@ TEST(DataStreamTest, SizeAndGetPos) {
   EXPECT_FALSE(stream_buffer.empty());
 }
 
+// An event that starts before the head and ends past the tail is cut-off and extends the buffer.
+TEST_P(DataStreamBufferTest, StraddlingEventExtendsBuffer) {
+  DataStreamBuffer stream_buffer(15, GetParam());
+
+  stream_buffer.Add(0, "0123", 0);
+  stream_buffer.RemovePrefix(4);
+  EXPECT_TRUE(stream_buffer.empty());
+
+  stream_buffer.Add(2, "234567", 2);
+  EXPECT_EQ(stream_buffer.position(), 4);
+  EXPECT_EQ(stream_buffer.size(), 4);
+  EXPECT_EQ(stream_buffer.Head(), "4567");
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(7), 2);
+}
+
+// The memory taken by a spike is released once the data is consumed.
+TEST_P(DataStreamBufferTest, ShrinkToFit) {
+  DataStreamBuffer stream_buffer(1 << 20, GetParam());
+  EXPECT_EQ(stream_buffer.AllocatedBytes(), 0);
+
+  stream_buffer.Add(0, std::string(100000, 'x'), 0);
+  EXPECT_GE(stream_buffer.AllocatedBytes(), 100000);
+
+  stream_buffer.RemovePrefix(99990);
+  stream_buffer.ShrinkToFit();
+  EXPECT_LT(stream_buffer.AllocatedBytes(), 100000);
+  EXPECT_EQ(stream_buffer.Head(), "xxxxxxxxxx");
+  EXPECT_OK_AND_EQ(stream_buffer.GetTimestamp(99999), 0);
+
+  stream_buffer.Add(100000, "0123", 1);
+  EXPECT_EQ(stream_buffer.Head(), "xxxxxxxxxx0123");
+
+  stream_buffer.Reset();
+  EXPECT_EQ(stream_buffer.AllocatedBytes(), 0);
+}
+
+// Streams events with gaps and out-of-order arrivals through both implementations, far enough
+// for the ring to wrap around many times, and checks that they always agree.
+TEST(DataStreamBufferImplTest, RingMatchesLinear) {
+  constexpr size_t kCapacity = 10000;
+  DataStreamBuffer linear(kCapacity, DataStreamBuffer::Impl::kLinear);
+  DataStreamBuffer ring(kCapacity, DataStreamBuffer::Impl::kRing);
+
+  std::mt19937 rng(37);
+  std::string data(4096, ' ');
+  for (auto& c : data) {
+    c = 'a' + rng() % 26;
+  }
+
+  size_t pos = 0;
+  for (int i = 0; i < 2000; ++i) {
+    size_t size = 1 + rng() % 1500;
+    size_t offset = rng() % (data.size() - size);
+    std::string_view event(data.data() + offset, size);
+    // Occasionally leave a gap, or deliver the next event before this one.
+    if (rng() % 8 == 0) {
+      pos += rng() % 200;
+    }
+    if (rng() % 8 == 0) {
+      std::string_view next(data.data() + offset / 2, 100);
+      linear.Add(pos + size, next, i + 1);
+      ring.Add(pos + size, next, i + 1);
+    }
+    linear.Add(pos, event, i);
+    ring.Add(pos, event, i);
+    pos += size;
+
+    ASSERT_EQ(ring.position(), linear.position());
+    ASSERT_EQ(ring.size(), linear.size());
+    ASSERT_EQ(ring.Head(), linear.Head());
+    ASSERT_EQ(ring.Get(pos - 1), linear.Get(pos - 1));
+    ASSERT_EQ(ring.GetTimestamp(pos - 1).ok(), linear.GetTimestamp(pos - 1).ok());
+
+    size_t consume = std::min(linear.Head().size(), static_cast<size_t>(rng() % 2000));
+    linear.RemovePrefix(consume);
+    ring.RemovePrefix(consume);
+    if (linear.Head().empty()) {
+      linear.Trim();
+      ring.Trim();
+    }
+    ASSERT_EQ(ring.Head(), linear.Head());
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Impls, DataStreamBufferTest,
+                         ::testing::Values(DataStreamBuffer::Impl::kLinear,
+                                           DataStreamBuffer::Impl::kRing));
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
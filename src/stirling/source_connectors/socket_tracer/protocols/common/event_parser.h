@@ -166,7 +166,9 @@ ParseResult ParseFramesLoop(message_type_t type, std::string_view buf,
   int invalid_count = 0;
 
   while (!buf.empty() && s != ParseState::kEOS) {
-    TFrameType frame;
+    // Parse straight into the back of the container, rather than into a temporary that then has
+    // to be moved in and destroyed. Frames that are not recorded are popped off again below.
+    TFrameType& frame = frames->emplace_back();
 
     s = ParseFrame(type, &buf, &frame, state);
 
@@ -207,6 +209,10 @@ ParseResult ParseFramesLoop(message_type_t type, std::string_view buf,
         DCHECK(false);
     }
 
+    if (!push) {
+      frames->pop_back();
+    }
+
     if (stop) {
       break;
     }
@@ -217,7 +223,6 @@ ParseResult ParseFramesLoop(message_type_t type, std::string_view buf,
 
     if (push) {
       frame_positions.push_back({start_position, end_position});
-      frames->push_back(std::move(frame));
     }
   }
   return ParseResult{std::move(frame_positions), bytes_processed, s, invalid_count};
@@ -99,6 +99,27 @@ TEST_F(EventParserTest, BasicProtocolParsing) {
   EXPECT_THAT(timestamps, ElementsAre(0, 1, 1, 2, 3, 4));
 }
 
+// Frames that are not complete yet must not be left behind in the frames container.
+TEST_F(EventParserTest, IncompleteFrameNotRecorded) {
+  std::deque<TestFrame> word_frames;
+
+  std::vector<std::string> event_messages = {"jupiter,saturn,nept"};
+  std::vector<SocketDataEvent> events = CreateEvents(event_messages);
+
+  AddEvents(events);
+  ParseResult res = ParseFrames(message_type_t::kRequest, data_buffer_, &word_frames);
+
+  EXPECT_EQ(ParseState::kNeedsMoreData, res.state);
+  EXPECT_THAT(res.frame_positions, ElementsAre(StartEndPos{0, 7}, StartEndPos{8, 14}));
+  EXPECT_EQ(res.end_position, 15);
+
+  std::vector<std::string> msgs;
+  for (const auto& frame : word_frames) {
+    msgs.push_back(frame.msg);
+  }
+  EXPECT_THAT(msgs, ElementsAre("jupiter", "saturn"));
+}
+
 // TODO(oazizi): Move any protocol specific tests that check for general EventParser behavior here.
 // Should help reduce duplication of tests.
 
@@ -75,7 +75,8 @@ struct NoState {
   std::monostate recv;
 };
 
-// NOTE: FindFrameBoundary(), ParseFrame(), and StitchFrames() must be implemented per protocol.
+// NOTE: FindFrameBoundary(), ParseFrame(), PartialFrameSize(), and StitchFrames() must be
+// implemented per protocol.
 
 /**
  * Attempt to find the next frame boundary.
@@ -106,6 +107,20 @@ template <typename TFrameType, typename TStateType = NoState>
 ParseState ParseFrame(message_type_t type, std::string_view* buf, TFrameType* frame,
                       TStateType* state = nullptr);
 
+/**
+ * Reads the size of the frame at the head of a buffer that holds only part of it, so that the
+ * frame isn't parsed again until all of it has arrived. Protocols without a length in their frame
+ * header return 0.
+ *
+ * @tparam TFrameType Type of frame at the head of the buffer.
+ * @param type Whether the frame is a request or response.
+ * @param buf The raw data that ParseFrame() needed more data for.
+ *
+ * @return The total size of the frame in bytes, or 0 if it is unknown.
+ */
+template <typename TFrameType>
+size_t PartialFrameSize(message_type_t type, std::string_view buf);
+
 /**
  * StitchFrames is the entry point of stitcher for all protocols. It loops through the responses,
  * matches them with the corresponding requests, and returns stitched request & response pairs.
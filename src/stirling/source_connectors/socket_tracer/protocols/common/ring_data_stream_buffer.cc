@@ -0,0 +1,420 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/ring_data_stream_buffer.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+namespace {
+
+// A drained ring larger than this is unmapped, so that it doesn't keep the memory of a spike.
+constexpr size_t kMaxDrainedRingSize = 1 << 20;
+
+size_t PageSize() {
+  static const size_t kPageSize = sysconf(_SC_PAGESIZE);
+  return kPageSize;
+}
+
+// Maps ring_size bytes of memory twice, back to back, so that the ring_size bytes starting at any
+// offset inside the first mapping are contiguous. Returns nullptr on failure.
+char* MapRing(size_t ring_size) {
+  int fd = memfd_create("data_stream_buffer", MFD_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  DEFER(close(fd));
+  if (ftruncate(fd, ring_size) != 0) {
+    return nullptr;
+  }
+
+  // Reserve the address range first, then map the memory file over both halves of it.
+  void* addr = mmap(nullptr, 2 * ring_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  char* ring = static_cast<char*>(addr);
+  for (char* half : {ring, ring + ring_size}) {
+    if (mmap(half, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) ==
+        MAP_FAILED) {
+      munmap(ring, 2 * ring_size);
+      return nullptr;
+    }
+  }
+  return ring;
+}
+
+// Get the entry with the largest position <= pos in a vector sorted by position.
+template <typename TEntry>
+typename std::vector<TEntry>::const_iterator FindLE(const std::vector<TEntry>& entries,
+                                                    size_t pos) {
+  auto iter = std::upper_bound(entries.begin(), entries.end(), pos,
+                               [](size_t pos, const TEntry& entry) { return pos < entry.pos; });
+  if (iter == entries.begin()) {
+    return entries.cend();
+  }
+  return --iter;
+}
+
+}  // namespace
+
+RingDataStreamBuffer::~RingDataStreamBuffer() { ReleaseRing(); }
+
+void RingDataStreamBuffer::Reset() {
+  ReleaseRing();
+  chunks_.clear();
+  timestamps_.clear();
+  size_ = 0;
+  position_ = 0;
+}
+
+void RingDataStreamBuffer::ReleaseRing() {
+  if (ring_ != nullptr) {
+    munmap(ring_, 2 * ring_size_);
+  }
+  ring_ = nullptr;
+  ring_size_ = 0;
+  head_ = 0;
+}
+
+bool RingDataStreamBuffer::Reserve(size_t size) {
+  if (size <= ring_size_) {
+    return true;
+  }
+
+  size_t new_ring_size = std::max(PageSize(), ring_size_);
+  while (new_ring_size < size) {
+    new_ring_size <<= 1;
+  }
+  return Remap(new_ring_size);
+}
+
+bool RingDataStreamBuffer::Remap(size_t new_ring_size) {
+  char* new_ring = MapRing(new_ring_size);
+  if (new_ring == nullptr) {
+    return false;
+  }
+  if (size_ > 0) {
+    memcpy(new_ring, Data(0), size_);
+  }
+  ReleaseRing();
+  ring_ = new_ring;
+  ring_size_ = new_ring_size;
+  return true;
+}
+
+void RingDataStreamBuffer::ShrinkToFit() {
+  if (size_ == 0) {
+    ReleaseRing();
+    return;
+  }
+  size_t new_ring_size = PageSize();
+  while (new_ring_size < size_) {
+    new_ring_size <<= 1;
+  }
+  if (ring_ != nullptr && new_ring_size < ring_size_) {
+    Remap(new_ring_size);
+  }
+}
+
+void RingDataStreamBuffer::AddNewChunk(size_t pos, size_t size) {
+  // Look for the chunks to the left and right of this new chunk.
+  auto r_iter = std::lower_bound(chunks_.begin(), chunks_.end(), pos,
+                                 [](const Chunk& chunk, size_t pos) { return chunk.pos < pos; });
+  auto l_iter = r_iter == chunks_.begin() ? chunks_.end() : std::prev(r_iter);
+
+  // Does this chunk fuse with the chunk on the left of it?
+  bool left_fuse = l_iter != chunks_.end() && l_iter->pos + l_iter->size == pos;
+
+  // Does this chunk fuse with the chunk on the right of it?
+  bool right_fuse = r_iter != chunks_.end() && pos + size == r_iter->pos;
+
+  if (left_fuse && right_fuse) {
+    // The new chunk bridges two previously separate chunks together.
+    // Keep the left one and increase its size to cover all three chunks.
+    l_iter->size += (size + r_iter->size);
+    chunks_.erase(r_iter);
+  } else if (left_fuse) {
+    // Merge new chunk directly to the one on its left.
+    l_iter->size += size;
+  } else if (right_fuse) {
+    // Merge new chunk into the one on its right. This doesn't change the order.
+    r_iter->pos = pos;
+    r_iter->size += size;
+  } else if (r_iter != chunks_.end() && r_iter->pos == pos) {
+    // Overlaps a chunk at the same position; replace it, like the linear buffer does.
+    r_iter->size = size;
+  } else {
+    // No fusing, so just add the new chunk.
+    chunks_.insert(r_iter, Chunk{pos, size});
+  }
+}
+
+void RingDataStreamBuffer::AddNewTimestamp(size_t pos, uint64_t timestamp) {
+  auto iter = std::lower_bound(timestamps_.begin(), timestamps_.end(), pos,
+                               [](const Timestamp& ts, size_t pos) { return ts.pos < pos; });
+  if (iter != timestamps_.end() && iter->pos == pos) {
+    iter->timestamp = timestamp;
+  } else {
+    timestamps_.insert(iter, Timestamp{pos, timestamp});
+  }
+}
+
+void RingDataStreamBuffer::Add(size_t pos, std::string_view data, uint64_t timestamp) {
+  if (data.size() > capacity_) {
+    size_t oversize_amount = data.size() - capacity_;
+    data.remove_prefix(oversize_amount);
+    pos += oversize_amount;
+  }
+
+  // Calculate physical positions (ppos) where the data would live, relative to the head.
+  ssize_t ppos_front = pos - position_;
+  ssize_t ppos_back = pos + data.size() - position_;
+
+  if (ppos_back < 0) {
+    // Case 1: Data being added is too far back. Just ignore it.
+    VLOG(1) << absl::Substitute(
+        "Ignoring event that has already been skipped [event pos=$0, current pos=$1].", pos,
+        position_);
+    return;
+  }
+
+  if (ppos_front < 0) {
+    // Case 2: Data being added is straddling the front-side of the buffer. Cut-off the prefix.
+    VLOG(1) << absl::Substitute(
+        "Event is partially too far in the past [event pos=$0, current pos=$1].", pos, position_);
+
+    ssize_t prefix = 0 - ppos_front;
+    data.remove_prefix(prefix);
+    pos += prefix;
+    ppos_front = 0;
+  }
+
+  if (ppos_back > static_cast<ssize_t>(size_)) {
+    // Case 3: Data being added extends the buffer.
+    // This can also apply to data that was cut-off by case 2.
+
+    if (pos > position_ + capacity_) {
+      VLOG(1) << absl::Substitute("Event skips ahead *a lot* [event pos=$0, current pos=$1].", pos,
+                                  position_);
+    }
+
+    ssize_t logical_size = pos + data.size() - position_;
+    if (logical_size > static_cast<ssize_t>(capacity_)) {
+      // The movement of the buffer position will cause some bytes to "fall off",
+      // remove those now.
+      size_t remove_count = logical_size - capacity_;
+
+      VLOG(1) << absl::Substitute("Event bytes to be dropped [count=$0].", remove_count);
+
+      RemovePrefix(remove_count);
+      ppos_front -= remove_count;
+      ppos_back -= remove_count;
+    }
+
+    DCHECK_GE(ppos_front, 0);
+    DCHECK_LE(ppos_front, capacity_);
+
+    DCHECK_GE(ppos_back, 0);
+    DCHECK_LE(ppos_back, capacity_);
+
+    if (!Reserve(ppos_back)) {
+      LOG_FIRST_N(ERROR, 10) << absl::Substitute(
+          "Could not map a data stream ring buffer, dropping event [event pos=$0 size=$1].", pos,
+          data.size());
+      return;
+    }
+
+    // The bytes of the extension that aren't covered by a chunk are never exposed,
+    // so they don't have to be cleared.
+    size_ = ppos_back;
+  } else {
+    // Case 4: Data being added is completely within the buffer. Write it directly.
+
+    // No adjustments required.
+  }
+
+  // Now copy the data into the ring. It never wraps, thanks to the second mapping.
+  if (!data.empty()) {
+    memcpy(Data(ppos_front), data.data(), data.size());
+  }
+
+  // Update the metadata.
+  AddNewChunk(pos, data.size());
+  AddNewTimestamp(pos, timestamp);
+}
+
+const RingDataStreamBuffer::Chunk* RingDataStreamBuffer::GetChunkForPos(size_t pos) const {
+  if (chunks_.empty()) {
+    return nullptr;
+  }
+
+  // Most lookups are at the head of the buffer, which is in the first chunk.
+  const Chunk* chunk = &chunks_.front();
+  if (chunks_.size() > 1 && pos >= chunks_[1].pos) {
+    chunk = &*FindLE(chunks_, pos);
+  }
+
+  // Does the chunk include pos?
+  if (pos < chunk->pos || pos - chunk->pos >= chunk->size) {
+    return nullptr;
+  }
+
+  return chunk;
+}
+
+std::string_view RingDataStreamBuffer::Get(size_t pos) const {
+  const Chunk* chunk = GetChunkForPos(pos);
+  if (chunk == nullptr) {
+    return {};
+  }
+
+  size_t bytes_available = chunk->size - (pos - chunk->pos);
+  DCHECK_GT(bytes_available, 0U);
+
+  DCHECK_GE(pos, position_);
+  size_t ppos = pos - position_;
+  DCHECK_LT(ppos, size_);
+  return std::string_view(Data(ppos), bytes_available);
+}
+
+StatusOr<uint64_t> RingDataStreamBuffer::GetTimestamp(size_t pos) const {
+  // Ensure the specified time corresponds to a real chunk.
+  if (GetChunkForPos(pos) == nullptr) {
+    return error::Internal("Specified position not found");
+  }
+
+  // Get timestamp which is <= pos.
+  auto iter = FindLE(timestamps_, pos);
+  if (iter == timestamps_.cend()) {
+    LOG(DFATAL) << absl::Substitute(
+        "Specified position should have been found, since we verified we are not in a chunk gap "
+        "[position=$0]\n$1.",
+        pos, DebugInfo());
+    return error::Internal("Specified position not found.");
+  }
+
+  return iter->timestamp;
+}
+
+void RingDataStreamBuffer::CleanupMetadata() {
+  CleanupChunks();
+  CleanupTimestamps();
+}
+
+void RingDataStreamBuffer::CleanupChunks() {
+  // Get chunk which is <= position_.
+  auto iter = FindLE(chunks_, position_);
+  if (iter == chunks_.cend()) {
+    return;
+  }
+
+  DCHECK_GE(position_, iter->pos);
+  ssize_t available = iter->size - (position_ - iter->pos);
+
+  if (available <= 0) {
+    // position_ was in a gap area between two chunks, so go back to the next chunk.
+    chunks_.erase(chunks_.cbegin(), iter + 1);
+  } else {
+    // Remove all chunks entirely before position_, and adjust the first chunk.
+    chunks_.erase(chunks_.cbegin(), iter);
+    chunks_.front() = Chunk{position_, static_cast<size_t>(available)};
+  }
+}
+
+void RingDataStreamBuffer::CleanupTimestamps() {
+  // Get timestamp which is <= position_.
+  auto iter = FindLE(timestamps_, position_);
+  if (iter == timestamps_.cend()) {
+    return;
+  }
+
+  // We are now at the timestamp that covers position_,
+  // anything before this is expired and can be removed.
+  timestamps_.erase(timestamps_.cbegin(), iter);
+}
+
+void RingDataStreamBuffer::RemovePrefix(ssize_t n) {
+  // Check for positive values of n.
+  // For safety in production code, just return.
+  DCHECK_GE(n, 0);
+  if (n < 0) {
+    return;
+  }
+
+  size_t removed = std::min(static_cast<size_t>(n), size_);
+  if (ring_ != nullptr) {
+    head_ = (head_ + removed) & (ring_size_ - 1);
+  }
+  size_ -= removed;
+  position_ += n;
+
+  CleanupMetadata();
+
+  if (size_ == 0 && ring_size_ > kMaxDrainedRingSize) {
+    ReleaseRing();
+  }
+}
+
+void RingDataStreamBuffer::Trim() {
+  if (chunks_.empty()) {
+    return;
+  }
+
+  size_t chunk_pos = chunks_.front().pos;
+  DCHECK_GE(chunk_pos, position_);
+  size_t trim_size = chunk_pos - position_;
+
+  head_ = (head_ + trim_size) & (ring_size_ - 1);
+  size_ -= trim_size;
+  position_ += trim_size;
+}
+
+std::string RingDataStreamBuffer::DebugInfo() const {
+  std::string s;
+
+  absl::StrAppend(&s, absl::Substitute("Position: $0\n", position_));
+  absl::StrAppend(&s, absl::Substitute("BufferSize: $0/$1\n", size_, capacity_));
+  absl::StrAppend(&s, absl::Substitute("RingSize: $0\n", ring_size_));
+  absl::StrAppend(&s, "Chunks:\n");
+  for (const auto& chunk : chunks_) {
+    absl::StrAppend(&s, absl::Substitute("  position:$0 size:$1\n", chunk.pos, chunk.size));
+  }
+  absl::StrAppend(&s, "Timestamps:\n");
+  for (const auto& ts : timestamps_) {
+    absl::StrAppend(&s, absl::Substitute("  position:$0 timestamp:$1\n", ts.pos, ts.timestamp));
+  }
+  std::string_view buffer = size_ == 0 ? std::string_view() : std::string_view(Data(0), size_);
+  absl::StrAppend(&s, absl::Substitute("Buffer: $0\n", buffer));
+
+  return s;
+}
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/common/data_stream_buffer_impl.h"
+
+namespace px {
+namespace stirling {
+namespace protocols {
+
+/**
+ * RingDataStreamBuffer keeps the data in a power-of-two sized ring, which is mapped twice into
+ * consecutive virtual memory. Any range of up to the ring size that starts inside the ring can
+ * then be read as one contiguous view, so RemovePrefix() only moves the head of the ring instead
+ * of shifting the data.
+ *
+ * The ring is mapped lazily and grows to fit the buffered data, up to the capacity. It is
+ * unmapped on Reset(), and when a large ring is fully drained, so that a spike doesn't stay
+ * resident for the lifetime of the stream.
+ *
+ * Chunks and timestamps are kept in sorted vectors. They almost always hold a handful of entries
+ * and are appended at the back and consumed from the front.
+ */
+class RingDataStreamBuffer : public DataStreamBufferImpl {
+ public:
+  explicit RingDataStreamBuffer(size_t max_capacity) : capacity_(max_capacity) {}
+  ~RingDataStreamBuffer() override;
+
+  RingDataStreamBuffer(const RingDataStreamBuffer&) = delete;
+  RingDataStreamBuffer& operator=(const RingDataStreamBuffer&) = delete;
+
+  void Add(size_t pos, std::string_view data, uint64_t timestamp) override;
+  std::string_view Get(size_t pos) const override;
+  StatusOr<uint64_t> GetTimestamp(size_t pos) const override;
+  void RemovePrefix(ssize_t n) override;
+  void Trim() override;
+  size_t size() const override { return size_; }
+  bool empty() const override { return size_ == 0; }
+  size_t position() const override { return position_; }
+  size_t AllocatedBytes() const override { return ring_size_; }
+  void ShrinkToFit() override;
+  std::string DebugInfo() const override;
+  void Reset() override;
+
+ private:
+  struct Chunk {
+    size_t pos;
+    size_t size;
+  };
+
+  struct Timestamp {
+    size_t pos;
+    uint64_t timestamp;
+  };
+
+  // Returns the chunk that contains pos, or nullptr if pos is in a gap.
+  const Chunk* GetChunkForPos(size_t pos) const;
+  void AddNewChunk(size_t pos, size_t size);
+  void AddNewTimestamp(size_t pos, uint64_t timestamp);
+
+  void CleanupTimestamps();
+  void CleanupChunks();
+
+  // Umbrella that calls CleanupTimestamps and CleanupChunks.
+  void CleanupMetadata();
+
+  // Grows the ring so that it holds at least size bytes. Returns false if the ring couldn't be
+  // mapped.
+  bool Reserve(size_t size);
+  // Moves the data into a new ring of new_ring_size bytes. Returns false if the ring couldn't be
+  // mapped, in which case the current ring is kept.
+  bool Remap(size_t new_ring_size);
+  void ReleaseRing();
+
+  // Address of the byte at physical position ppos, ie. at logical position position_ + ppos.
+  char* Data(size_t ppos) const { return ring_ + ((head_ + ppos) & (ring_size_ - 1)); }
+
+  const size_t capacity_;
+
+  // Logical position of data stream buffer.
+  // In other words, the position of the byte at head_.
+  size_t position_ = 0;
+
+  // Number of bytes in the buffer, including gaps.
+  size_t size_ = 0;
+
+  // The ring, mapped twice back to back. Its size is a power of two.
+  char* ring_ = nullptr;
+  size_t ring_size_ = 0;
+
+  // Offset of position_ in the ring.
+  size_t head_ = 0;
+
+  // Chunk start positions and sizes, sorted by position.
+  // A chunk is a contiguous sequence of bytes.
+  // Adjacent chunks are always fused, so a chunk either ends at a gap or the end of the buffer.
+  std::vector<Chunk> chunks_;
+
+  // Positions and timestamps, sorted by position.
+  // Unlike chunks_, which will fuse when adjacent, timestamps never fuse.
+  // Also, we don't track gaps in the buffer with timestamps; must use chunks_ for that.
+  std::vector<Timestamp> timestamps_;
+};
+
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
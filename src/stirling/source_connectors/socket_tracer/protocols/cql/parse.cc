@@ -96,6 +96,18 @@ size_t FindFrameBoundary<cass::Frame>(message_type_t /*type*/, std::string_view
   return std::string::npos;
 }
 
+template <>
+size_t PartialFrameSize<cass::Frame>(message_type_t /*type*/, std::string_view buf) {
+  if (buf.size() < cass::kFrameHeaderLength) {
+    return 0;
+  }
+  int32_t length = ntohl(utils::LEndianBytesToInt<int32_t>(buf.substr(5, 4)));
+  if (length < 0 || length > cass::kMaxFrameLength) {
+    return 0;
+  }
+  return cass::kFrameHeaderLength + length;
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
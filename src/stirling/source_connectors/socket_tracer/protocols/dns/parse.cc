@@ -99,6 +99,12 @@ size_t FindFrameBoundary<dns::Frame>(message_type_t /*type*/, std::string_view /
   return std::string::npos;
 }
 
+template <>
+size_t PartialFrameSize<dns::Frame>(message_type_t /*type*/, std::string_view /*buf*/) {
+  // DNS frames are whole UDP packets, so they are never partial.
+  return 0;
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
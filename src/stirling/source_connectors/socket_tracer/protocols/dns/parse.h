@@ -40,6 +40,9 @@ template <>
 size_t FindFrameBoundary<dns::Frame>(message_type_t type, std::string_view buf, size_t start_pos,
                                      NoState* state);
 
+template <>
+size_t PartialFrameSize<dns::Frame>(message_type_t type, std::string_view buf);
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
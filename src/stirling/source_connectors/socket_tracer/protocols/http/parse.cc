@@ -20,10 +20,17 @@
 
 #include <picohttpparser.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include <utility>
 
+#include <absl/strings/ascii.h>
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -41,6 +48,34 @@ HeadersMap GetHTTPHeadersMap(const phr_header* headers, size_t num_headers) {
   return result;
 }
 
+constexpr std::string_view kBoundaryMarker = "\r\n\r\n";
+
+// Returns the position of the first "\r\n\r\n" at or after pos, or std::string::npos.
+// With SSE2, 16 candidate positions are checked at once: each byte of the marker is compared
+// against its own shifted load, and a lane where all four compares match is a hit.
+size_t FindBoundaryMarker(std::string_view buf, size_t pos) {
+#if defined(__SSE2__)
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const char* data = buf.data();
+  constexpr size_t kLanes = sizeof(__m128i);
+  for (; pos + kLanes + kBoundaryMarker.size() - 1 <= buf.size(); pos += kLanes) {
+    __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 1));
+    __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 2));
+    __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 3));
+    __m128i match = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, cr), _mm_cmpeq_epi8(b1, lf)),
+                                  _mm_and_si128(_mm_cmpeq_epi8(b2, cr), _mm_cmpeq_epi8(b3, lf)));
+    int mask = _mm_movemask_epi8(match);
+    if (mask != 0) {
+      return pos + __builtin_ctz(mask);
+    }
+  }
+#endif
+  // The tail that is too short for a full vector, or the whole buffer without SSE2.
+  return buf.find(kBoundaryMarker, pos);
+}
+
 }  // namespace
 
 //=============================================================================
@@ -51,6 +86,50 @@ namespace pico_wrapper {
 
 namespace {
 
+// Walks the chunk size lines of a chunked body, skipping over the chunk data, and returns true
+// only if the body is certainly missing its last chunk. This is much cheaper than the copy and
+// decode in ParseChunk(), which would otherwise be redone on every retry of a large chunked body
+// that is still arriving. Anything the walk doesn't understand is left to phr_decode_chunked().
+bool ChunkedBodyIncomplete(std::string_view data) {
+  // A size beyond 15 hex digits might overflow, leave it to pico to reject.
+  constexpr int kMaxHexDigits = 15;
+  size_t pos = 0;
+  while (true) {
+    uint64_t chunk_size = 0;
+    int num_digits = 0;
+    for (; pos < data.size() && absl::ascii_isxdigit(data[pos]); ++pos, ++num_digits) {
+      if (num_digits == kMaxHexDigits) {
+        return false;
+      }
+      char c = absl::ascii_tolower(data[pos]);
+      chunk_size = chunk_size * 16 + (absl::ascii_isdigit(c) ? c - '0' : c - 'a' + 10);
+    }
+    if (pos == data.size()) {
+      return true;
+    }
+    if (num_digits == 0 || chunk_size == 0) {
+      return false;
+    }
+    // Skip any chunk extensions, up to the end of the size line.
+    pos = data.find('\n', pos);
+    if (pos == std::string_view::npos || data.size() - pos - 1 < chunk_size) {
+      return true;
+    }
+    pos += 1 + chunk_size;
+    // The chunk data is terminated by CRLF.
+    while (pos < data.size() && data[pos] == '\r') {
+      ++pos;
+    }
+    if (pos == data.size()) {
+      return true;
+    }
+    if (data[pos] != '\n') {
+      return false;
+    }
+    ++pos;
+  }
+}
+
 // TODO(oazizi): ParseChunk makes a copy of the data. Consider finding a way
 //               to mutate the input buffer such that we can avoid this copy.
 //               phr_decode_chunked() already mutates the input buffer, but
@@ -60,6 +139,10 @@ namespace {
 //               Note that the copy is not overhead when a complete message is found,
 //               since the data is std::moved to the result.
 ParseState ParseChunk(std::string_view* data, Message* result) {
+  if (ChunkedBodyIncomplete(*data)) {
+    return ParseState::kNeedsMoreData;
+  }
+
   phr_chunked_decoder chunk_decoder = {};
   std::string data_copy(*data);
   char* buf = data_copy.data();
@@ -311,8 +394,6 @@ size_t FindFrameBoundary(message_type_t type, std::string_view buf, size_t start
   static constexpr ArrayView<std::string_view> kHTTPRespStartPatterns =
       ArrayView<std::string_view>(kHTTPRespStartPatternArray);
 
-  static constexpr std::string_view kBoundaryMarker = "\r\n\r\n";
-
   // Choose the right set of patterns for request vs response.
   const ArrayView<std::string_view>* start_patterns = nullptr;
   switch (type) {
@@ -338,7 +419,7 @@ size_t FindFrameBoundary(message_type_t type, std::string_view buf, size_t start
   // Note that we don't search forwards for HTTP/1.1 directly, because it could result in matches
   // inside the request/response body.
   while (true) {
-    size_t marker_pos = buf.find(kBoundaryMarker, start_pos);
+    size_t marker_pos = FindBoundaryMarker(buf, start_pos);
 
     if (marker_pos == std::string::npos) {
       return std::string::npos;
@@ -381,6 +462,12 @@ size_t FindFrameBoundary<http::Message>(message_type_t type, std::string_view bu
   return http::FindFrameBoundary(type, buf, start_pos);
 }
 
+template <>
+size_t PartialFrameSize<http::Message>(message_type_t /*type*/, std::string_view /*buf*/) {
+  // The size depends on the headers, which are not parsed until they are complete.
+  return 0;
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
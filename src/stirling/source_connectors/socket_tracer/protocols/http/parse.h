@@ -39,6 +39,9 @@ template <>
 size_t FindFrameBoundary<http::Message>(message_type_t type, std::string_view buf, size_t start_pos,
                                         NoState* state);
 
+template <>
+size_t PartialFrameSize<http::Message>(message_type_t type, std::string_view buf);
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <string>
+
+#include <absl/strings/str_cat.h>
+
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/test_data.h"
+
+using px::stirling::protocols::FindFrameBoundary;
+using px::stirling::protocols::ParseFramesLoop;
+using px::stirling::protocols::ParseResult;
+using px::stirling::protocols::http::Message;
+
+namespace testdata = px::stirling::protocols::http::testdata;
+
+namespace {
+
+// A stream of back to back messages, built from the parse_test corpus.
+std::string RepeatedMessages(std::string_view msgs, int count) {
+  std::string buf;
+  for (int i = 0; i < count; ++i) {
+    absl::StrAppend(&buf, msgs);
+  }
+  return buf;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_parse_requests(benchmark::State& state) {
+  const std::string buf = RepeatedMessages(
+      absl::StrCat(testdata::kHTTPGetReq0, testdata::kHTTPPostReq0, testdata::kHTTPGetReq1),
+      state.range(0));
+  for (auto _ : state) {
+    std::deque<Message> frames;
+    ParseResult result = ParseFramesLoop(message_type_t::kRequest, buf, &frames);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_parse_responses(benchmark::State& state) {
+  const std::string buf = RepeatedMessages(
+      absl::StrCat(testdata::kHTTPResp0, testdata::kHTTPResp1, testdata::kHTTPResp2),
+      state.range(0));
+  for (auto _ : state) {
+    std::deque<Message> frames;
+    ParseResult result = ParseFramesLoop(message_type_t::kResponse, buf, &frames);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+
+// The retry of a large chunked response whose last chunk has yet to arrive, as happens on every
+// transfer iteration until it does.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_parse_incomplete_chunked_response(benchmark::State& state) {
+  std::string buf =
+      "HTTP/1.1 200 OK\r\n"
+      "Transfer-Encoding: chunked\r\n"
+      "\r\n";
+  const std::string chunk(4096, 'x');
+  for (int i = 0; i < state.range(0); ++i) {
+    absl::StrAppend(&buf, "1000\r\n", chunk, "\r\n");
+  }
+  for (auto _ : state) {
+    std::deque<Message> frames;
+    ParseResult result = ParseFramesLoop(message_type_t::kResponse, buf, &frames);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+
+// Resyncing past a large body that holds no message boundary, as after a lost event.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_find_frame_boundary(benchmark::State& state) {
+  const std::string buf =
+      absl::StrCat(std::string(state.range(0), 'x'), testdata::kHTTPResp0, testdata::kHTTPResp1);
+  for (auto _ : state) {
+    size_t pos = FindFrameBoundary<Message>(message_type_t::kResponse, buf, 1);
+    benchmark::DoNotOptimize(pos);
+  }
+  state.SetBytesProcessed(state.iterations() * buf.size());
+}
+
+BENCHMARK(BM_parse_requests)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK(BM_parse_responses)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK(BM_parse_incomplete_chunked_response)->RangeMultiplier(4)->Range(1, 256);
+BENCHMARK(BM_find_frame_boundary)->RangeMultiplier(8)->Range(64, 1 << 20);
@@ -26,6 +26,7 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/test_utils.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/parse.h"
+#include "src/stirling/source_connectors/socket_tracer/protocols/http/test_data.h"
 
 namespace px {
 namespace stirling {
@@ -39,17 +40,17 @@ using ::testing::Key;
 using ::testing::Not;
 using ::testing::Pair;
 
+using testdata::kHTTPGetReq0;
+using testdata::kHTTPGetReq1;
+using testdata::kHTTPPostReq0;
+using testdata::kHTTPResp0;
+using testdata::kHTTPResp1;
+using testdata::kHTTPResp2;
+
 //=============================================================================
 // Test Utilities
 //=============================================================================
 
-const std::string_view kHTTPGetReq0 =
-    "GET /index.html HTTP/1.1\r\n"
-    "Host: www.pixielabs.ai\r\n"
-    "Accept: image/gif, image/jpeg, */*\r\n"
-    "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
-    "\r\n";
-
 Message HTTPGetReq0ExpectedMessage() {
   Message expected_message;
   expected_message.type = message_type_t::kRequest;
@@ -63,13 +64,6 @@ Message HTTPGetReq0ExpectedMessage() {
   return expected_message;
 }
 
-const std::string_view kHTTPGetReq1 =
-    "GET /foo.html HTTP/1.1\r\n"
-    "Host: www.pixielabs.ai\r\n"
-    "Accept: image/gif, image/jpeg, */*\r\n"
-    "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
-    "\r\n";
-
 Message HTTPGetReq1ExpectedMessage() {
   Message expected_message;
   expected_message.type = message_type_t::kRequest;
@@ -83,14 +77,6 @@ Message HTTPGetReq1ExpectedMessage() {
   return expected_message;
 }
 
-const std::string_view kHTTPPostReq0 =
-    "POST /test HTTP/1.1\r\n"
-    "host: pixielabs.ai\r\n"
-    "content-type: application/x-www-form-urlencoded\r\n"
-    "content-length: 27\r\n"
-    "\r\n"
-    "field1=value1&field2=value2";
-
 Message HTTPPostReq0ExpectedMessage() {
   Message expected_message;
   expected_message.type = message_type_t::kRequest;
@@ -104,13 +90,6 @@ Message HTTPPostReq0ExpectedMessage() {
   return expected_message;
 }
 
-const std::string_view kHTTPResp0 =
-    "HTTP/1.1 200 OK\r\n"
-    "Content-Type: foo\r\n"
-    "Content-Length: 9\r\n"
-    "\r\n"
-    "pixielabs";
-
 Message HTTPResp0ExpectedMessage() {
   Message expected_message;
   expected_message.type = message_type_t::kResponse;
@@ -122,13 +101,6 @@ Message HTTPResp0ExpectedMessage() {
   return expected_message;
 }
 
-const std::string_view kHTTPResp1 =
-    "HTTP/1.1 200 OK\r\n"
-    "Content-Type: bar\r\n"
-    "Content-Length: 21\r\n"
-    "\r\n"
-    "pixielabs is awesome!";
-
 Message HTTPResp1ExpectedMessage() {
   Message expected_message;
   expected_message.type = message_type_t::kResponse;
@@ -140,17 +112,6 @@ Message HTTPResp1ExpectedMessage() {
   return expected_message;
 }
 
-const std::string_view kHTTPResp2 =
-    "HTTP/1.1 200 OK\r\n"
-    "Transfer-Encoding: chunked\r\n"
-    "\r\n"
-    "9\r\n"
-    "pixielabs\r\n"
-    "C\r\n"
-    " is awesome!\r\n"
-    "0\r\n"
-    "\r\n";
-
 Message HTTPResp2ExpectedMessage() {
   Message expected_message;
   expected_message.type = message_type_t::kResponse;
@@ -468,6 +429,29 @@ TEST_F(HTTPParserTest, ParseIncompleteChunks) {
   EXPECT_THAT(parsed_messages, IsEmpty());
 }
 
+// A chunked body is reported incomplete at every split point before its last chunk, and is then
+// parsed once it's all there.
+TEST_F(HTTPParserTest, ParseChunksAsTheyArrive) {
+  const std::string msg = HTTPRespWithChunkedBody({"pixielabs", " is awesome!"});
+  Message expected_message = EmptyChunkedHTTPResp();
+  expected_message.body = "pixielabs is awesome!";
+
+  // The zero-sized last chunk is the final "0\r\n\r\n".
+  const size_t complete_size = msg.size() - 2;
+  for (size_t size = 0; size < complete_size; ++size) {
+    std::deque<Message> parsed_messages;
+    ParseResult result =
+        ParseFramesLoop(message_type_t::kResponse, msg.substr(0, size), &parsed_messages);
+    EXPECT_EQ(size == 0 ? ParseState::kSuccess : ParseState::kNeedsMoreData, result.state);
+    EXPECT_THAT(parsed_messages, IsEmpty());
+  }
+
+  std::deque<Message> parsed_messages;
+  ParseResult result = ParseFramesLoop(message_type_t::kResponse, msg, &parsed_messages);
+  EXPECT_EQ(ParseState::kSuccess, result.state);
+  EXPECT_THAT(parsed_messages, ElementsAre(expected_message));
+}
+
 // Note that many other tests already use requests with no content-length,
 // but keeping this explicitly here in case the other tests change.
 TEST_F(HTTPParserTest, ParseRequestWithoutLengthOrChunking) {
@@ -804,6 +788,16 @@ TEST_F(HTTPParserTest, FindRespBoundaryWithStartPos) {
   }
 }
 
+// The boundary marker is searched 16 bytes at a time, so check that it's found wherever it falls
+// relative to those blocks, including in the tail that is too short for a full block.
+TEST_F(HTTPParserTest, FindRespBoundaryAtEveryOffset) {
+  for (size_t padding = 0; padding < 40; ++padding) {
+    const std::string buf = absl::StrCat(std::string(padding, '\r'), kHTTPResp0);
+    size_t pos = FindFrameBoundary<http::Message>(message_type_t::kResponse, buf, 0);
+    EXPECT_EQ(pos, padding);
+  }
+}
+
 TEST_F(HTTPParserTest, FindNoBoundary) {
   const std::string buf = "This is a bogus string in which there are no HTTP boundaries.";
 
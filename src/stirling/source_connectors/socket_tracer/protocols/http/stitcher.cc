@@ -18,9 +18,11 @@
 
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/stitcher.h"
 
+#include <algorithm>
 #include <deque>
 #include <limits>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "src/common/base/base.h"
@@ -43,7 +45,24 @@ namespace stirling {
 namespace protocols {
 namespace http {
 
-void PreProcessMessage(Message* message) {
+namespace {
+
+// Returns the decompressed size recorded in the trailer of gzip content (ISIZE, RFC 1952), which
+// is the size modulo 2^32.
+size_t GzipDecompressedSize(std::string_view body) {
+  constexpr size_t kTrailerSizeBytes = 4;
+  if (body.size() < kTrailerSizeBytes) {
+    return 0;
+  }
+  const auto* isize =
+      reinterpret_cast<const uint8_t*>(body.data() + body.size() - kTrailerSizeBytes);
+  return static_cast<size_t>(isize[0]) | static_cast<size_t>(isize[1]) << 8 |
+         static_cast<size_t>(isize[2]) << 16 | static_cast<size_t>(isize[3]) << 24;
+}
+
+}  // namespace
+
+size_t PreProcessMessage(Message* message, size_t max_body_bytes) {
   // Parse the flags on the first time only.
   static const HTTPHeaderFilter kHTTPResponseHeaderFilter =
       ParseHTTPHeaderFilters(FLAGS_http_response_header_filters);
@@ -52,7 +71,7 @@ void PreProcessMessage(Message* message) {
   auto content_type_iter = message->headers.find(http::kContentType);
   if (content_type_iter == message->headers.end()) {
     message->body = "<removed: unknown content-type>";
-    return;
+    return message->body.size();
   }
 
   // Rule: Exclude anything that doesn't match the filter, if filter is active.
@@ -61,22 +80,33 @@ void PreProcessMessage(Message* message) {
        !kHTTPResponseHeaderFilter.exclusions.empty())) {
     if (!MatchesHTTPHeaders(message->headers, kHTTPResponseHeaderFilter)) {
       message->body = "<removed: non-text content-type>";
-      return;
+      return message->body.size();
     }
   }
 
   auto content_encoding_iter = message->headers.find(kContentEncoding);
   // Replace body with decompressed version, if required.
+  // Only the bytes that are kept are decompressed, plus one so that the caller still sees that the
+  // body is longer than max_body_bytes and marks it as truncated.
   if (content_encoding_iter != message->headers.end() && content_encoding_iter->second == "gzip") {
     std::string_view body_strview(message->body);
-    auto bodyOrErr = px::zlib::Inflate(body_strview);
+    size_t max_output_size =
+        max_body_bytes == std::numeric_limits<size_t>::max() ? max_body_bytes : max_body_bytes + 1;
+    auto bodyOrErr = px::zlib::InflatePrefix(body_strview, max_output_size);
     if (!bodyOrErr.ok()) {
       LOG(WARNING) << "Unable to gunzip HTTP body.";
       message->body = "<Failed to gunzip body>";
-    } else {
-      message->body = bodyOrErr.ValueOrDie();
+      return message->body.size();
+    }
+    size_t body_size = bodyOrErr.ValueOrDie().size();
+    if (body_size == max_output_size) {
+      // Decompression stopped early, so take the full size from the gzip trailer.
+      body_size = std::max(body_size, GzipDecompressedSize(body_strview));
     }
+    message->body = std::move(bodyOrErr.ValueOrDie());
+    return body_size;
   }
+  return message->body.size();
 }
 
 }  // namespace http
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <deque>
+#include <limits>
 #include <map>
 #include <string>
 #include <vector>
@@ -45,7 +46,15 @@ namespace http {
 RecordsWithErrorCount<Record> ProcessMessages(std::deque<Message>* req_messages,
                                               std::deque<Message>* resp_messages);
 
-void PreProcessMessage(Message* message);
+/**
+ * Prepares the body of a message for the table: removes bodies of filtered out content types, and
+ * decompresses gzip bodies. Only up to max_body_bytes of a gzip body (plus a byte to show that it
+ * is longer) are decompressed, as longer bodies are truncated in the table anyway.
+ *
+ * @return The size of the body before it is cut to max_body_bytes.
+ */
+size_t PreProcessMessage(Message* message,
+                         size_t max_body_bytes = std::numeric_limits<size_t>::max());
 
 }  // namespace http
 
@@ -19,6 +19,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <string>
+
+#include "src/common/testing/testing.h"
+#include "src/common/zlib/zlib_wrapper.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/http/stitcher.h"
 
 namespace px {
@@ -44,6 +48,22 @@ TEST(PreProcessRecordTest, GzipCompressedContentIsDecompressed) {
   EXPECT_EQ("This is a test\n", message.body);
 }
 
+TEST(PreProcessRecordTest, GzipCompressedContentIsDecompressedUpToMaxBodyBytes) {
+  std::string content;
+  for (int i = 0; i < 1000; ++i) {
+    content += "This is a test\n";
+  }
+  ASSERT_OK_AND_ASSIGN(std::string compressed, px::zlib::Deflate(content));
+
+  Message message;
+  message.type = message_type_t::kResponse;
+  message.headers.insert({kContentEncoding, "gzip"});
+  message.headers.insert({kContentType, "json"});
+  message.body = compressed;
+  EXPECT_EQ(PreProcessMessage(&message, /*max_body_bytes*/ 10), content.size());
+  EXPECT_EQ(message.body, content.substr(0, 11));
+}
+
 TEST(PreProcessRecordTest, ContentHeaderIsNotAdded) {
   Message message;
   message.type = message_type_t::kResponse;
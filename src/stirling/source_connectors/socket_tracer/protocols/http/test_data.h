@@ -0,0 +1,80 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string_view>
+
+namespace px {
+namespace stirling {
+namespace protocols {
+namespace http {
+namespace testdata {
+
+constexpr std::string_view kHTTPGetReq0 =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: www.pixielabs.ai\r\n"
+    "Accept: image/gif, image/jpeg, */*\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+    "\r\n";
+
+constexpr std::string_view kHTTPGetReq1 =
+    "GET /foo.html HTTP/1.1\r\n"
+    "Host: www.pixielabs.ai\r\n"
+    "Accept: image/gif, image/jpeg, */*\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+    "\r\n";
+
+constexpr std::string_view kHTTPPostReq0 =
+    "POST /test HTTP/1.1\r\n"
+    "host: pixielabs.ai\r\n"
+    "content-type: application/x-www-form-urlencoded\r\n"
+    "content-length: 27\r\n"
+    "\r\n"
+    "field1=value1&field2=value2";
+
+constexpr std::string_view kHTTPResp0 =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: foo\r\n"
+    "Content-Length: 9\r\n"
+    "\r\n"
+    "pixielabs";
+
+constexpr std::string_view kHTTPResp1 =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: bar\r\n"
+    "Content-Length: 21\r\n"
+    "\r\n"
+    "pixielabs is awesome!";
+
+constexpr std::string_view kHTTPResp2 =
+    "HTTP/1.1 200 OK\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "9\r\n"
+    "pixielabs\r\n"
+    "C\r\n"
+    " is awesome!\r\n"
+    "0\r\n"
+    "\r\n";
+
+}  // namespace testdata
+}  // namespace http
+}  // namespace protocols
+}  // namespace stirling
+}  // namespace px
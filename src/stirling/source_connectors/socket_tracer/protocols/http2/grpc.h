@@ -18,17 +18,17 @@
 
 #pragma once
 
-#include <google/protobuf/message.h>
-
 #include <optional>
 #include <string>
 #include <string_view>
 
+#include "src/common/grpcutils/message_text.h"
+
 namespace px {
 namespace stirling {
 namespace grpc {
 
-constexpr size_t kGRPCMessageHeaderSizeInBytes = 5;
+using ::px::grpc::kGRPCMessageHeaderSizeInBytes;
 
 /**
  * Parses the input str as the provided protobuf message type.
@@ -104,6 +104,12 @@ StatusOr<MessageSet> PacketDecoder::ExtractMessageSet() {
   }
   PL_RETURN_IF_ERROR(MarkOffset(message_set.size));
 
+  if (!extract_record_batches_) {
+    // The size covers the record batches, and the tag section if any.
+    PL_RETURN_IF_ERROR(JumpToOffset());
+    return message_set;
+  }
+
   // The message set in a fetch response is sent with the sendfile syscall:
   // sendfile(int out_fd, int in_fd, off_t *offset, size_t count). We can only get the length of
   // the payload, not the content. To make sure ParseFrame functions correctly, a temporary fix
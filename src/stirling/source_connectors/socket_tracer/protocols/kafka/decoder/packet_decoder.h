@@ -234,6 +234,12 @@ class PacketDecoder {
     is_flexible_ = IsFlexible(api_key, api_version);
   }
 
+  // If false, ExtractMessageSet() only extracts the size of message sets, and skips over their
+  // record batches. Used when only the summary of the message set is output.
+  void set_extract_record_batches(bool extract_record_batches) {
+    extract_record_batches_ = extract_record_batches;
+  }
+
  private:
   // Represents a sequence of characters. First the length N is given as an INT16. Then N
   // bytes follow which are the UTF-8 encoding of the character sequence.
@@ -304,6 +310,7 @@ class PacketDecoder {
   APIKey api_key_;
   int16_t api_version_ = 0;
   bool is_flexible_ = false;
+  bool extract_record_batches_ = true;
 };
 
 }  // namespace kafka
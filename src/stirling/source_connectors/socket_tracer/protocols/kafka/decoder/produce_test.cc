@@ -209,6 +209,27 @@ TEST(KafkaPacketDecoderTest, ExtractProduceReqV9) {
   EXPECT_OK_AND_EQ(decoder.ExtractProduceReq(), expected_result);
 }
 
+TEST(KafkaPacketDecoderTest, ExtractProduceReqV9WithoutRecordBatches) {
+  const std::string_view input = CreateStringView<char>(
+      "\x00\x00\x01\x00\x00\x05\xdc\x02\x12\x71\x75\x69\x63\x6b\x73\x74\x61\x72\x74\x2d\x65"
+      "\x76\x65\x6e\x74\x73\x02\x00\x00\x00\x00\x5b\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+      "\x4e\xff\xff\xff\xff\x02\xc0\xde\x91\x11\x00\x00\x00\x00\x00\x00\x00\x00\x01\x7a\x1b\xc8"
+      "\x2d\xaa\x00\x00\x01\x7a\x1b\xc8\x2d\xaa\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+      "\xff\xff\x00\x00\x00\x01\x38\x00\x00\x00\x01\x2c\x54\x68\x69\x73\x20\x69\x73\x20\x6d\x79"
+      "\x20\x66\x69\x72\x73\x74\x20\x65\x76\x65\x6e\x74\x00\x00\x00\x00");
+  MessageSet message_set{.size = 91, .record_batches = {}};
+  ProduceReqPartition partition{.index = 0, .message_set = message_set};
+  ProduceReqTopic topic{.name = "quickstart-events", .partitions = {partition}};
+  ProduceReq expected_result{
+      .transactional_id = "", .acks = 1, .timeout_ms = 1500, .topics = {topic}};
+  PacketDecoder decoder(input);
+  decoder.SetAPIInfo(APIKey::kProduce, 9);
+  decoder.set_extract_record_batches(false);
+  ASSERT_OK_AND_ASSIGN(ProduceReq result, decoder.ExtractProduceReq());
+  EXPECT_EQ(result, expected_result);
+  EXPECT_EQ(result.topics[0].partitions[0].message_set.size, 91);
+}
+
 TEST(KafkaPacketDecoderTest, ExtractProduceRespV7) {
   const std::string_view input = CreateStringView<char>(
       "\x00\x00\x00\x01\x00\x08\x6D\x79\x2D\x74\x6F\x70\x69\x63\x00\x00\x00\x01\x00\x00\x00\x00\x00"
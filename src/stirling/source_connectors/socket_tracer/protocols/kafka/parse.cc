@@ -34,9 +34,6 @@ namespace stirling {
 namespace protocols {
 namespace kafka {
 
-#define PL_ASSIGN_OR_RETURN_INVALID(expr, val_or) \
-  PL_ASSIGN_OR(expr, val_or, return ParseState::kInvalid)
-
 // Kafka request/response format: https://kafka.apache.org/protocol.html#protocol_messages
 ParseState ParseFrame(message_type_t type, std::string_view* buf, Packet* result, State* state) {
   DCHECK(type == message_type_t::kRequest || type == message_type_t::kResponse);
@@ -48,9 +45,10 @@ ParseState ParseFrame(message_type_t type, std::string_view* buf, Packet* result
     return ParseState::kNeedsMoreData;
   }
 
+  // The header fields are all within the minimum packet length checked above.
   BinaryDecoder binary_decoder(*buf);
 
-  PL_ASSIGN_OR_RETURN_INVALID(int32_t payload_length, binary_decoder.ExtractInt<int32_t>());
+  int32_t payload_length = binary_decoder.ExtractIntUnchecked<int32_t>();
 
   if (payload_length + kafka::kMessageLengthBytes <= min_packet_length) {
     return ParseState::kInvalid;
@@ -61,13 +59,13 @@ ParseState ParseFrame(message_type_t type, std::string_view* buf, Packet* result
   APIKey request_api_key;
   int16_t request_api_version;
   if (type == message_type_t::kRequest) {
-    PL_ASSIGN_OR_RETURN_INVALID(int16_t request_api_key_int, binary_decoder.ExtractInt<int16_t>());
+    int16_t request_api_key_int = binary_decoder.ExtractIntUnchecked<int16_t>();
     if (!IsValidAPIKey(request_api_key_int)) {
       return ParseState::kInvalid;
     }
     request_api_key = static_cast<APIKey>(request_api_key_int);
 
-    PL_ASSIGN_OR_RETURN_INVALID(request_api_version, binary_decoder.ExtractInt<int16_t>());
+    request_api_version = binary_decoder.ExtractIntUnchecked<int16_t>();
 
     if (!IsSupportedAPIVersion(request_api_key, request_api_version)) {
       return ParseState::kInvalid;
@@ -75,7 +73,7 @@ ParseState ParseFrame(message_type_t type, std::string_view* buf, Packet* result
     // TODO(chengruizhe): Add length range checks for each api key x version.
   }
 
-  PL_ASSIGN_OR_RETURN_INVALID(int32_t correlation_id, binary_decoder.ExtractInt<int32_t>());
+  int32_t correlation_id = binary_decoder.ExtractIntUnchecked<int32_t>();
   if (correlation_id < 0) {
     return ParseState::kInvalid;
   }
@@ -172,6 +170,18 @@ size_t FindFrameBoundary<kafka::Packet, kafka::StateWrapper>(message_type_t type
   return kafka::FindFrameBoundary(type, buf, start_pos, &state->global);
 }
 
+template <>
+size_t PartialFrameSize<kafka::Packet>(message_type_t /*type*/, std::string_view buf) {
+  if (buf.size() < kafka::kMessageLengthBytes) {
+    return 0;
+  }
+  int32_t payload_length = utils::BEndianBytesToInt<int32_t>(buf);
+  if (payload_length <= 0) {
+    return 0;
+  }
+  return kafka::kMessageLengthBytes + payload_length;
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
@@ -42,6 +42,9 @@ template <>
 size_t FindFrameBoundary<kafka::Packet>(message_type_t type, std::string_view buf, size_t start_pos,
                                         kafka::StateWrapper* state);
 
+template <>
+size_t PartialFrameSize<kafka::Packet>(message_type_t type, std::string_view buf);
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
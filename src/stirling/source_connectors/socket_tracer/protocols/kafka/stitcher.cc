@@ -77,6 +77,8 @@ Status ProcessJoinGroupResp(PacketDecoder* decoder, Response* resp) {
 Status ProcessReq(Packet* req_packet, Request* req) {
   req->timestamp_ns = req_packet->timestamp_ns;
   PacketDecoder decoder(*req_packet);
+  // Only the size of message sets is output, so don't decode their records.
+  decoder.set_extract_record_batches(false);
   // Extracts api_key, api_version, and correlation_id.
   PL_RETURN_IF_ERROR(decoder.ExtractReqHeader(req));
 
@@ -98,6 +100,7 @@ Status ProcessResp(Packet* resp_packet, Response* resp, APIKey api_key, int16_t
   resp->timestamp_ns = resp_packet->timestamp_ns;
   PacketDecoder decoder(*resp_packet);
   decoder.SetAPIInfo(api_key, api_version);
+  decoder.set_extract_record_batches(false);
 
   PL_RETURN_IF_ERROR(decoder.ExtractRespHeader(resp));
 
@@ -135,6 +138,11 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Packet>* req_packets,
   std::vector<Record> entries;
   int error_count = 0;
 
+  // Nothing can be matched until a response arrives, so don't scan the pending requests.
+  if (resp_packets->empty()) {
+    return {entries, error_count};
+  }
+
   // Maps correlation_id to resp packet.
   absl::flat_hash_map<int32_t, Packet*> correlation_id_map;
   for (auto& resp_packet : *resp_packets) {
@@ -142,6 +150,12 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Packet>* req_packets,
   }
 
   for (auto& req_packet : *req_packets) {
+    if (correlation_id_map.empty()) {
+      break;
+    }
+    if (req_packet.consumed) {
+      continue;
+    }
     auto it = correlation_id_map.find(req_packet.correlation_id);
     if (it != correlation_id_map.end()) {
       StatusOr<Record> record_status = ProcessReqRespPair(&req_packet, it->second);
@@ -169,10 +183,7 @@ RecordsWithErrorCount<Record> StitchFrames(std::deque<Packet>* req_packets,
   }
 
   // Clean-up consumed req_packets at the head.
-  for (const auto& req_packet : *req_packets) {
-    if (!req_packet.consumed) {
-      break;
-    }
+  while (!req_packets->empty() && req_packets->front().consumed) {
     req_packets->pop_front();
   }
 
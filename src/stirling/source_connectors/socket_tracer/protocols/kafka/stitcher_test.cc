@@ -65,6 +65,53 @@ TEST(KafkaStitcherTest, BasicMatching) {
             "\"record_errors\":[],\"error_message\":\"\"}]}],\"throttle_time_ms\":0}");
 }
 
+TEST(KafkaStitcherTest, PipelinedOutOfOrderResponses) {
+  std::deque<Packet> req_packets;
+  std::deque<Packet> resp_packets;
+  State state{};
+  RecordsWithErrorCount<Record> result;
+
+  Packet req0 = testdata::kProduceReqPacket;
+  req0.correlation_id = 10;
+  req0.timestamp_ns = 0;
+  Packet req1 = testdata::kProduceReqPacket;
+  req1.correlation_id = 11;
+  req1.timestamp_ns = 1;
+  Packet resp0 = testdata::kProduceRespPacket;
+  resp0.correlation_id = 10;
+  resp0.timestamp_ns = 3;
+  Packet resp1 = testdata::kProduceRespPacket;
+  resp1.correlation_id = 11;
+  resp1.timestamp_ns = 2;
+
+  req_packets.push_back(req0);
+  req_packets.push_back(req1);
+  resp_packets.push_back(resp1);
+
+  // The second request is matched, but stays queued behind the first one.
+  result = StitchFrames(&req_packets, &resp_packets, &state);
+  EXPECT_TRUE(resp_packets.empty());
+  EXPECT_EQ(req_packets.size(), 2);
+  EXPECT_EQ(result.error_count, 0);
+  ASSERT_EQ(result.records.size(), 1);
+  EXPECT_EQ(result.records[0].req.timestamp_ns, 1);
+
+  // A duplicate response doesn't match the consumed request again.
+  resp_packets.push_back(resp1);
+  result = StitchFrames(&req_packets, &resp_packets, &state);
+  EXPECT_EQ(req_packets.size(), 2);
+  EXPECT_EQ(result.error_count, 1);
+  EXPECT_EQ(result.records.size(), 0);
+
+  resp_packets.push_back(resp0);
+  result = StitchFrames(&req_packets, &resp_packets, &state);
+  EXPECT_TRUE(resp_packets.empty());
+  EXPECT_TRUE(req_packets.empty());
+  EXPECT_EQ(result.error_count, 0);
+  ASSERT_EQ(result.records.size(), 1);
+  EXPECT_EQ(result.records[0].req.timestamp_ns, 0);
+}
+
 }  // namespace kafka
 }  // namespace protocols
 }  // namespace stirling
@@ -130,6 +130,12 @@ size_t FindFrameBoundary<mux::Frame>(message_type_t, std::string_view, size_t, N
   return std::string::npos;
 }
 
+template <>
+size_t PartialFrameSize<mux::Frame>(message_type_t /*type*/, std::string_view /*buf*/) {
+  // Not implemented.
+  return 0;
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
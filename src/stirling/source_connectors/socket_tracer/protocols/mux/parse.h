@@ -39,6 +39,9 @@ template <>
 size_t FindFrameBoundary<mux::Frame>(message_type_t type, std::string_view buf, size_t start_pos,
                                      NoState*);
 
+template <>
+size_t PartialFrameSize<mux::Frame>(message_type_t type, std::string_view buf);
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
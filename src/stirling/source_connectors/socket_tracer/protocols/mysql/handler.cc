@@ -190,7 +190,8 @@ StatusOr<ParseState> HandleResultsetResponse(DequeView<Packet> resp_packets, Rec
     resp_packets.pop_front();
   }
 
-  std::vector<ResultsetRow> results;
+  // Only the number of rows is output, so the rows are counted rather than kept.
+  size_t num_rows = 0;
 
   auto isLastPacket = [](const Packet& p) {
     return (IsErrPacket(p) || IsOKPacket(p) || IsEOFPacket(p));
@@ -212,8 +213,7 @@ StatusOr<ParseState> HandleResultsetResponse(DequeView<Packet> resp_packets, Rec
 
     if (s.ok()) {
       resp_packets.pop_front();
-      ResultsetRow row{row_packet.msg};
-      results.emplace_back(std::move(row));
+      ++num_rows;
     } else if (isLastPacket(row_packet)) {
       break;
     } else {
@@ -237,7 +237,7 @@ StatusOr<ParseState> HandleResultsetResponse(DequeView<Packet> resp_packets, Rec
   if (multi_resultset) {
     absl::StrAppend(&entry->resp.msg, ", ");
   }
-  absl::StrAppend(&entry->resp.msg, "Resultset rows = ", results.size());
+  absl::StrAppend(&entry->resp.msg, "Resultset rows = ", num_rows);
 
   // Check for another resultset in case this is a multi-resultset.
   if (MoreResultsExist(last_packet)) {
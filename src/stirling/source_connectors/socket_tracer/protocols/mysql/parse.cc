@@ -128,6 +128,15 @@ size_t FindFrameBoundary<mysql::Packet>(message_type_t type, std::string_view bu
   return mysql::FindFrameBoundary(type, buf, start_pos);
 }
 
+template <>
+size_t PartialFrameSize<mysql::Packet>(message_type_t /*type*/, std::string_view buf) {
+  if (buf.size() < mysql::kPacketHeaderLength) {
+    return 0;
+  }
+  return mysql::kPacketHeaderLength +
+         utils::LEndianBytesToInt<int, mysql::kPayloadLengthLength>(buf);
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
@@ -40,6 +40,9 @@ template <>
 size_t FindFrameBoundary<mysql::Packet>(message_type_t type, std::string_view buf, size_t start_pos,
                                         mysql::StateWrapper* state);
 
+template <>
+size_t PartialFrameSize<mysql::Packet>(message_type_t type, std::string_view buf);
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
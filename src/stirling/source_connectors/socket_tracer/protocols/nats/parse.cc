@@ -49,11 +49,11 @@ constexpr std::string_view kMessageFieldDelimiters = " \t";
 
 size_t FindMessageBoundary(std::string_view buf, size_t start_pos) {
   // Based on https://github.com/nats-io/docs/blob/master/nats_protocol/nats-protocol.md.
-  const std::vector<std::string_view> kmessage_type_ts = {kInfo, kConnect, kPub,  kSub, kUnsub,
-                                                          kMsg,  kPing,    kPong, kOK,  kERR};
+  static constexpr std::string_view kMessageTypes[] = {kInfo, kConnect, kPub,  kSub, kUnsub,
+                                                       kMsg,  kPing,    kPong, kOK,  kERR};
   constexpr size_t kMinMsgSize = 3;
-  for (size_t i = start_pos; i < buf.size() - kMinMsgSize; ++i) {
-    for (auto msg_type : kmessage_type_ts) {
+  for (size_t i = start_pos; i + kMinMsgSize < buf.size(); ++i) {
+    for (auto msg_type : kMessageTypes) {
       if (absl::StartsWith(buf.substr(i), msg_type)) {
         return i;
       }
@@ -111,17 +111,22 @@ StatusOr<std::vector<std::string_view>> GetMessageFields(NATSDecoder* decoder) {
 
 // The name zip is borrowed from Python. Returns a map with the keys and values provided in the
 // vectors.
-std::map<std::string_view, std::string_view> Zip(const std::vector<std::string_view>& keys,
+// The keys are an initializer_list, so that the field names of each message type don't have to
+// be allocated into a vector for every message.
+std::map<std::string_view, std::string_view> Zip(std::initializer_list<std::string_view> keys,
                                                  const std::vector<std::string_view>& values) {
   std::map<std::string_view, std::string_view> res;
-  for (size_t i = 0; i < keys.size() && i < values.size(); ++i) {
-    res[keys[i]] = values[i];
+  auto value_iter = values.begin();
+  for (auto key_iter = keys.begin(); key_iter != keys.end() && value_iter != values.end();
+       ++key_iter, ++value_iter) {
+    res[*key_iter] = *value_iter;
   }
   return res;
 }
 
 Status ParseMessageWithFields(NATSDecoder* decoder,
-                              const std::vector<std::string_view>& msg_field_names, Message* msg) {
+                              std::initializer_list<std::string_view> msg_field_names,
+                              Message* msg) {
   PL_ASSIGN_OR_RETURN(std::vector<std::string_view> msg_fields, GetMessageFields(decoder));
   msg->options = ToJSONString(Zip(msg_field_names, msg_fields));
   return Status::OK();
@@ -147,7 +152,8 @@ Status ParseSubOptions(NATSDecoder* decoder, Message* msg) {
 }
 
 Status ParseMessageWithPayload(NATSDecoder* decoder,
-                               const std::vector<std::string_view>& msg_field_names, Message* msg) {
+                               std::initializer_list<std::string_view> msg_field_names,
+                               Message* msg) {
   PL_ASSIGN_OR_RETURN(std::string_view msg_str,
                       decoder->ExtractStringUntil(kMessageTerminateMarker));
 
@@ -230,6 +236,12 @@ ParseState ParseFrame(message_type_t /*type*/, std::string_view* buf, nats::Mess
   return TranslateStatus(nats::ParseMessage(buf, msg));
 }
 
+template <>
+size_t PartialFrameSize<nats::Message>(message_type_t /*type*/, std::string_view /*buf*/) {
+  // NATS messages are delimited by CRLF, and carry no overall length.
+  return 0;
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
@@ -45,6 +45,10 @@ TEST(FindMessageBoundaryTest, ResultsAreAsExpected) {
   EXPECT_EQ(FindFrameBoundary<nats::Message>(message_type_t::kUnknown, " -ERR 'test'\r\n", 0), 1);
   EXPECT_EQ(FindFrameBoundary<nats::Message>(message_type_t::kUnknown, " {} \r\n", 0),
             std::string_view::npos);
+  EXPECT_EQ(FindFrameBoundary<nats::Message>(message_type_t::kUnknown, "", 0),
+            std::string_view::npos);
+  EXPECT_EQ(FindFrameBoundary<nats::Message>(message_type_t::kUnknown, "PI", 0),
+            std::string_view::npos);
 }
 
 struct TestParam {
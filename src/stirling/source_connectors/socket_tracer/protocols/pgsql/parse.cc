@@ -330,6 +330,23 @@ size_t FindFrameBoundary<pgsql::RegularMessage>(message_type_t type, std::string
   return pgsql::FindFrameBoundary(buf, start);
 }
 
+template <>
+size_t PartialFrameSize<pgsql::RegularMessage>(message_type_t /*type*/, std::string_view buf) {
+  constexpr size_t kTagLen = 1;
+  constexpr int kLenFieldLen = 4;
+  // A startup message has no tag, and starts with the high byte of its length instead, which is
+  // always zero. Its size is left unknown, rather than misread as the length of a regular message.
+  if (buf.size() < kTagLen + kLenFieldLen || buf[0] == '\0') {
+    return 0;
+  }
+  int32_t len = utils::BEndianBytesToInt<int32_t>(buf.substr(kTagLen));
+  if (len < kLenFieldLen) {
+    return 0;
+  }
+  // Len includes the length field itself, but not the tag.
+  return kTagLen + len;
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
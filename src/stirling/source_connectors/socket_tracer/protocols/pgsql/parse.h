@@ -59,6 +59,9 @@ template <>
 size_t FindFrameBoundary<pgsql::RegularMessage>(message_type_t type, std::string_view buf,
                                                 size_t start, pgsql::StateWrapper* /*state*/);
 
+template <>
+size_t PartialFrameSize<pgsql::RegularMessage>(message_type_t type, std::string_view buf);
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
@@ -293,6 +293,16 @@ TEST(FindFrameBoundaryTest, FindTag) {
   EXPECT_EQ(5, FindFrameBoundary(data, 0));
 }
 
+TEST(PartialFrameSizeTest, RegularAndStartupMessages) {
+  EXPECT_EQ(kQueryTestData.size(), PartialFrameSize<RegularMessage>(message_type_t::kRequest,
+                                                                    kQueryTestData.substr(0, 5)));
+  EXPECT_EQ(0, PartialFrameSize<RegularMessage>(message_type_t::kRequest,
+                                                kQueryTestData.substr(0, 4)));
+  // The size of a startup message is not known.
+  EXPECT_EQ(0, PartialFrameSize<RegularMessage>(message_type_t::kRequest,
+                                                kStartupMsgTestData.substr(0, 10)));
+}
+
 }  // namespace pgsql
 }  // namespace protocols
 }  // namespace stirling
@@ -28,6 +28,11 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/parse.h"
 #include "src/stirling/utils/binary_decoder.h"
 
+DEFINE_uint32(stirling_pgsql_max_data_rows,
+              gflags::Uint32FromEnv("PL_STIRLING_PGSQL_MAX_DATA_ROWS", 100),
+              "The most data rows of a query response that are kept for the response column. "
+              "The rest are only counted, without being parsed.");
+
 namespace px {
 namespace stirling {
 namespace protocols {
@@ -35,6 +40,19 @@ namespace pgsql {
 
 namespace {
 
+// Adds the data row to the response, or only counts it if the response already holds the most rows
+// that are kept.
+Status AddDataRow(const RegularMessage& msg, QueryReqResp::QueryResp* resp) {
+  if (resp->data_rows.size() >= FLAGS_stirling_pgsql_max_data_rows) {
+    ++resp->num_omitted_data_rows;
+    return Status::OK();
+  }
+  DataRow data_row;
+  PL_RETURN_IF_ERROR(ParseDataRow(msg, &data_row));
+  resp->data_rows.push_back(std::move(data_row));
+  return Status::OK();
+}
+
 void AdvanceIterBeyondTimestamp(MsgDeqIter* start, const MsgDeqIter& end, uint64_t ts) {
   while (*start != end && (*start)->timestamp_ns < ts) {
     ++(*start);
@@ -122,9 +140,7 @@ Status FillQueryResp(MsgDeqIter* resp_iter, const MsgDeqIter& end, QueryReqResp:
     }
 
     if (iter->tag == Tag::kDataRow) {
-      DataRow data_row;
-      PL_RETURN_IF_ERROR(ParseDataRow(*iter, &data_row));
-      resp->data_rows.push_back(std::move(data_row));
+      PL_RETURN_IF_ERROR(AddDataRow(*iter, resp));
     }
   }
 
@@ -179,11 +195,8 @@ Status HandleQuery(const RegularMessage& msg, MsgDeqIter* resp_iter, const MsgDe
     }
 
     if (iter->tag == Tag::kDataRow) {
-      DataRow data_row;
-      PL_RETURN_IF_ERROR(ParseDataRow(*iter, &data_row));
-
-      req_resp->resp.timestamp_ns = data_row.timestamp_ns;
-      req_resp->resp.data_rows.push_back(std::move(data_row));
+      req_resp->resp.timestamp_ns = iter->timestamp_ns;
+      PL_RETURN_IF_ERROR(AddDataRow(*iter, &req_resp->resp));
     }
   }
 
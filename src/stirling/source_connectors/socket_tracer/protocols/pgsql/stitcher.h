@@ -25,6 +25,8 @@
 #include "src/stirling/source_connectors/socket_tracer/protocols/common/interface.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/pgsql/types.h"
 
+DECLARE_uint32(stirling_pgsql_max_data_rows);
+
 namespace px {
 namespace stirling {
 namespace protocols {
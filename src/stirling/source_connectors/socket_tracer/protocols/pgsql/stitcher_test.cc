@@ -68,6 +68,39 @@ TEST(PGSQLParseTest, FillQueryResp) {
   EXPECT_EQ(begin, resps.end());
 }
 
+TEST(PGSQLParseTest, FillQueryRespOmitsRowsBeyondLimit) {
+  auto row_desc_data = kRowDescTestData;
+  auto data_row_data = kDataRowTestData;
+
+  RegularMessage row_desc = {};
+  RegularMessage data_row = {};
+  RegularMessage cmd_cmpl = {};
+  cmd_cmpl.tag = Tag::kCmdComplete;
+  cmd_cmpl.payload = "SELECT 3";
+
+  EXPECT_EQ(ParseState::kSuccess, ParseRegularMessage(&row_desc_data, &row_desc));
+  EXPECT_EQ(ParseState::kSuccess, ParseRegularMessage(&data_row_data, &data_row));
+
+  std::deque<RegularMessage> resps = {row_desc, data_row, data_row, data_row, cmd_cmpl};
+
+  const uint32_t max_data_rows = FLAGS_stirling_pgsql_max_data_rows;
+  FLAGS_stirling_pgsql_max_data_rows = 1;
+
+  QueryReqResp::QueryResp query_resp;
+  auto begin = resps.begin();
+  ASSERT_OK(FillQueryResp(&begin, resps.end(), &query_resp));
+  FLAGS_stirling_pgsql_max_data_rows = max_data_rows;
+
+  EXPECT_THAT(query_resp.data_rows, SizeIs(1));
+  EXPECT_EQ(query_resp.num_omitted_data_rows, 2);
+  EXPECT_EQ(
+      "Name,Owner,Encoding,Collate,Ctype,Access privileges\n"
+      "postgres,postgres,UTF8,en_US.utf8,en_US.utf8,[NULL]\n"
+      "[2 more rows]\n"
+      "SELECT 3",
+      query_resp.ToString());
+}
+
 TEST(PGSQLParseTest, FillQueryRespFailures) {
   std::deque<RegularMessage> resps;
   auto begin = resps.begin();
@@ -425,6 +425,8 @@ struct QueryReqResp {
     bool is_err_resp = false;
 
     std::vector<DataRow> data_rows;
+    // The number of data rows beyond the ones kept in data_rows.
+    size_t num_omitted_data_rows = 0;
     CmdCmpl cmd_cmpl;
     ErrResp err_resp;
 
@@ -445,6 +447,9 @@ struct QueryReqResp {
 
         absl::StrAppend(&res, absl::StrJoin(data_rows, "\n", ToStringFormatter<DataRow>()));
         absl::StrAppend(&res, "\n");
+        if (num_omitted_data_rows > 0) {
+          absl::StrAppend(&res, "[", num_omitted_data_rows, " more rows]\n");
+        }
       }
 
       absl::StrAppend(&res, cmd_cmpl.cmd_tag);
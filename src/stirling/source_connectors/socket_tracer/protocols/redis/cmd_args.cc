@@ -21,6 +21,7 @@
 #include <utility>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/strings/ascii.h>
 
 #include "src/common/json/json.h"
 
@@ -494,6 +495,29 @@ std::optional<const CmdArgs*> GetCmdAndArgs(std::string_view payload) {
   return std::nullopt;
 }
 
+// Longer than any command name in kCmdList, including the space of the double-words ones.
+constexpr size_t kMaxCmdNameSize = 64;
+
+// Returns the command named by the words, joined by a space, ignoring case. The name is upper-cased
+// into a stack buffer instead of a std::string, as this runs for every array message.
+std::optional<const CmdArgs*> GetCmdAndArgs(std::string_view first, std::string_view second) {
+  if (first.size() + 1 + second.size() > kMaxCmdNameSize) {
+    return std::nullopt;
+  }
+  char buf[kMaxCmdNameSize];
+  size_t size = 0;
+  for (char c : first) {
+    buf[size++] = absl::ascii_toupper(c);
+  }
+  if (!second.empty()) {
+    buf[size++] = ' ';
+    for (char c : second) {
+      buf[size++] = absl::ascii_toupper(c);
+    }
+  }
+  return GetCmdAndArgs(std::string_view(buf, size));
+}
+
 }  // namespace
 
 std::optional<const CmdArgs*> GetCmdAndArgs(VectorView<std::string>* payloads) {
@@ -501,17 +525,14 @@ std::optional<const CmdArgs*> GetCmdAndArgs(VectorView<std::string>* payloads) {
     return std::nullopt;
   }
   // Search the double-words command first.
-  if (payloads->size() >= 2) {
-    std::string candidate_cmd =
-        absl::AsciiStrToUpper(absl::StrCat((*payloads)[0], " ", (*payloads)[1]));
-    auto res_opt = GetCmdAndArgs(candidate_cmd);
+  if (payloads->size() >= 2 && !(*payloads)[1].empty()) {
+    auto res_opt = GetCmdAndArgs((*payloads)[0], (*payloads)[1]);
     if (res_opt.has_value()) {
       payloads->pop_front(2);
       return res_opt;
     }
   }
-  std::string candidate_cmd = absl::AsciiStrToUpper(payloads->front());
-  auto res_opt = GetCmdAndArgs(candidate_cmd);
+  auto res_opt = GetCmdAndArgs(payloads->front(), std::string_view());
   if (res_opt.has_value()) {
     payloads->pop_front(1);
   }
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/strings/match.h>
 
 #include "src/common/base/base.h"
 #include "src/stirling/source_connectors/socket_tracer/protocols/redis/formatting.h"
@@ -107,10 +108,7 @@ bool IsPubMsg(const std::vector<std::string>& payloads) {
     return false;
   }
   constexpr std::string_view kMessageStr = "MESSAGE";
-  if (absl::AsciiStrToUpper(payloads.front()) != kMessageStr) {
-    return false;
-  }
-  return true;
+  return absl::EqualsIgnoreCase(payloads.front(), kMessageStr);
 }
 
 // This calls ParseMessage(), which eventually calls ParseArray() and are both recursive
@@ -161,7 +159,14 @@ Status ParseArray(message_type_t type, BinaryDecoder* decoder, Message* msg) {
     return Status::OK();
   }
 
+  // Each element needs at least a type marker and the terminal sequence. Checking this before
+  // reserving keeps a bogus size from allocating a huge vector.
+  if (static_cast<size_t>(len) * (1 + kTerminalSequence.size()) > decoder->BufSize()) {
+    return error::ResourceUnavailable("Not enough data for $0 array elements", len);
+  }
+
   std::vector<std::string> payloads;
+  payloads.reserve(len);
   for (int i = 0; i < len; ++i) {
     Message tmp;
     PL_RETURN_IF_ERROR(ParseMessage(type, decoder, &tmp));
@@ -221,6 +226,12 @@ ParseState ParseFrame(message_type_t type, std::string_view* buf, redis::Message
   return redis::ParseMessage(type, buf, msg);
 }
 
+template <>
+size_t PartialFrameSize<redis::Message>(message_type_t /*type*/, std::string_view /*buf*/) {
+  // Only bulk strings carry a length, and only partway into the message.
+  return 0;
+}
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
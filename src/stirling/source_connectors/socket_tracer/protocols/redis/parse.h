@@ -35,6 +35,9 @@ template <>
 ParseState ParseFrame(message_type_t type, std::string_view* buf, redis::Message* msg,
                       NoState* /*state*/);
 
+template <>
+size_t PartialFrameSize<redis::Message>(message_type_t type, std::string_view buf);
+
 }  // namespace protocols
 }  // namespace stirling
 }  // namespace px
@@ -160,7 +160,7 @@ INSTANTIATE_TEST_SUITE_P(
                       "*3\r\n+OK\r\n-Error message\r\n$11\r", "*3\r\n+OK\r\n-Error message\r\n$11",
                       "*3\r\n+OK\r\n-Error message\r\n", "*3\r\n+OK\r\n-Error message\r",
                       "*3\r\n+OK\r\n-Error message", "*3\r\n+OK\r\n", "*3\r\n+OK\r", "*3\r\n+OK",
-                      "*3\r\n", "*3\r", "*3"));
+                      "*3\r\n", "*3\r", "*3", "*1000000\r\n+OK\r\n"));
 
 class ParseInvalidInputTest : public ::testing::TestWithParam<std::string> {};
 
@@ -27,6 +27,9 @@ DEFINE_uint32(stirling_conn_map_cleanup_threshold, kMaxConnMapCleanupItems,
               "Number of map cleanup entries to accumulate before triggering a BPF map clean-up. "
               "Higher numbers result in more efficiency. Too high a number will cause a BPF error "
               "because of the instruction count limit..");
+DEFINE_uint32(stirling_conn_map_leak_checks_per_iteration, 1000,
+              "The most conn_info_map entries that the periodic leak scan checks against /proc "
+              "per iteration. The rest of the scan continues in the following iterations.");
 
 // A function which we will uprobe on, to trigger our BPF code.
 // The function itself is irrelevant, but it must not be optimized away.
@@ -43,7 +46,8 @@ namespace px {
 namespace stirling {
 
 ConnInfoMapManager::ConnInfoMapManager(bpf_tools::BCCWrapper* bcc)
-    : conn_info_map_(bcc->GetHashTable<uint64_t, struct conn_info_t>("conn_info_map")),
+    : bcc_(bcc),
+      conn_info_map_(bcc->GetHashTable<uint64_t, struct conn_info_t>("conn_info_map")),
       conn_disabled_map_(bcc->GetHashTable<uint64_t, uint64_t>("conn_disabled_map")) {
   // Use address instead of symbol to specify this probe,
   // so that even if debug symbols are stripped, the uprobe can still attach.
@@ -77,10 +81,19 @@ void ConnInfoMapManager::Disable(struct conn_id_t conn_id) {
   }
 }
 
+void ConnInfoMapManager::StartBPFMapLeakScan() {
+  leak_scan_entries_ = ConnInfos();
+  leak_scan_pos_ = 0;
+}
+
 void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_mgr) {
   const auto& sysconfig = system::Config::GetInstance();
 
-  for (const auto& [pid_fd, conn_info] : conn_info_map_.get_table_offline()) {
+  uint32_t num_checked = 0;
+  for (; leak_scan_pos_ < leak_scan_entries_.size() &&
+         num_checked < FLAGS_stirling_conn_map_leak_checks_per_iteration;
+       ++leak_scan_pos_) {
+    const auto& [pid_fd, conn_info] = leak_scan_entries_[leak_scan_pos_];
     uint32_t pid = pid_fd >> 32;
     int32_t fd = pid_fd;
 
@@ -89,6 +102,7 @@ void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_m
     if (conn_trackers_mgr->GetConnTracker(pid, fd).ok()) {
       continue;
     }
+    ++num_checked;
 
     std::filesystem::path fd_file =
         sysconfig.proc_path() / std::to_string(pid) / "fd" / std::to_string(fd);
@@ -101,6 +115,44 @@ void ConnInfoMapManager::CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_m
     VLOG(1) << absl::Substitute("Found conn_info_map leak: pid=$0 fd=$1 af=$2", pid, fd,
                                 conn_info.addr.sa.sa_family);
   }
+
+  if (leak_scan_pos_ == leak_scan_entries_.size()) {
+    // Free the snapshot, which can be large, until the next scan.
+    std::vector<std::pair<uint64_t, struct conn_info_t>>().swap(leak_scan_entries_);
+    leak_scan_pos_ = 0;
+  }
+}
+
+TracedTGIDsMapManager::TracedTGIDsMapManager(bpf_tools::BCCWrapper* bcc)
+    : bcc_(bcc), traced_tgids_map_(bcc->GetHashTable<uint32_t, bool>("traced_tgids_map")) {}
+
+void TracedTGIDsMapManager::Update(const absl::flat_hash_set<uint32_t>& tgids) {
+  std::vector<uint32_t> removed_tgids;
+  for (auto it = tgids_.begin(); it != tgids_.end();) {
+    if (tgids.contains(*it)) {
+      ++it;
+      continue;
+    }
+    removed_tgids.push_back(*it);
+    tgids_.erase(it++);
+  }
+  size_t num_removed = bcc_->DeleteHashTableKeys("traced_tgids_map", removed_tgids);
+  if (num_removed != removed_tgids.size()) {
+    VLOG(1) << absl::Substitute("Removed $0 of $1 traced_tgids_map entries.", num_removed,
+                                removed_tgids.size());
+  }
+
+  for (uint32_t tgid : tgids) {
+    if (tgids_.contains(tgid)) {
+      continue;
+    }
+    if (!traced_tgids_map_.update_value(tgid, true).ok()) {
+      // The map is full. The TGID is retried on the next update.
+      VLOG(1) << absl::Substitute("Updating traced_tgids_map entry $0 failed.", tgid);
+      continue;
+    }
+    tgids_.insert(tgid);
+  }
 }
 
 }  // namespace stirling
@@ -19,12 +19,16 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_set.h>
+
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 
 DECLARE_uint32(stirling_conn_map_cleanup_threshold);
+DECLARE_uint32(stirling_conn_map_leak_checks_per_iteration);
 
 namespace px {
 namespace stirling {
@@ -40,19 +44,53 @@ class ConnInfoMapManager {
 
   void Disable(struct conn_id_t conn_id);
 
+  // Takes a snapshot of conn_info_map, whose entries CleanupBPFMapLeaks() then checks for leaks.
+  // Entries that are left from the previous snapshot are dropped.
+  void StartBPFMapLeakScan();
+
+  // Checks the next entries of the snapshot for leaks, and releases the leaked ones. Stops after
+  // --stirling_conn_map_leak_checks_per_iteration entries had to be checked against /proc, so
+  // that the scan of a large map is spread over several iterations.
   void CleanupBPFMapLeaks(ConnTrackersManager* conn_trackers_mgr);
 
+  // Returns the entries of conn_info_map, keyed by {TGID, FD}.
+  std::vector<std::pair<uint64_t, struct conn_info_t>> ConnInfos() {
+    return bcc_->GetHashTableEntries<uint64_t, struct conn_info_t>("conn_info_map");
+  }
+
  private:
+  bpf_tools::BCCWrapper* bcc_;
   ebpf::BPFHashTable<uint64_t, struct conn_info_t> conn_info_map_;
   ebpf::BPFHashTable<uint64_t, uint64_t> conn_disabled_map_;
 
   std::vector<struct conn_id_t> pending_release_queue_;
 
+  // The snapshot of the leak scan in progress, and the position of the next entry to check.
+  std::vector<std::pair<uint64_t, struct conn_info_t>> leak_scan_entries_;
+  size_t leak_scan_pos_ = 0;
+
   // TODO(oazizi): Can we share this with the similar function in socket_trace.c?
   uint64_t id(struct conn_id_t conn_id) const {
     return (static_cast<uint64_t>(conn_id.upid.tgid) << 32) | conn_id.fd;
   }
 };
 
+// Keeps traced_tgids_map, the TGIDs that BPF traces when the traced TGIDs filter is enabled,
+// in sync with the processes that user-space selects.
+class TracedTGIDsMapManager {
+ public:
+  explicit TracedTGIDsMapManager(bpf_tools::BCCWrapper* bcc);
+
+  // Adds the TGIDs that are new since the previous call, and removes those that are gone.
+  void Update(const absl::flat_hash_set<uint32_t>& tgids);
+
+ private:
+  bpf_tools::BCCWrapper* bcc_;
+  ebpf::BPFHashTable<uint32_t, bool> traced_tgids_map_;
+
+  // The TGIDs currently in traced_tgids_map.
+  absl::flat_hash_set<uint32_t> tgids_;
+};
+
 }  // namespace stirling
 }  // namespace px
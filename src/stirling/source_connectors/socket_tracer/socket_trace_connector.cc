@@ -21,11 +21,21 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <optional>
+#include <string_view>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+#include <absl/strings/ascii.h>
+#include <absl/strings/escaping.h>
 #include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/delimited_message_util.h>
 #include <magic_enum.hpp>
@@ -49,6 +59,10 @@
 DEFINE_uint32(
     stirling_conn_stats_sampling_ratio, 50,
     "Ratio of how frequently conn_stats_table is populated relative to the base sampling period");
+DEFINE_bool(stirling_conn_stats_bpf_polling,
+            gflags::BoolFromEnv("PL_STIRLING_CONN_STATS_BPF_POLLING", false),
+            "If true, connection stats are read from the BPF connection map when the "
+            "conn_stats_table is populated, instead of being sent from BPF as events.");
 // The default frequency logs every minute, since each iteration has a cycle period of 200ms.
 DEFINE_uint32(
     stirling_socket_tracer_stats_logging_ratio,
@@ -72,6 +86,11 @@ DEFINE_bool(stirling_enable_http_tracing, true,
             "If true, stirling will trace and process HTTP messages");
 DEFINE_bool(stirling_enable_http2_tracing, true,
             "If true, stirling will trace and process gRPC RPCs.");
+DEFINE_bool(stirling_http2_raw_grpc_bodies,
+            gflags::BoolFromEnv("PL_STIRLING_HTTP2_RAW_GRPC_BODIES", false),
+            "If true, the bodies of gRPC messages are recorded as base64-encoded wire bytes, "
+            "instead of being parsed into text format protobuf. Use px.grpc_body_to_text() to "
+            "parse them at query time.");
 DEFINE_bool(stirling_enable_mysql_tracing, true,
             "If true, stirling will trace and process MySQL messages.");
 DEFINE_bool(stirling_enable_pgsql_tracing, true,
@@ -87,17 +106,48 @@ DEFINE_bool(stirling_enable_nats_tracing, true,
 DEFINE_bool(stirling_enable_kafka_tracing, true,
             "If true, stirling will trace and process Kafka messages.");
 
+DEFINE_bool(stirling_socket_tracer_enable_ring_buffers, true,
+            "If true, and the kernel supports it (Linux 5.8+), the socket tracer exports its "
+            "events through BPF ring buffers instead of perf buffers.");
+
+DEFINE_string(stirling_socket_tracer_capture_size_bytes, "",
+              "Comma-separated list of <protocol>:<bytes>, e.g. \"http:5120,mysql:4096\". "
+              "Caps the number of bytes of each data event of the protocol that BPF copies to "
+              "user-space; the rest of the event is dropped in the kernel. Unlisted protocols "
+              "are copied in full.");
+
+DEFINE_int32(stirling_socket_tracer_parse_threads, 4,
+             "The number of threads, including the Stirling thread, that parse the connection "
+             "trackers' data into records. Capped at the number of CPUs.");
+
 DEFINE_bool(stirling_disable_self_tracing, true,
             "If true, stirling will not trace and process syscalls made by itself.");
 
+DEFINE_string(stirling_socket_tracer_namespaces,
+              gflags::StringFromEnv("PL_STIRLING_SOCKET_TRACER_NAMESPACES", ""),
+              "Comma-separated list of K8s namespaces. If not empty, the socket tracer BPF probes "
+              "only trace the processes of the pods in these namespaces, and drop the events of "
+              "all other processes in the kernel.");
+
+DEFINE_uint32(stirling_conn_inference_max_per_iteration, 1000,
+              "The most connections whose remote endpoint is inferred from /proc and sock_diag "
+              "per iteration. The remaining connections are inferred in later iterations.");
+
 DEFINE_uint32(messages_expiration_duration_secs, 10 * 60,
               "The duration for which a cached message to be erased.");
 DEFINE_uint32(messages_size_limit_bytes, 1024 * 1024,
               "The limit of the size of the parsed messages, not the BPF events, "
               "for each direction, of each connection tracker. "
               "All cached messages are erased if this limit is breached.");
+DEFINE_uint64(stirling_socket_tracer_memory_budget_bytes,
+              gflags::Uint64FromEnv("PL_STIRLING_SOCKET_TRACER_MEMORY_BUDGET_BYTES",
+                                    1024 * 1024 * 1024),
+              "The most memory held by the data buffers and parsed messages of all connections "
+              "after each iteration. Once exceeded, the data of disabled and closed connections is "
+              "dropped first, then that of the connections idle the longest. 0 means no budget.");
 
 BPF_SRC_STRVIEW(socket_trace_bcc_script, socket_trace);
+BPF_SRC_STRVIEW(socket_trace_ringbuf_bcc_script, socket_trace_ringbuf);
 
 namespace px {
 namespace stirling {
@@ -106,7 +156,10 @@ using ::px::stirling::protocols::kMaxBodyBytes;
 using ::px::utils::ToJSONString;
 
 SocketTraceConnector::SocketTraceConnector(std::string_view source_name)
-    : SourceConnector(source_name, kTables), conn_stats_(&conn_trackers_mgr_), uprobe_mgr_(this) {
+    : SourceConnector(source_name, kTables),
+      conn_stats_(&conn_trackers_mgr_),
+      ingest_sampler_(IngestSampler::ConfigFromFlags()),
+      uprobe_mgr_(this) {
   proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
   InitProtocolTransferSpecs();
 }
@@ -183,9 +236,70 @@ void SocketTraceConnector::InitProtocolTransferSpecs() {
   }
 }
 
+namespace {
+
+// Parses the value of --stirling_socket_tracer_capture_size_bytes. Protocols are named after their
+// traffic_protocol_t value without the kProtocol prefix, case-insensitively (e.g. "http", "mysql").
+StatusOr<std::vector<std::pair<traffic_protocol_t, uint64_t>>> ParseCaptureSizes(
+    std::string_view spec) {
+  std::vector<std::pair<traffic_protocol_t, uint64_t>> capture_sizes;
+  for (std::string_view entry : absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    std::vector<std::string_view> parts = absl::StrSplit(entry, ':');
+    uint64_t capture_size = 0;
+    if (parts.size() != 2 || !absl::SimpleAtoi(parts[1], &capture_size)) {
+      return error::InvalidArgument("Invalid capture size '$0', expected <protocol>:<bytes>",
+                                    entry);
+    }
+    std::string_view name = absl::StripAsciiWhitespace(parts[0]);
+    std::optional<traffic_protocol_t> protocol;
+    for (const auto& p : TrafficProtocolEnumValues()) {
+      std::string_view enum_name = magic_enum::enum_name(p);
+      absl::ConsumePrefix(&enum_name, "kProtocol");
+      if (absl::EqualsIgnoreCase(enum_name, name)) {
+        protocol = p;
+      }
+    }
+    if (!protocol.has_value()) {
+      return error::InvalidArgument("Unknown protocol '$0' in capture size '$1'", name, entry);
+    }
+    capture_sizes.emplace_back(protocol.value(), capture_size);
+  }
+  return capture_sizes;
+}
+
+// Returns the TGIDs of the live processes in the pods of the namespaces.
+absl::flat_hash_set<uint32_t> TGIDsInNamespaces(
+    ConnectorContext* ctx, const absl::flat_hash_set<std::string>& namespaces) {
+  const md::K8sMetadataState& k8s_md = ctx->GetK8SMetadata();
+  absl::flat_hash_set<uint32_t> tgids;
+  for (const auto& [upid, pid_info] : ctx->GetPIDInfoMap()) {
+    if (pid_info == nullptr || pid_info->stop_time_ns() > 0) {
+      continue;
+    }
+    const md::ContainerInfo* container_info = k8s_md.ContainerInfoByID(pid_info->cid());
+    if (container_info == nullptr) {
+      continue;
+    }
+    const md::PodInfo* pod_info = k8s_md.PodInfoByID(container_info->pod_id());
+    if (pod_info == nullptr || !namespaces.contains(pod_info->ns())) {
+      continue;
+    }
+    tgids.insert(upid.pid());
+  }
+  return tgids;
+}
+
+}  // namespace
+
 Status SocketTraceConnector::InitImpl() {
   sampling_freq_mgr_.set_period(kSamplingPeriod);
   push_freq_mgr_.set_period(kPushPeriod);
+  // The perf buffers are sized for kSamplingPeriod at the target data rate, so the period is only
+  // lengthened past it when they are mostly empty.
+  EnableAdaptiveSampling(kSamplingPeriod / 4, kSamplingPeriod * 2);
+  if (FLAGS_stirling_perf_buffer_reader_thread) {
+    EnablePerfBufferReaderThread();
+  }
 
   constexpr uint64_t kNanosPerSecond = 1000 * 1000 * 1000;
   if (kNanosPerSecond % sysconfig_.KernelTicksPerSecond() != 0) {
@@ -194,13 +308,27 @@ Status SocketTraceConnector::InitImpl() {
         "timestamps in a way that matches how /proc/stat does it");
   }
 
-  PL_RETURN_IF_ERROR(InitBPFProgram(socket_trace_bcc_script));
+  // Ring buffers are shared by all CPUs and keep events in order, so they are preferred over
+  // per-CPU perf buffers on the kernels that support them.
+  const bool use_ring_buffers =
+      FLAGS_stirling_socket_tracer_enable_ring_buffers && RingBuffersSupported();
+  if (use_ring_buffers) {
+    PL_RETURN_IF_ERROR(
+        InitBPFProgram(socket_trace_ringbuf_bcc_script, RingBufferCFlags(kPerfBufferSpecs)));
+  } else {
+    PL_RETURN_IF_ERROR(InitBPFProgram(socket_trace_bcc_script));
+  }
   PL_RETURN_IF_ERROR(AttachKProbes(kProbeSpecs));
   LOG(INFO) << absl::Substitute("Number of kprobes deployed = $0", kProbeSpecs.size());
   LOG(INFO) << "Probes successfully deployed.";
 
-  PL_RETURN_IF_ERROR(OpenPerfBuffers(kPerfBufferSpecs, this));
-  LOG(INFO) << absl::Substitute("Number of perf buffers opened = $0", kPerfBufferSpecs.size());
+  if (use_ring_buffers) {
+    PL_RETURN_IF_ERROR(OpenRingBuffers(kPerfBufferSpecs, this));
+    LOG(INFO) << absl::Substitute("Number of ring buffers opened = $0", kPerfBufferSpecs.size());
+  } else {
+    PL_RETURN_IF_ERROR(OpenPerfBuffers(kPerfBufferSpecs, this));
+    LOG(INFO) << absl::Substitute("Number of perf buffers opened = $0", kPerfBufferSpecs.size());
+  }
 
   // Set trace role to BPF probes.
   for (const auto& p : TrafficProtocolEnumValues()) {
@@ -213,10 +341,26 @@ Status SocketTraceConnector::InitImpl() {
     }
   }
 
+  PL_ASSIGN_OR_RETURN(auto capture_sizes,
+                      ParseCaptureSizes(FLAGS_stirling_socket_tracer_capture_size_bytes));
+  for (const auto& [protocol, capture_size] : capture_sizes) {
+    PL_RETURN_IF_ERROR(UpdateBPFProtocolCaptureSize(protocol, capture_size));
+    capture_sizes_[protocol] = capture_size;
+  }
+
   PL_RETURN_IF_ERROR(TestOnlySetTargetPID(FLAGS_test_only_socket_trace_target_pid));
   if (FLAGS_stirling_disable_self_tracing) {
     PL_RETURN_IF_ERROR(DisableSelfTracing());
   }
+  if (FLAGS_stirling_conn_stats_bpf_polling) {
+    PL_RETURN_IF_ERROR(EnableConnStatsPolling());
+  }
+  traced_namespaces_ =
+      absl::StrSplit(FLAGS_stirling_socket_tracer_namespaces, ',', absl::SkipWhitespace());
+  if (!traced_namespaces_.empty()) {
+    traced_tgids_map_mgr_ = std::make_unique<TracedTGIDsMapManager>(this);
+    PL_RETURN_IF_ERROR(EnableTracedTGIDsFilter());
+  }
   if (!FLAGS_perf_buffer_events_output_path.empty()) {
     SetupOutput(FLAGS_perf_buffer_events_output_path);
   }
@@ -241,7 +385,12 @@ Status SocketTraceConnector::InitImpl() {
 }
 
 void SocketTraceConnector::InitContextImpl(ConnectorContext* ctx) {
-  std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs());
+  if (traced_tgids_map_mgr_ != nullptr) {
+    traced_tgids_map_mgr_->Update(TGIDsInNamespaces(ctx, traced_namespaces_));
+  }
+
+  std::thread thread =
+      RunDeployUProbesThread(ctx->GetUPIDs(), ctx->GetUPIDsVersion(), ctx->GetUPIDsDelta());
 
   // On the first context, we want to make sure all uprobes deploy before returning.
   if (thread.joinable()) {
@@ -266,7 +415,8 @@ Status SocketTraceConnector::StopImpl() {
 }
 
 std::thread SocketTraceConnector::RunDeployUProbesThread(
-    const absl::flat_hash_set<md::UPID>& pids) {
+    const absl::flat_hash_set<md::UPID>& pids, uint64_t upids_version,
+    std::shared_ptr<const UPIDsDelta> upids_delta) {
   // The check that state is not uninitialized is required for socket_trace_connector_test,
   // which would otherwise try to deploy uprobes (for which it does not have permissions).
   // Also, we check that there is no other previous thread still running.
@@ -277,7 +427,14 @@ std::thread SocketTraceConnector::RunDeployUProbesThread(
   //               deployment will become asynchronous to TransferData(), and this may
   //               lead to non-determinism.
   if (state() != State::kUninitialized && !uprobe_mgr_.ThreadsRunning()) {
-    return uprobe_mgr_.RunDeployUProbesThread(pids);
+    // The number of connections of each PID stands for its traffic, so that the busiest
+    // processes get their uprobes first.
+    absl::flat_hash_map<uint32_t, int> pid_traffic;
+    for (const ConnTracker* tracker : conn_trackers_mgr_.active_trackers()) {
+      ++pid_traffic[tracker->conn_id().upid.pid];
+    }
+    return uprobe_mgr_.RunDeployUProbesThread(pids, upids_version, std::move(upids_delta),
+                                              std::move(pid_traffic));
   }
   return {};
 }
@@ -322,6 +479,7 @@ std::string BPFMapsInfo(bpf_tools::BCCWrapper* bcc) {
   out += BPFMapInfo<uint64_t, struct data_args_t>(bcc, "active_write_args_map");
   out += BPFMapInfo<uint64_t, struct data_args_t>(bcc, "active_read_args_map");
   out += BPFMapInfo<uint64_t, struct close_args_t>(bcc, "active_close_args_map");
+  out += BPFMapInfo<uint32_t, bool>(bcc, "traced_tgids_map");
 
   return out;
 }
@@ -340,7 +498,15 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
   // so raw data will be pushed to connection trackers more aggressively.
   // No data is lost, but this is a side-effect of sorts that affects timing of transfers.
   // It may be worth noting during debug.
-  PollPerfBuffers();
+  {
+    utils::ScopedTimer timer(perf_buffer_poll_time_ns_);
+    RecordSamplingBufferOccupancy(PollPerfBuffers());
+  }
+
+  // Let BPF trace the processes that started in the selected namespaces since the last update.
+  if (traced_tgids_map_mgr_ != nullptr) {
+    traced_tgids_map_mgr_->Update(TGIDsInNamespaces(ctx, traced_namespaces_));
+  }
 
   // Set-up current state for connection inference purposes.
   if (socket_info_mgr_ != nullptr) {
@@ -348,7 +514,8 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
   }
 
   // Deploy uprobes on newly discovered PIDs.
-  std::thread thread = RunDeployUProbesThread(ctx->GetUPIDs());
+  std::thread thread =
+      RunDeployUProbesThread(ctx->GetUPIDs(), ctx->GetUPIDsVersion(), ctx->GetUPIDsDelta());
   // Let it run in the background.
   if (thread.joinable()) {
     thread.detach();
@@ -360,11 +527,12 @@ void SocketTraceConnector::UpdateCommonState(ConnectorContext* ctx) {
   // TODO(oazizi): Track down and plug the leaks, then zap this function.
   constexpr auto kCleanupBPFMapLeaksPeriod = std::chrono::minutes(5);
   constexpr int kCleanupBPFMapLeaksSamplingRatio = kCleanupBPFMapLeaksPeriod / kSamplingPeriod;
-  if (FLAGS_stirling_enable_periodic_bpf_map_cleanup &&
-      sampling_freq_mgr_.count() % kCleanupBPFMapLeaksSamplingRatio == 0) {
-    if (conn_info_map_mgr_ != nullptr) {
-      conn_info_map_mgr_->CleanupBPFMapLeaks(&conn_trackers_mgr_);
+  if (FLAGS_stirling_enable_periodic_bpf_map_cleanup && conn_info_map_mgr_ != nullptr) {
+    if (sampling_freq_mgr_.count() % kCleanupBPFMapLeaksSamplingRatio == 0) {
+      conn_info_map_mgr_->StartBPFMapLeakScan();
     }
+    // The entries of a scan are checked over several iterations, to bound the cost of each.
+    conn_info_map_mgr_->CleanupBPFMapLeaks(&conn_trackers_mgr_);
   }
 }
 
@@ -386,12 +554,22 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
   DataTable* conn_stats_table = data_tables[kConnStatsTableNum];
   if (conn_stats_table != nullptr &&
       sampling_freq_mgr_.count() % FLAGS_stirling_conn_stats_sampling_ratio == 0) {
+    if (FLAGS_stirling_conn_stats_bpf_polling) {
+      PollConnStats();
+    }
     TransferConnStats(ctx, conn_stats_table);
   }
 
+  DataTable* http_red_metrics_table = data_tables[kHTTPREDMetricsTableNum];
+  if (http_red_metrics_table != nullptr &&
+      sampling_freq_mgr_.count() % (kHTTPREDMetricsPeriod / kSamplingPeriod) == 0) {
+    TransferHTTPREDMetrics(ctx, http_red_metrics_table);
+  }
+
   if ((sampling_freq_mgr_.count() + 1) % FLAGS_stirling_socket_tracer_stats_logging_ratio == 0) {
     conn_trackers_mgr_.ComputeProtocolStats();
     LOG(INFO) << "ConnTracker statistics: " << conn_trackers_mgr_.StatsString();
+    LOG(INFO) << "ConnTracker memory bytes: " << conn_trackers_mgr_.MemoryStatsString();
     LOG(INFO) << "SocketTracer statistics: " << stats_.Print();
   }
 
@@ -409,25 +587,80 @@ void SocketTraceConnector::TransferDataImpl(ConnectorContext* ctx,
     DataTable* data_table = data_tables[i];
 
     // Ensure records are within the time window, in order to ensure the order between record
-    // batches. Exception: conn_stats table does not need cutoff time, because its timestamps
-    // are assigned artificially.
-    if (i != kConnStatsTableNum && data_table != nullptr) {
+    // batches. Exception: conn_stats and http_red_metrics tables do not need cutoff time, because
+    // their timestamps are assigned artificially.
+    if (i != kConnStatsTableNum && i != kHTTPREDMetricsTableNum && data_table != nullptr) {
       data_table->SetConsumeRecordsCutoffTime(perf_buffer_drain_time_);
     }
   }
 
+  // The per-tracker state updates touch state shared across trackers (the proc parser, the
+  // socket info manager, the trace level pids), so they run serially. Only the parsing is done in
+  // parallel.
+  std::vector<ConnTracker*> trackers_to_parse;
+  size_t num_to_infer = 0;
+  for (const auto& conn_tracker : conn_trackers_mgr_.active_trackers()) {
+    num_to_infer += conn_tracker->NeedsConnInference();
+  }
+  if (conn_inference_offset_ >= num_to_infer) {
+    conn_inference_offset_ = 0;
+  }
+  size_t num_conn_inferences = 0;
   for (const auto& conn_tracker : conn_trackers_mgr_.active_trackers()) {
     const auto& transfer_spec = protocol_transfer_specs_[conn_tracker->protocol()];
     DataTable* data_table = data_tables[transfer_spec.table_num];
 
     UpdateTrackerTraceLevel(conn_tracker);
 
+    // Each inference reads the tracker's FD link, so the number of inferences is bounded per
+    // iteration, taking turns across the trackers that need one. The socket info used to resolve
+    // the inode of each network namespace is dumped once per iteration.
+    system::SocketInfoManager* socket_info_mgr = nullptr;
+    if (conn_tracker->NeedsConnInference()) {
+      size_t turn = (num_conn_inferences++ + num_to_infer - conn_inference_offset_) % num_to_infer;
+      if (turn < FLAGS_stirling_conn_inference_max_per_iteration) {
+        socket_info_mgr = socket_info_mgr_.get();
+      } else {
+        stats_.Increment(StatKey::kDeferredConnInferences);
+      }
+    }
     conn_tracker->IterationPreTick(iteration_time_, cluster_cidrs, proc_parser_.get(),
-                                   socket_info_mgr_.get());
-    if (transfer_spec.enabled && transfer_spec.transfer_fn && data_table != nullptr) {
-      transfer_spec.transfer_fn(*this, ctx, conn_tracker, data_table);
+                                   socket_info_mgr);
+    if (!transfer_spec.enabled || !transfer_spec.transfer_fn || data_table == nullptr) {
+      continue;
+    }
+    // Unsampled connections are disabled, so that BPF stops sending their data, and they are not
+    // parsed any more. Their connection stats are still collected.
+    if (conn_tracker->state() == ConnTracker::State::kTransferring &&
+        !ingest_sampler_.SampleConn(conn_tracker->conn_id())) {
+      conn_tracker->Disable("Connection not sampled");
+      stats_.Increment(StatKey::kUnsampledConns);
+      continue;
     }
+    trackers_to_parse.push_back(conn_tracker);
+  }
+
+  if (num_to_infer > 0) {
+    conn_inference_offset_ =
+        (conn_inference_offset_ + FLAGS_stirling_conn_inference_max_per_iteration) % num_to_infer;
+  }
+
+  ParseConnTrackers(ctx, trackers_to_parse, data_tables);
+
+  for (const auto& conn_tracker : conn_trackers_mgr_.active_trackers()) {
+    bool was_unparseable = conn_tracker->disabled_as_unparseable();
     conn_tracker->IterationPostTick();
+    if (FLAGS_stirling_enable_endpoint_protocol_cache && !was_unparseable &&
+        conn_tracker->disabled_as_unparseable() && conn_tracker->role() == kRoleClient) {
+      endpoint_protocol_cache_.ReportUnparseable(conn_tracker->conn_id().upid,
+                                                 conn_tracker->remote_endpoint());
+    }
+  }
+
+  if (FLAGS_stirling_socket_tracer_memory_budget_bytes > 0) {
+    stats_.Increment(StatKey::kMemoryEvictedConns,
+                     conn_trackers_mgr_.EnforceMemoryBudget(
+                         FLAGS_stirling_socket_tracer_memory_budget_bytes));
   }
 
   // Once we've cleared all the debug trace levels for this pid, we can remove it from the list.
@@ -451,6 +684,27 @@ Status SocketTraceConnector::UpdateBPFProtocolTraceRole(traffic_protocol_t proto
   return UpdatePerCPUArrayValue(static_cast<int>(protocol), role_mask, &control_map_handle);
 }
 
+void SocketTraceConnector::SetOverloadLevelImpl(OverloadLevel level) {
+  const bool no_body_capture = level >= OverloadLevel::kNoBodyCapture;
+  for (int i = 0; i < kNumProtocols; ++i) {
+    uint64_t capture_size = capture_sizes_[i];
+    if (no_body_capture && (capture_size == 0 || capture_size > kOverloadCaptureSizeBytes)) {
+      capture_size = kOverloadCaptureSizeBytes;
+    }
+    auto protocol = static_cast<traffic_protocol_t>(i);
+    Status s = UpdateBPFProtocolCaptureSize(protocol, capture_size);
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to set the capture size of $0: $1",
+                                                 magic_enum::enum_name(protocol), s.msg());
+  }
+}
+
+Status SocketTraceConnector::UpdateBPFProtocolCaptureSize(traffic_protocol_t protocol,
+                                                          uint64_t capture_size_bytes) {
+  auto capture_size_map_handle = GetPerCPUArrayTable<uint64_t>(kCaptureSizeMapName);
+  return UpdatePerCPUArrayValue(static_cast<int>(protocol), capture_size_bytes,
+                                &capture_size_map_handle);
+}
+
 Status SocketTraceConnector::TestOnlySetTargetPID(int64_t pid) {
   auto control_map_handle = GetPerCPUArrayTable<int64_t>(kControlValuesArrayName);
   return UpdatePerCPUArrayValue(kTargetTGIDIndex, pid, &control_map_handle);
@@ -462,6 +716,16 @@ Status SocketTraceConnector::DisableSelfTracing() {
   return UpdatePerCPUArrayValue(kStirlingTGIDIndex, self_pid, &control_map_handle);
 }
 
+Status SocketTraceConnector::EnableConnStatsPolling() {
+  auto control_map_handle = GetPerCPUArrayTable<int64_t>(kControlValuesArrayName);
+  return UpdatePerCPUArrayValue(kConnStatsPollingIndex, int64_t{1}, &control_map_handle);
+}
+
+Status SocketTraceConnector::EnableTracedTGIDsFilter() {
+  auto control_map_handle = GetPerCPUArrayTable<int64_t>(kControlValuesArrayName);
+  return UpdatePerCPUArrayValue(kTracedTGIDsFilterIndex, int64_t{1}, &control_map_handle);
+}
+
 //-----------------------------------------------------------------------------
 // Perf Buffer Polling and Callback functions.
 //-----------------------------------------------------------------------------
@@ -469,14 +733,21 @@ Status SocketTraceConnector::DisableSelfTracing() {
 void SocketTraceConnector::HandleDataEvent(void* cb_cookie, void* data, int /*data_size*/) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
   auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
-  auto data_event_ptr = std::make_unique<SocketDataEvent>(data);
-  connector->AcceptDataEvent(std::move(data_event_ptr));
+  // The msg is copied only once, from the perf buffer into the connection's DataStreamBuffer.
+  SocketDataEventView event(data);
+  if (event.ViewableInPlace()) {
+    connector->AcceptDataEvent(event);
+    return;
+  }
+  SocketDataEvent event_copy(data);
+  connector->AcceptDataEvent(SocketDataEventView(event_copy));
 }
 
 void SocketTraceConnector::HandleDataEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossSocketDataEvent,
-                                                                  lost);
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  connector->stats_.Increment(StatKey::kLossSocketDataEvent, lost);
+  connector->RecordSamplingLoss(lost);
 }
 
 void SocketTraceConnector::HandleControlEvent(void* cb_cookie, void* data, int /*data_size*/) {
@@ -487,8 +758,9 @@ void SocketTraceConnector::HandleControlEvent(void* cb_cookie, void* data, int /
 
 void SocketTraceConnector::HandleControlEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossSocketControlEvent,
-                                                                  lost);
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  connector->stats_.Increment(StatKey::kLossSocketControlEvent, lost);
+  connector->RecordSamplingLoss(lost);
 }
 
 void SocketTraceConnector::HandleConnStatsEvent(void* cb_cookie, void* data, int /*data_size*/) {
@@ -499,8 +771,9 @@ void SocketTraceConnector::HandleConnStatsEvent(void* cb_cookie, void* data, int
 
 void SocketTraceConnector::HandleConnStatsEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossConnStatsEvent,
-                                                                  lost);
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  connector->stats_.Increment(StatKey::kLossConnStatsEvent, lost);
+  connector->RecordSamplingLoss(lost);
 }
 
 void SocketTraceConnector::HandleMMapEvent(void* cb_cookie, void* data, int /*data_size*/) {
@@ -511,7 +784,9 @@ void SocketTraceConnector::HandleMMapEvent(void* cb_cookie, void* data, int /*da
 
 void SocketTraceConnector::HandleMMapEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossMMapEvent, lost);
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  connector->stats_.Increment(StatKey::kLossMMapEvent, lost);
+  connector->RecordSamplingLoss(lost);
 }
 
 void SocketTraceConnector::HandleHTTP2HeaderEvent(void* cb_cookie, void* data, int /*data_size*/) {
@@ -519,20 +794,21 @@ void SocketTraceConnector::HandleHTTP2HeaderEvent(void* cb_cookie, void* data, i
 
   auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
 
-  auto event = std::make_unique<HTTP2HeaderEvent>(data);
+  HTTP2HeaderEvent event(data);
 
   VLOG(3) << absl::Substitute(
       "t=$0 pid=$1 type=$2 fd=$3 tsid=$4 stream_id=$5 end_stream=$6 name=$7 value=$8",
-      event->attr.timestamp_ns, event->attr.conn_id.upid.pid,
-      magic_enum::enum_name(event->attr.type), event->attr.conn_id.fd, event->attr.conn_id.tsid,
-      event->attr.stream_id, event->attr.end_stream, event->name, event->value);
+      event.attr.timestamp_ns, event.attr.conn_id.upid.pid, magic_enum::enum_name(event.attr.type),
+      event.attr.conn_id.fd, event.attr.conn_id.tsid, event.attr.stream_id, event.attr.end_stream,
+      event.name, event.value);
   connector->AcceptHTTP2Header(std::move(event));
 }
 
 void SocketTraceConnector::HandleHTTP2HeaderEventLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossGoGRPCHeaderEvent,
-                                                                  lost);
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  connector->stats_.Increment(StatKey::kLossGoGRPCHeaderEvent, lost);
+  connector->RecordSamplingLoss(lost);
 }
 
 void SocketTraceConnector::HandleHTTP2Data(void* cb_cookie, void* data, int /*data_size*/) {
@@ -541,19 +817,23 @@ void SocketTraceConnector::HandleHTTP2Data(void* cb_cookie, void* data, int /*da
   auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
   // Directly access data through a go_grpc_data_event_t pointer results in mis-aligned access.
   // go_grpc_data_event_t is 8-bytes aligned, data is 4-bytes.
-  auto event = std::make_unique<HTTP2DataEvent>(data);
+  HTTP2DataEvent& event = connector->http2_data_event_;
+  event.Assign(data);
 
   VLOG(3) << absl::Substitute(
       "t=$0 pid=$1 type=$2 fd=$3 tsid=$4 stream_id=$5 end_stream=$6 data=$7",
-      event->attr.timestamp_ns, event->attr.conn_id.upid.pid,
-      magic_enum::enum_name(event->attr.type), event->attr.conn_id.fd, event->attr.conn_id.tsid,
-      event->attr.stream_id, event->attr.end_stream, event->payload);
+      event.attr.timestamp_ns, event.attr.conn_id.upid.pid, magic_enum::enum_name(event.attr.type),
+      event.attr.conn_id.fd, event.attr.conn_id.tsid, event.attr.stream_id, event.attr.end_stream,
+      event.payload);
+  // The tracker copies the payload, so the event keeps its buffer for the next one.
   connector->AcceptHTTP2Data(std::move(event));
 }
 
 void SocketTraceConnector::HandleHTTP2DataLoss(void* cb_cookie, uint64_t lost) {
   DCHECK(cb_cookie != nullptr) << "Perf buffer callback not set-up properly. Missing cb_cookie.";
-  static_cast<SocketTraceConnector*>(cb_cookie)->stats_.Increment(StatKey::kLossHTTP2Data, lost);
+  auto* connector = static_cast<SocketTraceConnector*>(cb_cookie);
+  connector->stats_.Increment(StatKey::kLossHTTP2Data, lost);
+  connector->RecordSamplingLoss(lost);
 }
 
 //-----------------------------------------------------------------------------
@@ -567,15 +847,19 @@ ConnTracker& SocketTraceConnector::GetOrCreateConnTracker(struct conn_id_t conn_
   return tracker;
 }
 
-void SocketTraceConnector::AcceptDataEvent(std::unique_ptr<SocketDataEvent> event) {
-  event->attr.timestamp_ns += ClockRealTimeOffset();
+void SocketTraceConnector::AcceptDataEvent(SocketDataEventView event) {
+  event.attr.timestamp_ns += ClockRealTimeOffset();
+
+  const SocketTracerProtocolMetrics& metrics = GetSocketTracerProtocolMetrics(event.attr.protocol);
+  metrics.data_events->Add();
+  metrics.data_bytes->Add(event.attr.msg_size);
 
   if (perf_buffer_events_output_stream_ != nullptr) {
-    WriteDataEvent(*event);
+    WriteDataEvent(event);
   }
 
-  ConnTracker& tracker = GetOrCreateConnTracker(event->attr.conn_id);
-  tracker.AddDataEvent(std::move(event));
+  ConnTracker& tracker = GetOrCreateConnTracker(event.attr.conn_id);
+  tracker.AddDataEvent(event);
 }
 
 void SocketTraceConnector::AcceptControlEvent(socket_control_event_t event) {
@@ -584,6 +868,31 @@ void SocketTraceConnector::AcceptControlEvent(socket_control_event_t event) {
 
   ConnTracker& tracker = GetOrCreateConnTracker(event.conn_id);
   tracker.AddControlEvent(event);
+  if (FLAGS_stirling_enable_endpoint_protocol_cache && event.type == kConnOpen) {
+    SeedFromEndpointProtocolCache(&tracker);
+  }
+}
+
+void SocketTraceConnector::SeedFromEndpointProtocolCache(ConnTracker* tracker) {
+  if (tracker->role() != kRoleClient || tracker->protocol() != kProtocolUnknown ||
+      tracker->state() == ConnTracker::State::kDisabled) {
+    return;
+  }
+  const EndpointProtocolCache::Entry* entry =
+      endpoint_protocol_cache_.Find(tracker->conn_id().upid, tracker->remote_endpoint());
+  if (entry == nullptr) {
+    return;
+  }
+  if (entry->uninteresting()) {
+    tracker->Disable("Earlier connections to the server were unparseable.");
+    stats_.Increment(StatKey::kUninterestingConns);
+    return;
+  }
+  if (entry->protocol != kProtocolUnknown) {
+    // Data events that BPF infers as another protocol are then ignored by the tracker.
+    tracker->SetProtocol(entry->protocol, "confirmed by earlier connections to the server");
+    stats_.Increment(StatKey::kSeededConns);
+  }
 }
 
 void SocketTraceConnector::AcceptConnStatsEvent(conn_stats_event_t event) {
@@ -593,18 +902,49 @@ void SocketTraceConnector::AcceptConnStatsEvent(conn_stats_event_t event) {
   tracker.AddConnStats(event);
 }
 
-void SocketTraceConnector::AcceptHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> event) {
-  event->attr.timestamp_ns += ClockRealTimeOffset();
+void SocketTraceConnector::PollConnStats() {
+  if (conn_info_map_mgr_ == nullptr) {
+    return;
+  }
+
+  // Same clock as the timestamps of BPF events.
+  const uint64_t timestamp_ns = AdjustedSteadyClockNowNS() + ClockRealTimeOffset();
+
+  for (const auto& [tgid_fd, conn_info] : conn_info_map_mgr_->ConnInfos()) {
+    // Connections without traffic have no stats to report.
+    if (conn_info.wr_bytes == 0 && conn_info.rd_bytes == 0) {
+      continue;
+    }
+
+    ConnTracker& tracker = conn_trackers_mgr_.GetOrCreateConnTracker(conn_info.conn_id);
+    if (tracker.conn_stats().bytes_sent() == conn_info.wr_bytes &&
+        tracker.conn_stats().bytes_recv() == conn_info.rd_bytes) {
+      continue;
+    }
 
-  ConnTracker& tracker = GetOrCreateConnTracker(event->attr.conn_id);
+    conn_stats_event_t event = {};
+    event.timestamp_ns = timestamp_ns;
+    event.conn_id = conn_info.conn_id;
+    event.addr = conn_info.addr;
+    event.role = conn_info.role;
+    event.wr_bytes = conn_info.wr_bytes;
+    event.rd_bytes = conn_info.rd_bytes;
+    tracker.AddConnStats(event);
+  }
+}
+
+void SocketTraceConnector::AcceptHTTP2Header(HTTP2HeaderEvent&& event) {
+  event.attr.timestamp_ns += ClockRealTimeOffset();
+
+  ConnTracker& tracker = GetOrCreateConnTracker(event.attr.conn_id);
   tracker.AddHTTP2Header(std::move(event));
 }
 
-void SocketTraceConnector::AcceptHTTP2Data(std::unique_ptr<HTTP2DataEvent> event) {
-  event->attr.timestamp_ns += ClockRealTimeOffset();
+void SocketTraceConnector::AcceptHTTP2Data(HTTP2DataEvent&& event) {
+  event.attr.timestamp_ns += ClockRealTimeOffset();
 
-  ConnTracker& tracker = GetOrCreateConnTracker(event->attr.conn_id);
-  tracker.AddHTTP2Data(std::move(event));
+  ConnTracker& tracker = GetOrCreateConnTracker(event.attr.conn_id);
+  tracker.AddHTTP2Data(event);
 }
 
 //-----------------------------------------------------------------------------
@@ -628,13 +968,14 @@ int64_t CalculateLatency(int64_t req_timestamp_ns, int64_t resp_timestamp_ns) {
 
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                                         protocols::http::Record record, DataTable* data_table) {
+                                         protocols::http::Record record, DataTable* data_table,
+                                         double sample_rate) {
   protocols::http::Message& req_message = record.req;
   protocols::http::Message& resp_message = record.resp;
 
   // Currently decompresses gzip content, but could handle other transformations too.
   // Note that we do this after filtering to avoid burning CPU cycles unnecessarily.
-  protocols::http::PreProcessMessage(&resp_message);
+  size_t resp_body_size = protocols::http::PreProcessMessage(&resp_message, kMaxBodyBytes);
 
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
                 conn_tracker.conn_id().upid.start_time_ticks);
@@ -663,10 +1004,11 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp_headers"), kMaxHTTPHeadersBytes>(ToJSONString(resp_message.headers));
   r.Append<r.ColIndex("resp_status")>(resp_message.resp_status);
   r.Append<r.ColIndex("resp_message")>(std::move(resp_message.resp_message));
-  r.Append<r.ColIndex("resp_body_size")>(resp_message.body.size());
+  r.Append<r.ColIndex("resp_body_size")>(resp_body_size);
   r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(resp_message.body));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(req_message.timestamp_ns, resp_message.timestamp_ns));
+  r.Append<r.ColIndex("sample_rate")>(sample_rate);
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -674,7 +1016,8 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                                         protocols::http2::Record record, DataTable* data_table) {
+                                         protocols::http2::Record record, DataTable* data_table,
+                                         double sample_rate) {
   using ::px::grpc::MethodInputOutput;
   using ::px::stirling::grpc::ParsePB;
 
@@ -709,11 +1052,17 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   size_t resp_data_size = resp_stream->original_data_size();
   if (record.HasGRPCContentType()) {
     content_type = HTTPContentType::kGRPC;
-    req_data = ParsePB(req_data, kMaxPBStringLen);
+    if (FLAGS_stirling_http2_raw_grpc_bodies) {
+      // Parsing is deferred to query time. The bodies are already capped by the data size limit.
+      req_data = absl::Base64Escape(req_data);
+      resp_data = absl::Base64Escape(resp_data);
+    } else {
+      req_data = ParsePB(req_data, kMaxPBStringLen);
+      resp_data = ParsePB(resp_data, kMaxPBStringLen);
+    }
     if (req_stream->data_truncated()) {
       req_data.append(DataTable::kTruncatedMsg);
     }
-    resp_data = ParsePB(resp_data, kMaxPBStringLen);
     if (resp_stream->data_truncated()) {
       resp_data.append(DataTable::kTruncatedMsg);
     }
@@ -746,6 +1095,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp_body")>(std::move(resp_data));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(req_stream->timestamp_ns, resp_stream->timestamp_ns));
+  r.Append<r.ColIndex("sample_rate")>(sample_rate);
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -753,7 +1103,8 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                                         protocols::mysql::Record entry, DataTable* data_table) {
+                                         protocols::mysql::Record entry, DataTable* data_table,
+                                         double sample_rate) {
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
                 conn_tracker.conn_id().upid.start_time_ticks);
 
@@ -769,6 +1120,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(entry.resp.msg));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_rate")>(sample_rate);
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -776,7 +1128,8 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                                         protocols::cass::Record entry, DataTable* data_table) {
+                                         protocols::cass::Record entry, DataTable* data_table,
+                                         double sample_rate) {
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
                 conn_tracker.conn_id().upid.start_time_ticks);
 
@@ -792,6 +1145,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp_body"), kMaxBodyBytes>(std::move(entry.resp.msg));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_rate")>(sample_rate);
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -799,7 +1153,8 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                                         protocols::dns::Record entry, DataTable* data_table) {
+                                         protocols::dns::Record entry, DataTable* data_table,
+                                         double sample_rate) {
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
                 conn_tracker.conn_id().upid.start_time_ticks);
 
@@ -815,6 +1170,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp_body")>(entry.resp.msg);
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_rate")>(sample_rate);
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -822,7 +1178,8 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                                         protocols::pgsql::Record entry, DataTable* data_table) {
+                                         protocols::pgsql::Record entry, DataTable* data_table,
+                                         double sample_rate) {
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
                 conn_tracker.conn_id().upid.start_time_ticks);
 
@@ -837,6 +1194,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
   r.Append<r.ColIndex("req_cmd")>(ToString(entry.req.tag, /* is_req */ true));
+  r.Append<r.ColIndex("sample_rate")>(sample_rate);
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -861,7 +1219,8 @@ endpoint_role_t Swapendpoint_role_t(endpoint_role_t role) {
 
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                                         protocols::redis::Record entry, DataTable* data_table) {
+                                         protocols::redis::Record entry, DataTable* data_table,
+                                         double sample_rate) {
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
                 conn_tracker.conn_id().upid.start_time_ticks);
 
@@ -881,6 +1240,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp")>(std::string(entry.resp.payload));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(entry.req.timestamp_ns, entry.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_rate")>(sample_rate);
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -888,7 +1248,8 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                                         protocols::nats::Record record, DataTable* data_table) {
+                                         protocols::nats::Record record, DataTable* data_table,
+                                         double sample_rate) {
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
                 conn_tracker.conn_id().upid.start_time_ticks);
 
@@ -902,6 +1263,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("cmd")>(record.req.command);
   r.Append<r.ColIndex("body")>(record.req.options);
   r.Append<r.ColIndex("resp")>(record.resp.command);
+  r.Append<r.ColIndex("sample_rate")>(sample_rate);
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -909,7 +1271,8 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
 
 template <>
 void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                                         protocols::kafka::Record record, DataTable* data_table) {
+                                         protocols::kafka::Record record, DataTable* data_table,
+                                         double sample_rate) {
   constexpr size_t kMaxKafkaBodyBytes = 65536;
 
   md::UPID upid(ctx->GetASID(), conn_tracker.conn_id().upid.pid,
@@ -928,6 +1291,7 @@ void SocketTraceConnector::AppendMessage(ConnectorContext* ctx, const ConnTracke
   r.Append<r.ColIndex("resp"), kMaxKafkaBodyBytes>(std::move(record.resp.msg));
   r.Append<r.ColIndex("latency")>(
       CalculateLatency(record.req.timestamp_ns, record.resp.timestamp_ns));
+  r.Append<r.ColIndex("sample_rate")>(sample_rate);
 #ifndef NDEBUG
   r.Append<r.ColIndex("px_info_")>(ToString(conn_tracker.conn_id()));
 #endif
@@ -948,7 +1312,7 @@ void SocketTraceConnector::SetupOutput(const std::filesystem::path& path) {
 }
 
 namespace {
-void SocketDataEventToPB(const SocketDataEvent& event, sockeventpb::SocketDataEvent* pb) {
+void SocketDataEventToPB(const SocketDataEventView& event, sockeventpb::SocketDataEvent* pb) {
   pb->mutable_attr()->set_timestamp_ns(event.attr.timestamp_ns);
   pb->mutable_attr()->mutable_conn_id()->set_pid(event.attr.conn_id.upid.pid);
   pb->mutable_attr()->mutable_conn_id()->set_start_time_ns(
@@ -960,11 +1324,11 @@ void SocketDataEventToPB(const SocketDataEvent& event, sockeventpb::SocketDataEv
   pb->mutable_attr()->set_direction(event.attr.direction);
   pb->mutable_attr()->set_pos(event.attr.pos);
   pb->mutable_attr()->set_msg_size(event.attr.msg_size);
-  pb->set_msg(event.msg);
+  pb->set_msg(std::string(event.msg));
 }
 }  // namespace
 
-void SocketTraceConnector::WriteDataEvent(const SocketDataEvent& event) {
+void SocketTraceConnector::WriteDataEvent(const SocketDataEventView& event) {
   using ::google::protobuf::TextFormat;
   using ::google::protobuf::util::SerializeDelimitedToOstream;
 
@@ -992,23 +1356,158 @@ void SocketTraceConnector::WriteDataEvent(const SocketDataEvent& event) {
 // TransferData Helpers
 //-----------------------------------------------------------------------------
 
+namespace {
+
+// Returns the fraction of records like this one that are kept in their table, or 0 if this record
+// is not kept. Only successful HTTP requests are sampled, and only when the RED metrics count them.
+template <typename TRecordType>
+double SuccessSampleRate(const ConnTracker& /*tracker*/, const TRecordType& /*record*/) {
+  return 1.0;
+}
+
+double SuccessSampleRate(const ConnTracker& tracker, const protocols::http::Record& record) {
+  const double rate = FLAGS_stirling_http_events_success_sample_rate;
+  if (!FLAGS_stirling_enable_http_red_metrics || rate >= 1.0 || record.resp.resp_status >= 400) {
+    return 1.0;
+  }
+  // Deterministic, so that replays of the same data keep the same records.
+  constexpr uint64_t kScale = 1 << 20;
+  uint64_t h = absl::Hash<std::tuple<conn_id_t, uint64_t>>()(
+      std::make_tuple(tracker.conn_id(), record.resp.timestamp_ns));
+  return h % kScale < rate * kScale ? rate : 0;
+}
+
+template <typename TRecordType>
+void AggregateREDMetrics(const ConnTracker& /*tracker*/, const TRecordType& /*record*/,
+                         HTTPREDMetrics* /*metrics*/) {}
+
+void AggregateREDMetrics(const ConnTracker& tracker, const protocols::http::Record& record,
+                         HTTPREDMetrics* metrics) {
+  metrics->Record(tracker.conn_id().upid, tracker.remote_endpoint().AddrStr(),
+                  tracker.remote_endpoint().port(), tracker.role(), record);
+}
+
+}  // namespace
+
 template <typename TProtocolTraits>
-void SocketTraceConnector::TransferStream(ConnectorContext* ctx, ConnTracker* tracker,
-                                          DataTable* data_table) {
+class SocketTraceConnector::TypedParsedRecords : public SocketTraceConnector::ParsedRecords {
+ public:
+  TypedParsedRecords(const ConnTracker* tracker,
+                     std::vector<typename TProtocolTraits::record_type> records)
+      : tracker_(tracker), records_(std::move(records)) {}
+
+  size_t size() const override { return records_.size(); }
+
+  void Append(ConnectorContext* ctx, DataTable* data_table, IngestSampler* sampler,
+              const IngestSampler::RecordKey& key) override {
+    for (auto& record : records_) {
+      double success_sample_rate = SuccessSampleRate(*tracker_, record);
+      if (success_sample_rate == 0) {
+        continue;
+      }
+      double sample_rate = sampler->Admit(key);
+      if (sample_rate > 0) {
+        AppendMessage(ctx, *tracker_, std::move(record), data_table,
+                      sample_rate * success_sample_rate);
+      }
+    }
+  }
+
+  void AggregateREDMetrics(HTTPREDMetrics* metrics) const override {
+    for (const auto& record : records_) {
+      ::px::stirling::AggregateREDMetrics(*tracker_, record, metrics);
+    }
+  }
+
+ private:
+  const ConnTracker* tracker_;
+  std::vector<typename TProtocolTraits::record_type> records_;
+};
+
+template <typename TProtocolTraits>
+std::unique_ptr<SocketTraceConnector::ParsedRecords> SocketTraceConnector::TransferStream(
+    ConnTracker* tracker) {
   VLOG(3) << absl::StrCat("Connection\n", DebugString<TProtocolTraits>(*tracker, ""));
 
-  if (tracker->state() == ConnTracker::State::kTransferring) {
-    // ProcessToRecords() parses raw events and produces messages in format that are expected by
-    // table store. But those messages are not cached inside ConnTracker.
-    auto records = tracker->ProcessToRecords<TProtocolTraits>();
-    for (auto& record : records) {
-      AppendMessage(ctx, *tracker, std::move(record), data_table);
+  if (tracker->state() != ConnTracker::State::kTransferring) {
+    return nullptr;
+  }
+
+  // ProcessToRecords() parses raw events and produces messages in format that are expected by
+  // table store. But those messages are not cached inside ConnTracker.
+  auto records = tracker->ProcessToRecords<TProtocolTraits>();
+
+  auto expiry_timestamp =
+      iteration_time_ - std::chrono::seconds(FLAGS_messages_expiration_duration_secs);
+  tracker->Cleanup<TProtocolTraits>(FLAGS_messages_size_limit_bytes, expiry_timestamp);
+
+  if (records.empty()) {
+    return nullptr;
+  }
+  return std::make_unique<TypedParsedRecords<TProtocolTraits>>(tracker, std::move(records));
+}
+
+void SocketTraceConnector::ParseConnTrackers(ConnectorContext* ctx,
+                                             const std::vector<ConnTracker*>& trackers,
+                                             const std::vector<DataTable*>& data_tables) {
+  // Each tracker's records go into its own slot, so the workers don't need to synchronize, and
+  // the records are appended in the same order as a serial transfer would produce.
+  std::vector<std::unique_ptr<ParsedRecords>> parsed(trackers.size());
+
+  // Trackers are partitioned by conn_id. There are a few shards per worker, so that workers that
+  // get lighter shards pick up the remaining ones.
+  constexpr int kShardsPerWorker = 4;
+  ThreadPool* pool = ThreadPool::Shared();
+  // The calling thread is one of the workers.
+  const int num_workers =
+      std::max(1, std::min(FLAGS_stirling_socket_tracer_parse_threads, pool->num_threads() + 1));
+  const size_t num_shards = num_workers == 1 ? 1 : num_workers * kShardsPerWorker;
+  std::vector<std::vector<size_t>> shards(num_shards);
+  for (size_t i = 0; i < trackers.size(); ++i) {
+    shards[absl::Hash<conn_id_t>()(trackers[i]->conn_id()) % num_shards].push_back(i);
+  }
+
+  pool->ParallelFor(num_shards, num_workers, [&](int64_t shard_idx, int /*worker_idx*/) {
+    for (size_t i : shards[shard_idx]) {
+      ConnTracker* tracker = trackers[i];
+      const auto& transfer_spec = protocol_transfer_specs_[tracker->protocol()];
+      parsed[i] = transfer_spec.transfer_fn(*this, tracker);
     }
+  });
+
+  auto record_key = [this](const ConnTracker& tracker) {
+    return IngestSampler::RecordKey{tracker.protocol(), tracker.conn_id().upid,
+                                    protocol_transfer_specs_[tracker.protocol()].table_num};
+  };
+
+  // All records of the iteration are offered first, so that the rate limits are shared evenly by
+  // the connections, rather than going to whichever connections are appended first.
+  ingest_sampler_.BeginIteration(iteration_time_);
+  for (size_t i = 0; i < trackers.size(); ++i) {
+    if (parsed[i] != nullptr) {
+      ingest_sampler_.Offer(record_key(*trackers[i]), parsed[i]->size());
+    }
+  }
 
-    auto expiry_timestamp =
-        iteration_time_ - std::chrono::seconds(FLAGS_messages_expiration_duration_secs);
-    tracker->Cleanup<TProtocolTraits>(FLAGS_messages_size_limit_bytes, expiry_timestamp);
+  const int64_t num_dropped = ingest_sampler_.num_dropped_records();
+  utils::ScopedTimer append_timer(data_table_append_time_ns_);
+  const bool aggregate_red_metrics = FLAGS_stirling_enable_http_red_metrics &&
+                                     data_tables[kHTTPREDMetricsTableNum] != nullptr;
+  for (size_t i = 0; i < trackers.size(); ++i) {
+    if (parsed[i] != nullptr) {
+      if (aggregate_red_metrics) {
+        parsed[i]->AggregateREDMetrics(&http_red_metrics_);
+      }
+      if (FLAGS_stirling_enable_endpoint_protocol_cache && trackers[i]->role() == kRoleClient) {
+        endpoint_protocol_cache_.Confirm(trackers[i]->conn_id().upid,
+                                         trackers[i]->remote_endpoint(), trackers[i]->protocol());
+      }
+      IngestSampler::RecordKey key = record_key(*trackers[i]);
+      parsed[i]->Append(ctx, data_tables[key.table_num], &ingest_sampler_, key);
+    }
   }
+  stats_.Increment(StatKey::kRateLimitedRecords,
+                   ingest_sampler_.num_dropped_records() - num_dropped);
 }
 
 void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* data_table) {
@@ -1073,5 +1572,34 @@ void SocketTraceConnector::TransferConnStats(ConnectorContext* ctx, DataTable* d
   }
 }
 
+void SocketTraceConnector::TransferHTTPREDMetrics(ConnectorContext* ctx, DataTable* data_table) {
+  namespace idx = ::px::stirling::http_red_metrics_idx;
+
+  uint64_t time = CurrentTimeNS();
+  for (const auto& [key, latencies] : http_red_metrics_.metrics()) {
+    md::UPID upid(ctx->GetASID(), key.upid.pid, key.upid.start_time_ticks);
+
+    DataTable::RecordBuilder<&kHTTPREDMetricsTable> r(data_table, time);
+    r.Append<idx::kTime>(time);
+    r.Append<idx::kUPID>(upid.value());
+    r.Append<idx::kRemoteAddr>(key.remote_addr);
+    r.Append<idx::kRemotePort>(key.remote_port);
+    r.Append<idx::kRole>(key.role);
+    r.Append<idx::kReqMethod>(key.req_method);
+    r.Append<idx::kReqPath>(key.req_path);
+    r.Append<idx::kRespStatusClass>(key.resp_status_class);
+    r.Append<idx::kNumRequests>(latencies.count());
+    r.Append<idx::kLatencyP50>(latencies.Quantile(0.5));
+    r.Append<idx::kLatencyP90>(latencies.Quantile(0.9));
+    r.Append<idx::kLatencyP99>(latencies.Quantile(0.99));
+    r.Append<idx::kLatencyMax>(latencies.max());
+    r.Append<idx::kLatencySum>(latencies.sum());
+#ifndef NDEBUG
+    r.Append<idx::kPxInfo>("");
+#endif
+  }
+  http_red_metrics_.Clear();
+}
+
 }  // namespace stirling
 }  // namespace px
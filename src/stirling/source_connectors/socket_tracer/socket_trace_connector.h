@@ -18,18 +18,22 @@
 
 #pragma once
 
+#include <array>
 #include <fstream>
 #include <list>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 #include <absl/synchronization/mutex.h>
 
+#include "src/common/base/thread_pool.h"
 #include "src/common/grpcutils/service_descriptor_database.h"
 #include "src/common/system/socket_info.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
@@ -41,17 +45,26 @@
 #include "src/stirling/source_connectors/socket_tracer/conn_stats.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_tracker.h"
 #include "src/stirling/source_connectors/socket_tracer/conn_trackers_manager.h"
+#include "src/stirling/source_connectors/socket_tracer/endpoint_protocol_cache.h"
+#include "src/stirling/source_connectors/socket_tracer/http_red_metrics.h"
+#include "src/stirling/source_connectors/socket_tracer/ingest_sampler.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_bpf_tables.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_tables.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_tracer_metrics.h"
 #include "src/stirling/source_connectors/socket_tracer/uprobe_manager.h"
 #include "src/stirling/utils/proc_path_tools.h"
 #include "src/stirling/utils/proc_tracker.h"
 
 DECLARE_uint32(stirling_conn_stats_sampling_ratio);
+DECLARE_bool(stirling_conn_stats_bpf_polling);
 DECLARE_bool(stirling_enable_periodic_bpf_map_cleanup);
 DECLARE_string(perf_buffer_events_output_path);
+DECLARE_bool(stirling_socket_tracer_enable_ring_buffers);
+DECLARE_string(stirling_socket_tracer_capture_size_bytes);
+DECLARE_int32(stirling_socket_tracer_parse_threads);
 DECLARE_bool(stirling_enable_http_tracing);
 DECLARE_bool(stirling_enable_http2_tracing);
+DECLARE_bool(stirling_http2_raw_grpc_bodies);
 DECLARE_bool(stirling_enable_mysql_tracing);
 DECLARE_bool(stirling_enable_cass_tracing);
 DECLARE_bool(stirling_enable_dns_tracing);
@@ -59,10 +72,13 @@ DECLARE_bool(stirling_enable_redis_tracing);
 DECLARE_bool(stirling_enable_nats_tracing);
 DECLARE_bool(stirling_enable_kafka_tracing);
 DECLARE_bool(stirling_disable_self_tracing);
+DECLARE_string(stirling_socket_tracer_namespaces);
 DECLARE_string(stirling_role_to_trace);
 
+DECLARE_uint32(stirling_conn_inference_max_per_iteration);
 DECLARE_uint32(messages_expiration_duration_secs);
 DECLARE_uint32(messages_size_limit_bytes);
+DECLARE_uint64(stirling_socket_tracer_memory_budget_bytes);
 
 namespace px {
 namespace stirling {
@@ -72,7 +88,7 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr std::string_view kName = "socket_tracer";
   static constexpr auto kTables =
       MakeArray(kConnStatsTable, kHTTPTable, kMySQLTable, kCQLTable, kPGSQLTable, kDNSTable,
-                kRedisTable, kNATSTable, kKafkaTable);
+                kRedisTable, kNATSTable, kKafkaTable, kHTTPREDMetricsTable);
 
   static constexpr uint32_t kConnStatsTableNum = TableNum(kTables, kConnStatsTable);
   static constexpr uint32_t kHTTPTableNum = TableNum(kTables, kHTTPTable);
@@ -83,17 +99,26 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   static constexpr uint32_t kRedisTableNum = TableNum(kTables, kRedisTable);
   static constexpr uint32_t kNATSTableNum = TableNum(kTables, kNATSTable);
   static constexpr uint32_t kKafkaTableNum = TableNum(kTables, kKafkaTable);
+  static constexpr uint32_t kHTTPREDMetricsTableNum = TableNum(kTables, kHTTPREDMetricsTable);
 
   static constexpr auto kSamplingPeriod = std::chrono::milliseconds{200};
   // TODO(yzhao): This is not used right now. Eventually use this to control data push frequency.
   static constexpr auto kPushPeriod = std::chrono::milliseconds{1000};
+  // How often the aggregated HTTP RED metrics are flushed to the http_red_metrics table.
+  static constexpr auto kHTTPREDMetricsPeriod = std::chrono::seconds{10};
+
+  // The bytes of each data event that BPF copies to user-space from OverloadLevel::kNoBodyCapture
+  // on. Enough for the headers of most messages, while bodies are mostly dropped in the kernel.
+  static constexpr uint64_t kOverloadCaptureSizeBytes = 1024;
 
   static std::unique_ptr<SourceConnector> Create(std::string_view name) {
     return std::unique_ptr<SourceConnector>(new SocketTraceConnector(name));
   }
 
   Status InitImpl() override;
+  bool UsesBPF() const override { return true; }
   Status StopImpl() override;
+  void SetOverloadLevelImpl(OverloadLevel level) override;
   void InitContextImpl(ConnectorContext* ctx) override;
   void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
 
@@ -110,8 +135,15 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // Role_mask a bit mask, and represents the endpoint_role_t roles that are allowed to transfer
   // data from inside BPF to user-space.
   Status UpdateBPFProtocolTraceRole(traffic_protocol_t protocol, uint64_t role_mask);
+
+  // Updates the number of bytes of each data event of the protocol that BPF copies to user-space.
+  // The rest of each event is only reported through its size. 0 copies the whole event.
+  Status UpdateBPFProtocolCaptureSize(traffic_protocol_t protocol, uint64_t capture_size_bytes);
+
   Status TestOnlySetTargetPID(int64_t pid);
   Status DisableSelfTracing();
+  Status EnableConnStatsPolling();
+  Status EnableTracedTGIDsFilter();
 
   void DisablePIDTrace(int pid) override {
     SourceConnector::DisablePIDTrace(pid);
@@ -243,18 +275,54 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   ConnTracker& GetOrCreateConnTracker(struct conn_id_t conn_id);
 
   // Events from BPF.
-  void AcceptDataEvent(std::unique_ptr<SocketDataEvent> event);
+  void AcceptDataEvent(std::unique_ptr<SocketDataEvent> event) {
+    AcceptDataEvent(SocketDataEventView(*event));
+  }
+  void AcceptDataEvent(SocketDataEventView event);
   void AcceptControlEvent(socket_control_event_t event);
   void AcceptConnStatsEvent(conn_stats_event_t event);
-  void AcceptHTTP2Header(std::unique_ptr<HTTP2HeaderEvent> event);
-  void AcceptHTTP2Data(std::unique_ptr<HTTP2DataEvent> event);
+  void AcceptHTTP2Header(HTTP2HeaderEvent&& event);
+  void AcceptHTTP2Data(HTTP2DataEvent&& event);
 
   // Transfer of messages to the data table.
   void TransferStreams(ConnectorContext* ctx, uint32_t table_num, DataTable* data_table);
   void TransferConnStats(ConnectorContext* ctx, DataTable* data_table);
+  void TransferHTTPREDMetrics(ConnectorContext* ctx, DataTable* data_table);
+
+  // Updates the trackers' connection stats from the counts that BPF keeps in conn_info_map.
+  // Only used with --stirling_conn_stats_bpf_polling, which stops BPF from sending them as events.
+  void PollConnStats();
+
+  // With --stirling_enable_endpoint_protocol_cache, sets the protocol of a new client connection
+  // from the earlier connections to the same server, or disables it if the server is
+  // uninteresting.
+  void SeedFromEndpointProtocolCache(ConnTracker* tracker);
+
+  // The records parsed out of a ConnTracker, waiting to be appended to their data table.
+  class ParsedRecords {
+   public:
+    virtual ~ParsedRecords() = default;
+    virtual size_t size() const = 0;
+    // Appends the records that the sampler admits.
+    virtual void Append(ConnectorContext* ctx, DataTable* data_table, IngestSampler* sampler,
+                        const IngestSampler::RecordKey& key) = 0;
+    // Adds the records to the HTTP RED metrics. Only HTTP records are added.
+    virtual void AggregateREDMetrics(HTTPREDMetrics* /*metrics*/) const {}
+  };
+
+  template <typename TProtocolTraits>
+  class TypedParsedRecords;
 
+  // Parses the tracker's data into records. Only touches the tracker itself, so different
+  // trackers can be parsed concurrently. Returns nullptr if there is nothing to append.
   template <typename TProtocolTraits>
-  void TransferStream(ConnectorContext* ctx, ConnTracker* tracker, DataTable* data_table);
+  std::unique_ptr<ParsedRecords> TransferStream(ConnTracker* tracker);
+
+  // Runs the transfer_fn of each tracker, sharded by conn_id across ThreadPool::Shared(), then
+  // appends the resulting records that ingest_sampler_ admits to the data tables, in tracker
+  // order, on the calling thread.
+  void ParseConnTrackers(ConnectorContext* ctx, const std::vector<ConnTracker*>& trackers,
+                         const std::vector<DataTable*>& data_tables);
 
   void set_iteration_time(std::chrono::time_point<std::chrono::steady_clock> time) {
     DCHECK(time >= iteration_time_);
@@ -266,20 +334,33 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   template <typename TRecordType>
   static void AppendMessage(ConnectorContext* ctx, const ConnTracker& conn_tracker,
-                            TRecordType record, DataTable* data_table);
+                            TRecordType record, DataTable* data_table, double sample_rate);
 
-  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids);
+  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids,
+                                     uint64_t upids_version,
+                                     std::shared_ptr<const UPIDsDelta> upids_delta);
 
   // Setups output file stream object writing to the input file path.
   void SetupOutput(const std::filesystem::path& file);
 
   // Writes data event to the specified output file.
-  void WriteDataEvent(const SocketDataEvent& event);
+  void WriteDataEvent(const SocketDataEventView& event);
 
   ConnTrackersManager conn_trackers_mgr_;
 
+  // Holds the HTTP2 data event being handled. Reused across events, so that copying the payload
+  // out of the perf buffer does not allocate for every event.
+  HTTP2DataEvent http2_data_event_;
+
   ConnStats conn_stats_;
 
+  // Only used with --stirling_enable_endpoint_protocol_cache.
+  static constexpr size_t kEndpointProtocolCacheMaxEntries = 10000;
+  EndpointProtocolCache endpoint_protocol_cache_{kEndpointProtocolCacheMaxEntries};
+
+  // Only used with --stirling_enable_http_red_metrics.
+  HTTPREDMetrics http_red_metrics_{FLAGS_stirling_http_red_metrics_max_keys};
+
   absl::flat_hash_set<int> pids_to_trace_disable_;
 
   struct TransferSpec {
@@ -288,7 +369,7 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
     bool enabled = false;
     uint32_t table_num = 0;
     std::vector<endpoint_role_t> trace_roles;
-    std::function<void(SocketTraceConnector&, ConnectorContext*, ConnTracker*, DataTable*)>
+    std::function<std::unique_ptr<ParsedRecords>(SocketTraceConnector&, ConnTracker*)>
         transfer_fn = nullptr;
   };
 
@@ -297,6 +378,13 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
   // The transfer_fn defines which function is called to process the data for transfer.
   std::vector<TransferSpec> protocol_transfer_specs_;
 
+  // The capture size of each protocol from --stirling_socket_tracer_capture_size_bytes, which
+  // SetOverloadLevelImpl() restores once Stirling is no longer overloaded.
+  std::array<uint64_t, kNumProtocols> capture_sizes_ = {};
+
+  // Samples connections and rate limits the records written to the data tables.
+  IngestSampler ingest_sampler_;
+
   // The time at which TransferDataImpl() begin. Used as a universal timestamp for the iteration,
   // to avoid too many calls to std::chrono::steady_clock::now().
   std::chrono::time_point<std::chrono::steady_clock> iteration_time_;
@@ -317,11 +405,18 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
 
   // Portal to query for connections, by pid and inode.
   std::unique_ptr<system::SocketInfoManager> socket_info_mgr_;
+  // The position, among the trackers that need connection inference, of the first tracker whose
+  // turn it is. See --stirling_conn_inference_max_per_iteration.
+  size_t conn_inference_offset_ = 0;
 
   std::unique_ptr<system::ProcParser> proc_parser_;
 
   std::shared_ptr<ConnInfoMapManager> conn_info_map_mgr_;
 
+  // The K8s namespaces whose processes BPF traces; empty to trace all processes.
+  absl::flat_hash_set<std::string> traced_namespaces_;
+  std::unique_ptr<TracedTGIDsMapManager> traced_tgids_map_mgr_;
+
   UProbeManager uprobe_mgr_;
 
   enum class StatKey {
@@ -331,10 +426,37 @@ class SocketTraceConnector : public SourceConnector, public bpf_tools::BCCWrappe
     kLossMMapEvent,
     kLossGoGRPCHeaderEvent,
     kLossHTTP2Data,
+    // Connections that were disabled because they were not sampled.
+    kUnsampledConns,
+    // Records dropped by the ingest rate limits.
+    kRateLimitedRecords,
+    // Connection inferences that were put off to a later iteration, to stay within
+    // --stirling_conn_inference_max_per_iteration.
+    kDeferredConnInferences,
+    // Client connections whose protocol was set, or that were disabled, from the endpoint
+    // protocol cache.
+    kSeededConns,
+    kUninterestingConns,
+    // Connections whose data was dropped to stay within
+    // --stirling_socket_tracer_memory_budget_bytes.
+    kMemoryEvictedConns,
   };
 
   utils::StatCounter<StatKey> stats_;
 
+  // The time spent draining the perf buffers, and appending the parsed records to the data
+  // tables, per iteration. The per-protocol metrics are in GetSocketTracerProtocolMetrics().
+  utils::Histogram* const perf_buffer_poll_time_ns_ = utils::MetricsRegistry::Global().GetHistogram(
+      "stirling_socket_tracer_perf_buffer_poll_ns", "The time spent draining the perf buffers.");
+  utils::Histogram* const data_table_append_time_ns_ =
+      utils::MetricsRegistry::Global().GetHistogram(
+          "stirling_socket_tracer_data_table_append_ns",
+          "The time spent appending the parsed records to the data tables.");
+
+  // Replays recorded data events through the perf buffer callbacks, in
+  // socket_trace_replay_benchmark.
+  friend class SocketTraceReplayer;
+
   FRIEND_TEST(SocketTraceConnectorTest, AppendNonContiguousEvents);
   FRIEND_TEST(SocketTraceConnectorTest, NoEvents);
   FRIEND_TEST(SocketTraceConnectorTest, SortedByResponseTime);
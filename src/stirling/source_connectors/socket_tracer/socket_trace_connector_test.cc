@@ -258,6 +258,36 @@ TEST_F(SocketTraceConnectorTest, HTTPBasic) {
   EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), ElementsAre("foo"));
 }
 
+TEST_F(SocketTraceConnectorTest, ConnectionsParsedInParallel) {
+  FLAGS_stirling_socket_tracer_parse_threads = 4;
+  constexpr int kNumConns = 64;
+
+  std::vector<testing::EventGenerator> event_gens;
+  for (int i = 0; i < kNumConns; ++i) {
+    event_gens.emplace_back(&mock_clock_, kPID, kFD + i);
+  }
+  for (auto& event_gen : event_gens) {
+    source_->AcceptControlEvent(event_gen.InitConn());
+    source_->AcceptDataEvent(event_gen.InitSendEvent<kProtocolHTTP>(kReq0));
+    source_->AcceptDataEvent(event_gen.InitRecvEvent<kProtocolHTTP>(kJSONResp));
+    source_->AcceptControlEvent(event_gen.InitClose());
+  }
+
+  connector_->TransferData(ctx_.get(), data_tables_->tables());
+
+  std::vector<TaggedRecordBatch> tablets = http_table_->ConsumeRecords();
+  ASSERT_FALSE(tablets.empty());
+  RecordBatch record_batch = tablets[0].records;
+  EXPECT_THAT(record_batch, Each(ColWrapperSizeIs(kNumConns)));
+  EXPECT_THAT(ToStringVector(record_batch[kHTTPRespBodyIdx]), Each(std::string("foo")));
+
+  // Nothing is sampled out by default.
+  const auto& sample_rates = record_batch[kHTTPTable.ColIndex("sample_rate")];
+  for (size_t i = 0; i < sample_rates->Size(); ++i) {
+    EXPECT_EQ(sample_rates->Get<types::Float64Value>(i).val, 1.0);
+  }
+}
+
 TEST_F(SocketTraceConnectorTest, HTTPContentType) {
   testing::EventGenerator event_gen(&mock_clock_);
   struct socket_control_event_t conn = event_gen.InitConn();
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/strings/str_split.h>
+
+#ifdef TCMALLOC
+#include <gperftools/malloc_hook.h>
+#endif
+
+#include "src/common/base/base.h"
+#include "src/common/perf/elapsed_timer.h"
+#include "src/stirling/core/connector_context.h"
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
+#include "src/stirling/source_connectors/socket_tracer/data_event_capture.h"
+#include "src/stirling/source_connectors/socket_tracer/socket_trace_connector.h"
+#include "src/stirling/testing/common.h"
+
+// Replays captures of socket data events through the SocketTraceConnector, from the perf buffer
+// callback to the data tables, without BPF.
+DEFINE_string(replay_captures, "",
+              "Comma separated binary captures of socket data events, recorded by running "
+              "stirling with --perf_buffer_events_output_path=<path>.bin. If empty, synthetic "
+              "HTTP events are used.");
+DEFINE_uint32(replay_events_per_transfer, 1024,
+              "The number of events accepted before each TransferData(), like the events of one "
+              "drain of the perf buffers.");
+
+namespace px {
+namespace stirling {
+
+// Hands events to the SocketTraceConnector through the same callback as the perf buffer.
+class SocketTraceReplayer {
+ public:
+  SocketTraceReplayer() {
+    connector_ = SocketTraceConnector::Create("socket_trace_connector");
+    ctx_ = std::make_unique<StandaloneContext>();
+    PL_CHECK_OK(ctx_->SetClusterCIDR("1.2.3.4/32"));
+    data_tables_ = std::make_unique<testing::DataTables>(SocketTraceConnector::kTables);
+  }
+
+  void AcceptDataEvent(const RawDataEvent& event) {
+    // The callback does not modify the event.
+    SocketTraceConnector::HandleDataEvent(connector_.get(), const_cast<char*>(event.data()),
+                                          event.size());
+  }
+
+  void TransferData() { connector_->TransferData(ctx_.get(), data_tables_->tables()); }
+
+ private:
+  std::unique_ptr<SourceConnector> connector_;
+  std::unique_ptr<StandaloneContext> ctx_;
+  std::unique_ptr<testing::DataTables> data_tables_;
+};
+
+}  // namespace stirling
+}  // namespace px
+
+using px::stirling::RawDataEvent;
+using px::stirling::SocketTraceReplayer;
+
+namespace {
+
+// The heap allocations of all threads, including the parse threads of the connector.
+std::atomic<int64_t> num_allocs = 0;
+
+void InstallAllocCounter() {
+#ifdef TCMALLOC
+  static const bool kInstalled = MallocHook::AddNewHook(
+      [](const void* /*ptr*/, size_t /*size*/) { num_allocs.fetch_add(1); });
+  PL_UNUSED(kInstalled);
+#endif
+}
+
+std::vector<RawDataEvent> SyntheticEvents() {
+  constexpr int kNumConns = 16;
+  constexpr int kNumReqsPerConn = 256;
+  constexpr std::string_view kReq =
+      "GET /index.html HTTP/1.1\r\n"
+      "Host: www.pixielabs.ai\r\n"
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+      "\r\n";
+  constexpr std::string_view kResp =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: application/json; charset=utf-8\r\n"
+      "Content-Length: 5\r\n"
+      "\r\n"
+      "pixie";
+
+  std::vector<RawDataEvent> events;
+  std::vector<uint64_t> send_pos(kNumConns, 0);
+  std::vector<uint64_t> recv_pos(kNumConns, 0);
+  uint64_t ts = 0;
+  for (int i = 0; i < kNumReqsPerConn; ++i) {
+    for (int c = 0; c < kNumConns; ++c) {
+      for (auto direction : {kEgress, kIngress}) {
+        std::string_view msg = direction == kEgress ? kReq : kResp;
+        uint64_t* pos = direction == kEgress ? &send_pos[c] : &recv_pos[c];
+        px::stirling::sockeventpb::SocketDataEvent pb;
+        pb.mutable_attr()->set_timestamp_ns(++ts);
+        pb.mutable_attr()->mutable_conn_id()->set_pid(c + 1);
+        pb.mutable_attr()->mutable_conn_id()->set_fd(3);
+        pb.mutable_attr()->set_protocol(kProtocolHTTP);
+        pb.mutable_attr()->set_role(kRoleClient);
+        pb.mutable_attr()->set_direction(direction);
+        pb.mutable_attr()->set_pos(*pos);
+        pb.mutable_attr()->set_msg_size(msg.size());
+        pb.set_msg(std::string(msg));
+        *pos += msg.size();
+        events.push_back(px::stirling::ToRawDataEvent(pb));
+      }
+    }
+  }
+  return events;
+}
+
+const std::vector<RawDataEvent>& AllEvents() {
+  static const std::vector<RawDataEvent> kEvents = [] {
+    if (FLAGS_replay_captures.empty()) {
+      return SyntheticEvents();
+    }
+    std::vector<RawDataEvent> events;
+    for (std::string_view path : absl::StrSplit(FLAGS_replay_captures, ',', absl::SkipEmpty())) {
+      std::vector<RawDataEvent> capture =
+          px::stirling::ReadDataEventCapture(path).ConsumeValueOrDie();
+      events.insert(events.end(), std::make_move_iterator(capture.begin()),
+                    std::make_move_iterator(capture.end()));
+    }
+    return events;
+  }();
+  return kEvents;
+}
+
+const socket_data_event_t::attr_t& Attr(const RawDataEvent& event) {
+  return reinterpret_cast<const socket_data_event_t*>(event.data())->attr;
+}
+
+std::vector<RawDataEvent> ProtocolEvents(traffic_protocol_t protocol) {
+  std::vector<RawDataEvent> events;
+  for (const auto& event : AllEvents()) {
+    if (protocol == kProtocolUnknown || Attr(event).protocol == protocol) {
+      events.push_back(event);
+    }
+  }
+  return events;
+}
+
+}  // namespace
+
+// Replays the events of the protocol, or all events for kProtocolUnknown. Besides the overall
+// events/sec and bytes/sec, reports the time spent in TransferData(), which is where the events
+// are parsed into records, and the heap allocations (with tcmalloc), per event.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_replay(benchmark::State& state, traffic_protocol_t protocol) {
+  FLAGS_stirling_check_proc_for_conn_close = false;
+  InstallAllocCounter();
+
+  const std::vector<RawDataEvent> events = ProtocolEvents(protocol);
+  if (events.empty()) {
+    state.SkipWithError("No events of the protocol to replay.");
+    return;
+  }
+  int64_t bytes = 0;
+  for (const auto& event : events) {
+    bytes += Attr(event).msg_buf_size;
+  }
+
+  px::ElapsedTimer transfer_timer;
+  int64_t allocs = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto replayer = std::make_unique<SocketTraceReplayer>();
+    int64_t allocs_start = num_allocs.load();
+    state.ResumeTiming();
+
+    for (size_t i = 0; i < events.size(); ++i) {
+      replayer->AcceptDataEvent(events[i]);
+      if ((i + 1) % FLAGS_replay_events_per_transfer == 0 || i + 1 == events.size()) {
+        transfer_timer.Resume();
+        replayer->TransferData();
+        transfer_timer.Stop();
+      }
+    }
+
+    state.PauseTiming();
+    allocs += num_allocs.load() - allocs_start;
+    replayer.reset();
+    state.ResumeTiming();
+  }
+
+  const int64_t num_events = state.iterations() * events.size();
+  state.SetBytesProcessed(state.iterations() * bytes);
+  state.SetItemsProcessed(num_events);
+  state.counters["transfer_ns_per_event"] =
+      1000.0 * transfer_timer.ElapsedTime_us() / num_events;
+#ifdef TCMALLOC
+  state.counters["allocs_per_event"] = static_cast<double>(allocs) / num_events;
+#else
+  PL_UNUSED(allocs);
+#endif
+}
+
+BENCHMARK_CAPTURE(BM_replay, all, kProtocolUnknown);
+BENCHMARK_CAPTURE(BM_replay, http, kProtocolHTTP);
+BENCHMARK_CAPTURE(BM_replay, http2, kProtocolHTTP2);
+BENCHMARK_CAPTURE(BM_replay, mysql, kProtocolMySQL);
+BENCHMARK_CAPTURE(BM_replay, cql, kProtocolCQL);
+BENCHMARK_CAPTURE(BM_replay, pgsql, kProtocolPGSQL);
+BENCHMARK_CAPTURE(BM_replay, dns, kProtocolDNS);
+BENCHMARK_CAPTURE(BM_replay, redis, kProtocolRedis);
+BENCHMARK_CAPTURE(BM_replay, nats, kProtocolNATS);
+BENCHMARK_CAPTURE(BM_replay, kafka, kProtocolKafka);
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/socket_tracer_metrics.h"
+
+#include <array>
+#include <string>
+
+#include <absl/strings/ascii.h>
+#include <magic_enum.hpp>
+
+namespace px {
+namespace stirling {
+
+namespace {
+
+using ProtocolMetricsArray = std::array<SocketTracerProtocolMetrics, kNumProtocols>;
+
+ProtocolMetricsArray CreateProtocolMetrics() {
+  auto& registry = utils::MetricsRegistry::Global();
+  ProtocolMetricsArray metrics;
+  for (traffic_protocol_t protocol : TrafficProtocolEnumValues()) {
+    // kProtocolHTTP -> http.
+    std::string name =
+        absl::AsciiStrToLower(magic_enum::enum_name(protocol).substr(sizeof("kProtocol") - 1));
+    utils::MetricsRegistry::Labels labels = {{"protocol", name}};
+    metrics[protocol] = {
+        registry.GetCounter("stirling_socket_tracer_data_events",
+                            "The data events received from BPF.", labels),
+        registry.GetCounter("stirling_socket_tracer_data_bytes",
+                            "The bytes of the data events received from BPF.", labels),
+        registry.GetHistogram("stirling_socket_tracer_parse_ns",
+                              "The time spent parsing a connection's data into frames.", labels),
+        registry.GetHistogram("stirling_socket_tracer_stitch_ns",
+                              "The time spent stitching a connection's frames into records.",
+                              labels),
+        registry.GetCounter("stirling_socket_tracer_evicted_bytes",
+                            "The bytes of connection data dropped to stay in the memory budget.",
+                            labels),
+    };
+  }
+  return metrics;
+}
+
+}  // namespace
+
+const SocketTracerProtocolMetrics& GetSocketTracerProtocolMetrics(traffic_protocol_t protocol) {
+  static const ProtocolMetricsArray kMetrics = CreateProtocolMetrics();
+  if (protocol < 0 || protocol >= kNumProtocols) {
+    return kMetrics[kProtocolUnknown];
+  }
+  return kMetrics[protocol];
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/common.h"
+#include "src/stirling/utils/metrics.h"
+
+namespace px {
+namespace stirling {
+
+/**
+ * The socket tracer's per-protocol ingestion metrics, in the global metrics registry.
+ */
+struct SocketTracerProtocolMetrics {
+  // The data events received from BPF, and the bytes they carried.
+  utils::Counter* data_events;
+  utils::Counter* data_bytes;
+  // The time spent parsing the data streams into frames, and stitching frames into records,
+  // per connection and iteration.
+  utils::Histogram* parse_time_ns;
+  utils::Histogram* stitch_time_ns;
+  // The bytes of buffered data and frames that were dropped to stay within the memory budget.
+  utils::Counter* evicted_bytes;
+};
+
+/**
+ * Returns the metrics of the protocol. Unknown protocols share the kProtocolUnknown metrics.
+ */
+const SocketTracerProtocolMetrics& GetSocketTracerProtocolMetrics(traffic_protocol_t protocol);
+
+}  // namespace stirling
+}  // namespace px
@@ -18,7 +18,7 @@
 
 #pragma once
 
-#include <memory>
+#include <string_view>
 
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/go_grpc_types.hpp"
 #include "src/stirling/source_connectors/socket_tracer/testing/clock.h"
@@ -33,44 +33,44 @@ class StreamEventGenerator {
       : clock_(clock), conn_id_(conn_id), stream_id_(stream_id) {}
 
   template <DataFrameEventType TType>
-  std::unique_ptr<HTTP2DataEvent> GenDataFrame(std::string_view body, bool end_stream = false) {
-    auto frame = std::make_unique<HTTP2DataEvent>();
-    frame->attr.conn_id = conn_id_;
-    frame->attr.type = TType;
-    frame->attr.timestamp_ns = clock_->now();
-    frame->attr.stream_id = stream_id_;
-    frame->attr.end_stream = end_stream;
-    frame->attr.pos = pos;
+  HTTP2DataEvent GenDataFrame(std::string_view body, bool end_stream = false) {
+    HTTP2DataEvent frame;
+    frame.attr.conn_id = conn_id_;
+    frame.attr.type = TType;
+    frame.attr.timestamp_ns = clock_->now();
+    frame.attr.stream_id = stream_id_;
+    frame.attr.end_stream = end_stream;
+    frame.attr.pos = pos;
     pos += body.length();
-    frame->attr.data_size = body.length();
-    frame->attr.data_buf_size = body.length();
-    frame->payload = body;
+    frame.attr.data_size = body.length();
+    frame.attr.data_buf_size = body.length();
+    frame.payload = body;
     return frame;
   }
 
   template <HeaderEventType TType>
-  std::unique_ptr<HTTP2HeaderEvent> GenHeader(std::string_view name, std::string_view value) {
-    auto hdr = std::make_unique<HTTP2HeaderEvent>();
-    hdr->attr.conn_id = conn_id_;
-    hdr->attr.type = TType;
-    hdr->attr.timestamp_ns = clock_->now();
-    hdr->attr.stream_id = stream_id_;
-    hdr->attr.end_stream = false;
-    hdr->name = name;
-    hdr->value = value;
+  HTTP2HeaderEvent GenHeader(std::string_view name, std::string_view value) {
+    HTTP2HeaderEvent hdr;
+    hdr.attr.conn_id = conn_id_;
+    hdr.attr.type = TType;
+    hdr.attr.timestamp_ns = clock_->now();
+    hdr.attr.stream_id = stream_id_;
+    hdr.attr.end_stream = false;
+    hdr.name = name;
+    hdr.value = value;
     return hdr;
   }
 
   template <HeaderEventType TType>
-  std::unique_ptr<HTTP2HeaderEvent> GenEndStreamHeader() {
-    auto hdr = std::make_unique<HTTP2HeaderEvent>();
-    hdr->attr.conn_id = conn_id_;
-    hdr->attr.type = TType;
-    hdr->attr.timestamp_ns = clock_->now();
-    hdr->attr.stream_id = stream_id_;
-    hdr->attr.end_stream = true;
-    hdr->name = "";
-    hdr->value = "";
+  HTTP2HeaderEvent GenEndStreamHeader() {
+    HTTP2HeaderEvent hdr;
+    hdr.attr.conn_id = conn_id_;
+    hdr.attr.type = TType;
+    hdr.attr.timestamp_ns = clock_->now();
+    hdr.attr.stream_id = stream_id_;
+    hdr.attr.end_stream = true;
+    hdr.name = "";
+    hdr.value = "";
     return hdr;
   }
 
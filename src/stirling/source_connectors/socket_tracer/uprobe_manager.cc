@@ -24,11 +24,18 @@
 #include <algorithm>
 #include <filesystem>
 #include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "src/common/base/base.h"
 #include "src/common/base/utils.h"
 #include "src/common/exec/subprocess.h"
 #include "src/common/fs/fs_wrapper.h"
+#include "src/common/perf/elapsed_timer.h"
 #include "src/stirling/bpf_tools/macros.h"
 #include "src/stirling/obj_tools/dwarf_reader.h"
 #include "src/stirling/obj_tools/go_syms.h"
@@ -42,14 +49,24 @@ DEFINE_bool(stirling_rescan_for_dlopen, false,
 DEFINE_double(stirling_rescan_exp_backoff_factor, 2.0,
               "Exponential backoff factor used in decided how often to rescan binaries for "
               "dynamically loaded libraries");
+DEFINE_string(stirling_uprobe_analysis_cache_dir,
+              gflags::StringFromEnv("PL_STIRLING_UPROBE_ANALYSIS_CACHE_DIR", ""),
+              "If set, the analysis of Go binaries for uprobe deployment is persisted to this "
+              "directory, so that it can be reused after a restart.");
+DEFINE_int32(stirling_uprobe_analysis_threads,
+             gflags::Int32FromEnv("PL_STIRLING_UPROBE_ANALYSIS_THREADS", 4),
+             "The number of threads, including the uprobe deployment thread, that analyze binaries "
+             "for uprobe deployment. Capped at the number of CPUs.");
 
 namespace px {
 namespace stirling {
 
+using ::px::stirling::obj_tools::DwarfIndexMode;
 using ::px::stirling::obj_tools::DwarfReader;
 using ::px::stirling::obj_tools::ElfReader;
 
-UProbeManager::UProbeManager(bpf_tools::BCCWrapper* bcc) : bcc_(bcc) {
+UProbeManager::UProbeManager(bpf_tools::BCCWrapper* bcc)
+    : bcc_(bcc), binary_analysis_cache_(FLAGS_stirling_uprobe_analysis_cache_dir) {
   proc_parser_ = std::make_unique<system::ProcParser>(system::Config::GetInstance());
 }
 
@@ -72,14 +89,13 @@ void UProbeManager::Init(bool enable_http2_tracing, bool disable_self_probing) {
 
 void UProbeManager::NotifyMMapEvent(upid_t upid) { upids_with_mmap_.insert(upid); }
 
-StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
-                                              const std::string& binary,
-                                              obj_tools::ElfReader* elf_reader) {
+StatusOr<std::vector<bpf_tools::UProbeSpec>> UProbeManager::ResolveUProbeTmpl(
+    const ArrayView<UProbeTmpl>& probe_tmpls, obj_tools::ElfReader* elf_reader) {
   using bpf_tools::BPFProbeAttachType;
 
-  int uprobe_count = 0;
+  std::vector<bpf_tools::UProbeSpec> specs;
   for (const auto& tmpl : probe_tmpls) {
-    bpf_tools::UProbeSpec spec = {binary,
+    bpf_tools::UProbeSpec spec = {/*binary_path*/ {},
                                   /*symbol*/ {},
                                   /*address*/ 0,    bpf_tools::UProbeSpec::kDefaultPID,
                                   tmpl.attach_type, std::string(tmpl.probe_fn)};
@@ -97,9 +113,10 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
       switch (tmpl.attach_type) {
         case BPFProbeAttachType::kEntry:
         case BPFProbeAttachType::kReturn: {
-          spec.symbol = symbol_info.name;
-          PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
-          ++uprobe_count;
+          // Attach by address, so that BCC doesn't search the binary's symbol table again for
+          // every probe.
+          spec.address = symbol_info.address;
+          specs.push_back(spec);
           break;
         }
         case BPFProbeAttachType::kReturnInsts: {
@@ -116,8 +133,7 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
           for (const uint64_t& addr : ret_inst_addrs) {
             spec.attach_type = BPFProbeAttachType::kEntry;
             spec.address = addr;
-            PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
-            ++uprobe_count;
+            specs.push_back(spec);
           }
           break;
         }
@@ -126,58 +142,54 @@ StatusOr<int> UProbeManager::AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe
       }
     }
   }
-  return uprobe_count;
+  return specs;
+}
+
+StatusOr<int> UProbeManager::AttachUProbes(const std::vector<bpf_tools::UProbeSpec>& probes,
+                                           const std::string& binary) {
+  ElapsedTimer timer;
+  timer.Start();
+  for (bpf_tools::UProbeSpec spec : probes) {
+    spec.binary_path = binary;
+    PL_RETURN_IF_ERROR(bcc_->AttachUProbe(spec));
+  }
+  VLOG(1) << absl::Substitute("Attached $0 uprobes to $1 in $2 ms.", probes.size(), binary,
+                              timer.ElapsedTime_us() / 1000.0);
+  return probes.size();
 }
 
 Status UProbeManager::UpdateOpenSSLSymAddrs(std::filesystem::path libcrypto_path, uint32_t pid) {
-  PL_ASSIGN_OR_RETURN(struct openssl_symaddrs_t symaddrs, OpenSSLSymAddrs(libcrypto_path));
+  PL_ASSIGN_OR_RETURN(BinaryKey key, BinaryKey::Create(libcrypto_path));
+  std::optional<struct openssl_symaddrs_t> symaddrs = binary_analysis_cache_.LookupOpenSSL(key);
+  if (!symaddrs.has_value()) {
+    PL_ASSIGN_OR_RETURN(symaddrs, OpenSSLSymAddrs(libcrypto_path));
+    binary_analysis_cache_.InsertOpenSSL(key, symaddrs.value());
+  }
 
-  openssl_symaddrs_map_->UpdateValue(pid, symaddrs);
+  openssl_symaddrs_map_->UpdateValue(pid, symaddrs.value());
 
   return Status::OK();
 }
 
-Status UProbeManager::UpdateGoCommonSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                             const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_common_symaddrs_t symaddrs,
-                      GoCommonSymAddrs(elf_reader, dwarf_reader));
-
+void UProbeManager::UpdateGoCommonSymAddrs(const struct go_common_symaddrs_t& symaddrs,
+                                           const std::vector<int32_t>& pids) {
   for (auto& pid : pids) {
     go_common_symaddrs_map_->UpdateValue(pid, symaddrs);
   }
-
-  return Status::OK();
 }
 
-Status UProbeManager::UpdateGoHTTP2SymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                            const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_http2_symaddrs_t symaddrs,
-                      GoHTTP2SymAddrs(elf_reader, dwarf_reader));
-
+void UProbeManager::UpdateGoHTTP2SymAddrs(const struct go_http2_symaddrs_t& symaddrs,
+                                          const std::vector<int32_t>& pids) {
   for (auto& pid : pids) {
     go_http2_symaddrs_map_->UpdateValue(pid, symaddrs);
   }
-
-  return Status::OK();
 }
 
-Status UProbeManager::UpdateGoTLSSymAddrs(ElfReader* elf_reader, DwarfReader* dwarf_reader,
-                                          const std::vector<int32_t>& pids) {
-  PL_ASSIGN_OR_RETURN(struct go_tls_symaddrs_t symaddrs, GoTLSSymAddrs(elf_reader, dwarf_reader));
-
+void UProbeManager::UpdateGoTLSSymAddrs(const struct go_tls_symaddrs_t& symaddrs,
+                                        const std::vector<int32_t>& pids) {
   for (auto& pid : pids) {
     go_tls_symaddrs_map_->UpdateValue(pid, symaddrs);
   }
-
-  return Status::OK();
-}
-
-Status UProbeManager::UpdateNodeTLSWrapSymAddrs(int32_t pid, const std::filesystem::path& node_exe,
-                                                const SemVer& ver) {
-  PL_ASSIGN_OR_RETURN(struct node_tlswrap_symaddrs_t symbol_offsets,
-                      NodeTLSWrapSymAddrs(node_exe, ver));
-  node_tlswrap_symaddrs_map_->UpdateValue(pid, symbol_offsets);
-  return Status::OK();
 }
 
 // Find the paths for some libraries, which may be inside of a container.
@@ -339,15 +351,16 @@ StatusOr<int> UProbeManager::AttachNodeJsOpenSSLUprobes(uint32_t pid) {
 
   std::filesystem::path host_proc_exe = system::Config::GetInstance().ToHostPath(proc_exe_paths[0]);
 
+  PL_ASSIGN_OR_RETURN(const NodeBinaryAnalysis* analysis,
+                      GetNodeBinaryAnalysis(pid, proc_exe, host_proc_exe));
+  node_tlswrap_symaddrs_map_->UpdateValue(pid, analysis->tlswrap_symaddrs);
+
   auto result = nodejs_binaries_.insert(host_proc_exe.string());
   if (!result.second) {
     // This is not a new binary, so nothing more to do.
     return 0;
   }
 
-  PL_ASSIGN_OR_RETURN(const SemVer ver, GetNodeVersion(pid, proc_exe));
-  PL_RETURN_IF_ERROR(UpdateNodeTLSWrapSymAddrs(pid, host_proc_exe, ver));
-
   // These probes are attached on OpenSSL dynamic library (if present) as well.
   // Here they are attached on statically linked OpenSSL library (eg. for node).
   for (auto spec : kOpenSSLUProbes) {
@@ -356,25 +369,41 @@ StatusOr<int> UProbeManager::AttachNodeJsOpenSSLUprobes(uint32_t pid) {
   }
 
   // These are node-specific probes.
-  PL_ASSIGN_OR_RETURN(auto uprobe_tmpls, GetNodeOpensslUProbeTmpls(ver));
-  PL_ASSIGN_OR_RETURN(auto elf_reader, ElfReader::Create(host_proc_exe));
-  PL_ASSIGN_OR_RETURN(int count, AttachUProbeTmpl(uprobe_tmpls, host_proc_exe, elf_reader.get()));
+  PL_ASSIGN_OR_RETURN(int count, AttachUProbes(analysis->probes, host_proc_exe));
 
   return kOpenSSLUProbes.size() + count;
 }
 
+StatusOr<const NodeBinaryAnalysis*> UProbeManager::GetNodeBinaryAnalysis(
+    uint32_t pid, const std::filesystem::path& proc_exe,
+    const std::filesystem::path& host_proc_exe) {
+  PL_ASSIGN_OR_RETURN(BinaryKey key, BinaryKey::Create(host_proc_exe));
+  const NodeBinaryAnalysis* cached = binary_analysis_cache_.LookupNode(key);
+  if (cached != nullptr) {
+    return cached;
+  }
+
+  NodeBinaryAnalysis analysis;
+  PL_ASSIGN_OR_RETURN(analysis.version, GetNodeVersion(pid, proc_exe));
+  PL_ASSIGN_OR_RETURN(analysis.tlswrap_symaddrs,
+                      NodeTLSWrapSymAddrs(host_proc_exe, analysis.version));
+  PL_ASSIGN_OR_RETURN(auto uprobe_tmpls, GetNodeOpensslUProbeTmpls(analysis.version));
+  PL_ASSIGN_OR_RETURN(auto elf_reader, ElfReader::Create(host_proc_exe));
+  PL_ASSIGN_OR_RETURN(analysis.probes, ResolveUProbeTmpl(uprobe_tmpls, elf_reader.get()));
+  return &binary_analysis_cache_.InsertNode(key, std::move(analysis));
+}
+
 StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
-                                                obj_tools::ElfReader* elf_reader,
-                                                obj_tools::DwarfReader* dwarf_reader,
+                                                const GoBinaryAnalysis& analysis,
                                                 const std::vector<int32_t>& pids) {
   // Step 1: Update BPF symbols_map on all new PIDs.
-  Status s = UpdateGoTLSSymAddrs(elf_reader, dwarf_reader, pids);
-  if (!s.ok()) {
+  if (!analysis.tls_symaddrs.has_value()) {
     // Doesn't appear to be a binary with the mandatory symbols.
     // Might not even be a golang binary.
     // Either way, not of interest to probe.
     return 0;
   }
+  UpdateGoTLSSymAddrs(analysis.tls_symaddrs.value(), pids);
 
   // Step 2: Deploy uprobes on all new binaries.
   auto result = go_tls_probed_binaries_.insert(binary);
@@ -382,7 +411,7 @@ StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
     // This is not a new binary, so nothing more to do.
     return 0;
   }
-  return AttachUProbeTmpl(kGoTLSUProbeTmpls, binary, elf_reader);
+  return AttachUProbes(analysis.tls_probes, binary);
 }
 
 // TODO(oazizi/yzhao): Should HTTP uprobes use a different set of perf buffers than the kprobes?
@@ -390,14 +419,13 @@ StatusOr<int> UProbeManager::AttachGoTLSUProbes(const std::string& binary,
 // cleanly. For example, right now, enabling uprobe & kprobe simultaneously can crash Stirling,
 // because of the mixed & duplicate data events from these 2 sources.
 StatusOr<int> UProbeManager::AttachGoHTTP2Probes(const std::string& binary,
-                                                 obj_tools::ElfReader* elf_reader,
-                                                 obj_tools::DwarfReader* dwarf_reader,
+                                                 const GoBinaryAnalysis& analysis,
                                                  const std::vector<int32_t>& pids) {
   // Step 1: Update BPF symaddrs for this binary.
-  Status s = UpdateGoHTTP2SymAddrs(elf_reader, dwarf_reader, pids);
-  if (!s.ok()) {
+  if (!analysis.http2_symaddrs.has_value()) {
     return 0;
   }
+  UpdateGoHTTP2SymAddrs(analysis.http2_symaddrs.value(), pids);
 
   // Step 2: Deploy uprobes on all new binaries.
   auto result = go_http2_probed_binaries_.insert(binary);
@@ -405,19 +433,20 @@ StatusOr<int> UProbeManager::AttachGoHTTP2Probes(const std::string& binary,
     // This is not a new binary, so nothing more to do.
     return 0;
   }
-  return AttachUProbeTmpl(kHTTP2ProbeTmpls, binary, elf_reader);
+  return AttachUProbes(analysis.http2_probes, binary);
 }
 
 namespace {
 
-// Convert PID list from list of UPIDs to a map with key=binary name, value=PIDs
-std::map<std::string, std::vector<int32_t>> ConvertPIDsListToMap(
-    const absl::flat_hash_set<md::UPID>& upids, LazyLoadedFPResolver* fp_resolver) {
+// Groups the UPIDs by binary, with the binaries ordered by the position of their first UPID.
+std::vector<std::pair<std::string, std::vector<md::UPID>>> GroupUPIDsByBinary(
+    const std::vector<md::UPID>& upids, LazyLoadedFPResolver* fp_resolver) {
   const system::Config& sysconfig = system::Config::GetInstance();
   const system::ProcParser proc_parser(sysconfig);
 
-  // Convert to a map of binaries, with the upids that are instances of that binary.
-  std::map<std::string, std::vector<int32_t>> pids;
+  // The binaries, with the upids that are instances of that binary.
+  std::vector<std::pair<std::string, std::vector<md::UPID>>> binaries;
+  absl::flat_hash_map<std::string, size_t> binary_idx;
 
   for (const auto& upid : upids) {
     // TODO(yzhao): Might need to check the start time.
@@ -435,42 +464,104 @@ std::map<std::string, std::vector<int32_t>> ConvertPIDsListToMap(
     if (!fs::Exists(host_exe_path).ok()) {
       continue;
     }
-    pids[host_exe_path.string()].push_back(upid.pid());
+    auto [iter, inserted] = binary_idx.try_emplace(host_exe_path.string(), binaries.size());
+    if (inserted) {
+      binaries.emplace_back(host_exe_path.string(), std::vector<md::UPID>{});
+    }
+    binaries[iter->second].second.push_back(upid);
   }
 
-  VLOG(1) << absl::Substitute("New PIDs count = $0", pids.size());
+  VLOG(1) << absl::Substitute("New binaries count = $0", binaries.size());
 
+  return binaries;
+}
+
+std::vector<int32_t> ToPIDs(const std::vector<md::UPID>& upids) {
+  std::vector<int32_t> pids;
+  pids.reserve(upids.size());
+  for (const auto& upid : upids) {
+    pids.push_back(upid.pid());
+  }
   return pids;
 }
 
 }  // namespace
 
-std::thread UProbeManager::RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids) {
+std::vector<md::UPID> PrioritizeUPIDs(const absl::flat_hash_set<md::UPID>& upids,
+                                      const absl::flat_hash_map<uint32_t, int>& pid_traffic) {
+  auto traffic = [&pid_traffic](const md::UPID& upid) {
+    auto iter = pid_traffic.find(upid.pid());
+    return iter == pid_traffic.end() ? 0 : iter->second;
+  };
+
+  std::vector<md::UPID> prioritized(upids.begin(), upids.end());
+  // The pid breaks ties, so that the order doesn't depend on the hash set's iteration order.
+  std::sort(prioritized.begin(), prioritized.end(),
+            [&traffic](const md::UPID& a, const md::UPID& b) {
+              return std::make_tuple(traffic(a), a.start_ts(), a.pid()) >
+                     std::make_tuple(traffic(b), b.start_ts(), b.pid());
+            });
+  return prioritized;
+}
+
+std::thread UProbeManager::RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids,
+                                                  uint64_t upids_version,
+                                                  std::shared_ptr<const UPIDsDelta> upids_delta,
+                                                  absl::flat_hash_map<uint32_t, int> pid_traffic) {
   // Increment before starting thread to avoid race in case thread starts late.
   ++num_deploy_uprobes_threads_;
-  return std::thread([this, pids]() {
-    DeployUProbes(pids);
+  return std::thread([this, pids, upids_version, upids_delta = std::move(upids_delta),
+                      pid_traffic = std::move(pid_traffic)]() {
+    DeployUProbes(pids, upids_version, upids_delta.get(), pid_traffic);
     --num_deploy_uprobes_threads_;
   });
   return {};
 }
 
+std::optional<std::chrono::nanoseconds> UProbeManager::DeployLatency(const md::UPID& upid) const {
+  absl::MutexLock lock(&deploy_latencies_mutex_);
+  auto iter = deploy_latencies_.find(upid);
+  if (iter == deploy_latencies_.end()) {
+    return std::nullopt;
+  }
+  return iter->second;
+}
+
+void UProbeManager::RecordDeployLatency(const std::vector<md::UPID>& upids) {
+  auto latency = std::chrono::steady_clock::now() - deploy_start_;
+  absl::MutexLock lock(&deploy_latencies_mutex_);
+  for (const auto& upid : upids) {
+    deploy_latencies_[upid] = latency;
+    VLOG(1) << absl::Substitute("Uprobe deployment on PID $0 took $1 ms", upid.pid(),
+                                std::chrono::duration_cast<std::chrono::milliseconds>(latency)
+                                    .count());
+  }
+}
+
 void UProbeManager::CleanupSymaddrMaps(const absl::flat_hash_set<md::UPID>& deleted_upids) {
+  std::vector<uint32_t> pids;
+  pids.reserve(deleted_upids.size());
+  for (const auto& upid : deleted_upids) {
+    pids.push_back(upid.pid());
+  }
+  openssl_symaddrs_map_->RemoveValues(pids);
+  go_common_symaddrs_map_->RemoveValues(pids);
+  go_tls_symaddrs_map_->RemoveValues(pids);
+  go_http2_symaddrs_map_->RemoveValues(pids);
+  node_tlswrap_symaddrs_map_->RemoveValues(pids);
+
+  absl::MutexLock lock(&deploy_latencies_mutex_);
   for (const auto& pid : deleted_upids) {
-    openssl_symaddrs_map_->RemoveValue(pid.pid());
-    go_common_symaddrs_map_->RemoveValue(pid.pid());
-    go_tls_symaddrs_map_->RemoveValue(pid.pid());
-    go_http2_symaddrs_map_->RemoveValue(pid.pid());
-    node_tlswrap_symaddrs_map_->RemoveValue(pid.pid());
+    deploy_latencies_.erase(pid);
   }
 }
 
-int UProbeManager::DeployOpenSSLUProbes(const absl::flat_hash_set<md::UPID>& pids) {
+int UProbeManager::DeployOpenSSLUProbes(const std::vector<md::UPID>& upids) {
   int uprobe_count = 0;
 
-  // TODO(yzhao): Change to use ConvertPIDsListToMap() to avoid processing the same executable
+  // TODO(yzhao): Change to use GroupUPIDsByBinary() to avoid processing the same executable
   // multiple times for different processes.
-  for (const auto& pid : pids) {
+  for (const auto& pid : upids) {
     if (cfg_disable_self_probing_ && pid.pid() == static_cast<uint32_t>(getpid())) {
       continue;
     }
@@ -505,82 +596,193 @@ int UProbeManager::DeployOpenSSLUProbes(const absl::flat_hash_set<md::UPID>& pid
   return uprobe_count;
 }
 
-int UProbeManager::DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids) {
+StatusOr<GoBinaryAnalysis> UProbeManager::AnalyzeGoBinary(const std::string& binary) const {
+  GoBinaryAnalysis analysis;
+  analysis.http2_analyzed = cfg_enable_http2_tracing_;
+
+  // Read binary's symbols.
+  PL_ASSIGN_OR_RETURN(std::unique_ptr<ElfReader> elf_reader, ElfReader::Create(binary));
+
+  // Avoid going passed this point if not a golang program.
+  // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
+  if (!IsGoExecutable(elf_reader.get())) {
+    return analysis;
+  }
+
+  StatusOr<std::unique_ptr<DwarfReader>> dwarf_reader_status =
+      DwarfReader::Create(binary, DwarfIndexMode::kLazy);
+  if (!dwarf_reader_status.ok()) {
+    VLOG(1) << absl::Substitute(
+        "Failed to get binary $0 debug symbols. Cannot deploy uprobes. "
+        "Message = $1",
+        binary, dwarf_reader_status.msg());
+    return analysis;
+  }
+  std::unique_ptr<DwarfReader> dwarf_reader = dwarf_reader_status.ConsumeValueOrDie();
+
+  StatusOr<struct go_common_symaddrs_t> common_symaddrs =
+      GoCommonSymAddrs(elf_reader.get(), dwarf_reader.get());
+  if (!common_symaddrs.ok()) {
+    VLOG(1) << absl::Substitute(
+        "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn).", binary);
+    return analysis;
+  }
+  analysis.common_symaddrs = common_symaddrs.ConsumeValueOrDie();
+
+  StatusOr<struct go_tls_symaddrs_t> tls_symaddrs =
+      GoTLSSymAddrs(elf_reader.get(), dwarf_reader.get());
+  if (tls_symaddrs.ok()) {
+    analysis.tls_symaddrs = tls_symaddrs.ConsumeValueOrDie();
+    StatusOr<std::vector<bpf_tools::UProbeSpec>> probes =
+        ResolveUProbeTmpl(kGoTLSUProbeTmpls, elf_reader.get());
+    if (probes.ok()) {
+      analysis.tls_probes = probes.ConsumeValueOrDie();
+    } else {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to find GoTLS Uprobes in $0: $1",
+                                                   binary, probes.ToString());
+    }
+  }
+
+  if (cfg_enable_http2_tracing_) {
+    StatusOr<struct go_http2_symaddrs_t> http2_symaddrs =
+        GoHTTP2SymAddrs(elf_reader.get(), dwarf_reader.get());
+    if (http2_symaddrs.ok()) {
+      analysis.http2_symaddrs = http2_symaddrs.ConsumeValueOrDie();
+      StatusOr<std::vector<bpf_tools::UProbeSpec>> probes =
+          ResolveUProbeTmpl(kHTTP2ProbeTmpls, elf_reader.get());
+      if (probes.ok()) {
+        analysis.http2_probes = probes.ConsumeValueOrDie();
+      } else {
+        LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to find HTTP2 Uprobes in $0: $1",
+                                                     binary, probes.ToString());
+      }
+    }
+  }
+
+  return analysis;
+}
+
+const GoBinaryAnalysis* UProbeManager::LookupGoBinaryAnalysis(const BinaryKey& key) {
+  const GoBinaryAnalysis* cached = binary_analysis_cache_.LookupGo(key);
+  // An analysis made without HTTP2 tracing doesn't have what's needed for HTTP2 probes.
+  if (cached != nullptr && (cached->http2_analyzed || !cfg_enable_http2_tracing_)) {
+    return cached;
+  }
+  return nullptr;
+}
+
+int UProbeManager::AttachGoUProbes(const std::string& binary, const GoBinaryAnalysis& analysis,
+                                   const std::vector<int32_t>& pid_vec) {
   int uprobe_count = 0;
 
-  static int32_t kPID = getpid();
+  if (!analysis.common_symaddrs.has_value()) {
+    return 0;
+  }
+  UpdateGoCommonSymAddrs(analysis.common_symaddrs.value(), pid_vec);
+
+  // GoTLS Probes.
+  {
+    StatusOr<int> attach_status = AttachGoTLSUProbes(binary, analysis, pid_vec);
+    if (!attach_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
+                                                   binary, attach_status.ToString());
+    } else {
+      uprobe_count += attach_status.ValueOrDie();
+    }
+  }
 
-  for (const auto& [binary, pid_vec] : ConvertPIDsListToMap(pids, &fp_resolver_)) {
-    // Don't bother rescanning binaries that have been scanned before to avoid unnecessary work.
-    if (!scanned_binaries_.insert(binary).second) {
-      continue;
+  // Go HTTP2 Probes.
+  if (cfg_enable_http2_tracing_) {
+    StatusOr<int> attach_status = AttachGoHTTP2Probes(binary, analysis, pid_vec);
+    if (!attach_status.ok()) {
+      LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
+                                                   binary, attach_status.ToString());
+    } else {
+      uprobe_count += attach_status.ValueOrDie();
     }
+  }
+
+  return uprobe_count;
+}
+
+int UProbeManager::DeployGoUProbes(const std::vector<md::UPID>& upids) {
+  static int32_t kPID = getpid();
 
+  std::vector<std::pair<std::string, std::vector<md::UPID>>> binaries;
+  for (auto& [binary, binary_upids] : GroupUPIDsByBinary(upids, &fp_resolver_)) {
     if (cfg_disable_self_probing_) {
       // Don't try to attach uprobes to self.
       // This speeds up stirling_wrapper initialization significantly.
-      if (pid_vec.size() == 1 && pid_vec[0] == kPID) {
+      if (binary_upids.size() == 1 && binary_upids[0].pid() == static_cast<uint32_t>(kPID)) {
         continue;
       }
     }
+    binaries.emplace_back(std::move(binary), std::move(binary_upids));
+  }
 
-    // Read binary's symbols.
-    StatusOr<std::unique_ptr<ElfReader>> elf_reader_status = ElfReader::Create(binary);
-    if (!elf_reader_status.ok()) {
-      LOG(WARNING) << absl::Substitute(
-          "Cannot analyze binary $0 for uprobe deployment. "
-          "If file is under /var/lib, container may have terminated. "
-          "Message = $1",
-          binary, elf_reader_status.msg());
-      continue;
-    }
-    std::unique_ptr<ElfReader> elf_reader = elf_reader_status.ConsumeValueOrDie();
-
-    // Avoid going passed this point if not a golang program.
-    // The DwarfReader is memory intensive, and the remaining probes are Golang specific.
-    if (!IsGoExecutable(elf_reader.get())) {
-      continue;
-    }
+  // Binaries are handled in batches of one binary per worker, in priority order, so that the
+  // uprobes of the first binaries are attached without waiting for the analysis of all of them.
+  ThreadPool* pool = ThreadPool::Shared();
+  // The calling thread is one of the workers.
+  const int num_workers =
+      std::max(1, std::min(FLAGS_stirling_uprobe_analysis_threads, pool->num_threads() + 1));
+  const size_t batch_size = num_workers;
+
+  auto log_analysis_failure = [](const std::string& binary, const Status& status) {
+    LOG(WARNING) << absl::Substitute(
+        "Cannot analyze binary $0 for uprobe deployment. "
+        "If file is under /var/lib, container may have terminated. "
+        "Message = $1",
+        binary, status.msg());
+  };
 
-    StatusOr<std::unique_ptr<DwarfReader>> dwarf_reader_status = DwarfReader::Create(binary);
-    if (!dwarf_reader_status.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Failed to get binary $0 debug symbols. Cannot deploy uprobes. "
-          "Message = $1",
-          binary, dwarf_reader_status.msg());
-      continue;
+  int uprobe_count = 0;
+  for (size_t batch_begin = 0; batch_begin < binaries.size(); batch_begin += batch_size) {
+    const size_t batch_end = std::min(batch_begin + batch_size, binaries.size());
+
+    // Binaries that have been analyzed before, under this path or another one, are not read
+    // again. The cache is only accessed by this thread.
+    std::vector<std::optional<BinaryKey>> keys(batch_end - batch_begin);
+    std::vector<const GoBinaryAnalysis*> analyses(batch_end - batch_begin, nullptr);
+    std::vector<size_t> to_analyze;
+    for (size_t i = batch_begin; i < batch_end; ++i) {
+      const std::string& binary = binaries[i].first;
+      StatusOr<BinaryKey> key_status = BinaryKey::Create(binary);
+      if (!key_status.ok()) {
+        log_analysis_failure(binary, key_status.status());
+        continue;
+      }
+      keys[i - batch_begin] = key_status.ConsumeValueOrDie();
+      analyses[i - batch_begin] = LookupGoBinaryAnalysis(keys[i - batch_begin].value());
+      if (analyses[i - batch_begin] == nullptr) {
+        to_analyze.push_back(i);
+      }
     }
-    std::unique_ptr<DwarfReader> dwarf_reader = dwarf_reader_status.ConsumeValueOrDie();
 
-    Status s = UpdateGoCommonSymAddrs(elf_reader.get(), dwarf_reader.get(), pid_vec);
-    if (!s.ok()) {
-      VLOG(1) << absl::Substitute(
-          "Golang binary $0 does not have the mandatory symbols (e.g. TCPConn).", binary);
-      continue;
-    }
+    std::vector<std::optional<StatusOr<GoBinaryAnalysis>>> results(to_analyze.size());
+    pool->ParallelFor(to_analyze.size(), num_workers, [&](int64_t idx, int /*worker_idx*/) {
+      results[idx] = AnalyzeGoBinary(binaries[to_analyze[idx]].first);
+    });
 
-    // GoTLS Probes.
-    {
-      StatusOr<int> attach_status =
-          AttachGoTLSUProbes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
-      if (!attach_status.ok()) {
-        LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach GoTLS Uprobes to $0: $1",
-                                                     binary, attach_status.ToString());
-      } else {
-        uprobe_count += attach_status.ValueOrDie();
+    for (const auto& [idx, i] : Enumerate(to_analyze)) {
+      StatusOr<GoBinaryAnalysis>& result = results[idx].value();
+      if (!result.ok()) {
+        log_analysis_failure(binaries[i].first, result.status());
+        continue;
       }
+      analyses[i - batch_begin] = &binary_analysis_cache_.InsertGo(
+          keys[i - batch_begin].value(), result.ConsumeValueOrDie());
     }
 
-    // Go HTTP2 Probes.
-    if (cfg_enable_http2_tracing_) {
-      StatusOr<int> attach_status =
-          AttachGoHTTP2Probes(binary, elf_reader.get(), dwarf_reader.get(), pid_vec);
-      if (!attach_status.ok()) {
-        LOG_FIRST_N(WARNING, 10) << absl::Substitute("Failed to attach HTTP2 Uprobes to $0: $1",
-                                                     binary, attach_status.ToString());
-      } else {
-        uprobe_count += attach_status.ValueOrDie();
+    // Attach the uprobes of the batch.
+    for (size_t i = batch_begin; i < batch_end; ++i) {
+      const GoBinaryAnalysis* analysis_ptr = analyses[i - batch_begin];
+      if (analysis_ptr == nullptr) {
+        continue;
       }
+      const auto& [binary, binary_upids] = binaries[i];
+      uprobe_count += AttachGoUProbes(binary, *analysis_ptr, ToPIDs(binary_upids));
+      RecordDeployLatency(binary_upids);
     }
   }
 
@@ -633,10 +835,13 @@ absl::flat_hash_set<md::UPID> UProbeManager::PIDsToRescanForUProbes() {
   return upids_to_rescan;
 }
 
-void UProbeManager::DeployUProbes(const absl::flat_hash_set<md::UPID>& pids) {
+void UProbeManager::DeployUProbes(const absl::flat_hash_set<md::UPID>& pids,
+                                  uint64_t upids_version, const UPIDsDelta* upids_delta,
+                                  const absl::flat_hash_map<uint32_t, int>& pid_traffic) {
   const std::lock_guard<std::mutex> lock(deploy_uprobes_mutex_);
+  deploy_start_ = std::chrono::steady_clock::now();
 
-  proc_tracker_.Update(pids);
+  proc_tracker_.Update(pids, upids_version, upids_delta);
 
   // Before deploying new probes, clean-up map entries for old processes that are now dead.
   CleanupSymaddrMaps(proc_tracker_.deleted_upids());
@@ -644,16 +849,26 @@ void UProbeManager::DeployUProbes(const absl::flat_hash_set<md::UPID>& pids) {
   // Refresh our file path resolver so it is aware of all new mounts.
   fp_resolver_.Refresh();
 
+  // Deploy on the processes whose traffic we'd miss the most first.
+  const std::vector<md::UPID> new_upids = PrioritizeUPIDs(proc_tracker_.new_upids(), pid_traffic);
+
   int uprobe_count = 0;
 
-  uprobe_count += DeployOpenSSLUProbes(proc_tracker_.new_upids());
+  uprobe_count += DeployOpenSSLUProbes(new_upids);
+  // Go binaries re-record the latency of their UPIDs once their uprobes are attached.
+  RecordDeployLatency(new_upids);
   if (FLAGS_stirling_rescan_for_dlopen) {
-    uprobe_count += DeployOpenSSLUProbes(PIDsToRescanForUProbes());
+    uprobe_count += DeployOpenSSLUProbes(PrioritizeUPIDs(PIDsToRescanForUProbes(), pid_traffic));
   }
-  uprobe_count += DeployGoUProbes(proc_tracker_.new_upids());
+  uprobe_count += DeployGoUProbes(new_upids);
 
   if (uprobe_count != 0) {
-    LOG(INFO) << absl::Substitute("Number of uprobes deployed = $0", uprobe_count);
+    LOG(INFO) << absl::Substitute(
+        "Number of uprobes deployed = $0, on $1 new processes, in $2 ms", uprobe_count,
+        new_upids.size(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                              deploy_start_)
+            .count());
   }
 }
 
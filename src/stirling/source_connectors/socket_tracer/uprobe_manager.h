@@ -18,20 +18,26 @@
 
 #pragma once
 
+#include <chrono>
+#include <filesystem>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <absl/container/flat_hash_map.h>
 #include <absl/synchronization/mutex.h>
 
+#include "src/common/base/thread_pool.h"
 #include "src/stirling/bpf_tools/bcc_wrapper.h"
 #include "src/stirling/obj_tools/dwarf_reader.h"
 #include "src/stirling/obj_tools/elf_reader.h"
 
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/socket_trace.hpp"
 #include "src/stirling/source_connectors/socket_tracer/bcc_bpf_intf/symaddrs.h"
+#include "src/stirling/source_connectors/socket_tracer/binary_analysis_cache.h"
 
 #include "src/stirling/utils/detect_application.h"
 #include "src/stirling/utils/proc_path_tools.h"
@@ -39,6 +45,8 @@
 
 DECLARE_bool(stirling_rescan_for_dlopen);
 DECLARE_double(stirling_rescan_exp_backoff_factor);
+DECLARE_string(stirling_uprobe_analysis_cache_dir);
+DECLARE_int32(stirling_uprobe_analysis_threads);
 
 namespace px {
 namespace stirling {
@@ -54,9 +62,21 @@ struct UProbeTmpl {
   bpf_tools::BPFProbeAttachType attach_type = bpf_tools::BPFProbeAttachType::kEntry;
 };
 
+/**
+ * Orders UPIDs for uprobe deployment, so that the processes whose traffic we'd miss the most get
+ * their uprobes first: processes with more traffic come first, and among those with the same
+ * traffic, the most recently started ones.
+ *
+ * @param upids The UPIDs to order.
+ * @param pid_traffic A measure of the traffic of each PID, e.g. its number of connections.
+ *                    PIDs that are missing have no traffic.
+ */
+std::vector<md::UPID> PrioritizeUPIDs(const absl::flat_hash_set<md::UPID>& upids,
+                                      const absl::flat_hash_map<uint32_t, int>& pid_traffic);
+
 // A wrapper around BPF maps that are exclusively written by user-space.
 // Provides an optimized RemoveValue() interface that avoids the BPF access
-// if the key doesn't exist.
+// if the key doesn't exist, and RemoveValues(), which removes many keys with one batch syscall.
 template <typename TKeyType, typename TValueType>
 class UserSpaceManagedBPFMap {
  public:
@@ -81,11 +101,25 @@ class UserSpaceManagedBPFMap {
     }
   }
 
+  void RemoveValues(const std::vector<TKeyType>& keys) {
+    std::vector<TKeyType> present_keys;
+    for (const TKeyType& key : keys) {
+      if (shadow_keys_.erase(key) > 0) {
+        present_keys.push_back(key);
+      }
+    }
+    bcc_->DeleteHashTableKeys(map_name_, present_keys);
+  }
+
  private:
   UserSpaceManagedBPFMap(bpf_tools::BCCWrapper* bcc, const std::string& map_name)
-      : map_(std::make_unique<ebpf::BPFHashTable<TKeyType, TValueType>>(
+      : bcc_(bcc),
+        map_name_(map_name),
+        map_(std::make_unique<ebpf::BPFHashTable<TKeyType, TValueType>>(
             bcc->GetHashTable<TKeyType, TValueType>(map_name))) {}
 
+  bpf_tools::BCCWrapper* bcc_;
+  std::string map_name_;
   std::unique_ptr<ebpf::BPFHashTable<TKeyType, TValueType>> map_;
   absl::flat_hash_set<TKeyType> shadow_keys_;
 };
@@ -120,9 +154,22 @@ class UProbeManager {
    * Runs the uprobe deployment code on the provided set of pids, as a thread.
    * @param pids New PIDs to analyze deploy uprobes on. Old PIDs can also be provided,
    *             if they need to be rescanned.
+   * @param upids_version The version of pids, see ConnectorContext::GetUPIDsVersion().
+   * @param upids_delta The delta of pids, see ConnectorContext::GetUPIDsDelta(). May be nullptr.
+   * @param pid_traffic The traffic of each PID, used to deploy on the busiest processes first.
+   *                    See PrioritizeUPIDs().
    * @return thread that handles the uprobe deployment work.
    */
-  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids);
+  std::thread RunDeployUProbesThread(const absl::flat_hash_set<md::UPID>& pids,
+                                     uint64_t upids_version,
+                                     std::shared_ptr<const UPIDsDelta> upids_delta = nullptr,
+                                     absl::flat_hash_map<uint32_t, int> pid_traffic = {});
+
+  /**
+   * Returns how long uprobe deployment took for the UPID, measured from the start of the
+   * deployment that first saw it, or std::nullopt if it hasn't been deployed on (yet).
+   */
+  std::optional<std::chrono::nanoseconds> DeployLatency(const md::UPID& upid) const;
 
   /**
    * Returns true if a previously dispatched thread (via RunDeployUProbesThread is still running).
@@ -340,38 +387,68 @@ class UProbeManager {
   /**
    * Deploys all available uprobe types (HTTP2, OpenSSL, etc.) on new processes.
    * @param pids The list of pids to analyze and instrument with uprobes, if appropriate.
+   * @param upids_version The version of pids. The pids are only diffed when it changes.
+   * @param upids_delta The delta of pids, applied instead of diffing them when possible.
+   * @param pid_traffic The traffic of each PID. See PrioritizeUPIDs().
    */
-  void DeployUProbes(const absl::flat_hash_set<md::UPID>& pids);
+  void DeployUProbes(const absl::flat_hash_set<md::UPID>& pids, uint64_t upids_version,
+                     const UPIDsDelta* upids_delta,
+                     const absl::flat_hash_map<uint32_t, int>& pid_traffic);
 
   /**
    * Deploys all OpenSSL uprobes on new processes.
-   * @param pids The list of pids to analyze and instrument with OpenSSL uprobes, if appropriate.
+   * @param upids The pids to analyze and instrument with OpenSSL uprobes, if appropriate,
+   *              in the order in which to deploy on them.
    * @return Number of uprobes deployed.
    */
-  int DeployOpenSSLUProbes(const absl::flat_hash_set<md::UPID>& pids);
+  int DeployOpenSSLUProbes(const std::vector<md::UPID>& upids);
 
   /**
    * Deploys all Go uprobes on new processes.
-   * @param pids The list of pids to analyze and instrument with Go uprobes, if appropriate.
+   * Binaries are analyzed on ThreadPool::Shared(), a batch at a time, while the
+   * uprobes are attached by this thread, so BCC is never accessed concurrently.
+   * @param upids The pids to analyze and instrument with Go uprobes, if appropriate,
+   *              in the order in which to deploy on them.
    * @return Number of uprobes deployed.
    */
-  int DeployGoUProbes(const absl::flat_hash_set<md::UPID>& pids);
+  int DeployGoUProbes(const std::vector<md::UPID>& upids);
+
+  /**
+   * Returns the cached analysis of a Go binary for uprobe deployment, if any copy of the binary
+   * has been analyzed before, or nullptr if the binary needs to be analyzed.
+   */
+  const GoBinaryAnalysis* LookupGoBinaryAnalysis(const BinaryKey& key);
+
+  /**
+   * Reads the ELF and DWARF info of a binary to find the symbol addresses and uprobes needed by
+   * Go tracing. Thread-safe, so that several binaries can be analyzed at once.
+   */
+  StatusOr<GoBinaryAnalysis> AnalyzeGoBinary(const std::string& binary) const;
+
+  /**
+   * Updates the BPF maps with the symbol addresses of a Go binary for the PIDs, and attaches the
+   * binary's uprobes if it hasn't been probed before.
+   * @return Number of uprobes deployed.
+   */
+  int AttachGoUProbes(const std::string& binary, const GoBinaryAnalysis& analysis,
+                      const std::vector<int32_t>& pid_vec);
+
+  // Records that the deployment on the UPIDs is complete.
+  void RecordDeployLatency(const std::vector<md::UPID>& upids);
 
   /**
    * Attaches the required probes for Go HTTP2 tracing to the specified binary, if it is a
    * compatible Go binary.
    *
    * @param binary The path to the binary on which to deploy Go HTTP2 probes.
-   * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
+   * @param analysis The analysis of the binary.
    * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
    *             addresses.
    * @return The number of uprobes deployed, or error. It is not considered an error if the binary
    *         is not a Go binary or doesn't use a Go HTTP2 library; instead the return value will be
    *         zero.
    */
-  StatusOr<int> AttachGoHTTP2Probes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                    obj_tools::DwarfReader* dwarf_reader,
+  StatusOr<int> AttachGoHTTP2Probes(const std::string& binary, const GoBinaryAnalysis& analysis,
                                     const std::vector<int32_t>& pids);
 
   /**
@@ -379,15 +456,13 @@ class UProbeManager {
    * Go binary.
    *
    * @param binary The path to the binary on which to deploy Go HTTP2 probes.
-   * @param elf_reader ELF reader for the binary.
-   * @param dwarf_reader DWARF reader for the binary.
+   * @param analysis The analysis of the binary.
    * @param pids The list of PIDs that are new instances of the binary. Used to populate symbol
    *             addresses.
    * @return The number of uprobes deployed, or error. It is not an error if the binary
    *         is not a Go binary or doesn't use Go TLS; instead the return value will be zero.
    */
-  StatusOr<int> AttachGoTLSUProbes(const std::string& binary, obj_tools::ElfReader* elf_reader,
-                                   obj_tools::DwarfReader* dwarf_reader,
+  StatusOr<int> AttachGoTLSUProbes(const std::string& binary, const GoBinaryAnalysis& analysis,
                                    const std::vector<int32_t>& new_pids);
 
   /**
@@ -411,33 +486,47 @@ class UProbeManager {
   StatusOr<int> AttachNodeJsOpenSSLUprobes(uint32_t pid);
 
   /**
-   * Helper function that calls BCCWrapper.AttachUprobe() from a probe template.
-   * Among other things, it finds all symbol matches as specified in the template,
-   * and attaches a probe per matching symbol.
+   * Returns the analysis of a node executable, from the cache if any copy of the executable has
+   * been analyzed before.
+   *
+   * @param pid A process running the executable, used to get its version.
+   * @param proc_exe The path of the executable in the process' mount namespace.
+   * @param host_proc_exe The path of the executable on the host.
+   */
+  StatusOr<const NodeBinaryAnalysis*> GetNodeBinaryAnalysis(
+      uint32_t pid, const std::filesystem::path& proc_exe,
+      const std::filesystem::path& host_proc_exe);
+
+  /**
+   * Helper function that finds the uprobes described by a probe template.
+   * It finds all symbol matches as specified in the template, with a probe per matching symbol.
    *
    * @param probe_tmpls Array of probe templates to process.
-   * @param binary The binary to uprobe.
    * @param elf_reader Pointer to an elf reader for the binary. Used to find symbol matches.
-   * @return Number of uprobes deployed, or error if uprobes failed to deploy. Zero uprobes
-   *         deploying because there are no symbol matches is not considered an error.
+   * @return The uprobes, without their binary_path, or error. No symbol matches is not
+   *         considered an error.
+   */
+  static StatusOr<std::vector<bpf_tools::UProbeSpec>> ResolveUProbeTmpl(
+      const ArrayView<UProbeTmpl>& probe_tmpls, obj_tools::ElfReader* elf_reader);
+
+  /**
+   * Calls BCCWrapper.AttachUprobe() for each of the uprobes, on the specified binary.
+   *
+   * @return Number of uprobes deployed, or error if uprobes failed to deploy.
    */
-  StatusOr<int> AttachUProbeTmpl(const ArrayView<UProbeTmpl>& probe_tmpls,
-                                 const std::string& binary, obj_tools::ElfReader* elf_reader);
+  StatusOr<int> AttachUProbes(const std::vector<bpf_tools::UProbeSpec>& probes,
+                              const std::string& binary);
 
   // Returns set of PIDs that have had mmap called on them since the last call.
   absl::flat_hash_set<md::UPID> PIDsToRescanForUProbes();
 
   Status UpdateOpenSSLSymAddrs(std::filesystem::path container_lib, uint32_t pid);
-  Status UpdateGoCommonSymAddrs(obj_tools::ElfReader* elf_reader,
-                                obj_tools::DwarfReader* dwarf_reader,
-                                const std::vector<int32_t>& pids);
-  Status UpdateGoHTTP2SymAddrs(obj_tools::ElfReader* elf_reader,
-                               obj_tools::DwarfReader* dwarf_reader,
-                               const std::vector<int32_t>& pids);
-  Status UpdateGoTLSSymAddrs(obj_tools::ElfReader* elf_reader, obj_tools::DwarfReader* dwarf_reader,
+  void UpdateGoCommonSymAddrs(const struct go_common_symaddrs_t& symaddrs,
+                              const std::vector<int32_t>& pids);
+  void UpdateGoHTTP2SymAddrs(const struct go_http2_symaddrs_t& symaddrs,
                              const std::vector<int32_t>& pids);
-  Status UpdateNodeTLSWrapSymAddrs(int32_t pid, const std::filesystem::path& node_exe,
-                                   const SemVer& ver);
+  void UpdateGoTLSSymAddrs(const struct go_tls_symaddrs_t& symaddrs,
+                           const std::vector<int32_t>& pids);
 
   // Clean-up various BPF maps used to communicate symbol addresses per PID.
   // Once the PID has terminated, the information is not required anymore.
@@ -456,6 +545,9 @@ class UProbeManager {
   std::mutex deploy_uprobes_mutex_;
   std::atomic<int> num_deploy_uprobes_threads_ = 0;
 
+  // The start of the current DeployUProbes(), from which deployment latencies are measured.
+  std::chrono::steady_clock::time_point deploy_start_;
+
   std::unique_ptr<system::ProcParser> proc_parser_;
   ProcTracker proc_tracker_;
   LazyLoadedFPResolver fp_resolver_;
@@ -474,11 +566,18 @@ class UProbeManager {
   // TODO(oazizi): How should these sets be cleaned up of old binaries, once they are deleted?
   //               Without clean-up, these could consume more-and-more memory.
   absl::flat_hash_set<std::string> openssl_probed_binaries_;
-  absl::flat_hash_set<std::string> scanned_binaries_;
   absl::flat_hash_set<std::string> go_http2_probed_binaries_;
   absl::flat_hash_set<std::string> go_tls_probed_binaries_;
   absl::flat_hash_set<std::string> nodejs_binaries_;
 
+  // The analysis of every binary seen so far, shared by all the processes that run a copy of it.
+  BinaryAnalysisCache binary_analysis_cache_;
+
+  // The uprobe deployment latency of each live UPID. See DeployLatency().
+  mutable absl::Mutex deploy_latencies_mutex_;
+  absl::flat_hash_map<md::UPID, std::chrono::nanoseconds> deploy_latencies_
+      ABSL_GUARDED_BY(deploy_latencies_mutex_);
+
   // BPF maps through which the addresses of symbols for a given pid are communicated to uprobes.
   std::unique_ptr<UserSpaceManagedBPFMap<uint32_t, struct openssl_symaddrs_t>>
       openssl_symaddrs_map_;
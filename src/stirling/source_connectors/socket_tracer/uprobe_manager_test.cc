@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/socket_tracer/uprobe_manager.h"
+
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::ElementsAre;
+
+TEST(PrioritizeUPIDsTest, BusiestThenMostRecentlyStarted) {
+  const md::UPID old_idle(1, 100, 1000);
+  const md::UPID new_idle(1, 101, 3000);
+  const md::UPID old_busy(1, 102, 2000);
+  const md::UPID new_busy(1, 103, 4000);
+  const md::UPID busiest(1, 104, 500);
+
+  absl::flat_hash_map<uint32_t, int> pid_traffic = {{102, 5}, {103, 5}, {104, 20}};
+
+  EXPECT_THAT(PrioritizeUPIDs({old_idle, new_idle, old_busy, new_busy, busiest}, pid_traffic),
+              ElementsAre(busiest, new_busy, old_busy, new_idle, old_idle));
+}
+
+TEST(PrioritizeUPIDsTest, NoTraffic) {
+  const md::UPID a(1, 100, 1000);
+  const md::UPID b(1, 101, 3000);
+  const md::UPID c(1, 102, 2000);
+
+  EXPECT_THAT(PrioritizeUPIDs({a, b, c}, {}), ElementsAre(b, c, a));
+  EXPECT_THAT(PrioritizeUPIDs({}, {}), ElementsAre());
+}
+
+}  // namespace stirling
+}  // namespace px
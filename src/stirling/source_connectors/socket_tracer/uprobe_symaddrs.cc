@@ -31,6 +31,7 @@
 #include "src/stirling/obj_tools/elf_reader.h"
 #include "src/stirling/utils/detect_application.h"
 
+using ::px::stirling::obj_tools::DwarfIndexMode;
 using ::px::stirling::obj_tools::DwarfReader;
 using ::px::stirling::obj_tools::ElfReader;
 
@@ -746,7 +747,7 @@ StatusOr<struct node_tlswrap_symaddrs_t> NodeTLSWrapSymAddrs(const std::filesyst
   //
   // TODO(yzhao): We can implement "selective caching". The input needs to be a collection of symbol
   // patterns, which means only indexing the matched symbols.
-  auto dwarf_reader_or = DwarfReader::Create(node_exe.string(), /*index*/ false);
+  auto dwarf_reader_or = DwarfReader::Create(node_exe.string(), DwarfIndexMode::kNone);
 
   // Creation might fail if source language cannot be detected, which means that there is no dwarf
   // info.
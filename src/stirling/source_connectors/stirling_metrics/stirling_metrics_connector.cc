@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/stirling_metrics/stirling_metrics_connector.h"
+
+#include <filesystem>
+#include <map>
+#include <string>
+
+#include "src/common/base/file.h"
+#include "src/common/json/json.h"
+
+DEFINE_string(stirling_metrics_prometheus_path,
+              gflags::StringFromEnv("PL_STIRLING_METRICS_PROMETHEUS_PATH", ""),
+              "If set, Stirling's internal metrics are written to this file in the Prometheus "
+              "text format on every push, for a node exporter textfile collector to scrape.");
+
+namespace px {
+namespace stirling {
+
+Status StirlingMetricsConnector::InitImpl() {
+  sampling_freq_mgr_.set_period(kSamplingPeriod);
+  push_freq_mgr_.set_period(kPushPeriod);
+  return Status::OK();
+}
+
+void StirlingMetricsConnector::TransferDataImpl(ConnectorContext* /*ctx*/,
+                                                const std::vector<DataTable*>& data_tables) {
+  DCHECK_EQ(data_tables.size(), 1);
+  DataTable* data_table = data_tables[0];
+
+  if (data_table != nullptr) {
+    const int64_t time = CurrentTimeNS();
+    registry_->ForEach([data_table, time](std::string_view name,
+                                          const utils::MetricsRegistry::Labels& labels,
+                                          const utils::Counter* counter,
+                                          const utils::Histogram* histogram) {
+      DataTable::RecordBuilder<&kStirlingMetricsTable> r(data_table, time);
+      r.Append<r.ColIndex("time_")>(time);
+      r.Append<r.ColIndex("metric")>(std::string(name));
+      r.Append<r.ColIndex("labels")>(
+          ToJSONString(std::map<std::string, std::string>(labels.begin(), labels.end())));
+      if (counter != nullptr) {
+        r.Append<r.ColIndex("value")>(counter->Value());
+        r.Append<r.ColIndex("sum")>(0);
+        r.Append<r.ColIndex("p50")>(0);
+        r.Append<r.ColIndex("p99")>(0);
+        return;
+      }
+      utils::Histogram::Snapshot snapshot = histogram->GetSnapshot();
+      r.Append<r.ColIndex("value")>(snapshot.count);
+      r.Append<r.ColIndex("sum")>(snapshot.sum);
+      r.Append<r.ColIndex("p50")>(static_cast<int64_t>(snapshot.Quantile(0.5)));
+      r.Append<r.ColIndex("p99")>(static_cast<int64_t>(snapshot.Quantile(0.99)));
+    });
+  }
+
+  if (!FLAGS_stirling_metrics_prometheus_path.empty()) {
+    Status s = WritePrometheusFile(FLAGS_stirling_metrics_prometheus_path);
+    LOG_IF(WARNING, !s.ok()) << absl::Substitute("Failed to write the Stirling metrics: $0",
+                                                 s.msg());
+  }
+}
+
+Status StirlingMetricsConnector::WritePrometheusFile(const std::string& path) const {
+  // Write to a temporary file first, so that the scraper never reads a partial file.
+  std::string tmp_path = absl::StrCat(path, ".tmp");
+  PL_RETURN_IF_ERROR(WriteFileFromString(tmp_path, registry_->PrometheusText()));
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    return error::Internal("Could not rename $0 to $1: $2", tmp_path, path, ec.message());
+  }
+  return Status::OK();
+}
+
+}  // namespace stirling
+}  // namespace px
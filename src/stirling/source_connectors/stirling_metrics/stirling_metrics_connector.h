@@ -0,0 +1,73 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/stirling/core/source_connector.h"
+#include "src/stirling/source_connectors/stirling_metrics/stirling_metrics_table.h"
+#include "src/stirling/utils/metrics.h"
+
+DECLARE_string(stirling_metrics_prometheus_path);
+
+namespace px {
+namespace stirling {
+
+/**
+ * StirlingMetricsConnector exports the metrics of the global utils::MetricsRegistry, which
+ * Stirling's components update on their hot paths, into the stirling_metrics table.
+ * If --stirling_metrics_prometheus_path is set, the metrics are also written there in the
+ * Prometheus text format, for a node exporter textfile collector to scrape.
+ */
+class StirlingMetricsConnector : public SourceConnector {
+ public:
+  static constexpr std::string_view kName = "stirling_metrics";
+  static constexpr auto kSamplingPeriod = std::chrono::milliseconds{10000};
+  static constexpr auto kPushPeriod = std::chrono::milliseconds{10000};
+  static constexpr auto kTables = MakeArray(kStirlingMetricsTable);
+
+  StirlingMetricsConnector() = delete;
+  ~StirlingMetricsConnector() override = default;
+
+  static std::unique_ptr<SourceConnector> Create(std::string_view name) {
+    return std::unique_ptr<SourceConnector>(new StirlingMetricsConnector(name));
+  }
+
+  Status InitImpl() override;
+  Status StopImpl() override { return Status::OK(); }
+  void TransferDataImpl(ConnectorContext* ctx, const std::vector<DataTable*>& data_tables) override;
+
+ protected:
+  StirlingMetricsConnector(std::string_view name, const utils::MetricsRegistry* registry)
+      : SourceConnector(name, kTables), registry_(registry) {}
+
+ private:
+  explicit StirlingMetricsConnector(std::string_view name)
+      : StirlingMetricsConnector(name, &utils::MetricsRegistry::Global()) {}
+
+  Status WritePrometheusFile(const std::string& path) const;
+
+  const utils::MetricsRegistry* registry_;
+};
+
+}  // namespace stirling
+}  // namespace px
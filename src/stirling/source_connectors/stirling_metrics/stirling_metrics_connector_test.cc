@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/source_connectors/stirling_metrics/stirling_metrics_connector.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/base/file.h"
+#include "src/common/base/test_utils.h"
+#include "src/stirling/testing/common.h"
+
+namespace px {
+namespace stirling {
+
+using ::testing::HasSubstr;
+
+class TestStirlingMetricsConnector : public StirlingMetricsConnector {
+ public:
+  explicit TestStirlingMetricsConnector(const utils::MetricsRegistry* registry)
+      : StirlingMetricsConnector("stirling_metrics", registry) {}
+};
+
+class StirlingMetricsConnectorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    registry_.GetCounter("events_total", "Events.", {{"protocol", "http"}})->Add(3);
+    utils::Histogram* histogram = registry_.GetHistogram("poll_ns", "Poll time.");
+    for (int i = 0; i < 100; ++i) {
+      histogram->Record(10);
+    }
+
+    connector_ = std::make_unique<TestStirlingMetricsConnector>(&registry_);
+    ASSERT_OK(connector_->Init());
+  }
+
+  void TearDown() override { EXPECT_OK(connector_->Stop()); }
+
+  utils::MetricsRegistry registry_;
+  std::unique_ptr<SourceConnector> connector_;
+  DataTable data_table_{/*id*/ 0, kStirlingMetricsTable};
+  const std::vector<DataTable*> data_tables_{&data_table_};
+};
+
+TEST_F(StirlingMetricsConnectorTest, TransferMetrics) {
+  StandaloneContext ctx;
+  connector_->TransferData(&ctx, data_tables_);
+
+  std::vector<TaggedRecordBatch> tablets = data_table_.ConsumeRecords();
+  ASSERT_EQ(tablets.size(), 1);
+  const types::ColumnWrapperRecordBatch& records = tablets[0].records;
+  ASSERT_EQ(records[0]->Size(), 2);
+
+  constexpr int kMetricIdx = kStirlingMetricsTable.ColIndex("metric");
+  constexpr int kLabelsIdx = kStirlingMetricsTable.ColIndex("labels");
+  constexpr int kValueIdx = kStirlingMetricsTable.ColIndex("value");
+  constexpr int kSumIdx = kStirlingMetricsTable.ColIndex("sum");
+  constexpr int kP50Idx = kStirlingMetricsTable.ColIndex("p50");
+
+  EXPECT_EQ(records[kMetricIdx]->Get<types::StringValue>(0), "events_total");
+  EXPECT_EQ(records[kLabelsIdx]->Get<types::StringValue>(0), R"({"protocol":"http"})");
+  EXPECT_EQ(records[kValueIdx]->Get<types::Int64Value>(0), 3);
+
+  EXPECT_EQ(records[kMetricIdx]->Get<types::StringValue>(1), "poll_ns");
+  EXPECT_EQ(records[kLabelsIdx]->Get<types::StringValue>(1), "{}");
+  EXPECT_EQ(records[kValueIdx]->Get<types::Int64Value>(1), 100);
+  EXPECT_EQ(records[kSumIdx]->Get<types::Int64Value>(1), 1000);
+  EXPECT_EQ(records[kP50Idx]->Get<types::Int64Value>(1), 15);
+}
+
+TEST_F(StirlingMetricsConnectorTest, WritePrometheusFile) {
+  std::string path = absl::StrCat(::testing::TempDir(), "/stirling_metrics.prom");
+  FLAGS_stirling_metrics_prometheus_path = path;
+  StandaloneContext ctx;
+  connector_->TransferData(&ctx, data_tables_);
+  FLAGS_stirling_metrics_prometheus_path = "";
+
+  ASSERT_OK_AND_ASSIGN(std::string contents, ReadFileToString(path));
+  EXPECT_THAT(contents, HasSubstr("events_total{protocol=\"http\"} 3\n"));
+  EXPECT_THAT(contents, HasSubstr("poll_ns_count 100\n"));
+}
+
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "src/stirling/core/canonical_types.h"
+#include "src/stirling/core/source_connector.h"
+
+namespace px {
+namespace stirling {
+
+// clang-format off
+constexpr DataElement kStirlingMetricsElements[] = {
+        canonical_data_elements::kTime,
+        {"metric", "The name of the metric",
+         types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+        {"labels", "The labels of the metric, as a JSON object",
+         types::DataType::STRING, types::SemanticType::ST_NONE, types::PatternType::GENERAL},
+        {"value", "The value of a counter, or the number of values recorded by a histogram",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+        {"sum", "The sum of the values recorded by a histogram",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_COUNTER},
+        {"p50", "The upper bound of the median value recorded by a histogram",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_GAUGE},
+        {"p99", "The upper bound of the 99th percentile value recorded by a histogram",
+         types::DataType::INT64, types::SemanticType::ST_NONE, types::PatternType::METRIC_GAUGE},
+};
+
+constexpr DataTableSchema kStirlingMetricsTable(
+    "stirling_metrics",
+    "Internal metrics of Stirling's data collection, such as the time spent polling the perf "
+    "buffers, and the events and bytes received per protocol. Counters and histogram sums are "
+    "cumulative since the agent started.",
+    kStirlingMetricsElements
+);
+// clang-format on
+DEFINE_PRINT_TABLE(StirlingMetrics);
+
+}  // namespace stirling
+}  // namespace px
@@ -21,21 +21,34 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <utility>
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/match.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/synchronization/notification.h>
+#include <absl/time/time.h>
+
+#include "blockingconcurrentqueue.h"
 
 #include "src/common/base/base.h"
 #include "src/common/perf/elapsed_timer.h"
+#include "src/common/system/cpu_affinity.h"
 #include "src/common/system/system_info.h"
+#include "src/shared/types/type_utils.h"
 
 #include "src/stirling/bpf_tools/probe_cleaner.h"
 #include "src/stirling/core/data_table.h"
+#include "src/stirling/core/overload_controller.h"
 #include "src/stirling/core/pub_sub_manager.h"
 #include "src/stirling/core/source_connector.h"
 #include "src/stirling/core/source_registry.h"
@@ -44,6 +57,7 @@
 #include "src/stirling/source_connectors/dynamic_bpftrace/dynamic_bpftrace_connector.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_trace_connector.h"
 #include "src/stirling/source_connectors/jvm_stats/jvm_stats_connector.h"
+#include "src/stirling/source_connectors/load_gen/load_gen_connector.h"
 #include "src/stirling/source_connectors/network_stats/network_stats_connector.h"
 #include "src/stirling/source_connectors/perf_profiler/perf_profile_connector.h"
 #include "src/stirling/source_connectors/pid_runtime/pid_runtime_connector.h"
@@ -52,14 +66,33 @@
 #include "src/stirling/source_connectors/process_stats/process_stats_connector.h"
 #include "src/stirling/source_connectors/seq_gen/seq_gen_connector.h"
 #include "src/stirling/source_connectors/socket_tracer/socket_trace_connector.h"
+#include "src/stirling/source_connectors/stirling_metrics/stirling_metrics_connector.h"
 
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/dynamic_tracer.h"
 
+DEFINE_bool(stirling_parallel_source_init,
+            gflags::BoolFromEnv("PL_STIRLING_PARALLEL_SOURCE_INIT", false),
+            "If true, the source connectors are initialized concurrently at startup, instead of "
+            "one after the other. The sources that use BPF are still initialized one at a time.");
+DEFINE_bool(stirling_shared_dynamic_trace_worker,
+            gflags::BoolFromEnv("PL_STIRLING_SHARED_DYNAMIC_TRACE_WORKER", true),
+            "If true, all the dynamic tracing sources are sampled and pushed by one shared worker "
+            "thread, instead of a thread per deployed tracepoint.");
+DEFINE_uint64(stirling_push_queue_max_batches,
+              gflags::Uint64FromEnv("PL_STIRLING_PUSH_QUEUE_MAX_BATCHES", 4096),
+              "The most record batches waiting to be pushed to the agent. Batches that are pushed "
+              "by the sources while the queue is full are dropped.");
+DEFINE_string(stirling_cpus, gflags::StringFromEnv("PL_STIRLING_CPUS", ""),
+              "The CPUs that Stirling's threads run on, as a CPU list such as \"0-3,8-11\". If "
+              "empty, they run on any of the process's CPUs.");
+
 namespace px {
 namespace stirling {
 
 namespace {
 
+constexpr char kDynTraceSourcePrefix[] = "DT_";
+
 #define REGISTRY_PAIR(source) \
   { source::kName, SourceRegistry::CreateRegistryElement<source>() }
 const absl::flat_hash_map<std::string_view, SourceRegistry::RegistryElement> kAllSources = {
@@ -67,7 +100,8 @@ const absl::flat_hash_map<std::string_view, SourceRegistry::RegistryElement> kAl
     REGISTRY_PAIR(ProcStatConnector),          REGISTRY_PAIR(SeqGenConnector),
     REGISTRY_PAIR(SocketTraceConnector),       REGISTRY_PAIR(ProcessStatsConnector),
     REGISTRY_PAIR(NetworkStatsConnector),      REGISTRY_PAIR(PerfProfileConnector),
-    REGISTRY_PAIR(PIDCPUUseBPFTraceConnector),
+    REGISTRY_PAIR(PIDCPUUseBPFTraceConnector), REGISTRY_PAIR(StirlingMetricsConnector),
+    REGISTRY_PAIR(LoadGenConnector),
 };
 #undef REGISTRY_PAIR
 
@@ -84,9 +118,12 @@ absl::flat_hash_set<std::string_view> GetSourceNamesForGroup(SourceConnectorGrou
         NetworkStatsConnector::kName,
         JVMStatsConnector::kName,
         SocketTraceConnector::kName,
-        PerfProfileConnector::kName
+        PerfProfileConnector::kName,
+        StirlingMetricsConnector::kName
       };
     case SourceConnectorGroup::kAll:
+      // Leaves out the LoadGenConnector, which writes to the http_events table of the
+      // SocketTraceConnector.
       return {
         ProcessStatsConnector::kName,
         NetworkStatsConnector::kName,
@@ -95,7 +132,8 @@ absl::flat_hash_set<std::string_view> GetSourceNamesForGroup(SourceConnectorGrou
         ProcStatConnector::kName,
         SeqGenConnector::kName,
         SocketTraceConnector::kName,
-        PerfProfileConnector::kName
+        PerfProfileConnector::kName,
+        StirlingMetricsConnector::kName
       };
     case SourceConnectorGroup::kTracers:
       return {
@@ -105,7 +143,8 @@ absl::flat_hash_set<std::string_view> GetSourceNamesForGroup(SourceConnectorGrou
       return {
         ProcessStatsConnector::kName,
         NetworkStatsConnector::kName,
-        JVMStatsConnector::kName
+        JVMStatsConnector::kName,
+        StirlingMetricsConnector::kName
       };
     case SourceConnectorGroup::kProfiler:
       return {
@@ -145,6 +184,34 @@ struct SourceOutput {
   std::vector<DataTable*> data_tables;
 };
 
+// Runs the sampling and push schedule of one source connector on its own thread, so that a slow
+// TransferData() of one source doesn't delay the others.
+struct SourceWorker {
+  SourceConnector* source = nullptr;
+  SourceOutput output;
+
+  // Run by the shared worker thread, along with the other shared workers, instead of by a thread of
+  // its own. Used for the dynamic tracing sources, of which there may be many, each mostly idle.
+  bool shared = false;
+
+  std::thread thread;
+  // Notified to stop the thread. A new one is created every time the thread is started.
+  std::unique_ptr<absl::Notification> stop;
+
+  // Held while the source transfers or pushes data, and by the debug calls into the source.
+  absl::Mutex source_lock;
+
+  absl::base_internal::SpinLock stats_lock;
+  SourceLoopStats stats ABSL_GUARDED_BY(stats_lock);
+};
+
+// A record batch pushed by a source worker, waiting to be passed on to the agent.
+struct QueuedRecordBatch {
+  uint32_t table_id = 0;
+  types::TabletID tablet_id;
+  std::unique_ptr<types::ColumnWrapperRecordBatch> records;
+};
+
 class StirlingImpl final : public Stirling {
  public:
   explicit StirlingImpl(std::unique_ptr<SourceRegistry> registry);
@@ -162,6 +229,9 @@ class StirlingImpl final : public Stirling {
       std::unique_ptr<dynamic_tracing::ir::logical::TracepointDeployment> program) override;
   StatusOr<stirlingpb::Publish> GetTracepointInfo(sole::uuid trace_id) override;
   Status RemoveTracepoint(sole::uuid trace_id) override;
+  Status StartProfilingSession(const std::vector<md::UPID>& upids,
+                               std::chrono::milliseconds sampling_period,
+                               std::chrono::milliseconds duration) override;
   void GetPublishProto(stirlingpb::Publish* publish_pb) override;
   void RegisterDataPushCallback(DataPushCallback f) override { data_push_callback_ = f; }
   void RegisterAgentMetadataCallback(AgentMetadataCallback f) override {
@@ -181,6 +251,10 @@ class StirlingImpl final : public Stirling {
   void EnablePIDTrace(int pid);
   void DisablePIDTrace(int pid);
 
+  std::vector<SourceLoopStats> GetSourceLoopStats() const override;
+  PushQueueStats GetPushQueueStats() const override;
+  OverloadLevel overload_level() const override { return overload_level_; }
+
  private:
   // Create data source connectors from the registered sources.
   Status CreateSourceConnectors();
@@ -188,9 +262,16 @@ class StirlingImpl final : public Stirling {
   // Adds a source to Stirling, and updates all state accordingly.
   Status AddSource(std::unique_ptr<SourceConnector> source);
 
+  // Adds a source that was already initialized, in init_time.
+  void RegisterSource(std::unique_ptr<SourceConnector> source,
+                      std::chrono::microseconds init_time);
+
   // Removes a source and all its info classes from stirling.
   Status RemoveSource(std::string_view source_name);
 
+  std::vector<std::unique_ptr<SourceConnector>>::iterator FindSource(std::string_view source_name)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(info_class_mgrs_lock_);
+
   // Creates and deploys dynamic tracing source.
   void DeployDynamicTraceConnector(
       sole::uuid trace_id,
@@ -202,6 +283,43 @@ class StirlingImpl final : public Stirling {
   // Main run implementation.
   void RunCore();
 
+  // Starts and stops the thread of a source worker. Shared workers are instead added to and removed
+  // from the shared worker thread, which is started along with the first of them.
+  void StartSourceWorker(SourceWorker* worker);
+  void StopSourceWorker(SourceWorker* worker);
+  void StopSharedSourceWorker();
+
+  // Sampling and push loop of a source worker.
+  void RunSourceWorker(SourceWorker* worker);
+
+  // Sampling and push loop of all the shared source workers.
+  void RunSharedSourceWorker();
+
+  // Samples and pushes the data of the source, if due. Returns how long until it is due again.
+  std::chrono::milliseconds RunSourceIteration(SourceWorker* worker,
+                                               const DataPushCallback& enqueue);
+
+  // Queues the record batches pushed by a source worker.
+  Status EnqueueRecordBatch(uint32_t table_id, types::TabletID tablet_id,
+                            std::unique_ptr<types::ColumnWrapperRecordBatch> records);
+
+  // Passes the record batches queued by the source workers on to the agent. Batches of the same
+  // table and tablet that were dequeued together are merged into one push.
+  // Returns false if nothing was queued within the timeout.
+  bool PushQueuedData(std::chrono::milliseconds timeout);
+
+  // The context shared by all the source workers, refreshed by RunCore().
+  std::shared_ptr<ConnectorContext> CurrentContext();
+
+  // Records how much later than planned a source worker woke up.
+  void RecordTickOvershoot(std::chrono::steady_clock::duration overshoot);
+  // Restricts the calling thread to --stirling_cpus. The threads that it creates inherit them.
+  void PinThread() const;
+
+  // Feeds the signals since the previous call to the overload controller, and applies the level
+  // that it steps to on all sources. Called periodically by RunCore().
+  void UpdateOverloadLevel();
+
   // Wait for Stirling to stop its main loop.
   void WaitForStop();
 
@@ -213,13 +331,46 @@ class StirlingImpl final : public Stirling {
   std::vector<std::unique_ptr<SourceConnector>> sources_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
 
   // TODO(yzhao): Move InfoClassManager objects into SourceConnector, and remove this map.
-  absl::flat_hash_map<SourceConnector*, SourceOutput> source_output_map_
+  absl::flat_hash_map<SourceConnector*, std::unique_ptr<SourceWorker>> source_workers_
       ABSL_GUARDED_BY(info_class_mgrs_lock_);
 
+  // Whether RunCore() has started the source workers, in which case sources that are added later
+  // start their workers right away.
+  bool workers_running_ ABSL_GUARDED_BY(info_class_mgrs_lock_) = false;
+
+  // The shared source workers, and the thread that runs them. The lock is held for a whole pass
+  // over the workers, so a worker is not run anymore once it's removed.
+  absl::Mutex shared_workers_lock_;
+  std::vector<SourceWorker*> shared_workers_ ABSL_GUARDED_BY(shared_workers_lock_);
+  std::thread shared_worker_thread_;
+  std::unique_ptr<absl::Notification> shared_worker_stop_;
+
   InfoClassManagerVec info_class_mgrs_ ABSL_GUARDED_BY(info_class_mgrs_lock_);
 
   // Lock to protect both info_class_mgrs_ and sources_.
-  absl::base_internal::SpinLock info_class_mgrs_lock_;
+  mutable absl::base_internal::SpinLock info_class_mgrs_lock_;
+
+  // Record batches pushed by the source workers. RunCore() is the single consumer, which calls
+  // data_push_callback_.
+  moodycamel::BlockingConcurrentQueue<QueuedRecordBatch> push_queue_;
+  std::atomic<uint64_t> num_pushes_ = 0;
+  std::atomic<uint64_t> num_batches_merged_ = 0;
+  std::atomic<uint64_t> num_batches_dropped_ = 0;
+  std::atomic<uint64_t> num_rows_dropped_ = 0;
+
+  // Parsed from --stirling_cpus. Empty if Stirling's threads aren't pinned.
+  std::vector<int> cpus_;
+
+  // Only used by RunCore(), except for the level and the overshoot.
+  OverloadController overload_controller_;
+  std::optional<std::filesystem::path> cpu_stat_path_;
+  std::optional<CPUThrottleStats> prev_throttle_stats_;
+  std::atomic<OverloadLevel> overload_level_ = OverloadLevel::kNone;
+  // The highest overshoot recorded since the previous UpdateOverloadLevel().
+  std::atomic<int64_t> max_tick_overshoot_ms_ = 0;
+
+  absl::base_internal::SpinLock context_lock_;
+  std::shared_ptr<ConnectorContext> context_ ABSL_GUARDED_BY(context_lock_);
 
   std::unique_ptr<SourceRegistry> registry_;
 
@@ -336,6 +487,55 @@ void StirlingImpl::RegisterUserDebugSignalHandlers(int signum) {
   sigaction(signum, &sigaction_specs, NULL);
 }
 
+namespace {
+
+// Initializes the source, and reports how long it took.
+Status InitSource(SourceConnector* source, std::chrono::microseconds* init_time) {
+  ElapsedTimer timer;
+  timer.Start();
+  Status s = source->Init();
+  *init_time = std::chrono::microseconds(timer.ElapsedTime_us());
+  LOG(INFO) << absl::Substitute("Source connector $0 $1 in $2 ms.", source->name(),
+                                s.ok() ? "initialized" : "failed to initialize",
+                                init_time->count() / 1000.0);
+  return s;
+}
+
+struct SourceInit {
+  std::string registry_name;
+  std::unique_ptr<SourceConnector> source;
+  Status status;
+  std::chrono::microseconds time{0};
+};
+
+// Initializes every source on its own thread, except for the sources that use BPF, which share
+// a single thread, since they share the BPF compiler and the Linux headers setup.
+// Startup then takes as long as the slowest source, or all the BPF sources together, rather than
+// all the sources together.
+void InitSourcesConcurrently(std::vector<SourceInit>* inits) {
+  std::vector<SourceInit*> bpf_inits;
+  std::vector<std::thread> threads;
+  for (SourceInit& init : *inits) {
+    if (init.source->UsesBPF()) {
+      bpf_inits.push_back(&init);
+      continue;
+    }
+    threads.emplace_back([&init]() { init.status = InitSource(init.source.get(), &init.time); });
+  }
+  if (!bpf_inits.empty()) {
+    threads.emplace_back([&bpf_inits]() {
+      for (SourceInit* init : bpf_inits) {
+        init->status = InitSource(init->source.get(), &init->time);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
 Status StirlingImpl::Init() {
   system::LogSystemInfo();
 
@@ -352,10 +552,30 @@ Status StirlingImpl::Init() {
     return error::NotFound("Source registry doesn't exist");
   }
 
-  for (const auto& [name, registry_element] : registry_->sources()) {
-    Status s = AddSource(registry_element.create_source_fn(name));
-    LOG_IF(DFATAL, !s.ok()) << absl::Substitute(
-        "Source Connector (registry name=$0) not instantiated, error: $1", name, s.ToString());
+  if (!FLAGS_stirling_cpus.empty()) {
+    PL_ASSIGN_OR_RETURN(cpus_, system::ParseCPUList(FLAGS_stirling_cpus));
+  }
+
+  if (FLAGS_stirling_parallel_source_init) {
+    std::vector<SourceInit> inits;
+    for (const auto& [name, registry_element] : registry_->sources()) {
+      inits.push_back({std::string(name), registry_element.create_source_fn(name)});
+    }
+    InitSourcesConcurrently(&inits);
+    for (SourceInit& init : inits) {
+      if (init.status.ok()) {
+        RegisterSource(std::move(init.source), init.time);
+      }
+      LOG_IF(DFATAL, !init.status.ok())
+          << absl::Substitute("Source Connector (registry name=$0) not instantiated, error: $1",
+                              init.registry_name, init.status.ToString());
+    }
+  } else {
+    for (const auto& [name, registry_element] : registry_->sources()) {
+      Status s = AddSource(registry_element.create_source_fn(name));
+      LOG_IF(DFATAL, !s.ok()) << absl::Substitute(
+          "Source Connector (registry name=$0) not instantiated, error: $1", name, s.ToString());
+    }
   }
   LOG(INFO) << "Stirling successfully initialized.";
   return Status::OK();
@@ -383,8 +603,15 @@ std::vector<DataTable*> GetDataTables(const std::vector<InfoClassManager*>& info
 
 Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
   // Step 1: Init the source.
-  PL_RETURN_IF_ERROR(source->Init());
+  std::chrono::microseconds init_time;
+  PL_RETURN_IF_ERROR(InitSource(source.get(), &init_time));
+
+  RegisterSource(std::move(source), init_time);
+  return Status::OK();
+}
 
+void StirlingImpl::RegisterSource(std::unique_ptr<SourceConnector> source,
+                                  std::chrono::microseconds init_time) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
   std::vector<InfoClassManager*> mgrs;
@@ -400,22 +627,56 @@ Status StirlingImpl::AddSource(std::unique_ptr<SourceConnector> source) {
 
   std::vector<DataTable*> data_tables = GetDataTables(mgrs);
 
-  source_output_map_[source.get()] = {std::move(mgrs),
-                                      // DataTable objects are created after subscribing.
-                                      std::move(data_tables)};
+  auto worker = std::make_unique<SourceWorker>();
+  worker->source = source.get();
+  worker->shared = FLAGS_stirling_shared_dynamic_trace_worker &&
+                   absl::StartsWith(source->name(), kDynTraceSourcePrefix);
+  worker->output = {std::move(mgrs),
+                    // DataTable objects are created after subscribing.
+                    std::move(data_tables)};
+  {
+    absl::base_internal::SpinLockHolder stats_lock(&worker->stats_lock);
+    worker->stats.init_time = init_time;
+  }
+  source->SetOverloadLevel(overload_level_);
+  if (workers_running_) {
+    StartSourceWorker(worker.get());
+  }
+  source_workers_[source.get()] = std::move(worker);
   sources_.push_back(std::move(source));
+}
 
-  return Status::OK();
+std::vector<std::unique_ptr<SourceConnector>>::iterator StirlingImpl::FindSource(
+    std::string_view source_name) {
+  return std::find_if(sources_.begin(), sources_.end(),
+                      [&source_name](const std::unique_ptr<SourceConnector>& s) {
+                        return s->name() == source_name;
+                      });
 }
 
 Status StirlingImpl::RemoveSource(std::string_view source_name) {
+  // Stop the source's worker first, outside of the lock, since it may be in the middle of a
+  // slow TransferData().
+  std::unique_ptr<SourceWorker> worker;
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    auto source_iter = FindSource(source_name);
+    if (source_iter == sources_.end()) {
+      return error::Internal("RemoveSource(): could not find source with name=$0", source_name);
+    }
+    auto worker_node = source_workers_.extract(source_iter->get());
+    if (!worker_node.empty()) {
+      worker = std::move(worker_node.mapped());
+    }
+  }
+  if (worker != nullptr) {
+    StopSourceWorker(worker.get());
+  }
+
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
 
   // Find the source.
-  auto source_iter = std::find_if(sources_.begin(), sources_.end(),
-                                  [&source_name](const std::unique_ptr<SourceConnector>& s) {
-                                    return s->name() == source_name;
-                                  });
+  auto source_iter = FindSource(source_name);
   if (source_iter == sources_.end()) {
     return error::Internal("RemoveSource(): could not find source with name=$0", source_name);
   }
@@ -430,7 +691,6 @@ Status StirlingImpl::RemoveSource(std::string_view source_name) {
 
   // Now perform the removal.
   PL_RETURN_IF_ERROR(source->Stop());
-  source_output_map_.erase(source.get());
   sources_.erase(source_iter);
 
   return Status::OK();
@@ -460,8 +720,6 @@ Status StirlingImpl::RemoveSource(std::string_view source_name) {
 
 namespace {
 
-constexpr char kDynTraceSourcePrefix[] = "DT_";
-
 StatusOr<std::unique_ptr<SourceConnector>> CreateDynamicSourceConnector(
     sole::uuid trace_id,
     dynamic_tracing::ir::logical::TracepointDeployment* tracepoint_deployment) {
@@ -492,6 +750,8 @@ StatusOr<std::unique_ptr<SourceConnector>> CreateDynamicSourceConnector(
 void StirlingImpl::DeployDynamicTraceConnector(
     sole::uuid trace_id,
     std::unique_ptr<dynamic_tracing::ir::logical::TracepointDeployment> program) {
+  PinThread();
+
   auto timer = ElapsedTimer();
   timer.Start();
 
@@ -613,6 +873,18 @@ Status StirlingImpl::RemoveTracepoint(sole::uuid trace_id) {
   return Status::OK();
 }
 
+Status StirlingImpl::StartProfilingSession(const std::vector<md::UPID>& upids,
+                                           std::chrono::milliseconds sampling_period,
+                                           std::chrono::milliseconds duration) {
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  auto source_iter = FindSource(PerfProfileConnector::kName);
+  if (source_iter == sources_.end()) {
+    return error::NotFound("The $0 source is not running.", PerfProfileConnector::kName);
+  }
+  auto* profiler = static_cast<PerfProfileConnector*>(source_iter->get());
+  return profiler->StartTargetedSession(upids, sampling_period, duration);
+}
+
 void StirlingImpl::GetPublishProto(stirlingpb::Publish* publish_pb) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
   PopulatePublishProto(publish_pb, info_class_mgrs_);
@@ -676,30 +948,53 @@ namespace {
 static constexpr std::chrono::milliseconds kMinSleepDuration{1};
 static constexpr std::chrono::milliseconds kMaxSleepDuration{1000};
 
-// Helper function: Figure out when to wake up next.
-std::chrono::milliseconds TimeUntilNextTick(
-    const absl::flat_hash_map<SourceConnector*, SourceOutput> source_output_map) {
-  // The amount to sleep depends on when the earliest Source needs to be sampled again.
+// How often RunCore() refreshes the context shared by the source workers.
+static constexpr std::chrono::milliseconds kContextRefreshPeriod{100};
+
+// How often RunCore() evaluates whether Stirling is overloaded.
+static constexpr std::chrono::seconds kOverloadEvalPeriod{5};
+
+// How long RunCore() waits for queued data before checking whether it should stop.
+static constexpr std::chrono::milliseconds kPushQueueTimeout{10};
+
+// The most record batches passed on to the agent per wake-up of RunCore().
+static constexpr size_t kMaxPushBatches = 64;
+
+template <typename TValueType>
+void AppendColumn(types::ColumnWrapper* src, types::ColumnWrapper* dst) {
+  auto* values = static_cast<TValueType*>(src->UnsafeRawData());
+  dst->Reserve(dst->Size() + src->Size());
+  for (size_t i = 0; i < src->Size(); ++i) {
+    dst->AppendNoTypeCheck(std::move(values[i]));
+  }
+}
+
+// Moves the rows of src to the end of dst, which has the same columns.
+void AppendRecords(types::ColumnWrapperRecordBatch* src, types::ColumnWrapperRecordBatch* dst) {
+  DCHECK_EQ(src->size(), dst->size());
+  for (size_t i = 0; i < src->size(); ++i) {
+    types::ColumnWrapper* src_col = (*src)[i].get();
+    types::ColumnWrapper* dst_col = (*dst)[i].get();
+#define TYPE_CASE(_dt_) AppendColumn<types::DataTypeTraits<_dt_>::value_type>(src_col, dst_col);
+    PL_SWITCH_FOREACH_DATATYPE(dst_col->data_type(), TYPE_CASE);
+#undef TYPE_CASE
+  }
+}
+
+// Helper function: Figure out when the source needs to wake up next.
+std::chrono::milliseconds TimeUntilNextTick(const SourceConnector& source) {
+  // The amount to sleep depends on when the Source needs to be sampled or pushed again.
   // Do this to avoid burning CPU cycles unnecessarily
   auto now = px::chrono::coarse_steady_clock::now();
 
   // Worst case, wake-up every so often.
-  // This is important if there are no subscribed info classes, to avoid sleeping eternally.
   auto wakeup_time = now + kMaxSleepDuration;
-  for (const auto& [source, output] : source_output_map) {
-    wakeup_time = std::min(wakeup_time, source->sampling_freq_mgr().next());
-    wakeup_time = std::min(wakeup_time, source->push_freq_mgr().next());
-  }
+  wakeup_time = std::min(wakeup_time, source.sampling_freq_mgr().next());
+  wakeup_time = std::min(wakeup_time, source.push_freq_mgr().next());
 
   return std::chrono::duration_cast<std::chrono::milliseconds>(wakeup_time - now);
 }
 
-void SleepForDuration(std::chrono::milliseconds sleep_duration) {
-  if (sleep_duration > kMinSleepDuration) {
-    std::this_thread::sleep_for(sleep_duration);
-  }
-}
-
 // Returns true if any of the input tables are beyond the threshold.
 bool DataExceedsThreshold(const std::vector<DataTable*>& data_tables) {
   // Data push threshold, based on percentage of buffer that is filled.
@@ -722,55 +1017,340 @@ bool DataExceedsThreshold(const std::vector<DataTable*>& data_tables) {
 }  // namespace
 
 // Main Data Collector loop.
-// Poll on Data Source Through connectors, when appropriate, then go to sleep.
+// Starts a worker thread per source, that samples and pushes the source's data on its own
+// schedule. This thread then passes the pushed data on to the agent until it's stopped.
 // Must run as a thread, so only call from Run() as a thread.
+void StirlingImpl::PinThread() const {
+  if (cpus_.empty()) {
+    return;
+  }
+  Status s = system::SetCurrentThreadAffinity(cpus_);
+  LOG_IF(WARNING, !s.ok()) << absl::Substitute("Could not pin thread to --stirling_cpus=$0: $1",
+                                               FLAGS_stirling_cpus, s.msg());
+}
+
 void StirlingImpl::RunCore() {
   running_ = true;
+  // The source workers, and the threads that the sources create, start from here.
+  PinThread();
 
   // First initialize each info class manager with context.
   {
     absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-    std::unique_ptr<ConnectorContext> initial_context = GetContext();
+    std::shared_ptr<ConnectorContext> initial_context = GetContext();
+    initial_context->DiffUPIDs(nullptr);
     for (const auto& s : sources_) {
       s->InitContext(initial_context.get());
     }
+    {
+      absl::base_internal::SpinLockHolder context_lock(&context_lock_);
+      context_ = std::move(initial_context);
+    }
+    for (auto& [source, worker] : source_workers_) {
+      StartSourceWorker(worker.get());
+    }
+    workers_running_ = true;
   }
   // TODO(oazizi): We need to call InitContext on dynamic sources too. Fix.
 
+  if (FLAGS_stirling_overload_control) {
+    cpu_stat_path_ = FindCPUStatPath();
+    LOG(INFO) << absl::Substitute("Overload control reads CPU throttling from: $0",
+                                  cpu_stat_path_.has_value() ? cpu_stat_path_->string() : "none");
+    UpdateOverloadLevel();
+  }
+
+  auto context_time = std::chrono::steady_clock::now();
+  auto overload_eval_time = context_time;
   while (run_enable_) {
-    auto sleep_duration = std::chrono::milliseconds::zero();
+    // Update the context/state shared by the source workers.
+    // Note that if no changes are present, the same metadata will be returned back.
+    auto now = std::chrono::steady_clock::now();
+    if (now - context_time >= kContextRefreshPeriod) {
+      std::shared_ptr<ConnectorContext> ctx = GetContext();
+      // The delta is computed once here, instead of by each connector that tracks the UPIDs.
+      ctx->DiffUPIDs(CurrentContext().get());
+      absl::base_internal::SpinLockHolder context_lock(&context_lock_);
+      context_ = std::move(ctx);
+      context_time = now;
+    }
+
+    if (FLAGS_stirling_overload_control && now - overload_eval_time >= kOverloadEvalPeriod) {
+      UpdateOverloadLevel();
+      overload_eval_time = now;
+    }
+
+    PushQueuedData(kPushQueueTimeout);
+  }
+
+  // As in RemoveSource(), the workers are joined outside of the lock, since they may be in the
+  // middle of a slow TransferData(). They're taken out of the map meanwhile, and put back for the
+  // sources that weren't removed by then.
+  absl::flat_hash_map<SourceConnector*, std::unique_ptr<SourceWorker>> workers;
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    workers_running_ = false;
+    workers.swap(source_workers_);
+  }
+  for (auto& [source, worker] : workers) {
+    StopSourceWorker(worker.get());
+  }
+  StopSharedSourceWorker();
+  {
+    absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+    for (auto& [source, worker] : workers) {
+      SourceConnector* worker_source = source;
+      bool source_exists =
+          std::any_of(sources_.begin(), sources_.end(),
+                      [worker_source](const auto& s) { return s.get() == worker_source; });
+      if (source_exists) {
+        source_workers_[worker_source] = std::move(worker);
+      }
+    }
+  }
+  // Pass on the data that the workers pushed before they stopped.
+  while (PushQueuedData(std::chrono::milliseconds::zero())) {
+  }
+  running_ = false;
+}
+
+void StirlingImpl::StartSourceWorker(SourceWorker* worker) {
+  if (worker->shared) {
+    absl::MutexLock lock(&shared_workers_lock_);
+    shared_workers_.push_back(worker);
+    if (!shared_worker_thread_.joinable()) {
+      shared_worker_stop_ = std::make_unique<absl::Notification>();
+      shared_worker_thread_ = std::thread(&StirlingImpl::RunSharedSourceWorker, this);
+    }
+    return;
+  }
+  DCHECK(!worker->thread.joinable());
+  worker->stop = std::make_unique<absl::Notification>();
+  worker->thread = std::thread(&StirlingImpl::RunSourceWorker, this, worker);
+}
 
-    // Update the context/state on each iteration.
-    // Note that if no changes are present, the same pointer will be returned back.
-    // TODO(oazizi): If context constructor does a lot of work (e.g. ListUPIDs()),
-    //               then there might be an inefficiency here, since we don't know if
-    //               mgr->SamplingRequired() will be true for any manager.
-    std::unique_ptr<ConnectorContext> ctx = GetContext();
+void StirlingImpl::StopSourceWorker(SourceWorker* worker) {
+  if (worker->shared) {
+    absl::MutexLock lock(&shared_workers_lock_);
+    shared_workers_.erase(std::remove(shared_workers_.begin(), shared_workers_.end(), worker),
+                          shared_workers_.end());
+    return;
+  }
+  if (!worker->thread.joinable()) {
+    return;
+  }
+  worker->stop->Notify();
+  worker->thread.join();
+}
+
+void StirlingImpl::StopSharedSourceWorker() {
+  if (!shared_worker_thread_.joinable()) {
+    return;
+  }
+  shared_worker_stop_->Notify();
+  shared_worker_thread_.join();
+}
+
+Status StirlingImpl::EnqueueRecordBatch(uint32_t table_id, types::TabletID tablet_id,
+                                        std::unique_ptr<types::ColumnWrapperRecordBatch> records) {
+  if (push_queue_.size_approx() >= FLAGS_stirling_push_queue_max_batches) {
+    // Dropping the data is better than holding up the sources, whose BPF buffers would overflow.
+    ++num_batches_dropped_;
+    num_rows_dropped_ += records->empty() ? 0 : records->front()->Size();
+    return Status::OK();
+  }
+  push_queue_.enqueue(QueuedRecordBatch{table_id, std::move(tablet_id), std::move(records)});
+  return Status::OK();
+}
+
+std::chrono::milliseconds StirlingImpl::RunSourceIteration(SourceWorker* worker,
+                                                           const DataPushCallback& enqueue) {
+  SourceConnector* source = worker->source;
+  auto start = std::chrono::steady_clock::now();
+  bool did_work = false;
+  std::chrono::milliseconds sleep_duration;
+  std::chrono::milliseconds sampling_period;
+  uint64_t num_shortened = 0;
+  uint64_t num_lengthened = 0;
+  {
+    absl::MutexLock lock(&worker->source_lock);
 
+    // Phase 1: Probe the source for its data.
+    if (source->sampling_freq_mgr().Expired()) {
+      std::shared_ptr<ConnectorContext> ctx = CurrentContext();
+      source->TransferData(ctx.get(), worker->output.data_tables);
+      did_work = true;
+    }
+    // Phase 2: Hand the data off to be pushed upstream.
+    if (source->push_freq_mgr().Expired() || DataExceedsThreshold(worker->output.data_tables)) {
+      source->PushData(enqueue, worker->output.data_tables);
+      did_work = true;
+    }
+
+    // Figure out how long to sleep.
+    sleep_duration = TimeUntilNextTick(*source);
+
+    sampling_period = source->sampling_freq_mgr().period();
+    const auto* controller = source->sampling_period_controller();
+    if (controller != nullptr) {
+      num_shortened = controller->num_shortened();
+      num_lengthened = controller->num_lengthened();
+    }
+  }
+
+  if (did_work) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    absl::base_internal::SpinLockHolder lock(&worker->stats_lock);
+    SourceLoopStats& stats = worker->stats;
+    ++stats.num_iterations;
+    stats.last_iteration_time = elapsed;
+    stats.max_iteration_time = std::max(stats.max_iteration_time, elapsed);
+    stats.total_iteration_time += elapsed;
+    stats.sampling_period = sampling_period;
+    stats.num_sampling_period_shortened = num_shortened;
+    stats.num_sampling_period_lengthened = num_lengthened;
+  }
+
+  return sleep_duration;
+}
+
+void StirlingImpl::RunSourceWorker(SourceWorker* worker) {
+  // Workers of sources that are registered later are started from other threads.
+  PinThread();
+
+  DataPushCallback enqueue = [this](uint32_t table_id, types::TabletID tablet_id,
+                                    std::unique_ptr<types::ColumnWrapperRecordBatch> records) {
+    return EnqueueRecordBatch(table_id, std::move(tablet_id), std::move(records));
+  };
+
+  while (!worker->stop->HasBeenNotified()) {
+    std::chrono::milliseconds sleep_duration = RunSourceIteration(worker, enqueue);
+    if (sleep_duration > kMinSleepDuration) {
+      auto wakeup_time = std::chrono::steady_clock::now() + sleep_duration;
+      worker->stop->WaitForNotificationWithTimeout(absl::FromChrono(sleep_duration));
+      RecordTickOvershoot(std::chrono::steady_clock::now() - wakeup_time);
+    }
+  }
+}
+
+void StirlingImpl::RunSharedSourceWorker() {
+  PinThread();
+
+  DataPushCallback enqueue = [this](uint32_t table_id, types::TabletID tablet_id,
+                                    std::unique_ptr<types::ColumnWrapperRecordBatch> records) {
+    return EnqueueRecordBatch(table_id, std::move(tablet_id), std::move(records));
+  };
+
+  while (!shared_worker_stop_->HasBeenNotified()) {
+    // Sleep until the first of the shared sources is due.
+    std::chrono::milliseconds sleep_duration = kMaxSleepDuration;
     {
-      // Acquire spin lock to go through one iteration of sampling and pushing data.
-      // Needed to avoid race with main thread update info_class_mgrs_ on new subscription.
-      absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-
-      // Run through every SourceConnector and InfoClassManager being managed.
-      for (auto& [source, output] : source_output_map_) {
-        // Phase 1: Probe each source for its data.
-        if (source->sampling_freq_mgr().Expired()) {
-          source->TransferData(ctx.get(), output.data_tables);
-        }
-        // Phase 2: Push Data upstream.
-        if (source->push_freq_mgr().Expired() || DataExceedsThreshold(output.data_tables)) {
-          source->PushData(data_push_callback_, output.data_tables);
-        }
+      absl::MutexLock lock(&shared_workers_lock_);
+      for (SourceWorker* worker : shared_workers_) {
+        sleep_duration = std::min(sleep_duration, RunSourceIteration(worker, enqueue));
       }
+    }
+    if (sleep_duration > kMinSleepDuration) {
+      auto wakeup_time = std::chrono::steady_clock::now() + sleep_duration;
+      shared_worker_stop_->WaitForNotificationWithTimeout(absl::FromChrono(sleep_duration));
+      RecordTickOvershoot(std::chrono::steady_clock::now() - wakeup_time);
+    }
+  }
+}
 
-      // Figure out how long to sleep.
-      sleep_duration = TimeUntilNextTick(source_output_map_);
+void StirlingImpl::RecordTickOvershoot(std::chrono::steady_clock::duration overshoot) {
+  int64_t overshoot_ms = std::chrono::duration_cast<std::chrono::milliseconds>(overshoot).count();
+  int64_t max_ms = max_tick_overshoot_ms_.load(std::memory_order_relaxed);
+  while (overshoot_ms > max_ms &&
+         !max_tick_overshoot_ms_.compare_exchange_weak(max_ms, overshoot_ms,
+                                                       std::memory_order_relaxed)) {
+  }
+}
+
+void StirlingImpl::UpdateOverloadLevel() {
+  OverloadController::Signals signals;
+  if (cpu_stat_path_.has_value()) {
+    StatusOr<std::string> contents = ReadFileToString(*cpu_stat_path_);
+    CPUThrottleStats stats;
+    if (contents.ok() && ParseCPUStat(contents.ValueOrDie(), &stats).ok()) {
+      if (prev_throttle_stats_.has_value() && stats.nr_periods > prev_throttle_stats_->nr_periods) {
+        signals.throttled_fraction =
+            static_cast<double>(stats.nr_throttled - prev_throttle_stats_->nr_throttled) /
+            (stats.nr_periods - prev_throttle_stats_->nr_periods);
+      }
+      prev_throttle_stats_ = stats;
     }
+  }
+  signals.max_tick_overshoot = std::chrono::milliseconds(max_tick_overshoot_ms_.exchange(0));
 
-    SleepForDuration(sleep_duration);
+  OverloadLevel level = overload_controller_.Update(signals);
+  if (level == overload_level_) {
+    return;
   }
-  running_ = false;
+  overload_level_ = level;
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  for (auto& [source, worker] : source_workers_) {
+    absl::MutexLock source_lock(&worker->source_lock);
+    source->SetOverloadLevel(level);
+  }
+}
+
+bool StirlingImpl::PushQueuedData(std::chrono::milliseconds timeout) {
+  std::vector<QueuedRecordBatch> batches(kMaxPushBatches);
+  size_t num_batches =
+      push_queue_.wait_dequeue_bulk_timed(batches.begin(), batches.size(), timeout);
+
+  // Merge the batches of each table and tablet into the first one. A table is pushed by a single
+  // source worker, whose batches are dequeued in order.
+  absl::flat_hash_map<std::pair<uint32_t, std::string_view>, QueuedRecordBatch*> first_batches;
+  for (size_t i = 0; i < num_batches; ++i) {
+    auto& batch = batches[i];
+    auto [it, inserted] =
+        first_batches.try_emplace(std::make_pair(batch.table_id, batch.tablet_id), &batch);
+    if (!inserted) {
+      AppendRecords(batch.records.get(), it->second->records.get());
+      batch.records.reset();
+      ++num_batches_merged_;
+    }
+  }
+
+  for (size_t i = 0; i < num_batches; ++i) {
+    auto& batch = batches[i];
+    if (batch.records == nullptr) {
+      continue;
+    }
+    ++num_pushes_;
+    Status s = data_push_callback_(batch.table_id, batch.tablet_id, std::move(batch.records));
+    LOG_IF(DFATAL, !s.ok()) << absl::Substitute("Failed to push data. Message = $0", s.msg());
+  }
+  return num_batches > 0;
+}
+
+std::shared_ptr<ConnectorContext> StirlingImpl::CurrentContext() {
+  absl::base_internal::SpinLockHolder lock(&context_lock_);
+  return context_;
+}
+
+PushQueueStats StirlingImpl::GetPushQueueStats() const {
+  PushQueueStats stats;
+  stats.depth = push_queue_.size_approx();
+  stats.num_pushes = num_pushes_;
+  stats.num_batches_merged = num_batches_merged_;
+  stats.num_batches_dropped = num_batches_dropped_;
+  stats.num_rows_dropped = num_rows_dropped_;
+  return stats;
+}
+
+std::vector<SourceLoopStats> StirlingImpl::GetSourceLoopStats() const {
+  std::vector<SourceLoopStats> loop_stats;
+  absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
+  for (const auto& [source, worker] : source_workers_) {
+    absl::base_internal::SpinLockHolder stats_lock(&worker->stats_lock);
+    loop_stats.push_back(worker->stats);
+    loop_stats.back().source_name = source->name();
+  }
+  return loop_stats;
 }
 
 bool StirlingImpl::IsRunning() const { return running_; }
@@ -807,22 +1387,25 @@ void StirlingImpl::Stop() {
 void StirlingImpl::SetDebugLevel(int level) {
   // Lock not really required, but compiler is making sure we're safe.
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->SetDebugLevel(level);
+  for (auto& [source, worker] : source_workers_) {
+    absl::MutexLock source_lock(&worker->source_lock);
+    source->SetDebugLevel(level);
   }
 }
 
 void StirlingImpl::EnablePIDTrace(int pid) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->EnablePIDTrace(pid);
+  for (auto& [source, worker] : source_workers_) {
+    absl::MutexLock source_lock(&worker->source_lock);
+    source->EnablePIDTrace(pid);
   }
 }
 
 void StirlingImpl::DisablePIDTrace(int pid) {
   absl::base_internal::SpinLockHolder lock(&info_class_mgrs_lock_);
-  for (auto& s : sources_) {
-    s->DisablePIDTrace(pid);
+  for (auto& [source, worker] : source_workers_) {
+    absl::MutexLock source_lock(&worker->source_lock);
+    source->DisablePIDTrace(pid);
   }
 }
 
@@ -20,6 +20,7 @@
 
 #include <signal.h>
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -27,11 +28,18 @@
 #include <sole.hpp>
 
 #include "src/common/base/base.h"
+#include "src/shared/upid/upid.h"
+#include "src/stirling/core/overload_controller.h"
 #include "src/stirling/core/pub_sub_manager.h"
 #include "src/stirling/core/source_registry.h"
 #include "src/stirling/proto/stirling.pb.h"
 #include "src/stirling/source_connectors/dynamic_tracer/dynamic_tracing/ir/logicalpb/logical.pb.h"
 
+DECLARE_bool(stirling_parallel_source_init);
+DECLARE_bool(stirling_shared_dynamic_trace_worker);
+DECLARE_uint64(stirling_push_queue_max_batches);
+DECLARE_string(stirling_cpus);
+
 namespace px {
 namespace stirling {
 
@@ -79,6 +87,41 @@ std::unique_ptr<SourceRegistry> CreateProdSourceRegistry();
  */
 absl::flat_hash_set<std::string_view> GetProdSourceNames();
 
+/**
+ * Latency of the sampling and push loop of a source connector. Only iterations that sampled or
+ * pushed data are counted.
+ */
+struct SourceLoopStats {
+  std::string source_name;
+  // How long the source's Init() took.
+  std::chrono::microseconds init_time{0};
+  uint64_t num_iterations = 0;
+  std::chrono::microseconds last_iteration_time{0};
+  std::chrono::microseconds max_iteration_time{0};
+  std::chrono::microseconds total_iteration_time{0};
+  // The current sampling period, and how many times it was adapted to the load of the source
+  // (see SourceConnector::EnableAdaptiveSampling()).
+  std::chrono::milliseconds sampling_period{0};
+  uint64_t num_sampling_period_shortened = 0;
+  uint64_t num_sampling_period_lengthened = 0;
+};
+
+/**
+ * Stats of the queue that hands the record batches pushed by the source workers off to the data
+ * push callback.
+ */
+struct PushQueueStats {
+  // The record batches waiting to be pushed.
+  uint64_t depth = 0;
+  // The calls to the data push callback, and the queued batches that were merged into the
+  // push of an earlier batch of the same table and tablet.
+  uint64_t num_pushes = 0;
+  uint64_t num_batches_merged = 0;
+  // The batches, and their rows, dropped because the queue was full.
+  uint64_t num_batches_dropped = 0;
+  uint64_t num_rows_dropped = 0;
+};
+
 /**
  * The data collector collects data from various different 'sources',
  * and makes them available via a structured API, where the data can then be used and queried as
@@ -122,6 +165,15 @@ class Stirling : public NotCopyable {
    */
   virtual Status RemoveTracepoint(sole::uuid trace_id) = 0;
 
+  /**
+   * Starts a time-limited profiling session, which samples the stack traces of the given
+   * processes at a higher frequency than the continuous profiler.
+   * See PerfProfileConnector::StartTargetedSession().
+   */
+  virtual Status StartProfilingSession(const std::vector<md::UPID>& upids,
+                                       std::chrono::milliseconds sampling_period,
+                                       std::chrono::milliseconds duration) = 0;
+
   /**
    * Populate the Publish Proto object. Agent calls this function to get the Publish
    * proto message. The proto publish message contains information (InfoClassSchema) on
@@ -187,6 +239,24 @@ class Stirling : public NotCopyable {
    * to clean-up BPF deployed resources.
    */
   virtual void Stop() = 0;
+
+  /**
+   * Returns the loop latency of every source connector. Each source connector samples and pushes
+   * its data on its own thread.
+   */
+  virtual std::vector<SourceLoopStats> GetSourceLoopStats() const = 0;
+
+  /**
+   * Returns the stats of the queue between the source workers and the data push callback. The
+   * queue holds at most --stirling_push_queue_max_batches batches, newer batches are dropped.
+   */
+  virtual PushQueueStats GetPushQueueStats() const = 0;
+
+  /**
+   * Returns the step of the degradation ladder that Stirling is on, see OverloadController. The
+   * agent throttles its queries from OverloadLevel::kQueriesThrottled on.
+   */
+  virtual OverloadLevel overload_level() const = 0;
 };
 
 namespace stirlingpb {
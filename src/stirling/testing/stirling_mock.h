@@ -21,6 +21,7 @@
 #include <gmock/gmock.h>
 #include <memory>
 #include <sole.hpp>
+#include <vector>
 
 #include "src/common/uuid/uuid.h"
 #include "src/stirling/core/source_registry.h"
@@ -40,6 +41,10 @@ class MockStirling : public Stirling {
               (override));
   MOCK_METHOD(StatusOr<stirlingpb::Publish>, GetTracepointInfo, (sole::uuid trace_id), (override));
   MOCK_METHOD(Status, RemoveTracepoint, (sole::uuid trace_id), (override));
+  MOCK_METHOD(Status, StartProfilingSession,
+              (const std::vector<md::UPID>& upids, std::chrono::milliseconds sampling_period,
+               std::chrono::milliseconds duration),
+              (override));
   MOCK_METHOD(void, GetPublishProto, (stirlingpb::Publish * publish_pb), (override));
   MOCK_METHOD(void, RegisterDataPushCallback, (DataPushCallback f), (override));
   MOCK_METHOD(void, RegisterAgentMetadataCallback, (AgentMetadataCallback f), (override));
@@ -49,6 +54,9 @@ class MockStirling : public Stirling {
   MOCK_METHOD(Status, WaitUntilRunning, (std::chrono::milliseconds timeout), (const override));
   MOCK_METHOD(void, WaitForThreadJoin, (), (override));
   MOCK_METHOD(void, Stop, (), (override));
+  MOCK_METHOD(std::vector<SourceLoopStats>, GetSourceLoopStats, (), (const override));
+  MOCK_METHOD(PushQueueStats, GetPushQueueStats, (), (const override));
+  MOCK_METHOD(OverloadLevel, overload_level, (), (const override));
 };
 
 }  // namespace stirling
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <cstring>
 #include <string_view>
 
 #include "src/common/base/base.h"
@@ -27,6 +28,10 @@ namespace stirling {
 
 /**
  * Provides functions to extract bytes from a bytes buffer.
+ *
+ * The Extract functions check the size of the buffer on every call. Decoders that read several
+ * fixed-size fields in a row can instead check once with HasBytes(), and then read the fields with
+ * the Unchecked functions, which only DCHECK the size.
  */
 // TODO(yzhao): Merge with code in
 // src/stirling/source_connectors/socket_tracer/protocols/cql/frame_body_decoder.{h,cc}.
@@ -39,38 +44,110 @@ class BinaryDecoder {
   std::string_view Buf() const { return buf_; }
   void SetBuf(std::string_view buf) { buf_ = buf; }
 
+  bool HasBytes(size_t len) const { return buf_.size() >= len; }
+
   template <typename TCharType = char>
   StatusOr<TCharType> ExtractChar() {
-    static_assert(sizeof(TCharType) == 1);
-    if (buf_.size() < sizeof(TCharType)) {
+    if (!HasBytes(sizeof(TCharType))) {
       return error::ResourceUnavailable("Insufficient number of bytes.");
     }
-    TCharType res = buf_.front();
-    buf_.remove_prefix(1);
-    return res;
+    return ExtractCharUnchecked<TCharType>();
   }
 
   template <typename TIntType>
   StatusOr<TIntType> ExtractInt() {
-    if (buf_.size() < sizeof(TIntType)) {
+    if (!HasBytes(sizeof(TIntType))) {
+      return error::ResourceUnavailable("Insufficient number of bytes.");
+    }
+    return ExtractIntUnchecked<TIntType>();
+  }
+
+  template <typename TCharType = char>
+  StatusOr<std::basic_string_view<TCharType>> ExtractString(size_t len) {
+    if (!HasBytes(len)) {
       return error::ResourceUnavailable("Insufficient number of bytes.");
     }
+    return ExtractStringUnchecked<TCharType>(len);
+  }
+
+  // The Unchecked versions of the above require that the caller has checked HasBytes().
+  template <typename TCharType = char>
+  TCharType ExtractCharUnchecked() {
+    static_assert(sizeof(TCharType) == 1);
+    DCHECK(HasBytes(sizeof(TCharType)));
+    TCharType res = buf_.front();
+    buf_.remove_prefix(1);
+    return res;
+  }
+
+  template <typename TIntType>
+  TIntType ExtractIntUnchecked() {
+    DCHECK(HasBytes(sizeof(TIntType)));
     TIntType val = ::px::utils::BEndianBytesToInt<TIntType>(buf_);
     buf_.remove_prefix(sizeof(TIntType));
     return val;
   }
 
   template <typename TCharType = char>
-  StatusOr<std::basic_string_view<TCharType>> ExtractString(size_t len) {
+  std::basic_string_view<TCharType> ExtractStringUnchecked(size_t len) {
     static_assert(sizeof(TCharType) == 1);
-    if (buf_.size() < len) {
-      return error::ResourceUnavailable("Insufficient number of bytes.");
-    }
+    DCHECK(HasBytes(len));
     auto tbuf = CreateStringView<TCharType>(buf_);
     buf_.remove_prefix(len);
     return tbuf.substr(0, len);
   }
 
+  /**
+   * Extracts an unsigned LEB128 varint of at most TMaxBytes bytes, as used by Kafka and protobuf.
+   * Each byte holds 7 bits of the value, least significant first, and the high bit of every byte
+   * but the last is set.
+   */
+  template <size_t TMaxBytes>
+  StatusOr<uint64_t> ExtractUnsignedVarint() {
+    static_assert(TMaxBytes > 0 && TMaxBytes <= 10);
+    constexpr uint64_t kContinuationBits = 0x8080808080808080ULL;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Varints are mostly short, so when the buffer holds a full word, load it at once and find the
+    // last byte of the varint from its continuation bits, instead of branching on every byte.
+    if (HasBytes(sizeof(uint64_t))) {
+      uint64_t word;
+      std::memcpy(&word, buf_.data(), sizeof(word));
+      uint64_t last_bytes = ~word & kContinuationBits;
+      if (last_bytes != 0) {
+        size_t len = __builtin_ctzll(last_bytes) / 8 + 1;
+        if (len > TMaxBytes) {
+          return error::Internal("Varint is longer than $0 bytes.", TMaxBytes);
+        }
+        if (len < sizeof(uint64_t)) {
+          word &= (uint64_t{1} << (8 * len)) - 1;
+        }
+        buf_.remove_prefix(len);
+        return CompactVarintBytes(word);
+      }
+    }
+#endif
+
+    uint64_t value = 0;
+    for (size_t i = 0; i < TMaxBytes; ++i) {
+      PL_ASSIGN_OR_RETURN(uint8_t b, ExtractChar<uint8_t>());
+      value |= static_cast<uint64_t>(b & 0x7f) << (7 * i);
+      if (!(b & 0x80)) {
+        return value;
+      }
+    }
+    return error::Internal("Varint is longer than $0 bytes.", TMaxBytes);
+  }
+
+  /**
+   * Extracts a zigzag encoded signed varint, in which 0, -1, 1, -2, ... are encoded as 0, 1, 2, 3.
+   */
+  template <size_t TMaxBytes>
+  StatusOr<int64_t> ExtractVarint() {
+    PL_ASSIGN_OR_RETURN(uint64_t value, ExtractUnsignedVarint<TMaxBytes>());
+    return static_cast<int64_t>((value >> 1) ^ -(value & 1));
+  }
+
   // Extract until encounter the input sentinel character.
   // The sentinel character is not returned, but is still removed from the buffer.
   template <typename TCharType = char>
@@ -105,6 +182,15 @@ class BinaryDecoder {
   }
 
  protected:
+  // Packs the low 7 bits of each of the (little endian) bytes of the word into a value.
+  static uint64_t CompactVarintBytes(uint64_t word) {
+    word &= 0x7f7f7f7f7f7f7f7fULL;
+    word = (word & 0x007f007f007f007fULL) | ((word & 0x7f007f007f007f00ULL) >> 1);
+    word = (word & 0x00003fff00003fffULL) | ((word & 0x3fff00003fff0000ULL) >> 2);
+    word = (word & 0x000000000fffffffULL) | ((word & 0x0fffffff00000000ULL) >> 4);
+    return word;
+  }
+
   std::string_view buf_;
 };
 
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+
+#include "src/stirling/utils/binary_decoder.h"
+
+using px::stirling::BinaryDecoder;
+
+namespace {
+
+// Returns the varint encoding of num_values random values of up to max_bits bits.
+std::string RandomVarints(int num_values, int max_bits) {
+  std::mt19937_64 rng(37);
+  std::string data;
+  for (int i = 0; i < num_values; ++i) {
+    uint64_t value = rng() >> (64 - max_bits);
+    do {
+      uint8_t b = value & 0x7f;
+      value >>= 7;
+      if (value != 0) {
+        b |= 0x80;
+      }
+      data.push_back(b);
+    } while (value != 0);
+  }
+  return data;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE : runtime/references.
+static void BM_extract_unsigned_varint(benchmark::State& state) {
+  constexpr int kNumValues = 4096;
+  const std::string data = RandomVarints(kNumValues, state.range(0));
+
+  for (auto _ : state) {
+    BinaryDecoder decoder(data);
+    while (!decoder.eof()) {
+      benchmark::DoNotOptimize(decoder.ExtractUnsignedVarint<10>().ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+// A frame header of fixed-size fields, read field by field, or after checking its size once.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_extract_header(benchmark::State& state) {
+  constexpr int kNumHeaders = 4096;
+  constexpr size_t kHeaderSize = 12;
+  const std::string data(kNumHeaders * kHeaderSize, '\x01');
+  const bool unchecked = state.range(0) != 0;
+
+  for (auto _ : state) {
+    BinaryDecoder decoder(data);
+    while (!decoder.eof()) {
+      if (unchecked && decoder.HasBytes(kHeaderSize)) {
+        benchmark::DoNotOptimize(decoder.ExtractIntUnchecked<int32_t>());
+        benchmark::DoNotOptimize(decoder.ExtractIntUnchecked<int16_t>());
+        benchmark::DoNotOptimize(decoder.ExtractIntUnchecked<int16_t>());
+        benchmark::DoNotOptimize(decoder.ExtractIntUnchecked<int32_t>());
+      } else {
+        benchmark::DoNotOptimize(decoder.ExtractInt<int32_t>().ValueOrDie());
+        benchmark::DoNotOptimize(decoder.ExtractInt<int16_t>().ValueOrDie());
+        benchmark::DoNotOptimize(decoder.ExtractInt<int16_t>().ValueOrDie());
+        benchmark::DoNotOptimize(decoder.ExtractInt<int32_t>().ValueOrDie());
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumHeaders);
+}
+
+BENCHMARK(BM_extract_unsigned_varint)->Arg(7)->Arg(14)->Arg(32)->Arg(64);
+BENCHMARK(BM_extract_header)->Arg(0)->Arg(1);
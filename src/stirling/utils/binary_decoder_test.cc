@@ -20,6 +20,7 @@
 
 #include <string>
 
+#include <absl/strings/str_cat.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -84,6 +85,69 @@ TEST(BinaryDecoderTest, ExtractStringUntilStr) {
   EXPECT_EQ("name", bin_decoder.Buf());
 }
 
+TEST(BinaryDecoderTest, ExtractUnchecked) {
+  std::string_view data("\x01\x02\x03\x04\x05" "abc");
+  BinaryDecoder bin_decoder(data);
+
+  ASSERT_TRUE(bin_decoder.HasBytes(8));
+  EXPECT_EQ(bin_decoder.ExtractCharUnchecked(), 1);
+  EXPECT_EQ(bin_decoder.ExtractIntUnchecked<int16_t>(), 0x0203);
+  EXPECT_EQ(bin_decoder.ExtractIntUnchecked<int16_t>(), 0x0405);
+  EXPECT_EQ(bin_decoder.ExtractStringUnchecked(3), "abc");
+  EXPECT_FALSE(bin_decoder.HasBytes(1));
+}
+
+TEST(BinaryDecoderTest, ExtractUnsignedVarint) {
+  // Varints at the end of the buffer are decoded a byte at a time, and the others a word at a time.
+  for (std::string_view suffix : {"", "nextxyzw"}) {
+    std::string data = absl::StrCat(std::string_view("\x00\x01\x7f\xac\x02", 5),
+                                    "\xff\xff\xff\xff\x0f",
+                                    "\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01", suffix);
+    BinaryDecoder bin_decoder(data);
+
+    ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint<5>(), 0u);
+    ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint<5>(), 1u);
+    ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint<5>(), 127u);
+    ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint<5>(), 300u);
+    ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint<5>(), 0xffffffffu);
+    ASSERT_OK_AND_EQ(bin_decoder.ExtractUnsignedVarint<10>(), 0xffffffffffffffffu);
+    EXPECT_EQ(suffix, bin_decoder.Buf());
+  }
+}
+
+TEST(BinaryDecoderTest, ExtractVarint) {
+  std::string_view data("\x00\x01\x02\x03\x04\xa3\x02", 7);
+  BinaryDecoder bin_decoder(data);
+
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractVarint<5>(), 0);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractVarint<5>(), -1);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractVarint<5>(), 1);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractVarint<5>(), -2);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractVarint<5>(), 2);
+  ASSERT_OK_AND_EQ(bin_decoder.ExtractVarint<5>(), -146);
+  EXPECT_TRUE(bin_decoder.eof());
+}
+
+TEST(BinaryDecoderTest, ExtractUnsignedVarintErrors) {
+  {
+    // Longer than the maximum length.
+    std::string_view data("\xff\xff\xff\xff\xff\x01" "abcd");
+    BinaryDecoder bin_decoder(data);
+    EXPECT_NOT_OK(bin_decoder.ExtractUnsignedVarint<5>());
+  }
+  {
+    std::string_view data("\xff\xff\xff\xff\xff\x01");
+    BinaryDecoder bin_decoder(data);
+    EXPECT_NOT_OK(bin_decoder.ExtractUnsignedVarint<5>());
+  }
+  {
+    // Missing the last byte.
+    std::string_view data("\xff\xff");
+    BinaryDecoder bin_decoder(data);
+    EXPECT_NOT_OK(bin_decoder.ExtractUnsignedVarint<5>());
+  }
+}
+
 TEST(BinaryDecoderTest, TooShortText) {
   {
     std::string_view data("");
@@ -113,6 +113,29 @@ std::array<size_t, N> SplitSortedVector(const std::vector<T>& vec,
   return out;
 }
 
+// Computes the values that are in cur but not in prev, and the values that are in prev but not in
+// cur, in sorted order. Both prev and cur must be sorted, and have no duplicates.
+// Takes a single pass over both vectors, so it is cheaper than diffing two hash sets when the
+// vectors are already sorted.
+template <typename T>
+void DiffSortedVectors(const std::vector<T>& prev, const std::vector<T>& cur, std::vector<T>* added,
+                       std::vector<T>* removed) {
+  auto prev_iter = prev.begin();
+  auto cur_iter = cur.begin();
+  while (prev_iter != prev.end() && cur_iter != cur.end()) {
+    if (*prev_iter < *cur_iter) {
+      removed->push_back(*prev_iter++);
+    } else if (*cur_iter < *prev_iter) {
+      added->push_back(*cur_iter++);
+    } else {
+      ++prev_iter;
+      ++cur_iter;
+    }
+  }
+  removed->insert(removed->end(), prev_iter, prev.end());
+  added->insert(added->end(), cur_iter, cur.end());
+}
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
@@ -52,6 +52,20 @@ TEST(SplitSortedVector, Basic) {
             (std::array<size_t, 3>{0, 3, 6}));
 }
 
+TEST(DiffSortedVectors, Basic) {
+  std::vector<int> added;
+  std::vector<int> removed;
+  DiffSortedVectors<int>({1, 2, 4, 6, 9}, {0, 2, 3, 4, 10, 11}, &added, &removed);
+  EXPECT_EQ(added, (std::vector<int>{0, 3, 10, 11}));
+  EXPECT_EQ(removed, (std::vector<int>{1, 6, 9}));
+
+  added.clear();
+  removed.clear();
+  DiffSortedVectors<int>({}, {1, 2}, &added, &removed);
+  EXPECT_EQ(added, (std::vector<int>{1, 2}));
+  EXPECT_TRUE(removed.empty());
+}
+
 void CheckAgainstReferenceModel(std::vector<int> vec, int t1, int t2,
                                 std::array<size_t, 2> split_positions) {
   int num_left = 0;
@@ -30,6 +30,7 @@
 #include <vector>
 
 #include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
 #include <absl/strings/str_replace.h>
 
 #include "src/common/base/file.h"
@@ -39,6 +40,11 @@
 #include "src/common/system/config.h"
 #include "src/common/zlib/zlib_wrapper.h"
 
+DEFINE_string(stirling_linux_headers_cache_dir,
+              gflags::StringFromEnv("PL_STIRLING_LINUX_HEADERS_CACHE_DIR", ""),
+              "If set, packaged Linux headers that were prepared for the host are kept in this "
+              "directory, and reused after a restart on the same kernel and kernel config.");
+
 namespace px {
 namespace stirling {
 namespace utils {
@@ -456,10 +462,13 @@ Status LinkHostLinuxHeaders(const std::filesystem::path& lib_modules_dir) {
   return Status::OK();
 }
 
-Status ExtractPackagedHeaders(PackagedLinuxHeadersSpec* headers_package) {
-  std::string expected_directory =
-      absl::Substitute("/usr/src/linux-headers-$0.$1.$2-pl", headers_package->version.version,
-                       headers_package->version.major_rev, headers_package->version.minor_rev);
+Status ExtractPackagedHeaders(PackagedLinuxHeadersSpec* headers_package,
+                              const std::filesystem::path& dest_root) {
+  std::filesystem::path expected_directory =
+      dest_root / absl::Substitute("usr/src/linux-headers-$0.$1.$2-pl",
+                                   headers_package->version.version,
+                                   headers_package->version.major_rev,
+                                   headers_package->version.minor_rev);
 
   // This is a loose check that we don't clobber what we *think* should the output directory.
   // If someone built a tar.gz with an incorrect directory structure, this check wouldn't save us.
@@ -469,7 +478,7 @@ Status ExtractPackagedHeaders(PackagedLinuxHeadersSpec* headers_package) {
 
   // Extract the files.
   ::px::tools::Minitar minitar(headers_package->path.string());
-  PL_RETURN_IF_ERROR(minitar.Extract("/"));
+  PL_RETURN_IF_ERROR(minitar.Extract(dest_root.string()));
 
   // Update the path to the extracted copy.
   headers_package->path = expected_directory;
@@ -539,6 +548,135 @@ StatusOr<PackagedLinuxHeadersSpec> FindClosestPackagedLinuxHeaders(
   return selected;
 }
 
+namespace {
+
+constexpr std::string_view kCachedHeadersPrefix = "linux-headers-";
+constexpr std::string_view kCacheKeyFile = "cache_key";
+
+// FNV-1a, since the hashes are persisted, and must not change between runs.
+uint64_t Fnv1aHash(std::string_view s) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : s) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::filesystem::path CachedHeadersDir(const std::filesystem::path& cache_dir,
+                                       const PackagedLinuxHeadersSpec& headers_package,
+                                       std::string_view key) {
+  const KernelVersion& v = headers_package.version;
+  return cache_dir / absl::Substitute("$0$1.$2.$3-$4", kCachedHeadersPrefix, v.version,
+                                      v.major_rev, v.minor_rev, absl::Hex(Fnv1aHash(key)));
+}
+
+std::filesystem::path CachedHeadersPath(const std::filesystem::path& dir,
+                                        const PackagedLinuxHeadersSpec& headers_package) {
+  const KernelVersion& v = headers_package.version;
+  return dir / absl::Substitute("usr/src/linux-headers-$0.$1.$2-pl", v.version, v.major_rev,
+                                v.minor_rev);
+}
+
+StatusOr<std::string> GetKernelBuild() {
+  struct utsname buffer;
+  if (uname(&buffer) != 0) {
+    return error::Internal("Could not determine kernel version (uname)");
+  }
+  // The version holds the build number and time, which tell apart builds of the same release.
+  return absl::StrCat(buffer.release, " ", buffer.version, " ", buffer.machine);
+}
+
+Status PreparePackagedHeaders(const std::filesystem::path& headers_path,
+                              KernelVersion kernel_version) {
+  PL_RETURN_IF_ERROR(ModifyKernelVersion(headers_path, kernel_version.code()));
+  PL_RETURN_IF_ERROR(ApplyConfigPatches(headers_path));
+  return Status::OK();
+}
+
+// Returns the path of the prepared headers in the cache, preparing them first if needed.
+StatusOr<std::filesystem::path> FindOrCachePackagedHeaders(
+    const std::filesystem::path& cache_dir, const PackagedLinuxHeadersSpec& headers_package,
+    KernelVersion kernel_version) {
+  PL_ASSIGN_OR_RETURN(std::string kernel_build, GetKernelBuild());
+  PL_ASSIGN_OR_RETURN(std::filesystem::path kernel_config, FindKernelConfig());
+  PL_ASSIGN_OR_RETURN(std::string kernel_config_contents, ReadFileToString(kernel_config));
+  std::string key = PackagedHeadersCacheKey(headers_package, kernel_build, kernel_config_contents);
+
+  StatusOr<std::filesystem::path> cached_or =
+      LookupCachedPackagedHeaders(cache_dir, headers_package, key);
+  if (cached_or.ok()) {
+    LOG(INFO) << absl::Substitute("Using cached copy of packaged headers at $0",
+                                  cached_or.ValueOrDie().string());
+    return cached_or;
+  }
+  VLOG(1) << absl::Substitute("No usable cached packaged headers: $0", cached_or.msg());
+
+  return CachePackagedHeaders(cache_dir, headers_package, key,
+                              [kernel_version](const std::filesystem::path& headers_path) {
+                                return PreparePackagedHeaders(headers_path, kernel_version);
+                              });
+}
+
+}  // namespace
+
+std::string PackagedHeadersCacheKey(const PackagedLinuxHeadersSpec& headers_package,
+                                    std::string_view kernel_build, std::string_view kernel_config) {
+  return absl::Substitute("kernel: $0\npackage: $1\nconfig: $2\n", kernel_build,
+                          headers_package.path.filename().string(),
+                          absl::Hex(Fnv1aHash(kernel_config)));
+}
+
+StatusOr<std::filesystem::path> LookupCachedPackagedHeaders(
+    const std::filesystem::path& cache_dir, const PackagedLinuxHeadersSpec& headers_package,
+    std::string_view key) {
+  std::filesystem::path dir = CachedHeadersDir(cache_dir, headers_package, key);
+  std::filesystem::path key_file = dir / kCacheKeyFile;
+  PL_RETURN_IF_ERROR(fs::Exists(key_file));
+  PL_ASSIGN_OR_RETURN(std::string cached_key, ReadFileToString(key_file));
+  if (cached_key != key) {
+    return error::NotFound("$0 was prepared for a different kernel or config.", dir.string());
+  }
+  std::filesystem::path headers_path = CachedHeadersPath(dir, headers_package);
+  PL_RETURN_IF_ERROR(fs::Exists(headers_path));
+  return headers_path;
+}
+
+StatusOr<std::filesystem::path> CachePackagedHeaders(
+    const std::filesystem::path& cache_dir, PackagedLinuxHeadersSpec headers_package,
+    std::string_view key, const std::function<Status(const std::filesystem::path&)>& prepare) {
+  std::filesystem::path dir = CachedHeadersDir(cache_dir, headers_package, key);
+  std::filesystem::path tmp_dir = absl::StrCat(dir.string(), ".tmp");
+
+  // Remove the headers of previous kernels or configs, and any partially prepared headers.
+  std::error_code ec;
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(cache_dir));
+  for (const auto& p : std::filesystem::directory_iterator(cache_dir, ec)) {
+    if (absl::StartsWith(p.path().filename().string(), kCachedHeadersPrefix)) {
+      std::filesystem::remove_all(p.path(), ec);
+      LOG_IF(WARNING, ec) << absl::Substitute("Could not remove $0: $1", p.path().string(),
+                                              ec.message());
+    }
+  }
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(tmp_dir));
+
+  // Prepare the headers in a temporary directory first, so that a crash can't leave partially
+  // prepared headers behind.
+  PL_RETURN_IF_ERROR(ExtractPackagedHeaders(&headers_package, tmp_dir));
+  PL_RETURN_IF_ERROR(prepare(headers_package.path));
+  PL_RETURN_IF_ERROR(WriteFileFromString(tmp_dir / kCacheKeyFile, key));
+  std::filesystem::rename(tmp_dir, dir, ec);
+  if (ec) {
+    return error::Internal("Could not rename $0 to $1: $2", tmp_dir.string(), dir.string(),
+                           ec.message());
+  }
+
+  std::filesystem::path headers_path = CachedHeadersPath(dir, headers_package);
+  LOG(INFO) << absl::Substitute("Cached prepared copy of packaged headers at $0",
+                                headers_path.string());
+  return headers_path;
+}
+
 Status InstallPackagedLinuxHeaders(const std::filesystem::path& lib_modules_dir) {
   // This is the directory in our container images that contains packaged linux headers.
   const std::filesystem::path kPackagedHeadersRoot = "/pl";
@@ -552,9 +690,21 @@ Status InstallPackagedLinuxHeaders(const std::filesystem::path& lib_modules_dir)
   PL_ASSIGN_OR_RETURN(PackagedLinuxHeadersSpec packaged_headers,
                       FindClosestPackagedLinuxHeaders(kPackagedHeadersRoot, kernel_version));
   LOG(INFO) << absl::Substitute("Using packaged header: $0", packaged_headers.path.string());
-  PL_RETURN_IF_ERROR(ExtractPackagedHeaders(&packaged_headers));
-  PL_RETURN_IF_ERROR(ModifyKernelVersion(packaged_headers.path, kernel_version.code()));
-  PL_RETURN_IF_ERROR(ApplyConfigPatches(packaged_headers.path));
+
+  StatusOr<std::filesystem::path> cached_or = error::NotFound("No linux headers cache.");
+  if (!FLAGS_stirling_linux_headers_cache_dir.empty()) {
+    cached_or = FindOrCachePackagedHeaders(FLAGS_stirling_linux_headers_cache_dir,
+                                           packaged_headers, kernel_version);
+    LOG_IF(WARNING, !cached_or.ok()) << absl::Substitute(
+        "Could not use the linux headers cache at $0: $1", FLAGS_stirling_linux_headers_cache_dir,
+        cached_or.msg());
+  }
+  if (cached_or.ok()) {
+    packaged_headers.path = cached_or.ConsumeValueOrDie();
+  } else {
+    PL_RETURN_IF_ERROR(ExtractPackagedHeaders(&packaged_headers));
+    PL_RETURN_IF_ERROR(PreparePackagedHeaders(packaged_headers.path, kernel_version));
+  }
   PL_RETURN_IF_ERROR(fs::CreateSymlinkIfNotExists(packaged_headers.path, lib_modules_build_dir));
   LOG(INFO) << absl::Substitute("Successfully installed packaged copy of headers at $0",
                                 lib_modules_build_dir.string());
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <filesystem>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -26,6 +27,8 @@
 
 #include "src/common/base/base.h"
 
+DECLARE_string(stirling_linux_headers_cache_dir);
+
 namespace px {
 namespace stirling {
 namespace utils {
@@ -159,6 +162,44 @@ struct PackagedLinuxHeadersSpec {
 StatusOr<PackagedLinuxHeadersSpec> FindClosestPackagedLinuxHeaders(
     const std::filesystem::path& packaged_headers_root, KernelVersion kernel_version);
 
+/**
+ * Extracts the packaged headers under dest_root, and updates the path of the package to the
+ * extracted headers.
+ */
+Status ExtractPackagedHeaders(PackagedLinuxHeadersSpec* headers_package,
+                              const std::filesystem::path& dest_root = "/");
+
+/**
+ * Returns the key of packaged headers that were prepared for a host. Headers that were prepared
+ * with the same key can be reused as is.
+ *
+ * @param headers_package The package the headers are extracted from.
+ * @param kernel_build Identifies the build of the host's kernel, such as uname's release and
+ * version.
+ * @param kernel_config The contents of the host's kernel config.
+ */
+std::string PackagedHeadersCacheKey(const PackagedLinuxHeadersSpec& headers_package,
+                                    std::string_view kernel_build, std::string_view kernel_config);
+
+/**
+ * Returns the path of the headers that CachePackagedHeaders() prepared in cache_dir with the key,
+ * or an error if there are none.
+ */
+StatusOr<std::filesystem::path> LookupCachedPackagedHeaders(
+    const std::filesystem::path& cache_dir, const PackagedLinuxHeadersSpec& headers_package,
+    std::string_view key);
+
+/**
+ * Extracts the packaged headers into cache_dir, and prepares them with the prepare function.
+ * The headers only become visible to LookupCachedPackagedHeaders() once they are fully prepared,
+ * and headers of other keys are removed from cache_dir.
+ *
+ * @return The path of the prepared headers.
+ */
+StatusOr<std::filesystem::path> CachePackagedHeaders(
+    const std::filesystem::path& cache_dir, PackagedLinuxHeadersSpec headers_package,
+    std::string_view key, const std::function<Status(const std::filesystem::path&)>& prepare);
+
 Status InstallPackagedLinuxHeaders(const std::filesystem::path& lib_modules_dir);
 
 // After headers are installed, this variable is set to true.
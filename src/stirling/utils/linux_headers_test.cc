@@ -255,6 +255,34 @@ TEST(LinuxHeadersUtils, FindClosestPackagedLinuxHeaders) {
   }
 }
 
+TEST(LinuxHeadersUtils, PackagedHeadersCacheKey) {
+  PackagedLinuxHeadersSpec package{KernelVersion{4, 14, 176}, "/pl/linux-headers-4.14.176.tar.gz"};
+  PackagedLinuxHeadersSpec other_package{KernelVersion{4, 18, 20},
+                                         "/pl/linux-headers-4.18.20.tar.gz"};
+
+  std::string key = PackagedHeadersCacheKey(package, "4.14.0-1 #1 SMP x86_64", "CONFIG_HZ=250");
+  EXPECT_EQ(key, PackagedHeadersCacheKey(package, "4.14.0-1 #1 SMP x86_64", "CONFIG_HZ=250"));
+  EXPECT_NE(key, PackagedHeadersCacheKey(package, "4.14.0-1 #2 SMP x86_64", "CONFIG_HZ=250"));
+  EXPECT_NE(key, PackagedHeadersCacheKey(package, "4.14.0-1 #1 SMP x86_64", "CONFIG_HZ=1000"));
+  EXPECT_NE(key,
+            PackagedHeadersCacheKey(other_package, "4.14.0-1 #1 SMP x86_64", "CONFIG_HZ=250"));
+}
+
+TEST(LinuxHeadersUtils, CachePackagedHeadersFailure) {
+  TempDir cache_dir;
+  PackagedLinuxHeadersSpec package{KernelVersion{4, 14, 176},
+                                   cache_dir.path() / "linux-headers-4.14.176.tar.gz"};
+  const std::string key = "key";
+
+  EXPECT_NOT_OK(LookupCachedPackagedHeaders(cache_dir.path(), package, key));
+
+  // Headers that could not be prepared are not used later.
+  ASSERT_OK(WriteFileFromString(package.path, "not a tarball"));
+  EXPECT_NOT_OK(CachePackagedHeaders(cache_dir.path(), package, key,
+                                     [](const std::filesystem::path&) { return Status::OK(); }));
+  EXPECT_NOT_OK(LookupCachedPackagedHeaders(cache_dir.path(), package, key));
+}
+
 }  // namespace utils
 }  // namespace stirling
 }  // namespace px
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/utils/metrics.h"
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_join.h>
+#include <absl/strings/str_replace.h>
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+namespace internal {
+
+int ThreadShard() {
+  static std::atomic<int> next_shard = 0;
+  thread_local const int shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kNumMetricShards;
+  return shard;
+}
+
+}  // namespace internal
+
+int64_t Counter::Value() const {
+  int64_t value = 0;
+  for (const auto& shard : shards_) {
+    value += shard.value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+uint64_t Histogram::Snapshot::Quantile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  const int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(q * count + 0.5));
+  int64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return i == 0 ? 0 : BucketUpperBound(i) - 1;
+    }
+  }
+  return BucketUpperBound(kNumBuckets - 1);
+}
+
+Histogram::Snapshot Histogram::GetSnapshot() const {
+  Snapshot snapshot;
+  for (const auto& shard : shards_) {
+    for (int i = 0; i < kNumBuckets; ++i) {
+      snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+    }
+    snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+  }
+  for (int64_t n : snapshot.buckets) {
+    snapshot.count += n;
+  }
+  return snapshot;
+}
+
+MetricsRegistry& MetricsRegistry::Global() {
+  static auto* registry = new MetricsRegistry();
+  return *registry;
+}
+
+MetricsRegistry::Family* MetricsRegistry::GetFamily(std::string_view name, std::string_view help,
+                                                    Type type) {
+  auto it = families_.find(name);
+  if (it == families_.end()) {
+    it = families_.emplace(std::string(name), Family{type, std::string(help), {}, {}}).first;
+  }
+  LOG_IF(DFATAL, it->second.type != type)
+      << absl::Substitute("Metric $0 is registered with two different types.", name);
+  return &it->second;
+}
+
+Counter* MetricsRegistry::GetCounter(std::string_view name, std::string_view help,
+                                     const Labels& labels) {
+  absl::MutexLock lock(&mutex_);
+  auto& counter = GetFamily(name, help, Type::kCounter)->counters[labels];
+  if (counter == nullptr) {
+    counter = std::make_unique<Counter>();
+  }
+  return counter.get();
+}
+
+Histogram* MetricsRegistry::GetHistogram(std::string_view name, std::string_view help,
+                                         const Labels& labels) {
+  absl::MutexLock lock(&mutex_);
+  auto& histogram = GetFamily(name, help, Type::kHistogram)->histograms[labels];
+  if (histogram == nullptr) {
+    histogram = std::make_unique<Histogram>();
+  }
+  return histogram.get();
+}
+
+void MetricsRegistry::ForEach(
+    const std::function<void(std::string_view name, const Labels& labels, const Counter* counter,
+                             const Histogram* histogram)>& fn) const {
+  absl::MutexLock lock(&mutex_);
+  for (const auto& [name, family] : families_) {
+    for (const auto& [labels, counter] : family.counters) {
+      fn(name, labels, counter.get(), nullptr);
+    }
+    for (const auto& [labels, histogram] : family.histograms) {
+      fn(name, labels, nullptr, histogram.get());
+    }
+  }
+}
+
+namespace {
+
+// Formats the labels as {k1="v1",k2="v2"}, with the extra label appended, if it is set.
+std::string FormatLabels(const MetricsRegistry::Labels& labels,
+                         std::pair<std::string_view, std::string> extra = {}) {
+  std::vector<std::string> parts;
+  auto append = [&parts](std::string_view key, std::string_view value) {
+    parts.push_back(absl::StrCat(
+        key, "=\"", absl::StrReplaceAll(value, {{"\\", "\\\\"}, {"\"", "\\\""}, {"\n", "\\n"}}),
+        "\""));
+  };
+  for (const auto& [key, value] : labels) {
+    append(key, value);
+  }
+  if (!extra.first.empty()) {
+    append(extra.first, extra.second);
+  }
+  if (parts.empty()) {
+    return "";
+  }
+  return absl::StrCat("{", absl::StrJoin(parts, ","), "}");
+}
+
+}  // namespace
+
+std::string MetricsRegistry::PrometheusText() const {
+  absl::MutexLock lock(&mutex_);
+  std::string out;
+  for (const auto& [name, family] : families_) {
+    absl::StrAppend(&out, "# HELP ", name, " ", family.help, "\n");
+    absl::StrAppend(&out, "# TYPE ", name,
+                    family.type == Type::kCounter ? " counter\n" : " histogram\n");
+    for (const auto& [labels, counter] : family.counters) {
+      absl::StrAppend(&out, name, FormatLabels(labels), " ", counter->Value(), "\n");
+    }
+    for (const auto& [labels, histogram] : family.histograms) {
+      Histogram::Snapshot snapshot = histogram->GetSnapshot();
+      // Prometheus buckets are cumulative, and their bounds are inclusive. Values above 2^40
+      // (18 minutes, or a terabyte) only fall in the +Inf bucket.
+      constexpr int kNumPrometheusBuckets = 41;
+      int64_t cumulative = 0;
+      for (int i = 0; i < kNumPrometheusBuckets; ++i) {
+        cumulative += snapshot.buckets[i];
+        std::string le = absl::StrCat(i == 0 ? 0 : Histogram::BucketUpperBound(i) - 1);
+        absl::StrAppend(&out, name, "_bucket", FormatLabels(labels, {"le", le}), " ", cumulative,
+                        "\n");
+      }
+      absl::StrAppend(&out, name, "_bucket", FormatLabels(labels, {"le", "+Inf"}), " ",
+                      snapshot.count, "\n");
+      absl::StrAppend(&out, name, "_sum", FormatLabels(labels), " ", snapshot.sum, "\n");
+      absl::StrAppend(&out, name, "_count", FormatLabels(labels), " ", snapshot.count, "\n");
+    }
+  }
+  return out;
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+/**
+ * The metrics below are updated on Stirling's hot paths, from the connector threads and the
+ * socket tracer's parse workers. Each metric is split into shards, and each thread updates its
+ * own shard with relaxed atomics, so updates take no locks and rarely share a cache line.
+ * Reads sum the shards, and may miss updates that are in flight.
+ */
+namespace internal {
+
+inline constexpr int kNumMetricShards = 16;
+
+// The shard of the calling thread. Threads are assigned shards round robin.
+int ThreadShard();
+
+struct alignas(64) CounterShard {
+  std::atomic<int64_t> value = 0;
+};
+
+}  // namespace internal
+
+class Counter : public NotCopyable {
+ public:
+  void Add(int64_t v = 1) {
+    shards_[internal::ThreadShard()].value.fetch_add(v, std::memory_order_relaxed);
+  }
+
+  int64_t Value() const;
+
+ private:
+  std::array<internal::CounterShard, internal::kNumMetricShards> shards_;
+};
+
+/**
+ * A histogram with power of 2 buckets. Bucket i holds the values in [2^(i-1), 2^i), and bucket 0
+ * holds the zeros.
+ */
+class Histogram : public NotCopyable {
+ public:
+  static constexpr int kNumBuckets = 64;
+
+  struct Snapshot {
+    std::array<int64_t, kNumBuckets> buckets = {};
+    int64_t count = 0;
+    int64_t sum = 0;
+
+    // The upper bound of the bucket that holds quantile q, which is in [0, 1].
+    uint64_t Quantile(double q) const;
+  };
+
+  static int BucketIndex(uint64_t v) {
+    int idx = v == 0 ? 0 : 64 - __builtin_clzll(v);
+    return idx < kNumBuckets ? idx : kNumBuckets - 1;
+  }
+
+  // The exclusive upper bound of the bucket.
+  static uint64_t BucketUpperBound(int idx) {
+    return idx >= kNumBuckets - 1 ? std::numeric_limits<uint64_t>::max() : uint64_t{1} << idx;
+  }
+
+  void Record(uint64_t v) {
+    Shard& shard = shards_[internal::ThreadShard()];
+    shard.buckets[BucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(static_cast<int64_t>(v), std::memory_order_relaxed);
+  }
+
+  Snapshot GetSnapshot() const;
+
+ private:
+  struct alignas(64) Shard {
+    std::array<std::atomic<int64_t>, kNumBuckets> buckets = {};
+    std::atomic<int64_t> sum = 0;
+  };
+
+  std::array<Shard, internal::kNumMetricShards> shards_;
+};
+
+/**
+ * Records the time from construction to destruction, in nanoseconds, into the histogram.
+ */
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Histogram* histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    histogram_->Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count());
+  }
+
+ private:
+  Histogram* histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * The registry of Stirling's internal metrics. Metrics are registered once, typically when a
+ * connector is created, and live as long as the registry, so callers keep the returned pointers
+ * and update them without going through the registry.
+ */
+class MetricsRegistry : public NotCopyable {
+ public:
+  using Labels = std::vector<std::pair<std::string, std::string>>;
+
+  enum class Type { kCounter, kHistogram };
+
+  /**
+   * The registry that Stirling's components register their metrics in.
+   */
+  static MetricsRegistry& Global();
+
+  /**
+   * Returns the counter with the name and labels, registering it on the first call.
+   */
+  Counter* GetCounter(std::string_view name, std::string_view help, const Labels& labels = {});
+
+  /**
+   * Returns the histogram with the name and labels, registering it on the first call.
+   */
+  Histogram* GetHistogram(std::string_view name, std::string_view help,
+                          const Labels& labels = {});
+
+  /**
+   * Calls fn for every registered metric, in name order. Exactly one of counter and histogram
+   * is set.
+   */
+  void ForEach(const std::function<void(std::string_view name, const Labels& labels,
+                                        const Counter* counter, const Histogram* histogram)>& fn)
+      const;
+
+  /**
+   * The metrics in the Prometheus text exposition format.
+   */
+  std::string PrometheusText() const;
+
+ private:
+  struct Family {
+    Type type;
+    std::string help;
+    std::map<Labels, std::unique_ptr<Counter>> counters;
+    std::map<Labels, std::unique_ptr<Histogram>> histograms;
+  };
+
+  Family* GetFamily(std::string_view name, std::string_view help, Type type)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  mutable absl::Mutex mutex_;
+  std::map<std::string, Family, std::less<>> families_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
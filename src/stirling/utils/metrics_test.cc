@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/stirling/utils/metrics.h"
+
+#include <thread>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace stirling {
+namespace utils {
+
+using ::testing::HasSubstr;
+
+TEST(CounterTest, AddFromManyThreads) {
+  Counter counter;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&counter]() {
+      for (int i = 0; i < 1000; ++i) {
+        counter.Add();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(counter.Value(), 8000);
+}
+
+TEST(HistogramTest, Buckets) {
+  EXPECT_EQ(Histogram::BucketIndex(0), 0);
+  EXPECT_EQ(Histogram::BucketIndex(1), 1);
+  EXPECT_EQ(Histogram::BucketIndex(2), 2);
+  EXPECT_EQ(Histogram::BucketIndex(3), 2);
+  EXPECT_EQ(Histogram::BucketIndex(4), 3);
+  EXPECT_EQ(Histogram::BucketIndex(std::numeric_limits<uint64_t>::max()),
+            Histogram::kNumBuckets - 1);
+}
+
+TEST(HistogramTest, Snapshot) {
+  Histogram histogram;
+  for (int i = 0; i < 100; ++i) {
+    histogram.Record(i < 90 ? 10 : 1000);
+  }
+  Histogram::Snapshot snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, 100);
+  EXPECT_EQ(snapshot.sum, 90 * 10 + 10 * 1000);
+  // Quantiles are the upper bounds of the buckets of the values.
+  EXPECT_EQ(snapshot.Quantile(0.5), 15);
+  EXPECT_EQ(snapshot.Quantile(0.99), 1023);
+  EXPECT_EQ(Histogram::Snapshot().Quantile(0.5), 0);
+}
+
+TEST(MetricsRegistryTest, GetReturnsTheRegisteredMetric) {
+  MetricsRegistry registry;
+  Counter* http = registry.GetCounter("events_total", "Events.", {{"protocol", "http"}});
+  Counter* mysql = registry.GetCounter("events_total", "Events.", {{"protocol", "mysql"}});
+  EXPECT_NE(http, mysql);
+  EXPECT_EQ(http, registry.GetCounter("events_total", "Events.", {{"protocol", "http"}}));
+
+  int num_metrics = 0;
+  registry.GetHistogram("poll_ns", "Poll time.");
+  registry.ForEach([&num_metrics](std::string_view, const MetricsRegistry::Labels&,
+                                  const Counter* counter, const Histogram* histogram) {
+    EXPECT_NE(counter == nullptr, histogram == nullptr);
+    ++num_metrics;
+  });
+  EXPECT_EQ(num_metrics, 3);
+}
+
+TEST(MetricsRegistryTest, PrometheusText) {
+  MetricsRegistry registry;
+  registry.GetCounter("events_total", "Events.", {{"protocol", "http"}})->Add(3);
+  Histogram* histogram = registry.GetHistogram("poll_ns", "Poll time.");
+  histogram->Record(0);
+  histogram->Record(5);
+
+  std::string text = registry.PrometheusText();
+  EXPECT_THAT(text, HasSubstr("# TYPE events_total counter\n"));
+  EXPECT_THAT(text, HasSubstr("events_total{protocol=\"http\"} 3\n"));
+  EXPECT_THAT(text, HasSubstr("# TYPE poll_ns histogram\n"));
+  EXPECT_THAT(text, HasSubstr("poll_ns_bucket{le=\"0\"} 1\n"));
+  EXPECT_THAT(text, HasSubstr("poll_ns_bucket{le=\"3\"} 1\n"));
+  EXPECT_THAT(text, HasSubstr("poll_ns_bucket{le=\"7\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("poll_ns_bucket{le=\"+Inf\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("poll_ns_sum 5\n"));
+  EXPECT_THAT(text, HasSubstr("poll_ns_count 2\n"));
+}
+
+}  // namespace utils
+}  // namespace stirling
+}  // namespace px
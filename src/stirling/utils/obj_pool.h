@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -27,10 +28,29 @@ namespace stirling {
 
 /**
  * ObjPool manages a pool of objects that can be recycled to avoid memory reallocations.
+ *
+ * Pop() and Recycle() are on the hot path of event ingestion, so they don't log. How well the
+ * pool is doing is tracked by its stats instead.
+ *
+ * Not thread-safe.
  */
 template <typename T>
 class ObjPool {
  public:
+  struct Stats {
+    // Pops that were served by a recycled object.
+    uint64_t hits = 0;
+    // Pops that had to allocate a new object.
+    uint64_t misses = 0;
+    // Recycled objects that were deallocated because the pool was at capacity.
+    uint64_t dropped = 0;
+
+    double hit_rate() const {
+      uint64_t pops = hits + misses;
+      return pops == 0 ? 0.0 : static_cast<double>(hits) / pops;
+    }
+  };
+
   explicit ObjPool(size_t capacity) : capacity_(capacity) { obj_pool_.reserve(capacity_); }
 
   ~ObjPool() {
@@ -49,12 +69,11 @@ class ObjPool {
    */
   std::unique_ptr<T> Pop() {
     if (obj_pool_.empty()) {
-      auto obj_ptr = std::make_unique<T>();
-      VLOG(1) << absl::Substitute("Pool is empty...creating new object [addr=$0].", obj_ptr.get());
-      return obj_ptr;
+      ++stats_.misses;
+      return std::make_unique<T>();
     }
 
-    VLOG(1) << absl::Substitute("Retrieving object from recycle pool [addr=$0].", obj_pool_.back());
+    ++stats_.hits;
     // The objects's memory was never released, but we still to initialize the object
     // as though it is new, so we use C++ "placement new" to do so.
     // This avoids a new memory allocation, but does still initialize the object.
@@ -69,20 +88,22 @@ class ObjPool {
    */
   void Recycle(std::unique_ptr<T> obj) {
     if (obj_pool_.size() >= capacity_) {
-      VLOG(1) << absl::Substitute("Pool is at capacity...deallocating object [addr=$0].",
-                                  obj.get());
+      ++stats_.dropped;
       return;
     }
 
-    VLOG(1) << absl::Substitute("Adding object to recycle pool [addr=$0].", obj.get());
     T* obj_ptr = obj.release();
     obj_pool_.push_back(obj_ptr);
     obj_ptr->~T();
   }
 
+  size_t size() const { return obj_pool_.size(); }
+  const Stats& stats() const { return stats_; }
+
  private:
   size_t capacity_;
   std::vector<T*> obj_pool_;
+  Stats stats_;
 };
 
 }  // namespace stirling
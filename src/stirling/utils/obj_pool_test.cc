@@ -90,5 +90,26 @@ TEST_F(ObjPoolTest, Capacity) {
   EXPECT_NE(uptrs[4].get(), ptrs[3]);
 }
 
+TEST_F(ObjPoolTest, Stats) {
+  std::vector<std::unique_ptr<TestObject>> objs;
+  for (int i = 0; i < 5; ++i) {
+    objs.push_back(obj_pool.Pop());
+  }
+  for (auto& obj : objs) {
+    obj_pool.Recycle(std::move(obj));
+  }
+  objs.clear();
+  EXPECT_EQ(obj_pool.size(), 4);
+
+  for (int i = 0; i < 3; ++i) {
+    objs.push_back(obj_pool.Pop());
+  }
+
+  EXPECT_EQ(obj_pool.stats().hits, 3);
+  EXPECT_EQ(obj_pool.stats().misses, 5);
+  EXPECT_EQ(obj_pool.stats().dropped, 1);
+  EXPECT_DOUBLE_EQ(obj_pool.stats().hit_rate(), 3.0 / 8);
+}
+
 }  // namespace stirling
 }  // namespace px
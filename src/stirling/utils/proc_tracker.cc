@@ -18,14 +18,69 @@
 
 #include "src/stirling/utils/proc_tracker.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "src/common/system/proc_parser.h"
+#include "src/stirling/utils/index_sorted_vector.h"
 
 namespace px {
 namespace stirling {
 
+std::unique_ptr<UPIDsDelta> ComputeUPIDsDelta(const absl::flat_hash_set<md::UPID>& upids,
+                                              uint64_t upids_version, const UPIDsDelta* prev) {
+  auto delta = std::make_unique<UPIDsDelta>();
+  delta->version = upids_version;
+  if (prev != nullptr && prev->version == upids_version) {
+    delta->sorted_upids = prev->sorted_upids;
+    delta->prev_version = prev->version;
+    return delta;
+  }
+
+  auto sorted_upids = std::make_shared<std::vector<md::UPID>>(upids.begin(), upids.end());
+  std::sort(sorted_upids->begin(), sorted_upids->end());
+  if (prev != nullptr) {
+    utils::DiffSortedVectors(*prev->sorted_upids, *sorted_upids, &delta->new_upids,
+                             &delta->deleted_upids);
+    delta->prev_version = prev->version;
+  }
+  delta->sorted_upids = std::move(sorted_upids);
+  return delta;
+}
+
+void ProcTracker::Update(const absl::flat_hash_set<md::UPID>& upids, uint64_t upids_version,
+                         const UPIDsDelta* upids_delta) {
+  if (upids_delta == nullptr || upids_delta->version != upids_version ||
+      !upids_version_.has_value() || upids_delta->prev_version != upids_version_) {
+    Update(upids, upids_version);
+    return;
+  }
+
+  new_upids_.clear();
+  deleted_upids_.clear();
+  for (const auto& upid : upids_delta->deleted_upids) {
+    upids_.erase(upid);
+    deleted_upids_.insert(upid);
+  }
+  for (const auto& upid : upids_delta->new_upids) {
+    upids_.insert(upid);
+    new_upids_.insert(upid);
+  }
+  upids_version_ = upids_version;
+}
+
+void ProcTracker::Update(const absl::flat_hash_set<md::UPID>& upids, uint64_t upids_version) {
+  if (upids_version_ == upids_version) {
+    new_upids_.clear();
+    deleted_upids_.clear();
+    return;
+  }
+  Update(upids);
+  upids_version_ = upids_version;
+}
+
 void ProcTracker::Update(absl::flat_hash_set<md::UPID> upids) {
+  upids_version_.reset();
   new_upids_.clear();
   for (const auto& upid : upids) {
     auto iter = upids_.find(upid);
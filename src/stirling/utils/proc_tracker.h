@@ -18,6 +18,10 @@
 
 #pragma once
 
+#include <memory>
+#include <optional>
+#include <vector>
+
 #include <absl/container/flat_hash_set.h>
 
 #include "src/common/system/proc_parser.h"
@@ -26,6 +30,26 @@
 namespace px {
 namespace stirling {
 
+/**
+ * The UPIDs of a version of the UPIDs, kept sorted, and how they differ from the previous version.
+ * Computed once per ConnectorContext, and shared by all the ProcTrackers that are updated from it.
+ */
+struct UPIDsDelta {
+  uint64_t version = 0;
+  std::shared_ptr<const std::vector<md::UPID>> sorted_upids;
+
+  // The version that new_upids and deleted_upids are relative to. Not set for the first version.
+  std::optional<uint64_t> prev_version;
+  std::vector<md::UPID> new_upids;
+  std::vector<md::UPID> deleted_upids;
+};
+
+/**
+ * Computes the UPIDsDelta of upids relative to prev, which may be nullptr.
+ */
+std::unique_ptr<UPIDsDelta> ComputeUPIDsDelta(const absl::flat_hash_set<md::UPID>& upids,
+                                              uint64_t upids_version, const UPIDsDelta* prev);
+
 /**
  * Keeps a list of UPIDs. Tracks newly-created and terminated processes each time an update is
  * provided, and updates its internal list of UPIDs.
@@ -38,6 +62,22 @@ class ProcTracker : NotCopyMoveable {
    */
   void Update(absl::flat_hash_set<md::UPID> upids);
 
+  /**
+   * Same as Update(), but skips copying and diffing the upids if upids_version is the version of
+   * the previous update, in which case there are no new and deleted upids.
+   * @param upids Current set of UPIDs.
+   * @param upids_version The version of upids, see ConnectorContext::GetUPIDsVersion().
+   */
+  void Update(const absl::flat_hash_set<md::UPID>& upids, uint64_t upids_version);
+
+  /**
+   * Same as above, but if upids_delta is relative to the version of the previous update, applies
+   * the delta instead of diffing all the upids.
+   * @param upids_delta The delta of upids, see ConnectorContext::GetUPIDsDelta(). May be nullptr.
+   */
+  void Update(const absl::flat_hash_set<md::UPID>& upids, uint64_t upids_version,
+              const UPIDsDelta* upids_delta);
+
   /**
    * Returns all current upids, as set by last call to Update().
    */
@@ -57,6 +97,7 @@ class ProcTracker : NotCopyMoveable {
   absl::flat_hash_set<md::UPID> upids_;
   absl::flat_hash_set<md::UPID> new_upids_;
   absl::flat_hash_set<md::UPID> deleted_upids_;
+  std::optional<uint64_t> upids_version_;
 };
 
 }  // namespace stirling
@@ -21,9 +21,12 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+
 namespace px {
 namespace stirling {
 
+using ::testing::ElementsAre;
 using ::testing::IsEmpty;
 using ::testing::UnorderedElementsAre;
 
@@ -61,5 +64,70 @@ TEST_F(ProcTrackerTest, Basic) {
   EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID3));
 }
 
+TEST_F(ProcTrackerTest, Versioned) {
+  using UPIDSet = absl::flat_hash_set<md::UPID>;
+
+  const md::UPID kUPID1 = md::UPID(0, 1, 111);
+  const md::UPID kUPID2 = md::UPID(0, 2, 222);
+
+  proc_tracker_.Update(UPIDSet{kUPID1}, /*upids_version*/ 1);
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID1));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID1));
+
+  // The same version is not diffed again.
+  proc_tracker_.Update(UPIDSet{kUPID1}, /*upids_version*/ 1);
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID1));
+  EXPECT_THAT(proc_tracker_.new_upids(), IsEmpty());
+  EXPECT_THAT(proc_tracker_.deleted_upids(), IsEmpty());
+
+  proc_tracker_.Update(UPIDSet{kUPID2}, /*upids_version*/ 2);
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID2));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID2));
+  EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID1));
+
+  // An unversioned update is always diffed, and so is the next versioned one.
+  proc_tracker_.Update(UPIDSet{kUPID1, kUPID2});
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID1));
+  proc_tracker_.Update(UPIDSet{kUPID2}, /*upids_version*/ 2);
+  EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID1));
+}
+
+TEST_F(ProcTrackerTest, Delta) {
+  using UPIDSet = absl::flat_hash_set<md::UPID>;
+
+  const md::UPID kUPID1 = md::UPID(0, 1, 111);
+  const md::UPID kUPID2 = md::UPID(0, 2, 222);
+  const md::UPID kUPID3 = md::UPID(0, 3, 333);
+
+  const UPIDSet upids1 = {kUPID1, kUPID2};
+  std::unique_ptr<UPIDsDelta> delta1 = ComputeUPIDsDelta(upids1, /*upids_version*/ 1, nullptr);
+  EXPECT_THAT(*delta1->sorted_upids, ElementsAre(kUPID1, kUPID2));
+  EXPECT_FALSE(delta1->prev_version.has_value());
+
+  const UPIDSet upids2 = {kUPID2, kUPID3};
+  std::unique_ptr<UPIDsDelta> delta2 = ComputeUPIDsDelta(upids2, /*upids_version*/ 2, delta1.get());
+  ASSERT_TRUE(delta2->prev_version.has_value());
+  EXPECT_EQ(*delta2->prev_version, 1u);
+  EXPECT_THAT(delta2->new_upids, ElementsAre(kUPID3));
+  EXPECT_THAT(delta2->deleted_upids, ElementsAre(kUPID1));
+
+  // The first update has nothing to apply the delta to, and diffs the upids.
+  proc_tracker_.Update(upids1, /*upids_version*/ 1, delta1.get());
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID1, kUPID2));
+
+  proc_tracker_.Update(upids2, /*upids_version*/ 2, delta2.get());
+  EXPECT_THAT(proc_tracker_.upids(), UnorderedElementsAre(kUPID2, kUPID3));
+  EXPECT_THAT(proc_tracker_.new_upids(), UnorderedElementsAre(kUPID3));
+  EXPECT_THAT(proc_tracker_.deleted_upids(), UnorderedElementsAre(kUPID1));
+
+  // A tracker that missed a version cannot apply the delta, and diffs the upids instead.
+  ProcTracker stale_tracker;
+  stale_tracker.Update(UPIDSet{kUPID1}, /*upids_version*/ 0);
+  stale_tracker.Update(upids2, /*upids_version*/ 2, delta2.get());
+  EXPECT_THAT(stale_tracker.upids(), UnorderedElementsAre(kUPID2, kUPID3));
+  EXPECT_THAT(stale_tracker.new_upids(), UnorderedElementsAre(kUPID2, kUPID3));
+  EXPECT_THAT(stale_tracker.deleted_upids(), UnorderedElementsAre(kUPID1));
+}
+
 }  // namespace stirling
 }  // namespace px
@@ -17,9 +17,12 @@
  */
 
 #include <arrow/array.h>
+#include <arrow/buffer.h>
 #include <algorithm>
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <absl/strings/str_format.h>
@@ -34,7 +37,27 @@ namespace schema {
 
 using types::DataType;
 
-std::shared_ptr<arrow::Array> RowBatch::ColumnAt(int64_t i) const { return columns_[i]; }
+std::shared_ptr<arrow::Array> RowBatch::ColumnAt(int64_t i) const {
+  if (columns_[i] == nullptr) {
+    columns_[i] = deferred_columns_[i]->Materialize();
+  }
+  return columns_[i];
+}
+
+StatusOr<std::shared_ptr<arrow::Array>> RowBatch::DeferredColumnRowsAt(
+    int64_t i, const std::vector<int64_t>& rows) const {
+  if (!IsDeferredColumn(i)) {
+    return error::InvalidArgument("Column[$0] is not deferred", i);
+  }
+  return deferred_columns_[i]->MaterializeRows(rows);
+}
+
+std::vector<std::shared_ptr<arrow::Array>> RowBatch::columns() const {
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    ColumnAt(i);
+  }
+  return columns_;
+}
 
 Status RowBatch::AddColumn(const std::shared_ptr<arrow::Array>& col) {
   if (columns_.size() >= desc_.size()) {
@@ -48,6 +71,22 @@ Status RowBatch::AddColumn(const std::shared_ptr<arrow::Array>& col) {
   }
 
   columns_.emplace_back(col);
+  if (!deferred_columns_.empty()) {
+    deferred_columns_.emplace_back(nullptr);
+  }
+  return Status::OK();
+}
+
+Status RowBatch::AddDeferredColumn(std::shared_ptr<DeferredColumn> col) {
+  if (columns_.size() >= desc_.size()) {
+    return error::InvalidArgument("Schema only allows $0 columns", desc_.size());
+  }
+  if (col->length() != num_rows_) {
+    return error::InvalidArgument("Schema only allows $0 rows, got $1", num_rows_, col->length());
+  }
+  deferred_columns_.resize(columns_.size());
+  deferred_columns_.emplace_back(std::move(col));
+  columns_.emplace_back(nullptr);
   return Status::OK();
 }
 
@@ -58,8 +97,8 @@ std::string RowBatch::DebugString() const {
     return "RowBatch: <empty>";
   }
   std::string debug_string = absl::StrFormat("RowBatch(eow=%d, eos=%d):\n", eow_, eos_);
-  for (const auto& col : columns_) {
-    debug_string += absl::StrFormat("  %s\n", col->ToString());
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    debug_string += absl::StrFormat("  %s\n", ColumnAt(i)->ToString());
   }
   return debug_string;
 }
@@ -70,7 +109,12 @@ int64_t RowBatch::NumBytes() const {
   }
 
   int64_t total_bytes = 0;
-  for (auto col : columns_) {
+  for (const auto& [col_idx, col] : Enumerate(columns_)) {
+    if (col == nullptr) {
+      // Don't materialize deferred columns just to size them.
+      total_bytes += deferred_columns_[col_idx]->NumBytes();
+      continue;
+    }
 #define TYPE_CASE(_dt_) total_bytes += types::GetArrowArrayBytes<_dt_>(col.get());
     PL_SWITCH_FOREACH_DATATYPE(types::ArrowToDataType(col->type_id()), TYPE_CASE);
 #undef TYPE_CASE
@@ -199,6 +243,9 @@ StatusOr<DataType> ProtoDataType(const table_store::schemapb::Column& proto) {
 
 StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
     const table_store::schemapb::RowBatchData& proto) {
+  if (proto.arrow_cols_size() > 0) {
+    return FromProto(table_store::schemapb::RowBatchData(proto));
+  }
   std::vector<DataType> types(proto.cols_size());
   std::vector<std::shared_ptr<arrow::Array>> data_columns(proto.cols_size());
 
@@ -223,6 +270,159 @@ StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
   return output_rb;
 }
 
+namespace {
+
+// An arrow buffer that takes ownership of the bytes of a proto field, so that they don't have to
+// be copied into an arrow allocation.
+class StringBuffer : public arrow::Buffer {
+ public:
+  explicit StringBuffer(std::string&& bytes) : arrow::Buffer(nullptr, 0), bytes_(std::move(bytes)) {
+    // Short strings are stored inline and may not be aligned for the values read out of them.
+    // Reserving forces them onto the heap.
+    if (reinterpret_cast<uintptr_t>(bytes_.data()) % alignof(std::max_align_t) != 0) {
+      bytes_.reserve(kMinHeapCapacity);
+    }
+    data_ = reinterpret_cast<const uint8_t*>(bytes_.data());
+    size_ = bytes_.size();
+    capacity_ = bytes_.size();
+  }
+
+ private:
+  // Larger than the inline capacity of std::string in both libstdc++ and libc++.
+  static constexpr size_t kMinHeapCapacity = 64;
+  std::string bytes_;
+};
+
+template <DataType T>
+void CopyIntoOutputArrowPB(table_store::schemapb::RowBatchData::ArrowColumn* output_column,
+                           const arrow::Array& input_column) {
+  output_column->set_data_type(T);
+  int64_t length = input_column.length();
+  if (length == 0) {
+    // The buffers of empty arrays may not have been allocated.
+    if constexpr (T == DataType::STRING) {
+      output_column->mutable_offsets()->assign(sizeof(int32_t), '\0');
+    }
+    return;
+  }
+  if constexpr (T == DataType::BOOLEAN) {
+    // The values are copied one at a time to bit pack them from the start of the buffer,
+    // regardless of the offset of the input array.
+    const auto& arr = static_cast<const arrow::BooleanArray&>(input_column);
+    std::string* data = output_column->mutable_data();
+    data->assign((length + 7) / 8, 0);
+    for (int64_t i = 0; i < length; ++i) {
+      if (arr.Value(i)) {
+        (*data)[i / 8] |= static_cast<char>(1 << (i % 8));
+      }
+    }
+  } else if constexpr (T == DataType::STRING) {
+    const auto& arr = static_cast<const arrow::StringArray&>(input_column);
+    const int32_t* offsets = arr.raw_value_offsets();
+    int32_t base = offsets[0];
+    std::string* out_offsets = output_column->mutable_offsets();
+    out_offsets->resize((length + 1) * sizeof(int32_t));
+    auto* out = reinterpret_cast<int32_t*>(out_offsets->data());
+    for (int64_t i = 0; i <= length; ++i) {
+      out[i] = offsets[i] - base;
+    }
+    output_column->set_data(reinterpret_cast<const char*>(arr.value_data()->data()) + base,
+                            offsets[length] - base);
+  } else {
+    using native_type = typename types::DataTypeTraits<T>::native_type;
+    const uint8_t* values =
+        input_column.data()->buffers[1]->data() + input_column.offset() * sizeof(native_type);
+    output_column->set_data(reinterpret_cast<const char*>(values), length * sizeof(native_type));
+  }
+}
+
+template <DataType T>
+StatusOr<std::shared_ptr<arrow::Array>> ArrowColumnFromPB(
+    int64_t num_rows, table_store::schemapb::RowBatchData::ArrowColumn* input_column) {
+  auto type = std::make_shared<typename types::DataTypeTraits<T>::arrow_type>();
+  int64_t expected_bytes;
+  if constexpr (T == DataType::BOOLEAN) {
+    expected_bytes = (num_rows + 7) / 8;
+  } else if constexpr (T == DataType::STRING) {
+    const std::string& offsets_bytes = input_column->offsets();
+    if (offsets_bytes.size() != (num_rows + 1) * sizeof(int32_t)) {
+      return error::InvalidArgument("Expected $0 offsets for STRING column, got $1 bytes",
+                                    num_rows + 1, offsets_bytes.size());
+    }
+    auto offsets = std::make_shared<StringBuffer>(std::move(*input_column->mutable_offsets()));
+    const auto* raw_offsets = reinterpret_cast<const int32_t*>(offsets->data());
+    for (int64_t i = 0; i < num_rows; ++i) {
+      if (raw_offsets[i] > raw_offsets[i + 1]) {
+        return error::InvalidArgument("STRING column offsets must not decrease");
+      }
+    }
+    if (raw_offsets[0] != 0 ||
+        raw_offsets[num_rows] != static_cast<int64_t>(input_column->data().size())) {
+      return error::InvalidArgument("STRING column offsets don't match its $0 bytes of data",
+                                    input_column->data().size());
+    }
+    auto data = std::make_shared<StringBuffer>(std::move(*input_column->mutable_data()));
+    return arrow::MakeArray(arrow::ArrayData::Make(type, num_rows, {nullptr, offsets, data}, 0));
+  } else {
+    expected_bytes = num_rows * sizeof(typename types::DataTypeTraits<T>::native_type);
+  }
+  if (static_cast<int64_t>(input_column->data().size()) != expected_bytes) {
+    return error::InvalidArgument("Expected $0 bytes for $1 column, got $2", expected_bytes,
+                                  magic_enum::enum_name(T), input_column->data().size());
+  }
+  auto values = std::make_shared<StringBuffer>(std::move(*input_column->mutable_data()));
+  return arrow::MakeArray(arrow::ArrayData::Make(type, num_rows, {nullptr, values}, 0));
+}
+
+}  // namespace
+
+Status RowBatch::ToArrowProto(table_store::schemapb::RowBatchData* proto) const {
+  proto->set_num_rows(num_rows_);
+  proto->set_eow(eow_);
+  proto->set_eos(eos_);
+
+  for (auto col_idx = 0; col_idx < num_columns(); ++col_idx) {
+    auto input_col = ColumnAt(col_idx);
+    auto output_col = proto->add_arrow_cols();
+
+#define TYPE_CASE(_dt_) CopyIntoOutputArrowPB<_dt_>(output_col, *input_col);
+    PL_SWITCH_FOREACH_DATATYPE(desc_.type(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  return Status::OK();
+}
+
+StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromProto(
+    table_store::schemapb::RowBatchData&& proto) {
+  if (proto.arrow_cols_size() == 0) {
+    return FromProto(static_cast<const table_store::schemapb::RowBatchData&>(proto));
+  }
+  std::vector<DataType> types(proto.arrow_cols_size());
+  std::vector<std::shared_ptr<arrow::Array>> data_columns(proto.arrow_cols_size());
+
+  for (auto i = 0; i < proto.arrow_cols_size(); ++i) {
+    auto input_col = proto.mutable_arrow_cols(i);
+    types[i] = input_col->data_type();
+
+#define TYPE_CASE(_dt_) \
+  PL_ASSIGN_OR_RETURN(data_columns[i], ArrowColumnFromPB<_dt_>(proto.num_rows(), input_col));
+    PL_SWITCH_FOREACH_DATATYPE(types[i], TYPE_CASE);
+#undef TYPE_CASE
+  }
+
+  std::unique_ptr<RowBatch> output_rb = std::make_unique<RowBatch>(RowDescriptor(types),
+                                                                   proto.num_rows());
+  output_rb->set_eow(proto.eow());
+  output_rb->set_eos(proto.eos());
+
+  for (const auto& col : data_columns) {
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(col));
+  }
+
+  return output_rb;
+}
+
 StatusOr<std::unique_ptr<RowBatch>> RowBatch::FromColumnBuilders(
     const RowDescriptor& desc, bool eow, bool eos,
     std::vector<std::unique_ptr<arrow::ArrayBuilder>>* builders) {
@@ -33,6 +33,37 @@ namespace px {
 namespace table_store {
 namespace schema {
 
+/**
+ * A DeferredColumn is a column of a RowBatch that has not been converted to arrow yet. It is
+ * converted the first time the column is accessed, and consumers that only need some of the rows
+ * (ie. filters) can convert just those.
+ */
+class DeferredColumn {
+ public:
+  virtual ~DeferredColumn() = default;
+
+  /**
+   * @return the number of rows in the column.
+   */
+  virtual int64_t length() const = 0;
+
+  /**
+   * @return an estimate of the number of bytes the column takes up once materialized.
+   */
+  virtual int64_t NumBytes() const = 0;
+
+  /**
+   * Converts the whole column to an arrow array.
+   */
+  virtual std::shared_ptr<arrow::Array> Materialize() const = 0;
+
+  /**
+   * Converts only the given rows, in the given order, to an arrow array.
+   */
+  virtual std::shared_ptr<arrow::Array> MaterializeRows(
+      const std::vector<int64_t>& rows) const = 0;
+};
+
 /**
  * A RowBatch is a table-like structure which consists of equal-length arrays
  * that match the schema described by the RowDescriptor.
@@ -50,9 +81,23 @@ class RowBatch {
   }
 
   Status ToProto(table_store::schemapb::RowBatchData* row_batch_proto) const;
+
+  /**
+   * Serializes the row batch with each column as its raw arrow buffers (arrow_cols), which is a
+   * bulk copy per column instead of ToProto's copy per value. Only Carnot can read this encoding.
+   */
+  Status ToArrowProto(table_store::schemapb::RowBatchData* row_batch_proto) const;
+
   static StatusOr<std::unique_ptr<RowBatch>> FromProto(
       const table_store::schemapb::RowBatchData& row_batch_proto);
 
+  /**
+   * Same as above, except that the arrow_cols buffers are moved out of the proto and used by the
+   * columns as is, instead of being copied.
+   */
+  static StatusOr<std::unique_ptr<RowBatch>> FromProto(
+      table_store::schemapb::RowBatchData&& row_batch_proto);
+
   static StatusOr<std::unique_ptr<RowBatch>> FromColumnBuilders(
       const RowDescriptor& desc, bool eow, bool eos,
       std::vector<std::unique_ptr<arrow::ArrayBuilder>>* builders);
@@ -82,6 +127,36 @@ class RowBatch {
    */
   Status AddColumn(const std::shared_ptr<arrow::Array>& col);
 
+  /**
+   * Adds a column that is only converted to arrow when it is first accessed through ColumnAt.
+   * Not thread safe: a deferred column must not be accessed concurrently before it has been
+   * materialized.
+   */
+  Status AddDeferredColumn(std::shared_ptr<DeferredColumn> col);
+
+  /**
+   * @ param i the index of the column to check.
+   * @ returns whether the column at the given index has not been materialized yet.
+   */
+  bool IsDeferredColumn(int64_t i) const {
+    return static_cast<size_t>(i) < columns_.size() && columns_[i] == nullptr;
+  }
+
+  /**
+   * @ returns the deferred column at index i, which must not have been materialized yet.
+   */
+  std::shared_ptr<DeferredColumn> DeferredColumnAt(int64_t i) const {
+    DCHECK(IsDeferredColumn(i));
+    return deferred_columns_[i];
+  }
+
+  /**
+   * Converts only the given rows of the deferred column at index i. The column itself stays
+   * deferred.
+   */
+  StatusOr<std::shared_ptr<arrow::Array>> DeferredColumnRowsAt(
+      int64_t i, const std::vector<int64_t>& rows) const;
+
   /**
    * @ param i the index of the column to be accessed.
    * @ returns the Arrow array for the column at the given index.
@@ -116,7 +191,7 @@ class RowBatch {
   const RowDescriptor& desc() const { return desc_; }
 
   std::string DebugString() const;
-  std::vector<std::shared_ptr<arrow::Array>> columns() const { return columns_; }
+  std::vector<std::shared_ptr<arrow::Array>> columns() const;
 
   int64_t NumBytes() const;
 
@@ -125,7 +200,10 @@ class RowBatch {
   int64_t num_rows_;
   bool eow_ = false;
   bool eos_ = false;
-  std::vector<std::shared_ptr<arrow::Array>> columns_;
+  // Null entries are deferred columns that have not been materialized yet.
+  mutable std::vector<std::shared_ptr<arrow::Array>> columns_;
+  // Indexed like columns_, only populated once a deferred column is added.
+  std::vector<std::shared_ptr<DeferredColumn>> deferred_columns_;
 };
 
 // Append a scalar value to an arrow::Array.
@@ -19,6 +19,8 @@
 #include <arrow/array.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/message_differencer.h>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include "src/common/testing/testing.h"
@@ -179,6 +181,47 @@ TEST_F(RowBatchTest, to_from_proto) {
   EXPECT_TRUE(differ.Compare(input_proto, output_proto));
 }
 
+TEST_F(RowBatchTest, to_from_arrow_proto) {
+  table_store::schemapb::RowBatchData input_proto;
+  ASSERT_TRUE(google::protobuf::TextFormat::MergeFromString(kTestRowBatchProto, &input_proto));
+  auto rb = RowBatch::FromProto(input_proto).ConsumeValueOrDie();
+
+  table_store::schemapb::RowBatchData arrow_proto;
+  EXPECT_OK(rb->ToArrowProto(&arrow_proto));
+  EXPECT_EQ(0, arrow_proto.cols_size());
+  EXPECT_EQ(3, arrow_proto.arrow_cols_size());
+
+  // Copying and moving out of the proto must produce the same row batch.
+  ASSERT_OK_AND_ASSIGN(auto copied_rb, RowBatch::FromProto(arrow_proto));
+  ASSERT_OK_AND_ASSIGN(auto moved_rb, RowBatch::FromProto(std::move(arrow_proto)));
+  for (const auto& output_rb : {copied_rb.get(), moved_rb.get()}) {
+    EXPECT_TRUE(output_rb->eow());
+    EXPECT_FALSE(output_rb->eos());
+    EXPECT_EQ(rb->desc(), output_rb->desc());
+
+    table_store::schemapb::RowBatchData output_proto;
+    EXPECT_OK(output_rb->ToProto(&output_proto));
+    google::protobuf::util::MessageDifferencer differ;
+    EXPECT_TRUE(differ.Compare(input_proto, output_proto));
+  }
+}
+
+TEST_F(RowBatchTest, to_from_arrow_proto_slice) {
+  ASSERT_OK_AND_ASSIGN(auto slice, rb_->Slice(1, 2));
+
+  table_store::schemapb::RowBatchData arrow_proto;
+  EXPECT_OK(slice->ToArrowProto(&arrow_proto));
+  ASSERT_OK_AND_ASSIGN(auto output_rb, RowBatch::FromProto(std::move(arrow_proto)));
+  EXPECT_EQ(slice->DebugString(), output_rb->DebugString());
+}
+
+TEST_F(RowBatchTest, from_arrow_proto_wrong_size) {
+  table_store::schemapb::RowBatchData arrow_proto;
+  EXPECT_OK(rb_->ToArrowProto(&arrow_proto));
+  arrow_proto.mutable_arrow_cols(1)->mutable_data()->pop_back();
+  EXPECT_NOT_OK(RowBatch::FromProto(std::move(arrow_proto)));
+}
+
 TEST_F(RowBatchTest, with_zero_rows) {
   bool eow = true;
   bool eos = false;
@@ -231,6 +274,67 @@ TEST_F(RowBatchTest, slice) {
   ASSERT_EQ(status2.msg(), "Slice(offset=-1, length=3) on rowbatch of length 3 is invalid");
 }
 
+class FakeDeferredColumn : public DeferredColumn {
+ public:
+  explicit FakeDeferredColumn(std::vector<types::Int64Value> values) : values_(std::move(values)) {}
+
+  int64_t length() const override { return values_.size(); }
+  int64_t NumBytes() const override { return values_.size() * sizeof(int64_t); }
+
+  std::shared_ptr<arrow::Array> Materialize() const override {
+    ++num_materialize_calls;
+    return types::ToArrow(values_, arrow::default_memory_pool());
+  }
+
+  std::shared_ptr<arrow::Array> MaterializeRows(const std::vector<int64_t>& rows) const override {
+    std::vector<types::Int64Value> selected;
+    for (auto row : rows) {
+      selected.push_back(values_[row]);
+    }
+    return types::ToArrow(selected, arrow::default_memory_pool());
+  }
+
+  mutable int num_materialize_calls = 0;
+
+ private:
+  std::vector<types::Int64Value> values_;
+};
+
+TEST(DeferredColumnTest, materialized_on_access) {
+  RowDescriptor rd({types::DataType::BOOLEAN, types::DataType::INT64});
+  RowBatch rb(rd, 3);
+  std::vector<types::BoolValue> in1 = {true, false, true};
+  EXPECT_OK(rb.AddColumn(types::ToArrow(in1, arrow::default_memory_pool())));
+  auto deferred = std::make_shared<FakeDeferredColumn>(std::vector<types::Int64Value>{3, 4, 5});
+  EXPECT_OK(rb.AddDeferredColumn(deferred));
+
+  EXPECT_FALSE(rb.IsDeferredColumn(0));
+  EXPECT_TRUE(rb.IsDeferredColumn(1));
+  EXPECT_EQ(3 * sizeof(int64_t) + 3 * sizeof(bool), rb.NumBytes());
+  EXPECT_NOT_OK(rb.DeferredColumnRowsAt(0, {0}));
+
+  ASSERT_OK_AND_ASSIGN(auto rows, rb.DeferredColumnRowsAt(1, {0, 2}));
+  std::vector<types::Int64Value> expected_rows = {3, 5};
+  EXPECT_TRUE(rows->Equals(types::ToArrow(expected_rows, arrow::default_memory_pool())));
+  EXPECT_EQ(0, deferred->num_materialize_calls);
+  EXPECT_TRUE(rb.IsDeferredColumn(1));
+
+  std::vector<types::Int64Value> expected = {3, 4, 5};
+  EXPECT_TRUE(rb.ColumnAt(1)->Equals(types::ToArrow(expected, arrow::default_memory_pool())));
+  EXPECT_TRUE(rb.ColumnAt(1)->Equals(types::ToArrow(expected, arrow::default_memory_pool())));
+  EXPECT_EQ(1, deferred->num_materialize_calls);
+  EXPECT_FALSE(rb.IsDeferredColumn(1));
+}
+
+TEST(DeferredColumnTest, wrong_length) {
+  RowDescriptor rd({types::DataType::INT64});
+  RowBatch rb(rd, 3);
+  EXPECT_NOT_OK(rb.AddDeferredColumn(
+      std::make_shared<FakeDeferredColumn>(std::vector<types::Int64Value>{3, 4})));
+  std::vector<types::Int64Value> in1 = {3, 4, 5};
+  EXPECT_OK(rb.AddColumn(types::ToArrow(in1, arrow::default_memory_pool())));
+}
+
 }  // namespace schema
 }  // namespace table_store
 }  // namespace px
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/cold_arena.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+
+DEFINE_bool(table_store_cold_arena_hugetlb, false,
+            "If true, cold arenas first try to map their slabs from the host's reserved huge "
+            "pages (hugetlbfs), before falling back to transparent huge pages.");
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+// The alignment of arrow's own pools.
+constexpr int64_t kAlignment = 64;
+
+// Zero-size buffers all point here, like with arrow's pools.
+alignas(kAlignment) uint8_t zero_size_area[1];
+
+int64_t RoundUp(int64_t size, int64_t multiple) {
+  return (size + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+ColdArena::~ColdArena() {
+  absl::base_internal::SpinLockHolder lock(&lock_);
+  for (const auto& [start, slab] : slabs_) {
+    munmap(start, slab.size);
+  }
+}
+
+uint8_t* ColdArena::MapRegion(int64_t size) {
+  // Hosts only have explicit huge pages if they reserved some, so stop asking once they ran out.
+  static std::atomic<bool> hugetlb_available = true;
+  if (FLAGS_table_store_cold_arena_hugetlb && hugetlb_available) {
+    void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (region != MAP_FAILED) {
+      return static_cast<uint8_t*>(region);
+    }
+    hugetlb_available = false;
+  }
+
+  // Transparent huge pages need the region to be aligned to them, which mmap doesn't guarantee,
+  // so map a slab more than needed and trim the ends.
+  int64_t mapped_size = size + kSlabBytes;
+  void* region =
+      mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED) {
+    return nullptr;
+  }
+  auto* mapped = static_cast<uint8_t*>(region);
+  auto* start = reinterpret_cast<uint8_t*>(
+      RoundUp(reinterpret_cast<intptr_t>(mapped), static_cast<intptr_t>(kSlabBytes)));
+  if (start > mapped) {
+    munmap(mapped, start - mapped);
+  }
+  int64_t tail = mapped + mapped_size - (start + size);
+  if (tail > 0) {
+    munmap(start + size, tail);
+  }
+  // Without THP (or with it set to "never"), the slab still works with regular pages.
+  madvise(start, size, MADV_HUGEPAGE);
+  return start;
+}
+
+uint8_t* ColdArena::SlabStart(uint8_t* buffer) {
+  return reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(buffer) &
+                                    ~static_cast<uintptr_t>(kSlabBytes - 1));
+}
+
+uint8_t* ColdArena::NewSlabUnlocked(int64_t size) {
+  uint8_t* start = MapRegion(size);
+  if (start == nullptr) {
+    return nullptr;
+  }
+  slabs_[start].size = size;
+  bytes_reserved_ += size;
+  return start;
+}
+
+void ColdArena::UnmapSlabUnlocked(uint8_t* start) {
+  auto it = slabs_.find(start);
+  DCHECK(it != slabs_.end());
+  munmap(start, it->second.size);
+  bytes_reserved_ -= it->second.size;
+  slabs_.erase(it);
+}
+
+void ColdArena::AddBytes(int64_t size) {
+  int64_t allocated = bytes_allocated_.fetch_add(size) + size;
+  int64_t peak = max_memory_.load();
+  while (allocated > peak && !max_memory_.compare_exchange_weak(peak, allocated)) {
+  }
+}
+
+arrow::Status ColdArena::Allocate(int64_t size, uint8_t** out) {
+  if (size < 0) {
+    return arrow::Status::Invalid("negative malloc size");
+  }
+  if (size == 0) {
+    *out = zero_size_area;
+    return arrow::Status::OK();
+  }
+  int64_t aligned_size = RoundUp(size, kAlignment);
+  {
+    absl::base_internal::SpinLockHolder lock(&lock_);
+    if (aligned_size > kSlabBytes / 2) {
+      // A slab of its own, which SlabStart() still finds, since the buffer is the slab's start.
+      int64_t slab_size = RoundUp(aligned_size, kSlabBytes);
+      uint8_t* start = NewSlabUnlocked(slab_size);
+      if (start == nullptr) {
+        return arrow::Status::OutOfMemory("cold arena failed to map ", slab_size, " bytes");
+      }
+      slabs_[start].used = slab_size;
+      slabs_[start].num_buffers = 1;
+      *out = start;
+    } else {
+      if (current_ == nullptr || slabs_[current_].used + aligned_size > kSlabBytes) {
+        // The previous slab is unmapped once its last buffer is freed.
+        current_ = NewSlabUnlocked(kSlabBytes);
+        if (current_ == nullptr) {
+          return arrow::Status::OutOfMemory("cold arena failed to map ", kSlabBytes, " bytes");
+        }
+      }
+      Slab& slab = slabs_[current_];
+      *out = current_ + slab.used;
+      slab.used += aligned_size;
+      ++slab.num_buffers;
+    }
+  }
+  refs_.fetch_add(1);
+  AddBytes(size);
+  return arrow::Status::OK();
+}
+
+arrow::Status ColdArena::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+  if (*ptr != zero_size_area && new_size > 0) {
+    if (new_size <= old_size) {
+      // The rest of the buffer is given back with it.
+      AddBytes(new_size - old_size);
+      return arrow::Status::OK();
+    }
+    absl::base_internal::SpinLockHolder lock(&lock_);
+    // The last buffer of the current slab grows in place, which is how builders grow.
+    if (current_ != nullptr && SlabStart(*ptr) == current_) {
+      Slab& slab = slabs_[current_];
+      int64_t offset = *ptr - current_;
+      int64_t new_end = offset + RoundUp(new_size, kAlignment);
+      if (offset + RoundUp(old_size, kAlignment) == slab.used && new_end <= kSlabBytes) {
+        slab.used = new_end;
+        AddBytes(new_size - old_size);
+        return arrow::Status::OK();
+      }
+    }
+  }
+  uint8_t* out;
+  ARROW_RETURN_NOT_OK(Allocate(new_size, &out));
+  if (*ptr != zero_size_area) {
+    std::memcpy(out, *ptr, std::min(old_size, new_size));
+  }
+  Free(*ptr, old_size);
+  *ptr = out;
+  return arrow::Status::OK();
+}
+
+void ColdArena::Free(uint8_t* buffer, int64_t size) {
+  if (buffer == zero_size_area) {
+    return;
+  }
+  {
+    absl::base_internal::SpinLockHolder lock(&lock_);
+    uint8_t* start = SlabStart(buffer);
+    auto it = slabs_.find(start);
+    DCHECK(it != slabs_.end());
+    if (--it->second.num_buffers == 0) {
+      if (start == current_) {
+        // Keep the current slab mapped, and start over from its beginning.
+        it->second.used = 0;
+      } else {
+        UnmapSlabUnlocked(start);
+      }
+    }
+  }
+  bytes_allocated_.fetch_sub(size);
+  Unref();
+}
+
+}  // namespace table_store
+}  // namespace px
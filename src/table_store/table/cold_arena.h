@@ -0,0 +1,113 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+#include <arrow/status.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include <absl/base/internal/spinlock.h>
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_bool(table_store_cold_arena_hugetlb);
+
+namespace px {
+namespace table_store {
+
+/**
+ * ColdArena is the arrow memory pool of a table's cold batches. It carves their buffers out of
+ * slabs backed by huge pages, so that scans over cold storage take fewer TLB misses, and returns
+ * a slab to the OS as soon as the last of its buffers is freed. Cold batches expire in the order
+ * they were compacted, so slabs empty out whole, instead of leaving the table's expired memory
+ * scattered over the heap.
+ *
+ * Buffers larger than half a slab get a mapping of their own.
+ *
+ * Like the buffers of a query's pool, cold buffers can outlive their table (ie. the arrays of a
+ * scan that is still running), so the table calls Release() instead of deleting the arena, and
+ * the arena deletes itself once the last of its buffers is freed.
+ */
+class ColdArena final : public arrow::MemoryPool {
+ public:
+  // The size of a huge page on x86_64 and arm64, which is also the size of a slab.
+  static constexpr int64_t kSlabBytes = 2 * 1024 * 1024;
+
+  static ColdArena* Create() { return new ColdArena(); }
+
+  /**
+   * Drops the table's reference to the arena. The arena must not be used for new allocations
+   * afterwards.
+   */
+  void Release() { Unref(); }
+
+  arrow::Status Allocate(int64_t size, uint8_t** out) override;
+  arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+  void Free(uint8_t* buffer, int64_t size) override;
+
+  // The bytes of the buffers that are currently allocated.
+  int64_t bytes_allocated() const override { return bytes_allocated_.load(); }
+  int64_t max_memory() const override { return max_memory_.load(); }
+
+  // The bytes of the slabs that are currently mapped, which bound what the arena adds to the RSS.
+  int64_t bytes_reserved() const { return bytes_reserved_.load(); }
+
+ private:
+  struct Slab {
+    int64_t size = 0;
+    // The bytes handed out from the start of the slab so far.
+    int64_t used = 0;
+    int64_t num_buffers = 0;
+  };
+
+  ColdArena() = default;
+  ~ColdArena() override;
+
+  // Maps a region of size bytes, aligned to kSlabBytes and backed by huge pages if possible.
+  static uint8_t* MapRegion(int64_t size);
+  // The start of the slab that the buffer was allocated from.
+  static uint8_t* SlabStart(uint8_t* buffer);
+  uint8_t* NewSlabUnlocked(int64_t size);
+  void UnmapSlabUnlocked(uint8_t* start);
+
+  void AddBytes(int64_t size);
+  void Unref() {
+    if (refs_.fetch_sub(1) == 1) {
+      delete this;
+    }
+  }
+
+  absl::base_internal::SpinLock lock_;
+  // The mapped slabs, by their start.
+  absl::flat_hash_map<uint8_t*, Slab> slabs_ ABSL_GUARDED_BY(lock_);
+  // The slab that buffers up to half a slab are allocated from.
+  uint8_t* current_ ABSL_GUARDED_BY(lock_) = nullptr;
+
+  std::atomic<int64_t> bytes_allocated_{0};
+  std::atomic<int64_t> max_memory_{0};
+  std::atomic<int64_t> bytes_reserved_{0};
+  // One reference for the table, plus one for each live buffer.
+  std::atomic<int64_t> refs_{1};
+};
+
+}  // namespace table_store
+}  // namespace px
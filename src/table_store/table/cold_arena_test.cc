@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/cold_arena.h"
+
+#include <cstring>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace table_store {
+
+class ColdArenaTest : public ::testing::Test {
+ protected:
+  void SetUp() override { arena_ = ColdArena::Create(); }
+  void TearDown() override { arena_->Release(); }
+
+  ColdArena* arena_;
+};
+
+TEST_F(ColdArenaTest, slabs_are_freed_whole) {
+  constexpr int64_t kBufferBytes = 64 * 1024;
+  constexpr int64_t kBuffersPerSlab = ColdArena::kSlabBytes / kBufferBytes;
+
+  std::vector<uint8_t*> buffers(kBuffersPerSlab + 1);
+  for (auto& buffer : buffers) {
+    ASSERT_TRUE(arena_->Allocate(kBufferBytes, &buffer).ok());
+    std::memset(buffer, 1, kBufferBytes);
+  }
+  EXPECT_EQ(kBufferBytes * (kBuffersPerSlab + 1), arena_->bytes_allocated());
+  EXPECT_EQ(2 * ColdArena::kSlabBytes, arena_->bytes_reserved());
+
+  // The first slab is unmapped once all of its buffers are freed.
+  for (int64_t i = 0; i < kBuffersPerSlab - 1; ++i) {
+    arena_->Free(buffers[i], kBufferBytes);
+  }
+  EXPECT_EQ(2 * ColdArena::kSlabBytes, arena_->bytes_reserved());
+  arena_->Free(buffers[kBuffersPerSlab - 1], kBufferBytes);
+  EXPECT_EQ(ColdArena::kSlabBytes, arena_->bytes_reserved());
+
+  // The current slab stays mapped for the next buffers.
+  arena_->Free(buffers[kBuffersPerSlab], kBufferBytes);
+  EXPECT_EQ(0, arena_->bytes_allocated());
+  EXPECT_EQ(ColdArena::kSlabBytes, arena_->bytes_reserved());
+}
+
+TEST_F(ColdArenaTest, large_buffers) {
+  constexpr int64_t kBufferBytes = ColdArena::kSlabBytes + 1;
+  uint8_t* buffer;
+  ASSERT_TRUE(arena_->Allocate(kBufferBytes, &buffer).ok());
+  std::memset(buffer, 1, kBufferBytes);
+  EXPECT_EQ(2 * ColdArena::kSlabBytes, arena_->bytes_reserved());
+  arena_->Free(buffer, kBufferBytes);
+  EXPECT_EQ(0, arena_->bytes_reserved());
+}
+
+TEST_F(ColdArenaTest, reallocate) {
+  uint8_t* buffer;
+  ASSERT_TRUE(arena_->Allocate(100, &buffer).ok());
+  std::memset(buffer, 7, 100);
+
+  // The last buffer grows in place.
+  uint8_t* grown = buffer;
+  ASSERT_TRUE(arena_->Reallocate(100, 1000, &grown).ok());
+  EXPECT_EQ(buffer, grown);
+  EXPECT_EQ(1000, arena_->bytes_allocated());
+
+  // Others are copied.
+  uint8_t* other;
+  ASSERT_TRUE(arena_->Allocate(100, &other).ok());
+  ASSERT_TRUE(arena_->Reallocate(1000, 2000, &grown).ok());
+  EXPECT_NE(buffer, grown);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(7, grown[i]);
+  }
+  EXPECT_EQ(2100, arena_->bytes_allocated());
+
+  arena_->Free(grown, 2000);
+  arena_->Free(other, 100);
+  EXPECT_EQ(0, arena_->bytes_allocated());
+}
+
+TEST(ColdArenaReleaseTest, buffers_outlive_release) {
+  ColdArena* arena = ColdArena::Create();
+  uint8_t* buffer;
+  ASSERT_TRUE(arena->Allocate(100, &buffer).ok());
+  arena->Release();
+  std::memset(buffer, 1, 100);
+  // Deletes the arena.
+  arena->Free(buffer, 100);
+}
+
+}  // namespace table_store
+}  // namespace px
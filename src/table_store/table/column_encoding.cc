@@ -0,0 +1,308 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/column_encoding.h"
+
+#include <arrow/builder.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/type_utils.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+uint64_t ZigZagEncode(int64_t val) {
+  return (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t val) {
+  return static_cast<int64_t>((val >> 1) ^ (~(val & 1) + 1));
+}
+
+// Dictionaries with more distinct values than this don't compress well enough to be worth it.
+constexpr int64_t kMaxDictionarySize = 1 << 16;
+
+}  // namespace
+
+BitPackedArray::BitPackedArray(const std::vector<uint64_t>& values, int bit_width)
+    : bit_width_(bit_width) {
+  DCHECK_LE(bit_width, 64);
+  if (bit_width_ == 0) {
+    return;
+  }
+  words_.resize((values.size() * bit_width_ + 63) / 64);
+  for (const auto& [i, val] : Enumerate(values)) {
+    uint64_t bit = i * bit_width_;
+    uint64_t word = bit / 64;
+    uint64_t shift = bit % 64;
+    words_[word] |= val << shift;
+    if (shift + bit_width_ > 64) {
+      words_[word + 1] |= val >> (64 - shift);
+    }
+  }
+}
+
+int BitPackedArray::BitWidth(uint64_t max_value) {
+  return max_value == 0 ? 0 : 64 - __builtin_clzll(max_value);
+}
+
+StatusOr<std::unique_ptr<EncodedColumn>> EncodedColumn::Encode(types::DataType data_type,
+                                                               const arrow::Array& arr) {
+  int64_t n = arr.length();
+  if (n < 2 || arr.null_count() > 0) {
+    return std::unique_ptr<EncodedColumn>();
+  }
+  std::unique_ptr<EncodedColumn> col;
+  switch (data_type) {
+    case types::INT64: {
+      const auto* values = static_cast<const arrow::Int64Array*>(&arr)->raw_values();
+      auto [min_it, max_it] = std::minmax_element(values, values + n);
+      uint64_t base = static_cast<uint64_t>(*min_it);
+      std::vector<uint64_t> offsets(n);
+      for (int64_t i = 0; i < n; ++i) {
+        offsets[i] = static_cast<uint64_t>(values[i]) - base;
+      }
+      col.reset(new EncodedColumn(ColumnEncoding::kBitPacked, data_type, n));
+      col->base_ = base;
+      col->values_ = BitPackedArray(
+          offsets, BitPackedArray::BitWidth(static_cast<uint64_t>(*max_it) - base));
+      break;
+    }
+    case types::TIME64NS: {
+      const auto* values =
+          static_cast<const types::DataTypeTraits<types::TIME64NS>::arrow_array_type*>(&arr)
+              ->raw_values();
+      // Deltas are computed with unsigned (wrapping) arithmetic so that they can't overflow.
+      std::vector<uint64_t> dods(n - 2);
+      uint64_t max_dod = 0;
+      for (int64_t i = 2; i < n; ++i) {
+        uint64_t delta = static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1]);
+        uint64_t prev_delta =
+            static_cast<uint64_t>(values[i - 1]) - static_cast<uint64_t>(values[i - 2]);
+        dods[i - 2] = ZigZagEncode(static_cast<int64_t>(delta - prev_delta));
+        max_dod = std::max(max_dod, dods[i - 2]);
+      }
+      col.reset(new EncodedColumn(ColumnEncoding::kDeltaOfDelta, data_type, n));
+      col->base_ = static_cast<uint64_t>(values[0]);
+      col->first_delta_ = static_cast<uint64_t>(values[1]) - static_cast<uint64_t>(values[0]);
+      col->values_ = BitPackedArray(dods, BitPackedArray::BitWidth(max_dod));
+      col->checkpoints_.reserve((n + kCheckpointInterval - 1) / kCheckpointInterval);
+      col->checkpoints_.push_back({col->base_, col->first_delta_});
+      for (int64_t i = kCheckpointInterval; i < n; i += kCheckpointInterval) {
+        col->checkpoints_.push_back(
+            {static_cast<uint64_t>(values[i]),
+             static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1])});
+      }
+      break;
+    }
+    case types::STRING: {
+      const auto* str_arr = static_cast<const arrow::StringArray*>(&arr);
+      absl::flat_hash_map<std::string_view, uint64_t> dictionary;
+      std::vector<uint64_t> codes(n);
+      for (int64_t i = 0; i < n; ++i) {
+        int32_t length;
+        const uint8_t* value = str_arr->GetValue(i, &length);
+        std::string_view view(reinterpret_cast<const char*>(value), length);
+        auto [it, inserted] = dictionary.try_emplace(view, dictionary.size());
+        codes[i] = it->second;
+        // Too many distinct values, dictionary encoding won't pay off.
+        if (inserted && (static_cast<int64_t>(dictionary.size()) > kMaxDictionarySize ||
+                         static_cast<int64_t>(dictionary.size()) > n / 2)) {
+          return std::unique_ptr<EncodedColumn>();
+        }
+      }
+      col.reset(new EncodedColumn(ColumnEncoding::kDictionary, data_type, n));
+      col->dictionary_.resize(dictionary.size());
+      for (const auto& [view, code] : dictionary) {
+        col->dictionary_[code] = std::string(view);
+      }
+      col->values_ = BitPackedArray(codes, BitPackedArray::BitWidth(dictionary.size() - 1));
+      break;
+    }
+    default:
+      return std::unique_ptr<EncodedColumn>();
+  }
+
+#define TYPE_CASE(_dt_) col->decoded_bytes_ = types::GetArrowArrayBytes<_dt_>(&arr);
+  PL_SWITCH_FOREACH_DATATYPE(data_type, TYPE_CASE);
+#undef TYPE_CASE
+  if (col->NumBytes() >= col->decoded_bytes_) {
+    return std::unique_ptr<EncodedColumn>();
+  }
+  return col;
+}
+
+int64_t EncodedColumn::NumBytes() const {
+  int64_t bytes = values_.NumBytes();
+  for (const auto& value : dictionary_) {
+    bytes += value.size();
+  }
+  bytes += checkpoints_.size() * sizeof(Checkpoint);
+  return bytes;
+}
+
+template <typename TFn>
+void EncodedColumn::ForEachDeltaOfDelta(int64_t first_row, TFn fn) const {
+  DCHECK_LT(first_row, length_);
+  int64_t row = first_row - first_row % kCheckpointInterval;
+  const auto& checkpoint = checkpoints_[row / kCheckpointInterval];
+  uint64_t val = checkpoint.val;
+  uint64_t delta = checkpoint.delta;
+  while (true) {
+    if (row >= first_row && !fn(row, static_cast<int64_t>(val))) {
+      return;
+    }
+    if (++row >= length_) {
+      return;
+    }
+    if (row >= 2) {
+      delta += static_cast<uint64_t>(ZigZagDecode(values_.Get(row - 2)));
+    }
+    val += delta;
+  }
+}
+
+std::vector<int64_t> EncodedColumn::DecodeDeltaOfDelta(int64_t first_row,
+                                                      int64_t last_row) const {
+  DCHECK_LT(last_row, length_);
+  std::vector<int64_t> values;
+  values.reserve(last_row - first_row + 1);
+  ForEachDeltaOfDelta(first_row, [&](int64_t row, int64_t val) {
+    values.push_back(val);
+    return row < last_row;
+  });
+  return values;
+}
+
+template <typename TRowFn>
+std::shared_ptr<arrow::Array> EncodedColumn::Build(int64_t num_rows, int64_t first_row,
+                                                   int64_t last_row, TRowFn row_at,
+                                                   arrow::MemoryPool* mem_pool) const {
+  auto builder = types::MakeArrowBuilder(data_type_, mem_pool);
+  PL_CHECK_OK(builder->Reserve(num_rows));
+  switch (encoding_) {
+    case ColumnEncoding::kBitPacked: {
+      auto* int_builder = static_cast<arrow::Int64Builder*>(builder.get());
+      for (int64_t i = 0; i < num_rows; ++i) {
+        int_builder->UnsafeAppend(IntValue(row_at(i)));
+      }
+      break;
+    }
+    case ColumnEncoding::kDeltaOfDelta: {
+      auto* time_builder =
+          static_cast<types::DataTypeTraits<types::TIME64NS>::arrow_builder_type*>(builder.get());
+      auto values =
+          num_rows == 0 ? std::vector<int64_t>() : DecodeDeltaOfDelta(first_row, last_row);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        time_builder->UnsafeAppend(values[row_at(i) - first_row]);
+      }
+      break;
+    }
+    case ColumnEncoding::kDictionary: {
+      auto* str_builder = static_cast<arrow::StringBuilder*>(builder.get());
+      int64_t total_size = 0;
+      for (int64_t i = 0; i < num_rows; ++i) {
+        total_size += dictionary_[values_.Get(row_at(i))].size();
+      }
+      PL_CHECK_OK(str_builder->ReserveData(total_size));
+      for (int64_t i = 0; i < num_rows; ++i) {
+        str_builder->UnsafeAppend(dictionary_[values_.Get(row_at(i))]);
+      }
+      break;
+    }
+  }
+  std::shared_ptr<arrow::Array> arr;
+  PL_CHECK_OK(builder->Finish(&arr));
+  return arr;
+}
+
+std::shared_ptr<arrow::Array> EncodedColumn::Decode(int64_t offset, int64_t length,
+                                                    arrow::MemoryPool* mem_pool) const {
+  DCHECK_LE(offset + length, length_);
+  return Build(
+      length, offset, offset + length - 1, [offset](int64_t i) { return offset + i; }, mem_pool);
+}
+
+std::shared_ptr<arrow::Array> EncodedColumn::DecodeRows(const std::vector<int64_t>& rows,
+                                                        arrow::MemoryPool* mem_pool) const {
+  int64_t first_row = 0;
+  int64_t last_row = 0;
+  if (!rows.empty()) {
+    auto [min_it, max_it] = std::minmax_element(rows.begin(), rows.end());
+    first_row = *min_it;
+    last_row = *max_it;
+  }
+  DCHECK_LT(last_row, length_);
+  return Build(
+      rows.size(), first_row, last_row, [&rows](int64_t i) { return rows[i]; }, mem_pool);
+}
+
+int64_t EncodedColumn::SearchGreaterThanOrEqual(int64_t val) const {
+  DCHECK(encoding_ == ColumnEncoding::kDeltaOfDelta);
+  // The first row >= val is after the last checkpoint < val, and at or before the next one.
+  auto it = std::lower_bound(
+      checkpoints_.begin(), checkpoints_.end(), val,
+      [](const Checkpoint& c, int64_t v) { return static_cast<int64_t>(c.val) < v; });
+  if (it == checkpoints_.begin()) {
+    return 0;
+  }
+  int64_t row = -1;
+  ForEachDeltaOfDelta((it - checkpoints_.begin() - 1) * kCheckpointInterval,
+                      [&](int64_t r, int64_t v) {
+                        if (v >= val) {
+                          row = r;
+                          return false;
+                        }
+                        return true;
+                      });
+  return row;
+}
+
+int64_t EncodedColumn::SearchLessThanOrEqual(int64_t val) const {
+  DCHECK(encoding_ == ColumnEncoding::kDeltaOfDelta);
+  // The last row <= val is at or after the last checkpoint <= val, and before the next one.
+  auto it = std::upper_bound(
+      checkpoints_.begin(), checkpoints_.end(), val,
+      [](int64_t v, const Checkpoint& c) { return v < static_cast<int64_t>(c.val); });
+  if (it == checkpoints_.begin()) {
+    return -1;
+  }
+  int64_t row = -1;
+  ForEachDeltaOfDelta((it - checkpoints_.begin() - 1) * kCheckpointInterval,
+                      [&](int64_t r, int64_t v) {
+                        if (v > val) {
+                          return false;
+                        }
+                        row = r;
+                        return true;
+                      });
+  return row;
+}
+
+}  // namespace table_store
+}  // namespace px
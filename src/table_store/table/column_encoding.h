@@ -0,0 +1,171 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+#include <arrow/memory_pool.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/types.h"
+
+namespace px {
+namespace table_store {
+
+enum class ColumnEncoding {
+  // Low cardinality STRING columns: the distinct values plus a bit-packed code per row.
+  kDictionary,
+  // TIME64NS columns: the bit-packed, zigzag encoded differences between consecutive deltas.
+  kDeltaOfDelta,
+  // INT64 columns: the bit-packed offset of each value from the minimum.
+  kBitPacked,
+};
+
+/**
+ * A fixed bit width packing of unsigned integers.
+ */
+class BitPackedArray {
+ public:
+  BitPackedArray() = default;
+  BitPackedArray(const std::vector<uint64_t>& values, int bit_width);
+
+  uint64_t Get(int64_t i) const {
+    if (bit_width_ == 0) {
+      return 0;
+    }
+    uint64_t bit = static_cast<uint64_t>(i) * bit_width_;
+    uint64_t word = bit / 64;
+    uint64_t shift = bit % 64;
+    uint64_t val = words_[word] >> shift;
+    if (shift + bit_width_ > 64) {
+      val |= words_[word + 1] << (64 - shift);
+    }
+    return bit_width_ == 64 ? val : val & ((uint64_t{1} << bit_width_) - 1);
+  }
+
+  int bit_width() const { return bit_width_; }
+  int64_t NumBytes() const { return words_.size() * sizeof(uint64_t); }
+
+  // Returns the number of bits needed to represent max_value.
+  static int BitWidth(uint64_t max_value);
+
+ private:
+  int bit_width_ = 0;
+  std::vector<uint64_t> words_;
+};
+
+/**
+ * EncodedColumn is an immutable, compressed copy of a cold column. It is decoded back into an
+ * arrow array when it's read.
+ */
+class EncodedColumn {
+ public:
+  /**
+   * Encodes the array with the encoding for its type, if that makes the column smaller than the
+   * plain arrow array.
+   * @return the encoded column, or nullptr if the column should be stored as is.
+   */
+  static StatusOr<std::unique_ptr<EncodedColumn>> Encode(types::DataType data_type,
+                                                         const arrow::Array& arr);
+
+  ColumnEncoding encoding() const { return encoding_; }
+  types::DataType data_type() const { return data_type_; }
+  int64_t length() const { return length_; }
+
+  /**
+   * @return the number of bytes of the encoded column.
+   */
+  int64_t NumBytes() const;
+
+  /**
+   * @return the number of bytes of the column once decoded, as counted by GetArrowArrayBytes.
+   */
+  int64_t DecodedBytes() const { return decoded_bytes_; }
+
+  /**
+   * Decodes the rows in [offset, offset + length) into an arrow array.
+   */
+  std::shared_ptr<arrow::Array> Decode(int64_t offset, int64_t length,
+                                       arrow::MemoryPool* mem_pool) const;
+  std::shared_ptr<arrow::Array> Decode(arrow::MemoryPool* mem_pool) const {
+    return Decode(0, length_, mem_pool);
+  }
+
+  /**
+   * Decodes only the given rows, in the given order, into an arrow array.
+   */
+  std::shared_ptr<arrow::Array> DecodeRows(const std::vector<int64_t>& rows,
+                                           arrow::MemoryPool* mem_pool) const;
+
+  /**
+   * Searches the sorted values of a kDeltaOfDelta column, with the same results as
+   * SearchArrowArrayGreaterThanOrEqual and SearchArrowArrayLessThanOrEqual on the decoded column.
+   * Only the rows after the closest checkpoint are decoded.
+   */
+  int64_t SearchGreaterThanOrEqual(int64_t val) const;
+  int64_t SearchLessThanOrEqual(int64_t val) const;
+
+ private:
+  // The number of rows between the checkpoints of a kDeltaOfDelta column.
+  static constexpr int64_t kCheckpointInterval = 128;
+
+  struct Checkpoint {
+    uint64_t val;
+    uint64_t delta;
+  };
+
+  EncodedColumn(ColumnEncoding encoding, types::DataType data_type, int64_t length)
+      : encoding_(encoding), data_type_(data_type), length_(length) {}
+
+  template <typename TRowFn>
+  std::shared_ptr<arrow::Array> Build(int64_t num_rows, int64_t first_row, int64_t last_row,
+                                      TRowFn row_at, arrow::MemoryPool* mem_pool) const;
+
+  // Calls fn(row, value) on the rows of a kDeltaOfDelta column from first_row on, until fn returns
+  // false or the column ends. Decoding starts at the checkpoint before first_row.
+  template <typename TFn>
+  void ForEachDeltaOfDelta(int64_t first_row, TFn fn) const;
+
+  // Returns the value of every row in [first_row, last_row]. Only used for kDeltaOfDelta, which
+  // can't be decoded at random.
+  std::vector<int64_t> DecodeDeltaOfDelta(int64_t first_row, int64_t last_row) const;
+  int64_t IntValue(int64_t i) const { return static_cast<int64_t>(base_ + values_.Get(i)); }
+
+  ColumnEncoding encoding_;
+  types::DataType data_type_;
+  int64_t length_;
+  int64_t decoded_bytes_ = 0;
+
+  // kBitPacked: values are base_ + values_[i].
+  // kDeltaOfDelta: the first value is base_, the first delta is first_delta_, and values_ holds
+  // the zigzag encoded delta of deltas from the third row on.
+  // kDictionary: values_ holds indexes into dictionary_.
+  uint64_t base_ = 0;
+  uint64_t first_delta_ = 0;
+  BitPackedArray values_;
+  std::vector<std::string> dictionary_;
+  // kDeltaOfDelta: the value and delta of every kCheckpointInterval-th row.
+  std::vector<Checkpoint> checkpoints_;
+};
+
+}  // namespace table_store
+}  // namespace px
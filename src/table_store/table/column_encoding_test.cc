@@ -0,0 +1,168 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table/column_encoding.h"
+
+namespace px {
+namespace table_store {
+
+TEST(BitPackedArrayTest, round_trip) {
+  std::vector<uint64_t> values = {0, 5, 7, 1, 3, 6, 2, 4, 7, 0};
+  BitPackedArray packed(values, BitPackedArray::BitWidth(7));
+  EXPECT_EQ(3, packed.bit_width());
+  for (const auto& [i, val] : Enumerate(values)) {
+    EXPECT_EQ(val, packed.Get(i));
+  }
+  EXPECT_EQ(sizeof(uint64_t), packed.NumBytes());
+
+  // Values that straddle word boundaries.
+  std::vector<uint64_t> wide_values = {(1ULL << 40) - 1, 12345, 1ULL << 39, 0, 99};
+  BitPackedArray wide_packed(wide_values, 40);
+  for (const auto& [i, val] : Enumerate(wide_values)) {
+    EXPECT_EQ(val, wide_packed.Get(i));
+  }
+
+  EXPECT_EQ(0, BitPackedArray::BitWidth(0));
+  EXPECT_EQ(64, BitPackedArray::BitWidth(~0ULL));
+}
+
+TEST(EncodedColumnTest, bit_packed_ints) {
+  std::vector<types::Int64Value> values;
+  for (int64_t i = 0; i < 100; ++i) {
+    values.push_back(-50 + (i * 7) % 31);
+  }
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+  ASSERT_OK_AND_ASSIGN(auto col, EncodedColumn::Encode(types::INT64, *arr));
+  ASSERT_NE(nullptr, col);
+  EXPECT_EQ(ColumnEncoding::kBitPacked, col->encoding());
+  EXPECT_EQ(100, col->length());
+  EXPECT_LT(col->NumBytes(), col->DecodedBytes());
+
+  EXPECT_TRUE(col->Decode(arrow::default_memory_pool())->Equals(*arr));
+  EXPECT_TRUE(col->Decode(10, 20, arrow::default_memory_pool())->Equals(*arr->Slice(10, 20)));
+}
+
+TEST(EncodedColumnTest, delta_of_delta_times) {
+  std::vector<types::Time64NSValue> values;
+  int64_t time = 1'600'000'000'000'000'000;
+  for (int64_t i = 0; i < 100; ++i) {
+    // Mostly regular intervals, with some jitter.
+    time += 1'000'000 + (i % 3 == 0 ? 17 : -3);
+    values.push_back(time);
+  }
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+  ASSERT_OK_AND_ASSIGN(auto col, EncodedColumn::Encode(types::TIME64NS, *arr));
+  ASSERT_NE(nullptr, col);
+  EXPECT_EQ(ColumnEncoding::kDeltaOfDelta, col->encoding());
+  EXPECT_LT(col->NumBytes(), col->DecodedBytes());
+
+  EXPECT_TRUE(col->Decode(arrow::default_memory_pool())->Equals(*arr));
+  EXPECT_TRUE(col->Decode(50, 50, arrow::default_memory_pool())->Equals(*arr->Slice(50, 50)));
+
+  std::vector<types::Time64NSValue> expected = {values[42], values[3], values[99]};
+  EXPECT_TRUE(col->DecodeRows({42, 3, 99}, arrow::default_memory_pool())
+                  ->Equals(*types::ToArrow(expected, arrow::default_memory_pool())));
+}
+
+TEST(EncodedColumnTest, delta_of_delta_search) {
+  std::vector<types::Time64NSValue> values;
+  int64_t time = 1'000'000;
+  for (int64_t i = 0; i < 1000; ++i) {
+    // Runs of duplicate times, some of which straddle checkpoints.
+    time += i % 5 == 0 ? 0 : 10 + i % 7;
+    values.push_back(time);
+  }
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+  ASSERT_OK_AND_ASSIGN(auto col, EncodedColumn::Encode(types::TIME64NS, *arr));
+  ASSERT_NE(nullptr, col);
+  ASSERT_EQ(ColumnEncoding::kDeltaOfDelta, col->encoding());
+
+  for (int64_t val = values.front().val - 5; val <= values.back().val + 5; ++val) {
+    EXPECT_EQ(types::SearchArrowArrayGreaterThanOrEqual<types::TIME64NS>(arr.get(), val),
+              col->SearchGreaterThanOrEqual(val))
+        << val;
+    EXPECT_EQ(types::SearchArrowArrayLessThanOrEqual<types::TIME64NS>(arr.get(), val),
+              col->SearchLessThanOrEqual(val))
+        << val;
+  }
+
+  // Decoding a range only decodes from the checkpoint before it.
+  EXPECT_TRUE(col->Decode(300, 500, arrow::default_memory_pool())->Equals(*arr->Slice(300, 500)));
+  std::vector<types::Time64NSValue> expected = {values[700], values[129]};
+  EXPECT_TRUE(col->DecodeRows({700, 129}, arrow::default_memory_pool())
+                  ->Equals(*types::ToArrow(expected, arrow::default_memory_pool())));
+}
+
+TEST(EncodedColumnTest, dictionary_strings) {
+  std::vector<types::StringValue> values;
+  std::vector<std::string> methods = {"GET", "POST", "PUT", "DELETE"};
+  for (int64_t i = 0; i < 100; ++i) {
+    values.push_back(methods[(i * 3) % methods.size()]);
+  }
+  auto arr = types::ToArrow(values, arrow::default_memory_pool());
+  ASSERT_OK_AND_ASSIGN(auto col, EncodedColumn::Encode(types::STRING, *arr));
+  ASSERT_NE(nullptr, col);
+  EXPECT_EQ(ColumnEncoding::kDictionary, col->encoding());
+  EXPECT_LT(col->NumBytes(), col->DecodedBytes());
+
+  EXPECT_TRUE(col->Decode(arrow::default_memory_pool())->Equals(*arr));
+  std::vector<types::StringValue> expected = {values[1], values[1], values[7]};
+  EXPECT_TRUE(col->DecodeRows({1, 1, 7}, arrow::default_memory_pool())
+                  ->Equals(*types::ToArrow(expected, arrow::default_memory_pool())));
+}
+
+TEST(EncodedColumnTest, not_worth_encoding) {
+  // High cardinality strings.
+  std::vector<types::StringValue> strs;
+  for (int64_t i = 0; i < 100; ++i) {
+    strs.push_back(absl::StrCat("value", i));
+  }
+  ASSERT_OK_AND_ASSIGN(
+      auto str_col,
+      EncodedColumn::Encode(types::STRING, *types::ToArrow(strs, arrow::default_memory_pool())));
+  EXPECT_EQ(nullptr, str_col);
+
+  // Ints that need the full 64 bits.
+  std::vector<types::Int64Value> ints = {std::numeric_limits<int64_t>::min(),
+                                         std::numeric_limits<int64_t>::max(), 0};
+  ASSERT_OK_AND_ASSIGN(
+      auto int_col,
+      EncodedColumn::Encode(types::INT64, *types::ToArrow(ints, arrow::default_memory_pool())));
+  EXPECT_EQ(nullptr, int_col);
+
+  // Unsupported types.
+  std::vector<types::Float64Value> floats = {1.0, 2.0, 3.0};
+  ASSERT_OK_AND_ASSIGN(
+      auto float_col,
+      EncodedColumn::Encode(types::FLOAT64, *types::ToArrow(floats, arrow::default_memory_pool())));
+  EXPECT_EQ(nullptr, float_col);
+}
+
+}  // namespace table_store
+}  // namespace px
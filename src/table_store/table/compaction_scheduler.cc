@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/compaction_scheduler.h"
+
+#include <algorithm>
+#include <vector>
+
+DEFINE_int32(table_store_compaction_threads,
+             gflags::Int32FromEnv("PL_TABLE_STORE_COMPACTION_THREADS", 2),
+             "The number of threads, including the caller, that compact tables in parallel.");
+
+namespace px {
+namespace table_store {
+
+CompactionScheduler::CompactionScheduler(int num_workers)
+    : num_workers_(std::max(1, num_workers)) {}
+
+Status CompactionScheduler::Run(const std::vector<Table*>& tables, arrow::MemoryPool* mem_pool) {
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = Status::OK();
+    mem_pool_ = mem_pool;
+    for (auto* table : tables) {
+      queue_.push(Job{table->HotBudgetRatio(), 0, table});
+    }
+  }
+  int num_workers = std::min<int64_t>(num_workers_, tables.size());
+  ThreadPool::Shared()->ParallelFor(num_workers, num_workers, [this](int64_t, int) { RunJobs(); });
+  std::lock_guard<std::mutex> lock(mutex_);
+  mem_pool_ = nullptr;
+  return status_;
+}
+
+int64_t CompactionScheduler::QueueDepth() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size() + in_flight_;
+}
+
+void CompactionScheduler::RunJobs() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    // A table in flight may still be put back in the queue.
+    work_cv_.wait(lock, [this] { return !queue_.empty() || in_flight_ == 0; });
+    if (queue_.empty()) {
+      return;
+    }
+    auto job = queue_.top();
+    queue_.pop();
+    ++in_flight_;
+    auto* mem_pool = mem_pool_;
+    lock.unlock();
+    Status s = job.table->CompactHotToCold(mem_pool);
+    double priority = job.table->HotBudgetRatio();
+    lock.lock();
+    --in_flight_;
+    if (!s.ok()) {
+      if (status_.ok()) {
+        status_ = s;
+      }
+    } else if (priority > 1 && ++job.rounds < kMaxCompactionRounds) {
+      // Still over budget, so the table goes back in the queue with its new priority.
+      queue_.push(Job{priority, job.rounds, job.table});
+      work_cv_.notify_one();
+    }
+    if (in_flight_ == 0 && queue_.empty()) {
+      work_cv_.notify_all();
+    }
+  }
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+#include "src/common/base/base.h"
+#include "src/common/base/thread_pool.h"
+#include "src/table_store/table/table.h"
+
+DECLARE_int32(table_store_compaction_threads);
+
+namespace px {
+namespace table_store {
+
+/**
+ * CompactionScheduler compacts the hot storage of a set of tables on up to num_workers threads
+ * of the process-wide ThreadPool::Shared(). Tables are compacted in order of their
+ * HotBudgetRatio, so the tables that are furthest behind go first. A table that is still over
+ * budget after a CompactHotToCold call is put back in the queue, up to kMaxCompactionRounds times
+ * per Run, so that bursty tables catch up within one compaction period instead of growing until
+ * they're expired.
+ *
+ * The calling thread participates as a worker, so a scheduler with num_workers == 1 compacts the
+ * tables inline.
+ */
+class CompactionScheduler : public NotCopyable {
+ public:
+  static constexpr int kMaxCompactionRounds = 8;
+
+  /**
+   * @param num_workers The total number of workers, including the calling thread.
+   */
+  explicit CompactionScheduler(int num_workers);
+
+  int num_workers() const { return num_workers_; }
+
+  /**
+   * Compacts the given tables and blocks until they are all done. The tables must outlive the
+   * call.
+   * @return the first error returned by CompactHotToCold, or OK.
+   */
+  Status Run(const std::vector<Table*>& tables, arrow::MemoryPool* mem_pool);
+
+  /**
+   * @return the number of tables waiting to be compacted by the current Run.
+   */
+  int64_t QueueDepth() const;
+
+ private:
+  struct Job {
+    double priority;
+    int rounds;
+    Table* table;
+
+    bool operator<(const Job& other) const { return priority < other.priority; }
+  };
+
+  // Compacts tables until the queue is empty and no other worker may put a table back.
+  void RunJobs();
+
+  const int num_workers_;
+
+  // Serializes calls to Run.
+  std::mutex run_mutex_;
+
+  mutable std::mutex mutex_;
+  // Signaled when a table is put in the queue, or the last table in flight is done.
+  std::condition_variable work_cv_;
+  std::priority_queue<Job> queue_;
+  int64_t in_flight_ = 0;
+  Status status_;
+  arrow::MemoryPool* mem_pool_ = nullptr;
+};
+
+}  // namespace table_store
+}  // namespace px
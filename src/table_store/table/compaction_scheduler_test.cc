@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/compaction_scheduler.h"
+
+namespace px {
+namespace table_store {
+
+class CompactionSchedulerTest : public ::testing::TestWithParam<int> {
+ protected:
+  // Makes a table with num_batches single row hot batches. With 8 byte cold batches a single
+  // CompactHotToCold call compacts kMaxBatchesPerCompactionCall of them.
+  static std::shared_ptr<Table> MakeHotTable(int64_t num_batches) {
+    schema::RowDescriptor rd({types::DataType::INT64});
+    schema::Relation rel(rd.types(), {"col1"});
+    auto table = std::make_shared<Table>(rel, 128 * 1024, sizeof(int64_t));
+    for (int64_t i = 0; i < num_batches; ++i) {
+      schema::RowBatch rb(rd, 1);
+      std::vector<types::Int64Value> col1 = {i};
+      PL_CHECK_OK(rb.AddColumn(types::ToArrow(col1, arrow::default_memory_pool())));
+      PL_CHECK_OK(table->WriteRowBatch(rb));
+    }
+    return table;
+  }
+};
+
+TEST_P(CompactionSchedulerTest, compacts_over_budget_tables_again) {
+  CompactionScheduler scheduler(GetParam());
+  EXPECT_EQ(GetParam(), scheduler.num_workers());
+
+  // 600 batches is more than two compaction calls' worth, 10 batches is well within budget.
+  auto behind_table = MakeHotTable(600);
+  auto other_behind_table = MakeHotTable(600);
+  auto small_table = MakeHotTable(10);
+  EXPECT_GT(behind_table->HotBudgetRatio(), 2);
+  EXPECT_LT(small_table->HotBudgetRatio(), 1);
+
+  EXPECT_OK(scheduler.Run({behind_table.get(), other_behind_table.get(), small_table.get()},
+                          arrow::default_memory_pool()));
+  EXPECT_EQ(0, scheduler.QueueDepth());
+
+  // The first two tables were still over budget after one call, so they were compacted a second
+  // time, which brought them under budget.
+  for (const auto& table : {behind_table, other_behind_table}) {
+    auto stats = table->GetTableStats();
+    EXPECT_EQ(2 * Table::kMaxBatchesPerCompactionCall, stats.compacted_batches);
+    EXPECT_EQ(600 - 2 * Table::kMaxBatchesPerCompactionCall, stats.num_hot_batches);
+    EXPECT_LT(table->HotBudgetRatio(), 1);
+    EXPECT_GT(stats.compaction_latency_ns, 0);
+  }
+  auto small_stats = small_table->GetTableStats();
+  EXPECT_EQ(10, small_stats.compacted_batches);
+  EXPECT_EQ(0, small_stats.num_hot_batches);
+  EXPECT_EQ(0, small_stats.hot_bytes);
+
+  // Nothing left to compact.
+  EXPECT_OK(scheduler.Run({small_table.get()}, arrow::default_memory_pool()));
+  EXPECT_EQ(10, small_table->GetTableStats().compacted_batches);
+}
+
+INSTANTIATE_TEST_SUITE_P(NumWorkers, CompactionSchedulerTest, ::testing::Values(1, 3));
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/memory_budget.h"
+
+#include <vector>
+
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_split.h>
+#include <absl/time/time.h>
+
+#include "src/table_store/table/table.h"
+
+DEFINE_int64(table_store_memory_budget_bytes,
+             gflags::Int64FromEnv("PL_TABLE_STORE_MEMORY_BUDGET_BYTES", 0),
+             "The number of bytes all the tables of the table store hold together. Over it, the "
+             "tables furthest over their share, see --table_store_table_budgets, expire their "
+             "oldest rows. Each table also keeps to its own size limit. 0 disables the budget.");
+DEFINE_string(table_store_table_budgets,
+              gflags::StringFromEnv("PL_TABLE_STORE_TABLE_BUDGETS", ""),
+              "How the tables share --table_store_memory_budget_bytes, as a comma separated list "
+              "of <table>=<weight>[:<min retention>], e.g. \"process_stats=4:1h,http_events=0.5\". "
+              "Tables that aren't listed have a weight of 1 and no minimum retention.");
+
+namespace px {
+namespace table_store {
+
+StatusOr<absl::flat_hash_map<std::string, TableBudget>> MemoryBudget::ParseTableBudgets(
+    std::string_view spec) {
+  absl::flat_hash_map<std::string, TableBudget> budgets;
+  for (std::string_view entry : absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    std::vector<std::string_view> name_and_budget = absl::StrSplit(entry, '=');
+    if (name_and_budget.size() != 2 || name_and_budget[0].empty()) {
+      return error::InvalidArgument("Table budget '$0' isn't of the form <table>=<weight>", entry);
+    }
+    std::vector<std::string_view> parts = absl::StrSplit(name_and_budget[1], ':');
+    TableBudget budget;
+    if (parts.size() > 2 || !absl::SimpleAtod(parts[0], &budget.weight) || budget.weight <= 0) {
+      return error::InvalidArgument("Table budget '$0' needs a positive weight", entry);
+    }
+    if (parts.size() == 2) {
+      absl::Duration retention;
+      if (!absl::ParseDuration(parts[1], &retention)) {
+        return error::InvalidArgument("Table budget '$0' has an invalid minimum retention", entry);
+      }
+      budget.min_retention_ns = absl::ToInt64Nanoseconds(retention);
+    }
+    budgets[name_and_budget[0]] = budget;
+  }
+  return budgets;
+}
+
+void MemoryBudget::AddTable(Table* table, TableBudget table_budget) {
+  absl::MutexLock lock(&lock_);
+  tables_[table] = table_budget;
+}
+
+void MemoryBudget::RemoveTable(Table* table) {
+  absl::MutexLock lock(&lock_);
+  tables_.erase(table);
+}
+
+Status MemoryBudget::MakeRoom(int64_t incoming_bytes) {
+  absl::MutexLock lock(&lock_);
+  while (true) {
+    int64_t total_bytes = incoming_bytes;
+    for (const auto& [table, table_budget] : tables_) {
+      total_bytes += table->Bytes();
+    }
+    if (total_bytes <= budget_bytes_) {
+      return Status::OK();
+    }
+
+    // The bytes of a table over its weight is proportional to how far over its share it is.
+    Table* victim = nullptr;
+    bool victim_within_retention = false;
+    double victim_share = 0;
+    for (const auto& [table, table_budget] : tables_) {
+      int64_t bytes = table->Bytes();
+      if (bytes == 0) {
+        continue;
+      }
+      bool within_retention = false;
+      if (table_budget.min_retention_ns > 0) {
+        int64_t retention_ns = table->RetentionNS();
+        within_retention = retention_ns != -1 && retention_ns <= table_budget.min_retention_ns;
+      }
+      double share = bytes / table_budget.weight;
+      if (victim == nullptr || (victim_within_retention && !within_retention) ||
+          (victim_within_retention == within_retention && share > victim_share)) {
+        victim = table;
+        victim_within_retention = within_retention;
+        victim_share = share;
+      }
+    }
+    if (victim == nullptr) {
+      return Status::OK();
+    }
+    int64_t victim_bytes = victim->Bytes();
+    PL_RETURN_IF_ERROR(victim->ExpireOldestBatch());
+    if (victim->Bytes() >= victim_bytes) {
+      return Status::OK();
+    }
+  }
+}
+
+}  // namespace table_store
+}  // namespace px
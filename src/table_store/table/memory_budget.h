@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+DECLARE_int64(table_store_memory_budget_bytes);
+DECLARE_string(table_store_table_budgets);
+
+namespace px {
+namespace table_store {
+
+class Table;
+
+// How a table shares a MemoryBudget with the other tables.
+struct TableBudget {
+  // The share of the budget the table gets, relative to the weights of the other tables.
+  double weight = 1.0;
+  // The table only gives up rows for the budget once its rows reach back further than this.
+  int64_t min_retention_ns = 0;
+};
+
+/**
+ * MemoryBudget is a memory budget that the tables of a TableStore share, on top of their own
+ * size limits. When a write would take the tables over the budget, the oldest batches of the
+ * table furthest over its weighted share of the budget are expired first, skipping tables whose
+ * rows don't reach back further than their minimum retention. If every table is within its
+ * minimum retention, the budget wins over the retention.
+ *
+ * Thread-safe.
+ */
+class MemoryBudget : public NotCopyable {
+ public:
+  explicit MemoryBudget(int64_t budget_bytes) : budget_bytes_(budget_bytes) {}
+
+  /**
+   * Parses the table budgets of --table_store_table_budgets, a comma separated list of
+   * <table>=<weight>[:<min retention>], e.g. "process_stats=4:1h,http_events=0.5".
+   */
+  static StatusOr<absl::flat_hash_map<std::string, TableBudget>> ParseTableBudgets(
+      std::string_view spec);
+
+  int64_t budget_bytes() const { return budget_bytes_; }
+
+  void AddTable(Table* table, TableBudget table_budget);
+  void RemoveTable(Table* table);
+
+  /**
+   * Expires batches of the tables until incoming_bytes more fit in the budget, or there is
+   * nothing left to expire.
+   */
+  Status MakeRoom(int64_t incoming_bytes);
+
+ private:
+  const int64_t budget_bytes_;
+
+  absl::Mutex lock_;
+  absl::flat_hash_map<Table*, TableBudget> tables_ ABSL_GUARDED_BY(lock_);
+};
+
+}  // namespace table_store
+}  // namespace px
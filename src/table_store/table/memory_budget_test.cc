@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "src/table_store/table/memory_budget.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "src/common/testing/testing.h"
+#include "src/table_store/table/table.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+schema::Relation TestRelation() {
+  return schema::Relation({types::DataType::TIME64NS, types::DataType::INT64}, {"time_", "count"});
+}
+
+// Writes a batch of one row, of 16 bytes.
+Status WriteRow(Table* table, int64_t time) {
+  auto rb = std::make_unique<types::ColumnWrapperRecordBatch>();
+  auto time_col = types::ColumnWrapper::Make(types::DataType::TIME64NS, 0);
+  time_col->Append<types::Time64NSValue>(time);
+  auto count_col = types::ColumnWrapper::Make(types::DataType::INT64, 0);
+  count_col->Append<types::Int64Value>(1);
+  rb->push_back(time_col);
+  rb->push_back(count_col);
+  return table->TransferRecordBatch(std::move(rb));
+}
+
+}  // namespace
+
+TEST(MemoryBudgetTest, parse_table_budgets) {
+  ASSERT_OK_AND_ASSIGN(auto budgets,
+                       MemoryBudget::ParseTableBudgets("process_stats=4:1h, http_events=0.5"));
+  ASSERT_EQ(budgets.size(), 2);
+  EXPECT_EQ(budgets["process_stats"].weight, 4);
+  EXPECT_EQ(budgets["process_stats"].min_retention_ns, 3600LL * 1000 * 1000 * 1000);
+  EXPECT_EQ(budgets["http_events"].weight, 0.5);
+  EXPECT_EQ(budgets["http_events"].min_retention_ns, 0);
+
+  ASSERT_OK_AND_ASSIGN(budgets, MemoryBudget::ParseTableBudgets(""));
+  EXPECT_TRUE(budgets.empty());
+
+  EXPECT_NOT_OK(MemoryBudget::ParseTableBudgets("process_stats"));
+  EXPECT_NOT_OK(MemoryBudget::ParseTableBudgets("process_stats=0"));
+  EXPECT_NOT_OK(MemoryBudget::ParseTableBudgets("process_stats=abc"));
+  EXPECT_NOT_OK(MemoryBudget::ParseTableBudgets("process_stats=1:forever"));
+  EXPECT_NOT_OK(MemoryBudget::ParseTableBudgets("=1"));
+}
+
+TEST(MemoryBudgetTest, expires_table_furthest_over_its_share) {
+  auto budget = std::make_shared<MemoryBudget>(/*budget_bytes*/ 8 * 16);
+  auto heavy = Table::Create(TestRelation());
+  auto light = Table::Create(TestRelation());
+  heavy->SetMemoryBudget(budget, TableBudget{/*weight*/ 3});
+  light->SetMemoryBudget(budget, TableBudget{/*weight*/ 1});
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_OK(WriteRow(heavy.get(), i));
+    ASSERT_OK(WriteRow(light.get(), i));
+  }
+  EXPECT_EQ(heavy->GetTableStats().num_batches, 4);
+  EXPECT_EQ(light->GetTableStats().num_batches, 4);
+
+  // The light table is further over its share, and gives up its rows to the heavy table.
+  ASSERT_OK(WriteRow(heavy.get(), 4));
+  ASSERT_OK(WriteRow(heavy.get(), 5));
+  EXPECT_EQ(heavy->GetTableStats().num_batches, 6);
+  EXPECT_EQ(light->GetTableStats().num_batches, 2);
+  EXPECT_EQ(light->GetTableStats().batches_expired, 2);
+  EXPECT_EQ(heavy->Bytes() + light->Bytes(), 8 * 16);
+}
+
+TEST(MemoryBudgetTest, min_retention) {
+  auto budget = std::make_shared<MemoryBudget>(/*budget_bytes*/ 8 * 16);
+  auto heavy = Table::Create(TestRelation());
+  auto retained = Table::Create(TestRelation());
+  heavy->SetMemoryBudget(budget, TableBudget{/*weight*/ 3});
+  retained->SetMemoryBudget(budget, TableBudget{/*weight*/ 1, /*min_retention_ns*/ 100});
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_OK(WriteRow(heavy.get(), i));
+    ASSERT_OK(WriteRow(retained.get(), i));
+  }
+
+  // The retained table's rows only reach back 3ns, so the heavy table expires its own rows.
+  ASSERT_OK(WriteRow(heavy.get(), 4));
+  EXPECT_EQ(heavy->GetTableStats().num_batches, 4);
+  EXPECT_EQ(retained->GetTableStats().num_batches, 4);
+
+  // Once the retained table's rows reach back further than its minimum retention, it's fair game.
+  heavy.reset();
+  auto other = Table::Create(TestRelation());
+  other->SetMemoryBudget(budget, TableBudget{/*weight*/ 3});
+  ASSERT_OK(WriteRow(retained.get(), 1000));
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_OK(WriteRow(other.get(), i));
+  }
+  EXPECT_EQ(other->GetTableStats().num_batches, 4);
+  EXPECT_EQ(retained->GetTableStats().num_batches, 4);
+  EXPECT_EQ(retained->GetTableStats().batches_expired, 1);
+}
+
+}  // namespace table_store
+}  // namespace px
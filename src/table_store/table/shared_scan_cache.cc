@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/shared_scan_cache.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+int64_t ArrayDataBytes(const arrow::ArrayData& data) {
+  int64_t bytes = 0;
+  for (const auto& buffer : data.buffers) {
+    if (buffer != nullptr) {
+      bytes += buffer->size();
+    }
+  }
+  for (const auto& child : data.child_data) {
+    bytes += ArrayDataBytes(*child);
+  }
+  return bytes;
+}
+
+}  // namespace
+
+std::shared_ptr<arrow::Array> SharedScanCache::Get(int64_t row_start_id, int64_t row_end_id,
+                                                   int64_t col_idx) {
+  absl::MutexLock lock(&mu_);
+  auto it = entries_.find(Key{row_start_id, row_end_id, col_idx});
+  if (it == entries_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->arr;
+}
+
+void SharedScanCache::Put(int64_t row_start_id, int64_t row_end_id, int64_t col_idx,
+                          std::shared_ptr<arrow::Array> arr) {
+  // Sliced arrays share their buffers with the whole array, which is what they keep alive.
+  int64_t bytes = ArrayDataBytes(*arr->data());
+  if (bytes > max_bytes_) {
+    return;
+  }
+  Key key{row_start_id, row_end_id, col_idx};
+  absl::MutexLock lock(&mu_);
+  if (entries_.contains(key)) {
+    return;
+  }
+  lru_.push_front(Entry{key, std::move(arr), bytes});
+  entries_[key] = lru_.begin();
+  bytes_ += bytes;
+  while (bytes_ > max_bytes_) {
+    const Entry& oldest = lru_.back();
+    bytes_ -= oldest.bytes;
+    entries_.erase(oldest.key);
+    lru_.pop_back();
+  }
+}
+
+int64_t SharedScanCache::bytes() const {
+  absl::MutexLock lock(&mu_);
+  return bytes_;
+}
+
+int64_t SharedScanCache::hits() const {
+  absl::MutexLock lock(&mu_);
+  return hits_;
+}
+
+int64_t SharedScanCache::misses() const {
+  absl::MutexLock lock(&mu_);
+  return misses_;
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+
+#include <list>
+#include <memory>
+#include <utility>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include "src/common/base/base.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * SharedScanCache keeps the arrow columns that scans of a table recently materialized, keyed by
+ * the unique row ids of the slice and the column, so that concurrent queries scanning the same
+ * rows convert each batch only once and share the resulting arrays. Rows never change once
+ * they're written, so entries don't need to be invalidated. Bounded by bytes, evicting the least
+ * recently used columns first. Thread safe.
+ */
+class SharedScanCache : public NotCopyable {
+ public:
+  explicit SharedScanCache(int64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  bool enabled() const { return max_bytes_ > 0; }
+
+  /**
+   * @return the cached column for the given rows, or nullptr if it isn't cached.
+   */
+  std::shared_ptr<arrow::Array> Get(int64_t row_start_id, int64_t row_end_id, int64_t col_idx);
+  void Put(int64_t row_start_id, int64_t row_end_id, int64_t col_idx,
+           std::shared_ptr<arrow::Array> arr);
+
+  int64_t bytes() const;
+  int64_t hits() const;
+  int64_t misses() const;
+
+ private:
+  struct Key {
+    int64_t row_start_id;
+    int64_t row_end_id;
+    int64_t col_idx;
+
+    bool operator==(const Key& other) const {
+      return row_start_id == other.row_start_id && row_end_id == other.row_end_id &&
+             col_idx == other.col_idx;
+    }
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.row_start_id, key.row_end_id, key.col_idx);
+    }
+  };
+  struct Entry {
+    Key key;
+    std::shared_ptr<arrow::Array> arr;
+    int64_t bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  const int64_t max_bytes_;
+  mutable absl::Mutex mu_;
+  // Most recently used first.
+  EntryList lru_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<Key, EntryList::iterator> entries_ ABSL_GUARDED_BY(mu_);
+  int64_t bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  int64_t hits_ ABSL_GUARDED_BY(mu_) = 0;
+  int64_t misses_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/shared_scan_cache.h"
+
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+std::shared_ptr<arrow::Array> Int64Array(int64_t num_rows) {
+  std::vector<types::Int64Value> values(num_rows, 1);
+  return types::ToArrow(values, arrow::default_memory_pool());
+}
+
+}  // namespace
+
+TEST(SharedScanCacheTest, get_put) {
+  SharedScanCache cache(1024);
+  EXPECT_EQ(nullptr, cache.Get(0, 9, 0));
+
+  auto arr = Int64Array(10);
+  cache.Put(0, 9, 0, arr);
+  EXPECT_EQ(arr.get(), cache.Get(0, 9, 0).get());
+  // Different rows and columns are different entries.
+  EXPECT_EQ(nullptr, cache.Get(0, 9, 1));
+  EXPECT_EQ(nullptr, cache.Get(0, 8, 0));
+
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(3, cache.misses());
+  EXPECT_LE(10 * sizeof(int64_t), cache.bytes());
+}
+
+TEST(SharedScanCacheTest, evicts_least_recently_used) {
+  SharedScanCache sizing(1024);
+  sizing.Put(0, 9, 0, Int64Array(10));
+  int64_t col_bytes = sizing.bytes();
+
+  // Room for two columns.
+  SharedScanCache cache(2 * col_bytes);
+  cache.Put(0, 9, 0, Int64Array(10));
+  cache.Put(10, 19, 0, Int64Array(10));
+  // Reading the first column makes the second the least recently used.
+  EXPECT_NE(nullptr, cache.Get(0, 9, 0));
+  cache.Put(20, 29, 0, Int64Array(10));
+
+  EXPECT_NE(nullptr, cache.Get(0, 9, 0));
+  EXPECT_EQ(nullptr, cache.Get(10, 19, 0));
+  EXPECT_NE(nullptr, cache.Get(20, 29, 0));
+  EXPECT_EQ(2 * col_bytes, cache.bytes());
+}
+
+TEST(SharedScanCacheTest, skips_columns_larger_than_the_cache) {
+  SharedScanCache cache(8);
+  cache.Put(0, 9, 0, Int64Array(10));
+  EXPECT_EQ(nullptr, cache.Get(0, 9, 0));
+  EXPECT_EQ(0, cache.bytes());
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/spill_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <absl/strings/str_format.h>
+#include "src/common/fs/fs_wrapper.h"
+#include "src/table_store/schemapb/schema.pb.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+// Returns a batch that shares the columns of rb, with all of them materialized, so that it can be
+// read concurrently.
+std::unique_ptr<schema::RowBatch> CopyBatch(const schema::RowBatch& rb) {
+  auto out = std::make_unique<schema::RowBatch>(rb.desc(), rb.num_rows());
+  for (int64_t i = 0; i < rb.num_columns(); ++i) {
+    PL_CHECK_OK(out->AddColumn(rb.ColumnAt(i)));
+  }
+  return out;
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<SpillStore>> SpillStore::Create(const std::filesystem::path& dir,
+                                                         const schema::Relation& rel,
+                                                         std::shared_ptr<SpillBudget> budget,
+                                                         int64_t segment_size) {
+  if (budget->max_bytes() <= 0) {
+    return error::InvalidArgument("Spill store size limit must be positive, got $0",
+                                  budget->max_bytes());
+  }
+  if (fs::Exists(dir).ok()) {
+    return error::AlreadyExists("Spill directory $0 already exists", dir.string());
+  }
+  PL_RETURN_IF_ERROR(fs::CreateDirectories(dir));
+  segment_size = std::max<int64_t>(1, std::min(segment_size, budget->max_bytes() / 4));
+  auto store = std::unique_ptr<SpillStore>(
+      new SpillStore(dir, rel, std::move(budget), segment_size));
+  PL_RETURN_IF_ERROR(store->OpenSegment());
+  return store;
+}
+
+StatusOr<std::unique_ptr<SpillStore>> SpillStore::Create(const std::filesystem::path& dir,
+                                                         const schema::Relation& rel,
+                                                         int64_t max_bytes, int64_t segment_size) {
+  return Create(dir, rel, std::make_shared<SpillBudget>(max_bytes), segment_size);
+}
+
+SpillStore::SpillStore(std::filesystem::path dir, schema::Relation rel,
+                       std::shared_ptr<SpillBudget> budget, int64_t segment_size)
+    : dir_(std::move(dir)),
+      rel_(std::move(rel)),
+      budget_(std::move(budget)),
+      segment_size_(segment_size) {
+  ++budget_->num_stores_;
+}
+
+SpillStore::~SpillStore() {
+  while (!segments_.empty()) {
+    EvictSegment();
+  }
+  --budget_->num_stores_;
+  std::error_code ec;
+  std::filesystem::remove(dir_, ec);
+  LOG_IF(WARNING, ec) << absl::Substitute("Failed to remove spill directory $0: $1", dir_.string(),
+                                          ec.message());
+}
+
+std::filesystem::path SpillStore::SegmentPath(int64_t segment_id) const {
+  return dir_ / absl::StrFormat("segment-%08d.rb", segment_id);
+}
+
+Status SpillStore::OpenSegment() {
+  auto path = SegmentPath(next_segment_id_);
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return error::Internal("Failed to create spill segment $0: $1", path.string(),
+                           std::strerror(errno));
+  }
+  segments_.push_back(Segment{next_segment_id_, fd, 0});
+  ++next_segment_id_;
+  return Status::OK();
+}
+
+int64_t SpillStore::EvictSegment() {
+  DCHECK(!segments_.empty());
+  auto segment = segments_.front();
+  segments_.pop_front();
+  int64_t num_batches = 0;
+  while (!locations_.empty() && locations_.front().segment_id == segment.id) {
+    locations_.pop_front();
+    row_ids_.pop_front();
+    times_.pop_front();
+    ++num_batches;
+  }
+  close(segment.fd);
+  auto path = SegmentPath(segment.id);
+  if (unlink(path.c_str()) != 0) {
+    LOG(WARNING) << absl::Substitute("Failed to delete spill segment $0: $1", path.string(),
+                                     std::strerror(errno));
+  }
+  bytes_ -= segment.bytes;
+  budget_->used_bytes_ -= segment.bytes;
+  return num_batches;
+}
+
+Status SpillStore::Add(std::shared_ptr<const schema::RowBatch> rb, RowIDInterval row_ids,
+                       TimeInterval times) {
+  if (rb->num_columns() != static_cast<int64_t>(rel_.NumColumns())) {
+    return error::InvalidArgument("Expected $0 columns in spilled batch, got $1",
+                                  rel_.NumColumns(), rb->num_columns());
+  }
+  if (NumPending() >= kMaxPendingBatches) {
+    return error::ResourceUnavailable("$0 batches are already waiting to be spilled", NumPending());
+  }
+  pending_.push_back(std::move(rb));
+  row_ids_.push_back(row_ids);
+  times_.push_back(times);
+  return Status::OK();
+}
+
+StatusOr<std::string> SpillStore::Serialize(const schema::RowBatch& rb) {
+  schemapb::RowBatchData pb;
+  PL_RETURN_IF_ERROR(rb.ToProto(&pb));
+  return pb.SerializeAsString();
+}
+
+StatusOr<int64_t> SpillStore::MakeRoom(int64_t size) {
+  if (size > budget_->max_bytes()) {
+    return error::InvalidArgument("Spilled batch ($0 bytes) is bigger than the spill limit ($1).",
+                                  size, budget_->max_bytes());
+  }
+  if (segments_.back().bytes >= segment_size_) {
+    PL_RETURN_IF_ERROR(OpenSegment());
+  }
+  auto must_evict = [&]() { return OverBudget(size) && bytes_ + size > budget_->FairShare(); };
+  int64_t num_evicted = 0;
+  while (must_evict() && segments_.size() > 1) {
+    num_evicted += EvictSegment();
+  }
+  if (must_evict() && bytes_ > 0) {
+    // Only the active segment is left, start over with a fresh one.
+    PL_RETURN_IF_ERROR(OpenSegment());
+    num_evicted += EvictSegment();
+  }
+  return num_evicted;
+}
+
+StatusOr<SpillStore::WriteSlot> SpillStore::Reserve(int64_t size, int64_t* num_evicted) {
+  DCHECK(!pending_.empty());
+  *num_evicted = 0;
+  PL_ASSIGN_OR_RETURN(*num_evicted, MakeRoom(size));
+  if (budget_->used_bytes_.fetch_add(size) + size > budget_->max_bytes()) {
+    budget_->used_bytes_ -= size;
+    return error::ResourceUnavailable("Spill budget of $0 bytes is full", budget_->max_bytes());
+  }
+  auto& segment = segments_.back();
+  WriteSlot slot{segment.id, segment.fd, segment.bytes, size};
+  segment.bytes += size;
+  bytes_ += size;
+  return slot;
+}
+
+Status SpillStore::Write(const WriteSlot& slot, const std::string& data) {
+  DCHECK_EQ(slot.size, static_cast<int64_t>(data.size()));
+  int64_t written = 0;
+  while (written < slot.size) {
+    ssize_t n = pwrite(slot.fd, data.data() + written, slot.size - written, slot.offset + written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return error::Internal("Failed to write to spill segment $0: $1", slot.segment_id,
+                             std::strerror(errno));
+    }
+    written += n;
+  }
+  return Status::OK();
+}
+
+void SpillStore::Commit(const WriteSlot& slot) {
+  DCHECK(!pending_.empty());
+  locations_.push_back(BatchLocation{slot.segment_id, slot.offset, slot.size});
+  pending_.pop_front();
+}
+
+void SpillStore::Abort(const WriteSlot* slot) {
+  DCHECK(!pending_.empty());
+  if (slot != nullptr) {
+    // Drop the partially written batch, so that the segment only holds complete batches. Nothing
+    // else can have been reserved after it.
+    auto& segment = segments_.back();
+    DCHECK_EQ(segment.id, slot->segment_id);
+    PL_UNUSED(ftruncate(segment.fd, slot->offset));
+    segment.bytes -= slot->size;
+    bytes_ -= slot->size;
+    budget_->used_bytes_ -= slot->size;
+  }
+  pending_.pop_front();
+  row_ids_.erase(row_ids_.begin() + locations_.size());
+  times_.erase(times_.begin() + locations_.size());
+}
+
+int64_t SpillStore::Trim() {
+  int64_t num_evicted = 0;
+  while (OverBudget(segment_size_) && bytes_ > budget_->FairShare() && segments_.size() > 1) {
+    num_evicted += EvictSegment();
+  }
+  return num_evicted;
+}
+
+StatusOr<int64_t> SpillStore::Append(const schema::RowBatch& rb, RowIDInterval row_ids,
+                                     TimeInterval times) {
+  PL_RETURN_IF_ERROR(Add(CopyBatch(rb), row_ids, times));
+  auto data_or_s = Serialize(rb);
+  if (!data_or_s.ok()) {
+    Abort(nullptr);
+    return data_or_s.status();
+  }
+  const std::string& data = data_or_s.ValueOrDie();
+  int64_t num_evicted = 0;
+  auto slot_or_s = Reserve(data.size(), &num_evicted);
+  if (!slot_or_s.ok()) {
+    Abort(nullptr);
+    return slot_or_s.status();
+  }
+  auto slot = slot_or_s.ConsumeValueOrDie();
+  auto s = Write(slot, data);
+  if (!s.ok()) {
+    Abort(&slot);
+    return s;
+  }
+  Commit(slot);
+  return num_evicted;
+}
+
+StatusOr<std::unique_ptr<schema::RowBatch>> SpillStore::Read(int64_t index) const {
+  if (index < 0 || index >= NumBatches()) {
+    return error::InvalidArgument("Spilled batch $0 is out of range", index);
+  }
+  if (index >= static_cast<int64_t>(locations_.size())) {
+    return CopyBatch(*pending_[index - locations_.size()]);
+  }
+  const auto& location = locations_[index];
+  const auto& segment = segments_[location.segment_id - segments_.front().id];
+
+  // mmap offsets have to be page aligned.
+  static const int64_t kPageSize = sysconf(_SC_PAGESIZE);
+  int64_t map_offset = location.offset - location.offset % kPageSize;
+  int64_t map_size = location.offset + location.size - map_offset;
+  void* addr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, segment.fd, map_offset);
+  if (addr == MAP_FAILED) {
+    return error::Internal("Failed to mmap spill segment $0: $1",
+                           SegmentPath(segment.id).string(), std::strerror(errno));
+  }
+  DEFER(munmap(addr, map_size));
+
+  schemapb::RowBatchData pb;
+  if (!pb.ParseFromArray(static_cast<const char*>(addr) + (location.offset - map_offset),
+                         location.size)) {
+    return error::Internal("Failed to parse spilled batch $0 from segment $1", index,
+                           SegmentPath(segment.id).string());
+  }
+  return schema::RowBatch::FromProto(pb);
+}
+
+}  // namespace table_store
+}  // namespace px
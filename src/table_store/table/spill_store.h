@@ -0,0 +1,241 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/memory_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "src/common/base/base.h"
+#include "src/table_store/schema/relation.h"
+#include "src/table_store/schema/row_batch.h"
+
+namespace px {
+namespace table_store {
+
+/**
+ * SpillBudget is the disk budget that a set of spill stores share. Each store keeps its own usage
+ * within the budget, and a store that has to make room for a batch only evicts its own segments,
+ * down to its fair share of the budget.
+ *
+ * SpillBudget is thread-safe.
+ */
+class SpillBudget : public NotCopyable {
+ public:
+  explicit SpillBudget(int64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  int64_t max_bytes() const { return max_bytes_; }
+  int64_t used_bytes() const { return used_bytes_.load(); }
+  // The number of bytes each store may keep when the budget is full.
+  int64_t FairShare() const { return max_bytes_ / std::max<int64_t>(1, num_stores_.load()); }
+
+ private:
+  friend class SpillStore;
+
+  const int64_t max_bytes_;
+  std::atomic<int64_t> used_bytes_ = 0;
+  std::atomic<int64_t> num_stores_ = 0;
+};
+
+/**
+ * SpillStore is an on-disk tier for batches that are expired from a table's cold storage. Batches
+ * are appended, in their RowBatchData proto form, to append-only segment files under a directory,
+ * and are read back by mmap'ing the batch's range of its segment. Once the stores sharing a
+ * budget grow past it, a store over its fair share deletes its oldest segment.
+ *
+ * Writes are split in phases, so that the owner only has to hold its lock while the index is
+ * updated, and not while the batch is serialized and written:
+ *  - Add() queues a batch in memory. Queued batches are readable right away.
+ *  - OldestPending() returns the oldest queued batch, which the owner serializes with Serialize().
+ *  - Reserve() makes room for it and returns where it goes, and Write() writes it there.
+ *  - Commit() moves the batch to disk, or Abort() drops it if the write failed.
+ * Only one batch can be reserved at a time.
+ *
+ * Batches are indexed like cold storage: the index of a batch is its position in row_ids(), and
+ * evicting a segment shifts the indexes of the remaining batches. Batches on disk come before
+ * queued batches.
+ *
+ * The index is kept in memory only, so the segments are deleted when the store is destroyed and
+ * spilled data doesn't survive a restart.
+ *
+ * SpillStore is not thread-safe, except for Serialize() and Write() which don't touch the store.
+ */
+class SpillStore : public NotCopyable {
+ public:
+  using RowIDInterval = std::pair<int64_t, int64_t>;
+  using TimeInterval = std::pair<int64_t, int64_t>;
+
+  static inline constexpr int64_t kDefaultSegmentSize = 16 * 1024 * 1024;
+  // Batches added past this many queued batches are dropped, so that a slow disk can't grow the
+  // queue without bound.
+  static inline constexpr int64_t kMaxPendingBatches = 64;
+
+  // Where a reserved batch is written to.
+  struct WriteSlot {
+    int64_t segment_id;
+    int fd;
+    int64_t offset;
+    int64_t size;
+  };
+
+  /**
+   * Creates a spill store in dir, which must not exist yet.
+   * @param budget the disk budget the store shares with other stores.
+   * @param segment_size the size after which the store moves on to a new segment file. Capped to
+   * a quarter of the budget, so that evicting a segment never drops most of the store.
+   */
+  static StatusOr<std::unique_ptr<SpillStore>> Create(const std::filesystem::path& dir,
+                                                      const schema::Relation& rel,
+                                                      std::shared_ptr<SpillBudget> budget,
+                                                      int64_t segment_size = kDefaultSegmentSize);
+  /**
+   * Creates a spill store in dir with a budget of its own of max_bytes.
+   */
+  static StatusOr<std::unique_ptr<SpillStore>> Create(const std::filesystem::path& dir,
+                                                      const schema::Relation& rel,
+                                                      int64_t max_bytes,
+                                                      int64_t segment_size = kDefaultSegmentSize);
+  ~SpillStore();
+
+  /**
+   * Queues the batch to be written to disk.
+   * @param row_ids the unique row identifiers of the first and last row of the batch.
+   * @param times the first and last times of the batch, or {-1, -1} if the table has no time
+   * column.
+   * @return ResourceUnavailable if kMaxPendingBatches are already queued, in which case the
+   * batch is dropped.
+   */
+  Status Add(std::shared_ptr<const schema::RowBatch> rb, RowIDInterval row_ids,
+             TimeInterval times);
+
+  /**
+   * Returns the oldest queued batch, or null if there are none.
+   */
+  std::shared_ptr<const schema::RowBatch> OldestPending() const {
+    return pending_.empty() ? nullptr : pending_.front();
+  }
+
+  /**
+   * Serializes a batch to the form it is spilled in.
+   */
+  static StatusOr<std::string> Serialize(const schema::RowBatch& rb);
+
+  /**
+   * Reserves size bytes at the end of the active segment for the oldest queued batch, evicting
+   * the oldest segments if that's needed to fit it.
+   * @param num_evicted set to the number of batches that were evicted.
+   * @return ResourceUnavailable if the shared budget is full and this store is within its fair
+   * share, in which case the batch stays queued until other stores make room.
+   */
+  StatusOr<WriteSlot> Reserve(int64_t size, int64_t* num_evicted);
+
+  /**
+   * Writes data to a reserved slot.
+   */
+  static Status Write(const WriteSlot& slot, const std::string& data);
+
+  /**
+   * Marks the oldest queued batch as written to the slot.
+   */
+  void Commit(const WriteSlot& slot);
+
+  /**
+   * Drops the oldest queued batch, after failing to write it to the slot, or after failing to
+   * serialize it if slot is null.
+   */
+  void Abort(const WriteSlot* slot);
+
+  /**
+   * Evicts the oldest segments while less than a segment of the shared budget is left and this
+   * store is over its fair share, so that the other stores can write. Returns the number of
+   * batches that were evicted.
+   */
+  int64_t Trim();
+
+  /**
+   * Adds the batch and writes it to disk right away.
+   * @return the number of batches that were evicted.
+   */
+  StatusOr<int64_t> Append(const schema::RowBatch& rb, RowIDInterval row_ids, TimeInterval times);
+
+  /**
+   * Reads back the batch at the given index.
+   */
+  StatusOr<std::unique_ptr<schema::RowBatch>> Read(int64_t index) const;
+
+  int64_t NumBatches() const { return row_ids_.size(); }
+  int64_t NumPending() const { return pending_.size(); }
+  // The number of bytes on disk.
+  int64_t NumBytes() const { return bytes_; }
+  int64_t BatchLength(int64_t index) const {
+    return row_ids_[index].second - row_ids_[index].first + 1;
+  }
+  const std::deque<RowIDInterval>& row_ids() const { return row_ids_; }
+  const std::deque<TimeInterval>& times() const { return times_; }
+
+ private:
+  struct Segment {
+    int64_t id;
+    int fd;
+    int64_t bytes;
+  };
+  struct BatchLocation {
+    int64_t segment_id;
+    int64_t offset;
+    int64_t size;
+  };
+
+  SpillStore(std::filesystem::path dir, schema::Relation rel, std::shared_ptr<SpillBudget> budget,
+             int64_t segment_size);
+
+  std::filesystem::path SegmentPath(int64_t segment_id) const;
+  Status OpenSegment();
+  // Deletes the oldest segment and returns the number of batches that were in it.
+  int64_t EvictSegment();
+  // Evicts the oldest segments while size more bytes don't fit the budget and this store is over
+  // its fair share. Returns the number of batches that were evicted.
+  StatusOr<int64_t> MakeRoom(int64_t size);
+  bool OverBudget(int64_t size) const {
+    return budget_->used_bytes() + size > budget_->max_bytes();
+  }
+
+  const std::filesystem::path dir_;
+  const schema::Relation rel_;
+  const std::shared_ptr<SpillBudget> budget_;
+  const int64_t segment_size_;
+
+  int64_t bytes_ = 0;
+  int64_t next_segment_id_ = 0;
+  std::deque<Segment> segments_;
+  // The locations of the batches on disk, which are the first locations_.size() batches.
+  std::deque<BatchLocation> locations_;
+  // The queued batches, which follow the batches on disk.
+  std::deque<std::shared_ptr<const schema::RowBatch>> pending_;
+  std::deque<RowIDInterval> row_ids_;
+  std::deque<TimeInterval> times_;
+};
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "src/common/fs/fs_wrapper.h"
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/spill_store.h"
+
+namespace px {
+namespace table_store {
+
+class SpillStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rel_ =
+        schema::Relation({types::DataType::TIME64NS, types::DataType::STRING}, {"time_", "name"});
+    dir_ = fs::TempDirectoryPath() / absl::StrCat("spill_store_test_", getpid());
+    std::filesystem::remove_all(dir_);
+  }
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  schema::RowBatch MakeBatch(int64_t first_time, int64_t num_rows) {
+    schema::RowBatch rb(schema::RowDescriptor(rel_.col_types()), num_rows);
+    std::vector<types::Time64NSValue> times;
+    std::vector<types::StringValue> names;
+    for (int64_t i = 0; i < num_rows; ++i) {
+      times.push_back(first_time + i);
+      names.push_back(absl::StrCat("name", first_time + i));
+    }
+    PL_CHECK_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    PL_CHECK_OK(rb.AddColumn(types::ToArrow(names, arrow::default_memory_pool())));
+    return rb;
+  }
+
+  std::filesystem::path dir_;
+  schema::Relation rel_;
+};
+
+TEST_F(SpillStoreTest, append_and_read) {
+  ASSERT_OK_AND_ASSIGN(auto store, SpillStore::Create(dir_, rel_, 1024 * 1024));
+  EXPECT_NOT_OK(SpillStore::Create(dir_, rel_, 1024 * 1024));
+
+  auto rb1 = MakeBatch(0, 3);
+  auto rb2 = MakeBatch(3, 5);
+  ASSERT_OK_AND_ASSIGN(auto evicted, store->Append(rb1, {0, 2}, {0, 2}));
+  EXPECT_EQ(0, evicted);
+  ASSERT_OK_AND_ASSIGN(evicted, store->Append(rb2, {3, 7}, {3, 7}));
+  EXPECT_EQ(0, evicted);
+
+  EXPECT_EQ(2, store->NumBatches());
+  EXPECT_LT(0, store->NumBytes());
+  EXPECT_EQ(5, store->BatchLength(1));
+  EXPECT_EQ(SpillStore::TimeInterval(3, 7), store->times()[1]);
+
+  ASSERT_OK_AND_ASSIGN(auto out1, store->Read(0));
+  ASSERT_OK_AND_ASSIGN(auto out2, store->Read(1));
+  EXPECT_TRUE(out1->ColumnAt(0)->Equals(rb1.ColumnAt(0)));
+  EXPECT_TRUE(out1->ColumnAt(1)->Equals(rb1.ColumnAt(1)));
+  EXPECT_TRUE(out2->ColumnAt(0)->Equals(rb2.ColumnAt(0)));
+  EXPECT_TRUE(out2->ColumnAt(1)->Equals(rb2.ColumnAt(1)));
+  EXPECT_NOT_OK(store->Read(2));
+}
+
+TEST_F(SpillStoreTest, evicts_oldest_segments) {
+  int64_t max_bytes = 2048;
+  ASSERT_OK_AND_ASSIGN(auto store, SpillStore::Create(dir_, rel_, max_bytes));
+
+  int64_t total_evicted = 0;
+  for (int64_t i = 0; i < 100; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto evicted,
+                         store->Append(MakeBatch(i * 10, 10), {i * 10, i * 10 + 9}, {i, i}));
+    total_evicted += evicted;
+    EXPECT_LE(store->NumBytes(), max_bytes);
+  }
+  EXPECT_LT(store->NumBatches(), 100);
+  EXPECT_EQ(100, store->NumBatches() + total_evicted);
+
+  // The batches left are the most recent ones.
+  EXPECT_EQ(99 * 10 + 9, store->row_ids().back().second);
+  EXPECT_EQ(total_evicted * 10, store->row_ids().front().first);
+  ASSERT_OK_AND_ASSIGN(auto oldest, store->Read(0));
+  EXPECT_TRUE(oldest->ColumnAt(0)->Equals(MakeBatch(total_evicted * 10, 10).ColumnAt(0)));
+
+  store.reset();
+  EXPECT_NOT_OK(fs::Exists(dir_));
+}
+
+TEST_F(SpillStoreTest, pending_batches_are_readable_until_flushed) {
+  ASSERT_OK_AND_ASSIGN(auto store, SpillStore::Create(dir_, rel_, 1024 * 1024));
+
+  auto rb1 = std::make_shared<schema::RowBatch>(MakeBatch(0, 3));
+  auto rb2 = std::make_shared<schema::RowBatch>(MakeBatch(3, 5));
+  ASSERT_OK(store->Add(rb1, {0, 2}, {0, 2}));
+  ASSERT_OK(store->Add(rb2, {3, 7}, {3, 7}));
+  EXPECT_EQ(2, store->NumBatches());
+  EXPECT_EQ(2, store->NumPending());
+  EXPECT_EQ(0, store->NumBytes());
+  ASSERT_OK_AND_ASSIGN(auto out2, store->Read(1));
+  EXPECT_TRUE(out2->ColumnAt(1)->Equals(rb2->ColumnAt(1)));
+
+  // Flush the first batch.
+  EXPECT_EQ(rb1, store->OldestPending());
+  ASSERT_OK_AND_ASSIGN(auto data, SpillStore::Serialize(*rb1));
+  int64_t evicted = 0;
+  ASSERT_OK_AND_ASSIGN(auto slot, store->Reserve(data.size(), &evicted));
+  EXPECT_EQ(0, evicted);
+  ASSERT_OK(SpillStore::Write(slot, data));
+  store->Commit(slot);
+  EXPECT_EQ(1, store->NumPending());
+  EXPECT_EQ(static_cast<int64_t>(data.size()), store->NumBytes());
+
+  // Fail to flush the second one, which drops it.
+  ASSERT_OK_AND_ASSIGN(data, SpillStore::Serialize(*rb2));
+  ASSERT_OK_AND_ASSIGN(slot, store->Reserve(data.size(), &evicted));
+  store->Abort(&slot);
+  EXPECT_EQ(1, store->NumBatches());
+  EXPECT_EQ(0, store->NumPending());
+  EXPECT_EQ(SpillStore::RowIDInterval(0, 2), store->row_ids().back());
+
+  ASSERT_OK_AND_ASSIGN(auto out1, store->Read(0));
+  EXPECT_TRUE(out1->ColumnAt(0)->Equals(rb1->ColumnAt(0)));
+  EXPECT_TRUE(out1->ColumnAt(1)->Equals(rb1->ColumnAt(1)));
+}
+
+TEST_F(SpillStoreTest, drops_batches_past_the_pending_limit) {
+  ASSERT_OK_AND_ASSIGN(auto store, SpillStore::Create(dir_, rel_, 1024 * 1024));
+  auto rb = std::make_shared<schema::RowBatch>(MakeBatch(0, 1));
+  for (int64_t i = 0; i < SpillStore::kMaxPendingBatches; ++i) {
+    ASSERT_OK(store->Add(rb, {i, i}, {i, i}));
+  }
+  EXPECT_NOT_OK(store->Add(rb, {100, 100}, {100, 100}));
+  EXPECT_EQ(SpillStore::kMaxPendingBatches, store->NumBatches());
+}
+
+TEST_F(SpillStoreTest, shared_budget) {
+  int64_t max_bytes = 4096;
+  auto budget = std::make_shared<SpillBudget>(max_bytes);
+  ASSERT_OK_AND_ASSIGN(auto store1, SpillStore::Create(dir_ / "1", rel_, budget, max_bytes / 8));
+
+  // The first store takes the whole budget while it is alone.
+  int64_t row_id = 0;
+  auto append = [&](SpillStore* store) {
+    return store->Append(MakeBatch(row_id, 10), {row_id, row_id + 9}, {row_id, row_id + 9});
+  };
+  for (; row_id < 1000; row_id += 10) {
+    ASSERT_OK(append(store1.get()));
+  }
+  EXPECT_LT(max_bytes / 2, store1->NumBytes());
+  EXPECT_EQ(store1->NumBytes(), budget->used_bytes());
+
+  // The second store fills what is left of the budget, and then waits for the first one to give
+  // back its share of it.
+  ASSERT_OK_AND_ASSIGN(auto store2, SpillStore::Create(dir_ / "2", rel_, budget, max_bytes / 8));
+  EXPECT_EQ(max_bytes / 2, budget->FairShare());
+  int64_t num_waits = 0;
+  for (int64_t i = 0; i < 100; ++i, row_id += 10) {
+    auto s = append(store2.get()).status();
+    if (!s.ok()) {
+      EXPECT_TRUE(error::IsResourceUnavailable(s));
+      ++num_waits;
+      EXPECT_LT(0, store1->Trim());
+      ASSERT_OK(append(store2.get()));
+    }
+    EXPECT_LE(budget->used_bytes(), max_bytes);
+  }
+  EXPECT_LT(0, num_waits);
+  EXPECT_GT(max_bytes * 3 / 4, store1->NumBytes());
+  EXPECT_LT(max_bytes / 4, store2->NumBytes());
+  EXPECT_EQ(store1->NumBytes() + store2->NumBytes(), budget->used_bytes());
+
+  store1.reset();
+  store2.reset();
+  EXPECT_EQ(0, budget->used_bytes());
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -17,18 +17,28 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
+#include <filesystem>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#include <unistd.h>
+
+#include <absl/strings/match.h>
 #include <absl/strings/str_format.h>
+#include <arrow/builder.h>
 #include "src/common/base/base.h"
 #include "src/common/base/status.h"
 #include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/column_wrapper_pool.h"
 #include "src/shared/types/type_utils.h"
 #include "src/table_store/schema/relation.h"
 #include "src/table_store/table/table.h"
@@ -37,10 +47,111 @@ DEFINE_int32(table_store_table_size_limit,
              gflags::Int32FromEnv("PL_TABLE_STORE_TABLE_SIZE_LIMIT", 1024 * 1024 * 64),
              "The maximal size a table allows. When the size grows beyond this limit, "
              "old data will be discarded.");
+DEFINE_bool(table_store_cold_zone_maps, true,
+            "Keep per-column zone maps (min/max or bloom filter) for each cold batch, so scans can "
+            "skip cold batches that can't match a predicate.");
+DEFINE_bool(table_store_cold_encoding, false,
+            "Encode cold batches (dictionary encoding for strings, delta-of-delta for times and "
+            "bit-packing for ints) so more data fits within the table size limit.");
+DEFINE_string(table_store_spill_dir, gflags::StringFromEnv("PL_TABLE_STORE_SPILL_DIR", ""),
+              "If set, batches expired from a table are spilled to files under this directory, "
+              "where queries can still read them, instead of being dropped.");
+DEFINE_int64(table_store_spill_size_limit,
+             gflags::Int64FromEnv("PL_TABLE_STORE_SPILL_SIZE_LIMIT", 1024LL * 1024 * 1024),
+             "The maximum number of bytes all tables together keep in --table_store_spill_dir. "
+             "When it is full, the tables using more than their share of it drop their oldest "
+             "spilled batches.");
+DEFINE_int64(table_store_shared_scan_cache_bytes,
+             gflags::Int64FromEnv("PL_TABLE_STORE_SHARED_SCAN_CACHE_BYTES", 16 * 1024 * 1024),
+             "The number of bytes of recently read columns each table keeps, so that concurrent "
+             "queries scanning the same rows share them instead of converting them again. "
+             "0 disables sharing.");
+DEFINE_int64(table_store_expiry_bucket_ns,
+             gflags::Int64FromEnv("PL_TABLE_STORE_EXPIRY_BUCKET_NS", 0),
+             "If set, tables with a time column expire their cold batches a whole time bucket of "
+             "this many nanoseconds at a time, instead of one batch at a time. 0 disables it.");
+DEFINE_bool(table_store_cold_arena, gflags::BoolFromEnv("PL_TABLE_STORE_COLD_ARENA", false),
+            "Allocate the buffers of cold batches from a per-table arena of huge page slabs, "
+            "which are returned to the OS whole as the batches expire.");
 
 namespace px {
 namespace table_store {
 
+namespace {
+
+// A row range of a hot column wrapper that is converted to arrow on first access.
+class DeferredHotColumn : public schema::DeferredColumn {
+ public:
+  DeferredHotColumn(types::SharedColumnWrapper col, int64_t offset, int64_t length,
+                    arrow::MemoryPool* mem_pool)
+      : col_(std::move(col)), offset_(offset), length_(length), mem_pool_(mem_pool) {}
+
+  int64_t length() const override { return length_; }
+
+  int64_t NumBytes() const override {
+    auto size = static_cast<int64_t>(col_->Size());
+    return size == 0 ? 0 : col_->Bytes() * length_ / size;
+  }
+
+  std::shared_ptr<arrow::Array> Materialize() const override {
+    auto arr = types::ColumnWrapper::AdoptToArrow(col_, mem_pool_);
+    if (offset_ == 0 && length_ == arr->length()) {
+      return arr;
+    }
+    return arr->Slice(offset_, length_);
+  }
+
+  std::shared_ptr<arrow::Array> MaterializeRows(const std::vector<int64_t>& rows) const override {
+    std::vector<size_t> indexes;
+    indexes.reserve(rows.size());
+    for (auto row : rows) {
+      DCHECK_LT(row, length_);
+      indexes.push_back(offset_ + row);
+    }
+    return types::ColumnWrapper::AdoptToArrow(col_->CopyIndexes(indexes), mem_pool_);
+  }
+
+ private:
+  types::SharedColumnWrapper col_;
+  int64_t offset_;
+  int64_t length_;
+  arrow::MemoryPool* mem_pool_;
+};
+
+// A row range of an encoded cold column that is decoded on first access.
+class DeferredEncodedColumn : public schema::DeferredColumn {
+ public:
+  DeferredEncodedColumn(std::shared_ptr<const EncodedColumn> col, int64_t offset, int64_t length,
+                        arrow::MemoryPool* mem_pool)
+      : col_(std::move(col)), offset_(offset), length_(length), mem_pool_(mem_pool) {}
+
+  int64_t length() const override { return length_; }
+
+  int64_t NumBytes() const override { return col_->DecodedBytes() * length_ / col_->length(); }
+
+  std::shared_ptr<arrow::Array> Materialize() const override {
+    return col_->Decode(offset_, length_, mem_pool_);
+  }
+
+  std::shared_ptr<arrow::Array> MaterializeRows(const std::vector<int64_t>& rows) const override {
+    std::vector<int64_t> col_rows;
+    col_rows.reserve(rows.size());
+    for (auto row : rows) {
+      DCHECK_LT(row, length_);
+      col_rows.push_back(offset_ + row);
+    }
+    return col_->DecodeRows(col_rows, mem_pool_);
+  }
+
+ private:
+  std::shared_ptr<const EncodedColumn> col_;
+  int64_t offset_;
+  int64_t length_;
+  arrow::MemoryPool* mem_pool_;
+};
+
+}  // namespace
+
 ArrowArrayCompactor::ArrowArrayCompactor(const schema::Relation& rel, arrow::MemoryPool* mem_pool)
     : output_columns_(rel.NumColumns()), column_types_(rel.col_types()) {
   for (auto col_type : column_types_) {
@@ -80,11 +191,47 @@ Status ArrowArrayCompactor::Finish() {
   return Status::OK();
 }
 
+namespace {
+
+// Removes the spill directories left behind by a previous run, which the index to read them back
+// was lost with.
+void RemoveStaleSpillDirs(const std::filesystem::path& spill_dir) {
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(spill_dir, ec)) {
+    if (!absl::StartsWith(entry.path().filename().string(), "table-")) {
+      continue;
+    }
+    std::filesystem::remove_all(entry.path(), ec);
+    LOG_IF(WARNING, ec) << absl::Substitute("Failed to remove stale spill directory $0: $1",
+                                            entry.path().string(), ec.message());
+  }
+}
+
+// The disk budget that the spill stores of all tables share. The first call also cleans up
+// --table_store_spill_dir.
+std::shared_ptr<SpillBudget> GlobalSpillBudget() {
+  static const auto budget = [] {
+    RemoveStaleSpillDirs(FLAGS_table_store_spill_dir);
+    return std::make_shared<SpillBudget>(FLAGS_table_store_spill_size_limit);
+  }();
+  return budget;
+}
+
+}  // namespace
+
 Table::Table(const schema::Relation& relation, size_t max_table_size, size_t min_cold_batch_size)
     : rel_(relation),
       max_table_size_(max_table_size),
       min_cold_batch_size_(min_cold_batch_size),
-      ring_capacity_(max_table_size / min_cold_batch_size) {
+      zone_maps_enabled_(FLAGS_table_store_cold_zone_maps),
+      cold_encoding_enabled_(FLAGS_table_store_cold_encoding),
+      expiry_bucket_ns_(FLAGS_table_store_expiry_bucket_ns),
+      ring_capacity_(max_table_size / min_cold_batch_size *
+                     (cold_encoding_enabled_ ? kMaxColdCompressionRatio : 1)),
+      shared_scans_(FLAGS_table_store_shared_scan_cache_bytes) {
+  if (FLAGS_table_store_cold_arena) {
+    cold_arena_ = ColdArena::Create();
+  }
   absl::MutexLock gen_lock(&generation_lock_);
   absl::MutexLock cold_lock(&cold_lock_);
   absl::MutexLock hot_lock(&hot_lock_);
@@ -93,6 +240,22 @@ Table::Table(const schema::Relation& relation, size_t max_table_size, size_t min
       time_col_idx_ = i;
     }
     cold_column_buffers_.emplace_back(ring_capacity_);
+    if (cold_encoding_enabled_) {
+      cold_encoded_buffers_.emplace_back(ring_capacity_);
+    }
+  }
+  if (!FLAGS_table_store_spill_dir.empty()) {
+    static std::atomic<int64_t> next_spill_id = 0;
+    auto dir = std::filesystem::path(FLAGS_table_store_spill_dir) /
+               absl::StrCat("table-", getpid(), "-", next_spill_id++);
+    auto spill_store_or_s = SpillStore::Create(dir, rel_, GlobalSpillBudget());
+    if (spill_store_or_s.ok()) {
+      spill_store_ = spill_store_or_s.ConsumeValueOrDie();
+    } else {
+      LOG(ERROR) << absl::Substitute(
+          "Failed to create spill store, expired batches will be dropped: $0",
+          spill_store_or_s.msg());
+    }
   }
 }
 
@@ -119,6 +282,12 @@ Status Table::ToProto(table_store::schemapb::Table* table_proto) const {
 
 StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetRowBatchSlice(
     const BatchSlice& slice, const std::vector<int64_t>& cols, arrow::MemoryPool* mem_pool) const {
+  return GetRowBatchSlice(slice, cols, /* defer_cols */ {}, mem_pool);
+}
+
+StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetRowBatchSlice(
+    const BatchSlice& slice, const std::vector<int64_t>& cols, const std::vector<bool>& defer_cols,
+    arrow::MemoryPool* mem_pool) const {
   if (!slice.IsValid())
     return error::InvalidArgument("GetRowBatchSlice called on invalid BatchSlice");
   // Get column types for row descriptor.
@@ -130,25 +299,281 @@ StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetRowBatchSlice(
 
   auto batch_size = slice.Size();
   auto output_rb = std::make_unique<schema::RowBatch>(schema::RowDescriptor(rb_types), batch_size);
-  PL_RETURN_IF_ERROR(AddBatchSliceToRowBatch(slice, cols, output_rb.get(), mem_pool));
+  if (dictionary_value_col_idx_ == -1 ||
+      std::find(cols.begin(), cols.end(), dictionary_value_col_idx_) == cols.end()) {
+    PL_RETURN_IF_ERROR(
+        AddBatchSliceToRowBatch(slice, cols, defer_cols, output_rb.get(), mem_pool));
+    return output_rb;
+  }
+
+  // The columns around the dictionary column are added in runs, so that they can still be deferred.
+  PL_ASSIGN_OR_RETURN(auto resolved, ResolveDictionaryColumn(slice, mem_pool));
+  std::vector<int64_t> run_cols;
+  std::vector<bool> run_defer_cols;
+  for (const auto& [i, col_idx] : Enumerate(cols)) {
+    if (col_idx != dictionary_value_col_idx_) {
+      run_cols.push_back(col_idx);
+      run_defer_cols.push_back(i < defer_cols.size() && defer_cols[i]);
+      continue;
+    }
+    if (!run_cols.empty()) {
+      PL_RETURN_IF_ERROR(
+          AddBatchSliceToRowBatch(slice, run_cols, run_defer_cols, output_rb.get(), mem_pool));
+      run_cols.clear();
+      run_defer_cols.clear();
+    }
+    PL_RETURN_IF_ERROR(output_rb->AddColumn(resolved));
+  }
+  if (!run_cols.empty()) {
+    PL_RETURN_IF_ERROR(
+        AddBatchSliceToRowBatch(slice, run_cols, run_defer_cols, output_rb.get(), mem_pool));
+  }
   return output_rb;
 }
 
+StatusOr<std::unique_ptr<schema::RowBatch>> Table::GetSharedRowBatchSlice(
+    const BatchSlice& slice, const std::vector<int64_t>& cols, const std::vector<bool>& defer_cols,
+    arrow::MemoryPool* mem_pool) const {
+  if (!shared_scans_.enabled() || !slice.IsValid()) {
+    return GetRowBatchSlice(slice, cols, defer_cols, mem_pool);
+  }
+  std::vector<std::shared_ptr<arrow::Array>> cached(cols.size());
+  std::vector<int64_t> missing_cols;
+  std::vector<bool> missing_defer_cols;
+  for (const auto& [i, col_idx] : Enumerate(cols)) {
+    cached[i] = shared_scans_.Get(slice.uniq_row_start_idx, slice.uniq_row_end_idx, col_idx);
+    if (cached[i] == nullptr) {
+      missing_cols.push_back(col_idx);
+      missing_defer_cols.push_back(i < defer_cols.size() && defer_cols[i]);
+    }
+  }
+
+  std::unique_ptr<schema::RowBatch> missing_rb;
+  if (!missing_cols.empty()) {
+    PL_ASSIGN_OR_RETURN(missing_rb,
+                        GetRowBatchSlice(slice, missing_cols, missing_defer_cols, mem_pool));
+    // Deferred columns stay private to this scan, converting them is up to the consumer.
+    for (const auto& [i, col_idx] : Enumerate(missing_cols)) {
+      if (!missing_rb->IsDeferredColumn(i)) {
+        shared_scans_.Put(slice.uniq_row_start_idx, slice.uniq_row_end_idx, col_idx,
+                          missing_rb->ColumnAt(i));
+      }
+    }
+    if (missing_cols.size() == cols.size()) {
+      return missing_rb;
+    }
+  }
+
+  std::vector<types::DataType> rb_types;
+  for (int64_t col_idx : cols) {
+    rb_types.push_back(rel_.col_types()[col_idx]);
+  }
+  auto output_rb =
+      std::make_unique<schema::RowBatch>(schema::RowDescriptor(rb_types), slice.Size());
+  int64_t missing_idx = 0;
+  for (const auto& arr : cached) {
+    if (arr != nullptr) {
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(arr));
+    } else if (missing_rb->IsDeferredColumn(missing_idx)) {
+      PL_RETURN_IF_ERROR(output_rb->AddDeferredColumn(missing_rb->DeferredColumnAt(missing_idx++)));
+    } else {
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(missing_rb->ColumnAt(missing_idx++)));
+    }
+  }
+  return output_rb;
+}
+
+Status Table::EnableStringDictionary(std::string_view key_col, std::string_view value_col) {
+  if (!rel_.HasColumn(std::string(key_col)) ||
+      rel_.GetColumnType(std::string(key_col)) != types::DataType::INT64) {
+    return error::InvalidArgument("Dictionary key column '$0' must be an INT64 column", key_col);
+  }
+  if (!rel_.HasColumn(std::string(value_col)) ||
+      rel_.GetColumnType(std::string(value_col)) != types::DataType::STRING) {
+    return error::InvalidArgument("Dictionary value column '$0' must be a STRING column",
+                                  value_col);
+  }
+  dictionary_key_col_idx_ = rel_.GetColumnIndex(std::string(key_col));
+  dictionary_value_col_idx_ = rel_.GetColumnIndex(std::string(value_col));
+  return Status::OK();
+}
+
+Table::DictionaryUpdate Table::CollectDictionaryUpdate(
+    const types::ColumnWrapperRecordBatch& record_batch) {
+  DictionaryUpdate update;
+  const auto& keys = record_batch[dictionary_key_col_idx_];
+  const auto& values = record_batch[dictionary_value_col_idx_];
+  update.keys.reserve(keys->Size());
+  for (size_t i = 0; i < keys->Size(); ++i) {
+    int64_t key = keys->Get<types::Int64Value>(i).val;
+    update.keys.push_back(key);
+    const auto& value = values->Get<types::StringValue>(i);
+    if (!value.empty()) {
+      update.values[key] = value;
+    }
+  }
+  return update;
+}
+
+Table::DictionaryUpdate Table::CollectDictionaryUpdate(const schema::RowBatch& rb) {
+  DictionaryUpdate update;
+  auto keys = rb.ColumnAt(dictionary_key_col_idx_);
+  auto values = rb.ColumnAt(dictionary_value_col_idx_);
+  update.keys.reserve(keys->length());
+  for (int64_t i = 0; i < keys->length(); ++i) {
+    int64_t key = types::GetValueFromArrowArray<types::DataType::INT64>(keys.get(), i);
+    update.keys.push_back(key);
+    auto value = types::GetValueFromArrowArray<types::DataType::STRING>(values.get(), i);
+    if (!value.empty()) {
+      update.values[key] = std::move(value);
+    }
+  }
+  return update;
+}
+
+void Table::UpdateDictionary(DictionaryUpdate update, int64_t last_row_id) {
+  // Read before taking dictionary_lock_, so that the two locks are never held together.
+  BatchSlice first_batch = FirstBatch();
+  absl::MutexLock dictionary_lock(&dictionary_lock_);
+  for (int64_t key : update.keys) {
+    auto it = update.values.find(key);
+    if (it != update.values.end()) {
+      dictionary_[key] = DictionaryEntry{std::move(it->second), last_row_id};
+      update.values.erase(it);
+      continue;
+    }
+    auto entry = dictionary_.find(key);
+    if (entry != dictionary_.end()) {
+      entry->second.last_row_id = last_row_id;
+    }
+  }
+
+  if (dictionary_.size() < dictionary_prune_size_ || !first_batch.IsValid()) {
+    return;
+  }
+  for (auto it = dictionary_.begin(); it != dictionary_.end();) {
+    if (it->second.last_row_id < first_batch.uniq_row_start_idx) {
+      dictionary_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  dictionary_prune_size_ = std::max(kMinDictionaryPruneSize, 2 * dictionary_.size());
+}
+
+StatusOr<Table::ArrowArrayPtr> Table::ResolveDictionaryColumn(const BatchSlice& slice,
+                                                              arrow::MemoryPool* mem_pool) const {
+  schema::RowBatch rb(schema::RowDescriptor({types::DataType::INT64, types::DataType::STRING}),
+                      slice.Size());
+  PL_RETURN_IF_ERROR(AddBatchSliceToRowBatch(
+      slice, {dictionary_key_col_idx_, dictionary_value_col_idx_}, {}, &rb, mem_pool));
+  auto keys = rb.ColumnAt(0);
+  auto values = rb.ColumnAt(1);
+  auto* str_values = static_cast<const arrow::StringArray*>(values.get());
+
+  bool has_empty = false;
+  for (int64_t i = 0; i < str_values->length() && !has_empty; ++i) {
+    has_empty = str_values->value_length(i) == 0;
+  }
+  if (!has_empty) {
+    return values;
+  }
+
+  arrow::StringBuilder builder(mem_pool);
+  PL_RETURN_IF_ERROR(builder.Reserve(str_values->length()));
+  absl::MutexLock dictionary_lock(&dictionary_lock_);
+  for (int64_t i = 0; i < str_values->length(); ++i) {
+    if (str_values->value_length(i) != 0) {
+      PL_RETURN_IF_ERROR(builder.Append(str_values->GetString(i)));
+      continue;
+    }
+    int64_t key = types::GetValueFromArrowArray<types::DataType::INT64>(keys.get(), i);
+    auto it = dictionary_.find(key);
+    PL_RETURN_IF_ERROR(builder.Append(it == dictionary_.end() ? "" : it->second.value));
+  }
+  ArrowArrayPtr resolved;
+  PL_RETURN_IF_ERROR(builder.Finish(&resolved));
+  return resolved;
+}
+
+Table::~Table() {
+  if (memory_budget_ != nullptr) {
+    memory_budget_->RemoveTable(this);
+  }
+  if (cold_arena_ != nullptr) {
+    // The cold batches still hold the arena until their buffers are freed.
+    cold_arena_->Release();
+  }
+}
+
+void Table::SetMemoryBudget(std::shared_ptr<MemoryBudget> memory_budget,
+                            TableBudget table_budget) {
+  memory_budget_ = std::move(memory_budget);
+  memory_budget_->AddTable(this, table_budget);
+}
+
+int64_t Table::Bytes() const {
+  absl::base_internal::SpinLockHolder lock(&stats_lock_);
+  return cold_bytes_ + hot_bytes_;
+}
+
+int64_t Table::RetentionNS() const {
+  if (time_col_idx_ == -1) {
+    return -1;
+  }
+  int64_t min_time = -1;
+  int64_t max_time = -1;
+  {
+    absl::MutexLock cold_lock(&cold_lock_);
+    if (!cold_time_.empty()) {
+      min_time = cold_time_.front().first;
+      max_time = cold_time_.back().second;
+    }
+  }
+  {
+    absl::MutexLock hot_lock(&hot_lock_);
+    if (!hot_time_.empty()) {
+      if (min_time == -1) {
+        min_time = hot_time_.front().first;
+      }
+      max_time = hot_time_.back().second;
+    }
+  }
+  return min_time == -1 ? -1 : max_time - min_time;
+}
+
+Status Table::ExpireOldestBatch() {
+  PL_RETURN_IF_ERROR(ExpireBatch());
+  absl::base_internal::SpinLockHolder lock(&stats_lock_);
+  batches_expired_++;
+  return Status::OK();
+}
+
 Status Table::ExpireRowBatches(int64_t row_batch_size) {
   if (row_batch_size > max_table_size_) {
     return error::InvalidArgument("RowBatch size ($0) is bigger than maximum table size ($1).",
                                   row_batch_size, max_table_size_);
   }
+  if (memory_budget_ != nullptr) {
+    PL_RETURN_IF_ERROR(memory_budget_->MakeRoom(row_batch_size));
+  }
   int64_t bytes;
   {
     absl::base_internal::SpinLockHolder lock(&stats_lock_);
     bytes = cold_bytes_ + hot_bytes_;
   }
   while (bytes + row_batch_size > max_table_size_) {
-    PL_RETURN_IF_ERROR(ExpireBatch());
+    int64_t num_expired = 0;
+    if (expiry_bucket_ns_ > 0 && time_col_idx_ != -1) {
+      num_expired = ExpireColdBucket();
+    }
+    if (num_expired == 0) {
+      PL_RETURN_IF_ERROR(ExpireBatch());
+      num_expired = 1;
+    }
     {
       absl::base_internal::SpinLockHolder lock(&stats_lock_);
-      batches_expired_++;
+      batches_expired_ += num_expired;
       bytes = cold_bytes_ + hot_bytes_;
     }
   }
@@ -180,7 +605,15 @@ Status Table::WriteRowBatch(const schema::RowBatch& rb) {
   }
 
   PL_RETURN_IF_ERROR(ExpireRowBatches(rb_bytes));
-  PL_RETURN_IF_ERROR(WriteHot(rb));
+  DictionaryUpdate update;
+  if (dictionary_key_col_idx_ != -1) {
+    update = CollectDictionaryUpdate(rb);
+  }
+  int64_t last_row_id;
+  PL_RETURN_IF_ERROR(WriteHot(rb, &last_row_id));
+  if (dictionary_key_col_idx_ != -1) {
+    UpdateDictionary(std::move(update), last_row_id);
+  }
   absl::base_internal::SpinLockHolder lock(&stats_lock_);
   hot_bytes_ += rb_bytes;
   ++batches_added_;
@@ -214,7 +647,15 @@ Status Table::TransferRecordBatch(
   }
 
   PL_RETURN_IF_ERROR(ExpireRowBatches(rb_bytes));
-  PL_RETURN_IF_ERROR(WriteHot(std::move(record_batch)));
+  DictionaryUpdate update;
+  if (dictionary_key_col_idx_ != -1) {
+    update = CollectDictionaryUpdate(*record_batch);
+  }
+  int64_t last_row_id;
+  PL_RETURN_IF_ERROR(WriteHot(std::move(record_batch), &last_row_id));
+  if (dictionary_key_col_idx_ != -1) {
+    UpdateDictionary(std::move(update), last_row_id);
+  }
 
   absl::base_internal::SpinLockHolder lock(&stats_lock_);
   hot_bytes_ += rb_bytes;
@@ -223,6 +664,36 @@ Status Table::TransferRecordBatch(
   return Status::OK();
 }
 
+namespace {
+
+// Galloping searches over a batch's sorted times. They step back from the end of the batch, since
+// most seeks are for recent times, then binary search the last step.
+// Returns the offset of the first time greater than or equal to time, or -1 if there is none.
+int64_t SearchTimesGreaterThanOrEqual(const int64_t* times, int64_t n, int64_t time) {
+  int64_t hi = n;
+  int64_t lo = n - 1;
+  for (int64_t step = 1; lo >= 0 && times[lo] >= time; step *= 2) {
+    hi = lo;
+    lo -= step;
+  }
+  auto it = std::lower_bound(times + std::max<int64_t>(lo, 0), times + hi, time);
+  return it == times + n ? -1 : it - times;
+}
+
+// Returns the offset of the last time less than or equal to time, or -1 if there is none.
+int64_t SearchTimesLessThanOrEqual(const int64_t* times, int64_t n, int64_t time) {
+  int64_t hi = n;
+  int64_t lo = n - 1;
+  for (int64_t step = 1; lo >= 0 && times[lo] > time; step *= 2) {
+    hi = lo;
+    lo -= step;
+  }
+  auto it = std::upper_bound(times + std::max<int64_t>(lo, 0), times + hi, time);
+  return (it - times) - 1;
+}
+
+}  // namespace
+
 static inline bool IntervalComparatorLowerBound(const std::pair<int64_t, int64_t> interval,
                                                 int64_t val) {
   return interval.second < val;
@@ -233,13 +704,26 @@ static inline bool IntervalComparatorUpperBound(int64_t val,
   return val < interval.first;
 }
 
-StatusOr<BatchSlice> Table::FindBatchSliceGreaterThanOrEqual(int64_t time,
-                                                             arrow::MemoryPool* mem_pool) const {
+StatusOr<BatchSlice> Table::FindBatchSliceGreaterThanOrEqual(int64_t time) const {
   if (time_col_idx_ == -1) {
     return error::InvalidArgument(
         "Cannot call FindBatchSliceGreaterThanOrEqual on table without a time column.");
   }
   absl::MutexLock gen_lock(&generation_lock_);
+  if (spill_store_ != nullptr) {
+    const auto& spilled_times = spill_store_->times();
+    auto it = std::lower_bound(spilled_times.begin(), spilled_times.end(), time,
+                               IntervalComparatorLowerBound);
+    if (it != spilled_times.end()) {
+      auto index = std::distance(spilled_times.begin(), it);
+      PL_ASSIGN_OR_RETURN(auto time_col, SpilledTimeColumnUnlocked(index));
+      auto row_offset = types::SearchArrowArrayGreaterThanOrEqual<types::DataType::TIME64NS>(
+          time_col.get(), time);
+      auto row_ids = spill_store_->row_ids()[index];
+      return BatchSlice::Spilled(index, row_offset, time_col->length() - 1, generation_,
+                                 row_ids.first + row_offset, row_ids.second);
+    }
+  }
   {
     absl::MutexLock cold_lock(&cold_lock_);
     auto it =
@@ -247,12 +731,10 @@ StatusOr<BatchSlice> Table::FindBatchSliceGreaterThanOrEqual(int64_t time,
     if (it != cold_time_.end()) {
       auto index = std::distance(cold_time_.begin(), it);
       auto ring_index = RingIndexUnlocked(index);
-      auto time_col = cold_column_buffers_[time_col_idx_][ring_index];
-      auto row_offset = types::SearchArrowArrayGreaterThanOrEqual<types::DataType::TIME64NS>(
-          time_col.get(), time);
+      auto row_offset = ColdTimeGreaterThanOrEqualUnlocked(ring_index, time);
       auto row_ids = cold_row_ids_[index];
-      return BatchSlice::Cold(ring_index, row_offset, time_col->length() - 1, generation_,
-                              row_ids.first + row_offset, row_ids.second);
+      return BatchSlice::Cold(ring_index, row_offset, ColdBatchLengthUnlocked(ring_index) - 1,
+                              generation_, row_ids.first + row_offset, row_ids.second);
     }
   }
   // If the time wasn't found in the cold batches, we look in the hot batches.
@@ -263,30 +745,19 @@ StatusOr<BatchSlice> Table::FindBatchSliceGreaterThanOrEqual(int64_t time,
     return BatchSlice::Invalid();
   }
   auto index = std::distance(hot_time_.begin(), it);
-
-  ArrowArrayPtr time_col;
-  if (std::holds_alternative<RecordBatchWithCache>(hot_batches_[index])) {
-    auto record_batch_ptr = std::get_if<RecordBatchWithCache>(&hot_batches_[index]);
-    time_col = GetHotColumnUnlocked(record_batch_ptr, time_col_idx_, mem_pool);
-  } else {
-    auto row_batch = std::get<schema::RowBatch>(hot_batches_[index]);
-    time_col = row_batch.columns().at(time_col_idx_);
-  }
-
-  auto row_offset =
-      types::SearchArrowArrayGreaterThanOrEqual<types::DataType::TIME64NS>(time_col.get(), time);
+  auto [times, num_times] = HotTimesUnlocked(index);
+  auto row_offset = SearchTimesGreaterThanOrEqual(times, num_times, time);
   auto row_ids = hot_row_ids_[index];
-  return BatchSlice::Hot(index, row_offset, time_col->length() - 1, generation_,
-                         row_ids.first + row_offset, row_ids.second);
+  return BatchSlice::Hot(index, row_offset, num_times - 1, generation_, row_ids.first + row_offset,
+                         row_ids.second);
 }
 
-StatusOr<Table::StopPosition> Table::FindStopPositionForTime(int64_t time,
-                                                             arrow::MemoryPool* mem_pool) const {
+StatusOr<Table::StopPosition> Table::FindStopPositionForTime(int64_t time) const {
   if (time_col_idx_ == -1) {
     return error::InvalidArgument(
         "Cannot call FindStopPositionForTime on table without a time column.");
   }
-  auto stop = FindStopTime(time, mem_pool);
+  auto stop = FindStopTime(time);
   if (stop == -1) {
     // If all the data is after the stop time then we return the first unique row identifier in the
     // table, which will cause no results to be returned.
@@ -300,14 +771,72 @@ schema::Relation Table::GetRelation() const { return rel_; }
 TableStats Table::GetTableStats() const {
   TableStats info;
   auto num_batches = NumBatches();
+  info.spilled_batches = 0;
+  info.spilled_bytes = 0;
+  {
+    absl::MutexLock gen_lock(&generation_lock_);
+    if (spill_store_ != nullptr) {
+      info.spilled_batches = spill_store_->NumBatches();
+      info.spilled_bytes = spill_store_->NumBytes();
+    }
+    info.spill_dropped_batches = spill_dropped_batches_;
+  }
+  info.num_rows = 0;
+  info.min_batch_rows = 0;
+  info.max_batch_rows = 0;
+  info.min_time = -1;
+  info.max_time = -1;
+  auto add_batch_rows = [&info](const RowIDInterval& row_ids) {
+    int64_t batch_rows = row_ids.second - row_ids.first + 1;
+    info.min_batch_rows =
+        info.num_rows == 0 ? batch_rows : std::min(info.min_batch_rows, batch_rows);
+    info.max_batch_rows = std::max(info.max_batch_rows, batch_rows);
+    info.num_rows += batch_rows;
+  };
+  // Cold and hot storage are read one after the other, so a compaction in between can make the
+  // row counts and times off by the compacted batches.
+  {
+    absl::MutexLock cold_lock(&cold_lock_);
+    for (const auto& row_ids : cold_row_ids_) {
+      add_batch_rows(row_ids);
+    }
+    if (time_col_idx_ != -1 && !cold_time_.empty()) {
+      info.min_time = cold_time_.front().first;
+      info.max_time = cold_time_.back().second;
+    }
+  }
+  int64_t num_hot_batches;
+  {
+    absl::MutexLock hot_lock(&hot_lock_);
+    num_hot_batches = hot_batches_.size();
+    for (const auto& row_ids : hot_row_ids_) {
+      add_batch_rows(row_ids);
+    }
+    if (time_col_idx_ != -1 && !hot_time_.empty()) {
+      if (info.min_time == -1) {
+        info.min_time = hot_time_.front().first;
+      }
+      info.max_time = hot_time_.back().second;
+    }
+  }
   absl::base_internal::SpinLockHolder lock(&stats_lock_);
 
   info.batches_added = batches_added_;
   info.batches_expired = batches_expired_;
   info.num_batches = num_batches;
+  info.num_hot_batches = num_hot_batches;
+  info.hot_bytes = hot_bytes_;
   info.bytes = hot_bytes_ + cold_bytes_;
   info.cold_bytes = cold_bytes_;
+  info.cold_decoded_bytes = cold_decoded_bytes_;
+  info.cold_compression_ratio =
+      cold_bytes_ == 0 ? 1.0 : static_cast<double>(cold_decoded_bytes_) / cold_bytes_;
   info.compacted_batches = compacted_batches_;
+  info.compaction_latency_ns = compaction_latency_ns_;
+  info.shared_scan_hits = shared_scans_.hits();
+  info.shared_scan_misses = shared_scans_.misses();
+  info.cold_arena_reserved_bytes = cold_arena_ != nullptr ? cold_arena_->bytes_reserved() : 0;
+  info.cold_arena_used_bytes = cold_arena_ != nullptr ? cold_arena_->bytes_allocated() : 0;
   info.max_table_size = max_table_size_;
 
   return info;
@@ -327,14 +856,17 @@ Status Table::UpdateTimeRowIndices(types::ColumnWrapperRecordBatch* record_batch
   return Status::OK();
 }
 
-Status Table::WriteHot(RecordBatchPtr record_batch) {
-  absl::MutexLock hot_lock(&hot_lock_);
-  PL_RETURN_IF_ERROR(UpdateTimeRowIndices(record_batch.get()));
+Status Table::WriteHot(RecordBatchPtr record_batch, int64_t* last_row_id) {
+  // Build the batch before taking hot_lock_, so that the critical section is just the appends.
+  auto* record_batch_ptr = record_batch.get();
   auto rb = RecordBatchWithCache{
       std::move(record_batch),
       std::vector<ArrowArrayPtr>(rel_.NumColumns()),
       std::vector<bool>(rel_.NumColumns(), false),
   };
+  absl::MutexLock hot_lock(&hot_lock_);
+  PL_RETURN_IF_ERROR(UpdateTimeRowIndices(record_batch_ptr));
+  *last_row_id = next_row_id_ - 1;
   hot_batches_.emplace_back(std::move(rb));
   return Status::OK();
 }
@@ -355,81 +887,134 @@ Status Table::UpdateTimeRowIndices(const schema::RowBatch& rb) {
   return Status::OK();
 }
 
-Status Table::WriteHot(const schema::RowBatch& rb) {
+Status Table::WriteHot(const schema::RowBatch& rb, int64_t* last_row_id) {
+  RecordOrRowBatch batch(rb);
   absl::MutexLock hot_lock(&hot_lock_);
   PL_RETURN_IF_ERROR(UpdateTimeRowIndices(rb));
-  hot_batches_.emplace_back(rb);
+  *last_row_id = next_row_id_ - 1;
+  hot_batches_.emplace_back(std::move(batch));
   return Status::OK();
 }
 
+const Table::RecordOrRowBatch* Table::HotBatch(int64_t hot_index) const {
+  absl::MutexLock hot_lock(&hot_lock_);
+  return &hot_batches_[hot_index];
+}
+
 Status Table::CompactSingleBatch(arrow::MemoryPool* mem_pool) {
-  ArrowArrayCompactor builder(rel_, mem_pool);
+  // Only the output goes into the cold arena. The conversions of hot batches are temporary.
+  ArrowArrayCompactor builder(rel_, cold_arena_ != nullptr ? cold_arena_ : mem_pool);
   int64_t first_time = -1;
   int64_t last_time = -1;
   int64_t first_row_id = -1;
   int64_t last_row_id = -1;
   absl::MutexLock gen_lock(&generation_lock_);
   // We first get the necessary batches to compact from hot storage. Then we compact those batches
-  // into one batch. Then we push that batch into cold storage.
+  // into one batch. Then we push that batch into cold storage. The hot batches are converted
+  // without holding hot_lock_ (see HotBatch), and are only popped from hot storage once
+  // they've all been appended.
+  int64_t num_hot_batches;
   {
     absl::MutexLock hot_lock(&hot_lock_);
-    for (auto it = hot_batches_.begin(); it != hot_batches_.end();) {
-      if (builder.Size() >= min_cold_batch_size_) {
-        break;
-      }
-      std::vector<std::shared_ptr<arrow::Array>> column_arrays;
-      if (std::holds_alternative<RecordBatchWithCache>(*it)) {
-        auto record_batch_ptr = std::get_if<RecordBatchWithCache>(&(*it));
-        for (int64_t col_idx = 0; col_idx < static_cast<int64_t>(rel_.NumColumns()); ++col_idx) {
-          if (record_batch_ptr->cache_validity[col_idx]) {
-            PL_RETURN_IF_ERROR(
-                builder.AppendColumn(col_idx, record_batch_ptr->arrow_cache[col_idx]));
-          } else {
-            PL_RETURN_IF_ERROR(builder.AppendColumn(
-                col_idx, record_batch_ptr->record_batch->at(col_idx)->ConvertToArrow(mem_pool)));
-          }
-        }
-      } else {
-        auto row_batch = std::get<schema::RowBatch>(*it);
-        for (auto [col_idx, col] : Enumerate(row_batch.columns())) {
-          PL_RETURN_IF_ERROR(builder.AppendColumn(col_idx, col));
+    num_hot_batches = hot_batches_.size();
+  }
+  int64_t num_compacted = 0;
+  for (; num_compacted < num_hot_batches; ++num_compacted) {
+    if (builder.Size() >= min_cold_batch_size_) {
+      break;
+    }
+    const RecordOrRowBatch* hot_batch = HotBatch(num_compacted);
+    if (std::holds_alternative<RecordBatchWithCache>(*hot_batch)) {
+      auto record_batch_ptr = std::get_if<RecordBatchWithCache>(hot_batch);
+      for (int64_t col_idx = 0; col_idx < static_cast<int64_t>(rel_.NumColumns()); ++col_idx) {
+        if (record_batch_ptr->cache_validity[col_idx]) {
+          PL_RETURN_IF_ERROR(builder.AppendColumn(col_idx, record_batch_ptr->arrow_cache[col_idx]));
+        } else {
+          PL_RETURN_IF_ERROR(builder.AppendColumn(
+              col_idx, types::ColumnWrapper::AdoptToArrow(
+                           record_batch_ptr->record_batch->at(col_idx), mem_pool)));
         }
       }
-      auto row_ids = hot_row_ids_.front();
-      if (first_row_id == -1) {
-        first_row_id = row_ids.first;
+    } else {
+      const auto& row_batch = std::get<schema::RowBatch>(*hot_batch);
+      for (auto [col_idx, col] : Enumerate(row_batch.columns())) {
+        PL_RETURN_IF_ERROR(builder.AppendColumn(col_idx, col));
       }
-      last_row_id = row_ids.second;
-
-      it = hot_batches_.erase(it);
+    }
+  }
+  if (num_compacted == 0) {
+    return Status::OK();
+  }
+  std::vector<RecordOrRowBatch> compacted_batches;
+  compacted_batches.reserve(num_compacted);
+  {
+    absl::MutexLock hot_lock(&hot_lock_);
+    first_row_id = hot_row_ids_.front().first;
+    last_row_id = hot_row_ids_[num_compacted - 1].second;
+    if (time_col_idx_ != -1) {
+      first_time = hot_time_.front().first;
+      last_time = hot_time_[num_compacted - 1].second;
+    }
+    for (int64_t i = 0; i < num_compacted; ++i) {
+      compacted_batches.push_back(std::move(hot_batches_.front()));
+      hot_batches_.pop_front();
       hot_row_ids_.pop_front();
-
-      if (time_col_idx_ != -1) {
-        auto times = hot_time_.front();
-        if (first_time == -1) {
-          first_time = times.first;
-        }
-        last_time = times.second;
-        hot_time_.pop_front();
-      }
+      if (time_col_idx_ != -1) hot_time_.pop_front();
     }
   }
   PL_RETURN_IF_ERROR(builder.Finish());
+  for (auto& batch : compacted_batches) {
+    RecycleHotBatch(&batch);
+  }
+  std::optional<ZoneMap> zone_map;
+  if (zone_maps_enabled_) {
+    PL_ASSIGN_OR_RETURN(zone_map, ZoneMap::Create(rel_, builder.output_columns()));
+  }
+  int64_t cold_batch_bytes = builder.Size();
+  std::vector<std::unique_ptr<EncodedColumn>> encoded_cols(rel_.NumColumns());
+  if (cold_encoding_enabled_) {
+    for (const auto& [col_idx, col] : Enumerate(builder.output_columns())) {
+      PL_ASSIGN_OR_RETURN(encoded_cols[col_idx],
+                          EncodedColumn::Encode(rel_.GetColumnType(col_idx), *col));
+      const auto& encoded_col = encoded_cols[col_idx];
+      if (encoded_col != nullptr) {
+        cold_batch_bytes += encoded_col->NumBytes() - encoded_col->DecodedBytes();
+      }
+    }
+  }
+  int64_t expired_bytes = 0;
+  int64_t expired_decoded_bytes = 0;
+  int64_t batches_expired = 0;
   {
     absl::MutexLock cold_lock(&cold_lock_);
+    if (RingSizeUnlocked() == ring_capacity_) {
+      // Only possible with cold encoding, when batches compress better than
+      // kMaxColdCompressionRatio. Make room by expiring the oldest batch.
+      ExpireColdUnlocked(&expired_bytes, &expired_decoded_bytes);
+      ++batches_expired;
+    }
     PL_RETURN_IF_ERROR(AdvanceRingBufferUnlocked());
     for (const auto& [col_idx, col] : Enumerate(builder.output_columns())) {
+      if (encoded_cols[col_idx] != nullptr) {
+        cold_encoded_buffers_[col_idx][ring_back_idx_] = std::move(encoded_cols[col_idx]);
+        continue;
+      }
       cold_column_buffers_[col_idx][ring_back_idx_] = col;
     }
     cold_row_ids_.emplace_back(first_row_id, last_row_id);
     if (time_col_idx_ != -1) {
       cold_time_.emplace_back(first_time, last_time);
     }
+    if (zone_map.has_value()) {
+      cold_zone_maps_.push_back(std::move(zone_map.value()));
+    }
   }
   {
     absl::base_internal::SpinLockHolder stat_lock(&stats_lock_);
     hot_bytes_ -= builder.Size();
-    cold_bytes_ += builder.Size();
+    cold_bytes_ += cold_batch_bytes - expired_bytes;
+    cold_decoded_bytes_ += builder.Size() - expired_decoded_bytes;
+    batches_expired_ += batches_expired;
     compacted_batches_++;
   }
   generation_++;
@@ -437,49 +1022,182 @@ Status Table::CompactSingleBatch(arrow::MemoryPool* mem_pool) {
 }
 
 Status Table::CompactHotToCold(arrow::MemoryPool* mem_pool) {
-  for (size_t i = 0; i < kMaxBatchesPerCompactionCall; ++i) {
+  auto start = std::chrono::steady_clock::now();
+  size_t num_compacted = 0;
+  for (; num_compacted < kMaxBatchesPerCompactionCall; ++num_compacted) {
     {
       absl::base_internal::SpinLockHolder stats_lock(&stats_lock_);
       if (hot_bytes_ < min_cold_batch_size_) {
-        return Status::OK();
+        break;
       }
     }
     PL_RETURN_IF_ERROR(CompactSingleBatch(mem_pool));
   }
+  if (num_compacted > 0) {
+    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    absl::base_internal::SpinLockHolder stats_lock(&stats_lock_);
+    compaction_latency_ns_ = latency;
+  }
+  return FlushSpill();
+}
 
-  return Status::OK();
+Status Table::FlushSpill() {
+  absl::MutexLock flush_lock(&spill_flush_lock_);
+  while (true) {
+    std::shared_ptr<const schema::RowBatch> rb;
+    {
+      absl::MutexLock gen_lock(&generation_lock_);
+      if (spill_store_ == nullptr) {
+        return Status::OK();
+      }
+      rb = spill_store_->OldestPending();
+      if (rb == nullptr) {
+        // Give back the space other tables need, now that this table is done writing.
+        if (spill_store_->Trim() > 0) {
+          generation_++;
+        }
+        return Status::OK();
+      }
+    }
+    auto data_or_s = SpillStore::Serialize(*rb);
+    SpillStore::WriteSlot slot;
+    {
+      absl::MutexLock gen_lock(&generation_lock_);
+      if (!data_or_s.ok()) {
+        spill_store_->Abort(nullptr);
+        generation_++;
+        return data_or_s.status();
+      }
+      int64_t num_evicted = 0;
+      auto slot_or_s = spill_store_->Reserve(data_or_s.ValueOrDie().size(), &num_evicted);
+      if (num_evicted > 0) {
+        generation_++;
+      }
+      if (error::IsResourceUnavailable(slot_or_s.status())) {
+        // The budget is taken by other tables, the batch waits for them to trim their share.
+        return Status::OK();
+      }
+      if (!slot_or_s.ok()) {
+        spill_store_->Abort(nullptr);
+        generation_++;
+        return slot_or_s.status();
+      }
+      slot = slot_or_s.ConsumeValueOrDie();
+    }
+    auto s = SpillStore::Write(slot, data_or_s.ValueOrDie());
+    absl::MutexLock gen_lock(&generation_lock_);
+    if (!s.ok()) {
+      spill_store_->Abort(&slot);
+      generation_++;
+      return s;
+    }
+    spill_store_->Commit(slot);
+  }
+}
+
+double Table::HotBudgetRatio() const {
+  absl::base_internal::SpinLockHolder stats_lock(&stats_lock_);
+  return static_cast<double>(hot_bytes_) / (min_cold_batch_size_ * kMaxBatchesPerCompactionCall);
+}
+
+Status Table::SpillColdBatchUnlocked() {
+  auto num_rows = ColdBatchLengthUnlocked(ring_front_idx_);
+  auto rb = std::make_shared<schema::RowBatch>(schema::RowDescriptor(rel_.col_types()), num_rows);
+  for (size_t col_idx = 0; col_idx < rel_.NumColumns(); ++col_idx) {
+    PL_RETURN_IF_ERROR(
+        rb->AddColumn(ColdColumnUnlocked(col_idx, ring_front_idx_, arrow::default_memory_pool())));
+  }
+  auto times = time_col_idx_ == -1 ? TimeInterval{-1, -1} : cold_time_.front();
+  return spill_store_->Add(rb, cold_row_ids_.front(), times);
+}
+
+StatusOr<Table::ArrowArrayPtr> Table::SpilledTimeColumnUnlocked(int64_t spill_index) const {
+  PL_ASSIGN_OR_RETURN(auto rb, spill_store_->Read(spill_index));
+  return rb->ColumnAt(time_col_idx_);
+}
+
+void Table::ExpireColdUnlocked(int64_t* bytes, int64_t* decoded_bytes) {
+  DCHECK_GT(RingSizeUnlocked(), 0);
+  if (spill_store_ != nullptr) {
+    auto s = SpillColdBatchUnlocked();
+    if (!s.ok()) {
+      // A slow disk fails every expiration until the queue drains, so this is only logged now and
+      // then. The drops are counted in the table stats.
+      ++spill_dropped_batches_;
+      LOG_EVERY_N(ERROR, 100) << absl::Substitute(
+          "Failed to spill expired batch, $0 dropped so far: $1", spill_dropped_batches_, s.msg());
+    }
+  }
+  cold_row_ids_.pop_front();
+  if (time_col_idx_ != -1) cold_time_.pop_front();
+  if (zone_maps_enabled_) cold_zone_maps_.pop_front();
+
+  for (size_t col_idx = 0; col_idx < rel_.NumColumns(); col_idx++) {
+    if (cold_encoding_enabled_ && cold_encoded_buffers_[col_idx][ring_front_idx_] != nullptr) {
+      *bytes += cold_encoded_buffers_[col_idx][ring_front_idx_]->NumBytes();
+      *decoded_bytes += cold_encoded_buffers_[col_idx][ring_front_idx_]->DecodedBytes();
+      cold_encoded_buffers_[col_idx][ring_front_idx_].reset();
+      continue;
+    }
+    int64_t col_bytes = 0;
+#define TYPE_CASE(_dt_) \
+  col_bytes = types::GetArrowArrayBytes<_dt_>(cold_column_buffers_[col_idx][ring_front_idx_].get());
+    PL_SWITCH_FOREACH_DATATYPE(rel_.GetColumnType(col_idx), TYPE_CASE);
+#undef TYPE_CASE
+    *bytes += col_bytes;
+    *decoded_bytes += col_bytes;
+    cold_column_buffers_[col_idx][ring_front_idx_].reset();
+  }
+  if (ring_front_idx_ == ring_back_idx_) {
+    // The batch we are expiring is the last batch in the ring buffer, so we reset the indices.
+    ring_front_idx_ = 0;
+    ring_back_idx_ = -1;
+  } else {
+    ring_front_idx_ = (ring_front_idx_ + 1) % ring_capacity_;
+  }
+  generation_++;
 }
 
 StatusOr<bool> Table::ExpireCold() {
   int64_t rb_bytes = 0;
+  int64_t rb_decoded_bytes = 0;
   {
     absl::MutexLock gen_lock(&generation_lock_);
     absl::MutexLock cold_lock(&cold_lock_);
     if (RingSizeUnlocked() == 0) {
       return false;
     }
-    cold_row_ids_.pop_front();
-    if (time_col_idx_ != -1) cold_time_.pop_front();
+    ExpireColdUnlocked(&rb_bytes, &rb_decoded_bytes);
+  }
+  absl::base_internal::SpinLockHolder lock(&stats_lock_);
+  cold_bytes_ -= rb_bytes;
+  cold_decoded_bytes_ -= rb_decoded_bytes;
+  return true;
+}
 
-    for (size_t col_idx = 0; col_idx < rel_.NumColumns(); col_idx++) {
-#define TYPE_CASE(_dt_) \
-  rb_bytes += types::GetArrowArrayBytes<_dt_>(cold_column_buffers_[col_idx][ring_front_idx_].get());
-      PL_SWITCH_FOREACH_DATATYPE(rel_.GetColumnType(col_idx), TYPE_CASE);
-#undef TYPE_CASE
-      cold_column_buffers_[col_idx][ring_front_idx_].reset();
-    }
-    if (ring_front_idx_ == ring_back_idx_) {
-      // The batch we are expiring is the last batch in the ring buffer, so we reset the indices.
-      ring_front_idx_ = 0;
-      ring_back_idx_ = -1;
-    } else {
-      ring_front_idx_ = (ring_front_idx_ + 1) % ring_capacity_;
+int64_t Table::ExpireColdBucket() {
+  int64_t num_expired = 0;
+  int64_t rb_bytes = 0;
+  int64_t rb_decoded_bytes = 0;
+  {
+    absl::MutexLock gen_lock(&generation_lock_);
+    absl::MutexLock cold_lock(&cold_lock_);
+    if (RingSizeUnlocked() == 0) {
+      return 0;
     }
-    generation_++;
+    // A batch is in the bucket of its first row.
+    int64_t bucket = cold_time_.front().first / expiry_bucket_ns_;
+    do {
+      ExpireColdUnlocked(&rb_bytes, &rb_decoded_bytes);
+      num_expired++;
+    } while (RingSizeUnlocked() > 0 && cold_time_.front().first / expiry_bucket_ns_ == bucket);
   }
   absl::base_internal::SpinLockHolder lock(&stats_lock_);
   cold_bytes_ -= rb_bytes;
-  return true;
+  cold_decoded_bytes_ -= rb_decoded_bytes;
+  return num_expired;
 }
 
 Status Table::ExpireHot() {
@@ -500,7 +1218,7 @@ Status Table::ExpireHot() {
   }
   int64_t rb_bytes = 0;
   if (std::holds_alternative<RecordBatchWithCache>(record_or_row_batch)) {
-    auto record_batch = std::move(std::get<RecordBatchWithCache>(record_or_row_batch));
+    const auto& record_batch = std::get<RecordBatchWithCache>(record_or_row_batch);
     for (const auto& col : *record_batch.record_batch) {
       rb_bytes += col->Bytes();
     }
@@ -516,9 +1234,24 @@ Status Table::ExpireHot() {
     absl::base_internal::SpinLockHolder lock(&stats_lock_);
     hot_bytes_ -= rb_bytes;
   }
+  RecycleHotBatch(&record_or_row_batch);
   return Status::OK();
 }
 
+void Table::RecycleHotBatch(RecordOrRowBatch* batch) {
+  auto* record_batch_ptr = std::get_if<RecordBatchWithCache>(batch);
+  if (record_batch_ptr == nullptr || record_batch_ptr->record_batch == nullptr) {
+    return;
+  }
+  // Cached arrays may reference the columns (see ColumnWrapper::AdoptToArrow). The pool only
+  // takes the columns that nothing else references anymore.
+  record_batch_ptr->arrow_cache.clear();
+  record_batch_ptr->cache_validity.clear();
+  for (auto& col : *record_batch_ptr->record_batch) {
+    types::ColumnWrapperPool::Global()->Release(std::move(col));
+  }
+}
+
 Status Table::ExpireBatch() {
   PL_ASSIGN_OR_RETURN(auto expired_cold, ExpireCold());
   if (expired_cold) {
@@ -530,41 +1263,70 @@ Status Table::ExpireBatch() {
 }
 
 Status Table::AddBatchSliceToRowBatch(const BatchSlice& slice, const std::vector<int64_t>& cols,
+                                      const std::vector<bool>& defer_cols,
                                       schema::RowBatch* output_rb,
                                       arrow::MemoryPool* mem_pool) const {
   absl::MutexLock gen_lock(&generation_lock_);
   PL_RETURN_IF_ERROR(UpdateSliceUnlocked(slice));
   // After this point, as long as gen_lock is held, the unsafe properties of slice are valid.
+  if (slice.unsafe_is_spilled) {
+    PL_ASSIGN_OR_RETURN(auto spilled_rb, spill_store_->Read(slice.unsafe_batch_index));
+    for (auto col_idx : cols) {
+      PL_RETURN_IF_ERROR(output_rb->AddColumn(spilled_rb->ColumnAt(col_idx)->Slice(
+          slice.unsafe_row_start, slice.unsafe_row_end + 1 - slice.unsafe_row_start)));
+    }
+    return Status::OK();
+  }
   if (!slice.unsafe_is_hot) {
     absl::MutexLock cold_lock(&cold_lock_);
+    auto length = slice.unsafe_row_end + 1 - slice.unsafe_row_start;
     for (auto col_idx : cols) {
-      auto arr = cold_column_buffers_[col_idx][slice.unsafe_batch_index]->Slice(
-          slice.unsafe_row_start, slice.unsafe_row_end + 1 - slice.unsafe_row_start);
+      if (cold_encoding_enabled_) {
+        const auto& encoded_col = cold_encoded_buffers_[col_idx][slice.unsafe_batch_index];
+        if (encoded_col != nullptr) {
+          // Encoded columns are only decoded once the consumer accesses them.
+          PL_RETURN_IF_ERROR(output_rb->AddDeferredColumn(std::make_shared<DeferredEncodedColumn>(
+              encoded_col, slice.unsafe_row_start, length, mem_pool)));
+          continue;
+        }
+      }
+      auto arr =
+          cold_column_buffers_[col_idx][slice.unsafe_batch_index]->Slice(slice.unsafe_row_start,
+                                                                         length);
       PL_RETURN_IF_ERROR(output_rb->AddColumn(arr));
     }
     return Status::OK();
   }
 
-  absl::MutexLock hot_lock(&hot_lock_);
-  if (std::holds_alternative<RecordBatchWithCache>(hot_batches_[slice.unsafe_batch_index])) {
-    auto record_batch_ptr =
-        std::get_if<RecordBatchWithCache>(&hot_batches_[slice.unsafe_batch_index]);
-    for (auto col_idx : cols) {
+  // The batch is read without holding hot_lock_, so that writers don't wait on arrow conversion.
+  const RecordOrRowBatch* hot_batch = HotBatch(slice.unsafe_batch_index);
+  if (std::holds_alternative<RecordBatchWithCache>(*hot_batch)) {
+    auto record_batch_ptr = std::get_if<RecordBatchWithCache>(hot_batch);
+    for (const auto& [i, col_idx] : Enumerate(cols)) {
       if (record_batch_ptr->cache_validity[col_idx]) {
         auto arr = record_batch_ptr->arrow_cache[col_idx]->Slice(
             slice.unsafe_row_start, slice.unsafe_row_end + 1 - slice.unsafe_row_start);
         PL_RETURN_IF_ERROR(output_rb->AddColumn(arr));
         continue;
       }
+      if (i < defer_cols.size() && defer_cols[i]) {
+        // The column wrapper is shared, so the deferred column stays valid even if this batch is
+        // compacted or expired before the consumer gets to it.
+        PL_RETURN_IF_ERROR(output_rb->AddDeferredColumn(std::make_shared<DeferredHotColumn>(
+            record_batch_ptr->record_batch->at(col_idx), slice.unsafe_row_start,
+            slice.unsafe_row_end + 1 - slice.unsafe_row_start, mem_pool)));
+        continue;
+      }
       // Arrow array wasn't in cache, Convert to arrow and then add to cache.
-      auto arr = record_batch_ptr->record_batch->at(col_idx)->ConvertToArrow(mem_pool);
+      auto arr =
+          types::ColumnWrapper::AdoptToArrow(record_batch_ptr->record_batch->at(col_idx), mem_pool);
       record_batch_ptr->arrow_cache[col_idx] = arr;
       record_batch_ptr->cache_validity[col_idx] = true;
       PL_RETURN_IF_ERROR(output_rb->AddColumn(
           arr->Slice(slice.unsafe_row_start, slice.unsafe_row_end + 1 - slice.unsafe_row_start)));
     }
   } else {
-    const auto& row_batch = std::get<schema::RowBatch>(hot_batches_[slice.unsafe_batch_index]);
+    const auto& row_batch = std::get<schema::RowBatch>(*hot_batch);
     for (auto col_idx : cols) {
       auto arr = row_batch.ColumnAt(col_idx)->Slice(
           slice.unsafe_row_start, slice.unsafe_row_end + 1 - slice.unsafe_row_start);
@@ -574,6 +1336,29 @@ Status Table::AddBatchSliceToRowBatch(const BatchSlice& slice, const std::vector
   return Status::OK();
 }
 
+bool Table::SliceMayMatch(const BatchSlice& slice,
+                          const std::vector<ZoneMapPredicate>& preds) const {
+  if (preds.empty() || !slice.IsValid()) {
+    return true;
+  }
+  // The zone maps only know about the strings as written, not about the ones they resolve to.
+  for (const auto& pred : preds) {
+    if (pred.col_idx == dictionary_value_col_idx_) {
+      return true;
+    }
+  }
+  absl::MutexLock gen_lock(&generation_lock_);
+  if (!UpdateSliceUnlocked(slice).ok() || slice.unsafe_is_hot || slice.unsafe_is_spilled) {
+    return true;
+  }
+  absl::MutexLock cold_lock(&cold_lock_);
+  auto index = RingVectorIndexUnlocked(slice.unsafe_batch_index);
+  if (index >= static_cast<int64_t>(cold_zone_maps_.size())) {
+    return true;
+  }
+  return cold_zone_maps_[index].MayMatchAll(preds);
+}
+
 int64_t Table::NumBatches() const {
   absl::MutexLock gen_lock(&generation_lock_);
   absl::MutexLock cold_lock(&cold_lock_);
@@ -583,6 +1368,14 @@ int64_t Table::NumBatches() const {
 
 BatchSlice Table::FirstBatch() const {
   absl::MutexLock gen_lock(&generation_lock_);
+  if (spill_store_ != nullptr && spill_store_->NumBatches() > 0) {
+    return BatchSlice::Spilled(0, 0, spill_store_->BatchLength(0) - 1, generation_,
+                               spill_store_->row_ids().front());
+  }
+  return FirstInMemoryBatchUnlocked();
+}
+
+BatchSlice Table::FirstInMemoryBatchUnlocked() const {
   {
     absl::MutexLock cold_lock(&cold_lock_);
     if (ring_back_idx_ != -1) {
@@ -616,6 +1409,22 @@ BatchSlice Table::NextBatchWithoutStop(const BatchSlice& slice) const {
   if (!status.ok()) {
     return BatchSlice::Invalid();
   }
+  if (slice.unsafe_is_spilled) {
+    auto batch_length = spill_store_->BatchLength(slice.unsafe_batch_index);
+    if (slice.unsafe_row_end < batch_length - 1) {
+      auto new_batch_size = batch_length - slice.unsafe_row_end;
+      return BatchSlice::Spilled(slice.unsafe_batch_index, slice.unsafe_row_end + 1,
+                                 batch_length - 1, generation_, slice.uniq_row_end_idx + 1,
+                                 slice.uniq_row_end_idx + new_batch_size - 1);
+    }
+    auto next_index = slice.unsafe_batch_index + 1;
+    if (next_index < spill_store_->NumBatches()) {
+      return BatchSlice::Spilled(next_index, 0, spill_store_->BatchLength(next_index) - 1,
+                                 generation_, spill_store_->row_ids()[next_index]);
+    }
+    // This is the last spilled batch, so continue with the batches in memory.
+    return FirstInMemoryBatchUnlocked();
+  }
   if (!slice.unsafe_is_hot) {
     absl::MutexLock cold_lock(&cold_lock_);
     auto batch_length = ColdBatchLengthUnlocked(slice.unsafe_batch_index);
@@ -662,7 +1471,7 @@ BatchSlice Table::NextBatchWithoutStop(const BatchSlice& slice) const {
   return BatchSlice::Hot(next_index, 0, next_length - 1, generation_, hot_row_ids_[next_index]);
 }
 
-int64_t Table::FindStopTime(int64_t time, arrow::MemoryPool* mem_pool) const {
+int64_t Table::FindStopTime(int64_t time) const {
   absl::MutexLock gen_lock(&generation_lock_);
   {
     absl::MutexLock hot_lock(&hot_lock_);
@@ -671,37 +1480,89 @@ int64_t Table::FindStopTime(int64_t time, arrow::MemoryPool* mem_pool) const {
     if (it != hot_time_.begin()) {
       it--;
       auto index = std::distance(hot_time_.begin(), it);
-      ArrowArrayPtr time_col;
-      if (std::holds_alternative<RecordBatchWithCache>(hot_batches_[index])) {
-        auto record_batch_ptr = std::get_if<RecordBatchWithCache>(&hot_batches_[index]);
-        time_col = GetHotColumnUnlocked(record_batch_ptr, time_col_idx_, mem_pool);
-      } else {
-        auto row_batch = std::get<schema::RowBatch>(hot_batches_[index]);
-        time_col = row_batch.columns().at(time_col_idx_);
-      }
-      auto row_offset =
-          types::SearchArrowArrayLessThanOrEqual<types::DataType::TIME64NS>(time_col.get(), time);
-      return hot_row_ids_[index].first + row_offset;
+      auto [times, num_times] = HotTimesUnlocked(index);
+      return hot_row_ids_[index].first + SearchTimesLessThanOrEqual(times, num_times, time);
     }
   }
-  absl::MutexLock cold_lock(&cold_lock_);
-  auto it =
-      std::upper_bound(cold_time_.begin(), cold_time_.end(), time, IntervalComparatorUpperBound);
-  if (it == cold_time_.begin()) {
+  {
+    absl::MutexLock cold_lock(&cold_lock_);
+    auto it =
+        std::upper_bound(cold_time_.begin(), cold_time_.end(), time, IntervalComparatorUpperBound);
+    if (it != cold_time_.begin()) {
+      it--;
+      auto index = it - cold_time_.begin();
+      auto ring_index = RingIndexUnlocked(index);
+      return cold_row_ids_[index].first + ColdTimeLessThanOrEqualUnlocked(ring_index, time);
+    }
+  }
+  if (spill_store_ == nullptr) {
+    return -1;
+  }
+  const auto& spilled_times = spill_store_->times();
+  auto it = std::upper_bound(spilled_times.begin(), spilled_times.end(), time,
+                             IntervalComparatorUpperBound);
+  if (it == spilled_times.begin()) {
     return -1;
   }
   it--;
-  auto index = it - cold_time_.begin();
-  auto ring_index = RingIndexUnlocked(index);
-  auto time_col = cold_column_buffers_[time_col_idx_][ring_index];
-  auto row_offset =
-      types::SearchArrowArrayLessThanOrEqual<types::DataType::TIME64NS>(time_col.get(), time);
-  return cold_row_ids_[index].first + row_offset;
+  auto index = it - spilled_times.begin();
+  auto time_col_or_s = SpilledTimeColumnUnlocked(index);
+  if (!time_col_or_s.ok()) {
+    LOG(ERROR) << absl::Substitute("Failed to read spilled batch: $0", time_col_or_s.msg());
+    // Stop before the batch we couldn't read.
+    return spill_store_->row_ids()[index].first - 1;
+  }
+  auto row_offset = types::SearchArrowArrayLessThanOrEqual<types::DataType::TIME64NS>(
+      time_col_or_s.ValueOrDie().get(), time);
+  return spill_store_->row_ids()[index].first + row_offset;
 }
 
 int64_t Table::ColdBatchLengthUnlocked(int64_t index) const {
+  if (cold_encoding_enabled_ && cold_encoded_buffers_[0].at(index) != nullptr) {
+    return cold_encoded_buffers_[0][index]->length();
+  }
   return cold_column_buffers_[0].at(index)->length();
 }
+
+Table::ArrowArrayPtr Table::ColdColumnUnlocked(int64_t col_idx, int64_t ring_index,
+                                               arrow::MemoryPool* mem_pool) const {
+  if (cold_encoding_enabled_ && cold_encoded_buffers_[col_idx][ring_index] != nullptr) {
+    return cold_encoded_buffers_[col_idx][ring_index]->Decode(mem_pool);
+  }
+  return cold_column_buffers_[col_idx][ring_index];
+}
+int64_t Table::ColdTimeGreaterThanOrEqualUnlocked(int64_t ring_index, int64_t time) const {
+  if (cold_encoding_enabled_ && cold_encoded_buffers_[time_col_idx_][ring_index] != nullptr) {
+    return cold_encoded_buffers_[time_col_idx_][ring_index]->SearchGreaterThanOrEqual(time);
+  }
+  const auto* time_col = static_cast<const arrow::Int64Array*>(
+      cold_column_buffers_[time_col_idx_][ring_index].get());
+  return SearchTimesGreaterThanOrEqual(time_col->raw_values(), time_col->length(), time);
+}
+
+int64_t Table::ColdTimeLessThanOrEqualUnlocked(int64_t ring_index, int64_t time) const {
+  if (cold_encoding_enabled_ && cold_encoded_buffers_[time_col_idx_][ring_index] != nullptr) {
+    return cold_encoded_buffers_[time_col_idx_][ring_index]->SearchLessThanOrEqual(time);
+  }
+  const auto* time_col = static_cast<const arrow::Int64Array*>(
+      cold_column_buffers_[time_col_idx_][ring_index].get());
+  return SearchTimesLessThanOrEqual(time_col->raw_values(), time_col->length(), time);
+}
+
+std::pair<const int64_t*, int64_t> Table::HotTimesUnlocked(int64_t index) const {
+  if (std::holds_alternative<RecordBatchWithCache>(hot_batches_[index])) {
+    const auto& col = std::get<RecordBatchWithCache>(hot_batches_[index])
+                          .record_batch->at(time_col_idx_);
+    // Time64NSValue has the memory layout of an int64_t, which AdoptToArrow relies on as well.
+    const auto* values =
+        static_cast<const types::Time64NSValueColumnWrapper*>(col.get())->UnsafeRawData();
+    return {reinterpret_cast<const int64_t*>(values), static_cast<int64_t>(col->Size())};
+  }
+  const auto& time_col = std::get<schema::RowBatch>(hot_batches_[index]).ColumnAt(time_col_idx_);
+  const auto* time_arr = static_cast<const arrow::Int64Array*>(time_col.get());
+  return {time_arr->raw_values(), time_arr->length()};
+}
+
 int64_t Table::HotBatchLengthUnlocked(int64_t index) const {
   if (std::holds_alternative<RecordBatchWithCache>(hot_batches_[index])) {
     auto record_batch_ptr = std::get_if<RecordBatchWithCache>(&hot_batches_[index]);
@@ -712,18 +1573,6 @@ int64_t Table::HotBatchLengthUnlocked(int64_t index) const {
   }
 }
 
-Table::ArrowArrayPtr Table::GetHotColumnUnlocked(const RecordBatchWithCache* record_batch_ptr,
-                                                 int64_t col_idx,
-                                                 arrow::MemoryPool* mem_pool) const {
-  if (record_batch_ptr->cache_validity[col_idx]) {
-    return record_batch_ptr->arrow_cache[col_idx];
-  }
-  auto arrow_array_sptr = record_batch_ptr->record_batch->at(col_idx)->ConvertToArrow(mem_pool);
-  record_batch_ptr->arrow_cache[col_idx] = arrow_array_sptr;
-  record_batch_ptr->cache_validity[col_idx] = true;
-  return arrow_array_sptr;
-}
-
 BatchSlice Table::SliceIfPastStop(const BatchSlice& slice, int64_t stop_row_id) const {
   if (!slice.IsValid()) {
     return slice;
@@ -790,6 +1639,26 @@ Status Table::UpdateSliceUnlocked(const BatchSlice& slice) const {
   if (slice.generation == generation_) {
     return Status::OK();
   }
+  if (spill_store_ != nullptr) {
+    const auto& spilled_row_ids = spill_store_->row_ids();
+    auto it = std::lower_bound(spilled_row_ids.begin(), spilled_row_ids.end(),
+                               slice.uniq_row_start_idx, IntervalComparatorLowerBound);
+    if (it != spilled_row_ids.end()) {
+      if (slice.uniq_row_end_idx < it->first) {
+        // All data in this slice has been evicted from the spill store.
+        return error::InvalidArgument(
+            "Requested RowBatch Slice has already been expired from the table");
+      }
+      slice.unsafe_is_hot = false;
+      slice.unsafe_is_spilled = true;
+      slice.unsafe_batch_index = std::distance(spilled_row_ids.begin(), it);
+      slice.unsafe_row_start = slice.uniq_row_start_idx - it->first;
+      slice.unsafe_row_end = slice.uniq_row_end_idx - it->first;
+      slice.generation = generation_;
+      return Status::OK();
+    }
+  }
+  slice.unsafe_is_spilled = false;
   {
     absl::MutexLock cold_lock(&cold_lock_);
     auto it = std::lower_bound(cold_row_ids_.begin(), cold_row_ids_.end(), slice.uniq_row_start_idx,
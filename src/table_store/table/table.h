@@ -25,12 +25,14 @@
 #include <deque>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include <absl/base/internal/spinlock.h>
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_format.h>
 #include "src/common/base/base.h"
 #include "src/shared/types/column_wrapper.h"
@@ -39,8 +41,21 @@
 #include "src/table_store/schema/row_batch.h"
 #include "src/table_store/schema/row_descriptor.h"
 #include "src/table_store/schemapb/schema.pb.h"
+#include "src/table_store/table/cold_arena.h"
+#include "src/table_store/table/column_encoding.h"
+#include "src/table_store/table/memory_budget.h"
+#include "src/table_store/table/shared_scan_cache.h"
+#include "src/table_store/table/spill_store.h"
+#include "src/table_store/table/zone_map.h"
 
 DECLARE_int32(table_store_table_size_limit);
+DECLARE_bool(table_store_cold_zone_maps);
+DECLARE_bool(table_store_cold_encoding);
+DECLARE_string(table_store_spill_dir);
+DECLARE_int64(table_store_spill_size_limit);
+DECLARE_int64(table_store_shared_scan_cache_bytes);
+DECLARE_int64(table_store_expiry_bucket_ns);
+DECLARE_bool(table_store_cold_arena);
 
 namespace px {
 namespace table_store {
@@ -50,11 +65,43 @@ using RecordBatchSPtr = std::shared_ptr<arrow::RecordBatch>;
 struct TableStats {
   int64_t bytes;
   int64_t cold_bytes;
+  // The size cold storage would have without encoding. Equal to cold_bytes unless
+  // --table_store_cold_encoding is set.
+  int64_t cold_decoded_bytes;
+  // cold_decoded_bytes / cold_bytes, or 1 if there are no cold batches.
+  double cold_compression_ratio;
   int64_t num_batches;
+  // The number of batches, and their bytes, waiting to be compacted into cold storage.
+  int64_t num_hot_batches;
+  int64_t hot_bytes;
   int64_t batches_added;
   int64_t batches_expired;
   int64_t compacted_batches;
+  // How long the last CompactHotToCold call that compacted anything took.
+  int64_t compaction_latency_ns;
+  // Batches expired from cold storage into the on-disk spill tier, if --table_store_spill_dir is
+  // set. Not counted in bytes or num_batches.
+  int64_t spilled_batches;
+  int64_t spilled_bytes;
+  // Expired batches that were dropped instead of spilled, because the spill store failed or its
+  // write queue was full.
+  int64_t spill_dropped_batches;
+  // Columns that scans read from the shared scan cache instead of converting them again.
+  int64_t shared_scan_hits;
+  int64_t shared_scan_misses;
+  // With --table_store_cold_arena, the bytes of huge page slabs mapped for cold batches, and the
+  // bytes of those slabs that the batches' buffers use. 0 without it.
+  int64_t cold_arena_reserved_bytes;
+  int64_t cold_arena_used_bytes;
   int64_t max_table_size;
+  // The rows in hot and cold storage, and the fewest and most rows of any of their batches.
+  int64_t num_rows;
+  int64_t min_batch_rows;
+  int64_t max_batch_rows;
+  // The times of the oldest and newest rows in hot and cold storage, or -1 if the table has no
+  // time column or no rows. Their difference is how far back the table currently reaches.
+  int64_t min_time;
+  int64_t max_time;
 };
 
 struct BatchSlice {
@@ -68,6 +115,9 @@ struct BatchSlice {
   mutable int64_t generation = -1;
   int64_t uniq_row_start_idx = -1;
   int64_t uniq_row_end_idx = -1;
+  // Set if the slice is in the on-disk spill tier, in which case unsafe_batch_index is an index
+  // into the spill store.
+  mutable bool unsafe_is_spilled = false;
 
   int64_t Size() const { return uniq_row_end_idx - uniq_row_start_idx + 1; }
   bool IsValid() const { return uniq_row_start_idx != -1 && uniq_row_end_idx != -1; }
@@ -92,6 +142,16 @@ struct BatchSlice {
     return BatchSlice{true,       hot_index,          row_start,       row_end,
                       generation, uniq_row_start_idx, uniq_row_end_idx};
   }
+  static BatchSlice Spilled(int64_t spill_index, int64_t row_start, int64_t row_end,
+                            int64_t generation, std::pair<int64_t, int64_t> row_ids) {
+    return Spilled(spill_index, row_start, row_end, generation, row_ids.first, row_ids.second);
+  }
+  static BatchSlice Spilled(int64_t spill_index, int64_t row_start, int64_t row_end,
+                            int64_t generation, int64_t uniq_row_start_idx,
+                            int64_t uniq_row_end_idx) {
+    return BatchSlice{false,      spill_index,        row_start,        row_end,
+                      generation, uniq_row_start_idx, uniq_row_end_idx, true};
+  }
 };
 
 class ArrowArrayCompactor {
@@ -175,6 +235,7 @@ class Table : public NotCopyable {
   using RecordBatchPtr = std::unique_ptr<px::types::ColumnWrapperRecordBatch>;
   using ArrowArrayPtr = std::shared_ptr<arrow::Array>;
   using ColumnBuffer = std::vector<ArrowArrayPtr>;
+  using EncodedColumnBuffer = std::vector<std::shared_ptr<const EncodedColumn>>;
   using TimeInterval = std::pair<int64_t, int64_t>;
   using RowIDInterval = std::pair<int64_t, int64_t>;
 
@@ -189,6 +250,9 @@ class Table : public NotCopyable {
   using RecordOrRowBatch = std::variant<RecordBatchWithCache, schema::RowBatch>;
 
   static inline constexpr int64_t kDefaultColdBatchMinSize = 64 * 1024;
+  // Encoded cold batches can be much smaller than min_cold_batch_size_, so the ring buffer gets
+  // this many times more slots when cold encoding is enabled.
+  static inline constexpr int64_t kMaxColdCompressionRatio = 8;
 
  public:
   static inline constexpr int64_t kMaxBatchesPerCompactionCall = 256;
@@ -210,6 +274,29 @@ class Table : public NotCopyable {
       : Table(relation, max_table_size, kDefaultColdBatchMinSize) {}
 
   Table(const schema::Relation& relation, size_t max_table_size, size_t min_cold_batch_size);
+  ~Table();
+
+  /**
+   * Makes the table share the memory budget with the other tables of the budget, on top of its
+   * own size limit. Must be called before anything is written to the table.
+   */
+  void SetMemoryBudget(std::shared_ptr<MemoryBudget> memory_budget, TableBudget table_budget);
+
+  /**
+   * @return the bytes in hot and cold storage, like GetTableStats().bytes but cheaper.
+   */
+  int64_t Bytes() const;
+
+  /**
+   * @return the time between the oldest and newest rows in hot and cold storage, or -1 if the
+   * table has no time column or no rows.
+   */
+  int64_t RetentionNS() const;
+
+  /**
+   * Expires the oldest batch of the table, for the memory budget.
+   */
+  Status ExpireOldestBatch();
 
   /**
    * Get a RowBatch of data corresponding to the passed in BatchSlice.
@@ -222,6 +309,33 @@ class Table : public NotCopyable {
                                                                const std::vector<int64_t>& cols,
                                                                arrow::MemoryPool* mem_pool) const;
 
+  /**
+   * Same as above, except that columns with defer_cols[i] set (i indexes into cols) are returned
+   * as deferred columns when the slice is in hot storage and the column hasn't been converted to
+   * arrow yet. Deferred columns are only converted when the consumer accesses them.
+   */
+  StatusOr<std::unique_ptr<schema::RowBatch>> GetRowBatchSlice(
+      const BatchSlice& slice, const std::vector<int64_t>& cols,
+      const std::vector<bool>& defer_cols, arrow::MemoryPool* mem_pool) const;
+
+  /**
+   * Same as above, except that the columns are shared through the table's shared scan cache with
+   * other scans of the same rows, so that concurrent queries over the same time range convert
+   * each batch only once. Columns that are already cached are never deferred.
+   */
+  StatusOr<std::unique_ptr<schema::RowBatch>> GetSharedRowBatchSlice(
+      const BatchSlice& slice, const std::vector<int64_t>& cols,
+      const std::vector<bool>& defer_cols, arrow::MemoryPool* mem_pool) const;
+
+  /**
+   * Checks the slice against the zone map of its batch. Only cold batches have zone maps.
+   * @param slice the BatchSlice to check.
+   * @param preds the predicates, all of which a row has to satisfy.
+   * @return false if the slice is in cold storage and none of its rows can satisfy all of the
+   * predicates, true otherwise.
+   */
+  bool SliceMayMatch(const BatchSlice& slice, const std::vector<ZoneMapPredicate>& preds) const;
+
   /**
    * Writes a row batch to the table.
    * @param rb Rowbatch to write to the table.
@@ -236,25 +350,33 @@ class Table : public NotCopyable {
    */
   Status TransferRecordBatch(std::unique_ptr<px::types::ColumnWrapperRecordBatch> record_batch);
 
+  /**
+   * Makes the table resolve empty strings in value_col through a dictionary keyed by the INT64
+   * key_col: writers only have to fill in value_col the first time they write a key (and whenever
+   * they want to refresh it), and reads return the last value written for the key instead of the
+   * empty string. A key's value is kept for as long as any row with that key is in the table.
+   * Must be called before anything is written to the table.
+   */
+  Status EnableStringDictionary(std::string_view key_col, std::string_view value_col);
+
   schema::Relation GetRelation() const;
   StatusOr<std::vector<RecordBatchSPtr>> GetTableAsRecordBatches() const;
 
   /**
+   * Time searches binary search the batches' time ranges, then the batch's times in place, without
+   * converting or decoding the batch.
    * @param time the timestamp to search for.
-   * @param mem_pool the arrow memory pool.
    * @return the BatchSlice of the first row with timestamp greater than or equal to the given time,
    * until the end of its corresponding row batch.
    */
-  StatusOr<BatchSlice> FindBatchSliceGreaterThanOrEqual(int64_t time,
-                                                        arrow::MemoryPool* mem_pool) const;
+  StatusOr<BatchSlice> FindBatchSliceGreaterThanOrEqual(int64_t time) const;
 
   /**
    * @param time the timestamp to search for.
-   * @param mem_pool the arrow memory pool.
    * @return the BatchSlice of the last row with timestamp less than or equal to the given time,
    * until the end of its corresponding row batch.
    */
-  StatusOr<StopPosition> FindStopPositionForTime(int64_t time, arrow::MemoryPool* mem_pool) const;
+  StatusOr<StopPosition> FindStopPositionForTime(int64_t time) const;
 
   /**
    * Covert the table and store in passed in proto.
@@ -303,10 +425,18 @@ class Table : public NotCopyable {
   /**
    * Compacts hot batches into min_cold_batch_size_ sized cold batches. Each call to
    * CompactHotToCold will create a maximum of kMaxBatchesPerCompactionCall cold batches.
+   * It then writes the batches that were expired since the last call to the spill store, if
+   * spilling is enabled.
    * @param mem_pool arrow MemoryPool to be used for creating new cold batches.
    */
   Status CompactHotToCold(arrow::MemoryPool* mem_pool);
 
+  /**
+   * @return the hot bytes of the table divided by the number of bytes a single CompactHotToCold
+   * call can move into cold storage. Above 1, the table can't catch up in one compaction call.
+   */
+  double HotBudgetRatio() const;
+
  private:
   Status ExpireRowBatches(int64_t row_batch_size);
 
@@ -315,17 +445,32 @@ class Table : public NotCopyable {
   mutable absl::base_internal::SpinLock stats_lock_;
   int64_t batches_expired_ ABSL_GUARDED_BY(stats_lock_) = 0;
   int64_t cold_bytes_ ABSL_GUARDED_BY(stats_lock_) = 0;
+  int64_t cold_decoded_bytes_ ABSL_GUARDED_BY(stats_lock_) = 0;
   int64_t hot_bytes_ ABSL_GUARDED_BY(stats_lock_) = 0;
   int64_t batches_added_ ABSL_GUARDED_BY(stats_lock_) = 0;
   int64_t compacted_batches_ ABSL_GUARDED_BY(stats_lock_) = 0;
+  int64_t compaction_latency_ns_ ABSL_GUARDED_BY(stats_lock_) = 0;
   int64_t max_table_size_ = 0;
   int64_t min_cold_batch_size_;
-
+  // Null unless the table shares a memory budget with other tables.
+  std::shared_ptr<MemoryBudget> memory_budget_;
+  const bool zone_maps_enabled_;
+  const bool cold_encoding_enabled_;
+  // 0 unless cold batches are expired a time bucket at a time.
+  const int64_t expiry_bucket_ns_;
+
+  // hot_lock_ only protects the structure of the hot deques. Writers only ever append to the back
+  // of hot_batches_, and everything that removes hot batches or touches their arrow caches holds
+  // generation_lock_, so with generation_lock_ held a hot batch can be read without hot_lock_ (see
+  // HotBatch). This keeps appends from waiting on arrow conversion in readers and compaction.
   mutable absl::Mutex hot_lock_;
   std::deque<RecordOrRowBatch> hot_batches_ ABSL_GUARDED_BY(hot_lock_);
 
   mutable absl::Mutex cold_lock_;
   std::vector<ColumnBuffer> cold_column_buffers_ ABSL_GUARDED_BY(cold_lock_);
+  // Indexed like cold_column_buffers_. Only populated if cold_encoding_enabled_, in which case the
+  // cold_column_buffers_ entry of every encoded column is null.
+  std::vector<EncodedColumnBuffer> cold_encoded_buffers_ ABSL_GUARDED_BY(cold_lock_);
 
   // The generation lock must be held during compaction and
   // expiration, and anytime one would like to access the unsafe_ attributes of BatchSlice.
@@ -346,33 +491,84 @@ class Table : public NotCopyable {
   std::deque<TimeInterval> hot_time_ ABSL_GUARDED_BY(hot_lock_);
   std::deque<RowIDInterval> cold_row_ids_ ABSL_GUARDED_BY(cold_lock_);
   std::deque<TimeInterval> cold_time_ ABSL_GUARDED_BY(cold_lock_);
+  // Zone maps of the cold batches, indexed like cold_row_ids_. Only kept if zone_maps_enabled_.
+  std::deque<ZoneMap> cold_zone_maps_ ABSL_GUARDED_BY(cold_lock_);
+
+  // The on-disk tier that batches expired from cold storage are written to, or null if spilling is
+  // disabled. Spilled batches come before all cold batches.
+  std::unique_ptr<SpillStore> spill_store_ ABSL_PT_GUARDED_BY(generation_lock_);
+  int64_t spill_dropped_batches_ ABSL_GUARDED_BY(generation_lock_) = 0;
+  // Serializes FlushSpill calls, since the spill store can only have one write in flight.
+  absl::Mutex spill_flush_lock_;
+
+  // Disabled if --table_store_shared_scan_cache_bytes is 0.
+  mutable SharedScanCache shared_scans_;
+  // The pool of the cold batches' buffers, if --table_store_cold_arena is set.
+  ColdArena* cold_arena_ = nullptr;
 
   int64_t time_col_idx_ = -1;
 
-  Status WriteHot(RecordBatchPtr record_batch);
-  Status WriteHot(const schema::RowBatch& rb);
+  // last_row_id is set to the unique identifier of the last row written.
+  Status WriteHot(RecordBatchPtr record_batch, int64_t* last_row_id);
+  Status WriteHot(const schema::RowBatch& rb, int64_t* last_row_id);
   Status UpdateTimeRowIndices(const schema::RowBatch& rb) ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_lock_);
   Status UpdateTimeRowIndices(types::ColumnWrapperRecordBatch* record_batch)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_lock_);
 
   Status ExpireBatch();
   Status ExpireHot();
+  // Returns the columns of a hot batch that has been removed from hot storage to the column
+  // wrapper pool, for Stirling to fill again.
+  static void RecycleHotBatch(RecordOrRowBatch* batch);
   StatusOr<bool> ExpireCold();
+  // Expires the cold batches whose first row is in the same expiry bucket as the first row of the
+  // oldest cold batch, under a single hold of the locks. Returns the number of batches expired.
+  int64_t ExpireColdBucket();
+  // Expires the oldest cold batch and adds its encoded and decoded sizes to bytes and
+  // decoded_bytes. The ring buffer must not be empty.
+  void ExpireColdUnlocked(int64_t* bytes, int64_t* decoded_bytes)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_, cold_lock_);
+  // Queues the oldest cold batch in the spill store, for FlushSpill to write out.
+  Status SpillColdBatchUnlocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_, cold_lock_);
+  // Writes the batches queued in the spill store to disk. Only holds generation_lock_ to update
+  // the spill store's index, not while serializing or writing a batch.
+  Status FlushSpill() ABSL_LOCKS_EXCLUDED(spill_flush_lock_, generation_lock_);
+  StatusOr<ArrowArrayPtr> SpilledTimeColumnUnlocked(int64_t spill_index) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_);
+  // Returns the first batch in memory (cold or hot), or an invalid slice if there are none.
+  BatchSlice FirstInMemoryBatchUnlocked() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_);
   Status CompactSingleBatch(arrow::MemoryPool* mem_pool);
 
   Status AddBatchSliceToRowBatch(const BatchSlice& slice, const std::vector<int64_t>& cols,
-                                 schema::RowBatch* output_rb, arrow::MemoryPool* mem_pool) const;
-  ArrowArrayPtr GetHotColumnUnlocked(const RecordBatchWithCache* record_batch_ptr, int64_t col_idx,
-                                     arrow::MemoryPool* mem_pool) const
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_lock_);
+                                 const std::vector<bool>& defer_cols, schema::RowBatch* output_rb,
+                                 arrow::MemoryPool* mem_pool) const;
 
   int64_t NumBatches() const;
   int64_t ColdBatchLengthUnlocked(int64_t ring_index) const
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
+  // Returns the cold column as an arrow array, decoding it if it's encoded.
+  ArrowArrayPtr ColdColumnUnlocked(int64_t col_idx, int64_t ring_index,
+                                   arrow::MemoryPool* mem_pool) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
   int64_t HotBatchLengthUnlocked(int64_t hot_index) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_lock_);
+  // Returns the hot batch at hot_index. The pointer stays valid for as long as generation_lock_ is
+  // held, since appends to a deque don't invalidate references to its elements.
+  const RecordOrRowBatch* HotBatch(int64_t hot_index) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_) ABSL_LOCKS_EXCLUDED(hot_lock_);
 
   // Returns the unique identifier of the last row less than or equal to the given time.
-  int64_t FindStopTime(int64_t time, arrow::MemoryPool* mem_pool) const;
+  int64_t FindStopTime(int64_t time) const;
+
+  // Return the row of the cold batch with the first time greater than or equal to time, or the
+  // last time less than or equal to time, or -1 if there is none. Encoded times are only decoded
+  // from the checkpoint closest to the result.
+  int64_t ColdTimeGreaterThanOrEqualUnlocked(int64_t ring_index, int64_t time) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
+  int64_t ColdTimeLessThanOrEqualUnlocked(int64_t ring_index, int64_t time) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cold_lock_);
+  // Returns the times of a hot batch and their number, read in place.
+  std::pair<const int64_t*, int64_t> HotTimesUnlocked(int64_t hot_index) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(hot_lock_);
 
   // Returns the index into cold_row_ids_ or cold_time_ given the ring buffer location.
   int64_t RingVectorIndexUnlocked(int64_t ring_index) const
@@ -387,6 +583,37 @@ class Table : public NotCopyable {
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(generation_lock_);
 
   BatchSlice NextBatchWithoutStop(const BatchSlice& slice) const;
+
+  // The non-empty values of a batch for the string dictionary, and all of the keys it references.
+  struct DictionaryUpdate {
+    absl::flat_hash_map<int64_t, std::string> values;
+    std::vector<int64_t> keys;
+  };
+  DictionaryUpdate CollectDictionaryUpdate(const types::ColumnWrapperRecordBatch& record_batch);
+  DictionaryUpdate CollectDictionaryUpdate(const schema::RowBatch& rb);
+  // Adds the update to the dictionary, and drops the keys that are no longer referenced by any row
+  // in the table.
+  void UpdateDictionary(DictionaryUpdate update, int64_t last_row_id)
+      ABSL_LOCKS_EXCLUDED(dictionary_lock_, generation_lock_);
+  // Returns the dictionary column of the slice, with empty strings replaced by their key's value.
+  StatusOr<ArrowArrayPtr> ResolveDictionaryColumn(const BatchSlice& slice,
+                                                  arrow::MemoryPool* mem_pool) const
+      ABSL_LOCKS_EXCLUDED(dictionary_lock_);
+
+  static inline constexpr size_t kMinDictionaryPruneSize = 1024;
+  struct DictionaryEntry {
+    std::string value;
+    // The unique identifier of the last row written with this key.
+    int64_t last_row_id;
+  };
+  // Both are -1 unless EnableStringDictionary was called.
+  int64_t dictionary_key_col_idx_ = -1;
+  int64_t dictionary_value_col_idx_ = -1;
+  mutable absl::Mutex dictionary_lock_;
+  absl::flat_hash_map<int64_t, DictionaryEntry> dictionary_ ABSL_GUARDED_BY(dictionary_lock_);
+  // Unreferenced keys are dropped once the dictionary grows past this size, which then becomes
+  // twice the size of what's left, so that the cost of dropping keys is amortized over writes.
+  size_t dictionary_prune_size_ ABSL_GUARDED_BY(dictionary_lock_) = kMinDictionaryPruneSize;
 };
 
 }  // namespace table_store
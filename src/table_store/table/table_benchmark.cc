@@ -17,8 +17,11 @@
  */
 
 #include <absl/synchronization/barrier.h>
+#include <absl/synchronization/blocking_counter.h>
 #include <absl/synchronization/notification.h>
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <deque>
 #include <numeric>
@@ -335,6 +338,71 @@ static void BM_TableThreaded(benchmark::State& state) {
   state.counters["Write"] = benchmark::Counter(write_average_time);
 }
 
+// Measures how long writers wait on readers scanning hot batches (which converts them to arrow),
+// with state.range(0) reader threads and state.range(1) writer threads.
+// NOLINTNEXTLINE : runtime/references.
+static void BM_TableHotContention(benchmark::State& state) {
+  int num_read_threads = state.range(0);
+  int num_write_threads = state.range(1);
+  int64_t table_size = 16 * 1024 * 1024;
+  // Large enough that nothing gets compacted, so every batch read is hot.
+  int64_t compaction_size = table_size;
+  int64_t batch_length = 1024;
+  int64_t num_writes_per_thread = 2 * 1024;
+  std::shared_ptr<Table> table_ptr = MakeTable(table_size, compaction_size);
+
+  absl::Notification done;
+  absl::base_internal::SpinLock result_lock;
+  std::vector<double> write_results;
+  std::atomic<int64_t> num_scans = 0;
+  absl::Barrier barrier(num_read_threads + num_write_threads);
+  absl::BlockingCounter writers_done(num_write_threads);
+
+  auto writer_work = [&]() {
+    barrier.Block();
+    for (int64_t i = 0; i < num_writes_per_thread; ++i) {
+      auto batch = MakeHotBatch(batch_length);
+      auto start = std::chrono::high_resolution_clock::now();
+      PL_CHECK_OK(table_ptr->TransferRecordBatch(std::move(batch)));
+      auto end = std::chrono::high_resolution_clock::now();
+      auto elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+      absl::base_internal::SpinLockHolder lock(&result_lock);
+      write_results.push_back(elapsed_seconds.count());
+    }
+    writers_done.DecrementCount();
+  };
+
+  auto reader_work = [&]() {
+    barrier.Block();
+    while (!done.HasBeenNotified()) {
+      ReadFullTable(table_ptr.get());
+      num_scans++;
+    }
+  };
+
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_read_threads; ++i) {
+      threads.emplace_back(reader_work);
+    }
+    for (int i = 0; i < num_write_threads; ++i) {
+      threads.emplace_back(writer_work);
+    }
+    writers_done.Wait();
+    done.Notify();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::sort(write_results.begin(), write_results.end());
+  state.counters["WriteAvg"] = benchmark::Counter(
+      std::accumulate(write_results.begin(), write_results.end(), 0.0) / write_results.size());
+  state.counters["WriteP99"] = benchmark::Counter(write_results[write_results.size() * 99 / 100]);
+  state.counters["WriteMax"] = benchmark::Counter(write_results.back());
+  state.counters["Scans"] = benchmark::Counter(num_scans);
+}
+
 BENCHMARK(BM_TableReadAllHot);
 BENCHMARK(BM_TableReadAllCold);
 BENCHMARK(BM_TableReadLastBatchAllHot)->Iterations(1000);
@@ -343,5 +411,11 @@ BENCHMARK(BM_TableWriteEmpty);
 BENCHMARK(BM_TableWriteFull);
 BENCHMARK(BM_TableCompaction);
 BENCHMARK(BM_TableThreaded)->UseManualTime()->Iterations(1);
+BENCHMARK(BM_TableHotContention)
+    ->Args({0, 1})
+    ->Args({4, 1})
+    ->Args({4, 4})
+    ->Args({8, 2})
+    ->Iterations(1);
 
 }  // namespace px::table_store
@@ -17,6 +17,7 @@
  */
 
 #include <algorithm>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -25,32 +26,78 @@
 namespace px {
 namespace table_store {
 
+TableStore::TableStore() {
+  {
+    absl::MutexLock lock(&registry_lock_);
+    PublishRegistry(std::make_unique<Registry>());
+  }
+  if (FLAGS_table_store_memory_budget_bytes <= 0) {
+    return;
+  }
+  memory_budget_ = std::make_shared<MemoryBudget>(FLAGS_table_store_memory_budget_bytes);
+  auto table_budgets_or_s = MemoryBudget::ParseTableBudgets(FLAGS_table_store_table_budgets);
+  if (table_budgets_or_s.ok()) {
+    table_budgets_ = table_budgets_or_s.ConsumeValueOrDie();
+  } else {
+    LOG(ERROR) << absl::Substitute("Ignoring --table_store_table_budgets: $0",
+                                   table_budgets_or_s.msg());
+  }
+}
+
+void TableStore::AddToMemoryBudget(const std::string& table_name, Table* table) {
+  if (memory_budget_ == nullptr) {
+    return;
+  }
+  auto it = table_budgets_.find(table_name);
+  table->SetMemoryBudget(memory_budget_, it == table_budgets_.end() ? TableBudget{} : it->second);
+}
+
+std::unique_ptr<TableStore::Registry> TableStore::CopyRegistry() const {
+  return std::make_unique<Registry>(*GetRegistry());
+}
+
+void TableStore::PublishRegistry(std::unique_ptr<Registry> registry) {
+  std::atomic_store(&registry_, std::shared_ptr<const Registry>(std::move(registry)));
+}
+
 std::unique_ptr<std::unordered_map<std::string, schema::Relation>> TableStore::GetRelationMap() {
+  auto registry = GetRegistry();
   auto map = std::make_unique<RelationMap>();
-  map->reserve(name_to_relation_map_.size());
-  for (auto& [table_name, relation] : name_to_relation_map_) {
+  map->reserve(registry->name_to_relation_map.size());
+  for (auto& [table_name, relation] : registry->name_to_relation_map) {
     map->emplace(table_name, relation);
   }
   return map;
 }
 
 StatusOr<Table*> TableStore::CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id) {
-  auto id_to_table_info_map_iter = id_to_table_info_map_.find(table_id);
-  if (id_to_table_info_map_iter == id_to_table_info_map_.end()) {
+  absl::MutexLock lock(&registry_lock_);
+  auto current = GetRegistry();
+  // Another thread may have created the tablet since the caller looked it up.
+  auto id_to_table_iter = current->id_to_table_map.find(TableIDTablet{table_id, tablet_id});
+  if (id_to_table_iter != current->id_to_table_map.end()) {
+    return id_to_table_iter->second.get();
+  }
+
+  auto id_to_table_info_map_iter = current->id_to_table_info_map.find(table_id);
+  if (id_to_table_info_map_iter == current->id_to_table_info_map.end()) {
     return error::InvalidArgument("Table_id $0 doesn't exist.", table_id);
   }
 
   const TableInfo& table_info = id_to_table_info_map_iter->second;
   const schema::Relation& relation = table_info.relation;
   std::shared_ptr<Table> new_tablet = Table::Create(relation);
+  AddToMemoryBudget(table_info.table_name, new_tablet.get());
 
+  auto registry = CopyRegistry();
   TableIDTablet id_key = {table_id, tablet_id};
-  id_to_table_map_[id_key] = new_tablet;
+  registry->id_to_table_map[id_key] = new_tablet;
 
   const std::string& table_name = table_info.table_name;
-  DCHECK(relation == name_to_relation_map_.find(table_name)->second);
+  DCHECK(relation == registry->name_to_relation_map.find(table_name)->second);
   NameTablet name_key = {table_name, tablet_id};
-  name_to_table_map_[name_key] = new_tablet;
+  registry->name_to_table_map[name_key] = new_tablet;
+  PublishRegistry(std::move(registry));
   return new_tablet.get();
 }
 
@@ -66,8 +113,9 @@ Status TableStore::AppendData(uint64_t table_id, types::TabletID tablet_id,
 
 table_store::Table* TableStore::GetTable(const std::string& table_name,
                                          const types::TabletID& tablet_id) const {
-  auto name_to_table_iter = name_to_table_map_.find(NameTablet{table_name, tablet_id});
-  if (name_to_table_iter == name_to_table_map_.end()) {
+  auto registry = GetRegistry();
+  auto name_to_table_iter = registry->name_to_table_map.find(NameTablet{table_name, tablet_id});
+  if (name_to_table_iter == registry->name_to_table_map.end()) {
     return nullptr;
   }
   return name_to_table_iter->second.get();
@@ -75,58 +123,67 @@ table_store::Table* TableStore::GetTable(const std::string& table_name,
 
 table_store::Table* TableStore::GetTable(uint64_t table_id,
                                          const types::TabletID& tablet_id) const {
-  auto id_to_table_iter = id_to_table_map_.find(TableIDTablet{table_id, tablet_id});
-  if (id_to_table_iter == id_to_table_map_.end()) {
+  auto registry = GetRegistry();
+  auto id_to_table_iter = registry->id_to_table_map.find(TableIDTablet{table_id, tablet_id});
+  if (id_to_table_iter == registry->id_to_table_map.end()) {
     return nullptr;
   }
   return id_to_table_iter->second.get();
 }
 
-void TableStore::RegisterTableName(const std::string& table_name, const types::TabletID& tablet_id,
+void TableStore::RegisterTableName(Registry* registry, const std::string& table_name,
+                                   const types::TabletID& tablet_id,
                                    const schema::Relation& table_relation,
                                    std::shared_ptr<table_store::Table> table) {
-  auto name_to_relation_map_iter = name_to_relation_map_.find(table_name);
-  if (name_to_relation_map_iter == name_to_relation_map_.end()) {
-    name_to_relation_map_[table_name] = table_relation;
+  auto name_to_relation_map_iter = registry->name_to_relation_map.find(table_name);
+  if (name_to_relation_map_iter == registry->name_to_relation_map.end()) {
+    registry->name_to_relation_map[table_name] = table_relation;
   } else {
     DCHECK_EQ(name_to_relation_map_iter->second, table_relation);
   }
 
   NameTablet key = {table_name, tablet_id};
-  name_to_table_map_[key] = table;
+  registry->name_to_table_map[key] = table;
 }
 
-void TableStore::RegisterTableID(uint64_t table_id, TableInfo table_info,
+void TableStore::RegisterTableID(Registry* registry, uint64_t table_id, TableInfo table_info,
                                  const types::TabletID& tablet_id,
                                  std::shared_ptr<table_store::Table> table) {
   // Lookup whether the table already exists in the relation map, add if it does not.
-  auto id_to_table_info_map_iter = id_to_table_info_map_.find(table_id);
-  if (id_to_table_info_map_iter == id_to_table_info_map_.end()) {
-    id_to_table_info_map_[table_id] = table_info;
+  auto id_to_table_info_map_iter = registry->id_to_table_info_map.find(table_id);
+  if (id_to_table_info_map_iter == registry->id_to_table_info_map.end()) {
+    registry->id_to_table_info_map[table_id] = table_info;
   } else {
     DCHECK_EQ(id_to_table_info_map_iter->second.relation, table_info.relation);
   }
 
   TableIDTablet key{table_id, tablet_id};
-  id_to_table_map_[key] = table;
+  registry->id_to_table_map[key] = table;
 }
 
 void TableStore::AddTable(std::shared_ptr<table_store::Table> table, const std::string& table_name,
                           std::optional<uint64_t> table_id, const types::TabletID& tablet_id) {
   const auto& table_relation = table->GetRelation();
+  AddToMemoryBudget(table_name, table.get());
 
+  absl::MutexLock lock(&registry_lock_);
+  auto registry = CopyRegistry();
   // Register the table by name.
-  RegisterTableName(table_name, tablet_id, table_relation, table);
+  RegisterTableName(registry.get(), table_name, tablet_id, table_relation, table);
 
   // Register the table by ID, if one is present.
   if (table_id.has_value()) {
-    RegisterTableID(table_id.value(), TableInfo{table_name, table_relation}, tablet_id, table);
+    RegisterTableID(registry.get(), table_id.value(), TableInfo{table_name, table_relation},
+                    tablet_id, table);
   }
+  PublishRegistry(std::move(registry));
 }
 
 Status TableStore::AddTableAlias(uint64_t table_id, const std::string& table_name) {
-  auto table_iter = name_to_table_map_.find({table_name, ""});
-  if (table_iter == name_to_table_map_.end()) {
+  absl::MutexLock lock(&registry_lock_);
+  auto current = GetRegistry();
+  auto table_iter = current->name_to_table_map.find({table_name, ""});
+  if (table_iter == current->name_to_table_map.end()) {
     return error::Internal(
         "Could not create table alias. Could not find table for $0 If the target table is "
         "tabletized, aliasing is not yet supported.",
@@ -134,34 +191,45 @@ Status TableStore::AddTableAlias(uint64_t table_id, const std::string& table_nam
   }
   std::shared_ptr<Table> table_ptr = table_iter->second;
 
-  auto relation_iter = name_to_relation_map_.find(table_name);
-  if (relation_iter == name_to_relation_map_.end()) {
+  auto relation_iter = current->name_to_relation_map.find(table_name);
+  if (relation_iter == current->name_to_relation_map.end()) {
     return error::Internal("Could not create table alias. Could not find relation for $0.",
                            table_name);
   }
   const schema::Relation& relation = relation_iter->second;
 
-  RegisterTableID(table_id, TableInfo{table_name, relation}, "", std::move(table_ptr));
+  auto registry = CopyRegistry();
+  RegisterTableID(registry.get(), table_id, TableInfo{table_name, relation}, "",
+                  std::move(table_ptr));
+  PublishRegistry(std::move(registry));
   return Status::OK();
 }
 
 Status TableStore::SchemaAsProto(schemapb::Schema* schema) const {
-  return schema::Schema::ToProto(schema, name_to_relation_map_);
+  return schema::Schema::ToProto(schema, GetRegistry()->name_to_relation_map);
 }
 
 std::vector<uint64_t> TableStore::GetTableIDs() const {
+  auto registry = GetRegistry();
   std::vector<uint64_t> ids;
-  for (const auto& it : id_to_table_map_) {
+  for (const auto& it : registry->id_to_table_map) {
     ids.emplace_back(it.first.table_id_);
   }
   return ids;
 }
 
 Status TableStore::RunCompaction(arrow::MemoryPool* mem_pool) {
-  for (const auto& it : name_to_table_map_) {
-    PL_RETURN_IF_ERROR(it.second->CompactHotToCold(mem_pool));
+  if (compaction_scheduler_ == nullptr) {
+    compaction_scheduler_ =
+        std::make_unique<CompactionScheduler>(FLAGS_table_store_compaction_threads);
   }
-  return Status::OK();
+  auto registry = GetRegistry();
+  std::vector<Table*> tables;
+  tables.reserve(registry->name_to_table_map.size());
+  for (const auto& it : registry->name_to_table_map) {
+    tables.push_back(it.second.get());
+  }
+  return compaction_scheduler_->Run(tables, mem_pool);
 }
 
 }  // namespace table_store
@@ -25,12 +25,15 @@
 #include <vector>
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
 
 #include "src/common/base/base.h"
 #include "src/shared/types/column_wrapper.h"
 #include "src/shared/types/hash_utils.h"
 #include "src/table_store/schema/relation.h"
 #include "src/table_store/schema/schema.h"
+#include "src/table_store/table/compaction_scheduler.h"
+#include "src/table_store/table/memory_budget.h"
 #include "src/table_store/table/table.h"
 #include "src/table_store/table/tablets_group.h"
 
@@ -75,12 +78,19 @@ struct TableInfo {
 
 /**
  * TableStore keeps track of the tables in our system.
+ *
+ * Lookups, which happen on every AppendData and query, read an immutable snapshot of the tables
+ * without taking a lock. Adding a table or tablet copies the snapshot and swaps in the new one.
  */
 class TableStore {
  public:
   using RelationMap = std::unordered_map<std::string, schema::Relation>;
 
-  TableStore() = default;
+  /**
+   * If --table_store_memory_budget_bytes is set, the tables added to the table store share that
+   * memory budget, as set out by --table_store_table_budgets.
+   */
+  TableStore();
 
   /**
    * Get table IDs returns a list of table ids available in the table store.
@@ -158,22 +168,60 @@ class TableStore {
    * GetTableName returns the table name if the ID is found, else empty string.
    */
   std::string GetTableName(uint64_t id) const {
-    const auto& it = id_to_table_info_map_.find(id);
-    if (it != id_to_table_info_map_.end()) {
+    auto registry = GetRegistry();
+    const auto& it = registry->id_to_table_info_map.find(id);
+    if (it != registry->id_to_table_info_map.end()) {
       return it->second.table_name;
     }
     return "";
   }
 
+  /**
+   * Compacts the hot storage of every table, in parallel on --table_store_compaction_threads
+   * threads. The tables that are furthest over their hot budget are compacted first.
+   */
   Status RunCompaction(arrow::MemoryPool* mem_pool);
 
- private:
-  void RegisterTableName(const std::string& table_name, const types::TabletID& tablet_id,
-                         const schema::Relation& table_relation,
-                         std::shared_ptr<table_store::Table> table);
+  /**
+   * @return the number of tables still waiting on, or in the middle of, a RunCompaction call.
+   */
+  int64_t CompactionQueueDepth() const {
+    return compaction_scheduler_ == nullptr ? 0 : compaction_scheduler_->QueueDepth();
+  }
 
-  void RegisterTableID(uint64_t table_id, TableInfo table_info, const types::TabletID& tablet_id,
-                       std::shared_ptr<table_store::Table> table);
+ private:
+  // The tables and their relations. Never modified once published.
+  struct Registry {
+    // Map a name to a table.
+    absl::flat_hash_map<NameTablet, std::shared_ptr<Table>> name_to_table_map;
+    // Map an id to a table.
+    absl::flat_hash_map<TableIDTablet, std::shared_ptr<Table>> id_to_table_map;
+    // Mapping from name to relation for adding new tablets.
+    // TODO(oazizi): value should likely be shared_ptr<schema::Relation> because the
+    //               same information is in id_to_table_info_map TableInfo.
+    //               Can avoid this copy.
+    absl::flat_hash_map<std::string, schema::Relation> name_to_relation_map;
+    // Mapping from id to name and relation pair for adding new tablets.
+    absl::flat_hash_map<uint64_t, TableInfo> id_to_table_info_map;
+  };
+
+  // Returns the current registry. Callers keep it alive for as long as they use it, even if a new
+  // registry is published in the meantime.
+  std::shared_ptr<const Registry> GetRegistry() const { return std::atomic_load(&registry_); }
+  // Returns a copy of the current registry, to be modified and then published with
+  // PublishRegistry.
+  std::unique_ptr<Registry> CopyRegistry() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(registry_lock_);
+  void PublishRegistry(std::unique_ptr<Registry> registry)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(registry_lock_);
+
+  static void RegisterTableName(Registry* registry, const std::string& table_name,
+                                const types::TabletID& tablet_id,
+                                const schema::Relation& table_relation,
+                                std::shared_ptr<table_store::Table> table);
+
+  static void RegisterTableID(Registry* registry, uint64_t table_id, TableInfo table_info,
+                              const types::TabletID& tablet_id,
+                              std::shared_ptr<table_store::Table> table);
 
   /**
    * Create a new tablet inside of the table with table_id
@@ -184,19 +232,21 @@ class TableStore {
    */
   StatusOr<Table*> CreateNewTablet(uint64_t table_id, const types::TabletID& tablet_id);
 
+  void AddToMemoryBudget(const std::string& table_name, Table* table);
+
   // The default value for tablets, when tablet is not specified.
   inline static types::TabletID kDefaultTablet = "";
-  // Map a name to a table.
-  absl::flat_hash_map<NameTablet, std::shared_ptr<Table>> name_to_table_map_;
-  // Map an id to a table.
-  absl::flat_hash_map<TableIDTablet, std::shared_ptr<Table>> id_to_table_map_;
-  // Mapping from name to relation for adding new tablets.
-  // TODO(oazizi): value should likely be shared_ptr<schema::Relation> because the
-  //               same information is in id_to_table_info_map_ TableInfo.
-  //               Can avoid this copy.
-  absl::flat_hash_map<std::string, schema::Relation> name_to_relation_map_;
-  // Mapping from id to name and relation pair for adding new tablets.
-  absl::flat_hash_map<uint64_t, TableInfo> id_to_table_info_map_;
+  // Serializes the writers of registry_. Readers load it atomically instead.
+  absl::Mutex registry_lock_;
+  // Only accessed through std::atomic_load and std::atomic_store. A registry is freed once it is
+  // replaced and the last reader that loaded it is done with it.
+  std::shared_ptr<const Registry> registry_;
+  // Null if there is no memory budget.
+  std::shared_ptr<MemoryBudget> memory_budget_;
+  absl::flat_hash_map<std::string, TableBudget> table_budgets_;
+  // Created on the first RunCompaction call, so that table stores that are never compacted don't
+  // start any threads.
+  std::unique_ptr<CompactionScheduler> compaction_scheduler_;
 };
 
 }  // namespace table_store
@@ -20,6 +20,7 @@
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
+#include <thread>
 #include <vector>
 
 #include "src/common/testing/testing.h"
@@ -276,6 +277,31 @@ TEST_F(TableStoreTabletsTest, add_tablet_on_append_data) {
   EXPECT_EQ(tablet2->GetTableStats().batches_added, 0);
 }
 
+// Tablets added by AppendData are visible to lookups running concurrently on other threads.
+TEST_F(TableStoreTabletsTest, concurrent_add_tablet_and_get_table) {
+  auto table_store = TableStore();
+  uint64_t table_id = 123;
+  table_store.AddTable(tablet1_1, "a", table_id, "0");
+
+  constexpr int kNumTablets = 100;
+  std::thread reader([&] {
+    for (int i = 0; i < kNumTablets; ++i) {
+      while (table_store.GetTable("a", absl::StrCat(i)) == nullptr) {
+      }
+    }
+  });
+  for (int i = 0; i < kNumTablets; ++i) {
+    EXPECT_OK(table_store.AppendData(table_id, absl::StrCat(i), MakeRel1ColumnWrapperBatch()));
+  }
+  reader.join();
+
+  for (int i = 0; i < kNumTablets; ++i) {
+    Table* tablet = table_store.GetTable(table_id, absl::StrCat(i));
+    ASSERT_NE(nullptr, tablet);
+    EXPECT_EQ(tablet->GetTableStats().batches_added, 1);
+  }
+}
+
 using TableStoreTabletsDeathTest = TableStoreTabletsTest;
 TEST_F(TableStoreTabletsDeathTest, tablet_test) {
   auto table_store = TableStore();
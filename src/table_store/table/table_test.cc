@@ -20,11 +20,16 @@
 #include <arrow/array.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/message_differencer.h>
+#include <unistd.h>
+#include <filesystem>
 #include <random>
+#include <string>
 #include <vector>
 
+#include "src/common/fs/fs_wrapper.h"
 #include "src/common/testing/testing.h"
 #include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/column_wrapper_pool.h"
 #include "src/table_store/schema/relation.h"
 #include "src/table_store/schemapb/schema.pb.h"
 #include "src/table_store/table/table.h"
@@ -220,6 +225,258 @@ TEST(TableTest, bytes_test_w_compaction) {
   EXPECT_EQ(table.GetTableStats().bytes, rb1_size + rb2_size + rb3_size);
 }
 
+TEST(TableTest, slice_may_match_zone_maps) {
+  auto rd = schema::RowDescriptor({types::DataType::INT64, types::DataType::STRING});
+  schema::Relation rel(rd.types(), {"col1", "col2"});
+
+  schema::RowBatch rb1(rd, 3);
+  std::vector<types::Int64Value> col1_rb1 = {4, 5, 10};
+  std::vector<types::StringValue> col2_rb1 = {"hello", "abc", "defg"};
+  EXPECT_OK(rb1.AddColumn(types::ToArrow(col1_rb1, arrow::default_memory_pool())));
+  EXPECT_OK(rb1.AddColumn(types::ToArrow(col2_rb1, arrow::default_memory_pool())));
+  int64_t rb1_size = 3 * sizeof(int64_t) + 12 * sizeof(char);
+
+  schema::RowBatch rb2(rd, 2);
+  std::vector<types::Int64Value> col1_rb2 = {20, 30};
+  std::vector<types::StringValue> col2_rb2 = {"a", "bc"};
+  EXPECT_OK(rb2.AddColumn(types::ToArrow(col1_rb2, arrow::default_memory_pool())));
+  EXPECT_OK(rb2.AddColumn(types::ToArrow(col2_rb2, arrow::default_memory_pool())));
+
+  // Only rb1 is compacted into cold.
+  std::shared_ptr<Table> table_ptr = std::make_shared<Table>(rel, 128 * 1024, rb1_size);
+  Table& table = *table_ptr;
+  EXPECT_OK(table.WriteRowBatch(rb1));
+  EXPECT_OK(table.WriteRowBatch(rb2));
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+
+  ZoneMapPredicate gt_pred;
+  gt_pred.col_idx = 0;
+  gt_pred.data_type = types::INT64;
+  gt_pred.op = ZoneMapOp::kGreaterThan;
+  gt_pred.int_value = 10;
+
+  ZoneMapPredicate str_pred;
+  str_pred.col_idx = 1;
+  str_pred.data_type = types::STRING;
+  str_pred.op = ZoneMapOp::kEqual;
+  str_pred.string_value = "abc";
+
+  auto cold_slice = table.FirstBatch();
+  ASSERT_FALSE(cold_slice.unsafe_is_hot);
+  EXPECT_TRUE(table.SliceMayMatch(cold_slice, {}));
+  EXPECT_TRUE(table.SliceMayMatch(cold_slice, {str_pred}));
+  EXPECT_FALSE(table.SliceMayMatch(cold_slice, {gt_pred}));
+  EXPECT_FALSE(table.SliceMayMatch(cold_slice, {str_pred, gt_pred}));
+
+  // Hot batches don't have zone maps.
+  auto hot_slice = table.NextBatch(cold_slice);
+  ASSERT_TRUE(hot_slice.unsafe_is_hot);
+  EXPECT_TRUE(table.SliceMayMatch(hot_slice, {gt_pred}));
+  EXPECT_TRUE(table.SliceMayMatch(hot_slice, {str_pred}));
+}
+
+TEST(TableTest, cold_encoding) {
+  bool cold_encoding = FLAGS_table_store_cold_encoding;
+  FLAGS_table_store_cold_encoding = true;
+  DEFER(FLAGS_table_store_cold_encoding = cold_encoding);
+
+  auto rd = schema::RowDescriptor(
+      {types::DataType::TIME64NS, types::DataType::INT64, types::DataType::STRING});
+  schema::Relation rel(rd.types(), {"time_", "count", "method"});
+
+  std::vector<types::Time64NSValue> times;
+  std::vector<types::Int64Value> counts;
+  std::vector<types::StringValue> methods;
+  std::vector<std::string> method_names = {"GET", "POST"};
+  for (int64_t i = 0; i < 100; ++i) {
+    times.push_back(1000 + i * 10);
+    counts.push_back(i % 10);
+    methods.push_back(method_names[i % 2]);
+  }
+  auto time_arr = types::ToArrow(times, arrow::default_memory_pool());
+  auto count_arr = types::ToArrow(counts, arrow::default_memory_pool());
+  auto method_arr = types::ToArrow(methods, arrow::default_memory_pool());
+  schema::RowBatch rb(rd, 100);
+  EXPECT_OK(rb.AddColumn(time_arr));
+  EXPECT_OK(rb.AddColumn(count_arr));
+  EXPECT_OK(rb.AddColumn(method_arr));
+
+  std::shared_ptr<Table> table_ptr = std::make_shared<Table>(rel, 128 * 1024, 1);
+  Table& table = *table_ptr;
+  EXPECT_OK(table.WriteRowBatch(rb));
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(1, stats.compacted_batches);
+  EXPECT_LT(stats.cold_bytes, stats.cold_decoded_bytes);
+  EXPECT_GT(stats.cold_compression_ratio, 1.0);
+
+  auto slice = table.FirstBatch();
+  ASSERT_FALSE(slice.unsafe_is_hot);
+  ASSERT_OK_AND_ASSIGN(auto out_rb, table.GetRowBatchSlice(slice, std::vector<int64_t>({0, 1, 2}),
+                                                           arrow::default_memory_pool()));
+  for (int64_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(out_rb->IsDeferredColumn(i));
+  }
+  EXPECT_TRUE(out_rb->ColumnAt(0)->Equals(*time_arr));
+  EXPECT_TRUE(out_rb->ColumnAt(1)->Equals(*count_arr));
+  EXPECT_TRUE(out_rb->ColumnAt(2)->Equals(*method_arr));
+
+  // Time searches work on the encoded time column.
+  ASSERT_OK_AND_ASSIGN(auto search_slice, table.FindBatchSliceGreaterThanOrEqual(1500));
+  ASSERT_TRUE(search_slice.IsValid());
+  ASSERT_OK_AND_ASSIGN(auto search_rb,
+                       table.GetRowBatchSlice(search_slice, std::vector<int64_t>({0}),
+                                              arrow::default_memory_pool()));
+  EXPECT_TRUE(search_rb->ColumnAt(0)->Equals(*time_arr->Slice(50)));
+}
+
+TEST(TableTest, cold_arena) {
+  bool cold_arena = FLAGS_table_store_cold_arena;
+  FLAGS_table_store_cold_arena = true;
+  DEFER(FLAGS_table_store_cold_arena = cold_arena);
+
+  auto rd = schema::RowDescriptor({types::DataType::INT64});
+  schema::Relation rel(rd.types(), {"count"});
+  std::vector<types::Int64Value> counts(1000, 1);
+  auto count_arr = types::ToArrow(counts, arrow::default_memory_pool());
+  schema::RowBatch rb(rd, 1000);
+  EXPECT_OK(rb.AddColumn(count_arr));
+
+  std::shared_ptr<Table> table_ptr = std::make_shared<Table>(rel, 128 * 1024, 1);
+  Table& table = *table_ptr;
+  EXPECT_OK(table.WriteRowBatch(rb));
+  EXPECT_EQ(0, table.GetTableStats().cold_arena_reserved_bytes);
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(ColdArena::kSlabBytes, stats.cold_arena_reserved_bytes);
+  EXPECT_GE(stats.cold_arena_used_bytes, stats.cold_bytes);
+
+  auto slice = table.FirstBatch();
+  ASSERT_FALSE(slice.unsafe_is_hot);
+  ASSERT_OK_AND_ASSIGN(auto out_rb, table.GetRowBatchSlice(slice, std::vector<int64_t>({0}),
+                                                           arrow::default_memory_pool()));
+  EXPECT_TRUE(out_rb->ColumnAt(0)->Equals(*count_arr));
+}
+
+TEST(TableTest, spill_expired_batches) {
+  auto spill_dir = fs::TempDirectoryPath() / absl::StrCat("table_test_spill_", getpid());
+  std::string spill_dir_flag = FLAGS_table_store_spill_dir;
+  FLAGS_table_store_spill_dir = spill_dir.string();
+  DEFER({
+    FLAGS_table_store_spill_dir = spill_dir_flag;
+    std::filesystem::remove_all(spill_dir);
+  });
+
+  auto rd = schema::RowDescriptor({types::DataType::TIME64NS, types::DataType::INT64});
+  schema::Relation rel(rd.types(), {"time_", "col1"});
+  int64_t batch_length = 10;
+  int64_t batch_size = batch_length * (sizeof(int64_t) + sizeof(int64_t));
+  // Room for two batches in memory.
+  std::shared_ptr<Table> table_ptr = std::make_shared<Table>(rel, 2 * batch_size, batch_size);
+  Table& table = *table_ptr;
+
+  std::vector<types::Time64NSValue> all_times;
+  for (int64_t b = 0; b < 5; ++b) {
+    schema::RowBatch rb(rd, batch_length);
+    std::vector<types::Time64NSValue> times;
+    std::vector<types::Int64Value> vals;
+    for (int64_t i = 0; i < batch_length; ++i) {
+      times.push_back(b * 100 + i);
+      vals.push_back(b);
+    }
+    all_times.insert(all_times.end(), times.begin(), times.end());
+    EXPECT_OK(rb.AddColumn(types::ToArrow(times, arrow::default_memory_pool())));
+    EXPECT_OK(rb.AddColumn(types::ToArrow(vals, arrow::default_memory_pool())));
+    EXPECT_OK(table.WriteRowBatch(rb));
+    EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  }
+
+  // The first three batches were expired from memory, and spilled.
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(3, stats.spilled_batches);
+  EXPECT_LT(0, stats.spilled_bytes);
+  EXPECT_EQ(0, stats.spill_dropped_batches);
+  EXPECT_EQ(2 * batch_size, stats.bytes);
+
+  // Every row can still be read, in order.
+  auto first_slice = table.FirstBatch();
+  EXPECT_TRUE(first_slice.unsafe_is_spilled);
+  std::vector<types::Time64NSValue> out_times;
+  for (auto slice = first_slice; slice.IsValid(); slice = table.NextBatch(slice)) {
+    ASSERT_OK_AND_ASSIGN(auto rb, table.GetRowBatchSlice(slice, std::vector<int64_t>({0, 1}),
+                                                         arrow::default_memory_pool()));
+    auto time_col = rb->ColumnAt(0);
+    for (int64_t i = 0; i < time_col->length(); ++i) {
+      out_times.push_back(types::GetValueFromArrowArray<types::TIME64NS>(time_col.get(), i));
+    }
+  }
+  EXPECT_EQ(all_times, out_times);
+
+  // Time searches work over the spilled batches.
+  ASSERT_OK_AND_ASSIGN(auto slice, table.FindBatchSliceGreaterThanOrEqual(105));
+  EXPECT_TRUE(slice.unsafe_is_spilled);
+  EXPECT_EQ(15, slice.uniq_row_start_idx);
+  EXPECT_EQ(19, slice.uniq_row_end_idx);
+  ASSERT_OK_AND_ASSIGN(auto stop, table.FindStopPositionForTime(205));
+  EXPECT_EQ(26, stop);
+}
+
+TEST(TableTest, expire_cold_buckets) {
+  int64_t expiry_bucket_ns = FLAGS_table_store_expiry_bucket_ns;
+  FLAGS_table_store_expiry_bucket_ns = 10;
+  DEFER(FLAGS_table_store_expiry_bucket_ns = expiry_bucket_ns);
+
+  auto rd = schema::RowDescriptor({types::DataType::TIME64NS, types::DataType::INT64});
+  schema::Relation rel(rd.types(), {"time_", "count"});
+  // Room for 6 rows of 16 bytes, with every hot batch compacting into a cold batch of its own.
+  std::shared_ptr<Table> table_ptr = std::make_shared<Table>(rel, 6 * 16, 1);
+  Table& table = *table_ptr;
+  auto write_row = [&](int64_t time) {
+    schema::RowBatch rb(rd, 1);
+    PL_CHECK_OK(rb.AddColumn(types::ToArrow(std::vector<types::Time64NSValue>{time},
+                                            arrow::default_memory_pool())));
+    PL_CHECK_OK(rb.AddColumn(
+        types::ToArrow(std::vector<types::Int64Value>{1}, arrow::default_memory_pool())));
+    return table.WriteRowBatch(rb);
+  };
+
+  for (int64_t time : {0, 1, 10, 11, 12, 20}) {
+    ASSERT_OK(write_row(time));
+  }
+  ASSERT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  EXPECT_EQ(6, table.GetTableStats().num_batches);
+
+  // The first bucket is expired whole, even though one batch would have made room.
+  ASSERT_OK(write_row(30));
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(2, stats.batches_expired);
+  EXPECT_EQ(5, stats.num_batches);
+  EXPECT_EQ(10, stats.min_time);
+
+  ASSERT_OK(write_row(31));
+  EXPECT_EQ(2, table.GetTableStats().batches_expired);
+  ASSERT_OK(write_row(32));
+  stats = table.GetTableStats();
+  EXPECT_EQ(5, stats.batches_expired);
+  EXPECT_EQ(4, stats.num_batches);
+  EXPECT_EQ(20, stats.min_time);
+
+  ASSERT_OK(write_row(40));
+  ASSERT_OK(write_row(41));
+  ASSERT_OK(write_row(42));
+  stats = table.GetTableStats();
+  EXPECT_EQ(6, stats.batches_expired);
+  EXPECT_EQ(30, stats.min_time);
+
+  // Once there are no cold batches left, hot batches are expired one at a time.
+  ASSERT_OK(write_row(43));
+  stats = table.GetTableStats();
+  EXPECT_EQ(7, stats.batches_expired);
+  EXPECT_EQ(31, stats.min_time);
+}
+
 TEST(TableTest, expiry_test) {
   auto rd = schema::RowDescriptor({types::DataType::INT64, types::DataType::STRING});
   schema::Relation rel(rd.types(), {"col1", "col2"});
@@ -475,6 +732,171 @@ TEST(TableTest, hot_batches_test) {
   EXPECT_TRUE(rb2->ColumnAt(1)->Equals(types::ToArrow(col2_in2, arrow::default_memory_pool())));
 }
 
+TEST(TableTest, hot_batches_deferred_cols_test) {
+  schema::Relation rel({types::DataType::BOOLEAN, types::DataType::INT64}, {"col1", "col2"});
+
+  std::shared_ptr<Table> table_ptr = Table::Create(rel);
+  Table& table = *table_ptr;
+
+  std::vector<types::BoolValue> col1_in1 = {true, false, true};
+  std::vector<types::Int64Value> col2_in1 = {1, 2, 3};
+  auto rb_wrapper_1 = std::make_unique<types::ColumnWrapperRecordBatch>();
+  rb_wrapper_1->push_back(
+      types::ColumnWrapper::FromArrow(types::ToArrow(col1_in1, arrow::default_memory_pool())));
+  rb_wrapper_1->push_back(
+      types::ColumnWrapper::FromArrow(types::ToArrow(col2_in1, arrow::default_memory_pool())));
+  EXPECT_OK(table.TransferRecordBatch(std::move(rb_wrapper_1)));
+
+  auto slice = table.FirstBatch();
+  ASSERT_OK_AND_ASSIGN(auto rb, table.GetRowBatchSlice(slice, std::vector<int64_t>({0, 1}),
+                                                       std::vector<bool>({false, true}),
+                                                       arrow::default_memory_pool()));
+  EXPECT_FALSE(rb->IsDeferredColumn(0));
+  EXPECT_TRUE(rb->IsDeferredColumn(1));
+  EXPECT_EQ(3 * sizeof(bool) + 3 * sizeof(int64_t), rb->NumBytes());
+
+  ASSERT_OK_AND_ASSIGN(auto rows, rb->DeferredColumnRowsAt(1, {0, 2}));
+  std::vector<types::Int64Value> expected_rows = {1, 3};
+  EXPECT_TRUE(rows->Equals(types::ToArrow(expected_rows, arrow::default_memory_pool())));
+
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(col1_in1, arrow::default_memory_pool())));
+  EXPECT_TRUE(rb->ColumnAt(1)->Equals(types::ToArrow(col2_in1, arrow::default_memory_pool())));
+  EXPECT_FALSE(rb->IsDeferredColumn(1));
+}
+
+TEST(TableTest, shared_row_batch_slices) {
+  schema::Relation rel({types::DataType::BOOLEAN, types::DataType::INT64}, {"col1", "col2"});
+  std::shared_ptr<Table> table_ptr = Table::Create(rel);
+  Table& table = *table_ptr;
+
+  std::vector<types::BoolValue> col1_in1 = {true, false, true};
+  std::vector<types::Int64Value> col2_in1 = {1, 2, 3};
+  auto rb_wrapper_1 = std::make_unique<types::ColumnWrapperRecordBatch>();
+  rb_wrapper_1->push_back(
+      types::ColumnWrapper::FromArrow(types::ToArrow(col1_in1, arrow::default_memory_pool())));
+  rb_wrapper_1->push_back(
+      types::ColumnWrapper::FromArrow(types::ToArrow(col2_in1, arrow::default_memory_pool())));
+  EXPECT_OK(table.TransferRecordBatch(std::move(rb_wrapper_1)));
+
+  auto slice = table.FirstBatch();
+  // Deferred columns aren't shared.
+  ASSERT_OK_AND_ASSIGN(auto rb1, table.GetSharedRowBatchSlice(slice, std::vector<int64_t>({0, 1}),
+                                                              std::vector<bool>({false, true}),
+                                                              arrow::default_memory_pool()));
+  EXPECT_TRUE(rb1->IsDeferredColumn(1));
+
+  // A second scan converts only the column that isn't shared yet, in its own column order.
+  ASSERT_OK_AND_ASSIGN(auto rb2, table.GetSharedRowBatchSlice(slice, std::vector<int64_t>({1, 0}),
+                                                              std::vector<bool>({false, false}),
+                                                              arrow::default_memory_pool()));
+  EXPECT_EQ(rb1->ColumnAt(0).get(), rb2->ColumnAt(1).get());
+  EXPECT_TRUE(rb2->ColumnAt(0)->Equals(types::ToArrow(col2_in1, arrow::default_memory_pool())));
+  EXPECT_TRUE(rb2->ColumnAt(1)->Equals(types::ToArrow(col1_in1, arrow::default_memory_pool())));
+
+  // Once shared, columns are never deferred.
+  ASSERT_OK_AND_ASSIGN(auto rb3, table.GetSharedRowBatchSlice(slice, std::vector<int64_t>({0, 1}),
+                                                              std::vector<bool>({true, true}),
+                                                              arrow::default_memory_pool()));
+  EXPECT_FALSE(rb3->IsDeferredColumn(0));
+  EXPECT_FALSE(rb3->IsDeferredColumn(1));
+  EXPECT_EQ(rb2->ColumnAt(1).get(), rb3->ColumnAt(0).get());
+  EXPECT_EQ(rb2->ColumnAt(0).get(), rb3->ColumnAt(1).get());
+
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(3, stats.shared_scan_hits);
+  EXPECT_EQ(3, stats.shared_scan_misses);
+}
+
+TEST(TableTest, string_dictionary) {
+  schema::Relation rel({types::DataType::INT64, types::DataType::STRING, types::DataType::INT64},
+                       {"id", "str", "count"});
+  // The two batches written below take up 48 and 72 bytes, so compaction merges them.
+  auto table_ptr = std::make_shared<Table>(rel, 128 * 1024, 48 + 72);
+  Table& table = *table_ptr;
+  EXPECT_NOT_OK(table.EnableStringDictionary("count", "str"));
+  EXPECT_NOT_OK(table.EnableStringDictionary("id", "count"));
+  ASSERT_OK(table.EnableStringDictionary("id", "str"));
+  auto* pool = arrow::default_memory_pool();
+
+  std::vector<types::Int64Value> ids1 = {1, 2};
+  std::vector<types::StringValue> strs1 = {"main;foo", "main;bar"};
+  std::vector<types::Int64Value> counts1 = {10, 20};
+  auto rb_wrapper = std::make_unique<types::ColumnWrapperRecordBatch>();
+  rb_wrapper->push_back(types::ColumnWrapper::FromArrow(types::ToArrow(ids1, pool)));
+  rb_wrapper->push_back(types::ColumnWrapper::FromArrow(types::ToArrow(strs1, pool)));
+  rb_wrapper->push_back(types::ColumnWrapper::FromArrow(types::ToArrow(counts1, pool)));
+  EXPECT_OK(table.TransferRecordBatch(std::move(rb_wrapper)));
+
+  // Only the new id carries its string, and id 4 was never written with one.
+  std::vector<types::Int64Value> ids2 = {2, 1, 3, 4};
+  std::vector<types::StringValue> strs2 = {"", "", "main;baz", ""};
+  std::vector<types::Int64Value> counts2 = {1, 2, 3, 4};
+  schema::RowBatch rb(schema::RowDescriptor(rel.col_types()), 4);
+  EXPECT_OK(rb.AddColumn(types::ToArrow(ids2, pool)));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(strs2, pool)));
+  EXPECT_OK(rb.AddColumn(types::ToArrow(counts2, pool)));
+  EXPECT_OK(table.WriteRowBatch(rb));
+
+  std::vector<types::StringValue> expected = {"main;bar", "main;foo", "main;baz", ""};
+  auto slice = table.NextBatch(table.FirstBatch());
+  // The dictionary column is resolved wherever it is in the requested columns.
+  ASSERT_OK_AND_ASSIGN(auto rb2, table.GetRowBatchSlice(slice, {2, 1, 0}, {true, true}, pool));
+  EXPECT_TRUE(rb2->ColumnAt(0)->Equals(types::ToArrow(counts2, pool)));
+  EXPECT_TRUE(rb2->ColumnAt(1)->Equals(types::ToArrow(expected, pool)));
+  EXPECT_TRUE(rb2->ColumnAt(2)->Equals(types::ToArrow(ids2, pool)));
+
+  // Values are still resolved once the rows that carried them are compacted into cold storage.
+  EXPECT_OK(table.CompactHotToCold(pool));
+  ASSERT_OK_AND_ASSIGN(auto cold_rb, table.GetRowBatchSlice(table.FirstBatch(), {1}, pool));
+  std::vector<types::StringValue> cold_expected = {"main;foo", "main;bar", "main;bar", "main;foo",
+                                                   "main;baz", ""};
+  EXPECT_TRUE(cold_rb->ColumnAt(0)->Equals(types::ToArrow(cold_expected, pool)));
+
+  // Zone maps can't rule out batches for predicates on the dictionary column.
+  ZoneMapPredicate pred;
+  pred.col_idx = 1;
+  pred.data_type = types::STRING;
+  pred.op = ZoneMapOp::kEqual;
+  pred.string_value = "main;qux";
+  EXPECT_TRUE(table.SliceMayMatch(table.FirstBatch(), {pred}));
+}
+
+TEST(TableTest, recycles_hot_columns) {
+  schema::Relation rel({types::DataType::INT64, types::DataType::STRING}, {"count", "str"});
+  auto table_ptr = std::make_shared<Table>(rel, 128 * 1024, 1);
+  Table& table = *table_ptr;
+  auto* pool = arrow::default_memory_pool();
+  auto* col_pool = types::ColumnWrapperPool::Global();
+  // Other tests may have filled the pool.
+  while (col_pool->NumPooled(types::DataType::INT64) > 0) {
+    col_pool->Acquire(types::DataType::INT64, 0);
+  }
+  while (col_pool->NumPooled(types::DataType::STRING) > 0) {
+    col_pool->Acquire(types::DataType::STRING, 0);
+  }
+
+  std::vector<types::Int64Value> counts = {1, 2, 3};
+  std::vector<types::StringValue> strs = {"a", "b", "c"};
+  auto rb_wrapper = std::make_unique<types::ColumnWrapperRecordBatch>();
+  rb_wrapper->push_back(std::make_shared<types::Int64ValueColumnWrapper>(counts));
+  rb_wrapper->push_back(std::make_shared<types::StringValueColumnWrapper>(strs));
+  const auto* count_values = rb_wrapper->at(0)->UnsafeRawData();
+  EXPECT_OK(table.TransferRecordBatch(std::move(rb_wrapper)));
+
+  // The hot INT64 column is read without being copied.
+  ASSERT_OK_AND_ASSIGN(auto rb, table.GetRowBatchSlice(table.FirstBatch(), {0, 1}, pool));
+  EXPECT_EQ(static_cast<arrow::Int64Array*>(rb->ColumnAt(0).get())->raw_values(),
+            reinterpret_cast<const int64_t*>(count_values));
+
+  // Once compacted, the columns are recycled unless they're still referenced, like the INT64 column
+  // is by the row batch read above.
+  EXPECT_OK(table.CompactHotToCold(pool));
+  EXPECT_EQ(0, col_pool->NumPooled(types::DataType::INT64));
+  EXPECT_EQ(1, col_pool->NumPooled(types::DataType::STRING));
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(counts, pool)));
+  EXPECT_TRUE(rb->ColumnAt(1)->Equals(types::ToArrow(strs, pool)));
+}
+
 TEST(TableTest, hot_batches_w_compaction_test) {
   schema::Relation rel({types::DataType::BOOLEAN, types::DataType::INT64}, {"col1", "col2"});
 
@@ -578,47 +1000,69 @@ TEST(TableTest, find_batch_slice_greater_or_eq) {
   wrapper_batch->push_back(col_wrapper);
   EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
 
-  auto batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(0, arrow::default_memory_pool()).ConsumeValueOrDie();
+  auto batch_slice = table.FindBatchSliceGreaterThanOrEqual(0).ConsumeValueOrDie();
   EXPECT_EQ(0, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(3, batch_slice.uniq_row_end_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(5, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(5).ConsumeValueOrDie();
   EXPECT_EQ(3, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(3, batch_slice.uniq_row_end_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(6, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(6).ConsumeValueOrDie();
   EXPECT_EQ(3, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(3, batch_slice.uniq_row_end_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(8, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(8).ConsumeValueOrDie();
   EXPECT_EQ(4, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(6, batch_slice.uniq_row_end_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(10, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(10).ConsumeValueOrDie();
   EXPECT_EQ(9, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(9, batch_slice.uniq_row_end_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(13, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(13).ConsumeValueOrDie();
   EXPECT_EQ(10, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(12, batch_slice.uniq_row_end_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(21, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(21).ConsumeValueOrDie();
   EXPECT_EQ(13, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(15, batch_slice.uniq_row_end_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(24, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(24).ConsumeValueOrDie();
   EXPECT_EQ(-1, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(-1, batch_slice.uniq_row_end_idx);
 }
 
+TEST(TableTest, time_search_within_large_batch) {
+  schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
+                       std::vector<std::string>({"time_"}));
+  std::shared_ptr<Table> table_ptr = Table::Create(rel);
+  Table& table = *table_ptr;
+
+  std::vector<types::Time64NSValue> times;
+  int64_t time = 100;
+  for (int64_t i = 0; i < 1000; ++i) {
+    time += i % 4 == 0 ? 0 : 3;
+    times.push_back(time);
+  }
+  auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+  col_wrapper->AppendFromVector(times);
+  wrapper_batch->push_back(col_wrapper);
+  EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+
+  auto arr = types::ToArrow(times, arrow::default_memory_pool());
+  for (int64_t val = times.front().val; val <= times.back().val; ++val) {
+    ASSERT_OK_AND_ASSIGN(auto slice, table.FindBatchSliceGreaterThanOrEqual(val));
+    EXPECT_EQ(types::SearchArrowArrayGreaterThanOrEqual<types::TIME64NS>(arr.get(), val),
+              slice.uniq_row_start_idx)
+        << val;
+    ASSERT_OK_AND_ASSIGN(auto stop, table.FindStopPositionForTime(val));
+    EXPECT_EQ(types::SearchArrowArrayLessThanOrEqual<types::TIME64NS>(arr.get(), val) + 1, stop)
+        << val;
+  }
+}
+
 TEST(TableTest, find_batch_slice_greater_or_eq_w_compaction) {
   schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
                        std::vector<std::string>({"time_"}));
@@ -640,12 +1084,10 @@ TEST(TableTest, find_batch_slice_greater_or_eq_w_compaction) {
   EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
 
   EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
-  auto batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(0, arrow::default_memory_pool()).ConsumeValueOrDie();
+  auto batch_slice = table.FindBatchSliceGreaterThanOrEqual(0).ConsumeValueOrDie();
   EXPECT_EQ(0, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(3, batch_slice.uniq_row_end_idx);
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(5, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(5).ConsumeValueOrDie();
   EXPECT_EQ(3, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(3, batch_slice.uniq_row_end_idx);
 
@@ -664,16 +1106,13 @@ TEST(TableTest, find_batch_slice_greater_or_eq_w_compaction) {
   EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
 
   EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(6, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(6).ConsumeValueOrDie();
   EXPECT_EQ(3, batch_slice.uniq_row_start_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(8, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(8).ConsumeValueOrDie();
   EXPECT_EQ(4, batch_slice.uniq_row_start_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(10, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(10).ConsumeValueOrDie();
   EXPECT_EQ(9, batch_slice.uniq_row_start_idx);
 
   wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
@@ -698,20 +1137,48 @@ TEST(TableTest, find_batch_slice_greater_or_eq_w_compaction) {
   EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
   EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(13, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(13).ConsumeValueOrDie();
   EXPECT_EQ(10, batch_slice.uniq_row_start_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(21, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(21).ConsumeValueOrDie();
   EXPECT_EQ(13, batch_slice.uniq_row_start_idx);
 
-  batch_slice =
-      table.FindBatchSliceGreaterThanOrEqual(24, arrow::default_memory_pool()).ConsumeValueOrDie();
+  batch_slice = table.FindBatchSliceGreaterThanOrEqual(24).ConsumeValueOrDie();
   EXPECT_EQ(-1, batch_slice.uniq_row_start_idx);
   EXPECT_EQ(-1, batch_slice.uniq_row_end_idx);
 }
 
+TEST(TableTest, table_stats_rows_and_times) {
+  schema::Relation rel(std::vector<types::DataType>({types::DataType::TIME64NS}),
+                       std::vector<std::string>({"time_"}));
+  int64_t compaction_size = 4 * sizeof(int64_t);
+  Table table(rel, 128 * 1024, compaction_size);
+
+  auto stats = table.GetTableStats();
+  EXPECT_EQ(0, stats.num_rows);
+  EXPECT_EQ(-1, stats.min_time);
+  EXPECT_EQ(-1, stats.max_time);
+
+  auto write_times = [&table](const std::vector<types::Time64NSValue>& times) {
+    auto wrapper_batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto col_wrapper = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+    col_wrapper->AppendFromVector(times);
+    wrapper_batch->push_back(col_wrapper);
+    EXPECT_OK(table.TransferRecordBatch(std::move(wrapper_batch)));
+  };
+  write_times({2, 3, 4, 6});
+  EXPECT_OK(table.CompactHotToCold(arrow::default_memory_pool()));
+  write_times({8, 8, 8});
+  write_times({9, 11});
+
+  stats = table.GetTableStats();
+  EXPECT_EQ(9, stats.num_rows);
+  EXPECT_EQ(2, stats.min_batch_rows);
+  EXPECT_EQ(4, stats.max_batch_rows);
+  EXPECT_EQ(2, stats.min_time);
+  EXPECT_EQ(11, stats.max_time);
+}
+
 TEST(TableTest, ToProto) {
   auto table = TestTable();
   table_store::schemapb::Table table_proto;
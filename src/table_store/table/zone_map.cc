@@ -0,0 +1,198 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/table_store/table/zone_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace table_store {
+
+namespace {
+
+// Bloom filter key for a UINT128 value, ie. a UPID.
+std::string UInt128Key(absl::uint128 val) {
+  uint64_t parts[2] = {absl::Uint128High64(val), absl::Uint128Low64(val)};
+  return std::string(reinterpret_cast<const char*>(parts), sizeof(parts));
+}
+
+template <typename T>
+bool RangeMayMatch(T min, T max, ZoneMapOp op, T val) {
+  switch (op) {
+    case ZoneMapOp::kEqual:
+      return min <= val && val <= max;
+    case ZoneMapOp::kLessThan:
+      return min < val;
+    case ZoneMapOp::kLessThanEqual:
+      return min <= val;
+    case ZoneMapOp::kGreaterThan:
+      return max > val;
+    case ZoneMapOp::kGreaterThanEqual:
+      return max >= val;
+  }
+  return true;
+}
+
+template <types::DataType TDataType, typename T>
+bool FindMinMax(const arrow::Array* input, T* min, T* max) {
+  const auto* arr =
+      static_cast<const typename types::DataTypeTraits<TDataType>::arrow_array_type*>(input);
+  bool has_range = false;
+  for (int64_t i = 0; i < arr->length(); ++i) {
+    if (arr->IsNull(i)) {
+      continue;
+    }
+    T val = arr->Value(i);
+    // NaNs don't satisfy any comparison, so they can be left out of the range.
+    if constexpr (std::is_floating_point_v<T>) {
+      if (std::isnan(val)) {
+        continue;
+      }
+    }
+    if (!has_range) {
+      *min = val;
+      *max = val;
+      has_range = true;
+      continue;
+    }
+    *min = std::min(*min, val);
+    *max = std::max(*max, val);
+  }
+  return has_range;
+}
+
+}  // namespace
+
+StatusOr<ZoneMap> ZoneMap::Create(const schema::Relation& rel,
+                                  const std::vector<std::shared_ptr<arrow::Array>>& columns) {
+  if (columns.size() != rel.NumColumns()) {
+    return error::InvalidArgument("Expected $0 columns, got $1", rel.NumColumns(), columns.size());
+  }
+  ZoneMap zone_map;
+  zone_map.zones_.resize(columns.size());
+  for (const auto& [col_idx, col] : Enumerate(columns)) {
+    auto& zone = zone_map.zones_[col_idx];
+    if (col == nullptr || col->length() == 0) {
+      continue;
+    }
+    switch (rel.GetColumnType(col_idx)) {
+      case types::INT64:
+        zone.has_range = FindMinMax<types::INT64>(col.get(), &zone.int_min, &zone.int_max);
+        break;
+      case types::TIME64NS:
+        zone.has_range = FindMinMax<types::TIME64NS>(col.get(), &zone.int_min, &zone.int_max);
+        break;
+      case types::FLOAT64:
+        zone.has_range = FindMinMax<types::FLOAT64>(col.get(), &zone.float_min, &zone.float_max);
+        break;
+      case types::STRING: {
+        PL_ASSIGN_OR_RETURN(zone.bloom_filter, bloomfilter::XXHash64BloomFilter::Create(
+                                                   col->length(), kBloomFilterErrorRate));
+        const auto* str_col = static_cast<const arrow::StringArray*>(col.get());
+        for (int64_t i = 0; i < str_col->length(); ++i) {
+          int32_t length;
+          const uint8_t* value = str_col->GetValue(i, &length);
+          zone.bloom_filter->Insert(std::string_view(reinterpret_cast<const char*>(value), length));
+        }
+        break;
+      }
+      case types::UINT128: {
+        PL_ASSIGN_OR_RETURN(zone.bloom_filter, bloomfilter::XXHash64BloomFilter::Create(
+                                                   col->length(), kBloomFilterErrorRate));
+        for (int64_t i = 0; i < col->length(); ++i) {
+          types::UInt128Value val = types::GetValueFromArrowArray<types::UINT128>(col.get(), i);
+          zone.bloom_filter->Insert(UInt128Key(val.val));
+          if (col->IsNull(i)) {
+            continue;
+          }
+          if (!zone.has_range) {
+            zone.uint128_min = val.val;
+            zone.uint128_max = val.val;
+            zone.has_range = true;
+            continue;
+          }
+          zone.uint128_min = std::min(zone.uint128_min, val.val);
+          zone.uint128_max = std::max(zone.uint128_max, val.val);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  return zone_map;
+}
+
+bool ZoneMap::MayMatch(const ZoneMapPredicate& pred) const {
+  if (pred.col_idx < 0 || pred.col_idx >= static_cast<int64_t>(zones_.size())) {
+    return true;
+  }
+  const auto& zone = zones_[pred.col_idx];
+  switch (pred.data_type) {
+    case types::INT64:
+    case types::TIME64NS:
+      return !zone.has_range || RangeMayMatch(zone.int_min, zone.int_max, pred.op, pred.int_value);
+    case types::FLOAT64:
+      return !zone.has_range ||
+             RangeMayMatch(zone.float_min, zone.float_max, pred.op, pred.float_value);
+    case types::STRING:
+      return pred.op != ZoneMapOp::kEqual || zone.bloom_filter == nullptr ||
+             zone.bloom_filter->Contains(pred.string_value);
+    case types::UINT128:
+      // The range check is exact and cheaper than hashing the value for the bloom filter.
+      if (zone.has_range &&
+          !RangeMayMatch(zone.uint128_min, zone.uint128_max, pred.op, pred.uint128_value)) {
+        return false;
+      }
+      return pred.op != ZoneMapOp::kEqual || zone.bloom_filter == nullptr ||
+             zone.bloom_filter->Contains(UInt128Key(pred.uint128_value));
+    default:
+      return true;
+  }
+}
+
+bool ZoneMap::MayMatchAll(const std::vector<ZoneMapPredicate>& preds) const {
+  for (const auto& pred : preds) {
+    if (!MayMatch(pred)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int64_t ZoneMap::NumBytes() const {
+  int64_t bytes = zones_.size() * sizeof(ColumnZone);
+  for (const auto& zone : zones_) {
+    if (zone.bloom_filter != nullptr) {
+      bytes += zone.bloom_filter->buffer_size_bytes();
+    }
+  }
+  return bytes;
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <arrow/array.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/numeric/int128.h>
+#include "src/common/base/base.h"
+#include "src/shared/bloomfilter/bloomfilter.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/schema/relation.h"
+
+namespace px {
+namespace table_store {
+
+enum class ZoneMapOp {
+  kEqual,
+  kLessThan,
+  kLessThanEqual,
+  kGreaterThan,
+  kGreaterThanEqual,
+};
+
+/**
+ * A predicate of the form `col <op> value` over a table column. INT64, TIME64NS, FLOAT64 and
+ * UINT128 predicates support every op, STRING predicates only support kEqual.
+ */
+struct ZoneMapPredicate {
+  // Index of the column in the table relation.
+  int64_t col_idx;
+  types::DataType data_type;
+  ZoneMapOp op;
+  // Only the value matching data_type is used: int_value for INT64 and TIME64NS, float_value for
+  // FLOAT64, string_value for STRING and uint128_value for UINT128.
+  int64_t int_value = 0;
+  double float_value = 0;
+  std::string string_value;
+  absl::uint128 uint128_value = 0;
+};
+
+/**
+ * ZoneMap summarizes the columns of a single cold batch so that scans can skip the batch entirely
+ * when a predicate can't match any of its rows. Numeric columns keep their min/max, STRING columns
+ * keep a bloom filter of their values, and UINT128 columns (UPIDs) keep both. Other columns are not
+ * summarized and never cause a batch to be skipped.
+ */
+class ZoneMap {
+ public:
+  // The false positive rate of the bloom filters for STRING and UINT128 columns.
+  static constexpr double kBloomFilterErrorRate = 0.01;
+
+  static StatusOr<ZoneMap> Create(const schema::Relation& rel,
+                                  const std::vector<std::shared_ptr<arrow::Array>>& columns);
+
+  /**
+   * @return false if no row of the batch can satisfy the predicate. May return true even if no row
+   * matches.
+   */
+  bool MayMatch(const ZoneMapPredicate& pred) const;
+
+  /**
+   * @return false if no row of the batch can satisfy all of the predicates.
+   */
+  bool MayMatchAll(const std::vector<ZoneMapPredicate>& preds) const;
+
+  /**
+   * @return the number of bytes used by the zone map (mostly the bloom filters).
+   */
+  int64_t NumBytes() const;
+
+ private:
+  struct ColumnZone {
+    bool has_range = false;
+    int64_t int_min = 0;
+    int64_t int_max = 0;
+    double float_min = 0;
+    double float_max = 0;
+    absl::uint128 uint128_min = 0;
+    absl::uint128 uint128_max = 0;
+    std::unique_ptr<bloomfilter::XXHash64BloomFilter> bloom_filter;
+  };
+
+  std::vector<ColumnZone> zones_;
+};
+
+}  // namespace table_store
+}  // namespace px
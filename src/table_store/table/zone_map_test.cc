@@ -0,0 +1,130 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <arrow/array.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/shared/types/types.h"
+#include "src/table_store/table/zone_map.h"
+
+namespace px {
+namespace table_store {
+
+class ZoneMapTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    schema::Relation rel({types::DataType::TIME64NS, types::DataType::FLOAT64,
+                          types::DataType::STRING, types::DataType::UINT128,
+                          types::DataType::BOOLEAN},
+                         {"time_", "latency", "req_path", "upid", "flag"});
+    std::vector<types::Time64NSValue> times = {10, 20, 30};
+    std::vector<types::Float64Value> latencies = {1.5, -2.5, 0.5};
+    std::vector<types::StringValue> paths = {"/a", "/b", "/c"};
+    std::vector<types::UInt128Value> upids = {{1, 2}, {3, 4}, {5, 6}};
+    std::vector<types::BoolValue> flags = {true, false, true};
+    auto* pool = arrow::default_memory_pool();
+    ASSERT_OK_AND_ASSIGN(
+        auto zone_map,
+        ZoneMap::Create(rel, {types::ToArrow(times, pool), types::ToArrow(latencies, pool),
+                              types::ToArrow(paths, pool), types::ToArrow(upids, pool),
+                              types::ToArrow(flags, pool)}));
+    zone_map_ = std::make_unique<ZoneMap>(std::move(zone_map));
+  }
+
+  static ZoneMapPredicate IntPredicate(int64_t col_idx, ZoneMapOp op, int64_t val) {
+    ZoneMapPredicate pred;
+    pred.col_idx = col_idx;
+    pred.data_type = types::TIME64NS;
+    pred.op = op;
+    pred.int_value = val;
+    return pred;
+  }
+
+  std::unique_ptr<ZoneMap> zone_map_;
+};
+
+TEST_F(ZoneMapTest, min_max) {
+  EXPECT_TRUE(zone_map_->MayMatch(IntPredicate(0, ZoneMapOp::kEqual, 10)));
+  EXPECT_TRUE(zone_map_->MayMatch(IntPredicate(0, ZoneMapOp::kEqual, 15)));
+  EXPECT_FALSE(zone_map_->MayMatch(IntPredicate(0, ZoneMapOp::kEqual, 31)));
+  EXPECT_FALSE(zone_map_->MayMatch(IntPredicate(0, ZoneMapOp::kLessThan, 10)));
+  EXPECT_TRUE(zone_map_->MayMatch(IntPredicate(0, ZoneMapOp::kLessThanEqual, 10)));
+  EXPECT_FALSE(zone_map_->MayMatch(IntPredicate(0, ZoneMapOp::kGreaterThan, 30)));
+  EXPECT_TRUE(zone_map_->MayMatch(IntPredicate(0, ZoneMapOp::kGreaterThanEqual, 30)));
+
+  ZoneMapPredicate float_pred;
+  float_pred.col_idx = 1;
+  float_pred.data_type = types::FLOAT64;
+  float_pred.op = ZoneMapOp::kLessThan;
+  float_pred.float_value = -2.5;
+  EXPECT_FALSE(zone_map_->MayMatch(float_pred));
+  float_pred.op = ZoneMapOp::kGreaterThan;
+  float_pred.float_value = 1.0;
+  EXPECT_TRUE(zone_map_->MayMatch(float_pred));
+}
+
+TEST_F(ZoneMapTest, bloom_filter) {
+  ZoneMapPredicate str_pred;
+  str_pred.col_idx = 2;
+  str_pred.data_type = types::STRING;
+  str_pred.op = ZoneMapOp::kEqual;
+  str_pred.string_value = "/b";
+  EXPECT_TRUE(zone_map_->MayMatch(str_pred));
+  str_pred.string_value = "/not_in_batch";
+  EXPECT_FALSE(zone_map_->MayMatch(str_pred));
+
+  ZoneMapPredicate upid_pred;
+  upid_pred.col_idx = 3;
+  upid_pred.data_type = types::UINT128;
+  upid_pred.op = ZoneMapOp::kEqual;
+  upid_pred.uint128_value = absl::MakeUint128(3, 4);
+  EXPECT_TRUE(zone_map_->MayMatch(upid_pred));
+  upid_pred.uint128_value = absl::MakeUint128(4, 3);
+  EXPECT_FALSE(zone_map_->MayMatch(upid_pred));
+  // Ruled out by the UPID range before the bloom filter.
+  upid_pred.uint128_value = absl::MakeUint128(7, 0);
+  EXPECT_FALSE(zone_map_->MayMatch(upid_pred));
+  upid_pred.op = ZoneMapOp::kLessThan;
+  upid_pred.uint128_value = absl::MakeUint128(1, 2);
+  EXPECT_FALSE(zone_map_->MayMatch(upid_pred));
+  upid_pred.op = ZoneMapOp::kGreaterThanEqual;
+  upid_pred.uint128_value = absl::MakeUint128(5, 6);
+  EXPECT_TRUE(zone_map_->MayMatch(upid_pred));
+
+  EXPECT_LT(0, zone_map_->NumBytes());
+}
+
+TEST_F(ZoneMapTest, may_match_all) {
+  EXPECT_TRUE(zone_map_->MayMatchAll({}));
+  EXPECT_TRUE(zone_map_->MayMatchAll({IntPredicate(0, ZoneMapOp::kGreaterThan, 15),
+                                      IntPredicate(0, ZoneMapOp::kLessThan, 25)}));
+  EXPECT_FALSE(zone_map_->MayMatchAll({IntPredicate(0, ZoneMapOp::kGreaterThan, 15),
+                                       IntPredicate(0, ZoneMapOp::kLessThan, 5)}));
+  // Columns without zones never rule out a batch.
+  EXPECT_TRUE(zone_map_->MayMatch(IntPredicate(4, ZoneMapOp::kGreaterThan, 100)));
+  EXPECT_TRUE(zone_map_->MayMatch(IntPredicate(10, ZoneMapOp::kGreaterThan, 100)));
+}
+
+}  // namespace table_store
+}  // namespace px
@@ -18,14 +18,21 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <memory>
+#include <random>
 #include <string>
 #include <vector>
 
+#include <absl/random/zipf_distribution.h>
 #include <absl/strings/str_format.h>
 #include "schema/row_batch.h"
 #include "schema/row_descriptor.h"
 #include "src/common/datagen/datagen.h"
+#include "src/shared/types/arrow_adapter.h"
+#include "src/table_store/table/table.h"
 
 namespace px {
 namespace table_store {
@@ -90,5 +97,240 @@ inline StatusOr<std::shared_ptr<Table>> CreateTable(
                      num_batches, dist_vars, len_vars);
 }
 
+/**
+ * The shape of a synthetic http_events table, for benchmarks. The values are drawn from
+ * distributions seeded with seed, so that the same spec always produces the same table.
+ */
+struct HTTPEventsTableSpec {
+  int64_t num_rows = 1000000;
+  int64_t rows_per_batch = 1024;
+  // The number of distinct processes (at least 2), and the skew of the requests across them.
+  int64_t num_upids = 100;
+  double upid_zipf_q = 1.1;
+  // The number of distinct remote endpoints.
+  int64_t num_remote_addrs = 1000;
+  // The number of distinct request paths (at least 2), and the skew of the requests across them.
+  int64_t num_paths = 1000;
+  double path_zipf_q = 1.2;
+  // The mean size of the request and response bodies, which are exponentially distributed.
+  int64_t mean_body_bytes = 64;
+  int64_t max_body_bytes = 16 * 1024;
+  // The fraction of responses with a 5xx status.
+  double error_rate = 0.01;
+  // The mean latency of the requests, which is exponentially distributed.
+  int64_t mean_latency_ns = 10 * 1000 * 1000;
+  // The rows are spread evenly over [start_time_ns, start_time_ns + duration_ns).
+  int64_t start_time_ns = 0;
+  int64_t duration_ns = std::chrono::nanoseconds(std::chrono::minutes(5)).count();
+  uint32_t seed = 0;
+};
+
+/**
+ * The shape of a synthetic conn_stats table, for benchmarks.
+ */
+struct ConnStatsTableSpec {
+  int64_t num_rows = 1000000;
+  int64_t rows_per_batch = 1024;
+  int64_t num_upids = 100;
+  double upid_zipf_q = 1.1;
+  int64_t num_remote_addrs = 1000;
+  int64_t start_time_ns = 0;
+  int64_t duration_ns = std::chrono::nanoseconds(std::chrono::minutes(5)).count();
+  uint32_t seed = 0;
+};
+
+inline schema::Relation HTTPEventsRelation() {
+  return schema::Relation(
+      {types::TIME64NS, types::UINT128, types::STRING, types::INT64, types::INT64, types::INT64,
+       types::INT64, types::INT64, types::STRING, types::STRING, types::STRING, types::STRING,
+       types::INT64, types::STRING, types::INT64, types::STRING, types::STRING, types::INT64,
+       types::INT64},
+      {"time_", "upid", "remote_addr", "remote_port", "trace_role", "major_version",
+       "minor_version", "content_type", "req_headers", "req_method", "req_path", "req_body",
+       "req_body_size", "resp_headers", "resp_status", "resp_message", "resp_body",
+       "resp_body_size", "latency"});
+}
+
+inline schema::Relation ConnStatsRelation() {
+  return schema::Relation(
+      {types::TIME64NS, types::UINT128, types::STRING, types::INT64, types::INT64, types::INT64,
+       types::INT64, types::BOOLEAN, types::INT64, types::INT64, types::INT64, types::INT64,
+       types::INT64},
+      {"time_", "upid", "remote_addr", "remote_port", "trace_role", "addr_family", "protocol",
+       "ssl", "conn_open", "conn_close", "conn_active", "bytes_sent", "bytes_recv"});
+}
+
+namespace internal {
+
+inline types::UInt128Value SyntheticUPID(int64_t idx) {
+  // asid 1, pid 1000 + idx, and a start time derived from the pid.
+  uint64_t pid = 1000 + idx;
+  return types::UInt128Value((uint64_t{1} << 32) | pid, pid * 1000);
+}
+
+inline std::string SyntheticRemoteAddr(int64_t idx) {
+  return absl::StrFormat("10.%d.%d.%d", (idx >> 16) & 0xff, (idx >> 8) & 0xff, idx & 0xff);
+}
+
+// Spreads the rows evenly over [start_time_ns, start_time_ns + duration_ns).
+inline int64_t SyntheticTime(int64_t start_time_ns, int64_t duration_ns, int64_t row,
+                             int64_t num_rows) {
+  return start_time_ns + static_cast<int64_t>(static_cast<double>(row) / num_rows * duration_ns);
+}
+
+template <typename TValue>
+Status AddColumn(const std::vector<TValue>& data, schema::RowBatch* rb) {
+  return rb->AddColumn(types::ToArrow(data, arrow::default_memory_pool()));
+}
+
+}  // namespace internal
+
+inline StatusOr<std::shared_ptr<Table>> CreateHTTPEventsTable(const HTTPEventsTableSpec& spec) {
+  auto table = std::make_shared<Table>(HTTPEventsRelation(), std::numeric_limits<size_t>::max());
+
+  std::mt19937_64 rng(spec.seed);
+  absl::zipf_distribution<int64_t> upid_dist(spec.num_upids - 1, spec.upid_zipf_q);
+  std::uniform_int_distribution<int64_t> remote_addr_dist(0, spec.num_remote_addrs - 1);
+  absl::zipf_distribution<int64_t> path_dist(spec.num_paths - 1, spec.path_zipf_q);
+  std::exponential_distribution<double> body_size_dist(1.0 / spec.mean_body_bytes);
+  std::exponential_distribution<double> latency_dist(1.0 / spec.mean_latency_ns);
+  std::bernoulli_distribution error_dist(spec.error_rate);
+  std::uniform_int_distribution<int> method_dist(0, 3);
+  constexpr const char* kMethods[] = {"GET", "GET", "POST", "PUT"};
+
+  std::vector<std::string> paths(spec.num_paths);
+  for (int64_t i = 0; i < spec.num_paths; ++i) {
+    paths[i] = absl::StrFormat("/api/v1/service%d/resource%d", i % 16, i);
+  }
+  // The bodies are prefixes of one random string.
+  const std::string body_chars = datagen::RandomString(spec.max_body_bytes);
+  auto body_size = [&]() {
+    return std::min<int64_t>(static_cast<int64_t>(body_size_dist(rng)), spec.max_body_bytes);
+  };
+
+  const std::vector<types::DataType> types = HTTPEventsRelation().col_types();
+  for (int64_t row = 0; row < spec.num_rows; row += spec.rows_per_batch) {
+    const int64_t n = std::min(spec.rows_per_batch, spec.num_rows - row);
+    std::vector<types::Time64NSValue> time(n);
+    std::vector<types::UInt128Value> upid(n);
+    std::vector<types::StringValue> remote_addr(n);
+    std::vector<types::Int64Value> remote_port(n, 8080);
+    std::vector<types::Int64Value> trace_role(n, 2);
+    std::vector<types::Int64Value> major_version(n, 1);
+    std::vector<types::Int64Value> minor_version(n, 1);
+    std::vector<types::Int64Value> content_type(n, 1);
+    std::vector<types::StringValue> req_headers(n, R"({"Host":"example.com"})");
+    std::vector<types::StringValue> req_method(n);
+    std::vector<types::StringValue> req_path(n);
+    std::vector<types::StringValue> req_body(n);
+    std::vector<types::Int64Value> req_body_size(n);
+    std::vector<types::StringValue> resp_headers(n, R"({"Content-Type":"application/json"})");
+    std::vector<types::Int64Value> resp_status(n);
+    std::vector<types::StringValue> resp_message(n);
+    std::vector<types::StringValue> resp_body(n);
+    std::vector<types::Int64Value> resp_body_size(n);
+    std::vector<types::Int64Value> latency(n);
+    for (int64_t i = 0; i < n; ++i) {
+      time[i] =
+          internal::SyntheticTime(spec.start_time_ns, spec.duration_ns, row + i, spec.num_rows);
+      upid[i] = internal::SyntheticUPID(upid_dist(rng));
+      remote_addr[i] = internal::SyntheticRemoteAddr(remote_addr_dist(rng));
+      req_method[i] = kMethods[method_dist(rng)];
+      req_path[i] = paths[path_dist(rng)];
+      int64_t req_size = body_size();
+      req_body[i] = body_chars.substr(0, req_size);
+      req_body_size[i] = req_size;
+      bool error = error_dist(rng);
+      resp_status[i] = error ? 500 : 200;
+      resp_message[i] = error ? "Internal Server Error" : "OK";
+      int64_t resp_size = body_size();
+      resp_body[i] = body_chars.substr(0, resp_size);
+      resp_body_size[i] = resp_size;
+      latency[i] = static_cast<int64_t>(latency_dist(rng));
+    }
+
+    schema::RowBatch rb(schema::RowDescriptor(types), n);
+    PL_RETURN_IF_ERROR(internal::AddColumn(time, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(upid, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(remote_addr, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(remote_port, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(trace_role, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(major_version, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(minor_version, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(content_type, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(req_headers, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(req_method, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(req_path, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(req_body, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(req_body_size, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(resp_headers, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(resp_status, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(resp_message, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(resp_body, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(resp_body_size, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(latency, &rb));
+    PL_RETURN_IF_ERROR(table->WriteRowBatch(rb));
+  }
+  return table;
+}
+
+inline StatusOr<std::shared_ptr<Table>> CreateConnStatsTable(const ConnStatsTableSpec& spec) {
+  auto table = std::make_shared<Table>(ConnStatsRelation(), std::numeric_limits<size_t>::max());
+
+  std::mt19937_64 rng(spec.seed);
+  absl::zipf_distribution<int64_t> upid_dist(spec.num_upids - 1, spec.upid_zipf_q);
+  std::uniform_int_distribution<int64_t> remote_addr_dist(0, spec.num_remote_addrs - 1);
+  std::uniform_int_distribution<int64_t> bytes_dist(0, 1 << 20);
+  std::uniform_int_distribution<int64_t> conns_dist(0, 10);
+
+  const std::vector<types::DataType> types = ConnStatsRelation().col_types();
+  for (int64_t row = 0; row < spec.num_rows; row += spec.rows_per_batch) {
+    const int64_t n = std::min(spec.rows_per_batch, spec.num_rows - row);
+    std::vector<types::Time64NSValue> time(n);
+    std::vector<types::UInt128Value> upid(n);
+    std::vector<types::StringValue> remote_addr(n);
+    std::vector<types::Int64Value> remote_port(n, 8080);
+    std::vector<types::Int64Value> trace_role(n, 1);
+    std::vector<types::Int64Value> addr_family(n, 2);
+    std::vector<types::Int64Value> protocol(n, 1);
+    std::vector<types::BoolValue> ssl(n, false);
+    std::vector<types::Int64Value> conn_open(n);
+    std::vector<types::Int64Value> conn_close(n);
+    std::vector<types::Int64Value> conn_active(n);
+    std::vector<types::Int64Value> bytes_sent(n);
+    std::vector<types::Int64Value> bytes_recv(n);
+    for (int64_t i = 0; i < n; ++i) {
+      time[i] =
+          internal::SyntheticTime(spec.start_time_ns, spec.duration_ns, row + i, spec.num_rows);
+      upid[i] = internal::SyntheticUPID(upid_dist(rng));
+      remote_addr[i] = internal::SyntheticRemoteAddr(remote_addr_dist(rng));
+      int64_t open = conns_dist(rng);
+      int64_t close = std::min(open, conns_dist(rng));
+      conn_open[i] = open;
+      conn_close[i] = close;
+      conn_active[i] = open - close;
+      bytes_sent[i] = bytes_dist(rng);
+      bytes_recv[i] = bytes_dist(rng);
+    }
+
+    schema::RowBatch rb(schema::RowDescriptor(types), n);
+    PL_RETURN_IF_ERROR(internal::AddColumn(time, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(upid, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(remote_addr, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(remote_port, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(trace_role, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(addr_family, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(protocol, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(ssl, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(conn_open, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(conn_close, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(conn_active, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(bytes_sent, &rb));
+    PL_RETURN_IF_ERROR(internal::AddColumn(bytes_recv, &rb));
+    PL_RETURN_IF_ERROR(table->WriteRowBatch(rb));
+  }
+  return table;
+}
+
 }  // namespace table_store
 }  // namespace px
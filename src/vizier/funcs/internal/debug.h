@@ -19,6 +19,7 @@
 #pragma once
 #include <string>
 
+#include "src/carnot/funcs/net/dns.h"
 #include "src/carnot/udf/registry.h"
 #include "src/carnot/udf/udf.h"
 #include "src/common/base/base.h"
@@ -61,6 +62,49 @@ class HeapStatsUDTF final : public carnot::udf::UDTF<HeapStatsUDTF> {
   }
 };
 
+class DNSCacheStatsUDTF final : public carnot::udf::UDTF<DNSCacheStatsUDTF> {
+ public:
+  static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
+
+  static constexpr auto OutputRelation() {
+    return MakeArray(ColInfo("asid", types::DataType::INT64, types::PatternType::GENERAL,
+                             "The short ID of the agent"),
+                     ColInfo("size", types::DataType::INT64, types::PatternType::METRIC_GAUGE,
+                             "The number of cached addresses"),
+                     ColInfo("hits", types::DataType::INT64, types::PatternType::METRIC_COUNTER,
+                             "The lookups that found a cached hostname"),
+                     ColInfo("negative_hits", types::DataType::INT64,
+                             types::PatternType::METRIC_COUNTER,
+                             "The lookups that found an address cached as having no hostname"),
+                     ColInfo("misses", types::DataType::INT64, types::PatternType::METRIC_COUNTER,
+                             "The lookups that waited for the address to be resolved"),
+                     ColInfo("async_misses", types::DataType::INT64,
+                             types::PatternType::METRIC_COUNTER,
+                             "The lookups that returned the address before it was resolved"),
+                     ColInfo("evictions", types::DataType::INT64,
+                             types::PatternType::METRIC_COUNTER, "The evicted addresses"),
+                     ColInfo("hit_rate", types::DataType::FLOAT64,
+                             types::PatternType::METRIC_GAUGE,
+                             "The fraction of lookups answered from the cache"));
+  }
+
+  bool NextRecord(FunctionContext* ctx, RecordWriter* rw) {
+    auto stats = carnot::funcs::net::internal::DNSCache::GetInstance().Stats();
+    int64_t cached = stats.hits + stats.negative_hits;
+    int64_t lookups = cached + stats.misses + stats.async_misses;
+
+    rw->Append<IndexOf("asid")>(ctx->metadata_state()->asid());
+    rw->Append<IndexOf("size")>(stats.size);
+    rw->Append<IndexOf("hits")>(stats.hits);
+    rw->Append<IndexOf("negative_hits")>(stats.negative_hits);
+    rw->Append<IndexOf("misses")>(stats.misses);
+    rw->Append<IndexOf("async_misses")>(stats.async_misses);
+    rw->Append<IndexOf("evictions")>(stats.evictions);
+    rw->Append<IndexOf("hit_rate")>(lookups == 0 ? 0.0 : static_cast<double>(cached) / lookups);
+    return false;
+  }
+};
+
 class HeapSampleUDTF final : public carnot::udf::UDTF<HeapSampleUDTF> {
  public:
   static constexpr auto Executor() { return carnot::udfspb::UDTFSourceExecutor::UDTF_ALL_AGENTS; }
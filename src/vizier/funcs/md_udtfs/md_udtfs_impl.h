@@ -594,17 +594,20 @@ class GetDebugMDWithPrefix final : public carnot::udf::UDTF<GetDebugMDWithPrefix
   }
 
   bool NextRecord(FunctionContext*, RecordWriter* rw) {
-    for (const px::vizier::services::metadata::WithPrefixKeyResponse_KV& kv : resp_->kvs()) {
-      rw->Append<IndexOf("key")>(kv.key());
-      rw->Append<IndexOf("value")>(kv.value());
+    // Output one key per record, so that a large dump is split over several batches.
+    if (idx_ >= resp_->kvs_size()) {
+      return false;
     }
-
-    // no more records.
-    return false;
+    const auto& kv = resp_->kvs(idx_);
+    rw->Append<IndexOf("key")>(kv.key());
+    rw->Append<IndexOf("value")>(kv.value());
+    ++idx_;
+    return idx_ < resp_->kvs_size();
   }
 
  private:
   std::unique_ptr<px::vizier::services::metadata::WithPrefixKeyResponse> resp_;
+  int idx_ = 0;
 
   std::shared_ptr<MDSStub> stub_;
   std::function<void(grpc::ClientContext*)> add_context_authentication_func_;
@@ -639,6 +642,22 @@ class GetDebugTableInfo final : public carnot::udf::UDTF<GetDebugTableInfo> {
                 "The size of this table in bytes"),
         ColInfo("cold_size", types::DataType::INT64, types::PatternType::GENERAL,
                 "The number of bytes in cold storage"),
+        ColInfo("cold_compression_ratio", types::DataType::FLOAT64, types::PatternType::GENERAL,
+                "The decoded size of cold storage divided by its encoded size"),
+        ColInfo("hot_size", types::DataType::INT64, types::PatternType::GENERAL,
+                "The number of bytes in hot storage waiting to be compacted"),
+        ColInfo("num_hot_batches", types::DataType::INT64, types::PatternType::GENERAL,
+                "The number of batches in hot storage waiting to be compacted"),
+        ColInfo("compaction_latency_ns", types::DataType::INT64, types::PatternType::GENERAL,
+                "How long the last compaction of this table took"),
+        ColInfo("shared_scan_hits", types::DataType::INT64, types::PatternType::GENERAL,
+                "The number of columns scans shared with other scans of the same rows"),
+        ColInfo("shared_scan_misses", types::DataType::INT64, types::PatternType::GENERAL,
+                "The number of columns scans had to convert themselves"),
+        ColInfo("cold_arena_reserved_size", types::DataType::INT64, types::PatternType::GENERAL,
+                "The number of bytes of huge page slabs mapped for cold storage"),
+        ColInfo("cold_arena_used_size", types::DataType::INT64, types::PatternType::GENERAL,
+                "The number of bytes of those slabs used by cold storage"),
         ColInfo("max_table_size", types::DataType::INT64, types::PatternType::GENERAL,
                 "The maximum size of this table"));
   }
@@ -665,6 +684,14 @@ class GetDebugTableInfo final : public carnot::udf::UDTF<GetDebugTableInfo> {
     rw->Append<IndexOf("compacted_batches")>(info.compacted_batches);
     rw->Append<IndexOf("size")>(info.bytes);
     rw->Append<IndexOf("cold_size")>(info.cold_bytes);
+    rw->Append<IndexOf("cold_compression_ratio")>(info.cold_compression_ratio);
+    rw->Append<IndexOf("hot_size")>(info.hot_bytes);
+    rw->Append<IndexOf("num_hot_batches")>(info.num_hot_batches);
+    rw->Append<IndexOf("compaction_latency_ns")>(info.compaction_latency_ns);
+    rw->Append<IndexOf("shared_scan_hits")>(info.shared_scan_hits);
+    rw->Append<IndexOf("shared_scan_misses")>(info.shared_scan_misses);
+    rw->Append<IndexOf("cold_arena_reserved_size")>(info.cold_arena_reserved_bytes);
+    rw->Append<IndexOf("cold_arena_used_size")>(info.cold_arena_used_bytes);
     rw->Append<IndexOf("max_table_size")>(info.max_table_size);
 
     ++current_idx_;
@@ -18,6 +18,8 @@
 
 #include <grpcpp/grpcpp.h>
 #include <algorithm>
+#include <string>
+#include <thread>
 
 #include <sole.hpp>
 
@@ -51,6 +53,11 @@ DEFINE_string(pod_name, gflags::StringFromEnv("PL_POD_NAME", ""),
 DEFINE_string(host_ip, gflags::StringFromEnv("PL_HOST_IP", ""),
               "The IP of the host this service is running on");
 
+DEFINE_int32(kelvin_exec_parallelism, gflags::Int32FromEnv("PL_KELVIN_EXEC_PARALLELISM", 0),
+             "The number of threads each query uses to execute its stateless operators on Kelvin. "
+             "0 uses the number of cores. Only applies when carnot_exec_parallelism isn't set on "
+             "the command line.");
+
 using ::px::vizier::agent::KelvinManager;
 using ::px::vizier::agent::Manager;
 
@@ -115,6 +122,17 @@ int main(int argc, char** argv) {
     LOG(FATAL) << "The HOST_IP must be specified";
   }
 
+  // Kelvin doesn't collect data, so its queries can use all of the cores.
+  int32_t exec_parallelism = FLAGS_kelvin_exec_parallelism;
+  if (exec_parallelism <= 0) {
+    exec_parallelism = std::max(1, static_cast<int32_t>(std::thread::hardware_concurrency()));
+  }
+  gflags::SetCommandLineOptionWithMode("carnot_exec_parallelism",
+                                       std::to_string(exec_parallelism).c_str(),
+                                       gflags::SET_FLAGS_DEFAULT);
+  LOG(INFO) << absl::Substitute("Executing queries with parallelism: $0",
+                                FLAGS_carnot_exec_parallelism);
+
   std::string addr = absl::Substitute("$0:$1", FLAGS_pod_ip, FLAGS_rpc_port);
 
   std::string mds_addr =
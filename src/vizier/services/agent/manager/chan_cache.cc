@@ -18,6 +18,7 @@
 
 #include "src/vizier/services/agent/manager/chan_cache.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace px {
@@ -30,33 +31,47 @@ std::shared_ptr<::grpc::Channel> ChanCache::GetChan(std::string_view remote_addr
   if (it == chan_cache_.end()) {
     return nullptr;
   }
-  return it->second.chan;
+  Channels& channels = it->second;
+  channels.next %= channels.chans.size();
+  return channels.chans[channels.next++].chan;
+}
+
+size_t ChanCache::NumChans(std::string_view remote_addr) {
+  absl::base_internal::SpinLockHolder lock(&chan_cache_lock_);
+  auto it = chan_cache_.find(remote_addr);
+  if (it == chan_cache_.end()) {
+    return 0;
+  }
+  return it->second.chans.size();
 }
 
 void ChanCache::Add(std::string remote_addr, std::shared_ptr<::grpc::Channel> chan) {
   absl::base_internal::SpinLockHolder lock(&chan_cache_lock_);
-  chan_cache_[remote_addr] = {chan, std::chrono::system_clock::now()};
+  chan_cache_[remote_addr].chans.push_back({chan, std::chrono::system_clock::now()});
 }
 
 Status ChanCache::CleanupChans() {
   absl::base_internal::SpinLockHolder lock(&chan_cache_lock_);
   std::vector<std::string> remote_addrs_to_delete;
   auto time_now = std::chrono::system_clock::now();
-  for (const auto& [remote_addr, chan] : chan_cache_) {
-    // Get the state of the channel.
-    auto state = chan.chan->GetState(/*try_to_connect*/ false);
-    if (state == grpc_connectivity_state::GRPC_CHANNEL_SHUTDOWN ||
-        state == grpc_connectivity_state::GRPC_CHANNEL_TRANSIENT_FAILURE) {
-      remote_addrs_to_delete.push_back(remote_addr);
-      continue;
-    }
-    std::chrono::nanoseconds age = time_now - chan.start_time;
-    // If the age of the channel is still warming up, we don't kill it for being idle.
-    if (age < warm_up_period_) {
-      continue;
-    }
-
-    if (state == grpc_connectivity_state::GRPC_CHANNEL_IDLE) {
+  for (auto& [remote_addr, channels] : chan_cache_) {
+    auto out_of_use = [&](const Channel& chan) {
+      // Get the state of the channel.
+      auto state = chan.chan->GetState(/*try_to_connect*/ false);
+      if (state == grpc_connectivity_state::GRPC_CHANNEL_SHUTDOWN ||
+          state == grpc_connectivity_state::GRPC_CHANNEL_TRANSIENT_FAILURE) {
+        return true;
+      }
+      std::chrono::nanoseconds age = time_now - chan.start_time;
+      // If the age of the channel is still warming up, we don't kill it for being idle.
+      if (age < warm_up_period_) {
+        return false;
+      }
+      return state == grpc_connectivity_state::GRPC_CHANNEL_IDLE;
+    };
+    auto& chans = channels.chans;
+    chans.erase(std::remove_if(chans.begin(), chans.end(), out_of_use), chans.end());
+    if (chans.empty()) {
       remote_addrs_to_delete.push_back(remote_addr);
     }
   }
@@ -23,6 +23,7 @@
 #include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <absl/base/internal/spinlock.h>
 #include <absl/container/flat_hash_map.h>
@@ -48,8 +49,8 @@ class ChanCache {
   explicit ChanCache(std::chrono::duration<int64_t, T> warm_up_period)
       : ChanCache(std::chrono::duration_cast<std::chrono::nanoseconds>(warm_up_period)) {}
   /**
-   * @brief Gets the Chan at remote_addr. If the cache doesn't contain the channel, it returns a
-   * nullptr.
+   * @brief Gets a Chan at remote_addr. If the cache holds several channels for the address, they
+   * are handed out in turn. If the cache doesn't contain a channel, it returns a nullptr.
    *
    * @param remote_addr the remote_address to look up.
    * @return std::shared_ptr<::grpc::Channel> the channel or a nullptr if not found.
@@ -57,7 +58,12 @@ class ChanCache {
   std::shared_ptr<::grpc::Channel> GetChan(std::string_view remote_addr);
 
   /**
-   * @brief Caches `chan` for the `remote_addr`.
+   * @brief Returns the number of channels cached for the `remote_addr`.
+   */
+  size_t NumChans(std::string_view remote_addr);
+
+  /**
+   * @brief Caches `chan` for the `remote_addr`, alongside the channels already cached for it.
    *
    * @param remote_addr the remote address corresponding to the channel.
    * @param chan the channel to cache.
@@ -82,8 +88,14 @@ class ChanCache {
     std::chrono::system_clock::time_point start_time;
   };
 
+  struct Channels {
+    std::vector<Channel> chans;
+    // The index of the next channel GetChan returns.
+    size_t next = 0;
+  };
+
   // The cache of channels (grpc conns) made to other agents.
-  absl::flat_hash_map<std::string, Channel> chan_cache_ GUARDED_BY(chan_cache_lock_);
+  absl::flat_hash_map<std::string, Channels> chan_cache_ GUARDED_BY(chan_cache_lock_);
   absl::base_internal::SpinLock chan_cache_lock_;
   // Connections that are alive for shorter than warm_up_period_ won't be cleared.
   std::chrono::nanoseconds warm_up_period_;
@@ -171,6 +171,41 @@ TEST_F(ChanCacheTest, channel_idleness_triggers_gc) {
   EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), nullptr);
 }
 
+TEST_F(ChanCacheTest, multiple_chans_per_addr) {
+  ChanCache chan_cache(std::chrono::minutes(5));
+  EXPECT_EQ(chan_cache.NumChans(GetServerAddress()), 0);
+
+  auto channel1 = grpc::CreateChannel(GetServerAddress(), InsecureChannelCredentials());
+  auto channel2 = grpc::CreateChannel(GetServerAddress(), InsecureChannelCredentials());
+  chan_cache.Add(GetServerAddress(), channel1);
+  chan_cache.Add(GetServerAddress(), channel2);
+  EXPECT_EQ(chan_cache.NumChans(GetServerAddress()), 2);
+
+  // The channels are handed out in turn.
+  EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), channel1);
+  EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), channel2);
+  EXPECT_EQ(chan_cache.GetChan(GetServerAddress()), channel1);
+}
+
+TEST_F(ChanCacheTest, gc_removes_only_failing_chans) {
+  ChanCache chan_cache(std::chrono::minutes(5));
+  auto wrong_server_address = absl::Substitute("$0:$1", hostname, port_ + 1);
+
+  auto good_channel = grpc::CreateChannel(wrong_server_address, InsecureChannelCredentials());
+  auto bad_channel = grpc::CreateChannel(wrong_server_address, InsecureChannelCredentials());
+  chan_cache.Add(wrong_server_address, good_channel);
+  chan_cache.Add(wrong_server_address, bad_channel);
+
+  // Only attempt a connection on one of the channels.
+  auto stub = BuildStub(bad_channel);
+  RunRPC(stub.get());
+  EXPECT_EQ(bad_channel->GetState(false), GRPC_CHANNEL_TRANSIENT_FAILURE);
+
+  EXPECT_OK(chan_cache.CleanupChans());
+  EXPECT_EQ(chan_cache.NumChans(wrong_server_address), 1);
+  EXPECT_EQ(chan_cache.GetChan(wrong_server_address), good_channel);
+}
+
 }  // namespace agent
 }  // namespace vizier
 }  // namespace px
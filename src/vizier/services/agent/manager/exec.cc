@@ -18,6 +18,7 @@
 
 #include "src/vizier/services/agent/manager/exec.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -27,31 +28,53 @@
 #include "src/common/base/base.h"
 #include "src/common/event/task.h"
 #include "src/common/perf/perf.h"
+#include "src/common/system/cpu_affinity.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
+DEFINE_int64(agent_max_concurrent_queries,
+             gflags::Int64FromEnv("PL_AGENT_MAX_CONCURRENT_QUERIES", 0),
+             "The number of queries an agent runs at once. Further queries wait for a slot, "
+             "interactive ones ahead of background ones. Internal and streaming queries don't "
+             "take a slot. 0 means unlimited.");
+DEFINE_double(agent_background_query_cpu_quota, 0.5,
+              "The fraction of a core that background queries without a CPU quota of their own may "
+              "use. 0 leaves them unthrottled.");
+DEFINE_string(agent_query_cpus, gflags::StringFromEnv("PL_AGENT_QUERY_CPUS", ""),
+              "The CPUs that queries run on, as a CPU list such as \"4-7\". If empty, PEMs run "
+              "them on the CPUs that --stirling_cpus leaves, and other agents on any CPU.");
+
 namespace px {
 namespace vizier {
 namespace agent {
 
 using ::px::event::AsyncTask;
+using ::px::carnot::planpb::PlanOptions;
 
 class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
  public:
   ExecuteQueryTask(ExecuteQueryMessageHandler* h, carnot::Carnot* carnot,
-                   std::unique_ptr<messages::VizierMessage> msg)
+                   QuerySpanTable* query_span_table, std::unique_ptr<messages::VizierMessage> msg)
       : parent_(h),
         carnot_(carnot),
+        query_span_table_(query_span_table),
         msg_(std::move(msg)),
         req_(msg_->execute_query_request()),
-        query_id_(ParseUUID(req_.query_id()).ConsumeValueOrDie()) {}
+        query_id_(ParseUUID(req_.query_id()).ConsumeValueOrDie()),
+        received_time_ns_(CurrentTimeNS()) {}
 
   sole::uuid query_id() { return query_id_; }
 
   void Work() override {
     LOG(INFO) << absl::Substitute("Executing query: id=$0", query_id_.str());
+    if (!parent_->query_cpus_.empty()) {
+      // The thread pool is shared with other work, so each query pins the thread that it gets.
+      ECHECK_OK(system::SetCurrentThreadAffinity(parent_->query_cpus_));
+    }
     VLOG(1) << absl::Substitute("Query Plan: $0=$1", query_id_.str(), req_.plan().DebugString());
 
+    int64_t work_start_ns = CurrentTimeNS();
     auto s = carnot_->ExecutePlan(req_.plan(), query_id_, req_.analyze());
+    RecordSpans(work_start_ns, CurrentTimeNS());
     if (!s.ok()) {
       if (s.code() == px::statuspb::Code::CANCELLED) {
         LOG(WARNING) << absl::Substitute("Cancelled query: $0", query_id_.str());
@@ -64,32 +87,84 @@ class ExecuteQueryMessageHandler::ExecuteQueryTask : public AsyncTask {
     }
   }
 
-  void Done() override { parent_->HandleQueryExecutionComplete(query_id_); }
+  void Done() override {
+    if (query_span_table_ != nullptr) {
+      ECHECK_OK(query_span_table_->Flush());
+    }
+    parent_->HandleQueryExecutionComplete(query_id_);
+  }
 
  private:
+  void RecordSpans(int64_t work_start_ns, int64_t work_end_ns) {
+    if (query_span_table_ == nullptr) {
+      return;
+    }
+    if (req_.plan_start_time_ns() != 0) {
+      int64_t compile_end_ns = req_.plan_start_time_ns() + req_.compile_time_ns();
+      query_span_table_->Record(query_id_, "broker.compile", req_.plan_start_time_ns(),
+                                compile_end_ns);
+      query_span_table_->Record(query_id_, "broker.distributed_plan", compile_end_ns,
+                                compile_end_ns + req_.distributed_plan_time_ns());
+    }
+    if (req_.dispatch_time_ns() != 0) {
+      query_span_table_->Record(query_id_, "nats.dispatch", req_.dispatch_time_ns(),
+                                received_time_ns_);
+    }
+    query_span_table_->Record(query_id_, "agent.queue", received_time_ns_, work_start_ns);
+    query_span_table_->Record(query_id_, "agent.execute", work_start_ns, work_end_ns);
+  }
+
   ExecuteQueryMessageHandler* parent_;
   carnot::Carnot* carnot_;
+  QuerySpanTable* query_span_table_;
 
   std::unique_ptr<messages::VizierMessage> msg_;
   const messages::ExecuteQueryRequest& req_;
   sole::uuid query_id_;
+  // When the agent got the query.
+  int64_t received_time_ns_;
 };
 
 ExecuteQueryMessageHandler::ExecuteQueryMessageHandler(px::event::Dispatcher* dispatcher,
                                                        Info* agent_info,
                                                        Manager::VizierNATSConnector* nats_conn,
-                                                       carnot::Carnot* carnot)
-    : MessageHandler(dispatcher, agent_info, nats_conn), carnot_(carnot) {}
+                                                       carnot::Carnot* carnot,
+                                                       QuerySpanTable* query_span_table)
+    : MessageHandler(dispatcher, agent_info, nats_conn),
+      carnot_(carnot),
+      query_span_table_(query_span_table),
+      scheduler_(std::max<int64_t>(0, FLAGS_agent_max_concurrent_queries)),
+      max_running_queries_(scheduler_.max_running_queries()) {
+  if (!FLAGS_agent_query_cpus.empty()) {
+    auto cpus = system::ParseCPUList(FLAGS_agent_query_cpus);
+    LOG_IF(ERROR, !cpus.ok()) << absl::Substitute("Ignoring --agent_query_cpus: $0", cpus.msg());
+    if (cpus.ok()) {
+      query_cpus_ = cpus.ConsumeValueOrDie();
+    }
+  }
+}
 
 Status ExecuteQueryMessageHandler::HandleMessage(std::unique_ptr<messages::VizierMessage> msg) {
-  // Create a task and run it on the threadpool.
-  auto task = std::make_unique<ExecuteQueryTask>(this, carnot_, std::move(msg));
+  auto* plan_options = msg->mutable_execute_query_request()->mutable_plan()->mutable_plan_options();
+  auto priority = plan_options->priority();
+  if (priority == PlanOptions::BACKGROUND && plan_options->cpu_quota() == 0) {
+    plan_options->set_cpu_quota(FLAGS_agent_background_query_cpu_quota);
+  }
+
+  // Create a task and run it on the threadpool once the scheduler admits it.
+  auto task = std::make_unique<ExecuteQueryTask>(this, carnot_, query_span_table_, std::move(msg));
 
   auto query_id = task->query_id();
   auto runnable = dispatcher()->CreateAsyncTask(std::move(task));
   auto runnable_ptr = runnable.get();
   LOG(INFO) << "Queries in flight: " << running_queries_.size();
   running_queries_[query_id] = std::move(runnable);
+  if (!scheduler_.Admit(query_id, priority, plan_options->streaming())) {
+    LOG(INFO) << absl::Substitute("Queued query: id=$0 priority=$1, $2", query_id.str(),
+                                  PlanOptions::QueryPriority_Name(priority),
+                                  scheduler_.DebugString());
+    return Status::OK();
+  }
   runnable_ptr->Run();
 
   return Status::OK();
@@ -103,6 +178,28 @@ void ExecuteQueryMessageHandler::HandleQueryExecutionComplete(sole::uuid query_i
     return;
   }
   dispatcher()->DeferredDelete(std::move(node.mapped()));
+  StartQueries(scheduler_.Finish(query_id));
+}
+
+void ExecuteQueryMessageHandler::SetThrottled(bool throttled) {
+  if (throttled == throttled_) {
+    return;
+  }
+  throttled_ = throttled;
+  LOG(INFO) << absl::Substitute("$0 queries, $1", throttled ? "Throttling" : "Unthrottling",
+                                scheduler_.DebugString());
+  StartQueries(scheduler_.SetMaxRunningQueries(throttled ? 1 : max_running_queries_));
+}
+
+void ExecuteQueryMessageHandler::StartQueries(const std::vector<sole::uuid>& query_ids) {
+  for (const auto& query_id : query_ids) {
+    auto it = running_queries_.find(query_id);
+    if (it == running_queries_.end()) {
+      LOG(ERROR) << "Attempting to start non-existent query: " << query_id.str();
+      continue;
+    }
+    it->second->Run();
+  }
 }
 
 }  // namespace agent
@@ -19,10 +19,18 @@
 #pragma once
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <absl/container/flat_hash_map.h>
 #include "src/carnot/plan/plan.h"
 #include "src/vizier/services/agent/manager/manager.h"
+#include "src/vizier/services/agent/manager/query_scheduler.h"
+#include "src/vizier/services/agent/manager/query_spans.h"
+
+DECLARE_int64(agent_max_concurrent_queries);
+DECLARE_double(agent_background_query_cpu_quota);
+DECLARE_string(agent_query_cpus);
 
 namespace px {
 namespace vizier {
@@ -34,16 +42,31 @@ namespace agent {
  * otherwise only query execution is performed.
  *
  * This class runs all of it's work on a thread pool and tracks pending queries internally.
+ * Queries beyond the agent's concurrency budget wait for a slot, see QueryScheduler.
+ * The stages of each query are recorded in the query span table, when there is one.
  */
 class ExecuteQueryMessageHandler : public Manager::MessageHandler {
  public:
   ExecuteQueryMessageHandler() = delete;
   ExecuteQueryMessageHandler(px::event::Dispatcher* dispatcher, Info* agent_info,
-                             Manager::VizierNATSConnector* nats_conn, carnot::Carnot* carnot);
+                             Manager::VizierNATSConnector* nats_conn, carnot::Carnot* carnot,
+                             QuerySpanTable* query_span_table);
   ~ExecuteQueryMessageHandler() override = default;
 
   Status HandleMessage(std::unique_ptr<messages::VizierMessage> msg) override;
 
+  /**
+   * While throttled, runs one query at a time, to leave the CPU to data collection. Internal and
+   * streaming queries are still always admitted.
+   */
+  void SetThrottled(bool throttled);
+
+  /**
+   * Pins the threads that execute queries to the CPUs, or leaves them unpinned if empty.
+   * Defaults to --agent_query_cpus. Must be called before the first query arrives.
+   */
+  void SetQueryCPUs(std::vector<int> cpus) { query_cpus_ = std::move(cpus); }
+
  protected:
   /**
    * HandleQueryExecutionComplete can be called by the async task to signal that work has been
@@ -55,10 +78,19 @@ class ExecuteQueryMessageHandler : public Manager::MessageHandler {
   // Forward declare private task class.
   class ExecuteQueryTask;
 
+  // Runs the queries that the scheduler admitted.
+  void StartQueries(const std::vector<sole::uuid>& query_ids);
+
   carnot::Carnot* carnot_;
+  QuerySpanTable* query_span_table_;
 
-  // Map from query_id -> Running query task.
+  // Map from query_id -> Running or queued query task.
   absl::flat_hash_map<sole::uuid, px::event::RunnableAsyncTaskUPtr> running_queries_;
+  QueryScheduler scheduler_;
+  // The scheduler's budget while not throttled.
+  const int64_t max_running_queries_;
+  bool throttled_ = false;
+  std::vector<int> query_cpus_;
 };
 
 }  // namespace agent
@@ -24,6 +24,12 @@
 
 #include "src/vizier/services/agent/manager/manager.h"
 
+DEFINE_int64(heartbeat_max_pid_updates,
+             gflags::Int64FromEnv("PL_HEARTBEAT_MAX_PID_UPDATES", 10000),
+             "The most process creations and terminations sent in a heartbeat. The others are "
+             "sent in the following heartbeats, so that heartbeats stay small on nodes with a lot "
+             "of process churn.");
+
 namespace px {
 namespace vizier {
 namespace agent {
@@ -164,16 +170,24 @@ Status HeartbeatMessageHandler::HandleMessage(std::unique_ptr<messages::VizierMe
 }
 
 void HeartbeatMessageHandler::ConsumeAgentPIDUpdates(messages::AgentUpdateInfo* update_info) {
-  while (auto pid_event = mds_manager_->GetNextPIDStatusEvent()) {
+  // The index in process_created of the processes created in this update.
+  absl::flat_hash_map<md::UPID, int> created_processes;
+  int64_t num_events = 0;
+  while (num_events < FLAGS_heartbeat_max_pid_updates) {
+    auto pid_event = mds_manager_->GetNextPIDStatusEvent();
+    if (pid_event == nullptr) {
+      break;
+    }
+    ++num_events;
     switch (pid_event->type) {
       case px::md::PIDStatusEventType::kStarted: {
         auto* ev = static_cast<px::md::PIDStartedEvent*>(pid_event.get());
-        ProcessPIDStartedEvent(*ev, update_info);
+        ProcessPIDStartedEvent(*ev, update_info, &created_processes);
         break;
       }
       case px::md::PIDStatusEventType::kTerminated: {
         auto* ev = static_cast<px::md::PIDTerminatedEvent*>(pid_event.get());
-        ProcessPIDTerminatedEvent(*ev, update_info);
+        ProcessPIDTerminatedEvent(*ev, update_info, created_processes);
         break;
       }
       default:
@@ -182,8 +196,10 @@ void HeartbeatMessageHandler::ConsumeAgentPIDUpdates(messages::AgentUpdateInfo*
   }
 }
 
-void HeartbeatMessageHandler::ProcessPIDStartedEvent(const px::md::PIDStartedEvent& ev,
-                                                     messages::AgentUpdateInfo* update_info) {
+void HeartbeatMessageHandler::ProcessPIDStartedEvent(
+    const px::md::PIDStartedEvent& ev, messages::AgentUpdateInfo* update_info,
+    absl::flat_hash_map<md::UPID, int>* created_processes) {
+  (*created_processes)[ev.pid_info.upid()] = update_info->process_created_size();
   auto* process_info = update_info->add_process_created();
 
   auto upid = ev.pid_info.upid();
@@ -196,8 +212,17 @@ void HeartbeatMessageHandler::ProcessPIDStartedEvent(const px::md::PIDStartedEve
   process_info->set_cid(ev.pid_info.cid());
 }
 
-void HeartbeatMessageHandler::ProcessPIDTerminatedEvent(const px::md::PIDTerminatedEvent& ev,
-                                                        messages::AgentUpdateInfo* update_info) {
+void HeartbeatMessageHandler::ProcessPIDTerminatedEvent(
+    const px::md::PIDTerminatedEvent& ev, messages::AgentUpdateInfo* update_info,
+    const absl::flat_hash_map<md::UPID, int>& created_processes) {
+  // Short-lived processes are sent as one ProcessCreated, rather than a ProcessCreated and a
+  // ProcessTerminated that the metadata service would apply one after the other.
+  auto it = created_processes.find(ev.upid);
+  if (it != created_processes.end()) {
+    update_info->mutable_process_created(it->second)->set_stop_timestamp_ns(ev.stop_time_ns);
+    return;
+  }
+
   auto process_info = update_info->add_process_terminated();
   process_info->set_stop_timestamp_ns(ev.stop_time_ns);
 
@@ -20,8 +20,12 @@
 
 #include <memory>
 
+#include <absl/container/flat_hash_map.h>
+
 #include "src/vizier/services/agent/manager/manager.h"
 
+DECLARE_int64(heartbeat_max_pid_updates);
+
 namespace px {
 namespace vizier {
 namespace agent {
@@ -41,12 +45,16 @@ class HeartbeatMessageHandler : public Manager::MessageHandler {
   void EnableHeartbeats();
 
  private:
+  // Adds up to --heartbeat_max_pid_updates PID events to the update. A process that terminated
+  // before its creation was sent is sent as a single ProcessCreated with its stop time.
   void ConsumeAgentPIDUpdates(messages::AgentUpdateInfo* update_info);
   void ProcessPIDStartedEvent(const px::md::PIDStartedEvent& ev,
-                              messages::AgentUpdateInfo* update_info);
+                              messages::AgentUpdateInfo* update_info,
+                              absl::flat_hash_map<md::UPID, int>* created_processes);
 
   void ProcessPIDTerminatedEvent(const px::md::PIDTerminatedEvent& ev,
-                                 messages::AgentUpdateInfo* update_info);
+                                 messages::AgentUpdateInfo* update_info,
+                                 const absl::flat_hash_map<md::UPID, int>& created_processes);
 
   void DoHeartbeats();
 
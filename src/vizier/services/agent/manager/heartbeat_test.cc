@@ -217,6 +217,50 @@ TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeat) {
   EXPECT_FALSE(hb.update_info().data().has_metadata_info());
 }
 
+TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatShortLivedProcess) {
+  auto start_time_nanos = time_to_nanos(start_monotonic_time_);
+  md::UPID upid(1, 2, start_time_nanos);
+  md::PIDInfo pid_info(upid, "./a_command", "example_container");
+  mds_manager_->AddPIDStatusEvent(std::make_unique<md::PIDStartedEvent>(pid_info));
+  mds_manager_->AddPIDStatusEvent(
+      std::make_unique<md::PIDTerminatedEvent>(upid, start_time_nanos + 10));
+
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  ASSERT_EQ(1, nats_conn_->published_msgs().size());
+  auto hb = nats_conn_->published_msgs()[0].heartbeat();
+  // The process that terminated before its creation was sent is sent once, with its stop time.
+  ASSERT_EQ(1, hb.update_info().process_created_size());
+  const auto& process = hb.update_info().process_created(0);
+  EXPECT_EQ(absl::Uint128Low64(upid.value()), process.upid().low());
+  EXPECT_EQ(start_time_nanos, process.start_timestamp_ns());
+  EXPECT_EQ(start_time_nanos + 10, process.stop_timestamp_ns());
+  EXPECT_EQ(0, hb.update_info().process_terminated_size());
+}
+
+TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatMaxPIDUpdates) {
+  FLAGS_heartbeat_max_pid_updates = 2;
+  auto start_time_nanos = time_to_nanos(start_monotonic_time_);
+  for (int i = 0; i < 3; ++i) {
+    md::PIDInfo pid_info(md::UPID(1, 2 + i, start_time_nanos), "./a_command", "container");
+    mds_manager_->AddPIDStatusEvent(std::make_unique<md::PIDStartedEvent>(pid_info));
+  }
+
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  ASSERT_EQ(1, nats_conn_->published_msgs().size());
+  EXPECT_EQ(2, nats_conn_->published_msgs()[0].heartbeat().update_info().process_created_size());
+
+  auto hb_ack = std::make_unique<messages::VizierMessage>();
+  hb_ack->mutable_heartbeat_ack()->set_sequence_number(0);
+  EXPECT_OK(heartbeat_handler_->HandleMessage(std::move(hb_ack)));
+
+  // The remaining update is sent in the next heartbeat.
+  time_system_->SetMonotonicTime(start_monotonic_time_ + std::chrono::seconds(5));
+  dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
+  FLAGS_heartbeat_max_pid_updates = 10000;
+  ASSERT_EQ(2, nats_conn_->published_msgs().size());
+  EXPECT_EQ(1, nats_conn_->published_msgs()[1].heartbeat().update_info().process_created_size());
+}
+
 TEST_F(HeartbeatMessageHandlerTest, HandleHeartbeatMetadataChange) {
   // Tthe metadata info should be resent when it changes.
   dispatcher_->Run(event::Dispatcher::RunType::NonBlock);
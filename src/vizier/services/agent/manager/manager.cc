@@ -20,6 +20,7 @@
 
 #include <limits.h>
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <random>
@@ -56,6 +57,10 @@ px::StatusOr<std::string> GetHostname() {
 
 DEFINE_string(jwt_signing_key, gflags::StringFromEnv("PL_JWT_SIGNING_KEY", ""),
               "The JWT signing key for outgoing requests");
+DEFINE_int32(agent_result_sink_chans_per_addr,
+             gflags::Int32FromEnv("PL_AGENT_RESULT_SINK_CHANS_PER_ADDR", 4),
+             "The number of channels, each with its own connection, that result sinks use to send "
+             "to a single address. Stubs are handed out over the channels in turn.");
 
 namespace px {
 namespace vizier {
@@ -127,6 +132,15 @@ Status Manager::Init() {
       md::AgentMetadataFilter::Create(kMetadataFilterMaxEntries, kMetadataFilterMaxErrorRate,
                                       md::kMetadataFilterEntities));
   chan_cache_ = std::make_unique<ChanCache>(kChanIdleGracePeriod);
+
+  query_span_table_ = std::make_unique<QuerySpanTable>(
+      info_.agent_id, info_.capabilities.collects_data() ? "pem" : "kelvin");
+  PL_RETURN_IF_ERROR(query_span_table_->Init(table_store_.get(), relation_info_manager_.get()));
+  carnot_->RegisterQuerySpanCallback([this](const sole::uuid& query_id, std::string_view span,
+                                            int64_t start_time_ns, int64_t end_time_ns) {
+    query_span_table_->Record(query_id, span, start_time_ns, end_time_ns);
+  });
+
   auto hostname_or_s = GetHostname();
   if (!hostname_or_s.ok()) {
     return hostname_or_s.status();
@@ -314,7 +328,10 @@ Status Manager::PostRegisterHook(uint32_t asid) {
     // TODO(james): when we change ExecState::exec_mem_pool to not return just the default pool, we
     // will need to figure out how to use the correct memory pool here, but for now we can just use
     // the default pool.
+    // Background queries give up the CPU while compaction runs.
+    carnot_->PauseQueries(carnot::planpb::PlanOptions::BACKGROUND);
     auto status = table_store()->RunCompaction(arrow::default_memory_pool());
+    carnot_->ResumeQueries(carnot::planpb::PlanOptions::BACKGROUND);
     LOG_IF(ERROR, !status.ok()) << status.msg();
     if (tablestore_compaction_timer_) {
       tablestore_compaction_timer_->EnableTimer(kTableStoreCompactionPeriod);
@@ -341,12 +358,19 @@ Status Manager::PostReregisterHook(uint32_t asid) {
 
 std::unique_ptr<Manager::ResultSinkStub> Manager::ResultSinkStubGenerator(
     const std::string& remote_addr, const std::string& ssl_targetname) {
-  auto chan = chan_cache_->GetChan(remote_addr);
-  if (chan != nullptr) {
-    return px::carnotpb::ResultSinkService::NewStub(chan);
+  size_t max_chans = std::max(1, FLAGS_agent_result_sink_chans_per_addr);
+  if (chan_cache_->NumChans(remote_addr) >= max_chans) {
+    auto chan = chan_cache_->GetChan(remote_addr);
+    // The channels may have been cleaned up in the meantime.
+    if (chan != nullptr) {
+      return px::carnotpb::ResultSinkService::NewStub(chan);
+    }
   }
 
   grpc::ChannelArguments args;
+  // Channels with the same arguments share their connection by default. Give each channel its own
+  // connection, so that the load of an address is spread over several connections.
+  args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
   if (ssl_targetname.size()) {
     args.SetSslTargetNameOverride(ssl_targetname);
   }
@@ -357,7 +381,9 @@ std::unique_ptr<Manager::ResultSinkStub> Manager::ResultSinkStubGenerator(
   args.SetInt(GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS, 50000);
   args.SetInt(GRPC_ARG_HTTP2_MIN_SENT_PING_INTERVAL_WITHOUT_DATA_MS, 100000);
 
-  chan = grpc::CreateCustomChannel(remote_addr, grpc_channel_creds_, args);
+  auto chan = grpc::CreateCustomChannel(remote_addr, grpc_channel_creds_, args);
+  // Start connecting right away, the stub's first call usually follows shortly.
+  chan->GetState(/*try_to_connect*/ true);
   chan_cache_->Add(remote_addr, chan);
   return px::carnotpb::ResultSinkService::NewStub(chan);
 }
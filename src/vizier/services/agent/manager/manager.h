@@ -34,6 +34,7 @@
 #include "src/vizier/funcs/context/vizier_context.h"
 #include "src/vizier/messages/messagespb/messages.pb.h"
 #include "src/vizier/services/agent/manager/chan_cache.h"
+#include "src/vizier/services/agent/manager/query_spans.h"
 #include "src/vizier/services/agent/manager/relation_info_manager.h"
 
 #include "src/vizier/services/metadata/metadatapb/service.grpc.pb.h"
@@ -158,6 +159,7 @@ class Manager : public px::NotCopyable {
   RelationInfoManager* relation_info_manager() { return relation_info_manager_.get(); }
   px::event::Dispatcher* dispatcher() { return dispatcher_.get(); }
   carnot::Carnot* carnot() { return carnot_.get(); }
+  QuerySpanTable* query_span_table() { return query_span_table_.get(); }
   const Info* info() const { return &info_; }
   Info* info() { return &info_; }
   VizierNATSConnector* agent_nats_connector() { return agent_nats_connector_.get(); }
@@ -223,6 +225,7 @@ class Manager : public px::NotCopyable {
   std::shared_ptr<table_store::TableStore> table_store_;
   std::unique_ptr<px::md::AgentMetadataStateManager> mds_manager_;
   std::unique_ptr<RelationInfoManager> relation_info_manager_;
+  std::unique_ptr<QuerySpanTable> query_span_table_;
 
   // Factory context for vizier functions.
   funcs::VizierFuncFactoryContext func_context_;
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/manager/query_scheduler.h"
+
+#include <algorithm>
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+using carnot::planpb::PlanOptions;
+
+bool QueryScheduler::Admit(const sole::uuid& query_id, Priority priority, bool long_lived) {
+  if (priority == PlanOptions::INTERNAL || long_lived) {
+    Start(query_id, priority, /* takes_slot */ false);
+    return true;
+  }
+  if (HasFreeSlot()) {
+    Start(query_id, priority, /* takes_slot */ true);
+    return true;
+  }
+  queues_[priority].push_back({query_id, std::chrono::steady_clock::now()});
+  ++stats_[priority].queued;
+  return false;
+}
+
+void QueryScheduler::Start(const sole::uuid& query_id, Priority priority, bool takes_slot) {
+  running_[query_id] = takes_slot;
+  if (takes_slot) {
+    ++slots_used_;
+  }
+  ++stats_[priority].admitted;
+}
+
+std::vector<sole::uuid> QueryScheduler::Finish(const sole::uuid& query_id) {
+  std::vector<sole::uuid> started;
+  auto it = running_.find(query_id);
+  if (it == running_.end()) {
+    for (auto& queue : queues_) {
+      auto queued = std::find_if(queue.begin(), queue.end(),
+                                 [&](const QueuedQuery& q) { return q.query_id == query_id; });
+      if (queued != queue.end()) {
+        queue.erase(queued);
+        break;
+      }
+    }
+    return started;
+  }
+  if (it->second) {
+    --slots_used_;
+  }
+  running_.erase(it);
+  StartQueued(&started);
+  return started;
+}
+
+std::vector<sole::uuid> QueryScheduler::SetMaxRunningQueries(int64_t max_running_queries) {
+  max_running_queries_ = max_running_queries;
+  std::vector<sole::uuid> started;
+  StartQueued(&started);
+  return started;
+}
+
+void QueryScheduler::StartQueued(std::vector<sole::uuid>* started) {
+  auto now = std::chrono::steady_clock::now();
+  for (auto priority : {PlanOptions::INTERACTIVE, PlanOptions::BACKGROUND}) {
+    auto& queue = queues_[priority];
+    while (!queue.empty() && HasFreeSlot()) {
+      std::chrono::nanoseconds wait = now - queue.front().queued_at;
+      auto& stats = stats_[priority];
+      stats.total_queue_time += wait;
+      stats.max_queue_time = std::max(stats.max_queue_time, wait);
+      Start(queue.front().query_id, priority, /* takes_slot */ true);
+      started->push_back(queue.front().query_id);
+      queue.pop_front();
+    }
+  }
+}
+
+int64_t QueryScheduler::num_queued() const {
+  int64_t num_queued = 0;
+  for (const auto& queue : queues_) {
+    num_queued += queue.size();
+  }
+  return num_queued;
+}
+
+std::string QueryScheduler::DebugString() const {
+  std::string out = absl::Substitute("running=$0/$1 queued=$2", slots_used_, max_running_queries_,
+                                     num_queued());
+  for (int i = 0; i < PlanOptions::QueryPriority_ARRAYSIZE; ++i) {
+    const auto& stats = stats_[i];
+    absl::StrAppend(&out, absl::Substitute(
+                              " $0{admitted=$1 queued=$2 waiting=$3 total_wait_ms=$4 "
+                              "max_wait_ms=$5}",
+                              PlanOptions::QueryPriority_Name(static_cast<Priority>(i)),
+                              stats.admitted, stats.queued, queues_[i].size(),
+                              std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  stats.total_queue_time)
+                                  .count(),
+                              std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  stats.max_queue_time)
+                                  .count()));
+  }
+  return out;
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <sole.hpp>
+
+#include "src/carnot/planpb/plan.pb.h"
+#include "src/common/base/base.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+/**
+ * QueryScheduler bounds the number of queries an agent runs at once. Queries over the budget wait
+ * in a queue per priority, and interactive queries get the next free slot before background
+ * ones. Internal queries and long-lived (streaming) queries are always admitted and don't take a
+ * slot, since they would otherwise hold it for as long as they run.
+ *
+ * The scheduler isn't thread safe, it's only used from the agent's event loop.
+ */
+class QueryScheduler : public NotCopyable {
+ public:
+  using Priority = carnot::planpb::PlanOptions::QueryPriority;
+
+  struct PriorityStats {
+    // The number of queries of this priority that have been admitted, after waiting or not.
+    int64_t admitted = 0;
+    // The number of those queries that had to wait for a slot.
+    int64_t queued = 0;
+    // The time admitted queries spent waiting, in total and at most.
+    std::chrono::nanoseconds total_queue_time{0};
+    std::chrono::nanoseconds max_queue_time{0};
+  };
+
+  /**
+   * @param max_running_queries The number of slots. 0 means unlimited.
+   */
+  explicit QueryScheduler(int64_t max_running_queries)
+      : max_running_queries_(max_running_queries) {}
+
+  /**
+   * Asks for a slot for the query.
+   * @param long_lived Whether the query runs until it is stopped, ie. it streams.
+   * @return true if the query can start now, false if it was queued until a slot frees up.
+   */
+  bool Admit(const sole::uuid& query_id, Priority priority, bool long_lived = false);
+
+  /**
+   * Releases the slot of a finished query, or drops the query from its queue if it never started.
+   * @return the queries that were admitted into the freed slot, in the order to start them.
+   */
+  std::vector<sole::uuid> Finish(const sole::uuid& query_id);
+
+  /**
+   * Changes the number of queries that run at once. Running queries over a lowered budget go on
+   * until they finish, and queued queries get the slots of a raised one.
+   * @return the queries that were admitted into the new slots, in the order to start them.
+   */
+  std::vector<sole::uuid> SetMaxRunningQueries(int64_t max_running_queries);
+
+  int64_t max_running_queries() const { return max_running_queries_; }
+  int64_t num_running() const { return running_.size(); }
+  int64_t num_queued() const;
+  const PriorityStats& stats(Priority priority) const { return stats_[priority]; }
+
+  std::string DebugString() const;
+
+ private:
+  struct QueuedQuery {
+    sole::uuid query_id;
+    std::chrono::steady_clock::time_point queued_at;
+  };
+
+  bool HasFreeSlot() const {
+    return max_running_queries_ <= 0 || slots_used_ < max_running_queries_;
+  }
+  void Start(const sole::uuid& query_id, Priority priority, bool takes_slot);
+  // Starts queued queries while there are free slots, and appends them to started.
+  void StartQueued(std::vector<sole::uuid>* started);
+
+  int64_t max_running_queries_;
+  // The queries that hold a slot, internal and long-lived queries excluded.
+  int64_t slots_used_ = 0;
+  // Whether each running query holds a slot.
+  absl::flat_hash_map<sole::uuid, bool> running_;
+  // The waiting queries of each priority, oldest first. Indexed by priority.
+  std::array<std::deque<QueuedQuery>, carnot::planpb::PlanOptions::QueryPriority_ARRAYSIZE>
+      queues_;
+  std::array<PriorityStats, carnot::planpb::PlanOptions::QueryPriority_ARRAYSIZE> stats_;
+};
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
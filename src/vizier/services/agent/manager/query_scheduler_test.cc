@@ -0,0 +1,143 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/manager/query_scheduler.h"
+
+#include <vector>
+
+#include "src/common/testing/testing.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+using carnot::planpb::PlanOptions;
+
+TEST(QuerySchedulerTest, admits_up_to_the_budget) {
+  QueryScheduler scheduler(2);
+  auto q1 = sole::uuid4();
+  auto q2 = sole::uuid4();
+  auto q3 = sole::uuid4();
+
+  EXPECT_TRUE(scheduler.Admit(q1, PlanOptions::INTERACTIVE));
+  EXPECT_TRUE(scheduler.Admit(q2, PlanOptions::BACKGROUND));
+  EXPECT_FALSE(scheduler.Admit(q3, PlanOptions::INTERACTIVE));
+  EXPECT_EQ(2, scheduler.num_running());
+  EXPECT_EQ(1, scheduler.num_queued());
+
+  EXPECT_THAT(scheduler.Finish(q1), ::testing::ElementsAre(q3));
+  EXPECT_EQ(0, scheduler.num_queued());
+  EXPECT_THAT(scheduler.Finish(q3), ::testing::IsEmpty());
+  EXPECT_THAT(scheduler.Finish(q2), ::testing::IsEmpty());
+  EXPECT_EQ(0, scheduler.num_running());
+
+  EXPECT_EQ(2, scheduler.stats(PlanOptions::INTERACTIVE).admitted);
+  EXPECT_EQ(1, scheduler.stats(PlanOptions::INTERACTIVE).queued);
+  EXPECT_EQ(1, scheduler.stats(PlanOptions::BACKGROUND).admitted);
+  EXPECT_EQ(0, scheduler.stats(PlanOptions::BACKGROUND).queued);
+}
+
+TEST(QuerySchedulerTest, interactive_before_background) {
+  QueryScheduler scheduler(1);
+  auto running = sole::uuid4();
+  auto background = sole::uuid4();
+  auto interactive = sole::uuid4();
+
+  EXPECT_TRUE(scheduler.Admit(running, PlanOptions::BACKGROUND));
+  EXPECT_FALSE(scheduler.Admit(background, PlanOptions::BACKGROUND));
+  EXPECT_FALSE(scheduler.Admit(interactive, PlanOptions::INTERACTIVE));
+
+  EXPECT_THAT(scheduler.Finish(running), ::testing::ElementsAre(interactive));
+  EXPECT_THAT(scheduler.Finish(interactive), ::testing::ElementsAre(background));
+  EXPECT_THAT(scheduler.Finish(background), ::testing::IsEmpty());
+}
+
+TEST(QuerySchedulerTest, internal_queries_skip_the_queue) {
+  QueryScheduler scheduler(1);
+  auto q1 = sole::uuid4();
+  auto q2 = sole::uuid4();
+  auto internal = sole::uuid4();
+
+  EXPECT_TRUE(scheduler.Admit(q1, PlanOptions::INTERACTIVE));
+  EXPECT_TRUE(scheduler.Admit(internal, PlanOptions::INTERNAL));
+  EXPECT_FALSE(scheduler.Admit(q2, PlanOptions::INTERACTIVE));
+
+  // Internal queries don't hold a slot, so finishing one doesn't start anything.
+  EXPECT_THAT(scheduler.Finish(internal), ::testing::IsEmpty());
+  EXPECT_THAT(scheduler.Finish(q1), ::testing::ElementsAre(q2));
+}
+
+TEST(QuerySchedulerTest, long_lived_queries_skip_the_queue) {
+  QueryScheduler scheduler(1);
+  auto stream = sole::uuid4();
+  auto q1 = sole::uuid4();
+
+  EXPECT_TRUE(scheduler.Admit(stream, PlanOptions::INTERACTIVE, /* long_lived */ true));
+  EXPECT_TRUE(scheduler.Admit(q1, PlanOptions::INTERACTIVE));
+  EXPECT_EQ(2, scheduler.num_running());
+  EXPECT_THAT(scheduler.Finish(stream), ::testing::IsEmpty());
+  EXPECT_THAT(scheduler.Finish(q1), ::testing::IsEmpty());
+}
+
+TEST(QuerySchedulerTest, unlimited_budget) {
+  QueryScheduler scheduler(0);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(scheduler.Admit(sole::uuid4(), PlanOptions::BACKGROUND));
+  }
+  EXPECT_EQ(100, scheduler.num_running());
+  EXPECT_EQ(0, scheduler.num_queued());
+}
+
+TEST(QuerySchedulerTest, finish_queued_query) {
+  QueryScheduler scheduler(1);
+  auto q1 = sole::uuid4();
+  auto q2 = sole::uuid4();
+
+  EXPECT_TRUE(scheduler.Admit(q1, PlanOptions::INTERACTIVE));
+  EXPECT_FALSE(scheduler.Admit(q2, PlanOptions::INTERACTIVE));
+  EXPECT_THAT(scheduler.Finish(q2), ::testing::IsEmpty());
+  EXPECT_EQ(0, scheduler.num_queued());
+  EXPECT_THAT(scheduler.Finish(q1), ::testing::IsEmpty());
+}
+
+TEST(QuerySchedulerTest, change_budget) {
+  QueryScheduler scheduler(2);
+  auto q1 = sole::uuid4();
+  auto q2 = sole::uuid4();
+  auto q3 = sole::uuid4();
+  auto q4 = sole::uuid4();
+
+  EXPECT_TRUE(scheduler.Admit(q1, PlanOptions::INTERACTIVE));
+  EXPECT_TRUE(scheduler.Admit(q2, PlanOptions::INTERACTIVE));
+
+  // Lowering the budget doesn't stop running queries, but new ones wait until it's met again.
+  EXPECT_THAT(scheduler.SetMaxRunningQueries(1), ::testing::IsEmpty());
+  EXPECT_FALSE(scheduler.Admit(q3, PlanOptions::BACKGROUND));
+  EXPECT_FALSE(scheduler.Admit(q4, PlanOptions::INTERACTIVE));
+  EXPECT_THAT(scheduler.Finish(q1), ::testing::IsEmpty());
+  EXPECT_THAT(scheduler.Finish(q2), ::testing::ElementsAre(q4));
+
+  // Raising it starts queued queries right away.
+  EXPECT_THAT(scheduler.SetMaxRunningQueries(2), ::testing::ElementsAre(q3));
+  EXPECT_EQ(2, scheduler.num_running());
+  EXPECT_EQ(0, scheduler.num_queued());
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/manager/query_spans.h"
+
+#include <algorithm>
+#include <utility>
+
+DEFINE_int64(agent_query_spans_table_size_bytes,
+             gflags::Int64FromEnv("PL_AGENT_QUERY_SPANS_TABLE_SIZE_BYTES", 4 * 1024 * 1024),
+             "The number of bytes that the px_query_spans table holds before it expires its oldest "
+             "rows.");
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+namespace {
+
+enum QuerySpanColumn {
+  kTime = 0,
+  kAgentID,
+  kAgentKind,
+  kQueryID,
+  kSpan,
+  kDurationNS,
+};
+
+}  // namespace
+
+table_store::schema::Relation QuerySpanTable::TableRelation() {
+  return table_store::schema::Relation(
+      {types::TIME64NS, types::STRING, types::STRING, types::STRING, types::STRING, types::INT64},
+      {"time_", "agent_id", "agent_kind", "query_id", "span", "duration_ns"});
+}
+
+Status QuerySpanTable::Init(table_store::TableStore* table_store,
+                            RelationInfoManager* relation_info_manager) {
+  table_ = std::make_shared<table_store::Table>(TableRelation(),
+                                                FLAGS_agent_query_spans_table_size_bytes);
+  table_store->AddTable(table_, kQuerySpansTableName);
+  return relation_info_manager->AddRelationInfo(
+      RelationInfo(kQuerySpansTableName, /* id */ 0,
+                   "The time spent in each stage of the queries that the agent ran",
+                   TableRelation()));
+}
+
+void QuerySpanTable::Record(const sole::uuid& query_id, std::string_view span,
+                            int64_t start_time_ns, int64_t end_time_ns) {
+  absl::MutexLock lock(&pending_lock_);
+  if (pending_ == nullptr) {
+    pending_ = std::make_unique<types::ColumnWrapperRecordBatch>();
+    auto relation = TableRelation();
+    for (auto type : relation.col_types()) {
+      pending_->push_back(types::ColumnWrapper::Make(type, 0));
+    }
+  }
+  auto& cols = *pending_;
+  cols[kTime]->Append<types::Time64NSValue>(start_time_ns);
+  cols[kAgentID]->Append<types::StringValue>(agent_id_);
+  cols[kAgentKind]->Append<types::StringValue>(agent_kind_);
+  cols[kQueryID]->Append<types::StringValue>(query_id.str());
+  cols[kSpan]->Append<types::StringValue>(std::string(span));
+  // The clocks of different hosts can make a span that crosses hosts come out negative.
+  cols[kDurationNS]->Append<types::Int64Value>(std::max<int64_t>(0, end_time_ns - start_time_ns));
+}
+
+Status QuerySpanTable::Flush() {
+  std::unique_ptr<types::ColumnWrapperRecordBatch> batch;
+  {
+    absl::MutexLock lock(&pending_lock_);
+    batch = std::move(pending_);
+  }
+  if (batch == nullptr || table_ == nullptr) {
+    return Status::OK();
+  }
+  return table_->TransferRecordBatch(std::move(batch));
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
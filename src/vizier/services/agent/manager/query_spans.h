@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <absl/synchronization/mutex.h>
+#include <sole.hpp>
+
+#include "src/common/base/base.h"
+#include "src/shared/types/column_wrapper.h"
+#include "src/table_store/table_store.h"
+#include "src/vizier/services/agent/manager/relation_info_manager.h"
+
+DECLARE_int64(agent_query_spans_table_size_bytes);
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+constexpr char kQuerySpansTableName[] = "px_query_spans";
+
+/**
+ * QuerySpanTable is the px_query_spans table of an agent. It has a row for each stage of the
+ * queries that the agent ran, with the start time and duration of the stage:
+ *   broker.compile, broker.distributed_plan: planning the query in the query broker, recorded by
+ *     one agent of the query.
+ *   nats.dispatch: from the query broker sending the query until the agent got it. This compares
+ *     clocks of different hosts.
+ *   agent.queue: waiting for a query slot on the agent.
+ *   agent.execute: running the query on the agent, made up of the carnot.* stages.
+ *
+ * Spans are recorded from any thread, and buffered until the next Flush.
+ */
+class QuerySpanTable : public NotCopyable {
+ public:
+  QuerySpanTable(const sole::uuid& agent_id, std::string_view agent_kind)
+      : agent_id_(agent_id.str()), agent_kind_(agent_kind) {}
+
+  static table_store::schema::Relation TableRelation();
+
+  /**
+   * Adds the table to the table store and to the schema of the agent.
+   */
+  Status Init(table_store::TableStore* table_store, RelationInfoManager* relation_info_manager);
+
+  void Record(const sole::uuid& query_id, std::string_view span, int64_t start_time_ns,
+              int64_t end_time_ns);
+
+  /**
+   * Writes the spans recorded since the previous call to the table.
+   */
+  Status Flush();
+
+ private:
+  const std::string agent_id_;
+  const std::string agent_kind_;
+  std::shared_ptr<table_store::Table> table_;
+
+  absl::Mutex pending_lock_;
+  std::unique_ptr<types::ColumnWrapperRecordBatch> pending_ ABSL_GUARDED_BY(pending_lock_);
+};
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/manager/query_spans.h"
+
+#include <memory>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+TEST(QuerySpanTableTest, RecordAndFlush) {
+  auto table_store = std::make_shared<table_store::TableStore>();
+  RelationInfoManager relation_info_manager;
+  auto agent_id = sole::uuid4();
+  QuerySpanTable query_span_table(agent_id, "pem");
+  ASSERT_OK(query_span_table.Init(table_store.get(), &relation_info_manager));
+  EXPECT_TRUE(relation_info_manager.HasRelation(kQuerySpansTableName));
+
+  auto query_id = sole::uuid4();
+  query_span_table.Record(query_id, "agent.queue", 100, 150);
+  query_span_table.Record(query_id, "agent.execute", 150, 1150);
+  // Spans across hosts can end before they start on the local clock.
+  query_span_table.Record(query_id, "nats.dispatch", 200, 100);
+  ASSERT_OK(query_span_table.Flush());
+  // Nothing to write.
+  ASSERT_OK(query_span_table.Flush());
+
+  table_store::Table* table = table_store->GetTable(kQuerySpansTableName);
+  ASSERT_NE(table, nullptr);
+  EXPECT_EQ(1, table->GetTableStats().num_batches);
+  auto rb = table
+                ->GetRowBatchSlice(table->FirstBatch(), std::vector<int64_t>({0, 1, 2, 3, 4, 5}),
+                                   arrow::default_memory_pool())
+                .ConsumeValueOrDie();
+  ASSERT_EQ(3, rb->num_rows());
+  EXPECT_TRUE(rb->ColumnAt(0)->Equals(types::ToArrow(
+      std::vector<types::Time64NSValue>({100, 150, 200}), arrow::default_memory_pool())));
+  EXPECT_TRUE(rb->ColumnAt(1)->Equals(
+      types::ToArrow(std::vector<types::StringValue>(3, agent_id.str()),
+                     arrow::default_memory_pool())));
+  EXPECT_TRUE(rb->ColumnAt(2)->Equals(
+      types::ToArrow(std::vector<types::StringValue>(3, "pem"), arrow::default_memory_pool())));
+  EXPECT_TRUE(rb->ColumnAt(3)->Equals(
+      types::ToArrow(std::vector<types::StringValue>(3, query_id.str()),
+                     arrow::default_memory_pool())));
+  EXPECT_TRUE(rb->ColumnAt(4)->Equals(
+      types::ToArrow(std::vector<types::StringValue>({"agent.queue", "agent.execute",
+                                                      "nats.dispatch"}),
+                     arrow::default_memory_pool())));
+  EXPECT_TRUE(rb->ColumnAt(5)->Equals(types::ToArrow(
+      std::vector<types::Int64Value>({50, 1000, 0}), arrow::default_memory_pool())));
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
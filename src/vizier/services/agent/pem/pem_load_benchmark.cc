@@ -0,0 +1,206 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Load tests the PEM's data pipeline without real traffic. The LoadGenConnector emits
+// http_events rows at --stirling_load_gen_rows_per_sec through Stirling's RunCore and data push
+// into a table store, which is compacted like the PEM does, while PxL queries run against it.
+// The PEM's NATS and metadata services are left out.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/substitute.h>
+#include <arrow/memory_pool.h>
+#include <sole.hpp>
+
+#include "src/carnot/carnot.h"
+#include "src/carnot/exec/local_grpc_result_server.h"
+#include "src/common/base/base.h"
+#include "src/shared/schema/utils.h"
+#include "src/stirling/source_connectors/load_gen/load_gen_connector.h"
+#include "src/stirling/stirling.h"
+#include "src/table_store/table_store.h"
+#include "src/vizier/services/agent/manager/manager.h"
+
+DEFINE_int32(duration_s, 60, "How long to run the load for.");
+DEFINE_int32(num_query_threads, 2, "The number of threads that run PxL queries back to back.");
+DEFINE_int32(query_pause_ms, 1000, "How long each query thread waits between its queries.");
+DEFINE_int32(report_period_s, 10, "How often to print the table and query stats.");
+
+using ::px::carnot::exec::LocalGRPCResultSinkServer;
+using ::px::stirling::LoadGenConnector;
+
+namespace {
+
+constexpr char kAggQuery[] = R"pxl(
+import px
+df = px.DataFrame(table='http_events', start_time='-30s')
+df.failure = df.resp_status >= 400
+df = df.groupby(['upid', 'req_path']).agg(
+    latency_quantiles=('latency', px.quantiles),
+    error_rate=('failure', px.mean),
+    throughput_total=('latency', px.count),
+)
+px.display(df, '$0')
+)pxl";
+
+constexpr char kFilterQuery[] = R"pxl(
+import px
+df = px.DataFrame(table='http_events', start_time='-5m')
+df = df[df.resp_status >= 500]
+df = df.head(1000)
+px.display(df[['time_', 'upid', 'req_path', 'resp_status', 'latency']], '$0')
+)pxl";
+
+constexpr const char* kQueries[] = {kAggQuery, kFilterQuery};
+
+// Creates the tables of the published schemas, like PEMManager::InitSchemas().
+void InitSchemas(px::stirling::Stirling* stirling, px::table_store::TableStore* table_store) {
+  px::stirling::stirlingpb::Publish publish_pb;
+  stirling->GetPublishProto(&publish_pb);
+  for (const auto& relation_info : px::ConvertPublishPBToRelationInfo(publish_pb)) {
+    std::shared_ptr<px::table_store::Table> table_ptr;
+    if (relation_info.name == "http_events") {
+      table_ptr = std::make_shared<px::table_store::Table>(relation_info.relation,
+                                                           1024 * 1024 * 512, 256 * 1024);
+    } else {
+      table_ptr = px::table_store::Table::Create(relation_info.relation);
+    }
+    table_store->AddTable(std::move(table_ptr), relation_info.name, relation_info.id);
+  }
+}
+
+struct QueryStats {
+  std::mutex mu;
+  std::vector<int64_t> latencies_ms;
+  int64_t num_failed = 0;
+};
+
+void RunQueries(px::carnot::Carnot* carnot, const std::atomic<bool>* done, int thread_idx,
+                QueryStats* stats) {
+  for (int i = 0; !*done; ++i) {
+    std::string query = absl::Substitute(kQueries[i % std::size(kQueries)],
+                                         absl::StrCat("results_", thread_idx, "_", i));
+    auto start = std::chrono::steady_clock::now();
+    px::Status s = carnot->ExecuteQuery(query, sole::uuid4(), px::CurrentTimeNS());
+    auto latency = std::chrono::steady_clock::now() - start;
+    {
+      std::lock_guard<std::mutex> lock(stats->mu);
+      if (s.ok()) {
+        stats->latencies_ms.push_back(
+            std::chrono::duration_cast<std::chrono::milliseconds>(latency).count());
+      } else {
+        LOG(WARNING) << absl::Substitute("Query failed: $0", s.msg());
+        ++stats->num_failed;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(FLAGS_query_pause_ms));
+  }
+}
+
+void Report(px::table_store::TableStore* table_store, QueryStats* stats) {
+  px::table_store::Table* table = table_store->GetTable("http_events");
+  px::table_store::TableStats table_stats = table->GetTableStats();
+  LOG(INFO) << absl::Substitute(
+      "http_events: rows=$0 bytes=$1 hot_bytes=$2 batches_added=$3 batches_expired=$4 "
+      "compaction_latency_ms=$5",
+      table_stats.num_rows, table_stats.bytes, table_stats.hot_bytes, table_stats.batches_added,
+      table_stats.batches_expired, table_stats.compaction_latency_ns / 1000 / 1000);
+
+  std::lock_guard<std::mutex> lock(stats->mu);
+  std::vector<int64_t>& latencies = stats->latencies_ms;
+  if (latencies.empty()) {
+    LOG(INFO) << absl::Substitute("queries: none finished, failed=$0", stats->num_failed);
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  LOG(INFO) << absl::Substitute("queries: count=$0 failed=$1 p50_ms=$2 p99_ms=$3 max_ms=$4",
+                                latencies.size(), stats->num_failed,
+                                latencies[latencies.size() / 2],
+                                latencies[latencies.size() * 99 / 100], latencies.back());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  px::EnvironmentGuard env_guard(&argc, argv);
+
+  auto registry = px::stirling::CreateSourceRegistry({LoadGenConnector::kName}).ConsumeValueOrDie();
+  std::unique_ptr<px::stirling::Stirling> stirling =
+      px::stirling::Stirling::Create(std::move(registry));
+
+  auto table_store = std::make_shared<px::table_store::TableStore>();
+  InitSchemas(stirling.get(), table_store.get());
+  stirling->RegisterDataPushCallback(std::bind(&px::table_store::TableStore::AppendData,
+                                               table_store.get(), std::placeholders::_1,
+                                               std::placeholders::_2, std::placeholders::_3));
+
+  LocalGRPCResultSinkServer result_server;
+  std::unique_ptr<px::carnot::Carnot> carnot =
+      px::carnot::Carnot::Create(sole::uuid4(), table_store,
+                                 std::bind(&LocalGRPCResultSinkServer::StubGenerator,
+                                           &result_server, std::placeholders::_1))
+          .ConsumeValueOrDie();
+
+  PL_CHECK_OK(stirling->RunAsThread());
+  PL_CHECK_OK(stirling->WaitUntilRunning(std::chrono::seconds(30)));
+
+  std::atomic<bool> done = false;
+  QueryStats query_stats;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < FLAGS_num_query_threads; ++i) {
+    threads.emplace_back(RunQueries, carnot.get(), &done, i, &query_stats);
+  }
+
+  // Compacts the table store like the PEM's agent manager does, pausing background queries.
+  const auto start = std::chrono::steady_clock::now();
+  const auto end = start + std::chrono::seconds(FLAGS_duration_s);
+  auto next_compaction = start + px::vizier::agent::kTableStoreCompactionPeriod;
+  auto next_report = start + std::chrono::seconds(FLAGS_report_period_s);
+  while (std::chrono::steady_clock::now() < end) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto now = std::chrono::steady_clock::now();
+    if (now >= next_compaction) {
+      carnot->PauseQueries(px::carnot::planpb::PlanOptions::BACKGROUND);
+      ECHECK_OK(table_store->RunCompaction(arrow::default_memory_pool()));
+      carnot->ResumeQueries(px::carnot::planpb::PlanOptions::BACKGROUND);
+      next_compaction = now + px::vizier::agent::kTableStoreCompactionPeriod;
+    }
+    if (now >= next_report) {
+      Report(table_store.get(), &query_stats);
+      next_report = now + std::chrono::seconds(FLAGS_report_period_s);
+    }
+  }
+
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  stirling->Stop();
+  Report(table_store.get(), &query_stats);
+  return 0;
+}
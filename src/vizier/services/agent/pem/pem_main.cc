@@ -30,6 +30,9 @@ DEFINE_string(pod_name, gflags::StringFromEnv("PL_POD_NAME", ""),
               "The name of the POD the PEM is running on");
 DEFINE_string(host_ip, gflags::StringFromEnv("PL_HOST_IP", ""),
               "The IP of the host this service is running on");
+DEFINE_int32(rpc_port, gflags::Int32FromEnv("PL_RPC_PORT", 0),
+             "The port of the RPC server that the PEM receives the inputs of broadcast joins on. "
+             "0 disables the server, and the joins then run on the Kelvin.");
 
 using ::px::vizier::agent::Manager;
 using ::px::vizier::agent::PEMManager;
@@ -92,7 +95,8 @@ int main(int argc, char** argv) {
   if (FLAGS_host_ip.length() == 0) {
     LOG(FATAL) << "The HOST_IP must be specified";
   }
-  auto manager = PEMManager::Create(agent_id, FLAGS_pod_name, FLAGS_host_ip, FLAGS_nats_url)
+  auto manager = PEMManager::Create(agent_id, FLAGS_pod_name, FLAGS_host_ip, FLAGS_rpc_port,
+                                    FLAGS_nats_url)
                      .ConsumeValueOrDie();
 
   AgentTerminationHandler::set_manager(manager.get());
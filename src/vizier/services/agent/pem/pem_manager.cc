@@ -18,6 +18,12 @@
 
 #include "src/vizier/services/agent/pem/pem_manager.h"
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "src/common/system/cpu_affinity.h"
+
 #include "src/vizier/services/agent/manager/exec.h"
 #include "src/vizier/services/agent/manager/manager.h"
 
@@ -25,6 +31,29 @@ namespace px {
 namespace vizier {
 namespace agent {
 
+namespace {
+// How often the agent checks whether Stirling asks for its queries to be throttled.
+constexpr std::chrono::seconds kOverloadPollPeriod{5};
+
+// The CPUs of the process that --stirling_cpus leaves for queries. Empty if Stirling isn't
+// pinned, or if it has all of them.
+std::vector<int> CPUsLeftByStirling() {
+  if (FLAGS_stirling_cpus.empty()) {
+    return {};
+  }
+  auto stirling_cpus = system::ParseCPUList(FLAGS_stirling_cpus);
+  auto process_cpus = system::CurrentThreadAffinity();
+  if (!stirling_cpus.ok() || !process_cpus.ok()) {
+    return {};
+  }
+  std::vector<int> cpus;
+  std::set_difference(process_cpus.ValueOrDie().begin(), process_cpus.ValueOrDie().end(),
+                      stirling_cpus.ValueOrDie().begin(), stirling_cpus.ValueOrDie().end(),
+                      std::back_inserter(cpus));
+  return cpus;
+}
+}  // namespace
+
 Status PEMManager::InitImpl() { return Status::OK(); }
 
 Status PEMManager::PostRegisterHookImpl() {
@@ -42,20 +71,54 @@ Status PEMManager::PostRegisterHookImpl() {
   PL_RETURN_IF_ERROR(InitSchemas());
   PL_RETURN_IF_ERROR(stirling_->RunAsThread());
 
-  auto execute_query_handler = std::make_shared<ExecuteQueryMessageHandler>(
-      dispatcher(), info(), agent_nats_connector(), carnot());
+  if (FLAGS_pem_enable_rollups) {
+    rollup_manager_ =
+        std::make_unique<RollupManager>(carnot(), table_store(), relation_info_manager());
+    PL_RETURN_IF_ERROR(rollup_manager_->Start(carnot::planner::DefaultRollups()));
+  }
+
+  execute_query_handler_ = std::make_shared<ExecuteQueryMessageHandler>(
+      dispatcher(), info(), agent_nats_connector(), carnot(), query_span_table());
+  if (FLAGS_agent_query_cpus.empty()) {
+    // Keeps queries off the CPUs that Stirling was pinned to.
+    execute_query_handler_->SetQueryCPUs(CPUsLeftByStirling());
+  }
   PL_RETURN_IF_ERROR(RegisterMessageHandler(messages::VizierMessage::MsgCase::kExecuteQueryRequest,
-                                            execute_query_handler));
+                                            execute_query_handler_));
+  overload_timer_ = dispatcher()->CreateTimer([this]() {
+    execute_query_handler_->SetThrottled(stirling_->overload_level() >=
+                                         stirling::OverloadLevel::kQueriesThrottled);
+    if (overload_timer_) {
+      overload_timer_->EnableTimer(kOverloadPollPeriod);
+    }
+  });
+  overload_timer_->EnableTimer(kOverloadPollPeriod);
 
   tracepoint_manager_ =
       std::make_shared<TracepointManager>(dispatcher(), info(), agent_nats_connector(),
                                           stirling_.get(), table_store(), relation_info_manager());
   PL_RETURN_IF_ERROR(RegisterMessageHandler(messages::VizierMessage::MsgCase::kTracepointMessage,
                                             tracepoint_manager_));
+
+  if (FLAGS_pem_table_store_stats_period_ms > 0) {
+    table_store_stats_ = std::make_unique<TableStoreStatsTable>(table_store());
+    PL_RETURN_IF_ERROR(table_store_stats_->Init(relation_info_manager()));
+    auto period = std::chrono::milliseconds(FLAGS_pem_table_store_stats_period_ms);
+    table_store_stats_timer_ = dispatcher()->CreateTimer([this, period]() {
+      ECHECK_OK(table_store_stats_->Sample(CurrentTimeNS()));
+      if (table_store_stats_timer_) {
+        table_store_stats_timer_->EnableTimer(period);
+      }
+    });
+    table_store_stats_timer_->EnableTimer(period);
+  }
   return Status::OK();
 }
 
 Status PEMManager::StopImpl(std::chrono::milliseconds) {
+  if (rollup_manager_ != nullptr) {
+    rollup_manager_->Stop();
+  }
   stirling_->Stop();
   return Status::OK();
 }
@@ -74,6 +137,11 @@ Status PEMManager::InitSchemas() {
     } else {
       table_ptr = table_store::Table::Create(relation_info.relation);
     }
+    if (relation_info.name == "stack_traces.beta") {
+      // The profiler only fills in stack_trace the first time it emits a stack_trace_id in each
+      // aging period of its ID cache, see --stirling_profiler_elide_repeated_stack_traces.
+      PL_RETURN_IF_ERROR(table_ptr->EnableStringDictionary("stack_trace_id", "stack_trace"));
+    }
 
     table_store()->AddTable(std::move(table_ptr), relation_info.name, relation_info.id);
     PL_RETURN_IF_ERROR(relation_info_manager()->AddRelationInfo(relation_info));
@@ -23,7 +23,10 @@
 #include <utility>
 
 #include "src/stirling/stirling.h"
+#include "src/vizier/services/agent/manager/exec.h"
 #include "src/vizier/services/agent/manager/manager.h"
+#include "src/vizier/services/agent/pem/rollup_manager.h"
+#include "src/vizier/services/agent/pem/table_store_stats.h"
 #include "src/vizier/services/agent/pem/tracepoint_manager.h"
 
 namespace px {
@@ -44,16 +47,22 @@ class PEMManager : public Manager {
  protected:
   PEMManager() = delete;
   PEMManager(sole::uuid agent_id, std::string_view pod_name, std::string_view host_ip,
-             std::string_view nats_url)
-      : PEMManager(agent_id, host_ip, pod_name, nats_url,
+             int grpc_server_port, std::string_view nats_url)
+      : PEMManager(agent_id, host_ip, pod_name, grpc_server_port, nats_url,
                    px::stirling::Stirling::Create(px::stirling::CreateProdSourceRegistry())) {}
 
   PEMManager(sole::uuid agent_id, std::string_view pod_name, std::string_view host_ip,
-             std::string_view nats_url, std::unique_ptr<stirling::Stirling> stirling)
-      : Manager(agent_id, host_ip, pod_name, /*grpc_server_port*/ 0, PEMManager::Capabilities(),
+             int grpc_server_port, std::string_view nats_url,
+             std::unique_ptr<stirling::Stirling> stirling)
+      : Manager(agent_id, host_ip, pod_name, grpc_server_port, PEMManager::Capabilities(),
                 nats_url,
                 /*mds_url*/ ""),
-        stirling_(std::move(stirling)) {}
+        stirling_(std::move(stirling)) {
+    // The Kelvin sends the inputs of broadcast joins to the GRPC server on the host network.
+    if (grpc_server_port > 0) {
+      info()->address = absl::Substitute("$0:$1", info()->host_ip, grpc_server_port);
+    }
+  }
 
   std::string k8s_update_selector() const override { return info()->host_ip; }
 
@@ -71,6 +80,12 @@ class PEMManager : public Manager {
 
   std::unique_ptr<stirling::Stirling> stirling_;
   std::shared_ptr<TracepointManager> tracepoint_manager_;
+  std::unique_ptr<RollupManager> rollup_manager_;
+  std::unique_ptr<TableStoreStatsTable> table_store_stats_;
+  px::event::TimerUPtr table_store_stats_timer_;
+  std::shared_ptr<ExecuteQueryMessageHandler> execute_query_handler_;
+  // Throttles the queries while Stirling is overloaded.
+  px::event::TimerUPtr overload_timer_;
 };
 
 }  // namespace agent
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/pem/rollup_manager.h"
+
+#include <chrono>
+#include <string>
+#include <utility>
+
+DEFINE_bool(pem_enable_rollups, gflags::BoolFromEnv("PL_PEM_ENABLE_ROLLUPS", false),
+            "Whether to maintain the rollup tables of the source tables, which the planner then "
+            "answers matching aggregates from.");
+DEFINE_int64(pem_rollup_table_size_bytes,
+             gflags::Int64FromEnv("PL_PEM_ROLLUP_TABLE_SIZE_BYTES", 64 * 1024 * 1024),
+             "The number of bytes that each rollup table holds before it expires its oldest rows.");
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+using carnot::planner::RollupDefinition;
+using table_store::schema::Relation;
+
+Status RollupManager::Start(const std::vector<RollupDefinition>& rollups) {
+  for (const auto& rollup : rollups) {
+    table_store::Table* source = table_store_->GetTable(rollup.source_table);
+    if (source == nullptr) {
+      VLOG(1) << absl::Substitute("Skipping rollup $0, there's no table $1", rollup.rollup_table,
+                                  rollup.source_table);
+      continue;
+    }
+    Relation source_relation = source->GetRelation();
+    PL_ASSIGN_OR_RETURN(Relation relation,
+                        carnot::planner::RollupRelation(rollup, source_relation));
+    PL_ASSIGN_OR_RETURN(planpb::Plan plan,
+                        carnot::planner::RollupMaintenancePlan(rollup, source_relation));
+
+    table_store_->AddTable(
+        std::make_shared<table_store::Table>(relation, FLAGS_pem_rollup_table_size_bytes),
+        rollup.rollup_table);
+    PL_RETURN_IF_ERROR(relation_info_manager_->AddRelationInfo(RelationInfo(
+        rollup.rollup_table, /* id */ 0,
+        absl::Substitute("Partial aggregates of $0 per $1ns bucket", rollup.source_table,
+                         rollup.bucket_ns),
+        relation)));
+
+    auto running = std::make_unique<RunningRollup>();
+    running->query_id = sole::uuid4();
+    running->thread = std::thread(
+        [this, plan = std::move(plan), running = running.get(), name = rollup.rollup_table]() {
+          auto s = carnot_->ExecutePlan(plan, running->query_id);
+          if (!s.ok()) {
+            LOG(ERROR) << absl::Substitute("Rollup $0 stopped: $1", name, s.msg());
+          }
+          running->done = true;
+        });
+    LOG(INFO) << absl::Substitute("Maintaining rollup $0 of $1: query id=$2", rollup.rollup_table,
+                                  rollup.source_table, running->query_id.str());
+    running_.push_back(std::move(running));
+  }
+  return Status::OK();
+}
+
+void RollupManager::Stop() {
+  for (auto& running : running_) {
+    // StopQuery fails until ExecutePlan has registered the query.
+    while (!running->done && !carnot_->StopQuery(running->query_id).ok()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    running->thread.join();
+  }
+  running_.clear();
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <sole.hpp>
+
+#include "src/carnot/carnot.h"
+#include "src/carnot/planner/rollup/rollup.h"
+#include "src/table_store/table_store.h"
+#include "src/vizier/services/agent/manager/relation_info_manager.h"
+
+DECLARE_bool(pem_enable_rollups);
+DECLARE_int64(pem_rollup_table_size_bytes);
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+/**
+ * RollupManager maintains the rollup tables of this agent. Each rollup table is a regular
+ * table in the table store, with a longer retention than its source table, that a continuous
+ * query on its own thread keeps appending the partial aggregates of the source to.
+ */
+class RollupManager : public NotCopyable {
+ public:
+  RollupManager(carnot::Carnot* carnot, table_store::TableStore* table_store,
+                RelationInfoManager* relation_info_manager)
+      : carnot_(carnot), table_store_(table_store), relation_info_manager_(relation_info_manager) {}
+  ~RollupManager() { Stop(); }
+
+  /**
+   * Creates the tables of the rollups whose source table this agent has, adds them to the schema
+   * and starts the queries that maintain them.
+   */
+  Status Start(const std::vector<carnot::planner::RollupDefinition>& rollups);
+
+  /**
+   * Stops the queries. The rollup tables and their rows stay in the table store.
+   */
+  void Stop();
+
+ private:
+  struct RunningRollup {
+    sole::uuid query_id;
+    std::thread thread;
+    std::atomic<bool> done{false};
+  };
+
+  carnot::Carnot* carnot_;
+  table_store::TableStore* table_store_;
+  RelationInfoManager* relation_info_manager_;
+  std::vector<std::unique_ptr<RunningRollup>> running_;
+};
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
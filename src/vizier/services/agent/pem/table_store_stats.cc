@@ -0,0 +1,138 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/pem/table_store_stats.h"
+
+#include <utility>
+#include <vector>
+
+DEFINE_int64(pem_table_store_stats_period_ms,
+             gflags::Int64FromEnv("PL_PEM_TABLE_STORE_STATS_PERIOD_MS", 10 * 1000),
+             "How often the PEM appends the stats of its tables to px_table_store_stats. 0 "
+             "disables the table.");
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+namespace {
+
+enum TableStoreStatsColumn {
+  kTime = 0,
+  kTableName,
+  kBytes,
+  kHotBytes,
+  kColdBytes,
+  kMaxTableSize,
+  kNumBatches,
+  kNumHotBatches,
+  kNumRows,
+  kMinBatchRows,
+  kMaxBatchRows,
+  kRetentionNS,
+  kHotBudgetRatio,
+  kCompactionLatencyNS,
+  kBatchesAdded,
+  kBatchesCompacted,
+  kBatchesExpired,
+};
+
+}  // namespace
+
+table_store::schema::Relation TableStoreStatsTable::TableRelation() {
+  return table_store::schema::Relation(
+      {types::TIME64NS, types::STRING, types::INT64, types::INT64, types::INT64, types::INT64,
+       types::INT64, types::INT64, types::INT64, types::INT64, types::INT64, types::INT64,
+       types::FLOAT64, types::INT64, types::INT64, types::INT64, types::INT64},
+      {"time_", "table_name", "bytes", "hot_bytes", "cold_bytes", "max_table_size", "num_batches",
+       "num_hot_batches", "num_rows", "min_batch_rows", "max_batch_rows", "retention_ns",
+       "hot_budget_ratio", "compaction_latency_ns", "batches_added", "batches_compacted",
+       "batches_expired"},
+      {"The time of the sample", "The name of the table",
+       "The bytes the table holds in hot and cold storage", "The bytes waiting to be compacted",
+       "The bytes in cold storage", "The most bytes the table holds before it expires rows",
+       "The batches in hot and cold storage", "The batches waiting to be compacted",
+       "The rows in hot and cold storage", "The fewest rows of any batch",
+       "The most rows of any batch",
+       "The time between the oldest and newest rows, or -1 for a table without a time column",
+       "The hot bytes over what one compaction moves to cold storage. Above 1, compaction is "
+       "falling behind",
+       "How long the last compaction of the table took",
+       "The batches added since the previous sample",
+       "The batches compacted into cold storage since the previous sample",
+       "The batches expired since the previous sample"});
+}
+
+Status TableStoreStatsTable::Init(RelationInfoManager* relation_info_manager) {
+  table_ = table_store::Table::Create(TableRelation());
+  table_store_->AddTable(table_, kTableStoreStatsTableName);
+  return relation_info_manager->AddRelationInfo(
+      RelationInfo(kTableStoreStatsTableName, /* id */ 0,
+                   "The memory use and churn of the tables of the agent over time",
+                   TableRelation()));
+}
+
+Status TableStoreStatsTable::Sample(int64_t time_ns) {
+  auto relation_map = table_store_->GetRelationMap();
+  auto batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  auto relation = TableRelation();
+  for (auto type : relation.col_types()) {
+    batch->push_back(types::ColumnWrapper::Make(type, 0));
+  }
+  auto& cols = *batch;
+  for (const auto& [name, table_relation] : *relation_map) {
+    const table_store::Table* table = table_store_->GetTable(name);
+    if (table == nullptr) {
+      continue;
+    }
+    auto stats = table->GetTableStats();
+    Counters& prev = prev_counters_[name];
+
+    cols[kTime]->Append<types::Time64NSValue>(time_ns);
+    cols[kTableName]->Append<types::StringValue>(name);
+    cols[kBytes]->Append<types::Int64Value>(stats.bytes);
+    cols[kHotBytes]->Append<types::Int64Value>(stats.hot_bytes);
+    cols[kColdBytes]->Append<types::Int64Value>(stats.cold_bytes);
+    cols[kMaxTableSize]->Append<types::Int64Value>(stats.max_table_size);
+    cols[kNumBatches]->Append<types::Int64Value>(stats.num_batches);
+    cols[kNumHotBatches]->Append<types::Int64Value>(stats.num_hot_batches);
+    cols[kNumRows]->Append<types::Int64Value>(stats.num_rows);
+    cols[kMinBatchRows]->Append<types::Int64Value>(stats.min_batch_rows);
+    cols[kMaxBatchRows]->Append<types::Int64Value>(stats.max_batch_rows);
+    cols[kRetentionNS]->Append<types::Int64Value>(
+        stats.min_time == -1 ? -1 : stats.max_time - stats.min_time);
+    cols[kHotBudgetRatio]->Append<types::Float64Value>(table->HotBudgetRatio());
+    cols[kCompactionLatencyNS]->Append<types::Int64Value>(stats.compaction_latency_ns);
+    cols[kBatchesAdded]->Append<types::Int64Value>(stats.batches_added - prev.batches_added);
+    cols[kBatchesCompacted]->Append<types::Int64Value>(stats.compacted_batches -
+                                                       prev.compacted_batches);
+    cols[kBatchesExpired]->Append<types::Int64Value>(stats.batches_expired -
+                                                     prev.batches_expired);
+    prev.batches_added = stats.batches_added;
+    prev.batches_expired = stats.batches_expired;
+    prev.compacted_batches = stats.compacted_batches;
+  }
+  if (cols[kTime]->Size() == 0) {
+    return Status::OK();
+  }
+  return table_->TransferRecordBatch(std::move(batch));
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
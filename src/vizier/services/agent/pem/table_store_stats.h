@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/base/base.h"
+#include "src/table_store/table_store.h"
+#include "src/vizier/services/agent/manager/relation_info_manager.h"
+
+DECLARE_int64(pem_table_store_stats_period_ms);
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+constexpr char kTableStoreStatsTableName[] = "px_table_store_stats";
+
+/**
+ * TableStoreStatsTable is the px_table_store_stats table of the PEM. Each Sample appends a row
+ * per table of the table store with its memory use, how far back its rows reach, its compaction
+ * backlog, and the batches added, compacted and expired since the previous sample. It's the time
+ * series of what GetDebugTableInfo shows at one point in time.
+ */
+class TableStoreStatsTable : public NotCopyable {
+ public:
+  explicit TableStoreStatsTable(table_store::TableStore* table_store)
+      : table_store_(table_store) {}
+
+  static table_store::schema::Relation TableRelation();
+
+  /**
+   * Adds the table to the table store and to the schema of the agent.
+   */
+  Status Init(RelationInfoManager* relation_info_manager);
+
+  /**
+   * Appends the stats of every table, at the given time.
+   */
+  Status Sample(int64_t time_ns);
+
+ private:
+  struct Counters {
+    int64_t batches_added = 0;
+    int64_t batches_expired = 0;
+    int64_t compacted_batches = 0;
+  };
+
+  table_store::TableStore* table_store_;
+  std::shared_ptr<table_store::Table> table_;
+  // The counters of each table at the previous sample.
+  absl::flat_hash_map<std::string, Counters> prev_counters_;
+};
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "src/vizier/services/agent/pem/table_store_stats.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/testing/testing.h"
+#include "src/shared/types/arrow_adapter.h"
+
+namespace px {
+namespace vizier {
+namespace agent {
+
+namespace {
+
+void WriteRows(table_store::Table* table, const std::vector<types::Time64NSValue>& times) {
+  auto batch = std::make_unique<types::ColumnWrapperRecordBatch>();
+  auto time_col = std::make_shared<types::Time64NSValueColumnWrapper>(0);
+  time_col->AppendFromVector(times);
+  batch->push_back(time_col);
+  ASSERT_OK(table->TransferRecordBatch(std::move(batch)));
+}
+
+struct StatsRow {
+  int64_t time;
+  int64_t num_rows;
+  int64_t max_batch_rows;
+  int64_t retention_ns;
+  int64_t batches_added;
+};
+
+// Returns the rows of px_table_store_stats about the given table.
+std::vector<StatsRow> StatsRowsOf(table_store::TableStore* table_store,
+                                  const std::string& table_name) {
+  table_store::Table* table = table_store->GetTable(kTableStoreStatsTableName);
+  std::vector<StatsRow> rows;
+  for (auto slice = table->FirstBatch(); slice.IsValid(); slice = table->NextBatch(slice)) {
+    auto rb = table
+                  ->GetRowBatchSlice(slice, std::vector<int64_t>({0, 1, 8, 10, 11, 14}),
+                                     arrow::default_memory_pool())
+                  .ConsumeValueOrDie();
+    for (int64_t i = 0; i < rb->num_rows(); ++i) {
+      if (types::GetValueFromArrowArray<types::STRING>(rb->ColumnAt(1).get(), i) != table_name) {
+        continue;
+      }
+      rows.push_back({types::GetValueFromArrowArray<types::TIME64NS>(rb->ColumnAt(0).get(), i),
+                      types::GetValueFromArrowArray<types::INT64>(rb->ColumnAt(2).get(), i),
+                      types::GetValueFromArrowArray<types::INT64>(rb->ColumnAt(3).get(), i),
+                      types::GetValueFromArrowArray<types::INT64>(rb->ColumnAt(4).get(), i),
+                      types::GetValueFromArrowArray<types::INT64>(rb->ColumnAt(5).get(), i)});
+    }
+  }
+  return rows;
+}
+
+}  // namespace
+
+TEST(TableStoreStatsTableTest, Sample) {
+  auto table_store = std::make_shared<table_store::TableStore>();
+  auto table = table_store::Table::Create(
+      table_store::schema::Relation({types::TIME64NS}, {"time_"}));
+  table_store->AddTable(table, "test_table");
+
+  RelationInfoManager relation_info_manager;
+  TableStoreStatsTable stats_table(table_store.get());
+  ASSERT_OK(stats_table.Init(&relation_info_manager));
+  EXPECT_TRUE(relation_info_manager.HasRelation(kTableStoreStatsTableName));
+
+  WriteRows(table.get(), {10, 20, 30});
+  ASSERT_OK(stats_table.Sample(100));
+  WriteRows(table.get(), {40});
+  ASSERT_OK(stats_table.Sample(200));
+
+  auto rows = StatsRowsOf(table_store.get(), "test_table");
+  ASSERT_EQ(2, rows.size());
+  EXPECT_EQ(100, rows[0].time);
+  EXPECT_EQ(3, rows[0].num_rows);
+  EXPECT_EQ(3, rows[0].max_batch_rows);
+  EXPECT_EQ(20, rows[0].retention_ns);
+  EXPECT_EQ(1, rows[0].batches_added);
+
+  EXPECT_EQ(200, rows[1].time);
+  EXPECT_EQ(4, rows[1].num_rows);
+  EXPECT_EQ(3, rows[1].max_batch_rows);
+  EXPECT_EQ(30, rows[1].retention_ns);
+  // Only the batch added since the first sample.
+  EXPECT_EQ(1, rows[1].batches_added);
+
+  // The table reports on itself too.
+  EXPECT_EQ(2, StatsRowsOf(table_store.get(), kTableStoreStatsTableName).size());
+}
+
+}  // namespace agent
+}  // namespace vizier
+}  // namespace px
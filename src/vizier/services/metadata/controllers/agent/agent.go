@@ -395,6 +395,7 @@ func (m *ManagerImpl) handleCreatedProcesses(processes []*metadatapb.ProcessCrea
 			StartTimestampNS: p.StartTimestampNS,
 			ProcessArgs:      p.Cmdline,
 			CID:              p.CID,
+			StopTimestampNS:  p.StopTimestampNS,
 		}
 		processInfos[i] = pPb
 	}
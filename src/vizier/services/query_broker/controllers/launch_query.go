@@ -19,7 +19,9 @@
 package controllers
 
 import (
+	"bytes"
 	"fmt"
+	"time"
 
 	"golang.org/x/sync/errgroup"
 
@@ -32,25 +34,59 @@ import (
 	"px.dev/pixie/src/vizier/utils/messagebus"
 )
 
-// LaunchQuery launches a query by sending query fragments to relevant agents.
-func LaunchQuery(queryID uuid.UUID, natsConn *nats.Conn, planMap map[uuid.UUID]*planpb.Plan, analyze bool) error {
+// PlannerTimings are the time spent planning a query, which an agent of the query records in its
+// px_query_spans table.
+type PlannerTimings struct {
+	StartTime             time.Time
+	CompileTimeNs         int64
+	DistributedPlanTimeNs int64
+}
+
+// plannerSpansAgent picks the agent that records the planner spans of a query. It's the first data
+// agent by ID, since the Kelvins' tables aren't queried.
+func plannerSpansAgent(planMap map[uuid.UUID]*planpb.Plan) uuid.UUID {
+	var picked uuid.UUID
+	pickedIsDataAgent := false
+	for agentID, plan := range planMap {
+		isDataAgent := len(plan.IncomingAgentIDs) == 0
+		if picked == uuid.Nil || (isDataAgent && !pickedIsDataAgent) ||
+			(isDataAgent == pickedIsDataAgent && bytes.Compare(agentID.Bytes(), picked.Bytes()) < 0) {
+			picked = agentID
+			pickedIsDataAgent = isDataAgent
+		}
+	}
+	return picked
+}
+
+// LaunchQuery launches a query by sending query fragments to relevant agents. plannerTimings may
+// be nil.
+func LaunchQuery(queryID uuid.UUID, natsConn *nats.Conn, planMap map[uuid.UUID]*planpb.Plan, analyze bool,
+	plannerTimings *PlannerTimings) error {
 	if len(planMap) == 0 {
 		return fmt.Errorf("Received no agent plans for query %s", queryID.String())
 	}
 
 	queryIDPB := utils.ProtoFromUUID(queryID)
+	spansAgentID := plannerSpansAgent(planMap)
 	// Broadcast query to all the agents in parallel.
 	var eg errgroup.Group
 
 	broadcastToAgent := func(agentID uuid.UUID, logicalPlan *planpb.Plan) error {
+		req := &messagespb.ExecuteQueryRequest{
+			QueryID: queryIDPB,
+			Plan:    logicalPlan,
+			Analyze: analyze,
+		}
+		if plannerTimings != nil && agentID == spansAgentID {
+			req.PlanStartTimeNs = plannerTimings.StartTime.UnixNano()
+			req.CompileTimeNs = plannerTimings.CompileTimeNs
+			req.DistributedPlanTimeNs = plannerTimings.DistributedPlanTimeNs
+		}
+		req.DispatchTimeNs = time.Now().UnixNano()
 		// Create NATS message containing the query string.
 		msg := messagespb.VizierMessage{
 			Msg: &messagespb.VizierMessage_ExecuteQueryRequest{
-				ExecuteQueryRequest: &messagespb.ExecuteQueryRequest{
-					QueryID: queryIDPB,
-					Plan:    logicalPlan,
-					Analyze: analyze,
-				},
+				ExecuteQueryRequest: req,
 			},
 		}
 		agentTopic := messagebus.AgentUUIDTopic(agentID)
@@ -89,7 +89,12 @@ func TestLaunchQuery(t *testing.T) {
 	planMap[agentUUIDs[1]] = planPB2
 
 	// Execute a query.
-	err = controllers.LaunchQuery(queryUUID, nc, planMap, false)
+	timings := &controllers.PlannerTimings{
+		StartTime:             time.Now(),
+		CompileTimeNs:         10,
+		DistributedPlanTimeNs: 20,
+	}
+	err = controllers.LaunchQuery(queryUUID, nc, planMap, false, timings)
 	require.NoError(t, err)
 
 	// Check that each agent received the correct message.
@@ -105,6 +110,7 @@ func TestLaunchQuery(t *testing.T) {
 
 	assert.Equal(t, planPB1, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.Plan)
 	assert.Equal(t, queryUUIDPb, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.QueryID)
+	req1 := pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest
 
 	m2, err := sub2.NextMsg(time.Second)
 	require.NoError(t, err)
@@ -113,6 +119,14 @@ func TestLaunchQuery(t *testing.T) {
 	require.NoError(t, err)
 	assert.Equal(t, planPB2, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.Plan)
 	assert.Equal(t, queryUUIDPb, pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest.QueryID)
+	req2 := pb.Msg.(*messagespb.VizierMessage_ExecuteQueryRequest).ExecuteQueryRequest
+
+	// Both agents record their dispatch, only one of them the planner timings.
+	assert.NotZero(t, req1.DispatchTimeNs)
+	assert.NotZero(t, req2.DispatchTimeNs)
+	assert.Equal(t, int64(10), req1.CompileTimeNs+req2.CompileTimeNs)
+	assert.Equal(t, int64(20), req1.DistributedPlanTimeNs+req2.DistributedPlanTimeNs)
+	assert.Equal(t, timings.StartTime.UnixNano(), req1.PlanStartTimeNs+req2.PlanStartTimeNs)
 }
 
 func TestLaunchQueryNoPlans(t *testing.T) {
@@ -126,7 +140,7 @@ func TestLaunchQueryNoPlans(t *testing.T) {
 
 	planMap := make(map[uuid.UUID]*planpb.Plan)
 
-	err = controllers.LaunchQuery(queryUUID, nc, planMap, false)
+	err = controllers.LaunchQuery(queryUUID, nc, planMap, false, nil)
 
 	assert.NotNil(t, err)
 	assert.Regexp(t, fmt.Sprintf("Received no agent plans for query %s", queryIDStr), err)
@@ -173,6 +187,6 @@ func TestLaunchQueryNATSFailure(t *testing.T) {
 	cleanup()
 
 	// Execute a query. This should return an error but not hang.
-	err = controllers.LaunchQuery(queryUUID, nc, planMap, false)
+	err = controllers.LaunchQuery(queryUUID, nc, planMap, false, nil)
 	require.NotNil(t, err)
 }
@@ -45,6 +45,12 @@ type QueryResultConsumer interface {
 	Consume(*vizierpb.ExecuteScriptResponse) error
 }
 
+// PlanChecker is implemented by QueryResultConsumers that check the plan of a query before it is
+// launched. The query fails with the error of CheckPlan, if any.
+type PlanChecker interface {
+	CheckPlan(planMap map[uuid.UUID]*planpb.Plan) error
+}
+
 // QueryExecutor executes a query and allows the caller to consume results via a QueryResultConsumer.
 type QueryExecutor interface {
 	Run(context.Context, *vizierpb.ExecuteScriptRequest, QueryResultConsumer) error
@@ -81,6 +87,7 @@ type QueryExecutorImpl struct {
 	queryID           uuid.UUID
 	startTime         time.Time
 	compilationTimeNs int64
+	plannerTimings    PlannerTimings
 
 	mutationExecFactory MutationExecFactory
 }
@@ -149,8 +156,9 @@ func (q *QueryExecutorImpl) Run(ctx context.Context, req *vizierpb.ExecuteScript
 	resultCh := make(chan *vizierpb.ExecuteScriptResponse)
 
 	q.eg.Go(func() error { return q.runConsumer(ctx, resultCh, consumer) })
+	checker, _ := consumer.(PlanChecker)
 	q.eg.Go(func() error {
-		return q.runScript(ctx, resultCh, req)
+		return q.runScript(ctx, resultCh, req, checker)
 	})
 
 	return nil
@@ -176,6 +184,9 @@ func (q *QueryExecutorImpl) Wait() error {
 	if errors.Is(err, nats.ErrConnectionClosed) {
 		return err
 	}
+	if errors.Is(err, errStreamingQuery) {
+		return err
+	}
 	if errors.Is(err, context.DeadlineExceeded) {
 		return err
 	}
@@ -290,6 +301,11 @@ func (q *QueryExecutorImpl) compilePlan(ctx context.Context, resultCh chan<- *vi
 		return nil, err
 	}
 	q.compilationTimeNs = time.Since(start).Nanoseconds()
+	q.plannerTimings = PlannerTimings{
+		StartTime:             start,
+		CompileTimeNs:         plannerResultPB.CompileTimeNs,
+		DistributedPlanTimeNs: plannerResultPB.DistributedPlanTimeNs,
+	}
 
 	// When the status is not OK, this means it's a compilation error on the query passed in.
 	if plannerResultPB.Status.ErrCode != statuspb.OK {
@@ -370,7 +386,7 @@ func (q *QueryExecutorImpl) buildQueryPlanOpts(ctx context.Context, resultCh cha
 	return queryPlanOpts, nil
 }
 
-func (q *QueryExecutorImpl) prepareScript(ctx context.Context, resultCh chan<- *vizierpb.ExecuteScriptResponse, req *vizierpb.ExecuteScriptRequest) error {
+func (q *QueryExecutorImpl) prepareScript(ctx context.Context, resultCh chan<- *vizierpb.ExecuteScriptResponse, req *vizierpb.ExecuteScriptRequest, checker PlanChecker) error {
 	planOpts, err := q.getPlanOpts(req.QueryStr)
 	if err != nil {
 		return err
@@ -399,6 +415,11 @@ func (q *QueryExecutorImpl) prepareScript(ctx context.Context, resultCh chan<- *
 	if err != nil {
 		return err
 	}
+	if checker != nil {
+		if err := checker.CheckPlan(planMap); err != nil {
+			return err
+		}
+	}
 	tableNameToIDMap, err := q.buildTableMap(planMap)
 	if err != nil {
 		return err
@@ -417,20 +438,20 @@ func (q *QueryExecutorImpl) prepareScript(ctx context.Context, resultCh chan<- *
 	if err != nil {
 		return err
 	}
-	err = LaunchQuery(q.queryID, q.natsConn, planMap, planOpts.Analyze)
+	err = LaunchQuery(q.queryID, q.natsConn, planMap, planOpts.Analyze, &q.plannerTimings)
 	if err != nil {
 		return err
 	}
 	return nil
 }
 
-func (q *QueryExecutorImpl) runScript(ctx context.Context, resultCh chan<- *vizierpb.ExecuteScriptResponse, req *vizierpb.ExecuteScriptRequest) error {
+func (q *QueryExecutorImpl) runScript(ctx context.Context, resultCh chan<- *vizierpb.ExecuteScriptResponse, req *vizierpb.ExecuteScriptRequest, checker PlanChecker) error {
 	defer close(resultCh)
 	q.startTime = time.Now()
 	log.WithField("query_id", q.queryID).Infof("Running script")
 
 	if req.QueryID == "" {
-		if err := q.prepareScript(ctx, resultCh, req); err != nil {
+		if err := q.prepareScript(ctx, resultCh, req, checker); err != nil {
 			return err
 		}
 	}
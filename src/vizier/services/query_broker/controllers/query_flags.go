@@ -38,6 +38,16 @@ var defaultQueryFlags = map[string]interface{}{
 	"explain":                   false,
 	"analyze":                   false,
 	"max_output_rows_per_table": 10000,
+	// How agents schedule the query: "interactive" or "background". Background queries wait for
+	// interactive ones and are throttled to cpu_quota, or to the agent's default quota if unset.
+	"priority":  "interactive",
+	"cpu_quota": 0.0,
+}
+
+// The values of the priority flag. Internal queries can't be requested from a script.
+var queryPriorities = map[string]planpb.PlanOptions_QueryPriority{
+	"interactive": planpb.INTERACTIVE,
+	"background":  planpb.BACKGROUND,
 }
 
 // QueryFlags represents a set of Pixie configuration flags.
@@ -109,6 +119,9 @@ func (f *QueryFlags) set(key string, value string) error {
 		if err != nil {
 			return err
 		}
+		if _, ok := queryPriorities[value]; key == "priority" && !ok {
+			return fmt.Errorf("%s is not a valid priority", value)
+		}
 		f.flags[key] = typedVal
 		return nil
 	}
@@ -122,6 +135,8 @@ func (f *QueryFlags) GetPlanOptions() *planpb.PlanOptions {
 		Explain:               f.GetBool("explain"),
 		Analyze:               f.GetBool("analyze"),
 		MaxOutputRowsPerTable: f.GetInt64("max_output_rows_per_table"),
+		Priority:              queryPriorities[f.GetString("priority")],
+		CpuQuota:              f.GetFloat64("cpu_quota"),
 	}
 }
 
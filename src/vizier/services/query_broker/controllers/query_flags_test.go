@@ -24,6 +24,7 @@ import (
 	"github.com/stretchr/testify/assert"
 	"github.com/stretchr/testify/require"
 
+	"px.dev/pixie/src/carnot/planpb"
 	"px.dev/pixie/src/vizier/services/query_broker/controllers"
 )
 
@@ -109,4 +110,17 @@ func TestParseQueryFlags_PlanOptions(t *testing.T) {
 	options := qf.GetPlanOptions()
 	assert.Equal(t, options.Explain, false)
 	assert.Equal(t, options.Analyze, true)
+	assert.Equal(t, options.Priority, planpb.INTERACTIVE)
+}
+
+func TestParseQueryFlags_Priority(t *testing.T) {
+	qf, err := controllers.ParseQueryFlags("#px:set priority=background\n#px:set cpu_quota=0.25\n")
+	require.NoError(t, err)
+
+	options := qf.GetPlanOptions()
+	assert.Equal(t, options.Priority, planpb.BACKGROUND)
+	assert.Equal(t, options.CpuQuota, 0.25)
+
+	_, err = controllers.ParseQueryFlags("#px:set priority=internal\n")
+	assert.NotNil(t, err)
 }
@@ -0,0 +1,305 @@
+/*
+ * Copyright 2018- The Pixie Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package controllers
+
+import (
+	"container/list"
+	"context"
+	"crypto/sha256"
+	"encoding/binary"
+	"encoding/hex"
+	"errors"
+	"sync"
+	"time"
+
+	"github.com/gofrs/uuid"
+	"github.com/gogo/protobuf/proto"
+	"github.com/spf13/pflag"
+	"github.com/spf13/viper"
+
+	"px.dev/pixie/src/api/proto/vizierpb"
+	"px.dev/pixie/src/carnot/planpb"
+)
+
+func init() {
+	pflag.Duration("query_result_cache_ttl", 0,
+		"How long the results of a query are reused for identical queries. Zero, the default, disables the cache.")
+	pflag.Duration("query_result_cache_time_bucket", 5*time.Second,
+		"Queries that are identical and start within the same bucket of this size share their results.")
+	pflag.Int64("query_result_cache_max_bytes", 64*1024*1024,
+		"The most bytes of query results that are kept in the query result cache.")
+}
+
+// queryResultCache shares the results of identical scripts that are run close together, such as
+// the scripts of a live view that is open by several users. Relative times in a script resolve
+// against the time the script is run, so scripts are only identical if they also start in the
+// same time bucket.
+//
+// The first request for a key starts the query and records its responses, and every request for
+// the key, including the first one, follows the recording. The query runs on a context of its
+// own, so that it keeps running for the other requests when the first one goes away, and is
+// cancelled once no request follows it anymore. Completed recordings are kept until they expire
+// or are evicted to stay under the byte limit.
+type queryResultCache struct {
+	ttl        time.Duration
+	timeBucket time.Duration
+	maxBytes   int64
+	now        func() time.Time
+
+	mu      sync.Mutex
+	entries map[string]*cachedQueryResult
+	// Completed entries, least recently completed first.
+	completed *list.List
+	bytes     int64
+}
+
+type cachedQueryResult struct {
+	key       string
+	responses []*vizierpb.ExecuteScriptResponse
+	bytes     int64
+	// Closed and replaced whenever a response is added or the query finishes.
+	updated   chan struct{}
+	done      bool
+	err       error
+	expiresAt time.Time
+	elem      *list.Element
+	// The context that the query runs on, cancelled once no request follows the entry anymore.
+	ctx       context.Context
+	cancel    context.CancelFunc
+	followers int
+}
+
+// errStreamingQuery fails the shared run of a script that turns out to be a streaming query, whose
+// results never complete and so can't be shared. Each request then runs the script itself.
+var errStreamingQuery = errors.New("streaming queries are not shared")
+
+func newQueryResultCacheFromFlags() *queryResultCache {
+	return newQueryResultCache(viper.GetDuration("query_result_cache_ttl"),
+		viper.GetDuration("query_result_cache_time_bucket"), viper.GetInt64("query_result_cache_max_bytes"))
+}
+
+func newQueryResultCache(ttl time.Duration, timeBucket time.Duration, maxBytes int64) *queryResultCache {
+	if ttl <= 0 || maxBytes <= 0 {
+		return nil
+	}
+	return &queryResultCache{
+		ttl:        ttl,
+		timeBucket: timeBucket,
+		maxBytes:   maxBytes,
+		now:        time.Now,
+		entries:    make(map[string]*cachedQueryResult),
+		completed:  list.New(),
+	}
+}
+
+// key returns the cache key of the request, or false if the results of the request must not be
+// shared.
+func (c *queryResultCache) key(req *vizierpb.ExecuteScriptRequest) (string, bool) {
+	// Mutations have side effects and resumed queries already have results. Streaming queries are
+	// only known once the script is compiled, see checkPlan.
+	if req.Mutation || req.QueryID != "" {
+		return "", false
+	}
+	h := sha256.New()
+	var buf [8]byte
+	writeBytes := func(b []byte) {
+		binary.LittleEndian.PutUint64(buf[:], uint64(len(b)))
+		h.Write(buf[:])
+		h.Write(b)
+	}
+	writeBytes([]byte(req.QueryStr))
+	for _, f := range req.ExecFuncs {
+		b, err := f.Marshal()
+		if err != nil {
+			return "", false
+		}
+		writeBytes(b)
+	}
+	bucket := c.now().UnixNano()
+	if c.timeBucket > 0 {
+		bucket /= int64(c.timeBucket)
+	}
+	binary.LittleEndian.PutUint64(buf[:], uint64(bucket))
+	h.Write(buf[:])
+	return hex.EncodeToString(h.Sum(nil)), true
+}
+
+// acquire returns the entry of the key, and whether the caller must start the query on the
+// entry's context and record its results into the entry. The caller follows the entry until it
+// calls release.
+func (c *queryResultCache) acquire(key string) (*cachedQueryResult, bool) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	c.evictExpiredLocked()
+	if e, ok := c.entries[key]; ok {
+		if e.done {
+			c.completed.MoveToBack(e.elem)
+		}
+		e.followers++
+		return e, false
+	}
+	e := &cachedQueryResult{
+		key:       key,
+		updated:   make(chan struct{}),
+		followers: 1,
+	}
+	e.ctx, e.cancel = context.WithCancel(context.Background())
+	c.entries[key] = e
+	return e, true
+}
+
+// release stops following the entry, and cancels its query if it was the last follower.
+func (c *queryResultCache) release(e *cachedQueryResult) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	e.followers--
+	if e.followers > 0 || e.done {
+		return
+	}
+	// New requests must not follow a query that is being cancelled.
+	if c.entries[e.key] == e {
+		delete(c.entries, e.key)
+	}
+	e.cancel()
+}
+
+func (c *queryResultCache) notifyLocked(e *cachedQueryResult) {
+	close(e.updated)
+	e.updated = make(chan struct{})
+}
+
+func (c *queryResultCache) record(e *cachedQueryResult, resp *vizierpb.ExecuteScriptResponse) {
+	resp = proto.Clone(resp).(*vizierpb.ExecuteScriptResponse)
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	e.responses = append(e.responses, resp)
+	e.bytes += int64(resp.Size())
+	// Requests that already follow the entry still get every response, but results that are too
+	// large to keep are not shared with new requests.
+	if e.bytes > c.maxBytes && c.entries[e.key] == e {
+		delete(c.entries, e.key)
+	}
+	c.notifyLocked(e)
+}
+
+func (c *queryResultCache) finish(e *cachedQueryResult, err error) {
+	defer e.cancel()
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	e.done = true
+	e.err = err
+	c.notifyLocked(e)
+	if c.entries[e.key] != e {
+		return
+	}
+	if err != nil {
+		delete(c.entries, e.key)
+		return
+	}
+	e.expiresAt = c.now().Add(c.ttl)
+	e.elem = c.completed.PushBack(e)
+	c.bytes += e.bytes
+	for c.bytes > c.maxBytes && c.completed.Len() > 0 {
+		c.removeLocked(c.completed.Front().Value.(*cachedQueryResult))
+	}
+}
+
+func (c *queryResultCache) removeLocked(e *cachedQueryResult) {
+	c.completed.Remove(e.elem)
+	delete(c.entries, e.key)
+	c.bytes -= e.bytes
+}
+
+func (c *queryResultCache) evictExpiredLocked() {
+	now := c.now()
+	for c.completed.Len() > 0 {
+		e := c.completed.Front().Value.(*cachedQueryResult)
+		if now.Before(e.expiresAt) {
+			return
+		}
+		c.removeLocked(e)
+	}
+}
+
+// replay sends the responses of the entry to the consumer as they are recorded, until the query
+// that records them finishes, and returns the error of the recorded query. If queryID is set, it
+// replaces the query ID of the recorded query in the responses.
+func (c *queryResultCache) replay(ctx context.Context, e *cachedQueryResult, consumer QueryResultConsumer, queryID string) error {
+	sent := 0
+	for {
+		c.mu.Lock()
+		pending := e.responses[sent:]
+		done, err, updated := e.done, e.err, e.updated
+		c.mu.Unlock()
+
+		for _, resp := range pending {
+			// Consumers may modify the response, such as to encrypt it.
+			resp = proto.Clone(resp).(*vizierpb.ExecuteScriptResponse)
+			if queryID != "" && resp.QueryID != "" {
+				resp.QueryID = queryID
+			}
+			if err := consumer.Consume(resp); err != nil {
+				return err
+			}
+			sent++
+		}
+		if len(pending) > 0 {
+			continue
+		}
+		if done {
+			return err
+		}
+		select {
+		case <-ctx.Done():
+			return ctx.Err()
+		case <-updated:
+		}
+	}
+}
+
+// newFollowerQueryID returns the query ID that a request which follows the query of another
+// request sees, so that each request has a query ID of its own.
+func newFollowerQueryID() (string, error) {
+	id, err := uuid.NewV4()
+	if err != nil {
+		return "", err
+	}
+	return id.String(), nil
+}
+
+// recordingConsumer records the responses of the query that a cache entry shares.
+type recordingConsumer struct {
+	c *queryResultCache
+	e *cachedQueryResult
+}
+
+func (r *recordingConsumer) Consume(resp *vizierpb.ExecuteScriptResponse) error {
+	r.c.record(r.e, resp)
+	return nil
+}
+
+// CheckPlan fails the query if it is a streaming query, before it sends any results.
+func (r *recordingConsumer) CheckPlan(planMap map[uuid.UUID]*planpb.Plan) error {
+	for _, plan := range planMap {
+		if plan.GetPlanOptions().GetStreaming() {
+			return errStreamingQuery
+		}
+	}
+	return nil
+}
@@ -20,6 +20,7 @@ package controllers
 
 import (
 	"context"
+	"errors"
 	"fmt"
 	"io"
 	"sync"
@@ -87,6 +88,9 @@ type Server struct {
 	planner Planner
 
 	queryExecFactory QueryExecutorFactory
+
+	// Nil if the results of identical queries are not shared.
+	resultCache *queryResultCache
 }
 
 // QueryExecutorFactory creates a new QueryExecutor.
@@ -130,6 +134,7 @@ func NewServerWithForwarderAndPlanner(env querybrokerenv.QueryBrokerEnv,
 		planner:           planner,
 		queryExecFactory:  queryExecFactory,
 		healthcheckQuitCh: make(chan struct{}),
+		resultCache:       newQueryResultCacheFromFlags(),
 	}
 	s.hcStatus.Store(fmt.Errorf("no healthcheck has run yet"))
 	go s.runHealthcheck()
@@ -318,6 +323,15 @@ func (s *Server) ExecuteScript(req *vizierpb.ExecuteScriptRequest, srv vizierpb.
 		}
 		consumer = c
 	}
+	if s.resultCache != nil {
+		if key, ok := s.resultCache.key(req); ok {
+			return s.executeCachedScript(ctx, req, key, consumer)
+		}
+	}
+	return s.runQuery(ctx, req, consumer)
+}
+
+func (s *Server) runQuery(ctx context.Context, req *vizierpb.ExecuteScriptRequest, consumer QueryResultConsumer) error {
 	queryExec := s.queryExecFactory(s, NewMutationExecutor)
 	if err := queryExec.Run(ctx, req, consumer); err != nil {
 		return err
@@ -327,6 +341,31 @@ func (s *Server) ExecuteScript(req *vizierpb.ExecuteScriptRequest, srv vizierpb.
 	return queryExec.Wait()
 }
 
+// executeCachedScript starts the script if no identical script is running or recently finished,
+// and sends the results of the identical script.
+func (s *Server) executeCachedScript(ctx context.Context, req *vizierpb.ExecuteScriptRequest, key string, consumer QueryResultConsumer) error {
+	e, leader := s.resultCache.acquire(key)
+	defer s.resultCache.release(e)
+	queryID := ""
+	if leader {
+		runCtx := context.WithValue(e.ctx, execStartKey, ctx.Value(execStartKey))
+		go func() {
+			err := s.runQuery(runCtx, req, &recordingConsumer{c: s.resultCache, e: e})
+			s.resultCache.finish(e, err)
+		}()
+	} else {
+		var err error
+		if queryID, err = newFollowerQueryID(); err != nil {
+			return err
+		}
+	}
+	err := s.resultCache.replay(ctx, e, consumer, queryID)
+	if errors.Is(err, errStreamingQuery) {
+		return s.runQuery(ctx, req, consumer)
+	}
+	return err
+}
+
 // TransferResultChunk implements the API that allows the query broker receive streamed results
 // from Carnot instances.
 func (s *Server) TransferResultChunk(srv carnotpb.ResultSinkService_TransferResultChunkServer) error {
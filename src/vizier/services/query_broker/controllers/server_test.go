@@ -23,10 +23,12 @@ import (
 	"fmt"
 	"io"
 	"testing"
+	"time"
 
 	"github.com/gofrs/uuid"
 	"github.com/gogo/protobuf/proto"
 	"github.com/golang/mock/gomock"
+	"github.com/spf13/viper"
 	"github.com/stretchr/testify/assert"
 	"github.com/stretchr/testify/require"
 
@@ -430,6 +432,62 @@ func TestExecuteScript(t *testing.T) {
 	}
 }
 
+func TestExecuteScript_CachedResults(t *testing.T) {
+	viper.Set("query_result_cache_ttl", time.Minute)
+	viper.Set("query_result_cache_time_bucket", 24*time.Hour)
+	viper.Set("query_result_cache_max_bytes", 1024*1024)
+	defer viper.Set("query_result_cache_ttl", 0)
+
+	queryID := uuid.Must(uuid.NewV4())
+	results := buildExecuteScriptSuccessResponses(queryID)
+	numQueries := 0
+	queryExecFactory := func(*controllers.Server, controllers.MutationExecFactory) controllers.QueryExecutor {
+		numQueries++
+		return &fakeQueryExecutor{
+			ResultsToSend: results,
+			queryID:       queryID,
+		}
+	}
+
+	dp := &fakeDataPrivacy{}
+	s, err := controllers.NewServerWithForwarderAndPlanner(nil, nil, dp, nil, nil, nil, nil, nil, queryExecFactory)
+	require.NoError(t, err)
+
+	ctrl := gomock.NewController(t)
+	defer ctrl.Finish()
+
+	execute := func(req *vizierpb.ExecuteScriptRequest) []*vizierpb.ExecuteScriptResponse {
+		srv := mock_vizierpb.NewMockVizierService_ExecuteScriptServer(ctrl)
+		ctx := authcontext.NewContext(context.Background(), authcontext.New())
+		srv.EXPECT().Context().Return(ctx).AnyTimes()
+		var resps []*vizierpb.ExecuteScriptResponse
+		srv.EXPECT().
+			Send(gomock.Any()).
+			DoAndReturn(func(arg *vizierpb.ExecuteScriptResponse) error {
+				resps = append(resps, arg)
+				return nil
+			}).
+			AnyTimes()
+		require.NoError(t, s.ExecuteScript(req, srv))
+		return resps
+	}
+
+	req := &vizierpb.ExecuteScriptRequest{QueryStr: "success"}
+	assert.Equal(t, results, execute(req))
+	// The identical query reuses the results of the first.
+	assert.Equal(t, results, execute(req))
+	assert.Equal(t, 1, numQueries)
+
+	execute(&vizierpb.ExecuteScriptRequest{QueryStr: "other"})
+	assert.Equal(t, 2, numQueries)
+
+	// Mutations are always run.
+	mutation := &vizierpb.ExecuteScriptRequest{QueryStr: "success", Mutation: true}
+	execute(mutation)
+	execute(mutation)
+	assert.Equal(t, 4, numQueries)
+}
+
 func TestTransferResultChunk_AgentStreamComplete(t *testing.T) {
 	nc, cleanup := testingutils.MustStartTestNATS(t)
 	defer cleanup()
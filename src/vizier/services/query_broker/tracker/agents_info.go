@@ -36,6 +36,9 @@ import (
 // Kelvins themselves. rather than this variable, when Kelvins send their updated state.
 const KelvinSSLTargetOverride = "kelvin.%s.svc"
 
+// PEMSSLTargetOverride the hostname used for SSL target override when sending data to a PEM.
+const PEMSSLTargetOverride = "pem.%s.svc"
+
 // AgentsInfo tracks information about the distributed state of the system.
 type AgentsInfo interface {
 	ClearPendingState()
@@ -124,7 +127,7 @@ func (a *AgentsInfoImpl) UpdateAgentsInfo(update *metadatapb.AgentUpdatesRespons
 					metadataInfo = carnotInfo.MetadataInfo
 				}
 				// this is a PEM
-				carnotInfoMap[agentUUID] = makeAgentCarnotInfo(agentUUID, agent.ASID, metadataInfo)
+				carnotInfoMap[agentUUID] = makeAgentCarnotInfo(agentUUID, agent.Info.IPAddress, agent.ASID, metadataInfo)
 			} else {
 				// this is a Kelvin
 				kelvinGRPCAddress := agent.Info.IPAddress
@@ -184,17 +187,27 @@ func (a *AgentsInfoImpl) DistributedState() distributedpb.DistributedState {
 	return a.ds
 }
 
-func makeAgentCarnotInfo(agentID uuid.UUID, asid uint32, agentMetadata *distributedpb.MetadataInfo) *distributedpb.CarnotInfo {
-	return &distributedpb.CarnotInfo{
-		QueryBrokerAddress:   agentID.String(),
-		AgentID:              utils.ProtoFromUUID(agentID),
-		ASID:                 asid,
-		HasGRPCServer:        false,
-		HasDataStore:         true,
-		ProcessesData:        true,
+// makeAgentCarnotInfo makes the info of a PEM. PEMs that run a GRPC server register its address,
+// and can receive the inputs of broadcast joins from the Kelvin on it.
+func makeAgentCarnotInfo(agentID uuid.UUID, grpcAddress string, asid uint32, agentMetadata *distributedpb.MetadataInfo) *distributedpb.CarnotInfo {
+	carnotInfo := &distributedpb.CarnotInfo{
+		QueryBrokerAddress: agentID.String(),
+		AgentID:            utils.ProtoFromUUID(agentID),
+		ASID:               asid,
+		HasGRPCServer:      false,
+		HasDataStore:       true,
+		ProcessesData:      true,
+		// PEMs only receive what is broadcast to them, so they aren't picked to process the data of
+		// other agents.
 		AcceptsRemoteSources: false,
 		MetadataInfo:         agentMetadata,
 	}
+	if grpcAddress != "" {
+		carnotInfo.HasGRPCServer = true
+		carnotInfo.GRPCAddress = grpcAddress
+		carnotInfo.SSLTargetName = fmt.Sprintf(PEMSSLTargetOverride, viper.GetString("pod_namespace"))
+	}
+	return carnotInfo
 }
 
 func makeKelvinCarnotInfo(agentID uuid.UUID, grpcAddress string, asid uint32) *distributedpb.CarnotInfo {
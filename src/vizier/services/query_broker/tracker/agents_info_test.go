@@ -239,13 +239,14 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 	expectedPEM1Info := &distributedpb.CarnotInfo{
 		QueryBrokerAddress:   "11285cdd-1de9-4ab1-ae6a-0ba08c8c676c",
 		AgentID:              uuidpbs[0],
-		HasGRPCServer:        false,
-		GRPCAddress:          "",
+		HasGRPCServer:        true,
+		GRPCAddress:          "127.0.1.2",
 		HasDataStore:         true,
 		ProcessesData:        true,
 		AcceptsRemoteSources: false,
 		ASID:                 123,
 		MetadataInfo:         agentDataInfos[0].MetadataInfo,
+		SSLTargetName:        "pem.pl.svc",
 	}
 
 	expectedKelvinInfo := &distributedpb.CarnotInfo{
@@ -284,12 +285,13 @@ func TestAgentsInfo_UpdateAgentsInfo(t *testing.T) {
 	expectedPEM2Info := &distributedpb.CarnotInfo{
 		QueryBrokerAddress:   "61123ced-1de9-4ab1-ae6a-0ba08c8c676c",
 		AgentID:              uuidpbs[2],
-		HasGRPCServer:        false,
-		GRPCAddress:          "",
+		HasGRPCServer:        true,
+		GRPCAddress:          "127.0.1.4",
 		HasDataStore:         true,
 		ProcessesData:        true,
 		AcceptsRemoteSources: false,
 		ASID:                 789,
+		SSLTargetName:        "pem.pl.svc",
 	}
 
 	updates2 := []*metadatapb.AgentUpdate{